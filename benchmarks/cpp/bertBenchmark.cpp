@@ -17,17 +17,22 @@
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/plugins/api/tllmPlugin.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/packedEncoderInputs.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 #include "tensorrt_llm/runtime/tllmRuntime.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
 #include <NvInfer.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cxxopts.hpp>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <random>
 #include <sstream>
 #include <string>
 
@@ -72,6 +77,61 @@ std::string engineFilename(
         + std::to_string(worldConfig.getRank()) + ".engine";
 }
 
+// Limits of the engine and whether it takes packed inputs
+struct EngineLimits
+{
+    bool removeInputPadding{false};
+    SizeType maxBatchSize{0};
+    SizeType maxInputLen{0};
+    SizeType maxNumTokens{0};
+};
+
+EngineLimits engineLimits(std::filesystem::path const& dataPath)
+{
+    auto constexpr allowExceptions = true;
+    auto constexpr ignoreComments = true;
+    std::ifstream jsonStream(dataPath / "config.json");
+    auto const json = nlohmann::json::parse(jsonStream, nullptr, allowExceptions, ignoreComments);
+    auto const& builderConfig = json.at("builder_config");
+
+    EngineLimits limits;
+    if (json.contains("plugin_config"))
+    {
+        limits.removeInputPadding = json.at("plugin_config").value("remove_input_padding", false);
+    }
+    limits.maxBatchSize = builderConfig.value("max_batch_size", 0);
+    limits.maxInputLen = builderConfig.value("max_input_len", 0);
+    auto const maxNumTokens = builderConfig.value("max_num_tokens", nlohmann::json{});
+    limits.maxNumTokens = maxNumTokens.is_number() ? maxNumTokens.get<SizeType>()
+                                                   : limits.maxBatchSize * limits.maxInputLen;
+    return limits;
+}
+
+//! \brief Lengths drawn from "uniform:min,max" or "normal:mean,stddev", clamped to [1, maxInputLen].
+std::vector<SizeType> sampleInputLengths(
+    std::string const& distribution, SizeType numRequests, SizeType maxInputLen, unsigned int seed)
+{
+    auto const colon = distribution.find(':');
+    auto const comma = distribution.find(',', colon);
+    TLLM_CHECK_WITH_INFO(colon != std::string::npos && comma != std::string::npos,
+        "Input length distribution must be uniform:min,max or normal:mean,stddev, got %s", distribution.c_str());
+    auto const kind = distribution.substr(0, colon);
+    auto const first = std::stod(distribution.substr(colon + 1, comma - colon - 1));
+    auto const second = std::stod(distribution.substr(comma + 1));
+
+    std::mt19937 generator{seed};
+    std::uniform_real_distribution<double> uniform{first, second};
+    std::normal_distribution<double> normal{first, second};
+    TLLM_CHECK_WITH_INFO(kind == "uniform" || kind == "normal", "Unknown distribution %s", kind.c_str());
+    std::vector<SizeType> lengths(numRequests);
+    for (auto& length : lengths)
+    {
+        auto const sample = kind == "uniform" ? uniform(generator) : normal(generator);
+        length = std::clamp(static_cast<SizeType>(std::lround(sample)), 1, maxInputLen);
+    }
+    return lengths;
+}
+
 void benchmarkBert(std::string const& modelName, std::filesystem::path const& dataPath,
     std::vector<int> const& batchSizes, std::vector<int> const& inLens,
     std::shared_ptr<nvinfer1::ILogger> const& logger, int warmUp, int numRuns, int duration)
@@ -82,6 +142,7 @@ void benchmarkBert(std::string const& modelName, std::filesystem::path const& da
 
     auto rt = std::make_shared<TllmRuntime>(engineBlob.data(), engineBlob.size(), *logger);
     rt->addContext(0);
+    auto const limits = engineLimits(dataPath);
 
     for (auto inLen : inLens)
     {
@@ -90,18 +151,29 @@ void benchmarkBert(std::string const& modelName, std::filesystem::path const& da
             auto& allocator = rt->getBufferManager();
             TllmRuntime::TensorMap tensorMap{};
 
-            // input_ids
-            std::vector<SizeType> inputIdsHost(batchSize * inLen, inLen);
-            auto inputIdsBuffer = std::shared_ptr<ITensor>{
-                allocator.copyFrom(inputIdsHost, ITensor::makeShape({batchSize, inLen}), MemoryType::kGPU)};
-            allocator.setZero(*inputIdsBuffer);
-            tensorMap.insert(std::make_pair("input_ids", inputIdsBuffer));
-            // input_lengths
-            std::vector<SizeType> inputLengthsHost(batchSize);
-            auto inLensBuffer = std::shared_ptr<ITensor>{
-                allocator.copyFrom(inputLengthsHost, ITensor::makeShape({batchSize}), MemoryType::kGPU)};
-            allocator.setZero(*inLensBuffer);
-            tensorMap.insert(std::make_pair("input_lengths", inLensBuffer));
+            std::optional<PackedEncoderInputs> packedInputs;
+            if (limits.removeInputPadding)
+            {
+                std::vector<std::vector<TokenIdType>> inputIds(batchSize, std::vector<TokenIdType>(inLen, 0));
+                packedInputs.emplace(batchSize, batchSize * inLen, allocator);
+                packedInputs->pack(inputIds, PackedEncoderBatch{0, batchSize, batchSize * inLen, inLen});
+                packedInputs->insertInputTensors(tensorMap);
+            }
+            else
+            {
+                // input_ids
+                std::vector<SizeType> inputIdsHost(batchSize * inLen, inLen);
+                auto inputIdsBuffer = std::shared_ptr<ITensor>{
+                    allocator.copyFrom(inputIdsHost, ITensor::makeShape({batchSize, inLen}), MemoryType::kGPU)};
+                allocator.setZero(*inputIdsBuffer);
+                tensorMap.insert(std::make_pair("input_ids", inputIdsBuffer));
+                // input_lengths
+                std::vector<SizeType> inputLengthsHost(batchSize);
+                auto inLensBuffer = std::shared_ptr<ITensor>{
+                    allocator.copyFrom(inputLengthsHost, ITensor::makeShape({batchSize}), MemoryType::kGPU)};
+                allocator.setZero(*inLensBuffer);
+                tensorMap.insert(std::make_pair("input_lengths", inLensBuffer));
+            }
 
             rt->setInputTensors(0, tensorMap);
             rt->setOutputTensors(0, tensorMap);
@@ -141,6 +213,119 @@ void benchmarkBert(std::string const& modelName, std::filesystem::path const& da
     }
 }
 
+// Runs requests of lengths drawn from a distribution in batches of at most batchSize requests and, with packed
+// inputs, of at most maxNumTokens tokens. Padded engines run each batch padded to its longest request.
+void benchmarkBertLengthDistribution(std::string const& modelName, std::filesystem::path const& dataPath,
+    std::string const& distribution, SizeType numRequests, SizeType batchSize, std::optional<SizeType> maxNumTokensArg,
+    unsigned int seed, std::shared_ptr<nvinfer1::ILogger> const& logger, int warmUp, int numRuns, int duration)
+{
+    auto const worldConfig = WorldConfig::mpi();
+    auto const enginePath = dataPath / engineFilename(dataPath, worldConfig, modelName);
+    auto engineBlob = loadEngine(enginePath.string());
+
+    auto rt = std::make_shared<TllmRuntime>(engineBlob.data(), engineBlob.size(), *logger);
+    rt->addContext(0);
+    auto& allocator = rt->getBufferManager();
+
+    auto const limits = engineLimits(dataPath);
+    TLLM_CHECK_WITH_INFO(limits.maxInputLen > 0, "The engine config does not set max_input_len");
+    TLLM_CHECK_WITH_INFO(numRequests > 0, "num_requests must be positive");
+    auto const lengths = sampleInputLengths(distribution, numRequests, limits.maxInputLen, seed);
+    std::vector<std::vector<TokenIdType>> inputIds;
+    for (auto const length : lengths)
+    {
+        inputIds.emplace_back(length, 0);
+    }
+
+    auto const maxNumTokens = maxNumTokensArg.value_or(limits.maxNumTokens);
+    auto const batches = limits.removeInputPadding
+        ? PackedEncoderInputs::batchByTokens(lengths, maxNumTokens, batchSize)
+        : PackedEncoderInputs::batchByTokens(lengths, batchSize * limits.maxInputLen, batchSize);
+
+    std::optional<PackedEncoderInputs> packedInputs;
+    ITensor::SharedPtr paddedInputIds;
+    ITensor::SharedPtr paddedInputLengths;
+    if (limits.removeInputPadding)
+    {
+        packedInputs.emplace(batchSize, maxNumTokens, allocator);
+    }
+    else
+    {
+        paddedInputIds
+            = allocator.gpu(ITensor::makeShape({batchSize * limits.maxInputLen}), nvinfer1::DataType::kINT32);
+        allocator.setZero(*paddedInputIds);
+        paddedInputLengths = allocator.gpu(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+    }
+
+    TllmRuntime::TensorMap tensorMap{};
+    auto const runBatch = [&](PackedEncoderBatch const& batch)
+    {
+        if (packedInputs)
+        {
+            packedInputs->pack(inputIds, batch);
+            packedInputs->insertInputTensors(tensorMap);
+        }
+        else
+        {
+            // The token values do not matter, only the lengths
+            ITensor::SharedPtr inputIdsView
+                = ITensor::slice(paddedInputIds, 0, batch.numRequests * batch.maxInputLength);
+            inputIdsView->reshape(ITensor::makeShape({batch.numRequests, batch.maxInputLength}));
+            ITensor::SharedPtr inputLengthsView = ITensor::slice(paddedInputLengths, 0, batch.numRequests);
+            allocator.copy(lengths.data() + batch.firstRequest, *inputLengthsView, MemoryType::kCPU);
+            tensorMap.insert_or_assign("input_ids", inputIdsView);
+            tensorMap.insert_or_assign("input_lengths", inputLengthsView);
+        }
+        rt->setInputTensors(0, tensorMap);
+        rt->setOutputTensors(0, tensorMap);
+        rt->executeContext(0);
+    };
+
+    for (auto r = 0; r < warmUp; ++r)
+    {
+        runBatch(batches.at(r % batches.size()));
+    }
+    rt->getStream().synchronize();
+
+    std::int64_t numTokens{0};
+    std::int64_t numPaddedTokens{0};
+    for (auto const& batch : batches)
+    {
+        numTokens += batch.numTokens;
+        numPaddedTokens += static_cast<std::int64_t>(batch.numRequests) * batch.maxInputLength;
+    }
+
+    // A run goes through all the requests
+    int runIdx = 0;
+    float curDuration = 0;
+    while (runIdx < numRuns || curDuration / 1000 < duration)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        for (auto const& batch : batches)
+        {
+            runBatch(batch);
+        }
+        rt->getStream().synchronize();
+        auto const end = std::chrono::steady_clock::now();
+
+        runIdx += 1;
+        curDuration
+            += (static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()) / 1000);
+    }
+    printf("Benchmarking done. Iteration: %d, duration: %.2f sec.\n", runIdx, curDuration / 1000);
+
+    auto const runLatencySec = curDuration / runIdx / 1000;
+    if (worldConfig.getRank() == 0)
+    {
+        printf(
+            "[BENCHMARK] input_len_dist %s num_requests %d remove_input_padding %d num_batches %zu "
+            "batch_latency(ms) %.2f tokens_per_sec %.1f sequences_per_sec %.1f padding(%%) %.1f\n",
+            distribution.c_str(), numRequests, limits.removeInputPadding ? 1 : 0, batches.size(),
+            curDuration / runIdx / batches.size(), numTokens / runLatencySec, numRequests / runLatencySec,
+            limits.removeInputPadding ? 0.f : 100.f * (numPaddedTokens - numTokens) / numPaddedTokens);
+    }
+}
+
 } // namespace
 
 int main(int argc, char* argv[])
@@ -159,6 +344,19 @@ int main(int argc, char* argv[])
         "separated by \";\", example: \"60;128\".",
         cxxopts::value<std::string>()->default_value("128"));
 
+    options.add_options()("input_len_dist",
+        "Benchmark requests of random lengths instead of the batch_size x input_len grid, with batch_size requests per "
+        "batch at most. Either \"uniform:min,max\" or \"normal:mean,stddev\".",
+        cxxopts::value<std::string>());
+    options.add_options()("num_requests", "Number of requests drawn from input_len_dist.",
+        cxxopts::value<int>()->default_value("1000"));
+    options.add_options()("max_num_tokens",
+        "Maximum number of tokens of a batch of requests drawn from input_len_dist, for engines with packed inputs. "
+        "Defaults to max_num_tokens of the engine.",
+        cxxopts::value<int>());
+    options.add_options()(
+        "random_seed", "Seed of the lengths drawn from input_len_dist.", cxxopts::value<int>()->default_value("0"));
+
     options.add_options()("log_level", "Choose log level between verbose/info/warning/error/internal_error.",
         cxxopts::value<std::string>()->default_value("error"));
     options.add_options()(
@@ -234,8 +432,22 @@ int main(int argc, char* argv[])
 
     try
     {
-        benchmarkBert(result["model"].as<std::string>(), result["engine_dir"].as<std::string>(), batchSizes, inLens,
-            logger, result["warm_up"].as<int>(), result["num_runs"].as<int>(), result["duration"].as<int>());
+        if (result.count("input_len_dist"))
+        {
+            auto const maxNumTokens = result.count("max_num_tokens")
+                ? std::optional<SizeType>{result["max_num_tokens"].as<int>()}
+                : std::nullopt;
+            benchmarkBertLengthDistribution(result["model"].as<std::string>(), result["engine_dir"].as<std::string>(),
+                result["input_len_dist"].as<std::string>(), result["num_requests"].as<int>(), batchSizes.front(),
+                maxNumTokens, result["random_seed"].as<int>(), logger, result["warm_up"].as<int>(),
+                result["num_runs"].as<int>(), result["duration"].as<int>());
+        }
+        else
+        {
+            benchmarkBert(result["model"].as<std::string>(), result["engine_dir"].as<std::string>(), batchSizes,
+                inLens, logger, result["warm_up"].as<int>(), result["num_runs"].as<int>(),
+                result["duration"].as<int>());
+        }
     }
     catch (const std::exception& e)
     {
@@ -0,0 +1,602 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/plugins/api/tllmPlugin.h"
+#include "tensorrt_llm/runtime/gptJsonConfig.h"
+#include "tensorrt_llm/runtime/gptSession.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+#include "tensorrt_llm/runtime/tllmLogger.h"
+
+#include <NvInfer.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace tc = tensorrt_llm::common;
+namespace trt = nvinfer1;
+
+namespace
+{
+// Least squares fit of y = sum_k coefficients[k] * features[k]. The terms whose feature does not vary enough over the
+// samples to be told apart from the others get a zero coefficient.
+template <std::size_t N>
+std::array<double, N> fitLeastSquares(std::vector<std::array<double, N>> const& features, std::vector<double> const& y)
+{
+    // Normal equations [A^T A | A^T y], solved by Gaussian elimination with partial pivoting
+    std::array<std::array<double, N + 1>, N> system{};
+    for (std::size_t s = 0; s < features.size(); ++s)
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            for (std::size_t j = 0; j < N; ++j)
+            {
+                system[i][j] += features[s][i] * features[s][j];
+            }
+            system[i][N] += features[s][i] * y[s];
+        }
+    }
+
+    std::array<bool, N> used{};
+    std::array<std::size_t, N> pivotRows{};
+    for (std::size_t col = 0; col < N; ++col)
+    {
+        auto pivot = N;
+        for (std::size_t row = 0; row < N; ++row)
+        {
+            if (!used[row] && (pivot == N || std::abs(system[row][col]) > std::abs(system[pivot][col])))
+            {
+                pivot = row;
+            }
+        }
+        auto constexpr kEpsilon = 1e-9;
+        if (pivot == N || std::abs(system[pivot][col]) <= kEpsilon * (1. + std::abs(system[col][col])))
+        {
+            pivotRows[col] = N;
+            continue;
+        }
+        used[pivot] = true;
+        pivotRows[col] = pivot;
+        for (std::size_t row = 0; row < N; ++row)
+        {
+            if (row == pivot)
+            {
+                continue;
+            }
+            auto const factor = system[row][col] / system[pivot][col];
+            for (std::size_t k = col; k <= N; ++k)
+            {
+                system[row][k] -= factor * system[pivot][k];
+            }
+        }
+    }
+
+    std::array<double, N> coefficients{};
+    for (std::size_t col = 0; col < N; ++col)
+    {
+        if (pivotRows[col] != N)
+        {
+            coefficients[col] = system[pivotRows[col]][N] / system[pivotRows[col]][col];
+        }
+    }
+    return coefficients;
+}
+
+// Latency in ms of a context step, a + b * tokens + c * attention, with attention the sum of the squared input
+// lengths of the batch. Features in thousands of tokens and millions of squared tokens to keep the fit conditioned.
+struct ContextModel
+{
+    std::array<double, 3> coefficients{};
+
+    static std::array<double, 3> features(double batchSize, double inputLength)
+    {
+        return {1., batchSize * inputLength / 1e3, batchSize * inputLength * inputLength / 1e6};
+    }
+
+    [[nodiscard]] double predict(double batchSize, double inputLength) const
+    {
+        auto const x = features(batchSize, inputLength);
+        return std::max(0., coefficients[0] * x[0] + coefficients[1] * x[1] + coefficients[2] * x[2]);
+    }
+};
+
+// Latency in ms of a generation step, a + b * batchSize + c * kvTokens, with kvTokens the KV cache tokens read by
+// the attention of the batch.
+struct GenerationModel
+{
+    std::array<double, 3> coefficients{};
+
+    static std::array<double, 3> features(double batchSize, double sequenceLength)
+    {
+        return {1., batchSize, batchSize * sequenceLength / 1e3};
+    }
+
+    [[nodiscard]] double predict(double batchSize, double sequenceLength) const
+    {
+        auto const x = features(batchSize, sequenceLength);
+        return std::max(0., coefficients[0] * x[0] + coefficients[1] * x[1] + coefficients[2] * x[2]);
+    }
+};
+
+struct Measurement
+{
+    int batchSize;
+    int inputLength;
+    float contextMs;
+    // Latency of each generation step, the KV cache holds inputLength + step tokens during step
+    std::vector<float> generationStepMs;
+};
+
+struct MemoryProfile
+{
+    std::size_t totalBytes;
+    // Weights, activations and runtime buffers, everything but the KV cache
+    std::size_t fixedBytes;
+    double kvBytesPerToken;
+};
+
+struct TrafficProfile
+{
+    int inputLength;
+    int outputLength;
+    float ttftSloMs;
+    float itlSloMs;
+};
+
+struct Recommendation
+{
+    int maxBatchSize;
+    int maxNumTokens;
+    int tokensPerBlock;
+    float kvCacheFreeGpuMemFraction;
+    // Limits of the batch size by the ITL SLO and by the memory
+    int itlBatchSize;
+    int memoryBatchSize;
+};
+
+// Start to end of each generation step of the last generation, over all its phases and micro batches
+std::map<SizeType, float> getStepLatencies(GptSession::GenerationProfiler& profiler)
+{
+    std::map<SizeType, std::pair<float, float>> spans;
+    for (auto const& record : profiler.getPhases())
+    {
+        auto const end = record.startMs + record.durationMs;
+        auto const [it, inserted] = spans.try_emplace(record.step, record.startMs, end);
+        if (!inserted)
+        {
+            it->second.first = std::min(it->second.first, record.startMs);
+            it->second.second = std::max(it->second.second, end);
+        }
+    }
+    std::map<SizeType, float> latencies;
+    for (auto const& [step, span] : spans)
+    {
+        latencies[step] = span.second - span.first;
+    }
+    return latencies;
+}
+
+Recommendation recommend(ContextModel const& contextModel, GenerationModel const& generationModel,
+    MemoryProfile const& memory, TrafficProfile const& traffic)
+{
+    Recommendation recommendation{};
+    auto const sequenceLength = traffic.inputLength + traffic.outputLength;
+
+    // The largest block that wastes less than 2% of the KV cache of a sequence on average, half a block per sequence
+    recommendation.tokensPerBlock = 16;
+    for (auto const tokensPerBlock : {32, 64, 128})
+    {
+        if (tokensPerBlock / 2. <= 0.02 * sequenceLength)
+        {
+            recommendation.tokensPerBlock = tokensPerBlock;
+        }
+    }
+
+    // Context steps of whole prompts of the profile within the TTFT SLO, in multiples of 64 tokens
+    auto constexpr kTokensGranularity = 64;
+    recommendation.maxNumTokens = 0;
+    for (auto numTokens = kTokensGranularity;; numTokens += kTokensGranularity)
+    {
+        auto const batchSize = std::max(1., static_cast<double>(numTokens) / traffic.inputLength);
+        if (contextModel.predict(batchSize, static_cast<double>(numTokens) / batchSize) > traffic.ttftSloMs
+            || numTokens > (1 << 20))
+        {
+            break;
+        }
+        recommendation.maxNumTokens = numTokens;
+    }
+
+    // Generation steps of sequences at their full length within the ITL SLO
+    recommendation.itlBatchSize = 0;
+    for (auto batchSize = 1; batchSize <= (1 << 16); ++batchSize)
+    {
+        if (generationModel.predict(batchSize, sequenceLength) > traffic.itlSloMs)
+        {
+            break;
+        }
+        recommendation.itlBatchSize = batchSize;
+    }
+
+    // Sequences at their full length, in whole blocks, in the memory left by the engine and its buffers
+    auto const blocksPerSequence = (sequenceLength + recommendation.tokensPerBlock - 1) / recommendation.tokensPerBlock;
+    auto const bytesPerSequence
+        = memory.kvBytesPerToken * static_cast<double>(blocksPerSequence * recommendation.tokensPerBlock);
+    auto const freeBytes = static_cast<double>(memory.totalBytes - std::min(memory.totalBytes, memory.fixedBytes));
+    // The allocator and the other processes on the device keep a share of the free memory
+    auto constexpr kMaxMemFraction = 0.95;
+    recommendation.memoryBatchSize = static_cast<int>(kMaxMemFraction * freeBytes / bytesPerSequence);
+
+    auto batchSize = std::min(recommendation.itlBatchSize, recommendation.memoryBatchSize);
+    if (batchSize >= 8)
+    {
+        batchSize -= batchSize % 8;
+    }
+    recommendation.maxBatchSize = batchSize;
+    recommendation.kvCacheFreeGpuMemFraction = freeBytes > 0.
+        ? std::min(kMaxMemFraction, std::ceil(100. * batchSize * bytesPerSequence / freeBytes) / 100.)
+        : 0.f;
+    return recommendation;
+}
+
+void adviseBuildConfig(std::string const& modelName, std::filesystem::path const& dataPath,
+    std::vector<int> const& batchSizes, std::vector<int> const& inputLengths, int generationSteps,
+    std::shared_ptr<nvinfer1::ILogger> const& logger, int warmUp, int numRuns, GptSession::Config& sessionConfig,
+    TrafficProfile const& traffic, std::optional<std::filesystem::path> const& outputCsv)
+{
+    auto const json = GptJsonConfig::parse(dataPath / "config.json");
+    auto const modelConfig = json.getModelConfig();
+    auto const inputPacked = modelConfig.usePackedInput();
+    SizeType deviceCount{0};
+    TLLM_CUDA_CHECK(cudaGetDeviceCount(&deviceCount));
+    auto const worldConfig = WorldConfig::mpi(deviceCount, json.getTensorParallelism(), json.getPipelineParallelism());
+    auto const enginePath = dataPath / json.engineFilename(worldConfig, modelName);
+    auto const maxNumTokens = modelConfig.getMaxNumTokens();
+
+    SamplingConfig samplingConfig{1};
+    samplingConfig.temperature = std::vector{1.0f};
+    samplingConfig.randomSeed = std::vector{static_cast<uint64_t>(42ull)};
+    samplingConfig.topK = std::vector{1};
+    samplingConfig.topP = std::vector{0.0f};
+    // Every sequence runs all the generation steps
+    samplingConfig.minLength = std::vector{generationSteps};
+
+    auto const maxBatchSize = *std::max_element(batchSizes.begin(), batchSizes.end());
+    auto const maxInputLength = *std::max_element(inputLengths.begin(), inputLengths.end());
+    sessionConfig.maxBatchSize = maxBatchSize;
+    sessionConfig.maxBeamWidth = 1;
+    sessionConfig.maxSequenceLength = maxInputLength + generationSteps;
+    sessionConfig.decoderPerRequest = false;
+    // A KV cache of known size, in whole blocks, to measure the bytes per token
+    auto const tokensPerBlock = modelConfig.usePagedKvCache() ? modelConfig.getTokensPerBlock() : 1;
+    auto const kvCacheTokens = (maxBatchSize * sessionConfig.maxSequenceLength + tokensPerBlock - 1) / tokensPerBlock
+        * tokensPerBlock;
+    sessionConfig.kvCacheConfig.maxTokens = kvCacheTokens;
+
+    GptSession session{sessionConfig, modelConfig, worldConfig, enginePath.string(), logger};
+    auto& bufferManager = session.getBufferManager();
+
+    auto& memoryCounters = MemoryCounters::getInstance();
+    auto const kvCacheBytes = memoryCounters.getTagged(MemoryType::kGPU, memoryCounters.getTagId("kv_cache"));
+    TLLM_CHECK_WITH_INFO(kvCacheBytes > 0, "The KV cache of the session is not accounted in the memory counters");
+    auto const [freeMem, totalMem] = tc::getDeviceMemoryInfo(false);
+    MemoryProfile const memory{totalMem, totalMem - freeMem - kvCacheBytes,
+        static_cast<double>(kvCacheBytes) / static_cast<double>(kvCacheTokens)};
+    TLLM_LOG_INFO(memoryCounters.tagsToString());
+
+    auto constexpr endId = 50256;
+    auto constexpr padId = 50256;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int32_t> tokenDist(0, modelConfig.getVocabSizePadded(worldConfig.getSize()) - 1);
+
+    std::vector<Measurement> measurements;
+    for (auto const batchSize : batchSizes)
+    {
+        for (auto const inputLength : inputLengths)
+        {
+            if (inputPacked && maxNumTokens && batchSize * inputLength > *maxNumTokens)
+            {
+                TLLM_LOG_WARNING("Skipping batch size %d and input length %d, above max_num_tokens %d", batchSize,
+                    inputLength, *maxNumTokens);
+                continue;
+            }
+            try
+            {
+                std::vector<SizeType> inputLengthsHost(batchSize, inputLength);
+                auto inputLengthsDevice
+                    = bufferManager.copyFrom(inputLengthsHost, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+                std::vector<int32_t> inputsHost(batchSize * inputLength);
+                std::generate(inputsHost.begin(), inputsHost.end(), [&]() { return tokenDist(gen); });
+                auto inputIds = bufferManager.copyFrom(inputsHost,
+                    inputPacked ? ITensor::makeShape({batchSize * inputLength})
+                                : ITensor::makeShape({batchSize, inputLength}),
+                    MemoryType::kGPU);
+
+                GenerationInput generationInput{
+                    endId, padId, std::move(inputIds), std::move(inputLengthsDevice), inputPacked};
+                generationInput.maxNewTokens = generationSteps;
+                GenerationOutput generationOutput{
+                    bufferManager.emptyTensor(MemoryType::kGPU, nvinfer1::DataType::kINT32),
+                    bufferManager.emptyTensor(MemoryType::kGPU, nvinfer1::DataType::kINT32)};
+
+                for (auto r = 0; r < warmUp; ++r)
+                {
+                    session.generate(generationOutput, generationInput, samplingConfig);
+                    bufferManager.getStream().synchronize();
+                }
+
+                // The context step runs before the generation profiler starts, it takes the rest of the latency
+                Measurement measurement{batchSize, inputLength, 0.f, std::vector<float>(generationSteps, 0.f)};
+                auto profiler = std::make_shared<GptSession::GenerationProfiler>(true);
+                for (auto r = 0; r < numRuns; ++r)
+                {
+                    auto const start = std::chrono::steady_clock::now();
+                    session.generate(generationOutput, generationInput, samplingConfig, profiler);
+                    bufferManager.getStream().synchronize();
+                    auto const latencyMs
+                        = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    measurement.contextMs += (latencyMs - profiler->getElapsedTimeMs()) / numRuns;
+                    for (auto const& [step, stepMs] : getStepLatencies(*profiler))
+                    {
+                        if (1 <= step && step <= generationSteps)
+                        {
+                            measurement.generationStepMs[step - 1] += stepMs / numRuns;
+                        }
+                    }
+                }
+                measurements.push_back(std::move(measurement));
+            }
+            catch (std::runtime_error const& e)
+            {
+                if (std::string(e.what()).find("out of memory") == std::string::npos)
+                {
+                    throw;
+                }
+                TLLM_LOG_WARNING(
+                    "Skipping batch size %d and input length %d, out of memory", batchSize, inputLength);
+            }
+        }
+    }
+    TLLM_CHECK_WITH_INFO(!measurements.empty(), "No configuration of the sweep could be measured");
+
+    std::vector<std::array<double, 3>> contextFeatures;
+    std::vector<double> contextLatencies;
+    std::vector<std::array<double, 3>> generationFeatures;
+    std::vector<double> generationLatencies;
+    for (auto const& m : measurements)
+    {
+        contextFeatures.push_back(ContextModel::features(m.batchSize, m.inputLength));
+        contextLatencies.push_back(m.contextMs);
+        for (std::size_t step = 1; step < m.generationStepMs.size(); ++step)
+        {
+            // The first step also captures the CUDA graphs and warms up the decoder, it is left out
+            generationFeatures.push_back(
+                GenerationModel::features(m.batchSize, m.inputLength + static_cast<double>(step) + 1.));
+            generationLatencies.push_back(m.generationStepMs[step]);
+        }
+    }
+    ContextModel const contextModel{fitLeastSquares(contextFeatures, contextLatencies)};
+    GenerationModel const generationModel{fitLeastSquares(generationFeatures, generationLatencies)};
+    auto const recommendation = recommend(contextModel, generationModel, memory, traffic);
+
+    if (worldConfig.getRank() != 0)
+    {
+        return;
+    }
+
+    for (auto const& m : measurements)
+    {
+        auto const steps = std::max<std::size_t>(m.generationStepMs.size(), 2) - 1;
+        auto const generationMs
+            = std::accumulate(m.generationStepMs.begin() + 1, m.generationStepMs.end(), 0.f) / steps;
+        printf("[MEASURE] batch_size %d input_length %d context(ms) %.3f predicted %.3f generation_step(ms) %.3f "
+               "predicted %.3f\n",
+            m.batchSize, m.inputLength, m.contextMs, contextModel.predict(m.batchSize, m.inputLength), generationMs,
+            generationModel.predict(m.batchSize, m.inputLength + generationSteps / 2.));
+    }
+    auto const& c = contextModel.coefficients;
+    auto const& g = generationModel.coefficients;
+    printf("[MODEL] context(ms) = %.4f + %.4f * ktokens + %.4f * Msquared_tokens\n", c[0], c[1], c[2]);
+    printf("[MODEL] generation_step(ms) = %.4f + %.4f * batch_size + %.4f * kkv_tokens\n", g[0], g[1], g[2]);
+    printf("[MEMORY] total(gb) %.2f fixed(gb) %.2f kv_bytes_per_token %.1f\n", memory.totalBytes / 1e9,
+        memory.fixedBytes / 1e9, memory.kvBytesPerToken);
+    printf("[RECOMMEND] max_batch_size %d (itl %d memory %d) max_num_tokens %d tokens_per_block %d "
+           "kv_cache_free_gpu_mem_fraction %.2f\n",
+        recommendation.maxBatchSize, recommendation.itlBatchSize, recommendation.memoryBatchSize,
+        recommendation.maxNumTokens, recommendation.tokensPerBlock, recommendation.kvCacheFreeGpuMemFraction);
+    if (recommendation.maxNumTokens < traffic.inputLength)
+    {
+        printf("[RECOMMEND] A prompt of %d tokens misses the TTFT SLO of %.1f ms alone\n", traffic.inputLength,
+            traffic.ttftSloMs);
+    }
+    if (recommendation.itlBatchSize == 0)
+    {
+        printf("[RECOMMEND] A single sequence misses the ITL SLO of %.1f ms\n", traffic.itlSloMs);
+    }
+    auto const maxMeasuredBatchSize = std::max_element(measurements.begin(), measurements.end(),
+        [](auto const& a, auto const& b) { return a.batchSize < b.batchSize; })->batchSize;
+    if (recommendation.maxBatchSize > 2 * maxMeasuredBatchSize)
+    {
+        printf("[RECOMMEND] max_batch_size is extrapolated beyond the measured batch sizes, confirm it with a "
+               "larger --batch_size\n");
+    }
+
+    if (outputCsv)
+    {
+        std::ofstream file(*outputCsv);
+        TLLM_CHECK_WITH_INFO(file.good(), "Cannot open %s for writing", outputCsv->string().c_str());
+        file << "batch_size,input_length,step,context_ms,generation_step_ms\n";
+        for (auto const& m : measurements)
+        {
+            for (std::size_t step = 0; step < m.generationStepMs.size(); ++step)
+            {
+                file << m.batchSize << "," << m.inputLength << "," << step + 1 << "," << m.contextMs << ","
+                     << m.generationStepMs[step] << "\n";
+            }
+        }
+        printf("Measurements written to %s\n", outputCsv->string().c_str());
+    }
+}
+
+std::vector<int> parseIntList(std::string const& arg)
+{
+    std::istringstream stream(arg);
+    std::vector<int> values;
+    for (std::string token; std::getline(stream, token, ';');)
+    {
+        values.push_back(std::stoi(token));
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options("TensorRT-LLM Build Config Advisor",
+        "Measures an engine over synthetic batches and recommends its build limits for a traffic profile and SLOs.");
+    options.add_options()("h,help", "Print usage");
+    options.add_options()(
+        "m,model", "Model name specified for engines.", cxxopts::value<std::string>()->default_value("gpt_350m"));
+    options.add_options()("engine_dir", "Directory that store the engines.", cxxopts::value<std::string>());
+    options.add_options()("batch_size", "Batch sizes of the sweep, separated by \";\", example: \"1;8;32\".",
+        cxxopts::value<std::string>()->default_value("1;4;16;32"));
+    options.add_options()("input_len", "Input lengths of the sweep, separated by \";\", example: \"128;512\".",
+        cxxopts::value<std::string>()->default_value("128;512;1024"));
+    options.add_options()("generation_steps", "Generation steps measured for each batch of the sweep.",
+        cxxopts::value<int>()->default_value("32"));
+    options.add_options()("profile_input_len", "Average input length of the traffic.",
+        cxxopts::value<int>()->default_value("512"));
+    options.add_options()("profile_output_len", "Average output length of the traffic.",
+        cxxopts::value<int>()->default_value("128"));
+    options.add_options()(
+        "ttft_slo", "Time to first token SLO (ms) of the traffic.", cxxopts::value<float>()->default_value("500"));
+    options.add_options()(
+        "itl_slo", "Inter-token latency SLO (ms) of the traffic.", cxxopts::value<float>()->default_value("50"));
+    options.add_options()("output_csv", "Write the measured step latencies to this CSV file.",
+        cxxopts::value<std::string>());
+
+    options.add_options()("log_level", "Choose log level between verbose/info/warning/error/internal_error.",
+        cxxopts::value<std::string>()->default_value("error"));
+    options.add_options()(
+        "warm_up", "Specify warm up iterations before each measurement.", cxxopts::value<int>()->default_value("1"));
+    options.add_options()(
+        "num_runs", "Number of iterations averaged by each measurement.", cxxopts::value<int>()->default_value("3"));
+    options.add_options()("enable_cuda_graph", "Execute GPT session with CUDA graph.");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        exit(0);
+    }
+
+    // Argument: Engine directory
+    if (!result.count("engine_dir"))
+    {
+        std::cout << options.help() << std::endl;
+        TLLM_LOG_ERROR("Please specify engine directory.");
+        return 1;
+    }
+
+    // Argument: Sweep
+    auto const batchSizes = parseIntList(result["batch_size"].as<std::string>());
+    auto const inputLengths = parseIntList(result["input_len"].as<std::string>());
+    auto const generationSteps = result["generation_steps"].as<int>();
+    auto const numRuns = result["num_runs"].as<int>();
+    if (batchSizes.empty() || inputLengths.empty() || generationSteps < 2 || numRuns < 1)
+    {
+        TLLM_LOG_ERROR("The sweep needs batch sizes, input lengths, 2 generation steps and 1 run at least.");
+        return 1;
+    }
+
+    // Argument: Traffic profile
+    TrafficProfile const traffic{result["profile_input_len"].as<int>(), result["profile_output_len"].as<int>(),
+        result["ttft_slo"].as<float>(), result["itl_slo"].as<float>()};
+    if (traffic.inputLength <= 0 || traffic.outputLength <= 0 || traffic.ttftSloMs <= 0.f || traffic.itlSloMs <= 0.f)
+    {
+        TLLM_LOG_ERROR("The lengths and SLOs of the traffic profile must be positive.");
+        return 1;
+    }
+
+    // Argument: Log level
+    auto logger = std::make_shared<TllmLogger>();
+    auto const logLevel = result["log_level"].as<std::string>();
+    if (logLevel == "verbose")
+    {
+        logger->setLevel(trt::ILogger::Severity::kVERBOSE);
+    }
+    else if (logLevel == "info")
+    {
+        logger->setLevel(trt::ILogger::Severity::kINFO);
+    }
+    else if (logLevel == "warning")
+    {
+        logger->setLevel(trt::ILogger::Severity::kWARNING);
+    }
+    else if (logLevel == "error")
+    {
+        logger->setLevel(trt::ILogger::Severity::kERROR);
+    }
+    else if (logLevel == "internal_error")
+    {
+        logger->setLevel(trt::ILogger::Severity::kINTERNAL_ERROR);
+    }
+    else
+    {
+        TLLM_LOG_ERROR("Unexpected log level: " + logLevel);
+        return 1;
+    }
+
+    GptSession::Config sessionConfig{0, 0, 0};
+    sessionConfig.cudaGraphMode = result.count("enable_cuda_graph") > 0;
+
+    std::optional<std::filesystem::path> outputCsv;
+    if (result.count("output_csv"))
+    {
+        outputCsv = result["output_csv"].as<std::string>();
+    }
+
+    initTrtLlmPlugins(logger.get());
+
+    try
+    {
+        adviseBuildConfig(result["model"].as<std::string>(), result["engine_dir"].as<std::string>(), batchSizes,
+            inputLengths, generationSteps, logger, result["warm_up"].as<int>(), numRuns, sessionConfig, traffic,
+            outputCsv);
+    }
+    catch (const std::exception& e)
+    {
+        TLLM_LOG_ERROR(e.what());
+        return 1;
+    }
+    return 0;
+}
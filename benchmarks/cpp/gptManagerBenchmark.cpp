@@ -23,17 +23,29 @@
 #include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/common/stringUtils.h"
 #include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/speculativeExecutor.h"
+#include "tensorrt_llm/executor/tensor.h"
 #include "tensorrt_llm/plugins/api/tllmPlugin.h"
+#include "tensorrt_llm/runtime/gptJsonConfig.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <cxxopts.hpp>
 #include <iostream>
+#include <list>
+#include <map>
 #include <nlohmann/json.hpp>
+#include <queue>
+#include <random>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 
 using namespace tensorrt_llm::batch_manager;
@@ -47,6 +59,15 @@ namespace trt = nvinfer1;
 namespace
 {
 
+enum class SpeculativeDecodingMode
+{
+    kNONE,
+    // The engine has Medusa heads
+    kMEDUSA,
+    // The requests carry draft tokens with a synthetic acceptance
+    kDRAFT,
+};
+
 struct BenchmarkParams
 {
     std::optional<SizeType> maxTokensInPagedKvCache = std::nullopt;
@@ -55,6 +76,44 @@ struct BenchmarkParams
     bool enableBlockReuse = false;
     bool enableChunkedContext = false;
     bool streaming = false;
+    // Service level objectives for the goodput, only checked when streaming
+    std::optional<float> ttftSloMs = std::nullopt;
+    std::optional<float> itlSloMs = std::nullopt;
+    // Load points of the run, either open loop with a Poisson or gamma arrival process of the given request rates
+    // (req/sec), or closed loop with the given numbers of requests in flight. Without either, the requests arrive with
+    // the delays of the dataset.
+    std::vector<float> requestRates;
+    std::vector<SizeType> concurrencies;
+    // Shape of the gamma distribution of the inter-arrival times, 1 is a Poisson process, lower is burstier.
+    float burstiness = 1.f;
+    int randomSeed = 0;
+    // Multi-LoRA load, disabled without adapters. The rank of each adapter is drawn from loraRanks with the weights
+    // loraRankWeights (uniform if empty), the adapter of each request from a uniform or Zipf popularity.
+    SizeType numLoraAdapters = 0;
+    std::vector<SizeType> loraRanks;
+    std::vector<float> loraRankWeights;
+    bool loraZipf = false;
+    float loraZipfExponent = 1.f;
+    // Capacity in adapters of the LRU cache of the hit rate, 0 for an unbounded cache
+    SizeType loraCacheAdapters = 0;
+    // Speculative decoding, with the executor API. The draft tokens follow the reference output of the target model
+    // and each one is accepted with the probability draftAcceptance, unless the sample of the dataset has its own.
+    SpeculativeDecodingMode speculativeDecodingMode = SpeculativeDecodingMode::kNONE;
+    SizeType maxDraftTokens = 4;
+    float draftAcceptance = 0.8f;
+    // Replay the dataset as a trace of conversations, the next turn of a session arriving thinkTime seconds after the
+    // response to the previous one
+    bool conversations = false;
+    float thinkTime = 1.f;
+};
+
+// Cumulative KV cache block counters of the batch manager, from its iteration statistics
+struct KvCacheCounters
+{
+    std::uint64_t allocTotalBlocks{0};
+    std::uint64_t allocNewBlocks{0};
+    std::uint64_t reusedBlocks{0};
+    SizeType tokensPerBlock{0};
 };
 } // namespace
 
@@ -206,28 +265,59 @@ struct BenchInfo
     int outputLength;
     std::chrono::time_point<std::chrono::steady_clock> start;
     std::chrono::time_point<std::chrono::steady_clock> end;
-    float latency; // millisecond
+    std::chrono::time_point<std::chrono::steady_clock> firstTokenTs;
+    int numGeneratedTokens{0};
+    float latency;             // millisecond
+    float firstTokenLatency{}; // millisecond, time to first token
+    float avgGenT2TLatency{};  // millisecond, average inter-token latency after the first token
+    std::optional<SizeType> loraAdapter;
 };
 
 class Recorder
 {
 public:
-    explicit Recorder(std::string opCsvFile)
+    explicit Recorder(std::string opCsvFile, BenchmarkParams const& benchmarkParams = {})
         : mOpCsvFile(std::move(opCsvFile))
+        , mStreaming(benchmarkParams.streaming)
+        , mTtftSloMs(benchmarkParams.ttftSloMs)
+        , mItlSloMs(benchmarkParams.itlSloMs)
+        , mLoraCacheAdapters(benchmarkParams.loraCacheAdapters)
+        , mSpeculative(benchmarkParams.speculativeDecodingMode != SpeculativeDecodingMode::kNONE)
     {
     }
 
     void initialize()
     {
+        mRequestBenchInfos.clear();
+        mLoraArrivals.clear();
+        mSpecDecodingStats = {};
+        mTurns.clear();
+        {
+            std::lock_guard<std::mutex> lock(mKvCacheMutex);
+            mKvCacheCountersAtStart = mKvCacheCounters;
+        }
         mStart = std::chrono::steady_clock::now();
     }
 
+    // Ranks of the LoRA adapters of a multi-LoRA load, whose metrics are then reported per adapter.
+    void setLoraRanks(std::vector<SizeType> loraRanks)
+    {
+        mLoraRanks = std::move(loraRanks);
+    }
+
+    // The metrics of a sweep are reported and written to the CSV with the load of each point.
+    void setSweepPoint(std::string name, float value)
+    {
+        mSweepPoint = std::make_pair(std::move(name), value);
+    }
+
     void finalize()
     {
         mEnd = std::chrono::steady_clock::now();
     }
 
-    void recordStart(std::shared_ptr<InferenceRequest> request, uint64_t requestId)
+    void recordStart(std::shared_ptr<InferenceRequest> request, uint64_t requestId,
+        std::optional<SizeType> loraAdapter = std::nullopt)
     {
         auto const inputLength = request->getInputIds()->getSize();
         auto const maxNewTokens = request->getMaxNewTokensNamed();
@@ -236,21 +326,67 @@ public:
             "Undefined scalar vector for %s", maxNewTokens.name.c_str());
         auto const outputLength = *bufferCast<SizeType>(*outputLengthTensor);
         auto const start = std::chrono::steady_clock::now();
-        mRequestBenchInfos[requestId] = BenchInfo(inputLength, outputLength, start);
+        recordStart(inputLength, outputLength, requestId, start, loraAdapter);
     }
 
     void recordStart(SizeType inputLength, SizeType maxNewTokens, uint64_t requestId,
-        std::chrono::time_point<std::chrono::steady_clock> const& start)
+        std::chrono::time_point<std::chrono::steady_clock> const& start,
+        std::optional<SizeType> loraAdapter = std::nullopt)
     {
-        mRequestBenchInfos[requestId] = BenchInfo(inputLength, maxNewTokens, start);
+        auto& info = mRequestBenchInfos[requestId];
+        info = BenchInfo(inputLength, maxNewTokens, start);
+        info.loraAdapter = loraAdapter;
+        if (loraAdapter)
+        {
+            mLoraArrivals.push_back(*loraAdapter);
+        }
+    }
+
+    // A response with numTokens new tokens per beam, the first one sets the time to first token.
+    void recordToken(uint64_t requestId, int numTokens = 1)
+    {
+        auto& info = mRequestBenchInfos[requestId];
+        if (info.numGeneratedTokens == 0 && numTokens > 0)
+        {
+            info.firstTokenTs = std::chrono::steady_clock::now();
+        }
+        info.numGeneratedTokens += numTokens;
+    }
+
+    // Turn of a request of a conversation, whose prompt starts with the numHistoryTokens tokens of the previous turns.
+    // Called before the request is enqueued.
+    void recordTurn(uint64_t requestId, SizeType turn, SizeType numHistoryTokens)
+    {
+        mTurns[requestId] = std::make_pair(turn, numHistoryTokens);
+    }
+
+    // Called by the batch manager on each iteration
+    void recordKvCacheCounters(KvCacheCounters const& counters)
+    {
+        std::lock_guard<std::mutex> lock(mKvCacheMutex);
+        mKvCacheCounters = counters;
+    }
+
+    // Acceptance of the draft tokens of a finished request
+    void recordSpecDecodingStats(texec::SpeculativeDecodingStats const& stats)
+    {
+        mSpecDecodingStats.merge(stats);
     }
 
     void recordEnd(uint64_t requestId)
     {
-        mRequestBenchInfos[requestId].end = std::chrono::steady_clock::now();
-        mRequestBenchInfos[requestId].latency = std::chrono::duration<float, std::milli>(
-            mRequestBenchInfos[requestId].end - mRequestBenchInfos[requestId].start)
-                                                    .count();
+        auto& info = mRequestBenchInfos[requestId];
+        info.end = std::chrono::steady_clock::now();
+        info.latency = std::chrono::duration<float, std::milli>(info.end - info.start).count();
+        if (mStreaming && info.numGeneratedTokens > 0)
+        {
+            info.firstTokenLatency = std::chrono::duration<float, std::milli>(info.firstTokenTs - info.start).count();
+            if (info.numGeneratedTokens > 1)
+            {
+                info.avgGenT2TLatency = std::chrono::duration<float, std::milli>(info.end - info.firstTokenTs).count()
+                    / static_cast<float>(info.numGeneratedTokens - 1);
+            }
+        }
     }
 
     void calculateMetrics()
@@ -260,22 +396,95 @@ public:
         mSeqThroughput = mNumSamples / (mTotalLatency / 1000);
         mAvgSeqLatency = 0;
         int totalOutputTokens = 0;
-        for (auto reqInfo : mRequestBenchInfos)
+        int numGoodRequests = 0;
+        std::vector<float> seqLatencies;
+        std::vector<float> firstTokenLatencies;
+        std::vector<float> genT2TLatencies;
+        for (auto const& [requestId, reqInfo] : mRequestBenchInfos)
         {
-            mAvgSeqLatency += reqInfo.second.latency;
-            totalOutputTokens += reqInfo.second.outputLength;
+            mAvgSeqLatency += reqInfo.latency;
+            totalOutputTokens += reqInfo.outputLength;
+            seqLatencies.push_back(reqInfo.latency);
+            firstTokenLatencies.push_back(reqInfo.firstTokenLatency);
+            genT2TLatencies.push_back(reqInfo.avgGenT2TLatency);
+            numGoodRequests += (!mTtftSloMs || reqInfo.firstTokenLatency <= *mTtftSloMs)
+                    && (!mItlSloMs || reqInfo.avgGenT2TLatency <= *mItlSloMs)
+                ? 1
+                : 0;
         }
         mAvgSeqLatency /= mNumSamples;
         mTokenThroughput = totalOutputTokens / (mTotalLatency / 1000);
+
+        mSeqLatency = LatencyStats(seqLatencies);
+        mFirstTokenLatency = LatencyStats(firstTokenLatencies);
+        mGenT2TLatency = LatencyStats(genT2TLatencies);
+        mGoodputFraction = static_cast<float>(numGoodRequests) / mNumSamples;
+        mGoodput = numGoodRequests / (mTotalLatency / 1000);
+        calculateLoraMetrics();
+        calculateConversationMetrics();
     }
 
     void report()
     {
+        if (mSweepPoint)
+        {
+            printf("[BENCHMARK] %s %.2f\n", mSweepPoint->first.c_str(), mSweepPoint->second);
+        }
         printf("[BENCHMARK] num_samples %d\n", mNumSamples);
         printf("[BENCHMARK] total_latency(ms) %.2f\n", mTotalLatency);
         printf("[BENCHMARK] seq_throughput(seq/sec) %.2f\n", mSeqThroughput);
         printf("[BENCHMARK] avg_sequence_latency(ms) %.2f\n", mAvgSeqLatency);
         printf("[BENCHMARK] token_throughput(token/sec) %.2f\n", mTokenThroughput);
+        mSeqLatency.report("sequence_latency");
+        if (mStreaming)
+        {
+            mFirstTokenLatency.report("time_to_first_token");
+            mGenT2TLatency.report("inter_token_latency");
+            if (hasSlo())
+            {
+                printf("[BENCHMARK] goodput_fraction %.4f\n", mGoodputFraction);
+                printf("[BENCHMARK] goodput(seq/sec) %.2f\n", mGoodput);
+            }
+        }
+        if (mSpeculative)
+        {
+            printf("[BENCHMARK] acceptance_rate %.4f\n", mSpecDecodingStats.getAcceptanceRate());
+            printf("[BENCHMARK] tokens_per_forward_pass %.2f\n", mSpecDecodingStats.getTokensPerStep());
+            // Fraction of the verification steps accepting n draft tokens, up to the longest acceptance
+            auto const& histogram = mSpecDecodingStats.acceptanceLengthHistogram;
+            auto const numSteps = std::max<std::uint64_t>(mSpecDecodingStats.numSteps, 1);
+            auto const last = std::find_if(histogram.rbegin(), histogram.rend(), [](auto count) { return count > 0; });
+            printf("[BENCHMARK] acceptance_length_histogram");
+            for (auto it = histogram.begin(); it != last.base(); ++it)
+            {
+                printf(" %zd:%.4f", it - histogram.begin(), static_cast<float>(*it) / numSteps);
+            }
+            printf("\n");
+        }
+        if (mKvCacheReport)
+        {
+            printf("[BENCHMARK] kv_cache_reuse_hit_rate %.4f\n", mKvCacheReport->hitRate);
+            printf("[BENCHMARK] kv_cache_reused_blocks %lu\n", mKvCacheReport->reusedBlocks);
+            printf("[BENCHMARK] kv_cache_new_blocks %lu\n", mKvCacheReport->newBlocks);
+            if (!mTurnStats.empty())
+            {
+                printf("[BENCHMARK] kv_cache_evicted_history_blocks %lu\n", mKvCacheReport->evictedHistoryBlocks);
+            }
+        }
+        for (std::size_t turn = 0; turn < mTurnStats.size(); ++turn)
+        {
+            printf("[BENCHMARK] turn %zu", turn);
+            mTurnStats[turn].report(mStreaming);
+        }
+        if (!mLoraRanks.empty())
+        {
+            printf("[BENCHMARK] lora_cache_hit_rate %.4f\n", mLoraCacheHitRate);
+            for (std::size_t adapter = 0; adapter < mLoraStats.size(); ++adapter)
+            {
+                printf("[BENCHMARK] lora_adapter %zu rank %d", adapter, mLoraRanks[adapter]);
+                mLoraStats[adapter].report(mStreaming);
+            }
+        }
     }
 
     void writeOpMetricsToCsv()
@@ -284,18 +493,84 @@ public:
         {
             std::vector<std::string> headers = {"num_samples", "total_latency(ms)", "seq_throughput(seq/sec)",
                 "avg_sequence_latency(ms)", "token_throughput(token/sec)"};
+            std::vector<float> values
+                = {static_cast<float>(mNumSamples), mTotalLatency, mSeqThroughput, mAvgSeqLatency, mTokenThroughput};
+            mSeqLatency.append("sequence_latency", headers, values);
+            if (mStreaming)
+            {
+                mFirstTokenLatency.append("time_to_first_token", headers, values);
+                mGenT2TLatency.append("inter_token_latency", headers, values);
+                if (hasSlo())
+                {
+                    headers.insert(headers.end(), {"goodput_fraction", "goodput(seq/sec)"});
+                    values.insert(values.end(), {mGoodputFraction, mGoodput});
+                }
+            }
+            if (mSpeculative)
+            {
+                headers.insert(headers.end(), {"acceptance_rate", "tokens_per_forward_pass"});
+                values.insert(values.end(),
+                    {mSpecDecodingStats.getAcceptanceRate(), mSpecDecodingStats.getTokensPerStep()});
+                auto const& histogram = mSpecDecodingStats.acceptanceLengthHistogram;
+                auto const numSteps = std::max<std::uint64_t>(mSpecDecodingStats.numSteps, 1);
+                for (std::size_t length = 0; length < histogram.size(); ++length)
+                {
+                    headers.push_back("accepted_" + std::to_string(length) + "_fraction");
+                    values.push_back(static_cast<float>(histogram[length]) / numSteps);
+                }
+            }
+            if (mKvCacheReport)
+            {
+                headers.insert(headers.end(),
+                    {"kv_cache_reuse_hit_rate", "kv_cache_reused_blocks", "kv_cache_new_blocks",
+                        "kv_cache_evicted_history_blocks"});
+                values.insert(values.end(),
+                    {mKvCacheReport->hitRate, static_cast<float>(mKvCacheReport->reusedBlocks),
+                        static_cast<float>(mKvCacheReport->newBlocks),
+                        static_cast<float>(mKvCacheReport->evictedHistoryBlocks)});
+            }
+            for (std::size_t turn = 0; turn < mTurnStats.size(); ++turn)
+            {
+                mTurnStats[turn].append("turn" + std::to_string(turn) + "_", mStreaming, headers, values);
+            }
+            if (!mLoraRanks.empty())
+            {
+                // Every adapter has its columns, so that the rows of a sweep line up
+                headers.push_back("lora_cache_hit_rate");
+                values.push_back(mLoraCacheHitRate);
+                for (std::size_t adapter = 0; adapter < mLoraStats.size(); ++adapter)
+                {
+                    auto const prefix = "lora" + std::to_string(adapter) + "_";
+                    headers.push_back(prefix + "rank");
+                    values.push_back(static_cast<float>(mLoraRanks[adapter]));
+                    mLoraStats[adapter].append(prefix, mStreaming, headers, values);
+                }
+            }
+
+            if (mSweepPoint)
+            {
+                headers.insert(headers.begin(), mSweepPoint->first);
+                values.insert(values.begin(), mSweepPoint->second);
+            }
 
-            std::ofstream outputFile(mOpCsvFile);
+            // The points of a sweep are rows of the same file
+            std::ofstream outputFile(mOpCsvFile, mCsvHeaderWritten ? std::ios::app : std::ios::trunc);
 
             if (outputFile.is_open())
             {
-                for (const auto& header : headers)
+                if (!mCsvHeaderWritten)
                 {
-                    outputFile << header << ",";
+                    for (const auto& header : headers)
+                    {
+                        outputFile << header << ",";
+                    }
+                    outputFile << "\n";
+                    mCsvHeaderWritten = true;
+                }
+                for (std::size_t i = 0; i < values.size(); ++i)
+                {
+                    outputFile << (i > 0 ? "," : "") << values[i];
                 }
-                outputFile << "\n";
-                outputFile << mNumSamples << "," << mTotalLatency << "," << mSeqThroughput << "," << mAvgSeqLatency
-                           << "," << mTokenThroughput;
                 outputFile << "\n";
             }
             else
@@ -306,6 +581,212 @@ public:
     }
 
 private:
+    // Average and nearest-rank percentiles of a per-request latency
+    struct LatencyStats
+    {
+        LatencyStats() = default;
+
+        explicit LatencyStats(std::vector<float> latencies)
+        {
+            if (latencies.empty())
+            {
+                return;
+            }
+            std::sort(latencies.begin(), latencies.end());
+            auto const percentile = [&latencies](float p)
+            {
+                auto const rank = static_cast<std::size_t>(std::ceil(p / 100.f * latencies.size()));
+                return latencies[std::clamp<std::size_t>(rank, 1, latencies.size()) - 1];
+            };
+            for (auto const latency : latencies)
+            {
+                avg += latency;
+            }
+            avg /= latencies.size();
+            p50 = percentile(50);
+            p90 = percentile(90);
+            p99 = percentile(99);
+        }
+
+        void report(char const* name) const
+        {
+            printf("[BENCHMARK] avg_%s(ms) %.2f\n", name, avg);
+            printf("[BENCHMARK] p50_%s(ms) %.2f\n", name, p50);
+            printf("[BENCHMARK] p90_%s(ms) %.2f\n", name, p90);
+            printf("[BENCHMARK] p99_%s(ms) %.2f\n", name, p99);
+        }
+
+        void append(std::string const& name, std::vector<std::string>& headers, std::vector<float>& values) const
+        {
+            std::initializer_list<std::pair<char const*, float>> const percentiles{
+                {"p50_", p50}, {"p90_", p90}, {"p99_", p99}};
+            for (auto const& [prefix, value] : percentiles)
+            {
+                headers.push_back(prefix + name + "(ms)");
+                values.push_back(value);
+            }
+            if (name != "sequence_latency")
+            {
+                // The average sequence latency is already reported
+                headers.push_back("avg_" + name + "(ms)");
+                values.push_back(avg);
+            }
+        }
+
+        float avg{};
+        float p50{};
+        float p90{};
+        float p99{};
+    };
+
+    // Metrics of a group of requests, e.g. of a LoRA adapter or of a turn of the conversations
+    struct GroupStats
+    {
+        GroupStats() = default;
+
+        explicit GroupStats(std::vector<BenchInfo const*> const& infos)
+            : numSamples(static_cast<int>(infos.size()))
+        {
+            std::vector<float> seqLatencies;
+            std::vector<float> firstTokenLatencies;
+            for (auto const* info : infos)
+            {
+                seqLatencies.push_back(info->latency);
+                firstTokenLatencies.push_back(info->firstTokenLatency);
+            }
+            seqLatency = LatencyStats(std::move(seqLatencies));
+            firstTokenLatency = LatencyStats(std::move(firstTokenLatencies));
+        }
+
+        // Ends the line of the group
+        void report(bool streaming) const
+        {
+            printf(" num_samples %d sequence_latency(ms) avg %.2f p50 %.2f p90 %.2f p99 %.2f", numSamples,
+                seqLatency.avg, seqLatency.p50, seqLatency.p90, seqLatency.p99);
+            if (streaming)
+            {
+                printf(" time_to_first_token(ms) avg %.2f p50 %.2f p90 %.2f p99 %.2f", firstTokenLatency.avg,
+                    firstTokenLatency.p50, firstTokenLatency.p90, firstTokenLatency.p99);
+            }
+            printf("\n");
+        }
+
+        void append(std::string const& prefix, bool streaming, std::vector<std::string>& headers,
+            std::vector<float>& values) const
+        {
+            headers.push_back(prefix + "num_samples");
+            values.push_back(static_cast<float>(numSamples));
+            seqLatency.append(prefix + "sequence_latency", headers, values);
+            if (streaming)
+            {
+                firstTokenLatency.append(prefix + "time_to_first_token", headers, values);
+            }
+        }
+
+        int numSamples{};
+        LatencyStats seqLatency;
+        LatencyStats firstTokenLatency;
+    };
+
+    [[nodiscard]] bool hasSlo() const
+    {
+        return mTtftSloMs.has_value() || mItlSloMs.has_value();
+    }
+
+    void calculateLoraMetrics()
+    {
+        if (mLoraRanks.empty())
+        {
+            return;
+        }
+        std::vector<std::vector<BenchInfo const*>> adapterInfos(mLoraRanks.size());
+        for (auto const& [requestId, reqInfo] : mRequestBenchInfos)
+        {
+            if (reqInfo.loraAdapter)
+            {
+                adapterInfos.at(*reqInfo.loraAdapter).push_back(&reqInfo);
+            }
+        }
+        mLoraStats.clear();
+        for (auto const& infos : adapterInfos)
+        {
+            mLoraStats.emplace_back(infos);
+        }
+
+        // The manager does not expose the counters of its LoRA cache, the hit rate is the one of an LRU cache of
+        // adapters replayed over the arrivals of the requests.
+        std::list<SizeType> lru;
+        std::unordered_map<SizeType, std::list<SizeType>::iterator> cached;
+        int numHits = 0;
+        for (auto const adapter : mLoraArrivals)
+        {
+            if (auto const it = cached.find(adapter); it != cached.end())
+            {
+                ++numHits;
+                lru.splice(lru.begin(), lru, it->second);
+                continue;
+            }
+            if (mLoraCacheAdapters > 0 && static_cast<SizeType>(lru.size()) == mLoraCacheAdapters)
+            {
+                cached.erase(lru.back());
+                lru.pop_back();
+            }
+            cached[adapter] = lru.insert(lru.begin(), adapter);
+        }
+        mLoraCacheHitRate
+            = mLoraArrivals.empty() ? 0.f : static_cast<float>(numHits) / static_cast<float>(mLoraArrivals.size());
+    }
+
+    void calculateConversationMetrics()
+    {
+        std::vector<std::vector<BenchInfo const*>> turnInfos;
+        std::uint64_t numHistoryBlocks = 0;
+        KvCacheCounters counters;
+        KvCacheCounters countersAtStart;
+        {
+            std::lock_guard<std::mutex> lock(mKvCacheMutex);
+            counters = mKvCacheCounters;
+            countersAtStart = mKvCacheCountersAtStart;
+        }
+        for (auto const& [requestId, turn] : mTurns)
+        {
+            auto const& [turnIdx, numHistoryTokens] = turn;
+            if (static_cast<std::size_t>(turnIdx) >= turnInfos.size())
+            {
+                turnInfos.resize(turnIdx + 1);
+            }
+            turnInfos[turnIdx].push_back(&mRequestBenchInfos.at(requestId));
+            // The last token of the history has no KV yet, only the full blocks can be reused
+            if (counters.tokensPerBlock > 0 && numHistoryTokens > 0)
+            {
+                numHistoryBlocks += (numHistoryTokens - 1) / counters.tokensPerBlock;
+            }
+        }
+        mTurnStats.clear();
+        for (auto const& infos : turnInfos)
+        {
+            mTurnStats.emplace_back(infos);
+        }
+
+        mKvCacheReport.reset();
+        if (counters.allocTotalBlocks == 0)
+        {
+            // The batch manager does not report the counters, or block reuse is disabled
+            return;
+        }
+        auto const allocTotalBlocks = counters.allocTotalBlocks - countersAtStart.allocTotalBlocks;
+        auto const reusedBlocks = counters.reusedBlocks - countersAtStart.reusedBlocks;
+        KvCacheReport report;
+        report.hitRate
+            = allocTotalBlocks > 0 ? static_cast<float>(reusedBlocks) / static_cast<float>(allocTotalBlocks) : 0.f;
+        report.reusedBlocks = reusedBlocks;
+        report.newBlocks = counters.allocNewBlocks - countersAtStart.allocNewBlocks;
+        // The blocks of the histories that were not reused, evicted before the next turn of their session. An
+        // estimate, as blocks shared across sessions are reused too.
+        report.evictedHistoryBlocks = numHistoryBlocks > reusedBlocks ? numHistoryBlocks - reusedBlocks : 0;
+        mKvCacheReport = report;
+    }
+
     std::unordered_map<uint64_t, BenchInfo> mRequestBenchInfos;
 
     std::chrono::time_point<std::chrono::steady_clock> mStart;
@@ -315,7 +796,41 @@ private:
     float mSeqThroughput{};
     float mAvgSeqLatency{};
     float mTokenThroughput{};
+    LatencyStats mSeqLatency;
+    LatencyStats mFirstTokenLatency;
+    LatencyStats mGenT2TLatency;
+    float mGoodputFraction{};
+    float mGoodput{};
     std::string mOpCsvFile;
+    bool mStreaming;
+    std::optional<float> mTtftSloMs;
+    std::optional<float> mItlSloMs;
+    std::optional<std::pair<std::string, float>> mSweepPoint;
+    bool mCsvHeaderWritten{false};
+    SizeType mLoraCacheAdapters;
+    std::vector<SizeType> mLoraRanks;
+    // Adapters of the requests in the order of their arrival
+    std::vector<SizeType> mLoraArrivals;
+    std::vector<GroupStats> mLoraStats;
+    float mLoraCacheHitRate{};
+    bool mSpeculative;
+    texec::SpeculativeDecodingStats mSpecDecodingStats;
+
+    struct KvCacheReport
+    {
+        float hitRate{};
+        std::uint64_t reusedBlocks{};
+        std::uint64_t newBlocks{};
+        std::uint64_t evictedHistoryBlocks{};
+    };
+
+    // Turn and number of history tokens of the requests of conversations
+    std::unordered_map<uint64_t, std::pair<SizeType, SizeType>> mTurns;
+    std::vector<GroupStats> mTurnStats;
+    std::mutex mKvCacheMutex;
+    KvCacheCounters mKvCacheCounters;
+    KvCacheCounters mKvCacheCountersAtStart;
+    std::optional<KvCacheReport> mKvCacheReport;
 }; // class Recorder
 
 class ExecutorServer
@@ -342,7 +857,46 @@ public:
 
     ~ExecutorServer() {}
 
-    void enqueue(std::vector<texec::Request> requests, bool warmup = false)
+    // Outputs of the requests in their order, run before startSpeculativeDecoding
+    std::vector<texec::VecTokens> generate(std::vector<texec::Request> requests)
+    {
+        TLLM_CHECK(mSpeculativeExecutor == nullptr);
+        auto const reqIds = mExecutor->enqueueRequests(std::move(requests));
+        std::unordered_map<texec::IdType, std::size_t> indices;
+        for (std::size_t i = 0; i < reqIds.size(); ++i)
+        {
+            indices[reqIds[i]] = i;
+        }
+        std::vector<texec::VecTokens> outputs(reqIds.size());
+        std::size_t numFinished = 0;
+        while (numFinished < reqIds.size())
+        {
+            for (auto const& response : mExecutor->awaitResponses(std::nullopt, mWaitSleep))
+            {
+                TLLM_CHECK_WITH_INFO(!response.hasError(), "Request id %lu failed with err %s",
+                    response.getRequestId(), response.getErrorMsg().c_str());
+                auto const result = response.getResult();
+                auto& output = outputs.at(indices.at(response.getRequestId()));
+                output.insert(output.end(), result.outputTokenIds.front().begin(), result.outputTokenIds.front().end());
+                numFinished += result.isFinal ? 1 : 0;
+            }
+        }
+        return outputs;
+    }
+
+    // From now on, the requests are enqueued with their drafters and verified by the executor
+    void startSpeculativeDecoding(SizeType maxDraftTokens)
+    {
+        texec::SpeculativeExecutorConfig config;
+        config.maxDraftTokens = maxDraftTokens;
+        mSpeculativeExecutor = std::make_unique<texec::SpeculativeExecutor>(*mExecutor, config);
+    }
+
+    // loraAdapters holds the LoRA adapter of each request in a multi-LoRA load, drafters the drafter of each request
+    // after startSpeculativeDecoding, both are empty otherwise.
+    void enqueue(std::vector<texec::Request> requests, bool warmup = false,
+        std::vector<SizeType> const& loraAdapters = {},
+        std::vector<texec::SpeculativeExecutor::DraftFunc> drafters = {})
     {
         try
         {
@@ -353,12 +907,28 @@ public:
                 maxNewTokens.push_back(request.getMaxNewTokens());
             }
             auto const start = std::chrono::steady_clock::now();
-            auto reqIds = mExecutor->enqueueRequests(std::move(requests));
+            std::vector<texec::IdType> reqIds;
+            if (mSpeculativeExecutor)
+            {
+                TLLM_CHECK(drafters.size() == requests.size());
+                for (std::size_t req = 0; req < requests.size(); ++req)
+                {
+                    reqIds.push_back(
+                        mSpeculativeExecutor->enqueueRequest(std::move(requests[req]), std::move(drafters[req])));
+                }
+            }
+            else
+            {
+                reqIds = mExecutor->enqueueRequests(std::move(requests));
+            }
             for (int req = 0; req < reqIds.size(); ++req)
             {
                 if (!warmup)
                 {
-                    mRecorder->recordStart(inputLengths.at(req), maxNewTokens.at(req), reqIds.at(req), start);
+                    auto const loraAdapter
+                        = loraAdapters.empty() ? std::nullopt : std::optional<SizeType>{loraAdapters.at(req)};
+                    mRecorder->recordStart(
+                        inputLengths.at(req), maxNewTokens.at(req), reqIds.at(req), start, loraAdapter);
                 }
                 mActiveCount++;
             }
@@ -375,7 +945,8 @@ public:
         SizeType numFinished = 0;
         while (mActiveCount || (numRequests && numFinished < numRequests.value()))
         {
-            auto responses = mExecutor->awaitResponses(std::nullopt, mWaitSleep);
+            auto responses = mSpeculativeExecutor ? mSpeculativeExecutor->awaitResponses(std::nullopt, mWaitSleep)
+                                                  : mExecutor->awaitResponses(std::nullopt, mWaitSleep);
             for (auto const& response : responses)
             {
                 if (response.hasError())
@@ -385,31 +956,66 @@ public:
                         + response.getErrorMsg();
                     TLLM_THROW(errStr);
                 }
-                else if (response.getResult().isFinal)
+                else
                 {
                     auto reqId = response.getRequestId();
-                    mActiveCount--;
-                    numFinished++;
-                    if (!warmup)
+                    auto const& result = response.getResult();
+                    if (!warmup && !result.outputTokenIds.empty())
                     {
-                        mRecorder->recordEnd(reqId);
+                        mRecorder->recordToken(reqId, static_cast<int>(result.outputTokenIds.front().size()));
+                    }
+                    if (result.isFinal)
+                    {
+                        numFinished++;
+                        // Taken for warmup requests as well, so that the executor does not keep their stats
+                        auto const stats
+                            = mSpeculativeExecutor ? mSpeculativeExecutor->takeRequestStats(reqId) : std::nullopt;
+                        if (!warmup)
+                        {
+                            mRecorder->recordEnd(reqId);
+                            if (stats)
+                            {
+                                mRecorder->recordSpecDecodingStats(*stats);
+                            }
+                        }
+                        {
+                            // Under the lock, so that waitForActiveBelow cannot miss the notification
+                            std::lock_guard<std::mutex> lock(mActiveMutex);
+                            mActiveCount--;
+                        }
+                        mActiveCv.notify_all();
                     }
                 }
             }
         }
     }
 
+    // Closed loop: blocks until less than limit requests are in flight
+    void waitForActiveBelow(SizeType limit)
+    {
+        std::unique_lock<std::mutex> lock(mActiveMutex);
+        mActiveCv.wait(lock, [this, limit]() { return mActiveCount < static_cast<uint64_t>(limit); });
+    }
+
     void shutdown()
     {
+        if (mSpeculativeExecutor)
+        {
+            mSpeculativeExecutor->shutdown();
+        }
         mExecutor->shutdown();
     }
 
 private:
     std::shared_ptr<texec::Executor> mExecutor;
+    // Draft/verify loop over mExecutor with the drafters of the requests, in draft mode
+    std::unique_ptr<texec::SpeculativeExecutor> mSpeculativeExecutor;
     std::shared_ptr<Recorder> mRecorder;
     std::chrono::milliseconds mWaitSleep;
     std::optional<int> mStaticEmulatedBatchSize;
     std::atomic<uint64_t> mActiveCount;
+    std::mutex mActiveMutex;
+    std::condition_variable mActiveCv;
 }; // class ExecutorServer
 
 class GptServer
@@ -428,7 +1034,9 @@ public:
         , mStaticEmulatedTimeoutMs(staticEmulatedTimeoutMs)
         , mActiveCount(0)
     {
-        ReturnBatchManagerStatsCallback iterationDataCallback = [this, logIterationData](std::string const& log)
+        auto const recordKvCacheCounters = optionalParams.kvCacheConfig.enableBlockReuse;
+        ReturnBatchManagerStatsCallback iterationDataCallback
+            = [this, logIterationData, recordKvCacheCounters](std::string const& log)
         {
             if (logIterationData)
             {
@@ -441,6 +1049,20 @@ public:
                 auto const activeRequests = json["Active Request Count"];
                 TLLM_CHECK(activeRequests <= mStaticEmulatedBatchSize.value());
             }
+
+            if (recordKvCacheCounters)
+            {
+                auto const json = nlohmann::json::parse(log);
+                if (json.contains("Reused KV cache blocks"))
+                {
+                    KvCacheCounters counters;
+                    counters.allocTotalBlocks = json.value("Alloc Total KV cache blocks", std::uint64_t{0});
+                    counters.allocNewBlocks = json.value("Alloc New KV cache blocks", std::uint64_t{0});
+                    counters.reusedBlocks = json["Reused KV cache blocks"].get<std::uint64_t>();
+                    counters.tokensPerBlock = json.value("Tokens per KV cache block", SizeType{0});
+                    mRecorder->recordKvCacheCounters(counters);
+                }
+            }
         };
 
         mBatchManager = std::make_shared<GptManager>(
@@ -457,7 +1079,16 @@ public:
         mWorkItemsQueue.clear();
     }
 
-    void enqueue(std::shared_ptr<InferenceRequest> const& request)
+    using ResponseCallback = std::function<void(uint64_t, std::list<NamedTensor> const&, bool)>;
+
+    // Called with the tensors of every response, set before the requests are enqueued
+    void setResponseCallback(ResponseCallback callback)
+    {
+        mResponseCallback = std::move(callback);
+    }
+
+    void enqueue(
+        std::shared_ptr<InferenceRequest> const& request, std::optional<SizeType> loraAdapter = std::nullopt)
     {
         TLLM_CHECK(request != nullptr);
         auto const requestId = request->getRequestId();
@@ -470,7 +1101,7 @@ public:
         // Enqueue
         try
         {
-            mRecorder->recordStart(request, requestId);
+            mRecorder->recordStart(request, requestId, loraAdapter);
             mWorkItemsQueue.push(request, requestId);
         }
         catch (const tc::TllmException& e)
@@ -491,6 +1122,13 @@ public:
         }
     }
 
+    // Closed loop: blocks until less than limit requests are queued or in flight
+    void waitForInFlightBelow(SizeType limit)
+    {
+        std::unique_lock<std::mutex> lock(mFinishedMutex);
+        mFinishedCv.wait(lock, [this, limit]() { return mWorkItemsQueue.size() < static_cast<size_t>(limit); });
+    }
+
     void waitBatchManager() const
     {
         mBatchManager->waitUntilTerminate();
@@ -600,7 +1238,7 @@ public:
         return rval;
     }
 
-    void sendResponse(uint64_t requestId, [[maybe_unused]] std::list<NamedTensor> const& response_tensors,
+    void sendResponse(uint64_t requestId, std::list<NamedTensor> const& response_tensors,
         bool final_response, [[maybe_unused]] const std::string& errMsg)
     {
         // `response_tensors` contains `outputIds, sequenceLength, [contextLogits, generationLogits], logProbs,
@@ -609,10 +1247,24 @@ public:
         // them.
         try
         {
+            // Each streamed response carries one new token per beam
+            mRecorder->recordToken(requestId);
             if (final_response)
             {
-                mWorkItemsQueue.markFinished(requestId);
                 mRecorder->recordEnd(requestId);
+            }
+            if (mResponseCallback)
+            {
+                mResponseCallback(requestId, response_tensors, final_response);
+            }
+            if (final_response)
+            {
+                {
+                    // Under the lock, so that waitForInFlightBelow cannot miss the notification
+                    std::lock_guard<std::mutex> lock(mFinishedMutex);
+                    mWorkItemsQueue.markFinished(requestId);
+                }
+                mFinishedCv.notify_all();
                 mActiveCount--;
             }
         }
@@ -632,6 +1284,9 @@ private:
     std::chrono::time_point<std::chrono::steady_clock> mEmulatedBatchEndTimestamp;
     int32_t mStaticEmulatedTimeoutMs;
     std::atomic<uint64_t> mActiveCount;
+    std::mutex mFinishedMutex;
+    std::condition_variable mFinishedCv;
+    ResponseCallback mResponseCallback;
 
 }; // class GptServer
 
@@ -643,10 +1298,96 @@ struct Sample
     std::vector<int32_t> inputIds;
     int32_t outputLen;
     float delay;
+    // Optional reference output of the target model and acceptance of the draft tokens, for speculative decoding
+    std::vector<int32_t> outputIds{};
+    std::optional<float> draftAcceptance{};
 };
 
 using Samples = std::vector<Sample>;
 
+struct LoadPoint
+{
+    std::optional<float> requestRate;
+    std::optional<SizeType> concurrency;
+};
+
+std::vector<LoadPoint> getLoadPoints(BenchmarkParams const& benchmarkParams)
+{
+    TLLM_CHECK_WITH_INFO(benchmarkParams.requestRates.empty() || benchmarkParams.concurrencies.empty(),
+        "Sweep either the request rate or the concurrency");
+    std::vector<LoadPoint> points;
+    for (auto const requestRate : benchmarkParams.requestRates)
+    {
+        TLLM_CHECK_WITH_INFO(requestRate > 0, "Request rate must be positive");
+        points.push_back(LoadPoint{requestRate, std::nullopt});
+    }
+    for (auto const concurrency : benchmarkParams.concurrencies)
+    {
+        TLLM_CHECK_WITH_INFO(concurrency > 0, "Concurrency must be positive");
+        points.push_back(LoadPoint{std::nullopt, concurrency});
+    }
+    if (points.empty())
+    {
+        points.emplace_back();
+    }
+    return points;
+}
+
+void setSweepPoint(Recorder& recorder, LoadPoint const& point, BenchmarkParams const& benchmarkParams)
+{
+    if (benchmarkParams.requestRates.size() + benchmarkParams.concurrencies.size() <= 1)
+    {
+        return;
+    }
+    if (point.requestRate)
+    {
+        recorder.setSweepPoint("request_rate(req/sec)", *point.requestRate);
+    }
+    else
+    {
+        recorder.setSweepPoint("concurrency", static_cast<float>(*point.concurrency));
+    }
+}
+
+// Delays in seconds after the arrival of each request, or of each conversation. With a request rate, the
+// inter-arrival times of a gamma process with the given burstiness, regenerated with the same seed for each point.
+// Closed loop runs ignore them.
+template <typename TItems>
+std::vector<float> getDelays(TItems const& samples, LoadPoint const& point, BenchmarkParams const& benchmarkParams)
+{
+    std::vector<float> delays;
+    delays.reserve(samples.size());
+    if (point.concurrency)
+    {
+        delays.resize(samples.size(), 0.f);
+    }
+    else if (point.requestRate)
+    {
+        std::mt19937 gen(benchmarkParams.randomSeed);
+        std::gamma_distribution<float> dist(
+            benchmarkParams.burstiness, 1.f / (*point.requestRate * benchmarkParams.burstiness));
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            delays.push_back(dist(gen));
+        }
+    }
+    else
+    {
+        for (auto const& sample : samples)
+        {
+            delays.push_back(sample.delay);
+        }
+    }
+    return delays;
+}
+
+// Arrival time of the next request, absolute so that the sleeps do not accumulate the enqueue overhead
+std::chrono::steady_clock::time_point nextArrival(std::chrono::steady_clock::time_point arrival, float delay)
+{
+    return arrival
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(delay));
+}
+
 Samples parseWorkloadJson(std::filesystem::path const& datasetPath, int maxNumSamples)
 {
     auto constexpr allowExceptions = true;
@@ -661,15 +1402,402 @@ Samples parseWorkloadJson(std::filesystem::path const& datasetPath, int maxNumSa
     {
         if (samples.size() >= maxNumSamples)
             break;
-        samples.emplace_back(Sample{sample["input_ids"], sample["output_len"], sample["delay"]});
+        auto& added = samples.emplace_back(Sample{sample["input_ids"], sample["output_len"], sample["delay"]});
+        if (sample.contains("output_ids"))
+        {
+            added.outputIds = sample["output_ids"].get<std::vector<int32_t>>();
+        }
+        if (sample.contains("draft_acceptance"))
+        {
+            added.draftAcceptance = sample["draft_acceptance"].get<float>();
+        }
     }
     return samples;
 }
 
+struct Turn
+{
+    std::vector<int32_t> inputIds;
+    int32_t outputLen;
+};
+
+// Session of a conversation trace, which starts delay seconds after the previous one
+struct Conversation
+{
+    std::vector<Turn> turns;
+    float delay;
+};
+
+using Conversations = std::vector<Conversation>;
+
+// {"sessions": [{"delay": 0.5, "turns": [{"input_ids": [...], "output_len": 32}, ...]}, ...]}, the input ids of a
+// turn are the new message of the user only.
+Conversations parseConversationJson(std::filesystem::path const& datasetPath, int maxNumConversations)
+{
+    auto constexpr allowExceptions = true;
+    auto constexpr ignoreComments = true;
+    TLLM_CHECK_WITH_INFO(std::filesystem::exists(datasetPath), "File does not exist: %s", datasetPath.c_str());
+    std::ifstream jsonStream(datasetPath);
+    auto json = nlohmann::json::parse(jsonStream, nullptr, allowExceptions, ignoreComments);
+
+    Conversations conversations;
+    for (auto const& session : json["sessions"])
+    {
+        if (conversations.size() >= maxNumConversations)
+            break;
+        auto& conversation = conversations.emplace_back(Conversation{{}, session.value("delay", 0.f)});
+        for (auto const& turn : session["turns"])
+        {
+            conversation.turns.emplace_back(Turn{turn["input_ids"], turn["output_len"]});
+        }
+        TLLM_CHECK_WITH_INFO(!conversation.turns.empty(), "Session %zu has no turns", conversations.size() - 1);
+    }
+    return conversations;
+}
+
+// Replays conversations through a GptServer. The first turn of a session arrives with the delays of the load point,
+// each next turn thinkTime after the response to the previous one, with the whole history as prompt: the prompts and
+// responses of the previous turns followed by the new input. With a concurrency, it bounds the sessions in progress.
+class ConversationReplay
+{
+public:
+    using MakeRequest = std::function<std::shared_ptr<InferenceRequest>(uint64_t, Sample const&)>;
+
+    ConversationReplay(Conversations const& conversations, float thinkTime, GptServer& server, Recorder& recorder)
+        : mConversations(conversations)
+        , mThinkTime(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(thinkTime)))
+        , mServer(server)
+        , mRecorder(recorder)
+    {
+        mServer.setResponseCallback([this](uint64_t requestId, std::list<NamedTensor> const& tensors, bool final)
+            { onResponse(requestId, tensors, final); });
+    }
+
+    ~ConversationReplay()
+    {
+        mServer.setResponseCallback(nullptr);
+    }
+
+    // Replays all conversations and returns when the last turn is answered, requests take ids from firstRequestId on
+    void run(std::vector<float> const& delays, std::optional<SizeType> concurrency, uint64_t firstRequestId,
+        MakeRequest const& makeRequest)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mSessions.assign(mConversations.size(), Session{});
+        mRequestSessions.clear();
+        mNumFinished = 0;
+        mNumActive = 0;
+        auto nextRequestId = firstRequestId;
+
+        std::vector<Clock::time_point> arrivals;
+        auto arrival = Clock::now();
+        for (auto const delay : delays)
+        {
+            arrivals.push_back(arrival);
+            arrival += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(delay));
+        }
+        std::size_t nextSession = 0;
+
+        while (mNumFinished < mConversations.size())
+        {
+            auto const now = Clock::now();
+            while (nextSession < mConversations.size() && arrivals[nextSession] <= now
+                && (!concurrency || mNumActive < static_cast<std::size_t>(*concurrency)))
+            {
+                mDue.emplace(arrivals[nextSession], nextSession);
+                ++nextSession;
+                ++mNumActive;
+            }
+            while (!mDue.empty() && mDue.top().first <= now)
+            {
+                auto const sessionIdx = mDue.top().second;
+                mDue.pop();
+                auto& session = mSessions[sessionIdx];
+                auto const& turn = mConversations[sessionIdx].turns[session.nextTurn];
+                auto const numHistoryTokens = static_cast<SizeType>(session.tokens.size());
+                session.tokens.insert(session.tokens.end(), turn.inputIds.begin(), turn.inputIds.end());
+                auto const requestId = nextRequestId++;
+                mRequestSessions[requestId] = sessionIdx;
+                auto request = makeRequest(requestId, Sample{session.tokens, turn.outputLen, 0.f});
+                mRecorder.recordTurn(requestId, session.nextTurn, numHistoryTokens);
+                // The responses may arrive before enqueue returns
+                lock.unlock();
+                mServer.enqueue(request);
+                lock.lock();
+            }
+
+            auto wakeUp = Clock::time_point::max();
+            if (!mDue.empty())
+            {
+                wakeUp = mDue.top().first;
+            }
+            if (nextSession < mConversations.size()
+                && (!concurrency || mNumActive < static_cast<std::size_t>(*concurrency)))
+            {
+                wakeUp = std::min(wakeUp, arrivals[nextSession]);
+            }
+            if (wakeUp == Clock::time_point::max())
+            {
+                mResponded.wait(lock);
+            }
+            else
+            {
+                mResponded.wait_until(lock, wakeUp);
+            }
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Session
+    {
+        std::size_t nextTurn{0};
+        // History of the conversation
+        std::vector<int32_t> tokens;
+    };
+
+    // Appends the tokens of a response to the history of its session. The responses of a streaming request carry the
+    // new tokens, the final response of other requests the whole sequence, prompt included.
+    void onResponse(uint64_t requestId, std::list<NamedTensor> const& tensors, bool final)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const it = mRequestSessions.find(requestId);
+        if (it == mRequestSessions.end())
+        {
+            return;
+        }
+        auto const sessionIdx = it->second;
+        auto& session = mSessions[sessionIdx];
+
+        auto const outputIds = std::find_if(tensors.begin(), tensors.end(),
+            [](auto const& tensor) { return tensor.name == inference_request::kOutputIdsTensorName; });
+        if (outputIds != tensors.end() && outputIds->tensor != nullptr)
+        {
+            auto const& tensor = *outputIds->tensor;
+            TLLM_CHECK_WITH_INFO(tensor.getMemoryType() != MemoryType::kGPU, "Expected output ids on the host");
+            auto const& shape = tensor.getShape();
+            // First beam
+            auto numTokens = static_cast<std::size_t>(shape.nbDims > 0 ? shape.d[shape.nbDims - 1] : 0);
+            auto const sequenceLength = std::find_if(tensors.begin(), tensors.end(),
+                [](auto const& tensor) { return tensor.name == inference_request::kSequenceLengthTensorName; });
+            if (sequenceLength != tensors.end() && sequenceLength->tensor != nullptr)
+            {
+                numTokens = std::min(
+                    numTokens, static_cast<std::size_t>(*bufferCast<SizeType>(*sequenceLength->tensor)));
+            }
+            auto const* tokens = bufferCast<int32_t>(tensor);
+            auto& history = session.tokens;
+            if (numTokens > history.size() && std::equal(history.begin(), history.end(), tokens))
+            {
+                history.assign(tokens, tokens + numTokens);
+            }
+            else
+            {
+                history.insert(history.end(), tokens, tokens + numTokens);
+            }
+        }
+
+        if (!final)
+        {
+            return;
+        }
+        mRequestSessions.erase(it);
+        if (++session.nextTurn < mConversations[sessionIdx].turns.size())
+        {
+            mDue.emplace(Clock::now() + mThinkTime, sessionIdx);
+        }
+        else
+        {
+            ++mNumFinished;
+            --mNumActive;
+        }
+        mResponded.notify_all();
+    }
+
+    Conversations const& mConversations;
+    Clock::duration mThinkTime;
+    GptServer& mServer;
+    Recorder& mRecorder;
+
+    std::mutex mMutex;
+    std::condition_variable mResponded;
+    std::vector<Session> mSessions;
+    // Sessions of the requests in flight
+    std::unordered_map<uint64_t, std::size_t> mRequestSessions;
+    // Sessions whose next turn is due, earliest first
+    using DueTurn = std::pair<Clock::time_point, std::size_t>;
+    std::priority_queue<DueTurn, std::vector<DueTurn>, std::greater<>> mDue;
+    std::size_t mNumFinished{0};
+    std::size_t mNumActive{0};
+};
+
+// Drafter of a request with a synthetic acceptance. The draft tokens follow the reference output of the target model
+// with greedy sampling, which the target model accepts. Each one is kept with the probability acceptance, else the
+// draft deviates from the reference and its remaining tokens are rejected.
+class SyntheticDrafter
+{
+public:
+    SyntheticDrafter(texec::VecTokens reference, std::size_t promptLength, float acceptance, unsigned seed)
+        : mReference(std::make_shared<texec::VecTokens>(std::move(reference)))
+        , mPromptLength(promptLength)
+        , mAcceptance(acceptance)
+        , mGen(seed)
+    {
+    }
+
+    texec::VecTokens operator()(texec::VecTokens const& tokens, SizeType numDraftTokens)
+    {
+        auto const numGenerated = tokens.size() - mPromptLength;
+        texec::VecTokens draft;
+        bool deviated = false;
+        auto const end = std::min(mReference->size(), numGenerated + static_cast<std::size_t>(numDraftTokens));
+        for (auto i = numGenerated; i < end; ++i)
+        {
+            auto token = (*mReference)[i];
+            if (!deviated && mDist(mGen) >= mAcceptance)
+            {
+                token = token > 0 ? token - 1 : token + 1;
+                deviated = true;
+            }
+            draft.push_back(token);
+        }
+        return draft;
+    }
+
+private:
+    // Shared by the copies of the std::function
+    std::shared_ptr<texec::VecTokens const> mReference;
+    std::size_t mPromptLength;
+    float mAcceptance;
+    std::mt19937 mGen;
+    std::uniform_real_distribution<float> mDist{0.f, 1.f};
+};
+
+// Elements [begin, begin + count) of values, which are empty when their feature is off
+template <typename T>
+std::vector<T> sliceOrEmpty(std::vector<T> const& values, std::size_t begin, std::size_t count)
+{
+    return values.empty() ? std::vector<T>{} : std::vector<T>(values.begin() + begin, values.begin() + begin + count);
+}
+
+// LoRA adapter of a multi-LoRA load. The weights are zeros, the cost of the LoRA GEMMs does not depend on them.
+struct LoraAdapter
+{
+    SizeType rank;
+    ITensor::SharedPtr weights; // [numModulesLayers, maxFlattenedInOutSize], in the data type of the model
+    ITensor::SharedPtr config;  // [numModulesLayers, 3], module id, layer and rank of each row
+};
+
+std::vector<LoraAdapter> makeLoraAdapters(
+    std::filesystem::path const& engineDir, BenchmarkParams const& benchmarkParams)
+{
+    std::vector<LoraAdapter> adapters;
+    if (benchmarkParams.numLoraAdapters == 0)
+    {
+        return adapters;
+    }
+    auto const modelConfig = GptJsonConfig::parse(engineDir / "config.json").getModelConfig();
+    auto const& modules = modelConfig.getLoraModules();
+    TLLM_CHECK_WITH_INFO(modelConfig.useLoraPlugin() && !modules.empty(),
+        "A multi-LoRA load needs an engine built with the LoRA plugin and LoRA target modules");
+    auto const maxLoraRank = modelConfig.getMaxLoraRank();
+
+    auto ranks = benchmarkParams.loraRanks;
+    if (ranks.empty())
+    {
+        ranks.push_back(maxLoraRank);
+    }
+    for (auto const rank : ranks)
+    {
+        TLLM_CHECK_WITH_INFO(0 < rank && rank <= maxLoraRank, "LoRA rank %d is not in (0, %d], the range of the engine",
+            rank, maxLoraRank);
+    }
+    auto rankWeights = benchmarkParams.loraRankWeights;
+    if (rankWeights.empty())
+    {
+        rankWeights.assign(ranks.size(), 1.f);
+    }
+    TLLM_CHECK_WITH_INFO(rankWeights.size() == ranks.size(), "Expected a weight for each of the %zu LoRA ranks",
+        ranks.size());
+
+    std::mt19937 gen(benchmarkParams.randomSeed);
+    std::discrete_distribution<std::size_t> rankDist(rankWeights.begin(), rankWeights.end());
+    auto const numLayers = modelConfig.getNbLayers();
+    auto const numRows = numLayers * static_cast<SizeType>(modules.size());
+    std::vector<SizeType> rowSizes;
+    std::size_t maxVolume = 0;
+    for (SizeType adapter = 0; adapter < benchmarkParams.numLoraAdapters; ++adapter)
+    {
+        auto const rank = ranks[rankDist(gen)];
+        auto config = BufferManager::pinned(ITensor::makeShape({numRows, 3}), trt::DataType::kINT32);
+        auto* row = bufferCast<SizeType>(*config);
+        SizeType rowSize = 0;
+        for (SizeType layer = 0; layer < numLayers; ++layer)
+        {
+            for (auto const& module : modules)
+            {
+                *row++ = module.value();
+                *row++ = layer;
+                *row++ = rank;
+                rowSize = std::max(rowSize, module.flattenedInOutSize(rank));
+            }
+        }
+        rowSizes.push_back(rowSize);
+        maxVolume = std::max(maxVolume, static_cast<std::size_t>(numRows) * rowSize);
+        adapters.push_back(LoraAdapter{rank, nullptr, std::move(config)});
+    }
+
+    // The weights of all the adapters view the same zeros
+    ITensor::SharedPtr zeros
+        = BufferManager::pinned(ITensor::makeShape({static_cast<SizeType>(maxVolume)}), modelConfig.getDataType());
+    std::memset(zeros->data(), 0, zeros->getSizeInBytes());
+    for (std::size_t adapter = 0; adapter < adapters.size(); ++adapter)
+    {
+        adapters[adapter].weights = ITensor::view(zeros, ITensor::makeShape({numRows, rowSizes[adapter]}));
+    }
+    return adapters;
+}
+
+// LoRA adapter of each sample. The popularity of the adapters is uniform or a Zipf law, where adapter k is requested
+// with a probability proportional to 1 / (k + 1)^exponent.
+std::vector<SizeType> assignLoraAdapters(std::size_t numSamples, BenchmarkParams const& benchmarkParams)
+{
+    std::vector<SizeType> loraAdapters;
+    if (benchmarkParams.numLoraAdapters == 0)
+    {
+        return loraAdapters;
+    }
+    std::vector<double> popularity;
+    for (SizeType adapter = 0; adapter < benchmarkParams.numLoraAdapters; ++adapter)
+    {
+        popularity.push_back(
+            benchmarkParams.loraZipf ? 1.0 / std::pow(adapter + 1.0, benchmarkParams.loraZipfExponent) : 1.0);
+    }
+    std::mt19937 gen(benchmarkParams.randomSeed);
+    std::discrete_distribution<SizeType> dist(popularity.begin(), popularity.end());
+    loraAdapters.reserve(numSamples);
+    for (std::size_t i = 0; i < numSamples; ++i)
+    {
+        loraAdapters.push_back(dist(gen));
+    }
+    return loraAdapters;
+}
+
+std::vector<SizeType> getLoraRanks(std::vector<LoraAdapter> const& loraAdapters)
+{
+    std::vector<SizeType> ranks;
+    for (auto const& adapter : loraAdapters)
+    {
+        ranks.push_back(adapter.rank);
+    }
+    return ranks;
+}
+
 std::shared_ptr<InferenceRequest> makeRequest(std::uint64_t reqId, Sample const& sample,
     ITensor::SharedPtr const& beamWidthTensor, ITensor::SharedPtr const& eosId, ITensor::SharedPtr const& padId,
     BufferManager const& bufferManager, ITensor::SharedPtr const& returnContextLogits = nullptr,
-    ITensor::SharedPtr const& returnGenerationLogits = nullptr)
+    ITensor::SharedPtr const& returnGenerationLogits = nullptr, LoraAdapter const* loraAdapter = nullptr)
 {
     auto request = std::make_shared<InferenceRequest>(reqId);
     auto const& inputIds = sample.inputIds;
@@ -695,16 +1823,33 @@ std::shared_ptr<InferenceRequest> makeRequest(std::uint64_t reqId, Sample const&
     {
         request->setReturnGenerationLogits(returnGenerationLogits);
     }
+    if (loraAdapter != nullptr)
+    {
+        // Views of the request, which may be reshaped
+        auto const& weights = loraAdapter->weights;
+        auto const& config = loraAdapter->config;
+        request->setLoraWeights(ITensor::view(weights, ITensor::unsqueeze(weights->getShape(), 0)));
+        request->setLoraConfig(ITensor::view(config, ITensor::unsqueeze(config->getShape(), 0)));
+    }
     return request;
 }
 
 texec::Request makeExecutorRequest(Sample const& sample, SizeType const& beamWidth,
     std::optional<SizeType> const& eosId, std::optional<SizeType> const& padId, bool streaming = false,
-    bool const& returnContextLogits = false, bool const& returnGenerationLogits = false)
+    bool const& returnContextLogits = false, bool const& returnGenerationLogits = false,
+    LoraAdapter const* loraAdapter = nullptr)
 {
     auto samplingConfig = texec::SamplingConfig{beamWidth};
     auto outputConfig = texec::OutputConfig{false, returnContextLogits, returnGenerationLogits, false};
-    return texec::Request(sample.inputIds, sample.outputLen, streaming, samplingConfig, outputConfig, eosId, padId);
+    auto request
+        = texec::Request(sample.inputIds, sample.outputLen, streaming, samplingConfig, outputConfig, eosId, padId);
+    if (loraAdapter != nullptr)
+    {
+        // Views of the request, which the executor reshapes
+        request.setLoraConfig(texec::LoraConfig(texec::detail::ofITensor(ITensor::view(loraAdapter->weights)),
+            texec::detail::ofITensor(ITensor::view(loraAdapter->config))));
+    }
+    return request;
 }
 
 void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType modelType,
@@ -735,13 +1880,29 @@ void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType
     ITensor::SharedPtr beamWidthTensor{
         bufferManager.copyFrom(&beamWidth, ITensor::makeShape({1}), MemoryType::kPINNED)};
 
-    // Load dataset
-    const auto samples = parseWorkloadJson(datasetPath, maxNumSamples);
+    // Load dataset, a conversation trace is replayed one turn after the other
+    Conversations conversations;
+    Samples samples;
+    std::size_t numTurns{0};
+    if (benchmarkParams.conversations)
+    {
+        conversations = parseConversationJson(datasetPath, maxNumSamples);
+        for (auto const& conversation : conversations)
+        {
+            numTurns += conversation.turns.size();
+        }
+        auto const& firstTurn = conversations.front().turns.front();
+        samples.emplace_back(Sample{firstTurn.inputIds, firstTurn.outputLen, 0.f});
+    }
+    else
+    {
+        samples = parseWorkloadJson(datasetPath, maxNumSamples);
+    }
     const auto numSamples = samples.size();
 
     const int maxBeamWidth = beamWidth;
-    auto recorder = std::make_shared<Recorder>(opCsvFile);
-    uint64_t terminateReqId = numSamples + 1;
+    auto recorder = std::make_shared<Recorder>(opCsvFile, benchmarkParams);
+    uint64_t terminateReqId = std::max(numSamples, numTurns) + 1;
     auto gptServer = std::make_shared<GptServer>(engineDir, modelType, maxBeamWidth, schedulerPolicy, optionalParams,
         recorder, terminateReqId, waitSleep, staticEmulatedBatchSize, staticEmulatedTimeoutMs, logIterationData);
 
@@ -760,6 +1921,10 @@ void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType
 
     if (worldConfig.getRank() == 0)
     {
+        auto const loraAdapters = makeLoraAdapters(engineDir, benchmarkParams);
+        auto const sampleLoraAdapters = assignLoraAdapters(numSamples, benchmarkParams);
+        recorder->setLoraRanks(getLoraRanks(loraAdapters));
+
         // Warm up
         SizeType reqId = 0;
         for (auto i = 0; i < warmUp; ++i)
@@ -767,31 +1932,64 @@ void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType
             ++reqId;
             if (i == terminateReqId)
                 ++reqId;
-            auto request = makeRequest(reqId, samples[0], beamWidthTensor, eosIdTensor, padIdTensor, bufferManager);
+            auto request = makeRequest(reqId, samples[0], beamWidthTensor, eosIdTensor, padIdTensor, bufferManager,
+                nullptr, nullptr, loraAdapters.empty() ? nullptr : &loraAdapters.front());
             gptServer->enqueue(request);
         }
         gptServer->waitForEmpty();
 
         // Benchmark
-        recorder->initialize();
-        for (std::size_t i = 0; i < numSamples; ++i)
+        for (auto const& point : getLoadPoints(benchmarkParams))
         {
-            auto request = makeRequest(i + 1, samples[i], beamWidthTensor, eosIdTensor, padIdTensor, bufferManager,
-                returnContextLogitsFlagTensor, returnGenerationLogitsFlagTensor);
-            gptServer->enqueue(request);
-            auto delayInMs = static_cast<int>(samples[i].delay * 1000);
+            if (benchmarkParams.conversations)
+            {
+                setSweepPoint(*recorder, point, benchmarkParams);
+                recorder->initialize();
+                ConversationReplay replay(conversations, benchmarkParams.thinkTime, *gptServer, *recorder);
+                replay.run(getDelays(conversations, point, benchmarkParams), point.concurrency, 1,
+                    [&](uint64_t requestId, Sample const& sample)
+                    {
+                        auto request = makeRequest(requestId, sample, beamWidthTensor, eosIdTensor, padIdTensor,
+                            bufferManager, returnContextLogitsFlagTensor, returnGenerationLogitsFlagTensor);
+                        request->setIsStreaming(benchmarkParams.streaming);
+                        return request;
+                    });
+                gptServer->waitForEmpty();
+                recorder->finalize();
+                recorder->calculateMetrics();
+                recorder->report();
+                recorder->writeOpMetricsToCsv();
+                continue;
+            }
 
-            if (delayInMs != 0)
+            auto const delays = getDelays(samples, point, benchmarkParams);
+            setSweepPoint(*recorder, point, benchmarkParams);
+            recorder->initialize();
+            auto arrival = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < numSamples; ++i)
             {
-                std::chrono::milliseconds delay(delayInMs);
-                std::this_thread::sleep_for(delay);
+                if (point.concurrency)
+                {
+                    gptServer->waitForInFlightBelow(*point.concurrency);
+                }
+                auto const loraAdapter = sampleLoraAdapters.empty()
+                    ? std::nullopt
+                    : std::optional<SizeType>{sampleLoraAdapters[i]};
+                auto request = makeRequest(i + 1, samples[i], beamWidthTensor, eosIdTensor, padIdTensor,
+                    bufferManager, returnContextLogitsFlagTensor, returnGenerationLogitsFlagTensor,
+                    loraAdapter ? &loraAdapters[*loraAdapter] : nullptr);
+                request->setIsStreaming(benchmarkParams.streaming);
+                gptServer->enqueue(request, loraAdapter);
+
+                arrival = nextArrival(arrival, delays[i]);
+                std::this_thread::sleep_until(arrival);
             }
+            gptServer->waitForEmpty();
+            recorder->finalize();
+            recorder->calculateMetrics();
+            recorder->report();
+            recorder->writeOpMetricsToCsv();
         }
-        gptServer->waitForEmpty();
-        recorder->finalize();
-        recorder->calculateMetrics();
-        recorder->report();
-        recorder->writeOpMetricsToCsv();
         // Send terminateReqId to terminate servers on all ranks
         // Server on rank 0 will broadcast the terminate signal to other servers on multi-GPU cases
         gptServer->enqueue(std::make_shared<InferenceRequest>(terminateReqId));
@@ -813,53 +2011,112 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
         TLLM_THROW("benchmarkExecutor does not yet support mpiSize > 1");
     }
 
+    auto const speculativeDecodingMode = benchmarkParams.speculativeDecodingMode;
+    if (speculativeDecodingMode == SpeculativeDecodingMode::kMEDUSA)
+    {
+        TLLM_CHECK_WITH_INFO(GptJsonConfig::parse(engineDir / "config.json").getModelConfig().useMedusa(),
+            "The engine has no Medusa heads");
+    }
+    if (speculativeDecodingMode == SpeculativeDecodingMode::kDRAFT)
+    {
+        TLLM_CHECK_WITH_INFO(
+            beamWidth == 1 && !benchmarkParams.streaming, "Draft tokens need beam width 1 and no streaming");
+    }
+
     // Load dataset
     const auto samples = parseWorkloadJson(datasetPath, maxNumSamples);
     const auto numSamples = samples.size();
 
-    auto recorder = std::make_shared<Recorder>(opCsvFile);
+    auto recorder = std::make_shared<Recorder>(opCsvFile, benchmarkParams);
 
     auto executorServer = std::make_shared<ExecutorServer>(engineDir, modelType, beamWidth, schedulerPolicy,
         benchmarkParams, recorder, waitSleep, staticEmulatedBatchSize, logIterationData);
 
     if (worldConfig.getRank() == 0)
     {
+        auto const loraAdapters = makeLoraAdapters(engineDir, benchmarkParams);
+        auto const sampleLoraAdapters = assignLoraAdapters(numSamples, benchmarkParams);
+        recorder->setLoraRanks(getLoraRanks(loraAdapters));
+
         // Warm up
         {
             std::vector<texec::Request> requests;
             for (auto i = 0; i < warmUp; ++i)
             {
                 requests.emplace_back(makeExecutorRequest(samples[0], beamWidth, eosId, padId,
-                    benchmarkParams.streaming, returnContextLogits, returnGenerationLogits));
+                    benchmarkParams.streaming, returnContextLogits, returnGenerationLogits,
+                    loraAdapters.empty() ? nullptr : &loraAdapters.front()));
             }
             executorServer->enqueue(std::move(requests), true);
             executorServer->waitForResponses(warmUp, true);
         }
 
+        // The draft tokens follow the reference outputs of the dataset, or else of a first pass of the target model
+        std::vector<texec::VecTokens> references;
+        if (speculativeDecodingMode == SpeculativeDecodingMode::kDRAFT)
+        {
+            std::vector<texec::Request> requests;
+            std::vector<std::size_t> missing;
+            for (std::size_t i = 0; i < numSamples; ++i)
+            {
+                references.push_back(samples[i].outputIds);
+                if (samples[i].outputIds.empty())
+                {
+                    auto request = makeExecutorRequest(samples[i], beamWidth, eosId, padId, false, false, false,
+                        sampleLoraAdapters.empty() ? nullptr : &loraAdapters[sampleLoraAdapters[i]]);
+                    auto outputConfig = request.getOutputConfig();
+                    outputConfig.excludeInputFromOutput = true;
+                    request.setOutputConfig(outputConfig);
+                    requests.push_back(std::move(request));
+                    missing.push_back(i);
+                }
+            }
+            if (!requests.empty())
+            {
+                TLLM_LOG_INFO("Generating the reference outputs of %zu samples", requests.size());
+                auto outputs = executorServer->generate(std::move(requests));
+                for (std::size_t i = 0; i < missing.size(); ++i)
+                {
+                    references[missing[i]] = std::move(outputs[i]);
+                }
+            }
+            executorServer->startSpeculativeDecoding(benchmarkParams.maxDraftTokens);
+        }
+
         // Benchmark
+        for (auto const& point : getLoadPoints(benchmarkParams))
         {
             // Create requests
+            auto const delays = getDelays(samples, point, benchmarkParams);
+            setSweepPoint(*recorder, point, benchmarkParams);
             recorder->initialize();
             std::vector<texec::Request> requests;
-            std::vector<int> delays;
             for (std::size_t i = 0; i < numSamples; ++i)
             {
                 requests.emplace_back(makeExecutorRequest(samples[i], beamWidth, eosId, padId,
-                    benchmarkParams.streaming, returnContextLogits, returnGenerationLogits));
-                delays.push_back(static_cast<int>(samples[i].delay * 1000));
+                    benchmarkParams.streaming, returnContextLogits, returnGenerationLogits,
+                    sampleLoraAdapters.empty() ? nullptr : &loraAdapters[sampleLoraAdapters[i]]));
+            }
+            // New drafters for each point, so that all points see the same draft tokens
+            std::vector<texec::SpeculativeExecutor::DraftFunc> drafters;
+            for (std::size_t i = 0; i < references.size(); ++i)
+            {
+                drafters.emplace_back(SyntheticDrafter(references[i], samples[i].inputIds.size(),
+                    samples[i].draftAcceptance.value_or(benchmarkParams.draftAcceptance),
+                    static_cast<unsigned>(benchmarkParams.randomSeed + i)));
             }
 
             bool hasDelay = std::any_of(delays.begin(), delays.end(), [](const auto& delay) { return delay > 0; });
-            if (hasDelay && staticEmulatedBatchSize)
+            if ((hasDelay || point.concurrency) && staticEmulatedBatchSize)
             {
-                TLLM_THROW("Executor benchmark doesn't support delays with emulated static batch sizes");
+                TLLM_THROW("Executor benchmark doesn't support delays or concurrency with emulated static batch sizes");
             }
 
-            if (!hasDelay)
+            if (!hasDelay && !point.concurrency)
             {
                 if (!staticEmulatedBatchSize)
                 {
-                    executorServer->enqueue(std::move(requests));
+                    executorServer->enqueue(std::move(requests), false, sampleLoraAdapters, std::move(drafters));
                     executorServer->waitForResponses(numSamples);
                 }
                 else
@@ -873,7 +2130,8 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
                         std::vector<texec::Request> requestsBatch(std::make_move_iterator(requests.begin() + req),
                             std::make_move_iterator(requests.begin() + req + batchSize));
                         // Enqueue in batches
-                        executorServer->enqueue(std::move(requestsBatch));
+                        executorServer->enqueue(std::move(requestsBatch), false,
+                            sliceOrEmpty(sampleLoraAdapters, req, batchSize), sliceOrEmpty(drafters, req, batchSize));
                         // Wait for current batch to be done
                         executorServer->waitForResponses(batchSize);
                     }
@@ -885,18 +2143,25 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
                 std::thread waitThread(
                     [numSamples, executorServer]() { executorServer->waitForResponses(numSamples); });
                 // Enqueue requests one by one
+                auto arrival = std::chrono::steady_clock::now();
                 for (std::size_t i = 0; i < numSamples; ++i)
                 {
-                    executorServer->enqueue({std::move(requests.at(i))});
-                    std::this_thread::sleep_for(std::chrono::milliseconds(delays.at(i)));
+                    if (point.concurrency)
+                    {
+                        executorServer->waitForActiveBelow(*point.concurrency);
+                    }
+                    executorServer->enqueue({std::move(requests.at(i))}, false, sliceOrEmpty(sampleLoraAdapters, i, 1),
+                        sliceOrEmpty(drafters, i, 1));
+                    arrival = nextArrival(arrival, delays.at(i));
+                    std::this_thread::sleep_until(arrival);
                 }
                 waitThread.join();
             }
+            recorder->finalize();
+            recorder->calculateMetrics();
+            recorder->report();
+            recorder->writeOpMetricsToCsv();
         }
-        recorder->finalize();
-        recorder->calculateMetrics();
-        recorder->report();
-        recorder->writeOpMetricsToCsv();
         // Send terminateReqId to terminate servers on all ranks
         // Sever on rank 0 will broadcast the terminate signal to other servers on multi-GPU cases
         // gptServer->enqueue(std::make_shared<InferenceRequest>(terminateReqId));
@@ -936,7 +2201,48 @@ int main(int argc, char* argv[])
         "kv_cache_free_gpu_mem_fraction", "K-V Cache Free Gpu Mem Fraction.", cxxopts::value<float>());
     options.add_options()("enable_trt_overlap", "Overlap TRT context preparation and execution",
         cxxopts::value<bool>()->default_value("false"));
-    options.add_options()("streaming", "Operate in streaming mode", cxxopts::value<bool>()->default_value("false"));
+    options.add_options()("streaming", "Operate in streaming mode, needed for the TTFT and ITL metrics.",
+        cxxopts::value<bool>()->default_value("false"));
+    options.add_options()(
+        "ttft_slo", "Time to first token SLO (ms) of the goodput, with streaming.", cxxopts::value<float>());
+    options.add_options()("request_rate",
+        "Open loop request rates (req/sec), comma separated to sweep. Overrides the delays of the dataset.",
+        cxxopts::value<std::vector<float>>());
+    options.add_options()("burstiness",
+        "Shape of the gamma distribution of the inter-arrival times, 1 is a Poisson process, lower is burstier.",
+        cxxopts::value<float>()->default_value("1.0"));
+    options.add_options()("concurrency", "Closed loop numbers of requests in flight, comma separated to sweep.",
+        cxxopts::value<std::vector<int>>());
+    options.add_options()("random_seed", "Seed of the arrival process and of the LoRA adapters.",
+        cxxopts::value<int>()->default_value("0"));
+    options.add_options()("num_lora_adapters", "Multi-LoRA load: number of LoRA adapters of the requests.",
+        cxxopts::value<int>()->default_value("0"));
+    options.add_options()("lora_ranks", "Ranks of the LoRA adapters, comma separated. Defaults to the max rank.",
+        cxxopts::value<std::vector<int>>());
+    options.add_options()("lora_rank_weights", "Relative frequencies of the LoRA ranks, comma separated.",
+        cxxopts::value<std::vector<float>>());
+    options.add_options()("lora_popularity", "Popularity of the LoRA adapters: uniform or zipf.",
+        cxxopts::value<std::string>()->default_value("uniform"));
+    options.add_options()("lora_zipf_exponent", "Exponent of the Zipf popularity of the LoRA adapters.",
+        cxxopts::value<float>()->default_value("1.0"));
+    options.add_options()("speculative_decoding",
+        "Speculative decoding with the executor API: none, medusa (a Medusa engine) or draft (synthetic draft tokens).",
+        cxxopts::value<std::string>()->default_value("none"));
+    options.add_options()("max_draft_tokens", "Number of draft tokens per step of the draft mode.",
+        cxxopts::value<int>()->default_value("4"));
+    options.add_options()("draft_acceptance",
+        "Probability to accept each draft token in the draft mode, unless the sample has its own.",
+        cxxopts::value<float>()->default_value("0.8"));
+    options.add_options()("lora_cache_adapters",
+        "Capacity in adapters of the LRU cache of the LoRA cache hit rate, 0 for an unbounded cache.",
+        cxxopts::value<int>()->default_value("0"));
+    options.add_options()("conversations",
+        "The dataset is a trace of multi-turn conversations, replayed with the history of each session as prompt.",
+        cxxopts::value<bool>()->default_value("false"));
+    options.add_options()("think_time", "Delay in seconds between a response and the next turn of its conversation.",
+        cxxopts::value<float>()->default_value("1.0"));
+    options.add_options()(
+        "itl_slo", "Average inter-token latency SLO (ms) of the goodput, with streaming.", cxxopts::value<float>());
     options.add_options()(
         "enable_kv_cache_reuse", "Enables the KV cache reuse.", cxxopts::value<bool>()->default_value("false"));
     options.add_options()("enable_chunked_context", "Whether to enable context chunking.",
@@ -1030,6 +2336,102 @@ int main(int argc, char* argv[])
     // Argument: streaming
     benchmarkParams.streaming = result["streaming"].as<bool>();
 
+    // Argument: Load points
+    if (result.count("request_rate"))
+    {
+        benchmarkParams.requestRates = result["request_rate"].as<std::vector<float>>();
+    }
+    if (result.count("concurrency"))
+    {
+        auto const concurrencies = result["concurrency"].as<std::vector<int>>();
+        benchmarkParams.concurrencies.assign(concurrencies.begin(), concurrencies.end());
+    }
+    benchmarkParams.burstiness = result["burstiness"].as<float>();
+    benchmarkParams.randomSeed = result["random_seed"].as<int>();
+    if (benchmarkParams.burstiness <= 0)
+    {
+        TLLM_LOG_ERROR("Burstiness must be positive.");
+        return 1;
+    }
+
+    // Argument: Multi-LoRA load
+    benchmarkParams.numLoraAdapters = result["num_lora_adapters"].as<int>();
+    if (result.count("lora_ranks"))
+    {
+        auto const loraRanks = result["lora_ranks"].as<std::vector<int>>();
+        benchmarkParams.loraRanks.assign(loraRanks.begin(), loraRanks.end());
+    }
+    if (result.count("lora_rank_weights"))
+    {
+        benchmarkParams.loraRankWeights = result["lora_rank_weights"].as<std::vector<float>>();
+    }
+    auto const loraPopularity = result["lora_popularity"].as<std::string>();
+    if (loraPopularity != "uniform" && loraPopularity != "zipf")
+    {
+        TLLM_LOG_ERROR("Unexpected LoRA popularity: " + loraPopularity);
+        return 1;
+    }
+    benchmarkParams.loraZipf = loraPopularity == "zipf";
+    benchmarkParams.loraZipfExponent = result["lora_zipf_exponent"].as<float>();
+    benchmarkParams.loraCacheAdapters = result["lora_cache_adapters"].as<int>();
+    if (benchmarkParams.numLoraAdapters < 0 || benchmarkParams.loraCacheAdapters < 0)
+    {
+        TLLM_LOG_ERROR("The numbers of LoRA adapters must not be negative.");
+        return 1;
+    }
+
+    // Argument: Speculative decoding
+    auto const speculativeDecoding = result["speculative_decoding"].as<std::string>();
+    if (speculativeDecoding == "medusa")
+    {
+        benchmarkParams.speculativeDecodingMode = SpeculativeDecodingMode::kMEDUSA;
+    }
+    else if (speculativeDecoding == "draft")
+    {
+        benchmarkParams.speculativeDecodingMode = SpeculativeDecodingMode::kDRAFT;
+    }
+    else if (speculativeDecoding != "none")
+    {
+        TLLM_LOG_ERROR("Unexpected speculative decoding mode: " + speculativeDecoding);
+        return 1;
+    }
+    if (benchmarkParams.speculativeDecodingMode != SpeculativeDecodingMode::kNONE && api != "executor")
+    {
+        TLLM_LOG_ERROR("Speculative decoding is benchmarked with the executor API.");
+        return 1;
+    }
+    benchmarkParams.maxDraftTokens = result["max_draft_tokens"].as<int>();
+    benchmarkParams.draftAcceptance = result["draft_acceptance"].as<float>();
+    if (benchmarkParams.maxDraftTokens <= 0)
+    {
+        TLLM_LOG_ERROR("The number of draft tokens must be positive.");
+        return 1;
+    }
+
+    // Argument: Multi-turn conversations
+    benchmarkParams.conversations = result["conversations"].as<bool>();
+    benchmarkParams.thinkTime = result["think_time"].as<float>();
+    if (benchmarkParams.conversations && (api != "gptManager" || benchmarkParams.numLoraAdapters > 0))
+    {
+        TLLM_LOG_ERROR("Conversations are replayed with the gptManager API and without LoRA adapters.");
+        return 1;
+    }
+    if (benchmarkParams.thinkTime < 0.f)
+    {
+        TLLM_LOG_ERROR("The think time must not be negative.");
+        return 1;
+    }
+
+    // Argument: SLOs of the goodput
+    if (result.count("ttft_slo"))
+    {
+        benchmarkParams.ttftSloMs = result["ttft_slo"].as<float>();
+    }
+    if (result.count("itl_slo"))
+    {
+        benchmarkParams.itlSloMs = result["itl_slo"].as<float>();
+    }
+
     // Argument: Enable batch stats output
     bool logIterationData = result["log_iteration_data"].as<bool>();
 
@@ -21,13 +21,17 @@
 #include "tensorrt_llm/runtime/gptSession.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/memoryCounters.h"
+#include "tensorrt_llm/runtime/startupReport.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 
 #include <NvInfer.h>
 #include <atomic>
 #include <chrono>
 #include <cxxopts.hpp>
+#include <filesystem>
+#include <fstream>
 #include <future>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -39,6 +43,30 @@ namespace trt = nvinfer1;
 
 namespace
 {
+// Write the phase timeline of the last run to <stem>_bs<batchSize>_in<inputLength>_out<outputLength><extension>
+void writePhaseTimeline(GptSession::GenerationProfiler& profiler, std::filesystem::path const& path, bool chromeTrace,
+    int batchSize, int maxInputLength, int maxNewTokens)
+{
+    auto fileName = path.stem().string() + "_bs" + std::to_string(batchSize) + "_in" + std::to_string(maxInputLength)
+        + "_out" + std::to_string(maxNewTokens) + path.extension().string();
+    auto const filePath = path.parent_path() / fileName;
+    std::ofstream file(filePath);
+    if (!file.good())
+    {
+        TLLM_LOG_ERROR("Cannot open %s for writing", filePath.string().c_str());
+        return;
+    }
+    if (chromeTrace)
+    {
+        profiler.writeChromeTrace(file);
+    }
+    else
+    {
+        profiler.writeCsv(file);
+    }
+    printf("Phase timeline written to %s\n", filePath.string().c_str());
+}
+
 size_t monitorMemory(std::atomic_bool& done)
 {
     // A simple memory monitor function that monitors peak GPU memory usage
@@ -59,7 +87,9 @@ size_t monitorMemory(std::atomic_bool& done)
 void benchmarkGptSession(std::string const& modelName, std::filesystem::path const& dataPath,
     std::vector<int> const& batchSizes, int beamWidth, std::vector<std::vector<int>> const& inOutLen,
     std::shared_ptr<nvinfer1::ILogger> const& logger, int warmUp, int numRuns, int duration,
-    GptSession::Config& sessionConfig, bool cudaGraphMode, bool printAllLogits, bool disableForceMaxTokens)
+    GptSession::Config& sessionConfig, bool cudaGraphMode, bool printAllLogits, bool disableForceMaxTokens,
+    std::optional<std::filesystem::path> const& phaseTraceFile,
+    std::optional<std::filesystem::path> const& phaseCsvFile)
 {
     std::string modelNameHyphen = modelName;
     std::filesystem::path jsonFileName = dataPath / "config.json";
@@ -167,24 +197,29 @@ void benchmarkGptSession(std::string const& modelName, std::filesystem::path con
 
                 TLLM_LOG_INFO(memoryCounter.toString());
 
-                for (auto r = 0; r < warmUp; ++r)
                 {
-                    SizeType numSteps = 0;
-                    generationOutput.onTokenGenerated
-                        = [&numSteps, maxNewTokens](GenerationOutput::TensorPtr const& outputIds, SizeType step,
-                              bool finished) { ++numSteps; };
-                    session.generate(generationOutput, generationInput, samplingConfig);
-                    bufferManager.getStream().synchronize();
+                    StartupReport::ScopedPhase const startupPhase{"warm_up"};
+                    for (auto r = 0; r < warmUp; ++r)
+                    {
+                        SizeType numSteps = 0;
+                        generationOutput.onTokenGenerated
+                            = [&numSteps, maxNewTokens](GenerationOutput::TensorPtr const& outputIds, SizeType step,
+                                  bool finished) { ++numSteps; };
+                        session.generate(generationOutput, generationInput, samplingConfig);
+                        bufferManager.getStream().synchronize();
+                    }
+                    cudaDeviceSynchronize();
                 }
-                cudaDeviceSynchronize();
 
                 TLLM_LOG_INFO(memoryCounter.toString());
+                TLLM_LOG_INFO(StartupReport::getInstance().toString());
 
                 int iterIdx = 0;
                 float curDuration = 0;
                 std::vector<float> latencies;
                 std::vector<float> generationTimes;
-                auto generationProfiler = std::make_shared<GptSession::GenerationProfiler>();
+                auto const recordPhases = phaseTraceFile.has_value() || phaseCsvFile.has_value();
+                auto generationProfiler = std::make_shared<GptSession::GenerationProfiler>(recordPhases);
                 while (iterIdx < numRuns || curDuration / 1000 < duration)
                 {
                     auto const start = std::chrono::steady_clock::now();
@@ -230,6 +265,17 @@ void benchmarkGptSession(std::string const& modelName, std::filesystem::path con
                     }
                 }
 
+                if (worldConfig.getRank() == 0 && phaseTraceFile)
+                {
+                    writePhaseTimeline(*generationProfiler, *phaseTraceFile, true, batchSize, maxInputLength,
+                        maxNewTokens);
+                }
+                if (worldConfig.getRank() == 0 && phaseCsvFile)
+                {
+                    writePhaseTimeline(*generationProfiler, *phaseCsvFile, false, batchSize, maxInputLength,
+                        maxNewTokens);
+                }
+
                 if (worldConfig.getRank() == 0)
                 {
                     auto const averageLatency = curDuration / iterIdx;
@@ -345,6 +391,12 @@ int main(int argc, char* argv[])
     options.add_options()("enable_cuda_graph", "Execute GPT session with CUDA graph.");
     options.add_options()("print_all_logits", "Print all context and generation logits.");
     options.add_options()("disable_force_max_tokens", "Disable force the engine generating new max_tokens.");
+    options.add_options()("phase_trace",
+        "Write the per-step phase timeline of the last run of each configuration as Chrome trace to this path.",
+        cxxopts::value<std::string>());
+    options.add_options()("phase_csv",
+        "Write the per-step phase timeline of the last run of each configuration as CSV to this path.",
+        cxxopts::value<std::string>());
 
     auto result = options.parse(argc, argv);
 
@@ -454,6 +506,17 @@ int main(int argc, char* argv[])
     auto enableCudaGraph = result.count("enable_cuda_graph") > 0;
     auto printAllLogits = result.count("print_all_logits") > 0;
     auto disableForceMaxTokens = result.count("disable_force_max_tokens") > 0;
+    // Argument: Phase timeline output
+    std::optional<std::filesystem::path> phaseTraceFile;
+    if (result.count("phase_trace"))
+    {
+        phaseTraceFile = result["phase_trace"].as<std::string>();
+    }
+    std::optional<std::filesystem::path> phaseCsvFile;
+    if (result.count("phase_csv"))
+    {
+        phaseCsvFile = result["phase_csv"].as<std::string>();
+    }
 
     initTrtLlmPlugins(logger.get());
 
@@ -461,7 +524,8 @@ int main(int argc, char* argv[])
     {
         benchmarkGptSession(result["model"].as<std::string>(), result["engine_dir"].as<std::string>(), batchSizes,
             beamWidth, inOutLen, logger, result["warm_up"].as<int>(), result["num_runs"].as<int>(),
-            result["duration"].as<int>(), sessionConfig, enableCudaGraph, printAllLogits, disableForceMaxTokens);
+            result["duration"].as<int>(), sessionConfig, enableCudaGraph, printAllLogits, disableForceMaxTokens,
+            phaseTraceFile, phaseCsvFile);
     }
     catch (const std::exception& e)
     {
@@ -0,0 +1,806 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/common/workspace.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/gqaGenerationAttentionKernels.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/kernels/mixtureOfExperts/moe_kernels.h"
+#include "tensorrt_llm/kernels/onlineSoftmaxBeamsearchKernels.h"
+#include "tensorrt_llm/kernels/samplingTopPKernels.h"
+#include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/enabled.h"
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/kernelLauncher.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cxxopts.hpp>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+namespace
+{
+
+struct BenchmarkParams
+{
+    std::set<std::string> kernels;
+    std::vector<int> batchSizes;
+    std::vector<int> seqLens;
+    std::vector<int> numKvHeads;
+    std::vector<int> numTokens;
+    int numHeads{32};
+    int headSize{128};
+    int vocabSize{32000};
+    int beamWidth{4};
+    int numExperts{8};
+    int topK{2};
+    int gemmN{4096};
+    int gemmK{4096};
+    bool multiBlockMode{false};
+    bool flushL2{true};
+    int warmUp{10};
+    int numRuns{100};
+    // Ceilings of the roofline. The peak bandwidth in GB/s, the peak compute in TFLOP/s, 0 if unknown.
+    double peakBandwidth{0.};
+    double peakTflops{0.};
+};
+
+std::vector<int> parseList(std::string const& arg)
+{
+    std::istringstream ss(arg);
+    std::vector<int> values;
+    for (std::string token; std::getline(ss, token, ';');)
+    {
+        values.push_back(std::stoi(token));
+    }
+    return values;
+}
+
+//! \brief DRAM bandwidth of the current device in GB/s from its memory clock and bus width.
+double getPeakBandwidth()
+{
+    auto const device = tc::getDevice();
+    int memoryClockKHz{0};
+    int busWidthBits{0};
+    TLLM_CUDA_CHECK(cudaDeviceGetAttribute(&memoryClockKHz, cudaDevAttrMemoryClockRate, device));
+    TLLM_CUDA_CHECK(cudaDeviceGetAttribute(&busWidthBits, cudaDevAttrGlobalMemoryBusWidth, device));
+    // Two transfers per clock
+    return 2. * memoryClockKHz * 1e3 * busWidthBits / 8. * 1e-9;
+}
+
+// Runs the kernels in isolation on synthetic inputs and reports their latency, their achieved bandwidth and compute,
+// and how close they come to the roofline of the device. The bytes of a kernel are its minimal DRAM traffic, each
+// input read and each output written once, so a kernel reading the same data several times or spilling to a
+// workspace shows as far from the roofline instead of as high bandwidth.
+class KernelBenchmark
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    explicit KernelBenchmark(BenchmarkParams params)
+        : mParams{std::move(params)}
+        , mStream{std::make_shared<CudaStream>()}
+        , mManager{mStream}
+        , mGenerator{42}
+    {
+        if (mParams.flushL2)
+        {
+            int l2CacheSize{0};
+            TLLM_CUDA_CHECK(cudaDeviceGetAttribute(&l2CacheSize, cudaDevAttrL2CacheSize, tc::getDevice()));
+            mL2Flush = mManager.gpu(2 * static_cast<std::size_t>(l2CacheSize), nvinfer1::DataType::kINT8);
+        }
+    }
+
+    void run()
+    {
+        auto const enabled = [this](std::string const& kernel) { return mParams.kernels.count(kernel) > 0; };
+        if (enabled("mmha"))
+        {
+            benchmarkMmha();
+        }
+        if (enabled("gqa_generation"))
+        {
+            benchmarkGqaGeneration();
+        }
+        if (enabled("top_p"))
+        {
+            benchmarkTopP(false);
+        }
+        if (enabled("air_top_p"))
+        {
+            benchmarkTopP(true);
+        }
+        if (enabled("beam_search"))
+        {
+            benchmarkBeamSearch();
+        }
+        if (enabled("moe_routing"))
+        {
+            benchmarkMoeRouting();
+        }
+        if (enabled("weight_only_gemv"))
+        {
+            benchmarkWeightOnlyGemv();
+        }
+        if (enabled("rope_kv_update"))
+        {
+            benchmarkRopeKvUpdate();
+        }
+    }
+
+private:
+    //! \brief Average latency of launch in microseconds. With flushL2, every run starts from a cold L2 so that inputs
+    //! smaller than the L2 are still read from DRAM.
+    template <typename Func>
+    float time(Func const& launch)
+    {
+        for (int i = 0; i < mParams.warmUp; ++i)
+        {
+            launch();
+        }
+        // A named flag, the literal would also convert to an event pointer
+        unsigned int constexpr kTimingFlags{cudaEventDefault};
+        std::vector<std::pair<CudaEvent, CudaEvent>> events;
+        events.reserve(mParams.numRuns);
+        for (int i = 0; i < mParams.numRuns; ++i)
+        {
+            if (mL2Flush)
+            {
+                mManager.setZero(*mL2Flush);
+            }
+            auto& [start, stop] = events.emplace_back(CudaEvent{kTimingFlags}, CudaEvent{kTimingFlags});
+            mStream->record(start);
+            launch();
+            mStream->record(stop);
+        }
+        mStream->synchronize();
+        sync_check_cuda_error();
+
+        float totalMs{0.f};
+        for (auto const& [start, stop] : events)
+        {
+            float ms{0.f};
+            TLLM_CUDA_CHECK(cudaEventElapsedTime(&ms, start.get(), stop.get()));
+            totalMs += ms;
+        }
+        return totalMs * 1000.f / static_cast<float>(mParams.numRuns);
+    }
+
+    //! \param flops Floating point operations of the kernel, 0 if not meaningful.
+    void report(std::string const& kernel, std::string const& shape, float latencyUs, double bytes, double flops) const
+    {
+        auto const seconds = latencyUs * 1e-6;
+        // Shortest time of the kernel on this device, bound by memory or by compute
+        auto boundSeconds = bytes * 1e-9 / mParams.peakBandwidth;
+        if (flops > 0. && mParams.peakTflops > 0.)
+        {
+            boundSeconds = std::max(boundSeconds, flops * 1e-12 / mParams.peakTflops);
+        }
+        auto const compute = flops > 0. ? tc::fmtstr("%.2f", flops / seconds * 1e-12) : std::string{"N/A"};
+        printf("[BENCHMARK] kernel %s %s latency(us) %.2f bandwidth(GB/s) %.1f compute(TFLOP/s) %s roofline(%%) %.1f\n",
+            kernel.c_str(), shape.c_str(), latencyUs, bytes / seconds * 1e-9, compute.c_str(),
+            100. * boundSeconds / seconds);
+    }
+
+    template <typename T>
+    ITensor::SharedPtr randomGpu(ITensor::Shape const& shape, float low, float high)
+    {
+        std::uniform_real_distribution<float> distr(low, high);
+        std::vector<T> values(ITensor::volume(shape));
+        std::generate(values.begin(), values.end(), [&]() { return static_cast<T>(distr(mGenerator)); });
+        return mManager.copyFrom(values, shape, MemoryType::kGPU);
+    }
+
+    ITensor::SharedPtr zerosGpu(ITensor::Shape const& shape, nvinfer1::DataType type)
+    {
+        auto tensor = mManager.gpu(shape, type);
+        mManager.setZero(*tensor);
+        return tensor;
+    }
+
+    ITensor::SharedPtr fillGpu(SizeType size, int32_t value)
+    {
+        return mManager.copyFrom(std::vector<int32_t>(size, value), ITensor::makeShape({size}), MemoryType::kGPU);
+    }
+
+    //! \brief Whether a linear KV cache of the shape can be addressed with the 32-bit offsets of KVLinearBuffer.
+    static bool fitsLinearKvCache(SizeType batchSize, SizeType seqLen, SizeType sizePerToken)
+    {
+        return 2 * static_cast<int64_t>(batchSize) * seqLen * sizePerToken <= std::numeric_limits<int32_t>::max();
+    }
+
+    static std::string attentionShape(SizeType batchSize, SizeType seqLen, SizeType numHeads, SizeType numKvHeads,
+        SizeType headSize)
+    {
+        return tc::fmtstr("batch_size %d seq_len %d num_heads %d num_kv_heads %d head_size %d", batchSize, seqLen,
+            numHeads, numKvHeads, headSize);
+    }
+
+    //! \brief Generation step of attention: one query token per sequence over seqLen cached tokens. The K/V cache is
+    //! read once at best, MMHA reads it once per query head, which shows with GQA.
+    void benchmarkMmha()
+    {
+        auto const numHeads = mParams.numHeads;
+        auto const headSize = mParams.headSize;
+        if (!tk::mmha_supported(headSize))
+        {
+            TLLM_LOG_WARNING("mmha: head size %d is not supported, skipped", headSize);
+            return;
+        }
+        auto const multiProcessorCount = tc::getMultiProcessorCount();
+        for (auto const batchSize : mParams.batchSizes)
+        {
+            for (auto const seqLen : mParams.seqLens)
+            {
+                for (auto const numKvHeads : mParams.numKvHeads)
+                {
+                    auto const sizePerToken = numKvHeads * headSize * static_cast<SizeType>(sizeof(half));
+                    if (numHeads % numKvHeads != 0 || !fitsLinearKvCache(batchSize, seqLen, sizePerToken))
+                    {
+                        TLLM_LOG_WARNING("mmha: %s skipped",
+                            attentionShape(batchSize, seqLen, numHeads, numKvHeads, headSize).c_str());
+                        continue;
+                    }
+                    auto const qkvSize = (numHeads + 2 * numKvHeads) * headSize;
+                    auto qkv = randomGpu<half>(ITensor::makeShape({batchSize, qkvSize}), -1.f, 1.f);
+                    auto output = mManager.gpu(
+                        ITensor::makeShape({batchSize, numHeads * headSize}), nvinfer1::DataType::kHALF);
+                    auto kvCache = zerosGpu(
+                        ITensor::makeShape({batchSize, 2, seqLen, numKvHeads * headSize}), nvinfer1::DataType::kHALF);
+                    auto seqLens = fillGpu(batchSize, seqLen);
+                    auto inputLens = fillGpu(batchSize, 1);
+
+                    // Same multi-block setup as GPTAttentionPluginCommon::enqueueGeneration
+                    auto const minSeqLenTile = tk::estimate_min_multi_block_count<half>(
+                        seqLen - 1, tc::getMaxSharedMemoryPerBlockOptin() - 2048);
+                    auto const maxSeqLenTile = std::max(
+                        mParams.multiBlockMode ? tc::divUp(multiProcessorCount, batchSize * numHeads) : 0,
+                        minSeqLenTile);
+                    auto const multiBlockMode = (mParams.multiBlockMode && maxSeqLenTile > 1) || minSeqLenTile > 1;
+                    ITensor::SharedPtr partialOut;
+                    ITensor::SharedPtr partialSum;
+                    ITensor::SharedPtr partialMax;
+                    ITensor::SharedPtr blockCounter;
+                    if (multiBlockMode)
+                    {
+                        partialOut = mManager.gpu(ITensor::makeShape({batchSize * numHeads * maxSeqLenTile, headSize}),
+                            nvinfer1::DataType::kHALF);
+                        partialSum = mManager.gpu(
+                            ITensor::makeShape({batchSize * numHeads * maxSeqLenTile}), nvinfer1::DataType::kFLOAT);
+                        partialMax = mManager.gpu(
+                            ITensor::makeShape({batchSize * numHeads * maxSeqLenTile}), nvinfer1::DataType::kFLOAT);
+                        blockCounter
+                            = mManager.gpu(ITensor::makeShape({batchSize * numHeads}), nvinfer1::DataType::kINT32);
+                    }
+
+                    tk::Masked_multihead_attention_params<uint16_t> params{};
+                    auto const* qkvPtr = reinterpret_cast<uint16_t const*>(bufferCast<half>(*qkv));
+                    params.q = qkvPtr;
+                    params.k = qkvPtr + numHeads * headSize;
+                    params.v = qkvPtr + (numHeads + numKvHeads) * headSize;
+                    params.out = reinterpret_cast<uint16_t*>(bufferCast<half>(*output));
+                    params.stride = qkvSize;
+                    params.batch_size = batchSize;
+                    params.beam_width = 1;
+                    params.max_attention_window_size = seqLen;
+                    params.cyclic_attention_window_size = seqLen;
+                    params.length_per_sample = bufferCast<int32_t>(*seqLens);
+                    params.input_lengths = bufferCast<int32_t>(*inputLens);
+                    params.timestep = seqLen - 1;
+                    params.num_heads = numHeads;
+                    params.num_kv_heads = numKvHeads;
+                    params.hidden_size_per_head = headSize;
+                    params.inv_sqrt_dh = 1.f / std::sqrt(static_cast<float>(headSize));
+                    params.multi_block_mode = multiBlockMode;
+                    if (multiBlockMode)
+                    {
+                        params.min_seq_len_tile = minSeqLenTile;
+                        params.max_seq_len_tile = maxSeqLenTile;
+                        params.partial_out = reinterpret_cast<uint16_t*>(bufferCast<half>(*partialOut));
+                        params.partial_sum = bufferCast<float>(*partialSum);
+                        params.partial_max = bufferCast<float>(*partialMax);
+                        params.block_counter = bufferCast<int32_t>(*blockCounter);
+                    }
+                    params.multi_processor_count = multiProcessorCount;
+                    params.sm_version = tc::getSMVersion();
+
+                    tk::KVLinearBuffer kvCacheBuffer(batchSize, 1, seqLen, sizePerToken, seqLen, 0, false);
+                    kvCacheBuffer.data = static_cast<int8_t*>(kvCache->data());
+                    tk::KVLinearBuffer shiftKCacheBuffer;
+
+                    auto const latency = time(
+                        [&]()
+                        {
+                            if (multiBlockMode)
+                            {
+                                mManager.setZero(*blockCounter);
+                            }
+                            tk::masked_multihead_attention(params, kvCacheBuffer, shiftKCacheBuffer, mStream->get());
+                        });
+                    auto const bytes = static_cast<double>(sizeof(half))
+                        * (kvCache->getSize() + qkv->getSize() + output->getSize());
+                    auto const flops = 4. * batchSize * numHeads * seqLen * headSize;
+                    report("mmha", attentionShape(batchSize, seqLen, numHeads, numKvHeads, headSize), latency, bytes,
+                        flops);
+                }
+            }
+        }
+    }
+
+    //! \brief Same generation step as benchmarkMmha on the tensor core kernel the plugin uses for GQA.
+    void benchmarkGqaGeneration()
+    {
+        auto const numHeads = mParams.numHeads;
+        auto const headSize = mParams.headSize;
+        if (!tk::isGQAGenerationAttentionSupported(false, headSize, tc::getSMVersion()))
+        {
+            TLLM_LOG_WARNING("gqa_generation: head size %d is not supported on this device, skipped", headSize);
+            return;
+        }
+        for (auto const batchSize : mParams.batchSizes)
+        {
+            for (auto const seqLen : mParams.seqLens)
+            {
+                for (auto const numKvHeads : mParams.numKvHeads)
+                {
+                    auto const sizePerToken = numKvHeads * headSize * static_cast<SizeType>(sizeof(half));
+                    if (numHeads % numKvHeads != 0 || numHeads / numKvHeads < tk::kGQAGenerationMinHeadsPerKv
+                        || !fitsLinearKvCache(batchSize, seqLen, sizePerToken))
+                    {
+                        TLLM_LOG_WARNING("gqa_generation: %s skipped",
+                            attentionShape(batchSize, seqLen, numHeads, numKvHeads, headSize).c_str());
+                        continue;
+                    }
+                    auto q = randomGpu<half>(ITensor::makeShape({batchSize, numHeads, headSize}), -1.f, 1.f);
+                    auto output = mManager.gpu(q->getShape(), nvinfer1::DataType::kHALF);
+                    auto kvCache = zerosGpu(
+                        ITensor::makeShape({batchSize, 2, seqLen, numKvHeads * headSize}), nvinfer1::DataType::kHALF);
+                    auto seqLens = fillGpu(batchSize, seqLen);
+
+                    tk::GQAGenerationAttentionParams params{};
+                    params.q = q->data();
+                    params.output = output->data();
+                    params.seqLens = bufferCast<int32_t>(*seqLens);
+                    params.batchSize = batchSize;
+                    params.numQHeads = numHeads;
+                    params.numKVHeads = numKvHeads;
+                    params.headSize = headSize;
+                    params.cyclicAttentionWindowSize = seqLen;
+                    params.softmaxScale = 1.f / std::sqrt(static_cast<float>(headSize));
+
+                    tk::KVLinearBuffer kvCacheBuffer(batchSize, 1, seqLen, sizePerToken, seqLen, 0, false);
+                    kvCacheBuffer.data = static_cast<int8_t*>(kvCache->data());
+
+                    auto const latency = time([&]()
+                        { tk::invokeGQAGenerationAttention<half, half>(params, kvCacheBuffer, mStream->get()); });
+                    auto const bytes = static_cast<double>(sizeof(half))
+                        * (kvCache->getSize() + q->getSize() + output->getSize());
+                    auto const flops = 4. * batchSize * numHeads * seqLen * headSize;
+                    report("gqa_generation", attentionShape(batchSize, seqLen, numHeads, numKvHeads, headSize),
+                        latency, bytes, flops);
+                }
+            }
+        }
+    }
+
+    //! \brief Softmax of random logits, the sampling layers pass probabilities to the top-p kernels.
+    ITensor::SharedPtr randomProbs(SizeType numRows, SizeType vocabSize)
+    {
+        std::normal_distribution<float> distr(0.f, 2.f);
+        std::vector<float> probs(static_cast<std::size_t>(numRows) * vocabSize);
+        for (SizeType row = 0; row < numRows; ++row)
+        {
+            auto* rowPtr = probs.data() + static_cast<std::size_t>(row) * vocabSize;
+            std::generate(rowPtr, rowPtr + vocabSize, [&]() { return std::exp(distr(mGenerator)); });
+            auto const sum = std::accumulate(rowPtr, rowPtr + vocabSize, 0.f);
+            std::transform(rowPtr, rowPtr + vocabSize, rowPtr, [sum](float p) { return p / sum; });
+        }
+        return mManager.copyFrom(probs, ITensor::makeShape({numRows, vocabSize}), MemoryType::kGPU);
+    }
+
+    //! \brief One top-p sampling step of the batch, with the initialization of the sort buffers for the deterministic
+    //! kernel as TopPSamplingLayer does every step.
+    void benchmarkTopP(bool air)
+    {
+        auto constexpr kTopP = 0.9f;
+        auto const vocabSize = mParams.vocabSize;
+        auto const kernel = air ? "air_top_p" : "top_p";
+        for (auto const batchSize : mParams.batchSizes)
+        {
+            auto probs = randomProbs(batchSize, vocabSize);
+            auto outputIds = zerosGpu(ITensor::makeShape({batchSize, 1}), nvinfer1::DataType::kINT32);
+            std::vector<int64_t> outputIdsPtrsHost(batchSize);
+            for (SizeType bi = 0; bi < batchSize; ++bi)
+            {
+                outputIdsPtrsHost[bi] = reinterpret_cast<int64_t>(bufferCast<int32_t>(*outputIds) + bi);
+            }
+            auto outputIdsPtrs
+                = mManager.copyFrom(outputIdsPtrsHost, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+            auto** outputIdsPtrsPtr = reinterpret_cast<int**>(bufferCast<int64_t>(*outputIdsPtrs));
+            auto sequenceLengths = fillGpu(batchSize, 0);
+            // No token is the end token, so that no request finishes during the benchmark
+            auto endIds = fillGpu(batchSize, -1);
+            auto finished = zerosGpu(
+                ITensor::makeShape({batchSize}), TRTDataType<tk::FinishedState::UnderlyingType>::value);
+            auto* finishedPtr
+                = reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*finished));
+            auto curandStates = mManager.gpu(batchSize * sizeof(tk::PhiloxState), nvinfer1::DataType::kINT8);
+            auto* curandStatesPtr = static_cast<tk::PhiloxState*>(curandStates->data());
+            tk::invokeCurandInitialize(curandStatesPtr, nullptr, batchSize, 0, mStream->get());
+
+            float latency{0.f};
+            if (air)
+            {
+                auto const blockNum
+                    = tk::calcAirTopPBlockNum<float, int, float>(batchSize, vocabSize, tc::getMultiProcessorCount());
+                std::size_t workspaceSize{0};
+                tk::invokeBatchAirTopPSampling<float>(nullptr, workspaceSize, nullptr, nullptr, nullptr, nullptr,
+                    nullptr, nullptr, nullptr, curandStatesPtr, batchSize, batchSize, vocabSize, nullptr, kTopP,
+                    nullptr, mStream->get(), blockNum, nullptr, nullptr);
+                auto workspace = mManager.gpu(workspaceSize, nvinfer1::DataType::kINT8);
+                latency = time(
+                    [&]()
+                    {
+                        tk::invokeBatchAirTopPSampling<float>(workspace->data(), workspaceSize, outputIdsPtrsPtr,
+                            bufferCast<int32_t>(*sequenceLengths), finishedPtr, finishedPtr, nullptr, nullptr,
+                            bufferCast<float>(*probs), curandStatesPtr, batchSize, batchSize, vocabSize,
+                            bufferCast<int32_t>(*endIds), kTopP, nullptr, mStream->get(), blockNum, nullptr, nullptr);
+                    });
+            }
+            else
+            {
+                auto topPIdVals = mManager.gpu(ITensor::makeShape({batchSize, vocabSize}), nvinfer1::DataType::kINT32);
+                auto offsets = mManager.gpu(ITensor::makeShape({batchSize + 1}), nvinfer1::DataType::kINT32);
+                auto beginOffsets = mManager.gpu(ITensor::makeShape({batchSize + 1}), nvinfer1::DataType::kINT32);
+                std::size_t workspaceSize{0};
+                std::size_t cubTempStorageSize{0};
+                tk::invokeBatchTopPSampling<float>(nullptr, workspaceSize, cubTempStorageSize, nullptr, nullptr,
+                    nullptr, nullptr, nullptr, nullptr, nullptr, bufferCast<int32_t>(*topPIdVals),
+                    bufferCast<int32_t>(*offsets), bufferCast<int32_t>(*beginOffsets), curandStatesPtr, batchSize,
+                    batchSize, vocabSize, nullptr, kTopP, nullptr, mStream->get(), nullptr, nullptr);
+                auto workspace = mManager.gpu(workspaceSize, nvinfer1::DataType::kINT8);
+                latency = time(
+                    [&]()
+                    {
+                        tk::invokeTopPInitialize(bufferCast<int32_t>(*topPIdVals), bufferCast<int32_t>(*offsets),
+                            bufferCast<int32_t>(*beginOffsets), batchSize, vocabSize, mStream->get());
+                        tk::invokeBatchTopPSampling<float>(workspace->data(), workspaceSize, cubTempStorageSize,
+                            outputIdsPtrsPtr, bufferCast<int32_t>(*sequenceLengths), finishedPtr, finishedPtr,
+                            nullptr, nullptr, bufferCast<float>(*probs), bufferCast<int32_t>(*topPIdVals),
+                            bufferCast<int32_t>(*offsets), bufferCast<int32_t>(*beginOffsets), curandStatesPtr,
+                            batchSize, batchSize, vocabSize, bufferCast<int32_t>(*endIds), kTopP, nullptr,
+                            mStream->get(), nullptr, nullptr);
+                    });
+            }
+            auto const bytes = static_cast<double>(sizeof(float)) * probs->getSize();
+            report(kernel, tc::fmtstr("batch_size %d vocab_size %d", batchSize, vocabSize), latency, bytes, 0.);
+        }
+    }
+
+    //! \brief One step of beam search: log softmax of the logits of each beam and top-k over all the beams.
+    void benchmarkBeamSearch()
+    {
+        auto const vocabSize = mParams.vocabSize;
+        auto const beamWidth = mParams.beamWidth;
+        SizeType constexpr kStep{1};
+        for (auto const batchSize : mParams.batchSizes)
+        {
+            auto const numVectors = batchSize * beamWidth;
+            auto logits = randomGpu<float>(ITensor::makeShape({numVectors, vocabSize}), -5.f, 5.f);
+            auto cumLogProbs = zerosGpu(ITensor::makeShape({numVectors}), nvinfer1::DataType::kFLOAT);
+            auto finished = zerosGpu(
+                ITensor::makeShape({numVectors}), TRTDataType<tk::FinishedState::UnderlyingType>::value);
+            auto sequenceLengths = fillGpu(numVectors, kStep);
+            auto outputIds
+                = mManager.gpu(ITensor::makeShape({batchSize, beamWidth, kStep + 1}), nvinfer1::DataType::kINT32);
+            std::vector<int64_t> outputIdsPtrsHost(batchSize);
+            for (SizeType bi = 0; bi < batchSize; ++bi)
+            {
+                outputIdsPtrsHost[bi]
+                    = reinterpret_cast<int64_t>(bufferCast<int32_t>(*outputIds) + bi * beamWidth * (kStep + 1));
+            }
+            auto outputIdsPtrs
+                = mManager.copyFrom(outputIdsPtrsHost, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+            // No token is the end token, so that no beam finishes during the benchmark
+            auto endIds = fillGpu(batchSize, -1);
+            auto diversityRates = zerosGpu(ITensor::makeShape({batchSize}), nvinfer1::DataType::kFLOAT);
+            auto lengthPenalties = zerosGpu(ITensor::makeShape({batchSize}), nvinfer1::DataType::kFLOAT);
+            auto earlyStoppings = fillGpu(batchSize, 1);
+            // Same workspace size as OnlineBeamSearchLayer, which covers both the split and the fused path
+            auto workspace = mManager.gpu(
+                ITensor::makeShape({static_cast<SizeType>(std::ceil(batchSize * 64 * (64 * 2) / 4.) * 4 * 2
+                    + std::ceil(batchSize * (64 * 2) * 128 * (2 * (4 * 2) + 2) / 4.) * 4)}),
+                nvinfer1::DataType::kFLOAT);
+
+            tk::BeamHypotheses beamHyps;
+            beamHyps.end_ids = bufferCast<int32_t>(*endIds);
+            beamHyps.sequence_lengths_src = bufferCast<int32_t>(*sequenceLengths);
+            beamHyps.output_ids_tgt_ptr = reinterpret_cast<int**>(bufferCast<int64_t>(*outputIdsPtrs));
+            beamHyps.batch_size = batchSize;
+            beamHyps.beam_width = beamWidth;
+            beamHyps.local_batch_size = batchSize;
+            beamHyps.max_seq_len = kStep + 1;
+            beamHyps.vocab_size = vocabSize;
+            beamHyps.diversity_rates = bufferCast<float>(*diversityRates);
+            beamHyps.length_penalties = bufferCast<float>(*lengthPenalties);
+            beamHyps.early_stoppings = bufferCast<int32_t>(*earlyStoppings);
+
+            auto* finishedPtr
+                = reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*finished));
+            auto const latency = time(
+                [&]()
+                {
+                    tk::invokeTopkSoftMax(bufferCast<float>(*logits), static_cast<float const*>(nullptr), finishedPtr,
+                        bufferCast<float>(*cumLogProbs), workspace->data(), static_cast<int>(workspace->getSize()),
+                        beamHyps, mStream->get());
+                });
+            auto const bytes = static_cast<double>(sizeof(float)) * logits->getSize();
+            report("beam_search",
+                tc::fmtstr("batch_size %d beam_width %d vocab_size %d", batchSize, beamWidth, vocabSize), latency,
+                bytes, 0.);
+        }
+    }
+
+    //! \brief Routing of the tokens to the experts: softmax and top-k of the gating logits, then the tokens sorted by
+    //! expert.
+    void benchmarkMoeRouting()
+    {
+        auto const numExperts = mParams.numExperts;
+        auto const topK = mParams.topK;
+        for (auto const numTokens : mParams.numTokens)
+        {
+            auto gating = randomGpu<float>(ITensor::makeShape({numTokens, numExperts}), -2.f, 2.f);
+            auto expertScales = mManager.gpu(ITensor::makeShape({numTokens, topK}), nvinfer1::DataType::kFLOAT);
+            auto expertForSourceRow = mManager.gpu(ITensor::makeShape({numTokens, topK}), nvinfer1::DataType::kINT32);
+            auto routingSizes = tk::getAllToAllRoutingBufferSizes(numTokens, numExperts, topK);
+            auto workspace = mManager.gpu(
+                tc::calculateTotalWorkspaceSize(routingSizes.data(), static_cast<int>(routingSizes.size())),
+                nvinfer1::DataType::kINT8);
+            auto const buffers
+                = tk::setupAllToAllRoutingBuffers(static_cast<char*>(workspace->data()), numTokens, numExperts, topK);
+
+            auto const latency = time(
+                [&]()
+                {
+                    tk::computeAllToAllRouting(bufferCast<float>(*gating), nullptr, bufferCast<float>(*expertScales),
+                        bufferCast<int32_t>(*expertForSourceRow), buffers, numTokens, numExperts, topK,
+                        mStream->get());
+                });
+            // Gating logits in, scales, experts, source and permuted rows out
+            auto const bytes = static_cast<double>(sizeof(float)) * gating->getSize()
+                + 4. * numTokens * topK * sizeof(int32_t) + static_cast<double>(numExperts) * sizeof(int64_t);
+            report("moe_routing",
+                tc::fmtstr("num_tokens %d num_experts %d top_k %d", numTokens, numExperts, topK), latency, bytes,
+                0.);
+        }
+    }
+
+    //! \brief The CUDA kernel of the weight-only plugins for up to 16 rows, per-channel scales, FP16 activations.
+    void benchmarkWeightOnlyGemv()
+    {
+        SizeType constexpr kMaxRows{16};
+        auto const n = mParams.gemmN;
+        auto const k = mParams.gemmK;
+        for (auto const quantType : {tk::WeightOnlyQuantType::Int8b, tk::WeightOnlyQuantType::Int4b})
+        {
+            auto const bits = quantType == tk::WeightOnlyQuantType::Int8b ? 8 : 4;
+            if (!tk::isWeightOnlyBatchedGemvEnabled(quantType))
+            {
+                TLLM_LOG_WARNING("weight_only_gemv: int%d is not supported on this device, skipped", bits);
+                continue;
+            }
+            // The values do not change the work, the weights are left in whatever layout zeros are in
+            auto weights = zerosGpu(ITensor::makeShape({n, k * bits / 8}), nvinfer1::DataType::kUINT8);
+            auto scales = randomGpu<half>(ITensor::makeShape({n}), 0.f, 1.f);
+            for (auto const m : mParams.batchSizes)
+            {
+                if (m > kMaxRows)
+                {
+                    continue;
+                }
+                auto input = randomGpu<half>(ITensor::makeShape({m, k}), -1.f, 1.f);
+                auto output = mManager.gpu(ITensor::makeShape({m, n}), nvinfer1::DataType::kHALF);
+                tk::WeightOnlyParams params{bufferCast<uint8_t>(*weights), scales->data(), nullptr, input->data(),
+                    nullptr, nullptr, output->data(), m, n, k, 0, quantType, tk::WeightOnlyType::PerChannel,
+                    tk::WeightOnlyActivationFunctionType::Identity, tk::WeightOnlyActivationType::FP16};
+
+                auto const latency
+                    = time([&]() { tk::weight_only_batched_gemv_launcher(params, mStream->get()); });
+                auto const bytes = static_cast<double>(weights->getSize())
+                    + sizeof(half) * static_cast<double>(scales->getSize() + input->getSize() + output->getSize());
+                auto const flops = 2. * m * n * k;
+                report("weight_only_gemv", tc::fmtstr("m %d n %d k %d weights int%d", m, n, k, bits), latency, bytes,
+                    flops);
+            }
+        }
+    }
+
+    //! \brief Context phase: GPT-NeoX RoPE applied to Q and K of all the prompt tokens, K and V written to the cache.
+    void benchmarkRopeKvUpdate()
+    {
+        auto const numHeads = mParams.numHeads;
+        auto const headSize = mParams.headSize;
+        for (auto const batchSize : mParams.batchSizes)
+        {
+            for (auto const seqLen : mParams.seqLens)
+            {
+                for (auto const numKvHeads : mParams.numKvHeads)
+                {
+                    auto const sizePerToken = numKvHeads * headSize * static_cast<SizeType>(sizeof(half));
+                    if (numHeads % numKvHeads != 0 || !fitsLinearKvCache(batchSize, seqLen, sizePerToken))
+                    {
+                        TLLM_LOG_WARNING("rope_kv_update: %s skipped",
+                            attentionShape(batchSize, seqLen, numHeads, numKvHeads, headSize).c_str());
+                        continue;
+                    }
+                    auto const numTokens = batchSize * seqLen;
+                    auto const qkvSize = (numHeads + 2 * numKvHeads) * headSize;
+                    auto qkv = zerosGpu(ITensor::makeShape({numTokens, qkvSize}), nvinfer1::DataType::kHALF);
+                    auto q = mManager.gpu(
+                        ITensor::makeShape({numTokens, numHeads * headSize}), nvinfer1::DataType::kHALF);
+                    auto kvCache = mManager.gpu(
+                        ITensor::makeShape({batchSize, 2, seqLen, numKvHeads * headSize}), nvinfer1::DataType::kHALF);
+                    auto seqLens = fillGpu(batchSize, seqLen);
+
+                    tk::KVLinearBuffer kvCacheBuffer(batchSize, 1, seqLen, sizePerToken, seqLen, 0, false);
+                    kvCacheBuffer.data = static_cast<int8_t*>(kvCache->data());
+                    int2 gridBlockCache{0, 0};
+
+                    auto const latency = time(
+                        [&]()
+                        {
+                            // Padded input: no padding offsets, numTokens = batchSize * seqLen
+                            tk::invokeApplyBiasRopeUpdateKVCache<half, tk::KVLinearBuffer, false>(
+                                bufferCast<half>(*qkv), bufferCast<half>(*q), kvCacheBuffer, nullptr,
+                                bufferCast<int32_t>(*seqLens), bufferCast<int32_t>(*seqLens), nullptr, batchSize,
+                                seqLen, seqLen, 0, numTokens, numHeads, numKvHeads, headSize, headSize, 10000.f,
+                                tk::RotaryScalingType::kNONE, 1.f, seqLen, tk::PositionEmbeddingType::kROPE_GPT_NEOX,
+                                nullptr, false, nullptr, 0, tk::KvCacheDataType::BASE, nullptr, false, 1,
+                                gridBlockCache, mStream->get());
+                        });
+                    auto const bytes = static_cast<double>(sizeof(half))
+                        * (qkv->getSize() + q->getSize() + kvCache->getSize());
+                    report("rope_kv_update", attentionShape(batchSize, seqLen, numHeads, numKvHeads, headSize),
+                        latency, bytes, 0.);
+                }
+            }
+        }
+    }
+
+    BenchmarkParams mParams;
+    std::shared_ptr<CudaStream> mStream;
+    BufferManager mManager;
+    std::mt19937 mGenerator;
+    // Written before every run to evict the inputs from the L2
+    IBuffer::SharedPtr mL2Flush;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options(
+        "TensorRT-LLM Kernel Benchmark", "Latency, bandwidth and compute of individual TensorRT-LLM kernels.");
+    options.add_options()("h,help", "Print usage");
+    options.add_options()("kernels",
+        "Kernels to benchmark, separated by \";\", among mmha, gqa_generation, top_p, air_top_p, beam_search, "
+        "moe_routing, weight_only_gemv and rope_kv_update.",
+        cxxopts::value<std::string>()->default_value(
+            "mmha;gqa_generation;top_p;air_top_p;beam_search;moe_routing;weight_only_gemv;rope_kv_update"));
+    options.add_options()("batch_size",
+        "Batch size(s) separated by \";\". Also the rows of weight_only_gemv, up to 16.",
+        cxxopts::value<std::string>()->default_value("1;8;64"));
+    options.add_options()("seq_len", "Tokens in the KV cache for the attention kernels, separated by \";\".",
+        cxxopts::value<std::string>()->default_value("1024;4096"));
+    options.add_options()("num_heads", "Query heads.", cxxopts::value<int>()->default_value("32"));
+    options.add_options()("num_kv_heads", "KV heads separated by \";\", to compare MHA, GQA and MQA.",
+        cxxopts::value<std::string>()->default_value("32;8;1"));
+    options.add_options()("head_size", "Head size.", cxxopts::value<int>()->default_value("128"));
+    options.add_options()("vocab_size", "Vocabulary size for sampling.", cxxopts::value<int>()->default_value("32000"));
+    options.add_options()("beam_width", "Beam width for beam search.", cxxopts::value<int>()->default_value("4"));
+    options.add_options()("num_tokens", "Tokens routed by moe_routing, separated by \";\".",
+        cxxopts::value<std::string>()->default_value("1;64;4096"));
+    options.add_options()("num_experts", "Experts for moe_routing.", cxxopts::value<int>()->default_value("8"));
+    options.add_options()("top_k", "Experts per token for moe_routing.", cxxopts::value<int>()->default_value("2"));
+    options.add_options()(
+        "gemm_n", "Output features of weight_only_gemv.", cxxopts::value<int>()->default_value("4096"));
+    options.add_options()(
+        "gemm_k", "Input features of weight_only_gemv.", cxxopts::value<int>()->default_value("4096"));
+    options.add_options()("multi_block_mode", "Split long sequences over several blocks in MMHA.",
+        cxxopts::value<bool>()->default_value("false"));
+    options.add_options()("flush_l2", "Evict the inputs from the L2 cache before every run.",
+        cxxopts::value<bool>()->default_value("true"));
+    options.add_options()(
+        "warm_up", "Warm up iterations before measuring.", cxxopts::value<int>()->default_value("10"));
+    options.add_options()("num_runs", "Measured iterations.", cxxopts::value<int>()->default_value("100"));
+    options.add_options()("peak_bandwidth",
+        "Peak DRAM bandwidth in GB/s for the roofline, computed from the memory clock and bus width if not set.",
+        cxxopts::value<double>());
+    options.add_options()("peak_tflops",
+        "Peak compute in TFLOP/s for the roofline of the attention and GEMM kernels. Without it, only the memory "
+        "roof is used.",
+        cxxopts::value<double>()->default_value("0"));
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        exit(0);
+    }
+
+    BenchmarkParams params;
+    std::istringstream ssKernelsArg(result["kernels"].as<std::string>());
+    for (std::string token; std::getline(ssKernelsArg, token, ';');)
+    {
+        params.kernels.insert(token);
+    }
+    params.batchSizes = parseList(result["batch_size"].as<std::string>());
+    params.seqLens = parseList(result["seq_len"].as<std::string>());
+    params.numKvHeads = parseList(result["num_kv_heads"].as<std::string>());
+    params.numTokens = parseList(result["num_tokens"].as<std::string>());
+    params.numHeads = result["num_heads"].as<int>();
+    params.headSize = result["head_size"].as<int>();
+    params.vocabSize = result["vocab_size"].as<int>();
+    params.beamWidth = result["beam_width"].as<int>();
+    params.numExperts = result["num_experts"].as<int>();
+    params.topK = result["top_k"].as<int>();
+    params.gemmN = result["gemm_n"].as<int>();
+    params.gemmK = result["gemm_k"].as<int>();
+    params.multiBlockMode = result["multi_block_mode"].as<bool>();
+    params.flushL2 = result["flush_l2"].as<bool>();
+    params.warmUp = result["warm_up"].as<int>();
+    params.numRuns = result["num_runs"].as<int>();
+    params.peakTflops = result["peak_tflops"].as<double>();
+
+    try
+    {
+        params.peakBandwidth
+            = result.count("peak_bandwidth") ? result["peak_bandwidth"].as<double>() : getPeakBandwidth();
+        TLLM_CHECK_WITH_INFO(params.numRuns > 0, "num_runs must be positive");
+        printf("[BENCHMARK] peak_bandwidth(GB/s) %.1f peak_compute(TFLOP/s) %.1f\n", params.peakBandwidth,
+            params.peakTflops);
+        KernelBenchmark benchmark{std::move(params)};
+        benchmark.run();
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_ERROR(e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,464 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/kvCacheReuseStats.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cxxopts.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace tb = tensorrt_llm::batch_manager;
+namespace bmkv = tensorrt_llm::batch_manager::kv_cache_manager;
+
+namespace
+{
+
+struct BenchmarkParams
+{
+    std::vector<int> maxBatchSizes;
+    std::vector<int> cachedBlocks;
+    int beamWidth{1};
+    int tokensPerBlock{64};
+    int maxNumBlocks{1 << 20};
+    int minInputLen{128};
+    int maxInputLen{2048};
+    int minOutputLen{16};
+    int maxOutputLen{512};
+    // Prompts starting with one of numPrefixes shared prefixes of prefixLen tokens, e.g. system prompts
+    int numPrefixes{8};
+    int prefixLen{512};
+    float sharedPrefixRatio{0.5f};
+    bool enableBlockReuse{true};
+    int numIterations{1000};
+    int warmUp{100};
+    unsigned int randomSeed{0};
+};
+
+std::vector<int> parseList(std::string const& arg)
+{
+    std::istringstream ss(arg);
+    std::vector<int> values;
+    for (std::string token; std::getline(ss, token, ';');)
+    {
+        values.push_back(std::stoi(token));
+    }
+    return values;
+}
+
+// Host time of the phases of one iteration, in microseconds
+struct IterationTimes
+{
+    double scheduling{0.};
+    double addSequence{0.};
+    double addToken{0.};
+    double blockPointers{0.};
+    double removeSequence{0.};
+
+    [[nodiscard]] double total() const
+    {
+        return scheduling + addSequence + addToken + blockPointers + removeSequence;
+    }
+};
+
+// Replays the KV cache calls of in-flight batching on a synthetic trace and times them on the host. Every iteration
+// checks the capacity of the cache for the running and the new requests, adds the new requests, adds a token to the
+// running ones, gathers the block pointers of the batch and removes the finished requests. The batch is refilled as
+// soon as a request finishes, so that it stays at maxBatchSize when the cache is large enough.
+//
+// The pool is kept tiny (one layer, one head of size one, INT8), the bookkeeping on the host does not depend on the
+// size of the blocks.
+class KvCacheManagerBenchmark
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using VecTokens = tb::LlmRequest::VecTokens;
+
+    explicit KvCacheManagerBenchmark(BenchmarkParams params)
+        : mParams{std::move(params)}
+        , mStream{std::make_shared<CudaStream>()}
+        , mGenerator{mParams.randomSeed}
+    {
+        std::uniform_int_distribution<SizeType> tokenDistr(0, kVocabSize - 1);
+        for (int i = 0; i < mParams.numPrefixes; ++i)
+        {
+            auto& prefix = mPrefixes.emplace_back(mParams.prefixLen);
+            std::generate(prefix.begin(), prefix.end(), [&]() { return tokenDistr(mGenerator); });
+        }
+    }
+
+    void run(SizeType maxBatchSize, SizeType cachedBlocks)
+    {
+        auto const beamWidth = mParams.beamWidth;
+        auto const maxAttentionWindow = mParams.maxInputLen + mParams.maxOutputLen;
+        bmkv::KVCacheManager kvCacheManager(1, 1, 1, mParams.tokensPerBlock, mParams.maxNumBlocks, maxBatchSize,
+            beamWidth, maxAttentionWindow, 0, false, nvinfer1::DataType::kINT8, mStream, mParams.enableBlockReuse);
+        auto const numCachedBlocks = fillCache(kvCacheManager, cachedBlocks);
+
+        // A view of the block pointers per batch entry, [1, beamWidth, 2, maxBlocksPerSeq] as for a batch of one
+        BufferManager manager{mStream};
+        auto blockPointers = std::shared_ptr<ITensor>{manager.cpu(
+            ITensor::makeShape({maxBatchSize, 1, beamWidth, 2, kvCacheManager.getMaxBlocksPerSeq()}),
+            nvinfer1::DataType::kINT64)};
+        std::vector<ITensor::SharedPtr> blockPointerViews;
+        for (SizeType bi = 0; bi < maxBatchSize; ++bi)
+        {
+            ITensor::SharedPtr view = ITensor::slice(blockPointers, bi, 1);
+            view->squeeze(0);
+            blockPointerViews.push_back(std::move(view));
+        }
+
+        std::vector<std::shared_ptr<tb::LlmRequest>> slots(maxBatchSize);
+        std::vector<IterationTimes> times;
+        times.reserve(mParams.numIterations);
+        SizeType numAddSequence{0};
+        SizeType numAddToken{0};
+        SizeType numRemoveSequence{0};
+        SizeType numBatchEntries{0};
+        auto const statsBefore = bmkv::getKvCacheReuseStats(kvCacheManager);
+        for (int iter = 0; iter < mParams.warmUp + mParams.numIterations; ++iter)
+        {
+            auto const measured = iter >= mParams.warmUp;
+            IterationTimes iterTimes;
+            Timer timer;
+
+            // Blocks still needed by the running requests, the new ones are admitted with what is left
+            kvCacheManager.startScheduling();
+            SizeType reservedBlocks{0};
+            for (auto const& request : slots)
+            {
+                if (request)
+                {
+                    reservedBlocks += kvCacheManager.getNeededBlocksToCompletion(*request);
+                }
+            }
+            std::vector<std::pair<SizeType, std::shared_ptr<tb::LlmRequest>>> newRequests;
+            auto availableBlocks = kvCacheManager.getNumFreeBlocks() - reservedBlocks;
+            for (SizeType slot = 0; slot < maxBatchSize; ++slot)
+            {
+                if (slots[slot])
+                {
+                    continue;
+                }
+                auto request = nextRequest();
+                auto const neededBlocks = kvCacheManager.getNeededBlocksToCompletion(*request);
+                if (neededBlocks > availableBlocks)
+                {
+                    break;
+                }
+                availableBlocks -= neededBlocks;
+                newRequests.emplace_back(slot, std::move(request));
+            }
+            iterTimes.scheduling = timer.lap();
+
+            for (auto& [slot, request] : newRequests)
+            {
+                kvCacheManager.addSequence(slot, request->mPromptLen, beamWidth, request);
+                request->mState = tb::REQUEST_STATE_GENERATION_IN_PROGRESS;
+                slots[slot] = std::move(request);
+            }
+            iterTimes.addSequence = timer.lap();
+
+            // The first token of the new requests comes from their context phase
+            SizeType iterAddToken{0};
+            for (SizeType slot = 0; slot < maxBatchSize; ++slot)
+            {
+                if (slots[slot])
+                {
+                    kvCacheManager.addToken(slot);
+                    ++iterAddToken;
+                }
+            }
+            iterTimes.addToken = timer.lap();
+
+            SizeType batchIdx{0};
+            for (SizeType slot = 0; slot < maxBatchSize; ++slot)
+            {
+                if (slots[slot])
+                {
+                    kvCacheManager.getBlockPointersOfBatch(*blockPointerViews[batchIdx++], slot, 1, beamWidth);
+                }
+            }
+            iterTimes.blockPointers = timer.lap();
+
+            // The tokens of the requests are not timed, the model would have produced them
+            std::vector<SizeType> finished;
+            std::uniform_int_distribution<SizeType> tokenDistr(0, kVocabSize - 1);
+            for (SizeType slot = 0; slot < maxBatchSize; ++slot)
+            {
+                auto const& request = slots[slot];
+                if (!request)
+                {
+                    continue;
+                }
+                for (SizeType beam = 0; beam < beamWidth; ++beam)
+                {
+                    request->addNewToken(tokenDistr(mGenerator), beam);
+                }
+                if (request->getMaxNumGeneratedTokens() >= request->mMaxNewTokens)
+                {
+                    finished.push_back(slot);
+                }
+            }
+            timer.lap();
+
+            for (auto const slot : finished)
+            {
+                slots[slot]->mState = tb::REQUEST_STATE_GENERATION_COMPLETE;
+                kvCacheManager.removeSequence(slot, slots[slot]);
+                slots[slot].reset();
+            }
+            iterTimes.removeSequence = timer.lap();
+
+            if (measured)
+            {
+                times.push_back(iterTimes);
+                numAddSequence += static_cast<SizeType>(newRequests.size());
+                numAddToken += iterAddToken;
+                numBatchEntries += batchIdx;
+                numRemoveSequence += static_cast<SizeType>(finished.size());
+            }
+        }
+        auto const statsAfter = bmkv::getKvCacheReuseStats(kvCacheManager);
+
+        std::vector<double> totals;
+        IterationTimes sum;
+        for (auto const& iterTimes : times)
+        {
+            totals.push_back(iterTimes.total());
+            sum.scheduling += iterTimes.scheduling;
+            sum.addSequence += iterTimes.addSequence;
+            sum.addToken += iterTimes.addToken;
+            sum.blockPointers += iterTimes.blockPointers;
+            sum.removeSequence += iterTimes.removeSequence;
+        }
+        std::sort(totals.begin(), totals.end());
+        auto const percentile = [&totals](double p)
+        {
+            auto const rank = static_cast<std::size_t>(std::ceil(p / 100. * totals.size()));
+            return totals.at(std::clamp<std::size_t>(rank, 1, totals.size()) - 1);
+        };
+        auto const perCall = [](double total, SizeType count) { return count > 0 ? total / count : 0.; };
+        auto const allocated = statsAfter.allocTotalBlocks - statsBefore.allocTotalBlocks;
+        auto const reused = statsAfter.reusedBlocks - statsBefore.reusedBlocks;
+
+        printf(
+            "[BENCHMARK] max_batch_size %d beam_width %d cached_blocks %d avg_batch_size %.1f iteration(us) avg %.2f "
+            "p50 %.2f p99 %.2f max %.2f\n",
+            maxBatchSize, beamWidth, numCachedBlocks, static_cast<double>(numBatchEntries) / times.size(),
+            sum.total() / times.size(), percentile(50.), percentile(99.), totals.back());
+        printf(
+            "[BENCHMARK] per call(us) scheduling %.2f add_sequence %.2f add_token %.3f block_pointers %.3f "
+            "remove_sequence %.2f reused_blocks(%%) %.1f\n",
+            sum.scheduling / times.size(), perCall(sum.addSequence, numAddSequence),
+            perCall(sum.addToken, numAddToken), perCall(sum.blockPointers, numBatchEntries),
+            perCall(sum.removeSequence, numRemoveSequence),
+            allocated > 0 ? 100. * reused / allocated : 0.);
+    }
+
+private:
+    static SizeType constexpr kVocabSize{32000};
+
+    class Timer
+    {
+    public:
+        //! \brief Microseconds since the previous lap.
+        double lap()
+        {
+            auto const now = std::chrono::steady_clock::now();
+            auto const elapsed = std::chrono::duration<double, std::micro>(now - mLast).count();
+            mLast = now;
+            return elapsed;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point mLast{std::chrono::steady_clock::now()};
+    };
+
+    std::shared_ptr<tb::LlmRequest> nextRequest()
+    {
+        std::uniform_int_distribution<SizeType> inputLenDistr(mParams.minInputLen, mParams.maxInputLen);
+        std::uniform_int_distribution<SizeType> outputLenDistr(mParams.minOutputLen, mParams.maxOutputLen);
+        std::uniform_int_distribution<SizeType> tokenDistr(0, kVocabSize - 1);
+        std::bernoulli_distribution sharedDistr(mPrefixes.empty() ? 0.f : mParams.sharedPrefixRatio);
+
+        auto tokens = std::make_shared<VecTokens>();
+        auto const inputLen = inputLenDistr(mGenerator);
+        if (sharedDistr(mGenerator))
+        {
+            std::uniform_int_distribution<std::size_t> prefixDistr(0, mPrefixes.size() - 1);
+            auto const& prefix = mPrefixes[prefixDistr(mGenerator)];
+            tokens->assign(prefix.begin(), prefix.begin() + std::min<std::size_t>(prefix.size(), inputLen));
+        }
+        while (static_cast<SizeType>(tokens->size()) < inputLen)
+        {
+            tokens->push_back(tokenDistr(mGenerator));
+        }
+        return std::make_shared<tb::LlmRequest>(
+            mNextRequestId++, outputLenDistr(mGenerator), tokens, SamplingConfig{mParams.beamWidth}, false);
+    }
+
+    //! \brief Stores blocks of distinct prompts in the reuse tree until about cachedBlocks blocks are cached, as after
+    //! a long run of a server.
+    //! \return The number of cached blocks. Only the full blocks of each prompt are counted, and never more than fit
+    //! into the pool, so that no cached block is evicted while filling.
+    SizeType fillCache(bmkv::KVCacheManager& kvCacheManager, SizeType cachedBlocks)
+    {
+        if (!mParams.enableBlockReuse || cachedBlocks == 0)
+        {
+            return 0;
+        }
+        auto const promptLen = mParams.maxInputLen;
+        auto const blocksPerPrompt = promptLen / mParams.tokensPerBlock;
+        if (blocksPerPrompt == 0)
+        {
+            TLLM_LOG_WARNING("Prompts of %d tokens do not fill a block, nothing is cached", promptLen);
+            return 0;
+        }
+        auto const maxCachedBlocks = mParams.maxNumBlocks / blocksPerPrompt * blocksPerPrompt;
+        if (cachedBlocks > maxCachedBlocks)
+        {
+            TLLM_LOG_WARNING("Cache full with %d cached blocks", maxCachedBlocks);
+        }
+        std::uniform_int_distribution<SizeType> tokenDistr(0, kVocabSize - 1);
+        SizeType numCachedBlocks{0};
+        while (numCachedBlocks < std::min(cachedBlocks, maxCachedBlocks))
+        {
+            auto tokens = std::make_shared<VecTokens>(promptLen);
+            std::generate(tokens->begin(), tokens->end(), [&]() { return tokenDistr(mGenerator); });
+            auto request
+                = std::make_shared<tb::LlmRequest>(mNextRequestId++, 1, tokens, SamplingConfig{1}, false);
+            kvCacheManager.addSequence(0, promptLen, 1, request);
+            request->mState = tb::REQUEST_STATE_GENERATION_COMPLETE;
+            kvCacheManager.removeSequence(0, request);
+            numCachedBlocks += blocksPerPrompt;
+        }
+        return numCachedBlocks;
+    }
+
+    BenchmarkParams mParams;
+    std::shared_ptr<CudaStream> mStream;
+    std::mt19937 mGenerator;
+    std::vector<VecTokens> mPrefixes;
+    tb::LlmRequest::RequestIdType mNextRequestId{0};
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options("TensorRT-LLM KV Cache Manager Benchmark",
+        "Host overhead of the KV cache manager calls of in-flight batching on a synthetic trace.");
+    options.add_options()("h,help", "Print usage");
+    options.add_options()("max_batch_size", "Maximum batch size(s) separated by \";\".",
+        cxxopts::value<std::string>()->default_value("8;64;256"));
+    options.add_options()("cached_blocks",
+        "Blocks cached for reuse before the measurement, separated by \";\". Needs enable_block_reuse.",
+        cxxopts::value<std::string>()->default_value("0;100000;1000000"));
+    options.add_options()("beam_width", "Beam width.", cxxopts::value<int>()->default_value("1"));
+    options.add_options()("tokens_per_block", "Tokens per block.", cxxopts::value<int>()->default_value("64"));
+    options.add_options()(
+        "max_num_blocks", "Blocks of the KV cache.", cxxopts::value<int>()->default_value("1100000"));
+    options.add_options()("input_len", "Minimum and maximum prompt length, separated by \",\".",
+        cxxopts::value<std::string>()->default_value("128,2048"));
+    options.add_options()("output_len", "Minimum and maximum number of generated tokens, separated by \",\".",
+        cxxopts::value<std::string>()->default_value("16,512"));
+    options.add_options()("num_prefixes", "Number of shared prefixes.", cxxopts::value<int>()->default_value("8"));
+    options.add_options()("prefix_len", "Tokens of the shared prefixes.", cxxopts::value<int>()->default_value("512"));
+    options.add_options()("shared_prefix_ratio", "Fraction of the prompts starting with a shared prefix.",
+        cxxopts::value<float>()->default_value("0.5"));
+    options.add_options()("enable_block_reuse", "Reuse the blocks of the previous requests.",
+        cxxopts::value<bool>()->default_value("true"));
+    options.add_options()(
+        "num_iterations", "Measured iterations.", cxxopts::value<int>()->default_value("1000"));
+    options.add_options()(
+        "warm_up", "Iterations before measuring, to fill the batch.", cxxopts::value<int>()->default_value("100"));
+    options.add_options()(
+        "random_seed", "Seed of the synthetic trace.", cxxopts::value<unsigned int>()->default_value("0"));
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        exit(0);
+    }
+
+    auto const parseRange = [&result](std::string const& name)
+    {
+        std::istringstream ss(result[name].as<std::string>());
+        std::vector<int> values;
+        for (std::string token; std::getline(ss, token, ',');)
+        {
+            values.push_back(std::stoi(token));
+        }
+        TLLM_CHECK_WITH_INFO(values.size() == 2 && 0 < values[0] && values[0] <= values[1],
+            "%s expects a minimum and a maximum", name.c_str());
+        return std::make_pair(values[0], values[1]);
+    };
+
+    try
+    {
+        BenchmarkParams params;
+        params.maxBatchSizes = parseList(result["max_batch_size"].as<std::string>());
+        params.cachedBlocks = parseList(result["cached_blocks"].as<std::string>());
+        params.beamWidth = result["beam_width"].as<int>();
+        params.tokensPerBlock = result["tokens_per_block"].as<int>();
+        params.maxNumBlocks = result["max_num_blocks"].as<int>();
+        std::tie(params.minInputLen, params.maxInputLen) = parseRange("input_len");
+        std::tie(params.minOutputLen, params.maxOutputLen) = parseRange("output_len");
+        params.numPrefixes = result["num_prefixes"].as<int>();
+        params.prefixLen = result["prefix_len"].as<int>();
+        params.sharedPrefixRatio = result["shared_prefix_ratio"].as<float>();
+        params.enableBlockReuse = result["enable_block_reuse"].as<bool>();
+        params.numIterations = result["num_iterations"].as<int>();
+        params.warmUp = result["warm_up"].as<int>();
+        params.randomSeed = result["random_seed"].as<unsigned int>();
+        TLLM_CHECK_WITH_INFO(params.numIterations > 0, "num_iterations must be positive");
+
+        KvCacheManagerBenchmark benchmark{params};
+        for (auto const cachedBlocks : params.cachedBlocks)
+        {
+            for (auto const maxBatchSize : params.maxBatchSizes)
+            {
+                benchmark.run(maxBatchSize, cachedBlocks);
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_ERROR(e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+"""Runs a matrix of C++ benchmarks and compares the results with a baseline.
+
+The matrix is a JSON file:
+
+{
+    "tolerance": 0.05,
+    "metric_tolerances": {"p99_time_to_first_token(ms)": 0.15},
+    "models": [
+        {
+            "name": "llama_7b",
+            "engine_dir": "/engines/llama_7b/fp16/1-gpu",
+            "fp8_kv_engine_dir": "/engines/llama_7b/fp16_kv_fp8/1-gpu",
+            "dataset": "/data/llama_7b_norm_dist.json"
+        }
+    ],
+    "runs": [
+        {
+            "benchmark": "gptSessionBenchmark",
+            "models": ["llama_7b"],
+            "batch_sizes": [1, 8, 64],
+            "input_output_lens": ["128,128", "2048,128"],
+            "features": [[], ["cuda_graph"], ["fp8_kv"]]
+        },
+        {
+            "benchmark": "gptManagerBenchmark",
+            "models": ["llama_7b"],
+            "batch_sizes": [64],
+            "features": [[], ["chunked_context"], ["kv_reuse"], ["fp8_kv"]],
+            "args": ["--max_num_samples", "500"]
+        }
+    ]
+}
+
+Every point of the matrix runs the benchmark once. The batch size is the
+static batch size of gptSessionBenchmark and the closed loop concurrency of
+gptManagerBenchmark. FP8 KV cache is a property of the engine, the fp8_kv
+feature selects fp8_kv_engine_dir instead of engine_dir.
+"""
+
+import itertools
+import json
+import re
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+import click
+
+# Feature -> arguments, by benchmark. fp8_kv is handled with the engine.
+FEATURE_ARGS = {
+    "gptSessionBenchmark": {
+        "cuda_graph": ["--enable_cuda_graph"],
+    },
+    "gptManagerBenchmark": {
+        "chunked_context": ["--enable_chunked_context", "true"],
+        "kv_reuse": ["--enable_kv_cache_reuse", "true"],
+    },
+}
+
+# Metrics that are not measurements but echo the configuration.
+CONFIG_METRICS = {
+    "batch_size", "input_length", "output_length", "num_samples",
+    "concurrency", "request_rate"
+}
+
+BENCHMARK_LINE = re.compile(r"^\[BENCHMARK\]\s+(.*)$")
+
+
+def higher_is_better(metric: str) -> bool:
+    return any(
+        key in metric
+        for key in ("throughput", "PerSec", "goodput", "fraction"))
+
+
+def parse_benchmark_output(output: str) -> dict:
+    """Collects the `[BENCHMARK] key value [key value...]` pairs."""
+    metrics = {}
+    for line in output.splitlines():
+        match = BENCHMARK_LINE.match(line.strip())
+        if match is None:
+            continue
+        tokens = match.group(1).split()
+        for key, value in zip(tokens[::2], tokens[1::2]):
+            try:
+                metrics[key] = float(value)
+            except ValueError:
+                pass
+    return {
+        key: value
+        for key, value in metrics.items() if key not in CONFIG_METRICS
+    }
+
+
+def query_gpus() -> list:
+    fields = ["name", "driver_version", "memory.total", "clocks.max.sm"]
+    try:
+        output = subprocess.run([
+            "nvidia-smi", f"--query-gpu={','.join(fields)}",
+            "--format=csv,noheader,nounits"
+        ],
+                                check=True,
+                                capture_output=True,
+                                text=True).stdout
+    except (OSError, subprocess.CalledProcessError):
+        return []
+    return [
+        dict(zip(fields, (value.strip() for value in line.split(","))))
+        for line in output.strip().splitlines()
+    ]
+
+
+def query_git_commit() -> str:
+    try:
+        return subprocess.run(["git", "rev-parse", "HEAD"],
+                              check=True,
+                              capture_output=True,
+                              text=True,
+                              cwd=Path(__file__).parent).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def expand_matrix(matrix: dict):
+    """Yields (point id, benchmark, command arguments) for every point."""
+    models = {model["name"]: model for model in matrix["models"]}
+    for run in matrix["runs"]:
+        benchmark = run["benchmark"]
+        if benchmark not in FEATURE_ARGS:
+            raise click.BadParameter(f"Unknown benchmark {benchmark}")
+        for model_name, batch_size, input_output_len, features in itertools.product(
+                run["models"], run.get("batch_sizes", [None]),
+                run.get("input_output_lens", [None]),
+                run.get("features", [[]])):
+            model = models[model_name]
+            engine_dir = model["engine_dir"]
+            args = []
+            for feature in features:
+                if feature == "fp8_kv":
+                    engine_dir = model["fp8_kv_engine_dir"]
+                elif feature in FEATURE_ARGS[benchmark]:
+                    args += FEATURE_ARGS[benchmark][feature]
+                else:
+                    raise click.BadParameter(
+                        f"Feature {feature} is not supported by {benchmark}")
+            args += ["--engine_dir", engine_dir]
+            point = [benchmark, model_name]
+            if benchmark == "gptSessionBenchmark":
+                args += ["--model", model.get("model", model_name)]
+                if batch_size is not None:
+                    args += ["--batch_size", str(batch_size)]
+                if input_output_len is not None:
+                    args += ["--input_output_len", input_output_len]
+            else:
+                args += ["--dataset", model["dataset"]]
+                if batch_size is not None:
+                    args += ["--concurrency", str(batch_size)]
+            if batch_size is not None:
+                point.append(f"bs{batch_size}")
+            if input_output_len is not None:
+                point.append(f"io{input_output_len.replace(',', 'x')}")
+            point += sorted(features)
+            yield "/".join(point), benchmark, args + run.get("args", [])
+
+
+def compare(results: dict, baseline: dict, tolerance: float,
+            metric_tolerances: dict) -> list:
+    """Returns the regressions, the metrics out of their tolerance band."""
+    regressions = []
+    for point, metrics in results.items():
+        for metric, value in metrics.items():
+            reference = baseline.get(point, {}).get(metric)
+            if reference is None or reference == 0:
+                continue
+            band = metric_tolerances.get(metric, tolerance)
+            change = (value - reference) / reference
+            if higher_is_better(metric):
+                change = -change
+            if change > band:
+                regressions.append((point, metric, reference, value, change,
+                                    band))
+    return regressions
+
+
+@click.command()
+@click.option("--matrix",
+              required=True,
+              type=click.Path(exists=True, dir_okay=False),
+              help="JSON file of the models, runs and tolerances.")
+@click.option("--benchmark-dir",
+              required=True,
+              type=click.Path(exists=True, file_okay=False),
+              help="Directory of the benchmark binaries, e.g. cpp/build/benchmarks.")
+@click.option("--output",
+              type=str,
+              default="perf_results.json",
+              help="Output json filename of the results.")
+@click.option("--baseline",
+              type=click.Path(exists=True, dir_okay=False),
+              help="Results of an earlier run to compare with.")
+@click.option(
+    "--launcher",
+    type=str,
+    default="",
+    help="Command the benchmarks are run with, e.g. \"mpirun -n 2\".")
+@click.option("--dry-run",
+              is_flag=True,
+              help="Print the commands of the matrix without running them.")
+def main(matrix, benchmark_dir, output, baseline, launcher, dry_run):
+    """Runs the benchmark matrix and fails on performance regressions."""
+    with open(matrix) as f:
+        matrix = json.load(f)
+    launcher = launcher.split()
+
+    results = {}
+    failures = []
+    for point, benchmark, args in expand_matrix(matrix):
+        command = launcher + [str(Path(benchmark_dir) / benchmark)] + args
+        print(f"[{point}] {' '.join(command)}", flush=True)
+        if dry_run:
+            continue
+        completed = subprocess.run(command, capture_output=True, text=True)
+        metrics = parse_benchmark_output(completed.stdout)
+        if completed.returncode != 0 or not metrics:
+            print(completed.stdout + completed.stderr, file=sys.stderr)
+            failures.append(point)
+            continue
+        results[point] = metrics
+
+    if dry_run:
+        return
+
+    report = {
+        "timestamp": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "git_commit": query_git_commit(),
+        "gpus": query_gpus(),
+        "results": results,
+    }
+    with open(output, "w") as f:
+        json.dump(report, f, indent=4)
+    print(f"Results written to {output}")
+
+    regressions = []
+    if baseline is not None:
+        with open(baseline) as f:
+            baseline = json.load(f)
+        if baseline.get("gpus") != report["gpus"]:
+            print("Warning: the baseline was measured on other GPUs or "
+                  "another driver: " + json.dumps(baseline.get("gpus")))
+        missing = sorted(set(baseline["results"]) - set(results))
+        if missing:
+            print("Warning: no results for the baseline points " +
+                  ", ".join(missing))
+        regressions = compare(results, baseline["results"],
+                              matrix.get("tolerance", 0.05),
+                              matrix.get("metric_tolerances", {}))
+        for point, metric, reference, value, change, band in regressions:
+            print(f"REGRESSION [{point}] {metric}: {reference:.2f} -> "
+                  f"{value:.2f} ({change:+.1%} worse, tolerance {band:.1%})")
+        if not regressions:
+            print("No regression against the baseline.")
+
+    for point in failures:
+        print(f"FAILED [{point}]")
+    if regressions or failures:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <memory>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Chooses the number of draft tokens of each iteration, from maxDraftTokens down to 0, from the current number of
+// generation requests and the measured acceptance.
+// Verification costs a forward pass over numGenRequests * (draftLength + 1) tokens. As long as that stays below
+// computeBoundTokens the step is memory bound and about as fast as a step without drafts, above it the step time
+// grows linearly. With a per token acceptance rate a, approximated by the measured fraction of accepted drafts, a
+// step produces (1 - a^(k+1)) / (1 - a) tokens in expectation for draft length k. The policy picks the k that
+// maximizes the expected tokens per unit of step time, so a single deployment speculates when lightly loaded and
+// stops drafting when the batch is large or the drafts are rejected.
+// Works for external draft tokens (setDraftTokens) and Medusa, whose tree budget follows getMaxBatchDraftTokens.
+// Meant to be applied to the active requests once per iteration, e.g. from an override of GptManager::step.
+class AdaptiveSpeculationPolicy
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestList = std::list<std::shared_ptr<LlmRequest>>;
+
+    //! \param maxDraftTokens Draft length when speculation pays off, K.
+    //! \param computeBoundTokens Tokens per forward pass from which the step time grows with the number of tokens.
+    //! \param acceptanceDecay Weight of the history in the moving average of the acceptance, in [0, 1).
+    //! \param probeInterval After that many iterations without drafts, one iteration drafts a single token to
+    //! measure the acceptance again.
+    explicit AdaptiveSpeculationPolicy(SizeType maxDraftTokens, SizeType computeBoundTokens = 256,
+        float acceptanceDecay = 0.9f, SizeType probeInterval = 64)
+        : mMaxDraftTokens{maxDraftTokens}
+        , mComputeBoundTokens{computeBoundTokens}
+        , mAcceptanceDecay{acceptanceDecay}
+        , mProbeInterval{probeInterval}
+    {
+        TLLM_CHECK_WITH_INFO(maxDraftTokens >= 0, "Maximum number of draft tokens must not be negative");
+        TLLM_CHECK_WITH_INFO(computeBoundTokens > 0, "Number of compute bound tokens must be positive");
+        TLLM_CHECK_WITH_INFO(acceptanceDecay >= 0.f && acceptanceDecay < 1.f, "acceptanceDecay must be in [0, 1)");
+        TLLM_CHECK_WITH_INFO(probeInterval > 0, "Probe interval must be positive");
+    }
+
+    //! \brief Record the outcome of a verification, e.g. of one request or of a whole iteration.
+    void recordAcceptance(SizeType numDraftTokens, SizeType numAcceptedTokens)
+    {
+        if (numDraftTokens <= 0)
+        {
+            return;
+        }
+        mDraftTokens = mAcceptanceDecay * mDraftTokens + (1.f - mAcceptanceDecay) * static_cast<float>(numDraftTokens);
+        mAcceptedTokens = mAcceptanceDecay * mAcceptedTokens
+            + (1.f - mAcceptanceDecay) * static_cast<float>(std::min(numAcceptedTokens, numDraftTokens));
+    }
+
+    //! \brief Measured fraction of accepted draft tokens, optimistic until the first measurement.
+    [[nodiscard]] float getAcceptanceRate() const noexcept
+    {
+        return mDraftTokens > 0.f ? mAcceptedTokens / mDraftTokens : 1.f;
+    }
+
+    //! \brief Expected tokens per step of one request for draft length k and acceptance rate a.
+    [[nodiscard]] static float expectedTokensPerStep(SizeType draftLength, float acceptanceRate)
+    {
+        if (acceptanceRate >= 1.f)
+        {
+            return static_cast<float>(draftLength + 1);
+        }
+        return (1.f - std::pow(acceptanceRate, static_cast<float>(draftLength + 1))) / (1.f - acceptanceRate);
+    }
+
+    //! \brief Draft length that maximizes the throughput for numGenRequests requests in generation.
+    [[nodiscard]] SizeType computeDraftLength(SizeType numGenRequests) const
+    {
+        if (numGenRequests <= 0)
+        {
+            return mMaxDraftTokens;
+        }
+        auto const acceptanceRate = getAcceptanceRate();
+        auto const throughput = [&](SizeType draftLength)
+        {
+            auto const numTokens = static_cast<float>(numGenRequests * (draftLength + 1));
+            auto const stepTime = std::max(1.f, numTokens / static_cast<float>(mComputeBoundTokens));
+            return expectedTokensPerStep(draftLength, acceptanceRate) / stepTime;
+        };
+        SizeType bestDraftLength{0};
+        auto bestThroughput = throughput(0);
+        for (SizeType draftLength = 1; draftLength <= mMaxDraftTokens; ++draftLength)
+        {
+            // Longer drafts must win clearly, they also cost draft model or Medusa head compute.
+            auto const candidate = throughput(draftLength);
+            if (candidate > bestThroughput * (1.f + kMinGain))
+            {
+                bestDraftLength = draftLength;
+                bestThroughput = candidate;
+            }
+        }
+        return bestDraftLength;
+    }
+
+    //! \brief Decide the draft length of this iteration and cut the draft tokens of the requests to it.
+    //! \return The draft length of the iteration.
+    SizeType apply(RequestList const& activeRequests)
+    {
+        auto const numGenRequests = static_cast<SizeType>(std::count_if(activeRequests.begin(),
+            activeRequests.end(), [](auto const& request) { return request->isGenerationInProgressState(); }));
+        mDraftLength = computeDraftLength(numGenRequests);
+        if (mDraftLength == 0 && mMaxDraftTokens > 0 && ++mIterationsWithoutDrafts >= mProbeInterval)
+        {
+            mDraftLength = 1;
+        }
+        if (mDraftLength > 0)
+        {
+            mIterationsWithoutDrafts = 0;
+        }
+        mNumGenRequests = numGenRequests;
+
+        for (auto const& request : activeRequests)
+        {
+            auto const& draftTokens = request->getDraftTokens();
+            if (request->isGenerationInProgressState() && draftTokens
+                && static_cast<SizeType>(draftTokens->size()) > mDraftLength)
+            {
+                request->setDraftTokens(std::make_shared<LlmRequest::VecTokens>(
+                    draftTokens->begin(), draftTokens->begin() + mDraftLength));
+            }
+        }
+        return mDraftLength;
+    }
+
+    //! \brief Draft length chosen by the last call to apply.
+    [[nodiscard]] SizeType getDraftLength() const noexcept
+    {
+        return mDraftLength;
+    }
+
+    //! \brief Draft tokens of the whole batch for the last iteration, e.g. the budget of a MedusaTreeSelector.
+    [[nodiscard]] SizeType getMaxBatchDraftTokens() const noexcept
+    {
+        return mDraftLength * mNumGenRequests;
+    }
+
+private:
+    static float constexpr kMinGain{0.01f};
+
+    SizeType mMaxDraftTokens;
+    SizeType mComputeBoundTokens;
+    float mAcceptanceDecay;
+    SizeType mProbeInterval;
+    // Moving averages of the draft tokens proposed and accepted per verification
+    float mDraftTokens{0.f};
+    float mAcceptedTokens{0.f};
+    SizeType mDraftLength{0};
+    SizeType mNumGenRequests{0};
+    SizeType mIterationsWithoutDrafts{0};
+};
+
+} // namespace tensorrt_llm::batch_manager
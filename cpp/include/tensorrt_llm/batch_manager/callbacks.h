@@ -27,9 +27,13 @@ namespace tensorrt_llm::batch_manager
 
 class InferenceRequest;
 class NamedTensor;
+struct StreamingResponseView;
 
 using GetInferenceRequestsCallback = std::function<std::list<std::shared_ptr<InferenceRequest>>(int32_t)>;
 using SendResponseCallback = std::function<void(uint64_t, std::list<NamedTensor> const&, bool, const std::string&)>;
+// Streaming variant of SendResponseCallback, the view is only valid until the callback returns, see
+// streamingResponseArena.h
+using StreamingResponseCallback = std::function<void(StreamingResponseView const&)>;
 using PollStopSignalCallback = std::function<std::unordered_set<uint64_t>()>;
 // json of stats as a string
 using ReturnBatchManagerStatsCallback = std::function<void(const std::string&)>;
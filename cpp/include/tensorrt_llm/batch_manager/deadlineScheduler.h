@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/kvCacheSwapSpace.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/requestSchedulingTable.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/loraCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+// Measured cost of the iterations of the executor. Fits the duration of an iteration as a fixed cost per step, which
+// is what every running decode waits for, plus a cost per context token, by least squares with exponential
+// forgetting so that the model follows changes of the load.
+class IterationCostModel
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using Duration = std::chrono::duration<double>;
+
+    // decay is the weight of the previous observations when a new one is added, minObservations the number of
+    // iterations before predictions are made.
+    explicit IterationCostModel(double decay = 0.95, SizeType minObservations = 8)
+        : mDecay{decay}
+        , mMinObservations{minObservations}
+    {
+        TLLM_CHECK_WITH_INFO(decay > 0.0 && decay < 1.0, "Decay (%f) must be in (0, 1)", decay);
+    }
+
+    //! \brief Record an iteration that processed numContextTokens context tokens and took duration.
+    void observe(SizeType numContextTokens, Duration duration)
+    {
+        auto const x = static_cast<double>(numContextTokens);
+        auto const y = duration.count();
+        mWeight = mDecay * mWeight + 1.0;
+        mSumX = mDecay * mSumX + x;
+        mSumY = mDecay * mSumY + y;
+        mSumXX = mDecay * mSumXX + x * x;
+        mSumXY = mDecay * mSumXY + x * y;
+        ++mNumObservations;
+    }
+
+    [[nodiscard]] bool isCalibrated() const noexcept
+    {
+        return mNumObservations >= mMinObservations;
+    }
+
+    //! \brief Seconds per context token. Zero until iterations with different numbers of context tokens were seen.
+    [[nodiscard]] double getCostPerContextToken() const
+    {
+        if (mWeight == 0.0)
+        {
+            return 0.0;
+        }
+        auto const meanX = mSumX / mWeight;
+        auto const varX = mSumXX / mWeight - meanX * meanX;
+        if (varX <= 1e-9 * std::max(1.0, meanX * meanX))
+        {
+            return 0.0;
+        }
+        auto const covXY = mSumXY / mWeight - meanX * mSumY / mWeight;
+        return std::max(covXY / varX, 0.0);
+    }
+
+    //! \brief Seconds of an iteration without context tokens, i.e. of one decode step.
+    [[nodiscard]] double getCostPerStep() const
+    {
+        if (mWeight == 0.0)
+        {
+            return 0.0;
+        }
+        return std::max((mSumY - getCostPerContextToken() * mSumX) / mWeight, 0.0);
+    }
+
+    //! \brief Time the request still needs to complete if it is scheduled in every iteration from now on: its
+    //! remaining context, then one step per remaining token. Steps with draft tokens may produce several tokens, so
+    //! this is an upper bound for speculative decoding.
+    [[nodiscard]] Duration predictRemainingTime(LlmRequest const& request) const
+    {
+        auto const numContextTokens = request.isContextInitState() ? request.getContextRemainingLength() : 0;
+        auto const numGenerated = request.isContextInitState() ? 0 : request.getMaxNumGeneratedTokens();
+        auto const numSteps = std::max(request.mMaxNewTokens - numGenerated, 0);
+        return Duration{numContextTokens * getCostPerContextToken() + numSteps * getCostPerStep()};
+    }
+
+private:
+    double mDecay;
+    SizeType mMinObservations;
+    SizeType mNumObservations{0};
+    // Exponentially weighted sums of the observations
+    double mWeight{0.0};
+    double mSumX{0.0};
+    double mSumY{0.0};
+    double mSumXX{0.0};
+    double mSumXY{0.0};
+};
+
+// Resources held by requests in flight, released by DeadlineScheduler when it drops a request. Unset members are
+// skipped.
+struct RequestResources
+{
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    kv_cache_manager::KVCacheManager* kvCacheManager{nullptr};
+    kv_cache_manager::KVCacheSwapSpace* swapSpace{nullptr};
+    runtime::LoraCache* loraCache{nullptr};
+    // Frees the decoder slot, i.e. the sequence slot, of a request
+    std::function<void(SizeType seqSlot)> releaseSeqSlot{};
+};
+
+// Deadline-aware admission and dropping of expired or cancelled requests.
+// admit() rejects a new request whose predicted completion, from the measured IterationCostModel, lies past its
+// deadline, so that it fails fast instead of taking capacity it cannot use in time. dropExpired() runs before the
+// capacity scheduler of every iteration and removes the requests that were cancelled or missed their deadline
+// anywhere in the active list, waiting or running, releasing their KV cache blocks, swap space, decoder slot and LoRA
+// pin right away so that the same iteration can schedule other requests into them. Deadlines and cancellations are read
+// from a RequestSchedulingTable, which may be shared with a PriorityScheduler.
+class DeadlineScheduler
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestPtr = std::shared_ptr<LlmRequest>;
+    using RequestList = std::list<RequestPtr>;
+    using TimePoint = RequestSchedulingTable::TimePoint;
+
+    explicit DeadlineScheduler(IterationCostModel costModel = IterationCostModel{},
+        std::shared_ptr<RequestSchedulingTable> schedulingTable = std::make_shared<RequestSchedulingTable>())
+        : mCostModel{std::move(costModel)}
+        , mSchedulingTable{std::move(schedulingTable)}
+    {
+        TLLM_CHECK_WITH_INFO(mSchedulingTable, "Scheduling table must not be null");
+    }
+
+    [[nodiscard]] std::shared_ptr<RequestSchedulingTable> const& getSchedulingTable() const noexcept
+    {
+        return mSchedulingTable;
+    }
+
+    [[nodiscard]] IterationCostModel& getCostModel() noexcept
+    {
+        return mCostModel;
+    }
+
+    [[nodiscard]] IterationCostModel const& getCostModel() const noexcept
+    {
+        return mCostModel;
+    }
+
+    //! \brief Predicted completion of the request if it is scheduled in every iteration from now on.
+    [[nodiscard]] TimePoint predictCompletion(LlmRequest const& request, TimePoint now) const
+    {
+        return now + std::chrono::duration_cast<TimePoint::duration>(mCostModel.predictRemainingTime(request));
+    }
+
+    //! \brief Whether a new request can meet its deadline. Requests without deadline are always admitted, and so are
+    //! all requests while the cost model is not calibrated.
+    [[nodiscard]] bool admit(LlmRequest const& request, TimePoint now = std::chrono::steady_clock::now())
+    {
+        auto const deadline = mSchedulingTable->getDeadline(request.mRequestId);
+        if (!deadline || !mCostModel.isCalibrated() || predictCompletion(request, now) <= *deadline)
+        {
+            return true;
+        }
+        TLLM_LOG_DEBUG("Rejecting request %lu, it cannot complete before its deadline", request.mRequestId);
+        ++mNumRejected;
+        return false;
+    }
+
+    //! \brief Remove the cancelled and expired requests from the list and release their resources.
+    //! \details The dropped requests are marked complete, so their final response carries the tokens generated so far,
+    //! and their entries are erased from the scheduling table.
+    //! \return The dropped requests.
+    std::vector<RequestPtr> dropExpired(
+        RequestList& requests, RequestResources const& resources, TimePoint now = std::chrono::steady_clock::now())
+    {
+        std::vector<RequestPtr> dropped;
+        for (auto it = requests.begin(); it != requests.end();)
+        {
+            auto const& request = *it;
+            auto const cancelled = mSchedulingTable->isCancelled(request->mRequestId);
+            if (!cancelled && !mSchedulingTable->isExpired(request->mRequestId, now))
+            {
+                ++it;
+                continue;
+            }
+            TLLM_LOG_DEBUG("Dropping %s request %lu", cancelled ? "cancelled" : "expired", request->mRequestId);
+            release(*request, resources);
+            request->mState = REQUEST_STATE_GENERATION_COMPLETE;
+            (cancelled ? mNumCancelled : mNumExpired) += 1;
+            mSchedulingTable->erase(request->mRequestId);
+            dropped.push_back(request);
+            it = requests.erase(it);
+        }
+        return dropped;
+    }
+
+    [[nodiscard]] SizeType getNumRejected() const noexcept
+    {
+        return mNumRejected;
+    }
+
+    [[nodiscard]] SizeType getNumExpired() const noexcept
+    {
+        return mNumExpired;
+    }
+
+    [[nodiscard]] SizeType getNumCancelled() const noexcept
+    {
+        return mNumCancelled;
+    }
+
+private:
+    void release(LlmRequest& request, RequestResources const& resources) const
+    {
+        auto const seqSlot = request.mSeqSlot;
+        if (seqSlot >= 0)
+        {
+            // The context of a dropped request may be incomplete, so its blocks are not stored for reuse.
+            if (resources.kvCacheManager != nullptr)
+            {
+                resources.kvCacheManager->removeSequence(seqSlot);
+            }
+            if (resources.releaseSeqSlot)
+            {
+                resources.releaseSeqSlot(seqSlot);
+            }
+            request.mSeqSlot = -1;
+        }
+        if (resources.swapSpace != nullptr)
+        {
+            resources.swapSpace->discard(request.mRequestId);
+        }
+        if (resources.loraCache != nullptr && mSchedulingTable->getLoraTaskId(request.mRequestId))
+        {
+            resources.loraCache->release(request.mRequestId);
+        }
+    }
+
+    IterationCostModel mCostModel;
+    std::shared_ptr<RequestSchedulingTable> mSchedulingTable;
+    SizeType mNumRejected{0};
+    SizeType mNumExpired{0};
+    SizeType mNumCancelled{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/inferenceRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include "tensorrt_llm/runtime/spscQueue.h"
+
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Counterpart of RequestBroadcaster for the ranks of an InProcessWorld, with the same usage.
+// The root hands the requests of an iteration to every other rank through a lock-free single producer queue per rank,
+// nothing is serialized and no collective is called. The followers receive shallow copies of the requests, which share
+// the input tensors of the root. The root may run ahead of the followers by up to kCapacity iterations.
+class InProcessRequestBroadcaster
+{
+public:
+    using RequestList = std::list<std::shared_ptr<InferenceRequest>>;
+
+    static std::size_t constexpr kCapacity{64};
+
+    // Collective over the ranks of the current world, which must all use the same root.
+    explicit InProcessRequestBroadcaster(int root)
+        : mRoot{root}
+    {
+        auto* world = runtime::InProcessWorld::getCurrent();
+        TLLM_CHECK_WITH_INFO(world != nullptr, "InProcessRequestBroadcaster must be created on the ranks of a world");
+        mRank = *runtime::InProcessWorld::getCurrentRank();
+        auto const size = world->getSize();
+        mQueues = world->getShared<Queues>("requestBroadcaster" + std::to_string(root),
+            [size]()
+            {
+                auto queues = std::make_shared<Queues>();
+                for (runtime::SizeType rank = 0; rank < size; ++rank)
+                {
+                    queues->push_back(std::make_unique<runtime::SpscQueue<RequestList>>(kCapacity));
+                }
+                return queues;
+            });
+    }
+
+    InProcessRequestBroadcaster(InProcessRequestBroadcaster const&) = delete;
+    InProcessRequestBroadcaster& operator=(InProcessRequestBroadcaster const&) = delete;
+
+    [[nodiscard]] bool isRoot() const
+    {
+        return mRank == mRoot;
+    }
+
+    // Hands a copy of the requests to every follower on the root, ignored on the followers.
+    void start(RequestList const& requests)
+    {
+        TLLM_CHECK_WITH_INFO(!mStarted, "The previous broadcast was not finished");
+        mStarted = true;
+        if (!isRoot())
+        {
+            return;
+        }
+        mRequests = requests;
+        for (std::size_t rank = 0; rank < mQueues->size(); ++rank)
+        {
+            if (static_cast<int>(rank) == mRoot)
+            {
+                continue;
+            }
+            RequestList copies;
+            for (auto const& request : requests)
+            {
+                copies.push_back(std::make_shared<InferenceRequest>(*request));
+            }
+            while (!(*mQueues)[rank]->tryPush(std::move(copies)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Completes the broadcast.
+    // \returns the requests passed to start on the root, their copies on the followers
+    RequestList finish()
+    {
+        TLLM_CHECK_WITH_INFO(mStarted, "No broadcast was started");
+        mStarted = false;
+        if (isRoot())
+        {
+            return std::move(mRequests);
+        }
+        auto& queue = *(*mQueues)[mRank];
+        std::optional<RequestList> requests;
+        while (!(requests = queue.tryPop()))
+        {
+            std::this_thread::yield();
+        }
+        return std::move(*requests);
+    }
+
+private:
+    // Queue of every rank, the one of the root is unused
+    using Queues = std::vector<std::unique_ptr<runtime::SpscQueue<RequestList>>>;
+
+    int mRoot;
+    int mRank{0};
+    std::shared_ptr<Queues> mQueues;
+    bool mStarted{false};
+    RequestList mRequests;
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -59,6 +59,10 @@ auto constexpr kReturnContextLogitsTensorName = "return_context_logits";
 auto constexpr kReturnGenerationLogitsTensorName = "return_generation_logits";
 auto constexpr kPromptEmbeddingTableName = "prompt_embedding_table";
 auto constexpr kPromptVocabSizeName = "prompt_vocab_size";
+// number of sequences sampled for the prompt, sharing one context, see ParallelSamplingTable
+auto constexpr kNumReturnSequencesTensorName = "num_return_sequences";
+// number of final input tokens scored instead of generating, see ScoringRequestTable
+auto constexpr kContinuationLengthTensorName = "continuation_length";
 // weights for a lora adapter shape [ num_lora_modules_layers, D x Hi + Ho x D ]
 // where the last dimension holds the in / out adapter weights for the associated module (e.g. attn_qkv) and model layer
 // each of the in / out tensors are first flattened and then concatenated together in the format above.
@@ -189,6 +193,8 @@ public:
         inference_request::kReturnGenerationLogitsTensorName,
         inference_request::kPromptEmbeddingTableName,
         inference_request::kPromptVocabSizeName,
+        inference_request::kNumReturnSequencesTensorName,
+        inference_request::kContinuationLengthTensorName,
         // obsolete names for backward compatibility
         inference_request::kInputLengthsTensorName,
         inference_request::kLoraWeights,
@@ -255,6 +261,8 @@ public:
     TENSOR_GETTER_SETTER(ReturnGenerationLogits, inference_request::kReturnGenerationLogitsTensorName)
     TENSOR_GETTER_SETTER(PromptEmbeddingTable, inference_request::kPromptEmbeddingTableName)
     TENSOR_GETTER_SETTER(PromptVocabSize, inference_request::kPromptVocabSizeName)
+    TENSOR_GETTER_SETTER(NumReturnSequences, inference_request::kNumReturnSequencesTensorName)
+    TENSOR_GETTER_SETTER(ContinuationLength, inference_request::kContinuationLengthTensorName)
     TENSOR_GETTER_SETTER(LoraWeights, inference_request::kLoraWeights)
     TENSOR_GETTER_SETTER(LoraConfig, inference_request::kLoraConfig)
 
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheCopyOnWrite.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Relocation of live blocks into the prefix [0, numLiveBlocks) of the KV cache pools.
+struct CompactionPlan
+{
+    // (source, destination) block copies, destinations are free blocks
+    std::vector<CopyOnWriteBlockTable::BlockCopy> moves;
+    // Old block id -> new block id for every moved block
+    std::unordered_map<runtime::SizeType, runtime::SizeType> remap;
+    runtime::SizeType numLiveBlocks{0};
+};
+
+// Online defragmentation of the KV cache pools.
+// Live blocks outside the prefix of the pool are moved into free blocks inside the prefix, highest first into the
+// lowest free block. The copies of one step are enqueued with a single launch per pool, so compaction can run in
+// small steps between iterations by bounding maxMoves. Once all live blocks are in the prefix, the tail of the pools
+// can be given back with shrinkPool.
+class KVCacheCompactor
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    //! \brief Plan the relocation of live blocks.
+    //! \param isLive isLive[b] is true if block b is referenced by a sequence or kept for reuse.
+    //! \param maxMoves Maximum number of blocks moved in this step.
+    [[nodiscard]] static CompactionPlan plan(
+        std::vector<bool> const& isLive, SizeType maxMoves = std::numeric_limits<SizeType>::max())
+    {
+        CompactionPlan plan;
+        auto const numBlocks = static_cast<SizeType>(isLive.size());
+        plan.numLiveBlocks = static_cast<SizeType>(std::count(isLive.begin(), isLive.end(), true));
+
+        SizeType hole{0};
+        SizeType live{numBlocks - 1};
+        while (static_cast<SizeType>(plan.moves.size()) < maxMoves)
+        {
+            while (hole < plan.numLiveBlocks && isLive[hole])
+            {
+                ++hole;
+            }
+            while (live >= plan.numLiveBlocks && !isLive[live])
+            {
+                --live;
+            }
+            if (hole >= plan.numLiveBlocks || live < plan.numLiveBlocks)
+            {
+                break;
+            }
+            plan.moves.emplace_back(live, hole);
+            plan.remap.emplace(live, hole);
+            ++hole;
+            --live;
+        }
+        return plan;
+    }
+
+    //! \brief Number of live blocks outside the prefix, i.e. moves left until the pool is compact.
+    [[nodiscard]] static SizeType countMisplaced(std::vector<bool> const& isLive)
+    {
+        auto const numLiveBlocks = std::count(isLive.begin(), isLive.end(), true);
+        return static_cast<SizeType>(std::count(isLive.begin() + numLiveBlocks, isLive.end(), true));
+    }
+
+    //! \brief Enqueue the block copies of plan in every pool on the stream of bufferManager.
+    //! \details Block tables must be remapped before the next engine step reads them, and the sources can only be
+    //! released once the copies have completed on that stream.
+    static void apply(CompactionPlan const& plan, std::vector<runtime::ITensor::SharedPtr> const& pools,
+        runtime::BufferManager const& bufferManager)
+    {
+        copyBlocks(plan.moves, pools, bufferManager);
+    }
+
+    //! \brief Rewrite block ids, e.g. GenerationRequest::getCacheBlockIds of every sequence, according to plan.
+    static void remapBlockIds(CompactionPlan const& plan, std::vector<std::vector<SizeType>>& cacheBlockIds)
+    {
+        for (auto& beamBlockIds : cacheBlockIds)
+        {
+            for (auto& blockId : beamBlockIds)
+            {
+                if (auto it = plan.remap.find(blockId); it != plan.remap.end())
+                {
+                    blockId = it->second;
+                }
+            }
+        }
+    }
+
+    //! \brief Allocate a pool holding only the first numBlocks blocks of pool and copy them over.
+    //! \details The old pool is released when the last reference to it is dropped. The freed memory goes back to the
+    //! CUDA memory pool and is returned to the driver with BufferManager::memoryPoolTrimTo.
+    [[nodiscard]] static runtime::ITensor::SharedPtr shrinkPool(
+        runtime::ITensor::SharedPtr const& pool, SizeType numBlocks, runtime::BufferManager const& bufferManager)
+    {
+        auto shape = pool->getShape();
+        TLLM_CHECK_WITH_INFO(numBlocks > 0 && numBlocks <= shape.d[0], "Cannot shrink pool of %ld blocks to %d blocks",
+            static_cast<long>(shape.d[0]), numBlocks);
+        shape.d[0] = numBlocks;
+        auto shrunk = bufferManager.gpu(shape, pool->getDataType());
+        bufferManager.copy(*runtime::ITensor::slice(pool, 0, numBlocks), *shrunk);
+        return shrunk;
+    }
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
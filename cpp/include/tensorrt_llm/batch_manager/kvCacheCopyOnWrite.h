@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Block table of the beams of one sequence with copy-on-write semantics.
+// Blocks are reference counted across beams. After a beam search step reorders the beams, beams that continue
+// the same parent share all of its blocks, and a beam only forks a block when it writes to a block that is still
+// shared. The fork copies are collected and enqueued for all sequences at once with copyBlocks.
+class CopyOnWriteBlockTable
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using BlockCopy = std::pair<SizeType, SizeType>;
+    //! Returns a free block id, e.g. by taking it from the BlockManager.
+    using AllocateBlockFn = std::function<SizeType()>;
+
+    explicit CopyOnWriteBlockTable(SizeType beamWidth)
+        : mCacheBlockIds(beamWidth)
+    {
+        TLLM_CHECK_WITH_INFO(beamWidth > 0, "Beam width must be positive");
+    }
+
+    //! \brief Table of the numSequences sequences of a parallel sampling request, held as the beams of the table.
+    //! \details The context is computed once in contextBlockIds and every block is shared by all sequences. A partial
+    //! last block is forked by prepareWrite when a sequence first writes a generated token into it, full blocks stay
+    //! shared until the sequences are released.
+    static CopyOnWriteBlockTable fromContext(std::vector<SizeType> const& contextBlockIds, SizeType numSequences)
+    {
+        CopyOnWriteBlockTable table{numSequences};
+        for (auto const blockIdx : contextBlockIds)
+        {
+            table.addSharedBlock(blockIdx);
+        }
+        return table;
+    }
+
+    [[nodiscard]] SizeType getBeamWidth() const
+    {
+        return static_cast<SizeType>(mCacheBlockIds.size());
+    }
+
+    [[nodiscard]] std::vector<std::vector<SizeType>> const& getCacheBlockIds() const
+    {
+        return mCacheBlockIds;
+    }
+
+    [[nodiscard]] SizeType getRefCount(SizeType blockIdx) const
+    {
+        auto it = mRefCounts.find(blockIdx);
+        return it != mRefCounts.end() ? it->second : 0;
+    }
+
+    //! \brief Append a block referenced by all beams, e.g. a context block.
+    void addSharedBlock(SizeType blockIdx)
+    {
+        for (auto& beamBlockIds : mCacheBlockIds)
+        {
+            beamBlockIds.push_back(blockIdx);
+        }
+        mRefCounts[blockIdx] += getBeamWidth();
+    }
+
+    //! \brief Append a block owned by a single beam.
+    void addBlock(SizeType beamIdx, SizeType blockIdx)
+    {
+        mCacheBlockIds.at(beamIdx).push_back(blockIdx);
+        ++mRefCounts[blockIdx];
+    }
+
+    //! \brief Let beam b continue the history of beam parentBeams[b], as selected by beam search.
+    //! \return Blocks that are no longer referenced by any beam and can be released.
+    std::vector<SizeType> reorderBeams(std::vector<SizeType> const& parentBeams)
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<SizeType>(parentBeams.size()) == getBeamWidth(),
+            "Expected %d parent beams, got %zu", getBeamWidth(), parentBeams.size());
+        std::vector<std::vector<SizeType>> reordered;
+        reordered.reserve(parentBeams.size());
+        for (auto const parent : parentBeams)
+        {
+            reordered.push_back(mCacheBlockIds.at(parent));
+            for (auto const blockIdx : reordered.back())
+            {
+                ++mRefCounts[blockIdx];
+            }
+        }
+        std::vector<SizeType> freedBlocks;
+        for (auto const& beamBlockIds : mCacheBlockIds)
+        {
+            for (auto const blockIdx : beamBlockIds)
+            {
+                if (decRef(blockIdx))
+                {
+                    freedBlocks.push_back(blockIdx);
+                }
+            }
+        }
+        mCacheBlockIds = std::move(reordered);
+        return freedBlocks;
+    }
+
+    //! \brief Make block blockPos of beamIdx private to the beam before the beam writes to it.
+    //! \details If the block is shared, a new block is allocated and a copy is recorded in the pending copies.
+    //! \return true if the block was forked.
+    bool prepareWrite(SizeType beamIdx, SizeType blockPos, AllocateBlockFn const& allocateBlock)
+    {
+        auto& blockIdx = mCacheBlockIds.at(beamIdx).at(blockPos);
+        if (getRefCount(blockIdx) <= 1)
+        {
+            return false;
+        }
+        auto const newBlockIdx = allocateBlock();
+        mPendingCopies.emplace_back(blockIdx, newBlockIdx);
+        decRef(blockIdx);
+        ++mRefCounts[newBlockIdx];
+        blockIdx = newBlockIdx;
+        return true;
+    }
+
+    //! \brief Fork copies recorded since the last call, as (source, destination) pairs.
+    [[nodiscard]] std::vector<BlockCopy> takePendingCopies()
+    {
+        return std::exchange(mPendingCopies, {});
+    }
+
+    //! \brief Drop all references, e.g. when the sequence terminates.
+    //! \return The distinct blocks referenced by the table.
+    std::vector<SizeType> release()
+    {
+        std::vector<SizeType> blocks;
+        blocks.reserve(mRefCounts.size());
+        for (auto const& [blockIdx, refCount] : mRefCounts)
+        {
+            blocks.push_back(blockIdx);
+        }
+        mRefCounts.clear();
+        for (auto& beamBlockIds : mCacheBlockIds)
+        {
+            beamBlockIds.clear();
+        }
+        mPendingCopies.clear();
+        return blocks;
+    }
+
+private:
+    //! \brief Returns true if the block is not referenced anymore.
+    bool decRef(SizeType blockIdx)
+    {
+        auto it = mRefCounts.find(blockIdx);
+        TLLM_CHECK_WITH_INFO(it != mRefCounts.end(), "Block %d is not referenced", blockIdx);
+        if (--it->second == 0)
+        {
+            mRefCounts.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<std::vector<SizeType>> mCacheBlockIds;
+    std::unordered_map<SizeType, SizeType> mRefCounts;
+    std::vector<BlockCopy> mPendingCopies;
+};
+
+//! \brief Enqueue block copies in every pool with a single kernel launch per pool.
+inline void copyBlocks(std::vector<CopyOnWriteBlockTable::BlockCopy> const& copies,
+    std::vector<runtime::ITensor::SharedPtr> const& pools, runtime::BufferManager const& bufferManager)
+{
+    if (copies.empty())
+    {
+        return;
+    }
+    std::vector<runtime::SizeType> srcIds;
+    std::vector<runtime::SizeType> dstIds;
+    srcIds.reserve(copies.size());
+    dstIds.reserve(copies.size());
+    for (auto const& [src, dst] : copies)
+    {
+        srcIds.push_back(src);
+        dstIds.push_back(dst);
+    }
+    auto srcDevice = bufferManager.copyFrom(srcIds, runtime::MemoryType::kGPU);
+    auto dstDevice = bufferManager.copyFrom(dstIds, runtime::MemoryType::kGPU);
+    for (auto const& pool : pools)
+    {
+        runtime::kernels::invokeCopyBlocks(*pool, *srcDevice, *dstDevice, bufferManager.getStream());
+    }
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <NvInferRuntime.h>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// KV cache of the decoder of encoder-decoder models (T5, BART, Whisper, ...).
+// The self-attention KV cache grows with the generated tokens while the cross-attention KV cache holds the
+// projected encoder output, which is written once in the context phase and then only read. Both are paged: each gets
+// its own KVCacheManager, i.e. its own pools, block manager and block tables. A sequence only takes the cross-attention
+// blocks of its actual encoder output length, so the batch size is no longer bounded by the longest possible encoder
+// input. The cross-attention pools hold the K/V of the cross-attention layers of the decoder, the block pointers of
+// both managers are passed to the attention plugins of the respective layers.
+class EncoderDecoderKVCacheManager
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using CudaStreamPtr = KVCacheManager::CudaStreamPtr;
+
+    //! \param maxSequenceLength Maximum decoder sequence length, sizes the self-attention block tables.
+    //! \param maxEncoderInputLength Maximum encoder output length, sizes the cross-attention block tables.
+    //! \param maxNumSelfBlocks, maxNumCrossBlocks Blocks of each pool, see calculateMaxNumBlocks.
+    EncoderDecoderKVCacheManager(SizeType numLayers, SizeType numKvHeads, SizeType sizePerHead,
+        SizeType tokensPerBlock, SizeType maxNumSelfBlocks, SizeType maxNumCrossBlocks, SizeType maxNumSequences,
+        SizeType maxBeamWidth, SizeType maxSequenceLength, SizeType maxEncoderInputLength, nvinfer1::DataType dtype,
+        CudaStreamPtr const& stream, bool enableBlockReuse = false, bool useUvm = false)
+        : mSelfKVCacheManager{numLayers, numKvHeads, sizePerHead, tokensPerBlock, maxNumSelfBlocks, maxNumSequences,
+            maxBeamWidth, maxSequenceLength, /*sinkTokenLength=*/0, /*useOneMoreBlock=*/false, dtype, stream,
+            enableBlockReuse, useUvm}
+        // The encoder output differs for every request even if the decoder prompts match, so its blocks are not reused.
+        , mCrossKVCacheManager{numLayers, numKvHeads, sizePerHead, tokensPerBlock, maxNumCrossBlocks, maxNumSequences,
+              maxBeamWidth, maxEncoderInputLength, /*sinkTokenLength=*/0, /*useOneMoreBlock=*/false, dtype, stream,
+              /*enableBlockReuse=*/false, useUvm}
+        , mEncoderInputLengths(maxNumSequences, 0)
+    {
+    }
+
+    //! \brief Split the blocks that fit into availableBytes between the self-attention and the cross-attention pools.
+    //! \param blockSizeInBytes Bytes of one block for all layers, the same in both pools.
+    //! \param crossKvCacheFraction Fraction of the memory for the cross-attention pools. By default, the memory is
+    //! split in proportion to the maximum decoder and encoder lengths.
+    //! \return The number of self-attention and cross-attention blocks.
+    [[nodiscard]] static std::pair<SizeType, SizeType> calculateMaxNumBlocks(std::size_t availableBytes,
+        std::size_t blockSizeInBytes, SizeType maxSequenceLength, SizeType maxEncoderInputLength,
+        std::optional<float> crossKvCacheFraction = std::nullopt)
+    {
+        TLLM_CHECK_WITH_INFO(blockSizeInBytes > 0, "Block size must be positive");
+        auto const crossFraction = crossKvCacheFraction.value_or(
+            static_cast<float>(maxEncoderInputLength) / static_cast<float>(maxSequenceLength + maxEncoderInputLength));
+        TLLM_CHECK_WITH_INFO(crossFraction > 0.f && crossFraction < 1.f,
+            "The cross-attention KV cache fraction must be in (0, 1), got %f", crossFraction);
+        auto const numBlocks = static_cast<SizeType>(availableBytes / blockSizeInBytes);
+        auto const numCrossBlocks = static_cast<SizeType>(static_cast<float>(numBlocks) * crossFraction);
+        return {numBlocks - numCrossBlocks, numCrossBlocks};
+    }
+
+    void startScheduling()
+    {
+        mSelfKVCacheManager.startScheduling();
+        mCrossKVCacheManager.startScheduling();
+    }
+
+    //! \brief Blocks the encoder output of a new sequence takes in the cross-attention pools.
+    //! \details Full blocks are shared among the beams, only a partially filled last block is allocated per beam.
+    [[nodiscard]] SizeType getNeededCrossBlocks(SizeType encoderInputLength, SizeType beamWidth) const
+    {
+        auto const tokensPerBlock = mCrossKVCacheManager.getTokensPerBlock();
+        auto const numBlocks = (encoderInputLength + tokensPerBlock - 1) / tokensPerBlock;
+        return numBlocks + (encoderInputLength % tokensPerBlock != 0 ? beamWidth - 1 : 0);
+    }
+
+    //! \brief Whether the cross-attention pools can take the encoder output of a new sequence.
+    //! \details The self-attention blocks are checked as for decoder-only models, see KVCacheManager.
+    [[nodiscard]] bool canAddSequence(SizeType encoderInputLength, SizeType beamWidth) const
+    {
+        return getNeededCrossBlocks(encoderInputLength, beamWidth) <= mCrossKVCacheManager.getNumFreeBlocks();
+    }
+
+    //! \brief Allocate the blocks of a new sequence.
+    //! \param inputLength Length of the decoder input.
+    //! \param encoderInputLength Length of the encoder output, all its blocks are allocated here.
+    void addSequence(SizeType seqSlotIdx, SizeType inputLength, SizeType encoderInputLength, SizeType beamWidth,
+        std::shared_ptr<LlmRequest> const& llmRequest = nullptr)
+    {
+        TLLM_CHECK_WITH_INFO(encoderInputLength > 0, "Encoder-decoder sequences need an encoder output");
+        mSelfKVCacheManager.addSequence(seqSlotIdx, inputLength, beamWidth, llmRequest);
+        mCrossKVCacheManager.addSequence(seqSlotIdx, encoderInputLength, beamWidth);
+        mEncoderInputLengths.at(seqSlotIdx) = encoderInputLength;
+    }
+
+    // The cross-attention KV cache does not grow during generation.
+
+    void addContextTokens(SizeType seqSlotIdx, SizeType numTokens)
+    {
+        mSelfKVCacheManager.addContextTokens(seqSlotIdx, numTokens);
+    }
+
+    void addToken(SizeType seqSlotIdx)
+    {
+        mSelfKVCacheManager.addToken(seqSlotIdx);
+    }
+
+    void removeSequence(SizeType seqSlotIdx, std::shared_ptr<LlmRequest> const& llmRequest = nullptr)
+    {
+        mSelfKVCacheManager.removeSequence(seqSlotIdx, llmRequest);
+        mCrossKVCacheManager.removeSequence(seqSlotIdx);
+        mEncoderInputLengths.at(seqSlotIdx) = 0;
+    }
+
+    void schedulingRemoveSequence(SizeType seqSlotIdx)
+    {
+        mSelfKVCacheManager.schedulingRemoveSequence(seqSlotIdx);
+        mCrossKVCacheManager.schedulingRemoveSequence(seqSlotIdx);
+    }
+
+    //! \brief Block pointers of the self-attention layers, see KVCacheManager::getBlockPointersOfBatch.
+    void getBlockPointersOfBatch(
+        runtime::ITensor& dstPointers, SizeType firstBatchSlotIdx, SizeType batchSize, SizeType beamWidth) const
+    {
+        mSelfKVCacheManager.getBlockPointersOfBatch(dstPointers, firstBatchSlotIdx, batchSize, beamWidth);
+    }
+
+    //! \brief Block pointers of the cross-attention layers, of shape [numLayers, batchSize * beamWidth, 2,
+    //! getCrossKVCacheManager().getMaxBlocksPerSeq()].
+    void getCrossBlockPointersOfBatch(
+        runtime::ITensor& dstPointers, SizeType firstBatchSlotIdx, SizeType batchSize, SizeType beamWidth) const
+    {
+        mCrossKVCacheManager.getBlockPointersOfBatch(dstPointers, firstBatchSlotIdx, batchSize, beamWidth);
+    }
+
+    //! \brief Encoder output length of the sequence in a slot, 0 if the slot is empty.
+    [[nodiscard]] SizeType getEncoderInputLength(SizeType seqSlotIdx) const
+    {
+        return mEncoderInputLengths.at(seqSlotIdx);
+    }
+
+    [[nodiscard]] KVCacheManager const& getSelfKVCacheManager() const noexcept
+    {
+        return mSelfKVCacheManager;
+    }
+
+    [[nodiscard]] KVCacheManager const& getCrossKVCacheManager() const noexcept
+    {
+        return mCrossKVCacheManager;
+    }
+
+    [[nodiscard]] KvCacheStats getKvCacheStats() const
+    {
+        return mSelfKVCacheManager.getKvCacheStats();
+    }
+
+    [[nodiscard]] KvCacheStats getCrossKvCacheStats() const
+    {
+        return mCrossKVCacheManager.getKvCacheStats();
+    }
+
+private:
+    KVCacheManager mSelfKVCacheManager;
+    KVCacheManager mCrossKVCacheManager;
+    // Encoder output length of the sequence in each slot
+    std::vector<SizeType> mEncoderInputLengths;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+enum class EvictionPolicyType : std::int32_t
+{
+    // Evict the block that was released or reused least recently.
+    kLRU = 0,
+    // Evict the block with the fewest reuse hits, ties broken by recency.
+    kLFU = 1,
+    // Evict the block that is cheapest to recompute, i.e. with the lowest hits weighted by prefix depth.
+    // Blocks close to the root are shared by more sequences and cost more context to rebuild.
+    kPrefixDepthWeighted = 2,
+};
+
+// Retention priority of reusable blocks. Blocks with a lower priority are always evicted before blocks with a
+// higher priority, the eviction policy only orders blocks of equal priority.
+using RetentionPriority = std::int32_t;
+RetentionPriority constexpr kMinRetentionPriority{0};
+RetentionPriority constexpr kDefaultRetentionPriority{35};
+RetentionPriority constexpr kMaxRetentionPriority{100};
+
+//! \brief Orders reusable blocks and picks the next one to evict, e.g. the slots of KVCacheHostPool.
+//! \details Blocks are inserted when they become reusable and removed when they are claimed again or evicted.
+//! All operations are O(log n) in the number of candidates.
+class EvictionPolicy
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    explicit EvictionPolicy(EvictionPolicyType type = EvictionPolicyType::kLRU)
+        : mType{type}
+    {
+    }
+
+    [[nodiscard]] EvictionPolicyType getType() const noexcept
+    {
+        return mType;
+    }
+
+    //! \brief Add a released block as eviction candidate.
+    //! \param prefixDepth Position of the block in its sequence, 0 for the first block of a prompt.
+    void insert(SizeType blockIdx, SizeType prefixDepth, RetentionPriority priority = kDefaultRetentionPriority)
+    {
+        TLLM_CHECK_WITH_INFO(priority >= kMinRetentionPriority && priority <= kMaxRetentionPriority,
+            "Retention priority %d out of range [%d, %d]", priority, kMinRetentionPriority, kMaxRetentionPriority);
+        auto& stats = mBlockStats[blockIdx];
+        if (stats.queued)
+        {
+            mQueue.erase(makeKey(blockIdx, stats));
+        }
+        stats.prefixDepth = prefixDepth;
+        // Several sequences may release the same block, keep the highest priority requested.
+        stats.priority = stats.queued ? std::max(stats.priority, priority) : priority;
+        stats.lastAccess = ++mClock;
+        stats.queued = true;
+        mQueue.insert(makeKey(blockIdx, stats));
+    }
+
+    //! \brief Remove a block from the candidates because it is reused. Counts as a reuse hit.
+    void claim(SizeType blockIdx)
+    {
+        auto it = mBlockStats.find(blockIdx);
+        if (it == mBlockStats.end())
+        {
+            return;
+        }
+        auto& stats = it->second;
+        if (stats.queued)
+        {
+            mQueue.erase(makeKey(blockIdx, stats));
+            stats.queued = false;
+        }
+        ++stats.hits;
+        stats.lastAccess = ++mClock;
+    }
+
+    //! \brief Pop the next block to evict, if any. Its statistics are reset.
+    [[nodiscard]] std::optional<SizeType> evict()
+    {
+        if (mQueue.empty())
+        {
+            return std::nullopt;
+        }
+        auto const blockIdx = std::get<kBlockIdxPos>(*mQueue.begin());
+        mQueue.erase(mQueue.begin());
+        mBlockStats.erase(blockIdx);
+        return blockIdx;
+    }
+
+    //! \brief Forget a block, e.g. because its contents were overwritten.
+    void remove(SizeType blockIdx)
+    {
+        if (auto it = mBlockStats.find(blockIdx); it != mBlockStats.end())
+        {
+            if (it->second.queued)
+            {
+                mQueue.erase(makeKey(blockIdx, it->second));
+            }
+            mBlockStats.erase(it);
+        }
+    }
+
+    [[nodiscard]] SizeType getNumCandidates() const noexcept
+    {
+        return static_cast<SizeType>(mQueue.size());
+    }
+
+    [[nodiscard]] bool contains(SizeType blockIdx) const
+    {
+        auto it = mBlockStats.find(blockIdx);
+        return it != mBlockStats.end() && it->second.queued;
+    }
+
+private:
+    struct BlockStats
+    {
+        SizeType prefixDepth{0};
+        RetentionPriority priority{kDefaultRetentionPriority};
+        std::uint64_t hits{0};
+        std::uint64_t lastAccess{0};
+        bool queued{false};
+    };
+
+    // (priority, score, lastAccess, blockIdx), the smallest key is evicted first
+    using Key = std::tuple<RetentionPriority, double, std::uint64_t, SizeType>;
+    static auto constexpr kBlockIdxPos = 3;
+
+    [[nodiscard]] Key makeKey(SizeType blockIdx, BlockStats const& stats) const
+    {
+        double score{0.0};
+        switch (mType)
+        {
+        case EvictionPolicyType::kLRU: break;
+        case EvictionPolicyType::kLFU: score = static_cast<double>(stats.hits); break;
+        case EvictionPolicyType::kPrefixDepthWeighted:
+            // Deep blocks are only shared by sequences with the same long prefix, so their hits are worth less.
+            score = static_cast<double>(stats.hits + 1) / static_cast<double>(stats.prefixDepth + 1);
+            break;
+        }
+        return {stats.priority, score, stats.lastAccess, blockIdx};
+    }
+
+    EvictionPolicyType mType;
+    std::set<Key> mQueue;
+    std::unordered_map<SizeType, BlockStats> mBlockStats;
+    // Logical time used for recency
+    std::uint64_t mClock{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
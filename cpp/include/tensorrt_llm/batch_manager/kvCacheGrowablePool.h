@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/timelineTracer.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/virtualMemory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// KV cache pools whose physical memory is allocated on demand.
+// Instead of sizing the pools from freeGpuMemoryFraction at startup, the virtual address range for maxNumBlocks
+// blocks is reserved up front and only initialNumBlocks blocks are backed by device memory. The pools grow in steps
+// of growthNumBlocks when the BlockManager runs out of free blocks and can shrink again under memory pressure,
+// e.g. after KVCacheCompactor moved the live blocks into the prefix of the pools. Block pointers never change since
+// the base address of every pool is fixed.
+class GrowableKVCachePools
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    //! \param poolShapes Shape of each pool for maxNumBlocks blocks, i.e. d[0] == maxNumBlocks.
+    GrowableKVCachePools(std::vector<runtime::ITensor::Shape> const& poolShapes, nvinfer1::DataType dtype,
+        SizeType initialNumBlocks, SizeType growthNumBlocks, int device)
+        : mGrowthNumBlocks{growthNumBlocks}
+    {
+        TLLM_CHECK_WITH_INFO(!poolShapes.empty(), "At least one KV cache pool is required");
+        TLLM_CHECK_WITH_INFO(growthNumBlocks > 0, "Growth step must be positive");
+        mMaxNumBlocks = static_cast<SizeType>(poolShapes.front().d[0]);
+        for (auto const& shape : poolShapes)
+        {
+            TLLM_CHECK_WITH_INFO(static_cast<SizeType>(shape.d[0]) == mMaxNumBlocks,
+                "All KV cache pools must have the same number of blocks");
+            auto const sizeInBytes
+                = runtime::ITensor::volumeNonNegative(shape) * runtime::BufferDataType(dtype).getSize();
+            auto buffer = std::make_unique<runtime::VirtualMemoryBuffer>(sizeInBytes, device);
+            mBytesPerBlock.push_back(sizeInBytes / static_cast<std::size_t>(mMaxNumBlocks));
+            mPools.emplace_back(runtime::ITensor::wrap(buffer->data(), dtype, shape));
+            mBuffers.emplace_back(std::move(buffer));
+        }
+        resize(std::clamp(initialNumBlocks, SizeType{1}, mMaxNumBlocks));
+    }
+
+    //! \brief Pools with the shape of maxNumBlocks blocks. Only blocks [0, getNumBlocks()) may be accessed.
+    [[nodiscard]] std::vector<runtime::ITensor::SharedPtr> const& getPools() const
+    {
+        return mPools;
+    }
+
+    //! \brief Number of blocks backed by device memory.
+    [[nodiscard]] SizeType getNumBlocks() const noexcept
+    {
+        return mNumBlocks;
+    }
+
+    [[nodiscard]] SizeType getMaxNumBlocks() const noexcept
+    {
+        return mMaxNumBlocks;
+    }
+
+    //! \brief Device memory of one block in all pools together.
+    [[nodiscard]] std::size_t getBytesPerBlock() const
+    {
+        std::size_t size{0};
+        for (auto const bytes : mBytesPerBlock)
+        {
+            size += bytes;
+        }
+        return size;
+    }
+
+    //! \brief Grow the pools by at least one growth step such that numRequiredBlocks blocks are backed.
+    //! \return Number of blocks added, 0 if the pools already hold enough blocks or are at their maximum size.
+    SizeType grow(SizeType numRequiredBlocks)
+    {
+        if (numRequiredBlocks <= mNumBlocks || mNumBlocks == mMaxNumBlocks)
+        {
+            return 0;
+        }
+        TLLM_TIMELINE_SCOPE(kKvCacheAllocation, grow);
+        auto const numSteps = (numRequiredBlocks - mNumBlocks + mGrowthNumBlocks - 1) / mGrowthNumBlocks;
+        auto const oldNumBlocks = mNumBlocks;
+        resize(std::min(mNumBlocks + numSteps * mGrowthNumBlocks, mMaxNumBlocks));
+        TLLM_LOG_DEBUG("Grew KV cache pools from %d to %d blocks", oldNumBlocks, mNumBlocks);
+        return mNumBlocks - oldNumBlocks;
+    }
+
+    //! \brief Give back the device memory of blocks [numBlocks, getNumBlocks()).
+    //! \details The blocks must be free, e.g. after compaction. The synchronization of the stream(s) that last accessed
+    //! them is the responsibility of the caller.
+    void shrink(SizeType numBlocks)
+    {
+        TLLM_CHECK_WITH_INFO(numBlocks > 0, "Cannot shrink KV cache pools to %d blocks", numBlocks);
+        if (numBlocks < mNumBlocks)
+        {
+            auto const oldNumBlocks = mNumBlocks;
+            resize(numBlocks);
+            TLLM_LOG_DEBUG("Shrunk KV cache pools from %d to %d blocks", oldNumBlocks, mNumBlocks);
+        }
+    }
+
+    //! \brief Device memory currently mapped for all pools.
+    [[nodiscard]] std::size_t getMappedSize() const
+    {
+        std::size_t size{0};
+        for (auto const& buffer : mBuffers)
+        {
+            size += buffer->getMappedSize();
+        }
+        return size;
+    }
+
+private:
+    void resize(SizeType numBlocks)
+    {
+        for (std::size_t poolIdx = 0; poolIdx < mBuffers.size(); ++poolIdx)
+        {
+            mBuffers[poolIdx]->resize(static_cast<std::size_t>(numBlocks) * mBytesPerBlock[poolIdx]);
+        }
+        // Memory is mapped in chunks, so the tail of the last chunk may hold a few additional blocks.
+        auto usableNumBlocks = mMaxNumBlocks;
+        for (std::size_t poolIdx = 0; poolIdx < mBuffers.size(); ++poolIdx)
+        {
+            usableNumBlocks = std::min(
+                usableNumBlocks, static_cast<SizeType>(mBuffers[poolIdx]->getMappedSize() / mBytesPerBlock[poolIdx]));
+        }
+        mNumBlocks = usableNumBlocks;
+    }
+
+    std::vector<std::unique_ptr<runtime::VirtualMemoryBuffer>> mBuffers;
+    // Views of the full reserved range of each buffer
+    std::vector<runtime::ITensor::SharedPtr> mPools;
+    std::vector<std::size_t> mBytesPerBlock;
+    SizeType mNumBlocks{0};
+    SizeType mMaxNumBlocks{0};
+    SizeType mGrowthNumBlocks;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
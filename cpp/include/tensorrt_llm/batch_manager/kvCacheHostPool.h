@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheEvictionPolicy.h"
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/kvCacheNvmePool.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Secondary tier of the paged KV cache in pinned host memory.
+// When the BlockManager has to evict a reusable block from the GPU pools, the block contents are copied
+// into a host slot instead of being dropped. On a later prefix hit the block can be brought back into a
+// free GPU block, which avoids recomputing the context for that part of the prompt.
+// The host pools mirror the GPU pools, i.e. host pool i has shape [numHostBlocks, ...] where the trailing
+// dimensions match GPU pool i. Host memory comes from the pinned memory pool (MemoryPool<PinnedAllocator>).
+// All copies are issued on a dedicated transfer stream and are ordered with respect to the compute stream
+// through events, so offloading and onboarding never block the host.
+// When the tier is full, the victim is picked by an EvictionPolicy from the retention priority and prefix depth given
+// at offload time, e.g. to keep the blocks of a shared system prompt over those of one-off requests.
+// With an NVMe tier (see setNvmeTier), evicted host blocks are spilled to the SSD and blocks missing from the host
+// tier are onboarded from there.
+class KVCacheHostPool
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using BlockKey = std::size_t;
+    using CudaStreamPtr = std::shared_ptr<runtime::CudaStream>;
+
+    KVCacheHostPool(SizeType numHostBlocks, std::vector<runtime::ITensor::SharedPtr> gpuPools,
+        CudaStreamPtr computeStream, CudaStreamPtr transferStream = nullptr,
+        EvictionPolicyType evictionPolicy = EvictionPolicyType::kLRU)
+        : mGpuPools{std::move(gpuPools)}
+        , mComputeStream{std::move(computeStream)}
+        , mTransferStream{transferStream ? std::move(transferStream) : std::make_shared<runtime::CudaStream>()}
+        , mBufferManager{mTransferStream}
+        , mSlots(numHostBlocks)
+        , mEvictionPolicy{evictionPolicy}
+    {
+        TLLM_CHECK_WITH_INFO(numHostBlocks > 0, "Number of host blocks must be positive");
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mComputeStream), "Undefined compute stream");
+        mHostPools.reserve(mGpuPools.size());
+        for (auto const& gpuPool : mGpuPools)
+        {
+            auto shape = gpuPool->getShape();
+            shape.d[0] = numHostBlocks;
+            mHostPools.emplace_back(mBufferManager.pinnedPool(shape, gpuPool->getDataType()));
+        }
+        for (SizeType slotIdx = 0; slotIdx < numHostBlocks; ++slotIdx)
+        {
+            mFreeSlots.push_back(slotIdx);
+        }
+    }
+
+    //! \brief Combine the key of the previous block with the tokens of a block.
+    //! \details Keys identify a block together with its whole prefix, like a path in the reuse tree.
+    [[nodiscard]] static BlockKey hashBlockKey(BlockKey prevKey, VecTokens const& tokens) noexcept
+    {
+        auto const tokensHash = std::hash<VecTokens>{}(tokens);
+        return prevKey ^ (tokensHash + 0x9e3779b97f4a7c15ULL + (prevKey << 6) + (prevKey >> 2));
+    }
+
+    //! \brief Number of host blocks that fit into hostCacheSize bytes for the given GPU pools.
+    [[nodiscard]] static SizeType calculateMaxNumBlocks(
+        std::size_t hostCacheSize, std::vector<runtime::ITensor::SharedPtr> const& gpuPools)
+    {
+        std::size_t bytesPerBlock{0};
+        for (auto const& gpuPool : gpuPools)
+        {
+            auto const numBlocks = static_cast<std::size_t>(gpuPool->getShape().d[0]);
+            bytesPerBlock += gpuPool->getSizeInBytes() / numBlocks;
+        }
+        return bytesPerBlock > 0 ? static_cast<SizeType>(hostCacheSize / bytesPerBlock) : 0;
+    }
+
+    //! \brief Copy GPU block gpuBlockIdx into the host tier under key.
+    //! \details Evicts the host block picked by the eviction policy if the tier is full. The compute stream waits for
+    //! the copy to complete before it can overwrite the GPU block.
+    //! \param prefixDepth Position of the block in its sequence, 0 for the first block of a prompt.
+    //! \param priority Retention priority of the block, blocks with a lower priority are evicted first.
+    void offloadBlock(BlockKey key, VecTokens const& tokens, SizeType gpuBlockIdx, SizeType prefixDepth = 0,
+        RetentionPriority priority = kDefaultRetentionPriority)
+    {
+        if (auto it = mKeyToSlot.find(key); it != mKeyToSlot.end())
+        {
+            if (mSlots[it->second].tokens == tokens)
+            {
+                // The block is already cached, keep the highest priority requested.
+                auto& slot = mSlots[it->second];
+                slot.prefixDepth = prefixDepth;
+                slot.priority = std::max(slot.priority, priority);
+                mEvictionPolicy.insert(it->second, slot.prefixDepth, slot.priority);
+                return;
+            }
+            // Same hash, different tokens: the older block is unreachable from now on
+            releaseSlot(it->second);
+        }
+
+        auto const slotIdx = acquireSlot();
+        auto& slot = mSlots[slotIdx];
+        slot.key = key;
+        slot.tokens = tokens;
+        slot.prefixDepth = prefixDepth;
+        slot.priority = priority;
+
+        copyBlocks(mGpuPools, gpuBlockIdx, mHostPools, slotIdx, slot);
+        mComputeStream->wait(*slot.ready);
+
+        mKeyToSlot[key] = slotIdx;
+        mEvictionPolicy.insert(slotIdx, prefixDepth, priority);
+        ++mNumOffloadedBlocks;
+    }
+
+    //! \brief Copy the host block stored under key back into GPU block gpuBlockIdx.
+    //! \details Falls back to the NVMe tier if the block is not in the host tier.
+    //! \return true if the block was found in the host or NVMe tier, false otherwise.
+    bool onboardBlock(BlockKey key, VecTokens const& tokens, SizeType gpuBlockIdx)
+    {
+        auto const slotIdx = findSlot(key, tokens);
+        if (!slotIdx)
+        {
+            if (mNvmeTier && mNvmeTier->onboardBlock(key, tokens, gpuBlockIdx))
+            {
+                return true;
+            }
+            ++mNumMisses;
+            return false;
+        }
+
+        copyBlocks(mHostPools, *slotIdx, mGpuPools, gpuBlockIdx, mSlots[*slotIdx]);
+        mComputeStream->wait(*mSlots[*slotIdx].ready);
+        // Count the reuse hit and requeue the block as most recently used.
+        auto const& slot = mSlots[*slotIdx];
+        mEvictionPolicy.claim(*slotIdx);
+        mEvictionPolicy.insert(*slotIdx, slot.prefixDepth, slot.priority);
+        ++mNumOnboardedBlocks;
+        return true;
+    }
+
+    //! \brief Whether onboardBlock finds the block, in the host or NVMe tier.
+    [[nodiscard]] bool hasBlock(BlockKey key, VecTokens const& tokens) const
+    {
+        return findSlot(key, tokens).has_value() || (mNvmeTier && mNvmeTier->hasBlock(key, tokens));
+    }
+
+    //! \brief Drop the block stored under key from the host and NVMe tiers, if any.
+    void removeBlock(BlockKey key)
+    {
+        if (auto it = mKeyToSlot.find(key); it != mKeyToSlot.end())
+        {
+            releaseSlot(it->second);
+        }
+        if (mNvmeTier)
+        {
+            mNvmeTier->removeBlock(key);
+        }
+    }
+
+    //! \brief Spill evicted host blocks to nvmeTier and onboard host misses from it, null to disable.
+    //! \details nvmeTier must mirror the GPU pools of this tier.
+    void setNvmeTier(std::shared_ptr<KVCacheNvmePool> nvmeTier)
+    {
+        mNvmeTier = std::move(nvmeTier);
+    }
+
+    [[nodiscard]] std::shared_ptr<KVCacheNvmePool> const& getNvmeTier() const
+    {
+        return mNvmeTier;
+    }
+
+    [[nodiscard]] SizeType getMaxNumBlocks() const
+    {
+        return static_cast<SizeType>(mSlots.size());
+    }
+
+    [[nodiscard]] SizeType getNumCachedBlocks() const
+    {
+        return static_cast<SizeType>(mKeyToSlot.size());
+    }
+
+    [[nodiscard]] std::size_t getNumOffloadedBlocks() const
+    {
+        return mNumOffloadedBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumOnboardedBlocks() const
+    {
+        return mNumOnboardedBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumMisses() const
+    {
+        return mNumMisses;
+    }
+
+    [[nodiscard]] std::vector<runtime::ITensor::SharedPtr> const& getHostPools() const
+    {
+        return mHostPools;
+    }
+
+    [[nodiscard]] EvictionPolicyType getEvictionPolicyType() const noexcept
+    {
+        return mEvictionPolicy.getType();
+    }
+
+private:
+    struct HostSlot
+    {
+        BlockKey key{0};
+        VecTokens tokens;
+        SizeType prefixDepth{0};
+        RetentionPriority priority{kDefaultRetentionPriority};
+        std::shared_ptr<runtime::CudaEvent> ready{std::make_shared<runtime::CudaEvent>()};
+    };
+
+    [[nodiscard]] std::optional<SizeType> findSlot(BlockKey key, VecTokens const& tokens) const
+    {
+        auto it = mKeyToSlot.find(key);
+        if (it == mKeyToSlot.end() || mSlots[it->second].tokens != tokens)
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    SizeType acquireSlot()
+    {
+        if (mFreeSlots.empty())
+        {
+            auto const victimIdx = mEvictionPolicy.evict();
+            TLLM_CHECK_WITH_INFO(victimIdx.has_value(), "KVCacheHostPool: no host block to evict");
+            TLLM_LOG_DEBUG("KVCacheHostPool: evicting host block %d", *victimIdx);
+            if (mNvmeTier)
+            {
+                auto const& victim = mSlots[*victimIdx];
+                mNvmeTier->spillBlock(victim.key, victim.tokens, mHostPools, *victimIdx, *victim.ready);
+            }
+            releaseSlot(*victimIdx);
+        }
+        auto const slotIdx = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        // Previous transfers from or to this slot must have completed before it is overwritten.
+        mTransferStream->wait(*mSlots[slotIdx].ready);
+        return slotIdx;
+    }
+
+    void releaseSlot(SizeType slotIdx)
+    {
+        auto& slot = mSlots[slotIdx];
+        if (auto it = mKeyToSlot.find(slot.key); it != mKeyToSlot.end() && it->second == slotIdx)
+        {
+            mKeyToSlot.erase(it);
+        }
+        mEvictionPolicy.remove(slotIdx);
+        slot.tokens.clear();
+        mFreeSlots.push_back(slotIdx);
+    }
+
+    //! \brief Copy block srcIdx of every pool in srcPools to block dstIdx of the matching pool in dstPools.
+    //! \details The ready event of the host slot involved in the transfer is recorded after the copies.
+    void copyBlocks(std::vector<runtime::ITensor::SharedPtr> const& srcPools, SizeType srcIdx,
+        std::vector<runtime::ITensor::SharedPtr> const& dstPools, SizeType dstIdx, HostSlot& slot)
+    {
+        // Wait for the compute stream to finish writing (or reading) the blocks involved in the copy.
+        runtime::CudaEvent computeDone{};
+        mComputeStream->record(computeDone);
+        mTransferStream->wait(computeDone);
+
+        for (std::size_t poolIdx = 0; poolIdx < srcPools.size(); ++poolIdx)
+        {
+            auto const srcBlock = runtime::ITensor::slice(srcPools[poolIdx], srcIdx, 1);
+            auto dstBlock = runtime::ITensor::slice(dstPools[poolIdx], dstIdx, 1);
+            mBufferManager.copy(*srcBlock, *dstBlock);
+        }
+
+        mTransferStream->record(*slot.ready);
+    }
+
+    // GPU pools of the primary tier, one per pool of the KVCacheManager
+    std::vector<runtime::ITensor::SharedPtr> mGpuPools;
+    // Pinned host pools of the secondary tier, same order as mGpuPools
+    std::vector<runtime::ITensor::SharedPtr> mHostPools;
+    // Stream on which the KV cache is read and written by the engine
+    CudaStreamPtr mComputeStream;
+    // Side stream for host <-> device block transfers
+    CudaStreamPtr mTransferStream;
+    runtime::BufferManager mBufferManager;
+    // Metadata of each host slot
+    std::vector<HostSlot> mSlots;
+    // Unused host slots
+    std::vector<SizeType> mFreeSlots;
+    // Orders the used host slots for eviction
+    EvictionPolicy mEvictionPolicy;
+    std::unordered_map<BlockKey, SizeType> mKeyToSlot;
+    // Optional tier below this one
+    std::shared_ptr<KVCacheNvmePool> mNvmeTier;
+    // Statistics for block transfers
+    std::size_t mNumOffloadedBlocks{0};
+    std::size_t mNumOnboardedBlocks{0};
+    std::size_t mNumMisses{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <NvInferRuntime.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Layers sharing the same KV cache geometry.
+struct KVCacheLayerGroup
+{
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    // Indices of the local layers in this group, in increasing order
+    std::vector<SizeType> layers;
+    SizeType numKvHeads;
+    SizeType sizePerHead;
+    // Attention window of the layers. Groups with a window shorter than the maximum sequence length use a cyclic
+    // KV cache, i.e. their blocks are recycled once the window is full.
+    SizeType attentionWindow;
+
+    //! \brief Bytes of one block for all layers of the group.
+    [[nodiscard]] std::size_t getBlockSizeInBytes(SizeType tokensPerBlock, nvinfer1::DataType dtype) const
+    {
+        return layers.size() * 2 * static_cast<std::size_t>(numKvHeads) * tokensPerBlock * sizePerHead
+            * runtime::BufferDataType(dtype).getSize();
+    }
+
+    //! \brief Blocks one sequence needs at most, i.e. for min(attentionWindow, maxSequenceLength) tokens.
+    [[nodiscard]] SizeType getMaxBlocksPerSeq(
+        SizeType tokensPerBlock, SizeType maxSequenceLength, bool useOneMoreBlock) const
+    {
+        auto const numTokens = std::min(attentionWindow, maxSequenceLength);
+        return (numTokens + tokensPerBlock - 1) / tokensPerBlock + (useOneMoreBlock ? 1 : 0);
+    }
+};
+
+//! \brief Group layers by (attention window, number of KV heads, head size).
+//! \param attentionWindows Attention window of each local layer.
+//! \param numKvHeads Number of KV heads of each local layer.
+[[nodiscard]] inline std::vector<KVCacheLayerGroup> groupLayersByGeometry(
+    std::vector<SizeType> const& attentionWindows, std::vector<SizeType> const& numKvHeads, SizeType sizePerHead)
+{
+    TLLM_CHECK_WITH_INFO(attentionWindows.size() == numKvHeads.size(),
+        "Attention windows (%zu) and KV heads (%zu) must be given for every layer", attentionWindows.size(),
+        numKvHeads.size());
+    std::map<std::tuple<SizeType, SizeType>, KVCacheLayerGroup> groups;
+    for (SizeType layer = 0; layer < static_cast<SizeType>(attentionWindows.size()); ++layer)
+    {
+        auto [it, inserted] = groups.try_emplace({attentionWindows[layer], numKvHeads[layer]});
+        if (inserted)
+        {
+            it->second = KVCacheLayerGroup{{}, numKvHeads[layer], sizePerHead, attentionWindows[layer]};
+        }
+        it->second.layers.push_back(layer);
+    }
+    std::vector<KVCacheLayerGroup> result;
+    result.reserve(groups.size());
+    for (auto& [key, group] : groups)
+    {
+        result.emplace_back(std::move(group));
+    }
+    return result;
+}
+
+// KV cache for models whose layers do not share one geometry, e.g. models interleaving sliding window and global
+// attention layers or using a different number of KV heads per layer.
+// Every layer group gets its own KVCacheManager, so each group has its own pools and block budget. Sliding window
+// groups are sized for their window and recycle their blocks cyclically, while global groups grow with the
+// sequence. Sequences are added to and removed from all groups together.
+class LayerGroupedKVCacheManager
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using CudaStreamPtr = KVCacheManager::CudaStreamPtr;
+
+    //! \param maxNumBlocks Number of blocks of each group, see calculateMaxNumBlocks.
+    LayerGroupedKVCacheManager(std::vector<KVCacheLayerGroup> groups, std::vector<SizeType> const& maxNumBlocks,
+        SizeType tokensPerBlock, SizeType maxNumSequences, SizeType maxBeamWidth, SizeType maxSequenceLength,
+        SizeType sinkTokenLength, bool useOneMoreBlock, nvinfer1::DataType dtype, CudaStreamPtr const& stream,
+        bool enableBlockReuse = false, bool useUvm = false)
+        : mGroups{std::move(groups)}
+        , mBufferManager{stream}
+    {
+        TLLM_CHECK_WITH_INFO(!mGroups.empty(), "At least one layer group is required");
+        TLLM_CHECK_WITH_INFO(maxNumBlocks.size() == mGroups.size(), "Number of blocks must be given for each group");
+        for (std::size_t groupIdx = 0; groupIdx < mGroups.size(); ++groupIdx)
+        {
+            auto const& group = mGroups[groupIdx];
+            TLLM_CHECK_WITH_INFO(!group.layers.empty(), "Layer group %zu is empty", groupIdx);
+            for (std::size_t localIdx = 0; localIdx < group.layers.size(); ++localIdx)
+            {
+                auto const layer = group.layers[localIdx];
+                if (static_cast<std::size_t>(layer) >= mLayerToGroup.size())
+                {
+                    mLayerToGroup.resize(layer + 1, -1);
+                    mLayerToLocalIdx.resize(layer + 1, -1);
+                }
+                TLLM_CHECK_WITH_INFO(mLayerToGroup[layer] < 0, "Layer %d is part of several groups", layer);
+                mLayerToGroup[layer] = static_cast<SizeType>(groupIdx);
+                mLayerToLocalIdx[layer] = static_cast<SizeType>(localIdx);
+            }
+            auto const maxAttentionWindow = std::min(group.attentionWindow, maxSequenceLength);
+            mManagers.emplace_back(std::make_unique<KVCacheManager>(static_cast<SizeType>(group.layers.size()),
+                group.numKvHeads, group.sizePerHead, tokensPerBlock, maxNumBlocks[groupIdx], maxNumSequences,
+                maxBeamWidth, maxAttentionWindow, sinkTokenLength, useOneMoreBlock, dtype, stream, enableBlockReuse,
+                useUvm));
+            mMaxBlocksPerSeq = std::max(mMaxBlocksPerSeq, mManagers.back()->getMaxBlocksPerSeq());
+        }
+        TLLM_CHECK_WITH_INFO(std::find(mLayerToGroup.begin(), mLayerToGroup.end(), -1) == mLayerToGroup.end(),
+            "Every layer must be part of a group");
+    }
+
+    //! \brief Split availableBytes between the groups such that all groups can hold the same number of sequences.
+    //! \details A global group needs blocks for maxSequenceLength tokens per sequence, a sliding window group only for
+    //! its window. Sizing every group for the full sequence would waste the memory of the sliding window layers.
+    [[nodiscard]] static std::vector<SizeType> calculateMaxNumBlocks(std::vector<KVCacheLayerGroup> const& groups,
+        std::size_t availableBytes, SizeType tokensPerBlock, SizeType maxSequenceLength, bool useOneMoreBlock,
+        nvinfer1::DataType dtype)
+    {
+        std::size_t bytesPerSequence{0};
+        for (auto const& group : groups)
+        {
+            bytesPerSequence += group.getBlockSizeInBytes(tokensPerBlock, dtype)
+                * group.getMaxBlocksPerSeq(tokensPerBlock, maxSequenceLength, useOneMoreBlock);
+        }
+        TLLM_CHECK_WITH_INFO(bytesPerSequence > 0, "Layer groups must not be empty");
+        auto const numSequences = static_cast<SizeType>(availableBytes / bytesPerSequence);
+        std::vector<SizeType> maxNumBlocks;
+        maxNumBlocks.reserve(groups.size());
+        for (auto const& group : groups)
+        {
+            maxNumBlocks.push_back(
+                numSequences * group.getMaxBlocksPerSeq(tokensPerBlock, maxSequenceLength, useOneMoreBlock));
+        }
+        return maxNumBlocks;
+    }
+
+    void startScheduling()
+    {
+        for (auto& manager : mManagers)
+        {
+            manager->startScheduling();
+        }
+    }
+
+    void addSequence(SizeType seqSlotIdx, SizeType inputLength, SizeType beamWidth,
+        std::shared_ptr<LlmRequest> const& llmRequest = nullptr)
+    {
+        for (auto& manager : mManagers)
+        {
+            manager->addSequence(seqSlotIdx, inputLength, beamWidth, llmRequest);
+        }
+    }
+
+    void addContextTokens(SizeType seqSlotIdx, SizeType numTokens)
+    {
+        for (auto& manager : mManagers)
+        {
+            manager->addContextTokens(seqSlotIdx, numTokens);
+        }
+    }
+
+    void addToken(SizeType seqSlotIdx)
+    {
+        for (auto& manager : mManagers)
+        {
+            manager->addToken(seqSlotIdx);
+        }
+    }
+
+    void removeSequence(SizeType seqSlotIdx, std::shared_ptr<LlmRequest> const& llmRequest = nullptr)
+    {
+        for (auto& manager : mManagers)
+        {
+            manager->removeSequence(seqSlotIdx, llmRequest);
+        }
+    }
+
+    void schedulingRemoveSequence(SizeType seqSlotIdx)
+    {
+        for (auto& manager : mManagers)
+        {
+            manager->schedulingRemoveSequence(seqSlotIdx);
+        }
+    }
+
+    //! \brief A request can only be scheduled if every group has enough free blocks for it.
+    [[nodiscard]] bool canAdvanceOneStep(LlmRequest const& req, bool twoStepsLookAhead) const
+    {
+        return std::all_of(mManagers.begin(), mManagers.end(), [&req, twoStepsLookAhead](auto const& manager)
+            { return manager->getNeededBlocksOneStep(req, twoStepsLookAhead) <= manager->getNumFreeBlocks(); });
+    }
+
+    //! \brief Fill the block pointers of all local layers.
+    //! \param dstPointers Host tensor of shape [numLayers, batchSize * beamWidth, 2, getMaxBlocksPerSeq()]. Rows of
+    //! groups with fewer blocks per sequence are padded with zeros.
+    void getBlockPointersOfBatch(
+        runtime::ITensor& dstPointers, SizeType firstBatchSlotIdx, SizeType batchSize, SizeType beamWidth)
+    {
+        auto const& dstShape = dstPointers.getShape();
+        TLLM_CHECK_WITH_INFO(dstShape.nbDims == 4 && dstShape.d[0] == getNumLayers()
+                && dstShape.d[3] == mMaxBlocksPerSeq,
+            "Invalid block pointer shape");
+        auto const pointerSize = runtime::BufferDataType(dstPointers.getDataType()).getSize();
+        auto const numRows = static_cast<std::size_t>(dstShape.d[1]) * dstShape.d[2];
+        auto const dstRowSize = static_cast<std::size_t>(mMaxBlocksPerSeq) * pointerSize;
+        auto* dst = static_cast<std::byte*>(dstPointers.data());
+        std::memset(dst, 0, dstPointers.getSizeInBytes());
+
+        mGroupPointers.resize(mManagers.size());
+        for (std::size_t groupIdx = 0; groupIdx < mManagers.size(); ++groupIdx)
+        {
+            auto const& manager = *mManagers[groupIdx];
+            auto groupShape = dstShape;
+            groupShape.d[0] = static_cast<SizeType>(mGroups[groupIdx].layers.size());
+            groupShape.d[3] = manager.getMaxBlocksPerSeq();
+            auto& groupPointers = mGroupPointers[groupIdx];
+            if (!groupPointers || runtime::ITensor::volumeNonNegative(groupShape) > groupPointers->getCapacity())
+            {
+                groupPointers = mBufferManager.cpu(groupShape, dstPointers.getDataType());
+            }
+            groupPointers->reshape(groupShape);
+            manager.getBlockPointersOfBatch(*groupPointers, firstBatchSlotIdx, batchSize, beamWidth);
+
+            auto const srcRowSize = static_cast<std::size_t>(groupShape.d[3]) * pointerSize;
+            auto const* src = static_cast<std::byte const*>(groupPointers->data());
+            for (std::size_t localIdx = 0; localIdx < mGroups[groupIdx].layers.size(); ++localIdx)
+            {
+                auto const layer = static_cast<std::size_t>(mGroups[groupIdx].layers[localIdx]);
+                for (std::size_t row = 0; row < numRows; ++row)
+                {
+                    std::memcpy(dst + (layer * numRows + row) * dstRowSize,
+                        src + (localIdx * numRows + row) * srcRowSize, srcRowSize);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] SizeType getNumGroups() const noexcept
+    {
+        return static_cast<SizeType>(mManagers.size());
+    }
+
+    [[nodiscard]] SizeType getNumLayers() const noexcept
+    {
+        return static_cast<SizeType>(mLayerToGroup.size());
+    }
+
+    [[nodiscard]] KVCacheLayerGroup const& getGroup(SizeType groupIdx) const
+    {
+        return mGroups.at(groupIdx);
+    }
+
+    [[nodiscard]] KVCacheManager const& getGroupManager(SizeType groupIdx) const
+    {
+        return *mManagers.at(groupIdx);
+    }
+
+    [[nodiscard]] SizeType getGroupOfLayer(SizeType layer) const
+    {
+        return mLayerToGroup.at(layer);
+    }
+
+    //! \brief Memory pool of a local layer.
+    [[nodiscard]] runtime::ITensor::SharedPtr const& getLayerMemoryPool(SizeType layer) const
+    {
+        return mManagers[getGroupOfLayer(layer)]->getMemoryPools().at(mLayerToLocalIdx.at(layer));
+    }
+
+    //! \brief Largest number of blocks per sequence over all groups.
+    [[nodiscard]] SizeType getMaxBlocksPerSeq() const noexcept
+    {
+        return mMaxBlocksPerSeq;
+    }
+
+    //! \brief Statistics of each group, in group order.
+    [[nodiscard]] std::vector<KvCacheStats> getKvCacheStats() const
+    {
+        std::vector<KvCacheStats> stats;
+        stats.reserve(mManagers.size());
+        for (auto const& manager : mManagers)
+        {
+            stats.push_back(manager->getKvCacheStats());
+        }
+        return stats;
+    }
+
+private:
+    std::vector<KVCacheLayerGroup> mGroups;
+    std::vector<std::unique_ptr<KVCacheManager>> mManagers;
+    // Group and index within the group of each local layer
+    std::vector<SizeType> mLayerToGroup;
+    std::vector<SizeType> mLayerToLocalIdx;
+    SizeType mMaxBlocksPerSeq{0};
+    runtime::BufferManager mBufferManager;
+    // Staging buffers for the block pointers of each group
+    std::vector<runtime::ITensor::SharedPtr> mGroupPointers;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
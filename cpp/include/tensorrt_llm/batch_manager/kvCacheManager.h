@@ -310,6 +310,27 @@ public:
         return mTokensPerBlock;
     }
 
+    //! \brief Root of the tree of reusable blocks. Its children are the first blocks of cached prompts.
+    [[nodiscard]] BlockPtr const& getCachedBlocksRoot() const
+    {
+        return mCachedBlocksRoot;
+    }
+
+    [[nodiscard]] std::size_t getNumAllocTotalBlocks() const
+    {
+        return mAllocTotalBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumAllocNewBlocks() const
+    {
+        return mAllocNewBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumReusedBlocks() const
+    {
+        return mReusedBlocks;
+    }
+
 private:
     //! \brief Add single block to beam of sequence and mAllocatedBlocksPerSeq.
     void addBlockToBeam(BlockPtr& block, GenerationRequest& sequence, SizeType beamIdx, SizeType seqSlotIdx);
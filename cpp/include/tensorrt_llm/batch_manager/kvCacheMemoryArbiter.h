@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheGrowablePool.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// KV cache demand of one model in the current iteration.
+struct KVCacheModelDemand
+{
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    // Blocks [0, numLiveBlocks) may be in use and are never released, e.g. the live prefix after KVCacheCompactor.
+    SizeType numLiveBlocks{0};
+    // Blocks the model needs beyond the live ones, e.g. for the prompts and new tokens of its queued requests
+    SizeType numQueuedBlocks{0};
+};
+
+// Splits one device memory budget for KV cache between the GrowableKVCachePools of several models on the same GPU.
+// Instead of a static freeGpuMemoryFraction per model, rebalance() moves memory to the models whose queues need
+// blocks: every model first gets its live blocks and minimum, then what its queue needs, in proportion to the need
+// when the budget is short. A model keeps its idle blocks until another model needs the memory, so a model whose
+// traffic comes back soon does not pay for growing again. Memory moves at the granularity of the growth steps of the
+// pools, which may exceed the budget by less than one step per model.
+class KVCacheMemoryArbiter
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    explicit KVCacheMemoryArbiter(std::size_t budgetBytes)
+        : mBudgetBytes{budgetBytes}
+    {
+        TLLM_CHECK_WITH_INFO(budgetBytes > 0, "KV cache memory budget must be positive");
+    }
+
+    //! \brief Arbitrate the memory of pools, which must outlive the arbiter.
+    //! \param minNumBlocks Blocks the model keeps at all times.
+    //! \return The index of the model in the demands of rebalance.
+    SizeType addModel(GrowableKVCachePools& pools, SizeType minNumBlocks = 1)
+    {
+        TLLM_CHECK_WITH_INFO(minNumBlocks > 0 && minNumBlocks <= pools.getMaxNumBlocks(),
+            "Minimum number of blocks (%d) must be in [1, %d]", minNumBlocks, pools.getMaxNumBlocks());
+        mModels.push_back(Model{&pools, minNumBlocks});
+        return static_cast<SizeType>(mModels.size() - 1);
+    }
+
+    [[nodiscard]] SizeType getNumModels() const noexcept
+    {
+        return static_cast<SizeType>(mModels.size());
+    }
+
+    [[nodiscard]] std::size_t getBudgetBytes() const noexcept
+    {
+        return mBudgetBytes;
+    }
+
+    //! \brief Device memory mapped by the pools of all models.
+    [[nodiscard]] std::size_t getMappedSize() const
+    {
+        std::size_t size{0};
+        for (auto const& model : mModels)
+        {
+            size += model.pools->getMappedSize();
+        }
+        return size;
+    }
+
+    //! \brief Compute the number of blocks of every model for the given demands.
+    [[nodiscard]] std::vector<SizeType> computeTargets(std::vector<KVCacheModelDemand> const& demands) const
+    {
+        TLLM_CHECK_WITH_INFO(demands.size() == mModels.size(), "Got %zu demands for %zu models", demands.size(),
+            mModels.size());
+        auto const numModels = mModels.size();
+        std::vector<SizeType> floors(numModels);
+        std::vector<SizeType> needs(numModels);
+        std::size_t floorBytes{0};
+        std::size_t extraBytes{0};
+        for (std::size_t i = 0; i < numModels; ++i)
+        {
+            auto const& model = mModels[i];
+            auto const maxNumBlocks = model.pools->getMaxNumBlocks();
+            floors[i] = std::clamp(demands[i].numLiveBlocks, model.minNumBlocks, maxNumBlocks);
+            needs[i] = std::clamp(demands[i].numLiveBlocks + demands[i].numQueuedBlocks, floors[i], maxNumBlocks);
+            floorBytes += bytes(i, floors[i]);
+            extraBytes += bytes(i, needs[i] - floors[i]);
+        }
+
+        // Live blocks cannot be taken away, so the floors are granted even over the budget.
+        auto const spareBytes = mBudgetBytes > floorBytes ? mBudgetBytes - floorBytes : 0;
+        auto const scale
+            = extraBytes > spareBytes ? static_cast<double>(spareBytes) / static_cast<double>(extraBytes) : 1.0;
+        std::vector<SizeType> targets(numModels);
+        std::size_t targetBytes{0};
+        for (std::size_t i = 0; i < numModels; ++i)
+        {
+            targets[i] = floors[i] + static_cast<SizeType>(scale * static_cast<double>(needs[i] - floors[i]));
+            targetBytes += bytes(i, targets[i]);
+        }
+
+        // Models keep their idle blocks as far as the budget allows.
+        for (std::size_t i = 0; i < numModels; ++i)
+        {
+            auto const numBlocks = mModels[i].pools->getNumBlocks();
+            if (numBlocks <= targets[i] || targetBytes >= mBudgetBytes)
+            {
+                continue;
+            }
+            auto const numKept = std::min(numBlocks - targets[i],
+                static_cast<SizeType>((mBudgetBytes - targetBytes) / mModels[i].pools->getBytesPerBlock()));
+            targets[i] += numKept;
+            targetBytes += bytes(i, numKept);
+        }
+        return targets;
+    }
+
+    //! \brief Shrink the models that hold more than their target, then grow the ones that hold less.
+    //! \details Blocks past the live blocks of a model must be free, and the caller must have synchronized the streams
+    //! that last accessed them. The BlockManager of every model must only hand out blocks below
+    //! GrowableKVCachePools::getNumBlocks afterwards.
+    //! \return The number of blocks released by the shrunk models.
+    SizeType rebalance(std::vector<KVCacheModelDemand> const& demands)
+    {
+        auto const targets = computeTargets(demands);
+        SizeType numReleased{0};
+        for (std::size_t i = 0; i < mModels.size(); ++i)
+        {
+            auto& pools = *mModels[i].pools;
+            if (targets[i] < pools.getNumBlocks())
+            {
+                auto const numBlocks = pools.getNumBlocks();
+                pools.shrink(targets[i]);
+                numReleased += numBlocks - pools.getNumBlocks();
+            }
+        }
+        for (std::size_t i = 0; i < mModels.size(); ++i)
+        {
+            auto& pools = *mModels[i].pools;
+            if (targets[i] > pools.getNumBlocks())
+            {
+                pools.grow(targets[i]);
+            }
+        }
+        if (numReleased > 0)
+        {
+            TLLM_LOG_DEBUG("KV cache arbiter released %d blocks, %zu of %zu bytes mapped", numReleased,
+                getMappedSize(), mBudgetBytes);
+        }
+        return numReleased;
+    }
+
+private:
+    struct Model
+    {
+        GrowableKVCachePools* pools;
+        SizeType minNumBlocks;
+    };
+
+    [[nodiscard]] std::size_t bytes(std::size_t modelIdx, SizeType numBlocks) const
+    {
+        return static_cast<std::size_t>(numBlocks) * mModels[modelIdx].pools->getBytesPerBlock();
+    }
+
+    std::size_t mBudgetBytes;
+    std::vector<Model> mModels;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
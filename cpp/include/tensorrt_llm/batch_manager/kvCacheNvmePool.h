@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/gdsFile.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Tertiary tier of the paged KV cache in a file on a local NVMe SSD, below KVCacheHostPool.
+// Blocks evicted from the host tier are spilled into a slot of the file instead of being dropped, and blocks can also
+// be offloaded straight from the GPU. A slot holds the block of every pool back to back, aligned to kAlignment, and
+// is keyed by the same prefix hash and tokens as the host tier, so a block keeps its identity across the tiers. With
+// GPUDirect Storage (see runtime::GdsFile), GPU blocks are read and written by DMA between the SSD and the GPU pools.
+// All transfers are issued on a dedicated transfer stream and are ordered with respect to the compute stream through
+// events, like the transfers of the host tier.
+class KVCacheNvmePool
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using BlockKey = std::size_t;
+    using CudaStreamPtr = std::shared_ptr<runtime::CudaStream>;
+
+    // Alignment of the slots in the file, the logical block size of NVMe drives and what O_DIRECT needs.
+    static constexpr std::size_t kAlignment = 4096;
+
+    KVCacheNvmePool(std::filesystem::path const& path, SizeType numNvmeBlocks,
+        std::vector<runtime::ITensor::SharedPtr> gpuPools, CudaStreamPtr computeStream,
+        CudaStreamPtr transferStream = nullptr)
+        : mGpuPools{std::move(gpuPools)}
+        , mComputeStream{std::move(computeStream)}
+        , mTransferStream{transferStream ? std::move(transferStream) : std::make_shared<runtime::CudaStream>()}
+        , mSlotBytes{calculateSlotBytes(mGpuPools)}
+        , mSlots(numNvmeBlocks)
+    {
+        TLLM_CHECK_WITH_INFO(numNvmeBlocks > 0, "Number of NVMe blocks must be positive");
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mComputeStream), "Undefined compute stream");
+        TLLM_CHECK_WITH_INFO(mSlotBytes > 0, "KV cache pools are empty");
+        mFile = std::make_unique<runtime::GdsFile>(path, mSlotBytes * static_cast<std::size_t>(numNvmeBlocks));
+        for (SizeType slotIdx = 0; slotIdx < numNvmeBlocks; ++slotIdx)
+        {
+            mFreeSlots.push_back(slotIdx);
+        }
+        TLLM_LOG_INFO("KV cache NVMe tier of %d blocks in %s%s", numNvmeBlocks, path.c_str(),
+            mFile->usesGds() ? " with GPUDirect Storage" : "");
+    }
+
+    //! \brief Number of NVMe blocks that fit into nvmeCacheSize bytes for the given GPU pools.
+    [[nodiscard]] static SizeType calculateMaxNumBlocks(
+        std::size_t nvmeCacheSize, std::vector<runtime::ITensor::SharedPtr> const& gpuPools)
+    {
+        auto const slotBytes = calculateSlotBytes(gpuPools);
+        return slotBytes > 0 ? static_cast<SizeType>(nvmeCacheSize / slotBytes) : 0;
+    }
+
+    //! \brief Write GPU block gpuBlockIdx to the NVMe tier under key.
+    //! \details Evicts the least recently used NVMe block if the tier is full. The compute stream waits for the write
+    //! to complete before it can overwrite the GPU block.
+    void offloadBlock(BlockKey key, VecTokens const& tokens, SizeType gpuBlockIdx)
+    {
+        if (auto const slotIdx = findSlot(key, tokens))
+        {
+            touch(*slotIdx);
+            return;
+        }
+
+        auto const slotIdx = acquireSlot(key, tokens);
+        waitForCompute();
+        transferBlock(mGpuPools, gpuBlockIdx, slotIdx, true);
+        mTransferStream->record(*mSlots[slotIdx].ready);
+        mComputeStream->wait(*mSlots[slotIdx].ready);
+        ++mNumOffloadedBlocks;
+    }
+
+    //! \brief Write block hostBlockIdx of the host pools to the NVMe tier under key, e.g. when the host tier evicts it.
+    //! \param hostSlotReady Event of the host block, waited for before reading it and recorded once it may be
+    //! overwritten again.
+    void spillBlock(BlockKey key, VecTokens const& tokens, std::vector<runtime::ITensor::SharedPtr> const& hostPools,
+        SizeType hostBlockIdx, runtime::CudaEvent const& hostSlotReady)
+    {
+        if (auto const slotIdx = findSlot(key, tokens))
+        {
+            touch(*slotIdx);
+            return;
+        }
+
+        auto const slotIdx = acquireSlot(key, tokens);
+        mTransferStream->wait(hostSlotReady);
+        transferBlock(hostPools, hostBlockIdx, slotIdx, true);
+        mTransferStream->record(*mSlots[slotIdx].ready);
+        mTransferStream->record(hostSlotReady);
+        ++mNumSpilledBlocks;
+    }
+
+    //! \brief Read the NVMe block stored under key into GPU block gpuBlockIdx.
+    //! \return true if the block was found in the NVMe tier, false otherwise.
+    bool onboardBlock(BlockKey key, VecTokens const& tokens, SizeType gpuBlockIdx)
+    {
+        auto const slotIdx = findSlot(key, tokens);
+        if (!slotIdx)
+        {
+            ++mNumMisses;
+            return false;
+        }
+
+        waitForCompute();
+        mTransferStream->wait(*mSlots[*slotIdx].ready);
+        transferBlock(mGpuPools, gpuBlockIdx, *slotIdx, false);
+        mTransferStream->record(*mSlots[*slotIdx].ready);
+        mComputeStream->wait(*mSlots[*slotIdx].ready);
+        touch(*slotIdx);
+        ++mNumOnboardedBlocks;
+        return true;
+    }
+
+    [[nodiscard]] bool hasBlock(BlockKey key, VecTokens const& tokens) const
+    {
+        return findSlot(key, tokens).has_value();
+    }
+
+    //! \brief Drop the NVMe block stored under key, if any.
+    void removeBlock(BlockKey key)
+    {
+        if (auto it = mKeyToSlot.find(key); it != mKeyToSlot.end())
+        {
+            releaseSlot(it->second);
+        }
+    }
+
+    [[nodiscard]] SizeType getMaxNumBlocks() const
+    {
+        return static_cast<SizeType>(mSlots.size());
+    }
+
+    [[nodiscard]] SizeType getNumCachedBlocks() const
+    {
+        return static_cast<SizeType>(mKeyToSlot.size());
+    }
+
+    [[nodiscard]] std::size_t getNumOffloadedBlocks() const
+    {
+        return mNumOffloadedBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumSpilledBlocks() const
+    {
+        return mNumSpilledBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumOnboardedBlocks() const
+    {
+        return mNumOnboardedBlocks;
+    }
+
+    [[nodiscard]] std::size_t getNumMisses() const
+    {
+        return mNumMisses;
+    }
+
+    [[nodiscard]] runtime::GdsFile const& getFile() const
+    {
+        return *mFile;
+    }
+
+private:
+    struct NvmeSlot
+    {
+        BlockKey key{0};
+        VecTokens tokens;
+        std::list<SizeType>::iterator lruIterator;
+        std::unique_ptr<runtime::CudaEvent> ready{std::make_unique<runtime::CudaEvent>()};
+    };
+
+    [[nodiscard]] static std::size_t calculateSlotBytes(std::vector<runtime::ITensor::SharedPtr> const& gpuPools)
+    {
+        std::size_t slotBytes{0};
+        for (auto const& gpuPool : gpuPools)
+        {
+            slotBytes += alignUp(getBlockBytes(*gpuPool));
+        }
+        return slotBytes;
+    }
+
+    [[nodiscard]] static std::size_t getBlockBytes(runtime::ITensor const& pool)
+    {
+        return pool.getSizeInBytes() / static_cast<std::size_t>(pool.getShape().d[0]);
+    }
+
+    [[nodiscard]] static std::size_t alignUp(std::size_t bytes)
+    {
+        return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    [[nodiscard]] std::optional<SizeType> findSlot(BlockKey key, VecTokens const& tokens) const
+    {
+        auto it = mKeyToSlot.find(key);
+        if (it == mKeyToSlot.end() || mSlots[it->second].tokens != tokens)
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void touch(SizeType slotIdx)
+    {
+        mLruSlots.splice(mLruSlots.begin(), mLruSlots, mSlots[slotIdx].lruIterator);
+    }
+
+    //! \brief Take a free slot for key, evicting the least recently used block if the tier is full.
+    SizeType acquireSlot(BlockKey key, VecTokens const& tokens)
+    {
+        if (auto it = mKeyToSlot.find(key); it != mKeyToSlot.end())
+        {
+            // Same hash, different tokens: the older block is unreachable from now on
+            releaseSlot(it->second);
+        }
+        if (mFreeSlots.empty())
+        {
+            TLLM_LOG_DEBUG("KVCacheNvmePool: evicting least recently used NVMe block");
+            releaseSlot(mLruSlots.back());
+        }
+        auto const slotIdx = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        auto& slot = mSlots[slotIdx];
+        // Previous transfers from or to this slot must have completed before it is overwritten.
+        mTransferStream->wait(*slot.ready);
+        slot.key = key;
+        slot.tokens = tokens;
+        mKeyToSlot[key] = slotIdx;
+        mLruSlots.push_front(slotIdx);
+        slot.lruIterator = mLruSlots.begin();
+        return slotIdx;
+    }
+
+    void releaseSlot(SizeType slotIdx)
+    {
+        auto& slot = mSlots[slotIdx];
+        mKeyToSlot.erase(slot.key);
+        mLruSlots.erase(slot.lruIterator);
+        slot.tokens.clear();
+        mFreeSlots.push_back(slotIdx);
+    }
+
+    //! \brief Wait for the compute stream to finish writing (or reading) the GPU blocks involved in a transfer.
+    void waitForCompute()
+    {
+        runtime::CudaEvent computeDone{};
+        mComputeStream->record(computeDone);
+        mTransferStream->wait(computeDone);
+    }
+
+    //! \brief Write block blockIdx of every pool in pools to slot slotIdx of the file, or read it back if not toFile.
+    void transferBlock(
+        std::vector<runtime::ITensor::SharedPtr> const& pools, SizeType blockIdx, SizeType slotIdx, bool toFile)
+    {
+        auto fileOffset = static_cast<std::size_t>(slotIdx) * mSlotBytes;
+        for (auto const& pool : pools)
+        {
+            auto const blockBytes = getBlockBytes(*pool);
+            std::vector<runtime::GdsFile::Extent> const extents{
+                {fileOffset, static_cast<std::size_t>(blockIdx) * blockBytes, blockBytes}};
+            if (toFile)
+            {
+                mFile->write(pool, extents, *mTransferStream);
+            }
+            else
+            {
+                mFile->read(pool, extents, *mTransferStream);
+            }
+            fileOffset += alignUp(blockBytes);
+        }
+    }
+
+    // GPU pools of the primary tier, one per pool of the KVCacheManager
+    std::vector<runtime::ITensor::SharedPtr> mGpuPools;
+    // Stream on which the KV cache is read and written by the engine
+    CudaStreamPtr mComputeStream;
+    // Side stream for the transfers to and from the file
+    CudaStreamPtr mTransferStream;
+    // Bytes of a slot in the file, the aligned blocks of all pools
+    std::size_t mSlotBytes;
+    std::unique_ptr<runtime::GdsFile> mFile;
+    // Metadata of each NVMe slot
+    std::vector<NvmeSlot> mSlots;
+    // Unused NVMe slots
+    std::vector<SizeType> mFreeSlots;
+    // Used NVMe slots, most recently used first
+    std::list<SizeType> mLruSlots;
+    std::unordered_map<BlockKey, SizeType> mKeyToSlot;
+    // Statistics for block transfers
+    std::size_t mNumOffloadedBlocks{0};
+    std::size_t mNumSpilledBlocks{0};
+    std::size_t mNumOnboardedBlocks{0};
+    std::size_t mNumMisses{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Prefix index over full KV cache blocks.
+// Every node of the tree represents one full block of tokensPerBlock tokens. A node is identified by a 64-bit
+// rolling hash of its tokens and the hash of its parent, computed once when the block is inserted. All children of
+// all nodes live in a single open-addressing table keyed by that hash, so there is no per-block child map and a
+// lookup costs one hash over the block tokens plus a token comparison to rule out collisions.
+// Nodes and their tokens are stored in flat arenas that are recycled through a free list, so the steady state
+// does not allocate.
+// Partially filled blocks, e.g. the last block of a released sequence, can be stored as leaves. They are not
+// hashed but linked to their parent like all other children, so that the leading tokens of any child block can be
+// matched for copy-on-match reuse.
+class BlockRadixIndex
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using TokenIdType = tensorrt_llm::runtime::TokenIdType;
+    using VecTokens = std::vector<TokenIdType>;
+    using NodeIdx = std::int32_t;
+    using HashType = std::uint64_t;
+
+    static NodeIdx constexpr kRootNode{0};
+    static NodeIdx constexpr kInvalidNode{-1};
+    static SizeType constexpr kInvalidBlock{-1};
+
+    //! \brief Block sharing a prefix with the requested tokens, but diverging before its end.
+    struct PartialMatch
+    {
+        NodeIdx node;
+        SizeType blockIdx;
+        // Number of leading tokens of the block equal to the requested tokens
+        SizeType numMatchedTokens;
+    };
+
+    struct PrefixMatch
+    {
+        // Deepest node matched by full blocks
+        NodeIdx node{kRootNode};
+        // Blocks that can be reused as is
+        std::vector<SizeType> blockIds;
+        // Block whose leading tokens can be copied into a fresh block
+        std::optional<PartialMatch> partial;
+        // Total number of reusable tokens, i.e. the value to report as number of prepopulated tokens
+        SizeType numMatchedTokens{0};
+    };
+
+    explicit BlockRadixIndex(SizeType tokensPerBlock, SizeType expectedNumBlocks = 0)
+        : mTokensPerBlock{tokensPerBlock}
+    {
+        TLLM_CHECK_WITH_INFO(mTokensPerBlock > 0, "Tokens per block must be positive");
+        auto const numNodes = static_cast<std::size_t>(std::max(expectedNumBlocks, 0)) + 1;
+        mNodes.reserve(numNodes);
+        mTokens.reserve(numNodes * mTokensPerBlock);
+        allocateNode(kInvalidNode, kRootHash, nullptr, 0, kInvalidBlock);
+        rehash(std::max<std::size_t>(kMinTableSize, nextPowerOfTwo(2 * numNodes)));
+    }
+
+    //! \brief Rolling hash of a block given the hash of its parent.
+    [[nodiscard]] static HashType hashBlock(HashType parentHash, TokenIdType const* tokens, SizeType numTokens) noexcept
+    {
+        auto hash = parentHash ^ (static_cast<HashType>(numTokens) * 0x9e3779b97f4a7c15ULL);
+        for (SizeType i = 0; i < numTokens; ++i)
+        {
+            hash = mix(hash ^ static_cast<std::uint32_t>(tokens[i]));
+        }
+        return hash;
+    }
+
+    [[nodiscard]] SizeType getTokensPerBlock() const noexcept
+    {
+        return mTokensPerBlock;
+    }
+
+    [[nodiscard]] HashType getHash(NodeIdx node) const
+    {
+        return mNodes.at(node).hash;
+    }
+
+    [[nodiscard]] SizeType getBlockIdx(NodeIdx node) const
+    {
+        return mNodes.at(node).blockIdx;
+    }
+
+    [[nodiscard]] NodeIdx getParent(NodeIdx node) const
+    {
+        return mNodes.at(node).parent;
+    }
+
+    [[nodiscard]] bool isLeaf(NodeIdx node) const
+    {
+        return mNodes.at(node).numChildren == 0;
+    }
+
+    [[nodiscard]] SizeType getNumTokens(NodeIdx node) const
+    {
+        return mNodes.at(node).numTokens;
+    }
+
+    [[nodiscard]] bool isFull(NodeIdx node) const
+    {
+        return mNodes.at(node).numTokens == mTokensPerBlock;
+    }
+
+    //! \brief Number of blocks stored in the index.
+    [[nodiscard]] SizeType getNumBlocks() const noexcept
+    {
+        return static_cast<SizeType>(mNodes.size() - mFreeNodes.size()) - 1;
+    }
+
+    //! \brief Find the child of parent holding exactly the tokensPerBlock tokens starting at tokens.
+    [[nodiscard]] NodeIdx findChild(NodeIdx parent, TokenIdType const* tokens) const
+    {
+        auto const hash = hashBlock(mNodes.at(parent).hash, tokens, mTokensPerBlock);
+        return findSlotNode(hash, parent, tokens);
+    }
+
+    //! \brief Insert a block as child of parent. Returns the existing node if the same block is already stored.
+    NodeIdx insert(NodeIdx parent, TokenIdType const* tokens, SizeType blockIdx)
+    {
+        auto const hash = hashBlock(mNodes.at(parent).hash, tokens, mTokensPerBlock);
+        if (auto const existing = findSlotNode(hash, parent, tokens); existing != kInvalidNode)
+        {
+            return existing;
+        }
+        if (2 * (mNumUsedSlots + 1) > mTable.size())
+        {
+            // Grows the table or only clears tombstones, depending on the number of live nodes.
+            rehash(std::max(mTable.size(), nextPowerOfTwo(4 * static_cast<std::size_t>(getNumBlocks() + 1))));
+        }
+        auto const node = allocateNode(parent, hash, tokens, mTokensPerBlock, blockIdx);
+        insertSlot(hash, node);
+        return node;
+    }
+
+    //! \brief Insert a partially filled block with numTokens < tokensPerBlock tokens as leaf child of parent.
+    //! \details Returns the existing node if a partial child with the same tokens is already stored.
+    NodeIdx insertPartial(NodeIdx parent, TokenIdType const* tokens, SizeType numTokens, SizeType blockIdx)
+    {
+        TLLM_CHECK_WITH_INFO(numTokens > 0 && numTokens < mTokensPerBlock,
+            "Partial block must hold between 1 and %d tokens, got %d", mTokensPerBlock - 1, numTokens);
+        for (auto child = mNodes.at(parent).firstChild; child != kInvalidNode; child = mNodes[child].nextSibling)
+        {
+            if (mNodes[child].numTokens == numTokens && std::equal(tokens, tokens + numTokens, nodeTokens(child)))
+            {
+                return child;
+            }
+        }
+        auto const hash = hashBlock(mNodes[parent].hash, tokens, numTokens);
+        return allocateNode(parent, hash, tokens, numTokens, blockIdx);
+    }
+
+    //! \brief Find the child of parent, full or partial, sharing the longest common prefix with tokens.
+    //! \details Cost is linear in the number of children of parent times the matched length.
+    [[nodiscard]] std::optional<PartialMatch> findPartialMatch(
+        NodeIdx parent, TokenIdType const* tokens, SizeType numTokens) const
+    {
+        std::optional<PartialMatch> best;
+        numTokens = std::min(numTokens, mTokensPerBlock);
+        for (auto child = mNodes.at(parent).firstChild; child != kInvalidNode; child = mNodes[child].nextSibling)
+        {
+            auto const& entry = mNodes[child];
+            auto const maxLen = std::min(numTokens, entry.numTokens);
+            auto const* childTokens = nodeTokens(child);
+            auto const matched = static_cast<SizeType>(
+                std::mismatch(tokens, tokens + maxLen, childTokens).first - tokens);
+            if (matched > 0 && (!best || matched > best->numMatchedTokens))
+            {
+                best = PartialMatch{child, entry.blockIdx, matched};
+            }
+        }
+        return best;
+    }
+
+    //! \brief Walk the tree along tokens. Returns the deepest matched node and the block ids along the path.
+    //! \details Only full blocks are matched. Cost is linear in the number of matched tokens.
+    NodeIdx matchPrefix(VecTokens const& tokens, std::vector<SizeType>& matchedBlockIds) const
+    {
+        matchedBlockIds.clear();
+        auto node = kRootNode;
+        auto const numFullBlocks = static_cast<SizeType>(tokens.size()) / mTokensPerBlock;
+        for (SizeType blockIdx = 0; blockIdx < numFullBlocks; ++blockIdx)
+        {
+            auto const child = findChild(node, tokens.data() + blockIdx * mTokensPerBlock);
+            if (child == kInvalidNode)
+            {
+                break;
+            }
+            node = child;
+            matchedBlockIds.push_back(mNodes[node].blockIdx);
+        }
+        return node;
+    }
+
+    //! \brief Match tokens against full blocks, then try to match the remaining tokens against a partial block.
+    //! \details Callers usually exclude the last prompt token from tokens, since its logits must be computed.
+    //! A partial match is only reported if it covers at least minPartialTokens tokens, copying a block to reuse a
+    //! handful of tokens is not worth it.
+    [[nodiscard]] PrefixMatch matchPrefixWithPartial(VecTokens const& tokens, SizeType minPartialTokens = 1) const
+    {
+        PrefixMatch match;
+        match.node = matchPrefix(tokens, match.blockIds);
+        match.numMatchedTokens = static_cast<SizeType>(match.blockIds.size()) * mTokensPerBlock;
+        auto const numRemaining = static_cast<SizeType>(tokens.size()) - match.numMatchedTokens;
+        if (numRemaining > 0)
+        {
+            auto partial = findPartialMatch(match.node, tokens.data() + match.numMatchedTokens, numRemaining);
+            if (partial && partial->numMatchedTokens >= std::max(minPartialTokens, 1))
+            {
+                match.numMatchedTokens += partial->numMatchedTokens;
+                match.partial = partial;
+            }
+        }
+        return match;
+    }
+
+    //! \brief Insert all full blocks of tokens under the root, assigning them blockIds in order.
+    //! \return The node of the last inserted block.
+    NodeIdx insertPrefix(VecTokens const& tokens, std::vector<SizeType> const& blockIds)
+    {
+        auto node = kRootNode;
+        auto const numFullBlocks = std::min(static_cast<SizeType>(tokens.size()) / mTokensPerBlock,
+            static_cast<SizeType>(blockIds.size()));
+        for (SizeType blockIdx = 0; blockIdx < numFullBlocks; ++blockIdx)
+        {
+            node = insert(node, tokens.data() + blockIdx * mTokensPerBlock, blockIds[blockIdx]);
+        }
+        return node;
+    }
+
+    //! \brief Remove a leaf node from the index, e.g. when its block is evicted.
+    void eraseLeaf(NodeIdx node)
+    {
+        TLLM_CHECK_WITH_INFO(node != kRootNode, "Cannot erase the root node");
+        auto& entry = mNodes.at(node);
+        TLLM_CHECK_WITH_INFO(entry.blockIdx != kInvalidBlock, "Node %d is not in use", node);
+        TLLM_CHECK_WITH_INFO(entry.numChildren == 0, "Node %d is not a leaf", node);
+        if (entry.numTokens == mTokensPerBlock)
+        {
+            eraseSlot(entry.hash, node);
+        }
+        unlinkChild(node);
+        entry.parent = kInvalidNode;
+        entry.blockIdx = kInvalidBlock;
+        mFreeNodes.push_back(node);
+    }
+
+private:
+    struct Node
+    {
+        HashType hash;
+        NodeIdx parent;
+        SizeType blockIdx;
+        SizeType numTokens;
+        SizeType numChildren;
+        // Intrusive list of the children of parent
+        NodeIdx firstChild;
+        NodeIdx prevSibling;
+        NodeIdx nextSibling;
+    };
+
+    static HashType constexpr kRootHash{0xcbf29ce484222325ULL};
+    static std::size_t constexpr kMinTableSize{64};
+    // Empty slots hold kInvalidNode, erased slots hold kTombstone to keep probe chains intact.
+    static NodeIdx constexpr kTombstone{-2};
+
+    // splitmix64 finalizer
+    [[nodiscard]] static HashType mix(HashType x) noexcept
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    [[nodiscard]] static std::size_t nextPowerOfTwo(std::size_t n) noexcept
+    {
+        std::size_t result{1};
+        while (result < n)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    [[nodiscard]] TokenIdType const* nodeTokens(NodeIdx node) const
+    {
+        return mTokens.data() + static_cast<std::size_t>(node) * mTokensPerBlock;
+    }
+
+    NodeIdx allocateNode(
+        NodeIdx parent, HashType hash, TokenIdType const* tokens, SizeType numTokens, SizeType blockIdx)
+    {
+        auto const entry = Node{hash, parent, blockIdx, numTokens, 0, kInvalidNode, kInvalidNode, kInvalidNode};
+        NodeIdx node;
+        if (!mFreeNodes.empty())
+        {
+            node = mFreeNodes.back();
+            mFreeNodes.pop_back();
+            mNodes[node] = entry;
+        }
+        else
+        {
+            node = static_cast<NodeIdx>(mNodes.size());
+            mNodes.push_back(entry);
+            mTokens.resize(mTokens.size() + mTokensPerBlock);
+        }
+        if (tokens != nullptr)
+        {
+            auto const offset = static_cast<std::size_t>(node) * mTokensPerBlock;
+            std::copy(tokens, tokens + numTokens, mTokens.begin() + offset);
+        }
+        if (parent != kInvalidNode)
+        {
+            linkChild(parent, node);
+        }
+        return node;
+    }
+
+    void linkChild(NodeIdx parent, NodeIdx node)
+    {
+        auto& parentEntry = mNodes[parent];
+        auto& entry = mNodes[node];
+        entry.nextSibling = parentEntry.firstChild;
+        if (parentEntry.firstChild != kInvalidNode)
+        {
+            mNodes[parentEntry.firstChild].prevSibling = node;
+        }
+        parentEntry.firstChild = node;
+        ++parentEntry.numChildren;
+    }
+
+    void unlinkChild(NodeIdx node)
+    {
+        auto& entry = mNodes[node];
+        auto& parentEntry = mNodes[entry.parent];
+        if (entry.prevSibling != kInvalidNode)
+        {
+            mNodes[entry.prevSibling].nextSibling = entry.nextSibling;
+        }
+        else
+        {
+            parentEntry.firstChild = entry.nextSibling;
+        }
+        if (entry.nextSibling != kInvalidNode)
+        {
+            mNodes[entry.nextSibling].prevSibling = entry.prevSibling;
+        }
+        entry.prevSibling = kInvalidNode;
+        entry.nextSibling = kInvalidNode;
+        --parentEntry.numChildren;
+    }
+
+    [[nodiscard]] NodeIdx findSlotNode(HashType hash, NodeIdx parent, TokenIdType const* tokens) const
+    {
+        auto const mask = mTable.size() - 1;
+        for (auto slot = static_cast<std::size_t>(hash) & mask;; slot = (slot + 1) & mask)
+        {
+            auto const node = mTable[slot];
+            if (node == kInvalidNode)
+            {
+                return kInvalidNode;
+            }
+            if (node != kTombstone)
+            {
+                auto const& entry = mNodes[node];
+                if (entry.hash == hash && entry.parent == parent && entry.numTokens == mTokensPerBlock
+                    && std::equal(tokens, tokens + mTokensPerBlock, nodeTokens(node)))
+                {
+                    return node;
+                }
+            }
+        }
+    }
+
+    void insertSlot(HashType hash, NodeIdx node)
+    {
+        auto const mask = mTable.size() - 1;
+        auto slot = static_cast<std::size_t>(hash) & mask;
+        while (mTable[slot] != kInvalidNode && mTable[slot] != kTombstone)
+        {
+            slot = (slot + 1) & mask;
+        }
+        if (mTable[slot] == kInvalidNode)
+        {
+            ++mNumUsedSlots;
+        }
+        mTable[slot] = node;
+    }
+
+    void eraseSlot(HashType hash, NodeIdx node)
+    {
+        auto const mask = mTable.size() - 1;
+        for (auto slot = static_cast<std::size_t>(hash) & mask; mTable[slot] != kInvalidNode; slot = (slot + 1) & mask)
+        {
+            if (mTable[slot] == node)
+            {
+                mTable[slot] = kTombstone;
+                return;
+            }
+        }
+        TLLM_THROW("Node %d not found in index", node);
+    }
+
+    void rehash(std::size_t tableSize)
+    {
+        mTable.assign(tableSize, kInvalidNode);
+        mNumUsedSlots = 0;
+        for (NodeIdx node = kRootNode + 1; node < static_cast<NodeIdx>(mNodes.size()); ++node)
+        {
+            if (mNodes[node].blockIdx != kInvalidBlock && mNodes[node].numTokens == mTokensPerBlock)
+            {
+                insertSlot(mNodes[node].hash, node);
+            }
+        }
+    }
+
+    SizeType mTokensPerBlock;
+    // Arena of nodes, index 0 is the root
+    std::vector<Node> mNodes;
+    // Tokens of node i are stored at [i * tokensPerBlock, (i + 1) * tokensPerBlock)
+    VecTokens mTokens;
+    // Recycled node indices
+    std::vector<NodeIdx> mFreeNodes;
+    // Open-addressing table with linear probing, maps block hash to node
+    std::vector<NodeIdx> mTable;
+    // Occupied or tombstoned slots in mTable
+    std::size_t mNumUsedSlots{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
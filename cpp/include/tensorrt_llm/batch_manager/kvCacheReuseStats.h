@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+// Block reuse counters of a KVCacheManager. Kept apart from KvCacheStats, whose layout is shared with the prebuilt
+// batch manager library.
+struct KvCacheReuseStats
+{
+    // Blocks handed out to sequences since construction, either new or reused
+    std::size_t allocTotalBlocks{0};
+    // Blocks handed out without reusing cached contents
+    std::size_t allocNewBlocks{0};
+    // Blocks whose cached contents were reused by a sequence
+    std::size_t reusedBlocks{0};
+    // Fraction of allocated blocks that were reused, 0 if nothing was allocated
+    float cacheHitRate{0.f};
+};
+
+//! \brief Read the reuse counters of the BlockManager of kvCacheManager in constant time.
+[[nodiscard]] inline KvCacheReuseStats getKvCacheReuseStats(KVCacheManager const& kvCacheManager)
+{
+    auto const& blockManager = kvCacheManager.getBlockManager();
+    KvCacheReuseStats stats;
+    stats.allocTotalBlocks = blockManager.getNumAllocTotalBlocks();
+    stats.allocNewBlocks = blockManager.getNumAllocNewBlocks();
+    stats.reusedBlocks = blockManager.getNumReusedBlocks();
+    stats.cacheHitRate = stats.allocTotalBlocks > 0
+        ? static_cast<float>(stats.reusedBlocks) / static_cast<float>(stats.allocTotalBlocks)
+        : 0.f;
+    return stats;
+}
+
+// Histogram of the prompt prefix length matched in the reuse tree, one sample per request.
+// Bucket 0 counts requests without a match, bucket i > 0 counts requests that matched [2^(i-1), 2^i) tokens and the
+// last bucket everything above. Together with KvCacheReuseStats::cacheHitRate this tells whether enableBlockReuse pays
+// off and how much of maxTokens is kept busy by cached prefixes.
+class PrefixMatchHistogram
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    static std::size_t constexpr kNumBuckets = 20;
+
+    void add(SizeType numMatchedTokens, SizeType promptLength)
+    {
+        TLLM_CHECK_WITH_INFO(numMatchedTokens >= 0 && numMatchedTokens <= promptLength,
+            "Matched %d tokens of a prompt of %d tokens", numMatchedTokens, promptLength);
+        ++mBuckets[getBucket(numMatchedTokens)];
+        ++mNumRequests;
+        mNumMatchedTokens += static_cast<std::uint64_t>(numMatchedTokens);
+        mNumPromptTokens += static_cast<std::uint64_t>(promptLength);
+    }
+
+    //! \brief Record the prefix reused by the first beam of a sequence added to the KV cache manager.
+    void add(KVCacheManager const& kvCacheManager, SizeType seqSlotIdx, SizeType promptLength)
+    {
+        add(kvCacheManager.getNumPrepopulatedTokens(seqSlotIdx, 0), promptLength);
+    }
+
+    [[nodiscard]] static std::size_t getBucket(SizeType numMatchedTokens) noexcept
+    {
+        std::size_t bucket{0};
+        for (auto value = static_cast<std::uint32_t>(numMatchedTokens); value > 0 && bucket + 1 < kNumBuckets;
+             value >>= 1)
+        {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    [[nodiscard]] std::array<std::uint64_t, kNumBuckets> const& getBuckets() const noexcept
+    {
+        return mBuckets;
+    }
+
+    [[nodiscard]] std::uint64_t getNumRequests() const noexcept
+    {
+        return mNumRequests;
+    }
+
+    //! \brief Fraction of all prompt tokens that did not have to be computed.
+    [[nodiscard]] float getTokenHitRate() const noexcept
+    {
+        return mNumPromptTokens > 0 ? static_cast<float>(mNumMatchedTokens) / static_cast<float>(mNumPromptTokens)
+                                    : 0.f;
+    }
+
+    void reset() noexcept
+    {
+        *this = PrefixMatchHistogram{};
+    }
+
+private:
+    std::array<std::uint64_t, kNumBuckets> mBuckets{};
+    std::uint64_t mNumRequests{0};
+    std::uint64_t mNumMatchedTokens{0};
+    std::uint64_t mNumPromptTokens{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheHostPool.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+struct KvCacheSwapStats
+{
+    // Number of requests whose blocks currently reside in the swap space
+    SizeType numSwappedRequests{0};
+    // Number of swap space blocks in use
+    SizeType numSwappedBlocks{0};
+    std::size_t numSwapOuts{0};
+    std::size_t numSwapIns{0};
+    // Bytes moved by completed swap transfers in both directions
+    std::size_t swappedBytes{0};
+    // Average bandwidth of completed swap transfers in GB/s
+    double swapBandwidth{0.0};
+};
+
+// Pinned host staging area for preempting sequences by swapping instead of recomputing.
+// When the scheduler pauses a request, all its KV blocks are copied to host slots with swapOut, after which the
+// GPU blocks can be released with KVCacheManager::removeSequence. On resume, fresh GPU blocks are allocated for
+// the sequence and swapIn restores the contents into them, so the context phase does not need to be redone.
+// Transfers run on a side stream. The compute stream waits for a swap-out to complete before it can overwrite the
+// released GPU blocks, and for a swap-in to complete before the restored blocks are read.
+class KVCacheSwapSpace
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestIdType = std::uint64_t;
+    using CudaStreamPtr = std::shared_ptr<runtime::CudaStream>;
+
+    KVCacheSwapSpace(SizeType numHostBlocks, std::vector<runtime::ITensor::SharedPtr> gpuPools,
+        CudaStreamPtr computeStream, CudaStreamPtr transferStream = nullptr)
+        : mGpuPools{std::move(gpuPools)}
+        , mComputeStream{std::move(computeStream)}
+        , mTransferStream{transferStream ? std::move(transferStream) : std::make_shared<runtime::CudaStream>()}
+        , mBufferManager{mTransferStream}
+    {
+        TLLM_CHECK_WITH_INFO(numHostBlocks > 0, "Number of swap blocks must be positive");
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mComputeStream), "Undefined compute stream");
+        mHostPools.reserve(mGpuPools.size());
+        for (auto const& gpuPool : mGpuPools)
+        {
+            auto shape = gpuPool->getShape();
+            shape.d[0] = numHostBlocks;
+            mHostPools.emplace_back(mBufferManager.pinnedPool(shape, gpuPool->getDataType()));
+            auto const numGpuBlocks = static_cast<std::size_t>(gpuPool->getShape().d[0]);
+            mBytesPerBlock += gpuPool->getSizeInBytes() / numGpuBlocks;
+        }
+        mFreeSlots.reserve(numHostBlocks);
+        for (SizeType slotIdx = numHostBlocks - 1; slotIdx >= 0; --slotIdx)
+        {
+            mFreeSlots.push_back(slotIdx);
+        }
+    }
+
+    //! \brief Number of swap blocks that fit into swapSpaceSize bytes for the given GPU pools.
+    [[nodiscard]] static SizeType calculateMaxNumBlocks(
+        std::size_t swapSpaceSize, std::vector<runtime::ITensor::SharedPtr> const& gpuPools)
+    {
+        return KVCacheHostPool::calculateMaxNumBlocks(swapSpaceSize, gpuPools);
+    }
+
+    [[nodiscard]] bool canSwapOut(SizeType numBlocks) const noexcept
+    {
+        return numBlocks <= static_cast<SizeType>(mFreeSlots.size());
+    }
+
+    //! \brief Copy the GPU blocks of a sequence into the swap space.
+    //! \param gpuBlockIds Block ids of the sequence in order, e.g. one beam of GenerationRequest::getCacheBlockIds.
+    void swapOut(RequestIdType requestId, std::vector<SizeType> const& gpuBlockIds)
+    {
+        TLLM_CHECK_WITH_INFO(mSwappedSequences.find(requestId) == mSwappedSequences.end(),
+            "Request %lu is already swapped out", requestId);
+        auto const numBlocks = static_cast<SizeType>(gpuBlockIds.size());
+        TLLM_CHECK_WITH_INFO(canSwapOut(numBlocks), "Not enough swap space for %d blocks of request %lu, %zu free",
+            numBlocks, requestId, mFreeSlots.size());
+
+        std::vector<SizeType> slots(mFreeSlots.end() - numBlocks, mFreeSlots.end());
+        mFreeSlots.resize(mFreeSlots.size() - numBlocks);
+
+        copySequence(mGpuPools, gpuBlockIds, mHostPools, slots);
+        mSwappedSequences.emplace(requestId, std::move(slots));
+        ++mNumSwapOuts;
+    }
+
+    //! \brief Restore a swapped sequence into newly allocated GPU blocks and free its swap space.
+    void swapIn(RequestIdType requestId, std::vector<SizeType> const& gpuBlockIds)
+    {
+        auto it = mSwappedSequences.find(requestId);
+        TLLM_CHECK_WITH_INFO(it != mSwappedSequences.end(), "Request %lu is not swapped out", requestId);
+        auto& slots = it->second;
+        TLLM_CHECK_WITH_INFO(slots.size() == gpuBlockIds.size(), "Request %lu swapped %zu blocks, but got %zu",
+            requestId, slots.size(), gpuBlockIds.size());
+
+        copySequence(mHostPools, slots, mGpuPools, gpuBlockIds);
+        // Slots are only rewritten by later transfers on the same stream, no need to wait.
+        mFreeSlots.insert(mFreeSlots.end(), slots.begin(), slots.end());
+        mSwappedSequences.erase(it);
+        ++mNumSwapIns;
+    }
+
+    //! \brief Drop the swapped blocks of a request, e.g. because it was cancelled while paused.
+    void discard(RequestIdType requestId)
+    {
+        if (auto it = mSwappedSequences.find(requestId); it != mSwappedSequences.end())
+        {
+            mFreeSlots.insert(mFreeSlots.end(), it->second.begin(), it->second.end());
+            mSwappedSequences.erase(it);
+        }
+    }
+
+    [[nodiscard]] bool isSwappedOut(RequestIdType requestId) const
+    {
+        return mSwappedSequences.find(requestId) != mSwappedSequences.end();
+    }
+
+    //! \brief Number of GPU blocks to allocate before the request can be swapped in.
+    [[nodiscard]] SizeType getNumSwappedBlocks(RequestIdType requestId) const
+    {
+        auto it = mSwappedSequences.find(requestId);
+        return it != mSwappedSequences.end() ? static_cast<SizeType>(it->second.size()) : 0;
+    }
+
+    [[nodiscard]] SizeType getMaxNumBlocks() const
+    {
+        return static_cast<SizeType>(mHostPools.empty() ? 0 : mHostPools.front()->getShape().d[0]);
+    }
+
+    //! \brief Statistics for the iteration stats. Accounts for completed transfers only and does not block.
+    [[nodiscard]] KvCacheSwapStats getSwapStats()
+    {
+        while (!mPendingTransfers.empty())
+        {
+            auto const& transfer = mPendingTransfers.front();
+            auto const status = ::cudaEventQuery(transfer.stop->get());
+            if (status == cudaErrorNotReady)
+            {
+                break;
+            }
+            TLLM_CUDA_CHECK(status);
+            float elapsedMs{0.f};
+            TLLM_CUDA_CHECK(::cudaEventElapsedTime(&elapsedMs, transfer.start->get(), transfer.stop->get()));
+            mTransferTimeMs += elapsedMs;
+            mSwappedBytes += transfer.bytes;
+            mPendingTransfers.pop_front();
+        }
+
+        KvCacheSwapStats stats;
+        stats.numSwappedRequests = static_cast<SizeType>(mSwappedSequences.size());
+        stats.numSwappedBlocks = getMaxNumBlocks() - static_cast<SizeType>(mFreeSlots.size());
+        stats.numSwapOuts = mNumSwapOuts;
+        stats.numSwapIns = mNumSwapIns;
+        stats.swappedBytes = mSwappedBytes;
+        // bytes / ms / 1e6 = GB/s
+        stats.swapBandwidth = mTransferTimeMs > 0.0 ? static_cast<double>(mSwappedBytes) / mTransferTimeMs / 1e6 : 0.0;
+        return stats;
+    }
+
+private:
+    struct Transfer
+    {
+        std::shared_ptr<runtime::CudaEvent> start;
+        std::shared_ptr<runtime::CudaEvent> stop;
+        std::size_t bytes;
+    };
+
+    void copySequence(std::vector<runtime::ITensor::SharedPtr> const& srcPools, std::vector<SizeType> const& srcIds,
+        std::vector<runtime::ITensor::SharedPtr> const& dstPools, std::vector<SizeType> const& dstIds)
+    {
+        if (srcIds.empty())
+        {
+            return;
+        }
+
+        // Wait for the compute stream to finish with the blocks involved in the copy.
+        runtime::CudaEvent computeDone{};
+        mComputeStream->record(computeDone);
+        mTransferStream->wait(computeDone);
+
+        // Timing events are only used for the bandwidth statistics.
+        auto transfer = Transfer{std::make_shared<runtime::CudaEvent>(cudaEventDefault),
+            std::make_shared<runtime::CudaEvent>(cudaEventDefault), mBytesPerBlock * srcIds.size()};
+        mTransferStream->record(*transfer.start);
+        for (std::size_t poolIdx = 0; poolIdx < srcPools.size(); ++poolIdx)
+        {
+            for (std::size_t i = 0; i < srcIds.size(); ++i)
+            {
+                auto const srcBlock = runtime::ITensor::slice(srcPools[poolIdx], srcIds[i], 1);
+                auto dstBlock = runtime::ITensor::slice(dstPools[poolIdx], dstIds[i], 1);
+                mBufferManager.copy(*srcBlock, *dstBlock);
+            }
+        }
+        mTransferStream->record(*transfer.stop);
+        mComputeStream->wait(*transfer.stop);
+        mPendingTransfers.push_back(std::move(transfer));
+    }
+
+    // GPU pools of the KVCacheManager
+    std::vector<runtime::ITensor::SharedPtr> mGpuPools;
+    // Pinned host pools of the swap space, same order as mGpuPools
+    std::vector<runtime::ITensor::SharedPtr> mHostPools;
+    CudaStreamPtr mComputeStream;
+    CudaStreamPtr mTransferStream;
+    runtime::BufferManager mBufferManager;
+    std::size_t mBytesPerBlock{0};
+    std::vector<SizeType> mFreeSlots;
+    // Host slots of each swapped sequence, in block order
+    std::unordered_map<RequestIdType, std::vector<SizeType>> mSwappedSequences;
+    // Transfers whose timing has not been accounted for yet
+    std::deque<Transfer> mPendingTransfers;
+    std::size_t mNumSwapOuts{0};
+    std::size_t mNumSwapIns{0};
+    std::size_t mSwappedBytes{0};
+    double mTransferTimeMs{0.0};
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Copy block srcIdx to block dstIdx in every KV cache pool.
+//! \details Used for copy-on-match reuse of a partially matched block: the whole block is copied, the tokens past
+//! the divergence offset are overwritten by the context phase of the new sequence. The copy is enqueued on the
+//! stream of bufferManager.
+inline void copyBlock(std::vector<runtime::ITensor::SharedPtr> const& pools, runtime::SizeType srcIdx,
+    runtime::SizeType dstIdx, runtime::BufferManager const& bufferManager)
+{
+    TLLM_CHECK_WITH_INFO(srcIdx != dstIdx, "Cannot copy block %d onto itself", srcIdx);
+    for (auto const& pool : pools)
+    {
+        auto const srcBlock = runtime::ITensor::slice(pool, srcIdx, 1);
+        auto dstBlock = runtime::ITensor::slice(pool, dstIdx, 1);
+        bufferManager.copy(*srcBlock, *dstBlock);
+    }
+}
+
+//! \brief Transferable description of the KV cache blocks of one sequence, used for disaggregated serving.
+//! \details A context executor describes a sequence after its context phase, sends the packed descriptor over its
+//! control channel and then streams the blocks with sendBlocks. The generation executor allocates
+//! getNumUniqueBlocks() blocks for the sequence, checks the descriptor against its own pools and receives the
+//! blocks in the same order with receiveBlocks.
+class KVCacheBlockDescriptor
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using Shape = runtime::ITensor::Shape;
+
+    KVCacheBlockDescriptor() = default;
+
+    KVCacheBlockDescriptor(GenerationRequest const& sequence, std::vector<runtime::ITensor::SharedPtr> const& pools,
+        SizeType tokensPerBlock)
+        : mTokensPerBlock{tokensPerBlock}
+        , mNumTokens{sequence.getNumTokens()}
+        , mCacheBlockIds{sequence.getCacheBlockIds()}
+    {
+        TLLM_CHECK_WITH_INFO(!pools.empty(), "No KV cache pools to describe");
+        mDataType = pools.front()->getDataType();
+        mBlockShapes.reserve(pools.size());
+        for (auto const& pool : pools)
+        {
+            TLLM_CHECK_WITH_INFO(pool->getDataType() == mDataType, "All KV cache pools must have the same data type");
+            mBlockShapes.push_back(blockShape(pool->getShape()));
+        }
+    }
+
+    [[nodiscard]] nvinfer1::DataType getDataType() const
+    {
+        return mDataType;
+    }
+
+    [[nodiscard]] SizeType getTokensPerBlock() const
+    {
+        return mTokensPerBlock;
+    }
+
+    [[nodiscard]] SizeType getNumTokens() const
+    {
+        return mNumTokens;
+    }
+
+    [[nodiscard]] std::vector<Shape> const& getBlockShapes() const
+    {
+        return mBlockShapes;
+    }
+
+    //! \brief Block ids of each beam on the exporting instance.
+    [[nodiscard]] std::vector<std::vector<SizeType>> const& getCacheBlockIds() const
+    {
+        return mCacheBlockIds;
+    }
+
+    //! \brief Block ids in transfer order, blocks shared among beams appear once.
+    [[nodiscard]] std::vector<SizeType> getUniqueBlockIds() const
+    {
+        std::vector<SizeType> uniqueIds;
+        std::unordered_set<SizeType> seen;
+        for (auto const& beamBlockIds : mCacheBlockIds)
+        {
+            for (auto const blockId : beamBlockIds)
+            {
+                if (seen.insert(blockId).second)
+                {
+                    uniqueIds.push_back(blockId);
+                }
+            }
+        }
+        return uniqueIds;
+    }
+
+    [[nodiscard]] SizeType getNumUniqueBlocks() const
+    {
+        return static_cast<SizeType>(getUniqueBlockIds().size());
+    }
+
+    //! \brief Check that blocks of this descriptor can be received into pools.
+    [[nodiscard]] bool isCompatible(
+        std::vector<runtime::ITensor::SharedPtr> const& pools, SizeType tokensPerBlock) const
+    {
+        if (tokensPerBlock != mTokensPerBlock || pools.size() != mBlockShapes.size())
+        {
+            return false;
+        }
+        for (std::size_t poolIdx = 0; poolIdx < pools.size(); ++poolIdx)
+        {
+            auto const shape = blockShape(pools[poolIdx]->getShape());
+            if (pools[poolIdx]->getDataType() != mDataType || shape.nbDims != mBlockShapes[poolIdx].nbDims
+                || !std::equal(shape.d, shape.d + shape.nbDims, mBlockShapes[poolIdx].d))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::vector<std::int64_t> serialize() const
+    {
+        std::vector<std::int64_t> packed;
+        packed.push_back(static_cast<std::int64_t>(mDataType));
+        packed.push_back(mTokensPerBlock);
+        packed.push_back(mNumTokens);
+        packed.push_back(static_cast<std::int64_t>(mBlockShapes.size()));
+        for (auto const& shape : mBlockShapes)
+        {
+            packed.push_back(shape.nbDims);
+            packed.insert(packed.end(), shape.d, shape.d + shape.nbDims);
+        }
+        packed.push_back(static_cast<std::int64_t>(mCacheBlockIds.size()));
+        for (auto const& beamBlockIds : mCacheBlockIds)
+        {
+            packed.push_back(static_cast<std::int64_t>(beamBlockIds.size()));
+            packed.insert(packed.end(), beamBlockIds.begin(), beamBlockIds.end());
+        }
+        return packed;
+    }
+
+    static KVCacheBlockDescriptor deserialize(std::vector<std::int64_t> const& packed)
+    {
+        std::size_t pos{0};
+        auto const next = [&packed, &pos]()
+        {
+            TLLM_CHECK_WITH_INFO(pos < packed.size(), "Truncated KV cache block descriptor");
+            return packed[pos++];
+        };
+        // Every counted element takes at least one word, so a count past the end of the data is corrupt.
+        auto const nextCount = [&packed, &pos, &next]()
+        {
+            auto const count = next();
+            TLLM_CHECK_WITH_INFO(count >= 0 && static_cast<std::uint64_t>(count) <= packed.size() - pos,
+                "Invalid count (%ld) in KV cache block descriptor", static_cast<long>(count));
+            return static_cast<std::size_t>(count);
+        };
+        KVCacheBlockDescriptor descriptor;
+        auto const dataType = next();
+        TLLM_CHECK_WITH_INFO(isValidDataType(dataType), "Invalid data type (%ld) in KV cache block descriptor",
+            static_cast<long>(dataType));
+        descriptor.mDataType = static_cast<nvinfer1::DataType>(dataType);
+        descriptor.mTokensPerBlock = static_cast<SizeType>(next());
+        descriptor.mNumTokens = static_cast<SizeType>(next());
+        descriptor.mBlockShapes.resize(nextCount());
+        for (auto& shape : descriptor.mBlockShapes)
+        {
+            shape.nbDims = static_cast<std::int32_t>(next());
+            TLLM_CHECK_WITH_INFO(shape.nbDims >= 0 && shape.nbDims <= Shape::MAX_DIMS, "Invalid block shape");
+            for (std::int32_t i = 0; i < shape.nbDims; ++i)
+            {
+                shape.d[i] = static_cast<std::int32_t>(next());
+            }
+        }
+        descriptor.mCacheBlockIds.resize(nextCount());
+        for (auto& beamBlockIds : descriptor.mCacheBlockIds)
+        {
+            beamBlockIds.resize(nextCount());
+            for (auto& blockId : beamBlockIds)
+            {
+                blockId = static_cast<SizeType>(next());
+            }
+        }
+        TLLM_CHECK_WITH_INFO(pos == packed.size(), "Trailing data in KV cache block descriptor");
+        return descriptor;
+    }
+
+private:
+    [[nodiscard]] static bool isValidDataType(std::int64_t value)
+    {
+        switch (static_cast<nvinfer1::DataType>(value))
+        {
+        case nvinfer1::DataType::kFLOAT: [[fallthrough]];
+        case nvinfer1::DataType::kHALF: [[fallthrough]];
+        case nvinfer1::DataType::kINT8: [[fallthrough]];
+        case nvinfer1::DataType::kINT32: [[fallthrough]];
+        case nvinfer1::DataType::kBOOL: [[fallthrough]];
+        case nvinfer1::DataType::kUINT8: [[fallthrough]];
+        case nvinfer1::DataType::kFP8: [[fallthrough]];
+        case nvinfer1::DataType::kBF16: [[fallthrough]];
+        case nvinfer1::DataType::kINT64: return true;
+        default: return false;
+        }
+    }
+
+    //! \brief Shape of a single block of a pool of shape [numBlocks, ...].
+    [[nodiscard]] static Shape blockShape(Shape const& poolShape)
+    {
+        Shape shape{};
+        shape.nbDims = poolShape.nbDims - 1;
+        std::copy(poolShape.d + 1, poolShape.d + poolShape.nbDims, shape.d);
+        return shape;
+    }
+
+    nvinfer1::DataType mDataType{nvinfer1::DataType::kFLOAT};
+    SizeType mTokensPerBlock{0};
+    SizeType mNumTokens{0};
+    std::vector<Shape> mBlockShapes;
+    std::vector<std::vector<SizeType>> mCacheBlockIds;
+};
+
+//! \brief Send the blocks of a described sequence to peer, in the order of getUniqueBlockIds.
+//! \details TCommunicator provides send(IBuffer const&, int peer, CudaStream const&), e.g.
+//! runtime::NcclCommunicator. The stream must be ordered after the context phase that wrote the blocks.
+template <typename TCommunicator>
+void sendBlocks(TCommunicator const& comm, KVCacheBlockDescriptor const& descriptor,
+    std::vector<runtime::ITensor::SharedPtr> const& pools, int peer, runtime::CudaStream const& stream)
+{
+    for (auto const blockId : descriptor.getUniqueBlockIds())
+    {
+        for (auto const& pool : pools)
+        {
+            auto const block = runtime::ITensor::slice(pool, blockId, 1);
+            comm.send(*block, peer, stream);
+        }
+    }
+}
+
+//! \brief Receive the blocks of a described sequence from peer into the locally allocated blockIds.
+//! \param localTokensPerBlock Tokens per block of the local KV cache, must match the exporting instance.
+//! \param blockIds Local block ids, one per entry of descriptor.getUniqueBlockIds() and in the same order.
+template <typename TCommunicator>
+void receiveBlocks(TCommunicator const& comm, KVCacheBlockDescriptor const& descriptor,
+    std::vector<runtime::ITensor::SharedPtr> const& pools, runtime::SizeType localTokensPerBlock,
+    std::vector<runtime::SizeType> const& blockIds, int peer, runtime::CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(descriptor.isCompatible(pools, localTokensPerBlock),
+        "KV cache block descriptor does not match the local KV cache pools");
+    TLLM_CHECK_WITH_INFO(static_cast<runtime::SizeType>(blockIds.size()) == descriptor.getNumUniqueBlocks(),
+        "Expected %d blocks, got %zu", descriptor.getNumUniqueBlocks(), blockIds.size());
+    for (auto const blockId : blockIds)
+    {
+        for (auto const& pool : pools)
+        {
+            auto block = runtime::ITensor::slice(pool, blockId, 1);
+            comm.receive(*block, peer, stream);
+        }
+    }
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+// Interleaves the iterations of several models sharing one GPU.
+// Stride scheduling over GPU time: every model has a virtual time that advances by the duration of its iterations
+// divided by its weight, one plus the number of its active and queued requests, and the model with work and the
+// smallest virtual time runs next. A model with many requests gets proportionally more iterations, and a model with a
+// few requests still runs regularly, so neither starves. A model that was idle rejoins at the smallest virtual time of
+// the busy models instead of catching up on the time it did not use. Pair with KVCacheMemoryArbiter, which moves the KV
+// cache memory along with the same queue depths.
+class MultiModelScheduler
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using Duration = std::chrono::duration<double>;
+
+    explicit MultiModelScheduler(SizeType numModels)
+        : mModels(numModels)
+    {
+        TLLM_CHECK_WITH_INFO(numModels > 0, "At least one model is required");
+    }
+
+    [[nodiscard]] SizeType getNumModels() const noexcept
+    {
+        return static_cast<SizeType>(mModels.size());
+    }
+
+    //! \brief Select the model of the next iteration.
+    //! \param numRequests Active and queued requests of every model.
+    //! \return The model, or nothing if no model has requests.
+    [[nodiscard]] std::optional<SizeType> next(std::vector<SizeType> const& numRequests)
+    {
+        TLLM_CHECK_WITH_INFO(numRequests.size() == mModels.size(), "Got request counts of %zu models for %zu models",
+            numRequests.size(), mModels.size());
+        auto minBusyTime = std::numeric_limits<double>::max();
+        for (std::size_t i = 0; i < mModels.size(); ++i)
+        {
+            if (numRequests[i] > 0 && mModels[i].busy)
+            {
+                minBusyTime = std::min(minBusyTime, mModels[i].virtualTime);
+            }
+        }
+        std::optional<SizeType> selected;
+        for (std::size_t i = 0; i < mModels.size(); ++i)
+        {
+            auto& model = mModels[i];
+            auto const busy = numRequests[i] > 0;
+            if (busy && !model.busy && minBusyTime != std::numeric_limits<double>::max())
+            {
+                model.virtualTime = std::max(model.virtualTime, minBusyTime);
+            }
+            model.busy = busy;
+            model.weight = 1.0 + static_cast<double>(numRequests[i]);
+            if (busy && (!selected || model.virtualTime < mModels[*selected].virtualTime))
+            {
+                selected = static_cast<SizeType>(i);
+            }
+        }
+        return selected;
+    }
+
+    //! \brief Charge an iteration of model that took duration.
+    void recordIteration(SizeType model, Duration duration)
+    {
+        TLLM_CHECK_WITH_INFO(model >= 0 && model < getNumModels(), "Invalid model index %d", model);
+        auto& state = mModels[model];
+        state.virtualTime += duration.count() / state.weight;
+        state.gpuTime += duration;
+        ++state.numIterations;
+    }
+
+    //! \brief GPU time of the iterations of model so far.
+    [[nodiscard]] Duration getGpuTime(SizeType model) const
+    {
+        return mModels.at(model).gpuTime;
+    }
+
+    [[nodiscard]] std::uint64_t getNumIterations(SizeType model) const
+    {
+        return mModels.at(model).numIterations;
+    }
+
+private:
+    struct ModelState
+    {
+        double virtualTime{0.0};
+        double weight{1.0};
+        bool busy{false};
+        Duration gpuTime{0.0};
+        std::uint64_t numIterations{0};
+    };
+
+    std::vector<ModelState> mModels;
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+struct MultiStepPlan
+{
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    // Generation steps enqueued back to back before the host looks at the results again
+    SizeType numSteps{0};
+    // Steps of every request of the round, in the order of the requests. A request is masked as finished on the
+    // device once it generated this many tokens, i.e. at its maxNewTokens.
+    std::vector<SizeType> requestSteps;
+    // KV cache blocks to reserve before the round so that no request runs out of blocks in the middle of it
+    SizeType numBlocks{0};
+};
+
+// Plans rounds of several generation steps, so that the host schedules, updates the KV cache and delivers responses
+// once per round instead of once per token. The engine and decoder steps of a round are enqueued back to back, the
+// decoder masks the sequences that finish within the round on the device. The blocks of all the steps are reserved
+// up front. A round shrinks to as many steps as the free blocks allow, at worst to the single step of the usual loop.
+// Usage, once per round:
+//     auto const plan = planner.plan(generationRequests, kvCacheManager.getNumFreeBlocks());
+//     ... add plan.requestSteps tokens of KV cache to every request ...
+//     for (step = 0; step < plan.numSteps; ++step) { enqueue engine and decoder steps }
+//     ... synchronize, then update the requests and send the responses ...
+class MultiStepPlanner
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestList = std::list<std::shared_ptr<LlmRequest>>;
+
+    MultiStepPlanner(SizeType maxNumSteps, SizeType tokensPerBlock)
+        : mMaxNumSteps{maxNumSteps}
+        , mTokensPerBlock{tokensPerBlock}
+    {
+        TLLM_CHECK_WITH_INFO(maxNumSteps > 0, "Number of steps per round must be positive");
+        TLLM_CHECK_WITH_INFO(tokensPerBlock > 0, "Tokens per block must be positive");
+    }
+
+    [[nodiscard]] SizeType getMaxNumSteps() const noexcept
+    {
+        return mMaxNumSteps;
+    }
+
+    //! \brief Tokens the request can still generate.
+    [[nodiscard]] static SizeType getRemainingSteps(LlmRequest const& req)
+    {
+        return std::max(req.mMaxNewTokens - req.getMaxNumGeneratedTokens(), 0);
+    }
+
+    //! \brief Blocks to add so that every beam of the request can generate numSteps more tokens. A generation step
+    //!        writes the KV cache of the last token of the sequence, so the cache holds numTokens - 1 tokens before
+    //!        the step. This is getNeededBlocksOneStep for numSteps == 1.
+    [[nodiscard]] SizeType getNeededBlocks(LlmRequest const& req, SizeType numSteps) const
+    {
+        auto const steps = std::min(numSteps, getRemainingSteps(req));
+        auto const cachedTokens = req.getMaxBeamNumTokens() - 1;
+        auto const neededPerBeam
+            = common::ceilDiv(cachedTokens + steps, mTokensPerBlock) - common::ceilDiv(cachedTokens, mTokensPerBlock);
+        return neededPerBeam * req.mSamplingConfig.beamWidth;
+    }
+
+    //! \brief Plan the next round of the requests in generation.
+    //! \param numFreeBlocks Free blocks of the KV cache manager.
+    //! \return The plan, with no step if no request can generate.
+    [[nodiscard]] MultiStepPlan plan(RequestList const& generationRequests, SizeType numFreeBlocks) const
+    {
+        MultiStepPlan plan;
+        // No step past the end of the longest request, the others are masked once they reach theirs.
+        for (auto const& req : generationRequests)
+        {
+            plan.numSteps = std::max(plan.numSteps, std::min(mMaxNumSteps, getRemainingSteps(*req)));
+        }
+        for (; plan.numSteps > 0; --plan.numSteps)
+        {
+            plan.numBlocks = 0;
+            for (auto const& req : generationRequests)
+            {
+                plan.numBlocks += getNeededBlocks(*req, plan.numSteps);
+            }
+            // A single step is left to the KV cache manager, which pauses requests when it runs out of blocks.
+            if (plan.numBlocks <= numFreeBlocks || plan.numSteps == 1)
+            {
+                break;
+            }
+        }
+
+        plan.requestSteps.reserve(generationRequests.size());
+        for (auto const& req : generationRequests)
+        {
+            plan.requestSteps.push_back(std::min(plan.numSteps, getRemainingSteps(*req)));
+        }
+        return plan;
+    }
+
+private:
+    SizeType mMaxNumSteps;
+    SizeType mTokensPerBlock;
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
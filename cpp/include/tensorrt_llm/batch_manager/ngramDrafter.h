@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Prompt lookup drafter: proposes draft tokens by matching the end of a sequence against earlier n-grams of the
+// same sequence, i.e. of its prompt and generated tokens. This works well when the output copies spans of the
+// input, as in retrieval augmented generation or code editing, and needs neither a draft model nor the client.
+// Every sequence has an index from n-gram to the position following its most recent earlier occurrence. The index
+// is updated incrementally with the tokens added since the previous call, so the cost per step is
+// O((maxNgramSize - minNgramSize + 1) * numNewTokens). The drafts are set with LlmRequest::setDraftTokens and are
+// verified by the target model like external draft tokens, through invokeAcceptDraftTokensByIds.
+class NgramDrafter
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using TokenIdType = tensorrt_llm::runtime::TokenIdType;
+    using RequestIdType = LlmRequest::RequestIdType;
+    using VecTokens = LlmRequest::VecTokens;
+
+    //! \param maxDraftTokens Maximum number of draft tokens proposed per step, K.
+    //! \param maxNgramSize Longest suffix that is matched, tried first.
+    //! \param minNgramSize Shortest suffix that is matched.
+    explicit NgramDrafter(SizeType maxDraftTokens, SizeType maxNgramSize = 3, SizeType minNgramSize = 1)
+        : mMaxDraftTokens{maxDraftTokens}
+        , mMaxNgramSize{maxNgramSize}
+        , mMinNgramSize{minNgramSize}
+    {
+        TLLM_CHECK_WITH_INFO(maxDraftTokens > 0, "Maximum number of draft tokens must be positive");
+        TLLM_CHECK_WITH_INFO(minNgramSize > 0 && minNgramSize <= maxNgramSize,
+            "Invalid n-gram sizes [%d, %d]", minNgramSize, maxNgramSize);
+    }
+
+    //! \brief Propose draft tokens for tokens, the prompt followed by the generated tokens of a sequence.
+    //! \details Tokens must only grow between calls with the same requestId, except for a rewind after rejected
+    //! drafts, which is detected and re-indexes the sequence.
+    [[nodiscard]] VecTokens proposeDraftTokens(
+        RequestIdType requestId, VecTokens const& tokens, SizeType maxDraftTokens)
+    {
+        auto& index = mIndices[requestId];
+        update(index, tokens);
+
+        auto const numTokens = static_cast<SizeType>(tokens.size());
+        auto const numDraftTokens = std::min(mMaxDraftTokens, maxDraftTokens);
+        if (numDraftTokens <= 0)
+        {
+            return {};
+        }
+        for (auto ngramSize = std::min(mMaxNgramSize, numTokens - 1); ngramSize >= mMinNgramSize; --ngramSize)
+        {
+            auto const begin = numTokens - ngramSize;
+            auto const it = index.continuations.find(hashNgram(tokens, begin, ngramSize));
+            if (it == index.continuations.end())
+            {
+                continue;
+            }
+            auto const continuation = it->second;
+            // Guard against hash collisions
+            if (!std::equal(tokens.begin() + begin, tokens.end(), tokens.begin() + continuation - ngramSize))
+            {
+                continue;
+            }
+            auto const end = std::min(continuation + numDraftTokens, numTokens);
+            ++mNumHits;
+            return VecTokens(tokens.begin() + continuation, tokens.begin() + end);
+        }
+        ++mNumMisses;
+        return {};
+    }
+
+    //! \brief Set the draft tokens of a request in generation phase.
+    //! \details Beam search does not support draft tokens, such requests are left unchanged. The number of drafts
+    //! is limited so that accepting all of them does not exceed the maximum number of new tokens.
+    void prepareDraftTokens(LlmRequest& request)
+    {
+        if (!request.isGenerationInProgressState() || request.mSamplingConfig.beamWidth != 1)
+        {
+            return;
+        }
+        // The target model produces one token in addition to the accepted drafts.
+        auto const maxDraftTokens = request.mMaxNewTokens - request.getMaxNumGeneratedTokens() - 1;
+        auto draftTokens = proposeDraftTokens(request.mRequestId, request.getTokens(0), maxDraftTokens);
+        request.setDraftTokens(std::make_shared<VecTokens>(std::move(draftTokens)));
+    }
+
+    //! \brief Drop the index of a finished request.
+    void removeRequest(RequestIdType requestId)
+    {
+        mIndices.erase(requestId);
+    }
+
+    [[nodiscard]] SizeType getNumSequences() const noexcept
+    {
+        return static_cast<SizeType>(mIndices.size());
+    }
+
+    [[nodiscard]] std::size_t getNumHits() const noexcept
+    {
+        return mNumHits;
+    }
+
+    [[nodiscard]] std::size_t getNumMisses() const noexcept
+    {
+        return mNumMisses;
+    }
+
+private:
+    struct SequenceIndex
+    {
+        // Hash of an n-gram and its size -> position of the token following its latest occurrence
+        std::unordered_map<std::uint64_t, SizeType> continuations;
+        // Number of tokens of the sequence already indexed
+        SizeType numIndexedTokens{0};
+        // Last token indexed, used to detect rewinds
+        TokenIdType lastToken{0};
+    };
+
+    [[nodiscard]] static std::uint64_t hashNgram(VecTokens const& tokens, SizeType begin, SizeType size) noexcept
+    {
+        auto hash = static_cast<std::uint64_t>(size);
+        for (auto i = begin; i < begin + size; ++i)
+        {
+            auto const token = static_cast<std::uint64_t>(static_cast<std::uint32_t>(tokens[i]));
+            hash ^= token + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
+    void update(SequenceIndex& index, VecTokens const& tokens) const
+    {
+        auto const numTokens = static_cast<SizeType>(tokens.size());
+        if (index.numIndexedTokens > numTokens
+            || (index.numIndexedTokens > 0 && tokens[index.numIndexedTokens - 1] != index.lastToken))
+        {
+            index.continuations.clear();
+            index.numIndexedTokens = 0;
+        }
+        // An n-gram ending at position pos - 1 is indexed once its continuation at pos exists. Later occurrences
+        // overwrite earlier ones, recent context is the better predictor.
+        for (auto pos = std::max(index.numIndexedTokens, 1); pos < numTokens; ++pos)
+        {
+            for (auto ngramSize = mMinNgramSize; ngramSize <= std::min(mMaxNgramSize, pos); ++ngramSize)
+            {
+                index.continuations[hashNgram(tokens, pos - ngramSize, ngramSize)] = pos;
+            }
+        }
+        index.numIndexedTokens = numTokens;
+        if (numTokens > 0)
+        {
+            index.lastToken = tokens[numTokens - 1];
+        }
+    }
+
+    SizeType mMaxDraftTokens;
+    SizeType mMaxNgramSize;
+    SizeType mMinNgramSize;
+    std::unordered_map<RequestIdType, SequenceIndex> mIndices;
+    std::size_t mNumHits{0};
+    std::size_t mNumMisses{0};
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Parallel sampling state of the requests in flight, keyed by request id, so that LlmRequest keeps the layout the
+// prebuilt batch manager was compiled against. A request with several return sequences runs its context once, then
+// is forked into one child request per additional sequence. Requests without an entry have a single sequence.
+// The owner of the request queue sets the number of sequences when a request arrives and erases the parent and its
+// children when they complete.
+class ParallelSamplingTable
+{
+public:
+    using RequestIdType = LlmRequest::RequestIdType;
+    using SizeType = LlmRequest::SizeType;
+
+    //! \brief Get the number of sequences sampled for the prompt of the request.
+    [[nodiscard]] SizeType getNumReturnSequences(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? it->second.numReturnSequences : 1;
+    }
+
+    void setNumReturnSequences(LlmRequest const& request, SizeType numReturnSequences)
+    {
+        TLLM_CHECK_WITH_INFO(numReturnSequences > 0, "Number of return sequences (%d) must be positive.",
+            numReturnSequences);
+        TLLM_CHECK_WITH_INFO(numReturnSequences == 1 || request.mSamplingConfig.beamWidth == 1,
+            "Multiple return sequences are only supported for sampling, got beam width %d.",
+            request.mSamplingConfig.beamWidth);
+        TLLM_CHECK_WITH_INFO(!getParentRequestId(request.mRequestId), "Request %lu is a child of request %lu.",
+            request.mRequestId, getParentRequestId(request.mRequestId).value_or(0));
+        mEntries[request.mRequestId].numReturnSequences = numReturnSequences;
+    }
+
+    //! \brief Get the id of the request this sequence was forked from, if any.
+    [[nodiscard]] std::optional<RequestIdType> getParentRequestId(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? it->second.parentRequestId : std::nullopt;
+    }
+
+    //! \brief Get the index of the sequence among the return sequences of its parent, 0 for the parent itself.
+    [[nodiscard]] SizeType getSequenceIndex(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? it->second.sequenceIndex : 0;
+    }
+
+    //! \brief Seed of sequence sequenceIdx of a request with several return sequences, mixed from the seed of the
+    //! request with splitmix64 so that the sequences differ and are reproducible. Sequence 0 keeps the request seed.
+    [[nodiscard]] static std::uint64_t deriveSequenceSeed(std::uint64_t requestSeed, SizeType sequenceIdx)
+    {
+        if (sequenceIdx == 0)
+        {
+            return requestSeed;
+        }
+        auto z = requestSeed + static_cast<std::uint64_t>(sequenceIdx) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    //! \brief Fork sequence sequenceIdx in [1, getNumReturnSequences()) of the parent after its context step, before
+    //! the first generated token is added.
+    //! \details The child copies the prompt and the context state, so that it goes straight to the generation phase,
+    //! and samples the logits of the last context token with its own seed. Its KV cache is made of the context blocks
+    //! of the parent shared by reference count, see kv_cache_manager::CopyOnWriteBlockTable::fromContext.
+    [[nodiscard]] std::shared_ptr<LlmRequest> createChildRequest(
+        LlmRequest const& parent, RequestIdType requestId, SizeType sequenceIdx)
+    {
+        auto const parentId = parent.mRequestId;
+        TLLM_CHECK_WITH_INFO(!getParentRequestId(parentId), "Request %lu is already a child of request %lu.",
+            parentId, getParentRequestId(parentId).value_or(0));
+        auto const numReturnSequences = getNumReturnSequences(parentId);
+        TLLM_CHECK_WITH_INFO(0 < sequenceIdx && sequenceIdx < numReturnSequences,
+            "Sequence index (%d) must be in [1, %d).", sequenceIdx, numReturnSequences);
+        TLLM_CHECK_WITH_INFO(parent.getNumTokens(0) == parent.mPromptLen,
+            "Request %lu must be forked before its first token.", parentId);
+        TLLM_CHECK_WITH_INFO(mEntries.count(requestId) == 0, "Request id %lu is already in use.", requestId);
+        auto child = std::make_shared<LlmRequest>(parent);
+        child->mRequestId = requestId;
+        auto const& seeds = parent.mSamplingConfig.randomSeed;
+        auto const requestSeed = seeds ? seeds->front() : 0;
+        child->mSamplingConfig.randomSeed = std::vector<std::uint64_t>{deriveSequenceSeed(requestSeed, sequenceIdx)};
+        auto& entry = mEntries[requestId];
+        entry.parentRequestId = parentId;
+        entry.sequenceIndex = sequenceIdx;
+        return child;
+    }
+
+    //! \brief Drop the state of a completed request.
+    void erase(RequestIdType requestId)
+    {
+        mEntries.erase(requestId);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return mEntries.size();
+    }
+
+private:
+    struct Entry
+    {
+        SizeType numReturnSequences{1};
+        std::optional<RequestIdType> parentRequestId;
+        SizeType sequenceIndex{0};
+    };
+
+    std::unordered_map<RequestIdType, Entry> mEntries;
+};
+
+} // namespace tensorrt_llm::batch_manager
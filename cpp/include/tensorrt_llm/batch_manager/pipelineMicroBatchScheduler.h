@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/tokenBudgetScheduler.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+// Schedules the in-flight micro-batches of a pipeline-parallel engine, 1F1B style.
+// While the last stage runs micro-batch i, the first stage already runs micro-batch i + 1, so with numMicroBatches
+// >= pipeline parallelism slots every stage always has work. The micro-batches are launched and completed in
+// round-robin order. A request is in at most one in-flight micro-batch, its next token is only known once its
+// micro-batch left the last stage. Each micro-batch is packed by the token budget scheduler from the requests that are
+// not in flight, and takes at most an even share of the decodes, so that the stages see micro-batches of similar cost
+// instead of one full micro-batch followed by bubbles.
+class PipelineMicroBatchScheduler
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestList = std::list<std::shared_ptr<LlmRequest>>;
+
+    PipelineMicroBatchScheduler(SizeType numMicroBatches, TokenBudgetConfig const& config)
+        : mScheduler{config}
+        , mMicroBatches(numMicroBatches)
+        , mInFlight(numMicroBatches, false)
+    {
+        TLLM_CHECK_WITH_INFO(numMicroBatches > 0, "Number of micro-batches must be positive");
+    }
+
+    [[nodiscard]] SizeType getNumMicroBatches() const noexcept
+    {
+        return static_cast<SizeType>(mMicroBatches.size());
+    }
+
+    //! \brief Micro-batch launched by the next call to scheduleNext, nullopt while all of them are in flight. The
+    //!        caller then completes the oldest micro-batch, which is the one to launch next.
+    [[nodiscard]] std::optional<SizeType> getNextMicroBatchId() const noexcept
+    {
+        if (mInFlight.at(mNextMicroBatchId))
+        {
+            return std::nullopt;
+        }
+        return mNextMicroBatchId;
+    }
+
+    [[nodiscard]] SizeType getNumInFlight() const noexcept
+    {
+        return static_cast<SizeType>(std::count(mInFlight.begin(), mInFlight.end(), true));
+    }
+
+    //! \brief Select the requests of the next micro-batch and mark them in flight.
+    //! \param maxBatchSize Maximum number of requests of the micro-batch.
+    //! \param loraCache Passed on to TokenBudgetScheduler::schedule.
+    //! \return The id of the micro-batch and its schedule, nullopt if the pipeline is full or nothing can be scheduled.
+    [[nodiscard]] std::optional<std::pair<SizeType, TokenBudgetSchedule>> scheduleNext(
+        RequestList const& requests, SizeType maxBatchSize, runtime::LoraCache* loraCache = nullptr)
+    {
+        auto const microBatchId = getNextMicroBatchId();
+        if (!microBatchId)
+        {
+            return std::nullopt;
+        }
+
+        SizeType numDecodes{0};
+        for (auto const& request : requests)
+        {
+            numDecodes += request->isGenerationInProgressState() ? 1 : 0;
+        }
+        auto const decodeShare = (numDecodes + getNumMicroBatches() - 1) / getNumMicroBatches();
+
+        RequestList candidates;
+        SizeType numCandidateDecodes{0};
+        for (auto const& request : requests)
+        {
+            if (mInFlightRequests.count(request->mRequestId) > 0)
+            {
+                continue;
+            }
+            if (request->isGenerationInProgressState())
+            {
+                if (numCandidateDecodes == decodeShare)
+                {
+                    continue;
+                }
+                ++numCandidateDecodes;
+            }
+            candidates.push_back(request);
+        }
+
+        auto schedule = mScheduler.schedule(candidates, maxBatchSize, loraCache);
+        if (schedule.generationRequests.empty() && schedule.contextRequests.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto& microBatch = mMicroBatches.at(*microBatchId);
+        microBatch.clear();
+        for (auto const* scheduled : {&schedule.generationRequests, &schedule.contextRequests})
+        {
+            for (auto const& request : *scheduled)
+            {
+                mInFlightRequests.insert(request->mRequestId);
+                microBatch.push_back(request->mRequestId);
+            }
+        }
+        mInFlight.at(*microBatchId) = true;
+        mNextMicroBatchId = (*microBatchId + 1) % getNumMicroBatches();
+        return std::make_pair(*microBatchId, std::move(schedule));
+    }
+
+    //! \brief The outputs of the micro-batch came back from the last stage, its requests can be scheduled again.
+    //!        Micro-batches complete in the order they were launched.
+    void complete(SizeType microBatchId)
+    {
+        TLLM_CHECK_WITH_INFO(mInFlight.at(microBatchId), "Micro-batch %d is not in flight", microBatchId);
+        auto const oldest = (mNextMicroBatchId + getNumMicroBatches() - getNumInFlight()) % getNumMicroBatches();
+        TLLM_CHECK_WITH_INFO(microBatchId == oldest, "Micro-batch %d completed before micro-batch %d", microBatchId,
+            static_cast<SizeType>(oldest));
+        for (auto const requestId : mMicroBatches.at(microBatchId))
+        {
+            mInFlightRequests.erase(requestId);
+        }
+        mMicroBatches.at(microBatchId).clear();
+        mInFlight.at(microBatchId) = false;
+    }
+
+private:
+    TokenBudgetScheduler mScheduler;
+    // Requests of each in-flight micro-batch
+    std::vector<std::vector<LlmRequest::RequestIdType>> mMicroBatches;
+    std::vector<bool> mInFlight;
+    std::unordered_set<LlmRequest::RequestIdType> mInFlightRequests;
+    SizeType mNextMicroBatchId{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
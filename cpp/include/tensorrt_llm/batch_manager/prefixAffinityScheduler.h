@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+// Reorders the pending requests so that block reuse pays off more often.
+// Within the first fairnessWindow requests waiting for their context phase:
+// - requests whose prompt prefix is already cached in the BlockManager are moved to the front, so they hit the
+//   blocks before they are evicted,
+// - requests sharing the same first prompt block are grouped back-to-back behind the first of them, which populates
+//   the blocks the others then reuse.
+// Probing the reuse tree only reads it (KVCacheBlock::findMatchingBlock), scheduling state is not modified.
+// A request that was overtaken maxBypass times is not overtaken anymore. Requests in generation keep their position.
+// Meant to be applied to the active requests before the MAX_UTILIZATION or GUARANTEED_NO_EVICT scheduler runs,
+// e.g. from an override of GptManager::step.
+class PrefixAffinityReorderer
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestIdType = LlmRequest::RequestIdType;
+    using RequestList = std::list<std::shared_ptr<LlmRequest>>;
+
+    explicit PrefixAffinityReorderer(SizeType fairnessWindow = 64, SizeType maxBypass = 8)
+        : mFairnessWindow{fairnessWindow}
+        , mMaxBypass{maxBypass}
+    {
+        TLLM_CHECK_WITH_INFO(fairnessWindow > 0, "Fairness window must be positive");
+        TLLM_CHECK_WITH_INFO(maxBypass >= 0, "Maximum number of bypasses must not be negative");
+    }
+
+    //! \brief Number of leading full prompt blocks of the request found in the reuse tree.
+    [[nodiscard]] static SizeType countCachedBlocks(
+        kv_cache_manager::BlockManager const& blockManager, LlmRequest const& request)
+    {
+        auto const tokensPerBlock = blockManager.getTokensPerBlock();
+        auto const& tokens = request.getTokens(0);
+        // The last prompt token is always recomputed to produce the first output token.
+        auto const numBlocks = (request.getOrigPromptLen() - 1) / tokensPerBlock;
+        auto block = blockManager.getCachedBlocksRoot();
+        kv_cache_manager::VecTokens blockTokens(tokensPerBlock);
+        SizeType numCachedBlocks{0};
+        for (; numCachedBlocks < numBlocks; ++numCachedBlocks)
+        {
+            auto const begin = tokens.begin() + numCachedBlocks * tokensPerBlock;
+            std::copy(begin, begin + tokensPerBlock, blockTokens.begin());
+            block = block->findMatchingBlock(blockTokens);
+            if (!block)
+            {
+                break;
+            }
+        }
+        return numCachedBlocks;
+    }
+
+    //! \brief Reorder the requests in the context phase at the front of the list.
+    void reorder(RequestList& requests, kv_cache_manager::BlockManager const& blockManager)
+    {
+        std::vector<RequestList::iterator> window;
+        for (auto it = requests.begin(); it != requests.end() && static_cast<SizeType>(window.size()) < mFairnessWindow;
+             ++it)
+        {
+            if ((*it)->isContextInitState())
+            {
+                window.push_back(it);
+            }
+        }
+        pruneBypassCounts(requests);
+        if (window.size() < 2)
+        {
+            return;
+        }
+
+        auto const tokensPerBlock = blockManager.getTokensPerBlock();
+        auto const numRequests = static_cast<SizeType>(window.size());
+        // (starving, not cached, group leader position, position), the smallest key goes first
+        using Key = std::tuple<bool, bool, SizeType, SizeType>;
+        std::vector<Key> keys;
+        keys.reserve(numRequests);
+        std::unordered_map<std::size_t, SizeType> groupLeaders;
+        for (SizeType pos = 0; pos < numRequests; ++pos)
+        {
+            auto const& request = **window[pos];
+            auto const starving = mBypassCounts[request.mRequestId] >= mMaxBypass;
+            auto const cached = countCachedBlocks(blockManager, request) > 0;
+            auto leader = pos;
+            if (auto const key = getFirstBlockKey(request, tokensPerBlock))
+            {
+                leader = groupLeaders.try_emplace(*key, pos).first->second;
+            }
+            keys.emplace_back(!starving, !cached, leader, pos);
+        }
+
+        std::vector<SizeType> order(numRequests);
+        for (SizeType pos = 0; pos < numRequests; ++pos)
+        {
+            order[pos] = pos;
+        }
+        std::stable_sort(
+            order.begin(), order.end(), [&keys](SizeType lhs, SizeType rhs) { return keys[lhs] < keys[rhs]; });
+
+        std::vector<std::shared_ptr<LlmRequest>> reordered;
+        reordered.reserve(numRequests);
+        for (SizeType newPos = 0; newPos < numRequests; ++newPos)
+        {
+            reordered.push_back(*window[order[newPos]]);
+        }
+        updateBypassCounts(order, reordered);
+        for (SizeType pos = 0; pos < numRequests; ++pos)
+        {
+            *window[pos] = std::move(reordered[pos]);
+        }
+    }
+
+    [[nodiscard]] SizeType getBypassCount(RequestIdType requestId) const
+    {
+        auto it = mBypassCounts.find(requestId);
+        return it != mBypassCounts.end() ? it->second : 0;
+    }
+
+private:
+    [[nodiscard]] static std::optional<std::size_t> getFirstBlockKey(LlmRequest const& request, SizeType tokensPerBlock)
+    {
+        if (request.getOrigPromptLen() <= tokensPerBlock)
+        {
+            return std::nullopt;
+        }
+        auto const& tokens = request.getTokens(0);
+        return std::hash<kv_cache_manager::VecTokens>{}(
+            kv_cache_manager::VecTokens(tokens.begin(), tokens.begin() + tokensPerBlock));
+    }
+
+    //! \brief Count for each request how many requests that were behind it have been moved ahead of it.
+    void updateBypassCounts(
+        std::vector<SizeType> const& order, std::vector<std::shared_ptr<LlmRequest>> const& reordered)
+    {
+        auto const numRequests = static_cast<SizeType>(order.size());
+        for (SizeType newPos = 0; newPos < numRequests; ++newPos)
+        {
+            SizeType numBypasses{0};
+            for (SizeType prevPos = 0; prevPos < newPos; ++prevPos)
+            {
+                numBypasses += order[prevPos] > order[newPos] ? 1 : 0;
+            }
+            mBypassCounts[reordered[newPos]->mRequestId] += numBypasses > 0 ? 1 : 0;
+        }
+    }
+
+    void pruneBypassCounts(RequestList const& requests)
+    {
+        std::unordered_set<RequestIdType> requestIds;
+        for (auto const& request : requests)
+        {
+            requestIds.insert(request->mRequestId);
+        }
+        for (auto it = mBypassCounts.begin(); it != mBypassCounts.end();)
+        {
+            it = requestIds.count(it->first) > 0 ? std::next(it) : mBypassCounts.erase(it);
+        }
+    }
+
+    SizeType mFairnessWindow;
+    SizeType mMaxBypass;
+    // Number of scheduling rounds in which a request was overtaken
+    std::unordered_map<RequestIdType, SizeType> mBypassCounts;
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/kvCacheSwapSpace.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/requestSchedulingTable.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+enum class PreemptionMode
+{
+    // Release the blocks and recompute the context, generated tokens are folded into the prompt.
+    kRECOMPUTE,
+    // Copy the blocks to the KVCacheSwapSpace and restore them on resume. Falls back to recompute for beam search
+    // or if the swap space is full.
+    kSWAP,
+};
+
+// Priority-aware admission and preemption on top of the MAX_UTILIZATION and GUARANTEED_NO_EVICT schedulers.
+// admit() moves waiting requests ahead of lower-priority ones, with earlier deadlines first among equal
+// priorities. When the KV cache cannot hold a newly admitted request, selectVictims() picks running requests of
+// lower priority whose blocks cover the shortfall and preempt() releases them by swap or recompute. Priorities and
+// deadlines are read from a RequestSchedulingTable, which may be shared with a DeadlineScheduler.
+class PriorityScheduler
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestPtr = std::shared_ptr<LlmRequest>;
+    using RequestList = std::list<RequestPtr>;
+
+    explicit PriorityScheduler(PreemptionMode preemptionMode = PreemptionMode::kRECOMPUTE,
+        std::shared_ptr<RequestSchedulingTable> schedulingTable = std::make_shared<RequestSchedulingTable>())
+        : mPreemptionMode{preemptionMode}
+        , mSchedulingTable{std::move(schedulingTable)}
+    {
+        TLLM_CHECK_WITH_INFO(mSchedulingTable, "Scheduling table must not be null");
+    }
+
+    [[nodiscard]] PreemptionMode getPreemptionMode() const noexcept
+    {
+        return mPreemptionMode;
+    }
+
+    [[nodiscard]] std::shared_ptr<RequestSchedulingTable> const& getSchedulingTable() const noexcept
+    {
+        return mSchedulingTable;
+    }
+
+    //! \brief Stable reorder of the requests waiting for their context phase by priority and deadline.
+    //! \details Requests in generation keep their position in the list.
+    void admit(RequestList& requests) const
+    {
+        std::vector<RequestList::iterator> waiting;
+        for (auto it = requests.begin(); it != requests.end(); ++it)
+        {
+            if ((*it)->isContextInitState())
+            {
+                waiting.push_back(it);
+            }
+        }
+        std::vector<RequestPtr> ordered;
+        ordered.reserve(waiting.size());
+        for (auto const& it : waiting)
+        {
+            ordered.push_back(*it);
+        }
+        std::stable_sort(ordered.begin(), ordered.end(), [this](RequestPtr const& lhs, RequestPtr const& rhs)
+            { return admissionKey(*lhs) < admissionKey(*rhs); });
+        for (std::size_t idx = 0; idx < waiting.size(); ++idx)
+        {
+            *waiting[idx] = std::move(ordered[idx]);
+        }
+    }
+
+    //! \brief Number of tokens in the KV cache of a request in generation. The cache of the last generated token is
+    //! only written by the next step.
+    [[nodiscard]] static SizeType getNumCachedTokens(LlmRequest const& request)
+    {
+        return request.getNumTokens(0) - 1;
+    }
+
+    //! \brief Block ids of every beam of the sequence of a running request.
+    //! \details Recovered from the block pointers of the first layer and the address of its pool, so that only the
+    //! public KVCacheManager interface is used. Sequences are assumed to hold
+    //! ceilDiv(getNumCachedTokens(), tokensPerBlock) blocks per beam.
+    [[nodiscard]] static std::vector<std::vector<SizeType>> getCacheBlockIds(
+        LlmRequest const& request, kv_cache_manager::KVCacheManager const& kvCacheManager)
+    {
+        auto const beamWidth = request.mSamplingConfig.beamWidth;
+        auto const maxBlocksPerSeq = kvCacheManager.getMaxBlocksPerSeq();
+        auto const numBlocks = std::min(
+            common::ceilDiv(getNumCachedTokens(request), kvCacheManager.getTokensPerBlock()), maxBlocksPerSeq);
+        auto const& pools = kvCacheManager.getMemoryPools();
+        TLLM_CHECK_WITH_INFO(!pools.empty(), "KV cache manager has no pools");
+        auto const& pool = *pools.front();
+        auto const poolAddress = reinterpret_cast<std::uintptr_t>(pool.data());
+        auto const blockSizeInBytes = pool.getSizeInBytes() / static_cast<std::size_t>(pool.getShape().d[0]);
+
+        auto const numLayers = static_cast<SizeType>(pools.size());
+        auto pointers = runtime::BufferManager::cpu(
+            runtime::ITensor::makeShape({numLayers, beamWidth, 2, maxBlocksPerSeq}), nvinfer1::DataType::kINT64);
+        kvCacheManager.getBlockPointersOfBatch(*pointers, request.mSeqSlot, 1, beamWidth);
+        auto const* pointersData = runtime::bufferCast<std::int64_t>(*pointers);
+
+        std::vector<std::vector<SizeType>> blockIds(beamWidth);
+        for (SizeType beam = 0; beam < beamWidth; ++beam)
+        {
+            // Pointers to the K part of the blocks of the first layer
+            auto const* beamPointers = pointersData + static_cast<std::size_t>(beam) * 2 * maxBlocksPerSeq;
+            for (SizeType blockIdx = 0; blockIdx < numBlocks; ++blockIdx)
+            {
+                auto const offset = static_cast<std::uintptr_t>(beamPointers[blockIdx]) - poolAddress;
+                blockIds[beam].push_back(static_cast<SizeType>(offset / blockSizeInBytes));
+            }
+        }
+        return blockIds;
+    }
+
+    //! \brief Number of distinct blocks held by the sequence of a running request.
+    [[nodiscard]] static SizeType getNumHeldBlocks(
+        LlmRequest const& request, kv_cache_manager::KVCacheManager const& kvCacheManager)
+    {
+        std::set<SizeType> blockIds;
+        for (auto const& beamBlockIds : getCacheBlockIds(request, kvCacheManager))
+        {
+            blockIds.insert(beamBlockIds.begin(), beamBlockIds.end());
+        }
+        return static_cast<SizeType>(blockIds.size());
+    }
+
+    //! \brief Pick running requests to preempt so that numNeededBlocks blocks become free for incoming.
+    //! \details Only requests with a strictly lower priority are considered, the lowest priority first and among
+    //! equal priorities the one that started last, which loses the least work. Shared blocks are counted for every
+    //! request holding them, so the estimate may be optimistic with block reuse.
+    //! \return The victims, or nothing if they cannot free enough blocks.
+    [[nodiscard]] std::vector<RequestPtr> selectVictims(RequestList const& running, LlmRequest const& incoming,
+        SizeType numNeededBlocks, kv_cache_manager::KVCacheManager const& kvCacheManager) const
+    {
+        auto numFreeBlocks = kvCacheManager.getNumFreeBlocks();
+        if (numFreeBlocks >= numNeededBlocks)
+        {
+            return {};
+        }
+        auto const& table = *mSchedulingTable;
+        auto const incomingPriority = table.getPriority(incoming.mRequestId);
+        std::vector<RequestPtr> candidates;
+        // Requests further back in the list started later.
+        for (auto it = running.rbegin(); it != running.rend(); ++it)
+        {
+            if ((*it)->isGenerationInProgressState() && table.getPriority((*it)->mRequestId) < incomingPriority)
+            {
+                candidates.push_back(*it);
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [&table](RequestPtr const& lhs, RequestPtr const& rhs)
+            { return table.getPriority(lhs->mRequestId) < table.getPriority(rhs->mRequestId); });
+
+        std::vector<RequestPtr> victims;
+        for (auto it = candidates.begin(); it != candidates.end() && numFreeBlocks < numNeededBlocks; ++it)
+        {
+            numFreeBlocks += getNumHeldBlocks(**it, kvCacheManager);
+            victims.push_back(*it);
+        }
+        if (numFreeBlocks < numNeededBlocks)
+        {
+            return {};
+        }
+        return victims;
+    }
+
+    //! \brief Release the KV cache of a running request so it can be resumed later.
+    //! \param swapSpace Swap space used with PreemptionMode::kSWAP, may be null.
+    //! \param maxInputLen Maximum prompt length of the engine, used when recomputing.
+    //! \return true if the request was swapped out, false if it will be recomputed.
+    bool preempt(LlmRequest& request, kv_cache_manager::KVCacheManager& kvCacheManager,
+        kv_cache_manager::KVCacheSwapSpace* swapSpace, SizeType maxInputLen) const
+    {
+        auto const seqSlot = request.mSeqSlot;
+        auto swap = mPreemptionMode == PreemptionMode::kSWAP && swapSpace != nullptr
+            && request.mSamplingConfig.beamWidth == 1;
+        if (swap)
+        {
+            auto const blockIds = getCacheBlockIds(request, kvCacheManager).front();
+            swap = swapSpace->canSwapOut(static_cast<SizeType>(blockIds.size()));
+            if (swap)
+            {
+                swapSpace->swapOut(request.mRequestId, blockIds);
+            }
+        }
+        TLLM_LOG_DEBUG("Preempting request %lu with priority %f by %s", request.mRequestId,
+            mSchedulingTable->getPriority(request.mRequestId), swap ? "swap" : "recompute");
+        kvCacheManager.removeSequence(seqSlot);
+        if (!swap)
+        {
+            request.pause(maxInputLen);
+        }
+        return swap;
+    }
+
+    //! \brief Bring back a request preempted by swap into sequence slot seqSlot.
+    static void resume(LlmRequest& request, SizeType seqSlot, kv_cache_manager::KVCacheManager& kvCacheManager,
+        kv_cache_manager::KVCacheSwapSpace& swapSpace)
+    {
+        TLLM_CHECK_WITH_INFO(swapSpace.isSwappedOut(request.mRequestId), "Request %lu is not swapped out",
+            request.mRequestId);
+        request.mSeqSlot = seqSlot;
+        kvCacheManager.addSequence(seqSlot, getNumCachedTokens(request), 1);
+        swapSpace.swapIn(request.mRequestId, getCacheBlockIds(request, kvCacheManager).front());
+    }
+
+private:
+    //! \brief Higher priorities first, then earlier deadlines, requests without deadline last.
+    [[nodiscard]] std::tuple<RequestSchedulingTable::PriorityType, bool, RequestSchedulingTable::TimePoint>
+    admissionKey(LlmRequest const& request) const
+    {
+        auto const deadline = mSchedulingTable->getDeadline(request.mRequestId);
+        return std::make_tuple(-mSchedulingTable->getPriority(request.mRequestId), !deadline.has_value(),
+            deadline.value_or(RequestSchedulingTable::TimePoint::max()));
+    }
+
+    PreemptionMode mPreemptionMode;
+    std::shared_ptr<RequestSchedulingTable> mSchedulingTable;
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
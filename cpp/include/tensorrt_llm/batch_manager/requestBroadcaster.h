@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/inferenceRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Broadcasts the new requests of an iteration from the rank that fetched them to the other ranks of the model.
+// The requests are serialized into one contiguous buffer of int64 words, [numWords, words...] per request, described by
+// a fixed header of two words. The header is broadcast with bcastAsync so that it completes while the GPU works on the
+// current step, the payload follows only when there are new requests. The followers learn that an iteration has no
+// new request from the header, which costs a single 16 byte broadcast that is overlapped.
+// Usage, on every rank of comm:
+//     broadcaster.start(newRequests); // ignored on the followers
+//     ... enqueue the current step ...
+//     auto requests = broadcaster.finish();
+class RequestBroadcaster
+{
+public:
+    using RequestList = std::list<std::shared_ptr<InferenceRequest>>;
+
+    RequestBroadcaster(mpi::MpiComm const& comm, int root)
+        : mComm{comm}
+        , mRoot{root}
+    {
+    }
+
+    RequestBroadcaster(RequestBroadcaster const&) = delete;
+    RequestBroadcaster& operator=(RequestBroadcaster const&) = delete;
+
+    ~RequestBroadcaster()
+    {
+        // The header must outlive its broadcast.
+        if (mHeaderRequest)
+        {
+            mHeaderRequest->wait();
+        }
+    }
+
+    [[nodiscard]] bool isRoot() const
+    {
+        return mComm.getRank() == mRoot;
+    }
+
+    // Serializes the requests on the root and posts the broadcast of the header.
+    void start(RequestList const& requests)
+    {
+        TLLM_CHECK_WITH_INFO(!mHeaderRequest, "The previous broadcast was not finished");
+        if (isRoot())
+        {
+            mRequests = requests;
+            mPayload.clear();
+            for (auto const& request : requests)
+            {
+                auto const packed = request->serialize();
+                mPayload.push_back(static_cast<int64_t>(packed.size()));
+                mPayload.insert(mPayload.end(), packed.begin(), packed.end());
+            }
+            mHeader = {static_cast<int64_t>(requests.size()), static_cast<int64_t>(mPayload.size())};
+        }
+        mHeaderRequest = mComm.bcastAsync(mHeader.data(), mHeader.size(), mpi::MpiType::kINT64, mRoot);
+    }
+
+    // Completes the broadcast.
+    // \returns the requests passed to start on the root, their copies on the followers
+    RequestList finish()
+    {
+        TLLM_CHECK_WITH_INFO(mHeaderRequest, "No broadcast was started");
+        mHeaderRequest->wait();
+        mHeaderRequest.reset();
+        auto const [numRequests, numWords] = mHeader;
+        if (numRequests == 0)
+        {
+            return {};
+        }
+
+        if (!isRoot())
+        {
+            mPayload.resize(numWords);
+        }
+        mComm.bcast(mPayload.data(), mPayload.size(), mpi::MpiType::kINT64, mRoot);
+        if (isRoot())
+        {
+            return std::move(mRequests);
+        }
+
+        RequestList requests;
+        auto const* packed = mPayload.data();
+        for (int64_t i = 0; i < numRequests; ++i)
+        {
+            auto const requestWords = *packed++;
+            TLLM_CHECK_WITH_INFO(packed + requestWords <= mPayload.data() + numWords, "Corrupted request broadcast");
+            requests.push_back(InferenceRequest::deserialize(std::vector<int64_t>(packed, packed + requestWords)));
+            packed += requestWords;
+        }
+        return requests;
+    }
+
+private:
+    mpi::MpiComm const& mComm;
+    int mRoot;
+    // Number of requests and number of words of the payload
+    std::array<int64_t, 2> mHeader{};
+    std::shared_ptr<mpi::MpiRequest> mHeaderRequest;
+    // Reused from one iteration to the next
+    std::vector<int64_t> mPayload;
+    RequestList mRequests;
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+// Scheduling attributes of the requests in flight, keyed by request id, so that LlmRequest keeps the layout the
+// prebuilt batch manager was compiled against. Requests without an entry have the default priority, no deadline, no
+// LoRA adapter and are not cancelled.
+// The owner of the request queue sets the attributes when a request arrives and erases them when it completes.
+class RequestSchedulingTable
+{
+public:
+    using RequestIdType = LlmRequest::RequestIdType;
+    using PriorityType = float;
+    // Task id of an adapter in runtime::LoraCache
+    using LoraTaskIdType = std::int64_t;
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static PriorityType constexpr kMinPriority{0.0f};
+    static PriorityType constexpr kDefaultPriority{0.5f};
+    static PriorityType constexpr kMaxPriority{1.0f};
+
+    //! \brief Requests with a higher priority are admitted first and may preempt running requests with a lower one.
+    void setPriority(RequestIdType requestId, PriorityType priority)
+    {
+        TLLM_CHECK_WITH_INFO(priority >= kMinPriority && priority <= kMaxPriority,
+            "Request priority (%f) must be in [%f, %f].", priority, kMinPriority, kMaxPriority);
+        mEntries[requestId].priority = priority;
+    }
+
+    [[nodiscard]] PriorityType getPriority(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? it->second.priority : kDefaultPriority;
+    }
+
+    //! \brief Point in time by which the request should have completed.
+    void setDeadline(RequestIdType requestId, TimePoint deadline)
+    {
+        mEntries[requestId].deadline = deadline;
+    }
+
+    //! \brief Set the deadline relative to the arrival of the request.
+    void setTimeout(RequestIdType requestId, std::chrono::milliseconds timeout, TimePoint arrivalTime = Clock::now())
+    {
+        setDeadline(requestId, arrivalTime + timeout);
+    }
+
+    [[nodiscard]] std::optional<TimePoint> getDeadline(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? it->second.deadline : std::nullopt;
+    }
+
+    //! \brief Whether the deadline of the request has passed.
+    [[nodiscard]] bool isExpired(RequestIdType requestId, TimePoint now = Clock::now()) const
+    {
+        auto const deadline = getDeadline(requestId);
+        return deadline.has_value() && now >= *deadline;
+    }
+
+    //! \brief Task id of the LoRA adapter of the request, if the adapter is served from the LoRA cache.
+    void setLoraTaskId(RequestIdType requestId, LoraTaskIdType taskId)
+    {
+        mEntries[requestId].loraTaskId = taskId;
+    }
+
+    [[nodiscard]] std::optional<LoraTaskIdType> getLoraTaskId(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? it->second.loraTaskId : std::nullopt;
+    }
+
+    //! \brief Mark the request as cancelled, DeadlineScheduler::dropExpired drops it and releases its resources in the
+    //! next iteration.
+    void cancel(RequestIdType requestId)
+    {
+        mEntries[requestId].cancelled = true;
+    }
+
+    [[nodiscard]] bool isCancelled(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() && it->second.cancelled;
+    }
+
+    //! \brief Drop the attributes of a completed request.
+    void erase(RequestIdType requestId)
+    {
+        mEntries.erase(requestId);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return mEntries.size();
+    }
+
+private:
+    struct Entry
+    {
+        PriorityType priority{kDefaultPriority};
+        std::optional<TimePoint> deadline;
+        std::optional<LoraTaskIdType> loraTaskId;
+        bool cancelled{false};
+    };
+
+    std::unordered_map<RequestIdType, Entry> mEntries;
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::rnn_state_manager
+{
+
+using SizeType = tensorrt_llm::runtime::SizeType;
+using VecTokens = kv_cache_manager::VecTokens;
+
+// One recurrent state of a sequence, e.g. the conv state [numLayers, convKernel - 1, dim] or the SSM state
+// [numLayers, dstate, dim] of a Mamba model.
+struct RnnStateDesc
+{
+    std::string name;
+    runtime::ITensor::Shape shape;
+    nvinfer1::DataType dataType;
+};
+
+struct RnnStateStats
+{
+    SizeType numSlots{0};
+    SizeType numFreeSlots{0};
+    SizeType numCheckpoints{0};
+    std::size_t numCheckpointHits{0};
+    std::size_t numCheckpointMisses{0};
+    // Prompt tokens that did not need a context phase thanks to a checkpoint
+    std::size_t numReusedTokens{0};
+    SizeType numSwappedRequests{0};
+    std::size_t numSwapOuts{0};
+    std::size_t numSwapIns{0};
+};
+
+// Counterpart of the KVCacheManager for the recurrent states of SSM models such as Mamba.
+// Each state lives in a GPU pool of shape [numSlots, ...]. Sequences take a slot when they start and give it back
+// when they finish, so the pools are sized by a memory budget (calculateMaxNumSlots) rather than by maxBatchSize. The
+// engine reads the states of the batch through the slot ids of fillSlotIds.
+//
+// The state after a prompt prefix summarizes the whole prefix, so it can be reused like the KV cache blocks of that
+// prefix. storeCheckpoint copies the state of a sequence into a checkpoint slot when its context reaches a multiple
+// of checkpointInterval tokens, and restoreCheckpoint starts a new sequence from the longest checkpointed prefix of
+// its prompt. Checkpoints are evicted in LRU order.
+//
+// swapOut and swapIn move the states of a paused sequence to pinned host memory and back, on a side stream ordered
+// with the compute stream by events, like KVCacheSwapSpace does for the KV cache.
+class RnnStateManager
+{
+public:
+    using RequestIdType = std::uint64_t;
+    using CheckpointKey = std::size_t;
+    using CudaStreamPtr = std::shared_ptr<runtime::CudaStream>;
+
+    RnnStateManager(SizeType numSlots, std::vector<RnnStateDesc> states, CudaStreamPtr computeStream,
+        SizeType numCheckpoints = 0, SizeType checkpointInterval = 0, SizeType numHostSlots = 0,
+        CudaStreamPtr transferStream = nullptr)
+        : mStates{std::move(states)}
+        , mComputeStream{std::move(computeStream)}
+        , mTransferStream{transferStream ? std::move(transferStream) : std::make_shared<runtime::CudaStream>()}
+        , mBufferManager{mComputeStream}
+        , mTransferBufferManager{mTransferStream}
+        , mCheckpointInterval{checkpointInterval}
+        , mCheckpoints(numCheckpoints)
+    {
+        TLLM_CHECK_WITH_INFO(numSlots > 0, "Number of state slots must be positive");
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mComputeStream), "Undefined compute stream");
+        TLLM_CHECK_WITH_INFO(numCheckpoints == 0 || checkpointInterval > 0,
+            "Checkpoints need a positive checkpoint interval, got %d", checkpointInterval);
+        for (auto const& state : mStates)
+        {
+            mGpuPools.emplace_back(mBufferManager.gpu(withNumSlots(state.shape, numSlots), state.dataType));
+            if (numCheckpoints > 0)
+            {
+                mCheckpointPools.emplace_back(
+                    mBufferManager.gpu(withNumSlots(state.shape, numCheckpoints), state.dataType));
+            }
+            if (numHostSlots > 0)
+            {
+                mHostPools.emplace_back(
+                    runtime::BufferManager::pinnedPool(withNumSlots(state.shape, numHostSlots), state.dataType));
+            }
+        }
+        for (SizeType slot = numSlots - 1; slot >= 0; --slot)
+        {
+            mFreeSlots.push_back(slot);
+        }
+        for (SizeType slot = numCheckpoints - 1; slot >= 0; --slot)
+        {
+            mFreeCheckpoints.push_back(slot);
+        }
+        for (SizeType slot = numHostSlots - 1; slot >= 0; --slot)
+        {
+            mFreeHostSlots.push_back(slot);
+        }
+    }
+
+    //! \brief Number of slots of the given states that fit into memoryBudget bytes.
+    [[nodiscard]] static SizeType calculateMaxNumSlots(
+        std::size_t memoryBudget, std::vector<RnnStateDesc> const& states)
+    {
+        std::size_t const bytesPerSlot = getBytesPerSlot(states);
+        return bytesPerSlot > 0 ? static_cast<SizeType>(memoryBudget / bytesPerSlot) : 0;
+    }
+
+    [[nodiscard]] static std::size_t getBytesPerSlot(std::vector<RnnStateDesc> const& states)
+    {
+        std::size_t bytesPerSlot{0};
+        for (auto const& state : states)
+        {
+            bytesPerSlot += static_cast<std::size_t>(runtime::ITensor::volumeNonNegative(state.shape))
+                * common::getDTypeSize(state.dataType);
+        }
+        return bytesPerSlot;
+    }
+
+    [[nodiscard]] SizeType getNumFreeSlots() const noexcept
+    {
+        return static_cast<SizeType>(mFreeSlots.size());
+    }
+
+    //! \brief Take a slot for a new sequence, its states start at zero.
+    SizeType addSequence(RequestIdType requestId)
+    {
+        auto const slot = acquireSlot(requestId);
+        for (auto const& pool : mGpuPools)
+        {
+            mBufferManager.setZero(*runtime::ITensor::slice(pool, slot, 1));
+        }
+        return slot;
+    }
+
+    //! \brief Give back the slot of a finished sequence, and its swapped states if it was paused.
+    void removeSequence(RequestIdType requestId)
+    {
+        if (auto it = mSlots.find(requestId); it != mSlots.end())
+        {
+            mFreeSlots.push_back(it->second);
+            mSlots.erase(it);
+        }
+        if (auto it = mSwapped.find(requestId); it != mSwapped.end())
+        {
+            mFreeHostSlots.push_back(it->second);
+            mSwapped.erase(it);
+        }
+    }
+
+    [[nodiscard]] SizeType getSlot(RequestIdType requestId) const
+    {
+        auto it = mSlots.find(requestId);
+        TLLM_CHECK_WITH_INFO(it != mSlots.end(), "Request %lu has no state slot", requestId);
+        return it->second;
+    }
+
+    //! \brief Write the slots of the requests of a batch, in order, into the host tensor slotIds of int32.
+    void fillSlotIds(std::vector<RequestIdType> const& requestIds, runtime::ITensor& slotIds) const
+    {
+        TLLM_CHECK_WITH_INFO(slotIds.getSize() >= requestIds.size(), "Slot ids tensor too small for %zu requests",
+            requestIds.size());
+        auto* slotIdsPtr = runtime::bufferCast<SizeType>(slotIds);
+        for (std::size_t i = 0; i < requestIds.size(); ++i)
+        {
+            slotIdsPtr[i] = getSlot(requestIds[i]);
+        }
+    }
+
+    //! \brief GPU pools of the states, in the order of the descriptions given to the constructor.
+    [[nodiscard]] std::vector<runtime::ITensor::SharedPtr> const& getStatePools() const
+    {
+        return mGpuPools;
+    }
+
+    [[nodiscard]] SizeType getCheckpointInterval() const noexcept
+    {
+        return mCheckpointInterval;
+    }
+
+    //! \brief Copy the states of a sequence whose context has processed exactly prefix into a checkpoint.
+    //! \details Call it when the context reaches a multiple of the checkpoint interval, e.g. at the end of a context
+    //! chunk. Evicts the least recently used checkpoint when all are taken.
+    void storeCheckpoint(RequestIdType requestId, VecTokens const& prefix)
+    {
+        if (mCheckpoints.empty())
+        {
+            return;
+        }
+        auto const length = static_cast<SizeType>(prefix.size());
+        TLLM_CHECK_WITH_INFO(length > 0 && length % mCheckpointInterval == 0,
+            "Checkpoints are taken every %d tokens, got a prefix of %d", mCheckpointInterval, length);
+        auto const key = hashPrefix(prefix, length);
+        if (auto const existing = findCheckpoint(key, prefix, length))
+        {
+            touch(*existing);
+            return;
+        }
+
+        auto const checkpoint = acquireCheckpoint();
+        copyStates(mGpuPools, getSlot(requestId), mCheckpointPools, checkpoint, mBufferManager);
+        auto& entry = mCheckpoints[checkpoint];
+        entry.key = key;
+        entry.tokens = prefix;
+        mKeyToCheckpoint[key] = checkpoint;
+        mLruCheckpoints.push_front(checkpoint);
+        entry.lruIterator = mLruCheckpoints.begin();
+    }
+
+    //! \brief Start the sequence of requestId from the longest checkpointed prefix of its prompt.
+    //! \details At least the last token of the prompt is left for the context phase, to compute the logits.
+    //! \returns the number of prompt tokens covered by the restored states, 0 if no checkpoint matched
+    SizeType restoreCheckpoint(RequestIdType requestId, VecTokens const& prompt)
+    {
+        if (mCheckpoints.empty())
+        {
+            return 0;
+        }
+        auto const maxLength = (static_cast<SizeType>(prompt.size()) - 1) / mCheckpointInterval * mCheckpointInterval;
+        for (auto length = maxLength; length > 0; length -= mCheckpointInterval)
+        {
+            if (auto const checkpoint = findCheckpoint(hashPrefix(prompt, length), prompt, length))
+            {
+                copyStates(mCheckpointPools, *checkpoint, mGpuPools, getSlot(requestId), mBufferManager);
+                touch(*checkpoint);
+                ++mNumCheckpointHits;
+                mNumReusedTokens += length;
+                return length;
+            }
+        }
+        ++mNumCheckpointMisses;
+        return 0;
+    }
+
+    [[nodiscard]] bool canSwapOut() const noexcept
+    {
+        return !mFreeHostSlots.empty();
+    }
+
+    //! \brief Move the states of a paused sequence to host memory and give back its GPU slot.
+    void swapOut(RequestIdType requestId)
+    {
+        TLLM_CHECK_WITH_INFO(canSwapOut(), "No host slot left to swap out request %lu", requestId);
+        auto const slot = getSlot(requestId);
+        auto const hostSlot = mFreeHostSlots.back();
+        mFreeHostSlots.pop_back();
+
+        runtime::CudaEvent computeDone{};
+        mComputeStream->record(computeDone);
+        mTransferStream->wait(computeDone);
+        copyStates(mGpuPools, slot, mHostPools, hostSlot, mTransferBufferManager);
+        // The slot may be given to another sequence and overwritten only once the copy is done
+        runtime::CudaEvent transferDone{};
+        mTransferStream->record(transferDone);
+        mComputeStream->wait(transferDone);
+
+        mFreeSlots.push_back(slot);
+        mSlots.erase(requestId);
+        mSwapped.emplace(requestId, hostSlot);
+        ++mNumSwapOuts;
+    }
+
+    //! \brief Bring the states of a paused sequence back into a GPU slot.
+    SizeType swapIn(RequestIdType requestId)
+    {
+        auto it = mSwapped.find(requestId);
+        TLLM_CHECK_WITH_INFO(it != mSwapped.end(), "Request %lu is not swapped out", requestId);
+        auto const slot = acquireSlot(requestId);
+
+        runtime::CudaEvent computeDone{};
+        mComputeStream->record(computeDone);
+        mTransferStream->wait(computeDone);
+        copyStates(mHostPools, it->second, mGpuPools, slot, mTransferBufferManager);
+        runtime::CudaEvent transferDone{};
+        mTransferStream->record(transferDone);
+        mComputeStream->wait(transferDone);
+
+        // Host slots are only rewritten by later transfers on the same stream, no need to wait
+        mFreeHostSlots.push_back(it->second);
+        mSwapped.erase(it);
+        ++mNumSwapIns;
+        return slot;
+    }
+
+    [[nodiscard]] bool isSwappedOut(RequestIdType requestId) const
+    {
+        return mSwapped.find(requestId) != mSwapped.end();
+    }
+
+    [[nodiscard]] RnnStateStats getStats() const
+    {
+        RnnStateStats stats;
+        stats.numSlots = static_cast<SizeType>(mFreeSlots.size() + mSlots.size());
+        stats.numFreeSlots = static_cast<SizeType>(mFreeSlots.size());
+        stats.numCheckpoints = static_cast<SizeType>(mKeyToCheckpoint.size());
+        stats.numCheckpointHits = mNumCheckpointHits;
+        stats.numCheckpointMisses = mNumCheckpointMisses;
+        stats.numReusedTokens = mNumReusedTokens;
+        stats.numSwappedRequests = static_cast<SizeType>(mSwapped.size());
+        stats.numSwapOuts = mNumSwapOuts;
+        stats.numSwapIns = mNumSwapIns;
+        return stats;
+    }
+
+private:
+    struct Checkpoint
+    {
+        CheckpointKey key{0};
+        VecTokens tokens;
+        std::list<SizeType>::iterator lruIterator;
+    };
+
+    static runtime::ITensor::Shape withNumSlots(runtime::ITensor::Shape const& shape, SizeType numSlots)
+    {
+        TLLM_CHECK_WITH_INFO(shape.nbDims < runtime::ITensor::Shape::MAX_DIMS, "State of rank %d is too large",
+            shape.nbDims);
+        runtime::ITensor::Shape result{};
+        result.nbDims = shape.nbDims + 1;
+        result.d[0] = numSlots;
+        for (SizeType i = 0; i < shape.nbDims; ++i)
+        {
+            result.d[i + 1] = shape.d[i];
+        }
+        return result;
+    }
+
+    static CheckpointKey hashPrefix(VecTokens const& tokens, SizeType length)
+    {
+        return std::hash<VecTokens>{}(VecTokens(tokens.begin(), tokens.begin() + length));
+    }
+
+    std::optional<SizeType> findCheckpoint(CheckpointKey key, VecTokens const& tokens, SizeType length) const
+    {
+        auto it = mKeyToCheckpoint.find(key);
+        if (it == mKeyToCheckpoint.end())
+        {
+            return std::nullopt;
+        }
+        auto const& stored = mCheckpoints[it->second].tokens;
+        if (static_cast<SizeType>(stored.size()) != length || !std::equal(stored.begin(), stored.end(), tokens.begin()))
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void touch(SizeType checkpoint)
+    {
+        mLruCheckpoints.splice(mLruCheckpoints.begin(), mLruCheckpoints, mCheckpoints[checkpoint].lruIterator);
+    }
+
+    SizeType acquireSlot(RequestIdType requestId)
+    {
+        TLLM_CHECK_WITH_INFO(mSlots.find(requestId) == mSlots.end(), "Request %lu already has a state slot", requestId);
+        TLLM_CHECK_WITH_INFO(!mFreeSlots.empty(), "No state slot left for request %lu", requestId);
+        auto const slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+        mSlots.emplace(requestId, slot);
+        return slot;
+    }
+
+    SizeType acquireCheckpoint()
+    {
+        if (mFreeCheckpoints.empty())
+        {
+            TLLM_LOG_DEBUG("RnnStateManager: evicting least recently used checkpoint");
+            auto const evicted = mLruCheckpoints.back();
+            mLruCheckpoints.pop_back();
+            mKeyToCheckpoint.erase(mCheckpoints[evicted].key);
+            mCheckpoints[evicted].tokens.clear();
+            mFreeCheckpoints.push_back(evicted);
+        }
+        auto const checkpoint = mFreeCheckpoints.back();
+        mFreeCheckpoints.pop_back();
+        return checkpoint;
+    }
+
+    //! \brief Copy slot srcIdx of every pool in srcPools to slot dstIdx of the matching pool in dstPools.
+    void copyStates(std::vector<runtime::ITensor::SharedPtr> const& srcPools, SizeType srcIdx,
+        std::vector<runtime::ITensor::SharedPtr> const& dstPools, SizeType dstIdx,
+        runtime::BufferManager const& bufferManager)
+    {
+        for (std::size_t poolIdx = 0; poolIdx < srcPools.size(); ++poolIdx)
+        {
+            auto const src = runtime::ITensor::slice(srcPools[poolIdx], srcIdx, 1);
+            auto dst = runtime::ITensor::slice(dstPools[poolIdx], dstIdx, 1);
+            bufferManager.copy(*src, *dst);
+        }
+    }
+
+    std::vector<RnnStateDesc> mStates;
+    CudaStreamPtr mComputeStream;
+    // Side stream for host <-> device swaps
+    CudaStreamPtr mTransferStream;
+    runtime::BufferManager mBufferManager;
+    runtime::BufferManager mTransferBufferManager;
+    SizeType mCheckpointInterval;
+
+    std::vector<runtime::ITensor::SharedPtr> mGpuPools;
+    std::vector<SizeType> mFreeSlots;
+    std::unordered_map<RequestIdType, SizeType> mSlots;
+
+    std::vector<runtime::ITensor::SharedPtr> mCheckpointPools;
+    std::vector<Checkpoint> mCheckpoints;
+    std::vector<SizeType> mFreeCheckpoints;
+    std::unordered_map<CheckpointKey, SizeType> mKeyToCheckpoint;
+    // Most recently used first
+    std::list<SizeType> mLruCheckpoints;
+
+    std::vector<runtime::ITensor::SharedPtr> mHostPools;
+    std::vector<SizeType> mFreeHostSlots;
+    // Host slot of each swapped out request
+    std::unordered_map<RequestIdType, SizeType> mSwapped;
+
+    std::size_t mNumCheckpointHits{0};
+    std::size_t mNumCheckpointMisses{0};
+    std::size_t mNumReusedTokens{0};
+    std::size_t mNumSwapOuts{0};
+    std::size_t mNumSwapIns{0};
+};
+
+} // namespace tensorrt_llm::batch_manager::rnn_state_manager
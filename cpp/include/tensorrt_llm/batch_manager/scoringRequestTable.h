@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Scoring requests in flight, keyed by request id, so that LlmRequest keeps the layout the prebuilt batch manager was
+// compiled against. A scoring request scores the last continuationLength tokens of its input instead of generating.
+// It only runs its context phase, needs no decoder slot and releases its KV cache right after it.
+// The owner of the request queue registers a scoring request when it arrives and erases it once its log
+// probabilities have been returned.
+class ScoringRequestTable
+{
+public:
+    using RequestIdType = LlmRequest::RequestIdType;
+    using SizeType = LlmRequest::SizeType;
+    using VecTokens = LlmRequest::VecTokens;
+    using VecLogProbs = LlmRequest::VecLogProbs;
+
+    //! \brief Make the request a scoring request of the last continuationLength tokens of its input.
+    void setContinuationLength(LlmRequest const& request, SizeType continuationLength)
+    {
+        TLLM_CHECK_WITH_INFO(0 < continuationLength && continuationLength < request.mPromptLen,
+            "Continuation length (%d) must be in [1, %d).", continuationLength, request.mPromptLen);
+        mEntries[request.mRequestId].continuationLength = continuationLength;
+    }
+
+    [[nodiscard]] bool isScoringRequest(RequestIdType requestId) const
+    {
+        return mEntries.count(requestId) > 0;
+    }
+
+    [[nodiscard]] std::optional<SizeType> getContinuationLength(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        return it != mEntries.end() ? std::make_optional(it->second.continuationLength) : std::nullopt;
+    }
+
+    //! \brief Token scored with each row of the context logits of a scoring request, for
+    //! kernels::invokeGatherTokenLogProbs. Row i predicts input token i + 1, rows that predict no continuation token
+    //! are -1.
+    //! \return [promptLen] token ids
+    [[nodiscard]] VecTokens getScoringTargetIds(LlmRequest const& request) const
+    {
+        auto const promptLen = request.mPromptLen;
+        auto const& entry = getEntry(request.mRequestId);
+        VecTokens targetIds(promptLen, -1);
+        auto const& tokens = request.getTokens(0);
+        for (auto ti = promptLen - entry.continuationLength; ti < promptLen; ++ti)
+        {
+            targetIds[ti - 1] = tokens[ti];
+        }
+        return targetIds;
+    }
+
+    //! \brief Store the log probabilities of the continuation tokens, once the context of the request has run.
+    void setScoringLogProbs(RequestIdType requestId, VecLogProbs logProbs)
+    {
+        auto& entry = getEntry(requestId);
+        TLLM_CHECK_WITH_INFO(static_cast<SizeType>(logProbs.size()) == entry.continuationLength,
+            "Expected %d log probabilities for request %lu, got %lu.", entry.continuationLength, requestId,
+            logProbs.size());
+        entry.logProbs = std::move(logProbs);
+    }
+
+    //! \return [continuationLength] log probabilities, empty until they are set.
+    [[nodiscard]] VecLogProbs const& getScoringLogProbs(RequestIdType requestId) const
+    {
+        return getEntry(requestId).logProbs;
+    }
+
+    //! \brief Drop a completed scoring request.
+    void erase(RequestIdType requestId)
+    {
+        mEntries.erase(requestId);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return mEntries.size();
+    }
+
+private:
+    struct Entry
+    {
+        SizeType continuationLength{0};
+        VecLogProbs logProbs;
+    };
+
+    [[nodiscard]] Entry const& getEntry(RequestIdType requestId) const
+    {
+        auto it = mEntries.find(requestId);
+        TLLM_CHECK_WITH_INFO(it != mEntries.end(), "Request %lu is not a scoring request.", requestId);
+        return it->second;
+    }
+
+    [[nodiscard]] Entry& getEntry(RequestIdType requestId)
+    {
+        return const_cast<Entry&>(std::as_const(*this).getEntry(requestId));
+    }
+
+    std::unordered_map<RequestIdType, Entry> mEntries;
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/callbacks.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/tokenStreamRing.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+// Tokens of one request delivered in one call of a StreamingResponseCallback.
+struct StreamingResponseDelta
+{
+    uint64_t requestId;
+    runtime::SizeType slot;
+    // Position in the sequence of the request of the first token of the delta
+    runtime::SizeType firstPosition;
+    runtime::SizeType numTokens;
+    // The request finished with the last token of the delta
+    bool finished;
+};
+
+// Points into the StreamingResponseArena, valid until the callback returns.
+struct StreamingResponseView
+{
+    StreamingResponseDelta delta;
+    // [numTokens]
+    runtime::TokenIdType const* tokenIds;
+    // [numTokens], nullptr if the request does not return log probs
+    float const* logProbs;
+};
+
+// Delivers streamed tokens without allocating per token or per request.
+// The SendResponseCallback of GptManager builds a std::list<NamedTensor> with freshly allocated host tensors for every
+// request at every step. The arena instead keeps one preallocated pinned row of token ids and log probs per batch
+// slot. The tokens of a step are gathered from the TokenStreamRing of GptDecoderBatch into the rows of their slots,
+// then the callback receives one view per request with new tokens. Tokens of slots without a request are dropped.
+// Meant to be driven by the loop that owns the decoder, once per step, e.g. from an override of GptManager::step.
+class StreamingResponseArena
+{
+public:
+    using SizeType = runtime::SizeType;
+    using TokenIdType = runtime::TokenIdType;
+    using TensorPtr = runtime::ITensor::SharedPtr;
+
+    // maxTokensPerSlot bounds the tokens of a slot delivered in one view, more tokens are delivered in several views.
+    StreamingResponseArena(SizeType maxNumSlots, SizeType maxTokensPerSlot)
+        : mMaxTokensPerSlot{maxTokensPerSlot}
+        , mSlots(maxNumSlots)
+    {
+        TLLM_CHECK_WITH_INFO(maxNumSlots > 0 && maxTokensPerSlot > 0, "Arena dimensions must be positive");
+        auto const shape = runtime::ITensor::makeShape({maxNumSlots, maxTokensPerSlot});
+        mTokenIds = runtime::BufferManager::pinned(shape, nvinfer1::DataType::kINT32);
+        mLogProbs = runtime::BufferManager::pinned(shape, nvinfer1::DataType::kFLOAT);
+        mPendingSlots.reserve(maxNumSlots);
+    }
+
+    // Starts streaming the tokens of slot to requestId.
+    void setRequest(SizeType slot, uint64_t requestId, bool returnLogProbs)
+    {
+        auto& state = getSlot(slot);
+        TLLM_CHECK_WITH_INFO(state.numTokens == 0, "Slot %d has undelivered tokens", slot);
+        state = SlotState{requestId, true, returnLogProbs, false, 0, 0};
+    }
+
+    // Stops streaming the tokens of slot, e.g. when its request is cancelled.
+    void releaseSlot(SizeType slot)
+    {
+        auto& state = getSlot(slot);
+        state.active = false;
+        state.numTokens = 0;
+    }
+
+    // Stages the token of record in the row of its slot. A full row is delivered first.
+    void append(runtime::TokenStreamRecord const& record, StreamingResponseCallback const& callback)
+    {
+        auto& state = getSlot(record.slot);
+        if (!state.active || state.finished)
+        {
+            return;
+        }
+        if (state.numTokens == mMaxTokensPerSlot)
+        {
+            deliver(record.slot, callback);
+        }
+        if (state.numTokens == 0)
+        {
+            state.firstPosition = record.position;
+            mPendingSlots.push_back(record.slot);
+        }
+        auto const offset = record.slot * mMaxTokensPerSlot + state.numTokens;
+        runtime::bufferCast<TokenIdType>(*mTokenIds)[offset] = record.token;
+        runtime::bufferCast<float>(*mLogProbs)[offset] = record.logProb;
+        ++state.numTokens;
+        state.finished = record.finished != 0;
+    }
+
+    // Delivers the staged tokens, one view per slot in the order the slots received their first token.
+    void deliver(StreamingResponseCallback const& callback)
+    {
+        for (auto const slot : mPendingSlots)
+        {
+            deliver(slot, callback);
+        }
+        mPendingSlots.clear();
+    }
+
+    // Polls the tokens published by the decoder, stages and delivers them.
+    // \returns the number of records polled
+    SizeType dispatch(runtime::TokenStreamRing& ring, StreamingResponseCallback const& callback)
+    {
+        mRecords.clear();
+        auto const numRecords = ring.poll(mRecords);
+        for (auto const& record : mRecords)
+        {
+            append(record, callback);
+        }
+        deliver(callback);
+        return numRecords;
+    }
+
+    // \returns [maxNumSlots, maxTokensPerSlot], int32, pinned
+    [[nodiscard]] TensorPtr const& getTokenIds() const
+    {
+        return mTokenIds;
+    }
+
+    // \returns [maxNumSlots, maxTokensPerSlot], float, pinned
+    [[nodiscard]] TensorPtr const& getLogProbs() const
+    {
+        return mLogProbs;
+    }
+
+private:
+    struct SlotState
+    {
+        uint64_t requestId{0};
+        bool active{false};
+        bool returnLogProbs{false};
+        bool finished{false};
+        SizeType firstPosition{0};
+        SizeType numTokens{0};
+    };
+
+    SlotState& getSlot(SizeType slot)
+    {
+        TLLM_CHECK_WITH_INFO(0 <= slot && slot < static_cast<SizeType>(mSlots.size()), "Invalid slot %d", slot);
+        return mSlots[slot];
+    }
+
+    void deliver(SizeType slot, StreamingResponseCallback const& callback)
+    {
+        auto& state = mSlots[slot];
+        if (state.numTokens == 0)
+        {
+            return;
+        }
+        auto const offset = slot * mMaxTokensPerSlot;
+        StreamingResponseView const view{
+            StreamingResponseDelta{state.requestId, slot, state.firstPosition, state.numTokens, state.finished},
+            runtime::bufferCast<TokenIdType>(*mTokenIds) + offset,
+            state.returnLogProbs ? runtime::bufferCast<float>(*mLogProbs) + offset : nullptr};
+        // Reset first, a full row is delivered again later in the same step.
+        state.firstPosition += state.numTokens;
+        state.numTokens = 0;
+        if (state.finished)
+        {
+            state.active = false;
+        }
+        callback(view);
+    }
+
+    SizeType mMaxTokensPerSlot;
+    std::vector<SlotState> mSlots;
+    // Slots with staged tokens, in delivery order
+    std::vector<SizeType> mPendingSlots;
+    std::vector<runtime::TokenStreamRecord> mRecords;
+    TensorPtr mTokenIds;
+    TensorPtr mLogProbs;
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/requestSchedulingTable.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/timelineTracer.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/requestLatencyTracker.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/loraCache.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+struct TokenBudgetConfig
+{
+    using SizeType = tensorrt_llm::runtime::SizeType;
+
+    // Tokens processed by one iteration, decode and context tokens together. Usually the maxNumTokens of the engine.
+    SizeType maxNumTokens;
+    // Largest context chunk of a single request. Chunking is disabled if not set, i.e. a context is only scheduled
+    // if it fits into the remaining budget as a whole.
+    std::optional<SizeType> contextChunkSize{std::nullopt};
+    // Chunks that do not end the context are rounded down to a multiple of this, e.g. the tokens per KV cache block.
+    SizeType chunkUnitSize{1};
+    // Distinct LoRA adapters of an iteration. Contexts with a new adapter are skipped once the running decodes and
+    // the scheduled contexts use this many adapters. Unbounded if not set.
+    std::optional<SizeType> maxNumLoraAdapters{std::nullopt};
+    // Iterations a context may be skipped for the adapter cap. After that it goes first and is scheduled even if its
+    // adapter exceeds the cap, so that a rare adapter is not starved by a steady stream of requests sharing the
+    // adapters of the running decodes.
+    SizeType maxNumLoraSkips{8};
+
+    //! \brief Budget of the executor, contexts are chunked in whole KV cache blocks if chunked context is enabled.
+    [[nodiscard]] static TokenBudgetConfig fromExecutorConfig(
+        executor::ExecutorConfig const& executorConfig, SizeType maxNumTokens, SizeType tokensPerBlock)
+    {
+        TokenBudgetConfig config{maxNumTokens};
+        if (executorConfig.getEnableChunkedContext())
+        {
+            config.contextChunkSize = maxNumTokens;
+            config.chunkUnitSize = tokensPerBlock;
+        }
+        return config;
+    }
+};
+
+struct TokenBudgetSchedule
+{
+    using RequestPtr = std::shared_ptr<LlmRequest>;
+
+    std::vector<RequestPtr> generationRequests;
+    std::vector<RequestPtr> contextRequests;
+    tensorrt_llm::runtime::SizeType numTokens{0};
+    // Distinct LoRA adapters of the scheduled requests
+    tensorrt_llm::runtime::SizeType numLoraAdapters{0};
+};
+
+// Packs the requests of one iteration into a token budget, decode first.
+// All running decodes are scheduled first, each costing its beam width plus its draft tokens. The remaining budget
+// is filled with context chunks in list order, so a long prompt is spread over several iterations instead of
+// stalling the decodes of everyone else. This keeps the inter-token latency flat while long prompts arrive.
+// The requests must already have been admitted by the capacity scheduler, the KV cache is not checked here.
+// With a cap on the LoRA adapters of an iteration, contexts sharing an adapter of the running decodes go first, then
+// contexts whose adapter is resident in the LoRA cache, then the rest, each group in list order. A long tail of
+// adapters with a few requests each then adds GEMM problems and cache traffic gradually instead of all at once.
+// Contexts skipped maxNumLoraSkips times for the cap are aged ahead of all others and may exceed the cap.
+class TokenBudgetScheduler
+{
+public:
+    using SizeType = tensorrt_llm::runtime::SizeType;
+    using RequestList = std::list<std::shared_ptr<LlmRequest>>;
+
+    //! \param latencyTracker If set, the scheduled contexts are marked scheduled in it.
+    //! \param schedulingTable Holds the LoRA task ids of the requests, may be shared with other schedulers.
+    explicit TokenBudgetScheduler(TokenBudgetConfig const& config,
+        std::shared_ptr<executor::RequestLatencyTracker> latencyTracker = nullptr,
+        std::shared_ptr<RequestSchedulingTable> schedulingTable = std::make_shared<RequestSchedulingTable>())
+        : mConfig{config}
+        , mLatencyTracker{std::move(latencyTracker)}
+        , mSchedulingTable{std::move(schedulingTable)}
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mSchedulingTable), "Undefined request scheduling table");
+        TLLM_CHECK_WITH_INFO(mConfig.maxNumTokens > 0, "Token budget must be positive");
+        TLLM_CHECK_WITH_INFO(mConfig.chunkUnitSize > 0, "Chunk unit size must be positive");
+        TLLM_CHECK_WITH_INFO(
+            mConfig.maxNumLoraAdapters.value_or(1) > 0, "Maximum number of LoRA adapters must be positive");
+        TLLM_CHECK_WITH_INFO(mConfig.maxNumLoraSkips > 0, "Maximum number of LoRA skips must be positive");
+        TLLM_CHECK_WITH_INFO(!mConfig.contextChunkSize || *mConfig.contextChunkSize >= mConfig.chunkUnitSize,
+            "Context chunk size (%d) must be at least the chunk unit size (%d)", mConfig.contextChunkSize.value_or(0),
+            mConfig.chunkUnitSize);
+    }
+
+    [[nodiscard]] TokenBudgetConfig const& getConfig() const noexcept
+    {
+        return mConfig;
+    }
+
+    [[nodiscard]] std::shared_ptr<RequestSchedulingTable> const& getSchedulingTable() const noexcept
+    {
+        return mSchedulingTable;
+    }
+
+    //! \brief Select the requests of the next iteration.
+    //! \details Updates the scheduled contexts: sets their chunk size if chunking is enabled, marks them scheduled in
+    //! the latency tracker and pins their LoRA adapter in loraCache until release() is called for them. Counts the
+    //! skips of the contexts held back by the adapter cap.
+    //! \param maxBatchSize Maximum number of requests in the iteration.
+    //! \param loraCache If set, a context with a LoRA task id is only scheduled once its adapter is resident.
+    //!        Adapters should be prefetched when requests are queued, a cold adapter is prefetched here at the latest.
+    [[nodiscard]] TokenBudgetSchedule schedule(
+        RequestList const& requests, SizeType maxBatchSize, runtime::LoraCache* loraCache = nullptr)
+    {
+        TLLM_TIMELINE_SCOPE(kScheduling, schedule);
+        TokenBudgetSchedule schedule;
+        auto const batchFull = [&schedule, maxBatchSize]()
+        {
+            return static_cast<SizeType>(schedule.generationRequests.size() + schedule.contextRequests.size())
+                >= maxBatchSize;
+        };
+
+        for (auto const& request : requests)
+        {
+            if (batchFull())
+            {
+                break;
+            }
+            if (!request->isGenerationInProgressState())
+            {
+                continue;
+            }
+            auto const numTokens = request->mSamplingConfig.beamWidth + request->getNumDraftTokens();
+            if (schedule.numTokens + numTokens > mConfig.maxNumTokens)
+            {
+                break;
+            }
+            schedule.numTokens += numTokens;
+            schedule.generationRequests.push_back(request);
+        }
+
+        std::unordered_set<RequestSchedulingTable::LoraTaskIdType> loraAdapters;
+        for (auto const& request : schedule.generationRequests)
+        {
+            if (auto const loraTaskId = mSchedulingTable->getLoraTaskId(request->mRequestId))
+            {
+                loraAdapters.insert(*loraTaskId);
+            }
+        }
+
+        std::vector<std::shared_ptr<LlmRequest>> contexts;
+        for (auto const& request : requests)
+        {
+            if (request->isContextInitState())
+            {
+                contexts.push_back(request);
+            }
+        }
+        if (mConfig.maxNumLoraAdapters)
+        {
+            // 0: starving, 1: no new adapter, 2: resident adapter, 3: adapter to load
+            auto const packingRank = [this, &loraAdapters, loraCache](std::shared_ptr<LlmRequest> const& request)
+            {
+                if (isStarving(*request))
+                {
+                    return 0;
+                }
+                auto const loraTaskId = mSchedulingTable->getLoraTaskId(request->mRequestId);
+                if (!loraTaskId || loraAdapters.count(*loraTaskId) > 0)
+                {
+                    return 1;
+                }
+                return loraCache && loraCache->isResident(*loraTaskId) ? 2 : 3;
+            };
+            std::stable_sort(contexts.begin(), contexts.end(),
+                [&packingRank](auto const& lhs, auto const& rhs) { return packingRank(lhs) < packingRank(rhs); });
+        }
+
+        for (auto const& request : contexts)
+        {
+            auto const remainingBudget = mConfig.maxNumTokens - schedule.numTokens;
+            if (batchFull() || remainingBudget <= 0)
+            {
+                break;
+            }
+            auto const numTokens = getContextTokens(*request, remainingBudget);
+            if (numTokens == 0)
+            {
+                // Without chunking a prompt that does not fit must not be overtaken forever by shorter ones.
+                break;
+            }
+            auto const loraTaskId = mSchedulingTable->getLoraTaskId(request->mRequestId);
+            if (loraTaskId && mConfig.maxNumLoraAdapters && loraAdapters.count(*loraTaskId) == 0
+                && static_cast<SizeType>(loraAdapters.size()) >= *mConfig.maxNumLoraAdapters && !isStarving(*request))
+            {
+                ++mNumLoraSkips[request->mRequestId];
+                continue;
+            }
+            if (loraCache && loraTaskId && !loraCache->acquire(*loraTaskId, request->mRequestId))
+            {
+                // The adapter is still being copied or the pool is full, the other contexts proceed meanwhile.
+                continue;
+            }
+            if (loraTaskId)
+            {
+                loraAdapters.insert(*loraTaskId);
+            }
+            mNumLoraSkips.erase(request->mRequestId);
+            if (mConfig.contextChunkSize)
+            {
+                request->setContextChunkSize(numTokens);
+            }
+            if (mLatencyTracker)
+            {
+                mLatencyTracker->markScheduled(request->mRequestId);
+            }
+            schedule.numTokens += numTokens;
+            schedule.contextRequests.push_back(request);
+        }
+        schedule.numLoraAdapters = static_cast<SizeType>(loraAdapters.size());
+        return schedule;
+    }
+
+    //! \brief Unpin the LoRA adapter that schedule() acquired for a request and forget its skips, once the request
+    //!        completed or was dropped.
+    void release(LlmRequest const& request, runtime::LoraCache* loraCache)
+    {
+        mNumLoraSkips.erase(request.mRequestId);
+        if (loraCache != nullptr && mSchedulingTable->getLoraTaskId(request.mRequestId))
+        {
+            loraCache->release(request.mRequestId);
+        }
+    }
+
+private:
+    [[nodiscard]] bool isStarving(LlmRequest const& request) const
+    {
+        auto it = mNumLoraSkips.find(request.mRequestId);
+        return it != mNumLoraSkips.end() && it->second >= mConfig.maxNumLoraSkips;
+    }
+
+    //! \brief Context tokens of the request that fit into the budget, 0 if it cannot be scheduled.
+    [[nodiscard]] SizeType getContextTokens(LlmRequest const& request, SizeType budget) const
+    {
+        auto const remainingLength = request.getContextRemainingLength();
+        if (!mConfig.contextChunkSize)
+        {
+            return remainingLength <= budget ? remainingLength : 0;
+        }
+        auto const maxChunk = std::min(budget, *mConfig.contextChunkSize);
+        if (remainingLength <= maxChunk)
+        {
+            return remainingLength;
+        }
+        return maxChunk / mConfig.chunkUnitSize * mConfig.chunkUnitSize;
+    }
+
+    TokenBudgetConfig mConfig;
+    std::shared_ptr<executor::RequestLatencyTracker> mLatencyTracker;
+    std::shared_ptr<RequestSchedulingTable> mSchedulingTable;
+    // Iterations each context was skipped for the adapter cap since it was last scheduled
+    std::unordered_map<LlmRequest::RequestIdType, SizeType> mNumLoraSkips;
+};
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -406,8 +406,9 @@ public:
     /// @brief  Returns the per-iterations statistics computed since last call to getLatestIterationStats
     ///         Contains at most iterStatsMaxIterations iterations
     ///         Will block until stats for at least one iteration are available
-    /// TODO: Should we use a class for iterationStats, i.e. std::deque<IterationStats>
-    /// @return
+    ///         Components that record typed IterationStats expose them through
+    ///         IterationStatsBuffer::getLatestIterationStats, which serializes to the same keys with toJson
+    /// @return The statistics of each iteration as JSON
     std::deque<std::string> getLatestIterationStats();
 
 private:
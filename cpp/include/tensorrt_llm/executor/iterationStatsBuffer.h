@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/types.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Serialize the statistics of an iteration with the keys of the JSON of Executor::getLatestIterationStats
+inline std::string toJson(IterationStats const& stats)
+{
+    auto const& kv = stats.kvCacheStats;
+    auto const& ifb = stats.inflightBatchingStats;
+    std::ostringstream os;
+    os << "{\"timestamp\":" << stats.timestampUs << ",\"iter\":" << stats.iter
+       << ",\"iterLatencyMS\":" << stats.iterLatencyMs << ",\"numActiveRequests\":" << stats.numActiveRequests
+       << ",\"maxNumActiveRequests\":" << stats.maxNumActiveRequests << ",\"gpuMemUsage\":" << stats.gpuMemUsage
+       << ",\"cpuMemUsage\":" << stats.cpuMemUsage << ",\"pinnedMemUsage\":" << stats.pinnedMemUsage
+       << ",\"kvCacheStats\":{\"maxNumBlocks\":" << kv.maxNumBlocks << ",\"freeNumBlocks\":" << kv.freeNumBlocks
+       << ",\"usedNumBlocks\":" << kv.usedNumBlocks << ",\"tokensPerBlock\":" << kv.tokensPerBlock
+       << ",\"reusedBlocks\":" << kv.reusedBlocks << ",\"cacheHitRate\":" << kv.cacheHitRate << "}"
+       << ",\"inflightBatchingStats\":{\"numScheduledRequests\":" << ifb.numScheduledRequests
+       << ",\"numContextRequests\":" << ifb.numContextRequests << ",\"numGenRequests\":" << ifb.numGenRequests
+       << ",\"numPausedRequests\":" << ifb.numPausedRequests << ",\"numCtxTokens\":" << ifb.numCtxTokens
+       << ",\"microBatchId\":" << ifb.microBatchId << "}}";
+    return os.str();
+}
+
+/// @brief Fixed-capacity ring buffer of the statistics of the latest iterations
+/// @details Holds the last iterStatsMaxIterations entries. The producer overwrites the oldest entry when the buffer is
+/// full, so a slow consumer loses old iterations instead of blocking the executor. Storage is allocated once in the
+/// constructor and entries are copied by value, so neither push nor drain allocates as long as the output vector has
+/// enough capacity.
+class IterationStatsBuffer
+{
+public:
+    explicit IterationStatsBuffer(SizeType maxIterations)
+        : mEntries(maxIterations > 0 ? maxIterations : 1)
+    {
+    }
+
+    /// @brief Record the statistics of an iteration
+    void push(IterationStats const& stats)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mEntries[(mBegin + mSize) % mEntries.size()] = stats;
+            if (mSize < mEntries.size())
+            {
+                ++mSize;
+            }
+            else
+            {
+                mBegin = (mBegin + 1) % mEntries.size();
+                ++mNumDropped;
+            }
+        }
+        mCv.notify_one();
+    }
+
+    /// @brief Move all buffered entries, oldest first, into out
+    /// @param out Cleared before it is filled, reuse it across calls to avoid allocations
+    /// @param timeout Wait at most this long for a first entry, do not wait if not set
+    /// @return The number of entries returned
+    std::size_t drain(std::vector<IterationStats>& out, std::optional<std::chrono::milliseconds> timeout = std::nullopt)
+    {
+        out.clear();
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (timeout)
+        {
+            mCv.wait_for(lock, *timeout, [this]() { return mSize > 0; });
+        }
+        for (std::size_t idx = 0; idx < mSize; ++idx)
+        {
+            out.push_back(mEntries[(mBegin + idx) % mEntries.size()]);
+        }
+        auto const numEntries = mSize;
+        mBegin = 0;
+        mSize = 0;
+        return numEntries;
+    }
+
+    /// @brief Return all buffered entries, oldest first
+    /// @param timeout Wait at most this long for a first entry, do not wait if not set
+    [[nodiscard]] std::deque<IterationStats> getLatestIterationStats(
+        std::optional<std::chrono::milliseconds> timeout = std::nullopt)
+    {
+        std::vector<IterationStats> entries;
+        drain(entries, timeout);
+        return {entries.begin(), entries.end()};
+    }
+
+    /// @brief getLatestIterationStats serialized with toJson, for consumers of the JSON of the executor
+    [[nodiscard]] std::deque<std::string> getLatestIterationStatsJson(
+        std::optional<std::chrono::milliseconds> timeout = std::nullopt)
+    {
+        std::deque<std::string> json;
+        for (auto const& stats : getLatestIterationStats(timeout))
+        {
+            json.push_back(toJson(stats));
+        }
+        return json;
+    }
+
+    [[nodiscard]] std::size_t getCapacity() const noexcept
+    {
+        return mEntries.size();
+    }
+
+    /// @brief Number of entries overwritten before they were drained
+    [[nodiscard]] std::uint64_t getNumDropped() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mNumDropped;
+    }
+
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable mCv;
+    std::vector<IterationStats> mEntries;
+    std::size_t mBegin{0};
+    std::size_t mSize{0};
+    std::uint64_t mNumDropped{0};
+};
+
+} // namespace tensorrt_llm::executor
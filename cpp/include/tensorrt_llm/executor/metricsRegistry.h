@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::executor::metrics
+{
+
+namespace detail
+{
+inline void atomicAdd(std::atomic<double>& target, double value) noexcept
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+inline void writeValue(std::ostream& os, double value)
+{
+    if (value == std::numeric_limits<double>::infinity())
+    {
+        os << "+Inf";
+    }
+    else
+    {
+        os << std::setprecision(std::numeric_limits<double>::digits10) << value;
+    }
+}
+} // namespace detail
+
+/// @brief Monotonic value, e.g. a number of tokens
+class Counter
+{
+public:
+    void increment(double value = 1.) noexcept
+    {
+        detail::atomicAdd(mValue, value);
+    }
+
+    [[nodiscard]] double getValue() const noexcept
+    {
+        return mValue.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> mValue{0.};
+};
+
+/// @brief Value that goes up and down, e.g. a queue depth
+class Gauge
+{
+public:
+    void set(double value) noexcept
+    {
+        mValue.store(value, std::memory_order_relaxed);
+    }
+
+    void add(double value) noexcept
+    {
+        detail::atomicAdd(mValue, value);
+    }
+
+    [[nodiscard]] double getValue() const noexcept
+    {
+        return mValue.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> mValue{0.};
+};
+
+/// @brief Distribution of observations in fixed buckets, e.g. latencies
+class Histogram
+{
+public:
+    /// @param upperBounds Inclusive upper bounds of the buckets, ascending. The +Inf bucket is implicit
+    explicit Histogram(std::vector<double> upperBounds)
+        : mUpperBounds{std::move(upperBounds)}
+        , mBucketCounts(mUpperBounds.size() + 1)
+    {
+        TLLM_CHECK_WITH_INFO(std::is_sorted(mUpperBounds.begin(), mUpperBounds.end()),
+            "Histogram bucket bounds must be ascending");
+    }
+
+    void observe(double value) noexcept
+    {
+        auto const bucket = std::lower_bound(mUpperBounds.begin(), mUpperBounds.end(), value) - mUpperBounds.begin();
+        mBucketCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+        detail::atomicAdd(mSum, value);
+    }
+
+    [[nodiscard]] std::vector<double> const& getUpperBounds() const noexcept
+    {
+        return mUpperBounds;
+    }
+
+    /// @brief Observations per bucket, not cumulative, the last one is the +Inf bucket
+    [[nodiscard]] std::vector<std::uint64_t> getBucketCounts() const
+    {
+        std::vector<std::uint64_t> counts(mBucketCounts.size());
+        for (std::size_t i = 0; i < counts.size(); ++i)
+        {
+            counts[i] = mBucketCounts[i].load(std::memory_order_relaxed);
+        }
+        return counts;
+    }
+
+    [[nodiscard]] double getSum() const noexcept
+    {
+        return mSum.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Bounds growing geometrically from start, count of them
+    [[nodiscard]] static std::vector<double> exponentialBounds(double start, double factor, std::size_t count)
+    {
+        std::vector<double> bounds(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            bounds[i] = i == 0 ? start : bounds[i - 1] * factor;
+        }
+        return bounds;
+    }
+
+private:
+    std::vector<double> mUpperBounds;
+    std::vector<std::atomic<std::uint64_t>> mBucketCounts;
+    std::atomic<double> mSum{0.};
+};
+
+/// @brief Named metrics rendered in the Prometheus text exposition format
+/// @details Metrics are registered once, under a mutex, and the returned references stay valid for the lifetime of the
+/// registry. Updates through the references are atomic and take no lock, so they can be made on the hot path. A
+/// metric is identified by its name and its labels, e.g. `tag="kv_cache",memory_type="GPU"`, the metrics of the same
+/// name form a family that shares the help text and the type.
+class MetricsRegistry
+{
+public:
+    Counter& getCounter(std::string const& name, std::string const& help, std::string const& labels = "")
+    {
+        return getMetric<Counter>(name, help, Type::kCounter, labels, [] { return std::make_unique<Counter>(); });
+    }
+
+    Gauge& getGauge(std::string const& name, std::string const& help, std::string const& labels = "")
+    {
+        return getMetric<Gauge>(name, help, Type::kGauge, labels, [] { return std::make_unique<Gauge>(); });
+    }
+
+    Histogram& getHistogram(std::string const& name, std::string const& help, std::vector<double> const& upperBounds,
+        std::string const& labels = "")
+    {
+        return getMetric<Histogram>(
+            name, help, Type::kHistogram, labels, [&upperBounds] { return std::make_unique<Histogram>(upperBounds); });
+    }
+
+    /// @brief All metrics in the Prometheus text exposition format, version 0.0.4
+    [[nodiscard]] std::string render() const
+    {
+        std::ostringstream os;
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto const& [name, family] : mFamilies)
+        {
+            os << "# HELP " << name << " " << family.help << "\n";
+            os << "# TYPE " << name << " " << toString(family.type) << "\n";
+            for (auto const& [labels, metric] : family.metrics)
+            {
+                if (family.type == Type::kHistogram)
+                {
+                    renderHistogram(os, name, labels, *static_cast<Histogram const*>(metric.get()));
+                    continue;
+                }
+                os << name << (labels.empty() ? "" : "{" + labels + "}") << " ";
+                detail::writeValue(os,
+                    family.type == Type::kCounter ? static_cast<Counter const*>(metric.get())->getValue()
+                                                  : static_cast<Gauge const*>(metric.get())->getValue());
+                os << "\n";
+            }
+        }
+        return os.str();
+    }
+
+private:
+    enum class Type
+    {
+        kCounter,
+        kGauge,
+        kHistogram
+    };
+
+    struct Family
+    {
+        std::string help;
+        Type type;
+        std::map<std::string, std::shared_ptr<void>> metrics;
+    };
+
+    static char const* toString(Type type)
+    {
+        switch (type)
+        {
+        case Type::kCounter: return "counter";
+        case Type::kGauge: return "gauge";
+        case Type::kHistogram: return "histogram";
+        }
+        return "untyped";
+    }
+
+    template <typename T, typename Factory>
+    T& getMetric(std::string const& name, std::string const& help, Type type, std::string const& labels,
+        Factory const& factory)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& family = mFamilies.try_emplace(name, Family{help, type, {}}).first->second;
+        TLLM_CHECK_WITH_INFO(family.type == type, "Metric %s is registered with another type", name.c_str());
+        auto& metric = family.metrics[labels];
+        if (!metric)
+        {
+            metric = std::shared_ptr<T>{factory()};
+        }
+        return *static_cast<T*>(metric.get());
+    }
+
+    static void renderHistogram(
+        std::ostream& os, std::string const& name, std::string const& labels, Histogram const& histogram)
+    {
+        auto const& upperBounds = histogram.getUpperBounds();
+        auto const counts = histogram.getBucketCounts();
+        auto const prefix = labels.empty() ? std::string{} : labels + ",";
+        std::uint64_t cumulative{0};
+        for (std::size_t i = 0; i < counts.size(); ++i)
+        {
+            cumulative += counts[i];
+            os << name << "_bucket{" << prefix << "le=\"";
+            detail::writeValue(os, i < upperBounds.size() ? upperBounds[i] : std::numeric_limits<double>::infinity());
+            os << "\"} " << cumulative << "\n";
+        }
+        auto const suffix = labels.empty() ? std::string{} : "{" + labels + "}";
+        os << name << "_sum" << suffix << " ";
+        detail::writeValue(os, histogram.getSum());
+        os << "\n" << name << "_count" << suffix << " " << cumulative << "\n";
+    }
+
+    mutable std::mutex mMutex;
+    std::map<std::string, Family> mFamilies;
+};
+
+/// @brief Serving metrics of an executor, fed from the IterationStats and the RequestPerfMetrics it produces
+/// @details observeIteration and observeRequest only touch atomics registered in the constructor. Scrape render() from
+/// an HTTP handler of the serving frontend, or any other exporter, at the scrape interval.
+class ExecutorMetrics
+{
+public:
+    ExecutorMetrics()
+        : mQueueDepth{mRegistry.getGauge("trtllm_queued_requests", "Requests waiting to be scheduled")}
+        , mActiveRequests{mRegistry.getGauge("trtllm_active_requests", "Requests in flight")}
+        , mMaxActiveRequests{mRegistry.getGauge("trtllm_max_active_requests", "Maximum number of requests in flight")}
+        , mIterations{mRegistry.getCounter("trtllm_iterations_total", "Executed iterations")}
+        , mIterationLatency{mRegistry.getHistogram("trtllm_iteration_latency_seconds", "Latency of the iterations",
+              Histogram::exponentialBounds(1e-3, 2., 14))}
+        , mContextTokens{mRegistry.getCounter("trtllm_context_tokens_total", "Prompt tokens processed")}
+        , mGeneratedTokens{mRegistry.getCounter("trtllm_generated_tokens_total", "Tokens generated")}
+        , mTokensPerSecond{mRegistry.getGauge(
+              "trtllm_tokens_per_second", "Prompt and generated tokens per second of the last iteration")}
+        , mKvMaxBlocks{mRegistry.getGauge("trtllm_kv_cache_max_blocks", "Blocks of the KV cache")}
+        , mKvFreeBlocks{mRegistry.getGauge("trtllm_kv_cache_free_blocks", "Free blocks of the KV cache")}
+        , mKvUsedBlocks{mRegistry.getGauge("trtllm_kv_cache_used_blocks", "Used blocks of the KV cache")}
+        , mKvReusedBlocks{mRegistry.getCounter("trtllm_kv_cache_reused_blocks_total", "Blocks reused from the cache")}
+        , mKvHitRate{
+              mRegistry.getGauge("trtllm_kv_cache_hit_rate", "Fraction of allocated blocks taken from the cache")}
+        , mDraftTokens{mRegistry.getCounter("trtllm_spec_decoding_draft_tokens_total", "Draft tokens proposed")}
+        , mAcceptedTokens{
+              mRegistry.getCounter("trtllm_spec_decoding_accepted_tokens_total", "Draft tokens accepted by the target")}
+        , mTimeToFirstToken{mRegistry.getHistogram("trtllm_time_to_first_token_seconds",
+              "Time from the arrival of a request to its first token", Histogram::exponentialBounds(1e-2, 2., 12))}
+        , mInterTokenLatency{mRegistry.getHistogram("trtllm_inter_token_latency_seconds",
+              "Mean time between the tokens of a request after the first", Histogram::exponentialBounds(1e-3, 2., 12))}
+        , mEndToEndLatency{mRegistry.getHistogram("trtllm_e2e_request_latency_seconds",
+              "Time from the arrival of a request to its completion", Histogram::exponentialBounds(1e-1, 2., 12))}
+        , mQueueTime{mRegistry.getHistogram("trtllm_request_queue_time_seconds",
+              "Time from the arrival of a request to its first scheduling", Histogram::exponentialBounds(1e-3, 2., 14))}
+    {
+    }
+
+    [[nodiscard]] MetricsRegistry& getRegistry() noexcept
+    {
+        return mRegistry;
+    }
+
+    /// @brief Requests enqueued but not scheduled yet, not part of IterationStats
+    void setQueueDepth(SizeType numQueuedRequests) noexcept
+    {
+        mQueueDepth.set(numQueuedRequests);
+    }
+
+    void observeIteration(IterationStats const& stats) noexcept
+    {
+        mIterations.increment();
+        mActiveRequests.set(stats.numActiveRequests);
+        mMaxActiveRequests.set(stats.maxNumActiveRequests);
+        mIterationLatency.observe(stats.iterLatencyMs * 1e-3);
+
+        auto const& batch = stats.inflightBatchingStats;
+        auto const& spec = stats.specDecodingStats;
+        // A context request that completes its prompt produces its first token, accepted drafts are extra tokens
+        auto const generatedTokens
+            = static_cast<double>(batch.numGenRequests + batch.numContextRequests + spec.numAcceptedTokens);
+        mContextTokens.increment(batch.numCtxTokens);
+        mGeneratedTokens.increment(generatedTokens);
+        mTokensPerSecond.set(
+            stats.iterLatencyMs > 0.f ? (batch.numCtxTokens + generatedTokens) / (stats.iterLatencyMs * 1e-3) : 0.);
+
+        auto const& kv = stats.kvCacheStats;
+        mKvMaxBlocks.set(kv.maxNumBlocks);
+        mKvFreeBlocks.set(kv.freeNumBlocks);
+        mKvUsedBlocks.set(kv.usedNumBlocks);
+        mKvHitRate.set(kv.cacheHitRate);
+        // The reused blocks are counted since the start of the executor
+        auto const previousReused = mLastReusedBlocks.exchange(kv.reusedBlocks, std::memory_order_relaxed);
+        if (kv.reusedBlocks > previousReused)
+        {
+            mKvReusedBlocks.increment(static_cast<double>(kv.reusedBlocks - previousReused));
+        }
+
+        mDraftTokens.increment(static_cast<double>(spec.numDraftTokens));
+        mAcceptedTokens.increment(static_cast<double>(spec.numAcceptedTokens));
+    }
+
+    /// @brief Record the latencies of a completed request
+    void observeRequest(RequestPerfMetrics const& metrics) noexcept
+    {
+        auto const observeMs = [](Histogram& histogram, std::optional<FloatType> valueMs)
+        {
+            if (valueMs)
+            {
+                histogram.observe(*valueMs * 1e-3);
+            }
+        };
+        observeMs(mQueueTime, metrics.getQueueTimeMs());
+        observeMs(mTimeToFirstToken, metrics.getTimeToFirstTokenMs());
+        observeMs(mInterTokenLatency, metrics.getMeanInterTokenLatencyMs());
+        observeMs(mEndToEndLatency, metrics.getEndToEndLatencyMs());
+    }
+
+    /// @brief Current and peak memory of each tag of the memory counters
+    /// @details Registers the gauges of the tags seen for the first time, call it at the scrape interval rather than
+    /// per iteration
+    void observeMemory(runtime::MemoryCounters const& counters)
+    {
+        for (auto const& tagStats : counters.getTagStats())
+        {
+            auto const memoryLabels
+                = "tag=\"" + tagStats.name + "\",memory_type=\"" + toString(tagStats.memoryType) + "\"";
+            mRegistry.getGauge("trtllm_memory_bytes", "Memory allocated per tag", memoryLabels)
+                .set(static_cast<double>(tagStats.current));
+            mRegistry.getGauge("trtllm_memory_peak_bytes", "Peak memory allocated per tag", memoryLabels)
+                .set(static_cast<double>(tagStats.peak));
+        }
+    }
+
+    /// @brief All metrics in the Prometheus text exposition format
+    [[nodiscard]] std::string render() const
+    {
+        return mRegistry.render();
+    }
+
+private:
+    static char const* toString(runtime::MemoryType memoryType)
+    {
+        switch (memoryType)
+        {
+        case runtime::MemoryType::kGPU: return runtime::MemoryTypeString<runtime::MemoryType::kGPU>::value;
+        case runtime::MemoryType::kCPU: return runtime::MemoryTypeString<runtime::MemoryType::kCPU>::value;
+        case runtime::MemoryType::kPINNED: return runtime::MemoryTypeString<runtime::MemoryType::kPINNED>::value;
+        case runtime::MemoryType::kUVM: return runtime::MemoryTypeString<runtime::MemoryType::kUVM>::value;
+        }
+        return "unknown";
+    }
+
+    MetricsRegistry mRegistry;
+    Gauge& mQueueDepth;
+    Gauge& mActiveRequests;
+    Gauge& mMaxActiveRequests;
+    Counter& mIterations;
+    Histogram& mIterationLatency;
+    Counter& mContextTokens;
+    Counter& mGeneratedTokens;
+    Gauge& mTokensPerSecond;
+    Gauge& mKvMaxBlocks;
+    Gauge& mKvFreeBlocks;
+    Gauge& mKvUsedBlocks;
+    Counter& mKvReusedBlocks;
+    Gauge& mKvHitRate;
+    Counter& mDraftTokens;
+    Counter& mAcceptedTokens;
+    Histogram& mTimeToFirstToken;
+    Histogram& mInterTokenLatency;
+    Histogram& mEndToEndLatency;
+    Histogram& mQueueTime;
+    std::atomic<std::uint64_t> mLastReusedBlocks{0};
+};
+
+} // namespace tensorrt_llm::executor::metrics
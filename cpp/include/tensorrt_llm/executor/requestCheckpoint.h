@@ -0,0 +1,565 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+namespace detail
+{
+
+//! \brief Appends trivially copyable values to a byte blob.
+class BlobWriter
+{
+public:
+    template <typename T>
+    void write(T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto const* bytes = reinterpret_cast<char const*>(&value);
+        mBlob.insert(mBlob.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    void write(std::optional<T> const& value)
+    {
+        write(value.has_value());
+        if (value)
+        {
+            write(*value);
+        }
+    }
+
+    template <typename T>
+    void write(std::vector<T> const& values)
+    {
+        write(static_cast<std::uint64_t>(values.size()));
+        for (auto const& value : values)
+        {
+            write(value);
+        }
+    }
+
+    template <typename T>
+    void write(std::list<T> const& values)
+    {
+        write(std::vector<T>(values.begin(), values.end()));
+    }
+
+    [[nodiscard]] std::vector<char> release()
+    {
+        return std::move(mBlob);
+    }
+
+private:
+    std::vector<char> mBlob;
+};
+
+//! \brief Reads back the values of a BlobWriter in the same order.
+class BlobReader
+{
+public:
+    explicit BlobReader(std::vector<char> const& blob)
+        : mBlob{blob}
+    {
+    }
+
+    template <typename T>
+    T read()
+    {
+        if constexpr (std::is_trivially_copyable_v<T>)
+        {
+            TLLM_CHECK_WITH_INFO(mPos + sizeof(T) <= mBlob.size(), "Truncated request checkpoint");
+            T value;
+            std::memcpy(&value, mBlob.data() + mPos, sizeof(T));
+            mPos += sizeof(T);
+            return value;
+        }
+        else
+        {
+            T value;
+            read(value);
+            return value;
+        }
+    }
+
+    [[nodiscard]] bool done() const noexcept
+    {
+        return mPos == mBlob.size();
+    }
+
+private:
+    template <typename T>
+    void read(std::optional<T>& value)
+    {
+        if (read<bool>())
+        {
+            value = read<T>();
+        }
+    }
+
+    template <typename T>
+    void read(std::vector<T>& values)
+    {
+        auto const size = read<std::uint64_t>();
+        TLLM_CHECK_WITH_INFO(size <= mBlob.size() - mPos, "Truncated request checkpoint");
+        values.reserve(size);
+        for (std::uint64_t i = 0; i < size; ++i)
+        {
+            values.emplace_back(read<T>());
+        }
+    }
+
+    template <typename T>
+    void read(std::list<T>& values)
+    {
+        auto const vector = read<std::vector<T>>();
+        values.assign(vector.begin(), vector.end());
+    }
+
+    std::vector<char> const& mBlob;
+    std::size_t mPos{0};
+};
+
+} // namespace detail
+
+/// @brief Portable snapshot of a request in flight: its parameters, the tokens it generated so far and the state of
+/// its random number generator
+/// @details A checkpoint resumes on any executor of the same model as a request whose prompt is the original prompt
+/// followed by the generated tokens and which generates the remaining tokens. The KV cache of that prefix is
+/// recomputed by the context phase of the resumed request, or reused from the KV cache blocks of the executor,
+/// including blocks offloaded to the host, when block reuse is enabled in its KvCacheConfig and the blocks are still
+/// cached, e.g. when a request is checkpointed and resumed on the same executor.
+/// Tensor-valued parameters (embedding bias, prompt tuning and LoRA configs) are not part of the checkpoint and have
+/// to be set again on the Request returned by toResumeRequest. Only beam width 1 is supported.
+struct RequestCheckpoint
+{
+    /// @brief Prompt of the original request
+    VecTokens inputTokenIds;
+    /// @brief Tokens generated before the checkpoint, excluding the prompt
+    VecTokens generatedTokenIds;
+    /// @brief Maximum number of new tokens of the original request, counting the generated tokens
+    SizeType maxNewTokens{0};
+    bool streaming{false};
+    SamplingConfig samplingConfig{};
+    OutputConfig outputConfig{};
+    std::optional<SizeType> endId{std::nullopt};
+    std::optional<SizeType> padId{std::nullopt};
+    std::optional<std::list<VecTokens>> badWords{std::nullopt};
+    std::optional<std::list<VecTokens>> stopWords{std::nullopt};
+    /// @brief Number of random numbers the sampling of the request drew so far, i.e. the Philox counter of its random
+    /// state, which together with the random seed of samplingConfig is the complete random state
+    std::uint64_t numRandomDraws{0};
+
+    static constexpr std::uint32_t kMagic = 0x4b435254; // "TRCK"
+    static constexpr std::uint32_t kVersion = 1;
+
+    /// @brief Checkpoint of a request that did not generate anything yet
+    static RequestCheckpoint fromRequest(Request const& request)
+    {
+        RequestCheckpoint checkpoint;
+        checkpoint.inputTokenIds = request.getInputTokenIds();
+        checkpoint.maxNewTokens = request.getMaxNewTokens();
+        checkpoint.streaming = request.getStreaming();
+        checkpoint.samplingConfig = request.getSamplingConfig();
+        checkpoint.outputConfig = request.getOutputConfig();
+        checkpoint.endId = request.getEndId();
+        checkpoint.padId = request.getPadId();
+        checkpoint.badWords = request.getBadWords();
+        checkpoint.stopWords = request.getStopWords();
+        return checkpoint;
+    }
+
+    /// @brief Number of tokens the resumed request may still generate
+    [[nodiscard]] SizeType getRemainingTokens() const
+    {
+        return maxNewTokens - static_cast<SizeType>(generatedTokenIds.size());
+    }
+
+    /// @brief Build the request that continues the checkpointed one
+    /// @details The resumed request has the generated tokens appended to its prompt. With excludeInputFromOutput its
+    /// results only hold the tokens generated after the checkpoint. The random seed is derived from the seed and the
+    /// number of draws of the checkpoint, so a resumed request samples reproducibly but not the same random numbers
+    /// an uninterrupted one would have drawn, since the Executor API does not take the Philox counter.
+    [[nodiscard]] Request toResumeRequest() const
+    {
+        TLLM_CHECK_WITH_INFO(getRemainingTokens() > 0, "The checkpointed request has no tokens left to generate");
+        auto tokens = inputTokenIds;
+        tokens.insert(tokens.end(), generatedTokenIds.begin(), generatedTokenIds.end());
+
+        auto const numGenerated = static_cast<SizeType>(generatedTokenIds.size());
+        auto const& sc = samplingConfig;
+        auto randomSeed = sc.getRandomSeed();
+        if (randomSeed && numRandomDraws > 0)
+        {
+            randomSeed = mixSeed(*randomSeed, numRandomDraws);
+        }
+        auto minLength = sc.getMinLength();
+        if (minLength)
+        {
+            minLength = std::max(*minLength - numGenerated, 0);
+        }
+        SamplingConfig resumedConfig{sc.getBeamWidth(), sc.getTopK(), sc.getTopP(), sc.getTopPMin(),
+            sc.getTopPResetIds(), sc.getTopPDecay(), randomSeed, sc.getTemperature(), minLength,
+            sc.getBeamSearchDiversityRate(), sc.getRepetitionPenalty(), sc.getPresencePenalty(),
+            sc.getFrequencyPenalty(), sc.getLengthPenalty(), sc.getEarlyStopping()};
+        return Request{std::move(tokens), getRemainingTokens(), streaming, std::move(resumedConfig), outputConfig,
+            endId, padId, badWords, stopWords};
+    }
+
+    [[nodiscard]] std::vector<char> serialize() const
+    {
+        detail::BlobWriter writer;
+        writer.write(kMagic);
+        writer.write(kVersion);
+        writer.write(inputTokenIds);
+        writer.write(generatedTokenIds);
+        writer.write(maxNewTokens);
+        writer.write(streaming);
+        auto const& sc = samplingConfig;
+        writer.write(sc.getBeamWidth());
+        writer.write(sc.getTopK());
+        writer.write(sc.getTopP());
+        writer.write(sc.getTopPMin());
+        writer.write(sc.getTopPResetIds());
+        writer.write(sc.getTopPDecay());
+        writer.write(sc.getRandomSeed());
+        writer.write(sc.getTemperature());
+        writer.write(sc.getMinLength());
+        writer.write(sc.getBeamSearchDiversityRate());
+        writer.write(sc.getRepetitionPenalty());
+        writer.write(sc.getPresencePenalty());
+        writer.write(sc.getFrequencyPenalty());
+        writer.write(sc.getLengthPenalty());
+        writer.write(sc.getEarlyStopping());
+        writer.write(outputConfig);
+        writer.write(endId);
+        writer.write(padId);
+        writer.write(badWords);
+        writer.write(stopWords);
+        writer.write(numRandomDraws);
+        return writer.release();
+    }
+
+    [[nodiscard]] static RequestCheckpoint deserialize(std::vector<char> const& blob)
+    {
+        detail::BlobReader reader{blob};
+        TLLM_CHECK_WITH_INFO(reader.read<std::uint32_t>() == kMagic, "Not a request checkpoint");
+        auto const version = reader.read<std::uint32_t>();
+        TLLM_CHECK_WITH_INFO(version == kVersion, "Unsupported request checkpoint version %u", version);
+
+        RequestCheckpoint checkpoint;
+        checkpoint.inputTokenIds = reader.read<VecTokens>();
+        checkpoint.generatedTokenIds = reader.read<VecTokens>();
+        checkpoint.maxNewTokens = reader.read<SizeType>();
+        checkpoint.streaming = reader.read<bool>();
+        // Function arguments are evaluated in an unspecified order, so read the fields one by one.
+        auto const beamWidth = reader.read<SizeType>();
+        auto const topK = reader.read<std::optional<SizeType>>();
+        auto const topP = reader.read<std::optional<FloatType>>();
+        auto const topPMin = reader.read<std::optional<FloatType>>();
+        auto const topPResetIds = reader.read<std::optional<SizeType>>();
+        auto const topPDecay = reader.read<std::optional<FloatType>>();
+        auto const randomSeed = reader.read<std::optional<RandomSeedType>>();
+        auto const temperature = reader.read<std::optional<FloatType>>();
+        auto const minLength = reader.read<std::optional<SizeType>>();
+        auto const beamSearchDiversityRate = reader.read<std::optional<FloatType>>();
+        auto const repetitionPenalty = reader.read<std::optional<FloatType>>();
+        auto const presencePenalty = reader.read<std::optional<FloatType>>();
+        auto const frequencyPenalty = reader.read<std::optional<FloatType>>();
+        auto const lengthPenalty = reader.read<std::optional<FloatType>>();
+        auto const earlyStopping = reader.read<std::optional<SizeType>>();
+        checkpoint.samplingConfig = SamplingConfig{beamWidth, topK, topP, topPMin, topPResetIds, topPDecay,
+            randomSeed, temperature, minLength, beamSearchDiversityRate, repetitionPenalty, presencePenalty,
+            frequencyPenalty, lengthPenalty, earlyStopping};
+        checkpoint.outputConfig = reader.read<OutputConfig>();
+        checkpoint.endId = reader.read<std::optional<SizeType>>();
+        checkpoint.padId = reader.read<std::optional<SizeType>>();
+        checkpoint.badWords = reader.read<std::optional<std::list<VecTokens>>>();
+        checkpoint.stopWords = reader.read<std::optional<std::list<VecTokens>>>();
+        checkpoint.numRandomDraws = reader.read<std::uint64_t>();
+        TLLM_CHECK_WITH_INFO(reader.done(), "Trailing bytes after the request checkpoint");
+        return checkpoint;
+    }
+
+private:
+    //! \brief splitmix64 finalizer of the seed and the number of draws.
+    [[nodiscard]] static RandomSeedType mixSeed(RandomSeedType seed, std::uint64_t numDraws)
+    {
+        auto z = seed + 0x9e3779b97f4a7c15ULL * (numDraws + 1);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+};
+
+/// @brief Tracks the requests of an Executor so that they can be checkpointed and resumed, e.g. to drain an
+/// executor gracefully or to migrate its requests to another one
+/// @details Requests and responses go through this object, which records the tokens of the streamed responses.
+/// Non-streaming requests are checkpointed with the tokens of their last response, i.e. none before they finish.
+/// A resumed request keeps the tokens of its checkpoint, so it can be checkpointed again.
+class RequestCheckpointer
+{
+public:
+    /// @param executor The executor whose requests are tracked, must outlive this object
+    explicit RequestCheckpointer(Executor& executor)
+        : mExecutor{executor}
+    {
+    }
+
+    RequestCheckpointer(RequestCheckpointer const&) = delete;
+    RequestCheckpointer& operator=(RequestCheckpointer const&) = delete;
+
+    /// @brief Enqueue a new request
+    /// @return The id of the request in the executor
+    IdType enqueueRequest(Request request)
+    {
+        return track(RequestCheckpoint::fromRequest(request), std::move(request));
+    }
+
+    /// @brief Resume a checkpoint on the executor, see RequestCheckpoint::toResumeRequest
+    /// @return The id of the resumed request in the executor
+    IdType resume(RequestCheckpoint checkpoint)
+    {
+        auto request = checkpoint.toResumeRequest();
+        return track(std::move(checkpoint), std::move(request));
+    }
+
+    /// @brief Resume a serialized checkpoint on the executor
+    IdType resume(std::vector<char> const& blob)
+    {
+        return resume(RequestCheckpoint::deserialize(blob));
+    }
+
+    /// @brief Await ready responses of the executor and record their tokens, same arguments as
+    /// Executor::awaitResponses
+    std::vector<Response> awaitResponses(
+        std::optional<IdType> id = std::nullopt, std::optional<std::chrono::milliseconds> timeout = std::nullopt)
+    {
+        {
+            std::lock_guard lock(mMutex);
+            auto responses = takeDrained(id);
+            if (!responses.empty())
+            {
+                return responses;
+            }
+        }
+        auto responses = mExecutor.awaitResponses(id, timeout);
+        std::lock_guard lock(mMutex);
+        for (auto const& response : responses)
+        {
+            record(response);
+        }
+        return responses;
+    }
+
+    /// @brief Snapshot the request with the given id, the request keeps running
+    [[nodiscard]] std::optional<RequestCheckpoint> checkpoint(IdType id)
+    {
+        std::lock_guard lock(mMutex);
+        auto it = mRequests.find(id);
+        if (it == mRequests.end())
+        {
+            return std::nullopt;
+        }
+        return it->second.checkpoint;
+    }
+
+    /// @brief Cancel all requests in flight and checkpoint the ones that did not complete
+    /// @details Waits up to timeout for the final responses of the cancelled requests. Their responses are returned
+    /// by the following calls of awaitResponses. Requests without a final response by then are checkpointed with the
+    /// tokens seen so far.
+    /// @return The checkpoints by request id
+    [[nodiscard]] std::unordered_map<IdType, RequestCheckpoint> drain(
+        std::chrono::milliseconds timeout = std::chrono::milliseconds{1000})
+    {
+        std::vector<IdType> ids;
+        {
+            std::lock_guard lock(mMutex);
+            for (auto const& [id, state] : mRequests)
+            {
+                ids.push_back(id);
+            }
+        }
+        for (auto const id : ids)
+        {
+            mExecutor.cancelRequest(id);
+        }
+
+        std::unordered_map<IdType, RequestCheckpoint> checkpoints;
+        auto const deadline = std::chrono::steady_clock::now() + timeout;
+        for (auto const id : ids)
+        {
+            auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            auto responses = mExecutor.awaitResponses(id, std::max(remaining, std::chrono::milliseconds{0}));
+            std::lock_guard lock(mMutex);
+            for (auto& response : responses)
+            {
+                if (auto cut = record(response, true))
+                {
+                    checkpoints.emplace(id, std::move(*cut));
+                }
+                mDrained.emplace_back(std::move(response));
+            }
+            if (auto it = mRequests.find(id); it != mRequests.end())
+            {
+                checkpoints.emplace(id, std::move(it->second.checkpoint));
+                mRequests.erase(it);
+            }
+        }
+        return checkpoints;
+    }
+
+    /// @brief Number of tracked requests in flight
+    [[nodiscard]] std::size_t getNumRequests()
+    {
+        std::lock_guard lock(mMutex);
+        return mRequests.size();
+    }
+
+private:
+    struct RequestState
+    {
+        RequestCheckpoint checkpoint;
+        // Number of generated tokens of the checkpoint the request was resumed from
+        SizeType numResumedTokens{0};
+    };
+
+    IdType track(RequestCheckpoint checkpoint, Request request)
+    {
+        TLLM_CHECK_WITH_INFO(request.getSamplingConfig().getBeamWidth() <= 1,
+            "Checkpointing does not support beam search");
+        std::lock_guard lock(mMutex);
+        auto const id = mExecutor.enqueueRequest(std::move(request));
+        auto const numResumedTokens = static_cast<SizeType>(checkpoint.generatedTokenIds.size());
+        mRequests.emplace(id, RequestState{std::move(checkpoint), numResumedTokens});
+        return id;
+    }
+
+    //! \brief Record the tokens of a response. Returns the checkpoint of a request cut short by cancellation when
+    //! draining, i.e. whose final response arrived before it hit its end id, a stop word or maxNewTokens.
+    std::optional<RequestCheckpoint> record(Response const& response, bool draining = false)
+    {
+        auto it = mRequests.find(response.getRequestId());
+        if (it == mRequests.end())
+        {
+            return std::nullopt;
+        }
+        auto& state = it->second;
+        auto& checkpoint = state.checkpoint;
+        if (response.hasError())
+        {
+            mRequests.erase(it);
+            return std::nullopt;
+        }
+        auto const result = response.getResult();
+        auto const& tokens = result.outputTokenIds.at(0);
+        auto newBegin = tokens.begin();
+        if (!checkpoint.outputConfig.excludeInputFromOutput
+            && static_cast<SizeType>(checkpoint.generatedTokenIds.size()) == state.numResumedTokens)
+        {
+            // The first output of a request with its input holds the prompt of the executor request.
+            auto const numInput = checkpoint.inputTokenIds.size() + state.numResumedTokens;
+            if (tokens.size() >= numInput)
+            {
+                newBegin += static_cast<std::ptrdiff_t>(numInput);
+            }
+        }
+        if (!checkpoint.streaming)
+        {
+            // Non-streaming results hold all tokens generated by the executor request.
+            checkpoint.generatedTokenIds.resize(state.numResumedTokens);
+        }
+        auto const numNew = std::min(static_cast<SizeType>(tokens.end() - newBegin), checkpoint.getRemainingTokens());
+        checkpoint.generatedTokenIds.insert(checkpoint.generatedTokenIds.end(), newBegin, newBegin + numNew);
+        checkpoint.numRandomDraws = checkpoint.generatedTokenIds.size();
+        if (!result.isFinal)
+        {
+            return std::nullopt;
+        }
+        auto node = mRequests.extract(it);
+        if (draining && !isComplete(node.mapped().checkpoint))
+        {
+            return std::move(node.mapped().checkpoint);
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] static bool isComplete(RequestCheckpoint const& checkpoint)
+    {
+        auto const& tokens = checkpoint.generatedTokenIds;
+        auto const hitEndId = checkpoint.endId && !tokens.empty() && tokens.back() == *checkpoint.endId;
+        if (checkpoint.getRemainingTokens() <= 0 || hitEndId)
+        {
+            return true;
+        }
+        if (!checkpoint.stopWords)
+        {
+            return false;
+        }
+        return std::any_of(checkpoint.stopWords->begin(), checkpoint.stopWords->end(),
+            [&tokens](VecTokens const& word)
+            {
+                return !word.empty() && word.size() <= tokens.size()
+                    && std::equal(word.rbegin(), word.rend(), tokens.rbegin());
+            });
+    }
+
+    //! \brief Responses collected by drain for the given request id, or for any request.
+    std::vector<Response> takeDrained(std::optional<IdType> id)
+    {
+        std::vector<Response> responses;
+        for (auto it = mDrained.begin(); it != mDrained.end();)
+        {
+            if (!id || it->getRequestId() == *id)
+            {
+                responses.emplace_back(std::move(*it));
+                it = mDrained.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return responses;
+    }
+
+    Executor& mExecutor;
+    std::mutex mMutex;
+    std::unordered_map<IdType, RequestState> mRequests;
+    // Responses awaited by drain and not yet returned by awaitResponses
+    std::deque<Response> mDrained;
+};
+
+} // namespace tensorrt_llm::executor
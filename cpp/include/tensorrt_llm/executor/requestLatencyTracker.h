@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/types.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Records the timestamps of the requests in flight and aggregates the latencies of the last completed
+/// requests into percentiles
+/// @details The timestamps are kept in a map keyed by request id, so that neither LlmRequest nor Result change their
+/// layout. The owner of the request loop calls arrive() on enqueue, markScheduled() when a context is scheduled,
+/// recordTokenStep() for every generation step and complete() with the final response.
+/// Keeps the samples of the last windowSize completed requests in preallocated storage, so add() never allocates.
+/// getStats() sorts a preallocated copy of the window, which is cheap for windows of a few thousand requests and is
+/// meant to be called once per iteration when the IterationStats are filled.
+class RequestLatencyTracker
+{
+public:
+    using TimePoint = RequestPerfMetrics::TimePoint;
+
+    explicit RequestLatencyTracker(std::size_t windowSize = 1024)
+        : mWindowSize{std::max<std::size_t>(windowSize, 1)}
+    {
+        for (auto& window : mWindows)
+        {
+            window.samples.resize(mWindowSize);
+        }
+        mScratch.reserve(mWindowSize);
+    }
+
+    /// @brief Start tracking a request
+    /// @param returnPerTokenTimes Record the time of every generation step, not only of the first and the last one
+    void arrive(IdType requestId, bool returnPerTokenTimes = false, TimePoint now = std::chrono::steady_clock::now())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& metrics = mInFlight[requestId];
+        metrics.arrivalTime = now;
+        if (returnPerTokenTimes)
+        {
+            metrics.tokenTimes.emplace();
+        }
+    }
+
+    /// @brief Record that the request was scheduled, only the first call has an effect
+    void markScheduled(IdType requestId, TimePoint now = std::chrono::steady_clock::now())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (auto* metrics = find(requestId); metrics != nullptr && !metrics->firstScheduledTime)
+        {
+            metrics->firstScheduledTime = now;
+        }
+    }
+
+    /// @brief Record a generation step of the request that produced tokens
+    void recordTokenStep(IdType requestId, TimePoint now = std::chrono::steady_clock::now())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto* metrics = find(requestId);
+        if (metrics == nullptr)
+        {
+            return;
+        }
+        if (!metrics->firstTokenTime)
+        {
+            metrics->firstTokenTime = now;
+        }
+        metrics->lastTokenTime = now;
+        ++metrics->numTokenSteps;
+        if (metrics->tokenTimes)
+        {
+            metrics->tokenTimes->push_back(now);
+        }
+    }
+
+    /// @brief Timestamps recorded so far for a request in flight
+    [[nodiscard]] std::optional<RequestPerfMetrics> getPerfMetrics(IdType requestId)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const* metrics = find(requestId);
+        return metrics != nullptr ? std::optional<RequestPerfMetrics>{*metrics} : std::nullopt;
+    }
+
+    /// @brief Stop tracking a request and add its latencies to the percentiles
+    /// @return The timestamps of the request, or nothing if it was not tracked
+    std::optional<RequestPerfMetrics> complete(IdType requestId, TimePoint now = std::chrono::steady_clock::now())
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mInFlight.find(requestId);
+        if (it == mInFlight.end())
+        {
+            return std::nullopt;
+        }
+        auto metrics = std::move(it->second);
+        mInFlight.erase(it);
+        metrics.completionTime = now;
+        addLocked(metrics);
+        return metrics;
+    }
+
+    /// @brief Add the metrics of a request completed without arrive()
+    void add(RequestPerfMetrics const& metrics)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        addLocked(metrics);
+    }
+
+    [[nodiscard]] std::size_t getNumInFlight()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mInFlight.size();
+    }
+
+    [[nodiscard]] RequestLatencyStats getStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        RequestLatencyStats stats;
+        stats.queueTimeMs = computePercentiles(mWindows[kQueueTime]);
+        stats.timeToFirstTokenMs = computePercentiles(mWindows[kTimeToFirstToken]);
+        stats.interTokenLatencyMs = computePercentiles(mWindows[kInterTokenLatency]);
+        stats.endToEndLatencyMs = computePercentiles(mWindows[kEndToEndLatency]);
+        return stats;
+    }
+
+private:
+    enum Metric
+    {
+        kQueueTime = 0,
+        kTimeToFirstToken,
+        kInterTokenLatency,
+        kEndToEndLatency,
+        kNumMetrics
+    };
+
+    struct Window
+    {
+        std::vector<FloatType> samples;
+        std::size_t next{0};
+        std::size_t size{0};
+
+        void add(std::optional<FloatType> sample, std::size_t capacity)
+        {
+            if (!sample)
+            {
+                return;
+            }
+            samples[next] = *sample;
+            next = (next + 1) % capacity;
+            size = std::min(size + 1, capacity);
+        }
+    };
+
+    [[nodiscard]] RequestPerfMetrics* find(IdType requestId)
+    {
+        auto it = mInFlight.find(requestId);
+        return it != mInFlight.end() ? &it->second : nullptr;
+    }
+
+    void addLocked(RequestPerfMetrics const& metrics)
+    {
+        mWindows[kQueueTime].add(metrics.getQueueTimeMs(), mWindowSize);
+        mWindows[kTimeToFirstToken].add(metrics.getTimeToFirstTokenMs(), mWindowSize);
+        mWindows[kInterTokenLatency].add(metrics.getMeanInterTokenLatencyMs(), mWindowSize);
+        mWindows[kEndToEndLatency].add(metrics.getEndToEndLatencyMs(), mWindowSize);
+    }
+
+    [[nodiscard]] LatencyPercentiles computePercentiles(Window const& window)
+    {
+        LatencyPercentiles percentiles;
+        percentiles.numSamples = static_cast<SizeType>(window.size);
+        if (window.size == 0)
+        {
+            return percentiles;
+        }
+        mScratch.assign(window.samples.begin(), window.samples.begin() + window.size);
+        std::sort(mScratch.begin(), mScratch.end());
+        auto const at = [this](double quantile)
+        { return mScratch[static_cast<std::size_t>(quantile * static_cast<double>(mScratch.size() - 1))]; };
+        percentiles.p50 = at(0.5);
+        percentiles.p90 = at(0.9);
+        percentiles.p99 = at(0.99);
+        percentiles.max = mScratch.back();
+        return percentiles;
+    }
+
+    std::size_t mWindowSize;
+    std::mutex mMutex;
+    std::array<Window, kNumMetrics> mWindows;
+    std::unordered_map<IdType, RequestPerfMetrics> mInFlight;
+    std::vector<FloatType> mScratch;
+};
+
+} // namespace tensorrt_llm::executor
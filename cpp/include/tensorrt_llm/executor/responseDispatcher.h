@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Delivers the responses of an Executor to a callback from a single thread
+/// @details Instead of polling awaitResponses or getNumResponsesReady per request id from several serving threads,
+/// one dispatcher thread waits for the responses of all requests and passes everything that became ready together,
+/// typically the responses of one iteration, to the callback in a single call. The callback runs on the dispatcher
+/// thread and should hand the responses off quickly.
+class ResponseDispatcher
+{
+public:
+    using ResponseCallback = std::function<void(std::vector<Response>&& responses)>;
+    /// @brief Waits up to the given timeout and returns the responses that are ready, like Executor::awaitResponses
+    using ResponseSource = std::function<std::vector<Response>(std::chrono::milliseconds timeout)>;
+
+    /// @param executor The executor whose responses are dispatched, must outlive the dispatcher
+    /// @param callback Called with each batch of ready responses
+    /// @param pollTimeout Maximum time to wait for responses before checking whether the dispatcher was stopped
+    ResponseDispatcher(Executor& executor, ResponseCallback callback,
+        std::chrono::milliseconds pollTimeout = std::chrono::milliseconds{100})
+        : ResponseDispatcher(
+            [&executor](std::chrono::milliseconds timeout) { return executor.awaitResponses(std::nullopt, timeout); },
+            std::move(callback), pollTimeout)
+    {
+    }
+
+    /// @param source Source of the responses, called from the dispatcher thread only
+    /// @param callback Called with each batch of ready responses
+    /// @param pollTimeout Maximum time to wait for responses before checking whether the dispatcher was stopped
+    ResponseDispatcher(ResponseSource source, ResponseCallback callback,
+        std::chrono::milliseconds pollTimeout = std::chrono::milliseconds{100})
+        : mSource{std::move(source)}
+        , mCallback{std::move(callback)}
+        , mPollTimeout{pollTimeout}
+        , mThread{[this]() { run(); }}
+    {
+    }
+
+    ~ResponseDispatcher()
+    {
+        stop();
+    }
+
+    ResponseDispatcher(ResponseDispatcher const&) = delete;
+    ResponseDispatcher& operator=(ResponseDispatcher const&) = delete;
+
+    /// @brief Stop dispatching and join the dispatcher thread, responses not yet dispatched stay in the executor
+    void stop()
+    {
+        mStopped = true;
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+    /// @brief Number of callback invocations so far
+    [[nodiscard]] std::uint64_t getNumBatches() const noexcept
+    {
+        return mNumBatches;
+    }
+
+    /// @brief Number of responses dispatched so far
+    [[nodiscard]] std::uint64_t getNumResponses() const noexcept
+    {
+        return mNumResponses;
+    }
+
+private:
+    void run()
+    {
+        while (!mStopped)
+        {
+            auto responses = mSource(mPollTimeout);
+            if (responses.empty())
+            {
+                continue;
+            }
+            ++mNumBatches;
+            mNumResponses += responses.size();
+            mCallback(std::move(responses));
+        }
+    }
+
+    ResponseSource mSource;
+    ResponseCallback mCallback;
+    std::chrono::milliseconds mPollTimeout;
+    std::atomic<bool> mStopped{false};
+    std::atomic<std::uint64_t> mNumBatches{0};
+    std::atomic<std::uint64_t> mNumResponses{0};
+    // Declared last so that it starts after all other members are initialized
+    std::thread mThread;
+};
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/tensor.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Configuration of draft/target speculative decoding run by a SpeculativeExecutor
+struct SpeculativeExecutorConfig
+{
+    /// @brief Number of tokens the draft model proposes per verification step, K
+    SizeType maxDraftTokens{4};
+    /// @brief Pass the draft logits to the target model, which then accepts drafts by logits (rejection sampling)
+    /// instead of by token ids
+    bool useDraftLogits{false};
+    /// @brief Acceptance threshold forwarded in the SpeculativeDecodingConfig of the target requests
+    std::optional<FloatType> acceptanceThreshold{std::nullopt};
+    /// @brief Maximum time the loop waits for one of the executors before checking for new work
+    std::chrono::milliseconds pollTimeout{1};
+};
+
+/// @brief Runs draft/target speculative decoding in process with a draft and a target Executor
+/// @details Clients enqueue regular requests. For every request the loop alternates K draft tokens generated by
+/// the draft executor with one step of the target executor that verifies them through its
+/// SpeculativeDecodingConfig and produces the accepted tokens plus one. Both executors keep their own in-flight
+/// batch, so the draft step of some requests overlaps with the verification step of others. The KV cache of
+/// rejected draft tokens is rewound inside the target executor, and with KV cache block reuse enabled in both
+/// ExecutorConfigs each step only recomputes the tokens added since the previous one.
+/// A request may bring its own DraftFunc instead of the draft executor, e.g. to benchmark a synthetic acceptance.
+/// Only beam width 1 is supported. The loop only uses the public Executor API, the applications create it on top of
+/// their executors, nothing in the library does.
+class SpeculativeExecutor
+{
+public:
+    /// @brief Proposes numDraftTokens draft tokens following tokens, the prompt and the tokens accepted so far. Called
+    /// on the thread of the loop, it may return fewer tokens.
+    using DraftFunc = std::function<VecTokens(VecTokens const& tokens, SizeType numDraftTokens)>;
+
+    /// @param draftExecutor Executor of the draft model, must outlive this object
+    /// @param targetExecutor Executor of the target model, must outlive this object
+    SpeculativeExecutor(Executor& draftExecutor, Executor& targetExecutor, SpeculativeExecutorConfig config = {})
+        : SpeculativeExecutor(&draftExecutor, targetExecutor, std::move(config))
+    {
+    }
+
+    /// @brief Without draft model, every request must be enqueued with its DraftFunc
+    /// @param targetExecutor Executor of the target model, must outlive this object
+    explicit SpeculativeExecutor(Executor& targetExecutor, SpeculativeExecutorConfig config = {})
+        : SpeculativeExecutor(nullptr, targetExecutor, std::move(config))
+    {
+    }
+
+    ~SpeculativeExecutor()
+    {
+        shutdown();
+    }
+
+    SpeculativeExecutor(SpeculativeExecutor const&) = delete;
+    SpeculativeExecutor& operator=(SpeculativeExecutor const&) = delete;
+
+    /// @brief Enqueue a new request
+    /// @param drafter Proposes the draft tokens of the request in place of the draft executor
+    /// @return A unique id that identifies the request in awaitResponses and cancelRequest
+    IdType enqueueRequest(Request request, DraftFunc drafter = nullptr)
+    {
+        TLLM_CHECK_WITH_INFO(request.getSamplingConfig().getBeamWidth() <= 1,
+            "Speculative decoding does not support beam search");
+        TLLM_CHECK_WITH_INFO(drafter || mDraftExecutor != nullptr, "A request needs a drafter without draft executor");
+        std::lock_guard lock(mMutex);
+        auto const id = ++mLastRequestId;
+        auto& state = mRequests.emplace(id, RequestState{std::move(request)}).first->second;
+        state.drafter = std::move(drafter);
+        state.tokens = state.request.getInputTokenIds();
+        mPending.push_back(id);
+        mWorkCv.notify_one();
+        return id;
+    }
+
+    /// @brief Await for ready responses
+    /// @param id An optional request id. If not specified, responses for any request can be returned
+    /// @param timeout The maximum time to wait for new responses
+    std::vector<Response> awaitResponses(
+        std::optional<IdType> id = std::nullopt, std::optional<std::chrono::milliseconds> timeout = std::nullopt)
+    {
+        std::unique_lock lock(mMutex);
+        auto const hasResponse = [this, &id]()
+        {
+            return mShutdown
+                || std::any_of(mResponses.begin(), mResponses.end(),
+                    [&id](Response const& r) { return !id || r.getRequestId() == *id; });
+        };
+        if (timeout)
+        {
+            mResponseCv.wait_for(lock, *timeout, hasResponse);
+        }
+        else
+        {
+            mResponseCv.wait(lock, hasResponse);
+        }
+        std::vector<Response> responses;
+        for (auto it = mResponses.begin(); it != mResponses.end();)
+        {
+            if (!id || it->getRequestId() == *id)
+            {
+                responses.emplace_back(std::move(*it));
+                it = mResponses.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return responses;
+    }
+
+    /// @brief Cancel the request with provided request id, its final response carries the tokens generated so far
+    void cancelRequest(IdType id)
+    {
+        std::lock_guard lock(mMutex);
+        if (auto it = mRequests.find(id); it != mRequests.end())
+        {
+            it->second.cancelled = true;
+        }
+    }
+
+    /// @brief Stop the loop, requests in flight are dropped
+    void shutdown()
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mShutdown = true;
+        }
+        mWorkCv.notify_all();
+        mResponseCv.notify_all();
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+    /// @brief Acceptance of draft tokens over all requests since the start
+    [[nodiscard]] SpeculativeDecodingStats getSpeculativeDecodingStats()
+    {
+        std::lock_guard lock(mMutex);
+        return mStats;
+    }
+
+    /// @brief Acceptance of draft tokens of a finished request
+    /// @details The stats are kept from the final response of the request until they are taken, so callers that
+    /// want them must take them once per request.
+    /// @return The stats, or nothing if the request is not finished or its stats were already taken
+    [[nodiscard]] std::optional<SpeculativeDecodingStats> takeRequestStats(IdType id)
+    {
+        std::lock_guard lock(mMutex);
+        auto node = mFinishedStats.extract(id);
+        return node.empty() ? std::nullopt : std::optional<SpeculativeDecodingStats>{node.mapped()};
+    }
+
+private:
+    SpeculativeExecutor(Executor* draftExecutor, Executor& targetExecutor, SpeculativeExecutorConfig config)
+        : mDraftExecutor{draftExecutor}
+        , mTargetExecutor{targetExecutor}
+        , mConfig{std::move(config)}
+        , mThread{[this]() { run(); }}
+    {
+        TLLM_CHECK_WITH_INFO(mConfig.maxDraftTokens > 0, "maxDraftTokens must be positive");
+    }
+
+    struct RequestState
+    {
+        Request request;
+        DraftFunc drafter{};
+        // Prompt followed by the tokens accepted so far
+        VecTokens tokens{};
+        SizeType numGenerated{0};
+        SizeType numDraftTokens{0};
+        SpeculativeDecodingStats stats{};
+        bool cancelled{false};
+    };
+
+    //! \brief Maximum number of tokens the request may still generate.
+    [[nodiscard]] static SizeType remainingTokens(RequestState const& state)
+    {
+        return state.request.getMaxNewTokens() - state.numGenerated;
+    }
+
+    //! \brief Submit a draft step, or a target step without drafts when at most one token remains.
+    void startStep(IdType id, RequestState& state)
+    {
+        state.numDraftTokens = std::min(mConfig.maxDraftTokens, remainingTokens(state) - 1);
+        if (state.numDraftTokens <= 0)
+        {
+            startTargetStep(id, state, {}, std::nullopt);
+            return;
+        }
+        if (state.drafter)
+        {
+            auto draftTokens = state.drafter(state.tokens, state.numDraftTokens);
+            if (static_cast<SizeType>(draftTokens.size()) > state.numDraftTokens)
+            {
+                draftTokens.resize(state.numDraftTokens);
+            }
+            startTargetStep(id, state, std::move(draftTokens), std::nullopt);
+            return;
+        }
+        OutputConfig outputConfig{};
+        outputConfig.excludeInputFromOutput = true;
+        outputConfig.returnGenerationLogits = mConfig.useDraftLogits;
+        Request draft{state.tokens, state.numDraftTokens, false, state.request.getSamplingConfig(), outputConfig,
+            state.request.getEndId(), state.request.getPadId()};
+        mDraftToRequest[mDraftExecutor->enqueueRequest(std::move(draft))] = id;
+    }
+
+    void startTargetStep(IdType id, RequestState& state, VecTokens draftTokens, std::optional<Tensor> draftLogits)
+    {
+        state.numDraftTokens = static_cast<SizeType>(draftTokens.size());
+        OutputConfig outputConfig{};
+        outputConfig.excludeInputFromOutput = true;
+        Request target{state.tokens, state.numDraftTokens + 1, false, state.request.getSamplingConfig(), outputConfig,
+            state.request.getEndId(), state.request.getPadId(), state.request.getBadWords(),
+            state.request.getStopWords(), state.request.getEmbeddingBias()};
+        if (!draftTokens.empty())
+        {
+            target.setSpeculativeDecodingConfig(
+                SpeculativeDecodingConfig{std::move(draftTokens), std::move(draftLogits), mConfig.acceptanceThreshold});
+        }
+        mTargetToRequest[mTargetExecutor.enqueueRequest(std::move(target))] = id;
+    }
+
+    //! \brief Generation logits of a draft response are [beamWidth, numTokens, vocabSize], drop the beam dimension.
+    [[nodiscard]] static std::optional<Tensor> draftLogits(Result const& result)
+    {
+        if (!result.generationLogits)
+        {
+            return std::nullopt;
+        }
+        auto const& logits = detail::toITensor(*result.generationLogits);
+        return detail::ofITensor(runtime::ITensor::view(logits, runtime::ITensor::squeeze(logits->getShape(), 0)));
+    }
+
+    //! \brief Stop words may span the tokens of several target steps, so they are matched on the whole output.
+    [[nodiscard]] static bool hitStopWord(RequestState const& state)
+    {
+        auto const stopWords = state.request.getStopWords();
+        if (!stopWords)
+        {
+            return false;
+        }
+        return std::any_of(stopWords->begin(), stopWords->end(),
+            [&state](VecTokens const& word)
+            {
+                return !word.empty() && static_cast<SizeType>(word.size()) <= state.numGenerated
+                    && std::equal(word.rbegin(), word.rend(), state.tokens.rbegin());
+            });
+    }
+
+    void finishRequest(IdType id, RequestState& state, std::optional<std::string> errorMsg = std::nullopt)
+    {
+        if (errorMsg)
+        {
+            mResponses.emplace_back(id, std::move(*errorMsg));
+        }
+        else
+        {
+            auto const& outputConfig = state.request.getOutputConfig();
+            auto const numSkipped = outputConfig.excludeInputFromOutput
+                ? static_cast<SizeType>(state.tokens.size()) - state.numGenerated
+                : 0;
+            Result result{};
+            result.isFinal = true;
+            result.outputTokenIds = {VecTokens(state.tokens.begin() + numSkipped, state.tokens.end())};
+            mFinishedStats[id] = state.stats;
+            mResponses.emplace_back(id, std::move(result));
+        }
+        mRequests.erase(id);
+        mResponseCv.notify_all();
+    }
+
+    //! \brief Append the tokens of a target step and start the next step, or finish the request.
+    void processTargetResult(IdType id, RequestState& state, Result const& result)
+    {
+        auto const& newTokens = result.outputTokenIds.at(0);
+        auto numNewTokens = std::min(static_cast<SizeType>(newTokens.size()), remainingTokens(state));
+        auto const endId = state.request.getEndId();
+        auto const endIt = endId ? std::find(newTokens.begin(), newTokens.begin() + numNewTokens, *endId)
+                                 : newTokens.begin() + numNewTokens;
+        auto const hitEndId = endIt != newTokens.begin() + numNewTokens;
+        numNewTokens = static_cast<SizeType>(endIt - newTokens.begin());
+
+        if (state.numDraftTokens > 0)
+        {
+            auto const numAcceptedTokens = std::clamp(numNewTokens - 1, 0, state.numDraftTokens);
+            state.stats.addStep(state.numDraftTokens, numAcceptedTokens);
+            mStats.addStep(state.numDraftTokens, numAcceptedTokens);
+        }
+        state.tokens.insert(state.tokens.end(), newTokens.begin(), endIt);
+        state.numGenerated += numNewTokens;
+
+        if (state.cancelled || hitEndId || hitStopWord(state) || remainingTokens(state) <= 0 || newTokens.empty())
+        {
+            finishRequest(id, state);
+            return;
+        }
+        startStep(id, state);
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock lock(mMutex);
+                mWorkCv.wait_for(lock, mConfig.pollTimeout,
+                    [this]() { return mShutdown || !mPending.empty() || !mRequests.empty(); });
+                if (mShutdown)
+                {
+                    return;
+                }
+                while (!mPending.empty())
+                {
+                    auto const id = mPending.front();
+                    mPending.pop_front();
+                    startStep(id, mRequests.at(id));
+                }
+            }
+
+            // Drafts of some requests and verification of others run concurrently on the two executors.
+            auto draftResponses = mDraftExecutor != nullptr
+                ? mDraftExecutor->awaitResponses(std::nullopt, mConfig.pollTimeout)
+                : std::vector<Response>{};
+            auto targetResponses = mTargetExecutor.awaitResponses(std::nullopt, mConfig.pollTimeout);
+
+            std::lock_guard lock(mMutex);
+            for (auto const& response : draftResponses)
+            {
+                auto const node = mDraftToRequest.extract(response.getRequestId());
+                if (node.empty())
+                {
+                    continue;
+                }
+                auto& state = mRequests.at(node.mapped());
+                if (response.hasError())
+                {
+                    finishRequest(node.mapped(), state, response.getErrorMsg());
+                    continue;
+                }
+                auto const result = response.getResult();
+                startTargetStep(node.mapped(), state, result.outputTokenIds.at(0), draftLogits(result));
+            }
+            for (auto const& response : targetResponses)
+            {
+                auto const node = mTargetToRequest.extract(response.getRequestId());
+                if (node.empty())
+                {
+                    continue;
+                }
+                auto& state = mRequests.at(node.mapped());
+                if (response.hasError())
+                {
+                    finishRequest(node.mapped(), state, response.getErrorMsg());
+                    continue;
+                }
+                processTargetResult(node.mapped(), state, response.getResult());
+            }
+        }
+    }
+
+    // Null without draft model
+    Executor* mDraftExecutor;
+    Executor& mTargetExecutor;
+    SpeculativeExecutorConfig mConfig;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCv;
+    std::condition_variable mResponseCv;
+    IdType mLastRequestId{0};
+    std::unordered_map<IdType, RequestState> mRequests;
+    // Requests waiting for their first draft step
+    std::deque<IdType> mPending;
+    // Ids of the requests in flight in the draft and target executors -> id of the client request
+    std::unordered_map<IdType, IdType> mDraftToRequest;
+    std::unordered_map<IdType, IdType> mTargetToRequest;
+    std::deque<Response> mResponses;
+    bool mShutdown{false};
+    SpeculativeDecodingStats mStats{};
+    // Stats of the finished requests until they are taken
+    std::unordered_map<IdType, SpeculativeDecodingStats> mFinishedStats;
+
+    // Declared last so that it starts after all other members are initialized
+    std::thread mThread;
+};
+
+} // namespace tensorrt_llm::executor
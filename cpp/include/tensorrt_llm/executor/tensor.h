@@ -22,6 +22,7 @@
 #include "tensorrt_llm/common/assert.h"
 
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <limits>
 #include <memory>
@@ -160,6 +161,22 @@ public:
         return of(getRuntimeType<T>(), static_cast<void*>(data), shape);
     }
 
+    //! Callback invoked with the data pointer once the last reference to a borrowed tensor is gone.
+    using ReleaseCallback = std::function<void(void* data)>;
+
+    //! Wrap a caller-owned buffer into a tensor without copying and get notified when it is no longer used.
+    //!
+    //! Unlike `of`, the caller does not have to keep the buffer alive for an unknown time: all copies of the
+    //! returned tensor, including the ones held by a `Request` or `PromptTuningConfig`, share the borrowed buffer,
+    //! and `release` is called exactly once after the last of them has been destroyed. The buffer may be in any
+    //! memory type, but only pinned, device or managed memory avoids a staging copy when the data is used on GPU.
+    //!
+    //! \param dataType The data type of the tensor.
+    //! \param data The caller-owned buffer. Must stay valid until `release` is invoked.
+    //! \param shape The shape of the tensor.
+    //! \param release Called with `data` when the tensor is released. May be empty.
+    static Tensor borrow(DataType dataType, void* data, Shape shape, ReleaseCallback release);
+
     //! Wrap any container into a tensor without taking ownership.
     //!
     //! \param shape The shape of the tensor.
@@ -269,4 +286,22 @@ private:
     friend Tensor detail::ofITensor(std::shared_ptr<runtime::ITensor> tensor);
 };
 
+inline Tensor Tensor::borrow(DataType dataType, void* data, Shape shape, ReleaseCallback release)
+{
+    auto view = detail::toITensor(of(dataType, data, shape));
+    if (!release)
+    {
+        return detail::ofITensor(std::move(view));
+    }
+    // Share the view under a deleter that drops it and hands the buffer back to its owner.
+    auto* const impl = view.get();
+    std::shared_ptr<Impl> borrowed{impl,
+        [view = std::move(view), release = std::move(release), data](Impl*) mutable
+        {
+            view.reset();
+            release(data);
+        }};
+    return detail::ofITensor(std::move(borrowed));
+}
+
 } // namespace tensorrt_llm::executor
@@ -16,8 +16,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #ifdef ENABLE_FP8
@@ -172,4 +177,225 @@ enum class CommMode
                    // Responses will be the same for all participants
 };
 
+/// @brief Monotonic timestamps of the lifetime of a request
+struct RequestPerfMetrics
+{
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    // When the request was enqueued
+    TimePoint arrivalTime{std::chrono::steady_clock::now()};
+    // When the first context chunk of the request was scheduled
+    std::optional<TimePoint> firstScheduledTime;
+    std::optional<TimePoint> firstTokenTime;
+    std::optional<TimePoint> lastTokenTime;
+    std::optional<TimePoint> completionTime;
+    // Number of generation steps that produced tokens
+    SizeType numTokenSteps{0};
+    // Time of every generation step, only recorded if requested
+    std::optional<std::vector<TimePoint>> tokenTimes;
+
+    /// @brief Time between enqueueing and scheduling in milliseconds
+    [[nodiscard]] std::optional<FloatType> getQueueTimeMs() const
+    {
+        return firstScheduledTime ? std::optional<FloatType>{toMs(*firstScheduledTime - arrivalTime)} : std::nullopt;
+    }
+
+    /// @brief Time to first token in milliseconds, measured from the arrival of the request
+    [[nodiscard]] std::optional<FloatType> getTimeToFirstTokenMs() const
+    {
+        return firstTokenTime ? std::optional<FloatType>{toMs(*firstTokenTime - arrivalTime)} : std::nullopt;
+    }
+
+    /// @brief Mean time between two generation steps after the first token in milliseconds
+    [[nodiscard]] std::optional<FloatType> getMeanInterTokenLatencyMs() const
+    {
+        if (!firstTokenTime || !lastTokenTime || numTokenSteps < 2)
+        {
+            return std::nullopt;
+        }
+        return toMs(*lastTokenTime - *firstTokenTime) / static_cast<FloatType>(numTokenSteps - 1);
+    }
+
+    /// @brief Time between enqueueing and completion in milliseconds
+    [[nodiscard]] std::optional<FloatType> getEndToEndLatencyMs() const
+    {
+        return completionTime ? std::optional<FloatType>{toMs(*completionTime - arrivalTime)} : std::nullopt;
+    }
+
+private:
+    [[nodiscard]] static FloatType toMs(TimePoint::duration duration)
+    {
+        return std::chrono::duration<FloatType, std::milli>(duration).count();
+    }
+};
+
+/// @brief Distribution of a latency over the requests completed recently, in milliseconds
+struct LatencyPercentiles
+{
+    SizeType numSamples{0};
+    FloatType p50{0.f};
+    FloatType p90{0.f};
+    FloatType p99{0.f};
+    FloatType max{0.f};
+};
+
+/// @brief Latency breakdown of the requests completed recently
+struct RequestLatencyStats
+{
+    LatencyPercentiles queueTimeMs{};
+    LatencyPercentiles timeToFirstTokenMs{};
+    LatencyPercentiles interTokenLatencyMs{};
+    LatencyPercentiles endToEndLatencyMs{};
+};
+
+/// @brief KV cache statistics of one iteration
+struct KvCacheStats
+{
+    SizeType maxNumBlocks{0};
+    SizeType freeNumBlocks{0};
+    SizeType usedNumBlocks{0};
+    SizeType tokensPerBlock{0};
+    // Blocks reused from the cache since the start of the executor
+    std::uint64_t reusedBlocks{0};
+    // Fraction of allocated blocks taken from the cache
+    FloatType cacheHitRate{0.f};
+};
+
+/// @brief Batch composition of one iteration with inflight batching
+struct InflightBatchingStats
+{
+    SizeType numScheduledRequests{0};
+    SizeType numContextRequests{0};
+    SizeType numGenRequests{0};
+    SizeType numPausedRequests{0};
+    // Number of context tokens processed in this iteration
+    SizeType numCtxTokens{0};
+    SizeType microBatchId{0};
+};
+
+/// @brief Acceptance of draft tokens in speculative decoding, for a request or for an iteration
+/// @details A step is one verification of draft tokens by the target model. Plain data with a fixed size histogram,
+/// so it can be part of IterationStats
+struct SpeculativeDecodingStats
+{
+    // Acceptance lengths from kMaxAcceptanceLength on share the last bin of the histogram
+    static SizeType constexpr kMaxAcceptanceLength{16};
+
+    std::uint64_t numSteps{0};
+    // Draft tokens proposed for verification
+    std::uint64_t numDraftTokens{0};
+    // Draft tokens accepted by the target model
+    std::uint64_t numAcceptedTokens{0};
+    // acceptanceLengthHistogram[n] is the number of steps that accepted n draft tokens
+    std::array<std::uint64_t, kMaxAcceptanceLength + 1> acceptanceLengthHistogram{};
+
+    void addStep(SizeType numDraftTokens, SizeType numAcceptedTokens)
+    {
+        ++numSteps;
+        this->numDraftTokens += numDraftTokens;
+        this->numAcceptedTokens += numAcceptedTokens;
+        ++acceptanceLengthHistogram[std::clamp(numAcceptedTokens, 0, kMaxAcceptanceLength)];
+    }
+
+    void merge(SpeculativeDecodingStats const& other)
+    {
+        numSteps += other.numSteps;
+        numDraftTokens += other.numDraftTokens;
+        numAcceptedTokens += other.numAcceptedTokens;
+        for (std::size_t i = 0; i < acceptanceLengthHistogram.size(); ++i)
+        {
+            acceptanceLengthHistogram[i] += other.acceptanceLengthHistogram[i];
+        }
+    }
+
+    /// @brief Fraction of the proposed draft tokens that were accepted
+    [[nodiscard]] FloatType getAcceptanceRate() const
+    {
+        return numDraftTokens > 0 ? static_cast<FloatType>(numAcceptedTokens) / static_cast<FloatType>(numDraftTokens)
+                                  : 0.f;
+    }
+
+    /// @brief Tokens per forward pass of the target model, the accepted drafts plus the token of the target model
+    [[nodiscard]] FloatType getTokensPerStep() const
+    {
+        return numSteps > 0 ? static_cast<FloatType>(numAcceptedTokens + numSteps) / static_cast<FloatType>(numSteps)
+                            : 0.f;
+    }
+};
+
+/// @brief Rows routed to the experts of the MoE layers, see runtime::MoeLoadStatsCollector
+/// @details Plain data with a fixed size array, so it can be part of IterationStats. With expert parallelism, a rank
+/// only counts the rows it processes. Experts from kMaxNumExperts on are not tracked
+struct MoeLoadStats
+{
+    static SizeType constexpr kMaxNumExperts{256};
+
+    SizeType numLayers{0};
+    SizeType numExperts{0};
+    // Expanded rows routed to each expert, summed over the layers
+    std::array<std::uint64_t, kMaxNumExperts> numRowsPerExpert{};
+    // Largest ratio over the layers of the rows of the most loaded expert to the mean, 1 if the load is balanced
+    FloatType maxImbalance{0.f};
+
+    void addLayer(std::int64_t const* numRows, SizeType numLayerExperts)
+    {
+        ++numLayers;
+        numExperts = std::max(numExperts, numLayerExperts);
+        std::int64_t totalRows{0};
+        std::int64_t maxRows{0};
+        for (SizeType expert = 0; expert < numLayerExperts; ++expert)
+        {
+            totalRows += numRows[expert];
+            maxRows = std::max(maxRows, numRows[expert]);
+            if (expert < kMaxNumExperts)
+            {
+                numRowsPerExpert[expert] += static_cast<std::uint64_t>(numRows[expert]);
+            }
+        }
+        if (totalRows > 0)
+        {
+            auto const imbalance = static_cast<FloatType>(maxRows) * static_cast<FloatType>(numLayerExperts)
+                / static_cast<FloatType>(totalRows);
+            maxImbalance = std::max(maxImbalance, imbalance);
+        }
+    }
+
+    /// @brief The count most loaded experts, the most loaded first. Candidates for replication across the
+    /// expert-parallel ranks
+    [[nodiscard]] std::vector<SizeType> getHottestExperts(SizeType count) const
+    {
+        std::vector<SizeType> experts(std::min(numExperts, kMaxNumExperts));
+        for (SizeType expert = 0; expert < static_cast<SizeType>(experts.size()); ++expert)
+        {
+            experts[expert] = expert;
+        }
+        count = std::clamp(count, 0, static_cast<SizeType>(experts.size()));
+        std::partial_sort(experts.begin(), experts.begin() + count, experts.end(),
+            [this](SizeType lhs, SizeType rhs) { return numRowsPerExpert[lhs] > numRowsPerExpert[rhs]; });
+        experts.resize(count);
+        return experts;
+    }
+};
+
+/// @brief Statistics of one executor iteration
+/// @details Plain data without heap members, so it can be kept in a preallocated buffer and copied without
+/// allocations, see IterationStatsBuffer
+struct IterationStats
+{
+    // Time since epoch of the end of the iteration, in microseconds
+    std::int64_t timestampUs{0};
+    std::uint64_t iter{0};
+    FloatType iterLatencyMs{0.f};
+    SizeType numActiveRequests{0};
+    SizeType maxNumActiveRequests{0};
+    std::size_t gpuMemUsage{0};
+    std::size_t cpuMemUsage{0};
+    std::size_t pinnedMemUsage{0};
+    KvCacheStats kvCacheStats{};
+    InflightBatchingStats inflightBatchingStats{};
+    RequestLatencyStats requestLatencyStats{};
+    SpeculativeDecodingStats specDecodingStats{};
+    MoeLoadStats moeLoadStats{};
+};
+
 } // namespace tensorrt_llm::executor
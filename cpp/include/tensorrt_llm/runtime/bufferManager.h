@@ -20,9 +20,13 @@
 #include "tensorrt_llm/runtime/cudaStream.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
 #include <NvInferRuntime.h>
+#include <cuda_runtime_api.h>
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -38,38 +42,91 @@ public:
 
     using CudaStreamPtr = std::shared_ptr<CudaStream>;
 
-    //! \brief Construct a BufferManager.
+    //! \brief Configuration of the stream-ordered memory pool GPU buffers are allocated from.
+    struct MemoryPoolConfig
+    {
+        //! Bytes the pool keeps reserved when it synchronizes, nullopt never releases memory to the OS.
+        std::optional<std::uint64_t> releaseThreshold{};
+        //! Devices granted read/write access to the pool, nullopt for all devices with peer access.
+        std::optional<std::vector<int>> peerDevices{};
+        //! Size the pool is trimmed to when `onIdle` is called, nullopt disables trimming on idle.
+        std::optional<std::size_t> idleTrimSize{};
+        //! Name of a dedicated pool shared by all buffer managers using the same name on a device, empty for the
+        //! default pool of the device.
+        std::string poolName{};
+        //! Upper bound on the memory reserved by a dedicated pool, 0 for no bound. Requires CUDA 12.2.
+        std::size_t maxPoolSize{0};
+    };
+
+    //! \brief Construct a BufferManager using the default memory pool configuration.
     //!
     //! \param[in] cudaStream The cuda stream to use for all operations on GPU (allocation, de-allocation, copying,
     //! etc.).
     explicit BufferManager(CudaStreamPtr stream);
 
+    //! \brief Construct a BufferManager allocating GPU buffers from the pool described by `poolConfig`.
+    BufferManager(CudaStreamPtr stream, MemoryPoolConfig poolConfig);
+
+    //! \brief Set the pool configuration used by buffer managers constructed without one, e.g. to place all runtime
+    //! and batch manager buffers into one dedicated pool.
+    static void setDefaultMemoryPoolConfig(MemoryPoolConfig poolConfig);
+
+    [[nodiscard]] static MemoryPoolConfig getDefaultMemoryPoolConfig();
+
+    //! \brief Get the dedicated pool `name` on `device`, creating it if needed. Pools live until the process exits.
+    [[nodiscard]] static ::cudaMemPool_t getNamedMemoryPool(std::string const& name, int device,
+        std::size_t maxPoolSize = 0);
+
     static auto constexpr kBYTE_TYPE = nvinfer1::DataType::kUINT8;
 
-    //! \brief Allocates an `IBuffer` of the given size on the GPU.
+    using MemoryTag = MemoryCounters::TagId;
+
+    //! \brief Allocates an `IBuffer` of the given size on the GPU, accounted to the current tag of the thread.
     [[nodiscard]] IBufferPtr gpu(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE) const;
 
-    //! \brief Allocates an `ITensor` of the given dimensions on the GPU.
+    //! \brief Allocates an `ITensor` of the given dimensions on the GPU, accounted to the current tag of the thread.
     [[nodiscard]] ITensorPtr gpu(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE) const;
 
+    //! \brief Allocates an `IBuffer` of the given size on the GPU, accounted to `tag` in the MemoryCounters.
+    [[nodiscard]] IBufferPtr gpu(std::size_t size, nvinfer1::DataType type, MemoryTag tag) const;
+
+    //! \brief Allocates an `ITensor` of the given dimensions on the GPU, accounted to `tag` in the MemoryCounters.
+    [[nodiscard]] ITensorPtr gpu(nvinfer1::Dims dims, nvinfer1::DataType type, MemoryTag tag) const;
+
     //! \brief Allocates an `IBuffer` of the given size on the CPU.
     [[nodiscard]] static IBufferPtr cpu(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE);
 
     //! \brief Allocates an `ITensor` of the given dimensions on the CPU.
     [[nodiscard]] static ITensorPtr cpu(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE);
 
-    //! \brief Allocates a pinned `IBuffer` of the given size on the CPU.
+    //! \brief Allocates a pinned `IBuffer` of the given size on the CPU, accounted to the current tag of the thread.
     [[nodiscard]] static IBufferPtr pinned(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE);
 
-    //! \brief Allocates a pinned `ITensor` of the given dimensions on the CPU.
+    //! \brief Allocates a pinned `ITensor` of the given dimensions on the CPU, accounted to the current tag of the
+    //! thread.
     [[nodiscard]] static ITensorPtr pinned(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE);
 
+    //! \brief Allocates a pinned `IBuffer` of the given size on the CPU, accounted to `tag` in the MemoryCounters.
+    [[nodiscard]] static IBufferPtr pinned(std::size_t size, nvinfer1::DataType type, MemoryTag tag);
+
+    //! \brief Allocates a pinned `ITensor` of the given dimensions on the CPU, accounted to `tag` in the
+    //! MemoryCounters.
+    [[nodiscard]] static ITensorPtr pinned(nvinfer1::Dims dims, nvinfer1::DataType type, MemoryTag tag);
+
     //! \brief Allocates a pinned `IBuffer` of the given size on the CPU in the default memory pool.
     [[nodiscard]] static IBufferPtr pinnedPool(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE);
 
     //! \brief Allocates a pinned `ITensor` of the given dimensions on the CPU in the default memory pool.
     [[nodiscard]] static ITensorPtr pinnedPool(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE);
 
+    //! \brief Allocates a small pinned `IBuffer` of the given size from the size-class slabs of the default memory
+    //! pool. Allocating and freeing cached blocks does not lock the pool.
+    [[nodiscard]] static IBufferPtr pinnedSizeClass(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE);
+
+    //! \brief Allocates a small pinned `ITensor` of the given dimensions from the size-class slabs of the default
+    //! memory pool. Allocating and freeing cached blocks does not lock the pool.
+    [[nodiscard]] static ITensorPtr pinnedSizeClass(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE);
+
     //! \brief Allocates an `IBuffer` of the given size in UVM.
     [[nodiscard]] static IBufferPtr managed(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE);
 
@@ -170,21 +227,35 @@ public:
     //! stream.
     void memoryPoolTrimTo(std::size_t size);
 
+    //! \brief Notify the manager that no work is in flight. Trims the pool to `idleTrimSize` if configured.
+    void onIdle();
+
+    //! \brief The memory pool GPU buffers are allocated from.
+    [[nodiscard]] ::cudaMemPool_t getMemoryPool() const;
+
+    [[nodiscard]] MemoryPoolConfig const& getMemoryPoolConfig() const
+    {
+        return mPoolConfig;
+    }
+
 private:
-    void static initMemoryPool(int device);
+    void static initMemoryPool(::cudaMemPool_t memPool, int device, MemoryPoolConfig const& poolConfig);
 
-    std::size_t static memoryPoolReserved(int device);
+    std::size_t static memoryPoolReserved(::cudaMemPool_t memPool);
 
-    std::size_t static memoryPoolUsed(int device);
+    std::size_t static memoryPoolUsed(::cudaMemPool_t memPool);
 
-    std::size_t static memoryPoolFree(int device)
+    std::size_t static memoryPoolFree(::cudaMemPool_t memPool)
     {
-        return memoryPoolReserved(device) - memoryPoolUsed(device);
+        return memoryPoolReserved(memPool) - memoryPoolUsed(memPool);
     }
 
-    void static memoryPoolTrimTo(int device, std::size_t size);
+    void static memoryPoolTrimTo(::cudaMemPool_t memPool, std::size_t size);
 
     CudaStreamPtr mStream;
+    MemoryPoolConfig mPoolConfig;
+    // Dedicated pool to allocate from, nullptr for the default pool of the device
+    ::cudaMemPool_t mMemPool{nullptr};
 };
 
 } // namespace tensorrt_llm::runtime
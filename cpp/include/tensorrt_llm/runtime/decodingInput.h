@@ -18,9 +18,11 @@
 
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/logitsPostProcessor.h"
 
 #include <memory>
 #include <optional>
+#include <vector>
 
 namespace tensorrt_llm::runtime
 {
@@ -70,9 +72,16 @@ public:
     TensorPtr stopWordsList;       // [maxBatchSize, 2, stopWordsLength], on gpu
     TensorPtr stopWordsPtrs;       // [maxBatchSize][2, stopWordsLength], on gpu
     TensorPtr stopWordsLens;       // [maxBatchSize], on gpu
+    TensorPtr stopWordsAutomaton;  // automaton of a single request, see kernels::buildAhoCorasick, on gpu
+    TensorPtr badWordsAutomaton;   // automaton of a single request, see kernels::buildAhoCorasick, on gpu
+    TensorPtr stopWordsAutomata;   // [maxBatchSize][automatonSize], optional, nullptr for requests without one, pinned
+    TensorPtr badWordsAutomata;    // [maxBatchSize][automatonSize], optional, nullptr for requests without one, pinned
+    TensorPtr wordsAutomataStates; // [maxBatchSize, 2], states of the stop and bad words automata, on gpu
     TensorPtr noRepeatNgramSize;   // [maxBatchSize], on gpu
     TensorPtr
         batchSlots; // [batchSize], optional, address map of the linear batch id to to the seq slots, int32_t, pinned
+    std::vector<LogitsPostProcessorPtr>
+        logitsPostProcessors; // [maxBatchSize], optional, indexed by seq slot, nullptr for requests without one
 
     // parameters for beam search
     TensorPtr cacheIndirection; // [maxBatchSize, beamWidth, maxSeqLen] - the k/v cache index for beam search, on gpu
@@ -49,6 +49,21 @@ public:
         return DecodingMode{kBeamSearch};
     }
 
+    static auto constexpr MinP()
+    {
+        return DecodingMode{kMinP};
+    }
+
+    static auto constexpr TypicalP()
+    {
+        return DecodingMode{kTypicalP};
+    }
+
+    static auto constexpr Lookahead()
+    {
+        return DecodingMode{kLookahead};
+    }
+
     bool constexpr isNone()
     {
         return mState == 0;
@@ -79,6 +94,27 @@ public:
         return anyBitSet(kBeamSearch);
     }
 
+    bool constexpr isMinP()
+    {
+        return anyBitSet(kMinP);
+    }
+
+    bool constexpr isTypicalP()
+    {
+        return anyBitSet(kTypicalP);
+    }
+
+    bool constexpr isLookahead()
+    {
+        return anyBitSet(kLookahead);
+    }
+
+    //! \brief True if any of the sampling modes (TopK, TopP, MinP, TypicalP) is set
+    bool constexpr isSampling()
+    {
+        return anyBitSet(kSampling);
+    }
+
     using UnderlyingType = uint8_t;
 
 private:
@@ -93,7 +129,13 @@ private:
     static UnderlyingType constexpr kTopK{1u << 0};
     static UnderlyingType constexpr kTopP{1u << 1};
     static UnderlyingType constexpr kBeamSearch{1u << 2};
+    // MinP and TypicalP can not be combined with other modes
+    static UnderlyingType constexpr kMinP{1u << 3};
+    static UnderlyingType constexpr kTypicalP{1u << 4};
+    // Greedy lookahead (Jacobi) decoding, see LookaheadAlgorithm. Can not be combined with other modes
+    static UnderlyingType constexpr kLookahead{1u << 5};
     static UnderlyingType constexpr kTopKTopP{kTopK | kTopP};
+    static UnderlyingType constexpr kSampling{kTopKTopP | kMinP | kTypicalP};
 
     bool constexpr anyBitSet(UnderlyingType bits) const
     {
@@ -133,6 +175,26 @@ static_assert(!DecodingMode::TopKTopP().isBeamSearch());
 
 static_assert(DecodingMode::BeamSearch().isBeamSearch());
 static_assert(!DecodingMode::BeamSearch().isTopKorTopP());
+static_assert(!DecodingMode::BeamSearch().isSampling());
+
+static_assert(DecodingMode::TopKTopP().isSampling());
+
+static_assert(DecodingMode::MinP().isMinP());
+static_assert(DecodingMode::MinP().isSampling());
+static_assert(!DecodingMode::MinP().isTopKorTopP());
+static_assert(!DecodingMode::MinP().isTypicalP());
+static_assert(!DecodingMode::MinP().isBeamSearch());
+
+static_assert(DecodingMode::TypicalP().isTypicalP());
+static_assert(DecodingMode::TypicalP().isSampling());
+static_assert(!DecodingMode::TypicalP().isTopKorTopP());
+static_assert(!DecodingMode::TypicalP().isMinP());
+static_assert(!DecodingMode::TypicalP().isBeamSearch());
+
+static_assert(DecodingMode::Lookahead().isLookahead());
+static_assert(!DecodingMode::Lookahead().isSampling());
+static_assert(!DecodingMode::Lookahead().isBeamSearch());
+static_assert(!DecodingMode::TopKTopP().isLookahead());
 
 } // namespace runtime
 } // namespace tensorrt_llm
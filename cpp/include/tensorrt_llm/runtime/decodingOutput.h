@@ -83,6 +83,10 @@ public:
     TensorPtr lengths;          // [batchSize, beamWidth], total sequence lengths including padding, on gpu
     TensorPtr cacheIndirection; // [batchSize, beamWidth, maxSeqLen], k/v indirection for next generation step, on gpu
 
+    // optional top-N alternatives of every generated token
+    TensorPtr topNIds;      // [batchSize, beamWidth, maxSeqLen, topN], on gpu
+    TensorPtr topNLogProbs; // [batchSize, beamWidth, maxSeqLen, topN], must be float*, on gpu
+
     BeamHypotheses beamHypotheses;
 };
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief File on a local SSD that device and host buffers are read from and written to in stream order.
+//! \details With ENABLE_CUFILE and a working GPUDirect Storage driver, device buffers move between the GPU and the
+//! file through cuFileReadAsync / cuFileWriteAsync, i.e. by DMA without a bounce through host memory and without a
+//! host thread in the data path. Otherwise, device buffers are staged through a pinned buffer and the file is read
+//! and written with pread / pwrite in a host function on the stream. Host buffers always take the latter path.
+//! A transfer keeps its buffer alive until the stream has passed it, so callers may drop their references right
+//! after enqueueing. I/O errors are reported by the first call after the stream has passed the failed transfer,
+//! or by synchronize. Not thread-safe.
+class GdsFile
+{
+public:
+    //! \brief A contiguous range of bytes, at fileOffset in the file and at bufferOffset in the buffer.
+    struct Extent
+    {
+        std::size_t fileOffset;
+        std::size_t bufferOffset;
+        std::size_t size;
+    };
+
+    //! \brief Create or truncate the file at path, sparse with size bytes.
+    //! \param removeOnClose Remove the file in the destructor, e.g. for a cache that does not outlive the process.
+    GdsFile(std::filesystem::path path, std::size_t size, bool removeOnClose = true);
+    ~GdsFile();
+
+    GdsFile(GdsFile const&) = delete;
+    GdsFile& operator=(GdsFile const&) = delete;
+
+    //! \brief Whether the library was built with cuFile and the GPUDirect Storage driver could be opened.
+    [[nodiscard]] static bool isGdsAvailable();
+
+    //! \brief Whether device buffers bypass host memory for this file.
+    [[nodiscard]] bool usesGds() const noexcept
+    {
+        return mUsesGds;
+    }
+
+    //! \brief Enqueue writing the extents of src to the file on stream.
+    void write(IBuffer::SharedConstPtr src, std::vector<Extent> const& extents, CudaStream const& stream);
+
+    //! \brief Enqueue writing all of src to the file at fileOffset on stream.
+    void write(IBuffer::SharedConstPtr const& src, std::size_t fileOffset, CudaStream const& stream);
+
+    //! \brief Enqueue reading the extents of the file into dst on stream.
+    void read(IBuffer::SharedPtr dst, std::vector<Extent> const& extents, CudaStream const& stream);
+
+    //! \brief Enqueue filling all of dst from the file at fileOffset on stream.
+    void read(IBuffer::SharedPtr const& dst, std::size_t fileOffset, CudaStream const& stream);
+
+    //! \brief Wait for all enqueued transfers and throw if one of them failed.
+    void synchronize();
+
+    [[nodiscard]] std::filesystem::path const& getPath() const noexcept
+    {
+        return mPath;
+    }
+
+    [[nodiscard]] std::size_t getSize() const noexcept
+    {
+        return mSize;
+    }
+
+    //! \brief Bytes moved by the transfers that have completed so far.
+    [[nodiscard]] std::size_t getNumBytesWritten() const noexcept
+    {
+        return mNumBytesWritten;
+    }
+
+    [[nodiscard]] std::size_t getNumBytesRead() const noexcept
+    {
+        return mNumBytesRead;
+    }
+
+private:
+    struct Transfer;
+
+    void enqueue(std::unique_ptr<Transfer> transfer, CudaStream const& stream);
+    void enqueueGds(Transfer& transfer, CudaStream const& stream);
+    void enqueueHost(Transfer& transfer, CudaStream const& stream);
+    //! \brief Drop the transfers the streams have passed and throw if one of them failed.
+    void reclaim(bool wait);
+    static void hostTransfer(void* userData);
+
+    std::filesystem::path mPath;
+    std::size_t mSize;
+    bool mRemoveOnClose;
+    // Descriptor of pread / pwrite
+    int mFd{-1};
+    // O_DIRECT descriptor registered with cuFile
+    int mDirectFd{-1};
+    void* mCuFileHandle{nullptr};
+    bool mUsesGds{false};
+    // In flight, oldest first
+    std::list<std::unique_ptr<Transfer>> mTransfers;
+    std::size_t mNumBytesWritten{0};
+    std::size_t mNumBytesRead{0};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -25,6 +25,18 @@
 namespace tensorrt_llm::runtime
 {
 
+//! Pooling of the final hidden states of a prompt into one embedding, see GptSession::computeEmbeddings.
+enum class EmbeddingPooling : std::int32_t
+{
+    //! Hidden state of the last token, e.g. for models trained with an end-of-sequence embedding token
+    kLAST = 0,
+    //! Mean over all tokens
+    kMEAN = 1,
+    //! Mean weighted by position, token i has weight i + 1, so later tokens that attended to more of the prompt
+    //! count more
+    kWEIGHTED_MEAN = 2,
+};
+
 template <typename TTensor>
 class GenericGenerationOutput
 {
@@ -37,6 +37,12 @@ template <typename T>
 class DynamicDecodeLayer;
 } // namespace layers
 
+namespace kernels
+{
+// Forward declaration
+struct PhiloxState;
+} // namespace kernels
+
 namespace runtime
 {
 
@@ -69,7 +75,7 @@ public:
     static void acceptDraftTokensByLogits(ITensor& draftLogits, ITensor const& targetLogits, ITensor& draftProbs,
         ITensor& targetProbs, ITensor const& numDraftTokens, ITensor& finished, ITensor const& batchSlots,
         SizeType vocabSize, SizeType vocabSizePadded, bool useRandomAcceptThreshold, float randomAcceptThreshold,
-        curandState_t* curandState, BufferManager::CudaStreamPtr const& stream);
+        tensorrt_llm::kernels::PhiloxState* curandState, BufferManager::CudaStreamPtr const& stream);
 
     static std::unique_ptr<IGptDecoder> create(DecodingMode const& mode, nvinfer1::DataType dtype, size_t maxBatchSize,
         size_t maxBeamWidth, size_t vocabSize, size_t vocabSizePadded, size_t maxSequenceLength,
@@ -23,6 +23,7 @@
 #include "tensorrt_llm/runtime/gptDecoder.h"
 #include "tensorrt_llm/runtime/iGptDecoderBatch.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/tokenStreamRing.h"
 
 #include <memory>
 #include <vector>
@@ -30,6 +31,9 @@
 namespace tensorrt_llm::runtime
 {
 
+class CopyBatcher;
+class CudaGraphCache;
+
 //! GPT decoder class with support for in-flight batching
 class GptDecoderBatch : public IGptDecoderBatch
 {
@@ -41,6 +45,8 @@ public:
     GptDecoderBatch(std::size_t vocabSize, std::size_t vocabSizePadded, CudaStreamPtr stream);
 
     //! Setup the decoder before calling `forward()`
+    //! Without fusedDecoder, requests can use any beam width up to maxBeamWidth within one batch. Requests with beam
+    //! width 1 are sampled even if mode is beam search.
     void setup(DecodingMode const& mode, SizeType maxBatchSize, SizeType maxBeamWidth, SizeType maxAttentionWindow,
         SizeType sinkTokenLength, SizeType maxSequenceLength, SizeType maxTokensPerStep, bool fusedDecoder,
         nvinfer1::DataType dtype) override;
@@ -84,6 +90,8 @@ public:
 
     //! @brief Gather final beam search results for request `batchIdx`.
     //! Result will only be available after event returned.
+    //! @details Runs on a side stream after the decoding steps enqueued so far, without blocking the decoding of the
+    //! other requests. A new request in the slot waits for it.
     [[nodiscard]] CudaEvent finalize(SizeType batchIdx) const override;
 
     //! @brief Gather final beam search results for all requests.
@@ -124,6 +132,48 @@ public:
         return tensor;
     }
 
+    //! @brief Return the `topN` most likely tokens and their log probabilities for every generated token.
+    //! Must be called after `setup()` and before requests are added. The alternatives are computed on the gpu, so only
+    //! [topN] ids and log probabilities per token have to be copied to the host instead of the logits.
+    void enableTopNLogProbs(SizeType topN);
+
+    //! @returns [maxBeamWidth, maxSequenceLength, topN], most likely token ids at each position of request `batchIdx`
+    //! by decreasing probability, on gpu
+    [[nodiscard]] TensorPtr getTopNIds(SizeType batchIdx) const
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mJointDecodingOutput->topNIds), "Top-N log probs are not enabled");
+        auto tensor = ITensor::slice(mJointDecodingOutput->topNIds, batchIdx, 1);
+        tensor->squeeze(0);
+        return tensor;
+    }
+
+    //! @returns [maxBeamWidth, maxSequenceLength, topN], log probabilities of the tokens of `getTopNIds`, on gpu
+    [[nodiscard]] TensorPtr getTopNLogProbs(SizeType batchIdx) const
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mJointDecodingOutput->topNLogProbs), "Top-N log probs are not enabled");
+        auto tensor = ITensor::slice(mJointDecodingOutput->topNLogProbs, batchIdx, 1);
+        tensor->squeeze(0);
+        return tensor;
+    }
+
+    //! @brief Launch the decoding step of the fused decoder as a CUDA graph, which saves the launch overhead of its
+    //! many small kernels at small batch sizes. The step is captured at every call and applied to a cached graph
+    //! instance per batch size bucket with `cudaGraphExecUpdate`. Must be called after `setup()`. Has no effect for
+    //! non-fused decoders, speculative decoding and in builds that synchronize after each kernel.
+    void enableCudaGraphs(SizeType maxNumGraphs = 8);
+
+    //! @brief Publish the tokens of beam 0 in a ring of pinned host memory at the end of each forward pass.
+    //! Must be called after `setup()` and before requests are added. The host can poll the ring while the decoder
+    //! stream is running, without waiting for `forwardSync()`. Tokens of requests with beam width > 1 are published
+    //! before gatherTree and may differ from the final output ids.
+    void enableTokenStreaming(SizeType capacity = TokenStreamRing::kDefaultCapacity);
+
+    //! @returns the token stream, nullptr if token streaming is not enabled
+    [[nodiscard]] std::shared_ptr<TokenStreamRing> getTokenStream() const
+    {
+        return mTokenStream;
+    }
+
     //! @brief Get maxTokensPerStep tokens generated in the last forward pass
     //! @returns [maxTokensPerStep, batchSize, maxBeamWidth], tokens generated in last forward pass, on gpu
     [[nodiscard]] TensorPtr getAllNewTokens() const override
@@ -158,7 +208,13 @@ private:
     [[nodiscard]] CudaEvent postProcessRequest(SizeType batchIdx) const;
 
     //! @brief Initialize the decoder at `batchIdx` with a new `request`.
-    void newRequest(SizeType batchIdx, decoder_batch::Request const& request, SamplingConfig const& samplingConfig);
+    //! @details The values of its slot are staged at `setupIdx` of mSetupParams and written by scatterNewRequests.
+    void newRequest(SizeType batchIdx, decoder_batch::Request const& request, SamplingConfig const& samplingConfig,
+        SizeType setupIdx);
+
+    //! @brief Copy `numRequests` staged requests from `setupIdx` to the device and scatter them to their slots with one
+    //! kernel.
+    void scatterNewRequests(SizeType setupIdx, SizeType numRequests, CudaStreamPtr const& stream);
 
 private:
     std::size_t const mVocabSize;
@@ -167,6 +223,9 @@ private:
     BufferManager mBufferManager;
     TokenPtr mForwardToken;
     CudaEvent mForwardEvent;
+    CudaStreamPtr mFinalizeStream;          // gathers the beams of finished requests
+    TensorPtr mFinalOutputIds;              // [1, beamWidth, maxSequenceLength], gatherTree output, on gpu
+    std::vector<CudaEvent> mFinalizeEvents; // [maxBatchSize], recorded after the last finalize of each slot
 
     std::vector<CudaStreamPtr> mStreams;
     using GptDecoderPtr = std::unique_ptr<IGptDecoder>;
@@ -204,6 +263,18 @@ private:
     TensorPtr mBatchSlotsAcceptTokens; // [maxBatchSize], int32_t, address map, pinned
     TensorPtr mBatchSlotsAcceptLogits; // [maxBatchSize], int32_t, address map, pinned
     TensorPtr mTargetLogitsPtrs;       // [maxBatchSize], float*, pointers to target logits, pinned
+    TensorPtr mStopWordsAutomata;      // [maxBatchSize], int32_t*, pointers to stop words automata, pinned
+    TensorPtr mBadWordsAutomata;       // [maxBatchSize], int32_t*, pointers to bad words automata, pinned
+    TensorPtr mWordsAutomataStates;    // [maxBatchSize, 2], int32_t, states of the words automata, on gpu
+    TensorPtr mSetupParams;            // [maxBatchSize, 4], int32_t, values of the new requests, pinned
+    TensorPtr mSetupParamsDevice;      // [maxBatchSize, 4], int32_t, values of the new requests, on gpu
+    CudaEvent mSetupParamsEvent;       // recorded after the scatter of mSetupParams by the fused decoder
+    std::shared_ptr<CopyBatcher> mSetupCopies; // coalesces the copies of new requests on the fused decoder stream
+    std::shared_ptr<TokenStreamRing> mTokenStream;
+    std::shared_ptr<CudaGraphCache> mDecoderGraphs;
+    TensorPtr mStreamedLengths;        // [maxBatchSize], int32_t, length of the streamed part of each sequence, on gpu
+    TensorPtr mTokenStreamSlots;       // [maxBatchSize], int32_t, slots decoded in the last forward pass, pinned
+    TensorPtr mTokenStreamOffsets;     // [maxBatchSize], int32_t, offsets of their final finished states, pinned
     SizeType mMaxSequenceLength{};
     SizeType mMaxAttentionWindow{};
     SizeType mSinkTokenLength{};
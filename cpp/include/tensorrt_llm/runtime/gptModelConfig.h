@@ -55,12 +55,14 @@ public:
         , mMaxNumTokens(std::nullopt)
         , mComputeContextLogits(false)
         , mComputeGenerationLogits(false)
+        , mComputeHiddenStates(false)
         , mModelVariant(ModelVariant::kGpt)
         , mUseCustomAllReduce(false)
         , mMaxPromptEmbeddingTableSize(0)
         , mMaxDraftLen(0)
         , mUseContextFMHAForGeneration(false)
         , mPagedContextFMHA(false)
+        , mKvCacheEvictionRecentWindow(0)
         , mUseLoraPlugin(false)
         , mMlpHiddenSize(0)
         , mMedusaModule(std::nullopt)
@@ -258,6 +260,18 @@ public:
         mComputeGenerationLogits = computeGenerationLogits;
     }
 
+    //! \brief The engine has no vocab projection and outputs the final hidden states of all context tokens in
+    //! hidden_states_output instead of logits, i.e. it serves as an embedding model.
+    [[nodiscard]] bool constexpr computeHiddenStates() const noexcept
+    {
+        return mComputeHiddenStates;
+    }
+
+    void constexpr computeHiddenStates(bool computeHiddenStates) noexcept
+    {
+        mComputeHiddenStates = computeHiddenStates;
+    }
+
     [[nodiscard]] ModelVariant getModelVariant() const
     {
         return mModelVariant;
@@ -313,6 +327,18 @@ public:
         return mPagedContextFMHA;
     }
 
+    //! \brief Set the number of most recent tokens kept by attention-guided KV cache eviction, 0 if it is disabled.
+    //! The blocks of the KV cache then hold the eviction metadata too.
+    void constexpr setKvCacheEvictionRecentWindow(SizeType recentWindow) noexcept
+    {
+        mKvCacheEvictionRecentWindow = recentWindow;
+    }
+
+    [[nodiscard]] SizeType constexpr getKvCacheEvictionRecentWindow() const noexcept
+    {
+        return mKvCacheEvictionRecentWindow;
+    }
+
     [[nodiscard]] bool constexpr useLoraPlugin() const noexcept
     {
         return mUseLoraPlugin;
@@ -389,6 +415,7 @@ private:
 
     bool mComputeContextLogits;
     bool mComputeGenerationLogits;
+    bool mComputeHiddenStates;
     ModelVariant mModelVariant;
     bool mUseCustomAllReduce;
 
@@ -397,6 +424,7 @@ private:
 
     bool mUseContextFMHAForGeneration;
     bool mPagedContextFMHA;
+    SizeType mKvCacheEvictionRecentWindow;
 
     bool mUseLoraPlugin;
     std::vector<LoraModule> mLoraModules;
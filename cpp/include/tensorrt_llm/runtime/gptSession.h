@@ -25,15 +25,22 @@
 #include "tensorrt_llm/runtime/generationOutput.h"
 #include "tensorrt_llm/runtime/gptModelConfig.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/numaAffinity.h"
 #include "tensorrt_llm/runtime/samplingConfig.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
 #include <NvInferRuntime.h>
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace tensorrt_llm::batch_manager
@@ -52,11 +59,16 @@ namespace tensorrt_llm::runtime
 namespace utils
 {
 std::vector<uint8_t> loadEngine(std::string const& enginePath);
-}
+class MappedFile;
+} // namespace utils
 
+class AsyncTokenCallback;
+class GenerationLogitsStreamer;
 class IpcMemory;
 class IStatefulGptDecoder;
+class MulticastMemory;
 class NcclCommunicator;
+class OptimizationProfileSelector;
 class RuntimeBuffers;
 class TllmRuntime;
 
@@ -88,6 +100,32 @@ public:
         SizeType maxSequenceLength;
         bool decoderPerRequest{false};
         bool cudaGraphMode{false};
+        // Maximum number of CUDA graph instances kept across batch size buckets, defaults to one set of
+        // flip-flop instances per power-of-2 bucket up to the generation micro batch size
+        std::optional<SizeType> cudaGraphCacheSize = std::nullopt;
+        // Fraction of the streamable engine weights kept in device memory, the rest is streamed from host memory.
+        // Values below 1 require an engine built with weight streaming enabled.
+        float gpuWeightsPercent{1.0f};
+        // Run `GenerationOutput::onTokenGenerated` on a separate thread. The callback then receives a snapshot of
+        // the output ids in pinned host memory and the next generation step does not wait for it.
+        bool asyncCallbacks{false};
+        // Copy the generation logits of each step to `GenerationOutput::generationLogits` in pinned host memory on a
+        // separate stream, instead of keeping the logits of all steps on the device. Requires an engine that computes
+        // generation logits.
+        bool streamGenerationLogits{false};
+        // Data type of the streamed generation logits, defaults to the logits type of the engine. Float logits may be
+        // narrowed to half or bfloat16 on the device before the copy.
+        std::optional<nvinfer1::DataType> generationLogitsDataType = std::nullopt;
+        // Allocate the fixed size runtime buffers of each micro batch, e.g. the KV cache block pointers and the cache
+        // indirection, in one planned device allocation at setup. Buffers whose lifetimes do not overlap share memory.
+        bool planRuntimeBuffers{false};
+        // Run each engine execution on the optimization profile that was fastest for its number of tokens and batch
+        // size in the first executions, instead of the first profile for the context and the last one for generation.
+        // Allows engines with more than two profiles.
+        bool selectOptimizationProfiles{false};
+        // Bind the session thread, the threads it creates and the pinned host memory to the NUMA node of the device,
+        // see NumaAffinity. The config overrides the node and the CPUs derived from the device.
+        std::optional<AffinityConfig> affinityConfig = std::nullopt;
         KvCacheConfig kvCacheConfig{};
         std::optional<SizeType> ctxMicroBatchSize = std::nullopt;
         std::optional<SizeType> genMicroBatchSize = std::nullopt;
@@ -96,15 +134,44 @@ public:
     };
 
     //! @brief Optional profiler class to profile the generation phase of an inference request
+    //! @details With `recordPhases` it additionally records a timeline of the phases of each generation step.
+    //!          Device phases are timed with CUDA events from a pool that is reused across calls to `generate`, host
+    //!          phases with the host clock. All times are relative to the start of the generation phase.
     class GenerationProfiler
     {
     public:
         // Use a constexpr variable to resolve the ambiguous match for overloaded CudaEvent constructor
         static constexpr unsigned int flags{cudaEventDefault};
 
-        GenerationProfiler()
+        enum class Phase : std::int32_t
+        {
+            // Prepare the inputs of the step, including the KV cache block pointers (device)
+            kPREPARE_STEP = 0,
+            // Capture and update the CUDA graph of the step (host)
+            kGRAPH_CAPTURE = 1,
+            // Wait for the decoder of the previous step and check the finished flags (host). With pipeline
+            // parallelism this includes waiting for the results of the last rank.
+            kSTOP_CHECK = 2,
+            // Enqueue and run the TRT engine (device)
+            kENGINE = 3,
+            // Decoder step, including the transfers between pipeline ranks (device)
+            kDECODER = 4,
+        };
+
+        struct PhaseRecord
+        {
+            Phase phase;
+            SizeType step;
+            SizeType microBatchId;
+            bool onDevice;
+            float startMs;
+            float durationMs;
+        };
+
+        explicit GenerationProfiler(bool recordPhases = false)
             : start(flags)
             , end(flags)
+            , mRecordPhases{recordPhases}
         {
         }
 
@@ -129,9 +196,57 @@ public:
             return result;
         }
 
+        [[nodiscard]] bool recordsPhases() const noexcept
+        {
+            return mRecordPhases;
+        }
+
+        //! @brief Record the start of the generation phase and discard the phases of the previous generation.
+        void startGeneration(CudaStream const& stream);
+
+        //! @brief Begin a phase. Device phases are timed on stream, host phases if stream is nullptr.
+        //! @return Handle to pass to `endPhase`.
+        std::size_t beginPhase(Phase phase, SizeType step, SizeType microBatchId, CudaStream const* stream);
+
+        void endPhase(std::size_t handle, CudaStream const* stream);
+
+        //! @brief Timeline of the last generation. Synchronizes with the end of the generation.
+        [[nodiscard]] std::vector<PhaseRecord> getPhases();
+
+        //! @brief Write the timeline of the last generation in the Chrome trace event format.
+        void writeChromeTrace(std::ostream& os);
+
+        //! @brief Write the timeline of the last generation as CSV.
+        void writeCsv(std::ostream& os);
+
+        [[nodiscard]] static char const* getPhaseName(Phase phase);
+
     private:
+        using Clock = std::chrono::steady_clock;
+
+        struct PendingPhase
+        {
+            Phase phase;
+            SizeType step;
+            SizeType microBatchId;
+            bool onDevice;
+            // indices into mEventPool for device phases
+            std::size_t beginEvent{0};
+            std::size_t endEvent{0};
+            Clock::time_point beginTime{};
+            Clock::time_point endTime{};
+        };
+
+        std::size_t acquireEvent(CudaStream const& stream);
+
         CudaEvent start;
         CudaEvent end;
+        bool mRecordPhases;
+        Clock::time_point mStartTime{};
+        std::vector<PendingPhase> mPhases;
+        // events are reused across generations, mNumUsedEvents are taken by the current one
+        std::vector<CudaEvent> mEventPool;
+        std::size_t mNumUsedEvents{0};
     };
 
     GptSession(Config const& sessionConfig, GptModelConfig const& modelConfig, WorldConfig const& worldConfig,
@@ -144,11 +259,11 @@ public:
     {
     }
 
+    //! @brief Load the engine from a memory-mapped file.
+    //! @details The engine is read through the page cache, which is shared with other processes and stays warm
+    //!          across restarts, and never copied into a private buffer.
     GptSession(Config const& sessionConfig, GptModelConfig const& modelConfig, WorldConfig const& worldConfig,
-        std::string const& engineFile, LoggerPtr logger = nullptr)
-        : GptSession(sessionConfig, modelConfig, worldConfig, utils::loadEngine(engineFile), std::move(logger))
-    {
-    }
+        std::string const& engineFile, LoggerPtr logger = nullptr);
 
     [[nodiscard]] nvinfer1::ILogger& getLogger() const;
 
@@ -179,10 +294,25 @@ public:
     void generate(GenerationOutput& outputs, GenerationInput const& inputs, SamplingConfig const& samplingConfig,
         std::shared_ptr<GenerationProfiler> const generationProfiler = nullptr);
 
+    //! @brief Run the prompts through an engine that outputs hidden states and pool them into one embedding each.
+    //! @details No tokens are generated. embeddings must be a float tensor and is reshaped to
+    //!          [batchSize, hiddenSize]. Requires an engine built with gather_hidden_states and no pipeline
+    //!          parallelism.
+    void computeEmbeddings(
+        TensorPtr const& embeddings, GenerationInput const& inputs, EmbeddingPooling pooling, bool normalize = false);
+
+    //! @brief Replace weights of a refittable engine without rebuilding it, e.g. to roll out fine-tuned weights.
+    //! @details Weights are identified by their refittable names in the engine. Must not be called concurrently
+    //!          with `generate`.
+    void refitWeights(StringPtrMap<ITensor> const& weights);
+
 private:
+    GptSession(Config const& sessionConfig, GptModelConfig const& modelConfig, WorldConfig const& worldConfig,
+        utils::MappedFile const& engineFile, LoggerPtr logger);
+
     [[nodiscard]] bool useCudaGraphs()
     {
-        return !mCudaGraphInstances.empty();
+        return mCudaGraphInstances.has_value();
     }
 
     void generateBatched(std::vector<GenerationOutput>& microBatchesOutputs,
@@ -204,7 +334,7 @@ private:
         std::vector<SizeType> const& generationBatchesOffsets, KvCacheManager const* kvCacheManager);
     SizeType executeGenerationStep(SizeType step, std::vector<GenerationInput> const& microBatchesInputs,
         std::vector<GenerationOutput>& microBatchesOutputs, std::vector<SizeType> const& microBatchOffsets,
-        KvCacheManager* kvCacheManager, std::vector<bool>& microBatchesFinished);
+        KvCacheManager* kvCacheManager, std::vector<bool>& microBatchesFinished, GenerationProfiler* profiler);
 
     //! @brief Execute decoder on last PP rank, receive decoder output on other PP ranks.
     void decoderStepAsync(SizeType decoderStep, SizeType microBatchId);
@@ -228,6 +358,8 @@ private:
     {
     public:
         CudaGraphExecutor() = default;
+        CudaGraphExecutor(CudaGraphExecutor const&) = delete;
+        CudaGraphExecutor& operator=(CudaGraphExecutor const&) = delete;
 
         ~CudaGraphExecutor()
         {
@@ -255,7 +387,46 @@ private:
         bool update(cudaGraph_t const& graph);
         void uploadToStream(CudaStream const& stream);
 
-        cudaGraphExec_t mInstance;
+        cudaGraphExec_t mInstance{nullptr};
+    };
+
+    //! @brief LRU cache of graph instances keyed by batch size bucket, context id and graph id.
+    //! @details Batches with sizes in the same power-of-2 bucket share an instance, and instances are kept across
+    //! calls to `generate`. A new capture can then usually be applied with a cheap `cudaGraphExecUpdate` instead of
+    //! instantiating a new executable graph whenever the batch size changes.
+    class CudaGraphExecutorCache
+    {
+    public:
+        explicit CudaGraphExecutorCache(SizeType capacity);
+
+        //! @brief Get the instance for a batch, creating an empty one and evicting the least recently used instance
+        //! if the cache is full.
+        CudaGraphExecutor& get(SizeType batchSize, SizeType contextId, SizeType graphId);
+
+        void clear();
+
+        [[nodiscard]] SizeType size() const
+        {
+            return static_cast<SizeType>(mEntries.size());
+        }
+
+        //! @brief Smallest power of 2 greater than or equal to batchSize.
+        [[nodiscard]] static SizeType getBatchSizeBucket(SizeType batchSize);
+
+    private:
+        // (batch size bucket, context id, graph id)
+        using Key = std::tuple<SizeType, SizeType, SizeType>;
+
+        struct Entry
+        {
+            Key key;
+            CudaGraphExecutor executor;
+        };
+
+        SizeType mCapacity;
+        // most recently used first
+        std::list<Entry> mEntries;
+        std::map<Key, std::list<Entry>::iterator> mIndex;
     };
 
     class MicroBatchConfig
@@ -302,6 +473,8 @@ private:
     // tensor parallelism with custom allreduce plugin
     ITensor::SharedPtr mCommPtrs;
     std::vector<std::shared_ptr<IpcMemory>> mIpcMemoryHandles;
+    // NVLS buffers paired with the ping and pong buffers, empty if the node does not support multicast
+    std::vector<std::shared_ptr<MulticastMemory>> mMulticastMemoryHandles;
 
     SizeType mDecoderMaxSequenceLength{};
     SizeType mDecoderMaxAttentionWindow{};
@@ -318,10 +491,20 @@ private:
     std::vector<CudaEvent> mReceivedEvents;
 
     bool mCudaGraphMode{false};
-    // ping-pong instances
-    std::vector<CudaGraphExecutor> mCudaGraphInstances;
+    // ping-pong instances for each batch size bucket
+    std::optional<CudaGraphExecutorCache> mCudaGraphInstances;
 
     bool mNormalizeLogProbs = true;
+
+    bool mAsyncCallbacks{false};
+    // worker of the current call to generate in async callback mode
+    std::shared_ptr<AsyncTokenCallback> mAsyncTokenCallback;
+
+    // copies the generation logits to host memory if streamGenerationLogits is enabled
+    std::shared_ptr<GenerationLogitsStreamer> mLogitsStreamer;
+
+    // selects the context of each execution if selectOptimizationProfiles is enabled
+    std::shared_ptr<OptimizationProfileSelector> mProfileSelector;
 };
 
 } // namespace tensorrt_llm::runtime
@@ -20,6 +20,7 @@
 #include "tensorrt_llm/runtime/cudaStream.h"
 #include "tensorrt_llm/runtime/iStatefulGptDecoder.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/logitsPostProcessor.h"
 #include "tensorrt_llm/runtime/utils/sessionUtils.h"
 
 #include <memory>
@@ -68,6 +69,11 @@ public:
     TensorPtr embeddingBias; // [vocabSizePadded], on gpu
     TensorPtr badWordsList;  // [2, badWordsLength], on gpu
     TensorPtr stopWordsList; // [2, stopWordsLength], on gpu
+    // Aho-Corasick automata built by kernels::buildAhoCorasick, matched in O(1) per step instead of the lists above,
+    // only for beam width 1, on gpu
+    TensorPtr stopWordsAutomaton;
+    TensorPtr badWordsAutomaton;
+    LogitsPostProcessorPtr logitsPostProcessor; // applied to the logits of this request before sampling, on gpu
 
     bool computeCumLogProbs; // boolean that controls if cumLogProbs should be computed for that request
     bool computeLogProbs;    // boolean that controls if cumLogProbs should be computed for that request
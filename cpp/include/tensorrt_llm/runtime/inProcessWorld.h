@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/worldConfig.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Runs the ranks of a model as threads of a single process, one thread per GPU, instead of one MPI process
+//! per GPU.
+//! \details run starts a thread per rank, sets the device of the rank and calls the function of the rank with its
+//! WorldConfig. The exchanges that go through MPI across processes, the NCCL unique ids, the IPC buffers of the custom
+//! all-reduce and the requests of an iteration, go through the memory of the process instead, see allgather and
+//! getShared. The NCCL registry, the plugins and IpcMemory look up the world of the calling thread with getCurrent,
+//! so the engines and sessions of a rank must be created and run on the thread of the rank.
+class InProcessWorld
+{
+public:
+    using RankFunc = std::function<void(WorldConfig const& worldConfig)>;
+
+    //! \param deviceIds Devices of the ranks, defaults to the first ranks of the node.
+    explicit InProcessWorld(SizeType tensorParallelism, SizeType pipelineParallelism = 1,
+        SizeType contextParallelism = 1, std::optional<std::vector<SizeType>> const& deviceIds = std::nullopt);
+
+    InProcessWorld(InProcessWorld const&) = delete;
+    InProcessWorld& operator=(InProcessWorld const&) = delete;
+
+    [[nodiscard]] SizeType getSize() const noexcept
+    {
+        return mWorldConfig.getSize();
+    }
+
+    //! \brief WorldConfig of rank.
+    [[nodiscard]] WorldConfig getWorldConfig(SizeType rank) const;
+
+    //! \brief Call func on every rank, each one on its own thread, and return when all calls returned.
+    //! \details If calls throw, the first exception is rethrown. A rank that throws leaves the others blocked in their
+    //! collectives, func must not fail on some ranks only.
+    void run(RankFunc const& func);
+
+    //! \brief World of the calling thread, nullptr outside of run.
+    [[nodiscard]] static InProcessWorld* getCurrent() noexcept;
+
+    //! \brief Rank of the calling thread in its world, nothing outside of run.
+    [[nodiscard]] static std::optional<SizeType> getCurrentRank() noexcept;
+
+    //! \brief Rank of the calling thread in the session, its in-process rank or else its MPI rank.
+    [[nodiscard]] static SizeType getSessionRank();
+
+    //! \brief Gather the data of every rank of group on every rank of group, ordered by rank.
+    //! \details Collective over the ranks of group, which must include the calling rank. The calls of a rank with the
+    //! same group are matched in order with the calls of the other ranks of the group.
+    std::vector<std::vector<char>> allgather(std::set<int> const& group, std::vector<char> data);
+
+    //! \brief Value of the first rank of group on every rank of group, collective over group.
+    template <typename T>
+    T broadcastValue(std::set<int> const& group, T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::vector<char> data(sizeof(T));
+        std::memcpy(data.data(), &value, sizeof(T));
+        auto const parts = allgather(group, std::move(data));
+        T result;
+        std::memcpy(&result, parts.front().data(), sizeof(T));
+        return result;
+    }
+
+    //! \brief Object named key, shared by all the ranks, created with factory by the first rank that asks for it.
+    template <typename T>
+    std::shared_ptr<T> getShared(std::string const& key, std::function<std::shared_ptr<T>()> const& factory)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& object = mShared[key];
+        if (!object)
+        {
+            object = factory();
+        }
+        return std::static_pointer_cast<T>(object);
+    }
+
+private:
+    struct Exchange
+    {
+        std::vector<std::vector<char>> parts;
+        SizeType numArrived{0};
+        SizeType numDeparted{0};
+    };
+
+    WorldConfig mWorldConfig;
+    std::optional<std::vector<SizeType>> mDeviceIds;
+
+    std::mutex mMutex;
+    std::condition_variable mExchanged;
+    // Exchanges in progress, by group and number of the call
+    std::map<std::pair<std::set<int>, std::uint64_t>, Exchange> mExchanges;
+    // Number of the next call of a rank with a group
+    std::map<std::pair<std::set<int>, int>, std::uint64_t> mNumCalls;
+    std::map<std::string, std::shared_ptr<void>> mShared;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstdint>
+#include <cuda_runtime_api.h>
+#include <deque>
+#include <optional>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Location and layout of a tensor in an IpcTensorArena, a plain struct that can be sent in a message of a
+//! common::ShmRingBuffer next to the serialized request or response it belongs to.
+struct IpcTensorDesc
+{
+    std::uint64_t offset;
+    std::uint64_t numBytes;
+    nvinfer1::DataType dataType;
+    ITensor::Shape shape;
+};
+
+//! \brief Device memory shared by two processes of the same node, to pass large tensors such as prompt embeddings or
+//! logits without a copy through the host.
+//! \details The owner allocates the arena and sends its handle once, the peer opens it once, so that no tensor pays
+//! for cudaIpcOpenMemHandle. The owner copies tensors in with put() and sends their descriptions, the peer wraps them
+//! with view(). Tensors are allocated in FIFO order and must be released in the order they were put, after the peer
+//! reported that it is done with them.
+class IpcTensorArena
+{
+public:
+    //! \brief Allocate an arena of capacity bytes on the current device.
+    explicit IpcTensorArena(std::size_t capacity);
+
+    //! \brief Open the arena of another process from the handle returned by its getHandle().
+    IpcTensorArena(cudaIpcMemHandle_t const& handle, std::size_t capacity);
+
+    ~IpcTensorArena();
+
+    IpcTensorArena(IpcTensorArena const&) = delete;
+    IpcTensorArena& operator=(IpcTensorArena const&) = delete;
+
+    [[nodiscard]] cudaIpcMemHandle_t getHandle() const;
+
+    [[nodiscard]] std::size_t getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    //! \brief Copy tensor into the arena on stream, owner only. The stream must be synchronized before the
+    //! description is sent.
+    //! \returns nothing if the arena has no room for the tensor
+    std::optional<IpcTensorDesc> put(ITensor const& tensor, CudaStream const& stream);
+
+    //! \brief Release the oldest tensor put in the arena, owner only.
+    void release(IpcTensorDesc const& desc);
+
+    //! \brief Tensor pointing at desc in the arena, valid until desc is released.
+    [[nodiscard]] ITensor::SharedPtr view(IpcTensorDesc const& desc) const;
+
+private:
+    // Allocations are aligned so that any data type can be read from a view
+    static std::size_t constexpr kAlignment{256};
+
+    struct Allocation
+    {
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    std::size_t mCapacity;
+    bool mOwner;
+    void* mData{nullptr};
+    // Monotonic byte positions of the live allocations, the offset in the arena is the position modulo capacity
+    std::deque<Allocation> mAllocations;
+    std::uint64_t mHead{0};
+};
+
+} // namespace tensorrt_llm::runtime
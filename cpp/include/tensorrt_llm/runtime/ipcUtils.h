@@ -21,6 +21,14 @@
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
+#include <cstdint>
+#include <memory>
+
+namespace tensorrt_llm::common
+{
+class CUDADriverWrapper;
+}
+
 namespace tensorrt_llm::runtime
 {
 
@@ -49,6 +57,56 @@ private:
     std::vector<void*> mCommPtrs;
     std::size_t mBufferSize;
     void* mBufferPtr{nullptr};
+    // The peers are ranks of the same InProcessWorld, their buffers are not IPC mappings
+    bool mInProcess{false};
+};
+
+//! \brief Buffer of the tensor parallel ranks of a node bound to an NVLink multicast object, for the NVLS all-reduce.
+//! \details Every rank maps its own part of the buffer, the unicast address, and the multicast address, through which
+//! the multimem instructions reduce the parts of all the ranks in the NVSwitch and store the result to all of them.
+//! The buffer is paired with an IPC buffer of the custom all-reduce workspace, so that the plugins find it from the
+//! workspace, see find.
+class MulticastMemory
+{
+public:
+    //! \brief Creates the buffer paired with the local IPC buffer ipcBuffer, collective over the tensor parallel ranks
+    //! of the node.
+    //! \returns nullptr on all the ranks if one of them does not support multicast objects
+    static std::shared_ptr<MulticastMemory> create(
+        WorldConfig const& worldConfig, void const* ipcBuffer, std::size_t bufferSize);
+
+    //! \brief Buffer paired with the local IPC buffer ipcBuffer, nullptr if there is none.
+    static MulticastMemory const* find(void const* ipcBuffer);
+
+    ~MulticastMemory();
+
+    MulticastMemory(MulticastMemory const&) = delete;
+    MulticastMemory& operator=(MulticastMemory const&) = delete;
+
+    [[nodiscard]] void* getUnicastPtr() const
+    {
+        return reinterpret_cast<void*>(mUnicastPtr);
+    }
+
+    [[nodiscard]] void* getMulticastPtr() const
+    {
+        return reinterpret_cast<void*>(mMulticastPtr);
+    }
+
+private:
+    MulticastMemory(std::shared_ptr<common::CUDADriverWrapper> driver, int device, void const* ipcBuffer,
+        std::size_t size, std::uint64_t multicastHandle);
+
+    std::shared_ptr<common::CUDADriverWrapper> mDriver;
+    // CUdevice
+    int mDevice;
+    void const* mIpcBuffer;
+    std::size_t mSize;
+    // CUmemGenericAllocationHandle and CUdeviceptr
+    std::uint64_t mMulticastHandle;
+    std::uint64_t mMemoryHandle{0};
+    std::uint64_t mUnicastPtr{0};
+    std::uint64_t mMulticastPtr{0};
 };
 
 } // namespace tensorrt_llm::runtime
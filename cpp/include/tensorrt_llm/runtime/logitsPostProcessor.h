@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cuda_runtime_api.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Callable that modifies the logits of the requests it is registered for, before sampling.
+//! \details It is invoked by the decoder after penalties and bad words have been applied and must only enqueue work
+//! on the given stream, e.g. launch a kernel, so that the logits never leave the device.
+//! \param logits [batchSize, beamWidth, vocabSizePadded], on gpu, modified in place for the whole batch
+//! \param batchSlots [batchSize], seq slot of each batch entry, int32_t, in pinned memory
+//! \param batchIndices batch entries of the requests that registered this processor, on cpu
+//! \param stream the stream of the decoder
+using LogitsPostProcessor = std::function<void(
+    ITensor& logits, ITensor const& batchSlots, std::vector<SizeType> const& batchIndices, cudaStream_t stream)>;
+
+//! \brief Requests sharing the same processor object are handed to it in a single call.
+using LogitsPostProcessorPtr = std::shared_ptr<LogitsPostProcessor const>;
+
+} // namespace tensorrt_llm::runtime
@@ -19,9 +19,14 @@
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace tensorrt_llm::runtime
 {
@@ -138,6 +143,122 @@ public:
 
     void deallocate(MemoryType memoryType, SizeType size);
 
+    //! \brief Bytes of slabs reserved by the size-class pools of the given memory type.
+    [[nodiscard]] SizeType getSlabReserved(MemoryType memoryType) const
+    {
+        return mSlabReserved[static_cast<std::size_t>(memoryType)];
+    }
+
+    //! \brief Bytes of slab blocks handed out by the size-class pools of the given memory type.
+    [[nodiscard]] SizeType getSlabUsed(MemoryType memoryType) const
+    {
+        return mSlabUsed[static_cast<std::size_t>(memoryType)];
+    }
+
+    //! \brief Fraction of the reserved slab memory that is not handed out, 0 if no slab is reserved.
+    [[nodiscard]] double getSlabFragmentation(MemoryType memoryType) const
+    {
+        auto const reserved = getSlabReserved(memoryType);
+        return reserved > 0 ? 1.0 - static_cast<double>(getSlabUsed(memoryType)) / static_cast<double>(reserved)
+                            : 0.0;
+    }
+
+    void reserveSlab(MemoryType memoryType, SizeType size)
+    {
+        mSlabReserved[static_cast<std::size_t>(memoryType)] += size;
+    }
+
+    void releaseSlab(MemoryType memoryType, SizeType size)
+    {
+        mSlabReserved[static_cast<std::size_t>(memoryType)] -= size;
+    }
+
+    void allocateSlabBlock(MemoryType memoryType, SizeType size)
+    {
+        mSlabUsed[static_cast<std::size_t>(memoryType)] += size;
+    }
+
+    void deallocateSlabBlock(MemoryType memoryType, SizeType size)
+    {
+        mSlabUsed[static_cast<std::size_t>(memoryType)] -= size;
+    }
+
+    //! \brief Identifies the subsystem an allocation belongs to, e.g. the KV cache or the decoder.
+    using TagId = std::uint32_t;
+    static TagId constexpr kUntagged{0};
+    static std::size_t constexpr kMaxTags{64};
+
+    struct TagStats
+    {
+        std::string name;
+        MemoryType memoryType;
+        SizeType current;
+        SizeType peak;
+    };
+
+    //! \brief Id of the tag `name`, registering it on first use.
+    [[nodiscard]] TagId getTagId(std::string const& name);
+
+    [[nodiscard]] std::string const& getTagName(TagId tag) const;
+
+    void allocateTagged(MemoryType memoryType, TagId tag, SizeType size)
+    {
+        auto& counters = getTagCounters(tag);
+        auto const typeIdx = static_cast<std::size_t>(memoryType);
+        auto const current = counters.current[typeIdx] += size;
+        auto peak = counters.peak[typeIdx].load(std::memory_order_relaxed);
+        while (current > peak && !counters.peak[typeIdx].compare_exchange_weak(peak, current))
+        {
+        }
+    }
+
+    void deallocateTagged(MemoryType memoryType, TagId tag, SizeType size)
+    {
+        getTagCounters(tag).current[static_cast<std::size_t>(memoryType)] -= size;
+    }
+
+    [[nodiscard]] SizeType getTagged(MemoryType memoryType, TagId tag) const
+    {
+        return getTagCounters(tag).current[static_cast<std::size_t>(memoryType)];
+    }
+
+    [[nodiscard]] SizeType getTaggedPeak(MemoryType memoryType, TagId tag) const
+    {
+        return getTagCounters(tag).peak[static_cast<std::size_t>(memoryType)];
+    }
+
+    //! \brief Current and peak usage of every tag and memory type that has been used.
+    [[nodiscard]] std::vector<TagStats> getTagStats() const;
+
+    //! \brief Reset the peaks of all tags to their current usage.
+    void resetTagPeaks();
+
+    //! \brief Human readable dump of getTagStats(), one line per tag and memory type.
+    [[nodiscard]] std::string tagsToString() const;
+
+    //! \brief Tag applied to buffers allocated through the BufferManager by the calling thread without explicit tag.
+    [[nodiscard]] static TagId getCurrentTag();
+
+    //! \brief Sets the current tag of the calling thread for the lifetime of the object.
+    class ScopedTag
+    {
+    public:
+        explicit ScopedTag(TagId tag);
+
+        explicit ScopedTag(std::string const& name)
+            : ScopedTag{getInstance().getTagId(name)}
+        {
+        }
+
+        ~ScopedTag();
+
+        ScopedTag(ScopedTag const&) = delete;
+        ScopedTag& operator=(ScopedTag const&) = delete;
+
+    private:
+        TagId mPrevious;
+    };
+
     static MemoryCounters& getInstance();
 
     static std::string bytesToString(SizeType bytes, int precision = 2);
@@ -149,6 +270,32 @@ public:
 private:
     std::atomic<SizeType> mGpu{}, mCpu{}, mPinned{}, mUVM{};
     std::atomic<DiffType> mGpuDiff{}, mCpuDiff{}, mPinnedDiff{}, mUVMDiff{};
+    // Slab statistics of the size-class pools, indexed by memory type
+    std::array<std::atomic<SizeType>, 4> mSlabReserved{}, mSlabUsed{};
+
+    struct TagCounters
+    {
+        std::array<std::atomic<SizeType>, 4> current{}, peak{};
+    };
+
+    [[nodiscard]] TagCounters& getTagCounters(TagId tag)
+    {
+        TLLM_CHECK_WITH_INFO(tag < mNumTags.load(std::memory_order_acquire), "Unknown memory tag %u", tag);
+        return mTagCounters[tag];
+    }
+
+    [[nodiscard]] TagCounters const& getTagCounters(TagId tag) const
+    {
+        TLLM_CHECK_WITH_INFO(tag < mNumTags.load(std::memory_order_acquire), "Unknown memory tag %u", tag);
+        return mTagCounters[tag];
+    }
+
+    // Fixed capacity so that counters can be updated without locking while tags are registered
+    std::array<TagCounters, kMaxTags> mTagCounters{};
+    std::array<std::string, kMaxTags> mTagNames{"untagged"};
+    std::atomic<TagId> mNumTags{1};
+    std::unordered_map<std::string, TagId> mTagIds{{"untagged", kUntagged}};
+    std::mutex mutable mTagLock{};
 };
 
 } // namespace tensorrt_llm::runtime
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/iBuffer.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+#include <cuda_runtime_api.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Records every allocation and free of the counted allocators, i.e. of the BufferManager, to find which
+//! buffers are alive together at the peak of the memory usage.
+//! \details Disabled by default, the allocators then only pay for one relaxed load. It is enabled by setting
+//! TRTLLM_MEMORY_TIMELINE to the path of the file written at exit, or with setEnabled. Allocations served from the
+//! memory pools of the runtime are not recorded, the chunks of the pools are.
+class MemoryTimeline
+{
+public:
+    using SizeType = MemoryCounters::SizeType;
+    using TagId = MemoryCounters::TagId;
+
+    //! \brief Return addresses kept per allocation to identify its call site.
+    static std::size_t constexpr kCallSiteDepth{8};
+
+    struct Event
+    {
+        std::int64_t timestampNs;
+        void const* ptr;
+        SizeType size;
+        MemoryType memoryType;
+        bool allocation;
+        TagId tag;
+        cudaStream_t stream;
+        std::array<void*, kCallSiteDepth> callSite;
+    };
+
+    //! \brief Live buffers of a memory type at the moment its usage peaked.
+    struct PeakSnapshot
+    {
+        MemoryType memoryType;
+        SizeType bytes;
+        std::int64_t timestampNs;
+        std::vector<Event> allocations;
+    };
+
+    static MemoryTimeline& getInstance();
+
+    [[nodiscard]] bool isEnabled() const
+    {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled)
+    {
+        mEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    //! \brief Record an allocation, tagged with the current tag of MemoryCounters.
+    void recordAllocation(MemoryType memoryType, void const* ptr, SizeType size, cudaStream_t stream = nullptr);
+
+    //! \brief Record a free. Buffers allocated before recording started are ignored.
+    void recordFree(MemoryType memoryType, void const* ptr, cudaStream_t stream = nullptr);
+
+    //! \brief Copy of the recorded events, in order.
+    [[nodiscard]] std::vector<Event> getEvents() const;
+
+    //! \brief Live allocations at the first time each memory type reached its peak usage, largest first. Only memory
+    //! types with recorded allocations are reported.
+    [[nodiscard]] std::vector<PeakSnapshot> getPeakSnapshots() const;
+
+    //! \brief Write the timeline as Chrome trace JSON, one counter track per memory type with the bytes of every tag,
+    //! and the peak snapshots under "peaks" with the symbolized call site of every live buffer.
+    void dump(std::ostream& os) const;
+
+    void dump(std::string const& path) const;
+
+    //! \brief Drop the recorded events and the known live buffers.
+    void clear();
+
+private:
+    MemoryTimeline() = default;
+
+    std::atomic<bool> mEnabled{false};
+    std::mutex mutable mMutex;
+    std::vector<Event> mEvents;
+    // Index of the allocation event of every live buffer, to match frees without a size
+    std::unordered_map<void const*, std::size_t> mLive;
+};
+
+} // namespace tensorrt_llm::runtime
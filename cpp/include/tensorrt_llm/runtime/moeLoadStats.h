@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Process-wide counters of the rows the MoE layers route to each expert.
+//! \details The MoE plugins with a layer index add to the counters of their layer on the device, in the routing of
+//! each enqueue. The counters are in managed memory, so collecting them is a host read without a copy kernel.
+class MoeLoadStatsCollector
+{
+public:
+    static MoeLoadStatsCollector& getInstance();
+
+    //! \brief Device pointer to the numExperts counters of a layer, allocated and zeroed on the first call.
+    [[nodiscard]] std::int64_t* getLayerCounters(SizeType layerIdx, SizeType numExperts);
+
+    //! \brief Add the load since the previous call to stats and reset the counters.
+    //! \details The streams the MoE layers ran on must be synchronized.
+    void collect(executor::MoeLoadStats& stats);
+
+    [[nodiscard]] bool empty() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mLayerCounters.empty();
+    }
+
+private:
+    MoeLoadStatsCollector() = default;
+
+    mutable std::mutex mMutex;
+    std::map<SizeType, IBuffer::UniquePtr> mLayerCounters;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Overrides of the host placement derived from the GPU, see NumaAffinity::apply.
+struct AffinityConfig
+{
+    //! NUMA node of the pinned host memory, defaults to the node the GPU is attached to.
+    std::optional<SizeType> numaNode = std::nullopt;
+    //! CPUs of the host threads, defaults to the CPUs local to the GPU.
+    std::optional<std::vector<SizeType>> cpus = std::nullopt;
+};
+
+//! \brief Places the host threads and the pinned host memory of a GPU on the NUMA node the GPU is attached to.
+//! \details On hosts with several sockets, threads and pinned buffers otherwise end up on whichever node the OS picks,
+//! and host to device copies cross the socket interconnect. The node and the local CPUs of a GPU are read from sysfs
+//! through its PCI bus id. Threads are bound with the CPU affinity of the calling thread, which the threads it creates
+//! afterwards inherit. Pinned memory of the PinnedAllocator is bound to the configured node with mbind and registered
+//! with CUDA instead of coming from cudaHostAlloc. Linux only, elsewhere the locality is unknown and nothing is bound.
+class NumaAffinity
+{
+public:
+    struct DeviceLocality
+    {
+        SizeType numaNode;
+        std::vector<SizeType> cpus;
+    };
+
+    static NumaAffinity& getInstance();
+
+    //! \brief Locality of a CUDA device, nothing if the platform does not report it, e.g. on a single node host.
+    [[nodiscard]] static std::optional<DeviceLocality> getDeviceLocality(int device);
+
+    //! \brief Locality of the PCI device pciBusId, e.g. "0000:3B:00.0", read from sysfsRoot.
+    [[nodiscard]] static std::optional<DeviceLocality> getDeviceLocality(
+        std::string const& pciBusId, std::filesystem::path const& sysfsRoot = "/sys/bus/pci/devices");
+
+    //! \brief Parse a kernel CPU list, e.g. "0-15,32-47".
+    [[nodiscard]] static std::vector<SizeType> parseCpuList(std::string const& cpuList);
+
+    //! \brief Bind the calling thread to cpus, threads it creates afterwards inherit the binding.
+    //! \return False if the binding was rejected, e.g. by the cpuset of a container.
+    static bool bindCurrentThread(std::vector<SizeType> const& cpus);
+
+    //! \brief Bind the calling thread and the pinned memory to the locality of device, with the overrides of config.
+    //! \return The applied locality, nothing if neither the device nor the config provides one.
+    std::optional<DeviceLocality> apply(int device, AffinityConfig const& config = {});
+
+    //! \brief Node of the pinned allocations from now on, nothing leaves the placement to the OS.
+    void setPinnedMemoryNode(std::optional<SizeType> node);
+
+    [[nodiscard]] std::optional<SizeType> getPinnedMemoryNode() const
+    {
+        auto const node = mPinnedMemoryNode.load(std::memory_order_relaxed);
+        return node < 0 ? std::nullopt : std::optional<SizeType>{node};
+    }
+
+    //! \brief Allocate size bytes of pinned memory on node.
+    [[nodiscard]] void* allocatePinned(std::size_t size, SizeType node);
+
+    //! \brief Free ptr if it was allocated with allocatePinned.
+    //! \return False if ptr was not allocated with allocatePinned and must be freed by the caller.
+    bool freePinned(void* ptr, std::size_t size);
+
+private:
+    NumaAffinity() = default;
+
+    std::atomic<SizeType> mPinnedMemoryNode{-1};
+    // Set on the first node local allocation, frees of other pinned memory skip the lookup until then
+    std::atomic<bool> mHasNodeAllocations{false};
+    std::mutex mMutex;
+    std::unordered_set<void*> mNodeAllocations;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -75,6 +75,9 @@ public:
         normalizeLogProbs = configs.front().normalizeLogProbs;
         temperature = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].temperature; });
         minLength = fuseValues<SizeType>(configs, [&configs](SizeType ci) { return configs[ci].minLength; });
+        logitsSoftCap = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].logitsSoftCap; });
+        allowedTokens
+            = fuseValues<Vec<SizeType>>(configs, [&configs](SizeType ci) { return configs[ci].allowedTokens; });
         repetitionPenalty
             = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].repetitionPenalty; });
         presencePenalty
@@ -85,6 +88,8 @@ public:
         topPDecay = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].topPDecay; });
         topPMin = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].topPMin; });
         topPResetIds = fuseValues<SizeType>(configs, [&configs](SizeType ci) { return configs[ci].topPResetIds; });
+        minP = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].minP; });
+        typicalP = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].typicalP; });
         beamSearchDiversityRate
             = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].beamSearchDiversityRate; });
         lengthPenalty = fuseValues<FloatType>(configs, [&configs](SizeType ci) { return configs[ci].lengthPenalty; });
@@ -135,6 +140,9 @@ public:
     OptVec<FloatType> repetitionPenalty; // [1] or [batch_size] on cpu
     OptVec<FloatType> presencePenalty;   // [1] or [batch_size] on cpu
     OptVec<FloatType> frequencyPenalty;  // [1] or [batch_size] on cpu
+    OptVec<FloatType> logitsSoftCap;     // [1] or [batch_size] on cpu, cap * tanh(logits / cap) if cap > 0
+    // [1] or [batch_size] on cpu, token ids the request may generate, an empty list allows the whole vocabulary
+    OptVec<Vec<SizeType>> allowedTokens;
 
     // sampling layers
     OptVec<SizeType> topK;         // [1] or [batch_size] on cpu
@@ -143,11 +151,15 @@ public:
     OptVec<FloatType> topPDecay;   // [batch_size], must between [0, 1]
     OptVec<FloatType> topPMin;     // [batch_size], must between [0, 1]
     OptVec<SizeType> topPResetIds; // [batch_size]
+    OptVec<FloatType> minP;        // [1] or [batch_size] on cpu, used with DecodingMode::MinP
+    OptVec<FloatType> typicalP;    // [1] or [batch_size] on cpu, used with DecodingMode::TypicalP
 
     // beam search layer
     OptVec<FloatType> beamSearchDiversityRate; // [1] or [batch_size]
     OptVec<FloatType> lengthPenalty;           // [1] or [batch_size]
-    OptVec<SizeType> earlyStopping;            // [1] or [batch_size]
+    // [1] or [batch_size], when beam search stops once beamWidth beams are finished: 1 right away, 0 once the best
+    // live beam cannot beat them at its current length, any other value once it cannot beat them at any length
+    OptVec<SizeType> earlyStopping;
 
     // speculative decoding, only the first value is used (in gptDecoderBatch.cpp)
     OptVec<FloatType> draftAcceptanceThreshold; // [1] or [batch_size]
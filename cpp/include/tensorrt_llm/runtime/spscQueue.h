@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief A bounded lock-free queue between one producer thread and one consumer thread.
+//! \details The slots form a ring indexed by two counters, the producer only writes the tail and the consumer only
+//! writes the head, so neither operation takes a lock or waits for the other thread.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : mSlots(capacity + 1)
+    {
+        TLLM_CHECK_WITH_INFO(capacity > 0, "Queue capacity must be positive");
+    }
+
+    SpscQueue(SpscQueue const&) = delete;
+    SpscQueue& operator=(SpscQueue const&) = delete;
+
+    [[nodiscard]] std::size_t getCapacity() const noexcept
+    {
+        return mSlots.size() - 1;
+    }
+
+    //! \brief Append value, producer only.
+    //! \return False if the queue is full, value is left untouched then.
+    bool tryPush(T&& value)
+    {
+        auto const tail = mTail.load(std::memory_order_relaxed);
+        auto const next = advance(tail);
+        if (next == mHead.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        mSlots[tail] = std::move(value);
+        mTail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Remove the oldest value, consumer only.
+    //! \return Nothing if the queue is empty.
+    std::optional<T> tryPop()
+    {
+        auto const head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+        {
+            return std::nullopt;
+        }
+        std::optional<T> value{std::move(mSlots[head])};
+        mSlots[head] = T{};
+        mHead.store(advance(head), std::memory_order_release);
+        return value;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+private:
+    [[nodiscard]] std::size_t advance(std::size_t idx) const noexcept
+    {
+        return idx + 1 == mSlots.size() ? 0 : idx + 1;
+    }
+
+    // One slot stays free to tell a full queue from an empty one
+    std::vector<T> mSlots;
+    // The counters are on their own cache lines, the producer and the consumer do not share one
+    alignas(64) std::atomic<std::size_t> mHead{0};
+    alignas(64) std::atomic<std::size_t> mTail{0};
+};
+
+} // namespace tensorrt_llm::runtime
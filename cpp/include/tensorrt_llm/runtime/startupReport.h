@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Host wall time spent in the phases of the startup of the process, e.g. engine deserialization, context
+//! creation, buffer and KV cache allocation and CUDA graph capture.
+//! \details Phases are recorded by name and accumulate, so that every engine or session of the process adds to the
+//! same phase. A phase recorded while another one is running on the same thread is named "outer/inner" and is not
+//! counted in the total.
+class StartupReport
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        double totalMs;
+        std::size_t count;
+        bool nested;
+    };
+
+    static StartupReport& getInstance();
+
+    void record(std::string const& name, double ms, bool nested = false);
+
+    //! \brief Recorded phases, in the order they were first recorded.
+    [[nodiscard]] std::vector<Phase> getPhases() const;
+
+    //! \brief Sum of the phases that are not nested.
+    [[nodiscard]] double getTotalMs() const;
+
+    //! \brief One line per phase with its time and its share of the total.
+    [[nodiscard]] std::string toString() const;
+
+    //! \brief {"total_ms": ..., "phases": [{"name": ..., "ms": ..., "count": ...}, ...]}
+    [[nodiscard]] std::string toJson() const;
+
+    void clear();
+
+    //! \brief Records the time until its destruction as a phase of the report.
+    class ScopedPhase
+    {
+    public:
+        explicit ScopedPhase(char const* name);
+
+        ~ScopedPhase();
+
+        ScopedPhase(ScopedPhase const&) = delete;
+        ScopedPhase& operator=(ScopedPhase const&) = delete;
+
+    private:
+        std::string mName;
+        bool mNested;
+        ScopedPhase* mParent;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+private:
+    StartupReport() = default;
+
+    std::mutex mutable mMutex;
+    std::vector<Phase> mPhases;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief A token produced by the decoder, as published in the TokenStreamRing.
+struct TokenStreamRecord
+{
+    // Position of the record in the stream plus one, 0 while the record is being written
+    std::int64_t sequence;
+    // Batch slot of the request
+    SizeType slot;
+    // Position of the token in the sequence of the request
+    SizeType position;
+    TokenIdType token;
+    // Log probability of the token, only valid if log probs are computed for the request
+    float logProb;
+    // Bits of the FinishedState of the request after this token, 0 if the request is not finished
+    std::int32_t finished;
+    std::int32_t padding;
+};
+
+static_assert(sizeof(TokenStreamRecord) == 32, "TokenStreamRecord must be 32 bytes");
+
+//! \brief Streams the tokens generated by GptDecoderBatch to the host without synchronizing the decoder stream.
+//! \details The records live in a ring of pinned host memory that the gpu writes directly. At the end of each
+//! decoding step a single kernel appends one record per new token and then publishes the new write index. The host
+//! polls the write index and copies the records it has not seen yet. If the host falls behind by more than the
+//! capacity, the oldest records are overwritten and reported as dropped.
+class TokenStreamRing
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    static SizeType constexpr kDefaultCapacity{1 << 16};
+
+    explicit TokenStreamRing(SizeType capacity = kDefaultCapacity);
+
+    //! \brief Append the records published since the last call to records.
+    //! \returns the number of records appended
+    SizeType poll(std::vector<TokenStreamRecord>& records);
+
+    [[nodiscard]] SizeType getCapacity() const
+    {
+        return mCapacity;
+    }
+
+    //! \returns the number of records that were overwritten before they could be polled
+    [[nodiscard]] std::int64_t getNumDropped() const
+    {
+        return mNumDropped;
+    }
+
+    //! \returns [capacity * sizeof(TokenStreamRecord)], records, pinned
+    [[nodiscard]] TensorPtr const& getRecords() const
+    {
+        return mRecords;
+    }
+
+    //! \returns [1], int64_t, number of records written so far, pinned
+    [[nodiscard]] TensorPtr const& getWriteIndex() const
+    {
+        return mWriteIndex;
+    }
+
+private:
+    SizeType mCapacity;
+    TensorPtr mRecords;
+    TensorPtr mWriteIndex;
+    std::int64_t mReadIndex{0};
+    std::int64_t mNumDropped{0};
+};
+
+} // namespace tensorrt_llm::runtime
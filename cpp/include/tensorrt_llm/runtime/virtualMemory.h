@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/cudaDriverWrapper.h"
+
+#include <cuda.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Device buffer with a fixed virtual address range and a physical backing that can grow and shrink.
+//! \details The constructor only reserves maxSizeInBytes of virtual address space. Physical memory is created and
+//! mapped in chunks of getChunkSize() bytes by resize(), so pointers into the buffer stay valid while it grows.
+//! Uses the CUDA virtual memory management API through the driver wrapper.
+class VirtualMemoryBuffer
+{
+public:
+    //! \param maxSizeInBytes Size of the virtual address range, rounded up to the chunk size.
+    //! \param device Device on which the physical memory is allocated.
+    //! \param chunkSize Granularity of resize(), rounded up to the allocation granularity of the device. The
+    //! recommended granularity is used if 0.
+    VirtualMemoryBuffer(std::size_t maxSizeInBytes, int device, std::size_t chunkSize = 0);
+
+    ~VirtualMemoryBuffer();
+
+    VirtualMemoryBuffer(VirtualMemoryBuffer const&) = delete;
+    VirtualMemoryBuffer& operator=(VirtualMemoryBuffer const&) = delete;
+
+    //! \brief Map or unmap chunks such that at least sizeInBytes bytes from the start of the range are backed.
+    //! \details The caller must make sure that no kernel accesses the memory that is unmapped.
+    void resize(std::size_t sizeInBytes);
+
+    [[nodiscard]] void* data() const
+    {
+        return reinterpret_cast<void*>(mBasePtr);
+    }
+
+    //! \brief Number of bytes currently backed by physical memory.
+    [[nodiscard]] std::size_t getMappedSize() const
+    {
+        return mHandles.size() * mChunkSize;
+    }
+
+    [[nodiscard]] std::size_t getReservedSize() const
+    {
+        return mReservedSize;
+    }
+
+    [[nodiscard]] std::size_t getChunkSize() const
+    {
+        return mChunkSize;
+    }
+
+    //! \brief Check whether the driver and the device support virtual memory management.
+    [[nodiscard]] static bool isSupported(int device);
+
+private:
+    void mapChunk();
+    void unmapChunk();
+
+    std::shared_ptr<common::CUDADriverWrapper> mDriver;
+    int mDevice;
+    std::size_t mChunkSize{0};
+    std::size_t mReservedSize{0};
+    CUdeviceptr mBasePtr{0};
+    // Physical allocation of each mapped chunk, in address order
+    std::vector<CUmemGenericAllocationHandle> mHandles;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief A fixed pool of threads for the per-request host work of a batching iteration.
+//! \details parallelFor splits the items, e.g. the active requests, into chunks and gives every worker a contiguous
+//! share of them. A worker that finished its share steals half of the remaining chunks of another worker, so a few
+//! expensive requests do not leave the other workers idle. The calling thread is worker 0, and the task receives the
+//! index of its worker, which selects per-worker scratch buffers without locking. Tasks write their results into the
+//! slot of their item, so the caller sees them in item order however the items were scheduled.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void(SizeType itemIdx, SizeType workerIdx)>;
+
+    //! \param numWorkers Workers including the calling thread, 1 runs every task on the calling thread.
+    explicit WorkStealingPool(SizeType numWorkers);
+
+    ~WorkStealingPool();
+
+    WorkStealingPool(WorkStealingPool const&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+    [[nodiscard]] SizeType getNumWorkers() const noexcept
+    {
+        return static_cast<SizeType>(mQueues.size());
+    }
+
+    //! \brief Call task for every item in [0, numItems) and return when all calls returned.
+    //! \details Not reentrant, a task must not call parallelFor. If tasks throw, the remaining chunks are skipped and
+    //! the first exception is rethrown.
+    //! \param grainSize Items per chunk, the unit of stealing.
+    void parallelFor(SizeType numItems, Task const& task, SizeType grainSize = 1);
+
+private:
+    // Chunks [begin, end) of a worker
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        SizeType begin{0};
+        SizeType end{0};
+    };
+
+    void workerLoop(SizeType workerIdx);
+
+    void runWorker(SizeType workerIdx);
+
+    bool popChunk(SizeType workerIdx, SizeType& chunk);
+
+    bool stealChunk(SizeType workerIdx, SizeType& chunk);
+
+    std::vector<Queue> mQueues;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mStart;
+    std::condition_variable mDone;
+    std::uint64_t mGeneration{0};
+    SizeType mNumBusy{0};
+    bool mShutdown{false};
+
+    // Job of the current parallelFor
+    Task const* mTask{nullptr};
+    SizeType mNumItems{0};
+    SizeType mGrainSize{1};
+    std::atomic<bool> mFailed{false};
+    std::exception_ptr mError;
+};
+
+} // namespace tensorrt_llm::runtime
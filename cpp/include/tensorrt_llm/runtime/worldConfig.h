@@ -19,6 +19,7 @@
 #include "tensorrt_llm/runtime/common.h"
 
 #include <NvInferRuntime.h>
+#include <algorithm>
 #include <optional>
 #include <vector>
 
@@ -31,11 +32,11 @@ public:
 
     explicit WorldConfig(SizeType tensorParallelism = 1, SizeType pipelineParallelism = 1, SizeType rank = 0,
         SizeType gpusPerNode = kDefaultGpusPerNode,
-        std::optional<std::vector<SizeType>> const& deviceIds = std::nullopt);
+        std::optional<std::vector<SizeType>> const& deviceIds = std::nullopt, SizeType contextParallelism = 1);
 
     [[nodiscard]] SizeType constexpr getSize() const noexcept
     {
-        return mTensorParallelism * mPipelineParallelism;
+        return mTensorParallelism * mContextParallelism * mPipelineParallelism;
     }
 
     [[nodiscard]] SizeType constexpr getTensorParallelism() const noexcept
@@ -58,6 +59,17 @@ public:
         return mPipelineParallelism > 1;
     }
 
+    //! \brief Number of ranks a sequence is split across, each one holding the KV cache of its part of the sequence.
+    [[nodiscard]] SizeType constexpr getContextParallelism() const noexcept
+    {
+        return mContextParallelism;
+    }
+
+    [[nodiscard]] bool constexpr isContextParallel() const noexcept
+    {
+        return mContextParallelism > 1;
+    }
+
     [[nodiscard]] SizeType constexpr getRank() const noexcept
     {
         return mRank;
@@ -68,6 +80,13 @@ public:
         return mGpusPerNode;
     }
 
+    //! \brief Tensor parallel ranks sharing a node, the peers of the custom all-reduce. With tensor parallelism across
+    //! nodes, the custom all-reduce reduces among them and NCCL across nodes.
+    [[nodiscard]] SizeType constexpr getTensorParallelRanksPerNode() const noexcept
+    {
+        return std::min(mTensorParallelism, mGpusPerNode);
+    }
+
     [[nodiscard]] SizeType getGpusPerGroup() const noexcept
     {
         return static_cast<SizeType>(mDeviceIds.size());
@@ -78,9 +97,16 @@ public:
         return mDeviceIds[mRank % getGpusPerGroup()];
     }
 
+    // Ranks are ordered by pipeline stage, then by context parallel rank, then by tensor parallel rank.
+
     [[nodiscard]] SizeType constexpr getPipelineParallelRank() const noexcept
     {
-        return mRank / mTensorParallelism;
+        return mRank / (mTensorParallelism * mContextParallelism);
+    }
+
+    [[nodiscard]] SizeType constexpr getContextParallelRank() const noexcept
+    {
+        return (mRank / mTensorParallelism) % mContextParallelism;
     }
 
     [[nodiscard]] SizeType constexpr getTensorParallelRank() const noexcept
@@ -106,16 +132,21 @@ public:
 
     [[nodiscard]] std::vector<SizeType> getPipelineParallelGroup() const;
 
-    static bool validConfig(SizeType tensorParallelism, SizeType pipelineParallelism);
+    //! \brief Ranks holding the other parts of the sequences of my rank, ordered by context parallel rank.
+    [[nodiscard]] std::vector<SizeType> getContextParallelGroup() const;
+
+    static bool validConfig(SizeType tensorParallelism, SizeType pipelineParallelism, SizeType contextParallelism = 1);
 
     static WorldConfig mpi(SizeType gpusPerNode = kDefaultGpusPerNode,
         std::optional<SizeType> tensorParallelism = std::nullopt,
         std::optional<SizeType> pipelineParallelism = std::nullopt,
-        std::optional<std::vector<SizeType>> const& deviceIds = std::nullopt);
+        std::optional<std::vector<SizeType>> const& deviceIds = std::nullopt,
+        std::optional<SizeType> contextParallelism = std::nullopt);
 
 private:
     SizeType mTensorParallelism;
     SizeType mPipelineParallelism;
+    SizeType mContextParallelism;
     SizeType mRank;
     SizeType mGpusPerNode;
     std::vector<SizeType> mDeviceIds;
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/asyncLogSink.h"
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+
+namespace tensorrt_llm::common
+{
+
+namespace
+{
+std::size_t constexpr kDefaultCapacity{4096};
+auto constexpr kIdleSleep = std::chrono::microseconds(200);
+auto constexpr kDropReportInterval = std::chrono::seconds(1);
+
+std::atomic<bool> instanceAlive{false};
+
+struct InstanceGuard
+{
+    InstanceGuard()
+    {
+        instanceAlive.store(true, std::memory_order_release);
+    }
+
+    ~InstanceGuard()
+    {
+        instanceAlive.store(false, std::memory_order_release);
+    }
+};
+} // namespace
+
+AsyncLogSink* AsyncLogSink::getInstance()
+{
+    static AsyncLogSink instance{kDefaultCapacity, stdout, stderr};
+    // Destroyed before the sink, so that logging from later static destructors falls back to the synchronous path
+    static InstanceGuard guard;
+    return instanceAlive.load(std::memory_order_acquire) ? &instance : nullptr;
+}
+
+AsyncLogSink::AsyncLogSink(std::size_t capacity, std::FILE* out, std::FILE* err)
+    : mRecords{std::make_unique<Record[]>(capacity)}
+    , mMask{capacity - 1}
+    , mOut{out}
+    , mErr{err}
+{
+    TLLM_CHECK_WITH_INFO(capacity > 0 && (capacity & (capacity - 1)) == 0,
+        "Capacity of the async log sink must be a power of two, got %zu", capacity);
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        mRecords[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mWriter = std::thread(&AsyncLogSink::run, this);
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    mStop.store(true, std::memory_order_release);
+    mWriter.join();
+}
+
+void AsyncLogSink::setRateLimit(int level, std::uint32_t recordsPerSecond)
+{
+    mLevels[std::clamp(level / 10, 0, kNumLevels - 1)].limit.store(recordsPerSecond, std::memory_order_relaxed);
+}
+
+bool AsyncLogSink::admit(int level)
+{
+    auto& state = mLevels[std::clamp(level / 10, 0, kNumLevels - 1)];
+    auto const limit = state.limit.load(std::memory_order_relaxed);
+    if (limit == 0)
+    {
+        return true;
+    }
+    auto const sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    auto const now = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch).count();
+    auto window = state.window.load(std::memory_order_relaxed);
+    // Approximate under contention, a few records more or less may pass when the window changes
+    if (window != now && state.window.compare_exchange_strong(window, now, std::memory_order_relaxed))
+    {
+        state.count.store(0, std::memory_order_relaxed);
+    }
+    return state.count.fetch_add(1, std::memory_order_relaxed) < limit;
+}
+
+void AsyncLogSink::drop()
+{
+    mDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+AsyncLogSink::Record* AsyncLogSink::acquire(int level)
+{
+    if (!admit(level))
+    {
+        drop();
+        return nullptr;
+    }
+    // Bounded multi-producer queue: a slot is free for position when its sequence equals position
+    auto position = mEnqueuePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        auto& record = mRecords[position & mMask];
+        auto const sequence = record.sequence.load(std::memory_order_acquire);
+        auto const diff = static_cast<std::int64_t>(sequence - position);
+        if (diff == 0)
+        {
+            if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                record.position = position;
+                return &record;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The writer did not free this slot yet, the ring is full
+            drop();
+            return nullptr;
+        }
+        else
+        {
+            position = mEnqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncLogSink::commit(Record* record)
+{
+    record->sequence.store(record->position + 1, std::memory_order_release);
+}
+
+bool AsyncLogSink::writePending()
+{
+    auto position = mDequeuePosition.load(std::memory_order_relaxed);
+    auto const start = position;
+    while (true)
+    {
+        auto& record = mRecords[position & mMask];
+        if (record.sequence.load(std::memory_order_acquire) != position + 1)
+        {
+            break;
+        }
+        auto* stream = record.toStderr ? mErr : mOut;
+        std::fputs(record.text, stream);
+        std::fputc('\n', stream);
+        record.sequence.store(position + mMask + 1, std::memory_order_release);
+        ++position;
+    }
+    if (position == start)
+    {
+        return false;
+    }
+    std::fflush(mOut);
+    std::fflush(mErr);
+    mDequeuePosition.store(position, std::memory_order_release);
+    return true;
+}
+
+void AsyncLogSink::run()
+{
+    auto lastReport = std::chrono::steady_clock::now();
+    while (true)
+    {
+        auto const stop = mStop.load(std::memory_order_acquire);
+        auto const wrote = writePending();
+
+        auto const now = std::chrono::steady_clock::now();
+        if (stop || now - lastReport >= kDropReportInterval)
+        {
+            lastReport = now;
+            auto const dropped = mDropped.load(std::memory_order_relaxed);
+            if (dropped != mReportedDropped)
+            {
+                std::fprintf(
+                    mErr, "[TensorRT-LLM][WARNING] Dropped %" PRIu64 " log records\n", dropped - mReportedDropped);
+                std::fflush(mErr);
+                mReportedDropped = dropped;
+            }
+        }
+
+        if (!wrote)
+        {
+            if (stop)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(kIdleSleep);
+        }
+    }
+}
+
+void AsyncLogSink::flush()
+{
+    auto const target = mEnqueuePosition.load(std::memory_order_acquire);
+    while (mDequeuePosition.load(std::memory_order_acquire) < target && mWriter.joinable()
+        && !mStop.load(std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_for(kIdleSleep / 4);
+    }
+}
+
+} // namespace tensorrt_llm::common
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+namespace tensorrt_llm::common
+{
+
+//! \brief Backend of the Logger that writes on a background thread, enabled with TLLM_LOG_ASYNC=ON.
+//!
+//! The caller formats its record directly into a slot of a bounded lock-free multi-producer ring, acquire() and
+//! commit() cost a few atomic operations and never block nor allocate. A record that finds the ring full or that
+//! exceeds the rate limit of its level is dropped and counted, the writer reports the drops once per second.
+class AsyncLogSink
+{
+public:
+    //! \brief Longest record including its prefix, longer ones are truncated.
+    static std::size_t constexpr kRecordSize{1024};
+
+    struct Record
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::uint64_t position;
+        bool toStderr;
+        char text[kRecordSize];
+    };
+
+    //! \brief Sink of the process, writing to stdout and stderr.
+    //! \returns nullptr once the process is exiting
+    static AsyncLogSink* getInstance();
+
+    //! \param capacity Number of records in the ring, a power of two.
+    AsyncLogSink(std::size_t capacity, std::FILE* out, std::FILE* err);
+
+    //! \brief Writes the committed records and stops the writer.
+    ~AsyncLogSink();
+
+    AsyncLogSink(AsyncLogSink const&) = delete;
+    AsyncLogSink& operator=(AsyncLogSink const&) = delete;
+
+    //! \brief Maximum number of records per second of a Logger::Level, 0 for no limit.
+    void setRateLimit(int level, std::uint32_t recordsPerSecond);
+
+    //! \brief Slot for a record of a Logger::Level, nullptr if the record is dropped. Must be followed by commit().
+    Record* acquire(int level);
+
+    //! \brief Hand the record filled by the caller to the writer.
+    void commit(Record* record);
+
+    //! \brief Wait until the writer has written every record committed so far.
+    void flush();
+
+    [[nodiscard]] std::uint64_t getDropped() const
+    {
+        return mDropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    static int constexpr kNumLevels{5};
+
+    struct LevelState
+    {
+        std::atomic<std::uint32_t> limit{0};
+        // Second of the current rate limiting window and records admitted in it
+        std::atomic<std::int64_t> window{-1};
+        std::atomic<std::uint32_t> count{0};
+    };
+
+    bool admit(int level);
+    void drop();
+    bool writePending();
+    void run();
+
+    std::unique_ptr<Record[]> mRecords;
+    std::size_t mMask;
+    std::FILE* mOut;
+    std::FILE* mErr;
+    std::array<LevelState, kNumLevels> mLevels;
+    alignas(64) std::atomic<std::uint64_t> mEnqueuePosition{0};
+    // Records written, only advanced by the writer
+    alignas(64) std::atomic<std::uint64_t> mDequeuePosition{0};
+    std::atomic<std::uint64_t> mDropped{0};
+    std::uint64_t mReportedDropped{0};
+    std::atomic<bool> mStop{false};
+    std::thread mWriter;
+};
+
+} // namespace tensorrt_llm::common
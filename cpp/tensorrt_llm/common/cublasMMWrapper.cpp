@@ -17,7 +17,11 @@
 #include "tensorrt_llm/common/cublasMMWrapper.h"
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cublasVersionCheck.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
 #include <algorithm>
+#include <cstring>
+#include <limits>
 
 #ifndef CUDART_VERSION
 #error CUDART_VERSION Undefined!
@@ -28,6 +32,66 @@ namespace tensorrt_llm
 namespace common
 {
 
+namespace
+{
+
+// Shapes beyond this number are not cached, their descriptors are created for every GEMM as without the cache.
+constexpr size_t kMaxCachedGemms = 4096;
+// Heuristics timed per shape when autotuning, and runs per heuristic
+constexpr size_t kMaxAutotuneAlgos = 8;
+constexpr int kAutotuneRuns = 5;
+
+class GemmCache
+{
+public:
+    static GemmCache& getInstance()
+    {
+        static GemmCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<CublasMMWrapper::CachedGemm> find(CublasMMWrapper::GemmKey const& key)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const it = mEntries.find(key);
+        return it != mEntries.end() ? it->second : nullptr;
+    }
+
+    // Returns the entry cached for key, which is not entry if another thread inserted the same shape first.
+    std::shared_ptr<CublasMMWrapper::CachedGemm> insert(
+        CublasMMWrapper::GemmKey const& key, std::shared_ptr<CublasMMWrapper::CachedGemm> entry)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mEntries.size() >= kMaxCachedGemms)
+        {
+            return entry;
+        }
+        return mEntries.emplace(key, std::move(entry)).first->second;
+    }
+
+private:
+    std::mutex mMutex;
+    std::map<CublasMMWrapper::GemmKey, std::shared_ptr<CublasMMWrapper::CachedGemm>> mEntries;
+};
+
+} // namespace
+
+CublasMMWrapper::CachedGemm::~CachedGemm()
+{
+    // No check, this may run at exit after the CUDA context is gone
+    if (operationDesc != NULL)
+    {
+        cublasLtMatmulDescDestroy(operationDesc);
+    }
+    for (auto desc : {aDesc, bDesc, cDesc})
+    {
+        if (desc != NULL)
+        {
+            cublasLtMatrixLayoutDestroy(desc);
+        }
+    }
+}
+
 CublasMMWrapper::CublasMMWrapper(std::shared_ptr<cublasHandle_t> cublasHandle,
     std::shared_ptr<cublasLtHandle_t> cublasltHandle, cudaStream_t stream, void* workspace)
     : mCublasHandle(cublasHandle)
@@ -53,26 +117,38 @@ CublasMMWrapper::CublasMMWrapper(const CublasMMWrapper& wrapper)
 void CublasMMWrapper::createDescriptors(cublasOperation_t transa, cublasOperation_t transb, const int m, const int n,
     const int k, const int lda, const int ldb, const int ldc)
 {
-    // --------------------------------------
-    // Create descriptors for the original matrices
-    check_cuda_error(
-        cublasLtMatrixLayoutCreate(&mADesc, mAType, transa == CUBLAS_OP_N ? m : k, transa == CUBLAS_OP_N ? k : m, lda));
-    check_cuda_error(
-        cublasLtMatrixLayoutCreate(&mBDesc, mBType, transb == CUBLAS_OP_N ? k : n, transb == CUBLAS_OP_N ? n : k, ldb));
-    check_cuda_error(cublasLtMatrixLayoutCreate(&mCDesc, mCType, m, n, ldc));
-    check_cuda_error(cublasLtMatmulDescCreate(&mOperationDesc, mComputeType, mScaleType));
-    check_cuda_error(cublasLtMatmulDescSetAttribute(
-        mOperationDesc, CUBLASLT_MATMUL_DESC_TRANSA, &transa, sizeof(cublasOperation_t)));
-    check_cuda_error(cublasLtMatmulDescSetAttribute(
-        mOperationDesc, CUBLASLT_MATMUL_DESC_TRANSB, &transb, sizeof(cublasOperation_t)));
+    GemmKey const key{getDevice(), transa, transb, m, n, k, lda, ldb, ldc, mAType, mBType, mCType, mComputeType,
+        mScaleType, mCublasWorkspace != NULL};
+    auto& cache = GemmCache::getInstance();
+    auto entry = cache.find(key);
+    if (!entry)
+    {
+        entry = std::make_shared<CachedGemm>();
+        // --------------------------------------
+        // Create descriptors for the original matrices
+        check_cuda_error(cublasLtMatrixLayoutCreate(
+            &entry->aDesc, mAType, transa == CUBLAS_OP_N ? m : k, transa == CUBLAS_OP_N ? k : m, lda));
+        check_cuda_error(cublasLtMatrixLayoutCreate(
+            &entry->bDesc, mBType, transb == CUBLAS_OP_N ? k : n, transb == CUBLAS_OP_N ? n : k, ldb));
+        check_cuda_error(cublasLtMatrixLayoutCreate(&entry->cDesc, mCType, m, n, ldc));
+        check_cuda_error(cublasLtMatmulDescCreate(&entry->operationDesc, mComputeType, mScaleType));
+        check_cuda_error(cublasLtMatmulDescSetAttribute(
+            entry->operationDesc, CUBLASLT_MATMUL_DESC_TRANSA, &transa, sizeof(cublasOperation_t)));
+        check_cuda_error(cublasLtMatmulDescSetAttribute(
+            entry->operationDesc, CUBLASLT_MATMUL_DESC_TRANSB, &transb, sizeof(cublasOperation_t)));
+        entry = cache.insert(key, std::move(entry));
+    }
+    mCachedGemm = std::move(entry);
+    mOperationDesc = mCachedGemm->operationDesc;
+    mADesc = mCachedGemm->aDesc;
+    mBDesc = mCachedGemm->bDesc;
+    mCDesc = mCachedGemm->cDesc;
 }
 
 void CublasMMWrapper::destroyDescriptors()
 {
-    check_cuda_error(cublasLtMatmulDescDestroy(mOperationDesc));
-    check_cuda_error(cublasLtMatrixLayoutDestroy(mADesc));
-    check_cuda_error(cublasLtMatrixLayoutDestroy(mBDesc));
-    check_cuda_error(cublasLtMatrixLayoutDestroy(mCDesc));
+    // The descriptors are owned by the entry, which is destroyed with the last reference if it is not cached
+    mCachedGemm.reset();
     mOperationDesc = NULL;
     mADesc = NULL;
     mBDesc = NULL;
@@ -136,9 +212,15 @@ void CublasMMWrapper::Gemm(cublasOperation_t transa, cublasOperation_t transb, c
         {
             hasAlgo = checkTactic(transa, transb, m, n, k, lda, ldb, ldc, algo);
         }
+        std::optional<cublasLtMatmulAlgo_t> defaultAlgo;
+        if (!hasAlgo)
+        {
+            defaultAlgo = getDefaultAlgo(alpha, A, B, beta, C, /* canOverwriteC */ f_beta == 0.0f, workspaceSize);
+        }
+        cublasLtMatmulAlgo_t const* ltAlgo = hasAlgo ? &algo : (defaultAlgo ? &*defaultAlgo : NULL);
 
         check_cuda_error(cublasLtMatmul(getCublasLtHandle(), mOperationDesc, alpha, A, mADesc, B, mBDesc, beta, C,
-            mCDesc, C, mCDesc, (hasAlgo ? (&algo) : NULL), mCublasWorkspace, workspaceSize, mStream));
+            mCDesc, C, mCDesc, ltAlgo, mCublasWorkspace, workspaceSize, mStream));
 
         sync_check_cuda_error();
     }
@@ -273,21 +355,35 @@ bool CublasMMWrapper::checkTactic(cublasOperation_t transa, cublasOperation_t tr
     TLLM_CHECK_WITH_INFO(
         descriptorsCreated(), "Descriptors are not created! Call createDescriptors before calling this function");
 
-    int workspaceSize = mCublasWorkspace == NULL ? 0 : CUBLAS_WORKSPACE_SIZE;
+    std::unique_lock<std::mutex> lock;
+    if (mCachedGemm)
+    {
+        lock = std::unique_lock<std::mutex>(mCachedGemm->mutex);
+        auto const& checked = mCachedGemm->checkedAlgos;
+        auto const it = std::find_if(checked.begin(), checked.end(),
+            [&algo](auto const& result) { return std::memcmp(&result.first, &algo, sizeof(algo)) == 0; });
+        if (it != checked.end())
+        {
+            return it->second;
+        }
+    }
 
     cublasLtMatmulHeuristicResult_t heurResult;
     cublasStatus_t algoStatus = cublasLtMatmulAlgoCheck(
         getCublasLtHandle(), mOperationDesc, mADesc, mBDesc, mCDesc, mCDesc, &algo, &heurResult);
 
-    if (algoStatus != CUBLAS_STATUS_SUCCESS || heurResult.state != CUBLAS_STATUS_SUCCESS
-        || heurResult.workspaceSize > CUBLAS_WORKSPACE_SIZE)
+    bool const valid = algoStatus == CUBLAS_STATUS_SUCCESS && heurResult.state == CUBLAS_STATUS_SUCCESS
+        && heurResult.workspaceSize <= CUBLAS_WORKSPACE_SIZE;
+    if (valid)
+    {
+        sync_check_cuda_error();
+    }
+    if (mCachedGemm)
     {
-        return false;
+        mCachedGemm->checkedAlgos.emplace_back(algo, valid);
     }
 
-    sync_check_cuda_error();
-
-    return true;
+    return valid;
 }
 
 std::vector<cublasLtMatmulHeuristicResult_t> CublasMMWrapper::getTactics(cublasOperation_t transa,
@@ -296,6 +392,12 @@ std::vector<cublasLtMatmulHeuristicResult_t> CublasMMWrapper::getTactics(cublasO
     TLLM_CHECK_WITH_INFO(
         descriptorsCreated(), "Descriptors are not created! Call createDescriptors before calling this function");
 
+    if (mCachedGemm)
+    {
+        std::lock_guard<std::mutex> lock(mCachedGemm->mutex);
+        return getCachedTactics(*mCachedGemm);
+    }
+
     const auto heuristics = getTactics(getCublasLtHandle(), mOperationDesc, mADesc, mBDesc, mCDesc, mCDesc);
 
     sync_check_cuda_error();
@@ -303,6 +405,105 @@ std::vector<cublasLtMatmulHeuristicResult_t> CublasMMWrapper::getTactics(cublasO
     return heuristics;
 }
 
+std::vector<cublasLtMatmulHeuristicResult_t> const& CublasMMWrapper::getCachedTactics(CachedGemm& entry)
+{
+    if (!entry.tactics)
+    {
+        entry.tactics = getTactics(
+            getCublasLtHandle(), entry.operationDesc, entry.aDesc, entry.bDesc, entry.cDesc, entry.cDesc);
+        sync_check_cuda_error();
+    }
+    return *entry.tactics;
+}
+
+std::optional<cublasLtMatmulAlgo_t> CublasMMWrapper::getDefaultAlgo(void const* alpha, void const* A, void const* B,
+    void const* beta, void* C, bool canOverwriteC, size_t workspaceSize)
+{
+    if (!mCachedGemm)
+    {
+        return std::nullopt;
+    }
+    auto& entry = *mCachedGemm;
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (entry.defaultAlgoChosen)
+    {
+        return entry.defaultAlgo;
+    }
+
+    std::vector<cublasLtMatmulAlgo_t> candidates;
+    for (auto const& heuristic : getCachedTactics(entry))
+    {
+        if (heuristic.state == CUBLAS_STATUS_SUCCESS && heuristic.workspaceSize <= workspaceSize)
+        {
+            candidates.push_back(heuristic.algo);
+        }
+    }
+    if (candidates.empty())
+    {
+        // Let cublasLtMatmul run its own heuristic
+        entry.defaultAlgoChosen = true;
+        return std::nullopt;
+    }
+
+    bool const autotune = getEnvCublasLtAutotune() && candidates.size() > 1;
+    auto const isCapturing = [this]()
+    {
+        cudaStreamCaptureStatus captureStatus{cudaStreamCaptureStatusNone};
+        // The legacy stream cannot be queried while another stream captures, which counts as capturing
+        return cudaStreamIsCapturing(mStream, &captureStatus) != cudaSuccess
+            || captureStatus != cudaStreamCaptureStatusNone;
+    };
+    if (autotune && (!canOverwriteC || isCapturing()))
+    {
+        // Tuned on a later GEMM of the shape
+        return candidates.front();
+    }
+
+    entry.defaultAlgo = candidates.front();
+    if (autotune)
+    {
+        candidates.resize(std::min(candidates.size(), kMaxAutotuneAlgos));
+        cudaEvent_t start;
+        cudaEvent_t stop;
+        check_cuda_error(cudaEventCreate(&start));
+        check_cuda_error(cudaEventCreate(&stop));
+        float bestMs = std::numeric_limits<float>::max();
+        for (auto const& candidate : candidates)
+        {
+            auto const run = [&]()
+            {
+                return cublasLtMatmul(getCublasLtHandle(), entry.operationDesc, alpha, A, entry.aDesc, B, entry.bDesc,
+                    beta, C, entry.cDesc, C, entry.cDesc, &candidate, mCublasWorkspace, workspaceSize, mStream);
+            };
+            // Warm up, and skip the algorithms that fail on these operands
+            if (run() != CUBLAS_STATUS_SUCCESS)
+            {
+                continue;
+            }
+            check_cuda_error(cudaEventRecord(start, mStream));
+            for (int i = 0; i < kAutotuneRuns; ++i)
+            {
+                run();
+            }
+            check_cuda_error(cudaEventRecord(stop, mStream));
+            check_cuda_error(cudaEventSynchronize(stop));
+            float ms{0};
+            check_cuda_error(cudaEventElapsedTime(&ms, start, stop));
+            if (ms < bestMs)
+            {
+                bestMs = ms;
+                entry.defaultAlgo = candidate;
+            }
+        }
+        check_cuda_error(cudaEventDestroy(start));
+        check_cuda_error(cudaEventDestroy(stop));
+        TLLM_LOG_DEBUG("cuBLASLt autotuning timed %zu algorithms, best %.3f ms", candidates.size(),
+            bestMs / kAutotuneRuns);
+    }
+    entry.defaultAlgoChosen = true;
+    return entry.defaultAlgo;
+}
+
 std::vector<cublasLtMatmulHeuristicResult_t> CublasMMWrapper::getTactics(cublasLtHandle_t lightHandle,
     cublasLtMatmulDesc_t computeDesc, cublasLtMatrixLayout_t Adesc, cublasLtMatrixLayout_t Bdesc,
     cublasLtMatrixLayout_t Cdesc, cublasLtMatrixLayout_t Ddesc)
@@ -19,11 +19,15 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include <cublasLt.h>
 #include <cublas_v2.h>
+#include <array>
 #include <cuda_runtime.h>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace tensorrt_llm
 {
@@ -32,6 +36,36 @@ namespace common
 
 class CublasMMWrapper
 {
+public:
+    // Descriptors of one GEMM shape and configuration, with the tactics found for it. Entries are shared by all the
+    // wrappers of the process, so that createDescriptors and the tactic selection only cost a lookup after the first
+    // GEMM of a shape. The descriptors are never modified once created.
+    struct CachedGemm
+    {
+        cublasLtMatmulDesc_t operationDesc{NULL};
+        cublasLtMatrixLayout_t aDesc{NULL};
+        cublasLtMatrixLayout_t bDesc{NULL};
+        cublasLtMatrixLayout_t cDesc{NULL};
+
+        // Guards the memoized tactics below
+        std::mutex mutex;
+        std::optional<std::vector<cublasLtMatmulHeuristicResult_t>> tactics;
+        // Algorithm of the GEMMs run without a tactic, empty for the default heuristic of cublasLtMatmul
+        bool defaultAlgoChosen{false};
+        std::optional<cublasLtMatmulAlgo_t> defaultAlgo;
+        // Results of checkTactic
+        std::vector<std::pair<cublasLtMatmulAlgo_t, bool>> checkedAlgos;
+
+        CachedGemm() = default;
+        CachedGemm(CachedGemm const&) = delete;
+        CachedGemm& operator=(CachedGemm const&) = delete;
+        ~CachedGemm();
+    };
+
+    // Device, transa, transb, m, n, k, lda, ldb, ldc, A, B and C types, compute type, scale type and whether there is
+    // a workspace
+    using GemmKey = std::array<int64_t, 15>;
+
 protected:
     std::shared_ptr<cublasHandle_t> mCublasHandle;
     std::shared_ptr<cublasLtHandle_t> mCublasLtHandle;
@@ -53,12 +87,23 @@ protected:
 
     void* mCublasWorkspace = nullptr;
 
+    // Entry of the descriptors set by createDescriptors
+    std::shared_ptr<CachedGemm> mCachedGemm;
+
 private:
     bool descriptorsCreated() const
     {
         return mOperationDesc != NULL && mADesc != NULL && mBDesc != NULL && mCDesc != NULL;
     }
 
+    // Heuristics of the current descriptors, queried on the first call. The lock of the entry must be held.
+    std::vector<cublasLtMatmulHeuristicResult_t> const& getCachedTactics(CachedGemm& entry);
+
+    // Algorithm of a cuBLASLt GEMM run without a tactic. With TRTLLM_CUBLASLT_AUTOTUNE=1, the heuristics are timed on
+    // the operands of the first GEMM of the shape when C can be overwritten and the stream is not being captured.
+    std::optional<cublasLtMatmulAlgo_t> getDefaultAlgo(void const* alpha, void const* A, void const* B,
+        void const* beta, void* C, bool canOverwriteC, size_t workspaceSize);
+
 public:
     CublasMMWrapper(std::shared_ptr<cublasHandle_t> cublasHandle, std::shared_ptr<cublasLtHandle_t> cublasLtHandle,
         cudaStream_t stream, void* workspace);
@@ -126,8 +171,10 @@ public:
 
     CublasDataType getCublasDataType(cudaDataType_t data_type);
 
+    // Descriptors are taken from the process-wide cache of GEMM shapes, created on the first use of a shape.
     void createDescriptors(cublasOperation_t transa, cublasOperation_t transb, const int m, const int n, const int k,
         const int lda, const int ldb, const int ldc);
+    // Releases the descriptors of the wrapper, the cache keeps them for the next GEMM of the same shape.
     void destroyDescriptors();
 
     cublasHandle_t getCublasHandle()
@@ -37,6 +37,92 @@ bool forceXQAKernels()
     return forceXQA;
 }
 
+std::string getEnvXQAJITSource()
+{
+    const char* xqa_jit_source_var = std::getenv("TRTLLM_XQA_JIT_SOURCE");
+    return xqa_jit_source_var != nullptr ? std::string(xqa_jit_source_var) : std::string();
+}
+
+std::string getEnvXQAJITCacheDir()
+{
+    const char* xqa_jit_cache_dir_var = std::getenv("TRTLLM_XQA_JIT_CACHE_DIR");
+    if (xqa_jit_cache_dir_var != nullptr)
+    {
+        return std::string(xqa_jit_cache_dir_var);
+    }
+    const char* home_var = std::getenv("HOME");
+    return home_var != nullptr ? std::string(home_var) + "/.cache/tensorrt_llm/xqa_jit" : std::string();
+}
+
+std::string getEnvGemmTacticCacheDir()
+{
+    const char* gemm_tactic_cache_dir_var = std::getenv("TRTLLM_GEMM_TACTIC_CACHE_DIR");
+    return gemm_tactic_cache_dir_var != nullptr ? std::string(gemm_tactic_cache_dir_var) : std::string();
+}
+
+bool getEnvCublasLtAutotune()
+{
+    const char* cublaslt_autotune_var = std::getenv("TRTLLM_CUBLASLT_AUTOTUNE");
+    return cublaslt_autotune_var != nullptr && cublaslt_autotune_var[0] == '1' && cublaslt_autotune_var[1] == '\0';
+}
+
+bool getEnvMoeGemmAutotune()
+{
+    const char* moe_gemm_autotune_var = std::getenv("TRTLLM_MOE_GEMM_AUTOTUNE");
+    return moe_gemm_autotune_var != nullptr && moe_gemm_autotune_var[0] == '1' && moe_gemm_autotune_var[1] == '\0';
+}
+
+bool getEnvAllReduceCalibration()
+{
+    const char* disable_calibration_var = std::getenv("TRTLLM_DISABLE_ALLREDUCE_CALIBRATION");
+    return !(disable_calibration_var != nullptr && disable_calibration_var[0] == '1'
+        && disable_calibration_var[1] == '\0');
+}
+
+std::string getEnvAllReduceCalibrationCacheDir()
+{
+    const char* calibration_cache_dir_var = std::getenv("TRTLLM_ALLREDUCE_CALIBRATION_CACHE_DIR");
+    if (calibration_cache_dir_var != nullptr)
+    {
+        return std::string(calibration_cache_dir_var);
+    }
+    const char* home_var = std::getenv("HOME");
+    return home_var != nullptr ? std::string(home_var) + "/.cache/tensorrt_llm/allreduce" : std::string();
+}
+
+bool getEnvTimelineTrace()
+{
+    const char* timeline_trace_var = std::getenv("TRTLLM_ENABLE_TIMELINE_TRACE");
+    return timeline_trace_var != nullptr && timeline_trace_var[0] == '1' && timeline_trace_var[1] == '\0';
+}
+
+std::string getEnvTimelineTraceDir()
+{
+    const char* timeline_trace_dir_var = std::getenv("TRTLLM_TIMELINE_TRACE_DIR");
+    return timeline_trace_dir_var != nullptr ? std::string(timeline_trace_dir_var) : std::string(".");
+}
+
+int getEnvTimelineTraceEvents()
+{
+    const char* timeline_trace_events_var = std::getenv("TRTLLM_TIMELINE_TRACE_EVENTS");
+    if (timeline_trace_events_var == nullptr)
+    {
+        return 0;
+    }
+    auto const events = std::atoi(timeline_trace_events_var);
+    if (events <= 0)
+    {
+        TLLM_LOG_WARNING("Invalid value for TRTLLM_TIMELINE_TRACE_EVENTS. Will use default values instead!");
+    }
+    return events;
+}
+
+std::string getEnvMemoryTimeline()
+{
+    const char* memory_timeline_var = std::getenv("TRTLLM_MEMORY_TIMELINE");
+    return memory_timeline_var != nullptr ? std::string(memory_timeline_var) : std::string();
+}
+
 // Tune the number of blocks per sequence for accuracy/performance purpose.
 bool getEnvMmhaMultiblockDebug()
 {
@@ -77,4 +163,23 @@ int getEnvMmhaBlocksPerSequence()
     return mmhaBlocksPerSequence;
 }
 
+bool getEnvFusedQKVPreprocessing()
+{
+    static bool init = false;
+    static bool fusedQKVPreprocessing = false;
+    if (!init)
+    {
+        init = true;
+        const char* fused_qkv_preprocessing_var = std::getenv("TRTLLM_ENABLE_FUSED_QKV_PREPROCESSING");
+        if (fused_qkv_preprocessing_var)
+        {
+            if (fused_qkv_preprocessing_var[0] == '1' && fused_qkv_preprocessing_var[1] == '\0')
+            {
+                fusedQKVPreprocessing = true;
+            }
+        }
+    }
+    return fusedQKVPreprocessing;
+}
+
 } // namespace tensorrt_llm::common
@@ -17,15 +17,54 @@
 
 #pragma once
 
+#include <string>
+
 namespace tensorrt_llm::common
 {
 
 // XQA kernels (optimized kernels for generation phase).
 bool forceXQAKernels();
 
+// Path of the XQA kernel source compiled by the JIT implementation. JIT is disabled when empty.
+std::string getEnvXQAJITSource();
+
+// Directory where JIT compiled XQA cubins are cached. No on-disk cache when empty.
+std::string getEnvXQAJITCacheDir();
+
+// Directory of the on-disk GEMM plugin tactic cache shared between engine builds. No on-disk cache when empty.
+std::string getEnvGemmTacticCacheDir();
+
+// Time the cuBLASLt heuristics on the first GEMM of every shape run without a tactic instead of taking the first one.
+bool getEnvCublasLtAutotune();
+
+// Runtime timing of the CUTLASS MoE GEMM tactics the first time a shape is seen, instead of the occupancy heuristic.
+bool getEnvMoeGemmAutotune();
+
+// Calibration of the AUTO all-reduce strategy on the first enqueue, on by default.
+bool getEnvAllReduceCalibration();
+
+// Directory where the AUTO all-reduce calibrations are cached per machine type. No on-disk cache when empty.
+std::string getEnvAllReduceCalibrationCacheDir();
+
+// Timeline tracing of the in-flight batching loop, dumped as Chrome trace JSON on SIGUSR2.
+bool getEnvTimelineTrace();
+
+// Directory of the timeline trace dumps, the working directory by default.
+std::string getEnvTimelineTraceDir();
+
+// Events kept per thread by the timeline tracer, 0 when unset.
+int getEnvTimelineTraceEvents();
+
+// File the memory timeline of the runtime allocations is written to at exit. Recording is disabled when empty.
+std::string getEnvMemoryTimeline();
+
 // Tune the number of blocks per sequence for accuracy/performance purpose.
 bool getEnvMmhaMultiblockDebug();
 
 int getEnvMmhaBlocksPerSequence();
 
+// Apply bias, RoPE and the KV cache update of the generation step in one preprocessing kernel before MMHA, which then
+// only reads the KV cache.
+bool getEnvFusedQKVPreprocessing();
+
 } // namespace tensorrt_llm::common
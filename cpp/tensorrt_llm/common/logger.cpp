@@ -53,6 +53,20 @@ Logger::Logger()
         }
         setLevel(level);
     }
+
+    auto const* async = std::getenv("TLLM_LOG_ASYNC");
+    async_ = async != nullptr && std::string(async) == "ON";
+    auto const* rateLimit = std::getenv("TLLM_LOG_RATE_LIMIT");
+    auto* sink = async_ && rateLimit != nullptr ? AsyncLogSink::getInstance() : nullptr;
+    if (sink != nullptr)
+    {
+        // Warnings and errors are never rate limited
+        auto const recordsPerSecond = static_cast<std::uint32_t>(std::stoul(rateLimit));
+        for (auto const level : {TRACE, DEBUG, INFO})
+        {
+            sink->setRateLimit(level, recordsPerSecond);
+        }
+    }
 }
 
 void Logger::log(std::exception const& ex, Logger::Level level)
@@ -16,12 +16,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <string>
 
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/asyncLogSink.h"
 #include "tensorrt_llm/common/stringUtils.h"
 
 namespace tensorrt_llm::common
@@ -100,9 +103,16 @@ private:
     const Level DEFAULT_LOG_LEVEL = INFO;
 #endif
     Level level_ = DEFAULT_LOG_LEVEL;
+    // Records go through the AsyncLogSink, TLLM_LOG_ASYNC=ON
+    bool async_ = false;
 
     Logger(); // NOLINT(modernize-use-equals-delete)
 
+    // Formats the record in place in the async sink, rank < 0 for none.
+    // Returns false if the sink is not available and the record must be written synchronously.
+    template <typename... Args>
+    bool logAsync(Level level, int rank, char const* format, Args const&... args);
+
     static inline char const* getLevelName(const Level level)
     {
         switch (level)
@@ -128,11 +138,52 @@ private:
     }
 };
 
+template <typename... Args>
+bool Logger::logAsync(Logger::Level level, int rank, char const* format, Args const&... args)
+{
+    auto* sink = AsyncLogSink::getInstance();
+    if (sink == nullptr)
+    {
+        return false;
+    }
+    auto* record = sink->acquire(level);
+    if (record == nullptr)
+    {
+        // Dropped and counted by the sink
+        return true;
+    }
+    auto constexpr size = AsyncLogSink::kRecordSize;
+    auto const prefixSize = rank < 0
+        ? std::snprintf(record->text, size, "%s[%s] ", kPREFIX, getLevelName(level))
+        : std::snprintf(record->text, size, "%s[%s][%d] ", kPREFIX, getLevelName(level), rank);
+    auto const offset = std::min(static_cast<std::size_t>(std::max(prefixSize, 0)), size - 1);
+    if constexpr (sizeof...(args) > 0)
+    {
+        std::snprintf(record->text + offset, size - offset, format, args...);
+    }
+    else
+    {
+        std::snprintf(record->text + offset, size - offset, "%s", format);
+    }
+    record->toStderr = level_ >= WARNING;
+    sink->commit(record);
+    if (level >= ERROR)
+    {
+        // Errors often precede the end of the process, do not lose them
+        sink->flush();
+    }
+    return true;
+}
+
 template <typename... Args>
 void Logger::log(Logger::Level level, char const* format, Args const&... args)
 {
     if (level_ <= level)
     {
+        if (async_ && logAsync(level, -1, format, args...))
+        {
+            return;
+        }
         auto const fmt = getPrefix(level) + format;
         auto& out = level_ < WARNING ? std::cout : std::cerr;
         if constexpr (sizeof...(args) > 0)
@@ -152,6 +203,10 @@ void Logger::log(const Logger::Level level, const int rank, char const* format,
 {
     if (level_ <= level)
     {
+        if (async_ && logAsync(level, rank, format, args...))
+        {
+            return;
+        }
         auto const fmt = getPrefix(level, rank) + format;
         auto& out = level_ < WARNING ? std::cout : std::cerr;
         if constexpr (sizeof...(args) > 0)
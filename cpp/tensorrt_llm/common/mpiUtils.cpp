@@ -18,6 +18,7 @@
 
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/timelineTracer.h"
 #include "tensorrt_llm/runtime/common.h"
 
 #include <csignal>
@@ -123,6 +124,7 @@ std::shared_ptr<MpiRequest> MpiComm::bcastAsync(void* buffer, size_t size, MpiTy
 
 void MpiComm::bcast(void* buffer, size_t size, MpiType dtype, int root) const
 {
+    TLLM_TIMELINE_SCOPE(kMpiBroadcast, bcast);
     MPICHECK(MPI_Bcast(buffer, size, getMpiDtype(dtype), root, mComm));
 }
 
@@ -91,6 +91,18 @@ public:
         return QuantMode(BaseType(1u) << 8);
     }
 
+    static constexpr QuantMode int4KvCache() noexcept
+    {
+        return QuantMode(BaseType(1u) << 9);
+    }
+
+    // Combined with int8KvCache or fp8KvCache: the scales are computed per head from the context of each sequence and
+    // stored in the KV cache blocks instead of calibrated offline.
+    static constexpr QuantMode kvCacheDynamicScales() noexcept
+    {
+        return QuantMode(BaseType(1u) << 10);
+    }
+
     constexpr BaseType value() const noexcept
     {
         return mValue;
@@ -151,6 +163,16 @@ public:
         return isSet(fp8Qdq());
     }
 
+    constexpr bool hasInt4KvCache() const noexcept
+    {
+        return isSet(int4KvCache());
+    }
+
+    constexpr bool hasKvCacheDynamicScales() const noexcept
+    {
+        return isSet(kvCacheDynamicScales()) && hasKvCacheQuant();
+    }
+
     constexpr bool hasKvCacheQuant() const noexcept
     {
         return hasInt8KvCache() || hasFp8KvCache();
@@ -158,7 +180,7 @@ public:
 
     static constexpr QuantMode fromDescription(bool quantizeWeights = false, bool quantizeActivations = false,
         bool perToken = false, bool perChannel = false, bool perGroup = false, bool useInt4Weights = false,
-        bool useInt8KvCache = false, bool useFp8KvCache = false, bool useFp8Qdq = false)
+        bool useInt8KvCache = false, bool useFp8KvCache = false, bool useFp8Qdq = false, bool useInt4KvCache = false)
     {
         QuantMode quantMode{};
         if (quantizeWeights)
@@ -202,6 +224,11 @@ public:
             quantMode += fp8Qdq();
         }
 
+        if (useInt4KvCache)
+        {
+            quantMode += int4KvCache();
+        }
+
         return quantMode;
     }
 
@@ -272,6 +299,18 @@ public:
         {
             quantMode += fp8KvCache();
         }
+        else if (kvCacheQuantAlgo == "INT4")
+        {
+            quantMode += int4KvCache();
+        }
+        else if (kvCacheQuantAlgo == "INT8_DYNAMIC")
+        {
+            quantMode += int8KvCache() + kvCacheDynamicScales();
+        }
+        else if (kvCacheQuantAlgo == "FP8_DYNAMIC")
+        {
+            quantMode += fp8KvCache() + kvCacheDynamicScales();
+        }
 
         return quantMode;
     }
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/shmRingBuffer.h"
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+namespace tensorrt_llm::common
+{
+
+namespace
+{
+std::uint64_t constexpr kMagic{0x54524c4c4d524e47}; // "TRLLMRNG"
+std::size_t constexpr kCacheLineSize{64};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared memory positions must be lock-free");
+
+//! \brief Spin briefly, then yield, then sleep, so that short waits stay short without burning a core on long ones.
+template <typename TryFn>
+bool waitFor(TryFn&& tryFn, std::chrono::microseconds timeout)
+{
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    for (int attempt = 0;; ++attempt)
+    {
+        if (tryFn())
+        {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        if (attempt > 1000)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+        else if (attempt > 100)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+} // namespace
+
+struct ShmRingBuffer::Header
+{
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t capacity;
+    // Bytes written so far, only written by the producer
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> writePosition;
+    // Bytes read so far, only written by the consumer
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> readPosition;
+};
+
+namespace
+{
+// The messages follow the header
+std::size_t constexpr kDataOffset{
+    (sizeof(ShmRingBuffer::Header) + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize};
+} // namespace
+
+ShmRingBuffer ShmRingBuffer::create(std::string const& name, std::size_t capacity)
+{
+    TLLM_CHECK_WITH_INFO(capacity > sizeof(std::uint64_t) && (capacity & (capacity - 1)) == 0,
+        "Capacity of the shared memory ring %s must be a power of two, got %zu", name.c_str(), capacity);
+    auto const fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    TLLM_CHECK_WITH_INFO(fd >= 0, "Error creating shared memory %s: %s", name.c_str(), std::strerror(errno));
+    auto const mappingSize = kDataOffset + capacity;
+    void* mapping = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(mappingSize)) == 0)
+    {
+        mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    auto const error = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        ::shm_unlink(name.c_str());
+        TLLM_THROW("Error mapping shared memory %s: %s", name.c_str(), std::strerror(error));
+    }
+
+    auto* header = new (mapping) Header{};
+    header->capacity = capacity;
+    header->writePosition.store(0, std::memory_order_relaxed);
+    header->readPosition.store(0, std::memory_order_relaxed);
+    // Published last, open() checks it
+    header->magic.store(kMagic, std::memory_order_release);
+    return ShmRingBuffer{name, mapping, mappingSize, true};
+}
+
+ShmRingBuffer ShmRingBuffer::open(std::string const& name)
+{
+    auto const fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    TLLM_CHECK_WITH_INFO(fd >= 0, "Error opening shared memory %s: %s", name.c_str(), std::strerror(errno));
+    struct stat fileStat = {};
+    void* mapping = MAP_FAILED;
+    if (::fstat(fd, &fileStat) == 0 && static_cast<std::size_t>(fileStat.st_size) > kDataOffset)
+    {
+        mapping = ::mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    auto const error = errno;
+    ::close(fd);
+    TLLM_CHECK_WITH_INFO(
+        mapping != MAP_FAILED, "Error mapping shared memory %s: %s", name.c_str(), std::strerror(error));
+    ShmRingBuffer ring{name, mapping, static_cast<std::size_t>(fileStat.st_size), false};
+    TLLM_CHECK_WITH_INFO(
+        ring.mHeader->magic.load(std::memory_order_acquire) == kMagic
+            && kDataOffset + ring.mHeader->capacity == ring.mMappingSize,
+        "Shared memory %s is not a ring buffer", name.c_str());
+    ring.mCapacity = ring.mHeader->capacity;
+    return ring;
+}
+
+ShmRingBuffer::ShmRingBuffer(std::string name, void* mapping, std::size_t mappingSize, bool owner)
+    : mName{std::move(name)}
+    , mMapping{mapping}
+    , mMappingSize{mappingSize}
+    , mOwner{owner}
+    , mHeader{static_cast<Header*>(mapping)}
+    , mData{static_cast<char*>(mapping) + kDataOffset}
+    , mCapacity{mappingSize - kDataOffset}
+{
+}
+
+ShmRingBuffer::ShmRingBuffer(ShmRingBuffer&& other) noexcept
+    : mName{std::move(other.mName)}
+    , mMapping{std::exchange(other.mMapping, nullptr)}
+    , mMappingSize{other.mMappingSize}
+    , mOwner{std::exchange(other.mOwner, false)}
+    , mHeader{other.mHeader}
+    , mData{other.mData}
+    , mCapacity{other.mCapacity}
+{
+}
+
+ShmRingBuffer& ShmRingBuffer::operator=(ShmRingBuffer&& other) noexcept
+{
+    // The previous segment of this ring is released by other
+    std::swap(mName, other.mName);
+    std::swap(mMapping, other.mMapping);
+    std::swap(mMappingSize, other.mMappingSize);
+    std::swap(mOwner, other.mOwner);
+    std::swap(mHeader, other.mHeader);
+    std::swap(mData, other.mData);
+    std::swap(mCapacity, other.mCapacity);
+    return *this;
+}
+
+ShmRingBuffer::~ShmRingBuffer()
+{
+    if (mMapping != nullptr)
+    {
+        ::munmap(mMapping, mMappingSize);
+    }
+    if (mOwner)
+    {
+        ::shm_unlink(mName.c_str());
+    }
+}
+
+void ShmRingBuffer::copyIn(std::uint64_t position, void const* src, std::size_t size)
+{
+    auto const offset = static_cast<std::size_t>(position & (mCapacity - 1));
+    auto const first = std::min(size, mCapacity - offset);
+    std::memcpy(mData + offset, src, first);
+    std::memcpy(mData, static_cast<char const*>(src) + first, size - first);
+}
+
+void ShmRingBuffer::copyOut(std::uint64_t position, void* dst, std::size_t size) const
+{
+    auto const offset = static_cast<std::size_t>(position & (mCapacity - 1));
+    auto const first = std::min(size, mCapacity - offset);
+    std::memcpy(dst, mData + offset, first);
+    std::memcpy(static_cast<char*>(dst) + first, mData, size - first);
+}
+
+bool ShmRingBuffer::tryWrite(void const* data, std::size_t size)
+{
+    TLLM_CHECK_WITH_INFO(size <= getMaxMessageSize(), "Message of %zu bytes exceeds the %zu bytes of the ring %s",
+        size, getMaxMessageSize(), mName.c_str());
+    auto const writePosition = mHeader->writePosition.load(std::memory_order_relaxed);
+    auto const readPosition = mHeader->readPosition.load(std::memory_order_acquire);
+    auto const length = static_cast<std::uint64_t>(size);
+    if (mCapacity - (writePosition - readPosition) < sizeof(length) + size)
+    {
+        return false;
+    }
+    copyIn(writePosition, &length, sizeof(length));
+    copyIn(writePosition + sizeof(length), data, size);
+    mHeader->writePosition.store(writePosition + sizeof(length) + size, std::memory_order_release);
+    return true;
+}
+
+bool ShmRingBuffer::write(void const* data, std::size_t size, std::chrono::microseconds timeout)
+{
+    return waitFor([&]() { return tryWrite(data, size); }, timeout);
+}
+
+bool ShmRingBuffer::tryRead(std::vector<char>& message)
+{
+    auto const readPosition = mHeader->readPosition.load(std::memory_order_relaxed);
+    auto const writePosition = mHeader->writePosition.load(std::memory_order_acquire);
+    if (readPosition == writePosition)
+    {
+        return false;
+    }
+    std::uint64_t length;
+    copyOut(readPosition, &length, sizeof(length));
+    TLLM_CHECK_WITH_INFO(length <= writePosition - readPosition - sizeof(length), "Corrupted shared memory ring %s",
+        mName.c_str());
+    message.resize(length);
+    copyOut(readPosition + sizeof(length), message.data(), length);
+    mHeader->readPosition.store(readPosition + sizeof(length) + length, std::memory_order_release);
+    return true;
+}
+
+bool ShmRingBuffer::read(std::vector<char>& message, std::chrono::microseconds timeout)
+{
+    return waitFor([&]() { return tryRead(message); }, timeout);
+}
+
+} // namespace tensorrt_llm::common
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::common
+{
+
+//! \brief Single-producer single-consumer queue of messages in POSIX shared memory, to pass serialized requests and
+//! responses between the processes of one node without MPI, e.g. between the orchestrator and the leader.
+//!
+//! Every message is a 64-bit length followed by its bytes, both possibly wrapping around the end of the ring. The
+//! producer and the consumer each own one position and only read the other one, so neither takes a lock. One process
+//! creates the segment and removes its name on destruction, the other one opens it by name.
+class ShmRingBuffer
+{
+public:
+    //! \brief Create the segment name, e.g. "/trtllm_requests", of capacity bytes, a power of two.
+    static ShmRingBuffer create(std::string const& name, std::size_t capacity);
+
+    //! \brief Open the segment name created by another process.
+    static ShmRingBuffer open(std::string const& name);
+
+    ShmRingBuffer(ShmRingBuffer&& other) noexcept;
+    ShmRingBuffer& operator=(ShmRingBuffer&& other) noexcept;
+    ShmRingBuffer(ShmRingBuffer const&) = delete;
+    ShmRingBuffer& operator=(ShmRingBuffer const&) = delete;
+
+    ~ShmRingBuffer();
+
+    //! \brief Append a message, producer only.
+    //! \returns false if there is not enough room, the message is then not written
+    bool tryWrite(void const* data, std::size_t size);
+
+    //! \brief Append a message, waiting for room until timeout.
+    bool write(void const* data, std::size_t size, std::chrono::microseconds timeout);
+
+    //! \brief Pop the oldest message into message, consumer only.
+    //! \returns false if the ring is empty
+    bool tryRead(std::vector<char>& message);
+
+    //! \brief Pop the oldest message, waiting for one until timeout.
+    bool read(std::vector<char>& message, std::chrono::microseconds timeout);
+
+    [[nodiscard]] std::size_t getCapacity() const noexcept
+    {
+        return mCapacity;
+    }
+
+    //! \brief Largest message that fits in an empty ring.
+    [[nodiscard]] std::size_t getMaxMessageSize() const noexcept
+    {
+        return mCapacity - sizeof(std::uint64_t);
+    }
+
+    //! \brief Layout of the start of the segment, defined in the source.
+    struct Header;
+
+private:
+    ShmRingBuffer(std::string name, void* mapping, std::size_t mappingSize, bool owner);
+
+    void copyIn(std::uint64_t position, void const* src, std::size_t size);
+    void copyOut(std::uint64_t position, void* dst, std::size_t size) const;
+
+    std::string mName;
+    void* mMapping{nullptr};
+    std::size_t mMappingSize{0};
+    bool mOwner{false};
+    Header* mHeader{nullptr};
+    char* mData{nullptr};
+    std::size_t mCapacity{0};
+};
+
+} // namespace tensorrt_llm::common
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/timelineTracer.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+namespace tensorrt_llm::common::timeline
+{
+
+namespace
+{
+
+std::atomic<std::uint64_t> gNextTracerId{0};
+
+// Write end of the pipe that wakes up the dump thread, written by the signal handler.
+std::atomic<int> gSignalPipe{-1};
+
+void signalHandler(int)
+{
+    auto const fd = gSignalPipe.load();
+    if (fd >= 0)
+    {
+        char const byte = 0;
+        [[maybe_unused]] auto const written = ::write(fd, &byte, 1);
+    }
+}
+
+void writeEscaped(std::ostream& os, char const* str)
+{
+    for (; *str != '\0'; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            os << '\\';
+        }
+        os << *str;
+    }
+}
+
+} // namespace
+
+char const* toString(Category category)
+{
+    switch (category)
+    {
+    case Category::kScheduling: return "scheduling";
+    case Category::kKvCacheAllocation: return "kv_cache_allocation";
+    case Category::kEngineEnqueue: return "engine_enqueue";
+    case Category::kDecoderStep: return "decoder_step";
+    case Category::kResponseDelivery: return "response_delivery";
+    case Category::kMpiBroadcast: return "mpi_broadcast";
+    }
+    return "unknown";
+}
+
+Tracer& Tracer::getInstance()
+{
+    static Tracer& tracer = []() -> Tracer&
+    {
+        auto const events = getEnvTimelineTraceEvents();
+        static Tracer instance{events > 0 ? static_cast<std::size_t>(events) : kDefaultEventsPerThread};
+        if (getEnvTimelineTrace())
+        {
+            instance.setEnabled(true);
+            instance.installSignalHandler(SIGUSR2, getEnvTimelineTraceDir());
+            TLLM_LOG_INFO("Timeline tracing enabled, send SIGUSR2 to dump the trace");
+        }
+        return instance;
+    }();
+    return tracer;
+}
+
+Tracer::Tracer(std::size_t eventsPerThread)
+    : mId{gNextTracerId++}
+    , mEventsPerThread{eventsPerThread}
+{
+    TLLM_CHECK_WITH_INFO(eventsPerThread > 0, "The timeline tracer needs room for at least one event per thread");
+}
+
+Tracer::ThreadRing& Tracer::getThreadRing()
+{
+    // Rings of the calling thread, by tracer. Shared with the tracer so that they survive the thread.
+    thread_local std::vector<std::pair<std::uint64_t, std::shared_ptr<ThreadRing>>> threadRings;
+    for (auto const& [id, ring] : threadRings)
+    {
+        if (id == mId)
+        {
+            return *ring;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto ring = std::make_shared<ThreadRing>(mEventsPerThread, mNextThreadId++);
+    mRings.push_back(ring);
+    return *threadRings.emplace_back(mId, std::move(ring)).second;
+}
+
+void Tracer::record(Category category, char const* name, std::int64_t startNs, std::int64_t endNs)
+{
+    auto& ring = getThreadRing();
+    auto const position = ring.head.load(std::memory_order_relaxed);
+    // A reader that sees any of the stores below also sees the head of the previous event, and thereby knows that this
+    // slot may be in the middle of being overwritten.
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& event = ring.events[position % ring.events.size()];
+    event.name.store(name, std::memory_order_relaxed);
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.endNs.store(endNs, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    ring.head.store(position + 1, std::memory_order_release);
+}
+
+void Tracer::dump(std::ostream& os) const
+{
+    struct Copy
+    {
+        char const* name;
+        std::int64_t startNs;
+        std::int64_t endNs;
+        Category category;
+        std::uint32_t threadId;
+    };
+
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        rings = mRings;
+    }
+
+    std::vector<Copy> events;
+    for (auto const& ring : rings)
+    {
+        auto const numSlots = static_cast<std::uint64_t>(ring->events.size());
+        auto const capacity = numSlots - 1;
+        auto const head = ring->head.load(std::memory_order_acquire);
+        auto const first = head > capacity ? head - capacity : 0;
+        auto const begin = events.size();
+        for (auto position = first; position < head; ++position)
+        {
+            auto const& event = ring->events[position % numSlots];
+            events.push_back(Copy{event.name.load(std::memory_order_relaxed),
+                event.startNs.load(std::memory_order_relaxed), event.endNs.load(std::memory_order_relaxed),
+                event.category.load(std::memory_order_relaxed), ring->threadId});
+        }
+        // The thread kept recording during the copy: the slots of the positions before newHead - capacity were possibly
+        // overwritten, including the one it is writing now.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto const newHead = ring->head.load(std::memory_order_relaxed);
+        auto const firstValid = std::max(first, newHead > capacity ? newHead - capacity : 0);
+        events.erase(events.begin() + static_cast<std::ptrdiff_t>(begin),
+            events.begin() + static_cast<std::ptrdiff_t>(begin + std::min(firstValid, head) - first));
+    }
+    std::sort(events.begin(), events.end(), [](Copy const& a, Copy const& b) { return a.startNs < b.startNs; });
+
+    auto const pid = ::getpid();
+    auto const flags = os.flags();
+    os << std::fixed;
+    os.precision(3);
+    os << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        auto const& event = events[i];
+        os << (i == 0 ? "\n" : ",\n") << "{\"name\":\"";
+        writeEscaped(os, event.name);
+        os << "\",\"cat\":\"" << toString(event.category) << "\",\"ph\":\"X\",\"ts\":"
+           << static_cast<double>(event.startNs) / 1000.
+           << ",\"dur\":" << static_cast<double>(event.endNs - event.startNs) / 1000. << ",\"pid\":" << pid
+           << ",\"tid\":" << event.threadId << "}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    os.flags(flags);
+}
+
+std::string Tracer::dump(std::string const& directory) const
+{
+    auto const path
+        = directory + "/timeline_" + std::to_string(::getpid()) + "_" + std::to_string(now()) + ".json";
+    std::ofstream file(path);
+    TLLM_CHECK_WITH_INFO(file.good(), "Failed to open %s", path.c_str());
+    dump(file);
+    TLLM_CHECK_WITH_INFO(file.good(), "Failed to write %s", path.c_str());
+    return path;
+}
+
+void Tracer::installSignalHandler(int signal, std::string directory)
+{
+    int fds[2];
+    TLLM_CHECK_WITH_INFO(::pipe(fds) == 0, "Failed to create the pipe of the timeline tracer");
+    auto expected = -1;
+    if (!gSignalPipe.compare_exchange_strong(expected, fds[1]))
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        TLLM_THROW("A timeline trace signal handler is already installed");
+    }
+
+    std::thread(
+        [this, readFd = fds[0], directory = std::move(directory)]()
+        {
+            char byte;
+            while (::read(readFd, &byte, 1) == 1)
+            {
+                try
+                {
+                    TLLM_LOG_INFO("Wrote timeline trace %s", dump(directory).c_str());
+                }
+                catch (std::exception const& e)
+                {
+                    TLLM_LOG_ERROR("Timeline trace dump failed: %s", e.what());
+                }
+            }
+        })
+        .detach();
+    std::signal(signal, signalHandler);
+}
+
+} // namespace tensorrt_llm::common::timeline
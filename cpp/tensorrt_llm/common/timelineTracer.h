@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::common::timeline
+{
+
+enum class Category : std::uint8_t
+{
+    kScheduling,
+    kKvCacheAllocation,
+    kEngineEnqueue,
+    kDecoderStep,
+    kResponseDelivery,
+    kMpiBroadcast,
+};
+
+char const* toString(Category category);
+
+//! \brief Flight recorder of the host timeline of the in-flight batching loop, for latency spikes on machines where
+//! Nsight cannot run.
+//!
+//! While enabled, every thread records its events into its own ring buffer, which keeps the most recent ones. Recording
+//! takes no lock, the cost of an event is two clock reads and a few stores. A capture, triggered by dump() or by a
+//! signal, writes the events still held by the rings as Chrome trace JSON, which chrome://tracing and Perfetto open.
+//!
+//! TRTLLM_ENABLE_TIMELINE_TRACE=1 enables the tracer at startup and dumps on SIGUSR2 into TRTLLM_TIMELINE_TRACE_DIR.
+//! TRTLLM_TIMELINE_TRACE_EVENTS sets the capacity of the rings.
+class Tracer
+{
+public:
+    static constexpr std::size_t kDefaultEventsPerThread = 1 << 16;
+
+    //! \brief Process-wide tracer, configured from the environment on first use.
+    static Tracer& getInstance();
+
+    explicit Tracer(std::size_t eventsPerThread = kDefaultEventsPerThread);
+
+    Tracer(Tracer const&) = delete;
+    Tracer& operator=(Tracer const&) = delete;
+
+    [[nodiscard]] bool isEnabled() const noexcept
+    {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled) noexcept
+    {
+        mEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    //! \brief Nanoseconds of the clock of the events.
+    static std::int64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    //! \brief Record an event on the ring of the calling thread, overwriting its oldest event when full.
+    //! \param name Must outlive the tracer, typically a string literal.
+    void record(Category category, char const* name, std::int64_t startNs, std::int64_t endNs);
+
+    //! \brief Write the events held by the rings as Chrome trace JSON. Safe while other threads record.
+    void dump(std::ostream& os) const;
+
+    //! \brief Write the capture to a file named after the process and the time in directory.
+    //! \return Path of the file.
+    std::string dump(std::string const& directory) const;
+
+    //! \brief Dump into directory whenever the process receives signal. The capture runs on a thread that lives until
+    //! the process exits, the handler only wakes it up, so the tracer must not be destroyed before. Once per process.
+    void installSignalHandler(int signal, std::string directory);
+
+private:
+    struct Event
+    {
+        std::atomic<char const*> name{nullptr};
+        std::atomic<std::int64_t> startNs{0};
+        std::atomic<std::int64_t> endNs{0};
+        std::atomic<Category> category{Category::kScheduling};
+    };
+
+    // Single producer ring, only its thread writes. A reader drops the events that may have been overwritten while
+    // it copied them, seqlock style. The spare slot is the one being written.
+    struct ThreadRing
+    {
+        ThreadRing(std::size_t capacity, std::uint32_t threadId)
+            : events(capacity + 1)
+            , threadId{threadId}
+        {
+        }
+
+        std::vector<Event> events;
+        // Number of events recorded so far, the ring holds the last events.size() - 1 of them
+        std::atomic<std::uint64_t> head{0};
+        std::uint32_t threadId;
+    };
+
+    ThreadRing& getThreadRing();
+
+    // Distinguishes the tracers in the per-thread cache of the rings
+    std::uint64_t const mId;
+    std::size_t const mEventsPerThread;
+    std::atomic<bool> mEnabled{false};
+    mutable std::mutex mMutex;
+    std::vector<std::shared_ptr<ThreadRing>> mRings;
+    std::uint32_t mNextThreadId{0};
+};
+
+//! \brief Records the lifetime of the scope as an event, when the tracer is enabled at construction.
+class ScopedEvent
+{
+public:
+    ScopedEvent(Category category, char const* name, Tracer& tracer = Tracer::getInstance())
+        : mTracer{tracer}
+        , mCategory{category}
+        , mName{name}
+        , mStartNs{tracer.isEnabled() ? Tracer::now() : -1}
+    {
+    }
+
+    ~ScopedEvent()
+    {
+        if (mStartNs >= 0)
+        {
+            mTracer.record(mCategory, mName, mStartNs, Tracer::now());
+        }
+    }
+
+    ScopedEvent(ScopedEvent const&) = delete;
+    ScopedEvent& operator=(ScopedEvent const&) = delete;
+
+private:
+    Tracer& mTracer;
+    Category mCategory;
+    char const* mName;
+    std::int64_t mStartNs;
+};
+
+} // namespace tensorrt_llm::common::timeline
+
+#define TLLM_TIMELINE_SCOPE(category, range)                                                                           \
+    ::tensorrt_llm::common::timeline::ScopedEvent range##_timeline(                                                    \
+        ::tensorrt_llm::common::timeline::Category::category, #range)
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*! \file
+  \brief Epilogue visitor for GEMMs whose columns come in (linear, gate) pairs, e.g. the FC1 of a SwiGLU MLP with
+  interleaved weights.
+
+  Column 2i of the accumulators is the linear part and column 2i + 1 the gate of output column i. The visitor computes
+  D[:, i] = (alpha * acc[:, 2i] + beta * bias[2i]) * activation(alpha * acc[:, 2i + 1] + beta * bias[2i + 1]), so the
+  output has half the columns of the GEMM and the GEMM results never reach global memory. The pairs never straddle two
+  accesses since the accesses start at multiples of kElementsPerAccess.
+*/
+
+#pragma once
+
+#include "cutlass/arch/memory.h"
+#include "cutlass/cutlass.h"
+#include "cutlass/matrix_coord.h"
+#include "cutlass/numeric_conversion.h"
+
+namespace cutlass
+{
+namespace epilogue
+{
+namespace threadblock
+{
+
+template <typename OutputTileIterator_, typename ElementAccumulator_, typename ElementwiseFunctor_,
+    template <typename> class ActivationFunctor_>
+class EpilogueVisitorGatedActivation
+{
+public:
+    using OutputTileIterator = OutputTileIterator_;
+    using ElementwiseFunctor = ElementwiseFunctor_;
+
+    static int const kIterations = OutputTileIterator::kIterations;
+    static int const kElementsPerAccess = OutputTileIterator::kElementsPerAccess;
+    static_assert(kElementsPerAccess % 2 == 0, "An access must hold whole (linear, gate) pairs");
+    static int const kOutputsPerAccess = kElementsPerAccess / 2;
+    //! Columns of the GEMM per column of the output
+    static int const kColumnsPerOutput = 2;
+
+    using ElementOutput = typename OutputTileIterator::Element;
+    using ElementAccumulator = ElementAccumulator_;
+    using ElementCompute = typename ElementwiseFunctor::ElementCompute;
+
+    using AccumulatorFragment = Array<ElementAccumulator, kElementsPerAccess>;
+    using ComputeFragment = Array<ElementCompute, kElementsPerAccess>;
+    using BiasVector = Array<ElementOutput, kElementsPerAccess>;
+    using OutputVector = Array<ElementOutput, kOutputsPerAccess>;
+    using ActivationFunctor = ActivationFunctor_<ElementCompute>;
+
+private:
+    OutputTileIterator iterator_position_;
+    MatrixCoord extent_;
+    ElementOutput const* ptr_bias_;
+    ElementOutput* ptr_D_;
+    int64_t ldd_;
+    ElementCompute alpha_;
+    ElementCompute beta_;
+    ActivationFunctor activation_;
+
+public:
+    //! problem_size and threadblock_offset are in the columns of the GEMM, ptr_bias holds one value per GEMM column and
+    //! ptr_D is [problem_size.row(), problem_size.column() / 2] with a leading dimension of ldd.
+    CUTLASS_DEVICE
+    EpilogueVisitorGatedActivation(typename ElementwiseFunctor::Params const& params,
+        cutlass::MatrixCoord const& problem_size, int thread_idx, ElementOutput const* ptr_bias, ElementOutput* ptr_D,
+        int64_t ldd, cutlass::MatrixCoord const& threadblock_offset)
+        // Only tracks the coordinates of the accesses, the visitor stores the halved rows itself
+        : iterator_position_(typename OutputTileIterator::Params(layout::RowMajor(problem_size.column())), nullptr,
+            problem_size, thread_idx, threadblock_offset)
+        , extent_(problem_size)
+        , ptr_bias_(ptr_bias)
+        , ptr_D_(ptr_D)
+        , ldd_(ldd)
+        , alpha_(params.alpha)
+        , beta_(ptr_bias != nullptr ? params.beta : ElementCompute(0))
+    {
+    }
+
+    /// Called at the start of the epilogue just before iterating over accumulator slices
+    CUTLASS_DEVICE
+    void begin_epilogue() {}
+
+    /// Called at the start of one step before starting accumulator exchange
+    CUTLASS_DEVICE
+    void begin_step(int step_idx) {}
+
+    /// Called at the start of a row
+    CUTLASS_DEVICE
+    void begin_row(int row_idx) {}
+
+    /// Called after accumulators have been exchanged for each accumulator vector
+    CUTLASS_DEVICE
+    void visit(int iter_idx, int row_idx, int column_idx, int frag_idx, AccumulatorFragment const& accum)
+    {
+        MatrixCoord const thread_offset
+            = iterator_position_.thread_start() + OutputTileIterator::ThreadMap::iteration_offset(frag_idx);
+        bool const guard = thread_offset.row() < extent_.row() && thread_offset.column() < extent_.column();
+
+        BiasVector bias;
+        bias.clear();
+        if (beta_ != ElementCompute(0))
+        {
+            arch::global_load<BiasVector, sizeof(BiasVector)>(bias, ptr_bias_ + thread_offset.column(), guard);
+        }
+
+        NumericArrayConverter<ElementCompute, ElementAccumulator, kElementsPerAccess> accum_converter;
+        NumericArrayConverter<ElementCompute, ElementOutput, kElementsPerAccess> bias_converter;
+        ComputeFragment const linear = accum_converter(accum);
+        ComputeFragment const bias_compute = bias_converter(bias);
+
+        Array<ElementCompute, kOutputsPerAccess> result;
+        CUTLASS_PRAGMA_UNROLL
+        for (int i = 0; i < kOutputsPerAccess; ++i)
+        {
+            ElementCompute const value = alpha_ * linear[2 * i] + beta_ * bias_compute[2 * i];
+            ElementCompute const gate = alpha_ * linear[2 * i + 1] + beta_ * bias_compute[2 * i + 1];
+            result[i] = value * activation_(gate);
+        }
+
+        NumericArrayConverter<ElementOutput, ElementCompute, kOutputsPerAccess> output_converter;
+        OutputVector const output = output_converter(result);
+        ElementOutput* output_ptr
+            = ptr_D_ + static_cast<int64_t>(thread_offset.row()) * ldd_ + thread_offset.column() / kColumnsPerOutput;
+        arch::global_store<OutputVector, sizeof(OutputVector)>(output, output_ptr, guard);
+    }
+
+    /// Called at the end of a row
+    CUTLASS_DEVICE
+    void end_row(int row_idx) {}
+
+    /// Called after all accumulator elements have been visited
+    CUTLASS_DEVICE
+    void end_step(int step_idx)
+    {
+        ++iterator_position_;
+    }
+
+    /// Called after all steps have been completed
+    CUTLASS_DEVICE
+    void end_epilogue() {}
+};
+
+} // namespace threadblock
+} // namespace epilogue
+} // namespace cutlass
@@ -31,6 +31,9 @@
 /*! \file
   \brief Epilogue visitor for threadblock scoped INT8 GEMMs that uses one scaling factor per row, and one per column.
 
+  The scaled accumulators can further get a per-column bias, an activation and a residual (the C operand, scaled by
+  beta) before the conversion to the output: D = activation(acc * alpha_row * alpha_col + bias) + beta * C.
+
   original file: 3rdparty/cutlass/include/cutlass/epilogue/threadblock/epilogue_visitor_with_softmax.h
 
 */
@@ -42,6 +45,7 @@
 #include "cutlass/arch/memory.h"
 #include "cutlass/arch/memory_sm75.h"
 #include "cutlass/cutlass.h"
+#include "cutlass/epilogue/thread/activation.h"
 #include "cutlass/fast_math.h"
 #include "cutlass/numeric_conversion.h"
 #include "tensorrt_llm/common/quantization.h"
@@ -56,7 +60,8 @@ namespace threadblock
 {
 
 template <typename ThreadblockShape_, int ThreadCount, typename ScaleTileIterator_, typename OutputTileIterator_,
-    typename ElementAccumulator_, typename ElementCompute_, typename ElementwiseFunctor_, bool UseMasking_ = false>
+    typename ElementAccumulator_, typename ElementCompute_, typename ElementwiseFunctor_, bool UseMasking_ = false,
+    template <typename> class ActivationFunctor_ = cutlass::epilogue::thread::Identity>
 class EpilogueVisitorPerRowPerCol
 {
 public:
@@ -80,6 +85,7 @@ public:
     using AccumulatorFragment = Array<ElementAccumulator, kElementsPerAccess>;
     using ComputeFragment = Array<ElementCompute_, kElementsPerAccess>;
     using OutputVector = Array<ElementOutput, kElementsPerAccess>;
+    using ActivationFunctor = ActivationFunctor_<ComputeFragment>;
 
     static int const kThreadsPerRow = OutputTileIterator::ThreadMap::Detail::kAccessWidth;
     static bool const kHasMultiStepsInRow = (OutputTileIterator::ThreadMap::Iterations::kColumn > 1);
@@ -92,6 +98,8 @@ public:
         int64_t batch_stride_alpha;
         int64_t batch_stride_C;
         int64_t batch_stride_D;
+        // Per-column bias of the output type, nullptr if there is none
+        ElementOutput* ptr_bias = nullptr;
 
         //
         // Methods
@@ -119,6 +127,16 @@ public:
             , batch_stride_D(batch_stride_D_)
         {
         }
+
+        Arguments(typename ElementwiseFunctor::Params elementwise_, int64_t batch_stride_alpha_,
+            int64_t batch_stride_C_, int64_t batch_stride_D_, ElementOutput* ptr_bias_)
+            : elementwise(elementwise_)
+            , batch_stride_alpha(batch_stride_alpha_)
+            , batch_stride_C(batch_stride_C_)
+            , batch_stride_D(batch_stride_D_)
+            , ptr_bias(ptr_bias_)
+        {
+        }
     };
 
     struct Params
@@ -128,6 +146,9 @@ public:
         int64_t batch_stride_alpha;
         int64_t batch_stride_C;
         int64_t batch_stride_D;
+        ElementOutput* ptr_bias;
+        // The bias is read as a row-major matrix with a zero row stride, like alpha_col
+        typename OutputTileIterator::Params params_bias;
 
         //
         // Methods
@@ -141,6 +162,8 @@ public:
             , batch_stride_alpha(args.batch_stride_alpha)
             , batch_stride_C(args.batch_stride_C)
             , batch_stride_D(args.batch_stride_D)
+            , ptr_bias(args.ptr_bias)
+            , params_bias(LayoutOutput(0))
         {
         }
     };
@@ -163,16 +186,20 @@ private:
     AlphaScaleElementType* ptr_alpha_row_;
     AlphaScaleElementType* ptr_alpha_col_;
     ScaleTileIterator iterator_alpha_col_;
+    OutputTileIterator iterator_bias_;
     OutputTileIterator iterator_C_;
     OutputTileIterator iterator_D_;
+    ActivationFunctor activation_;
 
     AlphaScaleElementType element_alpha_row_ = 1.0f;
     AlphaScaleElementType element_alpha_col_ = 1.0f;
     typename ScaleTileIterator::Fragment fragment_alpha_col_;
+    typename OutputTileIterator::Fragment fragment_bias_;
     typename OutputTileIterator::Fragment fragment_C_;
     typename OutputTileIterator::Fragment fragment_D_;
 
     ElementAccumulator beta_;
+    bool has_residual_;
 
     int column_offset_;
 
@@ -197,17 +224,24 @@ public:
         , ptr_alpha_row_(ptr_alpha_row)
         , ptr_alpha_col_(ptr_alpha_col)
         , iterator_alpha_col_(params_alpha_col, ptr_alpha_col, problem_size, thread_idx, threadblock_offset)
+        , iterator_bias_(params.params_bias, params.ptr_bias, problem_size, thread_idx, threadblock_offset)
         , iterator_C_(params_C, ptr_C, problem_size, thread_idx, threadblock_offset)
         , iterator_D_(params_D, ptr_D, problem_size, thread_idx, threadblock_offset)
         , extent_real_(problem_size_real)
     {
         beta_ = (params.elementwise.beta_ptr ? *params.elementwise.beta_ptr : params.elementwise.beta);
 
-        if (beta_ == ElementAccumulator())
+        has_residual_ = beta_ != ElementAccumulator() && ptr_C != nullptr;
+        if (!has_residual_)
         {
             iterator_C_.clear_mask();
         }
 
+        if (params.ptr_bias == nullptr)
+        {
+            iterator_bias_.clear_mask();
+        }
+
         if (!per_channel_quant_ && (ptr_alpha_col_ != nullptr))
         {
             element_alpha_col_ = *ptr_alpha_col_;
@@ -243,6 +277,9 @@ public:
         {
             iterator_alpha_col_.load(fragment_alpha_col_);
         }
+        // Masked off without a bias, which leaves zeros
+        fragment_bias_.clear();
+        iterator_bias_.load(fragment_bias_);
     }
 
     /// Called at the start of one step before starting accumulator exchange
@@ -252,7 +289,7 @@ public:
         fragment_D_.clear();
         fragment_C_.clear();
 
-        if (elementwise_.kScale != cutlass::epilogue::thread::ScaleType::OnlyAlphaScaling)
+        if (has_residual_ && elementwise_.kScale != cutlass::epilogue::thread::ScaleType::OnlyAlphaScaling)
         {
             iterator_C_.load(fragment_C_);
             ++iterator_C_;
@@ -292,6 +329,26 @@ public:
             result = per_token_scale_accumulator_(result, element_alpha_col_, element_alpha_row_);
         }
 
+        NumericArrayConverter<ElementCompute, ElementOutput, kElementsPerAccess> input_converter;
+        ComputeFragment bias = input_converter(reinterpret_cast<OutputVector const*>(&fragment_bias_)[column_idx]);
+        CUTLASS_PRAGMA_UNROLL
+        for (int i = 0; i < kElementsPerAccess; ++i)
+        {
+            result[i] += bias[i];
+        }
+
+        result = activation_(result);
+
+        if (has_residual_)
+        {
+            ComputeFragment residual = input_converter(reinterpret_cast<OutputVector const*>(&fragment_C_)[frag_idx]);
+            CUTLASS_PRAGMA_UNROLL
+            for (int i = 0; i < kElementsPerAccess; ++i)
+            {
+                result[i] += static_cast<ElementCompute>(beta_) * residual[i];
+            }
+        }
+
         // Convert to the output
         NumericArrayConverter<ElementOutput, ElementCompute, kElementsPerAccess> output_converter;
         OutputVector& output = reinterpret_cast<OutputVector*>(&fragment_D_)[frag_idx];
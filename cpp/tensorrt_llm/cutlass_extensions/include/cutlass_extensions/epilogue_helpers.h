@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include "cutlass/epilogue/thread/activation.h"
 #include "cutlass/epilogue/thread/linear_combination.h"
 #include "cutlass/epilogue/thread/linear_combination_generic.h"
 #include "cutlass/epilogue/thread/linear_combination_relu.h"
@@ -68,6 +69,40 @@ struct EpilogueOpDefault
 {
 };
 
+// Gated activations of a GEMM with interleaved columns: column 2i is the linear part and column 2i + 1 the gate of
+// output column i, so the output has half the columns of the GEMM.
+struct EpilogueOpGatedSilu
+{
+};
+
+struct EpilogueOpGatedGelu
+{
+};
+
+template <typename Op>
+struct GatedEpilogueActivation
+{
+    static constexpr bool value = false;
+};
+
+template <>
+struct GatedEpilogueActivation<EpilogueOpGatedSilu>
+{
+    static constexpr bool value = true;
+
+    template <typename T>
+    using type = cutlass::epilogue::thread::SiLu<T>;
+};
+
+template <>
+struct GatedEpilogueActivation<EpilogueOpGatedGelu>
+{
+    static constexpr bool value = true;
+
+    template <typename T>
+    using type = cutlass::epilogue::thread::GELU<T>;
+};
+
 template <typename ElementType, int ElementsPerVectorAccess, typename ElementAccumulator, typename Op>
 struct Epilogue
 {
@@ -135,5 +170,20 @@ struct Epilogue<ElementType, ElementsPerVectorAccess, ElementAccumulator, Epilog
         ElementAccumulator, DefaultScaleMode>;
 };
 
+// The linear combination applied to both columns of a pair before the gate
+template <typename ElementType, int ElementsPerVectorAccess, typename ElementAccumulator>
+struct Epilogue<ElementType, ElementsPerVectorAccess, ElementAccumulator, EpilogueOpGatedSilu>
+{
+    using Op = cutlass::epilogue::thread::LinearCombination<ElementType, ElementsPerVectorAccess, ElementAccumulator,
+        ElementAccumulator, DefaultScaleMode>;
+};
+
+template <typename ElementType, int ElementsPerVectorAccess, typename ElementAccumulator>
+struct Epilogue<ElementType, ElementsPerVectorAccess, ElementAccumulator, EpilogueOpGatedGelu>
+{
+    using Op = cutlass::epilogue::thread::LinearCombination<ElementType, ElementsPerVectorAccess, ElementAccumulator,
+        ElementAccumulator, DefaultScaleMode>;
+};
+
 } // namespace cutlass_extensions
 } // namespace tensorrt_llm
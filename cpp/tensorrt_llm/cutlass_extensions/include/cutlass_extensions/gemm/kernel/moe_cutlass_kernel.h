@@ -60,6 +60,31 @@ struct use_dq_gemm<Mma, void_t<typename Mma::IteratorScale>> : platform::true_ty
 {
 };
 
+// Likewise, epilogues that run a visitor (e.g. the gated activations) let the visitor store the output.
+template <typename Epilogue, typename = void>
+struct use_epilogue_visitor : platform::false_type
+{
+};
+
+template <typename Epilogue>
+struct use_epilogue_visitor<Epilogue, void_t<typename Epilogue::Visitor>> : platform::true_type
+{
+};
+
+template <typename Epilogue, bool = use_epilogue_visitor<Epilogue>::value>
+struct moe_epilogue_types
+{
+    using OutputOp = typename Epilogue::OutputOp;
+    using OutputTileIterator = typename Epilogue::OutputTileIterator;
+};
+
+template <typename Epilogue>
+struct moe_epilogue_types<Epilogue, true>
+{
+    using OutputOp = typename Epilogue::Visitor::ElementwiseFunctor;
+    using OutputTileIterator = typename Epilogue::Visitor::OutputTileIterator;
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename Mma_,          ///! Threadblock-scoped matrix multiply-accumulate
@@ -74,7 +99,8 @@ struct MoeFCGemm
 public:
     using Mma = Mma_;
     using Epilogue = Epilogue_;
-    using EpilogueOutputOp = typename Epilogue::OutputOp;
+    using EpilogueOutputOp = typename moe_epilogue_types<Epilogue>::OutputOp;
+    using EpilogueOutputTileIterator = typename moe_epilogue_types<Epilogue>::OutputTileIterator;
     using ThreadblockSwizzle = ThreadblockSwizzle_;
     static GroupScheduleMode const kGroupScheduleMode = GroupScheduleMode_;
     static bool const kTransposed = false;
@@ -92,7 +118,7 @@ public:
     using LayoutA = typename MapArguments::LayoutA;
     using ElementB = typename MapArguments::ElementB;
     using LayoutB = typename MapArguments::LayoutB;
-    using ElementC = typename Epilogue::OutputTileIterator::Element;
+    using ElementC = typename EpilogueOutputTileIterator::Element;
     using LayoutC = typename MapArguments::LayoutC;
     using ElementScale = ElementC;
 
@@ -110,7 +136,7 @@ public:
     static int const kStages = Mma::kStages;
     static int const kAlignmentA = MapArguments::kAlignmentA;
     static int const kAlignmentB = MapArguments::kAlignmentB;
-    static int const kAlignmentC = Epilogue::OutputTileIterator::kElementsPerAccess;
+    static int const kAlignmentC = EpilogueOutputTileIterator::kElementsPerAccess;
 
     /// Warp count (concept: GemmShape)
     using WarpCount = typename Mma::WarpCount;
@@ -312,6 +338,11 @@ public:
             CUTLASS_TRACE_HOST("MoeFCGemm::can_implement() - gemm_n is smaller than the input alignment");
             return Status::kInvalid;
         }
+        else if (use_epilogue_visitor<Epilogue>::value && args.gemm_n % kAlignmentC != 0)
+        {
+            CUTLASS_TRACE_HOST("MoeFCGemm::can_implement() - gemm_n is not a multiple of the output alignment");
+            return Status::kInvalid;
+        }
         return Status::kSuccess;
     }
 
@@ -332,8 +363,8 @@ public:
         using LayoutA = typename Mma::IteratorA::Layout;
         using ElementB = typename Mma::IteratorB::Element;
         using LayoutB = typename Mma::IteratorB::Layout;
-        using ElementC = typename Epilogue::OutputTileIterator::Element;
-        using LayoutC = typename Epilogue::OutputTileIterator::Layout;
+        using ElementC = typename EpilogueOutputTileIterator::Element;
+        using LayoutC = typename EpilogueOutputTileIterator::Layout;
         static constexpr int kInterleave = Mma::IteratorB::Shape::kRow / Mma::Shape::kK;
         static_assert(platform::is_same<LayoutB, layout::RowMajor>::value && kInterleave == 1
                 || platform::is_same<LayoutB, layout::ColumnMajor>::value && kInterleave >= 1,
@@ -444,29 +475,48 @@ public:
             // Epilogue
             //
 
-            EpilogueOutputOp output_op(params.output_op);
-
             ElementC* ptr_C = reinterpret_cast<ElementC*>(params.ptr_C) + problem_idx * gemm_n;
-            ElementC* ptr_D = reinterpret_cast<ElementC*>(params.ptr_D) + rows_to_jump * gemm_n;
 
-            LayoutC layout_C(0);
-            LayoutC layout_D(gemm_n);
+            if constexpr (use_epilogue_visitor<Epilogue>::value)
+            {
+                using EpilogueVisitor = typename Epilogue::Visitor;
+
+                // The output has one column per kColumnsPerOutput columns of the GEMM
+                const int64_t ldd = gemm_n / EpilogueVisitor::kColumnsPerOutput;
+                ElementC* ptr_D = reinterpret_cast<ElementC*>(params.ptr_D) + rows_to_jump * ldd;
 
-            typename Epilogue::OutputTileIterator::Params params_C(layout_C);
-            typename Epilogue::OutputTileIterator::Params params_D(layout_D);
+                EpilogueVisitor epilogue_visitor(params.output_op, problem_size.mn(), thread_idx,
+                    params.ptr_C ? ptr_C : nullptr, ptr_D, ldd, threadblock_offset.mn());
 
-            // Tile iterator loading from source tensor.
-            typename Epilogue::OutputTileIterator iterator_C(
-                params_C, ptr_C, problem_size.mn(), thread_idx, threadblock_offset.mn());
+                Epilogue epilogue(shared_storage.epilogue, thread_idx, warp_idx, lane_idx);
 
-            // Tile iterator writing to destination tensor.
-            typename Epilogue::OutputTileIterator iterator_D(
-                params_D, ptr_D, problem_size.mn(), thread_idx, threadblock_offset.mn());
+                epilogue(epilogue_visitor, accumulators);
+            }
+            else
+            {
+                EpilogueOutputOp output_op(params.output_op);
 
-            Epilogue epilogue(shared_storage.epilogue, thread_idx, warp_idx, lane_idx);
+                ElementC* ptr_D = reinterpret_cast<ElementC*>(params.ptr_D) + rows_to_jump * gemm_n;
 
-            // Execute the epilogue operator to update the destination tensor.
-            epilogue(output_op, iterator_D, accumulators, iterator_C);
+                LayoutC layout_C(0);
+                LayoutC layout_D(gemm_n);
+
+                typename Epilogue::OutputTileIterator::Params params_C(layout_C);
+                typename Epilogue::OutputTileIterator::Params params_D(layout_D);
+
+                // Tile iterator loading from source tensor.
+                typename Epilogue::OutputTileIterator iterator_C(
+                    params_C, ptr_C, problem_size.mn(), thread_idx, threadblock_offset.mn());
+
+                // Tile iterator writing to destination tensor.
+                typename Epilogue::OutputTileIterator iterator_D(
+                    params_D, ptr_D, problem_size.mn(), thread_idx, threadblock_offset.mn());
+
+                Epilogue epilogue(shared_storage.epilogue, thread_idx, warp_idx, lane_idx);
+
+                // Execute the epilogue operator to update the destination tensor.
+                epilogue(output_op, iterator_D, accumulators, iterator_C);
+            }
 
             // Next tile
             problem_visitor.advance(gridDim.x);
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/ahoCorasick.h"
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+std::vector<int32_t> buildAhoCorasick(std::vector<std::vector<int32_t>> const& words)
+{
+    // Trie with ordered children, so that the edges of each state come out sorted by token
+    std::vector<std::map<int32_t, int32_t>> children(1);
+    std::vector<int32_t> wordLength(1, 0);
+    for (auto const& word : words)
+    {
+        if (word.empty())
+        {
+            continue;
+        }
+        int32_t state = AhoCorasickView::kRootState;
+        for (auto const token : word)
+        {
+            TLLM_CHECK_WITH_INFO(token >= 0, "Invalid token %d in words list", token);
+            auto [it, inserted] = children[state].try_emplace(token, static_cast<int32_t>(children.size()));
+            if (inserted)
+            {
+                children.emplace_back();
+                wordLength.push_back(0);
+            }
+            state = it->second;
+        }
+        wordLength[state] = static_cast<int32_t>(word.size());
+    }
+
+    auto const numStates = static_cast<int32_t>(children.size());
+    std::vector<int32_t> failure(numStates, AhoCorasickView::kRootState);
+    std::vector<int32_t> matchLength(wordLength);
+    std::vector<std::vector<int32_t>> banned(numStates);
+
+    // Breadth-first, so that the failure state of every state has been processed before it
+    std::queue<int32_t> queue;
+    for (auto const& [token, child] : children[AhoCorasickView::kRootState])
+    {
+        queue.push(child);
+    }
+    for (auto const& [token, child] : children[AhoCorasickView::kRootState])
+    {
+        if (wordLength[child] > 0)
+        {
+            banned[AhoCorasickView::kRootState].push_back(token);
+        }
+    }
+    while (!queue.empty())
+    {
+        auto const state = queue.front();
+        queue.pop();
+        matchLength[state] = std::max(matchLength[state], matchLength[failure[state]]);
+
+        // Tokens completing a word from this state or from one of its proper suffixes, except the root
+        for (auto const& [token, child] : children[state])
+        {
+            if (wordLength[child] > 0)
+            {
+                banned[state].push_back(token);
+            }
+        }
+        if (failure[state] != AhoCorasickView::kRootState)
+        {
+            auto const& suffixBanned = banned[failure[state]];
+            banned[state].insert(banned[state].end(), suffixBanned.begin(), suffixBanned.end());
+        }
+        std::sort(banned[state].begin(), banned[state].end());
+        banned[state].erase(std::unique(banned[state].begin(), banned[state].end()), banned[state].end());
+        auto const& rootBanned = banned[AhoCorasickView::kRootState];
+        banned[state].erase(std::remove_if(banned[state].begin(), banned[state].end(),
+                                [&rootBanned](int32_t token)
+                                { return std::binary_search(rootBanned.begin(), rootBanned.end(), token); }),
+            banned[state].end());
+
+        for (auto const& [token, child] : children[state])
+        {
+            auto fallback = failure[state];
+            while (true)
+            {
+                auto it = children[fallback].find(token);
+                if (it != children[fallback].end())
+                {
+                    failure[child] = it->second;
+                    break;
+                }
+                if (fallback == AhoCorasickView::kRootState)
+                {
+                    failure[child] = AhoCorasickView::kRootState;
+                    break;
+                }
+                fallback = failure[fallback];
+            }
+            queue.push(child);
+        }
+    }
+
+    int32_t numEdges = 0;
+    int32_t numBanned = 0;
+    for (int32_t state = 0; state < numStates; ++state)
+    {
+        numEdges += static_cast<int32_t>(children[state].size());
+        numBanned += static_cast<int32_t>(banned[state].size());
+    }
+
+    std::vector<int32_t> data;
+    data.reserve(AhoCorasickView::kHeaderSize + 4 * numStates + 2 + 2 * numEdges + numBanned);
+    data.push_back(numStates);
+    data.push_back(numEdges);
+    data.push_back(numBanned);
+    // edgeOffsets
+    int32_t offset = 0;
+    for (int32_t state = 0; state < numStates; ++state)
+    {
+        data.push_back(offset);
+        offset += static_cast<int32_t>(children[state].size());
+    }
+    data.push_back(offset);
+    // edgeTokens, edgeTargets
+    for (int32_t state = 0; state < numStates; ++state)
+    {
+        for (auto const& [token, child] : children[state])
+        {
+            data.push_back(token);
+        }
+    }
+    for (int32_t state = 0; state < numStates; ++state)
+    {
+        for (auto const& [token, child] : children[state])
+        {
+            data.push_back(child);
+        }
+    }
+    data.insert(data.end(), failure.begin(), failure.end());
+    data.insert(data.end(), matchLength.begin(), matchLength.end());
+    // bannedOffsets, bannedTokens
+    offset = 0;
+    for (int32_t state = 0; state < numStates; ++state)
+    {
+        data.push_back(offset);
+        offset += static_cast<int32_t>(banned[state].size());
+    }
+    data.push_back(offset);
+    for (int32_t state = 0; state < numStates; ++state)
+    {
+        data.insert(data.end(), banned[state].begin(), banned[state].end());
+    }
+    return data;
+}
+
+std::vector<int32_t> buildAhoCorasickFromWordsList(int32_t const* wordsList, int32_t wordsLen)
+{
+    auto const* tokens = wordsList;
+    auto const* offsets = wordsList + wordsLen;
+    std::vector<std::vector<int32_t>> words;
+    int32_t begin = 0;
+    for (int32_t wi = 0; wi < wordsLen && offsets[wi] >= 0; ++wi)
+    {
+        auto const end = std::min(offsets[wi], wordsLen);
+        words.emplace_back(tokens + begin, tokens + end);
+        begin = end;
+    }
+    return buildAhoCorasick(words);
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+//! \brief Read-only view of an Aho-Corasick automaton over token ids, stored in a single int32_t buffer so that it
+//! can be passed per request like the stop and bad words lists.
+//!
+//! Layout of the buffer, S states, E trie edges and B banned tokens:
+//! [S, E, B, edgeOffsets[S + 1], edgeTokens[E], edgeTargets[E], failure[S], matchLength[S], bannedOffsets[S + 1],
+//! bannedTokens[B]]
+//! The edges of each state are sorted by token. matchLength is the length of the longest word ending in a state,
+//! 0 if none. bannedTokens of a state are the tokens that complete a word from it, excluding the ones of the root
+//! state which are banned in every state. State 0 is the root.
+class AhoCorasickView
+{
+public:
+    static constexpr int32_t kHeaderSize = 3;
+    static constexpr int32_t kRootState = 0;
+
+    __host__ __device__ explicit AhoCorasickView(int32_t const* data)
+        : mNumStates{data[0]}
+        , mEdgeOffsets{data + kHeaderSize}
+        , mEdgeTokens{mEdgeOffsets + data[0] + 1}
+        , mEdgeTargets{mEdgeTokens + data[1]}
+        , mFailure{mEdgeTargets + data[1]}
+        , mMatchLength{mFailure + data[0]}
+        , mBannedOffsets{mMatchLength + data[0]}
+        , mBannedTokens{mBannedOffsets + data[0] + 1}
+    {
+    }
+
+    [[nodiscard]] __host__ __device__ int32_t getNumStates() const
+    {
+        return mNumStates;
+    }
+
+    //! \brief Trie child of state for token, -1 if none.
+    [[nodiscard]] __host__ __device__ int32_t getChild(int32_t state, int32_t token) const
+    {
+        auto lo = mEdgeOffsets[state];
+        auto hi = mEdgeOffsets[state + 1];
+        while (lo < hi)
+        {
+            auto const mid = (lo + hi) / 2;
+            auto const midToken = mEdgeTokens[mid];
+            if (midToken == token)
+            {
+                return mEdgeTargets[mid];
+            }
+            if (midToken < token)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return -1;
+    }
+
+    //! \brief State reached from state after token. Amortized O(1) over a sequence.
+    [[nodiscard]] __host__ __device__ int32_t next(int32_t state, int32_t token) const
+    {
+        while (true)
+        {
+            auto const child = getChild(state, token);
+            if (child >= 0)
+            {
+                return child;
+            }
+            if (state == kRootState)
+            {
+                return kRootState;
+            }
+            state = mFailure[state];
+        }
+    }
+
+    [[nodiscard]] __host__ __device__ int32_t getMatchLength(int32_t state) const
+    {
+        return mMatchLength[state];
+    }
+
+    [[nodiscard]] __host__ __device__ int32_t getBannedBegin(int32_t state) const
+    {
+        return mBannedOffsets[state];
+    }
+
+    [[nodiscard]] __host__ __device__ int32_t getBannedEnd(int32_t state) const
+    {
+        return mBannedOffsets[state + 1];
+    }
+
+    [[nodiscard]] __host__ __device__ int32_t getBannedToken(int32_t idx) const
+    {
+        return mBannedTokens[idx];
+    }
+
+private:
+    int32_t mNumStates;
+    int32_t const* mEdgeOffsets;
+    int32_t const* mEdgeTokens;
+    int32_t const* mEdgeTargets;
+    int32_t const* mFailure;
+    int32_t const* mMatchLength;
+    int32_t const* mBannedOffsets;
+    int32_t const* mBannedTokens;
+};
+
+//! \brief Builds the automaton matching any of words, in the layout of AhoCorasickView.
+std::vector<int32_t> buildAhoCorasick(std::vector<std::vector<int32_t>> const& words);
+
+//! \brief Builds the automaton from a words list [2, wordsLen] in the format of the stop and bad words lists, i.e.
+//! the token ids followed by the offsets of the end of each word, padded with -1.
+std::vector<int32_t> buildAhoCorasickFromWordsList(int32_t const* wordsList, int32_t wordsLen);
+
+} // namespace kernels
+} // namespace tensorrt_llm
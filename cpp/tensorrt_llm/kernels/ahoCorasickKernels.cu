@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/ahoCorasick.h"
+#include "tensorrt_llm/kernels/ahoCorasickKernels.h"
+
+#include <cuda_fp16.h>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template <typename T>
+__global__ void banBadWordsAhoCorasick(T* logits, int32_t const* const* badWordsAutomata, int32_t const* states,
+    int32_t const* batchSlots, int32_t vocabSizePadded)
+{
+    auto const batchIdx = static_cast<int32_t>(blockIdx.x);
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+    auto const* automatonData = badWordsAutomata[batchSlot];
+    if (automatonData == nullptr)
+    {
+        return;
+    }
+    AhoCorasickView const automaton{automatonData};
+    auto const state = states[batchSlot * kNumWordsAutomata + kBadWordsAutomatonIdx];
+    auto* batchLogits = logits + static_cast<size_t>(batchIdx) * vocabSizePadded;
+    auto const tid = static_cast<int32_t>(threadIdx.x);
+
+    // Single token words are banned in every state
+    auto const rootEnd = automaton.getBannedEnd(AhoCorasickView::kRootState);
+    for (auto idx = automaton.getBannedBegin(AhoCorasickView::kRootState) + tid; idx < rootEnd; idx += blockDim.x)
+    {
+        batchLogits[automaton.getBannedToken(idx)] = static_cast<T>(-INFINITY);
+    }
+    if (state == AhoCorasickView::kRootState)
+    {
+        return;
+    }
+    auto const stateEnd = automaton.getBannedEnd(state);
+    for (auto idx = automaton.getBannedBegin(state) + tid; idx < stateEnd; idx += blockDim.x)
+    {
+        batchLogits[automaton.getBannedToken(idx)] = static_cast<T>(-INFINITY);
+    }
+}
+
+template <typename T>
+void invokeBanBadWordsAhoCorasick(T* logits, int32_t const* const* badWordsAutomata, int32_t const* states,
+    int32_t const* batchSlots, int32_t batchSize, int32_t vocabSizePadded, cudaStream_t stream)
+{
+    constexpr int32_t blockSize{128};
+    banBadWordsAhoCorasick<<<batchSize, blockSize, 0, stream>>>(
+        logits, badWordsAutomata, states, batchSlots, vocabSizePadded);
+    sync_check_cuda_error();
+}
+
+template void invokeBanBadWordsAhoCorasick(float* logits, int32_t const* const* badWordsAutomata,
+    int32_t const* states, int32_t const* batchSlots, int32_t batchSize, int32_t vocabSizePadded, cudaStream_t stream);
+template void invokeBanBadWordsAhoCorasick(half* logits, int32_t const* const* badWordsAutomata, int32_t const* states,
+    int32_t const* batchSlots, int32_t batchSize, int32_t vocabSizePadded, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeBanBadWordsAhoCorasick(__nv_bfloat16* logits, int32_t const* const* badWordsAutomata,
+    int32_t const* states, int32_t const* batchSlots, int32_t batchSize, int32_t vocabSizePadded, cudaStream_t stream);
+#endif
+
+__global__ void advanceWordsAutomata(int32_t const* const* stopWordsAutomata,
+    int32_t const* const* badWordsAutomata, int32_t* states, int32_t const** outputIds, FinishedState* finished,
+    int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t batchSize)
+{
+    auto const batchIdx = static_cast<int32_t>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (batchIdx >= batchSize)
+    {
+        return;
+    }
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+    auto const seqLen = sequenceLengths[batchSlot];
+    if (seqLen <= 0 || (finished != nullptr && finished[batchSlot].isFinished()))
+    {
+        return;
+    }
+    auto const token = outputIds[batchSlot][seqLen - 1];
+    auto* slotStates = states + batchSlot * kNumWordsAutomata;
+
+    if (auto const* automatonData = badWordsAutomata != nullptr ? badWordsAutomata[batchSlot] : nullptr)
+    {
+        AhoCorasickView const automaton{automatonData};
+        slotStates[kBadWordsAutomatonIdx] = automaton.next(slotStates[kBadWordsAutomatonIdx], token);
+    }
+    if (auto const* automatonData = stopWordsAutomata != nullptr ? stopWordsAutomata[batchSlot] : nullptr)
+    {
+        AhoCorasickView const automaton{automatonData};
+        auto const state = automaton.next(slotStates[kStopWordsAutomatonIdx], token);
+        slotStates[kStopWordsAutomatonIdx] = state;
+        if (automaton.getMatchLength(state) > 0 && finished != nullptr)
+        {
+            finished[batchSlot].setFinishedStopWords();
+        }
+    }
+}
+
+void invokeAdvanceWordsAutomata(int32_t const* const* stopWordsAutomata, int32_t const* const* badWordsAutomata,
+    int32_t* states, int32_t const** outputIds, FinishedState* finished, int32_t const* sequenceLengths,
+    int32_t const* batchSlots, int32_t batchSize, cudaStream_t stream)
+{
+    constexpr int32_t blockSize{128};
+    dim3 grid((batchSize + blockSize - 1) / blockSize);
+    advanceWordsAutomata<<<grid, blockSize, 0, stream>>>(
+        stopWordsAutomata, badWordsAutomata, states, outputIds, finished, sequenceLengths, batchSlots, batchSize);
+    sync_check_cuda_error();
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
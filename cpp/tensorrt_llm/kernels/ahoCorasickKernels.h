@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Indices of the automata states kept per request
+static constexpr int32_t kStopWordsAutomatonIdx = 0;
+static constexpr int32_t kBadWordsAutomatonIdx = 1;
+static constexpr int32_t kNumWordsAutomata = 2;
+
+//! \brief Sets the logits of the tokens that would complete a bad word to -inf, using the Aho-Corasick automaton
+//! state of each request instead of matching every word against the tail of the output.
+//!
+//! \param logits input/output buffer [batchSize, vocabSizePadded]
+//! \param badWordsAutomata input buffer [maxBatchSize], automata built by buildAhoCorasick, nullptr if none
+//! \param states input buffer [maxBatchSize, kNumWordsAutomata]. Current automata states
+//! \param batchSlots input buffer [batchSize], optional. Indices of rows of data in memory pool
+//! \param batchSize batch size
+//! \param vocabSizePadded size of padded vocab
+//! \param stream stream
+template <typename T>
+void invokeBanBadWordsAhoCorasick(T* logits, int32_t const* const* badWordsAutomata, int32_t const* states,
+    int32_t const* batchSlots, int32_t batchSize, int32_t vocabSizePadded, cudaStream_t stream);
+
+//! \brief Advances the stop and bad words automata of each request by the token generated in the last step.
+//! Sets finished state to FinishedState::FINISHED_STOP_WORDS if a stop word has been completed. The cost per step is
+//! independent of the number and length of the words. Only beam width 1 is supported.
+//!
+//! \param stopWordsAutomata input buffer [maxBatchSize], automata built by buildAhoCorasick, nullptr if none
+//! \param badWordsAutomata input buffer [maxBatchSize], automata built by buildAhoCorasick, nullptr if none
+//! \param states input/output buffer [maxBatchSize, kNumWordsAutomata]. Automata states, 0 for a new request
+//! \param outputIds input buffer [maxBatchSize][maxSeqLen]. Contains pointers to rows with output tokens per request
+//! \param finished input/output buffer [maxBatchSize]. Requests finished in earlier steps are skipped
+//! \param sequenceLengths input buffer [maxBatchSize]. Sequence lengths including the last token
+//! \param batchSlots input buffer [batchSize], optional. Indices of rows of data in memory pool
+//! \param batchSize batch size
+//! \param stream stream
+void invokeAdvanceWordsAutomata(int32_t const* const* stopWordsAutomata, int32_t const* const* badWordsAutomata,
+    int32_t* states, int32_t const** outputIds, FinishedState* finished, int32_t const* sequenceLengths,
+    int32_t const* batchSlots, int32_t batchSize, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
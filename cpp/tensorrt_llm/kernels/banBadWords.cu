@@ -16,6 +16,7 @@
 
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/kernels/banBadWords.h"
+#include "tensorrt_llm/kernels/banBadWordsUtils.h"
 
 using namespace tensorrt_llm::common;
 
@@ -35,63 +36,18 @@ __global__ void ban_bad_words(T* logits, int32_t const** output_ids_ptr, int32_t
     auto const batch_slot = batch_slots != nullptr ? batch_slots[batch_idx] : batch_idx;
     auto const batch_beam_idx = batch_slot * beam_width + beam_idx;
 
-    int32_t const* base_bad_words = bad_words_ptrs[batch_slot];
-    auto const bad_words_len = bad_words_lens[batch_slot];
-    int32_t const* base_bad_words_offsets = base_bad_words + bad_words_len;
-
-    if (id >= bad_words_len || base_bad_words_offsets[id] < 0)
+    if (id >= bad_words_lens[batch_slot])
     {
         return;
     }
 
-    auto const item_end = base_bad_words_offsets[id];
-    auto const item_start = (id > 0) ? base_bad_words_offsets[id - 1] : 0;
-    auto const item_size = item_end - item_start;
-
-    /* The single-token case unconditionally bans the token */
-    bool should_ban = item_size == 1;
-    int32_t const current_step{sequence_lengths[batch_beam_idx]};
-    /* Multi-token case and enough previously generated tokens to look for a match
-     */
-    if (item_size > 1 && current_step >= item_size - 1)
-    {
-        should_ban = true;
-        int32_t parent_id = beam_idx;
-        bool const gather_beam = beam_width > 1;
-
-        for (int32_t token_idx = item_size - 2; token_idx >= 0; token_idx--)
-        {
-            auto const previous_token
-                = output_ids_ptr[batch_slot][parent_id * max_seq_len + current_step - (item_size - 1) + token_idx];
-
-            if (previous_token != base_bad_words[item_start + token_idx])
-            {
-                should_ban = false;
-                break;
-            }
-            if (gather_beam)
-            {
-                parent_id = parent_ids_ptr == nullptr
-                    ? 0
-                    : parent_ids_ptr[batch_slot][parent_id * max_seq_len + current_step - (item_size - 1) + token_idx];
-
-                if (parent_id < 0 || parent_id >= beam_width)
-                {
-                    should_ban = false;
-                    break;
-                }
-            }
-        }
-    }
-
-    if (should_ban)
+    auto const banned_token = getBannedToken(bad_words_ptrs[batch_slot], bad_words_lens[batch_slot], id,
+        output_ids_ptr[batch_slot], parent_ids_ptr == nullptr ? nullptr : parent_ids_ptr[batch_slot], beam_idx,
+        beam_width, sequence_lengths[batch_beam_idx], max_seq_len);
+    if (0 <= banned_token && banned_token < vocab_size_padded)
     {
-        auto banned_token = base_bad_words[item_end - 1];
-        if (0 <= banned_token && banned_token < vocab_size_padded)
-        {
-            logits[batch_idx * beam_width * vocab_size_padded + beam_idx * vocab_size_padded + banned_token]
-                = static_cast<T>(-INFINITY);
-        }
+        logits[batch_idx * beam_width * vocab_size_padded + beam_idx * vocab_size_padded + banned_token]
+            = static_cast<T>(-INFINITY);
     }
 }
 
@@ -127,5 +83,52 @@ template void invokeBanBadWords(float* logits, int32_t const** output_ids_ptr, i
     int32_t const* bad_words_lens, int32_t max_bad_words_len, int32_t vocab_size_padded,
     int32_t const* sequence_lengths, int32_t max_seq_len, cudaStream_t stream);
 
+template <typename T>
+__global__ void apply_token_bitmask(T* logits, uint32_t const* const* bitmasks, int32_t const* batch_slots,
+    int32_t beam_width, int32_t vocab_size, int32_t vocab_size_padded)
+{
+    int32_t const batch_idx = blockIdx.y / beam_width;
+    int32_t const beam_idx = blockIdx.y % beam_width;
+    auto const batch_slot = batch_slots != nullptr ? batch_slots[batch_idx] : batch_idx;
+    auto const* bitmask = bitmasks[batch_slot];
+    if (bitmask == nullptr)
+    {
+        return;
+    }
+
+    auto* batch_logits = logits + (batch_idx * beam_width + beam_idx) * vocab_size_padded;
+    for (int32_t id = blockIdx.x * blockDim.x + threadIdx.x; id < vocab_size; id += gridDim.x * blockDim.x)
+    {
+        if (((bitmask[id / 32] >> (id % 32)) & 1u) == 0)
+        {
+            batch_logits[id] = static_cast<T>(-INFINITY);
+        }
+    }
+}
+
+template <typename T>
+void invokeApplyTokenBitmask(T* logits, uint32_t const* const* bitmasks, int32_t const* batch_slots,
+    int32_t batch_size, int32_t beam_width, int32_t vocab_size, int32_t vocab_size_padded, cudaStream_t stream)
+{
+    constexpr int32_t block_size{256};
+    constexpr int32_t max_blocks_per_seq{32};
+    dim3 block(block_size);
+    dim3 grid(min((vocab_size + block_size - 1) / block_size, max_blocks_per_seq), batch_size * beam_width);
+
+    apply_token_bitmask<<<grid, block, 0, stream>>>(
+        logits, bitmasks, batch_slots, beam_width, vocab_size, vocab_size_padded);
+    sync_check_cuda_error();
+}
+
+template void invokeApplyTokenBitmask(half* logits, uint32_t const* const* bitmasks, int32_t const* batch_slots,
+    int32_t batch_size, int32_t beam_width, int32_t vocab_size, int32_t vocab_size_padded, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeApplyTokenBitmask(__nv_bfloat16* logits, uint32_t const* const* bitmasks,
+    int32_t const* batch_slots, int32_t batch_size, int32_t beam_width, int32_t vocab_size, int32_t vocab_size_padded,
+    cudaStream_t stream);
+#endif
+template void invokeApplyTokenBitmask(float* logits, uint32_t const* const* bitmasks, int32_t const* batch_slots,
+    int32_t batch_size, int32_t beam_width, int32_t vocab_size, int32_t vocab_size_padded, cudaStream_t stream);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -19,6 +19,8 @@
 #include <cuda_fp16.h>
 #include <cuda_runtime.h>
 
+#include <cstdint>
+
 namespace tensorrt_llm
 {
 namespace kernels
@@ -30,5 +32,12 @@ void invokeBanBadWords(T* logits, int32_t const** output_ids_ptr, int32_t const*
     int32_t const* bad_words_len, int32_t max_bad_words_len, int32_t vocab_size_padded, int32_t const* sequence_lengths,
     int32_t max_seq_len, cudaStream_t stream);
 
+//! \brief Sets the logits of the tokens that are not allowed by the token bitmask of their request to -inf.
+//! \param bitmasks [max_batch_size][ceil(vocab_size / 32)], bit (t % 32) of word (t / 32) is set if token t is
+//! allowed, indexed by batch slot, nullptr for requests without constraint
+template <typename T>
+void invokeApplyTokenBitmask(T* logits, uint32_t const* const* bitmasks, int32_t const* batch_slots,
+    int32_t batch_size, int32_t beam_width, int32_t vocab_size, int32_t vocab_size_padded, cudaStream_t stream);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Returns the token banned by bad word `wordIdx` of a request or -1 if the generated tokens do not match its prefix.
+// The bad words of a request are stored as [tokens..., offsets...], the offsets being the exclusive end of each word
+// and negative for padding.
+__device__ inline int32_t getBannedToken(int32_t const* badWords, int32_t badWordsLen, int32_t wordIdx,
+    int32_t const* outputIds, int32_t const* parentIds, int32_t beamIdx, int32_t beamWidth, int32_t currentStep,
+    int32_t maxSeqLen)
+{
+    int32_t const* badWordsOffsets = badWords + badWordsLen;
+    if (wordIdx >= badWordsLen || badWordsOffsets[wordIdx] < 0)
+    {
+        return -1;
+    }
+
+    auto const itemEnd = badWordsOffsets[wordIdx];
+    auto const itemStart = (wordIdx > 0) ? badWordsOffsets[wordIdx - 1] : 0;
+    auto const itemSize = itemEnd - itemStart;
+
+    // The single-token case unconditionally bans the token
+    bool shouldBan = itemSize == 1;
+    // Multi-token case and enough previously generated tokens to look for a match
+    if (itemSize > 1 && currentStep >= itemSize - 1)
+    {
+        shouldBan = true;
+        int32_t parentId = beamIdx;
+        bool const gatherBeam = beamWidth > 1;
+
+        for (int32_t tokenIdx = itemSize - 2; tokenIdx >= 0; tokenIdx--)
+        {
+            auto const previousToken = outputIds[parentId * maxSeqLen + currentStep - (itemSize - 1) + tokenIdx];
+
+            if (previousToken != badWords[itemStart + tokenIdx])
+            {
+                shouldBan = false;
+                break;
+            }
+            if (gatherBeam)
+            {
+                parentId = parentIds == nullptr
+                    ? 0
+                    : parentIds[parentId * maxSeqLen + currentStep - (itemSize - 1) + tokenIdx];
+
+                if (parentId < 0 || parentId >= beamWidth)
+                {
+                    shouldBan = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return shouldBan ? badWords[itemEnd - 1] : -1;
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/cascadeAttentionKernels.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+// Tokens of K and V staged in shared memory at a time.
+constexpr int32_t kTileTokens = 16;
+// Each warp attends kQueriesPerWarp queries, so one thread block shares every K/V tile among
+// kWarpsPerBlock * kQueriesPerWarp queries.
+constexpr int32_t kWarpsPerBlock = 8;
+constexpr int32_t kQueriesPerWarp = 4;
+constexpr int32_t kQueriesPerBlock = kWarpsPerBlock * kQueriesPerWarp;
+
+//! \brief Attention of up to kQueriesPerBlock queries sharing a KV head over the tokens [tokenBegin, tokenEnd) of
+//! the KV cache of kvSeqIdx.
+//! \details In the prefix pass the queries are those of all sequences of a group, the normalized output and the
+//! log-sum-exp are written to the workspace. In the suffix pass the queries are those of a single sequence, the
+//! result is merged with the prefix pass of the sequence if it has one and written to the output.
+template <typename T, int32_t HEAD_SIZE, bool IS_PREFIX, typename KVCacheBuffer>
+__global__ void __launch_bounds__(kWarpsPerBlock * 32)
+    cascadeAttentionKernel(CascadeAttentionParams params, KVCacheBuffer kvCacheBuffer)
+{
+    constexpr int32_t kEltsPerLane = HEAD_SIZE / 32;
+
+    __shared__ T kTile[kTileTokens][HEAD_SIZE];
+    __shared__ T vTile[kTileTokens][HEAD_SIZE];
+
+    auto const warpIdx = static_cast<int32_t>(threadIdx.x) / 32;
+    auto const laneIdx = static_cast<int32_t>(threadIdx.x) % 32;
+    auto const kvHeadIdx = static_cast<int32_t>(blockIdx.y);
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+
+    int32_t kvSeqIdx;
+    int32_t tokenBegin;
+    int32_t tokenEnd;
+    int32_t const* querySeqIdx;
+    int32_t numQuerySeqs;
+    if (IS_PREFIX)
+    {
+        auto const groupIdx = static_cast<int32_t>(blockIdx.x);
+        kvSeqIdx = params.groupKvSeqIdx[groupIdx];
+        tokenBegin = 0;
+        tokenEnd = params.groupPrefixLens[groupIdx];
+        querySeqIdx = params.groupQuerySeqIdx + params.groupQueryOffsets[groupIdx];
+        numQuerySeqs = params.groupQueryOffsets[groupIdx + 1] - params.groupQueryOffsets[groupIdx];
+    }
+    else
+    {
+        kvSeqIdx = static_cast<int32_t>(blockIdx.x);
+        tokenBegin = params.seqPrefixLens[kvSeqIdx];
+        tokenEnd = params.seqLens[kvSeqIdx];
+        querySeqIdx = nullptr;
+        numQuerySeqs = 1;
+    }
+
+    auto const numQueries = numQuerySeqs * headsPerKv;
+    auto const queryBegin = static_cast<int32_t>(blockIdx.z) * kQueriesPerBlock;
+    if (queryBegin >= numQueries)
+    {
+        return;
+    }
+
+    // Sequence and query head of each query of the warp, a query index of numQueries or more is idle.
+    int32_t seqIdx[kQueriesPerWarp];
+    int32_t qHeadIdx[kQueriesPerWarp];
+    bool isActive[kQueriesPerWarp];
+    float q[kQueriesPerWarp][kEltsPerLane];
+    float acc[kQueriesPerWarp][kEltsPerLane];
+    float rowMax[kQueriesPerWarp];
+    float rowSum[kQueriesPerWarp];
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        auto const queryIdx = queryBegin + qi * kWarpsPerBlock + warpIdx;
+        isActive[qi] = queryIdx < numQueries;
+        auto const memberIdx = isActive[qi] ? queryIdx / headsPerKv : 0;
+        seqIdx[qi] = IS_PREFIX ? querySeqIdx[memberIdx] : kvSeqIdx;
+        qHeadIdx[qi] = kvHeadIdx * headsPerKv + (isActive[qi] ? queryIdx % headsPerKv : 0);
+        auto const* qPtr = reinterpret_cast<T const*>(params.q)
+            + (static_cast<size_t>(seqIdx[qi]) * params.numQHeads + qHeadIdx[qi]) * HEAD_SIZE;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            q[qi][ei] = isActive[qi] ? cuda_cast<float>(qPtr[ei * 32 + laneIdx]) * params.softmaxScale : 0.f;
+            acc[qi][ei] = 0.f;
+        }
+        rowMax[qi] = -INFINITY;
+        rowSum[qi] = 0.f;
+    }
+
+    for (int32_t tileBegin = tokenBegin; tileBegin < tokenEnd; tileBegin += kTileTokens)
+    {
+        auto const tileLen = min(kTileTokens, tokenEnd - tileBegin);
+
+        __syncthreads();
+        // Rows past the end of the range are zeroed so that they contribute nothing to the output.
+        for (int32_t idx = threadIdx.x; idx < kTileTokens * HEAD_SIZE; idx += blockDim.x)
+        {
+            auto const tileTokenIdx = idx / HEAD_SIZE;
+            auto const channelIdx = idx % HEAD_SIZE;
+            T kValue = cuda_cast<T>(0.f);
+            T vValue = cuda_cast<T>(0.f);
+            if (tileTokenIdx < tileLen)
+            {
+                auto const tokenIdx = tileBegin + tileTokenIdx;
+                auto const kLocalIdx
+                    = kvCacheBuffer.template getKLocalIdx<T>(tokenIdx, kvHeadIdx, HEAD_SIZE, channelIdx);
+                auto const vLocalIdx = kvCacheBuffer.getKVLocalIdx(tokenIdx, kvHeadIdx, HEAD_SIZE, channelIdx);
+                kValue = reinterpret_cast<T const*>(kvCacheBuffer.getKBlockPtr(kvSeqIdx, tokenIdx))[kLocalIdx];
+                vValue = reinterpret_cast<T const*>(kvCacheBuffer.getVBlockPtr(kvSeqIdx, tokenIdx))[vLocalIdx];
+            }
+            kTile[tileTokenIdx][channelIdx] = kValue;
+            vTile[tileTokenIdx][channelIdx] = vValue;
+        }
+        __syncthreads();
+
+#pragma unroll
+        for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+        {
+            if (!isActive[qi])
+            {
+                continue;
+            }
+
+            float scores[kTileTokens];
+            float tileMax = -INFINITY;
+#pragma unroll
+            for (int32_t ti = 0; ti < kTileTokens; ++ti)
+            {
+                float score = 0.f;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    score += q[qi][ei] * cuda_cast<float>(kTile[ti][ei * 32 + laneIdx]);
+                }
+#pragma unroll
+                for (int32_t mask = 16; mask > 0; mask >>= 1)
+                {
+                    score += __shfl_xor_sync(0xffffffff, score, mask);
+                }
+                scores[ti] = ti < tileLen ? score : -INFINITY;
+                tileMax = fmaxf(tileMax, scores[ti]);
+            }
+
+            auto const newMax = fmaxf(rowMax[qi], tileMax);
+            auto const rescale = __expf(rowMax[qi] - newMax);
+            rowMax[qi] = newMax;
+            rowSum[qi] *= rescale;
+#pragma unroll
+            for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+            {
+                acc[qi][ei] *= rescale;
+            }
+#pragma unroll
+            for (int32_t ti = 0; ti < kTileTokens; ++ti)
+            {
+                auto const p = ti < tileLen ? __expf(scores[ti] - newMax) : 0.f;
+                rowSum[qi] += p;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    acc[qi][ei] += p * cuda_cast<float>(vTile[ti][ei * 32 + laneIdx]);
+                }
+            }
+        }
+    }
+
+    // The workspace holds the normalized prefix output [numSeqs, numQHeads, headSize] followed by its log-sum-exp
+    // [numSeqs, numQHeads].
+    auto* prefixOut = reinterpret_cast<float*>(params.workspace);
+    auto* prefixLse = prefixOut + static_cast<size_t>(params.numSeqs) * params.numQHeads * HEAD_SIZE;
+
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        if (!isActive[qi])
+        {
+            continue;
+        }
+        auto const rowIdx = static_cast<size_t>(seqIdx[qi]) * params.numQHeads + qHeadIdx[qi];
+        auto const lse = rowMax[qi] + __logf(rowSum[qi]);
+        if (IS_PREFIX)
+        {
+#pragma unroll
+            for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+            {
+                prefixOut[rowIdx * HEAD_SIZE + ei * 32 + laneIdx] = acc[qi][ei] / rowSum[qi];
+            }
+            if (laneIdx == 0)
+            {
+                prefixLse[rowIdx] = lse;
+            }
+        }
+        else
+        {
+            // Merge with the prefix pass using the log-sum-exp of both partial softmaxes.
+            float prefixWeight = 0.f;
+            float suffixWeight = 1.f;
+            if (params.seqPrefixLens[seqIdx[qi]] > 0)
+            {
+                auto const maxLse = fmaxf(prefixLse[rowIdx], lse);
+                prefixWeight = __expf(prefixLse[rowIdx] - maxLse);
+                suffixWeight = __expf(lse - maxLse);
+            }
+            auto const norm = 1.f / (prefixWeight + suffixWeight);
+            auto* outPtr = reinterpret_cast<T*>(params.output) + rowIdx * HEAD_SIZE;
+#pragma unroll
+            for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+            {
+                auto const channelIdx = ei * 32 + laneIdx;
+                auto const prefixValue = prefixWeight > 0.f ? prefixOut[rowIdx * HEAD_SIZE + channelIdx] : 0.f;
+                auto const suffixValue = acc[qi][ei] / rowSum[qi];
+                outPtr[channelIdx] = cuda_cast<T>((prefixWeight * prefixValue + suffixWeight * suffixValue) * norm);
+            }
+        }
+    }
+}
+
+template <typename T, int32_t HEAD_SIZE, typename KVCacheBuffer>
+void launchCascadeAttention(CascadeAttentionParams const& params, KVCacheBuffer const& kvCacheBuffer,
+    cudaStream_t stream)
+{
+    dim3 const block(kWarpsPerBlock * 32);
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+    if (params.numGroups > 0)
+    {
+        dim3 const grid(params.numGroups, params.numKVHeads,
+            divUp(params.maxGroupSize * headsPerKv, kQueriesPerBlock));
+        cascadeAttentionKernel<T, HEAD_SIZE, true><<<grid, block, 0, stream>>>(params, kvCacheBuffer);
+    }
+    dim3 const grid(params.numSeqs, params.numKVHeads, divUp(headsPerKv, kQueriesPerBlock));
+    cascadeAttentionKernel<T, HEAD_SIZE, false><<<grid, block, 0, stream>>>(params, kvCacheBuffer);
+}
+
+} // namespace
+
+CascadeAttentionPlan buildCascadeAttentionPlan(std::vector<std::vector<int32_t>> const& seqBlockIds,
+    std::vector<int32_t> const& seqLens, int32_t tokensPerBlock, int32_t minSharedBlocks, int32_t minGroupSize)
+{
+    TLLM_CHECK(seqBlockIds.size() == seqLens.size());
+    TLLM_CHECK(tokensPerBlock > 0 && minSharedBlocks > 0);
+    auto const numSeqs = static_cast<int32_t>(seqLens.size());
+
+    // Full blocks of each sequence that may be shared, the block of the current token stays in the suffix.
+    std::vector<int32_t> maxPrefixBlocks(numSeqs);
+    for (int32_t seqIdx = 0; seqIdx < numSeqs; ++seqIdx)
+    {
+        maxPrefixBlocks[seqIdx] = std::min(
+            static_cast<int32_t>(seqBlockIds[seqIdx].size()), std::max(seqLens[seqIdx] - 1, 0) / tokensPerBlock);
+    }
+
+    // Candidates share their first block, in order of first appearance.
+    std::unordered_map<int32_t, size_t> firstBlockToCandidate;
+    std::vector<std::vector<int32_t>> candidates;
+    for (int32_t seqIdx = 0; seqIdx < numSeqs; ++seqIdx)
+    {
+        if (maxPrefixBlocks[seqIdx] < minSharedBlocks)
+        {
+            continue;
+        }
+        auto const [it, inserted] = firstBlockToCandidate.try_emplace(seqBlockIds[seqIdx].front(), candidates.size());
+        if (inserted)
+        {
+            candidates.emplace_back();
+        }
+        candidates[it->second].push_back(seqIdx);
+    }
+
+    CascadeAttentionPlan plan;
+    plan.seqPrefixLens.assign(numSeqs, 0);
+    plan.groupQueryOffsets.push_back(0);
+    for (auto const& members : candidates)
+    {
+        if (static_cast<int32_t>(members.size()) < minGroupSize)
+        {
+            continue;
+        }
+        auto const& leadBlocks = seqBlockIds[members.front()];
+        auto sharedBlocks = maxPrefixBlocks[members.front()];
+        for (auto const seqIdx : members)
+        {
+            auto const& blocks = seqBlockIds[seqIdx];
+            auto const limit = std::min(sharedBlocks, maxPrefixBlocks[seqIdx]);
+            sharedBlocks = static_cast<int32_t>(
+                std::mismatch(leadBlocks.begin(), leadBlocks.begin() + limit, blocks.begin()).first
+                - leadBlocks.begin());
+        }
+        if (sharedBlocks < minSharedBlocks)
+        {
+            continue;
+        }
+
+        auto const prefixLen = sharedBlocks * tokensPerBlock;
+        plan.groupKvSeqIdx.push_back(members.front());
+        plan.groupPrefixLens.push_back(prefixLen);
+        plan.groupQuerySeqIdx.insert(plan.groupQuerySeqIdx.end(), members.begin(), members.end());
+        plan.groupQueryOffsets.push_back(static_cast<int32_t>(plan.groupQuerySeqIdx.size()));
+        plan.maxGroupSize = std::max(plan.maxGroupSize, static_cast<int32_t>(members.size()));
+        for (auto const seqIdx : members)
+        {
+            plan.seqPrefixLens[seqIdx] = prefixLen;
+        }
+    }
+    return plan;
+}
+
+size_t getCascadeAttentionWorkspaceSize(int32_t numSeqs, int32_t numQHeads, int32_t headSize)
+{
+    return sizeof(float) * numSeqs * numQHeads * (headSize + 1);
+}
+
+template <typename T, typename KVCacheBuffer>
+void invokeCascadeAttention(CascadeAttentionParams const& params, KVCacheBuffer const& kvCacheBuffer,
+    cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.numQHeads % params.numKVHeads == 0,
+        "The number of query heads must be a multiple of the number of KV heads");
+    switch (params.headSize)
+    {
+    case 32: launchCascadeAttention<T, 32>(params, kvCacheBuffer, stream); break;
+    case 64: launchCascadeAttention<T, 64>(params, kvCacheBuffer, stream); break;
+    case 128: launchCascadeAttention<T, 128>(params, kvCacheBuffer, stream); break;
+    case 256: launchCascadeAttention<T, 256>(params, kvCacheBuffer, stream); break;
+    default: TLLM_THROW("Cascade attention does not support head size %d", params.headSize);
+    }
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_CASCADE_ATTENTION(T)                                                                               \
+    template void invokeCascadeAttention<T, KVLinearBuffer>(                                                           \
+        CascadeAttentionParams const& params, KVLinearBuffer const& kvCacheBuffer, cudaStream_t stream);              \
+    template void invokeCascadeAttention<T, KVBlockArray>(                                                             \
+        CascadeAttentionParams const& params, KVBlockArray const& kvCacheBuffer, cudaStream_t stream)
+
+INSTANTIATE_CASCADE_ATTENTION(float);
+INSTANTIATE_CASCADE_ATTENTION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_CASCADE_ATTENTION(__nv_bfloat16);
+#endif
+
+#undef INSTANTIATE_CASCADE_ATTENTION
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cuda_runtime.h>
+#include <vector>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Two level (cascade) attention for generation steps where many sequences share a prompt prefix through KV cache
+// block reuse. Attention over the shared prefix blocks is computed once per group of sequences, treating all queries
+// of the group as a multi-query batch that reads every prefix K/V tile once. Attention over the per-sequence suffix
+// is computed separately and both partial results are merged with their log-sum-exp.
+
+// Grouping of the sequences of a generation batch by shared prefix.
+struct CascadeAttentionPlan
+{
+    // Sequence whose KV cache holds the prefix of each group, [numGroups]
+    std::vector<int32_t> groupKvSeqIdx;
+    // Length of the shared prefix of each group in tokens, [numGroups]
+    std::vector<int32_t> groupPrefixLens;
+    // Range of groupQuerySeqIdx holding the sequences of each group, [numGroups + 1]
+    std::vector<int32_t> groupQueryOffsets;
+    // Sequences of all groups, [numGroupedSeqs]
+    std::vector<int32_t> groupQuerySeqIdx;
+    // Prefix length covered by the group of each sequence, 0 if the sequence is not in a group, [numSeqs]
+    std::vector<int32_t> seqPrefixLens;
+    // Largest number of sequences in a group
+    int32_t maxGroupSize{0};
+
+    [[nodiscard]] int32_t getNumGroups() const
+    {
+        return static_cast<int32_t>(groupKvSeqIdx.size());
+    }
+};
+
+//! \brief Group sequences that share their leading KV cache blocks.
+//! \param seqBlockIds Block ids of each sequence, as returned by GenerationRequest::getCacheBlockIds for beam 0.
+//! \param seqLens Number of tokens in the KV cache of each sequence, including the token of the current step.
+//! \param minSharedBlocks Minimum number of shared blocks for a group to be worth a prefix pass.
+//! \param minGroupSize Minimum number of sequences in a group.
+//! \details Only full blocks are shared and every sequence keeps at least one suffix token, the one of the current
+//! step, so the suffix pass is never empty.
+CascadeAttentionPlan buildCascadeAttentionPlan(std::vector<std::vector<int32_t>> const& seqBlockIds,
+    std::vector<int32_t> const& seqLens, int32_t tokensPerBlock, int32_t minSharedBlocks = 1,
+    int32_t minGroupSize = 2);
+
+struct CascadeAttentionParams
+{
+    // Queries after bias and RoPE, [numSeqs, numQHeads, headSize]
+    void const* q;
+    // Attention output, [numSeqs, numQHeads, headSize]
+    void* output;
+    // Device copies of the plan, see CascadeAttentionPlan
+    int32_t const* groupKvSeqIdx;
+    int32_t const* groupPrefixLens;
+    int32_t const* groupQueryOffsets;
+    int32_t const* groupQuerySeqIdx;
+    int32_t const* seqPrefixLens;
+    // Number of tokens in the KV cache of each sequence, including the token of the current step, [numSeqs]
+    int32_t const* seqLens;
+    // Workspace of getCascadeAttentionWorkspaceSize bytes
+    void* workspace;
+
+    int32_t numSeqs;
+    int32_t numGroups;
+    int32_t maxGroupSize;
+    int32_t numQHeads;
+    int32_t numKVHeads;
+    int32_t headSize;
+    float softmaxScale;
+};
+
+[[nodiscard]] size_t getCascadeAttentionWorkspaceSize(int32_t numSeqs, int32_t numQHeads, int32_t headSize);
+
+//! \brief Attention of one query token per sequence over its KV cache using the prefix groups of params.
+//! \details Supports head sizes 32, 64, 128 and 256. The KV cache must be stored in T and must not be cyclic, the
+//! shared prefix is read from the cache of the groupKvSeqIdx sequence of each group.
+template <typename T, typename KVCacheBuffer>
+void invokeCascadeAttention(CascadeAttentionParams const& params, KVCacheBuffer const& kvCacheBuffer,
+    cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -66,12 +66,38 @@ static inline void set_alpha(uint32_t& alpha, float norm, Data_type dtype)
         // This is because cublas does not allow current FP32 output.
         alpha = reinterpret_cast<const uint32_t&>(norm);
     }
+    else if (dtype == DATA_TYPE_E4M3)
+    {
+        // FP8 kernels accumulate and scale in FP32.
+        alpha = reinterpret_cast<const uint32_t&>(norm);
+    }
     else
     {
         assert(false);
     }
 }
 
+static inline size_t get_size_in_bytes(Data_type dtype)
+{
+    switch (dtype)
+    {
+    case DATA_TYPE_FP32:
+    case DATA_TYPE_INT32: return 4;
+    case DATA_TYPE_FP16:
+    case DATA_TYPE_BF16: return 2;
+    case DATA_TYPE_INT8:
+    case DATA_TYPE_E4M3:
+    case DATA_TYPE_E5M2: return 1;
+    default: assert(false); return 0;
+    }
+}
+
+// TMA only copies the bits, so the format just needs the element size.
+static inline cudaTmaDescFormat get_tma_format(Data_type dtype)
+{
+    return get_size_in_bytes(dtype) == 1 ? cudaTmaDescFormat::U8 : cudaTmaDescFormat::F16_RN;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class FusedMHARunnerV2::mhaImpl
@@ -86,7 +112,9 @@ public:
     {
         TLLM_CHECK_WITH_INFO(
             (sm == kSM_70 || sm == kSM_80 || sm == kSM_86 || sm == kSM_89 || sm == kSM_90), "Unsupported architecture");
-        TLLM_CHECK_WITH_INFO((mDataType == DATA_TYPE_FP16 || mDataType == DATA_TYPE_BF16), "Unsupported data type");
+        TLLM_CHECK_WITH_INFO((mDataType == DATA_TYPE_FP16 || mDataType == DATA_TYPE_BF16
+                                 || (mDataType == DATA_TYPE_E4M3 && sm == kSM_90)),
+            "Unsupported data type");
 
         pagedKVXmmaKernel = getPagedKVXMMAKernelsV2(mDataType, sm);
         xmmaKernel = getXMMAKernelsV2(mDataType, sm);
@@ -113,9 +141,10 @@ public:
         // Note that we apply scales and bias in the order of
         // (bmm1_output * scale_bmm1 + alibi) * scale_after_alibi
         const float scale_after_alibi = scale_alibi ? inv_sqrt_scale : 1.0f;
-        const float scale_bmm1 = scale_alibi ? 1.0f : inv_sqrt_scale;
+        // With FP8 inputs, Q and K are dequantized in bmm1, V is dequantized and the output quantized in bmm2.
+        const float scale_bmm1 = (scale_alibi ? 1.0f : inv_sqrt_scale) * mQkvScaleQuantOrig * mQkvScaleQuantOrig;
         const float scale_softmax = 1.f; // Seems to be only required for int8
-        const float scale_bmm2 = 1.f;
+        const float scale_bmm2 = mQkvScaleQuantOrig * mAttentionOutScaleOrigQuant;
 
         Data_type scale_type = mLaunchParams.force_fp32_acc ? DATA_TYPE_FP32 : mDataType;
         // Use exp2f optimization for warp-specialized ws kernels on Hopper.
@@ -138,7 +167,7 @@ public:
         params.d = mHeadSize;
         params.sliding_window_size = sliding_window_size;
 
-        params.o_stride_in_bytes = mNumHeads * mHeadSize * sizeof(half);
+        params.o_stride_in_bytes = mNumHeads * mHeadSize * get_size_in_bytes(mDataType);
 
         // Total sequence length needed by TMA descriptor
         // it should be actual total seq length if non-padded input is given.
@@ -234,7 +263,7 @@ public:
 
         // Set kernel parameters.
         setup_params(mParams, b, s, s, sliding_window_size, total_seqlen, has_alibi, scale_alibi, tp_size, tp_rank);
-        mParams.qkv_stride_in_bytes = (mNumHeads + 2 * mParams.h_kv) * mHeadSize * sizeof(half);
+        mParams.qkv_stride_in_bytes = (mNumHeads + 2 * mParams.h_kv) * mHeadSize * get_size_in_bytes(mDataType);
     }
 
     // Support paged_kv_cache and chunked_attention.
@@ -311,8 +340,8 @@ public:
 
         setup_params(
             mPagedKVParams, b, s_q, s_kv, sliding_window_size, total_seqlen, has_alibi, scale_alibi, tp_size, tp_rank);
-        mPagedKVParams.q_stride_in_bytes = mNumHeads * mHeadSize * sizeof(half);
-        mPagedKVParams.kv_stride_in_bytes = tokens_per_kv_block * mHeadSize * sizeof(half);
+        mPagedKVParams.q_stride_in_bytes = mNumHeads * mHeadSize * get_size_in_bytes(mDataType);
+        mPagedKVParams.kv_stride_in_bytes = tokens_per_kv_block * mHeadSize * get_size_in_bytes(mDataType);
     }
 
     // NOTE: assume that heads_interleaved = false (b, s, 3, h, d), and sequences are padded/non-padded
@@ -320,7 +349,7 @@ public:
     void set_tma_descriptors()
     {
         // split D into multiple groups in order to match the TMA swizzle mode (128B)
-        const uint32_t d_in_bytes = mLaunchParams.padded_d * sizeof(uint16_t);
+        const uint32_t d_in_bytes = mLaunchParams.padded_d * get_size_in_bytes(mDataType);
         const uint32_t d_groups = d_in_bytes > 128 ? d_in_bytes / 128 : 1;
 
         // separate q, k, and v tma descriptors
@@ -351,7 +380,7 @@ public:
 
         // stride size in bytes. Assumes least significant dim is 1 (?)
         uint64_t tensor_stride_qkv[3];
-        tensor_stride_qkv[0] = tensor_size_qkv[0] * sizeof(uint16_t);     // d
+        tensor_stride_qkv[0] = tensor_size_qkv[0] * get_size_in_bytes(mDataType);     // d
         tensor_stride_qkv[1] = tensor_size_qkv[1] * tensor_stride_qkv[0]; // d*h
         tensor_stride_qkv[2] = tensor_size_qkv[2] * tensor_stride_qkv[1]; // d*h*3
 
@@ -365,7 +394,7 @@ public:
         uint32_t fp32_to_tf32 = 0;
 
         // gmma descriptor mode
-        const uint32_t d_bytes_per_group = (mLaunchParams.padded_d * sizeof(uint16_t)) / d_groups;
+        const uint32_t d_bytes_per_group = (mLaunchParams.padded_d * get_size_in_bytes(mDataType)) / d_groups;
         const cudaTmaDescSwizzle swizzle_mode = (d_bytes_per_group > 64
                 ? cudaTmaDescSwizzle::SWIZZLE_128B
                 : (d_bytes_per_group > 32 ? cudaTmaDescSwizzle::SWIZZLE_64B : cudaTmaDescSwizzle::SWIZZLE_32B));
@@ -388,18 +417,18 @@ public:
 
         // Q: STEP_Q
         box_size[3] = q_step;
-        qkv_tma_descriptor.set_tma_desctriptor(qkv_ptr, cudaTmaDescFormat::F16_RN,
+        qkv_tma_descriptor.set_tma_desctriptor(qkv_ptr, get_tma_format(mDataType),
             cudaTmaDescInterleave::INTERLEAVE_DISABLED, swizzle_mode, cudaTmaDescPromotion::PROMOTION_DISABLED,
             tensor_size_qkv, tensor_stride_qkv, traversal_stride_qkv, box_size, oob_fill, fp32_to_tf32,
             &mParams.tma_desc_q);
 
         // K/V: STEP_KV
         box_size[3] = kv_step;
-        qkv_tma_descriptor.set_tma_desctriptor(qkv_ptr, cudaTmaDescFormat::F16_RN,
+        qkv_tma_descriptor.set_tma_desctriptor(qkv_ptr, get_tma_format(mDataType),
             cudaTmaDescInterleave::INTERLEAVE_DISABLED, swizzle_mode, cudaTmaDescPromotion::PROMOTION_DISABLED,
             tensor_size_qkv, tensor_stride_qkv, traversal_stride_qkv, box_size, oob_fill, fp32_to_tf32,
             &mParams.tma_desc_k);
-        qkv_tma_descriptor.set_tma_desctriptor(qkv_ptr, cudaTmaDescFormat::F16_RN,
+        qkv_tma_descriptor.set_tma_desctriptor(qkv_ptr, get_tma_format(mDataType),
             cudaTmaDescInterleave::INTERLEAVE_DISABLED, swizzle_mode, cudaTmaDescPromotion::PROMOTION_DISABLED,
             tensor_size_qkv, tensor_stride_qkv, traversal_stride_qkv, box_size, oob_fill, fp32_to_tf32,
             &mParams.tma_desc_v);
@@ -412,7 +441,7 @@ public:
     void set_paged_kv_tma_descriptors(cudaStream_t stream)
     {
         // split D into multiple groups in order to match the TMA swizzle mode (128B)
-        const uint32_t d_in_bytes = mLaunchParams.padded_d * sizeof(uint16_t);
+        const uint32_t d_in_bytes = mLaunchParams.padded_d * get_size_in_bytes(mDataType);
         const uint32_t d_groups = d_in_bytes > 128 ? d_in_bytes / 128 : 1;
 
         uint32_t q_step = 0, kv_step = 0;
@@ -447,7 +476,7 @@ public:
 
         // stride size in bytes.
         uint64_t tensor_stride_q[3];
-        tensor_stride_q[0] = tensor_size_q[0] * sizeof(uint16_t);
+        tensor_stride_q[0] = tensor_size_q[0] * get_size_in_bytes(mDataType);
         tensor_stride_q[1] = tensor_size_q[1] * tensor_stride_q[0];
         tensor_stride_q[2] = tensor_size_q[2] * tensor_stride_q[1];
 
@@ -461,7 +490,7 @@ public:
         uint32_t fp32_to_tf32 = 0;
 
         // gmma descriptor mode
-        const uint32_t d_bytes_per_group = (mLaunchParams.padded_d * sizeof(uint16_t)) / d_groups;
+        const uint32_t d_bytes_per_group = (mLaunchParams.padded_d * get_size_in_bytes(mDataType)) / d_groups;
         const cudaTmaDescSwizzle swizzle_mode = (d_bytes_per_group > 64
                 ? cudaTmaDescSwizzle::SWIZZLE_128B
                 : (d_bytes_per_group > 32 ? cudaTmaDescSwizzle::SWIZZLE_64B : cudaTmaDescSwizzle::SWIZZLE_32B));
@@ -470,7 +499,7 @@ public:
         const char* q_ptr = reinterpret_cast<const char*>(mPagedKVParams.q_ptr);
 
         // Q: STEP_Q.
-        q_tma_descriptor.set_tma_desctriptor(q_ptr, cudaTmaDescFormat::F16_RN,
+        q_tma_descriptor.set_tma_desctriptor(q_ptr, get_tma_format(mDataType),
             cudaTmaDescInterleave::INTERLEAVE_DISABLED, swizzle_mode, cudaTmaDescPromotion::PROMOTION_DISABLED,
             tensor_size_q, tensor_stride_q, traversal_stride, box_size_q, oob_fill, fp32_to_tf32,
             &mPagedKVParams.tma_desc_q);
@@ -498,7 +527,7 @@ public:
 
         // Stride size in bytes.
         uint64_t tensor_stride_kv[3];
-        tensor_stride_kv[0] = tensor_size_kv[0] * sizeof(uint16_t);
+        tensor_stride_kv[0] = tensor_size_kv[0] * get_size_in_bytes(mDataType);
         tensor_stride_kv[1] = tensor_size_kv[1] * tensor_stride_kv[0];
         tensor_stride_kv[2] = tensor_size_kv[2] * tensor_stride_kv[1];
 
@@ -510,7 +539,7 @@ public:
              block_idx++)
         {
             paged_kv_tma_descriptor.set_tma_desctriptor(
-                reinterpret_cast<char*>(mLaunchParams.paged_kv_block_ptrs[block_idx]), cudaTmaDescFormat::F16_RN,
+                reinterpret_cast<char*>(mLaunchParams.paged_kv_block_ptrs[block_idx]), get_tma_format(mDataType),
                 cudaTmaDescInterleave::INTERLEAVE_DISABLED, swizzle_mode, cudaTmaDescPromotion::PROMOTION_DISABLED,
                 tensor_size_kv, tensor_stride_kv, traversal_stride, box_size_kv, oob_fill, fp32_to_tf32, block_idx);
         }
@@ -520,8 +549,8 @@ public:
 
     void setup_flags(const bool force_fp32_acc, const bool is_s_padded, const bool causal_mask, const int num_kv_heads)
     {
-        // BF16 FMHA only accumulates on FP32
-        mLaunchParams.force_fp32_acc = mDataType == DATA_TYPE_BF16 || force_fp32_acc;
+        // BF16 and FP8 FMHA only accumulate on FP32
+        mLaunchParams.force_fp32_acc = mDataType == DATA_TYPE_BF16 || mDataType == DATA_TYPE_E4M3 || force_fp32_acc;
         mLaunchParams.attention_mask_type
             = causal_mask ? ContextAttentionMaskType::CAUSAL : ContextAttentionMaskType::PADDING;
 
@@ -536,6 +565,13 @@ public:
         mParams.is_s_padded = is_s_padded;
     }
 
+    void setup_fp8_scales(const float qkv_scale_quant_orig, const float attention_out_scale_orig_quant)
+    {
+        TLLM_CHECK_WITH_INFO(mDataType == DATA_TYPE_E4M3, "Only FP8 FMHA takes quantization scales");
+        mQkvScaleQuantOrig = qkv_scale_quant_orig;
+        mAttentionOutScaleOrigQuant = attention_out_scale_orig_quant;
+    }
+
     bool fmha_supported()
     {
         return MHARunner::fmha_supported(mHeadSize, sm);
@@ -562,7 +598,7 @@ public:
     {
         KVBlockArrayForContextFMHA pagedKVCacheForContextMHA;
         pagedKVCacheForContextMHA = KVBlockArrayForContextFMHA(pagedKVCache.mMaxSeqs, pagedKVCache.mMaxBlocksPerSeq,
-            pagedKVCache.mTokensPerBlock, mPagedKVParams.h_kv * mPagedKVParams.d * sizeof(half));
+            pagedKVCache.mTokensPerBlock, mPagedKVParams.h_kv * mPagedKVParams.d * get_size_in_bytes(mDataType));
         pagedKVCacheForContextMHA.data = pagedKVCache.data;
         mPagedKVParams.q_ptr = qPtr;
         mPagedKVParams.tma_desc_paged_kv = reinterpret_cast<cudaTmaDesc*>(pagedKVTmaDesc);
@@ -633,6 +669,9 @@ private:
     const int mHeadSize;
     const float mQScaling;
     int mTotalSeqLen;
+    // Per-tensor FP8 scales, fused into the bmm scales.
+    float mQkvScaleQuantOrig = 1.f;
+    float mAttentionOutScaleOrigQuant = 1.f;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -659,6 +698,11 @@ void FusedMHARunnerV2::setup_paged_kv(const int b, const int s_q, const int s_kv
         total_seqlen, has_alibi, scale_alibi, tp_size, tp_rank);
 }
 
+void FusedMHARunnerV2::setup_fp8_scales(const float qkv_scale_quant_orig, const float attention_out_scale_orig_quant)
+{
+    pimpl->setup_fp8_scales(qkv_scale_quant_orig, attention_out_scale_orig_quant);
+}
+
 bool FusedMHARunnerV2::fmha_supported()
 {
     return pimpl->fmha_supported();
@@ -60,6 +60,10 @@ public:
 
     virtual bool fmha_supported() = 0;
 
+    // Scales of the FP8 (E4M3) runner: the dequantization scale of Q, K and V and the quantization scale of the
+    // output. They are fused into the scales of the two BMMs, so the FP8 data needs no separate conversion pass.
+    virtual void setup_fp8_scales(const float qkv_scale_quant_orig, const float attention_out_scale_orig_quant) = 0;
+
     virtual void setup_flags(const bool force_fp32_acc, const bool is_s_padded, const bool causal_mask,
         const int num_kv_heads /* MQA or GQA */)
         = 0;
@@ -101,6 +105,8 @@ public:
 
     bool fmha_supported() override;
 
+    void setup_fp8_scales(const float qkv_scale_quant_orig, const float attention_out_scale_orig_quant) override;
+
     void run(const void* input, const void* cu_seqlens, void* output, cudaStream_t stream) override;
     void run_paged_kv(const void* q_input, void* paged_kv_tma_desc, const void* paged_kv_block_ptrs_on_host,
         const KVBlockArray paged_kv_cache, const void* cu_q_seqlens, const void* cu_kv_seqlens, void* output,
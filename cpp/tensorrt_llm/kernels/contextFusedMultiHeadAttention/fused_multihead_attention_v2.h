@@ -21,7 +21,9 @@
 #include "pagedKVCubin/fmha_cubin.h"
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaDriverWrapper.h"
+#include "tensorrt_llm/kernels/cubinModuleCache.h"
 #include "tmaDescriptor.h"
+#include <algorithm>
 #include <assert.h>
 #include <memory>
 #include <mutex>
@@ -40,6 +42,51 @@ namespace kernels
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+inline size_t getFmhaElementSize(Data_type dtype)
+{
+    switch (dtype)
+    {
+    case DATA_TYPE_FP32:
+    case DATA_TYPE_INT32: return 4;
+    case DATA_TYPE_FP16:
+    case DATA_TYPE_BF16: return 2;
+    case DATA_TYPE_INT8:
+    case DATA_TYPE_E4M3:
+    case DATA_TYPE_E5M2: return 1;
+    default: TLLM_CHECK_WITH_INFO(false, "FMHA Data Type is not supported."); return 0;
+    }
+}
+
+// Grid of the warp-specialized flash attention kernels on Hopper, (blocks per head, heads in flight).
+// The blocks of a head split its q steps, NUM_COMPUTE_GROUPS steps at a time. When the K/V read by the heads in flight
+// fit into half of the L2 (uGPU), one wave of blocks loops over the q steps, and every K/V tile is served from L2 after
+// its first read. Long sequences do not fit, then every block takes NUM_COMPUTE_GROUPS steps and the blocks of a head,
+// which run next to each other, read the same K/V tiles at about the same time.
+inline dim3 getWarpSpecializedGridSize(const Launch_params& launch_params, int num_heads_total, int s_q, int s_kv,
+    int d, size_t element_size, unsigned int unroll_step)
+{
+    dim3 block_size(1, std::min(num_heads_total, launch_params.multi_processor_count));
+    const size_t sms_per_head = launch_params.multi_processor_count / block_size.y;
+    size_t m_steps = size_t((s_q + unroll_step - 1) / unroll_step);
+    m_steps = size_t((m_steps + NUM_COMPUTE_GROUPS - 1) / NUM_COMPUTE_GROUPS) * NUM_COMPUTE_GROUPS;
+
+    // K and V of the heads in flight
+    const size_t size_in_bytes = size_t(block_size.y) * s_kv * d * 2 * element_size;
+    if (size_in_bytes <= size_t(launch_params.device_l2_cache_size) / 2)
+    {
+        // strategy 1: limit to only 1 wave
+        block_size.x = std::min(m_steps / NUM_COMPUTE_GROUPS, sms_per_head);
+    }
+    else
+    {
+        // strategy 2: fully unroll the q loops (contiguous blocks handle all q loops)
+        block_size.x = m_steps / NUM_COMPUTE_GROUPS;
+    }
+    return block_size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // meta info for tma warp-specialized kernels
 static const struct TmaKernelMetaInfo
 {
@@ -77,6 +124,8 @@ public:
     {
     }
 
+    // Indexes the kernels of the SM and data type. Their cubins are only loaded on their first launch, see
+    // getDeviceFunction.
     void loadXMMAKernels()
     {
         if (!mFunctions.empty())
@@ -89,27 +138,9 @@ public:
             const auto& kernelMeta = mKernelMeta[i];
             if (kernelMeta.mSM == mSM && kernelMeta.mDataType == mDataType)
             {
-                CUmodule hmod{0};
-                auto findModuleIter = mModules.find(kernelMeta.mCubin);
-                if (findModuleIter != mModules.end())
-                {
-                    hmod = findModuleIter->second;
-                }
-                else
-                {
-                    cuErrCheck(mDriver.cuModuleLoadData(&hmod, kernelMeta.mCubin), mDriver);
-                    mModules.insert(std::make_pair(kernelMeta.mCubin, hmod));
-                }
-
                 FusedMultiHeadAttentionKernelInfo funcInfo;
                 funcInfo.mMetaInfoIndex = i;
-                cuErrCheck(mDriver.cuModuleGetFunction(&funcInfo.mDeviceFunction, hmod, kernelMeta.mFuncName), mDriver);
-                if (kernelMeta.mSharedMemBytes >= 48 * 1024)
-                {
-                    cuErrCheck(mDriver.cuFuncSetAttribute(funcInfo.mDeviceFunction,
-                                   CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, kernelMeta.mSharedMemBytes),
-                        mDriver);
-                }
+                funcInfo.mDeviceFunction = nullptr;
                 mFunctions.insert(std::make_pair(hashID(kernelMeta), funcInfo));
                 int s = static_cast<int>(kernelMeta.mS);
                 if (mValidSequences.find(s) == mValidSequences.end())
@@ -128,7 +159,7 @@ public:
         const auto findIter = mFunctions.find(hashID(params.s, params.d));
 
         const auto& kernelMeta = mKernelMeta[findIter->second.mMetaInfoIndex];
-        const CUfunction func = findIter->second.mDeviceFunction;
+        const CUfunction func = getDeviceFunction(findIter->second);
 
         void* kernelParams[] = {&params, nullptr};
         cuErrCheck(mDriver.cuLaunchKernel(func, params.h, params.b, 1, kernelMeta.mThreadsPerCTA, 1, 1,
@@ -139,19 +170,43 @@ public:
     virtual ~TFusedMultiHeadAttentionXMMAKernel() = default;
 
 protected:
+    struct FusedMultiHeadAttentionKernelInfo
+    {
+        unsigned int mMetaInfoIndex;
+        // Set on the first launch
+        mutable CUfunction mDeviceFunction;
+    };
+
+    // Loads the cubin of the kernel, shared with the other lists of the process, on its first launch.
+    CUfunction getDeviceFunction(const FusedMultiHeadAttentionKernelInfo& funcInfo) const
+    {
+        std::lock_guard<std::mutex> lock(mLoadMutex);
+        if (funcInfo.mDeviceFunction == nullptr)
+        {
+            const auto& kernelMeta = mKernelMeta[funcInfo.mMetaInfoIndex];
+            ScopedRelaxedCaptureMode relaxedCaptureMode;
+            const CUmodule hmod = CubinModuleCache::getInstance().getModule(mDriver, kernelMeta.mCubin);
+            CUfunction func{nullptr};
+            cuErrCheck(mDriver.cuModuleGetFunction(&func, hmod, kernelMeta.mFuncName), mDriver);
+            if (kernelMeta.mSharedMemBytes >= 48 * 1024)
+            {
+                cuErrCheck(mDriver.cuFuncSetAttribute(
+                               func, CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, kernelMeta.mSharedMemBytes),
+                    mDriver);
+            }
+            funcInfo.mDeviceFunction = func;
+        }
+        return funcInfo.mDeviceFunction;
+    }
+
     tensorrt_llm::common::CUDADriverWrapper mDriver;
 
     Data_type mDataType;
     const TKernelMeta* mKernelMeta;
     unsigned int mKernelMetaCount;
     unsigned int mSM;
-    std::unordered_map<const unsigned char*, CUmodule> mModules;
-
-    struct FusedMultiHeadAttentionKernelInfo
-    {
-        unsigned int mMetaInfoIndex;
-        CUfunction mDeviceFunction;
-    };
+    // Guards the lazy loading of the kernels
+    mutable std::mutex mLoadMutex;
 
     std::unordered_map<uint64_t, FusedMultiHeadAttentionKernelInfo> mFunctions;
     std::set<int> mValidSequences;
@@ -291,7 +346,7 @@ public:
             static_cast<int>(launch_params.attention_mask_type), launch_params.granular_tiling);
 
         const auto& kernelMeta = mKernelMeta[findIter->second.mMetaInfoIndex];
-        const CUfunction func = findIter->second.mDeviceFunction;
+        const CUfunction func = getDeviceFunction(findIter->second);
 
         void* kernelParams[] = {&params, nullptr};
 
@@ -303,29 +358,8 @@ public:
         } // forceunroll = true for flash attention kernels
         else if (mSM == kSM_90 && launch_params.flash_attention && launch_params.warp_specialization)
         {
-            // tricks for launching warp-specialized flash attention kernels on Hopper
-            dim3 block_size(1, std::min(params.b * params.h, launch_params.multi_processor_count));
-
-            // distribute m steps to multiple blocks (fully utilize SMs)
-            // block.x = blocks that handle single head, block.y = blocks that handle different heads
-            size_t sms_per_head = (launch_params.multi_processor_count) / block_size.y;
-            size_t m_steps = size_t((params.s + kernelMeta.mUnrollStep - 1) / kernelMeta.mUnrollStep);
-            m_steps = size_t((m_steps + NUM_COMPUTE_GROUPS - 1) / NUM_COMPUTE_GROUPS) * NUM_COMPUTE_GROUPS;
-
-            // 2 * 2 stands for kv cache and 2 bytes per element.
-            size_t size_in_bytes = block_size.y * params.s * params.d * 2 * 2;
-            // Take uGPU into consideration.
-            if (size_in_bytes <= launch_params.device_l2_cache_size / 2)
-            {
-                // strategy 1: limit to only 1 wave
-                block_size.x = std::min(m_steps / NUM_COMPUTE_GROUPS, sms_per_head);
-            }
-            else
-            {
-                // strategy 2: fully unroll the q loops (contiguous blocks handle all q loops)
-                block_size.x = m_steps / NUM_COMPUTE_GROUPS;
-            }
-
+            const dim3 block_size = getWarpSpecializedGridSize(launch_params, params.b * params.h, params.s, params.s,
+                params.d, getFmhaElementSize(mDataType), kernelMeta.mUnrollStep);
             cuErrCheck(mDriver.cuLaunchKernel(func, block_size.x, block_size.y, block_size.z, kernelMeta.mThreadsPerCTA,
                            1, 1, kernelMeta.mSharedMemBytes, stream, kernelParams, nullptr),
                 mDriver);
@@ -427,35 +461,14 @@ public:
             launch_params.granular_tiling);
 
         const auto& kernelMeta = mKernelMeta[findIter->second.mMetaInfoIndex];
-        const CUfunction func = findIter->second.mDeviceFunction;
+        const CUfunction func = getDeviceFunction(findIter->second);
 
         void* kernelParams[] = {&params, nullptr};
 
         if (mSM == kSM_90 && launch_params.flash_attention && launch_params.warp_specialization)
         {
-            // tricks for launching warp-specialized flash attention kernels on Hopper
-            dim3 block_size(1, std::min(params.b * params.h, launch_params.multi_processor_count));
-
-            // distribute m steps to multiple blocks (fully utilize SMs)
-            // block.x = blocks that handle single head, block.y = blocks that handle different heads
-            size_t sms_per_head = (launch_params.multi_processor_count) / block_size.y;
-            size_t m_steps = size_t((params.s + kernelMeta.mUnrollStep - 1) / kernelMeta.mUnrollStep);
-            m_steps = size_t((m_steps + NUM_COMPUTE_GROUPS - 1) / NUM_COMPUTE_GROUPS) * NUM_COMPUTE_GROUPS;
-
-            // 2 * 2 stands for kv cache and 2 bytes per element.
-            size_t size_in_bytes = block_size.y * launch_params.kernel_kv_s * params.d * 2 * 2;
-            // Take uGPU into consideration.
-            if (size_in_bytes <= launch_params.device_l2_cache_size / 2)
-            {
-                // strategy 1: limit to only 1 wave
-                block_size.x = std::min(m_steps / NUM_COMPUTE_GROUPS, sms_per_head);
-            }
-            else
-            {
-                // strategy 2: fully unroll the q loops (contiguous blocks handle all q loops)
-                block_size.x = m_steps / NUM_COMPUTE_GROUPS;
-            }
-
+            const dim3 block_size = getWarpSpecializedGridSize(launch_params, params.b * params.h, params.s,
+                launch_params.kernel_kv_s, params.d, getFmhaElementSize(mDataType), kernelMeta.mUnrollStep);
             cuErrCheck(mDriver.cuLaunchKernel(func, block_size.x, block_size.y, block_size.z, kernelMeta.mThreadsPerCTA,
                            1, 1, kernelMeta.mSharedMemBytes, stream, kernelParams, nullptr),
                 mDriver);
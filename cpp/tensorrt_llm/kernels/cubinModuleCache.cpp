@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/cubinModuleCache.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+CubinModuleCache& CubinModuleCache::getInstance()
+{
+    static CubinModuleCache instance;
+    return instance;
+}
+
+CUmodule CubinModuleCache::getModule(const tensorrt_llm::common::CUDADriverWrapper& driver, const void* cubin)
+{
+    const auto key = std::make_pair(tensorrt_llm::common::getDevice(), cubin);
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto findIter = mModules.find(key);
+    if (findIter != mModules.end())
+    {
+        return findIter->second;
+    }
+    CUmodule hmod{0};
+    cuErrCheck(driver.cuModuleLoadData(&hmod, cubin), driver);
+    mModules.emplace(key, hmod);
+    return hmod;
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
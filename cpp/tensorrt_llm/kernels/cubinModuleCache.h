@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/cudaDriverWrapper.h"
+
+#include <cuda.h>
+#include <cuda_runtime_api.h>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Modules of the cubins embedded in the library, loaded on the first launch of one of their kernels and shared by all
+// the kernel lists of the process. The modules live as long as the CUDA context of their device, they are not
+// unloaded.
+class CubinModuleCache
+{
+public:
+    static CubinModuleCache& getInstance();
+
+    // Module of cubin on the current device.
+    CUmodule getModule(const tensorrt_llm::common::CUDADriverWrapper& driver, const void* cubin);
+
+private:
+    CubinModuleCache() = default;
+
+    std::mutex mMutex;
+    std::map<std::pair<int, const void*>, CUmodule> mModules;
+};
+
+// Loading a kernel is not a stream operation, so a first launch captured in a CUDA graph may load it. The calling
+// thread is switched to the relaxed capture mode meanwhile, the global mode forbids the loading APIs.
+class ScopedRelaxedCaptureMode
+{
+public:
+    ScopedRelaxedCaptureMode()
+    {
+        cudaThreadExchangeStreamCaptureMode(&mMode);
+    }
+
+    ~ScopedRelaxedCaptureMode()
+    {
+        cudaThreadExchangeStreamCaptureMode(&mMode);
+    }
+
+    ScopedRelaxedCaptureMode(const ScopedRelaxedCaptureMode&) = delete;
+    ScopedRelaxedCaptureMode& operator=(const ScopedRelaxedCaptureMode&) = delete;
+
+private:
+    cudaStreamCaptureMode mMode{cudaStreamCaptureModeRelaxed};
+};
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -17,11 +17,13 @@
 #include "customAllReduceKernels.h"
 #include "tensorrt_llm/common/cudaBf16Fallbacks.cuh"
 #include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include <tuple>
 
 namespace tensorrt_llm::kernels
 {
 
+using tensorrt_llm::common::cuda_cast;
 using tensorrt_llm::common::datatype_enum;
 using tensorrt_llm::common::divUp;
 
@@ -130,6 +132,33 @@ __inline__ __device__ void multi_gpu_barrier(
     __syncthreads();
 }
 
+// Barrier epoch of the device, for the launches with AllReduceParams::device_barrier_flag. The last block of every such
+// launch advances it. All the ranks launch the same all-reduces in the same order, so their epochs stay equal.
+static __device__ uint32_t g_barrier_epoch;
+static __device__ uint32_t g_barrier_arrivals;
+
+// Must be read by every thread before the first barrier of the kernel, whose __syncthreads orders it before the
+// arrival of the block.
+static inline __device__ uint32_t load_barrier_flag(const AllReduceParams& params)
+{
+    // The high bit keeps the epochs apart from the small host flags left in the same barriers by other kernels.
+    return params.device_barrier_flag ? (*reinterpret_cast<volatile uint32_t*>(&g_barrier_epoch) + 1) | 0x80000000u
+                                      : params.barrier_flag;
+}
+
+static inline __device__ void advance_barrier_epoch(const AllReduceParams& params)
+{
+    if (params.device_barrier_flag && threadIdx.x == 0)
+    {
+        // Every block arrives after reading the epoch, so the last one can advance it for the next launch.
+        if (atomicAdd(&g_barrier_arrivals, 1u) == gridDim.x - 1)
+        {
+            g_barrier_arrivals = 0;
+            g_barrier_epoch += 1;
+        }
+    }
+}
+
 __global__ void multiGpuBarrierKernel(AllReduceParams params)
 {
     multi_gpu_barrier(params.peer_barrier_ptrs_out, params.barrier_flag, params.local_rank, params.ranks_per_node,
@@ -148,7 +177,8 @@ static __global__ void oneShotAllReduceKernel(AllReduceParams params)
     // Packed data type for comms
     using PackedStruct = typename PackedOn16Bytes<T>::Type;
 
-    multi_gpu_barrier(params.peer_barrier_ptrs_in, params.barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx);
+    const uint32_t barrier_flag = load_barrier_flag(params);
+    multi_gpu_barrier(params.peer_barrier_ptrs_in, barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx);
 
     // The source pointers. Distributed round-robin for the different warps.
     const T* src_d[RANKS_PER_NODE];
@@ -187,6 +217,8 @@ static __global__ void oneShotAllReduceKernel(AllReduceParams params)
         // Store to the destination buffer.
         *reinterpret_cast<int4*>(&reinterpret_cast<T*>(params.local_output_buffer_ptr)[iter_offset]) = sums.packed;
     }
+
+    advance_barrier_epoch(params);
 }
 
 template <typename T, int RANKS_PER_NODE>
@@ -210,7 +242,8 @@ static __global__ void twoShotAllReduceKernel(AllReduceParams params)
     // The end of the segment computed by that block.
     size_t max_offset = min(block_start + params.elts_per_block, params.rank_offset + params.elts_per_rank);
 
-    multi_gpu_barrier(params.peer_barrier_ptrs_in, params.barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx);
+    const uint32_t barrier_flag = load_barrier_flag(params);
+    multi_gpu_barrier(params.peer_barrier_ptrs_in, barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx);
 
     // The source pointers. Distributed round-robin for the different warps.
     T* src_d[RANKS_PER_NODE];
@@ -257,7 +290,7 @@ static __global__ void twoShotAllReduceKernel(AllReduceParams params)
     {
         // The all blocks notifies the other ranks.
         uint32_t flag_block_offset = RANKS_PER_NODE + bidx * RANKS_PER_NODE;
-        st_flag_release(params.barrier_flag, params.peer_barrier_ptrs_in[tidx] + flag_block_offset + params.local_rank);
+        st_flag_release(barrier_flag, params.peer_barrier_ptrs_in[tidx] + flag_block_offset + params.local_rank);
 
         // Busy-wait until all ranks are ready.
         uint32_t rank_barrier = 0;
@@ -265,7 +298,7 @@ static __global__ void twoShotAllReduceKernel(AllReduceParams params)
         do
         {
             ld_flag_acquire(rank_barrier, peer_barrier_d);
-        } while (rank_barrier != params.barrier_flag);
+        } while (rank_barrier != barrier_flag);
     }
 
     // sync threads to make sure all other ranks has the final partial results
@@ -288,6 +321,508 @@ static __global__ void twoShotAllReduceKernel(AllReduceParams params)
                 = *reinterpret_cast<int4*>(&src_d[ii][offset_rank]);
         }
     }
+
+    advance_barrier_epoch(params);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sum of the 16 bytes at the multicast address over the buffers of all the ranks, and store of a value to all of them.
+// Half precision values are accumulated in fp32 by the switch.
+template <typename T>
+struct Multimem;
+
+template <>
+struct Multimem<float>
+{
+    static __device__ int4 ldReduce(const void* mc_ptr)
+    {
+        int4 sum;
+#if __CUDA_ARCH__ >= 900
+        asm volatile("multimem.ld_reduce.relaxed.sys.global.add.v4.f32 {%0, %1, %2, %3}, [%4];"
+                     : "=r"(sum.x), "=r"(sum.y), "=r"(sum.z), "=r"(sum.w)
+                     : "l"(mc_ptr)
+                     : "memory");
+#endif
+        return sum;
+    }
+};
+
+template <>
+struct Multimem<half>
+{
+    static __device__ int4 ldReduce(const void* mc_ptr)
+    {
+        int4 sum;
+#if __CUDA_ARCH__ >= 900
+        asm volatile("multimem.ld_reduce.relaxed.sys.global.add.acc::f32.v4.f16x2 {%0, %1, %2, %3}, [%4];"
+                     : "=r"(sum.x), "=r"(sum.y), "=r"(sum.z), "=r"(sum.w)
+                     : "l"(mc_ptr)
+                     : "memory");
+#endif
+        return sum;
+    }
+};
+
+#ifdef ENABLE_BF16
+template <>
+struct Multimem<__nv_bfloat16>
+{
+    static __device__ int4 ldReduce(const void* mc_ptr)
+    {
+        int4 sum;
+#if __CUDA_ARCH__ >= 900
+        asm volatile("multimem.ld_reduce.relaxed.sys.global.add.acc::f32.v4.bf16x2 {%0, %1, %2, %3}, [%4];"
+                     : "=r"(sum.x), "=r"(sum.y), "=r"(sum.z), "=r"(sum.w)
+                     : "l"(mc_ptr)
+                     : "memory");
+#endif
+        return sum;
+    }
+};
+#endif
+
+static inline __device__ void multimem_st(void* mc_ptr, const int4& val)
+{
+#if __CUDA_ARCH__ >= 900
+    asm volatile("multimem.st.relaxed.sys.global.v4.f32 [%0], {%1, %2, %3, %4};" ::"l"(mc_ptr), "r"(val.x), "r"(val.y),
+                 "r"(val.z), "r"(val.w)
+                 : "memory");
+#endif
+}
+
+// Orders the multimem accesses with the unicast accesses to the same memory.
+static inline __device__ void fence_proxy_alias()
+{
+#if __CUDA_ARCH__ >= 900
+    asm volatile("fence.proxy.alias;" ::: "memory");
+#endif
+}
+
+// The two-shot kernel with the reduce-scatter and the all-gather of a slice done by the switch. The slices and the
+// barriers between the blocks of the same index are those of the two-shot kernel.
+template <typename T>
+static __global__ void nvlsAllReduceKernel(AllReduceParams params)
+{
+#if __CUDA_ARCH__ >= 900
+    const int bidx = blockIdx.x;
+    const int tidx = threadIdx.x;
+    static constexpr int NUM_ELTS = 16 / sizeof(T);
+
+    const size_t block_offset = bidx * params.elts_per_block + tidx * NUM_ELTS;
+    const size_t block_start = params.rank_offset + block_offset;
+    const size_t max_offset = min(block_start + params.elts_per_block, params.rank_offset + params.elts_per_rank);
+
+    // The inputs of all the ranks are in their buffers
+    const uint32_t barrier_flag = load_barrier_flag(params);
+    multi_gpu_barrier(params.peer_barrier_ptrs_in, barrier_flag, params.local_rank, params.ranks_per_node, tidx, bidx);
+    fence_proxy_alias();
+
+    T* mc_ptr = reinterpret_cast<T*>(params.multicast_ptr);
+    for (size_t local_offset = block_start; local_offset < max_offset; local_offset += blockDim.x * NUM_ELTS)
+    {
+        multimem_st(&mc_ptr[local_offset], Multimem<T>::ldReduce(&mc_ptr[local_offset]));
+    }
+
+    fence_proxy_alias();
+    __syncthreads();
+
+    if (tidx < params.ranks_per_node)
+    {
+        const uint32_t flag_block_offset = params.ranks_per_node + bidx * params.ranks_per_node;
+        st_flag_release(barrier_flag, params.peer_barrier_ptrs_in[tidx] + flag_block_offset + params.local_rank);
+
+        uint32_t rank_barrier = 0;
+        uint32_t* peer_barrier_d = params.peer_barrier_ptrs_in[params.local_rank] + flag_block_offset + tidx;
+        do
+        {
+            ld_flag_acquire(rank_barrier, peer_barrier_d);
+        } while (rank_barrier != barrier_flag);
+    }
+
+    __syncthreads();
+    fence_proxy_alias();
+
+    // The sums of all the slices are in the local buffer
+    const T* uc_ptr = reinterpret_cast<const T*>(params.peer_comm_buffer_ptrs[params.local_rank]);
+    T* output = reinterpret_cast<T*>(params.local_output_buffer_ptr);
+    const size_t max_block_offset = min(block_offset + params.elts_per_block, params.elts_per_rank);
+    for (size_t local_offset = block_offset; local_offset < max_block_offset; local_offset += blockDim.x * NUM_ELTS)
+    {
+        for (size_t rank = 0; rank < params.ranks_per_node; ++rank)
+        {
+            const size_t offset_rank = rank * params.elts_per_rank + local_offset;
+            if (offset_rank < params.elts_total)
+            {
+                *reinterpret_cast<int4*>(&output[offset_rank]) = *reinterpret_cast<const int4*>(&uc_ptr[offset_rank]);
+            }
+        }
+    }
+
+    advance_barrier_epoch(params);
+#else
+    __trap();
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// First phase of the hierarchical all-reduce, the reduce-scatter of the two-shot kernel. The sum of the slice of the
+// rank is written to its own buffer, where the inter-node all-reduce picks it up.
+template <typename T, int RANKS_PER_NODE>
+static __global__ void reduceScatterKernel(AllReduceParams params)
+{
+    const int bidx = blockIdx.x;
+    const int tidx = threadIdx.x;
+
+    // The number of elements packed into one for comms
+    static constexpr int NUM_ELTS = 16 / sizeof(T);
+
+    // Packed data type for comms
+    using PackedType = typename PackedOn16Bytes<T>::Type;
+
+    const size_t block_start = params.rank_offset + bidx * params.elts_per_block;
+    const size_t block_end = min(block_start + params.elts_per_block, params.rank_offset + params.elts_per_rank);
+
+    // The whole input is copied to the peer buffers before the first chunk, the later chunks pass this barrier
+    // immediately.
+    multi_gpu_barrier(params.peer_barrier_ptrs_in, params.barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx);
+
+    // The source pointers. Distributed round-robin for the different warps.
+    T* src_d[RANKS_PER_NODE];
+#pragma unroll
+    for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+    {
+        int rank = (params.local_rank + ii) % RANKS_PER_NODE;
+        src_d[ii] = reinterpret_cast<T*>(params.peer_comm_buffer_ptrs[rank]);
+    }
+
+    for (size_t local_offset = block_start + tidx * NUM_ELTS; local_offset < block_end;
+         local_offset += blockDim.x * NUM_ELTS)
+    {
+        PackedType vals[RANKS_PER_NODE];
+#pragma unroll
+        for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+        {
+            vals[ii].packed = *reinterpret_cast<const int4*>(&src_d[ii][local_offset]);
+        }
+
+        PackedType sums;
+        sums.packed = {0, 0, 0, 0};
+#pragma unroll
+        for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+        {
+            sums.packed = add128b(sums, vals[ii]);
+        }
+
+        // Only this rank reads its slice, so it is updated in place.
+        *reinterpret_cast<int4*>(&src_d[0][local_offset]) = sums.packed;
+    }
+}
+
+// Last phase of the hierarchical all-reduce, the gather of the two-shot kernel. Each rank all-reduced its slice across
+// nodes before its kernel started, so hearing from the first block of every peer is enough.
+template <typename T, int RANKS_PER_NODE>
+static __global__ void allGatherKernel(AllReduceParams params)
+{
+    const int bidx = blockIdx.x;
+    const int tidx = threadIdx.x;
+
+    // The number of elements packed into one for comms
+    static constexpr int NUM_ELTS = 16 / sizeof(T);
+
+    multi_gpu_barrier(params.peer_barrier_ptrs_out, params.barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx);
+
+    // The source pointers. Distributed round-robin for the different warps.
+    const T* src_d[RANKS_PER_NODE];
+    size_t src_rank[RANKS_PER_NODE];
+#pragma unroll
+    for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+    {
+        int rank = (params.local_rank + ii) % RANKS_PER_NODE;
+        src_d[ii] = reinterpret_cast<const T*>(params.peer_comm_buffer_ptrs[rank]);
+        src_rank[ii] = rank;
+    }
+
+    T* dst = reinterpret_cast<T*>(params.local_output_buffer_ptr);
+    const size_t block_start = bidx * params.elts_per_block;
+    const size_t block_end = min(block_start + params.elts_per_block, params.elts_per_rank);
+    for (size_t local_offset = block_start + tidx * NUM_ELTS; local_offset < block_end;
+         local_offset += blockDim.x * NUM_ELTS)
+    {
+#pragma unroll
+        for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+        {
+            const size_t offset_rank = src_rank[ii] * params.elts_per_rank + local_offset;
+            *reinterpret_cast<int4*>(&dst[offset_rank]) = *reinterpret_cast<const int4*>(&src_d[ii][offset_rank]);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A thread of the QUANTIZED all-reduce converts 16 elements, the lanes of a group share a scale.
+constexpr int QUANT_ELTS_PER_THREAD = 16;
+constexpr int QUANT_GROUP_THREADS = QUANT_ALL_REDUCE_GROUP_SIZE / QUANT_ELTS_PER_THREAD;
+
+using PackedInt8 = union
+{
+    int4 packed;
+    int8_t unpacked[16];
+};
+
+template <typename T>
+static __global__ void quantizeForAllReduceKernel(const T* input, int8_t* quantized, float* scales, size_t elts)
+{
+    static constexpr int NUM_PACKS = QUANT_ELTS_PER_THREAD * sizeof(T) / 16;
+    const int lane = threadIdx.x % WARP_SIZE;
+    // elts is a multiple of the group size, so the lanes of a group are all in range or all out of it.
+    const unsigned mask = ((1u << QUANT_GROUP_THREADS) - 1) << (lane / QUANT_GROUP_THREADS * QUANT_GROUP_THREADS);
+
+    for (size_t offset = (blockIdx.x * blockDim.x + threadIdx.x) * QUANT_ELTS_PER_THREAD; offset < elts;
+         offset += gridDim.x * blockDim.x * QUANT_ELTS_PER_THREAD)
+    {
+        int4 packs[NUM_PACKS];
+#pragma unroll
+        for (int ii = 0; ii < NUM_PACKS; ++ii)
+        {
+            packs[ii] = reinterpret_cast<const int4*>(&input[offset])[ii];
+        }
+        const T* vals = reinterpret_cast<const T*>(packs);
+
+        float amax = 0.f;
+#pragma unroll
+        for (int ii = 0; ii < QUANT_ELTS_PER_THREAD; ++ii)
+        {
+            amax = fmaxf(amax, fabsf(cuda_cast<float>(vals[ii])));
+        }
+#pragma unroll
+        for (int delta = QUANT_GROUP_THREADS / 2; delta > 0; delta /= 2)
+        {
+            amax = fmaxf(amax, __shfl_xor_sync(mask, amax, delta, QUANT_GROUP_THREADS));
+        }
+        const float inv_scale = amax > 0.f ? 127.f / amax : 0.f;
+
+        PackedInt8 q;
+#pragma unroll
+        for (int ii = 0; ii < QUANT_ELTS_PER_THREAD; ++ii)
+        {
+            q.unpacked[ii] = static_cast<int8_t>(__float2int_rn(cuda_cast<float>(vals[ii]) * inv_scale));
+        }
+        *reinterpret_cast<int4*>(&quantized[offset]) = q.packed;
+        if (lane % QUANT_GROUP_THREADS == 0)
+        {
+            scales[offset / QUANT_ALL_REDUCE_GROUP_SIZE] = amax / 127.f;
+        }
+    }
+}
+
+template <typename T, int RANKS_PER_NODE>
+static __global__ void quantizedAllReduceKernel(AllReduceParams params)
+{
+    static constexpr int NUM_PACKS = QUANT_ELTS_PER_THREAD * sizeof(T) / 16;
+
+    multi_gpu_barrier(params.peer_barrier_ptrs_in, load_barrier_flag(params), params.local_rank, RANKS_PER_NODE,
+        threadIdx.x, blockIdx.x);
+
+    // The ranks are summed in the same order everywhere, so that all the ranks get the same rounding.
+    const size_t elts = params.elts_total;
+    const int8_t* src_q[RANKS_PER_NODE];
+    const float* src_s[RANKS_PER_NODE];
+#pragma unroll
+    for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+    {
+        src_q[ii] = reinterpret_cast<const int8_t*>(params.peer_comm_buffer_ptrs[ii]);
+        src_s[ii] = reinterpret_cast<const float*>(src_q[ii] + elts);
+    }
+
+    for (size_t offset = (blockIdx.x * blockDim.x + threadIdx.x) * QUANT_ELTS_PER_THREAD; offset < elts;
+         offset += gridDim.x * blockDim.x * QUANT_ELTS_PER_THREAD)
+    {
+        PackedInt8 vals[RANKS_PER_NODE];
+        float scales[RANKS_PER_NODE];
+#pragma unroll
+        for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+        {
+            vals[ii].packed = *reinterpret_cast<const int4*>(&src_q[ii][offset]);
+            scales[ii] = src_s[ii][offset / QUANT_ALL_REDUCE_GROUP_SIZE];
+        }
+
+        float sums[QUANT_ELTS_PER_THREAD] = {0.f};
+#pragma unroll
+        for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+        {
+#pragma unroll
+            for (int jj = 0; jj < QUANT_ELTS_PER_THREAD; ++jj)
+            {
+                sums[jj] += scales[ii] * static_cast<float>(vals[ii].unpacked[jj]);
+            }
+        }
+
+        int4 packs[NUM_PACKS];
+        T* out = reinterpret_cast<T*>(packs);
+#pragma unroll
+        for (int jj = 0; jj < QUANT_ELTS_PER_THREAD; ++jj)
+        {
+            out[jj] = cuda_cast<T>(sums[jj]);
+        }
+#pragma unroll
+        for (int ii = 0; ii < NUM_PACKS; ++ii)
+        {
+            reinterpret_cast<int4*>(&reinterpret_cast<T*>(params.local_output_buffer_ptr)[offset])[ii] = packs[ii];
+        }
+    }
+
+    advance_barrier_epoch(params);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Computes out = RMSNorm(allreduce(in) + residual) * weight and writes allreduce(in) + residual to the intermediate
+ * buffer. With RANKS_PER_NODE > 1, this is the one-shot all-reduce: the peer buffers are summed while the data is in
+ * registers. With RANKS_PER_NODE == 1, the intermediate buffer already holds allreduce(in) (two-shot or NCCL) and is
+ * updated in place.
+ *
+ * One CTA handles one row (token) at a time, so the variance is a block reduction. When quantizing, the normalized row
+ * is re-computed from the intermediate buffer once its amax is known, as in generalRmsNorm.
+ */
+template <typename T, int RANKS_PER_NODE>
+static __global__ void residualRmsNormKernel(AllReduceParams params)
+{
+    const int bidx = blockIdx.x;
+    const int tidx = threadIdx.x;
+
+    // The number of elements packed into one for comms
+    static constexpr int NUM_ELTS = 16 / sizeof(T);
+
+    // Packed data type for comms
+    using PackedStruct = typename PackedOn16Bytes<T>::Type;
+
+    const AllReduceFusionParams& fusion = params.fusion_params;
+    T* intermediate = reinterpret_cast<T*>(fusion.intermediate_buffer);
+    const T* residual = reinterpret_cast<const T*>(fusion.residual_buffer);
+    const T* weight = reinterpret_cast<const T*>(fusion.weight_buffer);
+    T* output = reinterpret_cast<T*>(params.local_output_buffer_ptr);
+    const bool quantize = fusion.quant_output_buffer != nullptr;
+
+    // The source pointers. Distributed round-robin for the different warps.
+    const T* src_d[RANKS_PER_NODE];
+    if constexpr (RANKS_PER_NODE == 1)
+    {
+        src_d[0] = intermediate;
+    }
+    else
+    {
+        multi_gpu_barrier(
+            params.peer_barrier_ptrs_in, load_barrier_flag(params), params.local_rank, RANKS_PER_NODE, tidx, bidx);
+#pragma unroll
+        for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+        {
+            int rank = (params.local_rank + ii) % RANKS_PER_NODE;
+            src_d[ii] = reinterpret_cast<T*>(params.peer_comm_buffer_ptrs[rank]);
+        }
+    }
+
+    __shared__ float s_inv_rms;
+
+    const size_t hidden_size = fusion.hidden_size;
+    const size_t num_tokens = params.elts_total / hidden_size;
+    for (size_t token = bidx; token < num_tokens; token += gridDim.x)
+    {
+        const size_t row_offset = token * hidden_size;
+
+        // Reduce, add the residual and accumulate the squares. Each thread only reads back what it wrote below.
+        float local_sq_sum = 0.f;
+        for (size_t col = tidx * NUM_ELTS; col < hidden_size; col += blockDim.x * NUM_ELTS)
+        {
+            PackedStruct sums;
+            sums.packed = {0, 0, 0, 0};
+#pragma unroll
+            for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+            {
+                PackedStruct vals;
+                vals.packed = *reinterpret_cast<const int4*>(&src_d[ii][row_offset + col]);
+                sums.packed = add128b(sums, vals);
+            }
+            PackedStruct res;
+            res.packed = *reinterpret_cast<const int4*>(&residual[row_offset + col]);
+            sums.packed = add128b(sums, res);
+            *reinterpret_cast<int4*>(&intermediate[row_offset + col]) = sums.packed;
+
+            const T* elts = reinterpret_cast<const T*>(&sums);
+#pragma unroll
+            for (int jj = 0; jj < NUM_ELTS; ++jj)
+            {
+                const float val = cuda_cast<float>(elts[jj]);
+                local_sq_sum += val * val;
+            }
+        }
+
+        float packed[1] = {local_sq_sum};
+        blockReduceSumV2<float, 1>(packed);
+        if (tidx == 0)
+        {
+            s_inv_rms = rsqrtf(packed[0] / hidden_size + fusion.eps);
+        }
+        __syncthreads();
+
+        // Normalize, or find the amax of the normalized row when quantizing.
+        float amax = 1e-6f;
+        for (size_t col = tidx * NUM_ELTS; col < hidden_size; col += blockDim.x * NUM_ELTS)
+        {
+            PackedStruct vals, gamma;
+            vals.packed = *reinterpret_cast<const int4*>(&intermediate[row_offset + col]);
+            gamma.packed = *reinterpret_cast<const int4*>(&weight[col]);
+            T* elts = reinterpret_cast<T*>(&vals);
+            const T* gamma_elts = reinterpret_cast<const T*>(&gamma);
+#pragma unroll
+            for (int jj = 0; jj < NUM_ELTS; ++jj)
+            {
+                const T normed
+                    = cuda_cast<T>(cuda_cast<float>(elts[jj]) * s_inv_rms * cuda_cast<float>(gamma_elts[jj]));
+                amax = fmaxf(amax, fabsf(cuda_cast<float>(normed)));
+                elts[jj] = normed;
+            }
+            if (!quantize)
+            {
+                *reinterpret_cast<int4*>(&output[row_offset + col]) = vals.packed;
+            }
+        }
+
+        if (quantize)
+        {
+            const float row_amax = blockAllReduceMax(amax);
+            const float scale_orig_quant = 127.f / row_amax;
+            for (size_t col = tidx * NUM_ELTS; col < hidden_size; col += blockDim.x * NUM_ELTS)
+            {
+                PackedStruct vals, gamma;
+                vals.packed = *reinterpret_cast<const int4*>(&intermediate[row_offset + col]);
+                gamma.packed = *reinterpret_cast<const int4*>(&weight[col]);
+                const T* elts = reinterpret_cast<const T*>(&vals);
+                const T* gamma_elts = reinterpret_cast<const T*>(&gamma);
+#pragma unroll
+                for (int jj = 0; jj < NUM_ELTS; ++jj)
+                {
+                    const T normed
+                        = cuda_cast<T>(cuda_cast<float>(elts[jj]) * s_inv_rms * cuda_cast<float>(gamma_elts[jj]));
+                    fusion.quant_output_buffer[row_offset + col + jj]
+                        = cuda_cast<int8_t>(cuda_cast<float>(normed) * scale_orig_quant);
+                }
+            }
+            if (tidx == 0)
+            {
+                fusion.scale_output_buffer[token] = row_amax / 127.f;
+            }
+        }
+
+        // The shared memory of the reductions and s_inv_rms are reused by the next row.
+        __syncthreads();
+    }
+
+    if constexpr (RANKS_PER_NODE != 1)
+    {
+        advance_barrier_epoch(params);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -372,20 +907,164 @@ void dispatchARKernels(
     }
 }
 
+std::tuple<int, int> residualRmsNormLaunchConfig(const AllReduceParams& param, size_t elts_per_thread, int max_blocks)
+{
+    const size_t hidden_size = param.fusion_params.hidden_size;
+    TLLM_CHECK_WITH_INFO(hidden_size > 0 && hidden_size % elts_per_thread == 0 && param.elts_total % hidden_size == 0,
+        "The fused RMSNorm needs a hidden size multiple of %zu that divides the number of elements", elts_per_thread);
+
+    const size_t num_tokens = param.elts_total / hidden_size;
+    const int threads_per_block = static_cast<int>(
+        std::min(DEFAULT_BLOCK_SIZE, WARP_SIZE * divUp(hidden_size / elts_per_thread, WARP_SIZE)));
+    const int blocks_per_grid = static_cast<int>(std::min(num_tokens, static_cast<size_t>(max_blocks)));
+    return std::make_tuple(blocks_per_grid, threads_per_block);
+}
+
+template <typename T, int RANKS_PER_NODE>
+void dispatchResidualRmsNormKernel(AllReduceParams& param, int max_blocks, cudaStream_t stream)
+{
+    auto [blocks_per_grid, threads_per_block] = residualRmsNormLaunchConfig(param, 16 / sizeof(T), max_blocks);
+    residualRmsNormKernel<T, RANKS_PER_NODE><<<blocks_per_grid, threads_per_block, 0, stream>>>(param);
+}
+
+template <typename T>
+void invokeResidualRmsNormKernel(AllReduceParams& param, cudaStream_t stream)
+{
+    // The kernel loops over the rows, a block per row is enough.
+    constexpr int kMaxBlocks = 65535;
+    dispatchResidualRmsNormKernel<T, 1>(param, kMaxBlocks, stream);
+}
+
 template <typename T>
-void invokeOneOrTwoShotAllReduceKernel(AllReduceParams& param, AllReduceStrategyType strat, cudaStream_t stream)
+void invokeOneOrTwoShotAllReduceKernel(
+    AllReduceParams& param, AllReduceStrategyType strat, AllReduceFusionOp fusionOp, cudaStream_t stream)
 {
-    TLLM_CHECK(strat == AllReduceStrategyType::ONESHOT || strat == AllReduceStrategyType::TWOSHOT);
+    TLLM_CHECK(strat == AllReduceStrategyType::ONESHOT || strat == AllReduceStrategyType::TWOSHOT
+        || strat == AllReduceStrategyType::NVLS);
+    TLLM_CHECK_WITH_INFO(strat != AllReduceStrategyType::NVLS || param.multicast_ptr != nullptr,
+        "The NVLS all-reduce needs a multicast buffer");
     sync_check_cuda_error();
 
+    if (fusionOp != AllReduceFusionOp::NONE && strat == AllReduceStrategyType::ONESHOT)
+    {
+        // Each rank reduces all the rows, so the residual add and the norm run in the same kernel.
+        switch (param.ranks_per_node)
+        {
+        case 2: dispatchResidualRmsNormKernel<T, 2>(param, MAX_ALL_REDUCE_BLOCKS, stream); break;
+        case 4: dispatchResidualRmsNormKernel<T, 4>(param, MAX_ALL_REDUCE_BLOCKS, stream); break;
+        case 6: dispatchResidualRmsNormKernel<T, 6>(param, MAX_ALL_REDUCE_BLOCKS, stream); break;
+        case 8: dispatchResidualRmsNormKernel<T, 8>(param, MAX_ALL_REDUCE_BLOCKS, stream); break;
+        default: break;
+        }
+        sync_check_cuda_error();
+        return;
+    }
+
+    // The two-shot reduce-scatter does not split along rows, so the fused operation runs once the values are gathered
+    // into the intermediate buffer.
+    void* output = param.local_output_buffer_ptr;
+    if (fusionOp != AllReduceFusionOp::NONE)
+    {
+        param.local_output_buffer_ptr = param.fusion_params.intermediate_buffer;
+    }
+
     size_t elts_per_thread = 16 / sizeof(T);
-    auto [blocks_per_grid, threads_per_block] = kernelLaunchConfig(strat, param, elts_per_thread);
+    if (strat == AllReduceStrategyType::NVLS)
+    {
+        // Split like the two-shot kernel, the ranks are not unrolled since the switch does the loads.
+        auto [blocks_per_grid, threads_per_block]
+            = kernelLaunchConfig(AllReduceStrategyType::TWOSHOT, param, elts_per_thread);
+        nvlsAllReduceKernel<T><<<blocks_per_grid, threads_per_block, 0, stream>>>(param);
+    }
+    else
+    {
+        auto [blocks_per_grid, threads_per_block] = kernelLaunchConfig(strat, param, elts_per_thread);
+        switch (param.ranks_per_node)
+        {
+        case 2: dispatchARKernels<T, 2>(strat, param, blocks_per_grid, threads_per_block, stream); break;
+        case 4: dispatchARKernels<T, 4>(strat, param, blocks_per_grid, threads_per_block, stream); break;
+        case 6: dispatchARKernels<T, 6>(strat, param, blocks_per_grid, threads_per_block, stream); break;
+        case 8: dispatchARKernels<T, 8>(strat, param, blocks_per_grid, threads_per_block, stream); break;
+        default: break;
+        }
+    }
+
+    if (fusionOp != AllReduceFusionOp::NONE)
+    {
+        param.local_output_buffer_ptr = output;
+        invokeResidualRmsNormKernel<T>(param, stream);
+    }
+    sync_check_cuda_error();
+}
+
+template <typename T, int RANKS_PER_NODE>
+void dispatchHierarchicalKernels(
+    bool gather, AllReduceParams& param, int blocks_per_grid, int threads_per_block, cudaStream_t stream)
+{
+    if (gather)
+    {
+        allGatherKernel<T, RANKS_PER_NODE><<<blocks_per_grid, threads_per_block, 0, stream>>>(param);
+    }
+    else
+    {
+        reduceScatterKernel<T, RANKS_PER_NODE><<<blocks_per_grid, threads_per_block, 0, stream>>>(param);
+    }
+}
+
+// Runs a node-local phase of the hierarchical all-reduce on the elements [offset, offset + param.elts_total) of the
+// peer buffers. Both phases split the slices like the two-shot kernel, so a block gathers what the same block reduced.
+template <typename T>
+void invokeHierarchicalKernel(AllReduceParams& param, size_t offset, bool gather, cudaStream_t stream)
+{
+    sync_check_cuda_error();
+    TLLM_CHECK_WITH_INFO(param.elts_total % (param.ranks_per_node * (16 / sizeof(T))) == 0,
+        "The hierarchical all-reduce needs a multiple of %zu elements", param.ranks_per_node * (16 / sizeof(T)));
+
+    AllReduceParams chunk = param;
+    for (size_t ii = 0; ii < param.ranks_per_node; ++ii)
+    {
+        chunk.peer_comm_buffer_ptrs[ii] = reinterpret_cast<T*>(param.peer_comm_buffer_ptrs[ii]) + offset;
+    }
+    if (gather)
+    {
+        chunk.local_output_buffer_ptr = reinterpret_cast<T*>(param.local_output_buffer_ptr) + offset;
+    }
+
+    auto [blocks_per_grid, threads_per_block]
+        = kernelLaunchConfig(AllReduceStrategyType::TWOSHOT, chunk, 16 / sizeof(T));
+    switch (chunk.ranks_per_node)
+    {
+    case 2: dispatchHierarchicalKernels<T, 2>(gather, chunk, blocks_per_grid, threads_per_block, stream); break;
+    case 4: dispatchHierarchicalKernels<T, 4>(gather, chunk, blocks_per_grid, threads_per_block, stream); break;
+    case 6: dispatchHierarchicalKernels<T, 6>(gather, chunk, blocks_per_grid, threads_per_block, stream); break;
+    case 8: dispatchHierarchicalKernels<T, 8>(gather, chunk, blocks_per_grid, threads_per_block, stream); break;
+    default: break;
+    }
+    sync_check_cuda_error();
+}
+
+template <typename T>
+void invokeQuantizedAllReduceKernel(AllReduceParams& param, const T* input, cudaStream_t stream)
+{
+    sync_check_cuda_error();
+    TLLM_CHECK_WITH_INFO(param.elts_total % QUANT_ALL_REDUCE_GROUP_SIZE == 0,
+        "The quantized all-reduce needs a multiple of %zu elements", QUANT_ALL_REDUCE_GROUP_SIZE);
+
+    const size_t total_threads = param.elts_total / QUANT_ELTS_PER_THREAD;
+    const int threads_per_block
+        = static_cast<int>(std::min(DEFAULT_BLOCK_SIZE, WARP_SIZE * divUp(total_threads, WARP_SIZE)));
+    auto* quantized = reinterpret_cast<int8_t*>(param.peer_comm_buffer_ptrs[param.local_rank]);
+    quantizeForAllReduceKernel<T><<<divUp(total_threads, threads_per_block), threads_per_block, 0, stream>>>(
+        input, quantized, reinterpret_cast<float*>(quantized + param.elts_total), param.elts_total);
+
+    const int blocks_per_grid = static_cast<int>(
+        std::min(MAX_ALL_REDUCE_BLOCKS, static_cast<size_t>(divUp(total_threads, threads_per_block))));
     switch (param.ranks_per_node)
     {
-    case 2: dispatchARKernels<T, 2>(strat, param, blocks_per_grid, threads_per_block, stream); break;
-    case 4: dispatchARKernels<T, 4>(strat, param, blocks_per_grid, threads_per_block, stream); break;
-    case 6: dispatchARKernels<T, 6>(strat, param, blocks_per_grid, threads_per_block, stream); break;
-    case 8: dispatchARKernels<T, 8>(strat, param, blocks_per_grid, threads_per_block, stream); break;
+    case 2: quantizedAllReduceKernel<T, 2><<<blocks_per_grid, threads_per_block, 0, stream>>>(param); break;
+    case 4: quantizedAllReduceKernel<T, 4><<<blocks_per_grid, threads_per_block, 0, stream>>>(param); break;
+    case 6: quantizedAllReduceKernel<T, 6><<<blocks_per_grid, threads_per_block, 0, stream>>>(param); break;
+    case 8: quantizedAllReduceKernel<T, 8><<<blocks_per_grid, threads_per_block, 0, stream>>>(param); break;
     default: break;
     }
     sync_check_cuda_error();
@@ -417,7 +1096,9 @@ AllReduceParams AllReduceParams::deserialize(const int32_t* buffer, size_t tpSiz
     {
         params.peer_barrier_ptrs_out[i] = reinterpret_cast<uint32_t*>(buffer_ptrs[3 * tpSize + i]);
     }
+    params.multicast_ptr = nullptr;
     params.barrier_flag = flag_value;
+    params.device_barrier_flag = false;
     params.ranks_per_node = tpSize;
     params.rank = tpRank;
     params.local_rank = tpRank;
@@ -426,23 +1107,23 @@ AllReduceParams AllReduceParams::deserialize(const int32_t* buffer, size_t tpSiz
 }
 
 void customAllReduce(kernels::AllReduceParams& params, void* data, size_t elts, size_t size_per_elem,
-    datatype_enum dataType, AllReduceStrategyType strat, cudaStream_t stream)
+    datatype_enum dataType, AllReduceStrategyType strat, cudaStream_t stream, AllReduceFusionOp fusionOp)
 {
     params.local_output_buffer_ptr = data;
     params.elts_total = elts;
 
     if (dataType == datatype_enum::TYPE_FP32)
     {
-        kernels::invokeOneOrTwoShotAllReduceKernel<float>(params, strat, stream);
+        kernels::invokeOneOrTwoShotAllReduceKernel<float>(params, strat, fusionOp, stream);
     }
     else if (dataType == datatype_enum::TYPE_FP16)
     {
-        kernels::invokeOneOrTwoShotAllReduceKernel<half>(params, strat, stream);
+        kernels::invokeOneOrTwoShotAllReduceKernel<half>(params, strat, fusionOp, stream);
     }
 #ifdef ENABLE_BF16
     else if (dataType == datatype_enum::TYPE_BF16)
     {
-        kernels::invokeOneOrTwoShotAllReduceKernel<__nv_bfloat16>(params, strat, stream);
+        kernels::invokeOneOrTwoShotAllReduceKernel<__nv_bfloat16>(params, strat, fusionOp, stream);
     }
 #endif
     else
@@ -451,4 +1132,108 @@ void customAllReduce(kernels::AllReduceParams& params, void* data, size_t elts,
     }
 }
 
+void customQuantizedAllReduce(kernels::AllReduceParams& params, const void* input, void* data, size_t elts,
+    datatype_enum dataType, cudaStream_t stream)
+{
+    params.local_output_buffer_ptr = data;
+    params.elts_total = elts;
+
+    if (dataType == datatype_enum::TYPE_FP32)
+    {
+        kernels::invokeQuantizedAllReduceKernel<float>(params, static_cast<const float*>(input), stream);
+    }
+    else if (dataType == datatype_enum::TYPE_FP16)
+    {
+        kernels::invokeQuantizedAllReduceKernel<half>(params, static_cast<const half*>(input), stream);
+    }
+#ifdef ENABLE_BF16
+    else if (dataType == datatype_enum::TYPE_BF16)
+    {
+        kernels::invokeQuantizedAllReduceKernel<__nv_bfloat16>(
+            params, static_cast<const __nv_bfloat16*>(input), stream);
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported dataType for the quantized all-reduce");
+    }
+}
+
+namespace
+{
+void hierarchicalPhase(kernels::AllReduceParams& params, size_t offset, size_t elts, bool gather,
+    datatype_enum dataType, cudaStream_t stream)
+{
+    params.elts_total = elts;
+
+    if (dataType == datatype_enum::TYPE_FP32)
+    {
+        kernels::invokeHierarchicalKernel<float>(params, offset, gather, stream);
+    }
+    else if (dataType == datatype_enum::TYPE_FP16)
+    {
+        kernels::invokeHierarchicalKernel<half>(params, offset, gather, stream);
+    }
+#ifdef ENABLE_BF16
+    else if (dataType == datatype_enum::TYPE_BF16)
+    {
+        kernels::invokeHierarchicalKernel<__nv_bfloat16>(params, offset, gather, stream);
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported dataType for the hierarchical all-reduce");
+    }
+}
+} // namespace
+
+void customReduceScatter(
+    kernels::AllReduceParams& params, size_t offset, size_t elts, datatype_enum dataType, cudaStream_t stream)
+{
+    hierarchicalPhase(params, offset, elts, false, dataType, stream);
+}
+
+void customAllGather(kernels::AllReduceParams& params, void* data, size_t offset, size_t elts, int chunk,
+    datatype_enum dataType, cudaStream_t stream)
+{
+    TLLM_CHECK(chunk >= 0 && static_cast<size_t>(chunk) < MAX_HIERARCHICAL_CHUNKS);
+    params.local_output_buffer_ptr = data;
+
+    // Each chunk signals on its own flags. The flag value is the same for all the chunks, the previous chunk would
+    // otherwise release the barrier of the next one before the peers are done with it.
+    kernels::AllReduceParams chunkParams = params;
+    for (size_t ii = 0; ii < params.ranks_per_node; ++ii)
+    {
+        chunkParams.peer_barrier_ptrs_out[ii] = params.peer_barrier_ptrs_out[ii] + chunk * params.ranks_per_node;
+    }
+    hierarchicalPhase(chunkParams, offset, elts, true, dataType, stream);
+}
+
+void residualRmsNorm(
+    kernels::AllReduceParams& params, void* data, size_t elts, datatype_enum dataType, cudaStream_t stream)
+{
+    params.local_output_buffer_ptr = data;
+    params.elts_total = elts;
+
+    if (dataType == datatype_enum::TYPE_FP32)
+    {
+        kernels::invokeResidualRmsNormKernel<float>(params, stream);
+    }
+    else if (dataType == datatype_enum::TYPE_FP16)
+    {
+        kernels::invokeResidualRmsNormKernel<half>(params, stream);
+    }
+#ifdef ENABLE_BF16
+    else if (dataType == datatype_enum::TYPE_BF16)
+    {
+        kernels::invokeResidualRmsNormKernel<__nv_bfloat16>(params, stream);
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported dataType for residualRmsNorm");
+    }
+    sync_check_cuda_error();
+}
+
 } // namespace tensorrt_llm::kernels
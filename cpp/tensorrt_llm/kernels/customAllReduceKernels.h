@@ -33,6 +33,11 @@ constexpr size_t WARP_SIZE = 32;
 constexpr size_t MAX_ALL_REDUCE_BLOCKS = 24;
 constexpr size_t MAX_RANKS_PER_NODE = 8;
 constexpr size_t DEFAULT_BLOCK_SIZE = 1024;
+// Chunks a hierarchical all-reduce is split into, so that the inter-node all-reduce of a chunk overlaps the node-local
+// phases of the others.
+constexpr size_t MAX_HIERARCHICAL_CHUNKS = 4;
+// Elements sharing a scale in the QUANTIZED all-reduce.
+constexpr size_t QUANT_ALL_REDUCE_GROUP_SIZE = 128;
 
 // Warning: python definition is in tensorrt_llm/functional.py
 // they must be kept in sync
@@ -42,6 +47,44 @@ enum class AllReduceStrategyType : int8_t
     ONESHOT = 1,
     TWOSHOT = 2,
     AUTO = 3,
+    // Tensor parallelism across nodes: reduce-scatter among the ranks of a node through the IPC buffers, all-reduce of
+    // the 1/ranks_per_node slice across nodes with NCCL, then all-gather among the ranks of the node.
+    HIERARCHICAL = 4,
+    // One-shot all-reduce of int8 values with a float scale per QUANT_ALL_REDUCE_GROUP_SIZE elements, accumulated in
+    // fp32. About halves the traffic of fp16/bf16 at the cost of the quantization error of every rank. Opt-in, AUTO
+    // never selects it.
+    QUANTIZED = 5,
+    // Two-shot all-reduce through an NVLink multicast object, SM90 with NVSwitch only. Each rank reduces its slice of
+    // the buffers of all the ranks in the switch with multimem.ld_reduce and stores the sum to all of them with
+    // multimem.st, so that every byte crosses NVLink once each way. Needs AllReduceParams::multicast_ptr.
+    NVLS = 6,
+};
+
+// Operation fused after the all-reduce.
+// Warning: python definition is in tensorrt_llm/functional.py
+// they must be kept in sync
+enum class AllReduceFusionOp : int8_t
+{
+    NONE = 0,
+    // out = RMSNorm(allreduce(in) + residual) * weight, the sum before the norm is the residual of the next layer.
+    RESIDUAL_RMS_NORM = 1,
+    // As RESIDUAL_RMS_NORM, with the normalized output quantized to int8 with per-token dynamic scales.
+    RESIDUAL_RMS_NORM_QUANT = 2,
+};
+
+struct AllReduceFusionParams
+{
+    size_t hidden_size = 0;
+    // [tokens, hidden_size], added to the reduced values.
+    const void* residual_buffer = nullptr;
+    // [hidden_size], the RMSNorm weight.
+    const void* weight_buffer = nullptr;
+    float eps = 1e-6f;
+    // [tokens, hidden_size], receives allreduce(in) + residual.
+    void* intermediate_buffer = nullptr;
+    // [tokens, hidden_size] and [tokens], the outputs of RESIDUAL_RMS_NORM_QUANT.
+    int8_t* quant_output_buffer = nullptr;
+    float* scale_output_buffer = nullptr;
 };
 
 struct AllReduceParams
@@ -52,20 +95,48 @@ struct AllReduceParams
     size_t rank_offset;
     size_t ranks_per_node, rank, local_rank;
     uint32_t barrier_flag;
+    // Ignore barrier_flag and use a flag advanced on the device by every launch, so that the launch can be captured in
+    // a CUDA graph and replayed as is. Only for the one-shot, two-shot, NVLS, quantized and fused kernels.
+    bool device_barrier_flag;
     uint32_t* peer_barrier_ptrs_in[MAX_RANKS_PER_NODE];
     uint32_t* peer_barrier_ptrs_out[MAX_RANKS_PER_NODE];
     void* peer_comm_buffer_ptrs[MAX_RANKS_PER_NODE];
     void* local_output_buffer_ptr;
+    // NVLS: multicast address of the buffer whose unicast address on this rank is peer_comm_buffer_ptrs[local_rank].
+    void* multicast_ptr;
+    AllReduceFusionParams fusion_params;
 
     static AllReduceParams deserialize(const int32_t* buffer, size_t tpSize, size_t tpRank, uint32_t flag_value);
 };
 
 template <typename T>
-void invokeOneOrTwoShotAllReduceKernel(AllReduceParams& param, AllReduceStrategyType strat, cudaStream_t stream);
+void invokeOneOrTwoShotAllReduceKernel(
+    AllReduceParams& param, AllReduceStrategyType strat, AllReduceFusionOp fusionOp, cudaStream_t stream);
 
 void invokeMultiGpuBarrier(AllReduceParams& param, cudaStream_t stream);
 
 void customAllReduce(kernels::AllReduceParams& params, void* data, size_t elts, size_t size_per_elem,
-    common::datatype_enum dataType, AllReduceStrategyType strat, cudaStream_t stream);
+    common::datatype_enum dataType, AllReduceStrategyType strat, cudaStream_t stream,
+    AllReduceFusionOp fusionOp = AllReduceFusionOp::NONE);
+
+// Node-local phases of the hierarchical all-reduce, on the elements [offset, offset + elts) of the peer buffers. elts
+// must be a multiple of ranks_per_node * 16 bytes. The reduce-scatter leaves the sum of the slice of local_rank in its
+// own buffer, to be all-reduced across nodes in place. The all-gather then copies the slices of all the ranks of the
+// node to data. The barrier flags of the all-gather are separate per chunk, chunk < MAX_HIERARCHICAL_CHUNKS.
+void customReduceScatter(kernels::AllReduceParams& params, size_t offset, size_t elts, common::datatype_enum dataType,
+    cudaStream_t stream);
+void customAllGather(kernels::AllReduceParams& params, void* data, size_t offset, size_t elts, int chunk,
+    common::datatype_enum dataType, cudaStream_t stream);
+
+// QUANTIZED all-reduce of input into data. Each rank quantizes its input into its own peer buffer, the int8 values
+// followed by the scales, then sums the dequantized values of all the ranks in fp32, in the same order on every rank.
+// elts must be a multiple of QUANT_ALL_REDUCE_GROUP_SIZE.
+void customQuantizedAllReduce(kernels::AllReduceParams& params, const void* input, void* data, size_t elts,
+    common::datatype_enum dataType, cudaStream_t stream);
+
+// Applies the residual RMSNorm of params.fusion_params to values that were already all-reduced into the intermediate
+// buffer, e.g. by NCCL. data receives the normalized output unless fusion_params.quant_output_buffer is set.
+void residualRmsNorm(
+    kernels::AllReduceParams& params, void* data, size_t elts, common::datatype_enum dataType, cudaStream_t stream);
 
 } // namespace tensorrt_llm::kernels
@@ -202,7 +202,12 @@ std::vector<CutlassTileConfigSM90> get_candidate_tiles_sm90(
             CutlassTileConfigSM90::CtaShape64x256x128B, CutlassTileConfigSM90::CtaShape128x16x128B,
             CutlassTileConfigSM90::CtaShape128x32x128B, CutlassTileConfigSM90::CtaShape128x64x128B,
             CutlassTileConfigSM90::CtaShape128x128x128B, CutlassTileConfigSM90::CtaShape128x256x128B};
-    default: throw std::runtime_error("get_candidate_tiles_sm90 only supports WeightOnly now.");
+    // FP8 GEMMs, the N tiles below 64 do not pay off without the weight conversion in the mainloop.
+    case CutlassGemmType::Default:
+        return {CutlassTileConfigSM90::CtaShape64x64x128B, CutlassTileConfigSM90::CtaShape64x128x128B,
+            CutlassTileConfigSM90::CtaShape64x256x128B, CutlassTileConfigSM90::CtaShape128x64x128B,
+            CutlassTileConfigSM90::CtaShape128x128x128B, CutlassTileConfigSM90::CtaShape128x256x128B};
+    default: throw std::runtime_error("get_candidate_tiles_sm90 only supports WeightOnly and FP8 GEMMs now.");
     }
 }
 
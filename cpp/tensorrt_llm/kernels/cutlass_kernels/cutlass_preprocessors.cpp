@@ -19,8 +19,14 @@
 #include "tensorrt_llm/common/cudaBf16Wrapper.h"
 #include "tensorrt_llm/common/stringUtils.h"
 
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/common.h"
+
 #include "cutlass_extensions/gemm/kernel/mixed_gemm_B_layout.h"
 
+#include <algorithm>
+#include <exception>
+#include <thread>
+
 using namespace tensorrt_llm::common;
 
 namespace tensorrt_llm
@@ -30,16 +36,82 @@ namespace kernels
 namespace cutlass_kernels
 {
 
+namespace
+{
+// Runs body(begin, end) on disjoint chunks of [0, num_items) on up to one thread per core. Inputs smaller than
+// min_items_per_thread per thread are not worth a thread. Exceptions of the body are rethrown on the calling thread.
+template <typename Body>
+void parallel_for(size_t num_items, size_t min_items_per_thread, Body&& body)
+{
+    const size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t num_threads = std::min(max_threads, num_items / std::max<size_t>(min_items_per_thread, 1));
+    if (num_threads <= 1)
+    {
+        body(size_t{0}, num_items);
+        return;
+    }
+
+    const size_t items_per_thread = (num_items + num_threads - 1) / num_threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (size_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+    {
+        const size_t begin = thread_idx * items_per_thread;
+        const size_t end = std::min(num_items, begin + items_per_thread);
+        if (begin >= end)
+        {
+            break;
+        }
+        threads.emplace_back(
+            [&body, &error = errors[thread_idx], begin, end]()
+            {
+                try
+                {
+                    body(begin, end);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (const auto& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Minimum work per thread of the CPU preprocessing, about 1 MiB of weights.
+constexpr size_t kMinBytesPerThread = size_t{1} << 20;
+} // namespace
+
 int get_bits_in_quant_type(QuantType quant_type)
 {
     switch (quant_type)
     {
     case QuantType::INT8_WEIGHT_ONLY: return 8;
     case QuantType::PACKED_INT4_WEIGHT_ONLY: return 4;
+    case QuantType::PACKED_INT3_WEIGHT_ONLY: return 3;
+    case QuantType::PACKED_INT2_WEIGHT_ONLY: return 2;
+    case QuantType::PACKED_NF4_WEIGHT_ONLY: return 4;
     default: TLLM_CHECK_WITH_INFO(false, "Invalid quant_type"); return -1;
     }
 }
 
+bool is_low_bit_quant_type(QuantType quant_type)
+{
+    return quant_type == QuantType::PACKED_INT3_WEIGHT_ONLY || quant_type == QuantType::PACKED_INT2_WEIGHT_ONLY
+        || quant_type == QuantType::PACKED_NF4_WEIGHT_ONLY;
+}
+
 struct LayoutDetails
 {
     enum class Layout
@@ -194,21 +266,24 @@ void permute_B_rows_for_mixed_gemm(int8_t* permuted_quantized_tensor, const int8
         fmtstr("Invalid shape for quantized tensor. On turing/Ampere, the number of cols must be a multiple of %d.",
             MMA_SHAPE_N));
 
-    // The code is written as below so it works for both int8 and packed int4.
-    for (int expert = 0; expert < num_experts; ++expert)
-    {
-        const int64_t matrix_offset = expert * int64_t(num_rows) * int64_t(num_vec_cols);
-        for (int base_row = 0; base_row < num_rows; base_row += B_ROWS_PER_MMA)
+    // The code is written as below so it works for both int8 and packed int4. Each thread writes whole rows.
+    const size_t min_rows_per_thread = kMinBytesPerThread / std::max<size_t>(num_vec_cols * sizeof(uint32_t), 1);
+    parallel_for(num_experts * num_rows, min_rows_per_thread,
+        [&](size_t begin, size_t end)
         {
-            for (int tile_row = 0; tile_row < B_ROWS_PER_MMA; ++tile_row)
+            for (size_t row_idx = begin; row_idx < end; ++row_idx)
             {
+                const int64_t expert = row_idx / num_rows;
+                const int64_t matrix_offset = expert * int64_t(num_rows) * int64_t(num_vec_cols);
+                const int write_row = row_idx % num_rows;
+                const int base_row = write_row / B_ROWS_PER_MMA * B_ROWS_PER_MMA;
+                const int tile_row = write_row % B_ROWS_PER_MMA;
+                const int tile_read_row
+                    = 8 * (((tile_row % ELTS_PER_REG) / 2)) + tile_row % 2 + 2 * (tile_row / ELTS_PER_REG);
+                const int read_row = base_row + tile_read_row;
 
                 for (int write_col = 0; write_col < num_vec_cols; ++write_col)
                 {
-                    const int write_row = base_row + tile_row;
-                    const int tile_read_row
-                        = 8 * (((tile_row % ELTS_PER_REG) / 2)) + tile_row % 2 + 2 * (tile_row / ELTS_PER_REG);
-                    const int read_row = base_row + tile_read_row;
                     const int read_col = write_col;
 
                     const int64_t read_offset = matrix_offset + int64_t(read_row) * num_vec_cols + read_col;
@@ -217,8 +292,7 @@ void permute_B_rows_for_mixed_gemm(int8_t* permuted_quantized_tensor, const int8
                     output_byte_ptr[write_offset] = input_byte_ptr[read_offset];
                 }
             }
-        }
-    }
+        });
 }
 
 // We need to use this transpose to correctly handle packed int4 and int8 data
@@ -248,7 +322,6 @@ void subbyte_transpose_impl(
 
     static constexpr int M_TILE_L1 = 64;
     static constexpr int N_TILE_L1 = M_TILE_L1 / ELTS_PER_BYTE;
-    uint8_t cache_buf[M_TILE_L1][N_TILE_L1];
 
     static constexpr int VECTOR_WIDTH = std::min(32, N_TILE_L1);
 
@@ -260,108 +333,118 @@ void subbyte_transpose_impl(
                "num_col_bytes = %ld.",
             VECTOR_WIDTH, col_bytes_trans, col_bytes));
 
-    const int num_m_tiles = (num_rows + M_TILE_L1 - 1) / M_TILE_L1;
-    const int num_n_tiles = (col_bytes + N_TILE_L1 - 1) / N_TILE_L1;
-
-    for (size_t expert = 0; expert < num_experts; ++expert)
+    const auto transpose_tile = [&](uint8_t(&cache_buf)[M_TILE_L1][N_TILE_L1], size_t row_tile_start,
+                                    size_t col_tile_start_byte, size_t matrix_offset)
     {
-        const size_t matrix_offset = expert * num_rows * col_bytes;
-        for (size_t row_tile_start = 0; row_tile_start < num_rows; row_tile_start += M_TILE_L1)
+        const int row_limit = std::min(row_tile_start + M_TILE_L1, num_rows);
+        const int col_limit = std::min(col_tile_start_byte + N_TILE_L1, col_bytes);
+
+        for (int ii = 0; ii < M_TILE_L1; ++ii)
         {
-            for (size_t col_tile_start_byte = 0; col_tile_start_byte < col_bytes; col_tile_start_byte += N_TILE_L1)
+            const int row = row_tile_start + ii;
+
+            for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
             {
+                const int col = col_tile_start_byte + jj;
 
-                const int row_limit = std::min(row_tile_start + M_TILE_L1, num_rows);
-                const int col_limit = std::min(col_tile_start_byte + N_TILE_L1, col_bytes);
+                const size_t logical_src_offset = matrix_offset + row * col_bytes + col;
 
-                for (int ii = 0; ii < M_TILE_L1; ++ii)
+                if (row < row_limit && col < col_limit)
                 {
-                    const int row = row_tile_start + ii;
-
-                    for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
+                    for (int v = 0; v < VECTOR_WIDTH; ++v)
                     {
-                        const int col = col_tile_start_byte + jj;
-
-                        const size_t logical_src_offset = matrix_offset + row * col_bytes + col;
-
-                        if (row < row_limit && col < col_limit)
-                        {
-                            for (int v = 0; v < VECTOR_WIDTH; ++v)
-                            {
-                                cache_buf[ii][jj + v] = input_byte_ptr[logical_src_offset + v];
-                            }
-                        }
+                        cache_buf[ii][jj + v] = input_byte_ptr[logical_src_offset + v];
                     }
                 }
+            }
+        }
 
-                if (quant_type == QuantType::INT8_WEIGHT_ONLY)
+        if (quant_type == QuantType::INT8_WEIGHT_ONLY)
+        {
+            for (int ii = 0; ii < M_TILE_L1; ++ii)
+            {
+                for (int jj = ii + 1; jj < N_TILE_L1; ++jj)
                 {
-                    for (int ii = 0; ii < M_TILE_L1; ++ii)
-                    {
-                        for (int jj = ii + 1; jj < N_TILE_L1; ++jj)
-                        {
-                            std::swap(cache_buf[ii][jj], cache_buf[jj][ii]);
-                        }
-                    }
+                    std::swap(cache_buf[ii][jj], cache_buf[jj][ii]);
                 }
-                else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
-                {
+            }
+        }
+        else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
+        {
 
-                    for (int ii = 0; ii < M_TILE_L1; ++ii)
-                    {
-                        // Using M_TILE_L1 here is deliberate since we assume that the cache tile
-                        // is square in the number of elements (not necessarily the number of bytes).
-                        for (int jj = ii + 1; jj < M_TILE_L1; ++jj)
-                        {
-                            const int ii_byte = ii / ELTS_PER_BYTE;
-                            const int ii_bit_offset = ii % ELTS_PER_BYTE;
+            for (int ii = 0; ii < M_TILE_L1; ++ii)
+            {
+                // Using M_TILE_L1 here is deliberate since we assume that the cache tile
+                // is square in the number of elements (not necessarily the number of bytes).
+                for (int jj = ii + 1; jj < M_TILE_L1; ++jj)
+                {
+                    const int ii_byte = ii / ELTS_PER_BYTE;
+                    const int ii_bit_offset = ii % ELTS_PER_BYTE;
 
-                            const int jj_byte = jj / ELTS_PER_BYTE;
-                            const int jj_bit_offset = jj % ELTS_PER_BYTE;
+                    const int jj_byte = jj / ELTS_PER_BYTE;
+                    const int jj_bit_offset = jj % ELTS_PER_BYTE;
 
-                            uint8_t src_elt = 0xF & (cache_buf[ii][jj_byte] >> (4 * jj_bit_offset));
-                            uint8_t tgt_elt = 0xF & (cache_buf[jj][ii_byte] >> (4 * ii_bit_offset));
+                    uint8_t src_elt = 0xF & (cache_buf[ii][jj_byte] >> (4 * jj_bit_offset));
+                    uint8_t tgt_elt = 0xF & (cache_buf[jj][ii_byte] >> (4 * ii_bit_offset));
 
-                            cache_buf[ii][jj_byte] &= (0xF0 >> (4 * jj_bit_offset));
-                            cache_buf[jj][ii_byte] &= (0xF0 >> (4 * ii_bit_offset));
+                    cache_buf[ii][jj_byte] &= (0xF0 >> (4 * jj_bit_offset));
+                    cache_buf[jj][ii_byte] &= (0xF0 >> (4 * ii_bit_offset));
 
-                            cache_buf[ii][jj_byte] |= (tgt_elt << (4 * jj_bit_offset));
-                            cache_buf[jj][ii_byte] |= (src_elt << (4 * ii_bit_offset));
-                        }
-                    }
-                }
-                else
-                {
-                    TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type.");
+                    cache_buf[ii][jj_byte] |= (tgt_elt << (4 * jj_bit_offset));
+                    cache_buf[jj][ii_byte] |= (src_elt << (4 * ii_bit_offset));
                 }
+            }
+        }
+        else
+        {
+            TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type.");
+        }
 
-                const size_t row_tile_start_trans = col_tile_start_byte * ELTS_PER_BYTE;
-                const size_t col_tile_start_byte_trans = row_tile_start / ELTS_PER_BYTE;
+        const size_t row_tile_start_trans = col_tile_start_byte * ELTS_PER_BYTE;
+        const size_t col_tile_start_byte_trans = row_tile_start / ELTS_PER_BYTE;
 
-                const int row_limit_trans = std::min(row_tile_start_trans + M_TILE_L1, num_cols);
-                const int col_limit_trans = std::min(col_tile_start_byte_trans + N_TILE_L1, col_bytes_trans);
+        const int row_limit_trans = std::min(row_tile_start_trans + M_TILE_L1, num_cols);
+        const int col_limit_trans = std::min(col_tile_start_byte_trans + N_TILE_L1, col_bytes_trans);
 
-                for (int ii = 0; ii < M_TILE_L1; ++ii)
-                {
-                    const int row = row_tile_start_trans + ii;
-                    for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
-                    {
-                        const int col = col_tile_start_byte_trans + jj;
+        for (int ii = 0; ii < M_TILE_L1; ++ii)
+        {
+            const int row = row_tile_start_trans + ii;
+            for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
+            {
+                const int col = col_tile_start_byte_trans + jj;
 
-                        const size_t logical_tgt_offset = matrix_offset + row * col_bytes_trans + col;
+                const size_t logical_tgt_offset = matrix_offset + row * col_bytes_trans + col;
 
-                        if (row < row_limit_trans && col < col_limit_trans)
-                        {
-                            for (int v = 0; v < VECTOR_WIDTH; ++v)
-                            {
-                                output_byte_ptr[logical_tgt_offset + v] = cache_buf[ii][jj + v];
-                            }
-                        }
+                if (row < row_limit_trans && col < col_limit_trans)
+                {
+                    for (int v = 0; v < VECTOR_WIDTH; ++v)
+                    {
+                        output_byte_ptr[logical_tgt_offset + v] = cache_buf[ii][jj + v];
                     }
                 }
             }
         }
-    }
+    };
+
+    const int num_m_tiles = (num_rows + M_TILE_L1 - 1) / M_TILE_L1;
+
+    // Each thread transposes whole rows of tiles, through its own cache buffer.
+    const size_t min_row_tiles_per_thread = kMinBytesPerThread / std::max<size_t>(M_TILE_L1 * col_bytes, 1);
+    parallel_for(num_experts * num_m_tiles, min_row_tiles_per_thread,
+        [&](size_t begin, size_t end)
+        {
+            uint8_t cache_buf[M_TILE_L1][N_TILE_L1];
+            for (size_t row_tile_idx = begin; row_tile_idx < end; ++row_tile_idx)
+            {
+                const size_t expert = row_tile_idx / num_m_tiles;
+                const size_t matrix_offset = expert * num_rows * col_bytes;
+                const size_t row_tile_start = (row_tile_idx % num_m_tiles) * M_TILE_L1;
+                for (size_t col_tile_start_byte = 0; col_tile_start_byte < col_bytes; col_tile_start_byte += N_TILE_L1)
+                {
+                    transpose_tile(cache_buf, row_tile_start, col_tile_start_byte, matrix_offset);
+                }
+            }
+        });
 }
 
 void subbyte_transpose(int8_t* transposed_quantized_tensor, const int8_t* quantized_tensor,
@@ -385,10 +468,14 @@ void subbyte_transpose(int8_t* transposed_quantized_tensor, const int8_t* quanti
 
 void add_bias_and_interleave_int8s_inplace(int8_t* int8_tensor, const size_t num_elts)
 {
-    for (int ii = 0; ii < num_elts; ++ii)
-    {
-        int8_tensor[ii] = int8_t(int(int8_tensor[ii]) + 128);
-    }
+    parallel_for(num_elts, kMinBytesPerThread,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t ii = begin; ii < end; ++ii)
+            {
+                int8_tensor[ii] = int8_t(int(int8_tensor[ii]) + 128);
+            }
+        });
 
     // Step 2 will transform the layout of a 32-bit register in CUDA in order to match the int4 layout. This has no
     // performance benefit and is purely so that int4 and int8 have the same layout.
@@ -401,10 +488,14 @@ void add_bias_and_interleave_int8s_inplace(int8_t* int8_tensor, const size_t num
     //      [elt_3  elt_1  elt_2  elt_0] (each elt occupies 8 bits)
 
     TLLM_CHECK_WITH_INFO(num_elts % 4 == 0, "Dimensions of int8 tensor must be a multiple of 4 for register relayout");
-    for (size_t base = 0; base < num_elts; base += 4)
-    {
-        std::swap(int8_tensor[base + 1], int8_tensor[base + 2]);
-    }
+    parallel_for(num_elts / 4, kMinBytesPerThread / 4,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t base = 4 * begin; base < 4 * end; base += 4)
+            {
+                std::swap(int8_tensor[base + 1], int8_tensor[base + 2]);
+            }
+        });
 }
 
 void add_bias_and_interleave_int4s_inplace(int8_t* packed_int4_tensor, const size_t num_elts)
@@ -413,23 +504,27 @@ void add_bias_and_interleave_int4s_inplace(int8_t* packed_int4_tensor, const siz
 
     // Step 1 will be to transform all the int4s to unsigned in order to make the dequantize take as little
     // instructions as possible in the CUDA code.
-    for (size_t ii = 0; ii < num_bytes; ++ii)
-    {
-        int8_t transformed_packed_int4s = 0;
-        int8_t transformed_first_elt
-            = (int8_t(packed_int4_tensor[ii] << 4) >> 4) + 8; // The double shift here is to ensure sign extension
-        int8_t transformed_second_elt = (packed_int4_tensor[ii] >> 4) + 8;
-
-        TLLM_CHECK_WITH_INFO(
-            transformed_first_elt >= 0 && transformed_first_elt <= 15, "Illegal result for int4 transform (first elt)");
-        TLLM_CHECK_WITH_INFO(transformed_second_elt >= 0 && transformed_second_elt <= 15,
-            "Illegal result for int4 transform (second elt)");
-
-        // We don't need to mask in these ops since everything should be in the range 0-15
-        transformed_packed_int4s |= transformed_first_elt;
-        transformed_packed_int4s |= (transformed_second_elt << 4);
-        packed_int4_tensor[ii] = transformed_packed_int4s;
-    }
+    parallel_for(num_bytes, kMinBytesPerThread,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t ii = begin; ii < end; ++ii)
+            {
+                int8_t transformed_packed_int4s = 0;
+                int8_t transformed_first_elt = (int8_t(packed_int4_tensor[ii] << 4) >> 4)
+                    + 8; // The double shift here is to ensure sign extension
+                int8_t transformed_second_elt = (packed_int4_tensor[ii] >> 4) + 8;
+
+                TLLM_CHECK_WITH_INFO(transformed_first_elt >= 0 && transformed_first_elt <= 15,
+                    "Illegal result for int4 transform (first elt)");
+                TLLM_CHECK_WITH_INFO(transformed_second_elt >= 0 && transformed_second_elt <= 15,
+                    "Illegal result for int4 transform (second elt)");
+
+                // We don't need to mask in these ops since everything should be in the range 0-15
+                transformed_packed_int4s |= transformed_first_elt;
+                transformed_packed_int4s |= (transformed_second_elt << 4);
+                packed_int4_tensor[ii] = transformed_packed_int4s;
+            }
+        });
 
     // Step 2 will transform the layout of a 32-bit register in CUDA in order to minimize the number of shift & logical
     // instructions That are needed to extract the int4s in the GEMM main loop. Pictorially, the loop below will do the
@@ -444,22 +539,26 @@ void add_bias_and_interleave_int4s_inplace(int8_t* packed_int4_tensor, const siz
     const size_t num_registers = num_bytes / 4;
 
     uint32_t* register_ptr = reinterpret_cast<uint32_t*>(packed_int4_tensor);
-    for (size_t ii = 0; ii < num_registers; ++ii)
-    {
-        const uint32_t current_register = register_ptr[ii];
-        uint32_t transformed_register = 0;
-
-        for (int dest_idx = 0; dest_idx < 8; ++dest_idx)
+    parallel_for(num_registers, kMinBytesPerThread / 4,
+        [&](size_t begin, size_t end)
         {
-            const int src_idx = dest_idx < 4 ? 2 * dest_idx : 2 * (dest_idx - 4) + 1;
-            const int src_shift = 4 * src_idx;
-            const int dest_shift = 4 * dest_idx;
+            for (size_t ii = begin; ii < end; ++ii)
+            {
+                const uint32_t current_register = register_ptr[ii];
+                uint32_t transformed_register = 0;
 
-            const uint32_t src_bits = (current_register >> src_shift) & 0xF;
-            transformed_register |= (src_bits << dest_shift);
-        }
-        register_ptr[ii] = transformed_register;
-    }
+                for (int dest_idx = 0; dest_idx < 8; ++dest_idx)
+                {
+                    const int src_idx = dest_idx < 4 ? 2 * dest_idx : 2 * (dest_idx - 4) + 1;
+                    const int src_shift = 4 * src_idx;
+                    const int dest_shift = 4 * dest_idx;
+
+                    const uint32_t src_bits = (current_register >> src_shift) & 0xF;
+                    transformed_register |= (src_bits << dest_shift);
+                }
+                register_ptr[ii] = transformed_register;
+            }
+        });
 }
 
 void add_bias_and_interleave_quantized_tensor_inplace(int8_t* tensor, const size_t num_elts, QuantType quant_type)
@@ -508,28 +607,33 @@ void interleave_column_major_tensor(int8_t* interleaved_quantized_tensor, const
     const int vec_rows_per_tile = rows_per_tile / elts_in_int32;
     const int interleave = details.columns_interleaved;
 
-    for (int expert = 0; expert < num_experts; ++expert)
-    {
-        const int64_t matrix_offset = expert * int64_t(num_vec_rows) * int64_t(num_cols);
-        for (int read_col = 0; read_col < num_cols; ++read_col)
+    // Each thread reads whole columns.
+    const size_t min_cols_per_thread = kMinBytesPerThread / std::max<size_t>(num_vec_rows * sizeof(uint32_t), 1);
+    parallel_for(num_experts * num_cols, min_cols_per_thread,
+        [&](size_t begin, size_t end)
         {
-            const int64_t write_col = read_col / interleave;
-            for (int base_vec_row = 0; base_vec_row < num_vec_rows; base_vec_row += vec_rows_per_tile)
+            for (size_t col_idx = begin; col_idx < end; ++col_idx)
             {
-                for (int vec_read_row = base_vec_row;
-                     vec_read_row < std::min(num_vec_rows, base_vec_row + vec_rows_per_tile); ++vec_read_row)
+                const int64_t expert = col_idx / num_cols;
+                const int64_t matrix_offset = expert * int64_t(num_vec_rows) * int64_t(num_cols);
+                const int read_col = col_idx % num_cols;
+                const int64_t write_col = read_col / interleave;
+                for (int base_vec_row = 0; base_vec_row < num_vec_rows; base_vec_row += vec_rows_per_tile)
                 {
-                    const int64_t vec_write_row = interleave * base_vec_row
-                        + vec_rows_per_tile * (read_col % interleave) + vec_read_row % vec_rows_per_tile;
+                    for (int vec_read_row = base_vec_row;
+                         vec_read_row < std::min(num_vec_rows, base_vec_row + vec_rows_per_tile); ++vec_read_row)
+                    {
+                        const int64_t vec_write_row = interleave * base_vec_row
+                            + vec_rows_per_tile * (read_col % interleave) + vec_read_row % vec_rows_per_tile;
 
-                    const int64_t read_offset = matrix_offset + int64_t(read_col) * num_vec_rows + vec_read_row;
-                    const int64_t write_offset
-                        = matrix_offset + int64_t(write_col) * num_vec_rows * interleave + vec_write_row;
-                    output_byte_ptr[write_offset] = input_byte_ptr[read_offset];
+                        const int64_t read_offset = matrix_offset + int64_t(read_col) * num_vec_rows + vec_read_row;
+                        const int64_t write_offset
+                            = matrix_offset + int64_t(write_col) * num_vec_rows * interleave + vec_write_row;
+                        output_byte_ptr[write_offset] = input_byte_ptr[read_offset];
+                    }
                 }
             }
-        }
-    }
+        });
 }
 
 void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, const int8_t* row_major_quantized_weight,
@@ -583,6 +687,93 @@ void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, co
     std::copy(src_buf.begin(), src_buf.end(), preprocessed_quantized_weight);
 }
 
+size_t get_preprocess_weights_for_mixed_gemm_cuda_workspace_size(
+    const std::vector<size_t>& shape, QuantType quant_type)
+{
+    TLLM_CHECK_WITH_INFO(shape.size() == 2 || shape.size() == 3, "Shape must be 2-D or 3-D");
+    size_t num_elts = 1;
+    for (const auto& dim : shape)
+    {
+        num_elts *= dim;
+    }
+    return num_elts * get_bits_in_quant_type(quant_type) / 8;
+}
+
+void preprocess_weights_for_mixed_gemm_cuda(int8_t* preprocessed_quantized_weight,
+    const int8_t* row_major_quantized_weight, void* workspace, const std::vector<size_t>& shape, QuantType quant_type,
+    cudaStream_t stream, bool force_interleave)
+{
+    int arch = getSMVersion();
+    if (force_interleave && arch == 90)
+    {
+        // Workaround for MOE which doesn't have specialised Hopper kernels yet
+        arch = 80;
+    }
+    LayoutDetails details = getLayoutDetailsForTransform(quant_type, arch);
+
+    TLLM_CHECK_WITH_INFO(shape.size() == 2 || shape.size() == 3, "Shape must be 2-D or 3-D");
+
+    size_t num_elts = 1;
+    for (const auto& dim : shape)
+    {
+        num_elts *= dim;
+    }
+
+    const size_t num_bytes = num_elts * get_bits_in_quant_type(quant_type) / 8;
+
+    // The same steps as on the host. The out of place steps alternate between the output and the workspace, starting
+    // with the one that makes the last step write the output.
+    const bool permute_rows = details.uses_imma_ldsm;
+    const bool transpose = details.layoutB == LayoutDetails::Layout::COLUMN_MAJOR;
+    const bool interleave = details.columns_interleaved > 1;
+    const int num_steps = int(permute_rows) + int(transpose) + int(interleave);
+    TLLM_CHECK_WITH_INFO(num_steps < 2 || workspace != nullptr, "Preprocessing the weights needs a workspace");
+    int8_t* buffers[2] = {preprocessed_quantized_weight, static_cast<int8_t*>(workspace)};
+    int next_buffer = num_steps % 2 == 1 ? 0 : 1;
+    const auto next_dst = [&]()
+    {
+        int8_t* dst = buffers[next_buffer];
+        next_buffer ^= 1;
+        return dst;
+    };
+
+    const int8_t* src = row_major_quantized_weight;
+    if (num_steps == 0)
+    {
+        check_cuda_error(
+            cudaMemcpyAsync(preprocessed_quantized_weight, src, num_bytes, cudaMemcpyDeviceToDevice, stream));
+    }
+
+    // Works on row major data, so issue this permutation first.
+    if (permute_rows)
+    {
+        int8_t* dst = next_dst();
+        permute_B_rows_for_mixed_gemm_cuda(dst, src, shape, quant_type, arch, stream);
+        src = dst;
+    }
+
+    if (transpose)
+    {
+        int8_t* dst = next_dst();
+        subbyte_transpose_cuda(dst, src, shape, quant_type, stream);
+        src = dst;
+    }
+
+    if (interleave)
+    {
+        int8_t* dst = next_dst();
+        interleave_column_major_tensor_cuda(
+            dst, src, shape, quant_type, details.rows_per_column_tile, details.columns_interleaved, stream);
+        src = dst;
+    }
+
+    if (arch >= 70 && arch < 90)
+    {
+        add_bias_and_interleave_quantized_tensor_inplace_cuda(
+            preprocessed_quantized_weight, num_elts, quant_type, stream);
+    }
+}
+
 /*
     Arguments:
       input_weight_ptr - the weight tensor to be quantized. Must be 2-D or 3-D and of type FP16.
@@ -649,25 +840,75 @@ void symmetric_quantize(int8_t* processed_quantized_weight, int8_t* unprocessed_
 
     std::vector<float> per_col_max(num_cols);
 
-    for (int expert = 0; expert < num_experts; ++expert)
+    const auto quantize_row = [&](int8_t* current_quantized_weight_row, const WeightType* current_weight_row)
     {
-        const WeightType* current_weight = input_weight_ptr + expert * input_mat_size;
-        int8_t* current_quantized_weight = unprocessed_quantized_weight + expert * quantized_mat_size;
-
-        // First we find the per column max for this expert weight.
-        for (int jj = 0; jj < num_cols; ++jj)
+        for (int jj = 0; jj < bytes_per_out_col; ++jj)
         {
-            per_col_max[jj] = 0.f;
-        }
 
-        for (int ii = 0; ii < num_rows; ++ii)
-        {
-            const WeightType* current_weight_row = current_weight + ii * num_cols;
-            for (int jj = 0; jj < num_cols; ++jj)
+            if (quant_type == QuantType::INT8_WEIGHT_ONLY)
             {
-                per_col_max[jj] = std::max(per_col_max[jj], std::abs(float(current_weight_row[jj])));
+                const float col_scale = per_col_max[jj];
+                const float weight_elt = float(current_weight_row[jj]);
+                const float scaled_weight = round(weight_elt / col_scale);
+                const int8_t clipped_weight = int8_t(std::max(-128.f, std::min(127.f, scaled_weight)));
+                current_quantized_weight_row[jj] = clipped_weight;
+            }
+            else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
+            {
+
+                // We will pack two int4 elements per iteration of the inner loop.
+                int8_t packed_int4s = 0;
+                for (int packed_idx = 0; packed_idx < 2; ++packed_idx)
+                {
+                    const int input_idx = 2 * jj + packed_idx;
+                    if (input_idx < num_cols)
+                    {
+                        const float col_scale = per_col_max[input_idx];
+                        const float weight_elt = float(current_weight_row[input_idx]);
+                        const float scaled_weight = round(weight_elt / col_scale);
+                        int int_weight = int(scaled_weight);
+                        const int8_t clipped_weight = std::max(-8, std::min(7, int_weight));
+
+                        // Kill the sign extension bits (hence 0x0F mask) then shift to upper bits
+                        // if packing the second int4 and or the bits into the final result.
+                        packed_int4s |= ((clipped_weight & 0x0F) << (4 * packed_idx));
+                    }
+                }
+                current_quantized_weight_row[jj] = packed_int4s;
+            }
+            else
+            {
+                TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type");
             }
         }
+    };
+
+    for (int expert = 0; expert < num_experts; ++expert)
+    {
+        const WeightType* current_weight = input_weight_ptr + expert * input_mat_size;
+        int8_t* current_quantized_weight = unprocessed_quantized_weight + expert * quantized_mat_size;
+
+        // First we find the per column max for this expert weight. Each thread reduces a range of columns over all
+        // the rows.
+        const size_t min_cols_per_thread
+            = kMinBytesPerThread / std::max<size_t>(num_rows * sizeof(WeightType), 1) + 1;
+        parallel_for(num_cols, min_cols_per_thread,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t jj = begin; jj < end; ++jj)
+                {
+                    per_col_max[jj] = 0.f;
+                }
+
+                for (int ii = 0; ii < num_rows; ++ii)
+                {
+                    const WeightType* current_weight_row = current_weight + ii * num_cols;
+                    for (size_t jj = begin; jj < end; ++jj)
+                    {
+                        per_col_max[jj] = std::max(per_col_max[jj], std::abs(float(current_weight_row[jj])));
+                    }
+                }
+            });
 
         // Then, we construct the scales
         ComputeType* current_scales = scale_ptr + expert * num_cols;
@@ -677,51 +918,16 @@ void symmetric_quantize(int8_t* processed_quantized_weight, int8_t* unprocessed_
             current_scales[jj] = ComputeType(per_col_max[jj]);
         }
 
-        // Finally, construct the weights.
-        for (int ii = 0; ii < num_rows; ++ii)
-        {
-            int8_t* current_quantized_weight_row = current_quantized_weight + ii * bytes_per_out_col;
-            const WeightType* current_weight_row = current_weight + ii * num_cols;
-            for (int jj = 0; jj < bytes_per_out_col; ++jj)
+        // Finally, construct the weights. Each thread quantizes whole rows.
+        const size_t min_rows_per_thread = kMinBytesPerThread / std::max<size_t>(num_cols * sizeof(WeightType), 1);
+        parallel_for(num_rows, min_rows_per_thread,
+            [&](size_t begin, size_t end)
             {
-
-                if (quant_type == QuantType::INT8_WEIGHT_ONLY)
-                {
-                    const float col_scale = per_col_max[jj];
-                    const float weight_elt = float(current_weight_row[jj]);
-                    const float scaled_weight = round(weight_elt / col_scale);
-                    const int8_t clipped_weight = int8_t(std::max(-128.f, std::min(127.f, scaled_weight)));
-                    current_quantized_weight_row[jj] = clipped_weight;
-                }
-                else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
+                for (size_t ii = begin; ii < end; ++ii)
                 {
-
-                    // We will pack two int4 elements per iteration of the inner loop.
-                    int8_t packed_int4s = 0;
-                    for (int packed_idx = 0; packed_idx < 2; ++packed_idx)
-                    {
-                        const int input_idx = 2 * jj + packed_idx;
-                        if (input_idx < num_cols)
-                        {
-                            const float col_scale = per_col_max[input_idx];
-                            const float weight_elt = float(current_weight_row[input_idx]);
-                            const float scaled_weight = round(weight_elt / col_scale);
-                            int int_weight = int(scaled_weight);
-                            const int8_t clipped_weight = std::max(-8, std::min(7, int_weight));
-
-                            // Kill the sign extension bits (hence 0x0F mask) then shift to upper bits
-                            // if packing the second int4 and or the bits into the final result.
-                            packed_int4s |= ((clipped_weight & 0x0F) << (4 * packed_idx));
-                        }
-                    }
-                    current_quantized_weight_row[jj] = packed_int4s;
-                }
-                else
-                {
-                    TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type");
+                    quantize_row(current_quantized_weight + ii * bytes_per_out_col, current_weight + ii * num_cols);
                 }
-            }
-        }
+            });
     }
 
     preprocess_weights_for_mixed_gemm(
@@ -772,6 +978,165 @@ template void symmetric_quantize<__nv_bfloat16, float>(
     int8_t*, __nv_bfloat16*, const float*, const std::vector<size_t>&, QuantType, bool);
 #endif
 
+namespace
+{
+void get_low_bit_shape(const std::vector<size_t>& shape, QuantType quant_type, size_t& num_rows, size_t& num_cols)
+{
+    TLLM_CHECK_WITH_INFO(is_low_bit_quant_type(quant_type), "Not a sub-4-bit quantization type");
+    TLLM_CHECK_WITH_INFO(shape.size() == 2, "Shape must be 2-D");
+    num_rows = shape[0];
+    num_cols = shape[1];
+    TLLM_CHECK_WITH_INFO(num_rows % kernels::kLowBitPackSize == 0, "Rows (%zu) must be a multiple of %d", num_rows,
+        kernels::kLowBitPackSize);
+}
+} // namespace
+
+size_t get_low_bit_packed_weight_size(const std::vector<size_t>& shape, QuantType quant_type)
+{
+    size_t num_rows, num_cols;
+    get_low_bit_shape(shape, quant_type, num_rows, num_cols);
+    return num_rows * num_cols * get_bits_in_quant_type(quant_type) / 8;
+}
+
+void pack_weights_for_low_bit_gemv(
+    int8_t* packed_weight, const uint8_t* codes, const std::vector<size_t>& shape, QuantType quant_type)
+{
+    size_t num_rows, num_cols;
+    get_low_bit_shape(shape, quant_type, num_rows, num_cols);
+    const int bits = get_bits_in_quant_type(quant_type);
+    const size_t num_packs = num_rows / kernels::kLowBitPackSize;
+    uint32_t* output_word_ptr = reinterpret_cast<uint32_t*>(packed_weight);
+
+    // Each thread packs whole rows of packs, reading the codes row by row and scattering the words of every column.
+    const size_t min_packs_per_thread
+        = kMinBytesPerThread / std::max<size_t>(kernels::kLowBitPackSize * num_cols, 1);
+    parallel_for(num_packs, min_packs_per_thread,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<uint32_t> words(num_cols * bits);
+            for (size_t pack = begin; pack < end; ++pack)
+            {
+                std::fill(words.begin(), words.end(), 0u);
+                for (int ii = 0; ii < kernels::kLowBitPackSize; ++ii)
+                {
+                    const uint8_t* row = codes + (pack * kernels::kLowBitPackSize + ii) * num_cols;
+                    for (size_t jj = 0; jj < num_cols; ++jj)
+                    {
+                        const uint32_t code = row[jj];
+                        TLLM_CHECK_WITH_INFO(code >> bits == 0, "Code %u does not fit in %d bits", code, bits);
+                        for (int bit = 0; bit < bits; ++bit)
+                        {
+                            words[jj * bits + bit] |= ((code >> bit) & 1u) << ii;
+                        }
+                    }
+                }
+                for (size_t jj = 0; jj < num_cols; ++jj)
+                {
+                    std::copy_n(&words[jj * bits], bits, output_word_ptr + (jj * num_packs + pack) * bits);
+                }
+            }
+        });
+}
+
+template <typename ComputeType, typename WeightType>
+void groupwise_quantize_low_bit(int8_t* packed_weight, uint8_t* codes, ComputeType* scale_ptr,
+    const WeightType* input_weight_ptr, const std::vector<size_t>& shape, QuantType quant_type, int group_size)
+{
+    TLLM_CHECK_WITH_INFO(packed_weight, "Packed tensor is NULL");
+    TLLM_CHECK_WITH_INFO(scale_ptr, "Scale output pointer is NULL");
+    TLLM_CHECK_WITH_INFO(input_weight_ptr, "Input weight pointer is NULL");
+
+    size_t num_rows, num_cols;
+    get_low_bit_shape(shape, quant_type, num_rows, num_cols);
+    TLLM_CHECK_WITH_INFO(group_size > 0 && num_rows % group_size == 0,
+        "Rows (%zu) must be a multiple of the group size (%d)", num_rows, group_size);
+
+    std::vector<uint8_t> code_buf;
+    if (codes == nullptr)
+    {
+        code_buf.resize(num_rows * num_cols);
+        codes = code_buf.data();
+    }
+
+    // NF4 scales the weights to [-1, 1] and takes the closest value of the table. The integer types are quantized as
+    // in symmetric_quantize, to [-2^(bits-1), 2^(bits-1) - 1], and biased to unsigned codes.
+    const bool is_nf4 = quant_type == QuantType::PACKED_NF4_WEIGHT_ONLY;
+    const int half_range = 1 << (get_bits_in_quant_type(quant_type) - 1);
+    const float quant_range_scale = is_nf4 ? 1.f : 1.f / float(half_range);
+
+    // Each thread quantizes whole groups of rows.
+    const size_t num_groups = num_rows / group_size;
+    const size_t min_groups_per_thread
+        = kMinBytesPerThread / std::max<size_t>(group_size * num_cols * sizeof(WeightType), 1);
+    parallel_for(num_groups, min_groups_per_thread,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<float> inv_scales(num_cols);
+            for (size_t group = begin; group < end; ++group)
+            {
+                const size_t first_row = group * group_size;
+                for (size_t jj = 0; jj < num_cols; ++jj)
+                {
+                    float col_max = 0.f;
+                    for (int ii = 0; ii < group_size; ++ii)
+                    {
+                        const float weight_elt = float(input_weight_ptr[(first_row + ii) * num_cols + jj]);
+                        col_max = std::max(col_max, std::abs(weight_elt));
+                    }
+                    const float scale = col_max * quant_range_scale;
+                    scale_ptr[group * num_cols + jj] = ComputeType(scale);
+                    inv_scales[jj] = scale > 0.f ? 1.f / scale : 0.f;
+                }
+
+                for (int ii = 0; ii < group_size; ++ii)
+                {
+                    const size_t row_offset = (first_row + ii) * num_cols;
+                    for (size_t jj = 0; jj < num_cols; ++jj)
+                    {
+                        const float scaled_weight = float(input_weight_ptr[row_offset + jj]) * inv_scales[jj];
+                        int code = 0;
+                        if (is_nf4)
+                        {
+                            for (int candidate = 1; candidate < 16; ++candidate)
+                            {
+                                if (std::abs(kernels::nf4_value(candidate) - scaled_weight)
+                                    < std::abs(kernels::nf4_value(code) - scaled_weight))
+                                {
+                                    code = candidate;
+                                }
+                            }
+                        }
+                        else
+                        {
+                            const int int_weight = int(std::round(scaled_weight));
+                            code = std::max(-half_range, std::min(half_range - 1, int_weight)) + half_range;
+                        }
+                        codes[row_offset + jj] = uint8_t(code);
+                    }
+                }
+            }
+        });
+
+    pack_weights_for_low_bit_gemv(packed_weight, codes, shape, quant_type);
+}
+
+template void groupwise_quantize_low_bit<float, float>(
+    int8_t*, uint8_t*, float*, const float*, const std::vector<size_t>&, QuantType, int);
+
+template void groupwise_quantize_low_bit<half, float>(
+    int8_t*, uint8_t*, half*, const float*, const std::vector<size_t>&, QuantType, int);
+
+template void groupwise_quantize_low_bit<half, half>(
+    int8_t*, uint8_t*, half*, const half*, const std::vector<size_t>&, QuantType, int);
+
+#ifdef ENABLE_BF16
+template void groupwise_quantize_low_bit<__nv_bfloat16, __nv_bfloat16>(
+    int8_t*, uint8_t*, __nv_bfloat16*, const __nv_bfloat16*, const std::vector<size_t>&, QuantType, int);
+
+template void groupwise_quantize_low_bit<__nv_bfloat16, float>(
+    int8_t*, uint8_t*, __nv_bfloat16*, const float*, const std::vector<size_t>&, QuantType, int);
+#endif
+
 } // namespace cutlass_kernels
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaBf16Wrapper.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
+
+#include <algorithm>
+
+using namespace tensorrt_llm::common;
+
+// The kernels below compute the same layouts as the host functions in cutlass_preprocessors.cpp, one thread per
+// output word or byte, so the result does not depend on the order in which the work is done.
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+namespace
+{
+
+constexpr int kThreadsPerBlock = 256;
+// The grid-stride kernels do not need more blocks than this to fill any GPU.
+constexpr int64_t kMaxBlocks = 1 << 16;
+
+struct MatrixShape
+{
+    size_t num_experts;
+    size_t num_rows;
+    size_t num_cols;
+};
+
+MatrixShape get_matrix_shape(const std::vector<size_t>& shape)
+{
+    TLLM_CHECK_WITH_INFO(shape.size() == 2 || shape.size() == 3, "Shape must be 2-D or 3-D");
+    return MatrixShape{shape.size() == 2 ? 1 : shape[0], shape.size() == 2 ? shape[0] : shape[1],
+        shape.size() == 2 ? shape[1] : shape[2]};
+}
+
+int get_num_blocks(int64_t num_threads)
+{
+    return static_cast<int>(std::min((num_threads + kThreadsPerBlock - 1) / kThreadsPerBlock, kMaxBlocks));
+}
+
+__global__ void permute_B_rows_kernel(uint32_t* output, const uint32_t* input, int64_t num_words, int num_rows,
+    int num_vec_cols, int b_rows_per_mma, int elts_per_reg)
+{
+    for (int64_t idx = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; idx < num_words;
+         idx += int64_t(gridDim.x) * blockDim.x)
+    {
+        const int write_col = idx % num_vec_cols;
+        const int64_t row_idx = idx / num_vec_cols;
+        const int write_row = row_idx % num_rows;
+        const int64_t matrix_offset = (row_idx - write_row) * num_vec_cols;
+
+        const int base_row = write_row / b_rows_per_mma * b_rows_per_mma;
+        const int tile_row = write_row % b_rows_per_mma;
+        const int tile_read_row = 8 * ((tile_row % elts_per_reg) / 2) + tile_row % 2 + 2 * (tile_row / elts_per_reg);
+        const int read_row = base_row + tile_read_row;
+
+        output[idx] = input[matrix_offset + int64_t(read_row) * num_vec_cols + write_col];
+    }
+}
+
+// Transposes tiles of kTileElts x kTileElts elements through shared memory, unpacked to one element per byte.
+constexpr int kTileElts = 64;
+
+template <int ELTS_PER_BYTE>
+__global__ void subbyte_transpose_kernel(
+    uint8_t* output, const uint8_t* input, int64_t num_rows, int64_t num_cols, int64_t matrix_bytes)
+{
+    static constexpr int TILE_BYTES = kTileElts / ELTS_PER_BYTE;
+    static constexpr int BITS_PER_ELT = 8 / ELTS_PER_BYTE;
+    static constexpr uint32_t ELT_MASK = (1u << BITS_PER_ELT) - 1;
+    // Padded so that the transposed reads hit different banks.
+    __shared__ uint8_t tile[kTileElts][kTileElts + 4];
+
+    const int64_t col_bytes = num_cols / ELTS_PER_BYTE;
+    const int64_t col_bytes_trans = num_rows / ELTS_PER_BYTE;
+    const int64_t tile_col_start = int64_t(blockIdx.x) * kTileElts;
+    const int64_t tile_row_start = int64_t(blockIdx.y) * kTileElts;
+    const int64_t matrix_offset = int64_t(blockIdx.z) * matrix_bytes;
+
+    for (int idx = threadIdx.x; idx < kTileElts * TILE_BYTES; idx += blockDim.x)
+    {
+        const int ii = idx / TILE_BYTES;
+        const int jj = idx % TILE_BYTES;
+        const int64_t row = tile_row_start + ii;
+        const int64_t col_byte = tile_col_start / ELTS_PER_BYTE + jj;
+        if (row < num_rows && col_byte < col_bytes)
+        {
+            const uint32_t packed = input[matrix_offset + row * col_bytes + col_byte];
+#pragma unroll
+            for (int elt = 0; elt < ELTS_PER_BYTE; ++elt)
+            {
+                tile[ii][jj * ELTS_PER_BYTE + elt] = (packed >> (BITS_PER_ELT * elt)) & ELT_MASK;
+            }
+        }
+    }
+    __syncthreads();
+
+    for (int idx = threadIdx.x; idx < kTileElts * TILE_BYTES; idx += blockDim.x)
+    {
+        const int ii = idx / TILE_BYTES;
+        const int jj = idx % TILE_BYTES;
+        const int64_t row = tile_col_start + ii;
+        const int64_t col_byte = tile_row_start / ELTS_PER_BYTE + jj;
+        if (row < num_cols && col_byte < col_bytes_trans)
+        {
+            uint32_t packed = 0;
+#pragma unroll
+            for (int elt = 0; elt < ELTS_PER_BYTE; ++elt)
+            {
+                packed |= uint32_t(tile[jj * ELTS_PER_BYTE + elt][ii]) << (BITS_PER_ELT * elt);
+            }
+            output[matrix_offset + row * col_bytes_trans + col_byte] = packed;
+        }
+    }
+}
+
+__global__ void interleave_column_major_kernel(uint32_t* output, const uint32_t* input, int64_t num_words,
+    int num_cols, int num_vec_rows, int vec_rows_per_tile, int interleave)
+{
+    for (int64_t idx = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; idx < num_words;
+         idx += int64_t(gridDim.x) * blockDim.x)
+    {
+        const int vec_read_row = idx % num_vec_rows;
+        const int64_t col_idx = idx / num_vec_rows;
+        const int read_col = col_idx % num_cols;
+        const int64_t matrix_offset = (col_idx - read_col) * num_vec_rows;
+
+        const int64_t write_col = read_col / interleave;
+        const int base_vec_row = vec_read_row / vec_rows_per_tile * vec_rows_per_tile;
+        const int64_t vec_write_row = interleave * base_vec_row + vec_rows_per_tile * (read_col % interleave)
+            + vec_read_row % vec_rows_per_tile;
+
+        output[matrix_offset + write_col * num_vec_rows * interleave + vec_write_row] = input[idx];
+    }
+}
+
+// Adding the bias 128 to int8 or 8 to int4 flips the sign bit of every element. The elements of each register are then
+// reordered to [elt_3 elt_1 elt_2 elt_0] for int8 and [elt_7 elt_5 elt_3 elt_1 elt_6 elt_4 elt_2 elt_0] for int4.
+template <QuantType quant_type>
+__global__ void add_bias_and_interleave_kernel(uint32_t* registers, int64_t num_registers)
+{
+    for (int64_t idx = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; idx < num_registers;
+         idx += int64_t(gridDim.x) * blockDim.x)
+    {
+        uint32_t transformed_register = 0;
+        if constexpr (quant_type == QuantType::INT8_WEIGHT_ONLY)
+        {
+            const uint32_t current_register = registers[idx] ^ 0x80808080u;
+            transformed_register = (current_register & 0xFF0000FFu) | ((current_register >> 8) & 0x0000FF00u)
+                | ((current_register << 8) & 0x00FF0000u);
+        }
+        else
+        {
+            const uint32_t current_register = registers[idx] ^ 0x88888888u;
+#pragma unroll
+            for (int dest_idx = 0; dest_idx < 8; ++dest_idx)
+            {
+                const int src_idx = dest_idx < 4 ? 2 * dest_idx : 2 * (dest_idx - 4) + 1;
+                transformed_register |= ((current_register >> (4 * src_idx)) & 0xFu) << (4 * dest_idx);
+            }
+        }
+        registers[idx] = transformed_register;
+    }
+}
+
+// The absolute maximum of each column over a range of kRowsPerColMaxBlock rows. The maxima are non-negative, so they
+// compare like their bits as integers.
+constexpr int kRowsPerColMaxBlock = 256;
+
+template <typename WeightType>
+__global__ void column_max_kernel(float* per_col_max, const WeightType* weight, int64_t num_rows, int64_t num_cols)
+{
+    const int64_t col = blockIdx.x * int64_t(blockDim.x) + threadIdx.x;
+    if (col >= num_cols)
+    {
+        return;
+    }
+    const int64_t expert = blockIdx.z;
+    const WeightType* current_weight = weight + expert * num_rows * num_cols;
+    const int64_t row_begin = int64_t(blockIdx.y) * kRowsPerColMaxBlock;
+    const int64_t row_end = row_begin + kRowsPerColMaxBlock < num_rows ? row_begin + kRowsPerColMaxBlock : num_rows;
+    float col_max = 0.f;
+    for (int64_t row = row_begin; row < row_end; ++row)
+    {
+        col_max = fmaxf(col_max, fabsf(cuda_cast<float>(current_weight[row * num_cols + col])));
+    }
+    atomicMax(reinterpret_cast<int*>(per_col_max + expert * num_cols + col), __float_as_int(col_max));
+}
+
+template <typename ComputeType>
+__global__ void compute_scales_kernel(
+    ComputeType* scales, float* per_col_max, int64_t num_scales, float quant_range_scale)
+{
+    for (int64_t idx = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; idx < num_scales;
+         idx += int64_t(gridDim.x) * blockDim.x)
+    {
+        const float col_scale = per_col_max[idx] * quant_range_scale;
+        per_col_max[idx] = col_scale;
+        scales[idx] = cuda_cast<ComputeType>(col_scale);
+    }
+}
+
+// Division and rounding are IEEE compliant regardless of --use_fast_math, to match the host.
+__device__ inline float quantize_elt(float weight_elt, float col_scale)
+{
+    return roundf(__fdiv_rn(weight_elt, col_scale));
+}
+
+template <typename WeightType, QuantType quant_type>
+__global__ void symmetric_quantize_kernel(int8_t* quantized_weight, const WeightType* weight,
+    const float* per_col_max, int64_t num_bytes, int64_t num_rows, int64_t num_cols, int64_t bytes_per_out_col)
+{
+    for (int64_t idx = blockIdx.x * int64_t(blockDim.x) + threadIdx.x; idx < num_bytes;
+         idx += int64_t(gridDim.x) * blockDim.x)
+    {
+        const int64_t out_col = idx % bytes_per_out_col;
+        const int64_t row_idx = idx / bytes_per_out_col;
+        const int64_t expert = row_idx / num_rows;
+        const WeightType* weight_row = weight + row_idx * num_cols;
+        const float* col_scales = per_col_max + expert * num_cols;
+
+        if constexpr (quant_type == QuantType::INT8_WEIGHT_ONLY)
+        {
+            const float scaled_weight = quantize_elt(cuda_cast<float>(weight_row[out_col]), col_scales[out_col]);
+            quantized_weight[idx] = int8_t(fmaxf(-128.f, fminf(127.f, scaled_weight)));
+        }
+        else
+        {
+            int8_t packed_int4s = 0;
+#pragma unroll
+            for (int packed_idx = 0; packed_idx < 2; ++packed_idx)
+            {
+                const int64_t input_idx = 2 * out_col + packed_idx;
+                if (input_idx < num_cols)
+                {
+                    const int int_weight
+                        = int(quantize_elt(cuda_cast<float>(weight_row[input_idx]), col_scales[input_idx]));
+                    const int8_t clipped_weight = max(-8, min(7, int_weight));
+                    packed_int4s |= ((clipped_weight & 0x0F) << (4 * packed_idx));
+                }
+            }
+            quantized_weight[idx] = packed_int4s;
+        }
+    }
+}
+
+} // namespace
+
+void permute_B_rows_for_mixed_gemm_cuda(int8_t* permuted_quantized_tensor, const int8_t* quantized_tensor,
+    const std::vector<size_t>& shape, QuantType quant_type, const int64_t arch_version, cudaStream_t stream)
+{
+    // We only want to run this step for weight only quant.
+    TLLM_CHECK(quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY || quant_type == QuantType::INT8_WEIGHT_ONLY);
+    const auto [num_experts, num_rows, num_cols] = get_matrix_shape(shape);
+
+    const int BITS_PER_ELT = get_bits_in_quant_type(quant_type);
+    const int K = 16 / BITS_PER_ELT;
+    const int ELTS_PER_REG = 32 / BITS_PER_ELT;
+    const int MMA_SHAPE_N = 8;
+    const int B_ROWS_PER_MMA = 8 * K;
+    const int num_vec_cols = num_cols / ELTS_PER_REG;
+
+    TLLM_CHECK_WITH_INFO(
+        arch_version >= 75, "Unsupported Arch. Pre-volta not supported. Column interleave not needed on Volta.");
+    TLLM_CHECK_WITH_INFO(num_rows % B_ROWS_PER_MMA == 0,
+        fmtstr("Invalid shape for quantized tensor. Number of rows of quantized matrix must be a multiple of %d",
+            B_ROWS_PER_MMA));
+    TLLM_CHECK_WITH_INFO(num_cols % MMA_SHAPE_N == 0,
+        fmtstr("Invalid shape for quantized tensor. On turing/Ampere, the number of cols must be a multiple of %d.",
+            MMA_SHAPE_N));
+
+    const int64_t num_words = int64_t(num_experts) * num_rows * num_vec_cols;
+    permute_B_rows_kernel<<<get_num_blocks(num_words), kThreadsPerBlock, 0, stream>>>(
+        reinterpret_cast<uint32_t*>(permuted_quantized_tensor), reinterpret_cast<const uint32_t*>(quantized_tensor),
+        num_words, num_rows, num_vec_cols, B_ROWS_PER_MMA, ELTS_PER_REG);
+    sync_check_cuda_error();
+}
+
+void subbyte_transpose_cuda(int8_t* transposed_quantized_tensor, const int8_t* quantized_tensor,
+    const std::vector<size_t>& shape, QuantType quant_type, cudaStream_t stream)
+{
+    const auto [num_experts, num_rows, num_cols] = get_matrix_shape(shape);
+    const int bits_per_elt = get_bits_in_quant_type(quant_type);
+    const size_t col_bytes = num_cols * bits_per_elt / 8;
+    const size_t col_bytes_trans = num_rows * bits_per_elt / 8;
+
+    // Same restriction as on the host, which keeps the packed elements of a byte within one tile.
+    constexpr int VECTOR_WIDTH = 32;
+    TLLM_CHECK_WITH_INFO(!(col_bytes_trans % VECTOR_WIDTH) && !(col_bytes % VECTOR_WIDTH),
+        fmtstr("Number of bytes for rows and cols must be a multiple of %d. However, num_rows_bytes = %ld and "
+               "num_col_bytes = %ld.",
+            VECTOR_WIDTH, col_bytes_trans, col_bytes));
+
+    const dim3 grid((num_cols + kTileElts - 1) / kTileElts, (num_rows + kTileElts - 1) / kTileElts, num_experts);
+    auto* output = reinterpret_cast<uint8_t*>(transposed_quantized_tensor);
+    const auto* input = reinterpret_cast<const uint8_t*>(quantized_tensor);
+    const int64_t matrix_bytes = int64_t(num_rows) * col_bytes;
+    if (quant_type == QuantType::INT8_WEIGHT_ONLY)
+    {
+        subbyte_transpose_kernel<1>
+            <<<grid, kThreadsPerBlock, 0, stream>>>(output, input, num_rows, num_cols, matrix_bytes);
+    }
+    else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
+    {
+        subbyte_transpose_kernel<2>
+            <<<grid, kThreadsPerBlock, 0, stream>>>(output, input, num_rows, num_cols, matrix_bytes);
+    }
+    else
+    {
+        TLLM_CHECK_WITH_INFO(false, "Invalid quant_type");
+    }
+    sync_check_cuda_error();
+}
+
+void interleave_column_major_tensor_cuda(int8_t* interleaved_quantized_tensor, const int8_t* quantized_tensor,
+    const std::vector<size_t>& shape, QuantType quant_type, int rows_per_column_tile, int columns_interleaved,
+    cudaStream_t stream)
+{
+    // We only want to run this step for weight only quant.
+    TLLM_CHECK(quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY || quant_type == QuantType::INT8_WEIGHT_ONLY);
+    const auto [num_experts, num_rows, num_cols] = get_matrix_shape(shape);
+
+    const int BITS_PER_ELT = get_bits_in_quant_type(quant_type);
+    const int elts_in_int32 = 32 / BITS_PER_ELT;
+
+    TLLM_CHECK_WITH_INFO(!(num_rows % elts_in_int32),
+        fmtstr("The number of rows must be a multiple of %d but the number of rows is %ld.", elts_in_int32, num_rows));
+    TLLM_CHECK_WITH_INFO(!(num_rows % rows_per_column_tile),
+        fmtstr("The number of rows must be a multiple of %d but the number of rows is %ld.", rows_per_column_tile,
+            num_rows));
+
+    const int num_vec_rows = num_rows / elts_in_int32;
+    const int vec_rows_per_tile = rows_per_column_tile / elts_in_int32;
+    const int64_t num_words = int64_t(num_experts) * num_cols * num_vec_rows;
+    interleave_column_major_kernel<<<get_num_blocks(num_words), kThreadsPerBlock, 0, stream>>>(
+        reinterpret_cast<uint32_t*>(interleaved_quantized_tensor), reinterpret_cast<const uint32_t*>(quantized_tensor),
+        num_words, num_cols, num_vec_rows, vec_rows_per_tile, columns_interleaved);
+    sync_check_cuda_error();
+}
+
+void add_bias_and_interleave_quantized_tensor_inplace_cuda(
+    int8_t* tensor, const size_t num_elts, QuantType quant_type, cudaStream_t stream)
+{
+    auto* registers = reinterpret_cast<uint32_t*>(tensor);
+    if (quant_type == QuantType::INT8_WEIGHT_ONLY)
+    {
+        TLLM_CHECK_WITH_INFO(
+            num_elts % 4 == 0, "Dimensions of int8 tensor must be a multiple of 4 for register relayout");
+        const int64_t num_registers = num_elts / 4;
+        add_bias_and_interleave_kernel<QuantType::INT8_WEIGHT_ONLY>
+            <<<get_num_blocks(num_registers), kThreadsPerBlock, 0, stream>>>(registers, num_registers);
+    }
+    else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
+    {
+        TLLM_CHECK_WITH_INFO(
+            num_elts % 8 == 0, "Dimensions of int4 tensor must be a multiple of 8 for register relayout");
+        const int64_t num_registers = num_elts / 8;
+        add_bias_and_interleave_kernel<QuantType::PACKED_INT4_WEIGHT_ONLY>
+            <<<get_num_blocks(num_registers), kThreadsPerBlock, 0, stream>>>(registers, num_registers);
+    }
+    else
+    {
+        TLLM_CHECK_WITH_INFO(false, "Invalid quantization type for interleaving.");
+    }
+    sync_check_cuda_error();
+}
+
+size_t get_symmetric_quantize_cuda_workspace_size(const std::vector<size_t>& shape, QuantType quant_type)
+{
+    const auto [num_experts, num_rows, num_cols] = get_matrix_shape(shape);
+    // The column maxima are dead once the weights are quantized, the preprocessing reuses their memory.
+    return std::max(num_experts * num_cols * sizeof(float),
+        get_preprocess_weights_for_mixed_gemm_cuda_workspace_size(shape, quant_type));
+}
+
+template <typename ComputeType, typename WeightType>
+void symmetric_quantize_cuda(int8_t* processed_quantized_weight, int8_t* unprocessed_quantized_weight,
+    ComputeType* scale_ptr, const WeightType* input_weight_ptr, void* workspace, const std::vector<size_t>& shape,
+    QuantType quant_type, bool force_interleave, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(processed_quantized_weight, "Processed quantized tensor is NULL");
+    TLLM_CHECK_WITH_INFO(unprocessed_quantized_weight, "Unprocessed quantized tensor is NULL");
+    TLLM_CHECK_WITH_INFO(scale_ptr, "Scale output pointer is NULL");
+    TLLM_CHECK_WITH_INFO(input_weight_ptr, "Input weight pointer is NULL");
+    TLLM_CHECK_WITH_INFO(workspace, "Workspace pointer is NULL");
+    const auto [num_experts, num_rows, num_cols] = get_matrix_shape(shape);
+
+    const int bits_in_type = get_bits_in_quant_type(quant_type);
+    const int64_t bytes_per_out_col = num_cols * bits_in_type / 8;
+    const float quant_range_scale = 1.f / float(1 << (bits_in_type - 1));
+
+    auto* per_col_max = static_cast<float*>(workspace);
+    const int64_t num_scales = int64_t(num_experts) * num_cols;
+    check_cuda_error(cudaMemsetAsync(per_col_max, 0, num_scales * sizeof(float), stream));
+    const dim3 col_max_grid((num_cols + kThreadsPerBlock - 1) / kThreadsPerBlock,
+        (num_rows + kRowsPerColMaxBlock - 1) / kRowsPerColMaxBlock, num_experts);
+    column_max_kernel<<<col_max_grid, kThreadsPerBlock, 0, stream>>>(
+        per_col_max, input_weight_ptr, num_rows, num_cols);
+    compute_scales_kernel<<<get_num_blocks(num_scales), kThreadsPerBlock, 0, stream>>>(
+        scale_ptr, per_col_max, num_scales, quant_range_scale);
+
+    const int64_t num_bytes = int64_t(num_experts) * num_rows * bytes_per_out_col;
+    if (quant_type == QuantType::INT8_WEIGHT_ONLY)
+    {
+        symmetric_quantize_kernel<WeightType, QuantType::INT8_WEIGHT_ONLY>
+            <<<get_num_blocks(num_bytes), kThreadsPerBlock, 0, stream>>>(unprocessed_quantized_weight,
+                input_weight_ptr, per_col_max, num_bytes, num_rows, num_cols, bytes_per_out_col);
+    }
+    else if (quant_type == QuantType::PACKED_INT4_WEIGHT_ONLY)
+    {
+        symmetric_quantize_kernel<WeightType, QuantType::PACKED_INT4_WEIGHT_ONLY>
+            <<<get_num_blocks(num_bytes), kThreadsPerBlock, 0, stream>>>(unprocessed_quantized_weight,
+                input_weight_ptr, per_col_max, num_bytes, num_rows, num_cols, bytes_per_out_col);
+    }
+    else
+    {
+        TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type");
+    }
+    sync_check_cuda_error();
+
+    preprocess_weights_for_mixed_gemm_cuda(processed_quantized_weight, unprocessed_quantized_weight, workspace, shape,
+        quant_type, stream, force_interleave);
+}
+
+template void symmetric_quantize_cuda<float, float>(
+    int8_t*, int8_t*, float*, const float*, void*, const std::vector<size_t>&, QuantType, bool, cudaStream_t);
+
+template void symmetric_quantize_cuda<half, float>(
+    int8_t*, int8_t*, half*, const float*, void*, const std::vector<size_t>&, QuantType, bool, cudaStream_t);
+
+template void symmetric_quantize_cuda<half, half>(
+    int8_t*, int8_t*, half*, const half*, void*, const std::vector<size_t>&, QuantType, bool, cudaStream_t);
+
+#ifdef ENABLE_BF16
+template void symmetric_quantize_cuda<__nv_bfloat16, __nv_bfloat16>(int8_t*, int8_t*, __nv_bfloat16*,
+    const __nv_bfloat16*, void*, const std::vector<size_t>&, QuantType, bool, cudaStream_t);
+
+template void symmetric_quantize_cuda<__nv_bfloat16, float>(
+    int8_t*, int8_t*, __nv_bfloat16*, const float*, void*, const std::vector<size_t>&, QuantType, bool, cudaStream_t);
+#endif
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
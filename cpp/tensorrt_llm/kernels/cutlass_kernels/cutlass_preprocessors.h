@@ -32,9 +32,14 @@ namespace cutlass_kernels
 enum class QuantType
 {
     INT8_WEIGHT_ONLY,
-    PACKED_INT4_WEIGHT_ONLY
+    PACKED_INT4_WEIGHT_ONLY,
+    // Sub-4-bit and NF4 types, they have no CUTLASS layout and are only run by the batched GEMV
+    PACKED_INT3_WEIGHT_ONLY,
+    PACKED_INT2_WEIGHT_ONLY,
+    PACKED_NF4_WEIGHT_ONLY
 };
 int get_bits_in_quant_type(QuantType quant_type);
+bool is_low_bit_quant_type(QuantType quant_type);
 
 // Shapes here can be 2 or 3D. 2-D shapes are [num_rows, num_cols]
 // 3-D shapes are [num_experts, num_rows, num_cols]
@@ -60,6 +65,54 @@ void symmetric_quantize(int8_t* processed_quantized_weight, int8_t* unprocessed_
     ComputeType* scale_ptr, const WeightType* input_weight_ptr, const std::vector<size_t>& shape, QuantType quant_type,
     bool force_interleave);
 
+// The sub-4-bit types are stored in the bit planes of weightOnlyBatchedGemv/lowBitKernel.h. The shape is the 2-D
+// [num_rows, num_cols] = [K, N] of the weights, num_rows must be a multiple of 32.
+size_t get_low_bit_packed_weight_size(const std::vector<size_t>& shape, QuantType quant_type);
+
+// codes is row major with one unsigned code per byte: the weight plus 4 for INT3, plus 2 for INT2 and the index into
+// the NF4 table for NF4.
+void pack_weights_for_low_bit_gemv(
+    int8_t* packed_weight, const uint8_t* codes, const std::vector<size_t>& shape, QuantType quant_type);
+
+// Symmetric group-wise quantization to a sub-4-bit type, the groups are group_size consecutive rows of a column and
+// scale_ptr is [num_rows / group_size, num_cols]. The unpacked codes are also written to codes if it is not null.
+template <typename ComputeType, typename WeightType>
+void groupwise_quantize_low_bit(int8_t* packed_weight, uint8_t* codes, ComputeType* scale_ptr,
+    const WeightType* input_weight_ptr, const std::vector<size_t>& shape, QuantType quant_type, int group_size);
+
+// CUDA implementations of the functions above. They produce the same bytes, for the layout of the current device.
+// All the pointers are device pointers, the outputs must not alias the inputs and the work is enqueued on stream.
+void permute_B_rows_for_mixed_gemm_cuda(int8_t* permuted_quantized_tensor, const int8_t* quantized_tensor,
+    const std::vector<size_t>& shape, QuantType quant_type, const int64_t arch_version, cudaStream_t stream);
+
+void subbyte_transpose_cuda(int8_t* transposed_quantized_tensor, const int8_t* quantized_tensor,
+    const std::vector<size_t>& shape, QuantType quant_type, cudaStream_t stream);
+
+// Interleaves the columns of a column major tensor in tiles of rows_per_column_tile rows, see
+// cutlass::layout::ColumnMajorTileInterleave.
+void interleave_column_major_tensor_cuda(int8_t* interleaved_quantized_tensor, const int8_t* quantized_tensor,
+    const std::vector<size_t>& shape, QuantType quant_type, int rows_per_column_tile, int columns_interleaved,
+    cudaStream_t stream);
+
+void add_bias_and_interleave_quantized_tensor_inplace_cuda(
+    int8_t* tensor, const size_t num_elts, QuantType quant_type, cudaStream_t stream);
+
+// The preprocessing ping-pongs between the output and a workspace of this many bytes.
+size_t get_preprocess_weights_for_mixed_gemm_cuda_workspace_size(
+    const std::vector<size_t>& shape, QuantType quant_type);
+
+void preprocess_weights_for_mixed_gemm_cuda(int8_t* preprocessed_quantized_weight,
+    const int8_t* row_major_quantized_weight, void* workspace, const std::vector<size_t>& shape, QuantType quant_type,
+    cudaStream_t stream, bool force_interleave = false);
+
+size_t get_symmetric_quantize_cuda_workspace_size(const std::vector<size_t>& shape, QuantType quant_type);
+
+// Unlike on the host, the unprocessed quantized weight is required since the preprocessing reads it.
+template <typename ComputeType, typename WeightType>
+void symmetric_quantize_cuda(int8_t* processed_quantized_weight, int8_t* unprocessed_quantized_weight,
+    ComputeType* scale_ptr, const WeightType* input_weight_ptr, void* workspace, const std::vector<size_t>& shape,
+    QuantType quant_type, bool force_interleave, cudaStream_t stream);
+
 } // namespace cutlass_kernels
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cutlass_extensions/gemm_configs.h"
+#include <cuda_runtime_api.h>
+#include <vector>
+
+namespace tkc = tensorrt_llm::cutlass_extensions;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+/*
+  This runner supports:
+  fp8 e4m3 inputs (A and B)
+  float scales per row of A (per token) and per column of B (per output channel), applied in the epilogue
+  T output (D) where T = {half, __nv_bfloat16}
+
+  Activations, scales and outputs are all assumed to be row-major.
+  Weights are assumed to be column-major.
+  Only SM90 is supported.
+*/
+
+class CutlassFp8RowwiseGemmRunnerInterface
+{
+public:
+    CutlassFp8RowwiseGemmRunnerInterface() {}
+
+    virtual ~CutlassFp8RowwiseGemmRunnerInterface() {}
+
+    virtual void gemm(const void* A, const void* B, const float* scaleTokens, const float* scaleChannels, void* D,
+        int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes,
+        cudaStream_t stream)
+        = 0;
+
+    // Returns desired workspace size in bytes.
+    virtual size_t getWorkspaceSize(const int m, const int n, const int k) = 0;
+
+    virtual std::vector<tkc::CutlassGemmConfig> getConfigs() const = 0;
+};
+
+template <typename T>
+class CutlassFp8RowwiseGemmRunner : public virtual CutlassFp8RowwiseGemmRunnerInterface
+{
+public:
+    CutlassFp8RowwiseGemmRunner();
+    ~CutlassFp8RowwiseGemmRunner();
+
+    void gemm(const void* A, const void* B, const float* scaleTokens, const float* scaleChannels, void* D, int m,
+        int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes,
+        cudaStream_t stream) override;
+
+    // Returns desired workspace size in bytes.
+    size_t getWorkspaceSize(const int m, const int n, const int k) override;
+
+    std::vector<tkc::CutlassGemmConfig> getConfigs() const override;
+
+private:
+    void dispatchToArch(const void* A, const void* B, const float* scaleTokens, const float* scaleChannels, T* D,
+        int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes,
+        cudaStream_t stream);
+
+    int mSm;
+};
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
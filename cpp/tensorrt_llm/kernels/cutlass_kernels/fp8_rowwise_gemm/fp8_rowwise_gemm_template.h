@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#endif // #ifndef _WIN32
+
+#include "cute/numeric/integral_constant.hpp"
+#include "cutlass/epilogue/collective/collective_builder.hpp"
+#include "cutlass/epilogue/fusion/sm90_visitor_load_tma_warpspecialized.hpp"
+#include "cutlass/gemm/collective/collective_builder.hpp"
+#include "cutlass/gemm/device/gemm_universal_adapter.h"
+#include "cutlass/gemm/dispatch_policy.hpp"
+#include "cutlass/gemm/kernel/gemm_universal.hpp"
+#include "cutlass/util/packed_stride.hpp"
+
+#include "cutlass_extensions/gemm_configs.h"
+
+#ifndef _WIN32
+#pragma GCC diagnostic pop
+#endif // #ifndef _WIN32
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_heuristic.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_type_conversion.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/fp8_rowwise_gemm/fp8_rowwise_gemm.h"
+
+namespace tk = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::cutlass_extensions;
+
+using namespace cute;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+template <typename T, typename CTAShape, typename ClusterShape, typename MainloopScheduleType,
+    typename EpilogueScheduleType>
+void sm90GenericFp8RowwiseGemmKernelLauncher(const void* A, const void* B, const float* scaleTokens,
+    const float* scaleChannels, T* D, int m, int n, int k, char* workspace, size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+
+#ifdef COMPILE_HOPPER_MIXED_INPUT_GEMMS
+    using ElementInput = cutlass::float_e4m3_t;
+    using ElementOutput = typename TllmToCutlassTypeAdapter<T>::type;
+
+    // only TN is supported, the K-major layouts of FP8 GMMA
+    using LayoutA = cutlass::layout::RowMajor;
+    constexpr int AlignmentA = 128 / cutlass::sizeof_bits<ElementInput>::value;
+    using LayoutB = cutlass::layout::ColumnMajor;
+    constexpr int AlignmentB = 128 / cutlass::sizeof_bits<ElementInput>::value;
+    using LayoutOutput = cutlass::layout::RowMajor;
+    constexpr int AlignmentOutput = 128 / cutlass::sizeof_bits<ElementOutput>::value;
+
+    using ElementAccumulator = float;
+    using ElementCompute = float;
+    using ArchTag = cutlass::arch::Sm90;
+    using OperatorClass = cutlass::arch::OpClassTensorOp;
+    using TileShape = CTAShape;
+
+    static constexpr auto RoundStyle = cutlass::FloatRoundStyle::round_to_nearest;
+    // D = scaleTokens[m] * (scaleChannels[n] * acc), the scales are loaded once per tile row/column.
+    using ScaleTokens = cutlass::epilogue::fusion::Sm90ColBroadcast<0, TileShape, ElementCompute, Stride<_1, _0, _0>>;
+    using ScaleChannels = cutlass::epilogue::fusion::Sm90RowBroadcast<0, TileShape, ElementCompute, Stride<_0, _1, _0>>;
+    using EVTScaleChannels = cutlass::epilogue::fusion::Sm90EVT<
+        cutlass::epilogue::fusion::Sm90Compute<cutlass::multiplies, ElementCompute, ElementCompute, RoundStyle>,
+        ScaleChannels, cutlass::epilogue::fusion::Sm90AccFetch>;
+    using EVTScaleTokens = cutlass::epilogue::fusion::Sm90EVT<
+        cutlass::epilogue::fusion::Sm90Compute<cutlass::multiplies, ElementOutput, ElementCompute, RoundStyle>,
+        ScaleTokens, EVTScaleChannels>;
+
+    // Void C since there is no source operand, which avoids its smem allocation.
+    using CollectiveEpilogue = typename cutlass::epilogue::collective::CollectiveBuilder<ArchTag, OperatorClass,
+        TileShape, ClusterShape, cutlass::epilogue::collective::EpilogueTileAuto, ElementAccumulator, ElementCompute,
+        void, LayoutOutput, AlignmentOutput, ElementOutput, LayoutOutput, AlignmentOutput, EpilogueScheduleType,
+        EVTScaleTokens>::CollectiveOp;
+
+    using CollectiveMainloop = typename cutlass::gemm::collective::CollectiveBuilder<ArchTag, OperatorClass,
+        ElementInput, LayoutA, AlignmentA, ElementInput, LayoutB, AlignmentB, ElementAccumulator, TileShape,
+        ClusterShape,
+        cutlass::gemm::collective::StageCountAutoCarveout<static_cast<int>(
+            sizeof(typename CollectiveEpilogue::SharedStorage))>,
+        MainloopScheduleType>::CollectiveOp;
+
+    using GemmKernel = cutlass::gemm::kernel::GemmUniversal<Shape<int, int, int, int>, // Indicates ProblemShape
+        CollectiveMainloop, CollectiveEpilogue>;
+
+    using Gemm = cutlass::gemm::device::GemmUniversalAdapter<GemmKernel>;
+
+    using StrideA = typename GemmKernel::StrideA;
+    using StrideB = typename GemmKernel::StrideB;
+    using StrideD = typename GemmKernel::StrideD;
+
+    StrideA strideA = cutlass::make_cute_packed_stride(StrideA{}, cute::make_shape(m, k, 1));
+    StrideB strideB = cutlass::make_cute_packed_stride(StrideB{}, cute::make_shape(n, k, 1));
+    StrideD strideD = cutlass::make_cute_packed_stride(StrideD{}, cute::make_shape(m, n, 1));
+
+    typename Gemm::Arguments args{cutlass::gemm::GemmUniversalMode::kGemm, {m, n, k, 1},
+        {reinterpret_cast<ElementInput const*>(A), strideA, reinterpret_cast<ElementInput const*>(B), strideB},
+        {{}, nullptr, strideD, reinterpret_cast<ElementOutput*>(D), strideD}};
+
+    args.epilogue.thread = {
+        {scaleTokens, 0.f},       // scale tokens
+        {
+            {scaleChannels, 0.f}, // scale channels
+            {},                   // accumulator
+            {}                    // multiplies
+        },
+        {}                        // multiplies
+    };
+
+    Gemm gemm;
+    if (gemm.get_workspace_size(args) > workspaceBytes)
+    {
+        TLLM_LOG_ERROR("[TensorRT-LLM Error][fp8RowwiseGemm Runner] given workspace size insufficient.");
+    }
+
+    auto can_implement = gemm.can_implement(args);
+    if (can_implement != cutlass::Status::kSuccess)
+    {
+        std::string errMsg = "fp8RowwiseGemm cutlass kernel will fail for params. Error: "
+            + std::string(cutlassGetStatusString(can_implement));
+        throw std::runtime_error("[TensorRT-LLM Error][fp8RowwiseGemm Runner] " + errMsg);
+    }
+
+    auto initStatus = gemm.initialize(args, workspace, stream);
+    if (initStatus != cutlass::Status::kSuccess)
+    {
+        std::string errMsg = "Failed to initialize cutlass fp8 rowwise gemm. Error: "
+            + std::string(cutlassGetStatusString(initStatus));
+        throw std::runtime_error("[TensorRT-LLM Error][fp8RowwiseGemm Runner] " + errMsg);
+    }
+
+    auto runStatus = gemm.run(stream);
+    if (runStatus != cutlass::Status::kSuccess)
+    {
+        std::string errMsg
+            = "Failed to run cutlass fp8 rowwise gemm. Error: " + std::string(cutlassGetStatusString(runStatus));
+        throw std::runtime_error("[TensorRT-LLM Error][fp8RowwiseGemm Runner] " + errMsg);
+    }
+#else  // COMPILE_HOPPER_MIXED_INPUT_GEMMS
+    throw std::runtime_error(
+        "[TensorRT-LLM Error][fp8RowwiseGemm Runner] Please recompile with support for hopper by passing 90-real as an "
+        "arch to build_wheel.py.");
+#endif // COMPILE_HOPPER_MIXED_INPUT_GEMMS
+}
+
+template <typename T, typename CTAShape, typename ClusterShape>
+void sm90DispatchFp8RowwiseSchedules(const void* A, const void* B, const float* scaleTokens,
+    const float* scaleChannels, T* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
+    size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(gemmConfig.mainloop_schedule == tkc::MainloopScheduleType::AUTO
+            && gemmConfig.epilogue_schedule == tkc::EpilogueScheduleType::AUTO,
+        "[TensorRT-LLM Error][fp8RowwiseGemm] Only the AUTO schedules are supported.");
+    // No fast accumulation: the accumulators are promoted to fp32 regularly, which keeps the accuracy of long Ks.
+    using MainloopScheduleType = cute::conditional_t<size<0>(CTAShape{}) == Int<64>{},
+        cutlass::gemm::KernelTmaWarpSpecializedPingpong, cutlass::gemm::KernelTmaWarpSpecializedCooperative>;
+    using EpilogueScheduleType = cute::conditional_t<size<0>(CTAShape{}) == Int<64>{},
+        cutlass::epilogue::TmaWarpSpecialized, cutlass::epilogue::TmaWarpSpecializedCooperative>;
+    sm90GenericFp8RowwiseGemmKernelLauncher<T, CTAShape, ClusterShape, MainloopScheduleType, EpilogueScheduleType>(
+        A, B, scaleTokens, scaleChannels, D, m, n, k, workspace, workspaceBytes, stream);
+}
+
+template <typename T, typename CTAShape>
+void sm90DispatchFp8RowwiseClusterShape(const void* A, const void* B, const float* scaleTokens,
+    const float* scaleChannels, T* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
+    size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    // Multicast along M needs an M tile of 128 and along N an N tile of at least 128, see get_candidate_configs.
+    constexpr bool mcastAlongM = size<0>(CTAShape{}) >= 128;
+    constexpr bool mcastAlongN = size<1>(CTAShape{}) >= 128;
+    switch (gemmConfig.cluster_shape)
+    {
+    case tkc::ClusterShape::ClusterShape_1x1x1:
+        sm90DispatchFp8RowwiseSchedules<T, CTAShape, Shape<_1, _1, _1>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        return;
+    case tkc::ClusterShape::ClusterShape_2x1x1:
+        if constexpr (mcastAlongM)
+        {
+            sm90DispatchFp8RowwiseSchedules<T, CTAShape, Shape<_2, _1, _1>>(
+                A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+            return;
+        }
+        break;
+    case tkc::ClusterShape::ClusterShape_1x2x1:
+        if constexpr (mcastAlongN)
+        {
+            sm90DispatchFp8RowwiseSchedules<T, CTAShape, Shape<_1, _2, _1>>(
+                A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+            return;
+        }
+        break;
+    case tkc::ClusterShape::ClusterShape_2x2x1:
+        if constexpr (mcastAlongM && mcastAlongN)
+        {
+            sm90DispatchFp8RowwiseSchedules<T, CTAShape, Shape<_2, _2, _1>>(
+                A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+            return;
+        }
+        break;
+    default: break;
+    }
+    throw std::runtime_error(
+        "[TensorRT-LLM Error][fp8RowwiseGemm][dispatch_CGA_config] Config is invalid for fp8 rowwise GEMM.");
+}
+
+template <typename T>
+void sm90DispatchFp8RowwiseGemmToCutlass(const void* A, const void* B, const float* scaleTokens,
+    const float* scaleChannels, T* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
+    size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    // 128 bytes of K, i.e. 128 fp8 elements.
+    using _Ktile = Int<128>;
+    switch (gemmConfig.tile_config_sm90)
+    {
+    case tkc::CutlassTileConfigSM90::CtaShape64x64x128B:
+        sm90DispatchFp8RowwiseClusterShape<T, Shape<_64, _64, _Ktile>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape64x128x128B:
+        sm90DispatchFp8RowwiseClusterShape<T, Shape<_64, _128, _Ktile>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape64x256x128B:
+        sm90DispatchFp8RowwiseClusterShape<T, Shape<_64, _256, _Ktile>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape128x64x128B:
+        sm90DispatchFp8RowwiseClusterShape<T, Shape<_128, _64, _Ktile>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape128x128x128B:
+        sm90DispatchFp8RowwiseClusterShape<T, Shape<_128, _128, _Ktile>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape128x256x128B:
+        sm90DispatchFp8RowwiseClusterShape<T, Shape<_128, _256, _Ktile>>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspace, workspaceBytes, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::Undefined:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][fp8RowwiseGemm][dispatch_gemm_to_cutlass] gemm config undefined.");
+        break;
+    case tkc::CutlassTileConfigSM90::ChooseWithHeuristic:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][fp8RowwiseGemm][dispatch_gemm_to_cutlass] gemm config should have already been set "
+            "by heuristic.");
+        break;
+    default:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][fp8RowwiseGemm][dispatch_gemm_to_cutlass] Config is invalid for fp8 rowwise GEMM.");
+        break;
+    }
+}
+
+template <typename T>
+CutlassFp8RowwiseGemmRunner<T>::CutlassFp8RowwiseGemmRunner()
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    mSm = tk::getSMVersion();
+}
+
+template <typename T>
+CutlassFp8RowwiseGemmRunner<T>::~CutlassFp8RowwiseGemmRunner()
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void CutlassFp8RowwiseGemmRunner<T>::dispatchToArch(const void* A, const void* B, const float* scaleTokens,
+    const float* scaleChannels, T* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr,
+    const size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    if (mSm == 90)
+    {
+        sm90DispatchFp8RowwiseGemmToCutlass<T>(
+            A, B, scaleTokens, scaleChannels, D, m, n, k, gemmConfig, workspacePtr, workspaceBytes, stream);
+    }
+    else
+    {
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][CutlassFp8RowwiseGemmRunner][GEMM Dispatch] Arch unsupported for CUTLASS fp8 rowwise "
+            "GEMM");
+    }
+}
+
+template <typename T>
+void CutlassFp8RowwiseGemmRunner<T>::gemm(const void* A, const void* B, const float* scaleTokens,
+    const float* scaleChannels, void* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr,
+    const size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    dispatchToArch(A, B, scaleTokens, scaleChannels, reinterpret_cast<T*>(D), m, n, k, gemmConfig, workspacePtr,
+        workspaceBytes, stream);
+}
+
+template <typename T>
+std::vector<tkc::CutlassGemmConfig> CutlassFp8RowwiseGemmRunner<T>::getConfigs() const
+{
+    static constexpr bool isWeightOnly = false;
+    std::vector<tkc::CutlassGemmConfig> candidateConfigs
+        = get_candidate_configs(mSm, isWeightOnly, /* SIMT configs */ false, /* INT8 configs */ false,
+            /* max split-k */ 1, /* Hopper GMMA */ true);
+    return candidateConfigs;
+}
+
+template <typename T>
+size_t CutlassFp8RowwiseGemmRunner<T>::getWorkspaceSize(const int m, const int n, const int k)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    // The persistent tile scheduler without split-k and the broadcast epilogue need no workspace.
+    return 0;
+}
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
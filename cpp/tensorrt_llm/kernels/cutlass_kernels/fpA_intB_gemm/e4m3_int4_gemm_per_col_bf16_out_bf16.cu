@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/cutlass_kernels/fpA_intB_gemm/fpA_intB_gemm_template.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+#if defined(ENABLE_FP8) && defined(ENABLE_BF16)
+template class CutlassFpAIntBGemmRunner<__nv_fp8_e4m3,                /*Activation Type*/
+    cutlass::int4b_t,                                                 /*Weight Type*/
+    cutlass::WeightOnlyQuantOp::PER_COLUMN_SCALE_ONLY, __nv_bfloat16, /*Scale and Zero Type*/
+    __nv_bfloat16,                                                    /*Bias type Type*/
+    __nv_bfloat16                                                     /*Output type Type*/
+    >;
+#endif
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cutlass_extensions/gemm_configs.h"
+#include <cstdint>
+#include <cuda_runtime_api.h>
+#include <vector>
+
+namespace tkc = tensorrt_llm::cutlass_extensions;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+enum class GroupedGemmActivation
+{
+    Identity = 0,
+    Relu,
+    Gelu,
+    Silu
+};
+
+// Description of the groups of a grouped GEMM D[g] = act(A[g] * B[g] + C[g]). All the arrays are in device memory
+// and hold one entry per group, so they can be filled by a kernel from data the host never sees (e.g. the rows
+// routed to each MoE expert).
+// A is [m, k] row-major, B is [k, n] row-major or [n, k] column-major, C and D are [m, n] row-major.
+struct HopperGroupedGemmInput
+{
+    // (m, n, k) of each group. Groups with m == 0 are skipped.
+    int32_t* problemShapes = nullptr;
+    void const** ptrA = nullptr;
+    void const** ptrB = nullptr;
+    // Only read when hasBias is set
+    void const** ptrC = nullptr;
+    void** ptrD = nullptr;
+    // Leading dimensions in elements. A leading dimension of 0 for C broadcasts one bias row to all the rows.
+    int64_t* ldA = nullptr;
+    int64_t* ldB = nullptr;
+    int64_t* ldC = nullptr;
+    int64_t* ldD = nullptr;
+    int numGroups = 0;
+    bool hasBias = false;
+
+    // Workspace of the CUTLASS kernel (the TMA descriptors of each SM)
+    char* gemmWorkspace = nullptr;
+    size_t gemmWorkspaceBytes = 0;
+};
+
+/*
+  This runner supports:
+  T inputs (A and B) and outputs (C and D) where T = {half, __nv_bfloat16}
+  a bias and an activation in the epilogue
+  __nv_fp8_e4m3 inputs with float outputs and column-major B, without bias nor activation
+
+  The problem sizes and pointers of the groups are read on the device, the host only needs the number of groups.
+  Only SM90 is supported.
+*/
+
+template <typename T, typename OutputType = T>
+class CutlassHopperGroupedGemmRunner
+{
+public:
+    CutlassHopperGroupedGemmRunner();
+    ~CutlassHopperGroupedGemmRunner();
+
+    //! \param weightsColumnMajor Whether B is [n, k] column-major (LoRA weights) or [k, n] row-major (MoE weights).
+    void gemm(HopperGroupedGemmInput const& input, bool weightsColumnMajor, GroupedGemmActivation activation,
+        tkc::CutlassGemmConfig gemmConfig, cudaStream_t stream);
+
+    // Returns the bytes of the group arrays plus the CUTLASS workspace.
+    size_t getWorkspaceSize(int numGroups) const;
+
+    // Carves the group arrays and the CUTLASS workspace out of a buffer of getWorkspaceSize(numGroups) bytes.
+    HopperGroupedGemmInput setupWorkspace(char* workspace, int numGroups) const;
+
+    std::vector<tkc::CutlassGemmConfig> getConfigs() const;
+
+    // Whether the TMA loads and stores can be used, they need 16 byte aligned rows.
+    static bool isSupported(int sm, int64_t n, int64_t k)
+    {
+        constexpr int64_t alignment = 16 / sizeof(T);
+        return sm == 90 && n % alignment == 0 && k % alignment == 0;
+    }
+
+private:
+    // FP8 GMMA only reads K-major operands, so the FP8 weights have to be column-major
+    static constexpr bool isFp8 = sizeof(T) == 1;
+
+    size_t getGemmWorkspaceSize() const;
+
+    int mSm;
+    int mMultiProcessorCount;
+};
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#endif // #ifndef _WIN32
+
+#include "cute/numeric/integral_constant.hpp"
+#include "cutlass/epilogue/collective/default_epilogue_array.hpp"
+#include "cutlass/epilogue/collective/detail.hpp"
+#include "cutlass/epilogue/thread/activation.h"
+#include "cutlass/epilogue/thread/linear_combination_generic.h"
+#include "cutlass/gemm/collective/collective_builder.hpp"
+#include "cutlass/gemm/device/gemm_universal_adapter.h"
+#include "cutlass/gemm/dispatch_policy.hpp"
+#include "cutlass/gemm/group_array_problem_shape.hpp"
+#include "cutlass/gemm/kernel/gemm_universal.hpp"
+
+#include "cutlass_extensions/gemm_configs.h"
+
+#ifndef _WIN32
+#pragma GCC diagnostic pop
+#endif // #ifndef _WIN32
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/workspace.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_heuristic.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_type_conversion.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/hopper_grouped_gemm/hopper_grouped_gemm.h"
+
+namespace tk = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::cutlass_extensions;
+
+using namespace cute;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+template <typename T, typename OutputType, typename LayoutB, template <typename> class Activation,
+    typename CTAShape, typename ClusterShape>
+void sm90GenericGroupedGemmKernelLauncher(HopperGroupedGemmInput const& input, int multiProcessorCount,
+    cudaStream_t stream, size_t* workspaceBytes = nullptr)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+
+#ifdef COMPILE_HOPPER_MIXED_INPUT_GEMMS
+    using ElementInput = typename TllmToCutlassTypeAdapter<T>::type;
+    using ElementOutput = typename TllmToCutlassTypeAdapter<OutputType>::type;
+
+    // The layouts are pointers since every group has its own stride
+    using LayoutA = cutlass::layout::RowMajor;
+    constexpr int AlignmentA = 128 / cutlass::sizeof_bits<ElementInput>::value;
+    constexpr int AlignmentB = 128 / cutlass::sizeof_bits<ElementInput>::value;
+    using LayoutOutput = cutlass::layout::RowMajor;
+
+    using ElementAccumulator = float;
+    using ElementCompute = float;
+    using ArchTag = cutlass::arch::Sm90;
+    using OperatorClass = cutlass::arch::OpClassTensorOp;
+    using TileShape = CTAShape;
+    using ProblemShape = cutlass::gemm::GroupProblemShape<Shape<int, int, int>>;
+
+    // The epilogue reads C and writes D straight from registers, which lets the bias be broadcast with a zero
+    // leading dimension and keeps the whole shared memory for the mainloop.
+    using ThreadEpilogueOp = cutlass::epilogue::thread::LinearCombinationGeneric<Activation, ElementOutput, 1,
+        ElementAccumulator, ElementCompute>;
+    using StrideOutput = cutlass::detail::TagToStrideC_t<LayoutOutput*>;
+    using CollectiveEpilogue = cutlass::epilogue::collective::detail::Sm90TmaWarpSpecializedAdapter<
+        cutlass::epilogue::collective::DefaultEpilogueArray<StrideOutput, StrideOutput, ThreadEpilogueOp,
+            cutlass::epilogue::PtrArrayNoSmemWarpSpecialized>>;
+
+    using CollectiveMainloop = typename cutlass::gemm::collective::CollectiveBuilder<ArchTag, OperatorClass,
+        ElementInput, LayoutA*, AlignmentA, ElementInput, LayoutB*, AlignmentB, ElementAccumulator, TileShape,
+        ClusterShape,
+        cutlass::gemm::collective::StageCountAutoCarveout<static_cast<int>(
+            sizeof(typename CollectiveEpilogue::SharedStorage))>,
+        cutlass::gemm::KernelPtrArrayTmaWarpSpecializedCooperative>::CollectiveOp;
+
+    using GemmKernel = cutlass::gemm::kernel::GemmUniversal<ProblemShape, CollectiveMainloop, CollectiveEpilogue>;
+
+    using Gemm = cutlass::gemm::device::GemmUniversalAdapter<GemmKernel>;
+
+    // Each stride has a single dynamic mode, the leading dimension, so the int64_t arrays of the input are used as is.
+    using StrideA = typename GemmKernel::InternalStrideA;
+    using StrideB = typename GemmKernel::InternalStrideB;
+    using StrideC = typename GemmKernel::InternalStrideC;
+    using StrideD = typename GemmKernel::InternalStrideD;
+    static_assert(sizeof(StrideA) == sizeof(int64_t) && sizeof(StrideB) == sizeof(int64_t)
+        && sizeof(StrideC) == sizeof(int64_t) && sizeof(StrideD) == sizeof(int64_t));
+    static_assert(sizeof(typename ProblemShape::UnderlyingProblemShape) == 3 * sizeof(int32_t));
+
+    cutlass::KernelHardwareInfo hwInfo;
+    hwInfo.sm_count = multiProcessorCount;
+
+    typename Gemm::Arguments args{cutlass::gemm::GemmUniversalMode::kGrouped,
+        {input.numGroups, reinterpret_cast<typename ProblemShape::UnderlyingProblemShape*>(input.problemShapes),
+            nullptr},
+        {reinterpret_cast<ElementInput const**>(input.ptrA), reinterpret_cast<StrideA*>(input.ldA),
+            reinterpret_cast<ElementInput const**>(input.ptrB), reinterpret_cast<StrideB*>(input.ldB)},
+        {{ElementCompute(1.f), input.hasBias ? ElementCompute(1.f) : ElementCompute(0.f)},
+            reinterpret_cast<ElementOutput const**>(input.ptrC), reinterpret_cast<StrideC*>(input.ldC),
+            reinterpret_cast<ElementOutput**>(input.ptrD), reinterpret_cast<StrideD*>(input.ldD)},
+        hwInfo};
+
+    if (workspaceBytes != nullptr)
+    {
+        *workspaceBytes = Gemm::get_workspace_size(args);
+        return;
+    }
+
+    Gemm gemm;
+    if (gemm.get_workspace_size(args) > input.gemmWorkspaceBytes)
+    {
+        TLLM_LOG_ERROR("[TensorRT-LLM Error][hopperGroupedGemm Runner] given workspace size insufficient.");
+    }
+
+    auto can_implement = gemm.can_implement(args);
+    if (can_implement != cutlass::Status::kSuccess)
+    {
+        std::string errMsg = "hopperGroupedGemm cutlass kernel will fail for params. Error: "
+            + std::string(cutlassGetStatusString(can_implement));
+        throw std::runtime_error("[TensorRT-LLM Error][hopperGroupedGemm Runner] " + errMsg);
+    }
+
+    auto initStatus = gemm.initialize(args, input.gemmWorkspace, stream);
+    if (initStatus != cutlass::Status::kSuccess)
+    {
+        std::string errMsg = "Failed to initialize cutlass hopper grouped gemm. Error: "
+            + std::string(cutlassGetStatusString(initStatus));
+        throw std::runtime_error("[TensorRT-LLM Error][hopperGroupedGemm Runner] " + errMsg);
+    }
+
+    auto runStatus = gemm.run(stream);
+    if (runStatus != cutlass::Status::kSuccess)
+    {
+        std::string errMsg
+            = "Failed to run cutlass hopper grouped gemm. Error: " + std::string(cutlassGetStatusString(runStatus));
+        throw std::runtime_error("[TensorRT-LLM Error][hopperGroupedGemm Runner] " + errMsg);
+    }
+#else  // COMPILE_HOPPER_MIXED_INPUT_GEMMS
+    throw std::runtime_error(
+        "[TensorRT-LLM Error][hopperGroupedGemm Runner] Please recompile with support for hopper by passing 90-real as "
+        "an arch to build_wheel.py.");
+#endif // COMPILE_HOPPER_MIXED_INPUT_GEMMS
+}
+
+template <typename T, typename OutputType, typename LayoutB, template <typename> class Activation, typename CTAShape>
+void sm90DispatchGroupedGemmClusterShape(HopperGroupedGemmInput const& input, tkc::CutlassGemmConfig gemmConfig,
+    int multiProcessorCount, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(gemmConfig.mainloop_schedule == tkc::MainloopScheduleType::AUTO
+            && gemmConfig.epilogue_schedule == tkc::EpilogueScheduleType::AUTO,
+        "[TensorRT-LLM Error][hopperGroupedGemm] Only the AUTO schedules are supported.");
+    // All the tiles have M = 128, only the N tile limits the multicast, see get_candidate_configs.
+    constexpr bool mcastAlongN = size<1>(CTAShape{}) >= 128;
+    switch (gemmConfig.cluster_shape)
+    {
+    case tkc::ClusterShape::ClusterShape_1x1x1:
+        sm90GenericGroupedGemmKernelLauncher<T, OutputType, LayoutB, Activation, CTAShape, Shape<_1, _1, _1>>(
+            input, multiProcessorCount, stream);
+        return;
+    case tkc::ClusterShape::ClusterShape_2x1x1:
+        sm90GenericGroupedGemmKernelLauncher<T, OutputType, LayoutB, Activation, CTAShape, Shape<_2, _1, _1>>(
+            input, multiProcessorCount, stream);
+        return;
+    case tkc::ClusterShape::ClusterShape_1x2x1:
+        if constexpr (mcastAlongN)
+        {
+            sm90GenericGroupedGemmKernelLauncher<T, OutputType, LayoutB, Activation, CTAShape, Shape<_1, _2, _1>>(
+                input, multiProcessorCount, stream);
+            return;
+        }
+        break;
+    case tkc::ClusterShape::ClusterShape_2x2x1:
+        if constexpr (mcastAlongN)
+        {
+            sm90GenericGroupedGemmKernelLauncher<T, OutputType, LayoutB, Activation, CTAShape, Shape<_2, _2, _1>>(
+                input, multiProcessorCount, stream);
+            return;
+        }
+        break;
+    default: break;
+    }
+    throw std::runtime_error(
+        "[TensorRT-LLM Error][hopperGroupedGemm][dispatch_CGA_config] Config is invalid for hopper grouped GEMM.");
+}
+
+template <typename T, typename OutputType, typename LayoutB, template <typename> class Activation>
+void sm90DispatchGroupedGemmToCutlass(HopperGroupedGemmInput const& input, tkc::CutlassGemmConfig gemmConfig,
+    int multiProcessorCount, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    // 128 bytes of K, i.e. 64 16-bit or 128 8-bit elements.
+    using _Ktile = Int<128 / sizeof(T)>;
+    // Only the cooperative ptr-array schedule is used, it needs an M tile of 128.
+    switch (gemmConfig.tile_config_sm90)
+    {
+    case tkc::CutlassTileConfigSM90::CtaShape128x64x128B:
+        sm90DispatchGroupedGemmClusterShape<T, OutputType, LayoutB, Activation, Shape<_128, _64, _Ktile>>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape128x128x128B:
+        sm90DispatchGroupedGemmClusterShape<T, OutputType, LayoutB, Activation, Shape<_128, _128, _Ktile>>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::CtaShape128x256x128B:
+        sm90DispatchGroupedGemmClusterShape<T, OutputType, LayoutB, Activation, Shape<_128, _256, _Ktile>>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    case tkc::CutlassTileConfigSM90::Undefined:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][hopperGroupedGemm][dispatch_gemm_to_cutlass] gemm config undefined.");
+        break;
+    case tkc::CutlassTileConfigSM90::ChooseWithHeuristic:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][hopperGroupedGemm][dispatch_gemm_to_cutlass] gemm config should have already been "
+            "set by heuristic.");
+        break;
+    default:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][hopperGroupedGemm][dispatch_gemm_to_cutlass] Config is invalid for hopper grouped "
+            "GEMM.");
+        break;
+    }
+}
+
+template <typename T, typename OutputType, typename LayoutB>
+void sm90DispatchGroupedGemmActivation(HopperGroupedGemmInput const& input, GroupedGemmActivation activation,
+    tkc::CutlassGemmConfig gemmConfig, int multiProcessorCount, cudaStream_t stream)
+{
+    switch (activation)
+    {
+    case GroupedGemmActivation::Identity:
+        sm90DispatchGroupedGemmToCutlass<T, OutputType, LayoutB, cutlass::epilogue::thread::Identity>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    case GroupedGemmActivation::Relu:
+        sm90DispatchGroupedGemmToCutlass<T, OutputType, LayoutB, cutlass::epilogue::thread::ReLu>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    // Same tanh approximation as EpilogueOpDefaultFtGelu of the SM80 kernels
+    case GroupedGemmActivation::Gelu:
+        sm90DispatchGroupedGemmToCutlass<T, OutputType, LayoutB, cutlass::epilogue::thread::GELU_taylor>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    case GroupedGemmActivation::Silu:
+        sm90DispatchGroupedGemmToCutlass<T, OutputType, LayoutB, cutlass::epilogue::thread::SiLu>(
+            input, gemmConfig, multiProcessorCount, stream);
+        break;
+    default: throw std::runtime_error("[TensorRT-LLM Error][hopperGroupedGemm] Invalid activation type.");
+    }
+}
+
+template <typename T, typename OutputType>
+CutlassHopperGroupedGemmRunner<T, OutputType>::CutlassHopperGroupedGemmRunner()
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    int device{-1};
+    tk::check_cuda_error(cudaGetDevice(&device));
+    mSm = tk::getSMVersion();
+    tk::check_cuda_error(cudaDeviceGetAttribute(&mMultiProcessorCount, cudaDevAttrMultiProcessorCount, device));
+}
+
+template <typename T, typename OutputType>
+CutlassHopperGroupedGemmRunner<T, OutputType>::~CutlassHopperGroupedGemmRunner()
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+}
+
+template <typename T, typename OutputType>
+void CutlassHopperGroupedGemmRunner<T, OutputType>::gemm(HopperGroupedGemmInput const& input, bool weightsColumnMajor,
+    GroupedGemmActivation activation, tkc::CutlassGemmConfig gemmConfig, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    if (mSm != 90)
+    {
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][CutlassHopperGroupedGemmRunner][GEMM Dispatch] Arch unsupported for CUTLASS hopper "
+            "grouped GEMM");
+    }
+    // The LoRA and FP8 weights have no activation, which keeps the number of column-major kernels down.
+    if (weightsColumnMajor)
+    {
+        TLLM_CHECK_WITH_INFO(activation == GroupedGemmActivation::Identity && !input.hasBias,
+            "[TensorRT-LLM Error][hopperGroupedGemm] Column-major weights support neither bias nor activation.");
+        sm90DispatchGroupedGemmToCutlass<T, OutputType, cutlass::layout::ColumnMajor,
+            cutlass::epilogue::thread::Identity>(input, gemmConfig, mMultiProcessorCount, stream);
+    }
+    else if constexpr (!isFp8)
+    {
+        sm90DispatchGroupedGemmActivation<T, OutputType, cutlass::layout::RowMajor>(
+            input, activation, gemmConfig, mMultiProcessorCount, stream);
+    }
+    else
+    {
+        throw std::runtime_error("[TensorRT-LLM Error][hopperGroupedGemm] FP8 GMMA needs column-major weights.");
+    }
+}
+
+template <typename T, typename OutputType>
+std::vector<tkc::CutlassGemmConfig> CutlassHopperGroupedGemmRunner<T, OutputType>::getConfigs() const
+{
+    static constexpr bool isWeightOnly = false;
+    std::vector<tkc::CutlassGemmConfig> candidateConfigs
+        = get_candidate_configs(mSm, isWeightOnly, /* SIMT configs */ false, /* INT8 configs */ false,
+            /* max split-k */ 1, /* Hopper GMMA */ true);
+    std::vector<tkc::CutlassGemmConfig> configs;
+    for (auto const& config : candidateConfigs)
+    {
+        if (config.tile_config_sm90 == tkc::CutlassTileConfigSM90::CtaShape128x64x128B
+            || config.tile_config_sm90 == tkc::CutlassTileConfigSM90::CtaShape128x128x128B
+            || config.tile_config_sm90 == tkc::CutlassTileConfigSM90::CtaShape128x256x128B)
+        {
+            configs.push_back(config);
+        }
+    }
+    return configs;
+}
+
+template <typename T, typename OutputType>
+size_t CutlassHopperGroupedGemmRunner<T, OutputType>::getGemmWorkspaceSize() const
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    if (mSm != 90)
+    {
+        return 0;
+    }
+    // The workspace holds the TMA descriptors each SM patches for its current group, it does not depend on the tile.
+    size_t workspaceBytes = 0;
+    using LayoutB = std::conditional_t<isFp8, cutlass::layout::ColumnMajor, cutlass::layout::RowMajor>;
+    sm90GenericGroupedGemmKernelLauncher<T, OutputType, LayoutB, cutlass::epilogue::thread::Identity,
+        Shape<_128, _128, Int<128 / sizeof(T)>>, Shape<_1, _1, _1>>(
+        HopperGroupedGemmInput{}, mMultiProcessorCount, nullptr, &workspaceBytes);
+    return workspaceBytes;
+}
+
+template <typename T, typename OutputType>
+size_t CutlassHopperGroupedGemmRunner<T, OutputType>::getWorkspaceSize(int numGroups) const
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    size_t const shapesBytes = numGroups * 3 * sizeof(int32_t);
+    size_t const ptrBytes = numGroups * sizeof(void*);
+    size_t const ldBytes = numGroups * sizeof(int64_t);
+    size_t workspaces[] = {shapesBytes, ptrBytes, ptrBytes, ptrBytes, ptrBytes, ldBytes, ldBytes, ldBytes, ldBytes,
+        getGemmWorkspaceSize()};
+    return tk::calculateTotalWorkspaceSize(workspaces, sizeof(workspaces) / sizeof(workspaces[0]));
+}
+
+template <typename T, typename OutputType>
+HopperGroupedGemmInput CutlassHopperGroupedGemmRunner<T, OutputType>::setupWorkspace(
+    char* workspace, int numGroups) const
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    size_t const shapesBytes = numGroups * 3 * sizeof(int32_t);
+    size_t const ptrBytes = numGroups * sizeof(void*);
+    size_t const ldBytes = numGroups * sizeof(int64_t);
+
+    HopperGroupedGemmInput input;
+    input.numGroups = numGroups;
+    auto* ptr = reinterpret_cast<int8_t*>(workspace);
+    input.problemShapes = reinterpret_cast<int32_t*>(ptr);
+    input.ptrA = reinterpret_cast<void const**>(ptr = tk::nextWorkspacePtr(ptr, shapesBytes));
+    input.ptrB = reinterpret_cast<void const**>(ptr = tk::nextWorkspacePtr(ptr, ptrBytes));
+    input.ptrC = reinterpret_cast<void const**>(ptr = tk::nextWorkspacePtr(ptr, ptrBytes));
+    input.ptrD = reinterpret_cast<void**>(ptr = tk::nextWorkspacePtr(ptr, ptrBytes));
+    input.ldA = reinterpret_cast<int64_t*>(ptr = tk::nextWorkspacePtr(ptr, ptrBytes));
+    input.ldB = reinterpret_cast<int64_t*>(ptr = tk::nextWorkspacePtr(ptr, ldBytes));
+    input.ldC = reinterpret_cast<int64_t*>(ptr = tk::nextWorkspacePtr(ptr, ldBytes));
+    input.ldD = reinterpret_cast<int64_t*>(ptr = tk::nextWorkspacePtr(ptr, ldBytes));
+    input.gemmWorkspace = reinterpret_cast<char*>(ptr = tk::nextWorkspacePtr(ptr, ldBytes));
+    input.gemmWorkspaceBytes = getGemmWorkspaceSize();
+    return input;
+}
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
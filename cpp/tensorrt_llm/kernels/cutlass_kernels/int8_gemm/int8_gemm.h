@@ -18,6 +18,7 @@
 
 #include "cutlass_extensions/gemm_configs.h"
 #include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/moe_gemm/moe_gemm_kernels.h"
 #include <cuda_runtime_api.h>
 
 namespace tk = tensorrt_llm::common;
@@ -38,6 +39,9 @@ namespace cutlass_kernels
 
   Activations, biases, scales and outputs are all assumed to be row-major.
   Weights are assumed to be column-major.
+
+  The epilogue can optionally fuse D = act(alpha * (A x B) + bias) + residual, where bias is a [n] vector,
+  residual is a [m, n] matrix of type T and act is a non-gated activation.
 */
 
 class CutlassInt8GemmRunnerInterface
@@ -52,6 +56,13 @@ public:
         const size_t workspaceBytes, cudaStream_t stream)
         = 0;
 
+    // bias and residual may be null, activation must not be gated.
+    virtual void gemm(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
+        const float* alphaRow, void* C, const void* bias, const void* residual, ActivationType activation, int m,
+        int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes,
+        cudaStream_t stream)
+        = 0;
+
     // Returns desired workspace size in bytes.
     virtual size_t getWorkspaceSize(const int m, const int n, const int k) = 0;
 
@@ -74,15 +85,22 @@ public:
         void* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr,
         const size_t workspaceBytes, cudaStream_t stream) override;
 
+    void gemm(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol, const float* alphaRow,
+        void* C, const void* bias, const void* residual, ActivationType activation, int m, int n, int k,
+        tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes,
+        cudaStream_t stream) override;
+
     // Returns desired workspace size in bytes.
     size_t getWorkspaceSize(const int m, const int n, const int k) override;
 
     std::vector<tkc::CutlassGemmConfig> getConfigs() const override;
 
 private:
+    template <typename EpilogueTag>
     void dispatchToArch(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-        const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr,
-        const size_t workspaceBytes, cudaStream_t stream, int* occupancy = nullptr);
+        const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+        tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream,
+        int* occupancy = nullptr);
 
     int mSm;
     int mMultiProcessorCount;
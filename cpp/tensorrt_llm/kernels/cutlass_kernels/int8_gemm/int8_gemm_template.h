@@ -59,10 +59,43 @@ namespace kernels
 namespace cutlass_kernels
 {
 
-template <typename T, typename arch, typename ThreadblockShape, typename WarpShape, int Stages>
+// Activation applied by the epilogue visitor after the scaling and the bias.
+template <typename EpilogueTag>
+struct Int8GemmEpilogueActivation;
+
+template <>
+struct Int8GemmEpilogueActivation<tkc::EpilogueOpDefault>
+{
+    template <typename T>
+    using type = cutlass::epilogue::thread::Identity<T>;
+};
+
+template <>
+struct Int8GemmEpilogueActivation<tkc::EpilogueOpDefaultFtGelu>
+{
+    template <typename T>
+    using type = cutlass::epilogue::thread::GELU_taylor<T>;
+};
+
+template <>
+struct Int8GemmEpilogueActivation<tkc::EpilogueOpDefaultSilu>
+{
+    template <typename T>
+    using type = cutlass::epilogue::thread::SiLu<T>;
+};
+
+template <>
+struct Int8GemmEpilogueActivation<tkc::EpilogueOpDefaultReLU>
+{
+    template <typename T>
+    using type = cutlass::epilogue::thread::ReLu<T>;
+};
+
+template <typename T, typename EpilogueTag, typename arch, typename ThreadblockShape, typename WarpShape, int Stages>
 void genericInt8GemmKernelLauncher(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-    const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
-    size_t workspaceBytes, cudaStream_t stream, int* occupancy = nullptr)
+    const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+    tkc::CutlassGemmConfig gemmConfig, char* workspace, size_t workspaceBytes, cudaStream_t stream,
+    int* occupancy = nullptr)
 {
     TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
 
@@ -108,7 +141,8 @@ void genericInt8GemmKernelLauncher(const int8_t* A, const int8_t* B, tk::QuantMo
     // Epilogue visitor
     using EpilogueVisitor = typename cutlass::epilogue::threadblock::EpilogueVisitorPerRowPerCol<ThreadblockShape,
         GemmKernel_::kThreadCount, AlphaColTileIterator, typename GemmKernel_::Epilogue::OutputTileIterator,
-        ElementAccumulator, ElementCompute, EpilogueOp>;
+        ElementAccumulator, ElementCompute, EpilogueOp, false,
+        Int8GemmEpilogueActivation<EpilogueTag>::template type>;
 
     /// Epilogue
     using Epilogue = typename cutlass::epilogue::threadblock::EpilogueWithVisitorFromExistingEpilogue<EpilogueVisitor,
@@ -126,15 +160,16 @@ void genericInt8GemmKernelLauncher(const int8_t* A, const int8_t* B, tk::QuantMo
 
     using Gemm = cutlass::gemm::device::GemmUniversalBaseCompat<GemmKernel>;
 
-    typename EpilogueOp::Params linearScalingParams; // TODO: right now it's unused (scaling is done in
-                                                     // visitor, no activation needed)
+    // The scaling is done in the visitor, only beta is used to add the residual (the C operand).
+    typename EpilogueOp::Params linearScalingParams(ElementCompute(1), ElementCompute(residual != nullptr ? 1 : 0));
     typename Gemm::Arguments args{cutlass::gemm::GemmUniversalMode::kBatched, {m, n, k}, 1,
         {reinterpret_cast<ElementInput*>(const_cast<ElementInput*>(A)), k},
         {reinterpret_cast<ElementInput*>(const_cast<ElementInput*>(B)), k}, quantOption,
         {reinterpret_cast<ElementCompute*>(const_cast<float*>(alphaCol)), 0},
-        {reinterpret_cast<ElementCompute*>(const_cast<float*>(alphaRow)), 0}, {nullptr, 0},
-        {reinterpret_cast<ElementOutput*>(C), n}, 0, 0,
-        typename EpilogueVisitor::Arguments(linearScalingParams, 0, 0, 0)};
+        {reinterpret_cast<ElementCompute*>(const_cast<float*>(alphaRow)), 0},
+        {reinterpret_cast<ElementOutput*>(const_cast<T*>(residual)), n}, {reinterpret_cast<ElementOutput*>(C), n}, 0, 0,
+        typename EpilogueVisitor::Arguments(
+            linearScalingParams, 0, 0, 0, reinterpret_cast<ElementOutput*>(const_cast<T*>(bias)))};
 
     Gemm gemm;
     // TODO: handle that
@@ -171,12 +206,14 @@ void genericInt8GemmKernelLauncher(const int8_t* A, const int8_t* B, tk::QuantMo
     }
 }
 
-template <typename T, typename arch, typename ThreadblockShape, typename WarpShape, int Stages, typename Enable = void>
+template <typename T, typename EpilogueTag, typename arch, typename ThreadblockShape, typename WarpShape, int Stages,
+    typename Enable = void>
 struct dispatchStages
 {
     static void dispatch(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-        const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
-        size_t workspaceBytes, cudaStream_t stream, int* occupancy = nullptr)
+        const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+        tkc::CutlassGemmConfig gemmConfig, char* workspace, size_t workspaceBytes, cudaStream_t stream,
+        int* occupancy = nullptr)
     {
         TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
         std::string errMsg = "Cutlass int8 gemm. Not instantiates for arch "
@@ -185,67 +222,71 @@ struct dispatchStages
     }
 };
 
-template <typename T, typename arch, typename ThreadblockShape, typename WarpShape>
-struct dispatchStages<T, arch, ThreadblockShape, WarpShape, 2>
+template <typename T, typename EpilogueTag, typename arch, typename ThreadblockShape, typename WarpShape>
+struct dispatchStages<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 2>
 {
     static void dispatch(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-        const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
-        size_t workspaceBytes, cudaStream_t stream, int* occupancy = nullptr)
+        const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+        tkc::CutlassGemmConfig gemmConfig, char* workspace, size_t workspaceBytes, cudaStream_t stream,
+        int* occupancy = nullptr)
     {
         TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
-        genericInt8GemmKernelLauncher<T, arch, ThreadblockShape, WarpShape, 2>(A, B, quantOption, alphaCol, alphaRow, C,
-            m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        genericInt8GemmKernelLauncher<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 2>(A, B, quantOption, alphaCol,
+            alphaRow, C, bias, residual, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
     }
 };
 
-template <typename T, typename ThreadblockShape, typename WarpShape, int Stages>
-struct dispatchStages<T, cutlass::arch::Sm80, ThreadblockShape, WarpShape, Stages,
+template <typename T, typename EpilogueTag, typename ThreadblockShape, typename WarpShape, int Stages>
+struct dispatchStages<T, EpilogueTag, cutlass::arch::Sm80, ThreadblockShape, WarpShape, Stages,
     typename std::enable_if<(Stages > 2)>::type>
 {
     static void dispatch(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-        const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
-        size_t workspaceBytes, cudaStream_t stream, int* occupancy = nullptr)
+        const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+        tkc::CutlassGemmConfig gemmConfig, char* workspace, size_t workspaceBytes, cudaStream_t stream,
+        int* occupancy = nullptr)
     {
 
         TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
-        genericInt8GemmKernelLauncher<T, cutlass::arch::Sm80, ThreadblockShape, WarpShape, Stages>(A, B, quantOption,
-            alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        genericInt8GemmKernelLauncher<T, EpilogueTag, cutlass::arch::Sm80, ThreadblockShape, WarpShape, Stages>(A, B,
+            quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k, gemmConfig, workspace, workspaceBytes, stream,
+            occupancy);
     }
 };
 
-template <typename T, typename arch, typename ThreadblockShape, typename WarpShape>
+template <typename T, typename EpilogueTag, typename arch, typename ThreadblockShape, typename WarpShape>
 void dispatchGemmConfig(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-    const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig, char* workspace,
-    size_t workspaceBytes, cudaStream_t stream, int* occupancy = nullptr)
+    const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+    tkc::CutlassGemmConfig gemmConfig, char* workspace, size_t workspaceBytes, cudaStream_t stream,
+    int* occupancy = nullptr)
 {
 
     TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
     switch (gemmConfig.stages)
     {
     case 2:
-        using DispatcherStages2 = dispatchStages<T, arch, ThreadblockShape, WarpShape, 2>;
-        DispatcherStages2::dispatch(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace,
-            workspaceBytes, stream, occupancy);
+        using DispatcherStages2 = dispatchStages<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 2>;
+        DispatcherStages2::dispatch(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k, gemmConfig,
+            workspace, workspaceBytes, stream, occupancy);
         break;
     case 3:
-        using DispatcherStages3 = dispatchStages<T, arch, ThreadblockShape, WarpShape, 3>;
-        DispatcherStages3::dispatch(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace,
-            workspaceBytes, stream, occupancy);
+        using DispatcherStages3 = dispatchStages<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 3>;
+        DispatcherStages3::dispatch(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k, gemmConfig,
+            workspace, workspaceBytes, stream, occupancy);
         break;
     case 4:
-        using DispatcherStages4 = dispatchStages<T, arch, ThreadblockShape, WarpShape, 4>;
-        DispatcherStages4::dispatch(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace,
-            workspaceBytes, stream, occupancy);
+        using DispatcherStages4 = dispatchStages<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 4>;
+        DispatcherStages4::dispatch(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k, gemmConfig,
+            workspace, workspaceBytes, stream, occupancy);
         break;
     case 5:
-        using DispatcherStages5 = dispatchStages<T, arch, ThreadblockShape, WarpShape, 5>;
-        DispatcherStages5::dispatch(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace,
-            workspaceBytes, stream, occupancy);
+        using DispatcherStages5 = dispatchStages<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 5>;
+        DispatcherStages5::dispatch(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k, gemmConfig,
+            workspace, workspaceBytes, stream, occupancy);
         break;
     case 6:
-        using DispatcherStages6 = dispatchStages<T, arch, ThreadblockShape, WarpShape, 6>;
-        DispatcherStages6::dispatch(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace,
-            workspaceBytes, stream, occupancy);
+        using DispatcherStages6 = dispatchStages<T, EpilogueTag, arch, ThreadblockShape, WarpShape, 6>;
+        DispatcherStages6::dispatch(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k, gemmConfig,
+            workspace, workspaceBytes, stream, occupancy);
         break;
     default:
         std::string errMsg = "dispatchGemmConfig does not support stages " + std::to_string(gemmConfig.stages);
@@ -254,10 +295,10 @@ void dispatchGemmConfig(const int8_t* A, const int8_t* B, tk::QuantMode quantOpt
     }
 }
 
-template <typename T, typename arch>
+template <typename T, typename EpilogueTag, typename arch>
 void dispatchGemmToCutlass(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
-    const float* alphaRow, T* C, int m, int n, int k, char* workspace, size_t workspaceBytes,
-    tkc::CutlassGemmConfig gemmConfig, cudaStream_t stream, int* occupancy = nullptr)
+    const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k, char* workspace,
+    size_t workspaceBytes, tkc::CutlassGemmConfig gemmConfig, cudaStream_t stream, int* occupancy = nullptr)
 {
 
     TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
@@ -265,28 +306,34 @@ void dispatchGemmToCutlass(const int8_t* A, const int8_t* B, tk::QuantMode quant
     switch (gemmConfig.tile_config)
     {
     case tkc::CutlassTileConfig::CtaShape128x64x64_WarpShape64x32x64:
-        dispatchGemmConfig<T, arch, cutlass::gemm::GemmShape<128, 64, 64>, cutlass::gemm::GemmShape<64, 32, 64>>(A, B,
-            quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        dispatchGemmConfig<T, EpilogueTag, arch, cutlass::gemm::GemmShape<128, 64, 64>,
+            cutlass::gemm::GemmShape<64, 32, 64>>(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k,
+            gemmConfig, workspace, workspaceBytes, stream, occupancy);
         break;
     case tkc::CutlassTileConfig::CtaShape256x128x64_WarpShape64x64x64:
-        dispatchGemmConfig<T, arch, cutlass::gemm::GemmShape<256, 128, 64>, cutlass::gemm::GemmShape<64, 64, 64>>(A, B,
-            quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        dispatchGemmConfig<T, EpilogueTag, arch, cutlass::gemm::GemmShape<256, 128, 64>,
+            cutlass::gemm::GemmShape<64, 64, 64>>(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k,
+            gemmConfig, workspace, workspaceBytes, stream, occupancy);
         break;
     case tkc::CutlassTileConfig::CtaShape32x128x64_WarpShape32x32x64:
-        dispatchGemmConfig<T, arch, cutlass::gemm::GemmShape<32, 128, 64>, cutlass::gemm::GemmShape<32, 32, 64>>(A, B,
-            quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        dispatchGemmConfig<T, EpilogueTag, arch, cutlass::gemm::GemmShape<32, 128, 64>,
+            cutlass::gemm::GemmShape<32, 32, 64>>(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k,
+            gemmConfig, workspace, workspaceBytes, stream, occupancy);
         break;
     case tkc::CutlassTileConfig::CtaShape64x128x64_WarpShape64x32x64:
-        dispatchGemmConfig<T, arch, cutlass::gemm::GemmShape<64, 128, 64>, cutlass::gemm::GemmShape<64, 32, 64>>(A, B,
-            quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        dispatchGemmConfig<T, EpilogueTag, arch, cutlass::gemm::GemmShape<64, 128, 64>,
+            cutlass::gemm::GemmShape<64, 32, 64>>(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k,
+            gemmConfig, workspace, workspaceBytes, stream, occupancy);
         break;
     case tkc::CutlassTileConfig::CtaShape64x64x128_WarpShape32x64x64:
-        dispatchGemmConfig<T, arch, cutlass::gemm::GemmShape<64, 64, 128>, cutlass::gemm::GemmShape<32, 64, 64>>(A, B,
-            quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        dispatchGemmConfig<T, EpilogueTag, arch, cutlass::gemm::GemmShape<64, 64, 128>,
+            cutlass::gemm::GemmShape<32, 64, 64>>(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k,
+            gemmConfig, workspace, workspaceBytes, stream, occupancy);
         break;
     case tkc::CutlassTileConfig::CtaShape128x256x64_WarpShape64x64x64:
-        dispatchGemmConfig<T, arch, cutlass::gemm::GemmShape<128, 256, 64>, cutlass::gemm::GemmShape<64, 64, 64>>(A, B,
-            quantOption, alphaCol, alphaRow, C, m, n, k, gemmConfig, workspace, workspaceBytes, stream, occupancy);
+        dispatchGemmConfig<T, EpilogueTag, arch, cutlass::gemm::GemmShape<128, 256, 64>,
+            cutlass::gemm::GemmShape<64, 64, 64>>(A, B, quantOption, alphaCol, alphaRow, C, bias, residual, m, n, k,
+            gemmConfig, workspace, workspaceBytes, stream, occupancy);
         break;
     case tkc::CutlassTileConfig::Undefined:
         throw std::runtime_error("[TensorRT-LLM Error][int8][dispatch_gemm_to_cutlass] gemm config undefined.");
@@ -320,30 +367,32 @@ CutlassInt8GemmRunner<T>::~CutlassInt8GemmRunner()
 }
 
 template <typename T>
+template <typename EpilogueTag>
 void CutlassInt8GemmRunner<T>::dispatchToArch(const int8_t* A, const int8_t* B, tk::QuantMode quantOption,
-    const float* alphaCol, const float* alphaRow, T* C, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig,
-    char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream, int* occupancy)
+    const float* alphaCol, const float* alphaRow, T* C, const T* bias, const T* residual, int m, int n, int k,
+    tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream,
+    int* occupancy)
 {
     TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
     if (mSm >= 70 && mSm < 72)
     {
-        dispatchGemmToCutlass<T, cutlass::arch::Sm70>(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, workspacePtr,
-            workspaceBytes, gemmConfig, stream, occupancy);
+        dispatchGemmToCutlass<T, EpilogueTag, cutlass::arch::Sm70>(A, B, quantOption, alphaCol, alphaRow, C, bias,
+            residual, m, n, k, workspacePtr, workspaceBytes, gemmConfig, stream, occupancy);
     }
     else if (mSm >= 72 && mSm < 75)
     {
-        dispatchGemmToCutlass<T, cutlass::arch::Sm72>(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, workspacePtr,
-            workspaceBytes, gemmConfig, stream, occupancy);
+        dispatchGemmToCutlass<T, EpilogueTag, cutlass::arch::Sm72>(A, B, quantOption, alphaCol, alphaRow, C, bias,
+            residual, m, n, k, workspacePtr, workspaceBytes, gemmConfig, stream, occupancy);
     }
     else if (mSm >= 75 && mSm < 80)
     {
-        dispatchGemmToCutlass<T, cutlass::arch::Sm75>(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, workspacePtr,
-            workspaceBytes, gemmConfig, stream, occupancy);
+        dispatchGemmToCutlass<T, EpilogueTag, cutlass::arch::Sm75>(A, B, quantOption, alphaCol, alphaRow, C, bias,
+            residual, m, n, k, workspacePtr, workspaceBytes, gemmConfig, stream, occupancy);
     }
     else if (mSm >= 80 && mSm <= 90)
     {
-        dispatchGemmToCutlass<T, cutlass::arch::Sm80>(A, B, quantOption, alphaCol, alphaRow, C, m, n, k, workspacePtr,
-            workspaceBytes, gemmConfig, stream, occupancy);
+        dispatchGemmToCutlass<T, EpilogueTag, cutlass::arch::Sm80>(A, B, quantOption, alphaCol, alphaRow, C, bias,
+            residual, m, n, k, workspacePtr, workspaceBytes, gemmConfig, stream, occupancy);
     }
     else
     {
@@ -358,8 +407,42 @@ void CutlassInt8GemmRunner<T>::gemm(const int8_t* A, const int8_t* B, tk::QuantM
     const size_t workspaceBytes, cudaStream_t stream)
 {
     TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
-    dispatchToArch(A, B, quantOption, alphaCol, alphaRow, reinterpret_cast<T*>(C), m, n, k, gemmConfig, workspacePtr,
-        workspaceBytes, stream);
+    dispatchToArch<tkc::EpilogueOpDefault>(A, B, quantOption, alphaCol, alphaRow, reinterpret_cast<T*>(C), nullptr,
+        nullptr, m, n, k, gemmConfig, workspacePtr, workspaceBytes, stream);
+}
+
+template <typename T>
+void CutlassInt8GemmRunner<T>::gemm(const int8_t* A, const int8_t* B, tk::QuantMode quantOption, const float* alphaCol,
+    const float* alphaRow, void* C, const void* bias, const void* residual, ActivationType activation, int m, int n,
+    int k, tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    auto* out = reinterpret_cast<T*>(C);
+    auto const* biasT = reinterpret_cast<const T*>(bias);
+    auto const* residualT = reinterpret_cast<const T*>(residual);
+    switch (activation)
+    {
+    case ActivationType::Identity:
+        dispatchToArch<tkc::EpilogueOpDefault>(A, B, quantOption, alphaCol, alphaRow, out, biasT, residualT, m, n, k,
+            gemmConfig, workspacePtr, workspaceBytes, stream);
+        break;
+    case ActivationType::Gelu:
+        dispatchToArch<tkc::EpilogueOpDefaultFtGelu>(A, B, quantOption, alphaCol, alphaRow, out, biasT, residualT, m, n,
+            k, gemmConfig, workspacePtr, workspaceBytes, stream);
+        break;
+    case ActivationType::Silu:
+        dispatchToArch<tkc::EpilogueOpDefaultSilu>(A, B, quantOption, alphaCol, alphaRow, out, biasT, residualT, m, n,
+            k, gemmConfig, workspacePtr, workspaceBytes, stream);
+        break;
+    case ActivationType::Relu:
+        dispatchToArch<tkc::EpilogueOpDefaultReLU>(A, B, quantOption, alphaCol, alphaRow, out, biasT, residualT, m, n,
+            k, gemmConfig, workspacePtr, workspaceBytes, stream);
+        break;
+    default:
+        // The gated activations combine two output columns, which a per-element epilogue cannot do.
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][CutlassInt8GemmRunner] Unsupported activation for the fused int8 GEMM epilogue");
+    }
 }
 
 template <typename T>
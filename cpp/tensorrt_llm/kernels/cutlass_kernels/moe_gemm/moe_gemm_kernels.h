@@ -17,8 +17,15 @@
 
 #pragma once
 #include "tensorrt_llm/cutlass_extensions/include/cutlass_extensions/gemm_configs.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/hopper_grouped_gemm/hopper_grouped_gemm.h"
 #include <cuda_runtime_api.h>
 #include <optional>
+#include <vector>
+#ifdef ENABLE_FP8
+#include <cuda_fp8.h>
+#endif
+#include <type_traits>
+#include <variant>
 
 namespace tensorrt_llm
 {
@@ -52,30 +59,98 @@ public:
         best_config_ = std::move(best_config);
     }
 
+    // workspace must hold getWorkspaceSize(num_experts) bytes, it is only used by the Hopper grouped GEMMs.
+    // The gated activations (Swiglu, Geglu) need supportsFusedGatedActivation(). Their B has interleaved columns, 2i is
+    // the linear part and 2i + 1 the gate of output column i, and C has gemm_n / 2 columns.
     void moeGemmBiasAct(const T* A, const WeightType* B, const T* weight_scales, const T* biases, T* C,
         int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-        ActivationType activation_type, cudaStream_t stream);
+        ActivationType activation_type, char* workspace, cudaStream_t stream);
 
     void moeGemm(const T* A, const WeightType* B, const T* weight_scales, T* C, int64_t* total_rows_before_expert,
-        int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts, cudaStream_t stream);
+        int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts, char* workspace, cudaStream_t stream);
 
+    size_t getWorkspaceSize(int num_experts) const;
+
+    bool supportsFusedGatedActivation() const
+    {
+        return supports_fused_gated_activation && sm_ >= 80 && sm_ < 90;
+    }
+
+    // On Hopper, the configs of the TMA grouped GEMMs come before the SM80 ones.
     std::vector<cutlass_extensions::CutlassGemmConfig> getConfigs();
 
 private:
+    // The Hopper grouped GEMMs take 16-bit activations and weights of the same type
+    static constexpr bool use_hopper_grouped_gemm = std::is_same_v<T, WeightType> && !std::is_same_v<T, float>;
+    // Only the SM80 kernels of the same types have the gated epilogue, Hopper runs its TMA GEMMs unfused
+    static constexpr bool supports_fused_gated_activation
+        = std::is_same_v<T, WeightType> && !std::is_same_v<T, float>;
+    using HopperGemmRunner = std::conditional_t<use_hopper_grouped_gemm,
+        kernels::cutlass_kernels::CutlassHopperGroupedGemmRunner<T>, std::monostate>;
+
+    std::vector<cutlass_extensions::CutlassGemmConfig> getAmpereConfigs();
+
+    template <typename EpilogueTag>
+    void runHopperGemm(const T* A, const WeightType* B, const T* biases, T* C, int64_t* total_rows_before_expert,
+        int64_t gemm_n, int64_t gemm_k, int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config,
+        char* workspace, cudaStream_t stream);
+
     template <typename EpilogueTag>
     void dispatchToArch(const T* A, const WeightType* B, const T* weight_scales, const T* biases, T* C,
         int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
         cutlass_extensions::CutlassGemmConfig gemm_config, cudaStream_t stream, int* occupancy = nullptr);
 
+    // Times the candidates with a nonzero occupancy on a private stream the first time a shape is seen. The choice is
+    // cached per SM, epilogue, rows rounded up to a power of 2, N, K and number of experts for the whole process.
+    template <typename EpilogueTag>
+    std::optional<cutlass_extensions::CutlassGemmConfig> autotuneGemm(const T* A, const WeightType* B,
+        const T* weight_scales, const T* biases, T* C, int64_t* total_rows_before_expert, int64_t total_rows,
+        int64_t gemm_n, int64_t gemm_k, int num_experts,
+        std::vector<cutlass_extensions::CutlassGemmConfig> const& configs, std::vector<int> const& occupancies,
+        cudaStream_t stream);
+
     template <typename EpilogueTag>
     void runGemm(const T* A, const WeightType* B, const T* weight_scales, const T* biases, T* C,
         int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-        cudaStream_t stream);
+        char* workspace, cudaStream_t stream);
 
 private:
     int sm_;
     int multi_processor_count_;
     std::optional<cutlass_extensions::CutlassGemmConfig> best_config_{};
+    HopperGemmRunner hopper_gemm_runner_;
+};
+
+#ifdef ENABLE_FP8
+// Grouped GEMM of the FP8 experts, C = A * B^T in fp32. A holds the rows of all the experts, [total_rows, gemm_k]
+// row-major, and the weights of an expert are [gemm_n, gemm_k] row-major since FP8 GMMA only reads K-major operands.
+// The GEMM applies no scale, bias nor activation: the activations have a scale per row, which the caller applies with
+// the scale of the expert while converting the fp32 results. Only SM90 is supported.
+class MoeFp8GemmRunner
+{
+public:
+    MoeFp8GemmRunner();
+
+    void setBestConfig(std::optional<cutlass_extensions::CutlassGemmConfig> best_config)
+    {
+        best_config_ = std::move(best_config);
+    }
+
+    // workspace must hold getWorkspaceSize(num_experts) bytes.
+    void moeGemm(const __nv_fp8_e4m3* A, const __nv_fp8_e4m3* B, float* C, int64_t* total_rows_before_expert,
+        int64_t gemm_n, int64_t gemm_k, int num_experts, char* workspace, cudaStream_t stream);
+
+    size_t getWorkspaceSize(int num_experts) const;
+
+    std::vector<cutlass_extensions::CutlassGemmConfig> getConfigs();
+
+private:
+    using HopperGemmRunner = kernels::cutlass_kernels::CutlassHopperGroupedGemmRunner<__nv_fp8_e4m3, float>;
+
+    int sm_;
+    std::optional<cutlass_extensions::CutlassGemmConfig> best_config_{};
+    HopperGemmRunner hopper_gemm_runner_;
 };
+#endif
 
 } // namespace tensorrt_llm
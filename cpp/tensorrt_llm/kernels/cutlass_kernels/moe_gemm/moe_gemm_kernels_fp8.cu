@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/moe_gemm/moe_gemm_kernels.h"
+
+#include <algorithm>
+
+namespace tensorrt_llm
+{
+#ifdef ENABLE_FP8
+
+// Same as computeHopperGroupedGemmArgsKernel, except that the weights of an expert are [gemm_n, gemm_k] row-major
+// and that there is no bias.
+__global__ void computeFp8GroupedGemmArgsKernel(const int64_t* total_rows_before_expert, const __nv_fp8_e4m3* A,
+    const __nv_fp8_e4m3* B, float* C, int64_t gemm_n, int64_t gemm_k, int num_experts,
+    kernels::cutlass_kernels::HopperGroupedGemmInput input)
+{
+    const int expert = blockIdx.x * blockDim.x + threadIdx.x;
+    if (expert >= num_experts)
+    {
+        return;
+    }
+    const int64_t first_row = expert == 0 ? 0 : total_rows_before_expert[expert - 1];
+    input.problemShapes[expert * 3 + 0] = static_cast<int32_t>(total_rows_before_expert[expert] - first_row);
+    input.problemShapes[expert * 3 + 1] = static_cast<int32_t>(gemm_n);
+    input.problemShapes[expert * 3 + 2] = static_cast<int32_t>(gemm_k);
+    input.ptrA[expert] = A + first_row * gemm_k;
+    input.ptrB[expert] = B + expert * gemm_n * gemm_k;
+    input.ptrC[expert] = nullptr;
+    input.ptrD[expert] = C + first_row * gemm_n;
+    input.ldA[expert] = gemm_k;
+    input.ldB[expert] = gemm_k;
+    input.ldC[expert] = 0;
+    input.ldD[expert] = gemm_n;
+}
+
+MoeFp8GemmRunner::MoeFp8GemmRunner()
+{
+    sm_ = tensorrt_llm::common::getSMVersion();
+}
+
+void MoeFp8GemmRunner::moeGemm(const __nv_fp8_e4m3* A, const __nv_fp8_e4m3* B, float* C,
+    int64_t* total_rows_before_expert, int64_t gemm_n, int64_t gemm_k, int num_experts, char* workspace,
+    cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(HopperGemmRunner::isSupported(sm_, gemm_n, gemm_k),
+        "FP8 MoE GEMMs need SM90 and dimensions that are multiples of 16, got n=%ld k=%ld on SM%d", gemm_n, gemm_k,
+        sm_);
+    TLLM_CHECK_WITH_INFO(workspace != nullptr, "The Hopper grouped GEMM needs a workspace");
+    // The TMA kernels are persistent, there is no occupancy to pick a tile from without profiling
+    cutlass_extensions::CutlassGemmConfig gemm_config(cutlass_extensions::CutlassTileConfigSM90::CtaShape128x128x128B,
+        cutlass_extensions::MainloopScheduleType::AUTO, cutlass_extensions::EpilogueScheduleType::AUTO,
+        cutlass_extensions::ClusterShape::ClusterShape_1x1x1);
+    if (best_config_
+        && best_config_->tile_config_sm90 != cutlass_extensions::CutlassTileConfigSM90::ChooseWithHeuristic)
+    {
+        gemm_config = *best_config_;
+    }
+
+    auto input = hopper_gemm_runner_.setupWorkspace(workspace, num_experts);
+    input.hasBias = false;
+    const int threads = std::min(1024, num_experts);
+    const int blocks = (num_experts + threads - 1) / threads;
+    computeFp8GroupedGemmArgsKernel<<<blocks, threads, 0, stream>>>(
+        total_rows_before_expert, A, B, C, gemm_n, gemm_k, num_experts, input);
+    hopper_gemm_runner_.gemm(input, /* weightsColumnMajor */ true,
+        kernels::cutlass_kernels::GroupedGemmActivation::Identity, gemm_config, stream);
+}
+
+size_t MoeFp8GemmRunner::getWorkspaceSize(int num_experts) const
+{
+    return hopper_gemm_runner_.getWorkspaceSize(num_experts);
+}
+
+std::vector<cutlass_extensions::CutlassGemmConfig> MoeFp8GemmRunner::getConfigs()
+{
+    return hopper_gemm_runner_.getConfigs();
+}
+
+#endif // ENABLE_FP8
+} // namespace tensorrt_llm
@@ -21,10 +21,12 @@
 #include "cutlass/array.h"
 #include "cutlass/numeric_conversion.h"
 
+#include "cutlass/epilogue/threadblock/epilogue_with_visitor.h"
 #include "cutlass/gemm/device/gemm_grouped.h"
 #include "cutlass/gemm/kernel/default_gemm_grouped.h"
 
 #include "cutlass_extensions/compute_occupancy.h"
+#include "cutlass_extensions/epilogue/threadblock/epilogue_gated_activation.h"
 #include "cutlass_extensions/epilogue_helpers.h"
 #include "cutlass_extensions/gemm/kernel/default_fpA_intB_traits.h"
 #include "cutlass_extensions/gemm/kernel/moe_cutlass_kernel.h"
@@ -34,17 +36,44 @@
 
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/cutlass_heuristic.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/moe_gemm/moe_gemm_kernels.h"
 #include <cuda.h>
 #include <cuda_fp16.h>
+#include <limits>
+#include <map>
 #include <math.h>
+#include <mutex>
 #include <sstream>
+#include <tuple>
+#include <typeindex>
 
 namespace tensorrt_llm
 {
 
 // ============================= Variable batched Gemm things ===========================
+
+// The epilogue of the default grouped GEMM, or a visitor that applies a gated activation to its column pairs
+template <typename EpilogueTag, typename DefaultEpilogue, typename ElementAccumulator, typename EpilogueOp,
+    typename Enable = void>
+struct MoeGemmEpilogue
+{
+    using type = DefaultEpilogue;
+};
+
+template <typename EpilogueTag, typename DefaultEpilogue, typename ElementAccumulator, typename EpilogueOp>
+struct MoeGemmEpilogue<EpilogueTag, DefaultEpilogue, ElementAccumulator, EpilogueOp,
+    std::enable_if_t<cutlass_extensions::GatedEpilogueActivation<EpilogueTag>::value>>
+{
+    using Visitor = cutlass::epilogue::threadblock::EpilogueVisitorGatedActivation<
+        typename DefaultEpilogue::OutputTileIterator, ElementAccumulator, EpilogueOp,
+        cutlass_extensions::GatedEpilogueActivation<EpilogueTag>::template type>;
+    using type = typename cutlass::epilogue::threadblock::EpilogueWithVisitorFromExistingEpilogue<Visitor,
+        DefaultEpilogue>::Epilogue;
+};
+
 template <typename T, typename WeightType, typename arch, typename EpilogueTag, typename ThreadblockShape,
     typename WarpShape, int Stages>
 void genericMoeGemmKernelLauncher(const T* A, const WeightType* B, const T* weight_scales, const T* biases, T* C,
@@ -106,7 +135,10 @@ void genericMoeGemmKernelLauncher(const T* A, const WeightType* B, const T* weig
         cutlass::gemm::threadblock::GemmBatchedIdentityThreadblockSwizzle, Stages,
         cutlass::gemm::kernel::GroupScheduleMode::kDeviceOnly, typename MixedGemmArchTraits::Operator>::GemmKernel;
 
-    using GemmKernel = cutlass::gemm::kernel::MoeFCGemm<typename GemmKernel_::Mma, typename GemmKernel_::Epilogue,
+    using Epilogue =
+        typename MoeGemmEpilogue<EpilogueTag, typename GemmKernel_::Epilogue, ElementAccumulator, EpilogueOp>::type;
+
+    using GemmKernel = cutlass::gemm::kernel::MoeFCGemm<typename GemmKernel_::Mma, Epilogue,
         typename GemmKernel_::ThreadblockSwizzle,
         arch, // Ensure top level arch is used for dispatch
         GemmKernel_::kGroupScheduleMode>;
@@ -348,8 +380,57 @@ void dispatchMoeGemmToCutlass(const T* A, const WeightType* B, const T* weight_s
     }
 }
 
+// Fills the group arrays of the Hopper grouped GEMM from the expert offsets, so the host never needs the number of
+// rows of each expert. The weights of an expert are [gemm_k, gemm_n] row-major, the bias is broadcast to all its rows.
+template <typename T>
+__global__ void computeHopperGroupedGemmArgsKernel(const int64_t* total_rows_before_expert, const T* A, const T* B,
+    const T* biases, T* C, int64_t gemm_n, int64_t gemm_k, int num_experts,
+    kernels::cutlass_kernels::HopperGroupedGemmInput input)
+{
+    const int expert = blockIdx.x * blockDim.x + threadIdx.x;
+    if (expert >= num_experts)
+    {
+        return;
+    }
+    const int64_t first_row = expert == 0 ? 0 : total_rows_before_expert[expert - 1];
+    input.problemShapes[expert * 3 + 0] = static_cast<int32_t>(total_rows_before_expert[expert] - first_row);
+    input.problemShapes[expert * 3 + 1] = static_cast<int32_t>(gemm_n);
+    input.problemShapes[expert * 3 + 2] = static_cast<int32_t>(gemm_k);
+    input.ptrA[expert] = A + first_row * gemm_k;
+    input.ptrB[expert] = B + expert * gemm_k * gemm_n;
+    input.ptrC[expert] = biases ? biases + expert * gemm_n : nullptr;
+    input.ptrD[expert] = C + first_row * gemm_n;
+    input.ldA[expert] = gemm_k;
+    input.ldB[expert] = gemm_n;
+    input.ldC[expert] = 0;
+    input.ldD[expert] = gemm_n;
+}
+
+template <typename EpilogueTag>
+constexpr kernels::cutlass_kernels::GroupedGemmActivation getGroupedGemmActivation()
+{
+    using kernels::cutlass_kernels::GroupedGemmActivation;
+    if constexpr (std::is_same_v<EpilogueTag, cutlass_extensions::EpilogueOpDefaultReLU>)
+    {
+        return GroupedGemmActivation::Relu;
+    }
+    else if constexpr (std::is_same_v<EpilogueTag, cutlass_extensions::EpilogueOpDefaultFtGelu>)
+    {
+        return GroupedGemmActivation::Gelu;
+    }
+    else if constexpr (std::is_same_v<EpilogueTag, cutlass_extensions::EpilogueOpDefaultSilu>)
+    {
+        return GroupedGemmActivation::Silu;
+    }
+    else
+    {
+        static_assert(std::is_same_v<EpilogueTag, cutlass_extensions::EpilogueOpDefault>);
+        return GroupedGemmActivation::Identity;
+    }
+}
+
 template <typename T, typename WeightType>
-std::vector<cutlass_extensions::CutlassGemmConfig> MoeGemmRunner<T, WeightType>::getConfigs()
+std::vector<cutlass_extensions::CutlassGemmConfig> MoeGemmRunner<T, WeightType>::getAmpereConfigs()
 {
     static constexpr bool is_weight_only = !std::is_same<T, WeightType>::value;
     static constexpr bool only_simt_configs = std::is_same<T, float>::value;
@@ -358,6 +439,35 @@ std::vector<cutlass_extensions::CutlassGemmConfig> MoeGemmRunner<T, WeightType>:
     return candidate_configs;
 }
 
+template <typename T, typename WeightType>
+std::vector<cutlass_extensions::CutlassGemmConfig> MoeGemmRunner<T, WeightType>::getConfigs()
+{
+    std::vector<cutlass_extensions::CutlassGemmConfig> candidate_configs;
+    if constexpr (use_hopper_grouped_gemm)
+    {
+        if (sm_ == 90)
+        {
+            candidate_configs = hopper_gemm_runner_.getConfigs();
+        }
+    }
+    auto ampere_configs = getAmpereConfigs();
+    candidate_configs.insert(candidate_configs.end(), ampere_configs.begin(), ampere_configs.end());
+    return candidate_configs;
+}
+
+template <typename T, typename WeightType>
+size_t MoeGemmRunner<T, WeightType>::getWorkspaceSize(int num_experts) const
+{
+    if constexpr (use_hopper_grouped_gemm)
+    {
+        if (sm_ == 90)
+        {
+            return hopper_gemm_runner_.getWorkspaceSize(num_experts);
+        }
+    }
+    return 0;
+}
+
 template <typename T, typename WeightType>
 MoeGemmRunner<T, WeightType>::MoeGemmRunner()
 {
@@ -374,7 +484,16 @@ void MoeGemmRunner<T, WeightType>::dispatchToArch<EpilogueTag>(const T* A, const
     const T* biases, T* C, int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k,
     int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, cudaStream_t stream, int* occupancy)
 {
-    if (sm_ >= 70 && sm_ < 75)
+    if constexpr (cutlass_extensions::GatedEpilogueActivation<EpilogueTag>::value)
+    {
+        // The gated epilogues are only built for the SM80 tensor core kernels
+        TLLM_CHECK_WITH_INFO(supportsFusedGatedActivation(), "Fused gated activations are not supported on SM%d", sm_);
+        dispatchMoeGemmToCutlass<T, WeightType, cutlass::arch::Sm80, EpilogueTag>(A, B, weight_scales, biases, C,
+            total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, gemm_config, sm_, multi_processor_count_,
+            stream, occupancy);
+        return;
+    }
+    else if (sm_ >= 70 && sm_ < 75)
     {
         dispatchMoeGemmToCutlass<T, WeightType, cutlass::arch::Sm70, EpilogueTag>(A, B, weight_scales, biases, C,
             total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, gemm_config, sm_, multi_processor_count_,
@@ -405,16 +524,153 @@ void MoeGemmRunner<T, WeightType>::dispatchToArch<EpilogueTag>(const T* A, const
     }
 }
 
+template <typename T, typename WeightType>
+template <typename EpilogueTag>
+void MoeGemmRunner<T, WeightType>::runHopperGemm<EpilogueTag>(const T* A, const WeightType* B, const T* biases, T* C,
+    int64_t* total_rows_before_expert, int64_t gemm_n, int64_t gemm_k, int num_experts,
+    cutlass_extensions::CutlassGemmConfig gemm_config, char* workspace, cudaStream_t stream)
+{
+    if constexpr (use_hopper_grouped_gemm)
+    {
+        TLLM_CHECK_WITH_INFO(workspace != nullptr, "The Hopper grouped GEMM needs a workspace");
+        auto input = hopper_gemm_runner_.setupWorkspace(workspace, num_experts);
+        input.hasBias = biases != nullptr;
+        const int threads = std::min(1024, num_experts);
+        const int blocks = (num_experts + threads - 1) / threads;
+        computeHopperGroupedGemmArgsKernel<T><<<blocks, threads, 0, stream>>>(
+            total_rows_before_expert, A, B, biases, C, gemm_n, gemm_k, num_experts, input);
+        hopper_gemm_runner_.gemm(
+            input, /* weightsColumnMajor */ false, getGroupedGemmActivation<EpilogueTag>(), gemm_config, stream);
+    }
+    else
+    {
+        TLLM_THROW("The Hopper grouped GEMM only supports 16-bit activations and weights of the same type");
+    }
+}
+
+template <typename T, typename WeightType>
+template <typename EpilogueTag>
+std::optional<cutlass_extensions::CutlassGemmConfig> MoeGemmRunner<T, WeightType>::autotuneGemm<EpilogueTag>(
+    const T* A, const WeightType* B, const T* weight_scales, const T* biases, T* C, int64_t* total_rows_before_expert,
+    int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
+    std::vector<cutlass_extensions::CutlassGemmConfig> const& configs, std::vector<int> const& occupancies,
+    cudaStream_t stream)
+{
+    using AutotuneKey = std::tuple<int, std::type_index, int64_t, int64_t, int64_t, int>;
+    static std::mutex autotune_mutex;
+    static std::map<AutotuneKey, cutlass_extensions::CutlassGemmConfig> autotune_cache;
+
+    // The number of routed rows changes with every batch, the buckets keep the number of tuning runs logarithmic
+    int64_t rows_bucket = 1;
+    while (rows_bucket < total_rows)
+    {
+        rows_bucket *= 2;
+    }
+    AutotuneKey const key{sm_, std::type_index(typeid(EpilogueTag)), rows_bucket, gemm_n, gemm_k, num_experts};
+
+    std::lock_guard<std::mutex> lock(autotune_mutex);
+    if (auto const it = autotune_cache.find(key); it != autotune_cache.end())
+    {
+        return it->second;
+    }
+
+    // Timing would synchronize the host inside a CUDA graph capture, use the heuristic until an eager run tunes
+    cudaStreamCaptureStatus capture_status;
+    if (cudaStreamIsCapturing(stream, &capture_status) != cudaSuccess
+        || capture_status != cudaStreamCaptureStatusNone)
+    {
+        return std::nullopt;
+    }
+
+    // The candidates run on a private stream after the inputs are ready, the final GEMM on stream overwrites C
+    cudaStream_t tuning_stream;
+    cudaEvent_t inputs_ready, start, stop;
+    check_cuda_error(cudaStreamCreateWithFlags(&tuning_stream, cudaStreamNonBlocking));
+    check_cuda_error(cudaEventCreateWithFlags(&inputs_ready, cudaEventDisableTiming));
+    check_cuda_error(cudaEventCreate(&start));
+    check_cuda_error(cudaEventCreate(&stop));
+    check_cuda_error(cudaEventRecord(inputs_ready, stream));
+    check_cuda_error(cudaStreamWaitEvent(tuning_stream, inputs_ready));
+
+    static constexpr int kAutotuneRuns = 5;
+    std::optional<cutlass_extensions::CutlassGemmConfig> best_config;
+    float best_time = std::numeric_limits<float>::max();
+    for (size_t ii = 0; ii < configs.size(); ++ii)
+    {
+        if (occupancies[ii] == 0)
+        {
+            continue;
+        }
+        // Warm-up run, also loads the kernel module
+        dispatchToArch<EpilogueTag>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n,
+            gemm_k, num_experts, configs[ii], tuning_stream);
+        check_cuda_error(cudaEventRecord(start, tuning_stream));
+        for (int run = 0; run < kAutotuneRuns; ++run)
+        {
+            dispatchToArch<EpilogueTag>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n,
+                gemm_k, num_experts, configs[ii], tuning_stream);
+        }
+        check_cuda_error(cudaEventRecord(stop, tuning_stream));
+        check_cuda_error(cudaEventSynchronize(stop));
+        float time_ms;
+        check_cuda_error(cudaEventElapsedTime(&time_ms, start, stop));
+        if (time_ms < best_time)
+        {
+            best_time = time_ms;
+            best_config = configs[ii];
+        }
+    }
+
+    check_cuda_error(cudaEventDestroy(stop));
+    check_cuda_error(cudaEventDestroy(start));
+    check_cuda_error(cudaEventDestroy(inputs_ready));
+    check_cuda_error(cudaStreamDestroy(tuning_stream));
+
+    if (best_config)
+    {
+        TLLM_LOG_DEBUG("Autotuned MoE GEMM rows<=%ld n=%ld k=%ld experts=%d: tile %d stages %d in %f ms", rows_bucket,
+            gemm_n, gemm_k, num_experts, static_cast<int>(best_config->tile_config), best_config->stages,
+            best_time / kAutotuneRuns);
+        autotune_cache.emplace(key, *best_config);
+    }
+    return best_config;
+}
+
 template <typename T, typename WeightType>
 template <typename EpilogueTag>
 void MoeGemmRunner<T, WeightType>::runGemm<EpilogueTag>(const T* A, const WeightType* B, const T* weight_scales,
     const T* biases, T* C, int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k,
-    int num_experts, cudaStream_t stream)
+    int num_experts, char* workspace, cudaStream_t stream)
 {
     auto chosen_conf = this->best_config_;
+    if constexpr (use_hopper_grouped_gemm && !cutlass_extensions::GatedEpilogueActivation<EpilogueTag>::value)
+    {
+        const bool is_hopper_conf = chosen_conf
+            && chosen_conf->tile_config_sm90 != cutlass_extensions::CutlassTileConfigSM90::ChooseWithHeuristic;
+        if (HopperGemmRunner::isSupported(sm_, gemm_n, gemm_k) && (!chosen_conf || is_hopper_conf))
+        {
+            // The TMA kernels are persistent, there is no occupancy to pick a tile from without profiling
+            cutlass_extensions::CutlassGemmConfig hopper_conf(
+                cutlass_extensions::CutlassTileConfigSM90::CtaShape128x128x128B,
+                cutlass_extensions::MainloopScheduleType::AUTO, cutlass_extensions::EpilogueScheduleType::AUTO,
+                cutlass_extensions::ClusterShape::ClusterShape_1x1x1);
+            if (is_hopper_conf)
+            {
+                hopper_conf = *chosen_conf;
+            }
+            runHopperGemm<EpilogueTag>(A, B, biases, C, total_rows_before_expert, gemm_n, gemm_k, num_experts,
+                hopper_conf, workspace, stream);
+            return;
+        }
+        // A Hopper config profiled for the other GEMM of the MoE does not apply to an unaligned shape
+        if (is_hopper_conf)
+        {
+            chosen_conf.reset();
+        }
+    }
     if (!chosen_conf)
     {
-        auto candidate_configs = getConfigs();
+        auto candidate_configs = getAmpereConfigs();
         std::vector<int> occupancies(candidate_configs.size());
 
         for (size_t ii = 0; ii < candidate_configs.size(); ++ii)
@@ -426,10 +682,18 @@ void MoeGemmRunner<T, WeightType>::runGemm<EpilogueTag>(const T* A, const Weight
         static constexpr int workspace_bytes = 0; // No workspace for MoE GEMMs.
         static constexpr int split_k_limit = 1;   // MoE GEMM does not support split-k.
 
-        static constexpr bool is_weight_only = !std::is_same<T, WeightType>::value;
-        chosen_conf = kernels::cutlass_kernels::estimate_best_config_from_occupancies(candidate_configs, occupancies,
-            total_rows, gemm_n, gemm_k, num_experts, split_k_limit, workspace_bytes, multi_processor_count_,
-            is_weight_only);
+        if (tensorrt_llm::common::getEnvMoeGemmAutotune())
+        {
+            chosen_conf = autotuneGemm<EpilogueTag>(A, B, weight_scales, biases, C, total_rows_before_expert,
+                total_rows, gemm_n, gemm_k, num_experts, candidate_configs, occupancies, stream);
+        }
+        if (!chosen_conf)
+        {
+            static constexpr bool is_weight_only = !std::is_same<T, WeightType>::value;
+            chosen_conf = kernels::cutlass_kernels::estimate_best_config_from_occupancies(candidate_configs,
+                occupancies, total_rows, gemm_n, gemm_k, num_experts, split_k_limit, workspace_bytes,
+                multi_processor_count_, is_weight_only);
+        }
     }
     assert(chosen_conf);
     dispatchToArch<EpilogueTag>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n, gemm_k,
@@ -439,25 +703,47 @@ void MoeGemmRunner<T, WeightType>::runGemm<EpilogueTag>(const T* A, const Weight
 template <typename T, typename WeightType>
 void MoeGemmRunner<T, WeightType>::moeGemmBiasAct(const T* A, const WeightType* B, const T* weight_scales,
     const T* biases, T* C, int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k,
-    int num_experts, ActivationType activation_type, cudaStream_t stream)
+    int num_experts, ActivationType activation_type, char* workspace, cudaStream_t stream)
 {
     switch (activation_type)
     {
     case ActivationType::Relu:
-        runGemm<cutlass_extensions::EpilogueOpDefaultReLU>(
-            A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, stream);
+        runGemm<cutlass_extensions::EpilogueOpDefaultReLU>(A, B, weight_scales, biases, C, total_rows_before_expert,
+            total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
         break;
     case ActivationType::Gelu:
-        runGemm<cutlass_extensions::EpilogueOpDefaultFtGelu>(
-            A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, stream);
+        runGemm<cutlass_extensions::EpilogueOpDefaultFtGelu>(A, B, weight_scales, biases, C, total_rows_before_expert,
+            total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
         break;
     case ActivationType::Silu:
-        runGemm<cutlass_extensions::EpilogueOpDefaultSilu>(
-            A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, stream);
+        runGemm<cutlass_extensions::EpilogueOpDefaultSilu>(A, B, weight_scales, biases, C, total_rows_before_expert,
+            total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
         break;
     case ActivationType::Identity:
-        runGemm<cutlass_extensions::EpilogueOpDefault>(
-            A, B, weight_scales, biases, C, total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, stream);
+        runGemm<cutlass_extensions::EpilogueOpDefault>(A, B, weight_scales, biases, C, total_rows_before_expert,
+            total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
+        break;
+    case ActivationType::Swiglu:
+    case ActivationType::Geglu:
+        if constexpr (supports_fused_gated_activation)
+        {
+            TLLM_CHECK_WITH_INFO(supportsFusedGatedActivation(), "Fused gated activations are not supported on SM%d",
+                sm_);
+            if (activation_type == ActivationType::Swiglu)
+            {
+                runGemm<cutlass_extensions::EpilogueOpGatedSilu>(A, B, weight_scales, biases, C,
+                    total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
+            }
+            else
+            {
+                runGemm<cutlass_extensions::EpilogueOpGatedGelu>(A, B, weight_scales, biases, C,
+                    total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
+            }
+        }
+        else
+        {
+            TLLM_THROW("Fused gated activations need 16-bit activations and weights of the same type");
+        }
         break;
     case ActivationType::InvalidType: TLLM_THROW("Activation type for fpA_intB must be valid."); break;
     default: TLLM_THROW("Invalid activation type."); break;
@@ -467,10 +753,10 @@ void MoeGemmRunner<T, WeightType>::moeGemmBiasAct(const T* A, const WeightType*
 template <typename T, typename WeightType>
 void MoeGemmRunner<T, WeightType>::moeGemm(const T* A, const WeightType* B, const T* weight_scales, T* C,
     int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-    cudaStream_t stream)
+    char* workspace, cudaStream_t stream)
 {
-    runGemm<cutlass_extensions::EpilogueOpDefault>(
-        A, B, weight_scales, nullptr, C, total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, stream);
+    runGemm<cutlass_extensions::EpilogueOpDefault>(A, B, weight_scales, nullptr, C, total_rows_before_expert,
+        total_rows, gemm_n, gemm_k, num_experts, workspace, stream);
 }
 
 } // namespace tensorrt_llm
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cutlass_extensions/gemm_configs.h"
+#include "tensorrt_llm/common/quantization.h"
+#include <cuda_runtime_api.h>
+#include <vector>
+
+namespace tk = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::cutlass_extensions;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+/*
+  This runner supports 2:4 structured sparse weights, at most 2 nonzeros in every group of 4 consecutive elements of a
+  row of the weights:
+  TIn inputs (A and B) where TIn = {half, __nv_bfloat16, int8_t}
+  float scales per token and per output channel, for int8 inputs only (SmoothQuant), see quantOption
+  TOut output (D) where TOut = TIn for 16-bit inputs and TOut = {half, __nv_bfloat16} for int8 inputs
+
+  Activations, scales and outputs are all assumed to be row-major.
+  Weights are [n, k] row-major, stored compressed as their [n, k / 2] nonzeros and the metadata that locates them, see
+  compressSparseGemmWeights.
+  n must be a multiple of 32 and k a multiple of 128. Only SM80 to SM90 are supported.
+*/
+
+class CutlassSparseGemmRunnerInterface
+{
+public:
+    CutlassSparseGemmRunnerInterface() {}
+
+    virtual ~CutlassSparseGemmRunnerInterface() {}
+
+    // scaleTokens and scaleChannels are ignored for 16-bit inputs.
+    virtual void gemm(const void* A, const void* B, const void* E, tk::QuantMode quantOption, const float* scaleTokens,
+        const float* scaleChannels, void* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig,
+        char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream)
+        = 0;
+
+    // Returns desired workspace size in bytes.
+    virtual size_t getWorkspaceSize(const int m, const int n, const int k) = 0;
+
+    virtual std::vector<tkc::CutlassGemmConfig> getConfigs() const = 0;
+
+protected:
+    // The tokens are padded to a multiple of this, so that every operand of the CUTLASS kernel is vector aligned.
+    static constexpr int M_ALIGNMENT = 16;
+};
+
+template <typename TIn, typename TOut>
+class CutlassSparseGemmRunner : public virtual CutlassSparseGemmRunnerInterface
+{
+public:
+    CutlassSparseGemmRunner();
+    ~CutlassSparseGemmRunner();
+
+    void gemm(const void* A, const void* B, const void* E, tk::QuantMode quantOption, const float* scaleTokens,
+        const float* scaleChannels, void* D, int m, int n, int k, tkc::CutlassGemmConfig gemmConfig,
+        char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream) override;
+
+    // Returns desired workspace size in bytes.
+    size_t getWorkspaceSize(const int m, const int n, const int k) override;
+
+    std::vector<tkc::CutlassGemmConfig> getConfigs() const override;
+
+private:
+    int mSm;
+};
+
+// Returns the size in bytes of the metadata of a [n, k] weight of type TIn.
+template <typename TIn>
+size_t getSparseGemmMetadataSize(int n, int k);
+
+// Compresses the row-major [n, k] weight dense on the host into its [n, k / 2] nonzeros and their metadata, in the
+// layout read by CutlassSparseGemmRunner. If prune is set, the 2 elements of largest magnitude of every group of 4 are
+// kept, else a group with more than 2 nonzeros is an error.
+template <typename TIn>
+void compressSparseGemmWeights(TIn* compressed, void* metadata, const TIn* dense, int n, int k, bool prune);
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
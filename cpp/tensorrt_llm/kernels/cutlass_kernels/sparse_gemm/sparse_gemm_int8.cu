@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2020-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/cutlass_kernels/sparse_gemm/sparse_gemm_template.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+template class CutlassSparseGemmRunner<int8_t, half>;
+#ifdef ENABLE_BF16
+template class CutlassSparseGemmRunner<int8_t, __nv_bfloat16>;
+#endif
+template size_t getSparseGemmMetadataSize<int8_t>(int n, int k);
+template void compressSparseGemmWeights<int8_t>(
+    int8_t* compressed, void* metadata, const int8_t* dense, int n, int k, bool prune);
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
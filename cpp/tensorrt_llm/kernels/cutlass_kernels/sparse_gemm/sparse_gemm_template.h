@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2020-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#endif // #ifndef _WIN32
+
+// clang-format off
+#include <cutlass/epilogue/thread/linear_combination.h>
+#include <cutlass/gemm/device/gemm_sparse.h>
+#include <cutlass/util/host_reorder.h>
+// clang-format on
+
+#include "cutlass_extensions/gemm_configs.h"
+
+#ifndef _WIN32
+#pragma GCC diagnostic pop
+#endif // #ifndef _WIN32
+
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/workspace.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_type_conversion.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/sparse_gemm/sparse_gemm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace tk = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::cutlass_extensions;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace cutlass_kernels
+{
+
+// Sparse tensor core instruction of the input type. The 16-bit inputs accumulate in float and the GEMM writes TOut
+// directly, the int8 inputs accumulate in int32, which the finalize kernel scales to TOut.
+template <typename TIn, typename TOut>
+struct SparseGemmTraits
+{
+    using ElementInput = typename TllmToCutlassTypeAdapter<TIn>::type;
+    using ElementAccumulator = float;
+    using ElementGemmOutput = typename TllmToCutlassTypeAdapter<TOut>::type;
+    using Operator = cutlass::arch::OpMultiplyAdd;
+    using InstructionShape = cutlass::gemm::GemmShape<16, 8, 32>;
+    // The K of the tiles of the configs is multiplied by this, the sparse int8 instruction is twice as deep
+    static constexpr int kTileKScale = 1;
+};
+
+template <typename TOut>
+struct SparseGemmTraits<int8_t, TOut>
+{
+    using ElementInput = int8_t;
+    using ElementAccumulator = int32_t;
+    using ElementGemmOutput = int32_t;
+    using Operator = cutlass::arch::OpMultiplyAddSaturate;
+    using InstructionShape = cutlass::gemm::GemmShape<16, 8, 64>;
+    static constexpr int kTileKScale = 2;
+};
+
+// The sparse operand of CUTLASS is A, so the weights are A and the GEMM computes the [n, m] transpose of the output,
+// the only output layout of the sparse kernels is row-major.
+template <typename TIn, typename TOut, typename ThreadblockShape, typename WarpShape, int Stages>
+struct SparseGemmKernel
+{
+    using Traits = SparseGemmTraits<TIn, TOut>;
+    using ElementInput = typename Traits::ElementInput;
+    using ElementOutput = typename Traits::ElementGemmOutput;
+    using ElementAccumulator = typename Traits::ElementAccumulator;
+
+    static constexpr int kAlignmentInput = 128 / cutlass::sizeof_bits<ElementInput>::value;
+    static constexpr int kAlignmentOutput = 128 / cutlass::sizeof_bits<ElementOutput>::value;
+
+    using EpilogueOp = cutlass::epilogue::thread::LinearCombination<ElementOutput, kAlignmentOutput,
+        ElementAccumulator, ElementAccumulator>;
+
+    using Gemm = cutlass::gemm::device::SparseGemm<ElementInput, cutlass::layout::RowMajor, ElementInput,
+        cutlass::layout::ColumnMajor, ElementOutput, cutlass::layout::RowMajor, ElementAccumulator,
+        cutlass::arch::OpClassTensorOp, cutlass::arch::Sm80, ThreadblockShape, WarpShape,
+        typename Traits::InstructionShape, EpilogueOp, cutlass::gemm::threadblock::GemmIdentityThreadblockSwizzle<>,
+        Stages, kAlignmentInput, kAlignmentInput, false, typename Traits::Operator>;
+};
+
+// The metadata format only depends on the input type, any tile gives it.
+template <typename TIn>
+using SparseGemmMetaGemm = typename SparseGemmKernel<TIn, TIn,
+    cutlass::gemm::GemmShape<128, 128, 64 * SparseGemmTraits<TIn, TIn>::kTileKScale>,
+    cutlass::gemm::GemmShape<64, 64, 64 * SparseGemmTraits<TIn, TIn>::kTileKScale>, 3>::Gemm;
+
+template <typename TIn, typename TOut, typename ThreadblockShape, typename WarpShape, int Stages>
+void genericSparseGemmKernelLauncher(const TIn* A, const TIn* B, const void* E,
+    typename SparseGemmTraits<TIn, TOut>::ElementGemmOutput* D, int m, int n, int k, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+
+    using Kernel = SparseGemmKernel<TIn, TOut, ThreadblockShape, WarpShape, Stages>;
+    using Gemm = typename Kernel::Gemm;
+    using ElementInput = typename Kernel::ElementInput;
+    using ElementAccumulator = typename Kernel::ElementAccumulator;
+    using ElementE = typename Gemm::ElementE;
+
+    int const metaColumns = k / Gemm::kSparse / Gemm::kElementsPerElementE;
+
+    // Problem {n, m, k}: the [n, k] sparse weights times the [k, m] column-major view of the row-major activations
+    typename Gemm::Arguments args{{n, m, k},
+        {reinterpret_cast<ElementInput*>(const_cast<TIn*>(B)), k / Gemm::kSparse},
+        {reinterpret_cast<ElementInput*>(const_cast<TIn*>(A)), k}, {D, m}, {D, m},
+        {reinterpret_cast<ElementE*>(const_cast<void*>(E)),
+            Gemm::LayoutE::packed(cutlass::MatrixCoord(n, metaColumns))},
+        {ElementAccumulator(1), ElementAccumulator(0)}, 1};
+
+    Gemm gemm;
+    auto can_implement = gemm.can_implement(args);
+    if (can_implement != cutlass::Status::kSuccess)
+    {
+        std::string errMsg = "sparse gemm cutlass kernel will fail for params. Error: "
+            + std::string(cutlassGetStatusString(can_implement));
+        throw std::runtime_error("[TensorRT-LLM Error][sparse gemm Runner] " + errMsg);
+    }
+
+    // Without serial split-k the kernel needs no workspace.
+    auto initStatus = gemm.initialize(args, nullptr, stream);
+    if (initStatus != cutlass::Status::kSuccess)
+    {
+        std::string errMsg
+            = "Failed to initialize cutlass sparse gemm. Error: " + std::string(cutlassGetStatusString(initStatus));
+        throw std::runtime_error("[TensorRT-LLM Error][sparse gemm Runner] " + errMsg);
+    }
+
+    auto runStatus = gemm.run(stream);
+    if (runStatus != cutlass::Status::kSuccess)
+    {
+        std::string errMsg
+            = "Failed to run cutlass sparse gemm. Error: " + std::string(cutlassGetStatusString(runStatus));
+        throw std::runtime_error("[TensorRT-LLM Error][sparse gemm Runner] " + errMsg);
+    }
+}
+
+template <typename TIn, typename TOut, typename ThreadblockShape, typename WarpShape>
+void dispatchGemmConfig(const TIn* A, const TIn* B, const void* E,
+    typename SparseGemmTraits<TIn, TOut>::ElementGemmOutput* D, int m, int n, int k,
+    tkc::CutlassGemmConfig gemmConfig, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    // The sparse multistage mainloop needs at least 3 stages.
+    switch (gemmConfig.stages)
+    {
+    case 3:
+        genericSparseGemmKernelLauncher<TIn, TOut, ThreadblockShape, WarpShape, 3>(A, B, E, D, m, n, k, stream);
+        break;
+    case 4:
+        genericSparseGemmKernelLauncher<TIn, TOut, ThreadblockShape, WarpShape, 4>(A, B, E, D, m, n, k, stream);
+        break;
+    default:
+        std::string errMsg = "dispatchGemmConfig does not support stages " + std::to_string(gemmConfig.stages);
+        throw std::runtime_error("[TensorRT-LLM Error][sparse][dispatch_gemm_config] " + errMsg);
+        break;
+    }
+}
+
+template <typename TIn, typename TOut>
+void dispatchGemmToCutlass(const TIn* A, const TIn* B, const void* E,
+    typename SparseGemmTraits<TIn, TOut>::ElementGemmOutput* D, int m, int n, int k,
+    tkc::CutlassGemmConfig gemmConfig, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+
+    static constexpr int kK = 64 * SparseGemmTraits<TIn, TOut>::kTileKScale;
+
+    // The M of the tiles is the one of the weights, their N the one of the tokens.
+    switch (gemmConfig.tile_config)
+    {
+    case tkc::CutlassTileConfig::CtaShape64x128x64_WarpShape32x64x64:
+        dispatchGemmConfig<TIn, TOut, cutlass::gemm::GemmShape<64, 128, kK>, cutlass::gemm::GemmShape<32, 64, kK>>(
+            A, B, E, D, m, n, k, gemmConfig, stream);
+        break;
+    case tkc::CutlassTileConfig::CtaShape128x64x64_WarpShape64x32x64:
+        dispatchGemmConfig<TIn, TOut, cutlass::gemm::GemmShape<128, 64, kK>, cutlass::gemm::GemmShape<64, 32, kK>>(
+            A, B, E, D, m, n, k, gemmConfig, stream);
+        break;
+    case tkc::CutlassTileConfig::CtaShape128x128x64_WarpShape64x64x64:
+        dispatchGemmConfig<TIn, TOut, cutlass::gemm::GemmShape<128, 128, kK>, cutlass::gemm::GemmShape<64, 64, kK>>(
+            A, B, E, D, m, n, k, gemmConfig, stream);
+        break;
+    case tkc::CutlassTileConfig::CtaShape128x256x64_WarpShape64x64x64:
+        dispatchGemmConfig<TIn, TOut, cutlass::gemm::GemmShape<128, 256, kK>, cutlass::gemm::GemmShape<64, 64, kK>>(
+            A, B, E, D, m, n, k, gemmConfig, stream);
+        break;
+    case tkc::CutlassTileConfig::CtaShape256x128x64_WarpShape64x64x64:
+        dispatchGemmConfig<TIn, TOut, cutlass::gemm::GemmShape<256, 128, kK>, cutlass::gemm::GemmShape<64, 64, kK>>(
+            A, B, E, D, m, n, k, gemmConfig, stream);
+        break;
+    case tkc::CutlassTileConfig::Undefined:
+        throw std::runtime_error("[TensorRT-LLM Error][sparse][dispatch_gemm_to_cutlass] gemm config undefined.");
+        break;
+    case tkc::CutlassTileConfig::ChooseWithHeuristic:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][sparse][dispatch_gemm_to_cutlass] gemm config should have already been set by "
+            "heuristic.");
+        break;
+    default:
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][sparse][dispatch_gemm_to_cutlass] Config is invalid for sparse GEMM.");
+        break;
+    }
+}
+
+static constexpr int kSparseGemmFinalizeTile = 32;
+
+// Transposes the [n, mPadded] product of the GEMM into the [m, n] output and applies the SmoothQuant scales if any.
+// The tile goes through shared memory so that both the reads and the writes are coalesced.
+template <typename TGemmOut, typename TOut>
+__global__ void sparseGemmFinalizeKernel(TOut* out, const TGemmOut* gemmOut, const float* scaleTokens,
+    const float* scaleChannels, bool perToken, bool perChannel, int m, int mPadded, int n)
+{
+    __shared__ float tile[kSparseGemmFinalizeTile][kSparseGemmFinalizeTile + 1];
+
+    int const tokenBase = blockIdx.x * kSparseGemmFinalizeTile;
+    int const channelBase = blockIdx.y * kSparseGemmFinalizeTile;
+
+    for (int i = threadIdx.y; i < kSparseGemmFinalizeTile; i += blockDim.y)
+    {
+        int const channel = channelBase + i;
+        int const token = tokenBase + threadIdx.x;
+        if (channel < n && token < m)
+        {
+            tile[i][threadIdx.x] = cuda_cast<float>(gemmOut[static_cast<size_t>(channel) * mPadded + token]);
+        }
+    }
+    __syncthreads();
+
+    for (int i = threadIdx.y; i < kSparseGemmFinalizeTile; i += blockDim.y)
+    {
+        int const token = tokenBase + i;
+        int const channel = channelBase + threadIdx.x;
+        if (token < m && channel < n)
+        {
+            float value = tile[threadIdx.x][i];
+            if (scaleTokens != nullptr)
+            {
+                value *= scaleTokens[perToken ? token : 0];
+            }
+            if (scaleChannels != nullptr)
+            {
+                value *= scaleChannels[perChannel ? channel : 0];
+            }
+            out[static_cast<size_t>(token) * n + channel] = cuda_cast<TOut>(value);
+        }
+    }
+}
+
+template <typename TIn, typename TOut>
+CutlassSparseGemmRunner<TIn, TOut>::CutlassSparseGemmRunner()
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    mSm = tk::getSMVersion();
+}
+
+template <typename TIn, typename TOut>
+CutlassSparseGemmRunner<TIn, TOut>::~CutlassSparseGemmRunner()
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+}
+
+template <typename TIn, typename TOut>
+void CutlassSparseGemmRunner<TIn, TOut>::gemm(const void* A, const void* B, const void* E, tk::QuantMode quantOption,
+    const float* scaleTokens, const float* scaleChannels, void* D, int m, int n, int k,
+    tkc::CutlassGemmConfig gemmConfig, char* workspacePtr, const size_t workspaceBytes, cudaStream_t stream)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    // The sparse tensor cores of Ampere are also those of Hopper, which has no sparse GMMA kernel in CUTLASS 2.
+    if (mSm < 80 || mSm > 90)
+    {
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][CutlassSparseGemmRunner][GEMM Dispatch] Arch unsupported for CUTLASS sparse GEMM");
+    }
+
+    using TGemmOut =
+        typename CutlassToTllmTypeAdapter<typename SparseGemmTraits<TIn, TOut>::ElementGemmOutput>::type;
+
+    int const mPadded = tk::roundUp(m, M_ALIGNMENT);
+    auto* base = reinterpret_cast<int8_t*>(workspacePtr);
+    uintptr_t offset = 0;
+    auto* paddedA = reinterpret_cast<TIn*>(
+        tk::nextWorkspacePtr(base, offset, mPadded == m ? 0 : static_cast<size_t>(mPadded) * k * sizeof(TIn)));
+    auto* gemmOut = reinterpret_cast<TGemmOut*>(
+        tk::nextWorkspacePtr(base, offset, static_cast<size_t>(n) * mPadded * sizeof(TGemmOut)));
+    if (offset > workspaceBytes)
+    {
+        throw std::runtime_error("[TensorRT-LLM Error][CutlassSparseGemmRunner] Workspace size insufficient");
+    }
+
+    // The tokens beyond m are zeros, their columns of the product are dropped by the finalize kernel.
+    auto const* activations = reinterpret_cast<const TIn*>(A);
+    if (paddedA != nullptr)
+    {
+        size_t const actBytes = static_cast<size_t>(m) * k * sizeof(TIn);
+        tk::check_cuda_error(cudaMemcpyAsync(paddedA, A, actBytes, cudaMemcpyDeviceToDevice, stream));
+        tk::check_cuda_error(cudaMemsetAsync(
+            paddedA + static_cast<size_t>(m) * k, 0, static_cast<size_t>(mPadded - m) * k * sizeof(TIn), stream));
+        activations = paddedA;
+    }
+
+    dispatchGemmToCutlass<TIn, TOut>(activations, reinterpret_cast<const TIn*>(B), E,
+        reinterpret_cast<typename SparseGemmTraits<TIn, TOut>::ElementGemmOutput*>(gemmOut), mPadded, n, k,
+        gemmConfig, stream);
+
+    bool const scaled = std::is_same<TIn, int8_t>::value;
+    dim3 const block(kSparseGemmFinalizeTile, 8);
+    dim3 const grid(tk::divUp(m, kSparseGemmFinalizeTile), tk::divUp(n, kSparseGemmFinalizeTile));
+    sparseGemmFinalizeKernel<TGemmOut, TOut><<<grid, block, 0, stream>>>(reinterpret_cast<TOut*>(D), gemmOut,
+        scaled ? scaleTokens : nullptr, scaled ? scaleChannels : nullptr, quantOption.hasPerTokenScaling(),
+        quantOption.hasPerChannelScaling(), m, mPadded, n);
+    tk::sync_check_cuda_error();
+}
+
+template <typename TIn, typename TOut>
+std::vector<tkc::CutlassGemmConfig> CutlassSparseGemmRunner<TIn, TOut>::getConfigs() const
+{
+    std::vector<tkc::CutlassGemmConfig> candidateConfigs;
+    for (auto const tileConfig : {tkc::CutlassTileConfig::CtaShape64x128x64_WarpShape32x64x64,
+             tkc::CutlassTileConfig::CtaShape128x64x64_WarpShape64x32x64,
+             tkc::CutlassTileConfig::CtaShape128x128x64_WarpShape64x64x64,
+             tkc::CutlassTileConfig::CtaShape128x256x64_WarpShape64x64x64,
+             tkc::CutlassTileConfig::CtaShape256x128x64_WarpShape64x64x64})
+    {
+        for (int const stages : {3, 4})
+        {
+            candidateConfigs.emplace_back(tileConfig, tkc::SplitKStyle::NO_SPLIT_K, 1, stages);
+        }
+    }
+    return candidateConfigs;
+}
+
+template <typename TIn, typename TOut>
+size_t CutlassSparseGemmRunner<TIn, TOut>::getWorkspaceSize(const int m, const int n, const int k)
+{
+    TLLM_LOG_DEBUG(__PRETTY_FUNCTION__);
+    using TGemmOut =
+        typename CutlassToTllmTypeAdapter<typename SparseGemmTraits<TIn, TOut>::ElementGemmOutput>::type;
+    // The padded activations, if m is not aligned, and the transposed product.
+    size_t const mPadded = tk::roundUp(m, M_ALIGNMENT);
+    size_t workspaces[2];
+    workspaces[0] = mPadded == static_cast<size_t>(m) ? 0 : mPadded * k * sizeof(TIn);
+    workspaces[1] = mPadded * n * sizeof(TGemmOut);
+    return tk::calculateTotalWorkspaceSize(workspaces, 2);
+}
+
+template <typename TIn>
+size_t getSparseGemmMetadataSize(int n, int k)
+{
+    using Gemm = SparseGemmMetaGemm<TIn>;
+    return static_cast<size_t>(n) * (k / Gemm::kSparse / Gemm::kElementsPerElementE) * sizeof(typename Gemm::ElementE);
+}
+
+template <typename TIn>
+void compressSparseGemmWeights(TIn* compressed, void* metadata, const TIn* dense, int n, int k, bool prune)
+{
+    using Gemm = SparseGemmMetaGemm<TIn>;
+    using ElementE = typename Gemm::ElementE;
+    static_assert(Gemm::kSparse == 2 && Gemm::kMetaSizeInBits == 2, "Only 2:4 sparsity is supported");
+
+    // The rows of the metadata are interleaved by groups of 32 and the K of the tiles is up to 128.
+    if (n % 32 != 0 || k % 128 != 0)
+    {
+        throw std::runtime_error(
+            "[TensorRT-LLM Error][compressSparseGemmWeights] n must be a multiple of 32 and k a multiple of 128");
+    }
+
+    static constexpr int kGroupSize = 4;
+    int const compressedK = k / Gemm::kSparse;
+    int const metaColumns = compressedK / Gemm::kElementsPerElementE;
+    std::vector<ElementE> meta(static_cast<size_t>(n) * metaColumns, ElementE(0));
+
+    for (int row = 0; row < n; ++row)
+    {
+        for (int group = 0; group < k / kGroupSize; ++group)
+        {
+            const TIn* values = dense + static_cast<size_t>(row) * k + group * kGroupSize;
+            float magnitudes[kGroupSize];
+            for (int i = 0; i < kGroupSize; ++i)
+            {
+                magnitudes[i] = std::abs(static_cast<float>(values[i]));
+            }
+
+            // Positions of the 2 kept elements in the group, in increasing order as the sparse MMA requires.
+            int kept[2];
+            if (prune)
+            {
+                int order[kGroupSize] = {0, 1, 2, 3};
+                std::stable_sort(
+                    order, order + kGroupSize, [&magnitudes](int a, int b) { return magnitudes[a] > magnitudes[b]; });
+                kept[0] = std::min(order[0], order[1]);
+                kept[1] = std::max(order[0], order[1]);
+            }
+            else
+            {
+                int numNonzeros = 0;
+                for (int i = 0; i < kGroupSize; ++i)
+                {
+                    if (magnitudes[i] != 0.f)
+                    {
+                        if (numNonzeros == 2)
+                        {
+                            throw std::runtime_error("[TensorRT-LLM Error][compressSparseGemmWeights] Row "
+                                + std::to_string(row) + " has more than 2 nonzeros in the group of 4 at column "
+                                + std::to_string(group * kGroupSize));
+                        }
+                        kept[numNonzeros++] = i;
+                    }
+                }
+                // Zeros fill the free positions
+                for (int i = 0; numNonzeros < 2; ++i)
+                {
+                    if (numNonzeros == 0 || kept[0] != i)
+                    {
+                        kept[numNonzeros++] = i;
+                    }
+                }
+                if (kept[0] > kept[1])
+                {
+                    std::swap(kept[0], kept[1]);
+                }
+            }
+
+            for (int j = 0; j < 2; ++j)
+            {
+                int const column = group * Gemm::kSparse + j;
+                compressed[static_cast<size_t>(row) * compressedK + column] = values[kept[j]];
+                meta[static_cast<size_t>(row) * metaColumns + column / Gemm::kElementsPerElementE]
+                    |= static_cast<ElementE>(static_cast<ElementE>(kept[j])
+                        << (Gemm::kMetaSizeInBits * (column % Gemm::kElementsPerElementE)));
+            }
+        }
+    }
+
+    // The sparse MMA reads the metadata of the rows in an interleaved order.
+    cutlass::reorder_meta(cutlass::TensorRef<ElementE, typename Gemm::LayoutE>(static_cast<ElementE*>(metadata),
+                              Gemm::LayoutE::packed(cutlass::MatrixCoord(n, metaColumns))),
+        cutlass::TensorRef<ElementE, cutlass::layout::RowMajor>(meta.data(), cutlass::layout::RowMajor(metaColumns)),
+        cutlass::gemm::GemmCoord(n, 0, metaColumns));
+}
+
+} // namespace cutlass_kernels
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -124,8 +124,13 @@ struct Multihead_attention_params_base
     RotaryScalingType rotary_embedding_scale_type = RotaryScalingType::kNONE;
     float rotary_embedding_scale = 0.0f;
     int rotary_embedding_max_positions = 0;
+    // Precomputed [positions, rotary_embedding_dim / 2] {cos, sin} table, nullptr to compute it on the fly.
+    const float2* rotary_embedding_cos_sin = nullptr;
     // Position shift for streamingllm
     bool position_shift_enabled = false;
+    // The bias, the rotary embedding and the KV cache write of the new token were done by
+    // invokeApplyBiasRopeUpdateKVCache. q, k and v hold the final values and the kernel only reads the KV cache.
+    bool qkv_preprocessed = false;
     // The current timestep. TODO Check that do we only this param in cross attention?
     int timestep = 0;
     // The current timestep of each sentences (support different timestep for different sentences)
@@ -153,6 +158,12 @@ struct Multihead_attention_params_base
 
     bool int8_kv_cache = false;
     bool fp8_kv_cache = false;
+    // The 8bits kv cache holds one scale per sequence and kv head in each block instead of kv_scale_*.
+    bool kv_cache_dynamic_scales = false;
+    // With attention-guided KV cache eviction, the cache slot of the new token per sequence and kv head, see
+    // invokeSelectKVCacheEvictionSlots. The kernel then adds the attention probabilities to the mass of the cached
+    // tokens. Needs the paged KV cache and no multi-block mode.
+    const int* kv_eviction_write_slots = nullptr;
 
     // Multi-block setups
     mutable bool multi_block_mode = false;
@@ -160,6 +171,8 @@ struct Multihead_attention_params_base
     // Number of streaming processors on the device.
     // Tune block size to maximum occupancy.
     int multi_processor_count = 1;
+    // The SM version of the device, selects the multi-block tuning of the GPU.
+    int sm_version = 0;
 
     mutable int timesteps_per_block = -1;
     mutable int seq_len_tile = -1;
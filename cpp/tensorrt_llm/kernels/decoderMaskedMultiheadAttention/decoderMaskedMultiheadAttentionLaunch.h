@@ -91,6 +91,29 @@ inline size_t smem_size_in_bytes(const Multihead_attention_params<T, DO_CROSS_AT
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// The fewest timesteps a block of the multi-block mode should process on each GPU architecture. Below it, the extra
+// blocks and the final reduction cost more than the parallel K/V loads save. Architectures missing from the table use
+// the entry of the closest older one.
+inline int multi_block_min_timesteps_per_block(int sm_version)
+{
+    struct TuningEntry
+    {
+        int sm_version;
+        int min_timesteps_per_block;
+    };
+
+    static constexpr TuningEntry kTuningTable[] = {{70, 256}, {80, 256}, {86, 128}, {89, 128}, {90, 512}};
+    int min_timesteps_per_block = kTuningTable[0].min_timesteps_per_block;
+    for (auto const& entry : kTuningTable)
+    {
+        if (entry.sm_version <= sm_version)
+        {
+            min_timesteps_per_block = entry.min_timesteps_per_block;
+        }
+    }
+    return min_timesteps_per_block;
+}
+
 template <typename T, int Dh, bool DO_CROSS_ATTENTION>
 inline void multi_block_grid_setup(dim3& grid, const Multihead_attention_params<T, DO_CROSS_ATTENTION>& params,
     int blocks_per_sm, int block_size, int tlength)
@@ -104,8 +127,10 @@ inline void multi_block_grid_setup(dim3& grid, const Multihead_attention_params<
         = mmha::divUp(params.multi_processor_count * blocks_per_sm, params.batch_size * params.num_heads);
 
     const int threads_per_value = mmha::threads_per_value<T>(mmha::dh_max(Dh));
-    // Make sure that each block at least processes one loop of kv (unroll size is default at 8).
-    const int seq_len_per_kv_loop = mmha::divUp(block_size, threads_per_value) * 8;
+    // Make sure that each block at least processes one loop of kv (unroll size is default at 8), and enough timesteps
+    // for the split to pay off on this GPU.
+    const int seq_len_per_kv_loop = std::max(
+        mmha::divUp(block_size, threads_per_value) * 8, multi_block_min_timesteps_per_block(params.sm_version));
     int max_seq_len_tile = params.max_seq_len_tile;
 
     const bool multi_block_debug_flag = getEnvMmhaMultiblockDebug();
@@ -119,6 +144,8 @@ inline void multi_block_grid_setup(dim3& grid, const Multihead_attention_params<
     else
     {
         max_seq_len_tile = std::min(mmha::divUp(tlength + 1, seq_len_per_kv_loop), max_seq_len_tile);
+        // The shared memory still bounds the timesteps per block from above.
+        max_seq_len_tile = std::max(max_seq_len_tile, params.min_seq_len_tile);
     }
 
     params.seq_len_tile = std::clamp(balanced_seq_len_tile, params.min_seq_len_tile, max_seq_len_tile);
@@ -126,7 +153,8 @@ inline void multi_block_grid_setup(dim3& grid, const Multihead_attention_params<
     TLLM_CHECK_WITH_INFO(
         params.seq_len_tile <= block_size, "The number of blocks per sequence may not exceed the thread block size.");
 
-    // We should consider the new timestep.
+    // We should consider the new timestep. tlength is the longest sequence of the batch, the kernel skips the tiles
+    // past the end of the shorter ones so that they are not split more than they need.
     params.timesteps_per_block = mmha::divUp(tlength + 1, params.seq_len_tile);
 
     params.multi_block_mode = (params.seq_len_tile > 1);
@@ -1481,8 +1481,10 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         ? params.memory_length_per_sample[batch_beam_idx] - 1
         : (params.length_per_sample ? (params.length_per_sample[batch_beam_idx] - 1) : static_cast<int>(timestep));
     // We will use cyclic kv cache when it exceeds the limit.
-    // The length position for storing new key and value.
-    const int cyclic_tlength = kvCacheBuffer.getKVTokenIdx(tlength);
+    // The length position for storing new key and value, chosen per kv head beforehand with KV cache eviction.
+    const int cyclic_tlength = params.kv_eviction_write_slots != nullptr
+        ? params.kv_eviction_write_slots[batch_beam_idx * params.num_kv_heads + hi_kv]
+        : kvCacheBuffer.getKVTokenIdx(tlength);
     // When enable cyclic kv cache and one more block mode, we need to shift the index to the actual index in the
     // sequence. Otherwise, if the token is not the sink token, we need to add the bubblen length to the index.
     const bool enable_use_seq_idx_kv = kvCacheBuffer.mEnableOneMoreBlock && tlength > cyclic_kv_cache_len;
@@ -1491,6 +1493,14 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     // The actual kv cache length.
     // tlength is the past length actually.
     const int kv_loop_length = min(tlength, cyclic_kv_cache_len);
+    // The timesteps per block are set by the longest sequence of the batch, so shorter sequences use fewer tiles. The
+    // tiles past the one holding the current timestep have nothing to attend and are left out of the reduction.
+    const unsigned num_seq_tiles{
+        MULTI_BLOCK_FLAG ? min(static_cast<unsigned>(tlength) / params.timesteps_per_block + 1, gridDim.z) : 1u};
+    if (MULTI_BLOCK_FLAG && c_tile >= num_seq_tiles)
+    {
+        return;
+    }
     // The context length for beam searching optimization (all points to beam 0).
     // TODO: with cyclic kv cache, we set it 0 for now (will optimize in the future)
     // as context kv cache might be overwritten by the new kv cache
@@ -1508,11 +1518,33 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
     // Quant/Dequant scales for 8bits kv cache.
     using T_scale = typename kv_cache_scale_type_t<T, Tcache>::Type;
-    T_scale kv_scale_orig_quant, k_scale_quant_orig;
-    const float k_scale_quant_orig_f = (ENABLE_8BITS_K_CACHE ? params.kv_scale_quant_orig[0] : 1.0f);
-    const float kv_scale_quant_orig_f = (ENABLE_8BITS_KV_CACHE ? params.kv_scale_quant_orig[0] : 1.0f);
+    // With dynamic scales, K and V have their own scale per sequence and kv head, stored in every block of the
+    // sequence by the context phase. kv_scale_* then refer to V only.
+    const bool dynamic_kv_scales = ENABLE_8BITS_KV_CACHE && params.kv_cache_dynamic_scales;
+    float* k_dynamic_scales = nullptr;
+    float* v_dynamic_scales = nullptr;
+    if (dynamic_kv_scales)
+    {
+        const int tokens_per_block = kvCacheBuffer.getTokensPerBlock();
+        k_dynamic_scales = getKVDynamicScalePtr(
+            kvCacheBuffer.getKBlockPtr(batch_beam_idx, 0), params.num_kv_heads, tokens_per_block, Dh);
+        v_dynamic_scales = getKVDynamicScalePtr(
+            kvCacheBuffer.getVBlockPtr(batch_beam_idx, 0), params.num_kv_heads, tokens_per_block, Dh);
+    }
+    T_scale kv_scale_orig_quant, k_scale_orig_quant, k_scale_quant_orig;
+    const float k_scale_quant_orig_f = dynamic_kv_scales
+        ? k_dynamic_scales[hi_kv]
+        : (ENABLE_8BITS_K_CACHE ? params.kv_scale_quant_orig[0] : 1.0f);
+    const float kv_scale_quant_orig_f = dynamic_kv_scales
+        ? v_dynamic_scales[hi_kv]
+        : (ENABLE_8BITS_KV_CACHE ? params.kv_scale_quant_orig[0] : 1.0f);
     convert_from_float(&k_scale_quant_orig, k_scale_quant_orig_f);
-    convert_from_float(&kv_scale_orig_quant, (ENABLE_8BITS_KV_CACHE ? params.kv_scale_orig_quant[0] : 1.0f));
+    convert_from_float(&k_scale_orig_quant,
+        dynamic_kv_scales ? 1.f / k_scale_quant_orig_f
+                          : (ENABLE_8BITS_KV_CACHE ? params.kv_scale_orig_quant[0] : 1.0f));
+    convert_from_float(&kv_scale_orig_quant,
+        dynamic_kv_scales ? 1.f / kv_scale_quant_orig_f
+                          : (ENABLE_8BITS_KV_CACHE ? params.kv_scale_orig_quant[0] : 1.0f));
 
     // Up to QK_VECS_PER_Dh_MAX threads load Q and K + the bias values for the current timestep.
     // Trigger the loads from the Q and K buffers.
@@ -1554,7 +1586,7 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         if constexpr (DO_CROSS_ATTENTION)
         {
             const auto k_idx = QK_VEC_SIZE * tidx;
-            const int inBlockIdx = kvCacheBuffer.getKVLocalIdx(cyclic_tlength, hi, Dh, k_idx);
+            const int inBlockIdx = kvCacheBuffer.template getKLocalIdx<Tcache>(cyclic_tlength, hi, Dh, k_idx);
             Tcache* k_cache = reinterpret_cast<Tcache*>(kvCacheBuffer.getKBlockPtr(batch_beam_idx, cyclic_tlength));
 
             k = vec_conversion<Qk_vec_k, Qk_vec_m>(*reinterpret_cast<const Qk_vec_m*>(&k_cache[inBlockIdx]));
@@ -1625,7 +1657,10 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     k_wo_pos = k;
 
     // Note we have no paddings in KV cache now.
-    switch (params.position_embedding_type)
+    // Preprocessed Q and K already carry the rotary embedding.
+    const auto position_embedding_type
+        = params.qkv_preprocessed ? PositionEmbeddingType::kLEARNED_ABSOLUTE : params.position_embedding_type;
+    switch (position_embedding_type)
     {
     case PositionEmbeddingType::kLEARNED_ABSOLUTE:
     case PositionEmbeddingType::kRELATIVE:
@@ -1639,12 +1674,12 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         if (HANDLE_KV)
         {
             apply_rotary_embedding(q, k, tidx, params.rotary_embedding_dim, params.rotary_embedding_base,
-                params.rotary_embedding_scale, current_pos_idx);
+                params.rotary_embedding_scale, current_pos_idx, params.rotary_embedding_cos_sin);
         }
         else
         {
             apply_rotary_embedding(q, tidx, params.rotary_embedding_dim, params.rotary_embedding_base,
-                params.rotary_embedding_scale, current_pos_idx);
+                params.rotary_embedding_scale, current_pos_idx, params.rotary_embedding_cos_sin);
         }
         break;
     }
@@ -1683,14 +1718,14 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 mmha::vec_from_smem_transpose(k, k_smem_, transpose_idx, smem_pitch);
 
                 mmha::apply_rotary_embedding(q, k, transpose_idx / tidx_factor, params.rotary_embedding_dim,
-                    rotary_embedding_base, rotary_embedding_scale, current_pos_idx);
+                    rotary_embedding_base, rotary_embedding_scale, current_pos_idx, params.rotary_embedding_cos_sin);
 
                 mmha::write_smem_transpose(k, k_smem_, transpose_idx, smem_pitch);
             }
             else
             {
                 mmha::apply_rotary_embedding(q, transpose_idx / tidx_factor, params.rotary_embedding_dim,
-                    rotary_embedding_base, rotary_embedding_scale, current_pos_idx);
+                    rotary_embedding_base, rotary_embedding_scale, current_pos_idx, params.rotary_embedding_cos_sin);
             }
             mmha::write_smem_transpose(q, q_smem_, transpose_idx, smem_pitch);
         }
@@ -1931,7 +1966,7 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 // Base pointer to k cache block for beam's batch
                 TKcache* k_cache_batch = reinterpret_cast<TKcache*>(pastKCache.getKBlockPtr(seqIdx, valid_time_now));
 
-                int inBlockIdx = pastKCache.getKVLocalIdx(valid_time_now, hi_kv, Dh, jj);
+                int inBlockIdx = pastKCache.template getKLocalIdx<TKcache>(valid_time_now, hi_kv, Dh, jj);
                 k_vec_cache[k_loop][k_vec_i] = *reinterpret_cast<const K_vec_m*>(&k_cache_batch[inBlockIdx]);
             }
         }
@@ -2077,7 +2112,7 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 // Base pointer to k cache block for beam's batch, before offsetting with indirection buffer
                 TKcache* k_cache_batch = reinterpret_cast<TKcache*>(pastKCache.getKBlockPtr(seqIdx, valid_time_now));
 
-                int inBlockIdx = pastKCache.getKVLocalIdx(valid_time_now, hi_kv, Dh, jj);
+                int inBlockIdx = pastKCache.template getKLocalIdx<TKcache>(valid_time_now, hi_kv, Dh, jj);
                 k_vec[k_vec_i] = (*reinterpret_cast<const K_vec_m*>(&k_cache_batch[inBlockIdx]));
             }
 
@@ -2213,18 +2248,25 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     // the end of the kernel. There's plenty of time for the transactions to complete.
 
     // For MQA/GQA mode, write only with the first Q head of each group per KV head.
-    if (HANDLE_KV && hi == (hi_kv * qhead_per_kv) && qk_vec_idx < Dh)
+    // Preprocessed K was written to the cache together with the rotary embedding.
+    if (HANDLE_KV && !params.qkv_preprocessed && hi == (hi_kv * qhead_per_kv) && qk_vec_idx < Dh)
     {
         // Trigger the stores to global memory.
         Qk_vec_k k_vec = *reinterpret_cast<Qk_vec_k*>(&k_smem[qk_vec_idx]);
         const auto k_idx = QK_VEC_SIZE * tidx;
-        const int inBlockIdx = kvCacheBuffer.getKVLocalIdx(cyclic_tlength, hi_kv, Dh, k_idx);
+        const int inBlockIdx = kvCacheBuffer.template getKLocalIdx<Tcache>(cyclic_tlength, hi_kv, Dh, k_idx);
         // The base pointer for the value in the cache buffer.
         Tcache* k_cache = reinterpret_cast<Tcache*>(kvCacheBuffer.getKBlockPtr(batch_beam_idx, cyclic_tlength));
 
         if constexpr (ENABLE_8BITS_KV_CACHE)
         {
-            store_8bits_kv_cache_vec(reinterpret_cast<Tcache*>(k_cache), k_vec, inBlockIdx, kv_scale_orig_quant);
+            store_8bits_kv_cache_vec(reinterpret_cast<Tcache*>(k_cache), k_vec, inBlockIdx, k_scale_orig_quant);
+            // The first token of a new block also brings its scale.
+            if (dynamic_kv_scales && k_idx == 0)
+            {
+                getKVDynamicScalePtr(k_cache, params.num_kv_heads, kvCacheBuffer.getTokensPerBlock(), Dh)[hi_kv]
+                    = k_scale_quant_orig_f;
+            }
         }
         else
         {
@@ -2297,6 +2339,14 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         if (!MULTI_BLOCK_FLAG)
         {
             convert_from_float(&logits_smem[ti], qk_smem[ti] * inv_sum);
+            // The attention mass of the cached token, summed over the query heads of the kv head.
+            if (params.kv_eviction_write_slots != nullptr && ti < kv_loop_length)
+            {
+                const int tokens_per_block = kvCacheBuffer.getTokensPerBlock();
+                float* mass = getKVEvictionMassPtr(kvCacheBuffer.getKBlockPtr(batch_beam_idx, ti), params.num_kv_heads,
+                    tokens_per_block, Dh, sizeof(Tcache));
+                atomicAdd(&mass[kvCacheBuffer.getKVScaleIdx(ti, hi_kv)], qk_smem[ti] * inv_sum);
+            }
         }
         else
         {
@@ -2524,11 +2574,17 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         // Store the values with bias back to global memory in the cache for V.
         //*reinterpret_cast<V_vec_k*>(&v_cache[params.timestep*Dh]) = v;
         // For MQA/GQA mode, write only with the first Q head of each group per KV head.
-        if (hi == (hi_kv * qhead_per_kv))
+        if (hi == (hi_kv * qhead_per_kv) && !params.qkv_preprocessed)
         {
             if (ENABLE_8BITS_KV_CACHE)
             {
                 store_8bits_kv_cache_vec(v_cache_base, v, inBlockIdx, kv_scale_orig_quant);
+                if (dynamic_kv_scales && vi == 0)
+                {
+                    const int tokens_per_block = kvCacheBuffer.getTokensPerBlock();
+                    getKVDynamicScalePtr(v_cache_base, params.num_kv_heads, tokens_per_block, Dh)[hi_kv]
+                        = kv_scale_quant_orig_f;
+                }
             }
             else
             {
@@ -2639,7 +2695,7 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         bool last_block{false};
         if (tidx == 0)
         {
-            if (count_ref.fetch_add(1, cuda::memory_order_acq_rel) == (gridDim.z - 1))
+            if (count_ref.fetch_add(1, cuda::memory_order_acq_rel) == (num_seq_tiles - 1))
             {
                 last_block = true;
             }
@@ -2661,7 +2717,7 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
             float final_max = -FLT_MAX;
             float thread_partial_max = -FLT_MAX;
-            thread_partial_max = params.partial_max[bhi_seq_len_tile + min(tidx, gridDim.z - 1)];
+            thread_partial_max = params.partial_max[bhi_seq_len_tile + min(tidx, num_seq_tiles - 1)];
 
             // Make sure we can start writing to shared memory.
             __syncthreads();
@@ -2672,7 +2728,8 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
             __shared__ typename BlockReduce::TempStorage temp_storage;
             // Obtain a segment of consecutive items that are blocked across threads (final_max from above)
             // Compute the block-wide max for thread0
-            final_max = BlockReduce(temp_storage).Reduce(thread_partial_max, cub::Max(), gridDim.z);
+            final_max
+                = BlockReduce(temp_storage).Reduce(thread_partial_max, cub::Max(), static_cast<int>(num_seq_tiles));
 
             __shared__ float final_max_smem;
             if (tidx == 0)
@@ -2686,11 +2743,11 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
             ////////////////////
             // Reduction for global sum over all partial sum (scaled by the exponential term from global max) -> use
-            // gridDim.z threads
+            // num_seq_tiles threads
             ////////////////////
 
             float final_sum = 0.f;
-            if (tidx < gridDim.z)
+            if (tidx < num_seq_tiles)
             {
                 thread_partial_max = params.partial_max[bhi_seq_len_tile + tidx];
                 const auto thread_partial_sum = params.partial_sum[bhi_seq_len_tile + tidx];
@@ -2702,10 +2759,10 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
             ////////////////////
             // Reduction for final output (scaled by the exponential term from global max) -> use THREADS_PER_VALUE
-            // * gridDim.z threads
+            // * num_seq_tiles threads
             ////////////////////
 
-            // Shared memory to store partial outputs for each oi. -> size: gridDim.z * Dh * 4 Bytes. Reuse qk_smem.
+            // Shared memory to store partial outputs for each oi. -> size: num_seq_tiles * Dh * 4 Bytes. Reuse qk_smem.
             T* out_oi_smem = reinterpret_cast<T*>(smem_);
 
             const auto o_idx = chunk_index<T, V_vec_k, THREADS_PER_VALUE>(tidx);
@@ -2722,7 +2779,7 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
             const auto oo = o_idx.x;
 
             // Each thread may handle more than one partial output.
-            for (int tile_idx = o_idx.x; tile_idx < gridDim.z; tile_idx += V_PER_ITER)
+            for (int tile_idx = o_idx.x; tile_idx < num_seq_tiles; tile_idx += V_PER_ITER)
             {
                 // Load partial output
                 int thread_partial_out_offset = tile_idx * params.batch_size * num_heads * params.hidden_size_per_head;
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplJIT.h"
+
+#include "tensorrt_llm/common/cudaDriverWrapper.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplCommon.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQARunner.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nvrtc.h>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define nvrtcErrCheck(stat)                                                                                            \
+    {                                                                                                                  \
+        nvrtcResult const _result = (stat);                                                                            \
+        TLLM_CHECK_WITH_INFO(_result == NVRTC_SUCCESS, "NVRTC error: %s", nvrtcGetErrorString(_result));               \
+    }
+
+namespace fs = std::filesystem;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+// Name of the kernel entry point, the source must declare it extern "C" like the precompiled cubins.
+constexpr char const* kXQAKernelName = "kernel_mha";
+
+char const* getDataTypeName(Data_type dataType)
+{
+    switch (dataType)
+    {
+    case DATA_TYPE_FP16: return "fp16";
+    case DATA_TYPE_BF16: return "bf16";
+    case DATA_TYPE_INT8: return "int8";
+    case DATA_TYPE_E4M3: return "e4m3";
+    default: TLLM_THROW("Unsupported XQA data type %d", static_cast<int>(dataType));
+    }
+}
+
+// Value of CACHE_ELEM_ENUM expected by the XQA source: 0 for the input type, 1 for int8 and 2 for fp8.
+int getCacheElemEnum(Data_type dataType, Data_type kvDataType)
+{
+    if (kvDataType == dataType)
+    {
+        return 0;
+    }
+    if (kvDataType == DATA_TYPE_INT8)
+    {
+        return 1;
+    }
+    TLLM_CHECK_WITH_INFO(kvDataType == DATA_TYPE_E4M3, "Unsupported XQA kv cache data type %d", kvDataType);
+    return 2;
+}
+
+std::string readFile(fs::path const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    TLLM_CHECK_WITH_INFO(file.good(), "Failed to open %s", path.c_str());
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Writes to a temporary file first, so that concurrent processes never read a partially written cubin.
+void writeFileAtomically(fs::path const& path, std::string const& data)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    auto const tmpPath = fs::path(path).concat(".tmp" + std::to_string(std::hash<std::string>{}(data)));
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.good())
+        {
+            TLLM_LOG_WARNING("Failed to write XQA JIT cache file %s", tmpPath.c_str());
+            return;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        TLLM_LOG_WARNING("Failed to write XQA JIT cache file %s: %s", path.c_str(), ec.message().c_str());
+        fs::remove(tmpPath, ec);
+    }
+}
+
+// Kernels compiled for one data type on one device.
+class XQAJITKernelList
+{
+public:
+    struct XQAKernelFuncInfo
+    {
+        unsigned int mSharedMemBytes;
+        CUfunction mDeviceFunction;
+    };
+
+    XQAJITKernelList(Data_type type, unsigned int sm)
+        : mDataType(type)
+        , mSM(sm)
+        , mSourcePath(tensorrt_llm::common::getEnvXQAJITSource())
+        , mCacheDir(tensorrt_llm::common::getEnvXQAJITCacheDir())
+    {
+        TLLM_CHECK_WITH_INFO(!mSourcePath.empty(), "TRTLLM_XQA_JIT_SOURCE is not set.");
+        mSource = readFile(mSourcePath);
+        // Part of the cache key, so that cubins compiled from an older source are not picked up.
+        mSourceHash = std::hash<std::string>{}(mSource);
+    }
+
+    ~XQAJITKernelList()
+    {
+        for (auto module : mModules)
+        {
+            mDriver.cuModuleUnload(module);
+        }
+    }
+
+    XQAJITKernelList(XQAJITKernelList const&) = delete;
+    XQAJITKernelList& operator=(XQAJITKernelList const&) = delete;
+
+    static bool supportConfig(const XQAParams& xqaParams)
+    {
+        if (xqaParams.head_size % 16 != 0 || xqaParams.head_size < 16 || xqaParams.head_size > 256)
+        {
+            return false;
+        }
+        if (xqaParams.beam_width > 4)
+        {
+            return false;
+        }
+        if (xqaParams.kv_cache_data_type != xqaParams.data_type && xqaParams.kv_cache_data_type != DATA_TYPE_INT8
+            && xqaParams.kv_cache_data_type != DATA_TYPE_E4M3)
+        {
+            return false;
+        }
+        // One CTA processes all the Q heads sharing a KV head, or an M tile of them in multi query tokens mode.
+        int const nbQHeadsPerKV = xqaParams.num_q_heads / xqaParams.num_kv_heads;
+        return xqaParams.multi_query_tokens || nbQHeadsPerKV <= 32;
+    }
+
+    XQAKernelFuncInfo const& getKernel(XQAKernelRuntimeHashKey const& key)
+    {
+        std::lock_guard<std::mutex> lg(mMutex);
+        auto findIter = mFunctions.find(key);
+        if (findIter == mFunctions.end())
+        {
+            findIter = mFunctions.emplace(key, loadKernel(key)).first;
+        }
+        return findIter->second;
+    }
+
+    tensorrt_llm::common::CUDADriverWrapper const& getDriver() const
+    {
+        return mDriver;
+    }
+
+private:
+    // File name of the cached cubin. Encodes everything the compiled code depends on.
+    std::string getCubinFileName(XQAKernelRuntimeHashKey const& key) const
+    {
+        return tensorrt_llm::common::fmtstr(
+            "xqa_jit_dt_%s_d_%u_beam_%u_kvt_%s_nqpkv_%u_m_%u_pagedKV_%u_spec_%d_sm_%u_%016zx.cubin",
+            getDataTypeName(mDataType), key.head_size, key.beam_size, getDataTypeName(key.kv_data_type),
+            key.num_q_heads_per_kv, key.m_tilesize, key.tokens_per_page, key.multi_query_tokens ? 1 : 0, mSM,
+            mSourceHash);
+    }
+
+    std::vector<std::string> getCompileOptions(XQAKernelRuntimeHashKey const& key) const
+    {
+        char const* cudaHome = std::getenv("CUDA_HOME");
+        std::string const cudaInclude = std::string(cudaHome != nullptr ? cudaHome : "/usr/local/cuda") + "/include";
+        return {
+            tensorrt_llm::common::fmtstr("-arch=sm_%u%s", mSM, mSM == kSM_90 ? "a" : ""),
+            "-std=c++17",
+            "-use_fast_math",
+            "-DNDEBUG",
+            "-DGENERATE_CUBIN=1",
+            tensorrt_llm::common::fmtstr("-DINPUT_FP16=%d", mDataType == DATA_TYPE_FP16 ? 1 : 0),
+            tensorrt_llm::common::fmtstr("-DCACHE_ELEM_ENUM=%d", getCacheElemEnum(mDataType, key.kv_data_type)),
+            tensorrt_llm::common::fmtstr("-DHEAD_ELEMS=%u", key.head_size),
+            tensorrt_llm::common::fmtstr("-DBEAM_WIDTH=%u", key.beam_size),
+            tensorrt_llm::common::fmtstr("-DHEAD_GRP_SIZE=%u", key.num_q_heads_per_kv),
+            tensorrt_llm::common::fmtstr("-DM_TILESIZE=%u", key.m_tilesize),
+            tensorrt_llm::common::fmtstr("-DUSE_PAGED_KV_CACHE=%d", key.paged_kv_cache ? 1 : 0),
+            tensorrt_llm::common::fmtstr("-DTOKENS_PER_PAGE=%u", key.tokens_per_page),
+            tensorrt_llm::common::fmtstr("-DSPEC_DEC=%d", key.multi_query_tokens ? 1 : 0),
+            "-I" + mSourcePath.parent_path().string(),
+            "-I" + cudaInclude,
+        };
+    }
+
+    std::string compileCubin(XQAKernelRuntimeHashKey const& key) const
+    {
+        auto const options = getCompileOptions(key);
+        std::vector<char const*> optionPtrs;
+        optionPtrs.reserve(options.size());
+        for (auto const& option : options)
+        {
+            optionPtrs.push_back(option.c_str());
+        }
+
+        nvrtcProgram program;
+        nvrtcErrCheck(
+            nvrtcCreateProgram(&program, mSource.c_str(), mSourcePath.filename().c_str(), 0, nullptr, nullptr));
+        nvrtcResult const compileResult
+            = nvrtcCompileProgram(program, static_cast<int>(optionPtrs.size()), optionPtrs.data());
+        if (compileResult != NVRTC_SUCCESS)
+        {
+            size_t logSize = 0;
+            nvrtcGetProgramLogSize(program, &logSize);
+            std::string log(logSize, '\0');
+            nvrtcGetProgramLog(program, log.data());
+            nvrtcDestroyProgram(&program);
+            TLLM_THROW("Failed to compile XQA kernel %s: %s\n%s", getCubinFileName(key).c_str(),
+                nvrtcGetErrorString(compileResult), log.c_str());
+        }
+
+        size_t cubinSize = 0;
+        nvrtcErrCheck(nvrtcGetCUBINSize(program, &cubinSize));
+        std::string cubin(cubinSize, '\0');
+        nvrtcErrCheck(nvrtcGetCUBIN(program, cubin.data()));
+        nvrtcErrCheck(nvrtcDestroyProgram(&program));
+        return cubin;
+    }
+
+    std::string getCubin(XQAKernelRuntimeHashKey const& key) const
+    {
+        if (mCacheDir.empty())
+        {
+            return compileCubin(key);
+        }
+        auto const cubinPath = mCacheDir / getCubinFileName(key);
+        std::error_code ec;
+        if (fs::exists(cubinPath, ec))
+        {
+            TLLM_LOG_DEBUG("Loading XQA kernel from %s", cubinPath.c_str());
+            return readFile(cubinPath);
+        }
+        TLLM_LOG_INFO("Compiling XQA kernel %s", cubinPath.filename().c_str());
+        auto cubin = compileCubin(key);
+        writeFileAtomically(cubinPath, cubin);
+        return cubin;
+    }
+
+    XQAKernelFuncInfo loadKernel(XQAKernelRuntimeHashKey const& key)
+    {
+        auto const cubin = getCubin(key);
+
+        CUmodule hmod{0};
+        cuErrCheck(mDriver.cuModuleLoadData(&hmod, cubin.data()), mDriver);
+        mModules.push_back(hmod);
+
+        XQAKernelFuncInfo funcInfo{};
+        cuErrCheck(mDriver.cuModuleGetFunction(&funcInfo.mDeviceFunction, hmod, kXQAKernelName), mDriver);
+        unsigned int* shmem_dev_ptr = nullptr;
+        cuErrCheck(
+            mDriver.cuModuleGetGlobal(reinterpret_cast<CUdeviceptr*>(&shmem_dev_ptr), nullptr, hmod, "smemSize"),
+            mDriver);
+        check_cuda_error(
+            cudaMemcpy(&funcInfo.mSharedMemBytes, shmem_dev_ptr, sizeof(unsigned int), cudaMemcpyDeviceToHost));
+
+        /* Set 46KB threshold here because we have to take static/driver shared memory into consideration. */
+        if (funcInfo.mSharedMemBytes >= 46 * 1024)
+        {
+            cuErrCheck(mDriver.cuFuncSetAttribute(funcInfo.mDeviceFunction,
+                           CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES, funcInfo.mSharedMemBytes),
+                mDriver);
+        }
+        return funcInfo;
+    }
+
+    tensorrt_llm::common::CUDADriverWrapper mDriver;
+
+    Data_type mDataType;
+    unsigned int mSM;
+    fs::path mSourcePath;
+    fs::path mCacheDir;
+    std::string mSource;
+    size_t mSourceHash;
+
+    std::mutex mMutex;
+    std::vector<CUmodule> mModules;
+    std::unordered_map<XQAKernelRuntimeHashKey, XQAKernelFuncInfo, XQAKernelRuntimeHasher> mFunctions;
+};
+
+XQAJITKernelList& getXQAJITKernels(Data_type type, unsigned int sm)
+{
+    static std::mutex s_mutex;
+    static std::map<std::pair<int, Data_type>, std::unique_ptr<XQAJITKernelList>> s_kernels;
+    std::lock_guard<std::mutex> lg(s_mutex);
+
+    auto& kernels = s_kernels[std::make_pair(tensorrt_llm::common::getDevice(), type)];
+    if (kernels == nullptr)
+    {
+        kernels = std::make_unique<XQAJITKernelList>(type, sm);
+    }
+    return *kernels;
+}
+
+} // namespace
+
+bool DecoderXQAImplJIT::isEnabled()
+{
+    return !tensorrt_llm::common::getEnvXQAJITSource().empty();
+}
+
+bool DecoderXQAImplJIT::shouldUse(const XQAParams& xqaParams)
+{
+    return isEnabled() && XQAJITKernelList::supportConfig(xqaParams)
+        && mayHavePerfGain(xqaParams, mRunner->mMultiProcessorCount, tensorrt_llm::common::forceXQAKernels());
+}
+
+void DecoderXQAImplJIT::prepare(const XQAParams& xqa_params)
+{
+    auto& xqa_kernels = getXQAJITKernels(mRunner->mDataType, tensorrt_llm::common::getSMVersion());
+    auto key = getRuntimeHashKeyFromXQAParams(xqa_params);
+    xqa_kernels.getKernel(key);
+    if (xqa_params.multi_query_tokens)
+    {
+        // The M tile depends on the number of query tokens of each step, compile both variants ahead of time.
+        key.m_tilesize = key.m_tilesize == 16 ? 32 : 16;
+        xqa_kernels.getKernel(key);
+    }
+}
+
+template <typename KVCacheBuffer>
+void DecoderXQAImplJIT::runDispatchBuffer(const XQAParams& xqa_params, KVCacheBuffer& kv_cache_buffer,
+    int2& rotary_kernel_launch_cache, const cudaStream_t& stream)
+{
+    auto& xqa_kernels = getXQAJITKernels(mRunner->mDataType, tensorrt_llm::common::getSMVersion());
+    // Compiles the kernel if a variant that prepare() did not anticipate is needed.
+    auto const& func_info = xqa_kernels.getKernel(getRuntimeHashKeyFromXQAParams(xqa_params));
+    int multi_processor_count = mRunner->mMultiProcessorCount;
+    if (mRunner->mDataType == DATA_TYPE_FP16)
+    {
+        launchXQAKernel<__half, KVCacheBuffer>(xqa_kernels.getDriver(), func_info.mDeviceFunction,
+            func_info.mSharedMemBytes, xqa_params, kv_cache_buffer, rotary_kernel_launch_cache, multi_processor_count,
+            stream);
+    }
+    else
+    {
+        launchXQAKernel<__nv_bfloat16, KVCacheBuffer>(xqa_kernels.getDriver(), func_info.mDeviceFunction,
+            func_info.mSharedMemBytes, xqa_params, kv_cache_buffer, rotary_kernel_launch_cache, multi_processor_count,
+            stream);
+    }
+}
+
+void DecoderXQAImplJIT::runWithKVLinearBuffer(const XQAParams& xqa_params, KVLinearBuffer& kv_linear_buffer,
+    int2& rotary_kernel_launch_cache, const cudaStream_t& stream)
+{
+    runDispatchBuffer<KVLinearBuffer>(xqa_params, kv_linear_buffer, rotary_kernel_launch_cache, stream);
+}
+
+void DecoderXQAImplJIT::runWithKVBlockArray(const XQAParams& xqa_params, KVBlockArray& kv_block_array,
+    int2& rotary_kernel_launch_cache, const cudaStream_t& stream)
+{
+    runDispatchBuffer<KVBlockArray>(xqa_params, kv_block_array, rotary_kernel_launch_cache, stream);
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
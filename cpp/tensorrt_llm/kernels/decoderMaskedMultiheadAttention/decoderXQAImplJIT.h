@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImpl.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// XQA implementation that compiles the kernel variant required by XQAParams with NVRTC on first use.
+// It covers head sizes and GQA ratios for which no cubin is shipped. The source is read from the
+// file pointed to by TRTLLM_XQA_JIT_SOURCE and the resulting cubins are cached on disk under
+// TRTLLM_XQA_JIT_CACHE_DIR, keyed by SM version, data types and kernel parameters.
+class DecoderXQAImplJIT : public DecoderXQAImpl
+{
+public:
+    DecoderXQAImplJIT(DecoderXQARunner* runner)
+        : DecoderXQAImpl(runner)
+    {
+    }
+
+    // Whether a kernel source to compile from is available.
+    static bool isEnabled();
+
+    bool shouldUse(const XQAParams& xqaParams) override;
+    // Compiles (or loads from the disk cache) the kernels required by xqa_params.
+    void prepare(const XQAParams& xqa_params) override;
+
+protected:
+    void runWithKVLinearBuffer(const XQAParams& xqa_params, KVLinearBuffer& kv_linear_buffer,
+        int2& rotary_kernel_launch_cache, const cudaStream_t& stream) override;
+    void runWithKVBlockArray(const XQAParams& xqa_params, KVBlockArray& kv_block_array,
+        int2& rotary_kernel_launch_cache, const cudaStream_t& stream) override;
+
+private:
+    template <typename KVCacheBuffer>
+    void runDispatchBuffer(const XQAParams& xqa_params, KVCacheBuffer& kv_cache_buffer,
+        int2& rotary_kernel_launch_cache, const cudaStream_t& stream);
+};
+
+} // namespace kernels
+} // namespace tensorrt_llm
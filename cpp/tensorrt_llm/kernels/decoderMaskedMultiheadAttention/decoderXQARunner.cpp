@@ -46,9 +46,13 @@ DecoderXQARunner::DecoderXQARunner(
     , mMultiBlockMode(multi_block_mode)
 {
     mMultiProcessorCount = tensorrt_llm::common::getMultiProcessorCount();
-    // The initialization of mImpl must be the last line because *this needs to be fully initialized before calling
-    // DecoderXQAImpl::create().
-    mImpl = DecoderXQAImpl::create(this, DecoderXQAImpl::ImplType::kPrecompiled);
+    // The initialization of the impls must be the last lines because *this needs to be fully initialized before
+    // calling DecoderXQAImpl::create().
+    mPrecompiledImpl = DecoderXQAImpl::create(this, DecoderXQAImpl::ImplType::kPrecompiled);
+    if (DecoderXQAImplJIT::isEnabled())
+    {
+        mJITImpl = DecoderXQAImpl::create(this, DecoderXQAImpl::ImplType::kJIT);
+    }
 }
 
 DecoderXQARunner::~DecoderXQARunner() = default;
@@ -68,6 +72,28 @@ constexpr inline T roundUp(T a, T b)
     return divUp(a, b) * b;
 }
 
+// Shapes for which cubins are shipped.
+bool supportedByPrecompiledKernels(const XQAParams& xqaParams)
+{
+    bool const isGPTJBeam4Kernel = (xqaParams.head_size == 256 && xqaParams.beam_width == 4
+        && xqaParams.paged_kv_cache && (xqaParams.tokens_per_block == 64 || xqaParams.tokens_per_block == 128));
+    if (xqaParams.head_size != 128 && xqaParams.head_size != 256 && !isGPTJBeam4Kernel)
+    {
+        SUPPORT_RETURN_FALSE("head_size");
+    }
+    if (xqaParams.beam_width != 1 && !isGPTJBeam4Kernel)
+    {
+        SUPPORT_RETURN_FALSE("beam_width");
+    }
+    // OPTIMIZE: For the standard generation-phase MHA, there are still extra limitations.
+    const int nbQHeadsPerKV = xqaParams.num_q_heads / xqaParams.num_kv_heads;
+    if (!xqaParams.multi_query_tokens && nbQHeadsPerKV != 8 && nbQHeadsPerKV != 1)
+    {
+        SUPPORT_RETURN_FALSE("nbHeads");
+    }
+    return true;
+}
+
 } // namespace
 
 size_t DecoderXQARunner::getWorkspaceSize(int max_batch_beam_size)
@@ -90,20 +116,37 @@ size_t DecoderXQARunner::getWorkspaceSize(int max_batch_beam_size)
     return workspace_size;
 }
 
+DecoderXQAImpl* DecoderXQARunner::getImplFor(const XQAParams& xqa_params)
+{
+    if (supportedByPrecompiledKernels(xqa_params) && mPrecompiledImpl->shouldUse(xqa_params))
+    {
+        return mPrecompiledImpl.get();
+    }
+    if (mJITImpl && mJITImpl->shouldUse(xqa_params))
+    {
+        return mJITImpl.get();
+    }
+    return nullptr;
+}
+
 bool DecoderXQARunner::shouldUseImpl(const XQAParams& xqaParams)
 {
-    return mImpl->shouldUse(xqaParams);
+    return getImplFor(xqaParams) != nullptr;
 }
 
 void DecoderXQARunner::prepareForRun(const XQAParams& xqa_params)
 {
-    return mImpl->prepare(xqa_params);
+    auto* impl = getImplFor(xqa_params);
+    TLLM_CHECK_WITH_INFO(impl != nullptr, "No XQA implementation supports the given parameters.");
+    return impl->prepare(xqa_params);
 }
 
 template <typename KVCacheBuffer>
 void DecoderXQARunner::run(const XQAParams& xqa_params, KVCacheBuffer& kv_cache_buffer, const cudaStream_t& stream)
 {
-    return mImpl->run(xqa_params, kv_cache_buffer, mLaunchGridBlockCache, stream);
+    auto* impl = getImplFor(xqa_params);
+    TLLM_CHECK_WITH_INFO(impl != nullptr, "No XQA implementation supports the given parameters.");
+    return impl->run(xqa_params, kv_cache_buffer, mLaunchGridBlockCache, stream);
 }
 
 template void DecoderXQARunner::run(
@@ -22,6 +22,7 @@
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplJIT.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplPrecompiled.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/xqaParams.h"
 #include "tensorrt_llm/kernels/gptKernels.h"
@@ -91,12 +92,6 @@ public:
         {
             SUPPORT_RETURN_FALSE("data type");
         }
-        bool const isGPTJBeam4Kernel = (xqaParams.head_size == 256 && xqaParams.beam_width == 4
-            && xqaParams.paged_kv_cache && (xqaParams.tokens_per_block == 64 || xqaParams.tokens_per_block == 128));
-        if (xqaParams.head_size != 128 && xqaParams.head_size != 256 && !isGPTJBeam4Kernel)
-        {
-            SUPPORT_RETURN_FALSE("head_size");
-        }
         if (xqaParams.unidirectional != 1)
         {
             SUPPORT_RETURN_FALSE("unidirectional");
@@ -122,10 +117,6 @@ public:
         {
             SUPPORT_RETURN_FALSE("host_past_key_value_lengths");
         }
-        if (xqaParams.beam_width != 1 && !isGPTJBeam4Kernel)
-        {
-            SUPPORT_RETURN_FALSE("beam_width");
-        }
         if (xqaParams.cyclic_attention_window_size != xqaParams.max_attention_window_size)
         {
             SUPPORT_RETURN_FALSE("cyclic_attention_window_size != max_attention_window_size");
@@ -134,20 +125,19 @@ public:
         {
             SUPPORT_RETURN_FALSE("streaming-llm");
         }
+        // The XQA kernels add no bias to Q*K^T, so ALiBi and relative attention bias stay on MMHA.
+        if (xqaParams.position_embedding_type == PositionEmbeddingType::kALIBI
+            || xqaParams.position_embedding_type == PositionEmbeddingType::kALIBI_WITH_SCALE
+            || xqaParams.position_embedding_type == PositionEmbeddingType::kRELATIVE)
+        {
+            SUPPORT_RETURN_FALSE("position_embedding_type");
+        }
 
-        // OPTIMIZE: For the standard generation-phase MHA, there are still extra limitations.
         // NOTE: Medusa mode = Multi_query_tokens > 1.
         const int nbQHeads = xqaParams.num_q_heads;
         const int nbKVHeads = xqaParams.num_kv_heads;
         const int nbQHeadsPerKV = nbQHeads / nbKVHeads;
-        if (!xqaParams.multi_query_tokens)
-        {
-            if (nbQHeadsPerKV != 8 && nbQHeadsPerKV != 1)
-            {
-                SUPPORT_RETURN_FALSE("nbHeads");
-            }
-        }
-        else
+        if (xqaParams.multi_query_tokens)
         {
             // Number of Q heads Per KV needs to be power of 2 or 1.
             if (!(nbQHeadsPerKV % 2 == 0 || nbQHeadsPerKV == 1))
@@ -155,6 +145,7 @@ public:
                 SUPPORT_RETURN_FALSE("nbHeads");
             }
         }
+        // Head size, beam width and number of heads are further limited by the implementation, see getImplFor().
         return shouldUseImpl(xqaParams);
     }
 
@@ -182,6 +173,9 @@ public:
 
 private:
     bool shouldUseImpl(const XQAParams& xqa_params);
+    // The precompiled implementation if it has a cubin for xqa_params, else the JIT implementation if enabled and
+    // able to compile one. nullptr if neither applies.
+    DecoderXQAImpl* getImplFor(const XQAParams& xqa_params);
     void prepareForRun(const XQAParams& xqa_params);
 
     template <typename KVCacheBuffer>
@@ -202,9 +196,12 @@ private:
     bool mMultiBlockMode;
     int mMultiProcessorCount;
 
-    std::unique_ptr<DecoderXQAImpl> mImpl;
+    std::unique_ptr<DecoderXQAImpl> mPrecompiledImpl;
+    // Only created when a kernel source for JIT compilation is configured.
+    std::unique_ptr<DecoderXQAImpl> mJITImpl;
 
     friend DecoderXQAImplPrecompiled;
+    friend DecoderXQAImplJIT;
 };
 
 } // namespace kernels
@@ -47,6 +47,8 @@ struct XQAParams
     const int32_t* sequence_lengths;    //
     const int32_t* context_lengths;     // maybe not used now
     const void* alibi_slopes;           // maybe not used now
+    // [batch_size, num_medusa_tokens + 1, divUp(num_medusa_tokens + 1, 32)], one tree per request.
+    // Requests with smaller trees are padded to num_medusa_tokens + 1 rows.
     const int32_t* medusa_packed_mask;
     const int* medusa_position_offsets; // rotary embedding.
 
@@ -64,6 +66,8 @@ struct XQAParams
     tensorrt_llm::kernels::RotaryScalingType rotary_embedding_scale_type;
     float rotary_embedding_scale;
     int rotary_embedding_max_positions;
+    // Precomputed {cos, sin} table of buildRotaryCosSinCache, nullptr to compute the coefficients on the fly.
+    const float2* rotary_cos_sin = nullptr;
     tensorrt_llm::kernels::PositionEmbeddingType position_embedding_type;
     bool position_shift_enabled = false;
     bool remove_padding = false;
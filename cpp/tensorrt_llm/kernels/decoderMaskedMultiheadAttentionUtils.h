@@ -2572,8 +2572,10 @@ inline __device__ void update_rotary_base_n_scale(float& base, float& scale, Rot
         }
         scale = 1.0f; // scale is only used in base for dynamic scaling
     }
-    else if (scale_type == RotaryScalingType::kLINEAR)
+    else if (scale_type == RotaryScalingType::kLINEAR || scale_type == RotaryScalingType::kYARN
+        || scale_type == RotaryScalingType::kLONGROPE)
     {
+        // kYARN and kLONGROPE fall back to linear interpolation for positions the cos/sin table does not cover.
         scale = 1.0f / scale;
     }
 }
@@ -2585,6 +2587,22 @@ inline __device__ float2 rotary_embedding_coefficient(
     return {cosf(inv_freq), sinf(inv_freq)};
 }
 
+// Reads the coefficients from the [positions, rot_embed_dim / 2] table of buildRotaryCosSinCache when it is provided.
+// Out of range dimensions, whose results are discarded by the callers, get the identity rotation.
+inline __device__ float2 rotary_embedding_coefficient(const int zid, const int rot_embed_dim, const float base,
+    const float scale, const float t_step, const float2* rotary_cos_sin)
+{
+    if (rotary_cos_sin == nullptr)
+    {
+        return rotary_embedding_coefficient(zid, rot_embed_dim, base, scale, t_step);
+    }
+    if (static_cast<unsigned>(zid) >= static_cast<unsigned>(rot_embed_dim))
+    {
+        return {1.f, 0.f};
+    }
+    return rotary_cos_sin[static_cast<int>(t_step) * (rot_embed_dim / 2) + zid / 2];
+}
+
 inline __device__ float2 rotary_embedding_transform(const float2 v, const float2 coef)
 {
     float2 rot_v;
@@ -2609,42 +2627,45 @@ inline __device__ __nv_bfloat162 rotary_embedding_transform(const __nv_bfloat162
 }
 #endif
 
-inline __device__ void apply_rotary_embedding(float& q, int zid, int rot_embed_dim, float base, float scale, int t_step)
+inline __device__ void apply_rotary_embedding(float& q, int zid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     return;
 }
 
 inline __device__ void apply_rotary_embedding(
-    float& q, float& k, int zid, int rot_embed_dim, float base, float scale, int t_step)
+    float& q, float& k, int zid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     return;
 }
 
 inline __device__ void apply_rotary_embedding(
-    float2& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    float2& q, int tid, int rot_embed_dim, float base, float scale, int t_step, const float2* rotary_cos_sin = nullptr)
 {
     if (2 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q = rotary_embedding_transform(q, coef);
 }
 
 inline __device__ void apply_rotary_embedding(
-    float2& q, float2& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    float2& q, float2& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (2 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q = rotary_embedding_transform(q, coef);
     k = rotary_embedding_transform(k, coef);
 }
 
 inline __device__ void apply_rotary_embedding(
-    float4& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    float4& q, int tid, int rot_embed_dim, float base, float scale, int t_step, const float2* rotary_cos_sin = nullptr)
 {
     if (4 * tid >= rot_embed_dim)
     {
@@ -2652,14 +2673,15 @@ inline __device__ void apply_rotary_embedding(
     }
 
     Float4_& q_ = *reinterpret_cast<Float4_*>(&q);
-    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.x = rotary_embedding_transform(q_.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.y = rotary_embedding_transform(q_.y, coef1);
 }
 
 inline __device__ void apply_rotary_embedding(
-    float4& q, float4& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    float4& q, float4& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (4 * tid >= rot_embed_dim)
     {
@@ -2668,16 +2690,17 @@ inline __device__ void apply_rotary_embedding(
 
     Float4_& q_ = *reinterpret_cast<Float4_*>(&q);
     Float4_& k_ = *reinterpret_cast<Float4_*>(&k);
-    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.x = rotary_embedding_transform(q_.x, coef0);
     k_.x = rotary_embedding_transform(k_.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.y = rotary_embedding_transform(q_.y, coef1);
     k_.y = rotary_embedding_transform(k_.y, coef1);
 }
 
 inline __device__ void apply_rotary_embedding(
-    Float8_& q, Float8_& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    Float8_& q, Float8_& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (8 * tid >= rot_embed_dim)
     {
@@ -2686,205 +2709,220 @@ inline __device__ void apply_rotary_embedding(
 
     Float8_& q_ = *reinterpret_cast<Float8_*>(&q);
     Float8_& k_ = *reinterpret_cast<Float8_*>(&k);
-    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.x = rotary_embedding_transform(q_.x, coef0);
     k_.x = rotary_embedding_transform(k_.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.y = rotary_embedding_transform(q_.y, coef1);
     k_.y = rotary_embedding_transform(k_.y, coef1);
-    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step);
+    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.z = rotary_embedding_transform(q_.z, coef2);
     k_.z = rotary_embedding_transform(k_.z, coef2);
-    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step);
+    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q_.w = rotary_embedding_transform(q_.w, coef3);
     k_.w = rotary_embedding_transform(k_.w, coef3);
 }
 
 inline __device__ void apply_rotary_embedding(
-    uint32_t& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    uint32_t& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (2 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q = rotary_embedding_transform(q, coef);
 }
 
 inline __device__ void apply_rotary_embedding(
-    uint32_t& q, uint32_t& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    uint32_t& q, uint32_t& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (2 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q = rotary_embedding_transform(q, coef);
     k = rotary_embedding_transform(k, coef);
 }
 
-inline __device__ void apply_rotary_embedding(half2& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+inline __device__ void apply_rotary_embedding(half2& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
-    return apply_rotary_embedding(*reinterpret_cast<uint32_t*>(&q), tid, rot_embed_dim, base, scale, t_step);
+    return apply_rotary_embedding(
+        *reinterpret_cast<uint32_t*>(&q), tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
 }
 
 inline __device__ void apply_rotary_embedding(
-    half2& q, half2& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    half2& q, half2& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
-    return apply_rotary_embedding(
-        *reinterpret_cast<uint32_t*>(&q), *reinterpret_cast<uint32_t*>(&k), tid, rot_embed_dim, base, scale, t_step);
+    return apply_rotary_embedding(*reinterpret_cast<uint32_t*>(&q), *reinterpret_cast<uint32_t*>(&k), tid,
+        rot_embed_dim, base, scale, t_step, rotary_cos_sin);
 }
 
-inline __device__ void apply_rotary_embedding(uint2& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+inline __device__ void apply_rotary_embedding(uint2& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (4 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
 }
 
 inline __device__ void apply_rotary_embedding(
-    uint2& q, uint2& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    uint2& q, uint2& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (4 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
     k.x = rotary_embedding_transform(k.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
     k.y = rotary_embedding_transform(k.y, coef1);
 }
 
-inline __device__ void apply_rotary_embedding(uint4& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+inline __device__ void apply_rotary_embedding(uint4& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (8 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
-    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step);
+    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.z = rotary_embedding_transform(q.z, coef2);
-    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step);
+    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.w = rotary_embedding_transform(q.w, coef3);
 }
 
 inline __device__ void apply_rotary_embedding(
-    uint4& q, uint4& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    uint4& q, uint4& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (8 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
     k.x = rotary_embedding_transform(k.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
     k.y = rotary_embedding_transform(k.y, coef1);
-    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step);
+    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.z = rotary_embedding_transform(q.z, coef2);
     k.z = rotary_embedding_transform(k.z, coef2);
-    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step);
+    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.w = rotary_embedding_transform(q.w, coef3);
     k.w = rotary_embedding_transform(k.w, coef3);
 }
 
 #ifdef ENABLE_BF16
 inline __device__ void apply_rotary_embedding(
-    __nv_bfloat162& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    __nv_bfloat162& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (2 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q = rotary_embedding_transform(q, coef);
 }
 
 inline __device__ void apply_rotary_embedding(
-    __nv_bfloat162& q, __nv_bfloat162& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    __nv_bfloat162& q, __nv_bfloat162& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (2 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef = rotary_embedding_coefficient(2 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q = rotary_embedding_transform(q, coef);
     k = rotary_embedding_transform(k, coef);
 }
 
 inline __device__ void apply_rotary_embedding(
-    bf16_4_t& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    bf16_4_t& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (4 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
 }
 
 inline __device__ void apply_rotary_embedding(
-    bf16_4_t& q, bf16_4_t& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    bf16_4_t& q, bf16_4_t& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (4 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(4 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
     k.x = rotary_embedding_transform(k.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(4 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
     k.y = rotary_embedding_transform(k.y, coef1);
 }
 
 inline __device__ void apply_rotary_embedding(
-    bf16_8_t& q, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    bf16_8_t& q, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (8 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
-    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step);
+    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.z = rotary_embedding_transform(q.z, coef2);
-    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step);
+    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.w = rotary_embedding_transform(q.w, coef3);
 }
 
 inline __device__ void apply_rotary_embedding(
-    bf16_8_t& q, bf16_8_t& k, int tid, int rot_embed_dim, float base, float scale, int t_step)
+    bf16_8_t& q, bf16_8_t& k, int tid, int rot_embed_dim, float base, float scale, int t_step,
+    const float2* rotary_cos_sin = nullptr)
 {
     if (8 * tid >= rot_embed_dim)
     {
         return;
     }
-    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step);
+    const auto coef0 = rotary_embedding_coefficient(8 * tid, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.x = rotary_embedding_transform(q.x, coef0);
     k.x = rotary_embedding_transform(k.x, coef0);
-    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step);
+    const auto coef1 = rotary_embedding_coefficient(8 * tid + 2, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.y = rotary_embedding_transform(q.y, coef1);
     k.y = rotary_embedding_transform(k.y, coef1);
-    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step);
+    const auto coef2 = rotary_embedding_coefficient(8 * tid + 4, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.z = rotary_embedding_transform(q.z, coef2);
     k.z = rotary_embedding_transform(k.z, coef2);
-    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step);
+    const auto coef3 = rotary_embedding_coefficient(8 * tid + 6, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     q.w = rotary_embedding_transform(q.w, coef3);
     k.w = rotary_embedding_transform(k.w, coef3);
 }
@@ -2894,9 +2932,9 @@ inline __device__ void apply_rotary_embedding(
 
 inline __device__ void apply_rotary_embedding(uint16_t& q, uint16_t q_pair, uint16_t& k, uint16_t k_pair, int tid0,
     int tid1, // not used
-    int rot_embed_dim, float base, float scale, int t_step, int first_half)
+    int rot_embed_dim, float base, float scale, int t_step, int first_half, const float2* rotary_cos_sin = nullptr)
 {
-    const float2 coef = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step);
+    const float2 coef = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     float cos = coef.x;
     float sin = coef.y;
     float q_, k_;
@@ -2917,10 +2955,11 @@ inline __device__ void apply_rotary_embedding(uint16_t& q, uint16_t q_pair, uint
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 inline __device__ void apply_rotary_embedding(uint32_t& q, uint32_t q_pair, uint32_t& k, uint32_t k_pair, int tid0,
-    int tid1, int rot_embed_dim, float base, float scale, int t_step, int first_half)
+    int tid1, int rot_embed_dim, float base, float scale, int t_step, int first_half,
+    const float2* rotary_cos_sin = nullptr)
 {
-    const float2 coef0 = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step);
-    const float2 coef1 = rotary_embedding_coefficient(tid1, rot_embed_dim, base, scale, t_step);
+    const float2 coef0 = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
+    const float2 coef1 = rotary_embedding_coefficient(tid1, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     float2 cos = make_float2(coef0.x, coef1.x);
     float2 sin = make_float2(coef0.y, coef1.y);
     float2 q_, k_;
@@ -2943,9 +2982,9 @@ inline __device__ void apply_rotary_embedding(uint32_t& q, uint32_t q_pair, uint
 inline __device__ void apply_rotary_embedding(__nv_bfloat16& q, __nv_bfloat16 q_pair, __nv_bfloat16& k,
     __nv_bfloat16 k_pair, int tid0,
     int tid1, // not used
-    int rot_embed_dim, float base, float scale, int t_step, int first_half)
+    int rot_embed_dim, float base, float scale, int t_step, int first_half, const float2* rotary_cos_sin = nullptr)
 {
-    const float2 coef = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step);
+    const float2 coef = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     float cos = coef.x;
     float sin = coef.y;
     float q_, k_;
@@ -2966,10 +3005,11 @@ inline __device__ void apply_rotary_embedding(__nv_bfloat16& q, __nv_bfloat16 q_
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 inline __device__ void apply_rotary_embedding(__nv_bfloat162& q, __nv_bfloat162 q_pair, __nv_bfloat162& k,
-    __nv_bfloat162 k_pair, int tid0, int tid1, int rot_embed_dim, float base, float scale, int t_step, int first_half)
+    __nv_bfloat162 k_pair, int tid0, int tid1, int rot_embed_dim, float base, float scale, int t_step, int first_half,
+    const float2* rotary_cos_sin = nullptr)
 {
-    const float2 coef0 = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step);
-    const float2 coef1 = rotary_embedding_coefficient(tid1, rot_embed_dim, base, scale, t_step);
+    const float2 coef0 = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
+    const float2 coef1 = rotary_embedding_coefficient(tid1, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     float2 cos = make_float2(coef0.x, coef1.x);
     float2 sin = make_float2(coef0.y, coef1.y);
     float2 q_, k_;
@@ -2991,9 +3031,9 @@ inline __device__ void apply_rotary_embedding(__nv_bfloat162& q, __nv_bfloat162
 
 inline __device__ void apply_rotary_embedding(float& q, float q_pair, float& k, float k_pair, int tid0,
     int tid1, // not used
-    int rot_embed_dim, float base, float scale, int t_step, int first_half)
+    int rot_embed_dim, float base, float scale, int t_step, int first_half, const float2* rotary_cos_sin = nullptr)
 {
-    const float2 coef = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step);
+    const float2 coef = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     float cos = coef.x;
     float sin = coef.y;
     if (first_half)
@@ -3011,10 +3051,10 @@ inline __device__ void apply_rotary_embedding(float& q, float q_pair, float& k,
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 inline __device__ void apply_rotary_embedding(float2& q, float2 q_pair, float2& k, float2 k_pair, int tid0, int tid1,
-    int rot_embed_dim, float base, float scale, int t_step, int first_half)
+    int rot_embed_dim, float base, float scale, int t_step, int first_half, const float2* rotary_cos_sin = nullptr)
 {
-    const float2 coef0 = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step);
-    const float2 coef1 = rotary_embedding_coefficient(tid1, rot_embed_dim, base, scale, t_step);
+    const float2 coef0 = rotary_embedding_coefficient(tid0, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
+    const float2 coef1 = rotary_embedding_coefficient(tid1, rot_embed_dim, base, scale, t_step, rotary_cos_sin);
     float2 cos = make_float2(coef0.x, coef1.x);
     float2 sin = make_float2(coef0.y, coef1.y);
     if (first_half)
@@ -3033,7 +3073,8 @@ inline __device__ void apply_rotary_embedding(float2& q, float2 q_pair, float2&
 
 template <typename Vec_type, typename Packed_type, typename T>
 inline __device__ void apply_rotary_embedding_gptneox(Vec_type& q, Vec_type& k, int tidx, int rotary_embedding_dim,
-    float rotary_embedding_base, float rotary_embedding_scale, int t_step, bool first_half)
+    float rotary_embedding_base, float rotary_embedding_scale, int t_step, bool first_half,
+    const float2* rotary_cos_sin = nullptr)
 {
     // 32 threads: each hold VEC_SIZE elements (half)
     Vec_type q_pair, k_pair;
@@ -3083,7 +3124,7 @@ inline __device__ void apply_rotary_embedding_gptneox(Vec_type& q, Vec_type& k,
         Packed_type k_pair_ = reinterpret_cast<Packed_type*>(&k_pair)[elt_id];
 
         apply_rotary_embedding(q_, q_pair_, k_, k_pair_, rotary_emd_pos0_id, rotary_emd_pos1_id, rotary_embedding_dim,
-            rotary_embedding_base, rotary_embedding_scale, t_step, first_half);
+            rotary_embedding_base, rotary_embedding_scale, t_step, first_half, rotary_cos_sin);
 
         if (valid_rotary_pos)
         {
@@ -3764,6 +3805,111 @@ inline __device__ void store_8bits_kv_cache_vec(__nv_fp8_e4m3* pointer, const Ve
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Marker cache type of the INT4 KV cache, see getInt4KVScaleZeroPtr for the layout.
+struct int4_kv_t
+{
+    uint8_t data;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns {scale, zero} of the INT4 values of one token and head, reduced over the warp that holds the head.
+// All lanes of the warp must call it, lanes without valid elements pass active = false.
+template <typename Vec_k>
+inline __device__ float2 int4_kv_cache_scale_zero(const Vec_k& vec, bool active)
+{
+    constexpr int N = num_elems<Vec_k>::value;
+    const auto vec_f = convert_to_float(vec);
+    const float* vals = reinterpret_cast<const float*>(&vec_f);
+    float lo = INFINITY;
+    float hi = -INFINITY;
+    if (active)
+    {
+#pragma unroll
+        for (int i = 0; i < N; ++i)
+        {
+            lo = fminf(lo, vals[i]);
+            hi = fmaxf(hi, vals[i]);
+        }
+    }
+#pragma unroll
+    for (int mask = 16; mask > 0; mask >>= 1)
+    {
+        lo = fminf(lo, __shfl_xor_sync(uint32_t(-1), lo, mask));
+        hi = fmaxf(hi, __shfl_xor_sync(uint32_t(-1), hi, mask));
+    }
+    // Avoid a zero scale for constant vectors.
+    return make_float2(fmaxf(hi - lo, 1e-6f) / 15.f, lo);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the absolute maximum of the values of one token and head, reduced over the warp that holds the head. Used
+// for the dynamic scales of the 8-bit KV cache, see getKVDynamicScalePtr. All lanes of the warp must call it, lanes
+// without valid elements pass active = false.
+template <typename Vec_k>
+inline __device__ float kv_cache_warp_amax(const Vec_k& vec, bool active)
+{
+    constexpr int N = num_elems<Vec_k>::value;
+    const auto vec_f = convert_to_float(vec);
+    const float* vals = reinterpret_cast<const float*>(&vec_f);
+    float amax = 0.f;
+    if (active)
+    {
+#pragma unroll
+        for (int i = 0; i < N; ++i)
+        {
+            amax = fmaxf(amax, fabsf(vals[i]));
+        }
+    }
+#pragma unroll
+    for (int mask = 16; mask > 0; mask >>= 1)
+    {
+        amax = fmaxf(amax, __shfl_xor_sync(uint32_t(-1), amax, mask));
+    }
+    return amax;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Vec_k>
+inline __device__ void store_int4_kv_cache_vec(uint8_t* pointer, const Vec_k& vec, int idx, float2 scale_zero)
+{
+    constexpr int N = num_elems<Vec_k>::value;
+    static_assert(N % 2 == 0, "The INT4 KV cache requires an even number of elements per vector");
+    const auto vec_f = convert_to_float(vec);
+    const float* vals = reinterpret_cast<const float*>(&vec_f);
+    const float inv_scale = 1.f / scale_zero.x;
+#pragma unroll
+    for (int i = 0; i < N / 2; ++i)
+    {
+        const int lo = __float2int_rn(fminf(fmaxf((vals[2 * i] - scale_zero.y) * inv_scale, 0.f), 15.f));
+        const int hi = __float2int_rn(fminf(fmaxf((vals[2 * i + 1] - scale_zero.y) * inv_scale, 0.f), 15.f));
+        pointer[idx + i] = static_cast<uint8_t>(lo | (hi << 4));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Vec_k>
+inline __device__ void load_int4_kv_cache_vec(Vec_k* vec, const uint8_t* pointer, int idx, float2 scale_zero)
+{
+    constexpr int N = num_elems<Vec_k>::value;
+    using Packed_Float_t = typename packed_type<float, N>::type;
+    Packed_Float_t vec_f;
+    float* vals = reinterpret_cast<float*>(&vec_f);
+#pragma unroll
+    for (int i = 0; i < N / 2; ++i)
+    {
+        const uint8_t packed = pointer[idx + i];
+        vals[2 * i] = static_cast<float>(packed & 0xF) * scale_zero.x + scale_zero.y;
+        vals[2 * i + 1] = static_cast<float>(packed >> 4) * scale_zero.x + scale_zero.y;
+    }
+    convert_from_float(vec, vec_f);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 template <typename Vec_in, typename Vec_out, typename T_cache, typename T_scale>
 inline __device__ void convert_from_8bit_kv_cache(Vec_out* vec_o, const Vec_in& vec_i, T_scale scale)
 {
@@ -14,6 +14,14 @@
  * limitations under the License.
  */
 
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/kernels/decodingCommon.h"
@@ -26,18 +34,70 @@ namespace tensorrt_llm
 namespace kernels
 {
 
-__global__ void curandInitialize(curandState_t* state, const int* batchSlots, const int size, const uint64_t randomSeed)
+template <int BLOCK_SIZE>
+__global__ void compactActiveSlots(int32_t* activeSlots, int32_t* numActiveSlots, FinishedState const* finished,
+    int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth)
+{
+    using BlockScan = cub::BlockScan<int32_t, BLOCK_SIZE>;
+    __shared__ typename BlockScan::TempStorage tempStorage;
+
+    // Stream compaction by prefix sum, in chunks of one index per thread
+    int32_t numActive = 0;
+    for (int32_t chunkStart = 0; chunkStart < batchSize; chunkStart += BLOCK_SIZE)
+    {
+        auto const batchIdx = chunkStart + static_cast<int32_t>(threadIdx.x);
+        int32_t isActive = 0;
+        if (batchIdx < batchSize)
+        {
+            auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+            for (int32_t beamIdx = 0; beamIdx < beamWidth; ++beamIdx)
+            {
+                isActive |= finished[batchSlot * beamWidth + beamIdx].isFinished() ? 0 : 1;
+            }
+        }
+        int32_t offset;
+        int32_t chunkActive;
+        BlockScan(tempStorage).ExclusiveSum(isActive, offset, chunkActive);
+        if (isActive)
+        {
+            activeSlots[numActive + offset] = batchIdx;
+        }
+        numActive += chunkActive;
+        // tempStorage is reused by the next chunk
+        __syncthreads();
+    }
+    if (threadIdx.x == 0)
+    {
+        *numActiveSlots = numActive;
+    }
+}
+
+void invokeCompactActiveSlots(int32_t* activeSlots, int32_t* numActiveSlots, FinishedState const* finished,
+    int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth, cudaStream_t stream)
+{
+    constexpr int BLOCK_SIZE = 256;
+    compactActiveSlots<BLOCK_SIZE>
+        <<<1, BLOCK_SIZE, 0, stream>>>(activeSlots, numActiveSlots, finished, batchSlots, batchSize, beamWidth);
+}
+
+__device__ __forceinline__ void philoxInitialize(PhiloxState& state, uint64_t randomSeed)
+{
+    state.key = make_uint2(static_cast<uint32_t>(randomSeed), static_cast<uint32_t>(randomSeed >> 32));
+    state.counter = 0;
+}
+
+__global__ void curandInitialize(PhiloxState* state, const int* batchSlots, const int size, const uint64_t randomSeed)
 {
     int const idx = threadIdx.x + blockIdx.x * blockDim.x;
     if (idx < size)
     {
         auto const batchSlot = batchSlots != nullptr ? batchSlots[idx] : idx;
-        curand_init(randomSeed, 0, 0, &state[batchSlot]);
+        philoxInitialize(state[batchSlot], randomSeed);
     }
 }
 
 void invokeCurandInitialize(
-    curandState_t* state, const int* batchSlots, const size_t batchSize, const uint64_t randomSeed, cudaStream_t stream)
+    PhiloxState* state, const int* batchSlots, const size_t batchSize, const uint64_t randomSeed, cudaStream_t stream)
 {
     dim3 block(256);
     dim3 grid((int) (ceil(batchSize * 1.0 / 256)));
@@ -45,17 +105,17 @@ void invokeCurandInitialize(
 }
 
 __global__ void curandBatchInitialize(
-    curandState_t* states, const int* batchSlots, const int size, const uint64_t* randomSeeds)
+    PhiloxState* states, const int* batchSlots, const int size, const uint64_t* randomSeeds)
 {
     int const idx = threadIdx.x + blockIdx.x * blockDim.x;
     if (idx < size)
     {
         auto const batchSlot = batchSlots != nullptr ? batchSlots[idx] : idx;
-        curand_init(randomSeeds[batchSlot], 0, 0, &states[batchSlot]);
+        philoxInitialize(states[batchSlot], randomSeeds[batchSlot]);
     }
 }
 
-void invokeCurandBatchInitialize(curandState_t* states, const int* batchSlots, const size_t batchSize,
+void invokeCurandBatchInitialize(PhiloxState* states, const int* batchSlots, const size_t batchSize,
     const uint64_t* randomSeeds, cudaStream_t stream)
 {
     dim3 block(256);
@@ -198,5 +258,31 @@ template void invokeScatterDecodingParams(
     uint32_t const* src, uint32_t* dst, int const* batchSlots, int batchSize, cudaStream_t stream);
 template void invokeScatterDecodingParams(
     int32_t const* src, int32_t* dst, int const* batchSlots, int batchSize, cudaStream_t stream);
+
+__global__ void scatterBatchedParamsKernel(uint32_t const* src, BatchedParams params, int32_t batchSize)
+{
+    auto const idx = static_cast<int32_t>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (idx >= params.numParams * batchSize)
+    {
+        return;
+    }
+    auto const paramIdx = idx / batchSize;
+    auto const batchIdx = idx % batchSize;
+    auto const batchSlot = src[batchIdx];
+    static_cast<uint32_t*>(params.dst[paramIdx])[batchSlot] = src[(paramIdx + 1) * batchSize + batchIdx];
+}
+
+void invokeScatterBatchedParams(
+    uint32_t const* src, BatchedParams const& params, int32_t batchSize, cudaStream_t stream)
+{
+    TLLM_CHECK(0 <= params.numParams && params.numParams <= BatchedParams::kMaxParams);
+    if (params.numParams == 0 || batchSize == 0)
+    {
+        return;
+    }
+    constexpr int THREADS_PER_CTA = 256;
+    dim3 grid(divUp(params.numParams * batchSize, THREADS_PER_CTA));
+    scatterBatchedParamsKernel<<<grid, THREADS_PER_CTA, 0, stream>>>(src, params, batchSize);
+}
 } // namespace kernels
 } // namespace tensorrt_llm
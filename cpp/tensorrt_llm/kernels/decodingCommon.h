@@ -143,6 +143,66 @@ static_assert(FinishedState::finishedEOS().isFinishedEOS());
 static_assert(FinishedState::finishedStopWords().isFinishedStopWords());
 static_assert(FinishedState::finishedMaxLength().isFinishedMaxLength());
 
+//! \brief Counter-based random number state of a request.
+//! \details Random numbers are drawn from the Philox4x32-10 generator of curand. The key is the random seed of the
+//! request and the counter is the number of draws so far, so the numbers of a request depend neither on its batch slot
+//! nor on the other requests. The state takes 16 bytes instead of the 48 bytes of curandState_t and seeding only stores
+//! the key. Draw numbers with philoxUniform from samplingUtils.cuh.
+struct PhiloxState
+{
+    // Low and high 32 bits of the random seed
+    uint2 key;
+    // Number of random numbers drawn from the state
+    uint64_t counter;
+};
+
+static_assert(sizeof(PhiloxState) == 16);
+
+//! \brief Compact list of the batch indices whose request is not finished, built on the device by
+//! invokeCompactActiveSlots before a decoding step. Kernels launched for the whole batch map the index of their block
+//! or thread through it and return early past the active ones, so that the finished slots do no work. Disabled if
+//! indices is nullptr, the kernels then process every index.
+struct ActiveSlots
+{
+    int32_t const* indices{nullptr};   // [batchSize], batch indices of the active slots in increasing order
+    int32_t const* numActive{nullptr}; // [1]
+
+    [[nodiscard]] __host__ __device__ bool isEnabled() const
+    {
+        return indices != nullptr;
+    }
+
+#ifdef __CUDACC__
+    //! \brief Replace the i-th active slot by its batch index.
+    //! \returns false if i is past the active slots
+    __device__ __forceinline__ bool map(int32_t& batchIdx) const
+    {
+        if (!isEnabled())
+        {
+            return true;
+        }
+        if (batchIdx >= *numActive)
+        {
+            return false;
+        }
+        batchIdx = indices[batchIdx];
+        return true;
+    }
+#endif
+};
+
+//! \brief Collects the batch indices of the requests with a beam that is not finished.
+//!
+//! \param activeSlots output buffer [batchSize]. Batch indices of the active requests in increasing order
+//! \param numActiveSlots output buffer [1]. Number of active requests
+//! \param finished input buffer [maxBatchSize, beamWidth]. Finished states of the previous step
+//! \param batchSlots input buffer[batchSize], optional. Indices of rows of data in memory pool
+//! \param batchSize batch size
+//! \param beamWidth beam width
+//! \param stream stream
+void invokeCompactActiveSlots(int32_t* activeSlots, int32_t* numActiveSlots, FinishedState const* finished,
+    int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth, cudaStream_t stream);
+
 //! \brief Initialize batchSize curand states with given seed.
 //!
 //! \param state output buffer [maxBatchSize]. Curand states to be initialized
@@ -151,7 +211,7 @@ static_assert(FinishedState::finishedMaxLength().isFinishedMaxLength());
 //! \param randomSeed seed to initialize states
 //! \param stream stream
 void invokeCurandInitialize(
-    curandState_t* state, const int* batchSlots, const size_t batchSize, uint64_t randomSeed, cudaStream_t stream);
+    PhiloxState* state, const int* batchSlots, const size_t batchSize, uint64_t randomSeed, cudaStream_t stream);
 
 //! \brief Initialize batchSize curand states with given seed per request.
 //!
@@ -160,7 +220,7 @@ void invokeCurandInitialize(
 //! \param batchSize number of states to initialize
 //! \param randomSeeds input buffer [maxBatchSize] with seeds
 //! \param stream stream
-void invokeCurandBatchInitialize(curandState_t* states, const int* batchSlots, const size_t batchSize,
+void invokeCurandBatchInitialize(PhiloxState* states, const int* batchSlots, const size_t batchSize,
     const uint64_t* randomSeeds, cudaStream_t stream);
 
 //! \brief Applies mask, adds bias to logits and computes softmax values.
@@ -201,5 +261,25 @@ void invokeAddBiasSoftMax(T* logits, T** logitsPtrs, T* probs, T const* bias, in
 //! \param stream stream
 template <typename T>
 void invokeScatterDecodingParams(T const* src, T* dst, int const* batchSlots, int batchSize, cudaStream_t stream);
+
+//! \brief Per-slot buffers of 4-byte setup parameters filled by invokeScatterBatchedParams.
+struct BatchedParams
+{
+    static constexpr int32_t kMaxParams{8};
+
+    void* dst[kMaxParams]{}; // [maxBatchSize] each, float or int32_t
+    int32_t numParams{0};
+};
+
+//! \brief Distributes the setup parameters of all the new requests of a batch with a single kernel, so that they
+//! need a single host to device copy of src instead of one per parameter.
+//!
+//! \param src input buffer [1 + params.numParams, batchSize] on the device. The first row holds the batch slots, the
+//! others the values of each parameter, bitwise copied to params.dst[p][batchSlots[bi]]
+//! \param params output buffers
+//! \param batchSize batch size
+//! \param stream stream
+void invokeScatterBatchedParams(
+    uint32_t const* src, BatchedParams const& params, int32_t batchSize, cudaStream_t stream);
 } // namespace kernels
 } // namespace tensorrt_llm
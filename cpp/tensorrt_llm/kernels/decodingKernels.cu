@@ -19,6 +19,7 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/kernels/decodingKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
 
 using namespace tensorrt_llm::common;
 
@@ -449,26 +450,41 @@ void invokeInitializeOutput(int* outputIds, const int* endIds, int batchBeam, in
 }
 
 __global__ void copyNextStepIds(int* nextStepIds, int** outputIdsPtr, const int* sequenceLengths, const int* batchSlots,
-    int batchSize, int beamWidth, int maxSeqLen)
+    int batchSize, int beamWidth, int maxSeqLen, TokenCounts tokenCounts, ActiveSlots activeSlots)
 {
-    for (int index = blockIdx.x * blockDim.x + threadIdx.x; index < batchSize * beamWidth;
+    auto const numActive = activeSlots.isEnabled() ? *activeSlots.numActive : batchSize;
+    for (int index = blockIdx.x * blockDim.x + threadIdx.x; index < numActive * beamWidth;
          index += blockDim.x * gridDim.x)
     {
-        const int batchIdx{index / beamWidth};
+        int batchIdx{index / beamWidth};
+        activeSlots.map(batchIdx);
         auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
         const int beamIdx{index % beamWidth};
         auto const batchBeamIdx = batchSlot * beamWidth + beamIdx;
-        nextStepIds[batchBeamIdx] = outputIdsPtr[batchSlot][beamIdx * maxSeqLen + sequenceLengths[batchBeamIdx] - 1];
+        auto const tokenId = outputIdsPtr[batchSlot][beamIdx * maxSeqLen + sequenceLengths[batchBeamIdx] - 1];
+        nextStepIds[batchBeamIdx] = tokenId;
+        // One thread per slot for beam width 1, no atomics needed
+        if (tokenCounts.isEnabled() && 0 <= tokenId && tokenId < tokenCounts.vocabSize)
+        {
+            auto const slotOffset = static_cast<size_t>(batchSlot) * tokenCounts.vocabSize;
+            if (tokenCounts.counts[slotOffset + tokenId]++ == 0)
+            {
+                tokenCounts.uniqueTokens[slotOffset + tokenCounts.numUniqueTokens[batchSlot]++] = tokenId;
+            }
+        }
     }
 }
 
 void invokeCopyNextStepIds(int* nextStepIds, int** outputIdsPtr, const int* sequenceLengths, const int* batchSlots,
-    int batchSize, int beamWidth, int maxSeqLen, cudaStream_t stream)
+    int batchSize, int beamWidth, int maxSeqLen, cudaStream_t stream, TokenCounts const& tokenCounts,
+    ActiveSlots const& activeSlots)
 {
+    TLLM_CHECK_WITH_INFO(
+        !tokenCounts.isEnabled() || beamWidth == 1, "Token counts are only supported with beam width 1");
     dim3 block(min(256, batchSize * beamWidth));
     dim3 grid(divUp(batchSize * beamWidth, block.x));
-    copyNextStepIds<<<grid, block, 0, stream>>>(
-        nextStepIds, outputIdsPtr, sequenceLengths, batchSlots, batchSize, beamWidth, maxSeqLen);
+    copyNextStepIds<<<grid, block, 0, stream>>>(nextStepIds, outputIdsPtr, sequenceLengths, batchSlots, batchSize,
+        beamWidth, maxSeqLen, tokenCounts, activeSlots);
 }
 
 __global__ void transposeLogProbs(float* outputLogProbs, float* outputLogProbsTiled, const int* sequenceLengths,
@@ -556,7 +572,7 @@ void invokeAcceptDraftTokensByIds(int32_t const* draftIds, int32_t const* target
 
 template <typename T>
 __global__ void acceptDraftTokensByLogitsKernel(T const* draftProbs, T* targetProbs, int32_t const* numsDraftTokens,
-    FinishedState* finished, curandState_t* curandState, int32_t const* batchSlots, int32_t batchSize,
+    FinishedState* finished, PhiloxState* curandState, int32_t const* batchSlots, int32_t batchSize,
     int32_t maxBatchSize, int32_t maxDraftTokens, int32_t beamWidth, int32_t vocabSize, bool randomThreshold,
     float constantThreshold)
 {
@@ -592,7 +608,7 @@ __global__ void acceptDraftTokensByLogitsKernel(T const* draftProbs, T* targetPr
         // the selected tokens based on the https://arxiv.org/pdf/2302.01318.pdf
         bool const pred = vIdx < vocabSize;
         auto const threshold
-            = pred ? (randomThreshold ? curand_uniform(curandState + batchSlot) : constantThreshold) : 0.f;
+            = pred ? (randomThreshold ? philoxUniform(curandState + batchSlot) : constantThreshold) : 0.f;
         auto const targetProb = pred ? static_cast<float>(targetProbsBatch[vIdx]) : 1.f;
         auto const draftProb = pred ? static_cast<float>(draftProbsBatch[vIdx]) : 0.f;
 
@@ -670,7 +686,7 @@ __global__ void correctAcceptedStatesAndLogits(T const* draftProbs, T* targetPro
 
 template <typename T>
 void acceptDraftTokensByLogits(T* draftLogits, T** targetLogits, T* draftProbs, T* targetProbs,
-    int32_t const* numsDraftTokens, FinishedState* finished, curandState_t* curandState, int32_t const* batchSlots,
+    int32_t const* numsDraftTokens, FinishedState* finished, PhiloxState* curandState, int32_t const* batchSlots,
     int32_t batchSize, int32_t maxBatchSize, int32_t beamWidth, int32_t vocabSize, int32_t vocabSizePadded,
     int32_t maxDraftTokens, bool randomThreshold, float constantThreshold, cudaStream_t stream)
 {
@@ -699,11 +715,11 @@ void acceptDraftTokensByLogits(T* draftLogits, T** targetLogits, T* draftProbs,
 }
 
 template void acceptDraftTokensByLogits(float* draftLogits, float** targetLogits, float* draftProbs, float* targetProbs,
-    int32_t const* numsDraftTokens, FinishedState* finished, curandState_t* curandState, int32_t const* batchSlots,
+    int32_t const* numsDraftTokens, FinishedState* finished, PhiloxState* curandState, int32_t const* batchSlots,
     int32_t batchSize, int32_t maxBatchSize, int32_t beamWidth, int32_t vocabSize, int32_t vocabSizePadded,
     int32_t maxDraftTokens, bool randomThreshold, float constantThreshold, cudaStream_t stream);
 template void acceptDraftTokensByLogits(half* draftLogits, half** targetLogits, half* draftProbs, half* targetProbs,
-    int32_t const* numsDraftTokens, FinishedState* finished, curandState_t* curandState, int32_t const* batchSlots,
+    int32_t const* numsDraftTokens, FinishedState* finished, PhiloxState* curandState, int32_t const* batchSlots,
     int32_t batchSize, int32_t maxBatchSize, int32_t beamWidth, int32_t vocabSize, int32_t vocabSizePadded,
     int32_t maxDraftTokens, bool randomThreshold, float constantThreshold, cudaStream_t stream);
 
@@ -18,6 +18,7 @@
 
 #include "gptKernels.h"
 #include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/penaltyKernels.h"
 #include <cuda_fp16.h>
 #include <cuda_runtime.h>
 #include <curand_kernel.h>
@@ -63,8 +64,12 @@ void invokeFinalize(int32_t* outputIds, int32_t* sequenceLengths, float* cumLogP
 void invokeInitializeOutput(
     int32_t* outputIds, const int32_t* endIds, int batchBeam, int maxSeqLen, cudaStream_t stream);
 
+//! \brief Copies the last token of every sequence to nextStepIds.
+//! If tokenCounts is enabled, the token is also added to the histogram of its slot, see TokenCounts.
+//! With activeSlots, the finished sequences are skipped, their last token was copied when they finished.
 void invokeCopyNextStepIds(int32_t* nextStepIds, int32_t** outputIdsPtr, int32_t const* sequenceLengths,
-    int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth, int32_t maxSeqLen, cudaStream_t stream);
+    int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth, int32_t maxSeqLen, cudaStream_t stream,
+    TokenCounts const& tokenCounts = {}, ActiveSlots const& activeSlots = {});
 
 //! \brief Accepts or rejects draft tokens based on the equality of draft and target tokens
 //! for speculative decoding. Target token is accepted if targetToken == draftToken.
@@ -125,7 +130,7 @@ void invokeAcceptDraftTokensByIds(int32_t const* draftIds, int32_t const* target
 //! \param stream stream
 template <typename T>
 void acceptDraftTokensByLogits(T* draftLogits, T** targetLogits, T* draftProbs, T* targetProbs,
-    int32_t const* numsDraftTokens, FinishedState* finished, curandState_t* curandState, int32_t const* batchSlots,
+    int32_t const* numsDraftTokens, FinishedState* finished, PhiloxState* curandState, int32_t const* batchSlots,
     int32_t batchSize, int32_t maxBatchSize, int32_t beamWidth, int32_t vocabSize, int32_t vocabSizePadded,
     int32_t maxDraftTokens, bool randomThreshold, float constantThreshold, cudaStream_t stream);
 
@@ -54,6 +54,10 @@ enum class RotaryScalingType : int8_t
     kNONE = 0,
     kLINEAR = 1,
     kDYNAMIC = 2,
+    // YaRN, the coefficients come from the table of buildRotaryCosSinCache.
+    kYARN = 3,
+    // LongRoPE per frequency rescaling, the coefficients come from the table of buildRotaryCosSinCache.
+    kLONGROPE = 4,
 };
 
 template <typename AttentionMaskDataType>
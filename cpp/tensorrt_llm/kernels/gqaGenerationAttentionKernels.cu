@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/gqaGenerationAttentionKernels.h"
+
+#include <mma.h>
+#include <type_traits>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+namespace wmma = nvcuda::wmma;
+
+// Rows of the MMA tiles, i.e. query heads of one KV head processed together.
+constexpr int32_t kMmaRows = 16;
+constexpr int32_t kMmaCols = 16;
+constexpr int32_t kWarpsPerBlock = 4;
+constexpr int32_t kThreadsPerBlock = kWarpsPerBlock * 32;
+// Threads sharing a row in the softmax, all in the same warp.
+constexpr int32_t kThreadsPerRow = kThreadsPerBlock / kMmaRows;
+
+// Tokens of K and V staged in shared memory at a time.
+template <int32_t HEAD_SIZE>
+constexpr int32_t tileTokens()
+{
+    return HEAD_SIZE <= 128 ? 64 : 32;
+}
+
+template <typename T, int32_t HEAD_SIZE>
+constexpr size_t sharedMemorySize()
+{
+    constexpr auto kTileTokens = tileTokens<HEAD_SIZE>();
+    // Q, K, V, scores, probabilities, output and the softmax state of each row.
+    return sizeof(T) * (kMmaRows + 2 * kTileTokens) * HEAD_SIZE + sizeof(float) * kMmaRows * kTileTokens
+        + sizeof(T) * kMmaRows * kTileTokens + sizeof(float) * kMmaRows * HEAD_SIZE + sizeof(float) * 3 * kMmaRows;
+}
+
+template <typename T, typename TCache, int32_t HEAD_SIZE, typename KVCacheBuffer>
+__device__ void gqaGenerationAttention(GQAGenerationAttentionParams const& params, KVCacheBuffer& kvCacheBuffer)
+{
+    constexpr auto kTileTokens = tileTokens<HEAD_SIZE>();
+    constexpr bool kQuantizedCache = !std::is_same_v<T, TCache>;
+
+    extern __shared__ __align__(128) char smem[];
+    auto* qTile = reinterpret_cast<T*>(smem);
+    auto* kTile = qTile + kMmaRows * HEAD_SIZE;
+    auto* vTile = kTile + kTileTokens * HEAD_SIZE;
+    auto* sTile = reinterpret_cast<float*>(vTile + kTileTokens * HEAD_SIZE);
+    auto* pTile = reinterpret_cast<T*>(sTile + kMmaRows * kTileTokens);
+    auto* oTile = reinterpret_cast<float*>(pTile + kMmaRows * kTileTokens);
+    auto* rowMax = oTile + kMmaRows * HEAD_SIZE;
+    auto* rowSum = rowMax + kMmaRows;
+    auto* rowScale = rowSum + kMmaRows;
+
+    auto const warpIdx = static_cast<int32_t>(threadIdx.x) / 32;
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+    auto const numChunks = (headsPerKv + kMmaRows - 1) / kMmaRows;
+    auto const kvHeadIdx = static_cast<int32_t>(blockIdx.x) / numChunks;
+    auto const firstQHead = kvHeadIdx * headsPerKv + (static_cast<int32_t>(blockIdx.x) % numChunks) * kMmaRows;
+    auto const numRows = min(kMmaRows, (kvHeadIdx + 1) * headsPerKv - firstQHead);
+    auto const seqIdx = static_cast<int32_t>(blockIdx.y);
+    auto const seqLen = params.seqLens[seqIdx];
+    auto const tokenBegin = max(0, seqLen - params.cyclicAttentionWindowSize);
+    auto const kvScale = kQuantizedCache ? params.kvScaleQuantOrig[0] : 1.f;
+
+    // The softmax scale is folded into Q. Rows past the last query head are zeros.
+    auto const* q = reinterpret_cast<T const*>(params.q)
+        + (static_cast<size_t>(seqIdx) * params.numQHeads + firstQHead) * HEAD_SIZE;
+    for (int32_t idx = threadIdx.x; idx < kMmaRows * HEAD_SIZE; idx += kThreadsPerBlock)
+    {
+        auto const row = idx / HEAD_SIZE;
+        qTile[idx] = cuda_cast<T>(row < numRows ? cuda_cast<float>(q[idx]) * params.softmaxScale : 0.f);
+        oTile[idx] = 0.f;
+    }
+    if (threadIdx.x < kMmaRows)
+    {
+        rowMax[threadIdx.x] = -INFINITY;
+        rowSum[threadIdx.x] = 0.f;
+    }
+
+    for (int32_t tileBegin = tokenBegin; tileBegin < seqLen; tileBegin += kTileTokens)
+    {
+        auto const tileLen = min(kTileTokens, seqLen - tileBegin);
+
+        __syncthreads();
+        // Rows past the end of the sequence are zeroed so that they contribute nothing to the output.
+        for (int32_t idx = threadIdx.x; idx < kTileTokens * HEAD_SIZE; idx += kThreadsPerBlock)
+        {
+            auto const tileTokenIdx = idx / HEAD_SIZE;
+            auto const channelIdx = idx % HEAD_SIZE;
+            float kValue = 0.f;
+            float vValue = 0.f;
+            if (tileTokenIdx < tileLen)
+            {
+                auto const tokenIdx = kvCacheBuffer.getKVTokenIdx(tileBegin + tileTokenIdx);
+                auto const kLocalIdx
+                    = kvCacheBuffer.template getKLocalIdx<TCache>(tokenIdx, kvHeadIdx, HEAD_SIZE, channelIdx);
+                auto const vLocalIdx = kvCacheBuffer.getKVLocalIdx(tokenIdx, kvHeadIdx, HEAD_SIZE, channelIdx);
+                kValue = static_cast<float>(
+                    reinterpret_cast<TCache const*>(kvCacheBuffer.getKBlockPtr(seqIdx, tokenIdx))[kLocalIdx]);
+                vValue = static_cast<float>(
+                    reinterpret_cast<TCache const*>(kvCacheBuffer.getVBlockPtr(seqIdx, tokenIdx))[vLocalIdx]);
+            }
+            kTile[idx] = cuda_cast<T>(kValue * kvScale);
+            vTile[idx] = cuda_cast<T>(vValue * kvScale);
+        }
+        __syncthreads();
+
+        // S = Q * K^T, one 16x16 block of scores per warp.
+        for (int32_t colTile = warpIdx; colTile < kTileTokens / kMmaCols; colTile += kWarpsPerBlock)
+        {
+            wmma::fragment<wmma::accumulator, kMmaRows, kMmaCols, 16, float> sFrag;
+            wmma::fill_fragment(sFrag, 0.f);
+#pragma unroll
+            for (int32_t k = 0; k < HEAD_SIZE; k += 16)
+            {
+                wmma::fragment<wmma::matrix_a, kMmaRows, kMmaCols, 16, T, wmma::row_major> qFrag;
+                wmma::fragment<wmma::matrix_b, kMmaRows, kMmaCols, 16, T, wmma::col_major> kFrag;
+                wmma::load_matrix_sync(qFrag, qTile + k, HEAD_SIZE);
+                wmma::load_matrix_sync(kFrag, kTile + colTile * kMmaCols * HEAD_SIZE + k, HEAD_SIZE);
+                wmma::mma_sync(sFrag, qFrag, kFrag, sFrag);
+            }
+            wmma::store_matrix_sync(sTile + colTile * kMmaCols, sFrag, kTileTokens, wmma::mem_row_major);
+        }
+        __syncthreads();
+
+        // Online softmax, kThreadsPerRow consecutive threads per row.
+        {
+            auto const row = static_cast<int32_t>(threadIdx.x) / kThreadsPerRow;
+            auto const rowLane = static_cast<int32_t>(threadIdx.x) % kThreadsPerRow;
+            float tileMax = -INFINITY;
+            for (int32_t col = rowLane; col < tileLen; col += kThreadsPerRow)
+            {
+                tileMax = fmaxf(tileMax, sTile[row * kTileTokens + col]);
+            }
+#pragma unroll
+            for (int32_t mask = kThreadsPerRow / 2; mask > 0; mask >>= 1)
+            {
+                tileMax = fmaxf(tileMax, __shfl_xor_sync(0xffffffff, tileMax, mask));
+            }
+            auto const prevMax = rowMax[row];
+            auto const newMax = fmaxf(prevMax, tileMax);
+            float tileSum = 0.f;
+            for (int32_t col = rowLane; col < kTileTokens; col += kThreadsPerRow)
+            {
+                auto const p = col < tileLen ? __expf(sTile[row * kTileTokens + col] - newMax) : 0.f;
+                tileSum += p;
+                pTile[row * kTileTokens + col] = cuda_cast<T>(p);
+            }
+#pragma unroll
+            for (int32_t mask = kThreadsPerRow / 2; mask > 0; mask >>= 1)
+            {
+                tileSum += __shfl_xor_sync(0xffffffff, tileSum, mask);
+            }
+            if (rowLane == 0)
+            {
+                auto const scale = __expf(prevMax - newMax);
+                rowScale[row] = scale;
+                rowSum[row] = rowSum[row] * scale + tileSum;
+                rowMax[row] = newMax;
+            }
+        }
+        __syncthreads();
+
+        for (int32_t idx = threadIdx.x; idx < kMmaRows * HEAD_SIZE; idx += kThreadsPerBlock)
+        {
+            oTile[idx] *= rowScale[idx / HEAD_SIZE];
+        }
+        __syncthreads();
+
+        // O += P * V, one 16x16 block of the output per warp at a time.
+        for (int32_t colTile = warpIdx; colTile < HEAD_SIZE / kMmaCols; colTile += kWarpsPerBlock)
+        {
+            wmma::fragment<wmma::accumulator, kMmaRows, kMmaCols, 16, float> oFrag;
+            wmma::load_matrix_sync(oFrag, oTile + colTile * kMmaCols, HEAD_SIZE, wmma::mem_row_major);
+#pragma unroll
+            for (int32_t k = 0; k < kTileTokens; k += 16)
+            {
+                wmma::fragment<wmma::matrix_a, kMmaRows, kMmaCols, 16, T, wmma::row_major> pFrag;
+                wmma::fragment<wmma::matrix_b, kMmaRows, kMmaCols, 16, T, wmma::row_major> vFrag;
+                wmma::load_matrix_sync(pFrag, pTile + k, kTileTokens);
+                wmma::load_matrix_sync(vFrag, vTile + k * HEAD_SIZE + colTile * kMmaCols, HEAD_SIZE);
+                wmma::mma_sync(oFrag, pFrag, vFrag, oFrag);
+            }
+            wmma::store_matrix_sync(oTile + colTile * kMmaCols, oFrag, HEAD_SIZE, wmma::mem_row_major);
+        }
+    }
+    __syncthreads();
+
+    // The output may alias Q, which was entirely read before the first tile.
+    auto* output = reinterpret_cast<T*>(params.output)
+        + (static_cast<size_t>(seqIdx) * params.numQHeads + firstQHead) * HEAD_SIZE;
+    for (int32_t idx = threadIdx.x; idx < numRows * HEAD_SIZE; idx += kThreadsPerBlock)
+    {
+        output[idx] = cuda_cast<T>(oTile[idx] / rowSum[idx / HEAD_SIZE]);
+    }
+}
+
+template <typename T, typename TCache, int32_t HEAD_SIZE, typename KVCacheBuffer>
+__global__ void __launch_bounds__(kThreadsPerBlock)
+    gqaGenerationAttentionKernel(GQAGenerationAttentionParams params, KVCacheBuffer kvCacheBuffer)
+{
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ < 800
+    // The BF16 MMA needs SM 80.
+    if constexpr (std::is_same_v<T, half>)
+    {
+        gqaGenerationAttention<T, TCache, HEAD_SIZE>(params, kvCacheBuffer);
+    }
+#else
+    gqaGenerationAttention<T, TCache, HEAD_SIZE>(params, kvCacheBuffer);
+#endif
+}
+
+template <typename T, typename TCache, int32_t HEAD_SIZE, typename KVCacheBuffer>
+void launchGQAGenerationAttention(
+    GQAGenerationAttentionParams const& params, KVCacheBuffer const& kvCacheBuffer, cudaStream_t stream)
+{
+    auto const kernel = gqaGenerationAttentionKernel<T, TCache, HEAD_SIZE, KVCacheBuffer>;
+    auto constexpr smemSize = sharedMemorySize<T, HEAD_SIZE>();
+    if (smemSize >= 48 * 1024)
+    {
+        TLLM_CUDA_CHECK(cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smemSize));
+    }
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+    dim3 const grid(params.numKVHeads * divUp(headsPerKv, kMmaRows), params.batchSize);
+    kernel<<<grid, kThreadsPerBlock, smemSize, stream>>>(params, kvCacheBuffer);
+}
+
+} // namespace
+
+bool isGQAGenerationAttentionSupported(bool isBf16, int32_t headSize, int32_t smVersion)
+{
+    auto const headSizeSupported = headSize == 32 || headSize == 64 || headSize == 128 || headSize == 256;
+    return headSizeSupported && smVersion >= (isBf16 ? 80 : 70);
+}
+
+template <typename T, typename TCache, typename KVCacheBuffer>
+void invokeGQAGenerationAttention(
+    GQAGenerationAttentionParams const& params, KVCacheBuffer const& kvCacheBuffer, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.numQHeads % params.numKVHeads == 0,
+        "The number of query heads must be a multiple of the number of KV heads");
+    TLLM_CHECK_WITH_INFO(std::is_same_v<T, TCache> || params.kvScaleQuantOrig != nullptr,
+        "A quantized KV cache needs its dequantization scale");
+    switch (params.headSize)
+    {
+    case 32: launchGQAGenerationAttention<T, TCache, 32>(params, kvCacheBuffer, stream); break;
+    case 64: launchGQAGenerationAttention<T, TCache, 64>(params, kvCacheBuffer, stream); break;
+    case 128: launchGQAGenerationAttention<T, TCache, 128>(params, kvCacheBuffer, stream); break;
+    case 256: launchGQAGenerationAttention<T, TCache, 256>(params, kvCacheBuffer, stream); break;
+    default: TLLM_THROW("GQA generation attention does not support head size %d", params.headSize);
+    }
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_GQA_GENERATION_ATTENTION(T, TCache)                                                                \
+    template void invokeGQAGenerationAttention<T, TCache, KVLinearBuffer>(                                             \
+        GQAGenerationAttentionParams const& params, KVLinearBuffer const& kvCacheBuffer, cudaStream_t stream);         \
+    template void invokeGQAGenerationAttention<T, TCache, KVBlockArray>(                                               \
+        GQAGenerationAttentionParams const& params, KVBlockArray const& kvCacheBuffer, cudaStream_t stream)
+
+INSTANTIATE_GQA_GENERATION_ATTENTION(half, half);
+INSTANTIATE_GQA_GENERATION_ATTENTION(half, int8_t);
+#ifdef ENABLE_FP8
+INSTANTIATE_GQA_GENERATION_ATTENTION(half, __nv_fp8_e4m3);
+#endif
+#ifdef ENABLE_BF16
+INSTANTIATE_GQA_GENERATION_ATTENTION(__nv_bfloat16, __nv_bfloat16);
+INSTANTIATE_GQA_GENERATION_ATTENTION(__nv_bfloat16, int8_t);
+#ifdef ENABLE_FP8
+INSTANTIATE_GQA_GENERATION_ATTENTION(__nv_bfloat16, __nv_fp8_e4m3);
+#endif
+#endif
+#undef INSTANTIATE_GQA_GENERATION_ATTENTION
+
+} // namespace kernels
+} // namespace tensorrt_llm
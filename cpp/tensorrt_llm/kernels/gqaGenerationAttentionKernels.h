@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Generation attention on tensor cores for grouped-query attention. The query heads sharing a KV head are processed
+// together as the rows of a 16-row MMA tile, so Q*K^T and P*V run as small GEMMs against K/V tiles staged in shared
+// memory once per KV head, instead of the per-head dot products of MMHA that read the same K/V once per query head.
+
+struct GQAGenerationAttentionParams
+{
+    // Queries after bias and RoPE, [batchSize, numQHeads, headSize]
+    void const* q;
+    // Attention output, [batchSize, numQHeads, headSize], may alias q
+    void* output;
+    // Tokens in the KV cache of each sequence, the one of the current step included, [batchSize]
+    int32_t const* seqLens;
+    // Scale from the quantized KV cache to the original values, [1], INT8 and FP8 caches only
+    float const* kvScaleQuantOrig;
+
+    int32_t batchSize;
+    int32_t numQHeads;
+    int32_t numKVHeads;
+    int32_t headSize;
+    // Tokens attended at most, the older tokens of a cyclic KV cache are overwritten
+    int32_t cyclicAttentionWindowSize;
+    float softmaxScale;
+};
+
+//! \brief Query heads per KV head from which the tensor core kernel is used instead of MMHA.
+constexpr int32_t kGQAGenerationMinHeadsPerKv = 4;
+
+//! \brief Whether invokeGQAGenerationAttention supports a configuration.
+//! \details Head sizes 32, 64, 128 and 256, FP16 on SM 70 and newer, BF16 on SM 80 and newer.
+bool isGQAGenerationAttentionSupported(bool isBf16, int32_t headSize, int32_t smVersion);
+
+//! \brief Attention of the single query token of each sequence over its KV cache.
+//! \details T is the type of Q and of the output, TCache the type of the KV cache: T, int8_t or __nv_fp8_e4m3.
+//! No beam search (no cache indirection), no sink tokens and no attention bias.
+template <typename T, typename TCache, typename KVCacheBuffer>
+void invokeGQAGenerationAttention(
+    GQAGenerationAttentionParams const& params, KVCacheBuffer const& kvCacheBuffer, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
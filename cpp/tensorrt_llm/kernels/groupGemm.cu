@@ -25,6 +25,7 @@
 #include "groupGemm.h"
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/hopper_grouped_gemm/hopper_grouped_gemm.h"
 
 #include "tensorrt_llm/common/cudaUtils.h"
 
@@ -170,6 +171,87 @@ void groupedGemm_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vect
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+// Runs the groups with the TMA grouped GEMM of Hopper, the arrays of the groups are laid out in the params workspace as
+// for the SM80 kernels. Returns false when the shapes or pointers are not 16 byte aligned for TMA.
+template <typename T>
+bool hopperGroupedGemm_(std::vector<cutlass::gemm::GemmCoord> const& problem_sizes, std::vector<void*> const& ptrA,
+    std::vector<void*> const& ptrB, std::vector<void*> const& ptrD, void* gemmParamsWorkSpace,
+    int64_t gemmParamsWorkSpaceSize, void* gemmWorkSpace, int64_t gemmWorkspaceSize, cudaStream_t stream)
+{
+    using Runner = cutlass_kernels::CutlassHopperGroupedGemmRunner<T>;
+    auto const sm = tensorrt_llm::common::getSMVersion();
+    auto const isAligned = [](void const* ptr) { return reinterpret_cast<uintptr_t>(ptr) % 16 == 0; };
+    int problem_count = problem_sizes.size();
+    for (int32_t i = 0; i < problem_count; ++i)
+    {
+        auto const& problem = problem_sizes.at(i);
+        if (!Runner::isSupported(sm, problem.n(), problem.k()) || !isAligned(ptrA.at(i)) || !isAligned(ptrB.at(i))
+            || !isAligned(ptrD.at(i)))
+        {
+            return false;
+        }
+    }
+
+    Runner runner;
+    // The group arrays fit in the params workspace, the GEMM workspace only has to hold the TMA descriptors.
+    cutlass_kernels::HopperGroupedGemmInput input;
+    input.gemmWorkspaceBytes = runner.getWorkspaceSize(/* numGroups */ 0);
+    if (input.gemmWorkspaceBytes > static_cast<size_t>(gemmWorkspaceSize))
+    {
+        return false;
+    }
+
+    auto gemm_coord_size = getGemmCoordSize(problem_count);
+    auto ptr_size = getPtrSize(problem_count);
+    auto ldd_size = getLddSize(problem_count);
+
+    std::vector<char> host_workspace(gemmParamsWorkSpaceSize);
+    auto* problem_sizes_host = reinterpret_cast<cutlass::gemm::GemmCoord*>(host_workspace.data());
+    auto** ptr_A_host = reinterpret_cast<void const**>(host_workspace.data() + gemm_coord_size);
+    auto** ptr_B_host = reinterpret_cast<void const**>(host_workspace.data() + gemm_coord_size + ptr_size);
+    auto** ptr_D_host = reinterpret_cast<void**>(host_workspace.data() + gemm_coord_size + 3 * ptr_size);
+    auto* lda_host = reinterpret_cast<int64_t*>(host_workspace.data() + gemm_coord_size + 4 * ptr_size);
+    auto* ldb_host = reinterpret_cast<int64_t*>(host_workspace.data() + gemm_coord_size + 4 * ptr_size + ldd_size);
+    auto* ldd_host = reinterpret_cast<int64_t*>(host_workspace.data() + gemm_coord_size + 4 * ptr_size + 3 * ldd_size);
+    for (int32_t i = 0; i < problem_count; ++i)
+    {
+        auto const& problem = problem_sizes.at(i);
+        problem_sizes_host[i] = problem;
+        ptr_A_host[i] = ptrA.at(i);
+        ptr_B_host[i] = ptrB.at(i);
+        ptr_D_host[i] = ptrD.at(i);
+        lda_host[i] = problem.k();
+        // The LoRA weights are [n, k] column-major
+        ldb_host[i] = problem.k();
+        ldd_host[i] = problem.n();
+    }
+    tensorrt_llm::common::cudaAutoCpy(
+        (int8_t*) gemmParamsWorkSpace, (int8_t*) host_workspace.data(), gemmParamsWorkSpaceSize, stream);
+
+    auto* params = static_cast<char*>(gemmParamsWorkSpace);
+    // GemmCoord is three ints, the (m, n, k) layout of the Hopper problem shapes
+    input.problemShapes = reinterpret_cast<int32_t*>(params);
+    input.ptrA = reinterpret_cast<void const**>(params + gemm_coord_size);
+    input.ptrB = reinterpret_cast<void const**>(params + gemm_coord_size + ptr_size);
+    input.ptrC = reinterpret_cast<void const**>(params + gemm_coord_size + 2 * ptr_size);
+    input.ptrD = reinterpret_cast<void**>(params + gemm_coord_size + 3 * ptr_size);
+    input.ldA = reinterpret_cast<int64_t*>(params + gemm_coord_size + 4 * ptr_size);
+    input.ldB = reinterpret_cast<int64_t*>(params + gemm_coord_size + 4 * ptr_size + ldd_size);
+    input.ldC = reinterpret_cast<int64_t*>(params + gemm_coord_size + 4 * ptr_size + 2 * ldd_size);
+    input.ldD = reinterpret_cast<int64_t*>(params + gemm_coord_size + 4 * ptr_size + 3 * ldd_size);
+    input.numGroups = problem_count;
+    input.hasBias = false;
+    input.gemmWorkspace = static_cast<char*>(gemmWorkSpace);
+
+    tensorrt_llm::cutlass_extensions::CutlassGemmConfig config(
+        tensorrt_llm::cutlass_extensions::CutlassTileConfigSM90::CtaShape128x128x128B,
+        tensorrt_llm::cutlass_extensions::MainloopScheduleType::AUTO,
+        tensorrt_llm::cutlass_extensions::EpilogueScheduleType::AUTO,
+        tensorrt_llm::cutlass_extensions::ClusterShape::ClusterShape_1x1x1);
+    runner.gemm(input, /* weightsColumnMajor */ true, cutlass_kernels::GroupedGemmActivation::Identity, config, stream);
+    return true;
+}
+
 template <int M1, int N1, int K1, int M2, int N2, int K2>
 void groupedGemmType_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vector<void*> ptrA,
     std::vector<void*> ptrB, std::vector<void*> ptrC, std::vector<void*> ptrD, void* gemmParamsWorkSpace,
@@ -198,6 +280,23 @@ void groupedGemm(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vecto
     std::vector<void*> ptrC, std::vector<void*> ptrD, void* gemmParamsWorkSpace, int64_t gemmParamsWorkSpaceSize,
     void* gemmWorkSpace, int64_t gemmWorkspaceSize, bool isLoraIn, nvinfer1::DataType dataType, cudaStream_t stream)
 {
+    // The LoRA out GEMMs have the large N of the hidden size and run with the TMA kernels on Hopper. The LoRA in GEMMs
+    // have N = rank, far below the 128 rows of the Hopper tiles, and stay on the SM80 kernels.
+    if (!isLoraIn && dataType == nvinfer1::DataType::kHALF
+        && hopperGroupedGemm_<half>(problem_sizes, ptrA, ptrB, ptrD, gemmParamsWorkSpace, gemmParamsWorkSpaceSize,
+            gemmWorkSpace, gemmWorkspaceSize, stream))
+    {
+        return;
+    }
+#ifdef ENABLE_BF16
+    if (!isLoraIn && dataType == nvinfer1::DataType::kBF16
+        && hopperGroupedGemm_<__nv_bfloat16>(problem_sizes, ptrA, ptrB, ptrD, gemmParamsWorkSpace,
+            gemmParamsWorkSpaceSize, gemmWorkSpace, gemmWorkspaceSize, stream))
+    {
+        return;
+    }
+#endif
+
     if (isLoraIn)
     {
         groupedGemmType_<16, 32, 64, 16, 32, 64>(problem_sizes, ptrA, ptrB, ptrC, ptrD, gemmParamsWorkSpace,
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/kvCacheEvictionKernels.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+constexpr int32_t kBlockSize = 256;
+
+// Candidates for eviction are compared by class first, then by value and slot.
+enum EvictionClass : int32_t
+{
+    kEMPTY = 0,
+    // Outside the sinks and the recent window, ordered by attention mass.
+    kEVICTABLE = 1,
+    // Within the recent window, ordered by position. Only used when the window covers every non-sink slot.
+    kRECENT = 2,
+    kSINK = 3
+};
+
+struct EvictionCandidate
+{
+    int32_t cls;
+    float value;
+    int32_t slot;
+};
+
+struct MinCandidate
+{
+    __device__ EvictionCandidate operator()(EvictionCandidate const& a, EvictionCandidate const& b) const
+    {
+        if (a.cls != b.cls)
+        {
+            return a.cls < b.cls ? a : b;
+        }
+        if (a.value != b.value)
+        {
+            return a.value < b.value ? a : b;
+        }
+        return a.slot < b.slot ? a : b;
+    }
+};
+
+__global__ void initKVCacheEvictionKernel(KVBlockArray kvCache, int32_t const* sequenceLengths, int32_t sizePerHead,
+    int32_t elemBytes)
+{
+    auto const kvHeadIdx = static_cast<int32_t>(blockIdx.x);
+    auto const numKvHeads = static_cast<int32_t>(gridDim.x);
+    auto const seqIdx = static_cast<int32_t>(blockIdx.y);
+    auto const seqLen = sequenceLengths[seqIdx];
+    auto const sinkLen = kvCache.mSinkTokens;
+    auto const capacity = sinkLen + kvCache.mCyclicCacheLen;
+
+    for (int32_t slot = threadIdx.x; slot < capacity; slot += blockDim.x)
+    {
+        // The last token written to the slot by the cyclic cache, see KVBlockArray::getKVTokenIdx.
+        int32_t position = -1;
+        if (slot < seqLen)
+        {
+            auto const cyclicLen = kvCache.mCyclicCacheLen;
+            position = slot < sinkLen ? slot : slot + (seqLen - 1 - slot) / cyclicLen * cyclicLen;
+        }
+        auto const idx = kvCache.getKVScaleIdx(slot, kvHeadIdx);
+        getKVEvictionMassPtr(kvCache.getKBlockPtr(seqIdx, slot), numKvHeads, kvCache.mTokensPerBlock, sizePerHead,
+            elemBytes)[idx]
+            = 0.f;
+        getKVEvictionPositionPtr(kvCache.getVBlockPtr(seqIdx, slot), numKvHeads, kvCache.mTokensPerBlock, sizePerHead,
+            elemBytes)[idx]
+            = position;
+    }
+}
+
+__global__ void selectKVCacheEvictionSlotsKernel(KVBlockArray kvCache, int32_t const* sequenceLengths,
+    int32_t sizePerHead, int32_t elemBytes, int32_t recentWindow, int32_t* writeSlots)
+{
+    using BlockReduce = cub::BlockReduce<EvictionCandidate, kBlockSize>;
+    __shared__ typename BlockReduce::TempStorage tempStorage;
+
+    auto const kvHeadIdx = static_cast<int32_t>(blockIdx.x);
+    auto const numKvHeads = static_cast<int32_t>(gridDim.x);
+    auto const seqIdx = static_cast<int32_t>(blockIdx.y);
+    // Position of the new token, i.e. the number of tokens before it.
+    auto const position = sequenceLengths[seqIdx] - 1;
+    auto const sinkLen = kvCache.mSinkTokens;
+    auto const capacity = sinkLen + kvCache.mCyclicCacheLen;
+    auto const tokensPerBlock = kvCache.mTokensPerBlock;
+
+    int32_t slot = position;
+    if (position >= capacity)
+    {
+        EvictionCandidate candidate{kSINK, 0.f, capacity};
+        for (int32_t s = threadIdx.x; s < capacity; s += blockDim.x)
+        {
+            auto const idx = kvCache.getKVScaleIdx(s, kvHeadIdx);
+            auto const slotPosition = getKVEvictionPositionPtr(
+                kvCache.getVBlockPtr(seqIdx, s), numKvHeads, tokensPerBlock, sizePerHead, elemBytes)[idx];
+            EvictionCandidate other{kSINK, 0.f, s};
+            if (slotPosition < 0)
+            {
+                other.cls = kEMPTY;
+            }
+            else if (slotPosition >= sinkLen && slotPosition < position - recentWindow)
+            {
+                other.cls = kEVICTABLE;
+                other.value = getKVEvictionMassPtr(
+                    kvCache.getKBlockPtr(seqIdx, s), numKvHeads, tokensPerBlock, sizePerHead, elemBytes)[idx];
+            }
+            else if (slotPosition >= sinkLen)
+            {
+                other.cls = kRECENT;
+                other.value = static_cast<float>(slotPosition);
+            }
+            candidate = MinCandidate{}(candidate, other);
+        }
+        candidate = BlockReduce(tempStorage).Reduce(candidate, MinCandidate{});
+        // Only the sinks are cached, fall back to the cyclic slot.
+        slot = candidate.cls == kSINK ? kvCache.getKVTokenIdx(position) : candidate.slot;
+    }
+
+    if (threadIdx.x == 0)
+    {
+        writeSlots[seqIdx * numKvHeads + kvHeadIdx] = slot;
+        auto const idx = kvCache.getKVScaleIdx(slot, kvHeadIdx);
+        getKVEvictionMassPtr(
+            kvCache.getKBlockPtr(seqIdx, slot), numKvHeads, tokensPerBlock, sizePerHead, elemBytes)[idx]
+            = 0.f;
+        getKVEvictionPositionPtr(
+            kvCache.getVBlockPtr(seqIdx, slot), numKvHeads, tokensPerBlock, sizePerHead, elemBytes)[idx]
+            = position;
+    }
+}
+
+} // namespace
+
+void invokeInitKVCacheEviction(KVBlockArray const& kvCache, int32_t const* sequenceLengths, int32_t batchSize,
+    int32_t numKvHeads, int32_t sizePerHead, int32_t elemBytes, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(kvCache.mBubbleLen == 0 && !kvCache.mEnableOneMoreBlock,
+        "KV cache eviction needs a sink token length multiple of the tokens per block and no extra block");
+    dim3 const grid(numKvHeads, batchSize);
+    initKVCacheEvictionKernel<<<grid, kBlockSize, 0, stream>>>(kvCache, sequenceLengths, sizePerHead, elemBytes);
+    sync_check_cuda_error();
+}
+
+void invokeSelectKVCacheEvictionSlots(KVBlockArray const& kvCache, int32_t const* sequenceLengths, int32_t batchSize,
+    int32_t numKvHeads, int32_t sizePerHead, int32_t elemBytes, int32_t recentWindow, int32_t* writeSlots,
+    cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(kvCache.mBubbleLen == 0 && !kvCache.mEnableOneMoreBlock,
+        "KV cache eviction needs a sink token length multiple of the tokens per block and no extra block");
+    dim3 const grid(numKvHeads, batchSize);
+    selectKVCacheEvictionSlotsKernel<<<grid, kBlockSize, 0, stream>>>(
+        kvCache, sequenceLengths, sizePerHead, elemBytes, recentWindow, writeSlots);
+    sync_check_cuda_error();
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
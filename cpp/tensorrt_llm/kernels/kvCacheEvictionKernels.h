@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Attention-guided eviction of the paged KV cache (Heavy-Hitter Oracle). The attention window of a sequence is a fixed
+// budget of cache slots. Until it is full, the tokens are written in order as usual. After that, each new token
+// replaces, per KV head, the cached token that received the least attention mass so far. The sinks and the most recent
+// tokens are never evicted. The MMHA kernel accumulates the mass and writes the new token to the selected slot, the
+// metadata of each slot is stored in the blocks, see getKVEvictionMassPtr.
+
+//! \brief Set the positions of the tokens in the cache after the context of each sequence was written and reset their
+//! attention mass. sequenceLengths are the numbers of tokens written so far, the cache must have no bubble after the
+//! sinks, i.e. the sink token length must be a multiple of the tokens per block.
+void invokeInitKVCacheEviction(KVBlockArray const& kvCache, int32_t const* sequenceLengths, int32_t batchSize,
+    int32_t numKvHeads, int32_t sizePerHead, int32_t elemBytes, cudaStream_t stream);
+
+//! \brief Select the slot of the new token of each generating sequence and KV head, [batchSize, numKvHeads], and
+//! assign the slot to it. sequenceLengths include the new token. The tokens within recentWindow of the new one and
+//! the sinks are kept, among the others the one with the least attention mass is replaced.
+void invokeSelectKVCacheEvictionSlots(KVBlockArray const& kvCache, int32_t const* sequenceLengths, int32_t batchSize,
+    int32_t numKvHeads, int32_t sizePerHead, int32_t elemBytes, int32_t recentWindow, int32_t* writeSlots,
+    cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -26,6 +26,66 @@ namespace tensorrt_llm
 namespace kernels
 {
 
+// INT4 KV cache layout. Each K or V block holds the packed 4-bit values [numHeads, tokensPerBlock, sizePerHead / 2],
+// two values per byte with the even channel in the low nibble, followed by the per token and head quantization
+// parameters [numHeads, tokensPerBlock] stored as half2 {scale, zero}. A value is dequantized as q * scale + zero.
+__host__ __device__ constexpr inline int32_t getInt4KVCacheBytesPerHead(int32_t sizePerHead)
+{
+    return sizePerHead / 2 + static_cast<int32_t>(sizeof(half2));
+}
+
+__host__ __device__ inline half2* getInt4KVScaleZeroPtr(
+    void* blockPtr, int32_t numHeads, int32_t tokensPerBlock, int32_t sizePerHead)
+{
+    return reinterpret_cast<half2*>(reinterpret_cast<int8_t*>(blockPtr) + numHeads * tokensPerBlock * sizePerHead / 2);
+}
+
+// Layout of the INT8/FP8 KV cache with dynamic scales. Each K or V block holds the 8-bit values
+// [numHeads, tokensPerBlock, sizePerHead], followed by one float scale per head that dequantizes them, i.e. the amax of
+// the head over the context of the sequence divided by the largest value of the cache type. Every block of a sequence
+// carries the scales of the sequence, so that blocks can be read, copied and shared without extra state.
+__host__ __device__ constexpr inline int32_t getDynamicScaleKVCacheBytesPerHead(
+    int32_t sizePerHead, int32_t tokensPerBlock)
+{
+    return sizePerHead + (static_cast<int32_t>(sizeof(float)) + tokensPerBlock - 1) / tokensPerBlock;
+}
+
+__host__ __device__ inline float* getKVDynamicScalePtr(
+    void* blockPtr, int32_t numHeads, int32_t tokensPerBlock, int32_t sizePerHead)
+{
+    return reinterpret_cast<float*>(reinterpret_cast<int8_t*>(blockPtr) + numHeads * tokensPerBlock * sizePerHead);
+}
+
+__host__ __device__ inline float const* getKVDynamicScalePtr(
+    void const* blockPtr, int32_t numHeads, int32_t tokensPerBlock, int32_t sizePerHead)
+{
+    return reinterpret_cast<float const*>(
+        reinterpret_cast<int8_t const*>(blockPtr) + numHeads * tokensPerBlock * sizePerHead);
+}
+
+// KV cache layout with attention-guided eviction. Each K or V block holds the values [numHeads, tokensPerBlock,
+// sizePerHead] of elemBytes each, followed by 4 bytes per token and head, indexed like getKVScaleIdx. The K blocks
+// store the attention mass the token has received as float, the V blocks the position of the token in the sequence as
+// int32_t, or -1 for an empty slot. The cached tokens are then in no particular order within the attention window.
+__host__ __device__ constexpr inline int32_t getKVEvictionCacheSizePerHead(int32_t sizePerHead, int32_t elemBytes)
+{
+    return sizePerHead + (static_cast<int32_t>(sizeof(float)) + elemBytes - 1) / elemBytes;
+}
+
+__host__ __device__ inline float* getKVEvictionMassPtr(
+    void* kBlockPtr, int32_t numHeads, int32_t tokensPerBlock, int32_t sizePerHead, int32_t elemBytes)
+{
+    return reinterpret_cast<float*>(
+        reinterpret_cast<int8_t*>(kBlockPtr) + numHeads * tokensPerBlock * sizePerHead * elemBytes);
+}
+
+__host__ __device__ inline int32_t* getKVEvictionPositionPtr(
+    void* vBlockPtr, int32_t numHeads, int32_t tokensPerBlock, int32_t sizePerHead, int32_t elemBytes)
+{
+    return reinterpret_cast<int32_t*>(
+        reinterpret_cast<int8_t*>(vBlockPtr) + numHeads * tokensPerBlock * sizePerHead * elemBytes);
+}
+
 // Internal for K and V cache indexing
 enum class KVIdxType : int32_t
 {
@@ -33,6 +93,29 @@ enum class KVIdxType : int32_t
     V_IDX = 1
 };
 
+// Layout of the K cache of one head inside a block. V always uses [tokensPerBlock, sizePerHead].
+enum class KVCacheLayout : int8_t
+{
+    // [tokensPerBlock, sizePerHead], the same as V.
+    kLINEAR = 0,
+    // [sizePerHead / x, tokensPerBlock, x] where x is the number of elements in 16 bytes. The generation kernels
+    // read the same 16B chunk of many consecutive tokens per warp, which are adjacent in this layout. The cubin
+    // based kernels (XQA, paged context FMHA) and the INT4 cache only support kLINEAR.
+    kINTERLEAVED_K = 1
+};
+
+// Index of element channelIdx of a token in the interleaved K layout, counted in elements of type T.
+// The layout is defined in 16B chunks, so it is the same for every T whose size divides 16 bytes.
+template <typename T>
+__host__ __device__ inline int32_t getInterleavedKLocalIdx(
+    int32_t localTokenIdx, int32_t headIdx, int32_t tokensPerBlock, int32_t dimsPerHead, int32_t channelIdx)
+{
+    static_assert(16 % sizeof(T) == 0, "The interleaved K layout needs elements that divide 16 bytes");
+    constexpr int32_t X_ELEMS = 16 / sizeof(T);
+    return headIdx * tokensPerBlock * dimsPerHead + (channelIdx / X_ELEMS) * tokensPerBlock * X_ELEMS
+        + localTokenIdx * X_ELEMS + channelIdx % X_ELEMS;
+}
+
 struct KVBlockArray
 {
     // Struct operates on paged kv cache providing
@@ -58,6 +141,8 @@ struct KVBlockArray
     int32_t mBubbleLen;
     // Enable one more block to save the kv tokens
     bool mEnableOneMoreBlock;
+    // Layout of the K blocks
+    KVCacheLayout mKLayout = KVCacheLayout::kLINEAR;
     // Table maps logical block idx to the data pointer of k/v cache block pool
     // Shape [B, W, 2, M], where 2 is table for K and V,
     // B is current number of sequences
@@ -69,12 +154,14 @@ struct KVBlockArray
     KVBlockArray() {}
 
     KVBlockArray(int32_t batchSize, int32_t maxBlocksPerSeq, int32_t tokensPerBlock, int32_t sizePerToken,
-        int32_t maxAttentionWindow, int32_t sinkTokenLen, bool onlyKorV)
+        int32_t maxAttentionWindow, int32_t sinkTokenLen, bool onlyKorV,
+        KVCacheLayout kLayout = KVCacheLayout::kLINEAR)
         : mMaxSeqs(batchSize)
         , mMaxBlocksPerSeq(maxBlocksPerSeq)
         , mTokensPerBlock(tokensPerBlock)
         , mMaxAttentionWindow(maxAttentionWindow)
         , mSinkTokens(sinkTokenLen)
+        , mKLayout(kLayout)
         , data(nullptr)
     {
         const float tokensPerBlockSeqLog2 = log2(mTokensPerBlock);
@@ -150,6 +237,30 @@ struct KVBlockArray
         // NOTE: we have remapped K layout as the same of V.
         return headIdx * mTokensPerBlock * dimsPerHead + getLocalIdx(globalTokenIdx) * dimsPerHead + channelIdx;
     }
+
+    // Index of a K element, counted in elements of type T. Equal to getKVLocalIdx for the linear layout.
+    template <typename T>
+    __host__ __device__ inline int32_t getKLocalIdx(
+        int32_t globalTokenIdx, int32_t headIdx, int32_t dimsPerHead, int32_t channelIdx)
+    {
+        if (mKLayout == KVCacheLayout::kINTERLEAVED_K)
+        {
+            return getInterleavedKLocalIdx<T>(
+                getLocalIdx(globalTokenIdx), headIdx, mTokensPerBlock, dimsPerHead, channelIdx);
+        }
+        return getKVLocalIdx(globalTokenIdx, headIdx, dimsPerHead, channelIdx);
+    }
+
+    __host__ __device__ inline int32_t getTokensPerBlock()
+    {
+        return mTokensPerBlock;
+    }
+
+    __host__ __device__ inline int32_t getKVScaleIdx(int32_t globalTokenIdx, int32_t headIdx)
+    {
+        // Index of the INT4 quantization parameters of one token and head, layout [numHeads, tokensPerBlock].
+        return headIdx * mTokensPerBlock + getLocalIdx(globalTokenIdx);
+    }
 };
 
 struct KVBlockArrayForContextFMHA
@@ -261,6 +372,8 @@ struct KVLinearBuffer
     int32_t mValidRowsPerSeq;
     // Enable one more block to save the kv tokens
     bool mEnableOneMoreBlock;
+    // Layout of the K cache
+    KVCacheLayout mKLayout = KVCacheLayout::kLINEAR;
     // Pointer to the of K/V cache data
     // Shape [B, 2, S*H*D], where 2 is for K and V,
     // B is current number of sequences and
@@ -275,12 +388,14 @@ struct KVLinearBuffer
     KVLinearBuffer() {}
 
     KVLinearBuffer(int32_t batchSize, int32_t maxBlocksPerSeq, int32_t tokensPerBlock, int32_t sizePerToken,
-        int32_t maxAttentionWindow, int32_t sinkTokenLen, bool onlyKorV)
+        int32_t maxAttentionWindow, int32_t sinkTokenLen, bool onlyKorV,
+        KVCacheLayout kLayout = KVCacheLayout::kLINEAR)
         : mMaxSeqs(batchSize)
         , mMaxSeqLen(tokensPerBlock)
         , mBytesPerSeq(tokensPerBlock * sizePerToken)
         , mMaxAttentionWindow(maxAttentionWindow)
         , mSinkTokens(sinkTokenLen)
+        , mKLayout(kLayout)
         , data(nullptr)
     {
         // NOTE: pointer offset arithmetic offset is performed on int32_t (see this.getRowPtr).
@@ -335,6 +450,28 @@ struct KVLinearBuffer
     {
         return headIdx * mMaxSeqLen * dimsPerHead + tokenIdx * dimsPerHead + channelIdx;
     }
+
+    // Index of a K element, counted in elements of type T. Equal to getKVLocalIdx for the linear layout.
+    template <typename T>
+    __host__ __device__ inline int32_t getKLocalIdx(
+        int32_t tokenIdx, int32_t headIdx, int32_t dimsPerHead, int32_t channelIdx)
+    {
+        if (mKLayout == KVCacheLayout::kINTERLEAVED_K)
+        {
+            return getInterleavedKLocalIdx<T>(tokenIdx, headIdx, mMaxSeqLen, dimsPerHead, channelIdx);
+        }
+        return getKVLocalIdx(tokenIdx, headIdx, dimsPerHead, channelIdx);
+    }
+
+    __host__ __device__ inline int32_t getTokensPerBlock()
+    {
+        return mMaxSeqLen;
+    }
+
+    __host__ __device__ inline int32_t getKVScaleIdx(int32_t tokenIdx, int32_t headIdx)
+    {
+        return headIdx * mMaxSeqLen + tokenIdx;
+    }
 };
 
 } // namespace kernels
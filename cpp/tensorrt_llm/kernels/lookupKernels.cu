@@ -17,6 +17,8 @@
 #include "tensorrt_llm/common/cudaTypeUtils.cuh"
 #include "tensorrt_llm/kernels/lookupKernels.h"
 
+#include <algorithm>
+
 using namespace tensorrt_llm::common;
 
 namespace tensorrt_llm
@@ -60,10 +62,41 @@ __global__ void lookup_kernel(T* output, const Idx* input, const T* weight, cons
     } // end for index
 }
 
+// Same as lookup_kernel with a block per row and 16 bytes per thread.
+template <typename T, typename Idx>
+__global__ void lookup_vectorized_kernel(T* output, const Idx* input, const T* weight, const Idx batch_size,
+    const Idx offset, const Idx size, const int n_embed)
+{
+    const int vecs_per_row = n_embed * sizeof(T) / sizeof(int4);
+    for (Idx row = blockIdx.x; row < batch_size; row += gridDim.x)
+    {
+        const Idx word_index = input[row] - offset;
+        const bool hit = word_index >= 0 && word_index < size;
+        const int4* src = reinterpret_cast<const int4*>(weight + static_cast<int64_t>(hit ? word_index : 0) * n_embed);
+        int4* dst = reinterpret_cast<int4*>(output + static_cast<int64_t>(row) * n_embed);
+        for (int col = threadIdx.x; col < vecs_per_row; col += blockDim.x)
+        {
+            dst[col] = hit ? __ldg(src + col) : make_int4(0, 0, 0, 0);
+        }
+    }
+}
+
 template <typename T, typename Idx>
 void invokeLookUp(T* out, const Idx* input, const T* weight, const Idx batch_size, const Idx offset, const Idx size,
     const int n_embed, cudaStream_t stream)
 {
+    const bool vectorized = (n_embed * sizeof(T)) % sizeof(int4) == 0
+        && reinterpret_cast<uintptr_t>(out) % sizeof(int4) == 0
+        && reinterpret_cast<uintptr_t>(weight) % sizeof(int4) == 0;
+    if (vectorized)
+    {
+        const int vecs_per_row = n_embed * sizeof(T) / sizeof(int4);
+        dim3 grid(min(batch_size, 65536));
+        dim3 block(std::min(static_cast<int>(divUp(vecs_per_row, 32)) * 32, 256));
+        lookup_vectorized_kernel<T, Idx>
+            <<<grid, block, 0, stream>>>(out, input, weight, batch_size, offset, size, n_embed);
+        return;
+    }
     dim3 grid(min(batch_size, 65536));
     dim3 block(min(n_embed, 512));
     lookup_kernel<T, Idx><<<grid, block, 0, stream>>>(out, input, weight, batch_size, offset, size, n_embed);
@@ -80,5 +113,124 @@ INSTANTIATE_LOOK_UP(half, int);
 INSTANTIATE_LOOK_UP(__nv_bfloat16, int);
 #endif
 
+// Chunks of one fused lookup. The barriers of chunk c use the flag (counter + 1) * LOOKUP_MAX_CHUNKS + c, which differs
+// from the counters used as flags by the all-reduce plugins around the lookup.
+constexpr int LOOKUP_MAX_CHUNKS = 1024;
+constexpr int LOOKUP_ALL_GATHER_THREADS = 256;
+
+// Signals the peers with the first block once all the previous writes of the rank are visible to them, and waits for
+// the signals of all the peers in every block.
+__device__ void lookup_barrier(uint32_t* const* signals, const uint32_t flag, const size_t rank, const size_t ranks)
+{
+    if (threadIdx.x < ranks)
+    {
+        if (blockIdx.x == 0)
+        {
+            __threadfence_system();
+            *reinterpret_cast<volatile uint32_t*>(&signals[threadIdx.x][rank]) = flag;
+        }
+        const volatile uint32_t* my_signals = signals[rank];
+        while (my_signals[threadIdx.x] != flag)
+        {
+        }
+    }
+    __syncthreads();
+}
+
+// Writes the rows of the chunk owned by the rank to the buffers of all the ranks. wait_flag, when not zero, is the
+// flag of the barrier that guarantees that the peers copied the previous chunk out of their buffers.
+template <typename T>
+__global__ void lookup_push_kernel(AllReduceParams params, const int* input, const T* weight, const int token_begin,
+    const int num_tokens, const int size, const int n_embed, const uint32_t wait_flag)
+{
+    if (wait_flag != 0)
+    {
+        lookup_barrier(params.peer_barrier_ptrs_out, wait_flag, params.local_rank, params.ranks_per_node);
+    }
+
+    const int vecs_per_row = n_embed * sizeof(T) / sizeof(int4);
+    const int64_t vocab_size = static_cast<int64_t>(size) * params.ranks_per_node;
+    for (int row = blockIdx.x; row < num_tokens; row += gridDim.x)
+    {
+        const int64_t id = input[token_begin + row];
+        const bool in_vocab = id >= 0 && id < vocab_size;
+        const size_t owner = in_vocab ? id / size : 0;
+        if (owner != params.local_rank)
+        {
+            continue;
+        }
+        const int4* src = reinterpret_cast<const int4*>(weight + (in_vocab ? id - owner * size : 0) * n_embed);
+        for (int col = threadIdx.x; col < vecs_per_row; col += blockDim.x)
+        {
+            const int4 value = in_vocab ? __ldg(src + col) : make_int4(0, 0, 0, 0);
+#pragma unroll
+            for (int peer = 0; peer < MAX_RANKS_PER_NODE; ++peer)
+            {
+                if (peer < params.ranks_per_node)
+                {
+                    reinterpret_cast<int4*>(params.peer_comm_buffer_ptrs[peer])[row * vecs_per_row + col] = value;
+                }
+            }
+        }
+    }
+}
+
+// Waits until all the ranks pushed their rows of the chunk and copies the buffer of the rank to out.
+__global__ void lookup_gather_kernel(AllReduceParams params, int4* out, const size_t num_vecs, const uint32_t flag)
+{
+    lookup_barrier(params.peer_barrier_ptrs_in, flag, params.local_rank, params.ranks_per_node);
+
+    const int4* src = reinterpret_cast<const int4*>(params.peer_comm_buffer_ptrs[params.local_rank]);
+    for (size_t idx = blockIdx.x * blockDim.x + threadIdx.x; idx < num_vecs; idx += gridDim.x * blockDim.x)
+    {
+        out[idx] = src[idx];
+    }
+}
+
+template <typename T>
+void invokeLookUpAllGather(T* out, const int* input, const T* weight, const int batch_size, const int size,
+    const int n_embed, AllReduceParams& params, size_t max_chunk_bytes, cudaStream_t stream)
+{
+    const size_t row_bytes = n_embed * sizeof(T);
+    TLLM_CHECK_WITH_INFO(row_bytes % sizeof(int4) == 0, "The fused lookup needs rows of a multiple of 16 bytes");
+    TLLM_CHECK_WITH_INFO(row_bytes <= max_chunk_bytes, "A row of %zu bytes does not fit in the all-reduce workspace",
+        row_bytes);
+    if (batch_size == 0)
+    {
+        return;
+    }
+    const int chunk_tokens = static_cast<int>(std::min<size_t>(max_chunk_bytes / row_bytes, batch_size));
+    const int num_chunks = static_cast<int>(divUp(batch_size, chunk_tokens));
+    TLLM_CHECK_WITH_INFO(num_chunks <= LOOKUP_MAX_CHUNKS, "%d tokens need too many chunks for the fused lookup",
+        batch_size);
+    // Every block must be resident for the barriers, as in the all-reduce kernels
+    const int blocks = std::min<int>(chunk_tokens, MAX_ALL_REDUCE_BLOCKS);
+    const uint32_t flag_base = (params.barrier_flag + 1) * LOOKUP_MAX_CHUNKS;
+    for (int chunk = 0; chunk < num_chunks; ++chunk)
+    {
+        const int token_begin = chunk * chunk_tokens;
+        const int num_tokens = std::min(chunk_tokens, batch_size - token_begin);
+        // The first chunk reuses the buffers of the previous layer of the same parity, which every rank is done with
+        const uint32_t wait_flag = chunk == 0 ? 0 : flag_base + chunk - 1;
+        lookup_push_kernel<T><<<blocks, LOOKUP_ALL_GATHER_THREADS, 0, stream>>>(
+            params, input, weight, token_begin, num_tokens, size, n_embed, wait_flag);
+        lookup_gather_kernel<<<blocks, LOOKUP_ALL_GATHER_THREADS, 0, stream>>>(params,
+            reinterpret_cast<int4*>(out + static_cast<int64_t>(token_begin) * n_embed),
+            num_tokens * row_bytes / sizeof(int4), flag_base + chunk);
+    }
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_LOOK_UP_ALL_GATHER(T)                                                                              \
+    template void invokeLookUpAllGather<T>(T * out, const int* input, const T* weight, const int batch_size,           \
+        const int size, const int n_embed, AllReduceParams& params, size_t max_chunk_bytes, cudaStream_t stream)
+
+INSTANTIATE_LOOK_UP_ALL_GATHER(float);
+INSTANTIATE_LOOK_UP_ALL_GATHER(half);
+
+#ifdef ENABLE_BF16
+INSTANTIATE_LOOK_UP_ALL_GATHER(__nv_bfloat16);
+#endif
+
 } // namespace kernels
 } // namespace tensorrt_llm
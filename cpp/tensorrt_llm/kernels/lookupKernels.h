@@ -17,6 +17,7 @@
 #pragma once
 
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
 #include <assert.h>
 #include <cuda_fp16.h>
 #include <cuda_runtime.h>
@@ -25,9 +26,22 @@ namespace tensorrt_llm
 {
 namespace kernels
 {
+// Rows of the ids in [offset, offset + size) are read from the local shard weight[size, n_embed] of the table, the
+// other rows are zero. The rows are copied in 16 byte vectors when n_embed * sizeof(T) is a multiple of 16 and the
+// pointers are aligned.
 template <typename T, typename Idx>
 void invokeLookUp(T* out, const Idx* input, const T* weight, const Idx batch_size, const Idx offset, const Idx size,
     const int n_embed, cudaStream_t stream = 0);
 
+// Lookup into a table split by vocabulary across the ranks of a node, fused with the combination of the shards, so that
+// no all-reduce follows. Every rank writes the rows of the ids of its shard [rank * size, (rank + 1) * size) into the
+// IPC buffers of params on all the ranks, rank 0 writes the zero rows of the ids out of the vocabulary, then each rank
+// copies its own buffer to out. params is deserialized from the custom all-reduce workspace with the counter of the
+// layer. The tokens are processed in chunks of at most max_chunk_bytes, the size of the buffers.
+// n_embed * sizeof(T) must be a multiple of 16.
+template <typename T>
+void invokeLookUpAllGather(T* out, const int* input, const T* weight, const int batch_size, const int size,
+    const int n_embed, AllReduceParams& params, size_t max_chunk_bytes, cudaStream_t stream);
+
 } // namespace kernels
 } // namespace tensorrt_llm
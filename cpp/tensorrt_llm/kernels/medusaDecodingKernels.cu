@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/medusaDecodingKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
+
+#include <cuda_fp16.h>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+int constexpr kBlockSize = 256;
+// The accepted path is packed with its length into one int for atomicMax
+int32_t constexpr kPathBits = 16;
+int32_t constexpr kPathMask = (1 << kPathBits) - 1;
+
+using ArgMaxPair = cub::KeyValuePair<int32_t, float>;
+
+template <typename T>
+__global__ void medusaDecodingKernel(MedusaDecodingParams<T> params)
+{
+    using BlockReduceArgMax = cub::BlockReduce<ArgMaxPair, kBlockSize>;
+    using BlockReduceFloat = cub::BlockReduce<float, kBlockSize>;
+    using BlockScanFloat = cub::BlockScan<float, kBlockSize>;
+
+    __shared__ union
+    {
+        typename BlockReduceArgMax::TempStorage argMax;
+        typename BlockReduceFloat::TempStorage reduce;
+        typename BlockScanFloat::TempStorage scan;
+    } tempStorage;
+
+    __shared__ ArgMaxPair sharedArgMax;
+    __shared__ float sharedThreshold;
+    __shared__ int32_t sharedBestPath;
+    __shared__ int32_t sharedTargetToken;
+
+    auto const maxTokensPerStep = params.maxTokensPerStep;
+    // Target distribution at every node, and the tokens the tree ids of the next step index
+    extern __shared__ char smem[];
+    auto* nodeMax = reinterpret_cast<float*>(smem);
+    auto* nodeSum = nodeMax + maxTokensPerStep;
+    auto* nodeEntropy = nodeSum + maxTokensPerStep;
+    auto* nodeArgMax = reinterpret_cast<int32_t*>(nodeEntropy + maxTokensPerStep);
+    auto* candidates = nodeArgMax + maxTokensPerStep;
+
+    auto const tid = static_cast<int32_t>(threadIdx.x);
+    auto const batchIdx = static_cast<int32_t>(blockIdx.x);
+    auto const slot = params.batchSlots == nullptr ? batchIdx : params.batchSlots[batchIdx];
+    auto const vocabSize = params.vocabSize;
+    auto const medusaHeads = params.medusaHeads;
+
+    auto const* treeIds = params.treeIds + slot * maxTokensPerStep;
+    auto const* treeTokens = params.treeTokens + slot * maxTokensPerStep;
+    auto const* paths = params.paths + slot * maxTokensPerStep * (medusaHeads + 1);
+    auto const* targetLogits
+        = params.targetLogits + static_cast<size_t>(slot) * maxTokensPerStep * params.vocabSizePadded;
+
+    // The tree occupies the first nodes of the slot
+    int32_t numNodes = 0;
+    while (numNodes < maxTokensPerStep && treeIds[numNodes] >= 0)
+    {
+        ++numNodes;
+    }
+
+    auto const invTemperature = params.temperatures == nullptr ? 1.f : 1.f / params.temperatures[slot];
+    auto const posteriorThreshold = params.posteriorThresholds == nullptr ? 0.f : params.posteriorThresholds[slot];
+    bool const typical = posteriorThreshold > 0.f;
+    auto const posteriorAlpha = !typical ? 0.f
+        : params.posteriorAlphas == nullptr  ? sqrtf(posteriorThreshold)
+                                             : params.posteriorAlphas[slot];
+
+    // Argmax of the target distribution at every node, plus its normalizer and entropy for typical acceptance
+    for (int32_t node = 0; node < numNodes; ++node)
+    {
+        auto const* logits = targetLogits + static_cast<size_t>(node) * params.vocabSizePadded;
+        ArgMaxPair localMax{vocabSize, -INFINITY};
+        for (int32_t vIdx = tid; vIdx < vocabSize; vIdx += kBlockSize)
+        {
+            localMax = cub::ArgMax()(localMax, ArgMaxPair{vIdx, static_cast<float>(logits[vIdx]) * invTemperature});
+        }
+        auto const blockMax = BlockReduceArgMax(tempStorage.argMax).Reduce(localMax, cub::ArgMax());
+        if (tid == 0)
+        {
+            nodeMax[node] = blockMax.value;
+            nodeArgMax[node] = blockMax.key;
+        }
+        __syncthreads();
+        if (!typical)
+        {
+            continue;
+        }
+
+        // With z the logits minus their max: sum = sum(exp(z)), entropy = log(sum) - sum(exp(z) * z) / sum
+        auto const maxLogit = nodeMax[node];
+        float sum = 0.f;
+        float weighted = 0.f;
+        for (int32_t vIdx = tid; vIdx < vocabSize; vIdx += kBlockSize)
+        {
+            auto const z = static_cast<float>(logits[vIdx]) * invTemperature - maxLogit;
+            auto const e = __expf(z);
+            sum += e;
+            weighted += e * z;
+        }
+        sum = BlockReduceFloat(tempStorage.reduce).Sum(sum);
+        __syncthreads();
+        weighted = BlockReduceFloat(tempStorage.reduce).Sum(weighted);
+        if (tid == 0)
+        {
+            nodeSum[node] = sum;
+            nodeEntropy[node] = __logf(sum) - weighted / sum;
+        }
+        __syncthreads();
+    }
+
+    // Longest accepted path, the first one on ties
+    if (tid == 0)
+    {
+        sharedBestPath = kPathMask;
+    }
+    __syncthreads();
+    auto const numPaths = params.numPaths[slot];
+    for (int32_t pathIdx = tid; pathIdx < numPaths; pathIdx += kBlockSize)
+    {
+        auto const* path = paths + pathIdx * (medusaHeads + 1);
+        int32_t accepted = 0;
+        for (int32_t depth = 1; depth <= medusaHeads; ++depth)
+        {
+            auto const node = path[depth];
+            if (node < 0)
+            {
+                break;
+            }
+            auto const parent = path[depth - 1];
+            auto const token = treeTokens[node];
+            bool accept;
+            if (typical)
+            {
+                auto const* parentLogits = targetLogits + static_cast<size_t>(parent) * params.vocabSizePadded;
+                auto const logit = static_cast<float>(parentLogits[token]) * invTemperature;
+                auto const prob = __expf(logit - nodeMax[parent]) / nodeSum[parent];
+                accept = prob > fminf(posteriorThreshold, posteriorAlpha * __expf(-nodeEntropy[parent]));
+            }
+            else
+            {
+                accept = token == nodeArgMax[parent];
+            }
+            if (!accept)
+            {
+                break;
+            }
+            ++accepted;
+        }
+        atomicMax(&sharedBestPath, (accepted << kPathBits) | (kPathMask - pathIdx));
+    }
+    __syncthreads();
+    auto const numAccepted = sharedBestPath >> kPathBits;
+    auto const bestPath = kPathMask - (sharedBestPath & kPathMask);
+    auto const lastNode = numAccepted > 0 ? paths[bestPath * (medusaHeads + 1) + numAccepted] : 0;
+
+    // Token of the target model after the accepted ones, greedy or sampled from the target distribution
+    if (tid == 0)
+    {
+        sharedTargetToken = nodeArgMax[lastNode];
+        if (typical)
+        {
+            sharedThreshold = philoxUniform(params.curandState + slot) * nodeSum[lastNode];
+        }
+    }
+    __syncthreads();
+    if (typical)
+    {
+        auto const* logits = targetLogits + static_cast<size_t>(lastNode) * params.vocabSizePadded;
+        auto const maxLogit = nodeMax[lastNode];
+        auto const threshold = sharedThreshold;
+        float prefix = 0.f;
+        for (int32_t chunk = 0; chunk < vocabSize; chunk += kBlockSize)
+        {
+            auto const vIdx = chunk + tid;
+            auto const e
+                = vIdx < vocabSize ? __expf(static_cast<float>(logits[vIdx]) * invTemperature - maxLogit) : 0.f;
+            float inclusive;
+            float total;
+            BlockScanFloat(tempStorage.scan).InclusiveSum(e, inclusive, total);
+            inclusive += prefix;
+            // Exactly one token crosses the threshold, rounding past the last token keeps the argmax
+            if (e > 0.f && inclusive >= threshold && inclusive - e < threshold)
+            {
+                sharedTargetToken = vIdx;
+            }
+            __syncthreads();
+            prefix += total;
+            if (prefix >= threshold)
+            {
+                break;
+            }
+        }
+    }
+    __syncthreads();
+
+    auto const targetToken = sharedTargetToken;
+    if (tid == 0)
+    {
+        auto const sequenceLength = params.sequenceLengths[slot];
+        auto* outputIds = params.outputIds + static_cast<size_t>(slot) * params.maxSeqLen;
+        for (int32_t ti = 0; ti <= numAccepted; ++ti)
+        {
+            auto const token
+                = ti < numAccepted ? treeTokens[paths[bestPath * (medusaHeads + 1) + ti + 1]] : targetToken;
+            if (sequenceLength + ti < params.maxSeqLen)
+            {
+                outputIds[sequenceLength + ti] = token;
+            }
+        }
+        params.sequenceLengths[slot] = sequenceLength + numAccepted + 1;
+        if (params.numAcceptedTokens != nullptr)
+        {
+            params.numAcceptedTokens[slot] = numAccepted;
+        }
+        if (params.acceptedPaths != nullptr)
+        {
+            params.acceptedPaths[slot] = bestPath;
+        }
+        candidates[0] = targetToken;
+    }
+    __syncthreads();
+
+    // Top-k of every head at the last accepted node, by decreasing logit and increasing token on ties. Each pass takes
+    // the best token after the previous one in that order, so no chosen token has to be excluded explicitly
+    auto const* medusaLogits = params.medusaLogits
+        + (static_cast<size_t>(slot) * maxTokensPerStep + lastNode) * medusaHeads * params.vocabSizePadded;
+    int32_t candidateOffset = 1;
+    for (int32_t head = 0; head < medusaHeads; ++head)
+    {
+        auto const topK = params.topKs[slot * medusaHeads + head];
+        auto const* logits = medusaLogits + static_cast<size_t>(head) * params.vocabSizePadded;
+        float prevValue = INFINITY;
+        int32_t prevToken = -1;
+        for (int32_t ki = 0; ki < topK; ++ki)
+        {
+            ArgMaxPair localMax{vocabSize, -INFINITY};
+            for (int32_t vIdx = tid; vIdx < vocabSize; vIdx += kBlockSize)
+            {
+                auto const value = static_cast<float>(logits[vIdx]);
+                if (value < prevValue || (value == prevValue && vIdx > prevToken))
+                {
+                    localMax = cub::ArgMax()(localMax, ArgMaxPair{vIdx, value});
+                }
+            }
+            auto const blockMax = BlockReduceArgMax(tempStorage.argMax).Reduce(localMax, cub::ArgMax());
+            if (tid == 0)
+            {
+                sharedArgMax = blockMax;
+                if (candidateOffset + ki < maxTokensPerStep)
+                {
+                    candidates[candidateOffset + ki] = blockMax.key;
+                }
+            }
+            __syncthreads();
+            prevValue = sharedArgMax.value;
+            prevToken = sharedArgMax.key;
+            __syncthreads();
+        }
+        candidateOffset += topK;
+    }
+
+    // Expand the candidates along the tree of the next step
+    auto* nextTreeTokens = params.nextTreeTokens + slot * maxTokensPerStep;
+    for (int32_t node = tid; node < maxTokensPerStep; node += kBlockSize)
+    {
+        auto const treeId = treeIds[node];
+        nextTreeTokens[node] = treeId >= 0 && treeId < maxTokensPerStep ? candidates[treeId] : targetToken;
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeMedusaDecoding(MedusaDecodingParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(
+        params.maxTokensPerStep <= kPathMask, "Too many tokens per step (%d)", params.maxTokensPerStep);
+    TLLM_CHECK_WITH_INFO(params.medusaHeads > 0, "Medusa decoding needs at least one head");
+    TLLM_CHECK_WITH_INFO(params.posteriorThresholds == nullptr || params.curandState != nullptr,
+        "Typical acceptance samples the target token and needs random states");
+    auto const smemSize = params.maxTokensPerStep * (3 * sizeof(float) + 2 * sizeof(int32_t));
+    medusaDecodingKernel<T><<<params.batchSize, kBlockSize, smemSize, stream>>>(params);
+    sync_check_cuda_error();
+}
+
+template void invokeMedusaDecoding(MedusaDecodingParams<float> const& params, cudaStream_t stream);
+template void invokeMedusaDecoding(MedusaDecodingParams<half> const& params, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
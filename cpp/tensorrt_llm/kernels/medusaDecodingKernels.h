@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// One Medusa decoding step on the device. The engine verified a tree of candidate tokens rooted at the last accepted
+// token and returned the target logits and the logits of every Medusa head at each node of the tree. The step accepts
+// the longest path of the tree, appends its tokens and one token of the target model to the output, and builds the
+// tree of the next step from the top-k tokens of every head at the last accepted node. The tree tensors are the ones
+// of MedusaModule and MedusaTreeSelector, laid out by batch slot.
+template <typename T>
+struct MedusaDecodingParams
+{
+    // [maxBatchSize, maxTokensPerStep, vocabSizePadded] target logits at every node of the tree
+    T const* targetLogits;
+    // [maxBatchSize, maxTokensPerStep, medusaHeads, vocabSizePadded] logits of the Medusa heads at every node
+    T const* medusaLogits;
+    // [maxBatchSize, maxTokensPerStep] tokens of the tree verified in this step, token 0 is the last accepted token
+    int32_t const* treeTokens;
+    // [maxBatchSize, medusaHeads] number of candidate tokens of each head
+    int32_t const* topKs;
+    // [maxBatchSize, maxTokensPerStep] index of the token of each node in [target token, top-k of head 0, top-k of
+    // head 1, ...], -1 past the tree
+    int32_t const* treeIds;
+    // [maxBatchSize, maxTokensPerStep, medusaHeads + 1] nodes of the paths from the root, padded with -1
+    int32_t const* paths;
+    // [maxBatchSize] number of paths of the tree
+    int32_t const* numPaths;
+    // [batchSize] batch slot of each request, nullptr if the slots are 0 ... batchSize - 1
+    int32_t const* batchSlots;
+    // [maxBatchSize] optional, typical acceptance: a token is accepted if its target probability exceeds
+    // min(posteriorThreshold, posteriorAlpha * exp(-entropy)). A threshold of 0 or nullptr accepts greedily, i.e.
+    // only the argmax of the target model
+    float const* posteriorThresholds;
+    // [maxBatchSize] optional with posteriorThresholds, defaults to sqrt(posteriorThreshold)
+    float const* posteriorAlphas;
+    // [maxBatchSize] optional, temperature of the target distribution, 1 if nullptr
+    float const* temperatures;
+    // [maxBatchSize] random states, used to sample the target token of the requests with typical acceptance
+    PhiloxState* curandState;
+    // [maxBatchSize, maxSeqLen] receives the accepted tokens and the target token after them
+    int32_t* outputIds;
+    // [maxBatchSize] advanced by the number of accepted tokens plus one
+    int32_t* sequenceLengths;
+    // [maxBatchSize] optional, receives the number of accepted draft tokens
+    int32_t* numAcceptedTokens;
+    // [maxBatchSize] optional, receives the index of the accepted path, e.g. for the KV cache rewind
+    int32_t* acceptedPaths;
+    // [maxBatchSize, maxTokensPerStep] receives the tree tokens of the next step, padded with the target token.
+    // May alias treeTokens
+    int32_t* nextTreeTokens;
+
+    int32_t batchSize;
+    int32_t maxBatchSize;
+    int32_t medusaHeads;
+    int32_t maxTokensPerStep;
+    int32_t vocabSize;
+    int32_t vocabSizePadded;
+    int32_t maxSeqLen;
+};
+
+//! \brief Accept the longest path of the Medusa tree of every request, append the accepted tokens and the target
+//! token, and expand the top-k tokens of every head along the tree of the next step, all in one launch.
+//! \details One thread block per request. The acceptance of every node only needs the max, the normalizer and the
+//! entropy of the target distribution at its parent, which the block computes for all nodes first. The top-k of the
+//! heads runs k block-wide argmax passes per head, so it is meant for the small k of Medusa trees.
+template <typename T>
+void invokeMedusaDecoding(MedusaDecodingParams<T> const& params, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -33,7 +33,9 @@
 
 #pragma GCC diagnostic pop
 
+#include "tensorrt_llm/common/cudaFp8Utils.h"
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/kernels/mixtureOfExperts/moe_kernels.h"
 
 #ifndef CUDART_VERSION
@@ -577,6 +579,215 @@ __global__ void computeTotalRowsBeforeExpertKernel(const int* sorted_experts, co
     total_rows_before_expert[expert] = findTotalEltsLeqTarget(sorted_experts, sorted_experts_len, expert);
 }
 
+// ============================== Expert replication and load =================================
+
+// Replaces the experts selected over all the experts by the local expert of this node, or by num_experts if another
+// node processes the row. The rows of a replicated expert go to node (source row % ep_size), which holds the replica
+// after its own experts.
+__global__ void mapExpertsToNodeKernel(int* expert_for_source_row, const int num_expanded_rows, const int k,
+    const int num_experts, const int experts_per_node, const int ep_size, const int ep_rank,
+    const MOEExpertReplication replication)
+{
+    const int expanded_row = blockIdx.x * blockDim.x + threadIdx.x;
+    if (expanded_row >= num_expanded_rows)
+    {
+        return;
+    }
+
+    const int expert = expert_for_source_row[expanded_row];
+    if (expert >= num_experts)
+    {
+        // Finished row
+        return;
+    }
+
+    int node = expert / experts_per_node;
+    int local_expert = expert % experts_per_node;
+    for (int i = 0; i < replication.num_replicated_experts; ++i)
+    {
+        if (replication.replicated_experts[i] == expert)
+        {
+            node = (expanded_row / k) % ep_size;
+            local_expert = experts_per_node + i;
+        }
+    }
+    expert_for_source_row[expanded_row] = node == ep_rank ? local_expert : num_experts;
+}
+
+// Adds the rows of each local expert, the difference of consecutive total_rows_before_expert, to the load of the
+// expert it holds.
+__global__ void accumulateExpertLoadKernel(const int64_t* total_rows_before_expert, int64_t* expert_load,
+    const int num_local_experts, const int experts_per_node, const int start_expert,
+    const MOEExpertReplication replication)
+{
+    const int local_expert = blockIdx.x * blockDim.x + threadIdx.x;
+    if (local_expert >= num_local_experts)
+    {
+        return;
+    }
+
+    const int64_t rows_before = local_expert > 0 ? total_rows_before_expert[local_expert - 1] : 0;
+    const int64_t rows = total_rows_before_expert[local_expert] - rows_before;
+    const int expert = local_expert < experts_per_node
+        ? start_expert + local_expert
+        : replication.replicated_experts[local_expert - experts_per_node];
+    atomicAdd(reinterpret_cast<unsigned long long*>(expert_load + expert), static_cast<unsigned long long>(rows));
+}
+
+// Appends the shared experts as GEMM groups after the local experts, each with one row per token.
+__global__ void appendSharedExpertsKernel(int64_t* total_rows_before_expert, const int num_local_experts,
+    const int num_shared_experts, const int num_rows)
+{
+    const int shared_expert = threadIdx.x;
+    if (shared_expert < num_shared_experts)
+    {
+        total_rows_before_expert[num_local_experts + shared_expert]
+            = total_rows_before_expert[num_local_experts - 1] + static_cast<int64_t>(shared_expert + 1) * num_rows;
+    }
+}
+
+// ============================== Fused routing =================================
+
+// Upper bound on the expanded rows for which the fused routing kernel replaces the sort.
+static constexpr int FUSED_ROUTING_MAX_EXPANDED_ROWS = 2048;
+static constexpr int FUSED_ROUTING_TPB = 256;
+
+inline size_t fusedRoutingSharedMemSize(const int num_expanded_rows, const int num_experts_per_node)
+{
+    return (num_expanded_rows + (FUSED_ROUTING_TPB / WARP_SIZE) * (num_experts_per_node + 1)) * sizeof(int);
+}
+
+inline bool canUseFusedRouting(const int num_expanded_rows, const int num_experts_per_node)
+{
+    return num_expanded_rows <= FUSED_ROUTING_MAX_EXPANDED_ROWS
+        && fusedRoutingSharedMemSize(num_expanded_rows, num_experts_per_node) <= (48 << 10);
+}
+
+// Replaces the radix sort of the expanded rows by expert and computeTotalRowsBeforeExpertKernel with a single CTA.
+// With few rows, as in the generation phase, the sort launches cost more than the expert GEMMs.
+//
+// Each warp owns a contiguous range of the expanded rows. The warps count their rows per expert, a scan over the
+// experts gives where every expert starts and where every warp starts within each expert, then each warp scatters its
+// rows in order. The result is the same as with the stable sort: the rows of an expert keep their source order.
+// Rows routed to the experts of other nodes (or finished) go to a last bucket after the local experts.
+template <int TPB>
+__launch_bounds__(TPB) __global__ void fusedMoeRoutingKernel(const int* expert_for_source_row, const int* source_rows,
+    int* permuted_rows, int64_t* total_rows_before_expert, const int num_expanded_rows,
+    const int num_valid_expanded_rows, const int num_experts_per_node)
+{
+    static constexpr int NUM_WARPS = TPB / WARP_SIZE;
+    using BlockScan = cub::BlockScan<int, TPB>;
+    __shared__ typename BlockScan::TempStorage scan_storage;
+
+    extern __shared__ int routing_smem[];
+    const int num_buckets = num_experts_per_node + 1;
+    // [num_expanded_rows], the bucket of each expanded row.
+    int* row_buckets = routing_smem;
+    // [NUM_WARPS, num_buckets], the rows of each warp per bucket, then the destination of its next row.
+    int* warp_offsets = routing_smem + num_expanded_rows;
+
+    const int warp_id = threadIdx.x / WARP_SIZE;
+    const int lane_id = threadIdx.x % WARP_SIZE;
+    const unsigned lanes_before = (1u << lane_id) - 1;
+
+    for (int ii = threadIdx.x; ii < NUM_WARPS * num_buckets; ii += TPB)
+    {
+        warp_offsets[ii] = 0;
+    }
+    __syncthreads();
+
+    const int rows_per_warp = (num_expanded_rows + NUM_WARPS - 1) / NUM_WARPS;
+    const int warp_begin = min(warp_id * rows_per_warp, num_expanded_rows);
+    const int warp_end = min(warp_begin + rows_per_warp, num_expanded_rows);
+    int* my_offsets = warp_offsets + warp_id * num_buckets;
+
+    // Count the rows of the warp per bucket. The lanes holding the same bucket elect their first lane to add them.
+    for (int base = warp_begin; base < warp_end; base += WARP_SIZE)
+    {
+        const int row = base + lane_id;
+        const bool valid = row < warp_end;
+        const int bucket = valid ? min(expert_for_source_row[row], num_experts_per_node) : -1;
+        if (valid)
+        {
+            row_buckets[row] = bucket;
+        }
+        const unsigned peers = __match_any_sync(0xffffffff, bucket);
+        if (valid && (peers & lanes_before) == 0)
+        {
+            my_offsets[bucket] += __popc(peers);
+        }
+        __syncwarp();
+    }
+    __syncthreads();
+
+    // Exclusive scan over the buckets, then over the warps within each bucket.
+    int carry = 0;
+    for (int base = 0; base < num_buckets; base += TPB)
+    {
+        const int bucket = base + threadIdx.x;
+        int bucket_rows = 0;
+        if (bucket < num_buckets)
+        {
+            for (int warp = 0; warp < NUM_WARPS; ++warp)
+            {
+                bucket_rows += warp_offsets[warp * num_buckets + bucket];
+            }
+        }
+
+        int bucket_start, chunk_rows;
+        BlockScan(scan_storage).ExclusiveSum(bucket_rows, bucket_start, chunk_rows);
+        bucket_start += carry;
+
+        if (bucket < num_experts_per_node)
+        {
+            // Same as computeTotalRowsBeforeExpertKernel on the first num_valid_expanded_rows sorted rows.
+            total_rows_before_expert[bucket] = min(bucket_start + bucket_rows, num_valid_expanded_rows);
+        }
+        if (bucket < num_buckets)
+        {
+            int warp_start = bucket_start;
+            for (int warp = 0; warp < NUM_WARPS; ++warp)
+            {
+                const int warp_rows = warp_offsets[warp * num_buckets + bucket];
+                warp_offsets[warp * num_buckets + bucket] = warp_start;
+                warp_start += warp_rows;
+            }
+        }
+        carry += chunk_rows;
+        // The scan storage is reused by the next chunk.
+        __syncthreads();
+    }
+
+    // Scatter the rows of the warp in order.
+    for (int base = warp_begin; base < warp_end; base += WARP_SIZE)
+    {
+        const int row = base + lane_id;
+        const bool valid = row < warp_end;
+        const int bucket = valid ? row_buckets[row] : -1;
+        const unsigned peers = __match_any_sync(0xffffffff, bucket);
+        if (valid)
+        {
+            permuted_rows[my_offsets[bucket] + __popc(peers & lanes_before)] = source_rows[row];
+        }
+        __syncwarp();
+        if (valid && (peers & lanes_before) == 0)
+        {
+            my_offsets[bucket] += __popc(peers);
+        }
+        __syncwarp();
+    }
+}
+
+void fusedMoeRoutingKernelLauncher(const int* expert_for_source_row, const int* source_rows, int* permuted_rows,
+    int64_t* total_rows_before_expert, const int num_expanded_rows, const int num_valid_expanded_rows,
+    const int num_experts_per_node, cudaStream_t stream)
+{
+    const size_t smem_size = fusedRoutingSharedMemSize(num_expanded_rows, num_experts_per_node);
+    fusedMoeRoutingKernel<FUSED_ROUTING_TPB><<<1, FUSED_ROUTING_TPB, smem_size, stream>>>(expert_for_source_row,
+        source_rows, permuted_rows, total_rows_before_expert, num_expanded_rows, num_valid_expanded_rows,
+        num_experts_per_node);
+}
+
 // ========================== Permutation things =======================================
 
 // Duplicated and permutes rows for MoE. In addition, reverse the permutation map to help with finalizing routing.
@@ -590,11 +801,32 @@ __global__ void computeTotalRowsBeforeExpertKernel(const int* sorted_experts, co
 // all map to row 0 in the original matrix. Thus, to know where to read in the source matrix, we simply take the modulus
 // of the expanded index.
 
+// The rows of the shared experts follow the valid routed rows: shared expert j reads the rows
+// [begin + j * num_rows, begin + (j + 1) * num_rows) of the permuted buffers, in the order of the input.
+template <bool CHECK_SKIPPED>
+__device__ inline int64_t sharedExpertRowsBegin(const int64_t* num_valid_ptr, const int num_rows, const int k)
+{
+    return CHECK_SKIPPED ? *num_valid_ptr : static_cast<int64_t>(k) * num_rows;
+}
+
 template <typename T, bool CHECK_SKIPPED>
 __global__ void expandInputRowsKernel(const T* unpermuted_input, T* permuted_output,
     const int* expanded_dest_row_to_expanded_source_row, int* expanded_source_row_to_expanded_dest_row,
-    const int num_rows, const int64_t* num_dest_rows, const int cols)
+    const int num_rows, const int64_t* num_dest_rows, const int cols, const int k)
 {
+    // The blocks past the routed rows copy the input once for each shared expert
+    if (blockIdx.x >= k * num_rows)
+    {
+        const int shared_row = blockIdx.x - k * num_rows;
+        const T* source_row_ptr = unpermuted_input + static_cast<int64_t>(shared_row % num_rows) * cols;
+        T* dest_row_ptr = permuted_output
+            + (sharedExpertRowsBegin<CHECK_SKIPPED>(num_dest_rows, num_rows, k) + shared_row) * cols;
+        for (int tid = threadIdx.x; tid < cols; tid += blockDim.x)
+        {
+            dest_row_ptr[tid] = source_row_ptr[tid];
+        }
+        return;
+    }
 
     // Reverse permutation map.
     // I do this so that later, we can use the source -> dest map to do the k-way reduction and unpermuting. I need the
@@ -625,13 +857,14 @@ __global__ void expandInputRowsKernel(const T* unpermuted_input, T* permuted_out
 template <typename T>
 void expandInputRowsKernelLauncher(const T* unpermuted_input, T* permuted_output,
     const int* expanded_dest_row_to_expanded_source_row, int* expanded_source_row_to_expanded_dest_row,
-    const int num_rows, const int64_t* num_valid_tokens_ptr, const int cols, const int k, cudaStream_t stream)
+    const int num_rows, const int64_t* num_valid_tokens_ptr, const int cols, const int k, const int num_shared_experts,
+    cudaStream_t stream)
 {
-    const int blocks = num_rows * k;
+    const int blocks = num_rows * (k + num_shared_experts);
     const int threads = std::min(cols, 1024);
     auto func = (num_valid_tokens_ptr != nullptr) ? expandInputRowsKernel<T, true> : expandInputRowsKernel<T, false>;
     func<<<blocks, threads, 0, stream>>>(unpermuted_input, permuted_output, expanded_dest_row_to_expanded_source_row,
-        expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, cols);
+        expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, cols, k);
 }
 
 enum class ScaleMode : int
@@ -643,10 +876,13 @@ enum class ScaleMode : int
 
 // Final kernel to unpermute and scale
 // This kernel unpermutes the original data, does the k-way reduction and performs the final skip connection.
+// The shared experts are added unscaled after the k-way reduction, their biases follow the bias of the last routed
+// expert of the node.
 template <typename T, int RESIDUAL_NUM, bool HAS_BIAS, ScaleMode SCALE_MODE, bool CHECK_SKIPPED>
 __global__ void finalizeMoeRoutingKernel(const T* expanded_permuted_rows, T* reduced_unpermuted_output, const T* skip_1,
     const T* skip_2, const T* bias, const float* scales, const int* expanded_source_row_to_expanded_dest_row,
-    const int* expert_for_source_row, const int cols, const int k, const int64_t* num_valid_ptr)
+    const int* expert_for_source_row, const int cols, const int k, const int64_t* num_valid_ptr,
+    const int num_shared_experts, const int first_shared_expert)
 {
     const int original_row = blockIdx.x;
     const int num_rows = gridDim.x;
@@ -704,6 +940,15 @@ __global__ void finalizeMoeRoutingKernel(const T* expanded_permuted_rows, T* red
             thread_output = static_cast<float>(thread_output) / row_rescale;
         }
 
+        for (int shared_idx = 0; shared_idx < num_shared_experts; ++shared_idx)
+        {
+            const int64_t shared_row = sharedExpertRowsBegin<CHECK_SKIPPED>(num_valid_ptr, num_rows, k)
+                + static_cast<int64_t>(shared_idx) * num_rows + original_row;
+            const T bias_value = HAS_BIAS ? bias[(first_shared_expert + shared_idx) * cols + tid] : T(0.f);
+            thread_output = static_cast<float>(thread_output)
+                + static_cast<float>(expanded_permuted_rows[shared_row * cols + tid] + bias_value);
+        }
+
         if (RESIDUAL_NUM == 1)
         {
             thread_output = thread_output + skip_1_row_ptr[tid];
@@ -720,7 +965,8 @@ template <typename T, int RESIDUAL_NUM>
 void finalizeMoeRoutingKernelLauncherSelectBias(const T* expanded_permuted_rows, T* reduced_unpermuted_output,
     const T* skip_1, const T* skip_2, const T* bias, const float* scales,
     const int* expanded_source_row_to_expanded_dest_row, const int* expert_for_source_row, const int num_rows,
-    const int cols, const int k, const int64_t* num_valid_ptr, MOEParallelismConfig parallelism_config,
+    const int cols, const int k, const int64_t* num_valid_ptr, const int num_shared_experts,
+    const int first_shared_expert, MOEParallelismConfig parallelism_config,
     MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
 {
     const int blocks = num_rows;
@@ -758,14 +1004,16 @@ void finalizeMoeRoutingKernelLauncherSelectBias(const T* expanded_permuted_rows,
             }};
     auto* const func = func_map[check_finished][int(renorm_scales)][has_bias];
     func<<<blocks, threads, 0, stream>>>(expanded_permuted_rows, reduced_unpermuted_output, skip_1, skip_2, bias,
-        scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, cols, k, num_valid_ptr);
+        scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, cols, k, num_valid_ptr,
+        num_shared_experts, first_shared_expert);
 }
 
 template <typename T>
 void finalizeMoeRoutingKernelLauncher(const T* expanded_permuted_rows, T* reduced_unpermuted_output, const T* skip_1,
     const T* skip_2, const T* bias, const float* scales, const int* expanded_source_row_to_expanded_dest_row,
     const int* expert_for_source_row, const int num_rows, const int cols, const int k, const int64_t* num_valid_ptr,
-    MOEParallelismConfig parallelism_config, MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
+    const int num_shared_experts, const int first_shared_expert, MOEParallelismConfig parallelism_config,
+    MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
 {
     // If we are not rank 0 we should not add any residuals because the allreduce would sum multiple copies
     const bool is_rank_0 = parallelism_config.tp_rank == 0;
@@ -774,27 +1022,29 @@ void finalizeMoeRoutingKernelLauncher(const T* expanded_permuted_rows, T* reduce
         assert(skip_2 == nullptr);
         finalizeMoeRoutingKernelLauncherSelectBias<T, 0>(expanded_permuted_rows, reduced_unpermuted_output, skip_1,
             skip_2, bias, scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows, cols, k,
-            num_valid_ptr, parallelism_config, normalization_mode, stream);
+            num_valid_ptr, num_shared_experts, first_shared_expert, parallelism_config, normalization_mode, stream);
     }
     else if (skip_2 == nullptr)
     {
         finalizeMoeRoutingKernelLauncherSelectBias<T, 1>(expanded_permuted_rows, reduced_unpermuted_output, skip_1,
             skip_2, bias, scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows, cols, k,
-            num_valid_ptr, parallelism_config, normalization_mode, stream);
+            num_valid_ptr, num_shared_experts, first_shared_expert, parallelism_config, normalization_mode, stream);
     }
     else
     {
         finalizeMoeRoutingKernelLauncherSelectBias<T, 2>(expanded_permuted_rows, reduced_unpermuted_output, skip_1,
             skip_2, bias, scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows, cols, k,
-            num_valid_ptr, parallelism_config, normalization_mode, stream);
+            num_valid_ptr, num_shared_experts, first_shared_expert, parallelism_config, normalization_mode, stream);
     }
 }
 
 // ============================== Gated Activation =================================
 
+// The GEMM result of a token is either [linear, gate], or interleaved with the linear part of output i in column 2i and
+// its gate in column 2i + 1.
 template <class T, class ActFn>
 __global__ void doGatedActivationKernel(
-    T* output, const T* gemm_result, const int64_t* num_valid_tokens_ptr, size_t inter_size)
+    T* output, const T* gemm_result, const int64_t* num_valid_tokens_ptr, size_t inter_size, bool interleaved)
 {
     const int tid = threadIdx.x;
     const int token = blockIdx.x;
@@ -808,9 +1058,9 @@ __global__ void doGatedActivationKernel(
     gemm_result = gemm_result + token * inter_size * 2;
     for (int i = tid; i < inter_size; i += blockDim.x)
     {
-        T fc1_value = gemm_result[i];
+        T fc1_value = gemm_result[interleaved ? 2 * i : i];
         // BF16 isn't supported, use FP32 for activation function
-        float gate_value = gemm_result[i + inter_size];
+        float gate_value = gemm_result[interleaved ? 2 * i + 1 : i + inter_size];
         T gate_act = fn(gate_value);
         output[i] = fc1_value * gate_act;
     }
@@ -818,7 +1068,7 @@ __global__ void doGatedActivationKernel(
 
 template <class T>
 void doGatedActivation(T* output, const T* gemm_result, const int64_t* num_valid_tokens_ptr, int inter_size,
-    int num_tokens, ActivationType activation_type, cudaStream_t stream)
+    int num_tokens, ActivationType activation_type, bool interleaved, cudaStream_t stream)
 {
     const int blocks = num_tokens;
     const int threads = std::min(inter_size, 1024);
@@ -828,18 +1078,231 @@ void doGatedActivation(T* output, const T* gemm_result, const int64_t* num_valid
     auto* fn = activation_type == ActivationType::Swiglu
         ? &doGatedActivationKernel<T, cutlass::epilogue::thread::SiLu<float>>
         : &doGatedActivationKernel<T, cutlass::epilogue::thread::GELU<float>>;
-    fn<<<blocks, threads, 0, stream>>>(output, gemm_result, num_valid_tokens_ptr, inter_size);
+    fn<<<blocks, threads, 0, stream>>>(output, gemm_result, num_valid_tokens_ptr, inter_size, interleaved);
+}
+
+// ============================== FP8 Experts =================================
+
+#ifdef ENABLE_FP8
+// The FP8 GEMMs only multiply, the scales of the rows of the activations and of the expert weights are applied on the
+// fp32 results. Each row is quantized with the scale that maps its absolute maximum to the largest E4M3 value.
+
+// Threads of the row kernels, a multiple of the warp size for the block reductions
+inline int fp8RowThreads(const int64_t cols)
+{
+    return static_cast<int>(std::min<int64_t>((cols + WARP_SIZE - 1) / WARP_SIZE * WARP_SIZE, 1024));
+}
+
+__device__ inline float fp8QuantScale(const float amax)
+{
+    return amax > 0.f ? FP8_E4M3_MAX / amax : 1.f;
+}
+
+// Number of entries of total_rows_before_expert that are <= row, i.e. the expert of the permuted row
+__device__ inline int findExpertOfPermutedRow(const int64_t* total_rows_before_expert, const int num_experts,
+    const int64_t row)
+{
+    int low = 0, high = num_experts;
+    while (low < high)
+    {
+        const int mid = (low + high) / 2;
+        if (total_rows_before_expert[mid] <= row)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Same as expandInputRowsKernel, but quantizes the permuted rows to FP8
+template <typename T, bool CHECK_SKIPPED>
+__global__ void expandInputRowsFp8Kernel(const T* unpermuted_input, __nv_fp8_e4m3* permuted_output,
+    float* permuted_scales, const int* expanded_dest_row_to_expanded_source_row,
+    int* expanded_source_row_to_expanded_dest_row, const int num_rows, const int64_t* num_dest_rows, const int cols,
+    const int k)
+{
+    int64_t expanded_dest_row;
+    int source_row;
+    if (blockIdx.x >= k * num_rows)
+    {
+        const int shared_row = blockIdx.x - k * num_rows;
+        expanded_dest_row = sharedExpertRowsBegin<CHECK_SKIPPED>(num_dest_rows, num_rows, k) + shared_row;
+        source_row = shared_row % num_rows;
+    }
+    else
+    {
+        expanded_dest_row = blockIdx.x;
+        const int expanded_source_row = expanded_dest_row_to_expanded_source_row[expanded_dest_row];
+        if (threadIdx.x == 0)
+        {
+            expanded_source_row_to_expanded_dest_row[expanded_source_row] = expanded_dest_row;
+        }
+
+        if (CHECK_SKIPPED && blockIdx.x >= *num_dest_rows)
+        {
+            return;
+        }
+        source_row = expanded_source_row % num_rows;
+    }
+
+    const T* source_row_ptr = unpermuted_input + static_cast<int64_t>(source_row) * cols;
+    __nv_fp8_e4m3* dest_row_ptr = permuted_output + expanded_dest_row * cols;
+
+    float amax = 0.f;
+    for (int tid = threadIdx.x; tid < cols; tid += blockDim.x)
+    {
+        amax = fmaxf(amax, fabsf(static_cast<float>(source_row_ptr[tid])));
+    }
+    const float quant_scale = fp8QuantScale(blockAllReduceMax(amax));
+    if (threadIdx.x == 0)
+    {
+        permuted_scales[expanded_dest_row] = 1.f / quant_scale;
+    }
+    for (int tid = threadIdx.x; tid < cols; tid += blockDim.x)
+    {
+        dest_row_ptr[tid] = static_cast<__nv_fp8_e4m3>(static_cast<float>(source_row_ptr[tid]) * quant_scale);
+    }
+}
+
+template <typename T>
+void expandInputRowsFp8KernelLauncher(const T* unpermuted_input, __nv_fp8_e4m3* permuted_output,
+    float* permuted_scales, const int* expanded_dest_row_to_expanded_source_row,
+    int* expanded_source_row_to_expanded_dest_row, const int num_rows, const int64_t* num_valid_tokens_ptr,
+    const int cols, const int k, const int num_shared_experts, cudaStream_t stream)
+{
+    const int blocks = num_rows * (k + num_shared_experts);
+    const int threads = fp8RowThreads(cols);
+    auto func = (num_valid_tokens_ptr != nullptr) ? expandInputRowsFp8Kernel<T, true>
+                                                  : expandInputRowsFp8Kernel<T, false>;
+    func<<<blocks, threads, 0, stream>>>(unpermuted_input, permuted_output, permuted_scales,
+        expanded_dest_row_to_expanded_source_row, expanded_source_row_to_expanded_dest_row, num_rows,
+        num_valid_tokens_ptr, cols, k);
+}
+
+// Dequantizes the FC1 results and adds the bias, applies the (gated) activation and quantizes the rows for FC2. The
+// activated values are written back in place until the scale of their row is known, each by the thread that reads it.
+template <class T, class ActFn, bool IS_GATED>
+__global__ void doFp8ActivationKernel(__nv_fp8_e4m3* output, float* output_scales, float* gemm_result,
+    const float* row_scales, const float* expert_scales, const T* bias, const int64_t* total_rows_before_expert,
+    const int num_experts, const int64_t* num_valid_tokens_ptr, const int64_t inter_size, const bool interleaved)
+{
+    const int64_t token = blockIdx.x;
+    if (num_valid_tokens_ptr && token >= *num_valid_tokens_ptr)
+    {
+        return;
+    }
+
+    const int expert = findExpertOfPermutedRow(total_rows_before_expert, num_experts, token);
+    const float dequant_scale = row_scales[token] * expert_scales[expert];
+    const int64_t gemm_cols = IS_GATED ? inter_size * 2 : inter_size;
+    float* gemm_row = gemm_result + token * gemm_cols;
+    const T* bias_row = bias ? bias + expert * gemm_cols : nullptr;
+
+    ActFn fn{};
+    float amax = 0.f;
+    // Every thread keeps its activations in the linear columns it read, so the in-place update never races
+    const int64_t linear_stride = IS_GATED && interleaved ? 2 : 1;
+    for (int64_t i = threadIdx.x; i < inter_size; i += blockDim.x)
+    {
+        const int64_t linear_col = i * linear_stride;
+        float value
+            = gemm_row[linear_col] * dequant_scale + (bias_row ? static_cast<float>(bias_row[linear_col]) : 0.f);
+        if constexpr (IS_GATED)
+        {
+            const int64_t gate_col = interleaved ? 2 * i + 1 : i + inter_size;
+            const float gate_value
+                = gemm_row[gate_col] * dequant_scale + (bias_row ? static_cast<float>(bias_row[gate_col]) : 0.f);
+            value = value * fn(gate_value);
+        }
+        else
+        {
+            value = fn(value);
+        }
+        gemm_row[linear_col] = value;
+        amax = fmaxf(amax, fabsf(value));
+    }
+
+    const float quant_scale = fp8QuantScale(blockAllReduceMax(amax));
+    if (threadIdx.x == 0)
+    {
+        output_scales[token] = 1.f / quant_scale;
+    }
+    __nv_fp8_e4m3* output_row = output + token * inter_size;
+    for (int64_t i = threadIdx.x; i < inter_size; i += blockDim.x)
+    {
+        output_row[i] = static_cast<__nv_fp8_e4m3>(gemm_row[i * linear_stride] * quant_scale);
+    }
+}
+
+template <class T>
+void doFp8Activation(__nv_fp8_e4m3* output, float* output_scales, float* gemm_result, const float* row_scales,
+    const float* expert_scales, const T* bias, const int64_t* total_rows_before_expert, const int num_experts,
+    const int64_t* num_valid_tokens_ptr, const int inter_size, const int num_tokens, ActivationType activation_type,
+    const bool interleaved, cudaStream_t stream)
+{
+    using namespace cutlass::epilogue::thread;
+    auto* fn = &doFp8ActivationKernel<T, Identity<float>, false>;
+    switch (activation_type)
+    {
+    case ActivationType::Gelu: fn = &doFp8ActivationKernel<T, GELU_taylor<float>, false>; break;
+    case ActivationType::Relu: fn = &doFp8ActivationKernel<T, ReLu<float>, false>; break;
+    case ActivationType::Silu: fn = &doFp8ActivationKernel<T, SiLu<float>, false>; break;
+    case ActivationType::Swiglu: fn = &doFp8ActivationKernel<T, SiLu<float>, true>; break;
+    case ActivationType::Geglu: fn = &doFp8ActivationKernel<T, GELU<float>, true>; break;
+    case ActivationType::Identity: break;
+    default: TLLM_THROW("Invalid activation type for the FP8 MoE");
+    }
+    fn<<<num_tokens, fp8RowThreads(inter_size), 0, stream>>>(output, output_scales, gemm_result, row_scales,
+        expert_scales, bias, total_rows_before_expert, num_experts, num_valid_tokens_ptr, inter_size, interleaved);
+}
+
+// Dequantizes the FC2 results for finalizeMoeRoutingKernel
+template <class T>
+__global__ void dequantFp8GemmResultKernel(T* output, const float* gemm_result, const float* row_scales,
+    const float* expert_scales, const int64_t* total_rows_before_expert, const int num_experts,
+    const int64_t* num_valid_tokens_ptr, const int64_t cols)
+{
+    const int64_t token = blockIdx.x;
+    if (num_valid_tokens_ptr && token >= *num_valid_tokens_ptr)
+    {
+        return;
+    }
+
+    const int expert = findExpertOfPermutedRow(total_rows_before_expert, num_experts, token);
+    const float dequant_scale = row_scales[token] * expert_scales[expert];
+    for (int64_t i = threadIdx.x; i < cols; i += blockDim.x)
+    {
+        output[token * cols + i] = static_cast<T>(gemm_result[token * cols + i] * dequant_scale);
+    }
+}
+
+template <class T>
+void dequantFp8GemmResult(T* output, const float* gemm_result, const float* row_scales, const float* expert_scales,
+    const int64_t* total_rows_before_expert, const int num_experts, const int64_t* num_valid_tokens_ptr,
+    const int cols, const int num_tokens, cudaStream_t stream)
+{
+    const int threads = std::min(cols, 1024);
+    dequantFp8GemmResultKernel<T><<<num_tokens, threads, 0, stream>>>(output, gemm_result, row_scales,
+        expert_scales, total_rows_before_expert, num_experts, num_valid_tokens_ptr, cols);
 }
+#endif // ENABLE_FP8
 
 template <typename T, typename WeightType, typename Enable>
 std::vector<size_t> CutlassMoeFCRunner<T, WeightType, Enable>::getWorkspaceBufferSizes(const int num_rows,
     const int hidden_size, const int inter_size, const int num_experts, const int num_experts_per_node, const int k,
     ActivationType activation_type) const
 {
-    const size_t num_moe_inputs = k * num_rows;
+    // The shared experts add one row per token each after the routed rows
+    const size_t num_moe_inputs = (k + num_shared_experts_) * num_rows;
     const size_t buf_size = num_moe_inputs * hidden_size;
     const size_t interbuf_elems = num_moe_inputs * inter_size;
-    const size_t glu_inter_elems = isGatedActivation(activation_type) ? (interbuf_elems * 2) : 0;
+    const size_t glu_inter_elems
+        = isGatedActivation(activation_type) && !useFusedGatedActivation(activation_type) ? (interbuf_elems * 2) : 0;
+    const int num_gemm_experts = num_experts_per_node + num_shared_experts_;
     int num_softmax_outs = 0;
 
     const bool is_pow_2 = (num_experts != 0) && ((num_experts & (num_experts - 1)) == 0);
@@ -848,15 +1311,22 @@ std::vector<size_t> CutlassMoeFCRunner<T, WeightType, Enable>::getWorkspaceBuffe
         num_softmax_outs = num_rows * num_experts;
     }
 
-    size_t source_rows_size = num_moe_inputs * sizeof(int);
-    size_t permuted_rows_size = num_moe_inputs * sizeof(int);
-    size_t permuted_experts_size = num_moe_inputs * sizeof(int);
-    size_t permuted_data_size = buf_size * sizeof(T);
-    size_t total_rows_before_expert_size = num_experts_per_node * sizeof(int64_t);
+    size_t source_rows_size = k * num_rows * sizeof(int);
+    size_t permuted_rows_size = k * num_rows * sizeof(int);
+    size_t permuted_experts_size = k * num_rows * sizeof(int);
+    size_t permuted_data_size = buf_size * sizeof(GemmInputType);
+    size_t total_rows_before_expert_size = num_gemm_experts * sizeof(int64_t);
     size_t softmax_out_size = num_softmax_outs * sizeof(float);
-    size_t glu_inter_size = glu_inter_elems * sizeof(T);
-    size_t fc1_result_size = interbuf_elems * sizeof(T);
+    // The FP8 experts apply the gated activation to fp8_gemm_result
+    size_t glu_inter_size = use_fp8 ? 0 : glu_inter_elems * sizeof(T);
+    size_t fc1_result_size = interbuf_elems * sizeof(GemmInputType);
     size_t sorter_size = CubKeyValueSorter::getWorkspaceSize(num_rows, num_experts);
+    size_t gemm_workspace_size = moe_gemm_runner_.getWorkspaceSize(num_gemm_experts);
+    size_t row_scales_size = use_fp8 ? num_moe_inputs * sizeof(float) : 0;
+    // Holds the results of FC1 and then of FC2
+    size_t fp8_gemm_result_size
+        = use_fp8 ? std::max(interbuf_elems * (isGatedActivation(activation_type) ? 2 : 1), buf_size) * sizeof(float)
+                  : 0;
 
     std::vector<size_t> workspace{
         source_rows_size,
@@ -868,6 +1338,10 @@ std::vector<size_t> CutlassMoeFCRunner<T, WeightType, Enable>::getWorkspaceBuffe
         glu_inter_size,
         // These pointers reuse the same memory
         std::max(fc1_result_size, sorter_size),
+        gemm_workspace_size,
+        row_scales_size,
+        row_scales_size,
+        fp8_gemm_result_size,
     };
     return workspace;
 }
@@ -879,8 +1353,9 @@ size_t CutlassMoeFCRunner<T, WeightType, Enable>::getWorkspaceSize(const int num
 {
     const int ep_size = parallelism_config.ep_size;
     TLLM_CHECK_WITH_INFO(num_experts % ep_size == 0, "Number of experts must be a multiple of tp size");
+    const int num_local_experts = num_experts / ep_size + replication_.num_replicated_experts;
     auto workspace = getWorkspaceBufferSizes(
-        num_rows, hidden_size, inter_size, num_experts, num_experts / ep_size, k, activation_type);
+        num_rows, hidden_size, inter_size, num_experts, num_local_experts, k, activation_type);
     return tensorrt_llm::common::calculateTotalWorkspaceSize(workspace.data(), workspace.size());
 }
 
@@ -901,7 +1376,7 @@ void CutlassMoeFCRunner<T, WeightType, Enable>::configureWsPtrs(char* ws_ptr, co
     source_rows_ = (int*) ws_sliced[0];
     permuted_rows_ = (int*) ws_sliced[1];
     permuted_experts_ = (int*) ws_sliced[2];
-    permuted_data_ = (T*) ws_sliced[3];
+    permuted_data_ = (GemmInputType*) ws_sliced[3];
 
     total_rows_before_expert_ = (int64_t*) ws_sliced[4];
 
@@ -916,7 +1391,13 @@ void CutlassMoeFCRunner<T, WeightType, Enable>::configureWsPtrs(char* ws_ptr, co
 
     // These pointers are aliased. Since the sort ws can be overwritten after it is finished
     sorter_ws_ = (char*) ws_sliced[7];
-    fc1_result_ = (T*) ws_sliced[7];
+    fc1_result_ = (GemmInputType*) ws_sliced[7];
+
+    gemm_workspace_ = (char*) ws_sliced[8];
+
+    permuted_scales_ = (float*) ws_sliced[9];
+    fc1_result_scales_ = (float*) ws_sliced[10];
+    fp8_gemm_result_ = (float*) ws_sliced[11];
 }
 
 template <typename T, typename WeightType, typename Enable>
@@ -930,7 +1411,7 @@ void CutlassMoeFCRunner<T, WeightType, Enable>::runMoe(const void* input_activat
     MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
 {
     static constexpr bool scales_required
-        = std::is_same<WeightType, uint8_t>::value || std::is_same<WeightType, cutlass::uint4b_t>::value;
+        = std::is_same<WeightType, uint8_t>::value || std::is_same<WeightType, cutlass::uint4b_t>::value || use_fp8;
 
     auto* input_activations = static_cast<const T*>(input_activations_void);
     auto* fc1_expert_weights = static_cast<const WeightType*>(fc1_expert_weights_void);
@@ -968,68 +1449,153 @@ void CutlassMoeFCRunner<T, WeightType, Enable>::runMoe(const void* input_activat
     const int num_experts_per_node = num_experts / parallelism_config.ep_size;
     const int start_expert = num_experts_per_node * parallelism_config.ep_rank;
     const int end_expert = start_expert + num_experts_per_node;
+    // The replicas of the hot experts come after the experts of the node
+    const bool has_replicas = replication_.num_replicated_experts > 0;
+    const int num_local_experts = num_experts_per_node + replication_.num_replicated_experts;
+    TLLM_CHECK_WITH_INFO(num_local_experts <= num_experts, "Too many replicated experts for %d experts per node",
+        num_experts_per_node);
 
     configureWsPtrs(
-        workspace_ptr, num_rows, hidden_size, inter_size, num_experts, num_experts_per_node, k, fc1_activation_type);
+        workspace_ptr, num_rows, hidden_size, inter_size, num_experts, num_local_experts, k, fc1_activation_type);
+    // With replicas the node of a row is only known once its experts are, so select over all the experts and map them
+    // to the local experts afterwards
     topkGatingSoftmaxKernelLauncher(gating_output, finished, expert_scales, softmax_out_, expert_for_source_row,
-        source_rows_, num_rows, num_experts, k, start_expert, end_expert, stream);
-
-    sync_check_cuda_error();
-
-    sorter_.updateNumExperts(num_experts);
-    const int sorter_ws_size_bytes = pad_to_multiple_of_16(sorter_.getWorkspaceSize(k * num_rows, num_experts));
-    sorter_.run((void*) sorter_ws_, sorter_ws_size_bytes, expert_for_source_row, permuted_experts_, source_rows_,
-        permuted_rows_, k * num_rows, stream);
+        source_rows_, num_rows, num_experts, k, has_replicas ? 0 : start_expert,
+        has_replicas ? num_experts : end_expert, stream);
+    if (has_replicas)
+    {
+        const int threads = 256;
+        const int blocks = (k * num_rows + threads - 1) / threads;
+        mapExpertsToNodeKernel<<<blocks, threads, 0, stream>>>(expert_for_source_row, k * num_rows, k, num_experts,
+            num_experts_per_node, parallelism_config.ep_size, parallelism_config.ep_rank, replication_);
+    }
 
     sync_check_cuda_error();
 
     // Upper bound on number of expanded rows
     const int expanded_active_expert_rows = k * active_rows;
-    computeTotalRowsBeforeExpert(
-        permuted_experts_, expanded_active_expert_rows, num_experts_per_node, total_rows_before_expert_, stream);
+    if (canUseFusedRouting(k * num_rows, num_local_experts))
+    {
+        fusedMoeRoutingKernelLauncher(expert_for_source_row, source_rows_, permuted_rows_, total_rows_before_expert_,
+            k * num_rows, expanded_active_expert_rows, num_local_experts, stream);
+    }
+    else
+    {
+        sorter_.updateNumExperts(num_experts);
+        const int sorter_ws_size_bytes = pad_to_multiple_of_16(sorter_.getWorkspaceSize(k * num_rows, num_experts));
+        sorter_.run((void*) sorter_ws_, sorter_ws_size_bytes, expert_for_source_row, permuted_experts_, source_rows_,
+            permuted_rows_, k * num_rows, stream);
+
+        sync_check_cuda_error();
+
+        computeTotalRowsBeforeExpert(
+            permuted_experts_, expanded_active_expert_rows, num_local_experts, total_rows_before_expert_, stream);
+    }
 
     sync_check_cuda_error();
 
+    // The shared experts are computed once, by the first node of the expert parallel group
+    const int num_shared_on_node = parallelism_config.ep_rank == 0 ? num_shared_experts_ : 0;
+    const int num_gemm_experts = num_local_experts + num_shared_on_node;
+    if (num_shared_on_node > 0)
+    {
+        appendSharedExpertsKernel<<<1, num_shared_on_node, 0, stream>>>(
+            total_rows_before_expert_, num_local_experts, num_shared_on_node, num_rows);
+        sync_check_cuda_error();
+    }
+
+    if (expert_load_)
+    {
+        const int threads = std::min(1024, num_local_experts);
+        const int blocks = (num_local_experts + threads - 1) / threads;
+        accumulateExpertLoadKernel<<<blocks, threads, 0, stream>>>(total_rows_before_expert_, expert_load_,
+            num_local_experts, num_experts_per_node, start_expert, replication_);
+    }
+
     const bool needs_num_valid = finished || parallelism_config.ep_size > 1;
     const int64_t* num_valid_tokens_ptr
-        = needs_num_valid ? total_rows_before_expert_ + num_experts_per_node - 1 : nullptr;
-    expandInputRowsKernelLauncher(input_activations, permuted_data_, permuted_rows_,
-        expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, hidden_size, k, stream);
+        = needs_num_valid ? total_rows_before_expert_ + num_local_experts - 1 : nullptr;
+    // The rows of the GEMMs and of the kernels between them, including those of the shared experts
+    const int64_t* gemm_valid_rows_ptr
+        = num_shared_on_node > 0 ? total_rows_before_expert_ + num_gemm_experts - 1 : num_valid_tokens_ptr;
+    const int num_gemm_rows = num_rows * (k + num_shared_on_node);
+    const int gemm_active_rows = expanded_active_expert_rows + num_shared_on_node * num_rows;
+    if constexpr (use_fp8)
+    {
+#ifdef ENABLE_FP8
+        expandInputRowsFp8KernelLauncher(input_activations, permuted_data_, permuted_scales_, permuted_rows_,
+            expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, hidden_size, k,
+            num_shared_on_node, stream);
 
-    sync_check_cuda_error();
+        sync_check_cuda_error();
 
-    if (!isGatedActivation(fc1_activation_type))
-    {
-        moe_gemm_runner_.moeGemmBiasAct(permuted_data_, fc1_expert_weights, fc1_scales, fc1_expert_biases, fc1_result_,
-            total_rows_before_expert_, expanded_active_expert_rows, inter_size, hidden_size, num_experts_per_node,
-            fc1_activation_type, stream);
+        // The scales of FP8 weights are per expert and in fp32
+        auto* fc1_weight_scales = static_cast<const float*>(fc1_scales_void);
+        auto* fc2_weight_scales = static_cast<const float*>(fc2_scales_void);
+        const int fc1_out_size = isGatedActivation(fc1_activation_type) ? inter_size * 2 : inter_size;
+        moe_gemm_runner_.moeGemm(permuted_data_, fc1_expert_weights, fp8_gemm_result_, total_rows_before_expert_,
+            fc1_out_size, hidden_size, num_gemm_experts, gemm_workspace_, stream);
+
+        sync_check_cuda_error();
+
+        doFp8Activation<T>(fc1_result_, fc1_result_scales_, fp8_gemm_result_, permuted_scales_, fc1_weight_scales,
+            fc1_expert_biases, total_rows_before_expert_, num_gemm_experts, gemm_valid_rows_ptr, inter_size,
+            num_gemm_rows, fc1_activation_type, gated_weights_interleaved_, stream);
+
+        sync_check_cuda_error();
+
+        moe_gemm_runner_.moeGemm(fc1_result_, fc2_expert_weights, fp8_gemm_result_, total_rows_before_expert_,
+            hidden_size, inter_size, num_gemm_experts, gemm_workspace_, stream);
+
+        sync_check_cuda_error();
+
+        dequantFp8GemmResult<T>(fc2_result, fp8_gemm_result_, fc1_result_scales_, fc2_weight_scales,
+            total_rows_before_expert_, num_gemm_experts, gemm_valid_rows_ptr, hidden_size, num_gemm_rows, stream);
+#endif // ENABLE_FP8
     }
     else
     {
-        const size_t fc1_out_size = inter_size * 2;
-        // Run the GEMM with activation function overridden with `Identity`, we do the activation separately
-        moe_gemm_runner_.moeGemmBiasAct(permuted_data_, fc1_expert_weights, fc1_scales, fc1_expert_biases,
-            glu_inter_result_, total_rows_before_expert_, expanded_active_expert_rows, fc1_out_size, hidden_size,
-            num_experts_per_node, ActivationType::Identity, stream);
+        expandInputRowsKernelLauncher(input_activations, permuted_data_, permuted_rows_,
+            expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, hidden_size, k,
+            num_shared_on_node, stream);
 
         sync_check_cuda_error();
 
-        doGatedActivation<T>(fc1_result_, glu_inter_result_, num_valid_tokens_ptr, inter_size, num_rows * k,
-            fc1_activation_type, stream);
-    }
+        if (!isGatedActivation(fc1_activation_type) || useFusedGatedActivation(fc1_activation_type))
+        {
+            // A fused gated activation reads the interleaved inter_size * 2 columns and writes inter_size of them
+            const int fc1_gemm_n = isGatedActivation(fc1_activation_type) ? inter_size * 2 : inter_size;
+            moe_gemm_runner_.moeGemmBiasAct(permuted_data_, fc1_expert_weights, fc1_scales, fc1_expert_biases,
+                fc1_result_, total_rows_before_expert_, gemm_active_rows, fc1_gemm_n, hidden_size, num_gemm_experts,
+                fc1_activation_type, gemm_workspace_, stream);
+        }
+        else
+        {
+            const size_t fc1_out_size = inter_size * 2;
+            // Run the GEMM with activation function overridden with `Identity`, we do the activation separately
+            moe_gemm_runner_.moeGemmBiasAct(permuted_data_, fc1_expert_weights, fc1_scales, fc1_expert_biases,
+                glu_inter_result_, total_rows_before_expert_, gemm_active_rows, fc1_out_size, hidden_size,
+                num_gemm_experts, ActivationType::Identity, gemm_workspace_, stream);
 
-    sync_check_cuda_error();
+            sync_check_cuda_error();
+
+            doGatedActivation<T>(fc1_result_, glu_inter_result_, gemm_valid_rows_ptr, inter_size, num_gemm_rows,
+                fc1_activation_type, gated_weights_interleaved_, stream);
+        }
+
+        sync_check_cuda_error();
 
-    moe_gemm_runner_.moeGemm(fc1_result_, fc2_expert_weights, fc2_scales, fc2_result, total_rows_before_expert_,
-        expanded_active_expert_rows, hidden_size, inter_size, num_experts_per_node, stream);
+        moe_gemm_runner_.moeGemm(fc1_result_, fc2_expert_weights, fc2_scales, fc2_result, total_rows_before_expert_,
+            gemm_active_rows, hidden_size, inter_size, num_gemm_experts, gemm_workspace_, stream);
+    }
 
     sync_check_cuda_error();
 
     finalizeMoeRoutingKernelLauncher<T>(fc2_result, final_output,
         // TODO pass 'skip' connections (residuals)
         nullptr, nullptr, fc2_expert_biases, expert_scales, expanded_source_row_to_expanded_dest_row,
-        expert_for_source_row, num_rows, hidden_size, k, num_valid_tokens_ptr, parallelism_config, normalization_mode,
-        stream);
+        expert_for_source_row, num_rows, hidden_size, k, num_valid_tokens_ptr, num_shared_on_node, num_local_experts,
+        parallelism_config, normalization_mode, stream);
 
     sync_check_cuda_error();
 }
@@ -1096,6 +1662,283 @@ void makeLoadBalancedRoutingConfiguration(
     sync_check_cuda_error();
 }
 
+// ==================== All-to-all expert parallelism ==================================
+
+std::vector<size_t> getAllToAllRoutingBufferSizes(const int num_rows, const int num_experts, const int k)
+{
+    const size_t num_moe_inputs = k * num_rows;
+    return {
+        num_rows * num_experts * sizeof(float), // softmax_temp
+        num_moe_inputs * sizeof(int),           // source_rows
+        num_moe_inputs * sizeof(int),           // permuted_rows
+        num_moe_inputs * sizeof(int),           // permuted_experts
+        num_experts * sizeof(int64_t),          // total_rows_before_expert
+        CubKeyValueSorter::getWorkspaceSize(num_moe_inputs, num_experts),
+    };
+}
+
+MoeAllToAllRoutingBuffers setupAllToAllRoutingBuffers(
+    char* ws_ptr, const int num_rows, const int num_experts, const int k)
+{
+    auto const sizes = getAllToAllRoutingBufferSizes(num_rows, num_experts, k);
+    std::vector<int8_t*> ws_sliced{(int8_t*) ws_ptr};
+    for (auto size : sizes)
+    {
+        ws_sliced.push_back(nextWorkspacePtr(ws_sliced.back(), size));
+    }
+
+    MoeAllToAllRoutingBuffers buffers;
+    buffers.softmax_temp = (float*) ws_sliced[0];
+    buffers.source_rows = (int*) ws_sliced[1];
+    buffers.permuted_rows = (int*) ws_sliced[2];
+    buffers.permuted_experts = (int*) ws_sliced[3];
+    buffers.total_rows_before_expert = (int64_t*) ws_sliced[4];
+    buffers.sorter_ws = (char*) ws_sliced[5];
+    buffers.sorter_ws_size = sizes[5];
+    return buffers;
+}
+
+void computeAllToAllRouting(const float* gating_output, const bool* finished, float* expert_scales,
+    int* expert_for_source_row, const MoeAllToAllRoutingBuffers& buffers, const int num_rows, const int num_experts,
+    const int k, cudaStream_t stream)
+{
+    // All the experts are candidates, the node of the expert is only known when dispatching.
+    topkGatingSoftmaxKernelLauncher(gating_output, finished, expert_scales, buffers.softmax_temp,
+        expert_for_source_row, buffers.source_rows, num_rows, num_experts, k, 0, num_experts, stream);
+
+    const int num_moe_inputs = k * num_rows;
+    if (canUseFusedRouting(num_moe_inputs, num_experts))
+    {
+        fusedMoeRoutingKernelLauncher(expert_for_source_row, buffers.source_rows, buffers.permuted_rows,
+            buffers.total_rows_before_expert, num_moe_inputs, num_moe_inputs, num_experts, stream);
+    }
+    else
+    {
+        CubKeyValueSorter sorter(num_experts);
+        sorter.run(buffers.sorter_ws, buffers.sorter_ws_size, expert_for_source_row, buffers.permuted_experts,
+            buffers.source_rows, buffers.permuted_rows, num_moe_inputs, stream);
+        const int threads = std::min(1024, num_experts);
+        const int blocks = (num_experts + threads - 1) / threads;
+        computeTotalRowsBeforeExpertKernel<<<blocks, threads, 0, stream>>>(
+            buffers.permuted_experts, num_moe_inputs, num_experts, buffers.total_rows_before_expert);
+    }
+    sync_check_cuda_error();
+}
+
+// Rows sent to expert e, capped by the capacity.
+__global__ void moeAllToAllSendCountsKernel(
+    const int64_t* total_rows_before_expert, int* send_counts, const int num_experts, const int capacity)
+{
+    const int expert = blockIdx.x * blockDim.x + threadIdx.x;
+    if (expert >= num_experts)
+    {
+        return;
+    }
+    const int64_t start = expert == 0 ? 0 : total_rows_before_expert[expert - 1];
+    const int count = static_cast<int>(total_rows_before_expert[expert] - start);
+    send_counts[expert] = capacity > 0 ? min(count, capacity) : count;
+}
+
+// One CTA per sorted expanded row: copies the row to its place in the send buffer and records it for the combine.
+template <typename T>
+__global__ void moeAllToAllDispatchKernel(const T* unpermuted_input, T* send_buffer, int* source_to_send_row,
+    const int* permuted_rows, const int* expert_for_source_row, const int64_t* total_rows_before_expert,
+    const int num_rows, const int k, const int num_experts, const int cols, const int capacity)
+{
+    const int sorted_row = blockIdx.x;
+    const int expanded_source_row = permuted_rows[sorted_row];
+    const int source_row = expanded_source_row % num_rows;
+    const int k_idx = expanded_source_row / num_rows;
+    const int expert = expert_for_source_row[source_row * k + k_idx];
+
+    // Finished rows are routed past the last expert.
+    int send_row = -1;
+    if (expert < num_experts)
+    {
+        const int slot = sorted_row - (expert == 0 ? 0 : static_cast<int>(total_rows_before_expert[expert - 1]));
+        if (capacity == 0)
+        {
+            send_row = sorted_row;
+        }
+        else if (slot < capacity)
+        {
+            send_row = expert * capacity + slot;
+        }
+    }
+
+    if (threadIdx.x == 0)
+    {
+        source_to_send_row[source_row * k + k_idx] = send_row;
+    }
+    if (send_row < 0)
+    {
+        return;
+    }
+
+    const T* source_row_ptr = unpermuted_input + static_cast<int64_t>(source_row) * cols;
+    T* dest_row_ptr = send_buffer + static_cast<int64_t>(send_row) * cols;
+    for (int tid = threadIdx.x; tid < cols; tid += blockDim.x)
+    {
+        dest_row_ptr[tid] = source_row_ptr[tid];
+    }
+}
+
+// Builds the routing of the received rows for the local experts: a one-hot gating on the expert the row was sent to,
+// and finished for the padding of the capacity segments.
+__global__ void moeAllToAllLocalRoutingKernel(const int* recv_counts, float* local_gating, bool* local_finished,
+    const int num_recv_rows, const int num_segments, const int experts_per_node, const int capacity)
+{
+    const int row = blockIdx.x * blockDim.x + threadIdx.x;
+    if (row >= num_recv_rows)
+    {
+        return;
+    }
+
+    // The received rows are grouped by source node, then by local expert.
+    int segment = 0;
+    int segment_begin = 0;
+    for (; segment < num_segments; ++segment)
+    {
+        const int segment_size = capacity > 0 ? capacity : recv_counts[segment];
+        if (row < segment_begin + segment_size)
+        {
+            break;
+        }
+        segment_begin += segment_size;
+    }
+    const bool valid = segment < num_segments && row - segment_begin < recv_counts[segment];
+    const int expert = segment % experts_per_node;
+
+    for (int ii = 0; ii < experts_per_node; ++ii)
+    {
+        local_gating[static_cast<int64_t>(row) * experts_per_node + ii] = ii == expert ? 0.f : -INFINITY;
+    }
+    local_finished[row] = !valid;
+}
+
+// One CTA per token: sums the returned expert outputs weighted by the routing scales. Dropped rows contribute zero.
+template <typename T>
+__global__ void moeAllToAllCombineKernel(const T* returned_rows, T* output, const float* expert_scales,
+    const int* source_to_send_row, const int cols, const int k, const bool renormalize)
+{
+    const int token = blockIdx.x;
+
+    float scale_sum = 1.f;
+    if (renormalize)
+    {
+        scale_sum = 0.f;
+        for (int k_idx = 0; k_idx < k; ++k_idx)
+        {
+            scale_sum += expert_scales[token * k + k_idx];
+        }
+    }
+
+    for (int tid = threadIdx.x; tid < cols; tid += blockDim.x)
+    {
+        float thread_output = 0.f;
+        for (int k_idx = 0; k_idx < k; ++k_idx)
+        {
+            const int send_row = source_to_send_row[token * k + k_idx];
+            if (send_row < 0)
+            {
+                continue;
+            }
+            const float row_scale = expert_scales[token * k + k_idx] / scale_sum;
+            thread_output += row_scale * static_cast<float>(returned_rows[static_cast<int64_t>(send_row) * cols + tid]);
+        }
+        output[static_cast<int64_t>(token) * cols + tid] = static_cast<T>(thread_output);
+    }
+}
+
+template <typename T>
+void moeAllToAllDispatchLauncher(const void* input, void* send_buffer, int* send_counts, int* source_to_send_row,
+    const int* expert_for_source_row, const MoeAllToAllRoutingBuffers& buffers, const int num_rows, const int cols,
+    const int num_experts, const int k, const int capacity, cudaStream_t stream)
+{
+    const int count_threads = std::min(1024, num_experts);
+    const int count_blocks = (num_experts + count_threads - 1) / count_threads;
+    moeAllToAllSendCountsKernel<<<count_blocks, count_threads, 0, stream>>>(
+        buffers.total_rows_before_expert, send_counts, num_experts, capacity);
+
+    const int threads = std::min(cols, 1024);
+    moeAllToAllDispatchKernel<T><<<num_rows * k, threads, 0, stream>>>(static_cast<const T*>(input),
+        static_cast<T*>(send_buffer), source_to_send_row, buffers.permuted_rows, expert_for_source_row,
+        buffers.total_rows_before_expert, num_rows, k, num_experts, cols, capacity);
+}
+
+void invokeMoeAllToAllDispatch(const void* input, void* send_buffer, int* send_counts, int* source_to_send_row,
+    const int* expert_for_source_row, const MoeAllToAllRoutingBuffers& buffers, const int num_rows, const int cols,
+    const int num_experts, const int k, const int capacity, nvinfer1::DataType type, cudaStream_t stream)
+{
+    if (type == nvinfer1::DataType::kFLOAT)
+    {
+        moeAllToAllDispatchLauncher<float>(input, send_buffer, send_counts, source_to_send_row, expert_for_source_row,
+            buffers, num_rows, cols, num_experts, k, capacity, stream);
+    }
+    else if (type == nvinfer1::DataType::kHALF)
+    {
+        moeAllToAllDispatchLauncher<half>(input, send_buffer, send_counts, source_to_send_row, expert_for_source_row,
+            buffers, num_rows, cols, num_experts, k, capacity, stream);
+    }
+#ifdef ENABLE_BF16
+    else if (type == nvinfer1::DataType::kBF16)
+    {
+        moeAllToAllDispatchLauncher<__nv_bfloat16>(input, send_buffer, send_counts, source_to_send_row,
+            expert_for_source_row, buffers, num_rows, cols, num_experts, k, capacity, stream);
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported data type for the MoE all-to-all dispatch");
+    }
+    sync_check_cuda_error();
+}
+
+void invokeMoeAllToAllLocalRouting(const int* recv_counts, float* local_gating, bool* local_finished,
+    const int num_recv_rows, const int ep_size, const int experts_per_node, const int capacity, cudaStream_t stream)
+{
+    if (num_recv_rows == 0)
+    {
+        return;
+    }
+    const int threads = 256;
+    const int blocks = (num_recv_rows + threads - 1) / threads;
+    moeAllToAllLocalRoutingKernel<<<blocks, threads, 0, stream>>>(recv_counts, local_gating, local_finished,
+        num_recv_rows, ep_size * experts_per_node, experts_per_node, capacity);
+    sync_check_cuda_error();
+}
+
+void invokeMoeAllToAllCombine(const void* returned_rows, void* output, const float* expert_scales,
+    const int* source_to_send_row, const int num_rows, const int cols, const int k,
+    MOEExpertScaleNormalizationMode normalization_mode, nvinfer1::DataType type, cudaStream_t stream)
+{
+    const int threads = std::min(cols, 1024);
+    const bool renormalize = normalization_mode == MOEExpertScaleNormalizationMode::RENORMALIZE;
+    if (type == nvinfer1::DataType::kFLOAT)
+    {
+        moeAllToAllCombineKernel<float><<<num_rows, threads, 0, stream>>>(static_cast<const float*>(returned_rows),
+            static_cast<float*>(output), expert_scales, source_to_send_row, cols, k, renormalize);
+    }
+    else if (type == nvinfer1::DataType::kHALF)
+    {
+        moeAllToAllCombineKernel<half><<<num_rows, threads, 0, stream>>>(static_cast<const half*>(returned_rows),
+            static_cast<half*>(output), expert_scales, source_to_send_row, cols, k, renormalize);
+    }
+#ifdef ENABLE_BF16
+    else if (type == nvinfer1::DataType::kBF16)
+    {
+        moeAllToAllCombineKernel<__nv_bfloat16><<<num_rows, threads, 0, stream>>>(
+            static_cast<const __nv_bfloat16*>(returned_rows), static_cast<__nv_bfloat16*>(output), expert_scales,
+            source_to_send_row, cols, k, renormalize);
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported data type for the MoE all-to-all combine");
+    }
+    sync_check_cuda_error();
+}
+
 // ==================== Variable batched GEMM specializations ==================================
 template class CutlassMoeFCRunner<float, float>;
 
@@ -1109,4 +1952,11 @@ template class CutlassMoeFCRunner<half, half>;
 template class CutlassMoeFCRunner<half, uint8_t>;
 template class CutlassMoeFCRunner<half, cutlass::uint4b_t>;
 
+#ifdef ENABLE_FP8
+template class CutlassMoeFCRunner<half, __nv_fp8_e4m3>;
+#ifdef ENABLE_BF16
+template class CutlassMoeFCRunner<__nv_bfloat16, __nv_fp8_e4m3>;
+#endif
+#endif
+
 } // namespace tensorrt_llm::kernels
@@ -22,6 +22,7 @@
 #include "tensorrt_llm/plugins/common/gemmPluginProfiler.h"
 #include <cuda_runtime_api.h>
 #include <optional>
+#include <type_traits>
 
 namespace tensorrt_llm::kernels
 {
@@ -78,6 +79,8 @@ enum class MOEParallelismMode : int
                         //!< parallelism
     TENSOR_PARALLELISM, //!< Divide the weight matrices between the nodes. The hidden dimension must be a multiple of
                         //!< parallelism
+    EXPERT_PARALLELISM_ALL_TO_ALL, //!< Divide the experts between the nodes as with EXPERT_PARALLELISM, but each node
+                                   //!< only holds its own tokens. The tokens are exchanged with an all-to-all
 };
 
 enum class MOEExpertScaleNormalizationMode : int
@@ -126,6 +129,20 @@ struct MOEParallelismConfig
     const int ep_rank = 0;
 };
 
+/**
+ * Experts copied to every node with expert parallelism, to spread the rows of the hottest experts over the nodes
+ * instead of leaving them all to their owner. Each node holds its experts_per_node experts followed by the replicas,
+ * in the order of replicated_experts, so the weights passed to runMoe have experts_per_node + num_replicated_experts
+ * experts. The rows of a replicated expert are split between the nodes by source row.
+ */
+struct MOEExpertReplication
+{
+    static constexpr int kMaxReplicatedExperts = 16;
+
+    int num_replicated_experts = 0;
+    int replicated_experts[kMaxReplicatedExperts]{};
+};
+
 class CutlassMoeFCRunnerInterface
 {
 public:
@@ -136,6 +153,16 @@ public:
         = 0;
     virtual void setTactic(std::optional<cutlass_extensions::CutlassGemmConfig> gemm_config) = 0;
     virtual std::vector<cutlass_extensions::CutlassGemmConfig> getTactics() = 0;
+    // If set, runMoe adds the rows this node processes for each expert to expert_load[num_experts]
+    virtual void setExpertLoadCounters(int64_t* expert_load) = 0;
+    virtual void setExpertReplication(MOEExpertReplication const& replication) = 0;
+    // Shared experts process every token and are added unscaled to the routed result. Their weights, biases and scales
+    // follow those of the node's experts (and replicas). Only ep rank 0 computes them, and fc2_result must then hold
+    // (k + num_shared_experts) * num_rows rows.
+    virtual void setSharedExperts(int num_shared_experts) = 0;
+    // If set, the FC1 weights of gated activations are interleaved: column 2i is the linear part of output i and
+    // column 2i + 1 its gate, instead of [linear, gate]. Allows fusing the activation into the GEMM epilogue.
+    virtual void setGatedWeightsInterleaved(bool interleaved) = 0;
 
     virtual void runMoe(const void* input_activations, const float* gating_output, const void* fc1_expert_weights,
         const void* fc1_scales, const void* fc1_expert_biases, ActivationType fc1_activation_type,
@@ -151,6 +178,8 @@ public:
 // Assumes inputs activations are row major. Weights need to be preprocessed by th_op/weight_quantize.cc .
 // Nested in a class to avoid multiple calls to cudaGetDeviceProperties as this call can be expensive.
 // Avoid making several duplicates of this class.
+// With FP8 E4M3 weights (SM90 only), the weights of an expert are [n, k] row-major and fc1_scales and fc2_scales hold
+// one float dequantization scale per expert. The activations are quantized per token while they are permuted.
 template <typename T,    /*The type used for activations/scales/compute*/
     typename WeightType, /* The type for the MoE weights */
     typename Enable = void>
@@ -173,6 +202,27 @@ public:
         return moe_gemm_runner_.getConfigs();
     }
 
+    void setExpertLoadCounters(int64_t* expert_load) override
+    {
+        expert_load_ = expert_load;
+    }
+
+    void setExpertReplication(MOEExpertReplication const& replication) override
+    {
+        replication_ = replication;
+    }
+
+    void setSharedExperts(int num_shared_experts) override
+    {
+        TLLM_CHECK(num_shared_experts >= 0);
+        num_shared_experts_ = num_shared_experts;
+    }
+
+    void setGatedWeightsInterleaved(bool interleaved) override
+    {
+        gated_weights_interleaved_ = interleaved;
+    }
+
     void runMoe(const void* input_activations, const float* gating_output, const void* fc1_expert_weights,
         const void* fc1_scales, const void* fc1_expert_biases, ActivationType fc1_activation_type,
         const void* fc2_expert_weights, const void* fc2_scales, const void* fc2_expert_biases, const int num_rows,
@@ -183,6 +233,16 @@ public:
         cudaStream_t stream) override;
 
 private:
+#ifdef ENABLE_FP8
+    static constexpr bool use_fp8 = std::is_same_v<WeightType, __nv_fp8_e4m3>;
+    using GemmRunner = std::conditional_t<use_fp8, MoeFp8GemmRunner, MoeGemmRunner<T, WeightType>>;
+#else
+    static constexpr bool use_fp8 = false;
+    using GemmRunner = MoeGemmRunner<T, WeightType>;
+#endif
+    // The FP8 GEMMs also take FP8 activations
+    using GemmInputType = std::conditional_t<use_fp8, WeightType, T>;
+
     void computeTotalRowsBeforeExpert(const int* sorted_indices, const int total_indices, const int num_experts,
         int64_t* total_rows_before_expert, cudaStream_t stream);
     std::vector<size_t> getWorkspaceBufferSizes(const int num_rows, const int hidden_size, const int inter_size,
@@ -190,22 +250,47 @@ private:
     void configureWsPtrs(char* ws_ptr, const int num_rows, const int hidden_size, const int inter_size,
         const int num_experts, const int num_experts_per_node, const int k, ActivationType activation_type);
 
+    // Whether the FC1 GEMM applies the gated activation in its epilogue, which needs interleaved weights
+    bool useFusedGatedActivation(ActivationType activation_type) const
+    {
+        if constexpr (use_fp8)
+        {
+            return false;
+        }
+        else
+        {
+            return isGatedActivation(activation_type) && gated_weights_interleaved_
+                && moe_gemm_runner_.supportsFusedGatedActivation();
+        }
+    }
+
 private:
     CubKeyValueSorter sorter_;
-    MoeGemmRunner<T, WeightType> moe_gemm_runner_;
+    GemmRunner moe_gemm_runner_;
 
     // Pointers
     int* source_rows_;
     int* permuted_rows_;
     int* permuted_experts_;
     char* sorter_ws_;
-    T* permuted_data_;
+    GemmInputType* permuted_data_;
     float* softmax_out_;
 
     int64_t* total_rows_before_expert_;
 
-    T* fc1_result_;
+    GemmInputType* fc1_result_;
     T* glu_inter_result_;
+    char* gemm_workspace_;
+
+    // Only used with FP8 weights: the scales of the rows of permuted_data_ and fc1_result_, and the fp32 GEMM results
+    float* permuted_scales_;
+    float* fc1_result_scales_;
+    float* fp8_gemm_result_;
+
+    int64_t* expert_load_ = nullptr;
+    MOEExpertReplication replication_{};
+    int num_shared_experts_ = 0;
+    bool gated_weights_interleaved_ = false;
 };
 
 template <typename WeightType>
@@ -226,6 +311,14 @@ public:
         return;
     }
 
+    void setExpertLoadCounters(int64_t* expert_load) override {}
+
+    void setExpertReplication(MOEExpertReplication const& replication) override {}
+
+    void setSharedExperts(int num_shared_experts) override {}
+
+    void setGatedWeightsInterleaved(bool interleaved) override {}
+
     void runMoe(const void* input_activations, const float* gating_output, const void* fc1_expert_weights,
         const void* fc1_scales, const void* fc1_expert_biases, ActivationType fc1_activation_type,
         const void* fc2_expert_weights, const void* fc2_scales, const void* fc2_expert_biases, const int num_rows,
@@ -242,4 +335,46 @@ public:
 void makeLoadBalancedRoutingConfiguration(
     void* data_void, int num_experts, int num_tokens, int k, nvinfer1::DataType type, cudaStream_t stream);
 
+/**
+ * Building blocks of MOEParallelismMode::EXPERT_PARALLELISM_ALL_TO_ALL, the exchanges between the nodes are done by the
+ * caller:
+ *  1. computeAllToAllRouting selects the top-k of all the experts and sorts the expanded rows by expert.
+ *  2. invokeMoeAllToAllDispatch copies the rows to the send buffer, which is grouped by expert and therefore by node,
+ *     and counts the rows of each expert. With a capacity, expert e owns the rows [e * capacity, (e + 1) * capacity)
+ *     and the rows past the capacity are dropped. Without (capacity == 0), the rows are packed.
+ *  3. After the exchange of the counts and the rows, invokeMoeAllToAllLocalRouting builds the routing of the received
+ *     rows for the local experts, which are run as an MoE with k = 1.
+ *  4. After the results are sent back, invokeMoeAllToAllCombine does the k-way reduction of each token.
+ */
+struct MoeAllToAllRoutingBuffers
+{
+    float* softmax_temp{};
+    int* source_rows{};
+    int* permuted_rows{};
+    int* permuted_experts{};
+    int64_t* total_rows_before_expert{};
+    char* sorter_ws{};
+    size_t sorter_ws_size{};
+};
+
+std::vector<size_t> getAllToAllRoutingBufferSizes(const int num_rows, const int num_experts, const int k);
+
+MoeAllToAllRoutingBuffers setupAllToAllRoutingBuffers(
+    char* ws_ptr, const int num_rows, const int num_experts, const int k);
+
+void computeAllToAllRouting(const float* gating_output, const bool* finished, float* expert_scales,
+    int* expert_for_source_row, const MoeAllToAllRoutingBuffers& buffers, const int num_rows, const int num_experts,
+    const int k, cudaStream_t stream);
+
+void invokeMoeAllToAllDispatch(const void* input, void* send_buffer, int* send_counts, int* source_to_send_row,
+    const int* expert_for_source_row, const MoeAllToAllRoutingBuffers& buffers, const int num_rows, const int cols,
+    const int num_experts, const int k, const int capacity, nvinfer1::DataType type, cudaStream_t stream);
+
+void invokeMoeAllToAllLocalRouting(const int* recv_counts, float* local_gating, bool* local_finished,
+    const int num_recv_rows, const int ep_size, const int experts_per_node, const int capacity, cudaStream_t stream);
+
+void invokeMoeAllToAllCombine(const void* returned_rows, void* output, const float* expert_scales,
+    const int* source_to_send_row, const int num_rows, const int cols, const int k,
+    MOEExpertScaleNormalizationMode normalization_mode, nvinfer1::DataType type, cudaStream_t stream);
+
 } // namespace tensorrt_llm::kernels
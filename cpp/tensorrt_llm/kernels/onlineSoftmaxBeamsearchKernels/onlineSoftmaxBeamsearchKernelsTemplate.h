@@ -113,13 +113,14 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topK_kernel(const int*
     }
 }
 
+// Selects the next K beams of batch vector_id from its 2 * K * K candidates and updates the beam hypotheses.
+// Shared by batch_topk_kernel and the fused large beam width kernel, which merges in the block finishing last.
 template <typename T, int MAX_K2, int THREADBLOCK_SIZE>
-__launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int* __restrict topk_tmp_id_buf,
-    const T* __restrict topk_tmp_val_buf, float* __restrict cum_log_probs, const FinishedState* finished,
-    BeamHypotheses beam_hyps, const int candidate_size)
+__device__ void batch_topk(const int* __restrict topk_tmp_id_buf, const T* __restrict topk_tmp_val_buf,
+    float* __restrict cum_log_probs, const FinishedState* finished, const BeamHypotheses& beam_hyps,
+    const int candidate_size, const int vector_id)
 {
     const int thread_id = threadIdx.x;
-    const int vector_id = blockIdx.x;
     const int K{beam_hyps.beam_width};
     const int vocab_size{beam_hyps.vocab_size};
     const int global_batch_idx{beam_hyps.ite * beam_hyps.local_batch_size + vector_id};
@@ -163,8 +164,8 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int*
         {
             beam_hyps.min_normed_scores[global_batch_idx] = FLT_MAX;
         }
-        // return if this batch has enough finished beams
-        else if (beam_hyps.num_beams[global_batch_idx] == K)
+        // return if no live beam can improve on the finished beams of this batch, see the end of this function
+        else if (beam_hyps.is_done[global_batch_idx])
         {
             return;
         }
@@ -236,9 +237,8 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int*
                     // The current score is worse than the worst one in beams
                     if (normed_score < beam_hyps.min_normed_scores[global_batch_idx])
                     {
-                        // Stop considering new beams
-                        selected_beams = K;
-                        break;
+                        // Drop it and keep extending the live beams, which may still improve on the finished ones
+                        continue;
                     }
                     // The current score is better than the worst one in beams
                     else
@@ -334,9 +334,9 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int*
     if (threadIdx.x == 0 && beam_hyps.num_beams != nullptr)
     {
         // no enough beams
-        if (beam_hyps.num_beams[blockIdx.x] < K)
+        if (beam_hyps.num_beams[global_batch_idx] < K)
         {
-            beam_hyps.is_done[blockIdx.x] = false;
+            beam_hyps.is_done[global_batch_idx] = false;
             return;
         }
         float highest_attainable_score = 0.0f;
@@ -344,13 +344,15 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int*
         {
         case 1:
             // enough beams with early stopping
-            beam_hyps.is_done[blockIdx.x] = true;
+            beam_hyps.is_done[global_batch_idx] = true;
             return;
         case 0:
-            // enough beams without early stopping
+            // enough beams without early stopping, done once the best live beam cannot beat the worst finished beam
+            // at its current length
             highest_attainable_score = static_cast<float>(apply_length_penalty(cum_log_probs[0],
                 sequence_lengths[vector_id * K] - beam_hyps.input_lengths[global_batch_idx], length_penalty));
-            beam_hyps.is_done[blockIdx.x] = beam_hyps.min_normed_scores[global_batch_idx] >= highest_attainable_score;
+            beam_hyps.is_done[global_batch_idx]
+                = beam_hyps.min_normed_scores[global_batch_idx] >= highest_attainable_score;
             return;
         default:
             // early_stopping == "never" in HF, i.e., compute the best possible score depending on `length_penalty`
@@ -359,14 +361,14 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int*
             {
                 highest_attainable_score = static_cast<float>(apply_length_penalty(cum_log_probs[0],
                     beam_hyps.max_seq_len - beam_hyps.input_lengths[global_batch_idx], length_penalty));
-                beam_hyps.is_done[blockIdx.x]
+                beam_hyps.is_done[global_batch_idx]
                     = beam_hyps.min_normed_scores[global_batch_idx] >= highest_attainable_score;
             }
             else
             {
                 highest_attainable_score = static_cast<float>(apply_length_penalty(cum_log_probs[0],
                     sequence_lengths[vector_id * K] - beam_hyps.input_lengths[global_batch_idx], length_penalty));
-                beam_hyps.is_done[blockIdx.x]
+                beam_hyps.is_done[global_batch_idx]
                     = beam_hyps.min_normed_scores[global_batch_idx] >= highest_attainable_score;
             }
             return;
@@ -374,6 +376,15 @@ __launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int*
     }
 }
 
+template <typename T, int MAX_K2, int THREADBLOCK_SIZE>
+__launch_bounds__(THREADBLOCK_SIZE) __global__ void batch_topk_kernel(const int* __restrict topk_tmp_id_buf,
+    const T* __restrict topk_tmp_val_buf, float* __restrict cum_log_probs, const FinishedState* finished,
+    BeamHypotheses beam_hyps, const int candidate_size)
+{
+    batch_topk<T, MAX_K2, THREADBLOCK_SIZE>(
+        topk_tmp_id_buf, topk_tmp_val_buf, cum_log_probs, finished, beam_hyps, candidate_size, blockIdx.x);
+}
+
 struct __align__(8) MD
 {
     float m;
@@ -819,6 +830,242 @@ void beam_online_softmax_topk_stage2_kernelLauncher(const float* temp_storage, c
     assert(0);
 }
 
+// Fused path for large beam widths. One CTA per beam computes the log-softmax statistics and the top 2 * K tokens
+// of its beam in a single pass over the vocabulary, and the CTA finishing last merges the candidates of its batch.
+// Compared to the split path there is no [batch * beam, parts, 2 * MAX_K2 + 2] staging buffer and no separate
+// stage 2 and batch top-k launches, the only extra workspace is one counter per batch.
+static const int FUSED_TOP_K_SOFTMAX_THREADBLOCK_SIZE = 256;
+static const int FUSED_TOP_K_SOFTMAX_MIN_K = 8;
+
+__device__ __forceinline__ bool is_better_candidate(float a_val, int a_id, float b_val, int b_id)
+{
+    // Break ties by token id so that the selection is deterministic
+    return a_val > b_val || (a_val == b_val && a_id < b_id);
+}
+
+// One compare-exchange step of a bitonic network over the 32 * ITEMS values of a warp, where item i of a lane is at
+// position 32 * i + lane. Positions p and p ^ j are compared, the block of size k holding p is sorted in the
+// requested order if (p & k) == 0 and in the opposite order otherwise.
+template <int ITEMS>
+__device__ __forceinline__ void warp_bitonic_step(float (&val)[ITEMS], int (&id)[ITEMS], int k, int j, bool descending)
+{
+    const int lane = threadIdx.x % 32;
+    float new_val[ITEMS];
+    int new_id[ITEMS];
+#pragma unroll
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        float other_val;
+        int other_id;
+        if (j < 32)
+        {
+            other_val = __shfl_xor_sync(unsigned(-1), val[i], j);
+            other_id = __shfl_xor_sync(unsigned(-1), id[i], j);
+        }
+        else
+        {
+            other_val = val[i ^ (j / 32)];
+            other_id = id[i ^ (j / 32)];
+        }
+        const int pos = 32 * i + lane;
+        const bool block_descending = ((pos & k) == 0) == descending;
+        const bool keep_better = ((pos & j) == 0) == block_descending;
+        const bool take_own = keep_better == is_better_candidate(val[i], id[i], other_val, other_id);
+        new_val[i] = take_own ? val[i] : other_val;
+        new_id[i] = take_own ? id[i] : other_id;
+    }
+#pragma unroll
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        val[i] = new_val[i];
+        id[i] = new_id[i];
+    }
+}
+
+template <int ITEMS>
+__device__ __forceinline__ void warp_bitonic_sort(float (&val)[ITEMS], int (&id)[ITEMS], bool descending)
+{
+    constexpr int N = 32 * ITEMS;
+#pragma unroll
+    for (int k = 2; k <= N; k <<= 1)
+    {
+#pragma unroll
+        for (int j = k >> 1; j > 0; j >>= 1)
+        {
+            warp_bitonic_step(val, id, k, j, descending);
+        }
+    }
+}
+
+// Merge an ascending chunk into a descending top list of the same size, keeping the best values of both.
+template <int ITEMS>
+__device__ __forceinline__ void warp_bitonic_merge(
+    float (&top_val)[ITEMS], int (&top_id)[ITEMS], const float (&val)[ITEMS], const int (&id)[ITEMS])
+{
+    constexpr int N = 32 * ITEMS;
+    // The element-wise best of a descending and an ascending sequence is bitonic and holds the best N values.
+#pragma unroll
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        if (is_better_candidate(val[i], id[i], top_val[i], top_id[i]))
+        {
+            top_val[i] = val[i];
+            top_id[i] = id[i];
+        }
+    }
+#pragma unroll
+    for (int j = N >> 1; j > 0; j >>= 1)
+    {
+        warp_bitonic_step(top_val, top_id, N, j, true);
+    }
+}
+
+template <typename T, int MAX_K, int THREADBLOCK_SIZE>
+__launch_bounds__(THREADBLOCK_SIZE) __global__ void beam_online_softmax_topk_fused_kernel(const T* __restrict log_probs,
+    const T* __restrict bias, const FinishedState* __restrict finished, float* __restrict cum_log_probs,
+    int* __restrict topk_tmp_id_buf, T* __restrict topk_tmp_val_buf, int* __restrict beam_counters,
+    BeamHypotheses beam_hyps)
+{
+    // Every warp keeps a sorted list of at least 2 * MAX_K tokens in registers, ITEMS per lane
+    constexpr int ITEMS = (2 * MAX_K + 31) / 32;
+    constexpr int LIST_SIZE = 32 * ITEMS;
+    constexpr int NUM_WARPS = THREADBLOCK_SIZE / 32;
+
+    const int thread_id = threadIdx.x;
+    const int lane = thread_id % 32;
+    const int warp = thread_id / 32;
+    const int vector_id = blockIdx.x;
+    const int K{beam_hyps.beam_width};
+    const int batch_id = vector_id / K;
+    const int vocab_size{beam_hyps.vocab_size};
+    const int end_id{beam_hyps.end_ids[batch_id]};
+    const bool is_finished{finished[vector_id].isFinished()};
+
+    using BlockReduceMD = cub::BlockReduce<MD, THREADBLOCK_SIZE>;
+    __shared__ typename BlockReduceMD::TempStorage md_smem;
+    __shared__ float list_val_s[NUM_WARPS][LIST_SIZE];
+    __shared__ int list_id_s[NUM_WARPS][LIST_SIZE];
+    __shared__ MD total_md;
+    __shared__ bool is_last_beam;
+
+    // reposition log_probs to data for the current vector
+    log_probs += vector_id * vocab_size;
+
+    float top_val[ITEMS];
+    int top_id[ITEMS];
+#pragma unroll
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        top_val[i] = -FLT_MAX;
+        top_id[i] = -1;
+    }
+    MD partial_md{-FLT_MAX, 0.0f};
+
+#pragma unroll 1
+    for (int chunk_start = warp * LIST_SIZE; chunk_start < vocab_size; chunk_start += NUM_WARPS * LIST_SIZE)
+    {
+        // The worst token of the list is at the last position, i.e. the last item of the last lane
+        const float threshold = __shfl_sync(unsigned(-1), top_val[ITEMS - 1], 31);
+        float val[ITEMS];
+        int id[ITEMS];
+        bool has_candidate{false};
+#pragma unroll
+        for (int i = 0; i < ITEMS; ++i)
+        {
+            const int elem_id = chunk_start + 32 * i + lane;
+            val[i] = -FLT_MAX;
+            id[i] = -1;
+            if (elem_id < vocab_size)
+            {
+                if (is_finished)
+                {
+                    val[i] = (elem_id == end_id) ? FLT_MAX : -FLT_MAX;
+                }
+                else
+                {
+                    val[i] = (float) log_probs[elem_id] + (bias == nullptr ? 0.0f : (float) bias[elem_id]);
+                }
+                id[i] = elem_id;
+                partial_md = reduce_md_op(partial_md, MD{val[i], 1.0F});
+                has_candidate |= val[i] > threshold;
+            }
+        }
+        // Once the list is filled, most chunks hold no better token and skip the sorting network
+        if (__any_sync(unsigned(-1), has_candidate))
+        {
+            warp_bitonic_sort(val, id, false);
+            warp_bitonic_merge(top_val, top_id, val, id);
+        }
+    }
+
+    // Merge the lists of all warps into warp 0. Lists are read back to front to get them in ascending order.
+#pragma unroll
+    for (int i = 0; i < ITEMS; ++i)
+    {
+        list_val_s[warp][32 * i + lane] = top_val[i];
+        list_id_s[warp][32 * i + lane] = top_id[i];
+    }
+    __syncthreads();
+    if (warp == 0)
+    {
+#pragma unroll 1
+        for (int w = 1; w < NUM_WARPS; ++w)
+        {
+            float val[ITEMS];
+            int id[ITEMS];
+#pragma unroll
+            for (int i = 0; i < ITEMS; ++i)
+            {
+                const int pos = LIST_SIZE - 1 - (32 * i + lane);
+                val[i] = list_val_s[w][pos];
+                id[i] = list_id_s[w][pos];
+            }
+            warp_bitonic_merge(top_val, top_id, val, id);
+        }
+    }
+
+    auto reduce_md_func = [](const MD& a, const MD& b) { return reduce_md_op(a, b); };
+    const MD block_md = BlockReduceMD(md_smem).Reduce(partial_md, reduce_md_func);
+    if (thread_id == 0)
+    {
+        total_md = block_md;
+    }
+    __syncthreads();
+
+    if (warp == 0)
+    {
+        const float d_total_log = logf(total_md.d);
+        const float cum_log_prob = cum_log_probs[vector_id];
+#pragma unroll
+        for (int i = 0; i < ITEMS; ++i)
+        {
+            const int pos = 32 * i + lane;
+            if (pos < 2 * K)
+            {
+                // trtllm needs absolute id
+                topk_tmp_id_buf[vector_id * 2 * K + pos] = top_id[i] + vector_id * vocab_size;
+                topk_tmp_val_buf[vector_id * 2 * K + pos] = (T) (top_val[i] - total_md.m - d_total_log + cum_log_prob);
+            }
+        }
+        // Make the candidates visible to the CTA merging the batch before this beam is counted as done
+        __threadfence();
+    }
+    __syncthreads();
+
+    if (thread_id == 0)
+    {
+        is_last_beam = atomicAdd(beam_counters + batch_id, 1) == K - 1;
+    }
+    __syncthreads();
+    if (!is_last_beam)
+    {
+        return;
+    }
+
+    batch_topk<T, 2 * MAX_K, THREADBLOCK_SIZE>(
+        topk_tmp_id_buf, topk_tmp_val_buf, cum_log_probs, finished, beam_hyps, 2 * K * K, batch_id);
+}
+
 template <typename T, int MAX_K>
 void topK_softMax_kernelLauncher(const T* log_probs, const T* bias, const FinishedState* finished, float* cum_log_probs,
     void* temp_storage, const int temp_storage_size, BeamHypotheses& beam_hyps, cudaStream_t stream)
@@ -842,6 +1089,26 @@ void topK_softMax_kernelLauncher(const T* log_probs, const T* bias, const Finish
     T* topk_tmp_val_buf = reinterpret_cast<T*>(topk_tmp_id_buf + topk_buf_offset);
     float* tmp_buffer = reinterpret_cast<float*>(topk_tmp_val_buf + topk_buf_offset);
 
+    // With enough beams to fill the device, one CTA per beam avoids the staging buffer of the split path.
+    if (MAX_K >= FUSED_TOP_K_SOFTMAX_MIN_K && batch_size * beam_width >= getMultiProcessorCount())
+    {
+        int* beam_counters = reinterpret_cast<int*>(tmp_buffer);
+        TLLM_CUDA_CHECK(cudaMemsetAsync(beam_counters, 0, sizeof(int) * batch_size, stream));
+
+        const int smem_size_batch_topk = sizeof(T) * beam_width * beam_width * 2;
+        if (smem_size_batch_topk >= (48 << 10))
+        {
+            TLLM_CUDA_CHECK(cudaFuncSetAttribute(
+                beam_online_softmax_topk_fused_kernel<T, MAX_K, FUSED_TOP_K_SOFTMAX_THREADBLOCK_SIZE>,
+                cudaFuncAttributeMaxDynamicSharedMemorySize, smem_size_batch_topk));
+        }
+        beam_online_softmax_topk_fused_kernel<T, MAX_K, FUSED_TOP_K_SOFTMAX_THREADBLOCK_SIZE>
+            <<<batch_size * beam_width, FUSED_TOP_K_SOFTMAX_THREADBLOCK_SIZE, smem_size_batch_topk, stream>>>(
+                log_probs, bias, finished, cum_log_probs, topk_tmp_id_buf, topk_tmp_val_buf, beam_counters, beam_hyps);
+        sync_check_cuda_error();
+        return;
+    }
+
 #ifdef DO_SPLIT_SMALL_TOP_K_SOFTMAX
     // First, we query the occupancy assuming we need no smem. The goal of this heuristic is to simply run
     // at max occupancy.
@@ -27,32 +27,17 @@ namespace tensorrt_llm::kernels::parallel_decoding
 
 static constexpr int kUpdateKVCacheKernelShmSize = 16384;
 
-template <typename KVCacheBuffer, int MaxLayerCount, typename MoveEltType>
-__global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheBuffer, MaxLayerCount> kvCacheBuffers,
-    const int* seqAcceptedDraftTokenOffsets, const IndexType* packedAcceptedDraftTokensIndices,
-    const int32_t* pastKeyValueLengths, int rewindDraftTokenCommonCount, const int* rewindDraftTokenSeparateAdjustments,
-    int eltCountPerHead)
+//! \brief Moves the KV of the tokens at tokenStartIdx + srcTokenIndices[i] to tokenStartIdx + i for one head.
+//! \details All tokens of a chunk of channels are loaded to shared memory before any is stored, so source and
+//! destination ranges may overlap.
+template <typename KVCacheBuffer, typename MoveEltType>
+__device__ void moveDraftTokensKV(KVCacheBuffer& kvCacheBuffer, int seqIdx, int headIdx, int tokenStartIdx,
+    const IndexType* srcTokenIndices, int tokenCount, int eltCountPerHead)
 {
-    int seqIdx = blockIdx.x;
-    int headIdx = blockIdx.y;
-    int layerIdx = blockIdx.z;
     int warpIdx = threadIdx.x / 32;
     int warpCount = blockDim.x / 32;
     int laneIdx = threadIdx.x & 0x1f;
-    int seqDraftTokenStart = seqAcceptedDraftTokenOffsets[seqIdx];
-    int seqDraftTokenEnd = seqAcceptedDraftTokenOffsets[seqIdx + 1];
-    int seqDraftCount = seqDraftTokenEnd - seqDraftTokenStart;
-    if (seqDraftCount == 0)
-    {
-        return;
-    }
-    KVCacheBuffer& kvCacheBuffer = kvCacheBuffers[layerIdx];
-    int tokenStartIdx = pastKeyValueLengths[seqIdx] - rewindDraftTokenCommonCount;
-    if (rewindDraftTokenSeparateAdjustments != nullptr)
-    {
-        tokenStartIdx -= rewindDraftTokenSeparateAdjustments[seqIdx];
-    }
-    int maxEltCountPerMove = kUpdateKVCacheKernelShmSize / sizeof(MoveEltType) / seqDraftCount;
+    int maxEltCountPerMove = kUpdateKVCacheKernelShmSize / sizeof(MoveEltType) / tokenCount;
     int eltCountPerMove = min(maxEltCountPerMove, eltCountPerHead);
     __shared__ char loadSmemBuffer[kUpdateKVCacheKernelShmSize];
     auto* eltLoadSmemBuffer = reinterpret_cast<MoveEltType*>(&loadSmemBuffer[0]);
@@ -60,22 +45,23 @@ __global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheB
     {
         int eltCountCurrentMove = min(eltCountPerMove, eltCountPerHead - startChannelOffset);
         // load K
-        for (int tokenIdx = warpIdx; tokenIdx < seqDraftCount; tokenIdx += warpCount)
+        for (int tokenIdx = warpIdx; tokenIdx < tokenCount; tokenIdx += warpCount)
         {
-            int tokenPos = packedAcceptedDraftTokensIndices[seqDraftTokenStart + tokenIdx];
+            int tokenPos = srcTokenIndices[tokenIdx];
             auto* tokenSmemBuffer = eltLoadSmemBuffer + tokenIdx * eltCountCurrentMove;
             int tokenKVPosition = tokenStartIdx + tokenPos;
             auto* kPtr = reinterpret_cast<MoveEltType*>(kvCacheBuffer.getKBlockPtr(seqIdx, tokenKVPosition));
             for (int loadChannelIdx = laneIdx; loadChannelIdx < eltCountCurrentMove; loadChannelIdx += 32)
             {
                 int channelIdx = loadChannelIdx + startChannelOffset;
-                int kvLocationIdx = kvCacheBuffer.getKVLocalIdx(tokenKVPosition, headIdx, eltCountPerHead, channelIdx);
+                int kvLocationIdx = kvCacheBuffer.template getKLocalIdx<MoveEltType>(
+                    tokenKVPosition, headIdx, eltCountPerHead, channelIdx);
                 tokenSmemBuffer[loadChannelIdx] = kPtr[kvLocationIdx];
             }
         }
         __syncthreads();
         // store K
-        for (int tokenIdx = warpIdx; tokenIdx < seqDraftCount; tokenIdx += warpCount)
+        for (int tokenIdx = warpIdx; tokenIdx < tokenCount; tokenIdx += warpCount)
         {
             int tokenPos = tokenIdx;
             auto* tokenSmemBuffer = eltLoadSmemBuffer + tokenIdx * eltCountCurrentMove;
@@ -84,15 +70,16 @@ __global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheB
             for (int loadChannelIdx = laneIdx; loadChannelIdx < eltCountCurrentMove; loadChannelIdx += 32)
             {
                 int channelIdx = loadChannelIdx + startChannelOffset;
-                int kvLocationIdx = kvCacheBuffer.getKVLocalIdx(tokenKVPosition, headIdx, eltCountPerHead, channelIdx);
+                int kvLocationIdx = kvCacheBuffer.template getKLocalIdx<MoveEltType>(
+                    tokenKVPosition, headIdx, eltCountPerHead, channelIdx);
                 kPtr[kvLocationIdx] = tokenSmemBuffer[loadChannelIdx];
             }
         }
         __syncthreads();
         // load V
-        for (int tokenIdx = warpIdx; tokenIdx < seqDraftCount; tokenIdx += warpCount)
+        for (int tokenIdx = warpIdx; tokenIdx < tokenCount; tokenIdx += warpCount)
         {
-            int tokenPos = packedAcceptedDraftTokensIndices[seqDraftTokenStart + tokenIdx];
+            int tokenPos = srcTokenIndices[tokenIdx];
             auto* tokenSmemBuffer = eltLoadSmemBuffer + tokenIdx * eltCountCurrentMove;
             int tokenKVPosition = tokenStartIdx + tokenPos;
             auto* vPtr = reinterpret_cast<MoveEltType*>(kvCacheBuffer.getVBlockPtr(seqIdx, tokenKVPosition));
@@ -105,7 +92,7 @@ __global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheB
         }
         __syncthreads();
         // store V
-        for (int tokenIdx = warpIdx; tokenIdx < seqDraftCount; tokenIdx += warpCount)
+        for (int tokenIdx = warpIdx; tokenIdx < tokenCount; tokenIdx += warpCount)
         {
             int tokenPos = tokenIdx;
             auto* tokenSmemBuffer = eltLoadSmemBuffer + tokenPos * eltCountCurrentMove;
@@ -122,6 +109,32 @@ __global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheB
     }
 }
 
+template <typename KVCacheBuffer, int MaxLayerCount, typename MoveEltType>
+__global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheBuffer, MaxLayerCount> kvCacheBuffers,
+    const int* seqAcceptedDraftTokenOffsets, const IndexType* packedAcceptedDraftTokensIndices,
+    const int32_t* pastKeyValueLengths, int rewindDraftTokenCommonCount, const int* rewindDraftTokenSeparateAdjustments,
+    int eltCountPerHead)
+{
+    int seqIdx = blockIdx.x;
+    int headIdx = blockIdx.y;
+    int layerIdx = blockIdx.z;
+    int seqDraftTokenStart = seqAcceptedDraftTokenOffsets[seqIdx];
+    int seqDraftTokenEnd = seqAcceptedDraftTokenOffsets[seqIdx + 1];
+    int seqDraftCount = seqDraftTokenEnd - seqDraftTokenStart;
+    if (seqDraftCount == 0)
+    {
+        return;
+    }
+    KVCacheBuffer& kvCacheBuffer = kvCacheBuffers[layerIdx];
+    int tokenStartIdx = pastKeyValueLengths[seqIdx] - rewindDraftTokenCommonCount;
+    if (rewindDraftTokenSeparateAdjustments != nullptr)
+    {
+        tokenStartIdx -= rewindDraftTokenSeparateAdjustments[seqIdx];
+    }
+    moveDraftTokensKV<KVCacheBuffer, MoveEltType>(kvCacheBuffer, seqIdx, headIdx, tokenStartIdx,
+        packedAcceptedDraftTokensIndices + seqDraftTokenStart, seqDraftCount, eltCountPerHead);
+}
+
 template <typename KVCacheBuffer, int MaxLayerCount>
 void updateKVCacheDraftTokenLocationBatched(const KVCacheBuffer* kvCacheBuffers,
     const int* seqAcceptedDraftTokenOffsets, const IndexType* packedAcceptedDraftTokensIndices,
@@ -299,4 +312,168 @@ void updateKVBlockArrayDraftTokenLocationSeparateRewind(const int* seqAcceptedDr
         rewindDraftTokenCounts, maxKVCacheLen, maxBlocksPerSeq, tokensPerBlock, stream);
 }
 
+template <typename KVCacheBuffer, int MaxLayerCount, typename MoveEltType>
+__global__ void acceptDraftTokensAndUpdateKVCacheKernel(std::array<KVCacheBuffer, MaxLayerCount> kvCacheBuffers,
+    AcceptDraftTokensParams params, int eltCountPerHead, bool updateOutputs)
+{
+    int seqIdx = blockIdx.x;
+    int headIdx = blockIdx.y;
+    int layerIdx = blockIdx.z;
+    int batchSlot = params.batchSlots == nullptr ? seqIdx : params.batchSlots[seqIdx];
+
+    __shared__ int bestPathKey;
+    __shared__ IndexType acceptedIndices[kMaxAcceptedPathLen];
+    if (threadIdx.x == 0)
+    {
+        bestPathKey = 0;
+    }
+    __syncthreads();
+
+    // One thread per path, the longest match wins and ties go to the lowest path index.
+    auto const* draftIds = params.draftIds + batchSlot * params.maxDraftTokens;
+    auto const* targetIds = params.targetIds + batchSlot * (params.maxDraftTokens + 1);
+    auto const* paths = params.paths + batchSlot * params.maxNumPaths * params.maxPathLen;
+    for (int pathIdx = threadIdx.x; pathIdx < params.maxNumPaths; pathIdx += blockDim.x)
+    {
+        auto const* path = paths + pathIdx * params.maxPathLen;
+        int acceptedLen = 0;
+        int prevTargetIdx = 0;
+        while (acceptedLen < params.maxPathLen && path[acceptedLen] >= 0
+            && draftIds[path[acceptedLen]] == targetIds[prevTargetIdx])
+        {
+            prevTargetIdx = path[acceptedLen] + 1;
+            ++acceptedLen;
+        }
+        atomicMax(&bestPathKey, (acceptedLen << 16) | (0xffff - pathIdx));
+    }
+    __syncthreads();
+
+    int const acceptedLen = bestPathKey >> 16;
+    int const bestPathIdx = 0xffff - (bestPathKey & 0xffff);
+    auto const* bestPath = paths + bestPathIdx * params.maxPathLen;
+    for (int ti = threadIdx.x; ti < acceptedLen; ti += blockDim.x)
+    {
+        acceptedIndices[ti] = bestPath[ti];
+    }
+    __syncthreads();
+
+    if (updateOutputs && headIdx == 0 && layerIdx == 0)
+    {
+        int const sequenceLength = params.sequenceLengths[batchSlot];
+        auto* outputIds = params.outputIds + batchSlot * params.maxSeqLen + sequenceLength;
+        int const numNewTokens = min(acceptedLen + 1, params.maxSeqLen - sequenceLength);
+        for (int ti = threadIdx.x; ti < numNewTokens; ti += blockDim.x)
+        {
+            outputIds[ti] = ti < acceptedLen ? draftIds[acceptedIndices[ti]]
+                                             : targetIds[acceptedLen > 0 ? acceptedIndices[acceptedLen - 1] + 1 : 0];
+        }
+        if (threadIdx.x == 0)
+        {
+            params.sequenceLengths[batchSlot] = sequenceLength + numNewTokens;
+            if (params.numAcceptedTokens != nullptr)
+            {
+                params.numAcceptedTokens[batchSlot] = acceptedLen;
+            }
+        }
+    }
+
+    if (acceptedLen == 0)
+    {
+        return;
+    }
+    moveDraftTokensKV<KVCacheBuffer, MoveEltType>(kvCacheBuffers[layerIdx], seqIdx, headIdx,
+        params.pastKeyValueLengths[seqIdx], acceptedIndices, acceptedLen, eltCountPerHead);
+}
+
+template <typename KVCacheBuffer, int MaxLayerCount>
+void acceptDraftTokensAndUpdateKVCacheBatched(AcceptDraftTokensParams const& params,
+    const KVCacheBuffer* kvCacheBuffers, int layerCount, int seqCount, int numKVHeads, int sizeInBytesPerKVHead,
+    bool updateOutputs, cudaStream_t stream)
+{
+    static_assert(MaxLayerCount * sizeof(KVCacheBuffer) + sizeof(AcceptDraftTokensParams) <= 3072);
+    int alignedBytes = 16;
+    while (alignedBytes > 0 && (sizeInBytesPerKVHead % alignedBytes != 0))
+    {
+        alignedBytes >>= 1;
+    }
+    TLLM_CHECK_WITH_INFO(alignedBytes > 0, "alignedByte should be positive");
+    int eltCountPerHead = sizeInBytesPerKVHead / alignedBytes;
+    dim3 grid(seqCount, numKVHeads, layerCount);
+    dim3 block(128, 1, 1);
+    std::array<KVCacheBuffer, MaxLayerCount> kvCacheBufferArray;
+    for (int i = 0; i < layerCount; i++)
+    {
+        kvCacheBufferArray[i] = kvCacheBuffers[i];
+    }
+    void (*pKernelFunc)(std::array<KVCacheBuffer, MaxLayerCount>, AcceptDraftTokensParams, int, bool) = nullptr;
+    switch (alignedBytes)
+    {
+    case 16: pKernelFunc = &acceptDraftTokensAndUpdateKVCacheKernel<KVCacheBuffer, MaxLayerCount, int4>; break;
+    case 8: pKernelFunc = &acceptDraftTokensAndUpdateKVCacheKernel<KVCacheBuffer, MaxLayerCount, int64_t>; break;
+    case 4: pKernelFunc = &acceptDraftTokensAndUpdateKVCacheKernel<KVCacheBuffer, MaxLayerCount, int32_t>; break;
+    case 2: pKernelFunc = &acceptDraftTokensAndUpdateKVCacheKernel<KVCacheBuffer, MaxLayerCount, int16_t>; break;
+    default:
+        TLLM_CHECK_WITH_INFO(alignedBytes == 1, "Strange alignedBytes");
+        pKernelFunc = &acceptDraftTokensAndUpdateKVCacheKernel<KVCacheBuffer, MaxLayerCount, int8_t>;
+        break;
+    }
+    pKernelFunc<<<grid, block, 0, stream>>>(kvCacheBufferArray, params, eltCountPerHead, updateOutputs);
+    TLLM_CUDA_CHECK(cudaGetLastError());
+}
+
+template <typename KVCacheBuffer>
+void acceptDraftTokensAndUpdateKVCache(AcceptDraftTokensParams const& params, const KVCacheBuffer* kvCacheBuffers,
+    int layerCount, int seqCount, int numKVHeads, int sizeInBytesPerKVHead, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.maxPathLen <= kMaxAcceptedPathLen,
+        "Draft paths longer than %d tokens are not supported", kMaxAcceptedPathLen);
+    TLLM_CHECK_WITH_INFO(params.maxNumPaths <= 0xffff, "More than 65535 draft paths are not supported");
+    if (seqCount == 0 || layerCount == 0)
+    {
+        return;
+    }
+    int startLayer = 0;
+    static constexpr int kMaxLayersPerIter = 32;
+    while (startLayer < layerCount)
+    {
+        int microBatchLayerCount = std::min(layerCount - startLayer, kMaxLayersPerIter);
+        // The acceptance is recomputed by every launch, outputs are only written by the first one.
+        acceptDraftTokensAndUpdateKVCacheBatched<KVCacheBuffer, kMaxLayersPerIter>(params,
+            kvCacheBuffers + startLayer, microBatchLayerCount, seqCount, numKVHeads, sizeInBytesPerKVHead,
+            startLayer == 0, stream);
+        startLayer += microBatchLayerCount;
+    }
+}
+
+void acceptDraftTokensAndUpdateLinearKVCache(AcceptDraftTokensParams const& params, int8_t* const* pastKeyValueList,
+    int layerCount, int seqCount, int numKVHeads, int sizeInBytesPerKVHead, int maxKVCacheLen, cudaStream_t stream)
+{
+    std::vector<KVLinearBuffer> kvLinearBuffers;
+    kvLinearBuffers.reserve(layerCount);
+    int sizePerToken = numKVHeads * sizeInBytesPerKVHead;
+    for (int i = 0; i < layerCount; i++)
+    {
+        kvLinearBuffers.emplace_back(seqCount, 0, maxKVCacheLen, sizePerToken, maxKVCacheLen, 0, false);
+        kvLinearBuffers.back().data = pastKeyValueList[i];
+    }
+    acceptDraftTokensAndUpdateKVCache(
+        params, kvLinearBuffers.data(), layerCount, seqCount, numKVHeads, sizeInBytesPerKVHead, stream);
+}
+
+void acceptDraftTokensAndUpdateKVBlockArray(AcceptDraftTokensParams const& params, int64_t* const* pointerArray,
+    int layerCount, int seqCount, int numKVHeads, int sizeInBytesPerKVHead, int maxKVCacheLen, int maxBlocksPerSeq,
+    int tokensPerBlock, cudaStream_t stream)
+{
+    std::vector<KVBlockArray> kvBlockArrays;
+    kvBlockArrays.reserve(layerCount);
+    int sizePerToken = numKVHeads * sizeInBytesPerKVHead;
+    for (int i = 0; i < layerCount; i++)
+    {
+        kvBlockArrays.emplace_back(seqCount, maxBlocksPerSeq, tokensPerBlock, sizePerToken, maxKVCacheLen, 0, false);
+        kvBlockArrays.back().data = pointerArray[i];
+    }
+    acceptDraftTokensAndUpdateKVCache(
+        params, kvBlockArrays.data(), layerCount, seqCount, numKVHeads, sizeInBytesPerKVHead, stream);
+}
+
 } // namespace tensorrt_llm::kernels::parallel_decoding
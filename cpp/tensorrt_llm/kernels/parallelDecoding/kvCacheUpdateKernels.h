@@ -164,4 +164,70 @@ void updateKVBlockArrayDraftTokenLocation(const int* seqAcceptedDraftTokenOffset
     int* rewindDraftTokenSeparateAdjustments, int maxKVCacheLen, int maxBlocksPerSeq, int tokensPerBlock,
     cudaStream_t stream);
 
+//! \brief Device buffers of acceptDraftTokensAndUpdate*, batch slots index the decoder buffers and the position in
+//! the batch indexes the KV cache.
+struct AcceptDraftTokensParams
+{
+    // [maxBatchSize, maxDraftTokens] draft tokens, linear drafts or the nodes of a tree
+    const int32_t* draftIds;
+    // [maxBatchSize, maxDraftTokens + 1] target tokens, entry 0 follows the last accepted token and entry i + 1
+    // follows draft token i
+    const int32_t* targetIds;
+    // [maxBatchSize, maxNumPaths, maxPathLen] draft token indices of the candidate paths, padded with -1.
+    // Linear drafts have the single path [0, 1, ..., numDraftTokens - 1]
+    const int32_t* paths;
+    // [seqCount] position of draft token 0 in the KV cache of each sequence
+    const int32_t* pastKeyValueLengths;
+    // [seqCount] batch slot of each sequence, nullptr if the slots are 0 ... seqCount - 1
+    const int32_t* batchSlots;
+    // [maxBatchSize, maxSeqLen] receives the accepted tokens and the target token after them
+    int32_t* outputIds;
+    // [maxBatchSize] advanced by the number of accepted tokens plus one, must not alias pastKeyValueLengths
+    int32_t* sequenceLengths;
+    // [maxBatchSize] optional, receives the number of accepted draft tokens
+    int32_t* numAcceptedTokens;
+    int32_t maxDraftTokens;
+    int32_t maxNumPaths;
+    int32_t maxPathLen;
+    int32_t maxSeqLen;
+};
+
+//! \brief Longest paths accepted by a single kernel, bounds the shared memory of the accepted indices.
+static constexpr int kMaxAcceptedPathLen = 64;
+
+/*!
+ * Accept draft tokens and compact their KV in one launch per 32 layers, driven only by device state.
+ * Every thread block recomputes the longest path of its sequence whose draft tokens match the target tokens, the
+ * blocks of the first head and layer write the accepted tokens and sequence lengths, and all blocks move the KV of
+ * the accepted tokens of their head and layer to the positions following the past KV. No offsets are exchanged
+ * through the host.
+ * @param params : Acceptance buffers, see AcceptDraftTokensParams.
+ * @param pastKeyValueList : Past key value list, which is the pointer array of each KVLinear cache.
+ * @param layerCount : Count of layers
+ * @param seqCount : Count of sequence
+ * @param numKVHeads : Number of KV heads
+ * @param sizeInBytesPerKVHead : Size of each KV head
+ * @param maxKVCacheLen : Maximum length of each KV cache
+ * @param stream : CUDA stream to use.
+ */
+void acceptDraftTokensAndUpdateLinearKVCache(AcceptDraftTokensParams const& params, int8_t* const* pastKeyValueList,
+    int layerCount, int seqCount, int numKVHeads, int sizeInBytesPerKVHead, int maxKVCacheLen, cudaStream_t stream);
+
+/*!
+ * Block KV cache version of acceptDraftTokensAndUpdateLinearKVCache.
+ * @param params : Acceptance buffers, see AcceptDraftTokensParams.
+ * @param pointerArray : Pointer array of each Block KV cache.
+ * @param layerCount : Count of layers
+ * @param seqCount : Count of sequence
+ * @param numKVHeads : Number of KV heads
+ * @param sizeInBytesPerKVHead : Size of each KV head
+ * @param maxKVCacheLen : Maximum length of each KV cache
+ * @param maxBlocksPerSeq : Maximum blocks per sequence of Block KV cache.
+ * @param tokensPerBlock : Tokens per block of Block KV cache
+ * @param stream : CUDA stream to use.
+ */
+void acceptDraftTokensAndUpdateKVBlockArray(AcceptDraftTokensParams const& params, int64_t* const* pointerArray,
+    int layerCount, int seqCount, int numKVHeads, int sizeInBytesPerKVHead, int maxKVCacheLen, int maxBlocksPerSeq,
+    int tokensPerBlock, cudaStream_t stream);
+
 } // namespace tensorrt_llm::kernels::parallel_decoding
@@ -20,6 +20,7 @@
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/banBadWordsUtils.h"
 #include "tensorrt_llm/kernels/penaltyKernels.h"
 
 using namespace tensorrt_llm::common;
@@ -35,10 +36,16 @@ __global__ void batchApplyPenalty(T const* const* inputLogits, T* outputLogits,
     float const* repetitionPenalties, float const* presencePenalties, float const* frequencyPenalties,
     const bool accumulateVocab, int32_t const maxSeqLen, int32_t const vocabSize, int32_t const vocabSizePadded,
     int32_t const** outputIdsPtr, int32_t const** parentIdsPtr, int32_t const* inputLengths,
-    int32_t const* sequenceLengths, int32_t const* minLengths, int32_t const* endIds, int32_t const* batchSlots)
+    int32_t const* sequenceLengths, int32_t const* minLengths, int32_t const* endIds, int32_t const* batchSlots,
+    int32_t const** badWordsPtr, int32_t const* badWordsLengths, TokenCounts tokenCounts, float const* logitsSoftCaps,
+    AllowedTokens allowedTokens, ActiveSlots activeSlots)
 {
     int32_t const beamWidth = gridDim.y;
-    int32_t const batchIdx = blockIdx.x;
+    int32_t batchIdx = blockIdx.x;
+    if (!activeSlots.map(batchIdx))
+    {
+        return;
+    }
     int32_t const beamIdx = blockIdx.y;
     int32_t const batchSlot = batchSlots == nullptr ? batchIdx : batchSlots[batchIdx];
     int32_t const batchBeamIdx = batchIdx * beamWidth + beamIdx;
@@ -46,8 +53,41 @@ __global__ void batchApplyPenalty(T const* const* inputLogits, T* outputLogits,
     int32_t const inputLen = inputLengths == nullptr ? 0 : inputLengths[batchSlotBeamIdx];
     int32_t const currentStep = sequenceLengths == nullptr ? 0 : sequenceLengths[batchSlotBeamIdx];
     T const* biasBase = biases + batchSlot * vocabSizePadded;
+    bool const sparseCounts = accumulateVocab && tokenCounts.isEnabled();
+    int32_t* uniqueTokens{nullptr};
+    int32_t* numUniqueTokens{nullptr};
+    if (sparseCounts)
+    {
+        penaltyWorkspace = tokenCounts.counts + batchSlot * vocabSize;
+        uniqueTokens = tokenCounts.uniqueTokens + batchSlot * vocabSize;
+        numUniqueTokens = tokenCounts.numUniqueTokens + batchSlot;
+        if (currentStep <= inputLen)
+        { // Context phase, only the tokens of the previous request in this slot have to be cleared
+            int32_t const numPrevUniqueTokens = *numUniqueTokens;
+            for (int32_t index = threadIdx.x; index < numPrevUniqueTokens; index += blockDim.x)
+            {
+                penaltyWorkspace[uniqueTokens[index]] = 0;
+            }
+            __syncthreads();
+            if (threadIdx.x == 0)
+            {
+                *numUniqueTokens = 0;
+            }
+            __syncthreads();
+            for (int32_t step = threadIdx.x; step < inputLen; step += blockDim.x)
+            {
+                int32_t penaltyIndex = outputIdsPtr[batchSlot][step];
+                if (penaltyIndex < vocabSize && atomicAdd(&penaltyWorkspace[penaltyIndex], 1) == 0)
+                {
+                    uniqueTokens[atomicAdd(numUniqueTokens, 1)] = penaltyIndex;
+                }
+            }
+            __syncthreads();
+        }
+        // Generation phase, the last token has already been counted by invokeCopyNextStepIds
+    }
     // Initialize or update the number of occurrences of tokens
-    if (accumulateVocab)
+    else if (accumulateVocab)
     {
         penaltyWorkspace += batchBeamIdx * vocabSize;
         if (currentStep <= inputLen)
@@ -95,6 +135,8 @@ __global__ void batchApplyPenalty(T const* const* inputLogits, T* outputLogits,
     auto outLogitsPtr = outputLogits + batchBeamIdx * vocabSizePadded;
     const T MASK_VAL = (std::is_same<T, half>::value) ? -HALF_FLT_MAX : -FLT_MAX;
     float invTemperature, repetitionPenalty, presencePenalty, frequencyPenalty;
+    float const logitsSoftCap = logitsSoftCaps == nullptr ? 0.0f : logitsSoftCaps[batchSlot];
+    int32_t const numAllowedTokens = allowedTokens.isEnabled() ? allowedTokens.numTokens[batchSlot] : 0;
     if (temperatures != nullptr)
     {
         invTemperature = 1.0f / (temperatures[batchSlot] + 1e-6f);
@@ -111,46 +153,83 @@ __global__ void batchApplyPenalty(T const* const* inputLogits, T* outputLogits,
     {
         frequencyPenalty = frequencyPenalties[batchSlot];
     }
-    for (int32_t index = threadIdx.x; index < vocabSizePadded; index += blockDim.x)
+    auto applyPenalties = [&](int32_t index, int32_t numOccurences)
     {
-        if (index < vocabSize)
+        float logit = (float) inLogitsPtr[index];
+        // Bias
+        if (biases != nullptr)
+        {
+            logit += (float) biasBase[index];
+        }
+        // Soft-capping
+        if (logitsSoftCap > 0.0f)
         {
-            float logit = (float) inLogitsPtr[index];
-            // Bias
-            if (biases != nullptr)
+            logit = logitsSoftCap * tanhf(logit / logitsSoftCap);
+        }
+        // Temperature
+        if (temperatures != nullptr)
+        {
+            logit *= invTemperature;
+        }
+        if (numOccurences > 0)
+        {
+            // Repetition
+            if (repetitionPenalties != nullptr)
             {
-                logit += (float) biasBase[index];
+                logit = logit < 0.0f ? logit * repetitionPenalty : logit / repetitionPenalty;
             }
-            // Temperature
-            if (temperatures != nullptr)
+            // Presence
+            if (presencePenalties != nullptr)
             {
-                logit *= invTemperature;
+                logit -= presencePenalty;
             }
-            int32_t numOccurences = penaltyWorkspace[index];
-            if (numOccurences > 0)
+            // Frequency
+            if (frequencyPenalties != nullptr)
             {
-                // Repetition
-                if (repetitionPenalties != nullptr)
-                {
-                    logit = logit < 0.0f ? logit * repetitionPenalty : logit / repetitionPenalty;
-                }
-                // Presence
-                if (presencePenalties != nullptr)
-                {
-                    logit -= presencePenalty;
-                }
-                // Frequency
-                if (frequencyPenalties != nullptr)
-                {
-                    logit -= frequencyPenalty * numOccurences;
-                }
+                logit -= frequencyPenalty * numOccurences;
             }
-            outLogitsPtr[index] = logit;
         }
-        else
+        outLogitsPtr[index] = logit;
+    };
+    if (numAllowedTokens > 0)
+    {
+        // Gather only the allowed tokens, all others are masked
+        for (int32_t index = threadIdx.x; index < vocabSizePadded; index += blockDim.x)
         {
             outLogitsPtr[index] = MASK_VAL;
         }
+        __syncthreads();
+        auto const* slotAllowedTokens = allowedTokens.tokens + batchSlot * allowedTokens.maxNumTokens;
+        for (int32_t index = threadIdx.x; index < numAllowedTokens; index += blockDim.x)
+        {
+            auto const tokenId = slotAllowedTokens[index];
+            applyPenalties(tokenId, accumulateVocab ? penaltyWorkspace[tokenId] : 0);
+        }
+    }
+    else
+    {
+        for (int32_t index = threadIdx.x; index < vocabSizePadded; index += blockDim.x)
+        {
+            if (index < vocabSize)
+            {
+                applyPenalties(index, sparseCounts || !accumulateVocab ? 0 : penaltyWorkspace[index]);
+            }
+            else
+            {
+                outLogitsPtr[index] = MASK_VAL;
+            }
+        }
+    }
+    if (sparseCounts && numAllowedTokens == 0)
+    {
+        __syncthreads();
+        // Penalize only the tokens that appeared, their logits are recomputed to keep the same rounding
+        int32_t const numUnique = *numUniqueTokens;
+        for (int32_t index = threadIdx.x; index < numUnique; index += blockDim.x)
+        {
+            auto const tokenId = uniqueTokens[index];
+            applyPenalties(tokenId, penaltyWorkspace[tokenId]);
+        }
     }
     if (minLengths != nullptr)
     {
@@ -161,19 +240,39 @@ __global__ void batchApplyPenalty(T const* const* inputLogits, T* outputLogits,
             outLogitsPtr[endIds[batchSlot]] = MASK_VAL;
         }
     }
+    if (badWordsPtr != nullptr)
+    {
+        __syncthreads();
+        // Bad words
+        auto const badWordsLen = badWordsLengths[batchSlot];
+        auto const* parentIds = beamWidth > 1 && parentIdsPtr != nullptr ? parentIdsPtr[batchSlot] : nullptr;
+        for (int32_t wordIdx = threadIdx.x; wordIdx < badWordsLen; wordIdx += blockDim.x)
+        {
+            auto const bannedToken = getBannedToken(badWordsPtr[batchSlot], badWordsLen, wordIdx,
+                outputIdsPtr[batchSlot], parentIds, beamIdx, beamWidth, currentStep, maxSeqLen);
+            if (0 <= bannedToken && bannedToken < vocabSizePadded)
+            {
+                outLogitsPtr[bannedToken] = static_cast<T>(-INFINITY);
+            }
+        }
+    }
 }
 
 template <typename T>
 void invokeBatchApplyPenalty(const InvokeBatchApplyPenaltyParams<T>& params)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(!params.tokenCounts.isEnabled() || params.beamWidth == 1,
+        "Sparse token counts are only supported with beam width 1");
     dim3 block(256);
     dim3 grid(params.batchSize, params.beamWidth);
     batchApplyPenalty<T><<<grid, block, 0, params.stream>>>(params.inputLogits, params.outputLogits, params.biases,
         params.penaltyWorkspace, params.penaltyWorkspacePrev, params.temperatures, params.repetitionPenalties,
         params.presencePenalties, params.frequencyPenalties, params.accumulateVocab, params.maxSeqLen, params.vocabSize,
         params.vocabSizePadded, params.outputIdsPtr, params.parentIdsPtr, params.inputLengths, params.sequenceLengths,
-        params.minLengths, params.endIds, params.batchSlots);
+        params.minLengths, params.endIds, params.batchSlots,
+        params.maxBadWordsLen > 0 ? params.badWordsPtr : nullptr, params.badWordsLengths, params.tokenCounts,
+        params.logitsSoftCaps, params.allowedTokens, params.activeSlots);
 }
 
 template void invokeBatchApplyPenalty(const InvokeBatchApplyPenaltyParams<float>& params);
@@ -18,6 +18,7 @@
 #include <cuda_fp16.h>
 
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
 #include "tensorrt_llm/kernels/penaltyTypes.h"
 
 namespace tensorrt_llm
@@ -25,6 +26,36 @@ namespace tensorrt_llm
 namespace kernels
 {
 
+//! \brief Sparse per slot histogram of the tokens for the repetition, presence and frequency penalties.
+//! The prompt is counted once when the request starts, generated tokens are added by invokeCopyNextStepIds, so the
+//! per step cost does not depend on the sequence length and penalties are only applied to tokens that appeared.
+struct TokenCounts
+{
+    int32_t* counts{nullptr};          // [maxBatchSize, vocabSize], occurrences of every token, zero initialized
+    int32_t* uniqueTokens{nullptr};    // [maxBatchSize, vocabSize], tokens with non-zero count in order of appearance
+    int32_t* numUniqueTokens{nullptr}; // [maxBatchSize], number of valid entries in uniqueTokens, zero initialized
+    int32_t vocabSize{0};
+
+    [[nodiscard]] __host__ __device__ bool isEnabled() const
+    {
+        return uniqueTokens != nullptr;
+    }
+};
+
+//! \brief Per slot subset of the vocabulary a request may generate, e.g. the labels of a classifier.
+//! Only the allowed tokens are gathered and penalized, all other logits are masked in the same pass.
+struct AllowedTokens
+{
+    int32_t const* tokens{nullptr};    // [maxBatchSize, maxNumTokens], allowed token ids of every slot
+    int32_t const* numTokens{nullptr}; // [maxBatchSize], 0 allows the whole vocabulary
+    int32_t maxNumTokens{0};
+
+    [[nodiscard]] __host__ __device__ bool isEnabled() const
+    {
+        return numTokens != nullptr;
+    }
+};
+
 template <typename T>
 struct InvokeBatchApplyPenaltyParams
 {
@@ -51,6 +82,18 @@ struct InvokeBatchApplyPenaltyParams
     const int* endIds;
     const int* batchSlots;
     cudaStream_t stream;
+    // Optional bad words banned in the same pass, see invokeBanBadWords. Disabled if maxBadWordsLen is 0.
+    const int** badWordsPtr{nullptr};
+    const int* badWordsLengths{nullptr};
+    const int maxBadWordsLen{0};
+    // Optional sparse histogram used instead of penaltyWorkspace, beam width 1 only
+    TokenCounts tokenCounts{};
+    // Optional cap * tanh(logit / cap) applied to the biased logits before the penalties, disabled if cap is 0
+    const float* logitsSoftCaps{nullptr};
+    // Optional allowed tokens per slot
+    AllowedTokens allowedTokens{};
+    // Optional, the logits of the finished requests are left as they are
+    ActiveSlots activeSlots{};
 };
 
 template <typename T>
@@ -26,11 +26,12 @@ namespace kernels
 
 enum class DecodingPenaltyType
 {
-    Temperature, // the temperature penalty
-    Repetition,  // the repetition penalty
-    Presence,    // the presence penalty
-    Frequency,   // the frequency penalty
-    MinLength,   // the min length penalty
+    Temperature,   // the temperature penalty
+    Repetition,    // the repetition penalty
+    Presence,      // the presence penalty
+    Frequency,     // the frequency penalty
+    MinLength,     // the min length penalty
+    LogitsSoftCap, // the soft-capping of the logits
 };
 
 inline float getDefaultPenaltyValue(DecodingPenaltyType penalty_type)
@@ -42,6 +43,7 @@ inline float getDefaultPenaltyValue(DecodingPenaltyType penalty_type)
     case DecodingPenaltyType::Presence: return 0.0f;
     case DecodingPenaltyType::Frequency: return 0.0f;
     case DecodingPenaltyType::MinLength: return 1.0f;
+    case DecodingPenaltyType::LogitsSoftCap: return 0.0f;
     default: break;
     }
     return 0.0f;
@@ -35,31 +35,39 @@ __global__ void apply_per_channel_scale(
         return;
     act += row_offset * kProcessRows * cols;
     smoothed_act += row_offset * kProcessRows * cols;
-    *reinterpret_cast<AccessType*>(scale) = reinterpret_cast<const AccessType*>(per_channel_scale)[col_offset];
+    // Without a scale the kernel only converts the activations, e.g. to fp8 for W4A8 GEMMs.
+    const bool has_scale = per_channel_scale != nullptr;
+    if (has_scale)
+    {
+        *reinterpret_cast<AccessType*>(scale) = reinterpret_cast<const AccessType*>(per_channel_scale)[col_offset];
+    }
 #pragma unroll
     for (int i = 0; i < kProcessRows; ++i)
     {
         *reinterpret_cast<AccessType*>(act_vec) = reinterpret_cast<const AccessType*>(act + i * cols)[col_offset];
-        if constexpr ((std::is_same_v<T_in, half>
+        if (has_scale)
+        {
+            if constexpr ((std::is_same_v<T_in, half>
 #if (defined(__CUDA_ARCH__) && (__CUDA_ARCH__ >= 800) && defined(ENABLE_BF16))
-                          || std::is_same_v<T_in, __nv_bfloat16>
+                              || std::is_same_v<T_in, __nv_bfloat16>
 #endif
-                          ) &&(kElems % 2 == 0))
-        {
-            using Vec2 = typename Vec2Type<T_in>::type;
-#pragma unroll
-            for (int j = 0; j < kElems; j += 2)
+                              ) &&(kElems % 2 == 0))
             {
-                *reinterpret_cast<Vec2*>(act_vec + j)
-                    = __hmul2(*reinterpret_cast<Vec2*>(act_vec + j), *reinterpret_cast<Vec2*>(scale + j));
-            }
-        }
-        else
-        {
+                using Vec2 = typename Vec2Type<T_in>::type;
 #pragma unroll
-            for (int j = 0; j < kElems; ++j)
+                for (int j = 0; j < kElems; j += 2)
+                {
+                    *reinterpret_cast<Vec2*>(act_vec + j)
+                        = __hmul2(*reinterpret_cast<Vec2*>(act_vec + j), *reinterpret_cast<Vec2*>(scale + j));
+                }
+            }
+            else
             {
-                act_vec[j] = static_cast<T_in>(static_cast<float>(act_vec[j]) * static_cast<float>(scale[j]));
+#pragma unroll
+                for (int j = 0; j < kElems; ++j)
+                {
+                    act_vec[j] = static_cast<T_in>(static_cast<float>(act_vec[j]) * static_cast<float>(scale[j]));
+                }
             }
         }
         if constexpr (std::is_same_v<T_in, T_out>)
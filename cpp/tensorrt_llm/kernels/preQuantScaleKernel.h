@@ -33,6 +33,7 @@ namespace tensorrt_llm
 namespace kernels
 {
 
+// smoothed_act = act * per_channel_scale, converted to T_out. A null per_channel_scale only converts act.
 template <typename T_in, typename T_out = T_in>
 void apply_per_channel_scale_kernel_launcher(
     T_out* smoothed_act, const T_in* act, const T_in* per_channel_scale, int rows, int cols, cudaStream_t stream = 0);
@@ -91,17 +91,23 @@ template void invokeQuantization<half>(
 
 template <typename T>
 __global__ void perTokenQuantization(
-    int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols, float* scalePtr)
+    int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols, float* scalePtr, const float* smoothScale)
 {
     const T* srcRow = src + blockIdx.x * numCols;
     int8_t* dstRow = dst + blockIdx.x * numCols;
 
-    T localMax = 1e-6f;
+    auto loadScaled = [&](int i)
+    {
+        const float val = cuda_cast<float>(srcRow[i]);
+        return smoothScale != nullptr ? val * smoothScale[i] : val;
+    };
+
+    float localMax = 1e-6f;
     for (int i = threadIdx.x; i < numCols; i += blockDim.x)
     {
-        localMax = cuda_max(localMax, cuda_abs(srcRow[i]));
+        localMax = fmaxf(localMax, fabsf(loadScaled(i)));
     }
-    const float rowMax = blockAllReduceMax(cuda_cast<float>(localMax));
+    const float rowMax = blockAllReduceMax(localMax);
 
     if (threadIdx.x == 0)
     {
@@ -111,24 +117,24 @@ __global__ void perTokenQuantization(
     const float scaleOrigQuant = 127.f / rowMax;
     for (int i = threadIdx.x; i < numCols; i += blockDim.x)
     {
-        dstRow[i] = cuda_cast<int8_t>(cuda_cast<float>(srcRow[i]) * scaleOrigQuant);
+        dstRow[i] = cuda_cast<int8_t>(loadScaled(i) * scaleOrigQuant);
     }
 }
 
 template <typename T>
-void invokePerTokenQuantization(
-    int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols, float* scalePtr, cudaStream_t stream)
+void invokePerTokenQuantization(int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols,
+    float* scalePtr, const float* smoothScale, cudaStream_t stream)
 {
     // each block is responsible for a single row
     const dim3 block(512);
     const dim3 grid(numRows);
 
-    perTokenQuantization<<<grid, block, 0, stream>>>(dst, src, numRows, numCols, scalePtr);
+    perTokenQuantization<<<grid, block, 0, stream>>>(dst, src, numRows, numCols, scalePtr, smoothScale);
 }
 
 #define INSTANTIATE_INVOKE_PER_TOKEN_QUANTIZATION(T)                                                                   \
-    template void invokePerTokenQuantization(                                                                          \
-        int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols, float* scalePtr, cudaStream_t stream)
+    template void invokePerTokenQuantization(int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols,  \
+        float* scalePtr, const float* smoothScale, cudaStream_t stream)
 
 INSTANTIATE_INVOKE_PER_TOKEN_QUANTIZATION(float);
 INSTANTIATE_INVOKE_PER_TOKEN_QUANTIZATION(half);
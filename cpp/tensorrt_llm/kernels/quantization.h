@@ -27,9 +27,11 @@ template <typename T>
 void invokeQuantization(
     int8_t* dst, const T* src, const int64_t size, const float* scalePtr, cudaStream_t stream = 0, int maxGirdSize = 0);
 
+// smoothScale, if not null, is a [numCols] vector the activations are multiplied with before quantization, i.e. the
+// inverse of the SmoothQuant smoothing factors.
 template <typename T>
-void invokePerTokenQuantization(
-    int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols, float* scalePtr, cudaStream_t stream = 0);
+void invokePerTokenQuantization(int8_t* dst, const T* src, const int64_t numRows, const int64_t numCols,
+    float* scalePtr, const float* smoothScale = nullptr, cudaStream_t stream = 0);
 
 } // namespace kernels
 } // namespace tensorrt_llm
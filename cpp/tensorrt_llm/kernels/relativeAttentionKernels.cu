@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/relativeAttentionKernels.h"
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+// Tokens of K and V staged in shared memory at a time.
+constexpr int32_t kTileTokens = 16;
+// Each warp attends kQueriesPerWarp queries, so one thread block shares every K/V tile among
+// kWarpsPerBlock * kQueriesPerWarp consecutive tokens of one head of one sequence.
+constexpr int32_t kWarpsPerBlock = 8;
+constexpr int32_t kQueriesPerWarp = 4;
+constexpr int32_t kQueriesPerBlock = kWarpsPerBlock * kQueriesPerWarp;
+// The relative attention table of the head is staged in shared memory.
+constexpr int32_t kMaxNumBuckets = 256;
+
+// Same bucketing as addRelativeAttentionBiasUnaligned, relativePosition is the key position minus the query position.
+__device__ int32_t relativePositionBucket(
+    int32_t relativePosition, int32_t numBuckets, int32_t maxDistance, bool bidirectional)
+{
+    int32_t bucket = 0;
+    if (bidirectional)
+    {
+        numBuckets /= 2;
+        bucket += relativePosition > 0 ? numBuckets : 0;
+        relativePosition = abs(relativePosition);
+    }
+    else
+    {
+        relativePosition = relativePosition > 0 ? 0 : -relativePosition;
+    }
+    auto const maxExact = numBuckets / 2;
+    if (relativePosition < maxExact)
+    {
+        return bucket + relativePosition;
+    }
+    auto const logRatio = logf(relativePosition * 1.0f / maxExact) / logf(static_cast<float>(maxDistance) / maxExact);
+    auto const large = maxExact + static_cast<int32_t>(logRatio * (numBuckets - maxExact));
+    return bucket + min(large, numBuckets - 1);
+}
+
+template <typename T, int32_t HEAD_SIZE>
+__global__ void __launch_bounds__(kWarpsPerBlock * 32) relativeAttentionKernel(RelativeAttentionParams params)
+{
+    constexpr int32_t kEltsPerLane = HEAD_SIZE / 32;
+
+    __shared__ T kTile[kTileTokens][HEAD_SIZE];
+    __shared__ T vTile[kTileTokens][HEAD_SIZE];
+    __shared__ float biasTable[kMaxNumBuckets];
+
+    auto const warpIdx = static_cast<int32_t>(threadIdx.x) / 32;
+    auto const laneIdx = static_cast<int32_t>(threadIdx.x) % 32;
+    auto const headIdx = static_cast<int32_t>(blockIdx.y);
+    auto const batchIdx = static_cast<int32_t>(blockIdx.z);
+
+    auto const seqLength = params.seqLengths[batchIdx];
+    auto const firstToken = params.seqOffsets != nullptr ? params.seqOffsets[batchIdx] : batchIdx * params.maxSeqLength;
+    // Padded input also has rows past the end of the sequence, which are zeroed.
+    auto const numRows = params.seqOffsets != nullptr ? seqLength : params.maxSeqLength;
+    auto const queryBegin = static_cast<int32_t>(blockIdx.x) * kQueriesPerBlock;
+    if (queryBegin >= numRows)
+    {
+        return;
+    }
+
+    auto const* table = reinterpret_cast<T const*>(params.relativeAttentionBias);
+    for (int32_t idx = threadIdx.x; idx < params.numBuckets; idx += blockDim.x)
+    {
+        biasTable[idx] = cuda_cast<float>(table[headIdx * params.numBuckets + idx]);
+    }
+
+    auto const qkvStride = static_cast<size_t>(3 * params.numHeads) * HEAD_SIZE;
+    auto const* qkv = reinterpret_cast<T const*>(params.qkv) + firstToken * qkvStride;
+    auto const qOffset = static_cast<size_t>(headIdx) * HEAD_SIZE;
+    auto const kOffset = qOffset + static_cast<size_t>(params.numHeads) * HEAD_SIZE;
+    auto const vOffset = kOffset + static_cast<size_t>(params.numHeads) * HEAD_SIZE;
+
+    int32_t tokenIdx[kQueriesPerWarp];
+    bool isActive[kQueriesPerWarp];
+    float qValues[kQueriesPerWarp][kEltsPerLane];
+    float acc[kQueriesPerWarp][kEltsPerLane];
+    float rowMax[kQueriesPerWarp];
+    float rowSum[kQueriesPerWarp];
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        tokenIdx[qi] = queryBegin + qi * kWarpsPerBlock + warpIdx;
+        isActive[qi] = tokenIdx[qi] < seqLength;
+        auto const* qPtr = qkv + (isActive[qi] ? tokenIdx[qi] : 0) * qkvStride + qOffset;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            qValues[qi][ei] = isActive[qi] ? cuda_cast<float>(qPtr[ei * 32 + laneIdx]) * params.qkScale : 0.f;
+            acc[qi][ei] = 0.f;
+        }
+        rowMax[qi] = -INFINITY;
+        rowSum[qi] = 0.f;
+    }
+
+    // A block of padding rows attends nothing.
+    auto const kvEnd = queryBegin < seqLength ? seqLength : 0;
+    for (int32_t tileBegin = 0; tileBegin < kvEnd; tileBegin += kTileTokens)
+    {
+        auto const tileLen = min(kTileTokens, kvEnd - tileBegin);
+
+        __syncthreads();
+        // Rows past the end of the sequence are zeroed so that they contribute nothing to the output.
+        for (int32_t idx = threadIdx.x; idx < kTileTokens * HEAD_SIZE; idx += blockDim.x)
+        {
+            auto const tileTokenIdx = idx / HEAD_SIZE;
+            auto const channelIdx = idx % HEAD_SIZE;
+            T kValue = cuda_cast<T>(0.f);
+            T vValue = cuda_cast<T>(0.f);
+            if (tileTokenIdx < tileLen)
+            {
+                auto const* row = qkv + (tileBegin + tileTokenIdx) * qkvStride;
+                kValue = row[kOffset + channelIdx];
+                vValue = row[vOffset + channelIdx];
+            }
+            kTile[tileTokenIdx][channelIdx] = kValue;
+            vTile[tileTokenIdx][channelIdx] = vValue;
+        }
+        __syncthreads();
+
+#pragma unroll
+        for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+        {
+            if (!isActive[qi])
+            {
+                continue;
+            }
+
+            float scores[kTileTokens];
+            float tileMax = -INFINITY;
+#pragma unroll
+            for (int32_t ti = 0; ti < kTileTokens; ++ti)
+            {
+                float score = 0.f;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    score += qValues[qi][ei] * cuda_cast<float>(kTile[ti][ei * 32 + laneIdx]);
+                }
+#pragma unroll
+                for (int32_t mask = 16; mask > 0; mask >>= 1)
+                {
+                    score += __shfl_xor_sync(0xffffffff, score, mask);
+                }
+                if (ti < tileLen)
+                {
+                    auto const bucket = relativePositionBucket(
+                        tileBegin + ti - tokenIdx[qi], params.numBuckets, params.maxDistance, params.bidirectional);
+                    scores[ti] = score + biasTable[bucket];
+                }
+                else
+                {
+                    scores[ti] = -INFINITY;
+                }
+                tileMax = fmaxf(tileMax, scores[ti]);
+            }
+
+            auto const newMax = fmaxf(rowMax[qi], tileMax);
+            auto const rescale = __expf(rowMax[qi] - newMax);
+            rowMax[qi] = newMax;
+            rowSum[qi] *= rescale;
+#pragma unroll
+            for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+            {
+                acc[qi][ei] *= rescale;
+            }
+#pragma unroll
+            for (int32_t ti = 0; ti < kTileTokens; ++ti)
+            {
+                auto const p = __expf(scores[ti] - newMax);
+                rowSum[qi] += p;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    acc[qi][ei] += p * cuda_cast<float>(vTile[ti][ei * 32 + laneIdx]);
+                }
+            }
+        }
+    }
+
+    auto* output = reinterpret_cast<T*>(params.output);
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        if (tokenIdx[qi] >= numRows)
+        {
+            continue;
+        }
+        auto const rowIdx = static_cast<size_t>(firstToken + tokenIdx[qi]) * params.numHeads + headIdx;
+        auto* outPtr = output + rowIdx * HEAD_SIZE;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            outPtr[ei * 32 + laneIdx] = cuda_cast<T>(isActive[qi] ? acc[qi][ei] / rowSum[qi] : 0.f);
+        }
+    }
+}
+
+template <typename T, int32_t HEAD_SIZE>
+void launchRelativeAttention(RelativeAttentionParams const& params, cudaStream_t stream)
+{
+    dim3 const block(kWarpsPerBlock * 32);
+    dim3 const grid(divUp(params.maxSeqLength, kQueriesPerBlock), params.numHeads, params.batchSize);
+    relativeAttentionKernel<T, HEAD_SIZE><<<grid, block, 0, stream>>>(params);
+}
+
+} // namespace
+
+bool isRelativeAttentionSupported(int32_t headSize, int32_t numBuckets)
+{
+    auto const headSizeSupported = headSize == 32 || headSize == 64 || headSize == 128 || headSize == 256;
+    return headSizeSupported && numBuckets <= kMaxNumBuckets;
+}
+
+template <typename T>
+void invokeRelativeAttention(RelativeAttentionParams const& params, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.numBuckets > 0 && params.numBuckets <= kMaxNumBuckets,
+        "Relative attention supports 1 to %d buckets, got %d", kMaxNumBuckets, params.numBuckets);
+    TLLM_CHECK_WITH_INFO(params.maxDistance > 0, "Implicit relative attention requires a positive max distance");
+    if (params.batchSize == 0 || params.maxSeqLength == 0)
+    {
+        return;
+    }
+    switch (params.headSize)
+    {
+    case 32: launchRelativeAttention<T, 32>(params, stream); break;
+    case 64: launchRelativeAttention<T, 64>(params, stream); break;
+    case 128: launchRelativeAttention<T, 128>(params, stream); break;
+    case 256: launchRelativeAttention<T, 256>(params, stream); break;
+    default: TLLM_THROW("Relative attention does not support head size %d", params.headSize);
+    }
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_RELATIVE_ATTENTION(T)                                                                              \
+    template void invokeRelativeAttention<T>(RelativeAttentionParams const& params, cudaStream_t stream)
+
+INSTANTIATE_RELATIVE_ATTENTION(float);
+INSTANTIATE_RELATIVE_ATTENTION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_RELATIVE_ATTENTION(__nv_bfloat16);
+#endif
+#undef INSTANTIATE_RELATIVE_ATTENTION
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Fused context attention with the implicit relative attention bias of T5-family models. The bias of a query and a key
+// is looked up in a [numHeads, numBuckets] table by the bucket of their relative position, computed on the fly inside
+// the kernel, and the softmax is computed online over tiles of K/V. Neither the [numHeads, seqLen, seqLen] QK matrix
+// nor the bias is ever materialized, so memory is linear in the sequence length.
+
+struct RelativeAttentionParams
+{
+    // Packed QKV without bias, [numTokens, 3, numHeads, headSize]
+    void const* qkv;
+    // [numTokens, numHeads, headSize]
+    void* output;
+    // Relative attention table, [numHeads, numBuckets]
+    void const* relativeAttentionBias;
+    // Offsets of the first token of every sequence, [batchSize + 1]. Null for padded input, where sequence i starts at
+    // token i * maxSeqLength.
+    int32_t const* seqOffsets;
+    // [batchSize]
+    int32_t const* seqLengths;
+
+    int32_t batchSize;
+    int32_t maxSeqLength;
+    int32_t numHeads;
+    int32_t headSize;
+    int32_t numBuckets;
+    int32_t maxDistance;
+    // Scale of QK, applied before the bias is added
+    float qkScale;
+    // Bucketing of encoders, which use half of the buckets for each direction
+    bool bidirectional;
+};
+
+//! \brief Whether the fused kernel supports the head size and number of buckets.
+bool isRelativeAttentionSupported(int32_t headSize, int32_t numBuckets = 0);
+
+//! \brief softmax(qkScale * Q * K^T + bias) * V for every sequence and head.
+//! \details Every query attends to all tokens of its sequence. Padded query tokens are written as zeros.
+template <typename T>
+void invokeRelativeAttention(RelativeAttentionParams const& params, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
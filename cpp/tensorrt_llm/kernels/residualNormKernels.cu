@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/residualNormKernels.h"
+
+#include <algorithm>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+constexpr int kThreadsPerBlock = 256;
+
+// 128 bits of a row
+template <typename T>
+struct alignas(16) PackedVec
+{
+    static constexpr int kSize = 16 / sizeof(T);
+    T data[kSize];
+};
+
+// Count, mean and sum of squared differences from the mean of a set of values
+struct WelfordState
+{
+    float count;
+    float mean;
+    float m2;
+};
+
+__device__ inline WelfordState welfordMerge(WelfordState const& a, WelfordState const& b)
+{
+    float const count = a.count + b.count;
+    if (count == 0.f)
+    {
+        return a;
+    }
+    float const delta = b.mean - a.mean;
+    float const ratio = b.count / count;
+    return {count, a.mean + delta * ratio, a.m2 + b.m2 + delta * delta * a.count * ratio};
+}
+
+// Merges the states of all threads, the result is returned to every thread.
+__device__ WelfordState blockAllReduceWelford(WelfordState state)
+{
+    __shared__ WelfordState shared[32];
+    __shared__ WelfordState result;
+    int const lane = threadIdx.x % 32;
+    int const warp = threadIdx.x / 32;
+    int const numWarps = (blockDim.x + 31) / 32;
+
+#pragma unroll
+    for (int mask = 16; mask > 0; mask >>= 1)
+    {
+        WelfordState const other{__shfl_xor_sync(0xffffffff, state.count, mask),
+            __shfl_xor_sync(0xffffffff, state.mean, mask), __shfl_xor_sync(0xffffffff, state.m2, mask)};
+        state = welfordMerge(state, other);
+    }
+    if (lane == 0)
+    {
+        shared[warp] = state;
+    }
+    __syncthreads();
+    if (warp == 0)
+    {
+        state = lane < numWarps ? shared[lane] : WelfordState{0.f, 0.f, 0.f};
+#pragma unroll
+        for (int mask = 16; mask > 0; mask >>= 1)
+        {
+            WelfordState const other{__shfl_xor_sync(0xffffffff, state.count, mask),
+                __shfl_xor_sync(0xffffffff, state.mean, mask), __shfl_xor_sync(0xffffffff, state.m2, mask)};
+            state = welfordMerge(state, other);
+        }
+        if (lane == 0)
+        {
+            result = state;
+        }
+    }
+    __syncthreads();
+    return result;
+}
+
+// Returns the sum over all threads to every thread.
+__device__ float blockAllReduceSumF(float val)
+{
+    __shared__ float shared[32];
+    __shared__ float result;
+    int const lane = threadIdx.x % 32;
+    int const warp = threadIdx.x / 32;
+    int const numWarps = (blockDim.x + 31) / 32;
+
+#pragma unroll
+    for (int mask = 16; mask > 0; mask >>= 1)
+    {
+        val += __shfl_xor_sync(0xffffffff, val, mask);
+    }
+    if (lane == 0)
+    {
+        shared[warp] = val;
+    }
+    __syncthreads();
+    if (warp == 0)
+    {
+        val = lane < numWarps ? shared[lane] : 0.f;
+#pragma unroll
+        for (int mask = 16; mask > 0; mask >>= 1)
+        {
+            val += __shfl_xor_sync(0xffffffff, val, mask);
+        }
+        if (lane == 0)
+        {
+            result = val;
+        }
+    }
+    __syncthreads();
+    return result;
+}
+
+// One CTA per row. With HIDDEN_DIM > 0 the CTA has kThreadsPerBlock threads and keeps the row in registers, with
+// HIDDEN_DIM == 0 the row of hidden_dim values is kept in dynamic shared memory.
+template <typename T, bool RMS_NORM, int HIDDEN_DIM>
+__global__ void __launch_bounds__(kThreadsPerBlock) residualNormKernel(T* normed_output, T* residual,
+    const T* input, const T* gamma, const T* beta, const float eps, const int hidden_dim)
+{
+    using Vec = PackedVec<T>;
+    constexpr int kVecSize = Vec::kSize;
+    constexpr bool kRowInRegisters = HIDDEN_DIM > 0;
+    constexpr int kVecsPerThread = kRowInRegisters ? ceilDiv(HIDDEN_DIM / kVecSize, kThreadsPerBlock) : 1;
+
+    extern __shared__ __align__(16) char _shmem[];
+    Vec* shmem_row = reinterpret_cast<Vec*>(_shmem);
+    Vec reg_row[kVecsPerThread];
+
+    const int num_vecs = hidden_dim / kVecSize;
+    const size_t row_offset = static_cast<size_t>(blockIdx.x) * num_vecs;
+    const Vec* input_row = reinterpret_cast<const Vec*>(input) + row_offset;
+    Vec* residual_row = reinterpret_cast<Vec*>(residual) + row_offset;
+    Vec* output_row = reinterpret_cast<Vec*>(normed_output) + row_offset;
+
+    auto add_residual = [&](int idx)
+    {
+        Vec const in = input_row[idx];
+        Vec sum = residual_row[idx];
+#pragma unroll
+        for (int j = 0; j < kVecSize; ++j)
+        {
+            sum.data[j] = cuda_cast<T>(cuda_cast<float>(in.data[j]) + cuda_cast<float>(sum.data[j]));
+        }
+        residual_row[idx] = sum;
+        return sum;
+    };
+
+    // Single pass over global memory: add, cache the sum and accumulate its sum per thread.
+    float thread_sum = 0.f;
+    int thread_count = 0;
+    if constexpr (kRowInRegisters)
+    {
+#pragma unroll
+        for (int k = 0; k < kVecsPerThread; ++k)
+        {
+            int const idx = threadIdx.x + k * kThreadsPerBlock;
+            if (idx < num_vecs)
+            {
+                reg_row[k] = add_residual(idx);
+#pragma unroll
+                for (int j = 0; j < kVecSize; ++j)
+                {
+                    float const val = cuda_cast<float>(reg_row[k].data[j]);
+                    thread_sum += RMS_NORM ? val * val : val;
+                }
+                thread_count += kVecSize;
+            }
+        }
+    }
+    else
+    {
+        for (int idx = threadIdx.x; idx < num_vecs; idx += blockDim.x)
+        {
+            Vec const sum = add_residual(idx);
+            shmem_row[idx] = sum;
+#pragma unroll
+            for (int j = 0; j < kVecSize; ++j)
+            {
+                float const val = cuda_cast<float>(sum.data[j]);
+                thread_sum += RMS_NORM ? val * val : val;
+            }
+            thread_count += kVecSize;
+        }
+    }
+
+    // Each thread only reads back its own cached values.
+    auto for_each_cached = [&](auto&& func)
+    {
+        if constexpr (kRowInRegisters)
+        {
+#pragma unroll
+            for (int k = 0; k < kVecsPerThread; ++k)
+            {
+                int const idx = threadIdx.x + k * kThreadsPerBlock;
+                if (idx < num_vecs)
+                {
+                    func(idx, reg_row[k]);
+                }
+            }
+        }
+        else
+        {
+            for (int idx = threadIdx.x; idx < num_vecs; idx += blockDim.x)
+            {
+                func(idx, shmem_row[idx]);
+            }
+        }
+    };
+
+    float mean = 0.f;
+    float inv_std;
+    if constexpr (RMS_NORM)
+    {
+        float const sum_squares = blockAllReduceSumF(thread_sum);
+        inv_std = rsqrtf(sum_squares / hidden_dim + eps);
+    }
+    else
+    {
+        // Welford: the statistics of the values of every thread, then Chan's merge across the threads.
+        WelfordState state{static_cast<float>(thread_count), thread_count > 0 ? thread_sum / thread_count : 0.f, 0.f};
+        for_each_cached(
+            [&](int, Vec const& vec)
+            {
+#pragma unroll
+                for (int j = 0; j < kVecSize; ++j)
+                {
+                    float const diff = cuda_cast<float>(vec.data[j]) - state.mean;
+                    state.m2 += diff * diff;
+                }
+            });
+        state = blockAllReduceWelford(state);
+        mean = state.mean;
+        inv_std = rsqrtf(state.m2 / hidden_dim + eps);
+    }
+
+    const Vec* gamma_vecs = reinterpret_cast<const Vec*>(gamma);
+    const Vec* beta_vecs = reinterpret_cast<const Vec*>(beta);
+    for_each_cached(
+        [&](int idx, Vec const& vec)
+        {
+            Vec const g = gamma_vecs[idx];
+            Vec b;
+            if (beta != nullptr)
+            {
+                b = beta_vecs[idx];
+            }
+            Vec out;
+#pragma unroll
+            for (int j = 0; j < kVecSize; ++j)
+            {
+                float val = (cuda_cast<float>(vec.data[j]) - mean) * inv_std * cuda_cast<float>(g.data[j]);
+                if (beta != nullptr)
+                {
+                    val += cuda_cast<float>(b.data[j]);
+                }
+                out.data[j] = cuda_cast<T>(val);
+            }
+            output_row[idx] = out;
+        });
+}
+
+template <typename T, bool RMS_NORM, int HIDDEN_DIM>
+void launchResidualNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta, const float eps,
+    const int tokens, const int hidden_dim, cudaStream_t stream)
+{
+    auto const kernel = residualNormKernel<T, RMS_NORM, HIDDEN_DIM>;
+    dim3 const grid(tokens);
+    if constexpr (HIDDEN_DIM > 0)
+    {
+        kernel<<<grid, kThreadsPerBlock, 0, stream>>>(out, residual, input, gamma, beta, eps, hidden_dim);
+    }
+    else
+    {
+        int const num_vecs = hidden_dim / PackedVec<T>::kSize;
+        dim3 const block(std::min(kThreadsPerBlock, 32 * ceilDiv(num_vecs, 32)));
+        size_t const shmem_size = hidden_dim * sizeof(T);
+        if (shmem_size >= (48 << 10))
+        {
+            TLLM_CUDA_CHECK(cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, shmem_size));
+        }
+        kernel<<<grid, block, shmem_size, stream>>>(out, residual, input, gamma, beta, eps, hidden_dim);
+    }
+}
+
+template <typename T, bool RMS_NORM>
+void invokeResidualNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta, const float eps,
+    const int tokens, const int hidden_dim, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(hidden_dim % PackedVec<T>::kSize == 0, "Hidden size %d must be a multiple of %d", hidden_dim,
+        PackedVec<T>::kSize);
+    if (tokens == 0)
+    {
+        return;
+    }
+    switch (hidden_dim)
+    {
+    case 4096:
+        launchResidualNorm<T, RMS_NORM, 4096>(out, residual, input, gamma, beta, eps, tokens, hidden_dim, stream);
+        break;
+    case 5120:
+        launchResidualNorm<T, RMS_NORM, 5120>(out, residual, input, gamma, beta, eps, tokens, hidden_dim, stream);
+        break;
+    case 8192:
+        launchResidualNorm<T, RMS_NORM, 8192>(out, residual, input, gamma, beta, eps, tokens, hidden_dim, stream);
+        break;
+    default:
+        launchResidualNorm<T, RMS_NORM, 0>(out, residual, input, gamma, beta, eps, tokens, hidden_dim, stream);
+        break;
+    }
+    sync_check_cuda_error();
+}
+
+} // namespace
+
+template <typename T>
+void invokeResidualLayerNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta, const float eps,
+    const int tokens, const int hidden_dim, cudaStream_t stream)
+{
+    invokeResidualNorm<T, false>(out, residual, input, gamma, beta, eps, tokens, hidden_dim, stream);
+}
+
+template <typename T>
+void invokeResidualRmsNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta, const float eps,
+    const int tokens, const int hidden_dim, cudaStream_t stream)
+{
+    invokeResidualNorm<T, true>(out, residual, input, gamma, beta, eps, tokens, hidden_dim, stream);
+}
+
+#define INSTANTIATE_RESIDUAL_NORM(T)                                                                                   \
+    template void invokeResidualLayerNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta,          \
+        const float eps, const int tokens, const int hidden_dim, cudaStream_t stream);                                 \
+    template void invokeResidualRmsNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta,            \
+        const float eps, const int tokens, const int hidden_dim, cudaStream_t stream)
+
+INSTANTIATE_RESIDUAL_NORM(float);
+INSTANTIATE_RESIDUAL_NORM(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_RESIDUAL_NORM(__nv_bfloat16);
+#endif
+
+#undef INSTANTIATE_RESIDUAL_NORM
+
+} // namespace kernels
+} // namespace tensorrt_llm
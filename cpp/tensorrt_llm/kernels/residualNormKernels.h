@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include <cuda_fp16.h>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Residual add fused with the norm that follows it in every transformer layer:
+//   residual <- input + residual
+//   out <- norm(residual) * gamma + beta
+// It replaces a separate add kernel followed by invokeGeneralLayerNorm or invokeGeneralRmsNorm. The input and the
+// residual are read once, and the sum is written once. One CTA handles one row with 128-bit loads and computes the
+// statistics in a single pass, with the row kept in registers for hidden sizes 4096, 5120 and 8192, and in shared
+// memory for the others. The sum is rounded to T before the norm, as it would be by the separate add.
+// hidden_dim must be a multiple of 16 / sizeof(T), the pointers 16-byte aligned, and beta may be null.
+
+template <typename T>
+void invokeResidualLayerNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta, const float eps,
+    const int tokens, const int hidden_dim, cudaStream_t stream = 0);
+
+template <typename T>
+void invokeResidualRmsNorm(T* out, T* residual, const T* input, const T* gamma, const T* beta, const float eps,
+    const int tokens, const int hidden_dim, cudaStream_t stream = 0);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/ringAttentionKernels.h"
+
+#include <algorithm>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+// Tokens of K and V staged in shared memory at a time.
+constexpr int32_t kTileTokens = 16;
+// Each warp attends kQueriesPerWarp queries, so one thread block shares every K/V tile among
+// kWarpsPerBlock * kQueriesPerWarp queries of consecutive tokens and of the query heads of one KV head.
+constexpr int32_t kWarpsPerBlock = 8;
+constexpr int32_t kQueriesPerWarp = 4;
+constexpr int32_t kQueriesPerBlock = kWarpsPerBlock * kQueriesPerWarp;
+
+template <typename T, int32_t HEAD_SIZE>
+__global__ void __launch_bounds__(kWarpsPerBlock * 32) ringAttentionStepKernel(RingAttentionStepParams params)
+{
+    constexpr int32_t kEltsPerLane = HEAD_SIZE / 32;
+
+    __shared__ T kTile[kTileTokens][HEAD_SIZE];
+    __shared__ T vTile[kTileTokens][HEAD_SIZE];
+
+    auto const warpIdx = static_cast<int32_t>(threadIdx.x) / 32;
+    auto const laneIdx = static_cast<int32_t>(threadIdx.x) % 32;
+    auto const kvHeadIdx = static_cast<int32_t>(blockIdx.y);
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+
+    // Queries are ordered by token, then by query head of the KV head.
+    auto const numQueries = params.numQTokens * headsPerKv;
+    auto const queryBegin = static_cast<int32_t>(blockIdx.x) * kQueriesPerBlock;
+    if (queryBegin >= numQueries)
+    {
+        return;
+    }
+
+    auto const* q = reinterpret_cast<T const*>(params.q);
+    auto const* kv = reinterpret_cast<T const*>(params.kv);
+    auto const kvStride = static_cast<size_t>(2 * params.numKVHeads) * HEAD_SIZE;
+    auto const kOffset = static_cast<size_t>(kvHeadIdx) * HEAD_SIZE;
+    auto const vOffset = kOffset + static_cast<size_t>(params.numKVHeads) * HEAD_SIZE;
+
+    int32_t stateIdx[kQueriesPerWarp];
+    int32_t qPosition[kQueriesPerWarp];
+    bool isActive[kQueriesPerWarp];
+    float qValues[kQueriesPerWarp][kEltsPerLane];
+    float acc[kQueriesPerWarp][kEltsPerLane];
+    float rowMax[kQueriesPerWarp];
+    float rowSum[kQueriesPerWarp];
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        auto const queryIdx = queryBegin + qi * kWarpsPerBlock + warpIdx;
+        isActive[qi] = queryIdx < numQueries;
+        auto const tokenIdx = isActive[qi] ? queryIdx / headsPerKv : 0;
+        auto const qHeadIdx = kvHeadIdx * headsPerKv + (isActive[qi] ? queryIdx % headsPerKv : 0);
+        stateIdx[qi] = tokenIdx * params.numQHeads + qHeadIdx;
+        qPosition[qi] = params.qPosition + tokenIdx;
+        auto const* qPtr = q + static_cast<size_t>(stateIdx[qi]) * HEAD_SIZE;
+        auto const* accPtr = params.accumulator + static_cast<size_t>(stateIdx[qi]) * HEAD_SIZE;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            qValues[qi][ei] = isActive[qi] ? cuda_cast<float>(qPtr[ei * 32 + laneIdx]) * params.softmaxScale : 0.f;
+            acc[qi][ei] = isActive[qi] ? accPtr[ei * 32 + laneIdx] : 0.f;
+        }
+        rowSum[qi] = isActive[qi] ? params.rowSum[stateIdx[qi]] : 0.f;
+        // The state is zero-initialized, the maximum is only meaningful once something was attended.
+        rowMax[qi] = rowSum[qi] > 0.f ? params.rowMax[stateIdx[qi]] : -INFINITY;
+    }
+
+    // With the causal mask the block reads the K/V tokens up to the position of its last query.
+    auto const lastToken = (min(queryBegin + kQueriesPerBlock, numQueries) - 1) / headsPerKv;
+    auto const kvEnd = params.causal ? min(params.numKvTokens, params.qPosition + lastToken - params.kvPosition + 1)
+                                     : params.numKvTokens;
+
+    for (int32_t tileBegin = 0; tileBegin < kvEnd; tileBegin += kTileTokens)
+    {
+        auto const tileLen = min(kTileTokens, kvEnd - tileBegin);
+
+        __syncthreads();
+        // Rows past the end of the shard are zeroed so that they contribute nothing to the output.
+        for (int32_t idx = threadIdx.x; idx < kTileTokens * HEAD_SIZE; idx += blockDim.x)
+        {
+            auto const tileTokenIdx = idx / HEAD_SIZE;
+            auto const channelIdx = idx % HEAD_SIZE;
+            T kValue = cuda_cast<T>(0.f);
+            T vValue = cuda_cast<T>(0.f);
+            if (tileTokenIdx < tileLen)
+            {
+                auto const* row = kv + (tileBegin + tileTokenIdx) * kvStride;
+                kValue = row[kOffset + channelIdx];
+                vValue = row[vOffset + channelIdx];
+            }
+            kTile[tileTokenIdx][channelIdx] = kValue;
+            vTile[tileTokenIdx][channelIdx] = vValue;
+        }
+        __syncthreads();
+
+#pragma unroll
+        for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+        {
+            if (!isActive[qi])
+            {
+                continue;
+            }
+
+            float scores[kTileTokens];
+            float tileMax = -INFINITY;
+#pragma unroll
+            for (int32_t ti = 0; ti < kTileTokens; ++ti)
+            {
+                float score = 0.f;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    score += qValues[qi][ei] * cuda_cast<float>(kTile[ti][ei * 32 + laneIdx]);
+                }
+#pragma unroll
+                for (int32_t mask = 16; mask > 0; mask >>= 1)
+                {
+                    score += __shfl_xor_sync(0xffffffff, score, mask);
+                }
+                auto const attended
+                    = ti < tileLen && (!params.causal || params.kvPosition + tileBegin + ti <= qPosition[qi]);
+                scores[ti] = attended ? score : -INFINITY;
+                tileMax = fmaxf(tileMax, scores[ti]);
+            }
+            // The whole tile is in the future of this query.
+            if (tileMax == -INFINITY)
+            {
+                continue;
+            }
+
+            auto const newMax = fmaxf(rowMax[qi], tileMax);
+            auto const rescale = __expf(rowMax[qi] - newMax);
+            rowMax[qi] = newMax;
+            rowSum[qi] *= rescale;
+#pragma unroll
+            for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+            {
+                acc[qi][ei] *= rescale;
+            }
+#pragma unroll
+            for (int32_t ti = 0; ti < kTileTokens; ++ti)
+            {
+                auto const p = __expf(scores[ti] - newMax);
+                rowSum[qi] += p;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    acc[qi][ei] += p * cuda_cast<float>(vTile[ti][ei * 32 + laneIdx]);
+                }
+            }
+        }
+    }
+
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        if (!isActive[qi])
+        {
+            continue;
+        }
+        auto* accPtr = params.accumulator + static_cast<size_t>(stateIdx[qi]) * HEAD_SIZE;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            accPtr[ei * 32 + laneIdx] = acc[qi][ei];
+        }
+        if (laneIdx == 0)
+        {
+            params.rowMax[stateIdx[qi]] = rowMax[qi];
+            params.rowSum[stateIdx[qi]] = rowSum[qi];
+        }
+    }
+}
+
+template <typename T>
+__global__ void ringAttentionFinalizeKernel(
+    T* output, float const* accumulator, float const* rowSum, int32_t numRows, int32_t headSize)
+{
+    auto const numElts = static_cast<size_t>(numRows) * headSize;
+    for (auto idx = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; idx < numElts;
+         idx += static_cast<size_t>(gridDim.x) * blockDim.x)
+    {
+        // Rows that attended nothing, e.g. padding, are written as zeros.
+        auto const sum = rowSum[idx / headSize];
+        output[idx] = cuda_cast<T>(sum > 0.f ? accumulator[idx] / sum : 0.f);
+    }
+}
+
+template <typename T, int32_t HEAD_SIZE>
+void launchRingAttentionStep(RingAttentionStepParams const& params, cudaStream_t stream)
+{
+    dim3 const block(kWarpsPerBlock * 32);
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+    dim3 const grid(divUp(params.numQTokens * headsPerKv, kQueriesPerBlock), params.numKVHeads);
+    ringAttentionStepKernel<T, HEAD_SIZE><<<grid, block, 0, stream>>>(params);
+}
+
+} // namespace
+
+template <typename T>
+void invokeRingAttentionStep(RingAttentionStepParams const& params, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.numQHeads % params.numKVHeads == 0,
+        "The number of query heads must be a multiple of the number of KV heads");
+    // Nothing to attend: an empty shard, or a shard entirely in the future of the local queries.
+    if (params.numQTokens == 0 || params.numKvTokens == 0
+        || (params.causal && params.kvPosition > params.qPosition + params.numQTokens - 1))
+    {
+        return;
+    }
+    switch (params.headSize)
+    {
+    case 32: launchRingAttentionStep<T, 32>(params, stream); break;
+    case 64: launchRingAttentionStep<T, 64>(params, stream); break;
+    case 128: launchRingAttentionStep<T, 128>(params, stream); break;
+    case 256: launchRingAttentionStep<T, 256>(params, stream); break;
+    default: TLLM_THROW("Ring attention does not support head size %d", params.headSize);
+    }
+    sync_check_cuda_error();
+}
+
+template <typename T>
+void invokeRingAttentionFinalize(void* output, float const* accumulator, float const* rowSum, int32_t numQTokens,
+    int32_t numQHeads, int32_t headSize, cudaStream_t stream)
+{
+    auto const numElts = static_cast<size_t>(numQTokens) * numQHeads * headSize;
+    if (numElts == 0)
+    {
+        return;
+    }
+    dim3 const block(256);
+    dim3 const grid(static_cast<unsigned>(std::min<size_t>(divUp(numElts, block.x), 65535)));
+    ringAttentionFinalizeKernel<T>
+        <<<grid, block, 0, stream>>>(static_cast<T*>(output), accumulator, rowSum, numQTokens * numQHeads, headSize);
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_RING_ATTENTION(T)                                                                                  \
+    template void invokeRingAttentionStep<T>(RingAttentionStepParams const& params, cudaStream_t stream);              \
+    template void invokeRingAttentionFinalize<T>(void* output, float const* accumulator, float const* rowSum,          \
+        int32_t numQTokens, int32_t numQHeads, int32_t headSize, cudaStream_t stream)
+
+INSTANTIATE_RING_ATTENTION(float);
+INSTANTIATE_RING_ATTENTION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_RING_ATTENTION(__nv_bfloat16);
+#endif
+#undef INSTANTIATE_RING_ATTENTION
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Ring attention for context parallelism. A sequence is split into contiguous shards across the ranks of a context
+// parallel group. Every rank keeps the queries and the K/V of its shard; the K/V shards are passed around the ring
+// and each rank attends its queries to one K/V shard per step. The partial results are merged with an online softmax,
+// so no rank ever holds the K/V of the whole sequence.
+
+struct RingAttentionStepParams
+{
+    // Queries of the local shard after bias and RoPE, [numQTokens, numQHeads, headSize]
+    void const* q;
+    // K/V shard of this step, [numKvTokens, 2, numKVHeads, headSize]
+    void const* kv;
+    // Running state of the online softmax, zero-initialized before the first step.
+    // Unnormalized output, [numQTokens, numQHeads, headSize]
+    float* accumulator;
+    // Running maximum and sum of exp(score - maximum), [numQTokens, numQHeads]
+    float* rowMax;
+    float* rowSum;
+
+    int32_t numQTokens;
+    int32_t numKvTokens;
+    // Positions of the first query and of the first K/V token in the sequence, used by the causal mask
+    int32_t qPosition;
+    int32_t kvPosition;
+    int32_t numQHeads;
+    int32_t numKVHeads;
+    int32_t headSize;
+    float softmaxScale;
+    bool causal;
+};
+
+//! \brief Attend the local queries to one K/V shard and merge the result into the running state.
+//! \details Supports head sizes 32, 64, 128 and 256.
+template <typename T>
+void invokeRingAttentionStep(RingAttentionStepParams const& params, cudaStream_t stream);
+
+//! \brief Normalize the running state after the last step, output is [numQTokens, numQHeads, headSize].
+template <typename T>
+void invokeRingAttentionFinalize(void* output, float const* accumulator, float const* rowSum, int32_t numQTokens,
+    int32_t numQHeads, int32_t headSize, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/rotaryCosSinCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+std::vector<float> computeRotaryInvFreqs(RotaryCosSinCacheParams const& params, float& attentionFactor)
+{
+    auto const rotDim = params.rotaryEmbeddingDim;
+    TLLM_CHECK_WITH_INFO(rotDim > 0 && rotDim % 2 == 0, "Rotary embedding dimension must be a positive even number.");
+    TLLM_CHECK_WITH_INFO(params.scaleType != RotaryScalingType::kDYNAMIC,
+        "Dynamic rotary scaling depends on the sequence length and has no cos/sin table.");
+
+    auto const numFreqs = rotDim / 2;
+    double const base = params.rotaryEmbeddingBase;
+    double const scale = params.scale;
+    std::vector<float> invFreqs(numFreqs);
+    attentionFactor = 1.f;
+
+    switch (params.scaleType)
+    {
+    case RotaryScalingType::kYARN:
+    {
+        TLLM_CHECK_WITH_INFO(params.originalMaxPositions > 0, "YaRN needs the original max positions.");
+        // Dimension whose frequency turns numRotations times over the original context.
+        auto const correctionDim = [&](double numRotations)
+        {
+            return rotDim * std::log(params.originalMaxPositions / (numRotations * 2 * M_PI)) / (2 * std::log(base));
+        };
+        auto const low = std::max(std::floor(correctionDim(params.yarnBetaFast)), 0.0);
+        auto high = std::min(std::ceil(correctionDim(params.yarnBetaSlow)), static_cast<double>(rotDim - 1));
+        if (high == low)
+        {
+            high += 0.001;
+        }
+        for (int i = 0; i < numFreqs; ++i)
+        {
+            auto const extrapolation = std::pow(base, -2.0 * i / rotDim);
+            auto const ramp = std::clamp((i - low) / (high - low), 0.0, 1.0);
+            invFreqs[i] = static_cast<float>(extrapolation / scale * ramp + extrapolation * (1.0 - ramp));
+        }
+        attentionFactor = scale > 1.0 ? static_cast<float>(0.1 * std::log(scale) + 1.0) : 1.f;
+        break;
+    }
+    case RotaryScalingType::kLONGROPE:
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<int>(params.longRopeFactors.size()) == numFreqs,
+            "LongRoPE needs one rescale factor per rotary frequency.");
+        TLLM_CHECK_WITH_INFO(params.originalMaxPositions > 1, "LongRoPE needs the original max positions.");
+        for (int i = 0; i < numFreqs; ++i)
+        {
+            invFreqs[i] = static_cast<float>(std::pow(base, -2.0 * i / rotDim) / params.longRopeFactors[i]);
+        }
+        attentionFactor = scale > 1.0
+            ? static_cast<float>(std::sqrt(1.0 + std::log(scale) / std::log(params.originalMaxPositions)))
+            : 1.f;
+        break;
+    }
+    default:
+    {
+        auto const divisor = params.scaleType == RotaryScalingType::kLINEAR ? scale : 1.0;
+        for (int i = 0; i < numFreqs; ++i)
+        {
+            invFreqs[i] = static_cast<float>(std::pow(base, -2.0 * i / rotDim) / divisor);
+        }
+        break;
+    }
+    }
+    return invFreqs;
+}
+
+__global__ void buildRotaryCosSinCache(
+    float2* cosSin, float const* invFreqs, int32_t numPositions, int32_t numFreqs, float attentionFactor)
+{
+    auto const numElems = static_cast<int64_t>(numPositions) * numFreqs;
+    for (auto idx = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x; idx < numElems;
+         idx += static_cast<int64_t>(gridDim.x) * blockDim.x)
+    {
+        // Double precision keeps the angle exact for the positions of long contexts, it only runs once per table.
+        double const angle = static_cast<double>(idx / numFreqs) * invFreqs[idx % numFreqs];
+        double sinValue, cosValue;
+        sincos(angle, &sinValue, &cosValue);
+        cosSin[idx] = make_float2(static_cast<float>(cosValue) * attentionFactor,
+            static_cast<float>(sinValue) * attentionFactor);
+    }
+}
+
+void invokeBuildRotaryCosSinCache(float2* cosSin, float const* invFreqs, int32_t numPositions,
+    int32_t rotaryEmbeddingDim, float attentionFactor, cudaStream_t stream)
+{
+    auto const numFreqs = rotaryEmbeddingDim / 2;
+    auto const numElems = static_cast<int64_t>(numPositions) * numFreqs;
+    int const blockSize = 256;
+    int const gridSize = static_cast<int>(std::min<int64_t>((numElems + blockSize - 1) / blockSize, 65536));
+    buildRotaryCosSinCache<<<gridSize, blockSize, 0, stream>>>(
+        cosSin, invFreqs, numPositions, numFreqs, attentionFactor);
+}
+
+namespace
+{
+
+class RotaryCosSinCacheLoader
+{
+public:
+    float2 const* getCache(RotaryCosSinCacheParams const& params, int32_t numPositions)
+    {
+        std::lock_guard<std::mutex> lg(mMutex);
+        for (auto const& entry : mEntries)
+        {
+            if (entry.params == params && entry.numPositions >= numPositions)
+            {
+                return entry.cosSin;
+            }
+        }
+
+        float attentionFactor;
+        auto const invFreqs = computeRotaryInvFreqs(params, attentionFactor);
+        float* deviceInvFreqs;
+        float2* cosSin;
+        TLLM_CUDA_CHECK(cudaMalloc(&deviceInvFreqs, invFreqs.size() * sizeof(float)));
+        TLLM_CUDA_CHECK(
+            cudaMalloc(&cosSin, static_cast<size_t>(numPositions) * params.rotaryEmbeddingDim / 2 * sizeof(float2)));
+        TLLM_CUDA_CHECK(
+            cudaMemcpy(deviceInvFreqs, invFreqs.data(), invFreqs.size() * sizeof(float), cudaMemcpyHostToDevice));
+        invokeBuildRotaryCosSinCache(
+            cosSin, deviceInvFreqs, numPositions, params.rotaryEmbeddingDim, attentionFactor, nullptr);
+        TLLM_CUDA_CHECK(cudaDeviceSynchronize());
+        TLLM_CUDA_CHECK(cudaFree(deviceInvFreqs));
+
+        // Smaller tables of the same params are kept, they may still be referenced.
+        mEntries.push_back({params, numPositions, cosSin});
+        return cosSin;
+    }
+
+    static RotaryCosSinCacheLoader& Get()
+    {
+        int device;
+        TLLM_CUDA_CHECK(cudaGetDevice(&device));
+        static std::mutex s_mutex;
+        static std::unique_ptr<RotaryCosSinCacheLoader> s_loaders[32] = {nullptr};
+        std::lock_guard<std::mutex> lg(s_mutex);
+        TLLM_CHECK(device < 32);
+        if (!s_loaders[device])
+        {
+            s_loaders[device].reset(new RotaryCosSinCacheLoader());
+        }
+        return *s_loaders[device];
+    }
+
+private:
+    struct Entry
+    {
+        RotaryCosSinCacheParams params;
+        int32_t numPositions;
+        float2* cosSin;
+    };
+
+    std::mutex mMutex;
+    std::vector<Entry> mEntries;
+};
+
+} // namespace
+
+float2 const* getRotaryCosSinCache(RotaryCosSinCacheParams const& params, int32_t numPositions)
+{
+    TLLM_CHECK_WITH_INFO(numPositions > 0, "The rotary cos/sin table needs at least one position.");
+    return RotaryCosSinCacheLoader::Get().getCache(params, numPositions);
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
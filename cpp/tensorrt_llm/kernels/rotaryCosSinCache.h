@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/gptKernels.h"
+
+#include <cstdint>
+#include <cuda_runtime.h>
+#include <vector>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Precomputed rotary embedding coefficients. The table holds {cos, sin} of position * invFreq[i] for every position
+// and every pair of rotated dimensions, [numPositions, rotaryEmbeddingDim / 2], so the attention kernels replace the
+// per element powf and sincos by a single load and the scaling variants that are not a closed form of
+// (base, scale, position) become possible.
+
+struct RotaryCosSinCacheParams
+{
+    int32_t rotaryEmbeddingDim{0};
+    float rotaryEmbeddingBase{10000.f};
+    // kDYNAMIC depends on the sequence length and has no table.
+    RotaryScalingType scaleType{RotaryScalingType::kNONE};
+    float scale{1.f};
+    // Context length the model was trained with, used by kYARN and kLONGROPE.
+    int32_t originalMaxPositions{0};
+    // YaRN keeps the frequencies turning more than betaFast times over the original context and interpolates the
+    // ones turning less than betaSlow times, with a linear ramp in between.
+    float yarnBetaFast{32.f};
+    float yarnBetaSlow{1.f};
+    // Per frequency rescale factors of kLONGROPE, [rotaryEmbeddingDim / 2].
+    std::vector<float> longRopeFactors;
+
+    bool operator==(RotaryCosSinCacheParams const& other) const
+    {
+        return rotaryEmbeddingDim == other.rotaryEmbeddingDim && rotaryEmbeddingBase == other.rotaryEmbeddingBase
+            && scaleType == other.scaleType && scale == other.scale
+            && originalMaxPositions == other.originalMaxPositions && yarnBetaFast == other.yarnBetaFast
+            && yarnBetaSlow == other.yarnBetaSlow && longRopeFactors == other.longRopeFactors;
+    }
+};
+
+//! \brief Compute the scaled inverse frequency of each pair of rotated dimensions, [rotaryEmbeddingDim / 2].
+//! \param attentionFactor Set to the factor YaRN and LongRoPE apply to the cos and sin values, 1 otherwise.
+std::vector<float> computeRotaryInvFreqs(RotaryCosSinCacheParams const& params, float& attentionFactor);
+
+//! \brief Fill cosSin, [numPositions, rotaryEmbeddingDim / 2], from the device array invFreqs.
+void invokeBuildRotaryCosSinCache(float2* cosSin, float const* invFreqs, int32_t numPositions,
+    int32_t rotaryEmbeddingDim, float attentionFactor, cudaStream_t stream);
+
+//! \brief Get the table of the current device covering at least numPositions positions, building it on first use.
+//! \details Tables are shared by all the layers and plugins with the same params and live until the process exits,
+//! as enqueued work and captured CUDA graphs may still read them. The call synchronizes the device when it builds a
+//! table, so it belongs to initialization code rather than to enqueue.
+float2 const* getRotaryCosSinCache(RotaryCosSinCacheParams const& params, int32_t numPositions);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -25,6 +25,7 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/kernels/samplingTopPKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
 #include <cuda/std/limits>
 #include <cuda_fp16.h>
 
@@ -76,98 +77,6 @@ struct alignas(128) Counter
 /*******************************Functions*********************************/
 using WideT = float4;
 
-//! \brief Provide a ceiling division operation ie. ceil(a / b)
-//! \tparam IntType supposed to be only integers for now!
-template <typename IntType>
-constexpr __host__ __device__ IntType ceilDiv(IntType a, IntType b)
-{
-    return (a + b - 1) / b;
-}
-
-//! \brief Provide an alignment function ie. ceil(a / b) * b
-//! \tparam IntType supposed to be only integers for now!
-template <typename IntType>
-constexpr __host__ __device__ IntType alignTo(IntType a, IntType b)
-{
-    return ceilDiv(a, b) * b;
-}
-
-//! \brief Calcute the number of buckets based on the number of bits per pass.
-//! \tparam BitsPerPass. If BitsPerPass==11, the number of buckets is 2048. If BitsPerPass==8, the number of buckets is
-//! 256.
-template <int BitsPerPass>
-__host__ __device__ int constexpr calcNumBuckets()
-{
-    return 1 << BitsPerPass;
-}
-
-//! \brief Calcute the number of passes based on the number of bits per pass.
-//! \tparam BitsPerPass. If BitsPerPass==11, the number of passes is 3. If BitsPerPass==8, the number of passes is 4.
-template <typename T, int BitsPerPass>
-__host__ __device__ int constexpr calcNumPasses()
-{
-    return ceilDiv<int>(sizeof(T) * 8, BitsPerPass);
-}
-
-/**
- * This implementation processes input from the most to the least significant bit (Bit 0 is the least
- * significant (rightmost)). This way, we can skip some passes in the end at the cost of having an unsorted output.
- */
-template <typename T, int BitsPerPass>
-__device__ int constexpr calcsStartBit(int pass)
-{
-    int startBit = static_cast<int>(sizeof(T) * 8) - (pass + 1) * BitsPerPass;
-    if (startBit < 0)
-    {
-        startBit = 0;
-    }
-    return startBit;
-}
-
-template <typename T, int BitsPerPass>
-__device__ unsigned constexpr calcMask(int pass)
-{
-    static_assert(BitsPerPass <= 31);
-    int numBits = calcsStartBit<T, BitsPerPass>(pass - 1) - calcsStartBit<T, BitsPerPass>(pass);
-    return (1 << numBits) - 1;
-}
-
-/**
- * Use CUB to twiddle bits.
- */
-template <typename T>
-__device__ typename cub::Traits<T>::UnsignedBits twiddleIn(T key, bool selectMin)
-{
-    auto bits = reinterpret_cast<typename cub::Traits<T>::UnsignedBits&>(key);
-    bits = cub::Traits<T>::TwiddleIn(bits);
-    if (!selectMin)
-    {
-        bits = ~bits;
-    }
-    return bits;
-}
-
-template <typename T>
-__device__ T twiddleOut(typename cub::Traits<T>::UnsignedBits bits, bool selectMin)
-{
-    if (!selectMin)
-    {
-        bits = ~bits;
-    }
-    bits = cub::Traits<T>::TwiddleOut(bits);
-    return reinterpret_cast<T&>(bits);
-}
-
-/**
- * Find the bucket based on the radix
- */
-template <typename T, int BitsPerPass>
-__device__ int calcBucket(T x, int startBit, unsigned mask, bool selectMin)
-{
-    static_assert(BitsPerPass <= sizeof(int) * 8 - 1, "BitsPerPass is too large that the result type could not be int");
-    return (twiddleIn(x, selectMin) >> startBit) & mask;
-}
-
 /**
  * This function calculate the bufLen, which is the size of buffer.
  * When the number of candidates for next pass exceeds the bufLen, we choose not to store the candidates. Otherwise, we
@@ -501,40 +410,6 @@ __device__ void chooseBucket(
     }
 }
 
-/**
- * Computes sequenceLength, finished state, outputLogProbs, and cumLogProbs.
- */
-template <typename T, typename IdxT>
-__device__ void epilogue(T const value, IdxT const index, float* outputLogProbs, float* cumLogProbs, IdxT const* endIds,
-    IdxT* sequenceLengths, FinishedState* finishedOutput, int const batchId, int maxBatchSize)
-{
-    if (outputLogProbs != nullptr || cumLogProbs != nullptr)
-    {
-        float res = logf(value);
-        if (outputLogProbs)
-        {
-            outputLogProbs[sequenceLengths[batchId] * maxBatchSize + batchId] = res;
-        }
-        if (cumLogProbs)
-        {
-            cumLogProbs[batchId] += res;
-        }
-    }
-    if (index == endIds[batchId])
-    {
-        if (finishedOutput != nullptr)
-        {
-            finishedOutput[batchId].setFinishedEOS();
-        }
-        // Do not increase seq len when EOS is generated. Seq len should always contain only tokens to be outputted
-    }
-    else
-    {
-        // We don't need to set output finished state as it is assumed to be in non finished state
-        sequenceLengths[batchId] += 1;
-    }
-}
-
 /**
  *  Find the target element.
  *  (steps 4 in `airTopPSampling` description)
@@ -793,7 +668,7 @@ __global__ void airTopPSampling(Counter<T, IdxT, AccT>* counters, AccT* histogra
  */
 template <typename T, typename IdxT, typename AccT, int BitsPerPass, int BlockSize>
 __global__ void airTopPInitialize(Counter<T, IdxT, AccT>* counters, int const batchSize, int const len, T const* in,
-    IdxT const* inIdx, float const topP, float const* topPs, curandState_t* curandstate, AccT* histograms,
+    IdxT const* inIdx, float const topP, float const* topPs, PhiloxState* curandstate, AccT* histograms,
     IdxT* countHistograms, int32_t const* batchSlots)
 {
     auto const batchIdx = blockIdx.x;
@@ -815,7 +690,7 @@ __global__ void airTopPInitialize(Counter<T, IdxT, AccT>* counters, int const ba
         counter->previousLen = len;
 
         float const probThreshold = (topPs != nullptr) ? topPs[batchSlot] : topP;
-        float const randP = curand_uniform(curandstate + batchSlot) * probThreshold;
+        float const randP = philoxUniform(curandstate + batchSlot) * probThreshold;
         counter->p = randP;
         counter->sum = 0;
 
@@ -892,7 +767,7 @@ unsigned calcAirTopPBlockNum(int batchSize, IdxT len, int smCnt)
 template <typename T>
 void invokeBatchAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    T const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    T const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
     int const* endIds, float const maxTopP, float const* topPs, cudaStream_t stream, int blockNum,
     bool const* skipDecode, int32_t const* batchSlots)
 {
@@ -962,20 +837,20 @@ void invokeBatchAirTopPSampling(void* workspace, size_t& workspaceSize, int** ou
 
 template void invokeBatchAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    float const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize,
+    float const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize,
     size_t const vocabSizePadded, int const* endIds, float const maxTopP, float const* topPs, cudaStream_t stream,
     int blockNum, bool const* skipDecode, int32_t const* batchSlots);
 
 template void invokeBatchAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    half const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize,
+    half const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize,
     size_t const vocabSizePadded, int const* endIds, float const maxTopP, float const* topPs, cudaStream_t stream,
     int blockNum, bool const* skipDecode, int32_t const* batchSlots);
 
 template <typename T>
 void invokeAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    T const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    T const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
     int const* endIds, float const topP, cudaStream_t stream, int blockNum, bool const* skipDecode,
     int32_t const* batchSlots)
 {
@@ -986,13 +861,13 @@ void invokeAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputI
 
 template void invokeAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    float const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize,
+    float const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize,
     size_t const vocabSizePadded, int const* endIds, float const topP, cudaStream_t stream, int blockNum,
     bool const* skipDecode, int32_t const* batchSlots);
 
 template void invokeAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    half const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize,
+    half const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize,
     size_t const vocabSizePadded, int const* endIds, float const topP, cudaStream_t stream, int blockNum,
     bool const* skipDecode, int32_t const* batchSlots);
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/samplingMinPKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
+
+#include <cuda_fp16.h>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template <typename T, int BlockSize>
+__global__ void minPSampling(int** outputIds, int* sequenceLengths, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const maxBatchSize, int const vocabSize, int const* endIds, float const* minPs,
+    bool const* skipDecode, int32_t const* batchSlots)
+{
+    using BlockReduce = cub::BlockReduce<float, BlockSize>;
+    __shared__ typename BlockReduce::TempStorage tempStorage;
+    __shared__ float sThreshold;
+    __shared__ float sRandomMass;
+
+    auto const batchIdx = static_cast<int>(blockIdx.x);
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+
+    // Skip kernel if this sampling method is not chosen
+    FinishedState const finishState = finishedInput != nullptr ? finishedInput[batchSlot] : FinishedState::empty();
+    if ((skipDecode != nullptr && skipDecode[batchSlot]) || finishState.isSkipDecoding())
+    {
+        return;
+    }
+
+    // Exit early if sequence has finished
+    if (finishState.isFinished())
+    {
+        if (threadIdx.x == 0)
+        {
+            if (finishedOutput != nullptr)
+            {
+                finishedOutput[batchSlot] = finishState;
+            }
+            outputIds[batchSlot][sequenceLengths[batchSlot]] = endIds[batchSlot];
+        }
+        return;
+    }
+
+    T const* rowProbs = probs + static_cast<size_t>(batchIdx) * vocabSize;
+
+    float localMaxProb = 0.f;
+    for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+    {
+        localMaxProb = fmaxf(localMaxProb, static_cast<float>(rowProbs[tokenId]));
+    }
+    float const maxProb = BlockReduce(tempStorage).Reduce(localMaxProb, cub::Max());
+    if (threadIdx.x == 0)
+    {
+        sThreshold = minPs[batchSlot] * maxProb;
+    }
+    __syncthreads();
+
+    float const threshold = sThreshold;
+    auto keep = [rowProbs, threshold](int tokenId)
+    {
+        float const prob = static_cast<float>(rowProbs[tokenId]);
+        return prob > 0.f && prob >= threshold;
+    };
+
+    float localKeptMass = 0.f;
+    for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+    {
+        if (keep(tokenId))
+        {
+            localKeptMass += static_cast<float>(rowProbs[tokenId]);
+        }
+    }
+    float const keptMass = BlockReduce(tempStorage).Sum(localKeptMass);
+    if (threadIdx.x == 0)
+    {
+        sRandomMass = philoxUniform(curandState + batchSlot) * keptMass;
+    }
+    __syncthreads();
+
+    auto const tokenId = sampleKeptToken<T, BlockSize>(rowProbs, vocabSize, sRandomMass, keep);
+    if (threadIdx.x == 0)
+    {
+        outputIds[batchSlot][sequenceLengths[batchSlot]] = tokenId;
+        epilogue(static_cast<float>(rowProbs[tokenId]), tokenId, outputLogProbs, cumLogProbs, endIds, sequenceLengths,
+            finishedOutput, batchSlot, maxBatchSize);
+    }
+}
+
+template <typename T>
+void invokeBatchMinPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* minPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots)
+{
+    int constexpr SAMPLING_BLOCK_SIZE = 256;
+
+    minPSampling<T, SAMPLING_BLOCK_SIZE><<<batchSize, SAMPLING_BLOCK_SIZE, 0, stream>>>(outputIds, sequenceLength,
+        finishedInput, finishedOutput, cumLogProbs, outputLogProbs, probs, curandState, maxBatchSize,
+        static_cast<int>(vocabSizePadded), endIds, minPs, skipDecode, batchSlots);
+    sync_check_cuda_error();
+}
+
+template void invokeBatchMinPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, float const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* minPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots);
+
+template void invokeBatchMinPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, half const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* minPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots);
+
+} // namespace kernels
+} // namespace tensorrt_llm
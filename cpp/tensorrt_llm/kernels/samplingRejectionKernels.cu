@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/samplingRejectionKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
+
+#include <cuda_fp16.h>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Upper bound of resampling rounds before falling back to greedy search. Every rejection removes the sampled token
+// and all less likely tokens from the candidates, so the bound is rarely reached.
+static int constexpr kMaxRejectionRounds = 32;
+
+template <typename T, int BlockSize>
+__global__ void rejectionTopKTopPSampling(int** outputIds, int* sequenceLengths, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const maxBatchSize, int const vocabSize, int const* endIds,
+    std::uint32_t const maxTopK, std::uint32_t const* topKs, float const maxTopP, float const* topPs,
+    bool const* skipDecode, int32_t const* batchSlots)
+{
+    using ArgMax = cub::KeyValuePair<int, float>;
+    using BlockReduce = cub::BlockReduce<float, BlockSize>;
+    using BlockReduceInt = cub::BlockReduce<int, BlockSize>;
+    using BlockReduceArgMax = cub::BlockReduce<ArgMax, BlockSize>;
+    __shared__ union
+    {
+        typename BlockReduce::TempStorage reduce;
+        typename BlockReduceInt::TempStorage reduceInt;
+        typename BlockReduceArgMax::TempStorage reduceArgMax;
+    } tempStorage;
+    __shared__ float sRandomMass;
+    __shared__ int sTokenId;
+    __shared__ bool sAccepted;
+
+    auto const batchIdx = static_cast<int>(blockIdx.x);
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+
+    // Skip kernel if this sampling method is not chosen
+    FinishedState const finishState = finishedInput != nullptr ? finishedInput[batchSlot] : FinishedState::empty();
+    if ((skipDecode != nullptr && skipDecode[batchSlot]) || finishState.isSkipDecoding())
+    {
+        return;
+    }
+
+    // Exit early if sequence has finished
+    if (finishState.isFinished())
+    {
+        if (threadIdx.x == 0)
+        {
+            if (finishedOutput != nullptr)
+            {
+                finishedOutput[batchSlot] = finishState;
+            }
+            outputIds[batchSlot][sequenceLengths[batchSlot]] = endIds[batchSlot];
+        }
+        return;
+    }
+
+    T const* rowProbs = probs + static_cast<size_t>(batchIdx) * vocabSize;
+    auto const topK = static_cast<int>(topKs != nullptr ? topKs[batchSlot] : maxTopK);
+    float const topP = topPs != nullptr ? topPs[batchSlot] : maxTopP;
+
+    // The most likely token is always accepted and is the fallback if too many samples were rejected.
+    ArgMax localArgMax{-1, -1.f};
+    for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+    {
+        float const prob = static_cast<float>(rowProbs[tokenId]);
+        if (prob > localArgMax.value)
+        {
+            localArgMax = {tokenId, prob};
+        }
+    }
+    ArgMax const argMax = BlockReduceArgMax(tempStorage.reduceArgMax).Reduce(localArgMax, cub::ArgMax());
+    if (threadIdx.x == 0)
+    {
+        sTokenId = argMax.key;
+        sAccepted = false;
+    }
+    __syncthreads();
+
+    // Tokens with a probability not above the pivot are known to be outside of the top K / top P set.
+    float pivot = 0.f;
+    for (int round = 0; round < kMaxRejectionRounds; ++round)
+    {
+        auto keep = [rowProbs, pivot](int tokenId) { return static_cast<float>(rowProbs[tokenId]) > pivot; };
+
+        float localMass = 0.f;
+        for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+        {
+            if (keep(tokenId))
+            {
+                localMass += static_cast<float>(rowProbs[tokenId]);
+            }
+        }
+        float const keptMass = BlockReduce(tempStorage.reduce).Sum(localMass);
+        if (threadIdx.x == 0)
+        {
+            sRandomMass = philoxUniform(curandState + batchSlot) * keptMass;
+        }
+        __syncthreads();
+
+        auto const candidateId = sampleKeptToken<T, BlockSize>(rowProbs, vocabSize, sRandomMass, keep);
+        float const candidateProb = static_cast<float>(rowProbs[candidateId]);
+
+        // A token is part of the top K / top P set if less than K tokens and less than P of the mass are more likely.
+        float localMassAbove = 0.f;
+        int localCountAbove = 0;
+        for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+        {
+            float const prob = static_cast<float>(rowProbs[tokenId]);
+            if (prob > candidateProb)
+            {
+                localMassAbove += prob;
+                ++localCountAbove;
+            }
+        }
+        float const massAbove = BlockReduce(tempStorage.reduce).Sum(localMassAbove);
+        __syncthreads();
+        int const countAbove = BlockReduceInt(tempStorage.reduceInt).Sum(localCountAbove);
+        if (threadIdx.x == 0 && massAbove < topP && (topK <= 0 || countAbove < topK))
+        {
+            sTokenId = candidateId;
+            sAccepted = true;
+        }
+        __syncthreads();
+        if (sAccepted)
+        {
+            break;
+        }
+        pivot = candidateProb;
+    }
+
+    if (threadIdx.x == 0)
+    {
+        auto const tokenId = sTokenId;
+        outputIds[batchSlot][sequenceLengths[batchSlot]] = tokenId;
+        epilogue(static_cast<float>(rowProbs[tokenId]), tokenId, outputLogProbs, cumLogProbs, endIds, sequenceLengths,
+            finishedOutput, batchSlot, maxBatchSize);
+    }
+}
+
+template <typename T>
+void invokeBatchRejectionTopKTopPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, std::uint32_t maxTopK, std::uint32_t const* topKs, float maxTopP, float const* topPs,
+    cudaStream_t stream, bool const* skipDecode, int32_t const* batchSlots)
+{
+    int constexpr SAMPLING_BLOCK_SIZE = 512;
+
+    rejectionTopKTopPSampling<T, SAMPLING_BLOCK_SIZE><<<batchSize, SAMPLING_BLOCK_SIZE, 0, stream>>>(outputIds,
+        sequenceLength, finishedInput, finishedOutput, cumLogProbs, outputLogProbs, probs, curandState, maxBatchSize,
+        static_cast<int>(vocabSizePadded), endIds, maxTopK, topKs, maxTopP, topPs, skipDecode, batchSlots);
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_REJECTION_SAMPLING(T)                                                                              \
+    template void invokeBatchRejectionTopKTopPSampling(int** outputIds, int* sequenceLength,                           \
+        FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,  \
+        T const* probs, PhiloxState* curandState, int const batchSize, int maxBatchSize,                             \
+        size_t const vocabSizePadded, int const* endIds, std::uint32_t maxTopK, std::uint32_t const* topKs,            \
+        float maxTopP, float const* topPs, cudaStream_t stream, bool const* skipDecode, int32_t const* batchSlots);
+
+INSTANTIATE_REJECTION_SAMPLING(float);
+INSTANTIATE_REJECTION_SAMPLING(half);
+
+#undef INSTANTIATE_REJECTION_SAMPLING
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include <curand_kernel.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+//! \brief Given probs, performs top K and / or top P sampling without sorting the vocabulary.
+//! Iterative rejection sampling: a token is sampled from the tokens with a probability above a pivot, if it is not
+//! part of the top K / top P set, its probability becomes the new pivot and the resampling starts again. The accepted
+//! token follows the renormalized top K / top P distribution. Every round is a few block-wide passes over the
+//! vocabulary with a single block per request, so nothing is written to global memory besides the outputs.
+//! If no token was accepted after a fixed number of rounds, the most likely token is taken.
+//! Fills sampled tokens to outputIds. Computes sequenceLength, finished state, cumLogProbs inplace.
+//! Sampling per request can be controlled using skipDecode, topKs and topPs parameters.
+//!
+//! \param outputIds output buffer [maxBatchSize][maxSeqLen]. Contains pointers to rows with output tokens per
+//! request
+//! \param sequenceLength input/output buffer [maxBatchSize]. Current sequence length of the request up to, but
+//! excluding endId token
+//! \param finishedInput input buffer [maxBatchSize]. If true, request exits early.
+//! \param finishedOutput output buffer [maxBatchSize]. Set flag if sequence has finished (if finished || outputId ==
+//! endId).
+//! \param cumLogProbs input/output buffer [maxBatchSize]. Cumulative log probability of selected tokens. Ignored if
+//! nullptr
+//! \param outputLogProbs output buffer [maxSeqLen, maxBatchSize]. Log probability of the selected token under the full
+//! distribution. Ignored if nullptr
+//! \param probs input buffer [batchSize x vocabSizePadded]. Probabilities of each token in the vocab, i.e. softmax
+//! has to be applied before.
+//! \param curandState input buffer [maxBatchSize]. Curand states properly initialized using invokeCurandInitialize
+//! per request.
+//! \param batchSize batch size
+//! \param maxBatchSize max batch size
+//! \param vocabSizePadded size of padded vocab
+//! \param endIds input buffer [maxBatchSize]. EOS token ids per request
+//! \param maxTopK K used for all requests if topKs is nullptr. 0 disables top K filtering.
+//! \param topKs input buffer [maxBatchSize], optional. K for top K sampling per request, 0 disables top K filtering.
+//! \param maxTopP P used for all requests if topPs is nullptr.
+//! \param topPs input buffer [maxBatchSize], optional. P for top P sampling per request in range (0.0, 1.0].
+//! \param stream cuda stream
+//! \param skipDecode input buffer [maxBatchSize]. Flags whether to skip decoding per request
+//! \param batchSlots input buffer[batchSize], optional. Indices of rows of data in memory pool
+template <typename T>
+void invokeBatchRejectionTopKTopPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, std::uint32_t maxTopK, std::uint32_t const* topKs, float maxTopP, float const* topPs,
+    cudaStream_t stream, bool const* skipDecode, int32_t const* batchSlots);
+
+//! \brief Heuristic whether invokeBatchRejectionTopKTopPSampling is expected to be faster than the sort (or radix
+//! select) based top P sampling.
+//! The rejection sampler uses one block per request, it wins when the batch occupies the device and sorting the
+//! vocabulary is expensive.
+//!
+//! \param batchSize batch size
+//! \param vocabSizePadded size of padded vocab
+//! \param smCount number of multiprocessors on device
+[[nodiscard]] inline bool preferRejectionSampling(int batchSize, size_t vocabSizePadded, int smCount)
+{
+    size_t constexpr kMinVocabSize = 32 * 1024;
+    return vocabSizePadded >= kMinVocabSize && 2 * batchSize >= smCount;
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -28,6 +28,7 @@
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/common/stringUtils.h"
 #include "tensorrt_llm/kernels/samplingTopKKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
 
 using namespace tensorrt_llm::common;
 
@@ -122,7 +123,7 @@ template <typename T, int BLOCK_SIZE_, int BLOCKS_PER_BEAM_>
 __global__ void topKStage2Sampling(const int* __restrict topKTmpIdBuf, T* topKTmpValBuf, int** ids,
     int* sequenceLengths, const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, const int maxTopK, const int* topKs, const float topP, const float* topPs,
-    curandState_t* curandstate, const int* endIds, const int vocabSize, const bool* skipDecode, const int* batchSlots,
+    PhiloxState* curandstate, const int* endIds, const int vocabSize, const bool* skipDecode, const int* batchSlots,
     int maxBatchSize, const bool normalizeLogProbs, const bool logitHasProbs)
 {
     bool const IS_FP16 = std::is_same<T, half>::value;
@@ -199,7 +200,7 @@ __global__ void topKStage2Sampling(const int* __restrict topKTmpIdBuf, T* topKTm
 
     if (tid == 0)
     {
-        float randNum = (float) curand_uniform(curandstate + batchSlot) * probThreshold * s_sum;
+        float randNum = (float) philoxUniform(curandstate + batchSlot) * probThreshold * s_sum;
         for (int i = 0; i < k; i++)
         {
             float expLogit = s_val2[i];
@@ -265,7 +266,7 @@ __global__ void topKStage2Sampling(const int* __restrict topKTmpIdBuf, T* topKTm
 template <typename T>
 void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, const T* logProbs, int** ids, int* sequenceLengths,
     const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    curandState_t* curandstate, const int maxTopK, const int* topKs, const float topP, const float* topPs,
+    PhiloxState* curandstate, const int maxTopK, const int* topKs, const float topP, const float* topPs,
     const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream, const int batchSize,
     int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs, const bool logitsHasProbs)
 {
@@ -330,14 +331,14 @@ void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, const T* lo
 
 template void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, const float* logProbs, int** ids,
     int* sequenceLengths, const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
-    float* outputLogProbs, curandState_t* curandstate, const int maxTopK, const int* topKs, const float topP,
+    float* outputLogProbs, PhiloxState* curandstate, const int maxTopK, const int* topKs, const float topP,
     const float* topPs, const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream,
     const int batchSize, int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs,
     const bool logitsHasProbs);
 
 template void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, const half* logProbs, int** ids,
     int* sequenceLengths, const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
-    float* outputLogProbs, curandState_t* curandstate, const int maxTopK, const int* topKs, const float topP,
+    float* outputLogProbs, PhiloxState* curandstate, const int maxTopK, const int* topKs, const float topP,
     const float* topPs, const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream,
     const int batchSize, int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs,
     const bool logitsHasProbs);
@@ -345,7 +346,7 @@ template void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, co
 template <typename T>
 void invokeTopKSampling(void* workspace, size_t& workspaceSize, const T* logProbs, int** ids, int* sequenceLengths,
     const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    curandState_t* curandstate, const int topK, const float topP, const int vocabSizePadded, const int* endIds,
+    PhiloxState* curandstate, const int topK, const float topP, const int vocabSizePadded, const int* endIds,
     const int* batchSlots, cudaStream_t stream, const int batchSize, int maxBatchSize, const bool* skipDecode,
     const bool normalizeLogProbs, const bool logitsHasProbs)
 {
@@ -356,15 +357,185 @@ void invokeTopKSampling(void* workspace, size_t& workspaceSize, const T* logProb
 
 template void invokeTopKSampling(void* workspace, size_t& workspaceSize, const float* logProbs, int** ids,
     int* sequenceLengths, const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
-    float* outputLogProbs, curandState_t* curandstate, const int topK, const float topP, const int vocabSizePadded,
+    float* outputLogProbs, PhiloxState* curandstate, const int topK, const float topP, const int vocabSizePadded,
     const int* endIds, const int* batchSlots, cudaStream_t stream, const int batchSize, int maxBatchSize,
     const bool* skipDecode, const bool normalizeLogProbs, const bool logitsHasProbs);
 
 template void invokeTopKSampling(void* workspace, size_t& workspaceSize, const half* logProbs, int** ids,
     int* sequenceLengths, const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
-    float* outputLogProbs, curandState_t* curandstate, const int topK, const float topP, const int vocabSizePadded,
+    float* outputLogProbs, PhiloxState* curandstate, const int topK, const float topP, const int vocabSizePadded,
     const int* endIds, const int* batchSlots, cudaStream_t stream, const int batchSize, int maxBatchSize,
     const bool* skipDecode, const bool normalizeLogProbs, const bool logitsHasProbs);
 
+namespace
+{
+// Running argmax of a row, with the sum of exp(x - maxVal) when the log-sum-exp is needed
+struct GreedyPartial
+{
+    float maxVal;
+    int maxIdx;
+    float sumExp;
+};
+
+struct GreedyReduceOp
+{
+    __device__ __forceinline__ GreedyPartial operator()(GreedyPartial const& a, GreedyPartial const& b) const
+    {
+        GreedyPartial out;
+        bool const takeB = b.maxVal > a.maxVal || (b.maxVal == a.maxVal && b.maxIdx >= 0 && b.maxIdx < a.maxIdx)
+            || a.maxIdx < 0;
+        out.maxVal = takeB ? b.maxVal : a.maxVal;
+        out.maxIdx = takeB ? b.maxIdx : a.maxIdx;
+        out.sumExp = (a.maxIdx < 0 ? 0.f : a.sumExp * __expf(a.maxVal - out.maxVal))
+            + (b.maxIdx < 0 ? 0.f : b.sumExp * __expf(b.maxVal - out.maxVal));
+        return out;
+    }
+};
+
+template <bool COMPUTE_SUM>
+__device__ __forceinline__ void greedyInsert(GreedyPartial& partial, float val, int idx)
+{
+    // NaN never compares larger, a row of NaN keeps maxIdx at -1
+    if (val > partial.maxVal)
+    {
+        if (COMPUTE_SUM)
+        {
+            partial.sumExp = partial.maxIdx < 0 ? 1.f : partial.sumExp * __expf(partial.maxVal - val) + 1.f;
+        }
+        partial.maxVal = val;
+        partial.maxIdx = idx;
+    }
+    else if (COMPUTE_SUM && partial.maxIdx >= 0)
+    {
+        partial.sumExp += __expf(val - partial.maxVal);
+    }
+}
+
+template <typename T, int BLOCK_SIZE, bool COMPUTE_SUM>
+__global__ void __launch_bounds__(BLOCK_SIZE) batchGreedySearch(const T* __restrict logProbs, int** ids,
+    int* sequenceLengths, const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
+    float* outputLogProbs, const int* topKs, const int vocabSize, const int* endIds, const int* batchSlots,
+    int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs, const bool logitHasProbs)
+{
+    auto const batchIdx = blockIdx.x;
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+    FinishedState const finishState = finishedInput != nullptr ? finishedInput[batchSlot] : FinishedState::empty();
+    if ((skipDecode != nullptr && skipDecode[batchSlot]) || finishState.isSkipDecoding()
+        || (topKs != nullptr && topKs[batchSlot] != 1))
+    {
+        return;
+    }
+    if (finishState.isFinished())
+    {
+        if (threadIdx.x == 0 && finishedOutput != nullptr)
+        {
+            finishedOutput[batchSlot] = finishState;
+        }
+        return;
+    }
+
+    GreedyPartial partial{-INFINITY, -1, 0.f};
+    T const* row = logProbs + static_cast<size_t>(batchIdx) * vocabSize;
+    auto constexpr kVecSize = static_cast<int>(sizeof(uint4) / sizeof(T));
+    if (vocabSize % kVecSize == 0)
+    {
+        // Rows of a multiple of 16 bytes keep the alignment of the buffer
+        auto const* rowVec = reinterpret_cast<uint4 const*>(row);
+        for (int vecIdx = threadIdx.x; vecIdx < vocabSize / kVecSize; vecIdx += BLOCK_SIZE)
+        {
+            uint4 const packed = rowVec[vecIdx];
+            T const* vals = reinterpret_cast<T const*>(&packed);
+#pragma unroll
+            for (int i = 0; i < kVecSize; ++i)
+            {
+                greedyInsert<COMPUTE_SUM>(partial, static_cast<float>(vals[i]), vecIdx * kVecSize + i);
+            }
+        }
+    }
+    else
+    {
+        for (int idx = threadIdx.x; idx < vocabSize; idx += BLOCK_SIZE)
+        {
+            greedyInsert<COMPUTE_SUM>(partial, static_cast<float>(row[idx]), idx);
+        }
+    }
+
+    typedef cub::BlockReduce<GreedyPartial, BLOCK_SIZE> BlockReduce;
+    __shared__ typename BlockReduce::TempStorage tempStorage;
+    GreedyPartial const total = BlockReduce(tempStorage).Reduce(partial, GreedyReduceOp{});
+
+    if (threadIdx.x == 0)
+    {
+        // As in top K sampling, NaN logits select the last token of the vocabulary
+        auto const outputId = total.maxIdx >= 0 ? total.maxIdx : vocabSize - 1;
+        auto const curSeqLen = sequenceLengths[batchSlot];
+        ids[batchSlot][curSeqLen] = outputId;
+        if (cumLogProbs != nullptr || outputLogProbs != nullptr)
+        {
+            float const logProb = logitHasProbs ? logf(total.maxVal) : -logf(total.sumExp);
+            if (cumLogProbs != nullptr)
+            {
+                cumLogProbs[batchSlot] += logProb;
+            }
+            if (outputLogProbs != nullptr)
+            {
+                // Normalized to the top 1, the selected token has probability 1
+                outputLogProbs[curSeqLen * maxBatchSize + batchSlot] = normalizeLogProbs ? 0.f : logProb;
+            }
+        }
+        if (finishedOutput != nullptr)
+        {
+            if (outputId == endIds[batchSlot])
+            {
+                finishedOutput[batchSlot].setFinishedEOS();
+            }
+            else
+            {
+                sequenceLengths[batchSlot] += 1;
+            }
+        }
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeBatchGreedySearch(const T* logProbs, int** ids, int* sequenceLengths, const FinishedState* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, const int* topKs,
+    const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream, const int batchSize,
+    int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs, const bool logitsHasProbs)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    int constexpr kBlockSize = 256;
+    // The log-sum-exp is only needed for log probs of logits, probabilities give them directly
+    bool const computeSum = !logitsHasProbs && (cumLogProbs != nullptr || outputLogProbs != nullptr);
+    if (computeSum)
+    {
+        batchGreedySearch<T, kBlockSize, true><<<batchSize, kBlockSize, 0, stream>>>(logProbs, ids, sequenceLengths,
+            finishedInput, finishedOutput, cumLogProbs, outputLogProbs, topKs, vocabSizePadded, endIds, batchSlots,
+            maxBatchSize, skipDecode, normalizeLogProbs, logitsHasProbs);
+    }
+    else
+    {
+        batchGreedySearch<T, kBlockSize, false><<<batchSize, kBlockSize, 0, stream>>>(logProbs, ids, sequenceLengths,
+            finishedInput, finishedOutput, cumLogProbs, outputLogProbs, topKs, vocabSizePadded, endIds, batchSlots,
+            maxBatchSize, skipDecode, normalizeLogProbs, logitsHasProbs);
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeBatchGreedySearch(const float* logProbs, int** ids, int* sequenceLengths,
+    const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
+    const int* topKs, const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream,
+    const int batchSize, int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs,
+    const bool logitsHasProbs);
+
+template void invokeBatchGreedySearch(const half* logProbs, int** ids, int* sequenceLengths,
+    const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
+    const int* topKs, const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream,
+    const int batchSize, int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs,
+    const bool logitsHasProbs);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -67,7 +67,7 @@ namespace kernels
 template <typename T>
 void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, const T* logProbs, int** ids, int* sequenceLengths,
     const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    curandState_t* curandstate, const int maxTopK, const int* topKs, const float topP, const float* topPs,
+    PhiloxState* curandstate, const int maxTopK, const int* topKs, const float topP, const float* topPs,
     const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream, const int batchSize,
     int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs, const bool logitsHasProbs);
 
@@ -75,9 +75,25 @@ void invokeBatchTopKSampling(void* workspace, size_t& workspaceSize, const T* lo
 template <typename T>
 void invokeTopKSampling(void* workspace, size_t& workspaceSize, const T* logProbs, int** outputIds, int* sequenceLength,
     const FinishedState* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    curandState_t* curandstate, const int topK, const float topP, const int vocabSizePadded, const int* endIds,
+    PhiloxState* curandstate, const int topK, const float topP, const int vocabSizePadded, const int* endIds,
     const int* batchSlots, cudaStream_t stream, const int batchSize, int maxBatchSize, const bool* skipDecode,
     const bool normalizeLogProbs, const bool logitsHasProbs);
 
+//! \brief Greedy fast path of invokeBatchTopKSampling for the requests with K=1. Picks the token with the largest
+//! logit in a single vectorized pass over the vocabulary, without the workspace, the random states and the sorting of
+//! top K. Produces the same outputs, sequence lengths, finished states and log probs as top K sampling with K=1. When
+//! logProbs contains logits and log probs are requested, the log-sum-exp is computed in the same pass, so the softmax
+//! over the vocabulary can be skipped. Ties go to the smallest token id.
+//!
+//! \param topKs input buffer [maxBatchSize], optional. Only requests with topKs[slot] == 1 are decoded, the others are
+//! left to invokeBatchTopKSampling. If nullptr, all requests are decoded.
+//! \param skipDecode input buffer [maxBatchSize], optional. Flags whether to skip decoding per request
+//! All other parameters are the same as in invokeBatchTopKSampling.
+template <typename T>
+void invokeBatchGreedySearch(const T* logProbs, int** ids, int* sequenceLengths, const FinishedState* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, const int* topKs,
+    const int vocabSizePadded, const int* endIds, const int* batchSlots, cudaStream_t stream, const int batchSize,
+    int maxBatchSize, const bool* skipDecode, const bool normalizeLogProbs, const bool logitsHasProbs);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -26,6 +26,7 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/kernels/samplingTopPKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
 
 using namespace tensorrt_llm::common;
 
@@ -199,7 +200,7 @@ __device__ void epilogue(int batchId, int currentStep, int offset, int** ids, in
 template <typename T, int blockSize>
 __global__ void topPSsampling(T* sortedLogProbs, int* sortedIdVals, int** ids, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    int const* beginOffsetBuf, int const* offsetBuf, int const vocabSize, curandState_t* curandstate, float const topP,
+    int const* beginOffsetBuf, int const* offsetBuf, int const vocabSize, PhiloxState* curandstate, float const topP,
     float const* topPs, int const* endIds, int maxBatchSize, bool const* skipDecode, int const* batchSlots)
 {
     /**
@@ -247,7 +248,7 @@ __global__ void topPSsampling(T* sortedLogProbs, int* sortedIdVals, int** ids, i
     // will choose the token which probability makes cumulative probability sum to exceed P'
     if (threadIdx.x == 0)
     {
-        randNumS = curand_uniform(curandstate + blockIdx.x) * probThreshold;
+        randNumS = philoxUniform(curandstate + blockIdx.x) * probThreshold;
     }
 
     // if beginOffsetBuf and offsetBuf of sorting have same value,
@@ -308,7 +309,7 @@ template <typename T>
 void invokeBatchTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize, int** outputIds,
     int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, T const* logProbs, int const* idVals, int* offsetBuf, int* beginOffsetBuf,
-    curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
+    PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
     float const maxTopP, float const* topPs, cudaStream_t stream, bool const* skipDecode, int const* batchSlots)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
@@ -364,14 +365,14 @@ void invokeBatchTopPSampling(void* workspace, size_t& workspaceSize, size_t& cub
 template void invokeBatchTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize,
     int** outputIds, int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput,
     float* cumLogProbs, float* outputLogProbs, float const* logProbs, int const* idVals, int* offsetBuf,
-    int* beginOffsetBuf, curandState_t* curandstate, int const batchSize, int maxBatchSize,
+    int* beginOffsetBuf, PhiloxState* curandstate, int const batchSize, int maxBatchSize,
     size_t const vocabSizePadded, int const* endIds, float const maxTopP, float const* topPs, cudaStream_t stream,
     bool const* skipDecode, int const* batchSlots);
 
 template void invokeBatchTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize,
     int** outputIds, int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput,
     float* cumLogProbs, float* outputLogProbs, half const* logProbs, int const* idVals, int* offsetBuf,
-    int* beginOffsetBuf, curandState_t* curandstate, int const batchSize, int maxBatchSize,
+    int* beginOffsetBuf, PhiloxState* curandstate, int const batchSize, int maxBatchSize,
     size_t const vocabSizePadded, int const* endIds, float const maxTopP, float const* topPs, cudaStream_t stream,
     bool const* skipDecode, int const* batchSlots);
 
@@ -379,7 +380,7 @@ template <typename T>
 void invokeTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize, int** outputIds,
     int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, T const* logProbs, int const* idVals, int* offsetBuf, int* beginOffsetBuf,
-    curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
+    PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
     float const topP, cudaStream_t stream, bool const* skipDecode, int const* batchSlots)
 {
     invokeBatchTopPSampling(workspace, workspaceSize, cubTempStorageSize, outputIds, sequenceLength, finishedInput,
@@ -390,13 +391,13 @@ void invokeTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempS
 template void invokeTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize, int** outputIds,
     int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, float const* logProbs, int const* idVals, int* offsetBuf, int* beginOffsetBuf,
-    curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
+    PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
     float const topP, cudaStream_t stream, bool const* skipDecode, int const* batchSlots);
 
 template void invokeTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize, int** outputIds,
     int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, half const* logProbs, int const* idVals, int* offsetBuf, int* beginOffsetBuf,
-    curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
+    PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
     float const topP, cudaStream_t stream, bool const* skipDecode, int const* batchSlots);
 
 __global__ void computeToppDecay(float* runtimeTopP, float const* runtimeInitialTopP, int const** outputIds,
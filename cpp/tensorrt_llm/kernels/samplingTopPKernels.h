@@ -78,7 +78,7 @@ template <typename T>
 void invokeBatchTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize, int** outputIds,
     int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, T const* logProbs, int const* idVals, int* offsetBuf, int* beginOffsetBuf,
-    curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
+    PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
     float const maxTopP, float const* topPs, cudaStream_t stream, bool const* skipDecode, int const* batchSlots);
 
 //! \brief Specialization of invokeBatchTopPSampling with topPs=nullptr
@@ -86,7 +86,7 @@ template <typename T>
 void invokeTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempStorageSize, int** outputIds,
     int* sequenceLength, FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs,
     float* outputLogProbs, T const* logProbs, int const* idVals, int* offsetBuf, int* beginOffsetBuf,
-    curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
+    PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded, int const* endIds,
     float const topPp, cudaStream_t stream, bool const* skipDecode, int const* batchSlots);
 
 //! \brief Given logProbs, performs top P sampling.
@@ -130,7 +130,7 @@ void invokeTopPSampling(void* workspace, size_t& workspaceSize, size_t& cubTempS
 template <typename T>
 void invokeBatchAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    T const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    T const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
     int const* endIds, float const maxTopP, float const* topPs, cudaStream_t stream, int blockNum,
     bool const* skipDecode, int32_t const* batchSlots);
 
@@ -138,7 +138,7 @@ void invokeBatchAirTopPSampling(void* workspace, size_t& workspaceSize, int** ou
 template <typename T>
 void invokeAirTopPSampling(void* workspace, size_t& workspaceSize, int** outputIds, int* sequenceLength,
     FinishedState const* finishedInput, FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs,
-    T const* logProbs, curandState_t* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    T const* logProbs, PhiloxState* curandstate, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
     int const* endIds, float const topP, cudaStream_t stream, int blockNum, bool const* skipDecode,
     int32_t const* batchSlots);
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/samplingTypicalPKernels.h"
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
+
+#include <cuda_fp16.h>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template <typename T, int BlockSize>
+__global__ void typicalPSampling(int** outputIds, int* sequenceLengths, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const maxBatchSize, int const vocabSize, int const* endIds,
+    float const* typicalPs, bool const* skipDecode, int32_t const* batchSlots)
+{
+    using Bits = typename cub::Traits<float>::UnsignedBits;
+    int constexpr BitsPerPass = 8;
+    int constexpr numBuckets = calcNumBuckets<BitsPerPass>();
+    int constexpr numPasses = calcNumPasses<float, BitsPerPass>();
+
+    using BlockReduce = cub::BlockReduce<float, BlockSize>;
+    __shared__ typename BlockReduce::TempStorage tempStorage;
+    __shared__ float sHistogram[numBuckets];
+    __shared__ float sEntropy;
+    __shared__ float sBelowMass;
+    __shared__ float sRandomMass;
+    __shared__ Bits sKthValueBits;
+
+    auto const batchIdx = static_cast<int>(blockIdx.x);
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+
+    // Skip kernel if this sampling method is not chosen
+    FinishedState const finishState = finishedInput != nullptr ? finishedInput[batchSlot] : FinishedState::empty();
+    if ((skipDecode != nullptr && skipDecode[batchSlot]) || finishState.isSkipDecoding())
+    {
+        return;
+    }
+
+    // Exit early if sequence has finished
+    if (finishState.isFinished())
+    {
+        if (threadIdx.x == 0)
+        {
+            if (finishedOutput != nullptr)
+            {
+                finishedOutput[batchSlot] = finishState;
+            }
+            outputIds[batchSlot][sequenceLengths[batchSlot]] = endIds[batchSlot];
+        }
+        return;
+    }
+
+    T const* rowProbs = probs + static_cast<size_t>(batchIdx) * vocabSize;
+    float const typicalP = typicalPs[batchSlot];
+
+    float localEntropy = 0.f;
+    for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+    {
+        float const prob = static_cast<float>(rowProbs[tokenId]);
+        if (prob > 0.f)
+        {
+            localEntropy -= prob * __logf(prob);
+        }
+    }
+    // Only valid in thread 0
+    float const blockEntropy = BlockReduce(tempStorage).Sum(localEntropy);
+    if (threadIdx.x == 0)
+    {
+        sEntropy = blockEntropy;
+        sBelowMass = 0.f;
+        sKthValueBits = 0;
+    }
+    __syncthreads();
+
+    // Distances are non-negative, the most typical tokens are the ones with the smallest radix.
+    auto distanceBits = [rowProbs, entropy = sEntropy](int tokenId)
+    {
+        float const prob = static_cast<float>(rowProbs[tokenId]);
+        return twiddleIn(fabsf(-__logf(prob) - entropy), /* selectMin */ true);
+    };
+
+    // Radix select of the distance at which the cumulative mass of the most typical tokens reaches typicalP,
+    // from the most to the least significant digit. A pass builds the histogram of the probability mass of the
+    // tokens matching the digits selected so far and picks the bucket in which typicalP is reached.
+    if (typicalP < 1.f)
+    {
+        for (int pass = 0; pass < numPasses; ++pass)
+        {
+            for (int bucket = threadIdx.x; bucket < numBuckets; bucket += BlockSize)
+            {
+                sHistogram[bucket] = 0.f;
+            }
+            __syncthreads();
+
+            int const startBit = calcsStartBit<float, BitsPerPass>(pass);
+            int const previousStartBit = calcsStartBit<float, BitsPerPass>(pass - 1);
+            unsigned const mask = calcMask<float, BitsPerPass>(pass);
+            Bits const kthValueBits = sKthValueBits;
+            for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+            {
+                float const prob = static_cast<float>(rowProbs[tokenId]);
+                if (prob <= 0.f)
+                {
+                    continue;
+                }
+                auto const bits = distanceBits(tokenId);
+                if (pass == 0 || ((bits ^ kthValueBits) >> previousStartBit) == 0)
+                {
+                    atomicAdd(&sHistogram[(bits >> startBit) & mask], prob);
+                }
+            }
+            __syncthreads();
+
+            if (threadIdx.x == 0)
+            {
+                float belowMass = sBelowMass;
+                int bucket = 0;
+                for (; bucket < numBuckets - 1; ++bucket)
+                {
+                    if (sHistogram[bucket] > 0.f && belowMass + sHistogram[bucket] >= typicalP)
+                    {
+                        break;
+                    }
+                    belowMass += sHistogram[bucket];
+                }
+                sBelowMass = belowMass;
+                sKthValueBits = kthValueBits | (static_cast<Bits>(bucket) << startBit);
+            }
+            __syncthreads();
+        }
+    }
+
+    bool const keepAll = typicalP >= 1.f;
+    Bits const kthValueBits = sKthValueBits;
+    auto keep = [rowProbs, keepAll, kthValueBits, distanceBits](int tokenId)
+    { return static_cast<float>(rowProbs[tokenId]) > 0.f && (keepAll || distanceBits(tokenId) <= kthValueBits); };
+
+    float localKeptMass = 0.f;
+    for (int tokenId = threadIdx.x; tokenId < vocabSize; tokenId += BlockSize)
+    {
+        if (keep(tokenId))
+        {
+            localKeptMass += static_cast<float>(rowProbs[tokenId]);
+        }
+    }
+    float const keptMass = BlockReduce(tempStorage).Sum(localKeptMass);
+    if (threadIdx.x == 0)
+    {
+        sRandomMass = philoxUniform(curandState + batchSlot) * keptMass;
+    }
+    __syncthreads();
+
+    auto const tokenId = sampleKeptToken<T, BlockSize>(rowProbs, vocabSize, sRandomMass, keep);
+    if (threadIdx.x == 0)
+    {
+        outputIds[batchSlot][sequenceLengths[batchSlot]] = tokenId;
+        epilogue(static_cast<float>(rowProbs[tokenId]), tokenId, outputLogProbs, cumLogProbs, endIds, sequenceLengths,
+            finishedOutput, batchSlot, maxBatchSize);
+    }
+}
+
+template <typename T>
+void invokeBatchTypicalPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* typicalPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots)
+{
+    int constexpr SAMPLING_BLOCK_SIZE = 256;
+
+    typicalPSampling<T, SAMPLING_BLOCK_SIZE><<<batchSize, SAMPLING_BLOCK_SIZE, 0, stream>>>(outputIds, sequenceLength,
+        finishedInput, finishedOutput, cumLogProbs, outputLogProbs, probs, curandState, maxBatchSize,
+        static_cast<int>(vocabSizePadded), endIds, typicalPs, skipDecode, batchSlots);
+    sync_check_cuda_error();
+}
+
+template void invokeBatchTypicalPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, float const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* typicalPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots);
+
+template void invokeBatchTypicalPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, half const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* typicalPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots);
+
+} // namespace kernels
+} // namespace tensorrt_llm
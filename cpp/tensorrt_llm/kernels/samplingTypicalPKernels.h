@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include <curand_kernel.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+//! \brief Given probs, performs locally typical sampling (https://arxiv.org/abs/2202.00666).
+//! Tokens are ordered by the distance of their information content -log(p) to the entropy of the distribution.
+//! The smallest set of the most typical tokens whose cumulative probability reaches typicalP is kept, the sampled
+//! token is drawn from the renormalized distribution over the kept tokens.
+//! The typical set is found with a radix select over the distances, like the AIR top-p kernel does over the probs.
+//! Computes sequenceLength, finished state, cumLogProbs inplace.
+//! Sampling per request can be controlled using skipDecode and typicalPs parameters.
+//!
+//! \param outputIds output buffer [maxBatchSize][maxSeqLen]. Contains pointers to rows with output tokens per
+//! request
+//! \param sequenceLength input/output buffer [maxBatchSize]. Current sequence length of the request up to, but
+//! excluding endId token
+//! \param finishedInput input buffer [maxBatchSize]. If true, request exits early.
+//! \param finishedOutput output buffer [maxBatchSize]. Set flag if sequence has finished (if finished || outputId ==
+//! endId).
+//! \param cumLogProbs input/output buffer [maxBatchSize]. Cumulative log probability of selected tokens. Ignored if
+//! nullptr
+//! \param outputLogProbs output buffer [maxSeqLen, maxBatchSize]. Log probability of the selected token under the full
+//! distribution. Ignored if nullptr
+//! \param probs input buffer [batchSize x vocabSizePadded]. Probabilities of each token in the vocab, i.e. softmax
+//! has to be applied before.
+//! \param curandState input buffer [maxBatchSize]. Curand states properly initialized using invokeCurandInitialize
+//! per request.
+//! \param batchSize batch size
+//! \param maxBatchSize max batch size
+//! \param vocabSizePadded size of padded vocab
+//! \param endIds input buffer [maxBatchSize]. EOS token ids per request
+//! \param typicalPs input buffer [maxBatchSize]. Probability mass of the typical set per request, in range
+//! (0.0, 1.0]. 1.0 samples from the full distribution.
+//! \param stream cuda stream
+//! \param skipDecode input buffer [maxBatchSize]. Flags whether to skip decoding per request
+//! \param batchSlots input buffer[batchSize], optional. Indices of rows of data in memory pool
+template <typename T>
+void invokeBatchTypicalPSampling(int** outputIds, int* sequenceLength, FinishedState const* finishedInput,
+    FinishedState* finishedOutput, float* cumLogProbs, float* outputLogProbs, T const* probs,
+    PhiloxState* curandState, int const batchSize, int maxBatchSize, size_t const vocabSizePadded,
+    int const* endIds, float const* typicalPs, cudaStream_t stream, bool const* skipDecode,
+    int32_t const* batchSlots);
+
+} // namespace kernels
+} // namespace tensorrt_llm
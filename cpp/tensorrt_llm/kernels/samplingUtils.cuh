@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+#include "tensorrt_llm/kernels/decodingCommon.h"
+
+// Device helpers shared by the radix select based sampling kernels (AIR top-p, typical-p) and the other
+// single-pass sampling kernels.
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+//! \brief Draw 32 random bits from a state initialized with invokeCurandInitialize, advances the state.
+__device__ __forceinline__ uint32_t philoxRandom(PhiloxState* state)
+{
+    auto const counter = state->counter++;
+    // The draw index is the counter, the upper words are reserved for sub-streams of the same seed
+    uint4 const ctr{static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0u, 0u};
+    return curand_Philox4x32_10(ctr, state->key).x;
+}
+
+//! \brief Draw a float uniformly distributed in (0, 1], same range as curand_uniform.
+__device__ __forceinline__ float philoxUniform(PhiloxState* state)
+{
+    return _curand_uniform(philoxRandom(state));
+}
+
+//! \brief Provide a ceiling division operation ie. ceil(a / b)
+//! \tparam IntType supposed to be only integers for now!
+template <typename IntType>
+constexpr __host__ __device__ IntType ceilDiv(IntType a, IntType b)
+{
+    return (a + b - 1) / b;
+}
+
+//! \brief Provide an alignment function ie. ceil(a / b) * b
+//! \tparam IntType supposed to be only integers for now!
+template <typename IntType>
+constexpr __host__ __device__ IntType alignTo(IntType a, IntType b)
+{
+    return ceilDiv(a, b) * b;
+}
+
+//! \brief Calcute the number of buckets based on the number of bits per pass.
+//! \tparam BitsPerPass. If BitsPerPass==11, the number of buckets is 2048. If BitsPerPass==8, the number of buckets is
+//! 256.
+template <int BitsPerPass>
+__host__ __device__ int constexpr calcNumBuckets()
+{
+    return 1 << BitsPerPass;
+}
+
+//! \brief Calcute the number of passes based on the number of bits per pass.
+//! \tparam BitsPerPass. If BitsPerPass==11, the number of passes is 3. If BitsPerPass==8, the number of passes is 4.
+template <typename T, int BitsPerPass>
+__host__ __device__ int constexpr calcNumPasses()
+{
+    return ceilDiv<int>(sizeof(T) * 8, BitsPerPass);
+}
+
+/**
+ * This implementation processes input from the most to the least significant bit (Bit 0 is the least
+ * significant (rightmost)). This way, we can skip some passes in the end at the cost of having an unsorted output.
+ */
+template <typename T, int BitsPerPass>
+__device__ int constexpr calcsStartBit(int pass)
+{
+    int startBit = static_cast<int>(sizeof(T) * 8) - (pass + 1) * BitsPerPass;
+    if (startBit < 0)
+    {
+        startBit = 0;
+    }
+    return startBit;
+}
+
+template <typename T, int BitsPerPass>
+__device__ unsigned constexpr calcMask(int pass)
+{
+    static_assert(BitsPerPass <= 31);
+    int numBits = calcsStartBit<T, BitsPerPass>(pass - 1) - calcsStartBit<T, BitsPerPass>(pass);
+    return (1 << numBits) - 1;
+}
+
+/**
+ * Use CUB to twiddle bits.
+ */
+template <typename T>
+__device__ typename cub::Traits<T>::UnsignedBits twiddleIn(T key, bool selectMin)
+{
+    auto bits = reinterpret_cast<typename cub::Traits<T>::UnsignedBits&>(key);
+    bits = cub::Traits<T>::TwiddleIn(bits);
+    if (!selectMin)
+    {
+        bits = ~bits;
+    }
+    return bits;
+}
+
+template <typename T>
+__device__ T twiddleOut(typename cub::Traits<T>::UnsignedBits bits, bool selectMin)
+{
+    if (!selectMin)
+    {
+        bits = ~bits;
+    }
+    bits = cub::Traits<T>::TwiddleOut(bits);
+    return reinterpret_cast<T&>(bits);
+}
+
+/**
+ * Find the bucket based on the radix
+ */
+template <typename T, int BitsPerPass>
+__device__ int calcBucket(T x, int startBit, unsigned mask, bool selectMin)
+{
+    static_assert(BitsPerPass <= sizeof(int) * 8 - 1, "BitsPerPass is too large that the result type could not be int");
+    return (twiddleIn(x, selectMin) >> startBit) & mask;
+}
+
+/**
+ * Computes sequenceLength, finished state, outputLogProbs, and cumLogProbs.
+ */
+template <typename T, typename IdxT>
+__device__ void epilogue(T const value, IdxT const index, float* outputLogProbs, float* cumLogProbs, IdxT const* endIds,
+    IdxT* sequenceLengths, FinishedState* finishedOutput, int const batchId, int maxBatchSize)
+{
+    if (outputLogProbs != nullptr || cumLogProbs != nullptr)
+    {
+        float res = logf(value);
+        if (outputLogProbs)
+        {
+            outputLogProbs[sequenceLengths[batchId] * maxBatchSize + batchId] = res;
+        }
+        if (cumLogProbs)
+        {
+            cumLogProbs[batchId] += res;
+        }
+    }
+    if (index == endIds[batchId])
+    {
+        if (finishedOutput != nullptr)
+        {
+            finishedOutput[batchId].setFinishedEOS();
+        }
+        // Do not increase seq len when EOS is generated. Seq len should always contain only tokens to be outputted
+    }
+    else
+    {
+        // We don't need to set output finished state as it is assumed to be in non finished state
+        sequenceLengths[batchId] += 1;
+    }
+}
+
+//! \brief Sample a token among the tokens of probs accepted by keep.
+//! \details Scans the vocabulary in index order with one block, accumulating the accepted probability mass until it
+//! reaches randomMass. randomMass is expected in (0, keptMass]. Falls back to the last accepted token when the
+//! accumulated mass does not reach randomMass because of rounding. Has to be called by all threads of the block.
+//! \return sampled token id, the same for all threads of the block
+template <typename T, int BlockSize, typename KeepFunc>
+__device__ int sampleKeptToken(T const* probs, int const vocabSize, float const randomMass, KeepFunc keep)
+{
+    using BlockScan = cub::BlockScan<float, BlockSize>;
+    __shared__ typename BlockScan::TempStorage tempStorage;
+    __shared__ float sPrefixMass;
+    __shared__ int sSelected;
+    __shared__ int sLastKept;
+
+    if (threadIdx.x == 0)
+    {
+        sPrefixMass = 0.f;
+        sSelected = -1;
+        sLastKept = -1;
+    }
+    __syncthreads();
+
+    for (int offset = 0; offset < vocabSize; offset += BlockSize)
+    {
+        int const tokenId = offset + threadIdx.x;
+        bool const kept = tokenId < vocabSize && keep(tokenId);
+        float const mass = kept ? static_cast<float>(probs[tokenId]) : 0.f;
+        float cumMass;
+        BlockScan(tempStorage).InclusiveSum(mass, cumMass);
+        cumMass += sPrefixMass;
+        if (kept)
+        {
+            atomicMax(&sLastKept, tokenId);
+            if (mass > 0.f && cumMass >= randomMass && cumMass - mass < randomMass)
+            {
+                sSelected = tokenId;
+            }
+        }
+        __syncthreads();
+        if (threadIdx.x == BlockSize - 1)
+        {
+            sPrefixMass = cumMass;
+        }
+        __syncthreads();
+        if (sSelected >= 0)
+        {
+            break;
+        }
+    }
+    return sSelected >= 0 ? sSelected : sLastKept;
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
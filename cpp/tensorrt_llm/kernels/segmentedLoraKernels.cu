@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/segmentedLoraKernels.h"
+
+#include <cuda_fp16.h>
+#ifdef ENABLE_BF16
+#include <cuda_bf16.h>
+#endif
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+constexpr int kWarpSize = 32;
+// Ranks computed by a block of the shrink kernel, one warp each
+constexpr int kShrinkWarps = 4;
+constexpr int kExpandBlockSize = 256;
+
+template <typename T>
+__device__ inline bool isVectorizable(T const* a, T const* b, int n)
+{
+    constexpr int kVecSize = 16 / sizeof(T);
+    return n % kVecSize == 0 && ((reinterpret_cast<uintptr_t>(a) | reinterpret_cast<uintptr_t>(b)) % 16) == 0;
+}
+
+//! \brief Partial dot product of the elements first, first + stride, ... of a and b.
+template <typename T>
+__device__ inline float stridedDot(T const* a, T const* b, int n, int first, int stride, bool vectorized)
+{
+    float sum = 0.f;
+    if (vectorized)
+    {
+        constexpr int kVecSize = 16 / sizeof(T);
+        for (int i = first * kVecSize; i < n; i += stride * kVecSize)
+        {
+            uint4 const va = *reinterpret_cast<uint4 const*>(a + i);
+            uint4 const vb = *reinterpret_cast<uint4 const*>(b + i);
+            T const* ea = reinterpret_cast<T const*>(&va);
+            T const* eb = reinterpret_cast<T const*>(&vb);
+#pragma unroll
+            for (int j = 0; j < kVecSize; ++j)
+            {
+                sum += static_cast<float>(ea[j]) * static_cast<float>(eb[j]);
+            }
+        }
+    }
+    else
+    {
+        for (int i = first; i < n; i += stride)
+        {
+            sum += static_cast<float>(a[i]) * static_cast<float>(b[i]);
+        }
+    }
+    return sum;
+}
+
+// lowRank[t, r] = input[t, :] . A[r, :], a warp per (token, rank)
+template <typename T>
+__global__ void segmentedLoraShrinkKernel(SegmentedLoraParams params)
+{
+    auto const tokenIdx = static_cast<int>(blockIdx.x);
+    auto const laneIdx = static_cast<int>(threadIdx.x) % kWarpSize;
+    auto const rankIdx = static_cast<int>(blockIdx.y) * kShrinkWarps + static_cast<int>(threadIdx.x) / kWarpSize;
+
+    auto const adapterIdx = params.tokenAdapterIdx[tokenIdx];
+    if (adapterIdx < 0 || rankIdx >= params.adapterRanks[adapterIdx])
+    {
+        return;
+    }
+
+    auto const k = params.inHiddenSize;
+    auto const* weights = reinterpret_cast<T const*>(params.adapterWeightsPtrs[2 * adapterIdx]) + rankIdx * k;
+    auto const* input = static_cast<T const*>(params.input) + static_cast<int64_t>(tokenIdx) * k;
+
+    auto const vectorized = isVectorizable(input, weights, k);
+    auto sum = stridedDot(input, weights, k, laneIdx, kWarpSize, vectorized);
+#pragma unroll
+    for (int mask = kWarpSize / 2; mask > 0; mask >>= 1)
+    {
+        sum += __shfl_xor_sync(0xffffffff, sum, mask);
+    }
+    if (laneIdx == 0)
+    {
+        static_cast<T*>(params.lowRank)[static_cast<int64_t>(tokenIdx) * params.maxLowRank + rankIdx]
+            = static_cast<T>(sum);
+    }
+}
+
+// output[t, n] = lowRank[t, :] . B[n, :], a thread per (token, n). B rows are only rank elements long, so a thread
+// reads a whole row with a few vector loads.
+template <typename T>
+__global__ void segmentedLoraExpandKernel(SegmentedLoraParams params)
+{
+    extern __shared__ __align__(16) char smem[];
+    auto* sLowRank = reinterpret_cast<T*>(smem);
+
+    auto const tokenIdx = static_cast<int>(blockIdx.x);
+    auto const adapterIdx = params.tokenAdapterIdx[tokenIdx];
+    if (adapterIdx < 0)
+    {
+        return;
+    }
+    auto const rank = params.adapterRanks[adapterIdx];
+    if (rank == 0)
+    {
+        return;
+    }
+
+    auto const* lowRank = static_cast<T const*>(params.lowRank) + static_cast<int64_t>(tokenIdx) * params.maxLowRank;
+    for (int r = threadIdx.x; r < rank; r += blockDim.x)
+    {
+        sLowRank[r] = lowRank[r];
+    }
+    __syncthreads();
+
+    auto const n = static_cast<int>(blockIdx.y * blockDim.x + threadIdx.x);
+    if (n >= params.outHiddenSize)
+    {
+        return;
+    }
+    auto const* weights = reinterpret_cast<T const*>(params.adapterWeightsPtrs[2 * adapterIdx + 1]) + n * rank;
+    auto const sum = stridedDot(sLowRank, weights, rank, 0, 1, isVectorizable(sLowRank, weights, rank));
+    static_cast<T*>(params.output)[static_cast<int64_t>(tokenIdx) * params.outHiddenSize + n] = static_cast<T>(sum);
+}
+
+__global__ void buildTokenAdapterIdxKernel(
+    int32_t* tokenAdapterIdx, int32_t const* segmentOffsets, int32_t numSegments, int32_t numTokens)
+{
+    auto const tokenIdx = static_cast<int32_t>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (tokenIdx >= numTokens)
+    {
+        return;
+    }
+    // Last segment starting at or before the token
+    int32_t lo = 0;
+    int32_t hi = numSegments;
+    while (hi - lo > 1)
+    {
+        auto const mid = (lo + hi) / 2;
+        if (segmentOffsets[mid] <= tokenIdx)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    tokenAdapterIdx[tokenIdx] = tokenIdx < segmentOffsets[numSegments] ? lo : -1;
+}
+} // namespace
+
+template <typename T>
+void invokeSegmentedLoraGemm(SegmentedLoraParams const& params, cudaStream_t stream)
+{
+    if (params.numTokens == 0 || params.maxLowRank == 0)
+    {
+        return;
+    }
+    dim3 const shrinkGrid(params.numTokens, divUp(params.maxLowRank, kShrinkWarps));
+    segmentedLoraShrinkKernel<T><<<shrinkGrid, kShrinkWarps * kWarpSize, 0, stream>>>(params);
+
+    dim3 const expandGrid(params.numTokens, divUp(params.outHiddenSize, kExpandBlockSize));
+    // The low rank row is staged in shared memory, padded for the vector loads
+    auto const smemSize = divUp(params.maxLowRank * sizeof(T), 16) * 16;
+    segmentedLoraExpandKernel<T><<<expandGrid, kExpandBlockSize, smemSize, stream>>>(params);
+    sync_check_cuda_error();
+}
+
+void invokeBuildTokenAdapterIdx(int32_t* tokenAdapterIdx, int32_t const* segmentOffsets, int32_t numSegments,
+    int32_t numTokens, cudaStream_t stream)
+{
+    if (numTokens == 0)
+    {
+        return;
+    }
+    constexpr int kBlockSize = 256;
+    buildTokenAdapterIdxKernel<<<divUp(numTokens, kBlockSize), kBlockSize, 0, stream>>>(
+        tokenAdapterIdx, segmentOffsets, numSegments, numTokens);
+    sync_check_cuda_error();
+}
+
+template void invokeSegmentedLoraGemm<float>(SegmentedLoraParams const& params, cudaStream_t stream);
+template void invokeSegmentedLoraGemm<half>(SegmentedLoraParams const& params, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeSegmentedLoraGemm<__nv_bfloat16>(SegmentedLoraParams const& params, cudaStream_t stream);
+#endif
+
+} // namespace kernels
+} // namespace tensorrt_llm
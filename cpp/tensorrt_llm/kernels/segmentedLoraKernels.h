@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+struct SegmentedLoraParams
+{
+    // [numTokens, inHiddenSize]
+    void const* input{nullptr};
+    // [numTokens, outHiddenSize]. Rows of tokens without an adapter are not written.
+    void* output{nullptr};
+    // [numTokens, maxLowRank], scratch for the output of the in weights
+    void* lowRank{nullptr};
+    // [numTokens], adapter of each token, -1 for tokens without LoRA
+    int32_t const* tokenAdapterIdx{nullptr};
+    // [numAdapters], rank of each adapter, 0 disables the adapter
+    int32_t const* adapterRanks{nullptr};
+    // [numAdapters, 2], device addresses of the in weights [rank, inHiddenSize] and of the out weights
+    // [outHiddenSize, rank] of each adapter, as filled by LoraManager::fillInputTensors
+    int64_t const* adapterWeightsPtrs{nullptr};
+
+    int32_t numTokens{0};
+    int32_t inHiddenSize{0};
+    int32_t outHiddenSize{0};
+    int32_t maxLowRank{0};
+};
+
+//! \brief Applies the LoRA adapter of each token, output = (input * A^T) * B^T, gathering the weights per token.
+//! All the descriptors are read on the device, so the launch does not depend on the batch composition on the host
+//! and can be captured in a CUDA graph. Tokens of different adapters and ranks are processed by the same launch,
+//! tokens sharing an adapter read its weights from L2. Meant for decode batches, where every adapter only sees a few
+//! tokens and a grouped GEMM is dominated by its setup.
+template <typename T>
+void invokeSegmentedLoraGemm(SegmentedLoraParams const& params, cudaStream_t stream);
+
+//! \brief Expands segments of tokens to the per token adapter index, tokens [segmentOffsets[i],
+//! segmentOffsets[i + 1]) use adapter i.
+//! \param tokenAdapterIdx output buffer [numTokens]
+//! \param segmentOffsets input buffer [numSegments + 1], on the device
+void invokeBuildTokenAdapterIdx(int32_t* tokenAdapterIdx, int32_t const* segmentOffsets, int32_t numSegments,
+    int32_t numTokens, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
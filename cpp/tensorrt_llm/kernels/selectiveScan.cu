@@ -338,6 +338,220 @@ INSTANTIATE_SELECTIVE_SCAN_DATA_TYPE(__nv_bfloat16, float);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Chunked variant of the context phase. The recurrence state = exp(A * dt) * state + B * dt * x is linear, so the
+// sequence is split into chunks of SCAN_CHUNK_SIZE tokens that are scanned in parallel from a zero state by
+// selective_scan_chunk_state_kernel. The state entering a chunk is the sum of the final states of the previous chunks,
+// each one decayed by exp(A * sum of dt) over the chunks that follow it. selective_scan_chunk_output_kernel combines
+// them and scans its chunk again from that state to produce the outputs. It does about twice the work of the loop
+// kernel, but with num_chunks times more blocks, which pays for long prompts of small batches.
+
+static constexpr int SCAN_CHUNK_SIZE = 256;
+static constexpr int SCAN_CHUNK_THREADS = 128;
+// Below 4 chunks the parallelism does not make up for the extra work
+static constexpr int SCAN_CHUNK_MIN_SEQLEN = 4 * SCAN_CHUNK_SIZE;
+
+__device__ inline float deltaWithSoftplus(float dt, bool dt_softplus)
+{
+    return dt_softplus && dt <= 20.f ? log1pf(__expf(dt)) : dt;
+}
+
+template <typename input_t, typename weight_t, int DSTATE = 16>
+__launch_bounds__(SCAN_CHUNK_THREADS) __global__ void selective_scan_chunk_state_kernel(
+    SSMParamsBase params, int num_chunks, float* chunk_states, float* chunk_dt_sums)
+{
+    input_t const* x = reinterpret_cast<input_t const*>(params.u_ptr);
+    input_t const* dt = reinterpret_cast<input_t const*>(params.delta_ptr);
+    weight_t const* A = reinterpret_cast<weight_t const*>(params.A_ptr);
+    input_t const* B = reinterpret_cast<input_t const*>(params.B_ptr);
+    weight_t const* dt_bias = reinterpret_cast<weight_t const*>(params.delta_bias_ptr);
+    int const num_tokens = params.seqlen;
+    int const num_channels = params.dim;
+
+    int const channel = blockIdx.x * blockDim.x + threadIdx.x;
+    int const chunk = blockIdx.y;
+    int const sample = blockIdx.z;
+    int const token_begin = chunk * SCAN_CHUNK_SIZE;
+    int const token_end = min(token_begin + SCAN_CHUNK_SIZE, num_tokens);
+
+    float A_reg[DSTATE];
+    float state_reg[DSTATE];
+#pragma unroll
+    for (int i = 0; i < DSTATE; i++)
+    {
+        A_reg[i] = toFloat(A[i * num_channels + channel]);
+        state_reg[i] = 0.f;
+    }
+    float const my_dt_bias = dt_bias ? toFloat(dt_bias[channel]) : 0.f;
+
+    float dt_sum = 0.f;
+    for (int token_id = token_begin; token_id < token_end; token_id++)
+    {
+        size_t const row = static_cast<size_t>(sample) * num_tokens + token_id;
+        float const dt_b_sp
+            = deltaWithSoftplus(toFloat(dt[row * num_channels + channel]) + my_dt_bias, params.delta_softplus);
+        float const dtx = dt_b_sp * toFloat(x[row * num_channels + channel]);
+        dt_sum += dt_b_sp;
+#pragma unroll
+        for (int i = 0; i < DSTATE; i++)
+        {
+            state_reg[i] = __expf(A_reg[i] * dt_b_sp) * state_reg[i] + toFloat(B[row * DSTATE + i]) * dtx;
+        }
+    }
+
+    // The last chunk is not stored, no chunk follows it
+    size_t const chunk_row = static_cast<size_t>(sample) * (num_chunks - 1) + chunk;
+#pragma unroll
+    for (int i = 0; i < DSTATE; i++)
+    {
+        chunk_states[(chunk_row * DSTATE + i) * num_channels + channel] = state_reg[i];
+    }
+    chunk_dt_sums[chunk_row * num_channels + channel] = dt_sum;
+}
+
+template <typename input_t, typename weight_t, int DSTATE = 16>
+__launch_bounds__(SCAN_CHUNK_THREADS) __global__ void selective_scan_chunk_output_kernel(
+    SSMParamsBase params, int num_chunks, float const* chunk_states, float const* chunk_dt_sums)
+{
+    input_t* output = reinterpret_cast<input_t*>(params.out_ptr);
+    weight_t* state = reinterpret_cast<weight_t*>(params.x_ptr);
+    input_t const* x = reinterpret_cast<input_t const*>(params.u_ptr);
+    input_t const* dt = reinterpret_cast<input_t const*>(params.delta_ptr);
+    weight_t const* A = reinterpret_cast<weight_t const*>(params.A_ptr);
+    input_t const* B = reinterpret_cast<input_t const*>(params.B_ptr);
+    input_t const* C = reinterpret_cast<input_t const*>(params.C_ptr);
+    weight_t const* D = reinterpret_cast<weight_t const*>(params.D_ptr);
+    input_t const* z = reinterpret_cast<input_t const*>(params.z_ptr);
+    weight_t const* dt_bias = reinterpret_cast<weight_t const*>(params.delta_bias_ptr);
+    int const num_tokens = params.seqlen;
+    int const num_channels = params.dim;
+
+    int const channel = blockIdx.x * blockDim.x + threadIdx.x;
+    int const chunk = blockIdx.y;
+    int const sample = blockIdx.z;
+    int const token_begin = chunk * SCAN_CHUNK_SIZE;
+    int const token_end = min(token_begin + SCAN_CHUNK_SIZE, num_tokens);
+
+    float A_reg[DSTATE];
+    float state_reg[DSTATE];
+#pragma unroll
+    for (int i = 0; i < DSTATE; i++)
+    {
+        A_reg[i] = toFloat(A[i * num_channels + channel]);
+        state_reg[i] = 0.f;
+    }
+
+    // State entering the chunk, from the states of the previous chunks
+    for (int prev = 0; prev < chunk; prev++)
+    {
+        size_t const chunk_row = static_cast<size_t>(sample) * (num_chunks - 1) + prev;
+        float const dt_sum = chunk_dt_sums[chunk_row * num_channels + channel];
+#pragma unroll
+        for (int i = 0; i < DSTATE; i++)
+        {
+            state_reg[i] = __expf(A_reg[i] * dt_sum) * state_reg[i]
+                + chunk_states[(chunk_row * DSTATE + i) * num_channels + channel];
+        }
+    }
+
+    float const my_dt_bias = dt_bias ? toFloat(dt_bias[channel]) : 0.f;
+    float const my_D = D ? toFloat(D[channel]) : 0.f;
+    for (int token_id = token_begin; token_id < token_end; token_id++)
+    {
+        size_t const row = static_cast<size_t>(sample) * num_tokens + token_id;
+        float const dt_b_sp
+            = deltaWithSoftplus(toFloat(dt[row * num_channels + channel]) + my_dt_bias, params.delta_softplus);
+        float const my_x = toFloat(x[row * num_channels + channel]);
+        float const dtx = dt_b_sp * my_x;
+
+        float out = my_D * my_x;
+#pragma unroll
+        for (int i = 0; i < DSTATE; i++)
+        {
+            state_reg[i] = __expf(A_reg[i] * dt_b_sp) * state_reg[i] + toFloat(B[row * DSTATE + i]) * dtx;
+            out += state_reg[i] * toFloat(C[row * DSTATE + i]);
+        }
+
+        if (z)
+        {
+            float const my_z = toFloat(z[row * num_channels + channel]);
+            out *= my_z / (1.f + __expf(-my_z));
+        }
+        convertAndStore(&output[row * num_channels + channel], out);
+    }
+
+    if (chunk == num_chunks - 1)
+    {
+        // Write the new state back out to the cache
+        weight_t* my_state = &state[static_cast<size_t>(sample) * num_channels * DSTATE];
+#pragma unroll
+        for (int i = 0; i < DSTATE; i++)
+        {
+            convertAndStore(&my_state[i * num_channels + channel], state_reg[i]);
+        }
+    }
+}
+
+bool useSelectiveScanChunked(int batch, int dim, int seqlen)
+{
+    if (seqlen < SCAN_CHUNK_MIN_SEQLEN)
+    {
+        return false;
+    }
+    // The loop kernel runs one block per SM, it is latency bound when its blocks do not fill the GPU
+    static int const multiProcessorCount = tensorrt_llm::common::getMultiProcessorCount();
+    return batch * static_cast<int>(tensorrt_llm::common::divUp(dim, 128)) < multiProcessorCount;
+}
+
+size_t getSelectiveScanChunkedWorkspaceSize(int batch, int dim, int seqlen, int dstate)
+{
+    if (seqlen < SCAN_CHUNK_MIN_SEQLEN)
+    {
+        return 0;
+    }
+    auto const num_chunks = tensorrt_llm::common::divUp(seqlen, SCAN_CHUNK_SIZE);
+    return static_cast<size_t>(batch) * (num_chunks - 1) * (dstate + 1) * dim * sizeof(float);
+}
+
+template <typename input_t, typename weight_t>
+void invokeSelectiveScanChunked(SSMParamsBase& params, void* workspace, cudaStream_t stream)
+{
+    int const samples = params.batch;
+    int const channels = params.dim;
+    int const num_chunks = tensorrt_llm::common::divUp(params.seqlen, SCAN_CHUNK_SIZE);
+
+    TLLM_CHECK((channels % SCAN_CHUNK_THREADS) == 0);
+    TLLM_CHECK(params.is_variable_B);
+    TLLM_CHECK(params.is_variable_C);
+    TLLM_CHECK(params.dstate == 16);
+    TLLM_CHECK(num_chunks == 1 || workspace != nullptr);
+
+    auto* chunk_states = static_cast<float*>(workspace);
+    auto* chunk_dt_sums = chunk_states + static_cast<size_t>(samples) * (num_chunks - 1) * params.dstate * channels;
+    int const blocks = channels / SCAN_CHUNK_THREADS;
+    if (num_chunks > 1)
+    {
+        dim3 grid(blocks, num_chunks - 1, samples);
+        selective_scan_chunk_state_kernel<input_t, weight_t>
+            <<<grid, SCAN_CHUNK_THREADS, 0, stream>>>(params, num_chunks, chunk_states, chunk_dt_sums);
+    }
+    dim3 grid(blocks, num_chunks, samples);
+    selective_scan_chunk_output_kernel<input_t, weight_t>
+        <<<grid, SCAN_CHUNK_THREADS, 0, stream>>>(params, num_chunks, chunk_states, chunk_dt_sums);
+}
+
+#define INSTANTIATE_SELECTIVE_SCAN_CHUNKED_DATA_TYPE(input_t, weight_t)                                                \
+    template void invokeSelectiveScanChunked<input_t, weight_t>(                                                      \
+        SSMParamsBase & params, void* workspace, cudaStream_t stream);
+
+INSTANTIATE_SELECTIVE_SCAN_CHUNKED_DATA_TYPE(float, float);
+INSTANTIATE_SELECTIVE_SCAN_CHUNKED_DATA_TYPE(half, float);
+#ifdef ENABLE_BF16
+INSTANTIATE_SELECTIVE_SCAN_CHUNKED_DATA_TYPE(__nv_bfloat16, float);
+#endif
+#undef INSTANTIATE_SELECTIVE_SCAN_CHUNKED_DATA_TYPE
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 template <typename input_t, typename weight_t, int DSTATE = 16, int CHANNELS_PER_BLOCK = 128>
 __launch_bounds__(128, 2) __global__ void selective_scan_update_kernel(SSMParamsBase params)
 {
@@ -445,5 +659,136 @@ INSTANTIATE_SELECTIVE_SCAN_UPDATE_DATA_TYPE(__nv_bfloat16, float);
 #endif
 #undef INSTANTIATE_SELECTIVE_SCAN_UPDATE_DATA_TYPE
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// SiLU of the causal conv of one conv channel at token position, whose input is current. The inputs of the previous
+// tokens are read from the circular conv state.
+template <typename input_t>
+__device__ inline float causalConvSilu(input_t const* conv_weight, input_t const* conv_bias, input_t const* conv_state,
+    int conv_channel, int conv_channels, int dconv, int position, float current)
+{
+    float acc = conv_bias ? toFloat(conv_bias[conv_channel]) : 0.f;
+    for (int k = 0; k < dconv - 1; k++)
+    {
+        int const token = position - (dconv - 1) + k;
+        if (token >= 0)
+        {
+            acc += toFloat(conv_weight[k * conv_channels + conv_channel])
+                * toFloat(conv_state[(token % dconv) * conv_channels + conv_channel]);
+        }
+    }
+    acc += toFloat(conv_weight[(dconv - 1) * conv_channels + conv_channel]) * current;
+    return acc / (1.f + __expf(-acc));
+}
+
+template <typename input_t, typename weight_t, int DSTATE = 16, int CHANNELS_PER_BLOCK = 128>
+__launch_bounds__(CHANNELS_PER_BLOCK) __global__ void selective_scan_fused_conv_update_kernel(SSMParamsBase params)
+{
+    input_t* output = reinterpret_cast<input_t*>(params.out_ptr);
+    weight_t* state = reinterpret_cast<weight_t*>(params.x_ptr);
+    input_t const* x = reinterpret_cast<input_t const*>(params.u_ptr);
+    input_t const* dt = reinterpret_cast<input_t const*>(params.delta_ptr);
+    weight_t const* A = reinterpret_cast<weight_t const*>(params.A_ptr);
+    input_t const* B = reinterpret_cast<input_t const*>(params.B_ptr);
+    input_t const* C = reinterpret_cast<input_t const*>(params.C_ptr);
+    weight_t const* D = reinterpret_cast<weight_t const*>(params.D_ptr);
+    input_t const* z = reinterpret_cast<input_t const*>(params.z_ptr);
+    weight_t const* dt_bias = reinterpret_cast<weight_t const*>(params.delta_bias_ptr);
+    input_t const* conv_weight = reinterpret_cast<input_t const*>(params.conv_weight_ptr);
+    input_t const* conv_bias = reinterpret_cast<input_t const*>(params.conv_bias_ptr);
+    input_t* conv_state = reinterpret_cast<input_t*>(params.conv_state_ptr);
+    int const num_channels = params.dim;
+    int const conv_channels = num_channels + 2 * DSTATE;
+    int const dconv = params.dconv;
+
+    int const channel = blockIdx.x * blockDim.x + threadIdx.x;
+    int const sample = blockIdx.y;
+    int const slot = params.slot_ids_ptr ? params.slot_ids_ptr[sample] : sample;
+    int const position = params.positions_ptr[sample];
+    input_t* my_conv_state = &conv_state[static_cast<size_t>(slot) * dconv * conv_channels];
+    // Index of the current token in the circular conv state, it holds the input of token position - dconv, which is
+    // out of the window and not read by any block
+    int const conv_index = position % dconv;
+
+    // Every block needs all of B and C, their conv is cheap enough to be repeated, only the first block updates
+    // their conv state
+    __shared__ float sh_B[DSTATE];
+    __shared__ float sh_C[DSTATE];
+    if (threadIdx.x < 2 * DSTATE)
+    {
+        int const i = threadIdx.x % DSTATE;
+        input_t const current = threadIdx.x < DSTATE ? B[sample * DSTATE + i] : C[sample * DSTATE + i];
+        int const conv_channel = num_channels + threadIdx.x;
+        float const value = causalConvSilu(
+            conv_weight, conv_bias, my_conv_state, conv_channel, conv_channels, dconv, position, toFloat(current));
+        (threadIdx.x < DSTATE ? sh_B : sh_C)[i] = value;
+        if (blockIdx.x == 0)
+        {
+            my_conv_state[conv_index * conv_channels + conv_channel] = current;
+        }
+    }
+    __syncthreads();
+    if (channel >= num_channels)
+        return;
+
+    input_t const raw_x = x[sample * num_channels + channel];
+    float const my_x = causalConvSilu(
+        conv_weight, conv_bias, my_conv_state, channel, conv_channels, dconv, position, toFloat(raw_x));
+    my_conv_state[conv_index * conv_channels + channel] = raw_x;
+
+    float const my_dt_bias = dt_bias ? toFloat(dt_bias[channel]) : 0.f;
+    float const dt_b_sp
+        = deltaWithSoftplus(toFloat(dt[sample * num_channels + channel]) + my_dt_bias, params.delta_softplus);
+    float const dtx = dt_b_sp * my_x;
+
+    weight_t* my_state = &state[static_cast<size_t>(slot) * num_channels * DSTATE];
+    float out = D ? toFloat(D[channel]) * my_x : 0.f;
+#pragma unroll
+    for (int i = 0; i < DSTATE; i++)
+    {
+        float const new_state
+            = __expf(toFloat(A[i * num_channels + channel]) * dt_b_sp) * toFloat(my_state[i * num_channels + channel])
+            + sh_B[i] * dtx;
+        convertAndStore(&my_state[i * num_channels + channel], new_state);
+        out += new_state * sh_C[i];
+    }
+
+    if (z)
+    {
+        float const my_z = toFloat(z[sample * num_channels + channel]);
+        out *= my_z / (1.f + __expf(-my_z));
+    }
+    convertAndStore(&output[sample * num_channels + channel], out);
+}
+
+template <typename input_t, typename weight_t>
+void invokeSelectiveScanFusedConvUpdate(SSMParamsBase& params, cudaStream_t stream)
+{
+    int const samples = params.batch;
+    int const channels = params.dim;
+
+    int const threads = 128;
+    dim3 block(threads);
+    dim3 grid(tensorrt_llm::common::divUp(channels, threads), samples);
+
+    TLLM_CHECK(params.is_variable_B);
+    TLLM_CHECK(params.is_variable_C);
+    TLLM_CHECK(params.dstate == 16);
+    TLLM_CHECK(params.dconv > 0);
+    TLLM_CHECK(params.conv_weight_ptr != nullptr && params.conv_state_ptr != nullptr);
+    TLLM_CHECK(params.positions_ptr != nullptr);
+    selective_scan_fused_conv_update_kernel<input_t, weight_t><<<grid, block, 0, stream>>>(params);
+}
+
+#define INSTANTIATE_SELECTIVE_SCAN_FUSED_CONV_UPDATE_DATA_TYPE(input_t, weight_t)                                      \
+    template void invokeSelectiveScanFusedConvUpdate<input_t, weight_t>(SSMParamsBase & params, cudaStream_t stream)
+
+INSTANTIATE_SELECTIVE_SCAN_FUSED_CONV_UPDATE_DATA_TYPE(float, float);
+INSTANTIATE_SELECTIVE_SCAN_FUSED_CONV_UPDATE_DATA_TYPE(half, float);
+#ifdef ENABLE_BF16
+INSTANTIATE_SELECTIVE_SCAN_FUSED_CONV_UPDATE_DATA_TYPE(__nv_bfloat16, float);
+#endif
+#undef INSTANTIATE_SELECTIVE_SCAN_FUSED_CONV_UPDATE_DATA_TYPE
+
 } // namespace kernels
 } // namespace tensorrt_llm
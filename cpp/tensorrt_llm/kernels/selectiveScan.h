@@ -59,6 +59,16 @@ struct SSMParamsBase
     void* __restrict__ out_ptr;
     void* __restrict__ x_ptr;
     void* __restrict__ z_ptr;
+
+    // Fused causal conv1d of the generation step, see invokeSelectiveScanFusedConvUpdate.
+    int dconv;
+    void* __restrict__ conv_weight_ptr;
+    void* __restrict__ conv_bias_ptr;
+    void* __restrict__ conv_state_ptr;
+    // State slot of each sample, the sample index when null
+    int const* __restrict__ slot_ids_ptr;
+    // Number of tokens of each sample before the current one
+    int const* __restrict__ positions_ptr;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -66,7 +76,25 @@ struct SSMParamsBase
 template <typename input_t, typename weight_t>
 void invokeSelectiveScan(SSMParamsBase& params, cudaStream_t stream);
 
+// Chunked parallel scan of the context phase, for long sequences of small batches.
+bool useSelectiveScanChunked(int batch, int dim, int seqlen);
+
+// Bytes of workspace of invokeSelectiveScanChunked, 0 when it would not be used for seqlen.
+size_t getSelectiveScanChunkedWorkspaceSize(int batch, int dim, int seqlen, int dstate);
+
+template <typename input_t, typename weight_t>
+void invokeSelectiveScanChunked(SSMParamsBase& params, void* workspace, cudaStream_t stream);
+
 template <typename input_t, typename weight_t>
 void invokeSelectiveScanUpdate(SSMParamsBase& params, cudaStream_t stream);
+
+// Generation step of a layer whose x, B and C go through a depthwise causal conv1d of width dconv before the scan, as
+// in Mamba-2. Applies the conv, SiLU, the discretization and the state update in one kernel.
+// u_ptr, B_ptr and C_ptr are the inputs of the conv, [batch, dim] and [batch, dstate]. The conv weights are
+// [dconv, dim + 2 * dstate] and the conv state [slots, dconv, dim + 2 * dstate] is a circular buffer: the input of
+// token t is kept at index t % dconv, so the window is never shifted. The context phase must leave the inputs of the
+// last tokens at the same indices.
+template <typename input_t, typename weight_t>
+void invokeSelectiveScanFusedConvUpdate(SSMParamsBase& params, cudaStream_t stream);
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/sinkAttentionKernels.h"
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+// Tokens of K and V staged in shared memory at a time.
+constexpr int32_t kTileTokens = 16;
+// Each warp attends kQueriesPerWarp queries, so one thread block shares every K/V tile among
+// kWarpsPerBlock * kQueriesPerWarp queries of consecutive tokens and of the query heads of one KV head.
+constexpr int32_t kWarpsPerBlock = 8;
+constexpr int32_t kQueriesPerWarp = 4;
+constexpr int32_t kQueriesPerBlock = kWarpsPerBlock * kQueriesPerWarp;
+
+template <typename T, int32_t HEAD_SIZE>
+__global__ void __launch_bounds__(kWarpsPerBlock * 32) sinkAttentionKernel(SinkAttentionParams params)
+{
+    constexpr int32_t kEltsPerLane = HEAD_SIZE / 32;
+
+    __shared__ T kTile[kTileTokens][HEAD_SIZE];
+    __shared__ T vTile[kTileTokens][HEAD_SIZE];
+
+    auto const warpIdx = static_cast<int32_t>(threadIdx.x) / 32;
+    auto const laneIdx = static_cast<int32_t>(threadIdx.x) % 32;
+    auto const kvHeadIdx = static_cast<int32_t>(blockIdx.y);
+    auto const seqIdx = static_cast<int32_t>(blockIdx.z);
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+
+    auto const seqBegin = params.cuSeqLens[seqIdx];
+    auto const seqLen = params.cuSeqLens[seqIdx + 1] - seqBegin;
+    // Queries are ordered by token, then by query head of the KV head.
+    auto const numQueries = seqLen * headsPerKv;
+    auto const queryBegin = static_cast<int32_t>(blockIdx.x) * kQueriesPerBlock;
+    if (queryBegin >= numQueries)
+    {
+        return;
+    }
+
+    auto const tokenOffset = static_cast<size_t>(params.paddedSeqLen > 0 ? seqIdx * params.paddedSeqLen : seqBegin);
+    auto const qkvStride = static_cast<size_t>(params.numQHeads + 2 * params.numKVHeads) * HEAD_SIZE;
+    auto const* qkv = reinterpret_cast<T const*>(params.qkv) + tokenOffset * qkvStride;
+    auto const kOffset = static_cast<size_t>(params.numQHeads + kvHeadIdx) * HEAD_SIZE;
+    auto const vOffset = kOffset + static_cast<size_t>(params.numKVHeads) * HEAD_SIZE;
+
+    auto const sinkLen = min(params.sinkTokenLength, seqLen);
+    // Non-sink tokens of the window, the query token included.
+    auto const recentLen = params.windowSize - params.sinkTokenLength;
+
+    int32_t tokenIdx[kQueriesPerWarp];
+    int32_t qHeadIdx[kQueriesPerWarp];
+    bool isActive[kQueriesPerWarp];
+    float q[kQueriesPerWarp][kEltsPerLane];
+    float acc[kQueriesPerWarp][kEltsPerLane];
+    float rowMax[kQueriesPerWarp];
+    float rowSum[kQueriesPerWarp];
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        auto const queryIdx = queryBegin + qi * kWarpsPerBlock + warpIdx;
+        isActive[qi] = queryIdx < numQueries;
+        tokenIdx[qi] = isActive[qi] ? queryIdx / headsPerKv : 0;
+        qHeadIdx[qi] = kvHeadIdx * headsPerKv + (isActive[qi] ? queryIdx % headsPerKv : 0);
+        auto const* qPtr = qkv + tokenIdx[qi] * qkvStride + static_cast<size_t>(qHeadIdx[qi]) * HEAD_SIZE;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            q[qi][ei] = isActive[qi] ? cuda_cast<float>(qPtr[ei * 32 + laneIdx]) * params.softmaxScale : 0.f;
+            acc[qi][ei] = 0.f;
+        }
+        rowMax[qi] = -INFINITY;
+        rowSum[qi] = 0.f;
+    }
+
+    // The block reads the sinks and the union of the windows of its tokens, which are consecutive.
+    auto const firstToken = queryBegin / headsPerKv;
+    auto const lastToken = (min(queryBegin + kQueriesPerBlock, numQueries) - 1) / headsPerKv;
+    auto const windowBegin = max(firstToken + 1 - recentLen, sinkLen);
+    int32_t const rangeBegin[2] = {0, windowBegin};
+    int32_t const rangeEnd[2] = {min(sinkLen, windowBegin), lastToken + 1};
+
+    for (int32_t rangeIdx = 0; rangeIdx < 2; ++rangeIdx)
+    {
+        for (int32_t tileBegin = rangeBegin[rangeIdx]; tileBegin < rangeEnd[rangeIdx]; tileBegin += kTileTokens)
+        {
+            auto const tileLen = min(kTileTokens, rangeEnd[rangeIdx] - tileBegin);
+
+            __syncthreads();
+            // Rows past the end of the range are zeroed so that they contribute nothing to the output.
+            for (int32_t idx = threadIdx.x; idx < kTileTokens * HEAD_SIZE; idx += blockDim.x)
+            {
+                auto const tileTokenIdx = idx / HEAD_SIZE;
+                auto const channelIdx = idx % HEAD_SIZE;
+                T kValue = cuda_cast<T>(0.f);
+                T vValue = cuda_cast<T>(0.f);
+                if (tileTokenIdx < tileLen)
+                {
+                    auto const* row = qkv + (tileBegin + tileTokenIdx) * qkvStride;
+                    kValue = row[kOffset + channelIdx];
+                    vValue = row[vOffset + channelIdx];
+                }
+                kTile[tileTokenIdx][channelIdx] = kValue;
+                vTile[tileTokenIdx][channelIdx] = vValue;
+            }
+            __syncthreads();
+
+#pragma unroll
+            for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+            {
+                if (!isActive[qi])
+                {
+                    continue;
+                }
+
+                // Causal, and either a sink or in the recent part of the window of the query.
+                auto const firstRecentToken = tokenIdx[qi] + 1 - recentLen;
+                float scores[kTileTokens];
+                float tileMax = -INFINITY;
+#pragma unroll
+                for (int32_t ti = 0; ti < kTileTokens; ++ti)
+                {
+                    float score = 0.f;
+#pragma unroll
+                    for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                    {
+                        score += q[qi][ei] * cuda_cast<float>(kTile[ti][ei * 32 + laneIdx]);
+                    }
+#pragma unroll
+                    for (int32_t mask = 16; mask > 0; mask >>= 1)
+                    {
+                        score += __shfl_xor_sync(0xffffffff, score, mask);
+                    }
+                    auto const token = tileBegin + ti;
+                    auto const attended = ti < tileLen && token <= tokenIdx[qi]
+                        && (token < sinkLen || token >= firstRecentToken);
+                    scores[ti] = attended ? score : -INFINITY;
+                    tileMax = fmaxf(tileMax, scores[ti]);
+                }
+                // The whole tile is outside of the window of this query.
+                if (tileMax == -INFINITY)
+                {
+                    continue;
+                }
+
+                auto const newMax = fmaxf(rowMax[qi], tileMax);
+                auto const rescale = __expf(rowMax[qi] - newMax);
+                rowMax[qi] = newMax;
+                rowSum[qi] *= rescale;
+#pragma unroll
+                for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                {
+                    acc[qi][ei] *= rescale;
+                }
+#pragma unroll
+                for (int32_t ti = 0; ti < kTileTokens; ++ti)
+                {
+                    auto const p = __expf(scores[ti] - newMax);
+                    rowSum[qi] += p;
+#pragma unroll
+                    for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+                    {
+                        acc[qi][ei] += p * cuda_cast<float>(vTile[ti][ei * 32 + laneIdx]);
+                    }
+                }
+            }
+        }
+    }
+
+    auto* output = reinterpret_cast<T*>(params.output) + tokenOffset * params.numQHeads * HEAD_SIZE;
+#pragma unroll
+    for (int32_t qi = 0; qi < kQueriesPerWarp; ++qi)
+    {
+        if (!isActive[qi])
+        {
+            continue;
+        }
+        auto* outPtr = output + (static_cast<size_t>(tokenIdx[qi]) * params.numQHeads + qHeadIdx[qi]) * HEAD_SIZE;
+#pragma unroll
+        for (int32_t ei = 0; ei < kEltsPerLane; ++ei)
+        {
+            outPtr[ei * 32 + laneIdx] = cuda_cast<T>(acc[qi][ei] / rowSum[qi]);
+        }
+    }
+}
+
+template <typename T, int32_t HEAD_SIZE>
+void launchSinkAttention(SinkAttentionParams const& params, cudaStream_t stream)
+{
+    dim3 const block(kWarpsPerBlock * 32);
+    auto const headsPerKv = params.numQHeads / params.numKVHeads;
+    dim3 const grid(divUp(params.maxSeqLen * headsPerKv, kQueriesPerBlock), params.numKVHeads, params.batchSize);
+    sinkAttentionKernel<T, HEAD_SIZE><<<grid, block, 0, stream>>>(params);
+}
+
+} // namespace
+
+template <typename T>
+void invokeSinkAttention(SinkAttentionParams const& params, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.numQHeads % params.numKVHeads == 0,
+        "The number of query heads must be a multiple of the number of KV heads");
+    TLLM_CHECK_WITH_INFO(params.windowSize > params.sinkTokenLength,
+        "The attention window (%d) must be larger than the number of sink tokens (%d)", params.windowSize,
+        params.sinkTokenLength);
+    switch (params.headSize)
+    {
+    case 32: launchSinkAttention<T, 32>(params, stream); break;
+    case 64: launchSinkAttention<T, 64>(params, stream); break;
+    case 128: launchSinkAttention<T, 128>(params, stream); break;
+    case 256: launchSinkAttention<T, 256>(params, stream); break;
+    default: TLLM_THROW("Sink attention does not support head size %d", params.headSize);
+    }
+    sync_check_cuda_error();
+}
+
+template void invokeSinkAttention<float>(SinkAttentionParams const& params, cudaStream_t stream);
+template void invokeSinkAttention<half>(SinkAttentionParams const& params, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeSinkAttention<__nv_bfloat16>(SinkAttentionParams const& params, cudaStream_t stream);
+#endif
+
+} // namespace kernels
+} // namespace tensorrt_llm
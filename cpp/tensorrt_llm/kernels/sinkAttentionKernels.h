@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Context attention with a sliding window and attention sinks (StreamingLLM). Each query attends to the first
+// sinkTokenLength tokens of its sequence and to the most recent tokens that fit in the rest of the window, the same
+// tokens the cyclic KV cache keeps for the generation steps. Only the K/V tiles of the sinks and of the window are
+// read, so the cost per token is O(windowSize) instead of O(sequence length).
+
+struct SinkAttentionParams
+{
+    // Packed QKV after bias and RoPE, [numTokens, numQHeads + 2 * numKVHeads, headSize]
+    void const* qkv;
+    // Attention output, [numTokens, numQHeads, headSize]
+    void* output;
+    // Prefix sum of the sequence lengths, [batchSize + 1]
+    int32_t const* cuSeqLens;
+    // Distance in tokens between the sequences of a padded input, 0 for a packed input
+    int32_t paddedSeqLen;
+
+    int32_t batchSize;
+    int32_t maxSeqLen;
+    int32_t numQHeads;
+    int32_t numKVHeads;
+    int32_t headSize;
+    // Tokens attended by a query, sinks included
+    int32_t windowSize;
+    int32_t sinkTokenLength;
+    float softmaxScale;
+};
+
+//! \brief Causal attention over the sinks and the sliding window of each token of the context sequences.
+//! \details Supports head sizes 32, 64, 128 and 256. windowSize must be larger than sinkTokenLength.
+template <typename T>
+void invokeSinkAttention(SinkAttentionParams const& params, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
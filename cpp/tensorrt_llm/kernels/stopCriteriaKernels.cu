@@ -26,11 +26,15 @@ namespace kernels
 {
 __global__ void stopWordsCriterion(int32_t const** outputIds, int32_t const** parentIds, int32_t const** stopWords,
     FinishedState* finished, int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t const* stopWordsLens,
-    int32_t batchSize, int32_t beamWidth, int32_t maxSeqLen)
+    int32_t batchSize, int32_t beamWidth, int32_t maxSeqLen, ActiveSlots activeSlots)
 {
     int32_t const id = blockIdx.x * blockDim.x + threadIdx.x;
-    int32_t const batchIdx = blockIdx.y / beamWidth;
+    int32_t batchIdx = blockIdx.y / beamWidth;
     int32_t const beamIdx = blockIdx.y % beamWidth;
+    if (!activeSlots.map(batchIdx))
+    {
+        return;
+    }
     auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
     auto const batchBeamIdx = batchSlot * beamWidth + beamIdx;
 
@@ -91,7 +95,8 @@ __global__ void stopWordsCriterion(int32_t const** outputIds, int32_t const** pa
 
 void invokeStopWordsCriterion(int32_t const** outputIds, int32_t const** parentIds, int32_t const** stopWords,
     FinishedState* finished, int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t const* stopWordsLen,
-    int32_t maxStopWordsLen, int32_t batchSize, int32_t beamWidth, int32_t maxSeqLen, cudaStream_t stream)
+    int32_t maxStopWordsLen, int32_t batchSize, int32_t beamWidth, int32_t maxSeqLen, cudaStream_t stream,
+    ActiveSlots const& activeSlots)
 {
     // Check if we have sampled a word from the stopWords list. If so, stop the sequence.
     dim3 block, grid;
@@ -102,7 +107,7 @@ void invokeStopWordsCriterion(int32_t const** outputIds, int32_t const** parentI
     grid.y = batchSize * beamWidth;
 
     stopWordsCriterion<<<grid, block, 0, stream>>>(outputIds, parentIds, stopWords, finished, sequenceLengths,
-        batchSlots, stopWordsLen, batchSize, beamWidth, maxSeqLen);
+        batchSlots, stopWordsLen, batchSize, beamWidth, maxSeqLen, activeSlots);
     sync_check_cuda_error();
 }
 
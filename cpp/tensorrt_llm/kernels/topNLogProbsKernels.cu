@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/topNLogProbsKernels.h"
+
+#include <cuda_fp16.h>
+
+#include <cfloat>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+using Candidate = cub::KeyValuePair<int32_t, float>;
+
+//! \brief Orders candidates by decreasing value, ties by increasing index. Invalid candidates have key < 0.
+struct CandidateMax
+{
+    __device__ __forceinline__ Candidate operator()(Candidate const& a, Candidate const& b) const
+    {
+        if (a.key < 0)
+        {
+            return b;
+        }
+        if (b.key < 0)
+        {
+            return a;
+        }
+        return (b.value > a.value || (b.value == a.value && b.key < a.key)) ? b : a;
+    }
+};
+
+//! \brief True if the candidate comes after prev in the order of CandidateMax, i.e. has not been selected yet.
+__device__ __forceinline__ bool isAfter(int32_t index, float value, Candidate const& prev)
+{
+    return prev.key < 0 || value < prev.value || (value == prev.value && index > prev.key);
+}
+} // namespace
+
+template <typename T, int BlockSize>
+__global__ void topNLogProbsKernel(int32_t* topNIds, float* topNLogProbs, T const* logits,
+    FinishedState const* finished, int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t beamWidth,
+    int32_t vocabSize, int32_t vocabSizePadded, int32_t maxSeqLen, int32_t topN)
+{
+    using BlockReduce = cub::BlockReduce<float, BlockSize>;
+    using BlockReduceCandidate = cub::BlockReduce<Candidate, BlockSize>;
+    __shared__ union
+    {
+        typename BlockReduce::TempStorage reduce;
+        typename BlockReduceCandidate::TempStorage reduceCandidate;
+    } tempStorage;
+    __shared__ float sMax;
+    __shared__ float sLogSumExp;
+    __shared__ Candidate sPrev;
+
+    auto const batchIdx = static_cast<int32_t>(blockIdx.x) / beamWidth;
+    auto const beamIdx = static_cast<int32_t>(blockIdx.x) % beamWidth;
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+    auto const slotBeamIdx = batchSlot * beamWidth + beamIdx;
+    if (finished != nullptr && finished[slotBeamIdx].isFinished())
+    {
+        return;
+    }
+    auto const step = sequenceLengths[slotBeamIdx];
+    if (step >= maxSeqLen)
+    {
+        return;
+    }
+
+    auto const* rowLogits = logits + static_cast<size_t>(batchIdx * beamWidth + beamIdx) * vocabSizePadded;
+
+    // Log-sum-exp of the row for the normalization of the selected tokens
+    float localMax = -FLT_MAX;
+    for (int32_t vi = threadIdx.x; vi < vocabSize; vi += BlockSize)
+    {
+        localMax = fmaxf(localMax, static_cast<float>(rowLogits[vi]));
+    }
+    float const blockMax = BlockReduce(tempStorage.reduce).Reduce(localMax, cub::Max());
+    if (threadIdx.x == 0)
+    {
+        sMax = blockMax;
+    }
+    __syncthreads();
+
+    float localSum = 0.f;
+    for (int32_t vi = threadIdx.x; vi < vocabSize; vi += BlockSize)
+    {
+        localSum += __expf(static_cast<float>(rowLogits[vi]) - sMax);
+    }
+    __syncthreads();
+    float const blockSum = BlockReduce(tempStorage.reduce).Sum(localSum);
+    if (threadIdx.x == 0)
+    {
+        sLogSumExp = sMax + __logf(blockSum);
+        sPrev = Candidate{-1, 0.f};
+    }
+    __syncthreads();
+
+    // Partial sort by repeated block argmax, each round skips the candidates selected before
+    auto const outputOffset = (static_cast<size_t>(slotBeamIdx) * maxSeqLen + step) * topN;
+    for (int32_t ni = 0; ni < topN; ++ni)
+    {
+        Candidate const prev = sPrev;
+        Candidate local{-1, 0.f};
+        for (int32_t vi = threadIdx.x; vi < vocabSize; vi += BlockSize)
+        {
+            auto const value = static_cast<float>(rowLogits[vi]);
+            if (isAfter(vi, value, prev))
+            {
+                local = CandidateMax()(local, Candidate{vi, value});
+            }
+        }
+        __syncthreads();
+        Candidate const best = BlockReduceCandidate(tempStorage.reduceCandidate).Reduce(local, CandidateMax());
+        if (threadIdx.x == 0)
+        {
+            topNIds[outputOffset + ni] = best.key;
+            topNLogProbs[outputOffset + ni] = best.key < 0 ? -INFINITY : best.value - sLogSumExp;
+            sPrev = best.key < 0 ? prev : best;
+        }
+        __syncthreads();
+    }
+}
+
+template <typename T>
+void invokeTopNLogProbs(int32_t* topNIds, float* topNLogProbs, T const* logits, FinishedState const* finished,
+    int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth, int32_t vocabSize,
+    int32_t vocabSizePadded, int32_t maxSeqLen, int32_t topN, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(0 < topN && topN <= kMaxTopNLogProbs, "topN (%d) must be in range [1, %d]", topN,
+        kMaxTopNLogProbs);
+    constexpr int32_t blockSize{256};
+    dim3 block(blockSize);
+    dim3 grid(batchSize * beamWidth);
+    topNLogProbsKernel<T, blockSize><<<grid, block, 0, stream>>>(topNIds, topNLogProbs, logits, finished,
+        sequenceLengths, batchSlots, beamWidth, vocabSize, vocabSizePadded, maxSeqLen, topN);
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_TOP_N_LOG_PROBS(T)                                                                                 \
+    template void invokeTopNLogProbs(int32_t* topNIds, float* topNLogProbs, T const* logits,                           \
+        FinishedState const* finished, int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t batchSize,   \
+        int32_t beamWidth, int32_t vocabSize, int32_t vocabSizePadded, int32_t maxSeqLen, int32_t topN,                \
+        cudaStream_t stream);
+
+INSTANTIATE_TOP_N_LOG_PROBS(float);
+INSTANTIATE_TOP_N_LOG_PROBS(half);
+
+#undef INSTANTIATE_TOP_N_LOG_PROBS
+
+template <typename T, int BlockSize>
+__global__ void gatherTokenLogProbsKernel(
+    float* logProbs, T const* logits, int32_t const* targetIds, int32_t vocabSize, int32_t vocabSizePadded)
+{
+    using BlockReduce = cub::BlockReduce<float, BlockSize>;
+    __shared__ typename BlockReduce::TempStorage tempStorage;
+    __shared__ float sMax;
+
+    auto const tokenIdx = static_cast<int32_t>(blockIdx.x);
+    auto const targetId = targetIds[tokenIdx];
+    if (targetId < 0 || targetId >= vocabSize)
+    {
+        if (threadIdx.x == 0)
+        {
+            logProbs[tokenIdx] = 0.f;
+        }
+        return;
+    }
+
+    auto const* rowLogits = logits + static_cast<size_t>(tokenIdx) * vocabSizePadded;
+    float localMax = -FLT_MAX;
+    for (int32_t vi = threadIdx.x; vi < vocabSize; vi += BlockSize)
+    {
+        localMax = fmaxf(localMax, static_cast<float>(rowLogits[vi]));
+    }
+    float const blockMax = BlockReduce(tempStorage).Reduce(localMax, cub::Max());
+    if (threadIdx.x == 0)
+    {
+        sMax = blockMax;
+    }
+    __syncthreads();
+
+    float localSum = 0.f;
+    for (int32_t vi = threadIdx.x; vi < vocabSize; vi += BlockSize)
+    {
+        localSum += __expf(static_cast<float>(rowLogits[vi]) - sMax);
+    }
+    __syncthreads();
+    float const blockSum = BlockReduce(tempStorage).Sum(localSum);
+    if (threadIdx.x == 0)
+    {
+        logProbs[tokenIdx] = static_cast<float>(rowLogits[targetId]) - sMax - __logf(blockSum);
+    }
+}
+
+template <typename T>
+void invokeGatherTokenLogProbs(float* logProbs, T const* logits, int32_t const* targetIds, int32_t numTokens,
+    int32_t vocabSize, int32_t vocabSizePadded, cudaStream_t stream)
+{
+    if (numTokens == 0)
+    {
+        return;
+    }
+    constexpr int32_t blockSize{256};
+    dim3 block(blockSize);
+    dim3 grid(numTokens);
+    gatherTokenLogProbsKernel<T, blockSize>
+        <<<grid, block, 0, stream>>>(logProbs, logits, targetIds, vocabSize, vocabSizePadded);
+    sync_check_cuda_error();
+}
+
+template void invokeGatherTokenLogProbs(float* logProbs, float const* logits, int32_t const* targetIds,
+    int32_t numTokens, int32_t vocabSize, int32_t vocabSizePadded, cudaStream_t stream);
+template void invokeGatherTokenLogProbs(float* logProbs, half const* logits, int32_t const* targetIds,
+    int32_t numTokens, int32_t vocabSize, int32_t vocabSizePadded, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Upper bound of the number of alternatives returned per token
+static constexpr int32_t kMaxTopNLogProbs = 20;
+
+//! \brief Computes the N most likely tokens of each request and their log probabilities under the full
+//! distribution, without materializing the log softmax. Results are written at the position of the token that is
+//! sampled from the same logits, i.e. at the current sequence length.
+//!
+//! \param topNIds output buffer [maxBatchSize, beamWidth, maxSeqLen, topN]. Token ids by decreasing probability
+//! \param topNLogProbs output buffer [maxBatchSize, beamWidth, maxSeqLen, topN]. Log probabilities of topNIds
+//! \param logits input buffer [batchSize, beamWidth, vocabSizePadded]. Logits after penalties, before sampling
+//! \param finished input buffer [maxBatchSize, beamWidth], optional. Finished requests are skipped
+//! \param sequenceLengths input buffer [maxBatchSize, beamWidth]. Current sequence length of each beam
+//! \param batchSlots input buffer [batchSize], optional. Indices of rows of data in memory pool
+//! \param batchSize batch size
+//! \param beamWidth beam width
+//! \param vocabSize size of the vocab, padded logits are ignored
+//! \param vocabSizePadded size of the padded vocab
+//! \param maxSeqLen maximum sequence length
+//! \param topN number of alternatives per token, in range [1, kMaxTopNLogProbs]
+//! \param stream cuda stream
+template <typename T>
+void invokeTopNLogProbs(int32_t* topNIds, float* topNLogProbs, T const* logits, FinishedState const* finished,
+    int32_t const* sequenceLengths, int32_t const* batchSlots, int32_t batchSize, int32_t beamWidth, int32_t vocabSize,
+    int32_t vocabSizePadded, int32_t maxSeqLen, int32_t topN, cudaStream_t stream);
+
+//! \brief Computes the log probability of a given target token for each row of logits, e.g. of the continuation of
+//! a scoring request under the context logits of prompt and continuation. The log softmax is not materialized, only
+//! numTokens floats are written.
+//!
+//! \param logProbs output buffer [numTokens]. Log probability of targetIds[ti] under row ti, 0 for skipped rows
+//! \param logits input buffer [numTokens, vocabSizePadded]
+//! \param targetIds input buffer [numTokens]. Token scored with each row, rows with a negative id are skipped
+//! \param numTokens number of rows
+//! \param vocabSize size of the vocab, padded logits are ignored
+//! \param vocabSizePadded size of the padded vocab
+//! \param stream cuda stream
+template <typename T>
+void invokeGatherTokenLogProbs(float* logProbs, T const* logits, int32_t const* targetIds, int32_t numTokens,
+    int32_t vocabSize, int32_t vocabSizePadded, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -1241,7 +1241,7 @@ __global__ void add_fusedQKV_bias_transpose_kernel(T* q_buf, T* k_buf, T* v_buf,
     const int* seq_lens, const int* padding_offset, const int batch_size, const int seq_len, const int head_num,
     const int kv_head_num, const int size_per_head, const int rotary_embedding_dim, float rotary_embedding_base,
     RotaryScalingType const rotary_scale_type, float rotary_embedding_scale, const int rotary_embedding_max_positions,
-    PositionEmbeddingType const position_embedding_type)
+    PositionEmbeddingType const position_embedding_type, const float2* rotary_cos_sin)
 {
     // This kernel add bias to QKV, which has shape [batch_size, seq_len, 3, head_num, size_per_head], and
     // QKV split to 3 split buffer q, k, v and transpose them to [batch_size, head_num, seq_len, size_per_head].
@@ -1347,8 +1347,8 @@ __global__ void add_fusedQKV_bias_transpose_kernel(T* q_buf, T* k_buf, T* v_buf,
     {
     case PositionEmbeddingType::kROPE_GPTJ:
     {
-        mmha::apply_rotary_embedding(
-            q, k, tidx, rotary_embedding_dim, rotary_embedding_base, rotary_embedding_scale, dst_kv_seq_idx);
+        mmha::apply_rotary_embedding(q, k, tidx, rotary_embedding_dim, rotary_embedding_base, rotary_embedding_scale,
+            dst_kv_seq_idx, rotary_cos_sin);
         break;
     }
     case PositionEmbeddingType::kROPE_GPT_NEOX:
@@ -1379,7 +1379,7 @@ __global__ void add_fusedQKV_bias_transpose_kernel(T* q_buf, T* k_buf, T* v_buf,
             mmha::vec_from_smem_transpose(k, k_smem, transpose_idx, smem_pitch);
 
             mmha::apply_rotary_embedding(q, k, transpose_idx / tidx_factor, rotary_embedding_dim, rotary_embedding_base,
-                rotary_embedding_scale, dst_kv_seq_idx);
+                rotary_embedding_scale, dst_kv_seq_idx, rotary_cos_sin);
 
             mmha::write_smem_transpose(q, q_smem, transpose_idx, smem_pitch);
             mmha::write_smem_transpose(k, k_smem, transpose_idx, smem_pitch);
@@ -1436,7 +1436,7 @@ __global__ void add_fusedQKV_bias_transpose_kernel(T* q_buf, T* k_buf, T* v_buf,
     add_fusedQKV_bias_transpose_kernel<T, ADD_BIAS><<<grid, block, smem_size, stream>>>(q_buf, k_buf, v_buf, QKV,      \
         qkv_bias, seq_lens, padding_offset, batch_size, seq_len, head_num, kv_head_num, size_per_head,                 \
         rotary_embedding_dim, rotary_embedding_base, rotary_scale_type, rotary_embedding_scale,                        \
-        rotary_embedding_max_positions, position_embedding_type);
+        rotary_embedding_max_positions, position_embedding_type, rotary_cos_sin);
 
 template <typename T>
 void invokeAddFusedQKVBiasTranspose(T* q_buf, T* k_buf, T* v_buf, T* QKV, const T* qkv_bias, const int* seq_lens,
@@ -1444,7 +1444,7 @@ void invokeAddFusedQKVBiasTranspose(T* q_buf, T* k_buf, T* v_buf, T* QKV, const
     const int kv_head_num, const int size_per_head, const int rotary_embedding_dim, const float rotary_embedding_base,
     const RotaryScalingType rotary_scale_type, const float rotary_embedding_scale,
     const int rotary_embedding_max_positions, const PositionEmbeddingType position_embedding_type, const float* scale,
-    const int int8_mode, cudaStream_t stream)
+    const int int8_mode, cudaStream_t stream, const float2* rotary_cos_sin)
 {
     // [bs, seq_len, 3, head, Dh]
     if (rotary_embedding_dim == 0)
@@ -1491,7 +1491,7 @@ void invokeAddFusedQKVBiasTranspose(T* q_buf, T* k_buf, T* v_buf, T* QKV, const
         const float rotary_embedding_base, const RotaryScalingType rotary_scale_type,                                  \
         const float rotary_embedding_scale, const int rotary_embedding_max_poisitions,                                 \
         const PositionEmbeddingType position_embedding_type, const float* scale, const int int8_mode,                  \
-        cudaStream_t stream)
+        cudaStream_t stream, const float2* rotary_cos_sin)
 INSTANTIATE_ADDFUSEDQKVBIAS_TRANSPOSE(float);
 INSTANTIATE_ADDFUSEDQKVBIAS_TRANSPOSE(half);
 #ifdef ENABLE_BF16
@@ -1606,8 +1606,10 @@ __global__ void transpose4dBatchMajorKVCache(const T* kSrc, const T* vSrc, KVCac
     auto valDst = handle_k ? reinterpret_cast<T_dst*>(kvCacheBuffer.getKBlockPtr(batchIdx, tokenKVIdx))
                            : reinterpret_cast<T_dst*>(kvCacheBuffer.getVBlockPtr(batchIdx, tokenKVIdx));
 
-    // Local to block dst idx
-    int inBlockIdx = kvCacheBuffer.getKVLocalIdx(tokenKVIdx, headIdx, sizePerHeadDivX, channelIdx);
+    // Local to block dst idx, counted in T_dst elements. K may be interleaved, see KVCacheLayout.
+    const int inBlockIdx = handle_k
+        ? kvCacheBuffer.template getKLocalIdx<T_dst>(tokenKVIdx, headIdx, sizePerHead, channelIdx * X_ELEMS)
+        : kvCacheBuffer.getKVLocalIdx(tokenKVIdx, headIdx, sizePerHead, channelIdx * X_ELEMS);
 
     // 16 byte loads will handle "x" dimension
     const size_t srcOffset = (batchIdx * headNum + headIdx) * sizePerHead * seqLen;
@@ -1619,8 +1621,6 @@ __global__ void transpose4dBatchMajorKVCache(const T* kSrc, const T* vSrc, KVCac
         // If T is fp32, T_src is float4 and mmha::num_elems<T_src>::value returns 4
         // If T is fp16/bf16, T_src is uint4 and mmha::num_elems<T_src>::value returns 8
         // mmha::packed_type<int8_t ...>::type becomes uint32_t or uint64_t respectively
-        // FIXME mmha::num_elems semantic is confusing
-        inBlockIdx = inBlockIdx * sizeof(mmha::packed_type<T_dst, mmha::num_elems<T_src>::value>::type);
         // Cast float scale to dst data type.
         using T_scale = typename mmha::kv_cache_scale_type_t<T, T_cache>::Type;
         T_scale scaleOrigQuant;
@@ -1630,7 +1630,7 @@ __global__ void transpose4dBatchMajorKVCache(const T* kSrc, const T* vSrc, KVCac
     }
     else
     {
-        reinterpret_cast<T_src*>(valDst)[inBlockIdx] = val;
+        *reinterpret_cast<T_src*>(&valDst[inBlockIdx]) = val;
     }
 }
 
@@ -1785,7 +1785,6 @@ __global__ void shiftKCache(KVCacheBuffer kvCacheBuffer, KVLinearBuffer shiftKCa
     using Vec_k = typename mmha::packed_type<T, vec_size>::type;
     using Vec_k_cache = typename mmha::packed_type<T_cache, vec_size>::type;
     using T_dst = T;
-    const int sizePerHeadDivX = sizePerHead / vec_size;
 
     // The start token idx for the cyclic part in k cache
     const int cyclic_k_cache_start_idx
@@ -1833,7 +1832,8 @@ __global__ void shiftKCache(KVCacheBuffer kvCacheBuffer, KVLinearBuffer shiftKCa
     Vec_k k;
     Vec_k_cache k_cache;
     T_cache* k_cache_batch = reinterpret_cast<T_cache*>(kvCacheBuffer.getKBlockPtr(batch_beam_idx, token_kv_idx));
-    int inBlockIdx_r = kvCacheBuffer.getKVLocalIdx(token_kv_idx, head_idx, sizePerHead, tidx * vec_size);
+    int inBlockIdx_r
+        = kvCacheBuffer.template getKLocalIdx<T_cache>(token_kv_idx, head_idx, sizePerHead, tidx * vec_size);
     k_cache = *reinterpret_cast<const Vec_k_cache*>(&k_cache_batch[inBlockIdx_r]);
     if constexpr (INT8_K_CACHE)
     {
@@ -1902,8 +1902,9 @@ __global__ void shiftKCache(KVCacheBuffer kvCacheBuffer, KVLinearBuffer shiftKCa
     // Write k cache
     auto token_k_idx = shiftKCacheBuffer.getKVTokenIdx(token_idx);
     T_dst* kDst = reinterpret_cast<T_dst*>(shiftKCacheBuffer.getKBlockPtr(batch_beam_idx, token_k_idx));
-    int inBlockIdx_w = shiftKCacheBuffer.getKVLocalIdx(token_k_idx, head_idx, sizePerHeadDivX, tidx);
-    reinterpret_cast<Vec_k*>(kDst)[inBlockIdx_w] = k;
+    int inBlockIdx_w
+        = shiftKCacheBuffer.getKLocalIdx<T_dst>(token_k_idx, head_idx, sizePerHead, tidx * vec_size);
+    *reinterpret_cast<Vec_k*>(&kDst[inBlockIdx_w]) = k;
 }
 
 template <typename T, typename KVCacheBuffer>
@@ -1969,5 +1970,108 @@ INSTANTIATE_SHIFT_K_CACHE(__nv_bfloat16);
 #undef INSTANTIATE_SHIFT_K_CACHE_CACHE_TYPE
 #undef INSTANTIATE_SHIFT_K_CACHE
 
+template <typename T, typename T_cache>
+__global__ void dequantizeKVBlockArray(KVBlockArray srcKVCache, KVBlockArray dstKVCache, const int* kv_seq_lengths,
+    const int kv_head_num, const int size_per_head, const float* kvScaleQuantOrig, const bool dynamic_scales)
+{
+    // FP8 KV Cache.
+    static constexpr bool FP8_KV_CACHE = std::is_same<T_cache, __nv_fp8_e4m3>::value;
+    // INT8 KV Cache.
+    static constexpr bool INT8_KV_CACHE = std::is_same<T_cache, int8_t>::value;
+    static_assert(FP8_KV_CACHE || INT8_KV_CACHE, "Only 8bits KV cache can be dequantized");
+
+    // Each thread will handle 16 bytes of the output.
+    constexpr int vec_size = 16u / sizeof(T);
+    using Vec_kv = typename mmha::packed_type<T, vec_size>::type;
+    using Vec_kv_cache = typename mmha::packed_type<T_cache, vec_size>::type;
+
+    // The block idx inside the sequence
+    const int block_idx = blockIdx.x;
+    // The batch idx
+    const int batch_idx = blockIdx.y;
+    // K or V
+    const auto kv_idx = static_cast<KVIdxType>(blockIdx.z);
+
+    // Blocks are copied entirely, the tokens past the kv length are masked by the attention kernel.
+    const int token_idx = block_idx * srcKVCache.mTokensPerBlock;
+    if (token_idx >= kv_seq_lengths[batch_idx])
+    {
+        return;
+    }
+
+    // Both blocks have the layout [numHeads, tokensPerBlock, sizePerHead] and only differ in the element type.
+    const T_cache* src = reinterpret_cast<const T_cache*>(srcKVCache.getBlockPtr(batch_idx, token_idx, kv_idx));
+    T* dst = reinterpret_cast<T*>(dstKVCache.getBlockPtr(batch_idx, token_idx, kv_idx));
+    const int elts_per_head = srcKVCache.mTokensPerBlock * size_per_head;
+    const int elts_per_block = kv_head_num * elts_per_head;
+    // Dynamic scales are stored per kv head after the values of the block, see getKVDynamicScalePtr.
+    const float* dynamic_scale_quant_orig = dynamic_scales
+        ? getKVDynamicScalePtr(src, kv_head_num, srcKVCache.mTokensPerBlock, size_per_head)
+        : nullptr;
+    for (int elt_idx = threadIdx.x * vec_size; elt_idx < elts_per_block; elt_idx += blockDim.x * vec_size)
+    {
+        // Dequant scales for 8bits kv cache, a vector never crosses heads as the head size is a multiple of it.
+        const float kv_scale_quant_orig
+            = dynamic_scales ? dynamic_scale_quant_orig[elt_idx / elts_per_head] : kvScaleQuantOrig[0];
+        Vec_kv_cache kv_cache = *reinterpret_cast<const Vec_kv_cache*>(&src[elt_idx]);
+        Vec_kv kv;
+        if constexpr (INT8_KV_CACHE)
+        {
+            using Packed_Float_t = typename mmha::packed_type<float, vec_size>::type;
+            mmha::convert_from_float(
+                &kv, mmha::mul<Packed_Float_t, float>(kv_scale_quant_orig, mmha::float_from_int8(kv_cache)));
+        }
+#ifdef ENABLE_FP8
+        else if constexpr (FP8_KV_CACHE)
+        {
+            mmha::convert_from_8bit_kv_cache<Vec_kv_cache, Vec_kv, T_cache, float>(&kv, kv_cache, kv_scale_quant_orig);
+        }
+#endif // ENABLE_FP8
+        *reinterpret_cast<Vec_kv*>(&dst[elt_idx]) = kv;
+    }
+}
+
+template <typename T>
+void invokeDequantizeKVBlockArray(const KVBlockArray& srcKVCache, const KVBlockArray& dstKVCache,
+    const KvCacheDataType cache_type, const int* kv_seq_lengths, const int batch_size, const int kv_head_num,
+    const int size_per_head, const float* kvScaleQuantOrig, const bool dynamic_scales, cudaStream_t stream)
+{
+    // The interleaved K layout depends on the element size, so it does not survive an elementwise copy.
+    TLLM_CHECK_WITH_INFO(srcKVCache.mKLayout == KVCacheLayout::kLINEAR && dstKVCache.mKLayout == KVCacheLayout::kLINEAR,
+        "Only the linear K cache layout can be dequantized");
+    dim3 block(256);
+    dim3 grid(srcKVCache.mMaxBlocksPerSeq, batch_size, 2);
+
+    if (cache_type == KvCacheDataType::INT8)
+    {
+        dequantizeKVBlockArray<T, int8_t><<<grid, block, 0, stream>>>(
+            srcKVCache, dstKVCache, kv_seq_lengths, kv_head_num, size_per_head, kvScaleQuantOrig, dynamic_scales);
+    }
+#ifdef ENABLE_FP8
+    else if (cache_type == KvCacheDataType::FP8)
+    {
+        dequantizeKVBlockArray<T, __nv_fp8_e4m3><<<grid, block, 0, stream>>>(
+            srcKVCache, dstKVCache, kv_seq_lengths, kv_head_num, size_per_head, kvScaleQuantOrig, dynamic_scales);
+    }
+#endif // ENABLE_FP8
+    else
+    {
+        TLLM_CHECK_WITH_INFO(false, "Only INT8 and FP8 KV caches can be dequantized");
+    }
+}
+
+#define INSTANTIATE_DEQUANTIZE_KV_BLOCK_ARRAY(T)                                                                       \
+    template void invokeDequantizeKVBlockArray<T>(const KVBlockArray& srcKVCache, const KVBlockArray& dstKVCache,      \
+        const KvCacheDataType cache_type, const int* kv_seq_lengths, const int batch_size, const int kv_head_num,      \
+        const int size_per_head, const float* kvScaleQuantOrig, const bool dynamic_scales, cudaStream_t stream)
+
+INSTANTIATE_DEQUANTIZE_KV_BLOCK_ARRAY(float);
+INSTANTIATE_DEQUANTIZE_KV_BLOCK_ARRAY(uint16_t);
+#ifdef ENABLE_BF16
+INSTANTIATE_DEQUANTIZE_KV_BLOCK_ARRAY(__nv_bfloat16);
+#endif
+
+#undef INSTANTIATE_DEQUANTIZE_KV_BLOCK_ARRAY
+
 } // namespace kernels
 } // namespace tensorrt_llm
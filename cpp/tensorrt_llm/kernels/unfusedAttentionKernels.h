@@ -51,7 +51,9 @@ enum class KvCacheDataType
 {
     BASE = 0,
     INT8,
-    FP8
+    FP8,
+    // 4-bit values with a scale and zero per token and head, see getInt4KVScaleZeroPtr
+    INT4
 };
 
 template <typename T, typename T_IN>
@@ -77,7 +79,8 @@ void invokeAddFusedQKVBiasTranspose(T* q_buf, T* k_buf, T* v_buf, T* QKV, const
     const int* padding_offset, const int batch_size, const int seq_len, const int token_num, const int head_num,
     const int kv_head_num, const int size_per_head, const int rotary_embedding_dim, float rotary_embedding_base,
     const RotaryScalingType rotary_scale_type, float rotary_embedding_scale, const int rotary_embedding_max_positions,
-    PositionEmbeddingType const position_embedding_type, const float* scale, const int int8_mode, cudaStream_t stream);
+    PositionEmbeddingType const position_embedding_type, const float* scale, const int int8_mode, cudaStream_t stream,
+    const float2* rotary_cos_sin = nullptr);
 
 template <typename T>
 void invokeAddFusedQKVBiasTranspose(T* q_buf, T* k_buf, T* v_buf, T* QKV, const T* qkv_bias, const int* seq_lens,
@@ -116,7 +119,8 @@ void invokeApplyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer& kvTable, cons
     const int rotary_embedding_max_positions, const PositionEmbeddingType position_embedding_type,
     const int* medusa_position_offsets, const bool position_shift_enabled, const float* scale, const int int8_mode,
     const KvCacheDataType cache_type, const float* kvScaleOrigQuant, const bool enable_paged_kv_fmha,
-    const int beam_width, int2& grid_block_cache, cudaStream_t stream);
+    const int beam_width, int2& grid_block_cache, cudaStream_t stream, const float2* rotary_cos_sin = nullptr,
+    float* kvDynamicAmax = nullptr);
 
 template <typename T, typename BT>
 void invokeAddRelativeAttentionBiasUnaligned(T* qk_buf, const BT* relative_attention_bias, const int batch_size,
@@ -130,5 +134,13 @@ void invokeShiftKCache(KVCacheBuffer kvCacheBuffer, KVLinearBuffer shiftKCacheBu
     const int* input_lengths, const int rotary_embedding_dim, float rotary_embedding_base,
     RotaryScalingType const rotary_scale_type, float rotary_embedding_scale, const int rotary_embedding_max_positions,
     PositionEmbeddingType const position_embedding_type, cudaStream_t stream);
+
+// Dequantize the INT8/FP8 blocks of srcKVCache holding tokens below kv_seq_lengths into the blocks of dstKVCache
+// stored in T, so that the paged kv context FMHA kernels can attend to them. With dynamic_scales, the scales are read
+// per kv head from the blocks instead of kvScaleQuantOrig.
+template <typename T>
+void invokeDequantizeKVBlockArray(const KVBlockArray& srcKVCache, const KVBlockArray& dstKVCache,
+    const KvCacheDataType cache_type, const int* kv_seq_lengths, const int batch_size, const int kv_head_num,
+    const int size_per_head, const float* kvScaleQuantOrig, const bool dynamic_scales, cudaStream_t stream);
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -160,11 +160,13 @@ template <typename T, typename T_cache, int Dh_MAX, bool ADD_BIAS, bool STORE_QK
     typename KVCacheBuffer, bool IS_GENERATE>
 __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBuffer, const T* __restrict qkv_bias,
     const int* seq_lens, const int* kv_seq_lens, const int* padding_offset, const float* kvScaleOrigQuant,
-    const int num_tokens, const int batch_size, const int seq_len, const int cyclic_kv_cache_len,
-    const int sink_token_len, const int head_num, const int kv_head_num, const int qheads_per_kv_head,
-    const int size_per_head, const int rotary_embedding_dim, float rotary_embedding_base,
+    float* kvDynamicAmax, const bool computeDynamicAmax, const int num_tokens, const int batch_size,
+    const int seq_len, const int cyclic_kv_cache_len, const int sink_token_len, const int head_num,
+    const int kv_head_num, const int qheads_per_kv_head, const int size_per_head, const int rotary_embedding_dim,
+    float rotary_embedding_base,
     RotaryScalingType const rotary_scale_type, float rotary_embedding_scale, const int rotary_embedding_max_positions,
-    PositionEmbeddingType const position_embedding_type, const int* medusa_position_offsets, const int beam_width)
+    PositionEmbeddingType const position_embedding_type, const int* medusa_position_offsets, const int beam_width,
+    const float2* rotary_cos_sin)
 {
     // This kernel add bias to QKV, which has shape [batch_size, seq_len, 3, head_num, size_per_head]
     // Extract the Q input when using paged KV FMHA.
@@ -193,7 +195,8 @@ __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBu
     using Packed_type = typename Rotary_vec_t<T, Dh_MAX>::Packed_type;
     const bool has_padding = padding_offset == nullptr;
 
-    constexpr bool ENABLE_8BITS_CACHE = sizeof(T_cache) == 1;
+    constexpr bool ENABLE_INT4_CACHE = std::is_same<T_cache, mmha::int4_kv_t>::value;
+    constexpr bool ENABLE_8BITS_CACHE = sizeof(T_cache) == 1 && !ENABLE_INT4_CACHE;
     const int sizePerHeadDivX = size_per_head / VEC_SIZE;
     using T_dst = T_cache;
 
@@ -312,7 +315,7 @@ __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBu
         case PositionEmbeddingType::kROPE_GPTJ:
         {
             mmha::apply_rotary_embedding(
-                q, k, tidx, rotary_embedding_dim, updated_base, updated_scale, rotary_position);
+                q, k, tidx, rotary_embedding_dim, updated_base, updated_scale, rotary_position, rotary_cos_sin);
             break;
         }
         // Rotate by half rotary embedding.
@@ -326,8 +329,8 @@ __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBu
             // Note that the half rotary embedding may not be power of 2.
             // e.g. 80 head size (next power of 2 is 128, so each thread will process 4 elements),
             //  which means only thread 0 ~ 10 (exclusive), and 16 ~ 26 (exclusive) have work to do.
-            mmha::apply_rotary_embedding_gptneox<Vec_type, Packed_type, T>(
-                q, k, tidx, rotary_embedding_dim, updated_base, updated_scale, rotary_position, first_half);
+            mmha::apply_rotary_embedding_gptneox<Vec_type, Packed_type, T>(q, k, tidx, rotary_embedding_dim,
+                updated_base, updated_scale, rotary_position, first_half, rotary_cos_sin);
             break;
         }
         }
@@ -339,11 +342,45 @@ __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBu
             && (token_idx_in_seq >= tokenIdxLowerBound || token_idx_in_seq < sink_token_len);
         const int token_kv_idx = kvCacheBuffer.getKVTokenIdx(token_idx_in_seq);
 
+        // The INT4 cache has one scale and zero per token and head. One warp handles one head, so the reduction
+        // has to happen before the masked lanes diverge.
+        float2 k_scale_zero, v_scale_zero;
+        if constexpr (ENABLE_INT4_CACHE)
+        {
+            k_scale_zero = mmha::int4_kv_cache_scale_zero((POS_SHIFT) ? k_wo_pos : k, !is_masked);
+            v_scale_zero = mmha::int4_kv_cache_scale_zero(v, !is_masked);
+        }
+
+        // With dynamic scales, the first pass only reduces the amax of K and V per sequence and kv head over the
+        // context, see kernelDispatchHeadSize. Chunks after the first one keep the scales stored with the first.
+        const bool first_context_chunk = !IS_GENERATE && final_kv_seq_len == actual_seq_len;
+        if constexpr (ENABLE_8BITS_CACHE)
+        {
+            if (computeDynamicAmax)
+            {
+                const float k_amax = mmha::kv_cache_warp_amax((POS_SHIFT) ? k_wo_pos : k, !is_masked);
+                const float v_amax = mmha::kv_cache_warp_amax(v, !is_masked);
+                if (threadIdx.x == 0 && valid_seq && first_context_chunk
+                    && ((head_num == kv_head_num) || (head_idx == (kv_head_idx * qheads_per_kv_head))))
+                {
+                    // The amax is non-negative, so comparing the bits as int orders it like the floats.
+                    auto* amax
+                        = reinterpret_cast<int*>(&kvDynamicAmax[(batch_beam_idx * kv_head_num + kv_head_idx) * 2]);
+                    atomicMax(&amax[0], __float_as_int(k_amax));
+                    atomicMax(&amax[1], __float_as_int(v_amax));
+                }
+                continue;
+            }
+        }
+
         if (!is_masked)
         {
             auto kDst = reinterpret_cast<T_dst*>(kvCacheBuffer.getKBlockPtr(batch_beam_idx, token_kv_idx));
             auto vDst = reinterpret_cast<T_dst*>(kvCacheBuffer.getVBlockPtr(batch_beam_idx, token_kv_idx));
             int inBlockIdx = kvCacheBuffer.getKVLocalIdx(token_kv_idx, kv_head_idx, sizePerHeadDivX, channelIdx);
+            // K may be interleaved (see KVCacheLayout), its index is counted in T_dst elements.
+            const int kInBlockIdx = kvCacheBuffer.template getKLocalIdx<T_dst>(
+                token_kv_idx, kv_head_idx, size_per_head, channelIdx * VEC_SIZE);
             Vec_type k_to_cache = (POS_SHIFT) ? k_wo_pos : k;
 
             if constexpr (STORE_QKV)
@@ -367,20 +404,70 @@ __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBu
 
                 if (valid_kv_cache_pos)
                 {
-                    if constexpr (ENABLE_8BITS_CACHE)
+                    if constexpr (ENABLE_INT4_CACHE)
+                    {
+                        // Two values per byte.
+                        inBlockIdx = inBlockIdx * VEC_SIZE / 2;
+                        mmha::store_int4_kv_cache_vec(
+                            reinterpret_cast<uint8_t*>(kDst), k_to_cache, inBlockIdx, k_scale_zero);
+                        mmha::store_int4_kv_cache_vec(reinterpret_cast<uint8_t*>(vDst), v, inBlockIdx, v_scale_zero);
+                        if (channelIdx == 0)
+                        {
+                            const int tokensPerBlock = kvCacheBuffer.getTokensPerBlock();
+                            const int scaleIdx = kvCacheBuffer.getKVScaleIdx(token_kv_idx, kv_head_idx);
+                            getInt4KVScaleZeroPtr(kDst, kv_head_num, tokensPerBlock, size_per_head)[scaleIdx]
+                                = __float22half2_rn(k_scale_zero);
+                            getInt4KVScaleZeroPtr(vDst, kv_head_num, tokensPerBlock, size_per_head)[scaleIdx]
+                                = __float22half2_rn(v_scale_zero);
+                        }
+                    }
+                    else if constexpr (ENABLE_8BITS_CACHE)
                     {
                         inBlockIdx = inBlockIdx * VEC_SIZE;
                         // Cast float scale to dst data type.
                         using T_scale = typename mmha::kv_cache_scale_type_t<T, T_cache>::Type;
-                        T_scale scaleOrigQuant;
-                        mmha::convert_from_float(&scaleOrigQuant, kvScaleOrigQuant[0]);
+                        T_scale kScaleOrigQuant, vScaleOrigQuant;
+                        if (kvDynamicAmax != nullptr)
+                        {
+                            const int tokensPerBlock = kvCacheBuffer.getTokensPerBlock();
+                            float kScaleQuantOrig, vScaleQuantOrig;
+                            if (first_context_chunk)
+                            {
+                                // Largest magnitude of the cache type, avoid a zero scale for all-zero heads.
+                                constexpr float maxQuant = std::is_same_v<T_cache, int8_t> ? 127.f : 448.f;
+                                const float* amax = &kvDynamicAmax[(batch_beam_idx * kv_head_num + kv_head_idx) * 2];
+                                kScaleQuantOrig = fmaxf(amax[0], 1e-6f) / maxQuant;
+                                vScaleQuantOrig = fmaxf(amax[1], 1e-6f) / maxQuant;
+                            }
+                            else
+                            {
+                                kScaleQuantOrig = getKVDynamicScalePtr(kvCacheBuffer.getKBlockPtr(batch_beam_idx, 0),
+                                    kv_head_num, tokensPerBlock, size_per_head)[kv_head_idx];
+                                vScaleQuantOrig = getKVDynamicScalePtr(kvCacheBuffer.getVBlockPtr(batch_beam_idx, 0),
+                                    kv_head_num, tokensPerBlock, size_per_head)[kv_head_idx];
+                            }
+                            if (channelIdx == 0)
+                            {
+                                getKVDynamicScalePtr(kDst, kv_head_num, tokensPerBlock, size_per_head)[kv_head_idx]
+                                    = kScaleQuantOrig;
+                                getKVDynamicScalePtr(vDst, kv_head_num, tokensPerBlock, size_per_head)[kv_head_idx]
+                                    = vScaleQuantOrig;
+                            }
+                            mmha::convert_from_float(&kScaleOrigQuant, 1.f / kScaleQuantOrig);
+                            mmha::convert_from_float(&vScaleOrigQuant, 1.f / vScaleQuantOrig);
+                        }
+                        else
+                        {
+                            mmha::convert_from_float(&kScaleOrigQuant, kvScaleOrigQuant[0]);
+                            vScaleOrigQuant = kScaleOrigQuant;
+                        }
                         // Store 8bits kv cache.
-                        mmha::store_8bits_kv_cache_vec(kDst, k_to_cache, inBlockIdx, scaleOrigQuant);
-                        mmha::store_8bits_kv_cache_vec(vDst, v, inBlockIdx, scaleOrigQuant);
+                        mmha::store_8bits_kv_cache_vec(kDst, k_to_cache, kInBlockIdx, kScaleOrigQuant);
+                        mmha::store_8bits_kv_cache_vec(vDst, v, inBlockIdx, vScaleOrigQuant);
                     }
                     else
                     {
-                        reinterpret_cast<Vec_type*>(kDst)[inBlockIdx] = k_to_cache;
+                        *reinterpret_cast<Vec_type*>(&kDst[kInBlockIdx]) = k_to_cache;
                         reinterpret_cast<Vec_type*>(vDst)[inBlockIdx] = v;
                     }
                 }
@@ -406,10 +493,11 @@ __global__ void applyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer kvCacheBu
     dim3 grid(blocks_per_sequence, head_num);                                                                          \
     applyBiasRopeUpdateKVCache<T, T_cache, Dh_MAX, ADD_BIAS, STORE_QKV, POS_SHIFT, KVCacheBuffer, IS_GENERATE>         \
         <<<grid, block, 0, stream>>>(QKV, Q, kvTable, qkv_bias, seq_lens, kv_seq_lens, padding_offset,                 \
-            kvScaleOrigQuant, token_num, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len, head_num,           \
-            kv_head_num, head_num / kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base,           \
-            rotary_scale_type, updated_rotary_embedding_scale, rotary_embedding_max_positions,                         \
-            position_embedding_type, medusa_position_offsets, beam_width);
+            kvScaleOrigQuant, kvDynamicAmax, compute_dynamic_amax, token_num, batch_size, seq_len,                     \
+            cyclic_kv_cache_len, sink_token_len, head_num, kv_head_num, head_num / kv_head_num, size_per_head,         \
+            rotary_embedding_dim, rotary_embedding_base, rotary_scale_type, updated_rotary_embedding_scale,            \
+            rotary_embedding_max_positions, position_embedding_type, medusa_position_offsets, beam_width,              \
+            rotary_cos_sin);
 
 template <int Dh_MAX, typename T, typename T_cache, typename KVCacheBuffer, bool IS_GENERATE>
 void kernelDispatchHeadSize(T* QKV, T* Q, KVCacheBuffer& kvTable, const T* qkv_bias, const int* seq_lens,
@@ -419,63 +507,76 @@ void kernelDispatchHeadSize(T* QKV, T* Q, KVCacheBuffer& kvTable, const T* qkv_b
     const RotaryScalingType rotary_scale_type, const float rotary_embedding_scale,
     const int rotary_embedding_max_positions, const PositionEmbeddingType position_embedding_type,
     const int* medusa_position_offsets, const bool position_shift_enabled, const float* scale,
-    const float* kvScaleOrigQuant, const int int8_mode, const bool enable_paged_kv_fmha, const int beam_width,
-    int2& grid_block_cache, cudaStream_t stream)
+    const float* kvScaleOrigQuant, float* kvDynamicAmax, const int int8_mode, const bool enable_paged_kv_fmha,
+    const int beam_width, int2& grid_block_cache, const float2* rotary_cos_sin, cudaStream_t stream)
 {
     const bool add_bias = qkv_bias != nullptr;
     const bool store_contiguous_qkv = !enable_paged_kv_fmha;
 
-    // Update scale if scale_type == RotaryScalingType::kLINEAR.
-    const float updated_rotary_embedding_scale
-        = rotary_scale_type == RotaryScalingType::kLINEAR ? 1.0f / rotary_embedding_scale : rotary_embedding_scale;
+    // Update scale if scale_type == RotaryScalingType::kLINEAR, kYARN and kLONGROPE fall back to it without a table.
+    const bool interpolate = rotary_scale_type == RotaryScalingType::kLINEAR
+        || rotary_scale_type == RotaryScalingType::kYARN || rotary_scale_type == RotaryScalingType::kLONGROPE;
+    const float updated_rotary_embedding_scale = interpolate ? 1.0f / rotary_embedding_scale : rotary_embedding_scale;
 
-    if (add_bias)
+    // With dynamic KV cache scales, a first pass reduces the amax of K and V of every sequence and kv head, the second
+    // one quantizes with the scales derived from it and stores them next to the quantized values.
+    if (kvDynamicAmax != nullptr)
     {
-        if (store_contiguous_qkv)
-        {
-            if (position_shift_enabled)
-            {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, true, true);
-            }
-            else
-            {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, true, false);
-            }
-        }
-        else
-        {
-            if (position_shift_enabled)
-            {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, false, true);
-            }
-            else
-            {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, false, false);
-            }
-        }
+        TLLM_CUDA_CHECK(
+            cudaMemsetAsync(kvDynamicAmax, 0, sizeof(float) * batch_size * beam_width * kv_head_num * 2, stream));
     }
-    else
+    const int num_passes = kvDynamicAmax != nullptr ? 2 : 1;
+    for (int pass = 0; pass < num_passes; ++pass)
     {
-        if (store_contiguous_qkv)
+        const bool compute_dynamic_amax = pass + 1 < num_passes;
+        if (add_bias)
         {
-            if (position_shift_enabled)
+            if (store_contiguous_qkv)
             {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, true, true);
+                if (position_shift_enabled)
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, true, true);
+                }
+                else
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, true, false);
+                }
             }
             else
             {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, true, false);
+                if (position_shift_enabled)
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, false, true);
+                }
+                else
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, true, false, false);
+                }
             }
         }
         else
         {
-            if (position_shift_enabled)
+            if (store_contiguous_qkv)
             {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, false, true);
+                if (position_shift_enabled)
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, true, true);
+                }
+                else
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, true, false);
+                }
             }
             else
             {
-                APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, false, false);
+                if (position_shift_enabled)
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, false, true);
+                }
+                else
+                {
+                    APPLY_BIAS_ROPE_UPDATE_KV_CACHE(Dh_MAX, false, false, false);
+                }
             }
         }
     }
@@ -489,8 +590,8 @@ void invokeApplyBiasRopeUpdateKVCacheDispatch(T* QKV, T* Q, KVCacheBuffer& kvTab
     const RotaryScalingType rotary_scale_type, const float rotary_embedding_scale,
     const int rotary_embedding_max_positions, const PositionEmbeddingType position_embedding_type,
     const int* medusa_position_offsets, const bool position_shift_enabled, const float* scale,
-    const float* kvScaleOrigQuant, const int int8_mode, const bool enable_paged_kv_fmha, const int beam_width,
-    int2& grid_block_cache, cudaStream_t stream)
+    const float* kvScaleOrigQuant, float* kvDynamicAmax, const int int8_mode, const bool enable_paged_kv_fmha,
+    const int beam_width, int2& grid_block_cache, const float2* rotary_cos_sin, cudaStream_t stream)
 {
     TLLM_CHECK_WITH_INFO(int8_mode != 2, "w8a8 not yet implemented with RoPE"); // TODO
     if constexpr (!IS_GENERATE)
@@ -513,8 +614,8 @@ void invokeApplyBiasRopeUpdateKVCacheDispatch(T* QKV, T* Q, KVCacheBuffer& kvTab
             kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len, token_num, head_num,
             kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type,
             rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type, medusa_position_offsets,
-            position_shift_enabled, scale, kvScaleOrigQuant, int8_mode, enable_paged_kv_fmha, beam_width,
-            grid_block_cache, stream);
+            position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode, enable_paged_kv_fmha,
+            beam_width, grid_block_cache, rotary_cos_sin, stream);
     }
     else if (size_per_head <= 128)
     {
@@ -522,8 +623,8 @@ void invokeApplyBiasRopeUpdateKVCacheDispatch(T* QKV, T* Q, KVCacheBuffer& kvTab
             kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len, token_num, head_num,
             kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type,
             rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type, medusa_position_offsets,
-            position_shift_enabled, scale, kvScaleOrigQuant, int8_mode, enable_paged_kv_fmha, beam_width,
-            grid_block_cache, stream);
+            position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode, enable_paged_kv_fmha,
+            beam_width, grid_block_cache, rotary_cos_sin, stream);
     }
     else if (size_per_head <= 256)
     {
@@ -531,8 +632,8 @@ void invokeApplyBiasRopeUpdateKVCacheDispatch(T* QKV, T* Q, KVCacheBuffer& kvTab
             kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len, token_num, head_num,
             kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type,
             rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type, medusa_position_offsets,
-            position_shift_enabled, scale, kvScaleOrigQuant, int8_mode, enable_paged_kv_fmha, beam_width,
-            grid_block_cache, stream);
+            position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode, enable_paged_kv_fmha,
+            beam_width, grid_block_cache, rotary_cos_sin, stream);
     }
     else
     {
@@ -549,7 +650,8 @@ void invokeApplyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer& kvTable, cons
     const int rotary_embedding_max_positions, const PositionEmbeddingType position_embedding_type,
     const int* medusa_position_offsets, const bool position_shift_enabled, const float* scale, const int int8_mode,
     const KvCacheDataType cache_type, const float* kvScaleOrigQuant, const bool enable_paged_kv_fmha,
-    const int beam_width, int2& grid_block_cache, cudaStream_t stream)
+    const int beam_width, int2& grid_block_cache, cudaStream_t stream, const float2* rotary_cos_sin,
+    float* kvDynamicAmax)
 {
     // Block handles both K and V tile.
     constexpr int x = (sizeof(T) == 4) ? 4 : 8;
@@ -561,8 +663,8 @@ void invokeApplyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer& kvTable, cons
             seq_lens, kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len, token_num,
             head_num, kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type,
             rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type, medusa_position_offsets,
-            position_shift_enabled, scale, kvScaleOrigQuant, int8_mode, enable_paged_kv_fmha, beam_width,
-            grid_block_cache, stream);
+            position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode, enable_paged_kv_fmha,
+            beam_width, grid_block_cache, rotary_cos_sin, stream);
     }
 #ifdef ENABLE_FP8
     else if (cache_type == KvCacheDataType::FP8)
@@ -571,18 +673,29 @@ void invokeApplyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer& kvTable, cons
             qkv_bias, seq_lens, kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len,
             token_num, head_num, kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base,
             rotary_scale_type, rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type,
-            medusa_position_offsets, position_shift_enabled, scale, kvScaleOrigQuant, int8_mode, enable_paged_kv_fmha,
-            beam_width, grid_block_cache, stream);
+            medusa_position_offsets, position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode,
+            enable_paged_kv_fmha, beam_width, grid_block_cache, rotary_cos_sin, stream);
     }
 #endif // ENABLE_FP8
+    else if (cache_type == KvCacheDataType::INT4)
+    {
+        TLLM_CHECK_WITH_INFO(kvDynamicAmax == nullptr, "Dynamic KV cache scales need an INT8 or FP8 KV cache");
+        invokeApplyBiasRopeUpdateKVCacheDispatch<T, mmha::int4_kv_t, KVCacheBuffer, IS_GENERATE>(QKV, Q, kvTable,
+            qkv_bias, seq_lens, kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len,
+            token_num, head_num, kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base,
+            rotary_scale_type, rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type,
+            medusa_position_offsets, position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode,
+            enable_paged_kv_fmha, beam_width, grid_block_cache, rotary_cos_sin, stream);
+    }
     else
     {
+        TLLM_CHECK_WITH_INFO(kvDynamicAmax == nullptr, "Dynamic KV cache scales need an INT8 or FP8 KV cache");
         invokeApplyBiasRopeUpdateKVCacheDispatch<T, T, KVCacheBuffer, IS_GENERATE>(QKV, Q, kvTable, qkv_bias, seq_lens,
             kv_seq_lens, padding_offset, batch_size, seq_len, cyclic_kv_cache_len, sink_token_len, token_num, head_num,
             kv_head_num, size_per_head, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type,
             rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type, medusa_position_offsets,
-            position_shift_enabled, scale, kvScaleOrigQuant, int8_mode, enable_paged_kv_fmha, beam_width,
-            grid_block_cache, stream);
+            position_shift_enabled, scale, kvScaleOrigQuant, kvDynamicAmax, int8_mode, enable_paged_kv_fmha,
+            beam_width, grid_block_cache, rotary_cos_sin, stream);
     }
 }
 
@@ -596,7 +709,8 @@ void invokeApplyBiasRopeUpdateKVCache(T* QKV, T* Q, KVCacheBuffer& kvTable, cons
         const int rotary_embedding_max_positions, const PositionEmbeddingType position_embedding_type,                 \
         const int* medusa_position_offsets, const bool position_shift_enabled, const float* scale,                     \
         const int int8_mode, const KvCacheDataType cache_type, const float* kvScaleOrigQuant,                          \
-        const bool enable_paged_kv_fmha, const int beam_width, int2& grid_block_cache, cudaStream_t stream)
+        const bool enable_paged_kv_fmha, const int beam_width, int2& grid_block_cache, cudaStream_t stream,            \
+        const float2* rotary_cos_sin, float* kvDynamicAmax)
 
 } // namespace kernels
 } // namespace tensorrt_llm
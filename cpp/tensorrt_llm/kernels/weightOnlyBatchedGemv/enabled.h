@@ -91,6 +91,11 @@ inline bool isWeightOnlyBatchedGemvEnabled(WeightOnlyQuantType qtype)
     {
         return isEnabledForArch<uint8_t>(arch);
     }
+    else if (isLowBitQuantType(qtype))
+    {
+        // The bit plane layout is the same on every arch, which only has to match the other kernels
+        return arch >= 75;
+    }
     else
     {
         TLLM_CHECK_WITH_INFO(false, "Unsupported WeightOnlyQuantType");
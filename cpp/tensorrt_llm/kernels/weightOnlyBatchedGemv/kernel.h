@@ -294,7 +294,8 @@ public:
 template <typename ActType, WeightOnlyQuantType QType, typename WeightOnlyFlag, template <typename T> class ActOp,
     bool Zero, bool Bias, bool ActScale, int NPerBlock, int Batch, int BlockSize>
 __device__ void weight_only_batched_gemv(const uint8_t* qweight, const ActType* scales, const ActType* zeros,
-    const ActType* in, const ActType* act_scale, const ActType* bias, ActType* out, const int n, const int k)
+    const ActType* in, const ActType* act_scale, const ActType* bias, ActType* out, const int m, const int n,
+    const int k)
 {
     static_assert(NPerBlock == 1 || (NPerBlock % 2 == 0));
     using ActType2 = typename ActTypeDetails<ActType>::Vec2;
@@ -389,6 +390,11 @@ __device__ void weight_only_batched_gemv(const uint8_t* qweight, const ActType*
 #pragma unroll
         for (int b = 0; b < Batch; ++b)
         {
+            // Batch is the M tile, the rows past m of a partially filled tile are skipped.
+            if (b >= m)
+            {
+                break;
+            }
             ActType in_v[Details::kElemsPerThread];
 #pragma unroll
             for (int idx = 0; idx < Details::kActivationAccessNum; ++idx)
@@ -449,7 +455,7 @@ __device__ void weight_only_batched_gemv(const uint8_t* qweight, const ActType*
     Details::Layout::sync<Num, WarpSize>(reses, sm);
 
     // Each thread is responsible for the accumulation and store to global memory of one element
-    for (int i = tid; i < Num * Interleave; i += BlockSize)
+    for (int i = tid; i < m * NPerBlock * Interleave; i += BlockSize)
     {
         int nid = i % (NPerBlock * Interleave);
         float v = 0.f;
@@ -470,18 +476,19 @@ __device__ void weight_only_batched_gemv(const uint8_t* qweight, const ActType*
 template <typename ActType, WeightOnlyQuantType QType, typename WeightOnlyFlag, template <typename T> class ActOp,
     bool Zero, bool Bias, bool ActScale, int NPerBlock, int Batch, int BlockSize>
 __global__ void weight_only_batched_gemv_wrapper(const uint8_t* qweight, const ActType* scales, const ActType* zeros,
-    const ActType* in, const ActType* act_scale, const ActType* bias, ActType* out, const int n, const int k)
+    const ActType* in, const ActType* act_scale, const ActType* bias, ActType* out, const int m, const int n,
+    const int k)
 {
     if constexpr (std::is_same_v<ActType, half>)
     {
         weight_only_batched_gemv<ActType, QType, WeightOnlyFlag, ActOp, Zero, Bias, ActScale, NPerBlock, Batch,
-            BlockSize>(qweight, scales, zeros, in, act_scale, bias, out, n, k);
+            BlockSize>(qweight, scales, zeros, in, act_scale, bias, out, m, n, k);
     }
 #if (defined(__CUDA_ARCH__) && (__CUDA_ARCH__ >= 800) && defined(ENABLE_BF16))
     else if (std::is_same_v<ActType, nv_bfloat16>)
     {
         weight_only_batched_gemv<ActType, QType, WeightOnlyFlag, ActOp, Zero, Bias, ActScale, NPerBlock, Batch,
-            BlockSize>(qweight, scales, zeros, in, act_scale, bias, out, n, k);
+            BlockSize>(qweight, scales, zeros, in, act_scale, bias, out, m, n, k);
     }
 #endif
 }
@@ -504,8 +511,8 @@ struct WeightOnlyBatchedGemvKernelLauncher
                     BlockSize><<<grid, block, size, stream>>>(params.qweight,
                     reinterpret_cast<const half*>(params.scales), reinterpret_cast<const half*>(params.zeros),
                     reinterpret_cast<const half*>(params.in), reinterpret_cast<const half*>(params.act_scale),
-                    reinterpret_cast<const half*>(params.bias), reinterpret_cast<half*>(params.out), params.n,
-                    params.k);
+                    reinterpret_cast<const half*>(params.bias), reinterpret_cast<half*>(params.out), params.m,
+                    params.n, params.k);
             }
             else
             {
@@ -513,8 +520,8 @@ struct WeightOnlyBatchedGemvKernelLauncher
                     Batch, BlockSize><<<grid, block, size, stream>>>(params.qweight,
                     reinterpret_cast<const half*>(params.scales), reinterpret_cast<const half*>(params.zeros),
                     reinterpret_cast<const half*>(params.in), reinterpret_cast<const half*>(params.act_scale),
-                    reinterpret_cast<const half*>(params.bias), reinterpret_cast<half*>(params.out), params.n,
-                    params.k);
+                    reinterpret_cast<const half*>(params.bias), reinterpret_cast<half*>(params.out), params.m,
+                    params.n, params.k);
             }
         }
 #if defined(ENABLE_BF16)
@@ -533,7 +540,7 @@ struct WeightOnlyBatchedGemvKernelLauncher
                     reinterpret_cast<const __nv_bfloat16*>(params.in),
                     reinterpret_cast<const __nv_bfloat16*>(params.act_scale),
                     reinterpret_cast<const __nv_bfloat16*>(params.bias), reinterpret_cast<__nv_bfloat16*>(params.out),
-                    params.n, params.k);
+                    params.m, params.n, params.k);
             }
             else
             {
@@ -544,7 +551,7 @@ struct WeightOnlyBatchedGemvKernelLauncher
                     reinterpret_cast<const __nv_bfloat16*>(params.in),
                     reinterpret_cast<const __nv_bfloat16*>(params.act_scale),
                     reinterpret_cast<const __nv_bfloat16*>(params.bias), reinterpret_cast<__nv_bfloat16*>(params.out),
-                    params.n, params.k);
+                    params.m, params.n, params.k);
             }
         }
 #endif
@@ -28,6 +28,12 @@ struct WeightOnlyBatchedGemvKernelLauncher
     static void run(const WeightOnlyParams& params, cudaStream_t stream);
 };
 
+template <WeightOnlyQuantType QType, int GroupSize, int Batch, int BlockSize>
+struct WeightOnlyLowBitGemvKernelLauncher
+{
+    static void run(const WeightOnlyParams& params, cudaStream_t stream);
+};
+
 template <WeightOnlyQuantType QType, typename WeightOnlyFlag, template <typename T> class ActOp, int N_PER_BLOCK,
     int BATCH, int BLOCK_SIZE>
 void select_zero_bias(const WeightOnlyParams& params, cudaStream_t stream)
@@ -119,13 +125,85 @@ void select_groupwise_weight_only(const WeightOnlyParams& params, cudaStream_t s
     }
 }
 
+template <WeightOnlyQuantType QType, int GroupSize>
+void select_low_bit_batch(const WeightOnlyParams& params, cudaStream_t stream)
+{
+    switch (params.m)
+    {
+    case 1: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 1, 256>::run(params, stream); break;
+    case 2: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 2, 256>::run(params, stream); break;
+    case 3: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 3, 256>::run(params, stream); break;
+    case 4: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 4, 256>::run(params, stream); break;
+    case 5:
+    case 6:
+    case 7:
+    case 8: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 8, 256>::run(params, stream); break;
+    case 9:
+    case 10:
+    case 11:
+    case 12: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 12, 256>::run(params, stream); break;
+    case 13:
+    case 14:
+    case 15:
+    case 16: WeightOnlyLowBitGemvKernelLauncher<QType, GroupSize, 16, 256>::run(params, stream); break;
+    default: throw std::runtime_error("Weight only cuda kernel only supported bs <= 16");
+    }
+}
+
+template <int GroupSize>
+void select_low_bit_quant_type(const WeightOnlyParams& params, cudaStream_t stream)
+{
+    if (params.quant_type == WeightOnlyQuantType::Int3b)
+    {
+        select_low_bit_batch<WeightOnlyQuantType::Int3b, GroupSize>(params, stream);
+    }
+    else if (params.quant_type == WeightOnlyQuantType::Int2b)
+    {
+        select_low_bit_batch<WeightOnlyQuantType::Int2b, GroupSize>(params, stream);
+    }
+    else if (params.quant_type == WeightOnlyQuantType::NF4)
+    {
+        select_low_bit_batch<WeightOnlyQuantType::NF4, GroupSize>(params, stream);
+    }
+    else
+    {
+        throw std::runtime_error("Unknown QuantType");
+    }
+}
+
+// The sub-4-bit types are group-wise only, k must be a multiple of the group size
+void weight_only_low_bit_gemv_launcher(const WeightOnlyParams& params, cudaStream_t stream)
+{
+    if (params.weight_only_type != WeightOnlyType::GroupWise || params.k % params.group_size != 0)
+    {
+        throw std::runtime_error("Sub-4-bit weight only kernels need groupwise weights with k % gs == 0");
+    }
+    if (params.group_size == 64)
+    {
+        select_low_bit_quant_type<64>(params, stream);
+    }
+    else if (params.group_size == 128)
+    {
+        select_low_bit_quant_type<128>(params, stream);
+    }
+    else
+    {
+        throw std::runtime_error("Only support groupwise weight only for gs=64/128");
+    }
+}
+
+// Batches 1 to 4 have a kernel each, larger batches run on the next M tile of 8, 12 or 16 rows.
 void weight_only_batched_gemv_launcher(const WeightOnlyParams& params, cudaStream_t stream)
 {
     assert(params.act_func_type == WeightOnlyActivationFunctionType::Identity);
     assert(params.weight_only_type == WeightOnlyType::GroupWise
         || (params.weight_only_type == WeightOnlyType::PerChannel && params.bias == nullptr
             && params.zeros == nullptr));
-    if (params.weight_only_type == WeightOnlyType::PerChannel)
+    if (isLowBitQuantType(params.quant_type))
+    {
+        weight_only_low_bit_gemv_launcher(params, stream);
+    }
+    else if (params.weight_only_type == WeightOnlyType::PerChannel)
     {
         if (params.quant_type == WeightOnlyQuantType::Int4b)
         {
@@ -155,9 +233,36 @@ void weight_only_batched_gemv_launcher(const WeightOnlyParams& params, cudaStrea
                     IdentityActivation, false, false, 4, 4, 256>::run(params, stream);
                 break;
             }
+            case 5:
+            case 6:
+            case 7:
+            case 8:
+            {
+                WeightOnlyBatchedGemvKernelLauncher<WeightOnlyQuantType::Int4b, WeightOnlyPerChannel,
+                    IdentityActivation, false, false, 2, 8, 256>::run(params, stream);
+                break;
+            }
+            case 9:
+            case 10:
+            case 11:
+            case 12:
+            {
+                WeightOnlyBatchedGemvKernelLauncher<WeightOnlyQuantType::Int4b, WeightOnlyPerChannel,
+                    IdentityActivation, false, false, 2, 12, 256>::run(params, stream);
+                break;
+            }
+            case 13:
+            case 14:
+            case 15:
+            case 16:
+            {
+                WeightOnlyBatchedGemvKernelLauncher<WeightOnlyQuantType::Int4b, WeightOnlyPerChannel,
+                    IdentityActivation, false, false, 2, 16, 256>::run(params, stream);
+                break;
+            }
             default:
             {
-                throw std::runtime_error("Weight only cuda kernel only supported bs <= 4");
+                throw std::runtime_error("Weight only cuda kernel only supported bs <= 16");
                 break;
             }
             }
@@ -190,9 +295,36 @@ void weight_only_batched_gemv_launcher(const WeightOnlyParams& params, cudaStrea
                     IdentityActivation, false, false, 2, 4, 256>::run(params, stream);
                 break;
             }
+            case 5:
+            case 6:
+            case 7:
+            case 8:
+            {
+                WeightOnlyBatchedGemvKernelLauncher<WeightOnlyQuantType::Int8b, WeightOnlyPerChannel,
+                    IdentityActivation, false, false, 2, 8, 256>::run(params, stream);
+                break;
+            }
+            case 9:
+            case 10:
+            case 11:
+            case 12:
+            {
+                WeightOnlyBatchedGemvKernelLauncher<WeightOnlyQuantType::Int8b, WeightOnlyPerChannel,
+                    IdentityActivation, false, false, 2, 12, 256>::run(params, stream);
+                break;
+            }
+            case 13:
+            case 14:
+            case 15:
+            case 16:
+            {
+                WeightOnlyBatchedGemvKernelLauncher<WeightOnlyQuantType::Int8b, WeightOnlyPerChannel,
+                    IdentityActivation, false, false, 2, 16, 256>::run(params, stream);
+                break;
+            }
             default:
             {
-                throw std::runtime_error("Weight only cuda kernel only supported bs <= 4");
+                throw std::runtime_error("Weight only cuda kernel only supported bs <= 16");
                 break;
             }
             }
@@ -222,9 +354,33 @@ void weight_only_batched_gemv_launcher(const WeightOnlyParams& params, cudaStrea
             select_groupwise_weight_only<2, 4, 128>(params, stream);
             break;
         }
+        case 5:
+        case 6:
+        case 7:
+        case 8:
+        {
+            select_groupwise_weight_only<2, 8, 128>(params, stream);
+            break;
+        }
+        case 9:
+        case 10:
+        case 11:
+        case 12:
+        {
+            select_groupwise_weight_only<2, 12, 128>(params, stream);
+            break;
+        }
+        case 13:
+        case 14:
+        case 15:
+        case 16:
+        {
+            select_groupwise_weight_only<2, 16, 128>(params, stream);
+            break;
+        }
         default:
         {
-            throw std::runtime_error("Weight only cuda kernel only supported bs <= 4");
+            throw std::runtime_error("Weight only cuda kernel only supported bs <= 16");
             break;
         }
         }
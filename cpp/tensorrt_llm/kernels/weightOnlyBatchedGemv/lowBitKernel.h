@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/common.h"
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/utility.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+// The sub-4-bit weights are stored as bit planes instead of the interleaved layout of the int4/int8 kernels.
+// Every column of the weights is split into packs of 32 consecutive rows and a pack is stored as kBits uint32 words,
+// bit i of word b is bit b of the code of row i of the pack, so qweight is [n][k / 32][kBits] words.
+// The codes are the integer weight plus kBias for Int3b/Int2b and the index into nf4_value for NF4, the dequantized
+// weight is (code - kBias) * scale + zero or nf4_value(code) * scale.
+
+template <WeightOnlyQuantType QType>
+struct LowBitDetails;
+
+template <>
+struct LowBitDetails<WeightOnlyQuantType::Int3b>
+{
+    static constexpr int kBits = 3;
+    static constexpr int kBias = 4;
+    static constexpr bool kLookup = false;
+};
+
+template <>
+struct LowBitDetails<WeightOnlyQuantType::Int2b>
+{
+    static constexpr int kBits = 2;
+    static constexpr int kBias = 2;
+    static constexpr bool kLookup = false;
+};
+
+template <>
+struct LowBitDetails<WeightOnlyQuantType::NF4>
+{
+    static constexpr int kBits = 4;
+    static constexpr int kBias = 0;
+    static constexpr bool kLookup = true;
+};
+
+// One warp per column of the output, lane l dequantizes the packs l, l + 32, ... of the column once and applies them
+// to the Batch rows of the activation. A pack never spans two groups since the group size is a multiple of 32.
+template <typename ActType, WeightOnlyQuantType QType, int GroupSize, int Batch, int BlockSize>
+__device__ void weight_only_low_bit_gemv(const uint32_t* qweight, const ActType* scales, const ActType* zeros,
+    const ActType* in, const ActType* act_scale, const ActType* bias, ActType* out, const int m, const int n,
+    const int k)
+{
+    using Details = LowBitDetails<QType>;
+    static constexpr int kBits = Details::kBits;
+    static constexpr int WarpSize = 32;
+    static constexpr int kWarps = BlockSize / WarpSize;
+    static constexpr int kActPerVec = sizeof(uint4) / sizeof(ActType);
+    static_assert(GroupSize % kLowBitPackSize == 0);
+
+    __shared__ float lut[16];
+    if constexpr (Details::kLookup)
+    {
+        if (threadIdx.x < 16)
+        {
+            lut[threadIdx.x] = nf4_value(threadIdx.x);
+        }
+        __syncthreads();
+    }
+
+    const int lane = threadIdx.x % WarpSize;
+    const int col = blockIdx.x * kWarps + threadIdx.x / WarpSize;
+    if (col >= n)
+    {
+        return;
+    }
+
+    const int num_packs = k / kLowBitPackSize;
+    const uint32_t* col_qweight = qweight + static_cast<size_t>(col) * num_packs * kBits;
+    float acc[Batch];
+#pragma unroll
+    for (int b = 0; b < Batch; ++b)
+    {
+        acc[b] = 0.f;
+    }
+
+    for (int pack = lane; pack < num_packs; pack += WarpSize)
+    {
+        uint32_t planes[kBits];
+#pragma unroll
+        for (int i = 0; i < kBits; ++i)
+        {
+            planes[i] = col_qweight[pack * kBits + i];
+        }
+        const int k_start = pack * kLowBitPackSize;
+        const int group_offset = k_start / GroupSize * n + col;
+        const float scale = static_cast<float>(scales[group_offset]);
+        const float zero = zeros != nullptr ? static_cast<float>(zeros[group_offset]) : 0.f;
+
+        float w[kLowBitPackSize];
+#pragma unroll
+        for (int i = 0; i < kLowBitPackSize; ++i)
+        {
+            int code = 0;
+#pragma unroll
+            for (int j = 0; j < kBits; ++j)
+            {
+                code |= ((planes[j] >> i) & 1u) << j;
+            }
+            const float v = Details::kLookup ? lut[code] : static_cast<float>(code - Details::kBias);
+            w[i] = v * scale + zero;
+        }
+        // The pre-quant scale of the activation is folded into the weights, which are shared by all the rows
+        if (act_scale != nullptr)
+        {
+#pragma unroll
+            for (int i = 0; i < kLowBitPackSize; ++i)
+            {
+                w[i] *= static_cast<float>(act_scale[k_start + i]);
+            }
+        }
+
+#pragma unroll
+        for (int b = 0; b < Batch; ++b)
+        {
+            if (b < m)
+            {
+                alignas(16) ActType x[kLowBitPackSize];
+#pragma unroll
+                for (int i = 0; i < kLowBitPackSize / kActPerVec; ++i)
+                {
+                    load<uint4>(x + i * kActPerVec, in + static_cast<size_t>(b) * k + k_start, i);
+                }
+#pragma unroll
+                for (int i = 0; i < kLowBitPackSize; ++i)
+                {
+                    acc[b] += w[i] * static_cast<float>(x[i]);
+                }
+            }
+        }
+    }
+
+#pragma unroll
+    for (int b = 0; b < Batch; ++b)
+    {
+        float v = acc[b];
+#pragma unroll
+        for (int mask = WarpSize / 2; mask > 0; mask >>= 1)
+        {
+            v += __shfl_xor_sync(~0, v, mask);
+        }
+        if (lane == 0 && b < m)
+        {
+            const float bias_v = bias != nullptr ? static_cast<float>(bias[col]) : 0.f;
+            out[static_cast<size_t>(b) * n + col] = static_cast<ActType>(v + bias_v);
+        }
+    }
+}
+
+template <typename ActType, WeightOnlyQuantType QType, int GroupSize, int Batch, int BlockSize>
+__global__ void weight_only_low_bit_gemv_wrapper(const uint32_t* qweight, const ActType* scales, const ActType* zeros,
+    const ActType* in, const ActType* act_scale, const ActType* bias, ActType* out, const int m, const int n,
+    const int k)
+{
+    if constexpr (std::is_same_v<ActType, half>)
+    {
+        weight_only_low_bit_gemv<ActType, QType, GroupSize, Batch, BlockSize>(
+            qweight, scales, zeros, in, act_scale, bias, out, m, n, k);
+    }
+#if (defined(__CUDA_ARCH__) && (__CUDA_ARCH__ >= 800) && defined(ENABLE_BF16))
+    else if (std::is_same_v<ActType, nv_bfloat16>)
+    {
+        weight_only_low_bit_gemv<ActType, QType, GroupSize, Batch, BlockSize>(
+            qweight, scales, zeros, in, act_scale, bias, out, m, n, k);
+    }
+#endif
+}
+
+template <WeightOnlyQuantType QType, int GroupSize, int Batch, int BlockSize>
+struct WeightOnlyLowBitGemvKernelLauncher
+{
+    static void run(const WeightOnlyParams& params, cudaStream_t stream)
+    {
+        dim3 grid((params.n + BlockSize / 32 - 1) / (BlockSize / 32));
+        dim3 block(BlockSize);
+        const uint32_t* qweight = reinterpret_cast<const uint32_t*>(params.qweight);
+        if (params.act_type == WeightOnlyActivationType::FP16)
+        {
+            weight_only_low_bit_gemv_wrapper<half, QType, GroupSize, Batch, BlockSize><<<grid, block, 0, stream>>>(
+                qweight, reinterpret_cast<const half*>(params.scales), reinterpret_cast<const half*>(params.zeros),
+                reinterpret_cast<const half*>(params.in), reinterpret_cast<const half*>(params.act_scale),
+                reinterpret_cast<const half*>(params.bias), reinterpret_cast<half*>(params.out), params.m, params.n,
+                params.k);
+        }
+#if defined(ENABLE_BF16)
+        else if (params.act_type == WeightOnlyActivationType::BF16)
+        {
+            weight_only_low_bit_gemv_wrapper<__nv_bfloat16, QType, GroupSize, Batch, BlockSize>
+                <<<grid, block, 0, stream>>>(qweight, reinterpret_cast<const __nv_bfloat16*>(params.scales),
+                    reinterpret_cast<const __nv_bfloat16*>(params.zeros),
+                    reinterpret_cast<const __nv_bfloat16*>(params.in),
+                    reinterpret_cast<const __nv_bfloat16*>(params.act_scale),
+                    reinterpret_cast<const __nv_bfloat16*>(params.bias), reinterpret_cast<__nv_bfloat16*>(params.out),
+                    params.m, params.n, params.k);
+        }
+#endif
+    }
+};
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/lowBitKernel.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 1, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 2, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 3, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 4, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 8, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 12, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 64, 16, 256>;
+
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 1, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 2, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 3, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 4, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 8, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 12, 256>;
+template struct WeightOnlyLowBitGemvKernelLauncher<WeightOnlyQuantType::NF4, 128, 16, 256>;
+
+} // namespace kernels
+} // namespace tensorrt_llm
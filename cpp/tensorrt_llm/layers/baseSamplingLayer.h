@@ -20,6 +20,7 @@
 #include <curand_kernel.h>
 
 #include "tensorrt_llm/common/tensor.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
 #include "tensorrt_llm/kernels/penaltyTypes.h"
 #include "tensorrt_llm/layers/baseLayer.h"
 #include "tensorrt_llm/layers/decodingParams.h"
@@ -46,6 +47,8 @@ public:
         std::optional<std::vector<float>> top_p_decay;            // [batchSize], must between [0, 1]
         std::optional<std::vector<float>> top_p_min;              // [batchSize], must between [0, 1]
         std::optional<std::vector<std::int32_t>> top_p_reset_ids; // [batchSize]
+        std::optional<std::vector<float>> runtime_min_p;          // [1] or [batchSize] on cpu
+        std::optional<std::vector<float>> runtime_typical_p;      // [1] or [batchSize] on cpu
         std::optional<bool> normalize_log_probs;
     };
 
@@ -63,7 +66,7 @@ public:
 
         // optional parameters
         std::optional<tc::Tensor> input_lengths; // [localBatchSize]
-        curandState_t* curand_states;            // [localBatchSize]
+        kernels::PhiloxState* curand_states;     // [localBatchSize]
         // Pointer to the workspace for sampling computation
         void* sampling_workspace;
         // Flag to mark that logits tensor contains probabilities
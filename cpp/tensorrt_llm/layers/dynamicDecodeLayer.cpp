@@ -16,17 +16,22 @@
 
 #include "tensorrt_llm/layers/dynamicDecodeLayer.h"
 #include "tensorrt_llm/common/memoryUtils.h"
-#include "tensorrt_llm/kernels/banBadWords.h"
+#include "tensorrt_llm/kernels/ahoCorasickKernels.h"
 #include "tensorrt_llm/kernels/banRepeatNgram.h"
 #include "tensorrt_llm/kernels/decodingKernels.h"
 #include "tensorrt_llm/kernels/penaltyKernels.h"
 #include "tensorrt_llm/kernels/stopCriteriaKernels.h"
+#include "tensorrt_llm/kernels/topNLogProbsKernels.h"
 #include "tensorrt_llm/layers/baseBeamSearchLayer.h"
 #include "tensorrt_llm/layers/fillBuffers.h"
 #include "tensorrt_llm/layers/onlineBeamSearchLayer.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/cudaStream.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 using namespace tensorrt_llm::common;
 using namespace tensorrt_llm::kernels;
 using namespace tensorrt_llm::runtime;
@@ -105,6 +110,10 @@ DynamicDecodeLayer<T>::~DynamicDecodeLayer()
 {
     TLLM_LOG_TRACE(__PRETTY_FUNCTION__);
     freeBuffer();
+    if (mSetupStagingEvent != nullptr)
+    {
+        cudaEventDestroy(mSetupStagingEvent);
+    }
 }
 
 template <typename T>
@@ -114,6 +123,10 @@ void DynamicDecodeLayer<T>::initialize()
 
     mIdsPtrHost = runtime::BufferManager::pinned(ITensor::makeShape({}), runtime::TRTDataType<int*>::value);
     mLogitsPtrsHost = runtime::BufferManager::pinned(ITensor::makeShape({}), runtime::TRTDataType<T*>::value);
+    mSetupStagingHost = runtime::BufferManager::pinned(
+        ITensor::makeShape({BatchedParams::kMaxParams + 1, static_cast<int32_t>(mMaxBatchSize)}),
+        nvinfer1::DataType::kINT32);
+    TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mSetupStagingEvent, cudaEventDisableTiming));
 
     allocateBuffer();
 
@@ -126,6 +139,9 @@ void DynamicDecodeLayer<T>::initialize()
     mPresencePenalty.resize(mMaxBatchSize);
     mFrequencyPenalty.resize(mMaxBatchSize);
     mMinLength.resize(mMaxBatchSize);
+    mLogitsSoftCap.resize(mMaxBatchSize);
+    mAllowedTokens.resize(mMaxBatchSize);
+    mNumAllowedTokens.resize(mMaxBatchSize);
 
     if (!mDecodingMode.isNone())
     {
@@ -144,6 +160,12 @@ void DynamicDecodeLayer<T>::allocateBuffer()
     mPresencePenaltyDevice = mAllocator->reMalloc(mPresencePenaltyDevice, sizeof(float) * mMaxBatchSize, false);
     mFrequencyPenaltyDevice = mAllocator->reMalloc(mFrequencyPenaltyDevice, sizeof(float) * mMaxBatchSize, false);
     mMinLengthDevice = mAllocator->reMalloc(mMinLengthDevice, sizeof(int32_t) * mMaxBatchSize, false);
+    mLogitsSoftCapDevice = mAllocator->reMalloc(mLogitsSoftCapDevice, sizeof(float) * mMaxBatchSize, false);
+    mNumAllowedTokensDevice = mAllocator->reMalloc(mNumAllowedTokensDevice, sizeof(int32_t) * mMaxBatchSize, true);
+    mActiveSlotsDevice = mAllocator->reMalloc(mActiveSlotsDevice, sizeof(int32_t) * mMaxBatchSize, false);
+    mNumActiveSlotsDevice = mAllocator->reMalloc(mNumActiveSlotsDevice, sizeof(int32_t), false);
+    mSetupStagingDevice = mAllocator->reMalloc(
+        mSetupStagingDevice, sizeof(uint32_t) * (BatchedParams::kMaxParams + 1) * mMaxBatchSize, false);
     mRuntimeLogitsDevice = mAllocator->reMalloc(
         mRuntimeLogitsDevice, sizeof(T) * mMaxBatchSize * mMaxBeamWidth * mVocabSizePadded, false);
 }
@@ -161,11 +183,25 @@ void DynamicDecodeLayer<T>::freeBuffer()
     {
         mAllocator->free((void**) &mPenaltyWorkspacePrevDevice);
     }
+    if (mPenaltyUniqueTokensDevice != nullptr)
+    {
+        mAllocator->free((void**) &mPenaltyUniqueTokensDevice);
+        mAllocator->free((void**) &mPenaltyNumUniqueTokensDevice);
+    }
     mAllocator->free((void**) (&mTemperatureDevice));
     mAllocator->free((void**) (&mRepetitionPenaltyDevice));
     mAllocator->free((void**) (&mPresencePenaltyDevice));
     mAllocator->free((void**) (&mFrequencyPenaltyDevice));
     mAllocator->free((void**) (&mMinLengthDevice));
+    mAllocator->free((void**) (&mLogitsSoftCapDevice));
+    mAllocator->free((void**) (&mNumAllowedTokensDevice));
+    mAllocator->free((void**) (&mActiveSlotsDevice));
+    mAllocator->free((void**) (&mNumActiveSlotsDevice));
+    mAllocator->free((void**) (&mSetupStagingDevice));
+    if (mAllowedTokensDevice != nullptr)
+    {
+        mAllocator->free((void**) (&mAllowedTokensDevice));
+    }
     mAllocator->free((void**) (&mRuntimeLogitsDevice));
 }
 
@@ -173,10 +209,15 @@ template <typename T>
 void DynamicDecodeLayer<T>::initializeLayers()
 {
     const size_t workspaceSize = sizeof(int) * mMaxBatchSize * mConfiguredBeamWidth * mVocabSize;
-    mPenaltyWorkspaceDevice = mAllocator->reMalloc(mPenaltyWorkspaceDevice, workspaceSize, false);
+    // With beam width 1 the workspace holds the token counts of every slot and must start zeroed, see TokenCounts
+    mPenaltyWorkspaceDevice
+        = mAllocator->reMalloc(mPenaltyWorkspaceDevice, workspaceSize, mDecodingMode.isSampling());
 
-    if (mDecodingMode.isTopKorTopP())
+    if (mDecodingMode.isSampling())
     {
+        mPenaltyUniqueTokensDevice = mAllocator->reMalloc(mPenaltyUniqueTokensDevice, workspaceSize, false);
+        mPenaltyNumUniqueTokensDevice
+            = mAllocator->reMalloc(mPenaltyNumUniqueTokensDevice, sizeof(int32_t) * mMaxBatchSize, true);
         mSamplingLayer = std::make_unique<SamplingLayer<T>>(
             mDecodingMode, mMaxBatchSize, mVocabSize, mVocabSizePadded, mStream, mAllocator, mCudaDeviceProp);
     }
@@ -188,7 +229,8 @@ void DynamicDecodeLayer<T>::initializeLayers()
     }
     else
     {
-        TLLM_CHECK_WITH_INFO(false, "Decoding mode is none of the supported {TopK, TopP, TopKTopP, BeamSearch}");
+        TLLM_CHECK_WITH_INFO(
+            false, "Decoding mode is none of the supported {TopK, TopP, TopKTopP, MinP, TypicalP, BeamSearch}");
     }
 }
 
@@ -208,37 +250,67 @@ void DynamicDecodeLayer<T>::setup(
         initializeLayers();
     }
 
-    TLLM_CHECK_WITH_INFO((mConfiguredBeamWidth == 1 && beamWidth == 1)
-            || (mConfiguredBeamWidth > 1 && beamWidth > 1 && beamWidth <= mConfiguredBeamWidth),
+    // A decoder configured for beam search also decodes requests with beam width 1, they are sampled instead
+    TLLM_CHECK_WITH_INFO(beamWidth > 0 && beamWidth <= static_cast<size_t>(mConfiguredBeamWidth),
         "Decoder is configured with beam width %d, but %lu was given", mConfiguredBeamWidth, beamWidth);
     TLLM_CHECK_WITH_INFO(mConfiguredBeamWidth <= mMaxBeamWidth,
         "Decoder is created with max beam width %lu, but %d was given", mMaxBeamWidth, mConfiguredBeamWidth);
 
-    setupLayers(batchSize, beamWidth, batchSlots, setupParams);
+    auto penaltyTemperature = setupParams.temperature;
+    setupLayers(batchSize, beamWidth, batchSlots, setupParams, penaltyTemperature);
 
-    setupPenalties(batchSize, batchSlots, setupParams);
+    setupPenalties(batchSize, batchSlots, setupParams, penaltyTemperature);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
 template <typename T>
-void DynamicDecodeLayer<T>::setupLayers(
-    size_t batchSize, size_t beamWidth, int32_t const* batchSlots, SetupParams const& setupParams)
+void DynamicDecodeLayer<T>::setupLayers(size_t batchSize, size_t beamWidth, int32_t const* batchSlots,
+    SetupParams const& setupParams, std::optional<std::vector<float>>& penaltyTemperature)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     if (beamWidth == 1)
     { // sampling layers
-        TLLM_CHECK_WITH_INFO(
-            mDecodingMode.isTopKorTopP(), "beamWidth == 1 is given, but decoder is not configured as TopK or TopP");
+        if (!mSamplingLayer)
+        {
+            // Requests with beam width 1 in a decoder configured for beam search
+            TLLM_CHECK(mDecodingMode.isBeamSearch());
+            TLLM_LOG_DEBUG("Creating sampling layer for beam width 1 in beam search decoder");
+            mSamplingLayer = std::make_unique<SamplingLayer<T>>(DecodingMode::TopKTopP(), mMaxBatchSize, mVocabSize,
+                mVocabSizePadded, mStream, mAllocator, mCudaDeviceProp);
+        }
         typename TopPSamplingLayer<T>::SetupParams samplingParams;
 
         samplingParams.runtime_top_k = setupParams.runtime_top_k;
         samplingParams.runtime_top_p = setupParams.runtime_top_p;
+        auto const& temperature = setupParams.temperature;
+        if ((mDecodingMode.isTopK() || mDecodingMode.isBeamSearch()) && temperature
+            && std::any_of(temperature->begin(), temperature->end(), [](float t) { return t == 0.f; }))
+        {
+            // Temperature 0 is greedy search, take the argmax path of K=1 instead of sampling a sharpened distribution
+            TLLM_CHECK_WITH_INFO(temperature->size() == 1 || temperature->size() == batchSize,
+                "Argument vector size mismatch.");
+            auto const& topKs = setupParams.runtime_top_k.value_or(std::vector<uint32_t>{0});
+            std::vector<uint32_t> runtimeTopK(batchSize);
+            // The logits of greedy requests are not scaled, 1 / (0 + 1e-6) would overflow them in half precision and
+            // sharpen their log probs
+            std::vector<float> temperatures(batchSize);
+            for (size_t bi = 0; bi < batchSize; ++bi)
+            {
+                auto const t = temperature->size() == 1 ? temperature->front() : temperature.value()[bi];
+                runtimeTopK[bi] = t == 0.f ? 1 : topKs.size() == 1 ? topKs.front() : topKs[bi];
+                temperatures[bi] = t == 0.f ? 1.f : t;
+            }
+            samplingParams.runtime_top_k = std::move(runtimeTopK);
+            penaltyTemperature = std::move(temperatures);
+        }
         samplingParams.randomSeed = setupParams.randomSeed;
 
         samplingParams.top_p_decay = setupParams.top_p_decay;
         samplingParams.top_p_min = setupParams.top_p_min;
         samplingParams.top_p_reset_ids = setupParams.top_p_reset_ids;
+        samplingParams.runtime_min_p = setupParams.runtime_min_p;
+        samplingParams.runtime_typical_p = setupParams.runtime_typical_p;
         samplingParams.normalize_log_probs = setupParams.normalize_log_probs;
 
         mSamplingLayer->setup(batchSize, batchSlots, samplingParams);
@@ -260,7 +332,8 @@ void DynamicDecodeLayer<T>::setupLayers(
 }
 
 template <typename T>
-void DynamicDecodeLayer<T>::setupPenalties(size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams)
+void DynamicDecodeLayer<T>::setupPenalties(size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams,
+    std::optional<std::vector<float>> const& penaltyTemperature)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     std::vector<int32_t> batchSlotsVec(batchSize);
@@ -270,36 +343,119 @@ void DynamicDecodeLayer<T>::setupPenalties(size_t batchSize, int32_t const* batc
     // Setup penalties.
     FillBuffers const fillBuffers{batchSize, mMaxBatchSize, mStream};
 
-    mUseTemperature = static_cast<bool>(setupParams.temperature);
+    mUseTemperature = static_cast<bool>(penaltyTemperature);
     mUseRepetitionPenalty = static_cast<bool>(setupParams.repetition_penalty);
     mUsePresencePenalty = static_cast<bool>(setupParams.presence_penalty);
     mUseFrequencyPenalty = static_cast<bool>(setupParams.frequency_penalty);
     mUseMinLength = static_cast<bool>(setupParams.min_length);
+    mUseLogitsSoftCap = static_cast<bool>(setupParams.logits_soft_cap);
+
+    // The penalties of the new requests are staged together, copied once and scattered to their slots by one kernel
+    TLLM_CUDA_CHECK(cudaEventSynchronize(mSetupStagingEvent));
+    auto* staging = reinterpret_cast<uint32_t*>(runtime::bufferCast<int32_t>(*mSetupStagingHost));
+    std::copy(batchSlotsHost, batchSlotsHost + batchSize, staging);
+    BatchedParams batchedParams;
+    auto const stage = [&](auto const& optParam, auto const defaultValue, auto& hostBuffer, void* deviceBuffer)
+    {
+        fillBuffers.fillHost(optParam, defaultValue, hostBuffer, batchSlotsHost);
+        auto* row = staging + (batchedParams.numParams + 1) * batchSize;
+        for (size_t bi = 0; bi < batchSize; ++bi)
+        {
+            std::memcpy(row + bi, &hostBuffer[batchSlotsHost[bi]], sizeof(uint32_t));
+        }
+        batchedParams.dst[batchedParams.numParams++] = deviceBuffer;
+    };
     if (mUseTemperature)
     {
-        fillBuffers(setupParams.temperature, getDefaultPenaltyValue(DecodingPenaltyType::Temperature), mTemperature,
-            mTemperatureDevice, batchSlotsHost);
+        stage(penaltyTemperature, getDefaultPenaltyValue(DecodingPenaltyType::Temperature), mTemperature,
+            mTemperatureDevice);
     }
     if (mUseRepetitionPenalty)
     {
-        fillBuffers(setupParams.repetition_penalty, getDefaultPenaltyValue(DecodingPenaltyType::Repetition),
-            mRepetitionPenalty, mRepetitionPenaltyDevice, batchSlotsHost);
+        stage(setupParams.repetition_penalty, getDefaultPenaltyValue(DecodingPenaltyType::Repetition),
+            mRepetitionPenalty, mRepetitionPenaltyDevice);
     }
     if (mUsePresencePenalty)
     {
-        fillBuffers(setupParams.presence_penalty, getDefaultPenaltyValue(DecodingPenaltyType::Presence),
-            mPresencePenalty, mPresencePenaltyDevice, batchSlotsHost);
+        stage(setupParams.presence_penalty, getDefaultPenaltyValue(DecodingPenaltyType::Presence), mPresencePenalty,
+            mPresencePenaltyDevice);
     }
     if (mUseFrequencyPenalty)
     {
-        fillBuffers(setupParams.frequency_penalty, getDefaultPenaltyValue(DecodingPenaltyType::Frequency),
-            mFrequencyPenalty, mFrequencyPenaltyDevice, batchSlotsHost);
+        stage(setupParams.frequency_penalty, getDefaultPenaltyValue(DecodingPenaltyType::Frequency),
+            mFrequencyPenalty, mFrequencyPenaltyDevice);
     }
     if (mUseMinLength)
     {
-        fillBuffers(setupParams.min_length, (int) getDefaultPenaltyValue(DecodingPenaltyType::MinLength), mMinLength,
-            mMinLengthDevice, batchSlotsHost);
+        stage(setupParams.min_length, (int) getDefaultPenaltyValue(DecodingPenaltyType::MinLength), mMinLength,
+            mMinLengthDevice);
+    }
+    if (mUseLogitsSoftCap)
+    {
+        stage(setupParams.logits_soft_cap, getDefaultPenaltyValue(DecodingPenaltyType::LogitsSoftCap),
+            mLogitsSoftCap, mLogitsSoftCapDevice);
+    }
+    if (batchedParams.numParams > 0)
+    {
+        TLLM_CUDA_CHECK(cudaMemcpyAsync(mSetupStagingDevice, staging,
+            sizeof(uint32_t) * (batchedParams.numParams + 1) * batchSize, cudaMemcpyHostToDevice, mStream));
+        invokeScatterBatchedParams(mSetupStagingDevice, batchedParams, static_cast<int32_t>(batchSize), mStream);
+        TLLM_CUDA_CHECK(cudaEventRecord(mSetupStagingEvent, mStream));
     }
+    setupAllowedTokens(batchSize, batchSlotsHost, setupParams);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void DynamicDecodeLayer<T>::setupAllowedTokens(
+    size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    // Unlike the penalties, slots of this setup without a list are reset, so that other slots keep their lists
+    auto const& allowedTokens = setupParams.allowed_tokens;
+    TLLM_CHECK_WITH_INFO(!allowedTokens || allowedTokens->size() == 1 || allowedTokens->size() == batchSize,
+        "Argument vector size mismatch.");
+    for (size_t bi = 0; bi < batchSize; ++bi)
+    {
+        auto const batchSlot = batchSlots[bi];
+        auto& slotTokens = mAllowedTokens[batchSlot];
+        slotTokens.clear();
+        if (allowedTokens)
+        {
+            slotTokens = allowedTokens->size() == 1 ? allowedTokens->front() : allowedTokens.value()[bi];
+        }
+        for (auto const token : slotTokens)
+        {
+            TLLM_CHECK_WITH_INFO(0 <= token && token < static_cast<int32_t>(mVocabSize),
+                "Allowed token %d is out of the vocabulary (%lu)", token, mVocabSize);
+        }
+        mNumAllowedTokens[batchSlot] = static_cast<int32_t>(slotTokens.size());
+    }
+
+    auto const maxNumAllowedTokens = *std::max_element(mNumAllowedTokens.begin(), mNumAllowedTokens.end());
+    mUseAllowedTokens = maxNumAllowedTokens > 0;
+    if (maxNumAllowedTokens > mMaxNumAllowedTokens)
+    {
+        // Grow the buffer and upload the lists of all slots, since the row stride changes
+        mMaxNumAllowedTokens = maxNumAllowedTokens;
+        mAllowedTokensDevice = mAllocator->reMalloc(
+            mAllowedTokensDevice, sizeof(int32_t) * mMaxBatchSize * mMaxNumAllowedTokens, false);
+        for (size_t slot = 0; slot < mMaxBatchSize; ++slot)
+        {
+            cudaAutoCpy(mAllowedTokensDevice + slot * mMaxNumAllowedTokens, mAllowedTokens[slot].data(),
+                mAllowedTokens[slot].size(), mStream);
+        }
+    }
+    else
+    {
+        for (size_t bi = 0; bi < batchSize; ++bi)
+        {
+            auto const batchSlot = batchSlots[bi];
+            cudaAutoCpy(mAllowedTokensDevice + batchSlot * mMaxNumAllowedTokens, mAllowedTokens[batchSlot].data(),
+                mAllowedTokens[batchSlot].size(), mStream);
+        }
+    }
+    cudaAutoCpy(mNumAllowedTokensDevice, mNumAllowedTokens.data(), mMaxBatchSize, mStream);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -334,8 +490,8 @@ void DynamicDecodeLayer<T>::forward(OutputParams& outputs, ForwardParams const&
         vocabSize = logitsShape[2];
     }
 
-    TLLM_CHECK_WITH_INFO((mConfiguredBeamWidth == 1 && beamWidth == 1)
-            || (mConfiguredBeamWidth > 1 && beamWidth > 1 && beamWidth <= mConfiguredBeamWidth),
+    // A decoder configured for beam search also decodes requests with beam width 1, they are sampled instead
+    TLLM_CHECK_WITH_INFO(beamWidth > 0 && beamWidth <= static_cast<size_t>(mConfiguredBeamWidth),
         "Decoder is configured with beam width %d, but %lu was given", mConfiguredBeamWidth, beamWidth);
 
     if (!mLogitsPtrsHost->data())
@@ -360,21 +516,30 @@ void DynamicDecodeLayer<T>::forward(OutputParams& outputs, ForwardParams const&
     auto logits = Tensor(MEMORY_GPU, std::is_same_v<T, float> ? DataType::TYPE_FP32 : DataType::TYPE_FP16,
         {batchSize, beamWidth, mVocabSizePadded}, mRuntimeLogitsDevice);
 
+    // Finished requests are skipped by the kernels that do nothing useful for them
+    auto const activeSlots = compactActiveSlots(params, batchSlots, batchSize, beamWidth);
+
     // Apply penalties
-    applyPenalties(outputs, params, batchSlotsHost, batchSlots, batchSize, beamWidth, maxSeqLen);
+    applyPenalties(outputs, params, batchSlotsHost, batchSlots, batchSize, beamWidth, maxSeqLen, activeSlots);
 
-    // Ban bad words and NGrams
+    // Ban NGrams, bad words are banned together with the penalties
     banWords(logits, outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, mVocabSizePadded, mStream);
 
+    // Custom logits manipulation registered per request, enqueued on the decoder stream
+    applyLogitsPostProcessors(logits, params, batchSlotsHost, batchSize, beamWidth);
+
+    // Alternatives of the token sampled below, computed on the final logits
+    computeTopNLogProbs(logits, outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen);
+
     // Main function that calls forward of the respective layers
     layersForward(logits, outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen);
 
     // Check if stop conditions are met
-    checkStopCriteria(outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, mStream);
+    checkStopCriteria(outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, activeSlots, mStream);
 
     // Copy nextIds and transpose logits when needed
-    prepareOutputData(
-        outputs, params, mIdsPtrHost, batchSlots, batchSize, mMaxBatchSize, beamWidth, maxSeqLen, mCyclicStep, mStream);
+    prepareOutputData(outputs, params, mIdsPtrHost, batchSlots, batchSize, mMaxBatchSize, beamWidth, maxSeqLen,
+        mCyclicStep, getTokenCounts(beamWidth), activeSlots, mStream);
 
     mCyclicStep += 1;
 
@@ -456,8 +621,7 @@ void DynamicDecodeLayer<T>::layersForward(Tensor& logits, OutputParams& outputs,
     }
     else
     { // beamWidth == 1
-        TLLM_CHECK_WITH_INFO(
-            mDecodingMode.isTopKorTopP(), "beamWidth == 1 is given, but decoder is not configured as TopK or TopP");
+        TLLM_CHECK_WITH_INFO(mSamplingLayer, "beamWidth == 1 is given, but no sampling request has been set up");
 
         // In sampling, we have supported batch sampling. So, we always compute all
         // sentences once.
@@ -503,7 +667,8 @@ void DynamicDecodeLayer<T>::layersForward(Tensor& logits, OutputParams& outputs,
 
 template <typename T>
 void DynamicDecodeLayer<T>::applyPenalties(OutputParams& outputs, ForwardParams const& params,
-    int32_t const* batchSlotsHost, int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen)
+    int32_t const* batchSlotsHost, int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen,
+    ActiveSlots const& activeSlots)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
@@ -542,9 +707,15 @@ void DynamicDecodeLayer<T>::applyPenalties(OutputParams& outputs, ForwardParams
     auto* presencePenalties = GET_PENALTIES(PresencePenalty, Presence, float);
     auto* frequencyPenalties = GET_PENALTIES(FrequencyPenalty, Frequency, float);
     auto* minLengths = GET_PENALTIES(MinLength, MinLength, int32_t);
+    auto* logitsSoftCaps = GET_PENALTIES(LogitsSoftCap, LogitsSoftCap, float);
 
 #undef GET_PENALTIES
 
+    // Bad words only touch a few logits, they are banned by the penalty kernel instead of a separate launch.
+    auto const maxBadWordsLength = static_cast<int32_t>(params.max_bad_words_len);
+    auto const** badWordsPtr = maxBadWordsLength ? params.bad_words_ptr->template getPtr<int32_t const*>() : nullptr;
+    auto const* badWordsLens = maxBadWordsLength ? params.bad_words_lengths->template getPtr<int32_t>() : nullptr;
+
     InvokeBatchApplyPenaltyParams<T> penaltyParams{reinterpret_cast<T const* const*>(logitsPtrsHostData),
         mRuntimeLogitsDevice, embeddingBias, mPenaltyWorkspaceDevice, mPenaltyWorkspacePrevDevice, temperatures,
         repetitionPenalties, presencePenalties, frequencyPenalties,
@@ -552,13 +723,99 @@ void DynamicDecodeLayer<T>::applyPenalties(OutputParams& outputs, ForwardParams
         static_cast<int32_t>(beamWidth), static_cast<int32_t>(maxSeqLen), mVocabSize, mVocabSizePadded,
         outputs.output_ids_ptr.template getPtr<const int*>(), outputs.parent_ids_ptr.template getPtr<const int*>(),
         inputLengths, outputs.sequence_length->template getPtr<const int>(), minLengths,
-        params.end_ids.template getPtr<const int>(), batchSlots, mStream};
+        params.end_ids.template getPtr<const int>(), batchSlots, mStream, badWordsPtr, badWordsLens,
+        maxBadWordsLength, getTokenCounts(beamWidth), logitsSoftCaps,
+        mUseAllowedTokens ? AllowedTokens{mAllowedTokensDevice, mNumAllowedTokensDevice, mMaxNumAllowedTokens}
+                          : AllowedTokens{},
+        activeSlots};
     invokeBatchApplyPenalty(penaltyParams);
     sync_check_cuda_error();
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+template <typename T>
+void DynamicDecodeLayer<T>::applyLogitsPostProcessors(
+    Tensor& logits, ForwardParams const& params, int32_t const* batchSlotsHost, size_t batchSize, size_t beamWidth)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    if (!params.logits_post_processors)
+    {
+        return;
+    }
+    auto const& processors = params.logits_post_processors.value();
+
+    // Group the batch by processor, so that each processor sees all of its requests at once
+    std::vector<runtime::LogitsPostProcessorPtr> uniqueProcessors;
+    std::vector<std::vector<runtime::SizeType>> processorBatchIndices;
+    for (size_t bi = 0; bi < batchSize; ++bi)
+    {
+        auto const batchSlot = batchSlotsHost[bi];
+        TLLM_CHECK_WITH_INFO(static_cast<size_t>(batchSlot) < processors.size(),
+            "Batch slot %d is out of range of the logits post-processors (%lu)", batchSlot, processors.size());
+        auto const& processor = processors[batchSlot];
+        if (!processor)
+        {
+            continue;
+        }
+        auto it = std::find(uniqueProcessors.begin(), uniqueProcessors.end(), processor);
+        if (it == uniqueProcessors.end())
+        {
+            uniqueProcessors.push_back(processor);
+            processorBatchIndices.emplace_back();
+            it = std::prev(uniqueProcessors.end());
+        }
+        auto const processorIdx = std::distance(uniqueProcessors.begin(), it);
+        processorBatchIndices[processorIdx].push_back(static_cast<runtime::SizeType>(bi));
+    }
+
+    if (uniqueProcessors.empty())
+    {
+        return;
+    }
+
+    auto logitsView = ITensor::wrap(logits.template getPtr<T>(), runtime::TRTDataType<T>::value,
+        ITensor::makeShape({static_cast<runtime::SizeType>(batchSize), static_cast<runtime::SizeType>(beamWidth),
+            static_cast<runtime::SizeType>(mVocabSizePadded)}));
+    auto const batchSlotsView = ITensor::wrap(
+        const_cast<int32_t*>(batchSlotsHost), ITensor::makeShape({static_cast<runtime::SizeType>(batchSize)}));
+    for (size_t pi = 0; pi < uniqueProcessors.size(); ++pi)
+    {
+        (*uniqueProcessors[pi])(*logitsView, *batchSlotsView, processorBatchIndices[pi], mStream);
+    }
+
+    sync_check_cuda_error();
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void DynamicDecodeLayer<T>::computeTopNLogProbs(Tensor const& logits, OutputParams& outputs,
+    ForwardParams const& params, int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    if (!outputs.top_n_ids)
+    {
+        return;
+    }
+    TLLM_CHECK_WITH_INFO(outputs.top_n_log_probs.has_value(), "top_n_log_probs is required with top_n_ids");
+    auto const& topNShape = outputs.top_n_ids->shape;
+    TLLM_CHECK_WITH_INFO(topNShape.size() == 4 && topNShape[2] == maxSeqLen,
+        "top_n_ids must have shape [max_batch_size, beam_width, max_seq_len, top_n]");
+    auto const topN = static_cast<int32_t>(topNShape[3]);
+
+    auto const* finished = reinterpret_cast<FinishedState const*>(
+        params.finished.value_or(Tensor{}).template getPtr<FinishedState::UnderlyingType const>());
+    invokeTopNLogProbs(outputs.top_n_ids->template getPtr<int32_t>(),
+        outputs.top_n_log_probs->template getPtr<float>(), logits.template getPtr<T const>(), finished,
+        outputs.sequence_length->template getPtr<int32_t const>(), batchSlots, static_cast<int32_t>(batchSize),
+        static_cast<int32_t>(beamWidth), static_cast<int32_t>(mVocabSize), static_cast<int32_t>(mVocabSizePadded),
+        static_cast<int32_t>(maxSeqLen), topN, mStream);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
 template <typename T>
 void DynamicDecodeLayer<T>::banWords(Tensor& logits, OutputParams& outputs, ForwardParams const& params,
     int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, size_t vocabSizePadded,
@@ -567,7 +824,7 @@ void DynamicDecodeLayer<T>::banWords(Tensor& logits, OutputParams& outputs, Forw
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
     banRepeatNGrams(logits, outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, vocabSizePadded, stream);
-    banBadWords(logits, outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, vocabSizePadded, stream);
+    banBadWordsAutomata(logits, params, batchSlots, batchSize, beamWidth, vocabSizePadded, stream);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -594,32 +851,32 @@ void DynamicDecodeLayer<T>::banRepeatNGrams(Tensor& logits, OutputParams& output
 }
 
 template <typename T>
-void DynamicDecodeLayer<T>::banBadWords(Tensor& logits, OutputParams& outputs, ForwardParams const& params,
-    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, size_t vocabSizePadded,
-    cudaStream_t stream)
+void DynamicDecodeLayer<T>::banBadWordsAutomata(Tensor& logits, ForwardParams const& params,
+    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t vocabSizePadded, cudaStream_t stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
-    auto const maxBadWordsLength = params.max_bad_words_len;
-    if (maxBadWordsLength)
+    if (params.bad_words_automata)
     {
-        int32_t const** badWordsPtr = params.bad_words_ptr->template getPtr<int32_t const*>();
-        int32_t const* badWordsLens = params.bad_words_lengths->template getPtr<int32_t>();
-
-        invokeBanBadWords((T*) logits.template getPtr<T>(), outputs.output_ids_ptr.template getPtr<int32_t const*>(),
-            beamWidth > 1 ? outputs.parent_ids_ptr.template getPtr<int32_t const*>() : nullptr, batchSlots, batchSize,
-            beamWidth, badWordsPtr, badWordsLens, maxBadWordsLength, vocabSizePadded,
-            outputs.sequence_length->template getPtr<int>(), maxSeqLen, stream);
+        TLLM_CHECK_WITH_INFO(beamWidth == 1, "Bad words automata are only supported with beam width 1");
+        TLLM_CHECK_WITH_INFO(params.words_automata_states.has_value(), "Words automata require their states");
+        invokeBanBadWordsAhoCorasick(logits.template getPtr<T>(),
+            params.bad_words_automata->template getPtr<int32_t const* const>(),
+            params.words_automata_states->template getPtr<int32_t const>(), batchSlots,
+            static_cast<int32_t>(batchSize), static_cast<int32_t>(vocabSizePadded), stream);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
 template <typename T>
 void DynamicDecodeLayer<T>::checkStopCriteria(OutputParams& outputs, ForwardParams const& params,
-    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, cudaStream_t stream)
+    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, ActiveSlots const& activeSlots,
+    cudaStream_t stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    checkStopWordsStopCriteria(outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, stream);
+    checkStopWordsStopCriteria(outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, activeSlots, stream);
+    checkWordsAutomataStopCriteria(outputs, params, batchSlots, batchSize, beamWidth, stream);
+    // Over the whole batch, the finished sums of the finished requests are read back too
     checkMaxLengthStopCriteria(outputs, params, batchSlots, batchSize, beamWidth, maxSeqLen, stream);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -627,7 +884,8 @@ void DynamicDecodeLayer<T>::checkStopCriteria(OutputParams& outputs, ForwardPara
 
 template <typename T>
 void DynamicDecodeLayer<T>::checkStopWordsStopCriteria(OutputParams& outputs, ForwardParams const& params,
-    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, cudaStream_t stream)
+    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, ActiveSlots const& activeSlots,
+    cudaStream_t stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     auto const maxStopWordsLength = params.max_stop_words_len;
@@ -639,7 +897,28 @@ void DynamicDecodeLayer<T>::checkStopWordsStopCriteria(OutputParams& outputs, Fo
             reinterpret_cast<FinishedState*>(outputs.finished->template getPtr<FinishedState::UnderlyingType>()),
             outputs.sequence_length->template getPtr<int32_t>(), batchSlots,
             params.stop_words_lengths->template getPtr<int32_t const>(), maxStopWordsLength, batchSize, beamWidth,
-            maxSeqLen, stream);
+            maxSeqLen, stream, activeSlots);
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void DynamicDecodeLayer<T>::checkWordsAutomataStopCriteria(OutputParams& outputs, ForwardParams const& params,
+    int32_t const* batchSlots, size_t batchSize, size_t beamWidth, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (params.stop_words_automata || params.bad_words_automata)
+    {
+        TLLM_CHECK_WITH_INFO(beamWidth == 1, "Words automata are only supported with beam width 1");
+        TLLM_CHECK_WITH_INFO(params.words_automata_states.has_value(), "Words automata require their states");
+        // Advance by the token sampled in this step, the states are used to ban bad words in the next step
+        invokeAdvanceWordsAutomata(params.stop_words_automata.value_or(Tensor{}).template getPtr<int32_t const*>(),
+            params.bad_words_automata.value_or(Tensor{}).template getPtr<int32_t const*>(),
+            params.words_automata_states->template getPtr<int32_t>(),
+            outputs.output_ids_ptr.template getPtr<int32_t const*>(),
+            reinterpret_cast<FinishedState*>(outputs.finished->template getPtr<FinishedState::UnderlyingType>()),
+            outputs.sequence_length->template getPtr<int32_t const>(), batchSlots, static_cast<int32_t>(batchSize),
+            stream);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -695,16 +974,48 @@ void DynamicDecodeLayer<T>::prepareIdsPtrs(
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+template <typename T>
+TokenCounts DynamicDecodeLayer<T>::getTokenCounts(size_t beamWidth) const
+{
+    if (beamWidth > 1 || mPenaltyUniqueTokensDevice == nullptr
+        || !(mUseRepetitionPenalty || mUsePresencePenalty || mUseFrequencyPenalty))
+    {
+        return {};
+    }
+    return {mPenaltyWorkspaceDevice, mPenaltyUniqueTokensDevice, mPenaltyNumUniqueTokensDevice,
+        static_cast<int32_t>(mVocabSize)};
+}
+
+template <typename T>
+ActiveSlots DynamicDecodeLayer<T>::compactActiveSlots(
+    ForwardParams const& params, int32_t const* batchSlots, size_t batchSize, size_t beamWidth)
+{
+    // Beam search reads the logits of all the beams, also of the finished ones
+    if (beamWidth > 1 || !params.finished)
+    {
+        return {};
+    }
+    invokeCompactActiveSlots(mActiveSlotsDevice, mNumActiveSlotsDevice,
+        reinterpret_cast<FinishedState const*>(
+            params.finished->template getPtr<FinishedState::UnderlyingType const>()),
+        batchSlots, static_cast<int32_t>(batchSize), static_cast<int32_t>(beamWidth), mStream);
+    sync_check_cuda_error();
+    return {mActiveSlotsDevice, mNumActiveSlotsDevice};
+}
+
 template <typename T>
 void DynamicDecodeLayer<T>::prepareOutputData(OutputParams& outputs, ForwardParams const& params,
     runtime::ITensor::SharedPtr const& idsPtrsHost, int32_t const* batchSlots, size_t batchSize, size_t maxBatchSize,
-    size_t beamWidth, size_t maxSeqLen, int32_t cyclicStep, cudaStream_t stream)
+    size_t beamWidth, size_t maxSeqLen, int32_t cyclicStep, TokenCounts const& tokenCounts,
+    ActiveSlots const& activeSlots, cudaStream_t stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     auto idsPtrHostSlice = ITensor::slice(idsPtrsHost, cyclicStep, 1);
     auto idsPtrHost = reinterpret_cast<int32_t**>(runtime::bufferCast<int64_t>(*idsPtrHostSlice));
+    // Also counts the new tokens for the penalties of the next step
     invokeCopyNextStepIds(outputs.newTokens.template getPtr<int>(), idsPtrHost,
-        outputs.sequence_length->template getPtr<int>(), batchSlots, batchSize, beamWidth, maxSeqLen, stream);
+        outputs.sequence_length->template getPtr<int>(), batchSlots, batchSize, beamWidth, maxSeqLen, stream,
+        tokenCounts, activeSlots);
 
     // Transpose the output log probs from [maxSeqLen, bs, beamWidth] to [batchSize, beamWidth, maxSeqLen]
     if (outputs.output_log_probs_tiled)
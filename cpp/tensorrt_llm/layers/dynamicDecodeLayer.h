@@ -18,12 +18,14 @@
 
 #include "tensorrt_llm/common/tensor.h"
 #include "tensorrt_llm/kernels/beamSearchTopkKernels.h"
+#include "tensorrt_llm/kernels/penaltyKernels.h"
 #include "tensorrt_llm/layers/baseLayer.h"
 #include "tensorrt_llm/layers/onlineBeamSearchLayer.h"
 #include "tensorrt_llm/layers/samplingLayer.h"
 #include "tensorrt_llm/runtime/cudaStream.h"
 #include "tensorrt_llm/runtime/decodingMode.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/logitsPostProcessor.h"
 
 #include <optional>
 #include <string>
@@ -61,6 +63,9 @@ public:
         std::optional<std::vector<float>> presence_penalty;   // [1] or [batch_size] on cpu
         std::optional<std::vector<float>> frequency_penalty;  // [1] or [batch_size] on cpu
         std::optional<std::vector<std::int32_t>> min_length;  // [1] or [batch_size] on cpu
+        std::optional<std::vector<float>> logits_soft_cap;    // [1] or [batch_size] on cpu
+        // [1] or [batch_size] on cpu, tokens each request may generate, an empty list allows the whole vocabulary
+        std::optional<std::vector<std::vector<std::int32_t>>> allowed_tokens;
 
         // baseSamplingLayer
         std::optional<std::vector<std::uint32_t>> runtime_top_k; // [1] or [batch_size] on cpu
@@ -72,6 +77,10 @@ public:
         std::optional<std::vector<float>> top_p_min;              // [batch_size], must between [0, 1]
         std::optional<std::vector<std::int32_t>> top_p_reset_ids; // [batch_size]
 
+        // minPSamplingLayer and typicalPSamplingLayer
+        std::optional<std::vector<float>> runtime_min_p;     // [1] or [batch_size] on cpu
+        std::optional<std::vector<float>> runtime_typical_p; // [1] or [batch_size] on cpu
+
         // omlineBeamSearchLayer
         std::optional<std::vector<float>> beam_search_diversity_rate;
         std::optional<std::vector<float>> length_penalty;
@@ -127,8 +136,14 @@ public:
         std::optional<tc::Tensor> bad_words_lengths;    // [batch_size], on gpu
         std::optional<tc::Tensor> stop_words_ptr;       // [batch_size][2, stop_words_length], on gpu
         std::optional<tc::Tensor> stop_words_lengths;   // [batch_size], on gpu
+        // Aho-Corasick automata replacing the scan over [2, words_length] lists, beam width 1 only
+        std::optional<tc::Tensor> stop_words_automata;   // [max_batch_size] pointers or nullptr, in pinned memory
+        std::optional<tc::Tensor> bad_words_automata;    // [max_batch_size] pointers or nullptr, in pinned memory
+        std::optional<tc::Tensor> words_automata_states; // [max_batch_size, 2], on gpu
         std::optional<tc::Tensor> no_repeat_ngram_size; // [batch_size], optional
         std::optional<tc::Tensor> batch_slots;          // [batch_size], optional, in pinned memory
+        std::optional<std::vector<runtime::LogitsPostProcessorPtr>>
+            logits_post_processors; // [max_batch_size], optional, indexed by batch slot, on cpu
     };
 
     class OutputParams
@@ -144,7 +159,7 @@ public:
         tc::Tensor newTokens;  // [batch_size, beam_width]
         // optional parameters
         std::optional<tc::Tensor> finished;        // [batch_size * beam_width], optional
-        std::optional<tc::Tensor> finished_sum;    // [1], optional, in pinned host memory
+        std::optional<tc::Tensor> finished_sum;    // [maxBatchSize], optional, in device or pinned host memory
         std::optional<tc::Tensor> cum_log_probs;   // [batch_size * beam_width], necessary in beam search
         std::optional<tc::Tensor> parent_ids;      // [max_seq_len, batch_size * beam_width], necessary in beam search
         std::optional<tc::Tensor> sequence_length; // [batch_size * beam_width], optional
@@ -154,6 +169,8 @@ public:
             output_log_probs;       // [batch_size, beam_width, request_output_length], must be float*, optional
         std::optional<tc::Tensor>
             tgt_cache_indirection;  // [local_batch_size, beam_width, max_seq_len], the k/v cache index for beam search
+        std::optional<tc::Tensor> top_n_ids;       // [max_batch_size, beam_width, max_seq_len, top_n], optional
+        std::optional<tc::Tensor> top_n_log_probs; // [max_batch_size, beam_width, max_seq_len, top_n], optional
         std::shared_ptr<kernels::BeamHypotheses>
             beamHypotheses;         // a special structure which maintains some pointers of beam search
 
@@ -174,13 +191,24 @@ private:
     void initialize();
     void initializeLayers();
 
-    void setupLayers(size_t batchSize, size_t beamWidth, int32_t const* batchSlots, SetupParams const& setupParams);
-    void setupPenalties(size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams);
+    //! \param penaltyTemperature Temperature staged by setupPenalties, requests remapped to greedy search get 1.
+    void setupLayers(size_t batchSize, size_t beamWidth, int32_t const* batchSlots, SetupParams const& setupParams,
+        std::optional<std::vector<float>>& penaltyTemperature);
+    void setupPenalties(size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams,
+        std::optional<std::vector<float>> const& penaltyTemperature);
+    void setupAllowedTokens(size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams);
 
     void layersForward(tc::Tensor& logits, OutputParams& outputs, ForwardParams const& params,
         int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen);
 
     void applyPenalties(OutputParams& outputs, ForwardParams const& params, int32_t const* batchSlotsHost,
+        int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen,
+        kernels::ActiveSlots const& activeSlots);
+
+    void applyLogitsPostProcessors(tc::Tensor& logits, ForwardParams const& params, int32_t const* batchSlotsHost,
+        size_t batchSize, size_t beamWidth);
+
+    void computeTopNLogProbs(tc::Tensor const& logits, OutputParams& outputs, ForwardParams const& params,
         int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen);
 
     static void banWords(tc::Tensor& logits, OutputParams& outputs, ForwardParams const& params,
@@ -189,22 +217,34 @@ private:
     static void banRepeatNGrams(tc::Tensor& logits, OutputParams& outputs, ForwardParams const& params,
         int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, size_t vocabSizePadded,
         cudaStream_t stream);
-    static void banBadWords(tc::Tensor& logits, OutputParams& outputs, ForwardParams const& params,
-        int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, size_t vocabSizePadded,
-        cudaStream_t stream);
+    static void banBadWordsAutomata(tc::Tensor& logits, ForwardParams const& params, int32_t const* batchSlots,
+        size_t batchSize, size_t beamWidth, size_t vocabSizePadded, cudaStream_t stream);
 
     static void checkStopCriteria(OutputParams& outputs, ForwardParams const& params, int32_t const* batchSlots,
-        size_t batchSize, size_t beamWidth, size_t maxSeqLen, cudaStream_t stream);
+        size_t batchSize, size_t beamWidth, size_t maxSeqLen, kernels::ActiveSlots const& activeSlots,
+        cudaStream_t stream);
     static void checkMaxLengthStopCriteria(OutputParams& outputs, ForwardParams const& params,
         int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, cudaStream_t stream);
     static void checkStopWordsStopCriteria(OutputParams& outputs, ForwardParams const& params,
-        int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen, cudaStream_t stream);
+        int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen,
+        kernels::ActiveSlots const& activeSlots, cudaStream_t stream);
+    static void checkWordsAutomataStopCriteria(OutputParams& outputs, ForwardParams const& params,
+        int32_t const* batchSlots, size_t batchSize, size_t beamWidth, cudaStream_t stream);
 
     void prepareIdsPtrs(
         OutputParams& outputs, int32_t const* batchSlots, size_t batchSize, size_t beamWidth, size_t maxSeqLen);
     static void prepareOutputData(OutputParams& outputs, ForwardParams const& params,
         runtime::ITensor::SharedPtr const& idsPtrsHost, int32_t const* batchSlots, size_t batchSize,
-        size_t maxBatchSize, size_t beamWidth, size_t maxSeqLen, int32_t cyclicStep, cudaStream_t stream);
+        size_t maxBatchSize, size_t beamWidth, size_t maxSeqLen, int32_t cyclicStep,
+        kernels::TokenCounts const& tokenCounts, kernels::ActiveSlots const& activeSlots, cudaStream_t stream);
+
+    //! \brief Sparse token histogram for the penalties, disabled for beam search and if no penalty uses it.
+    [[nodiscard]] kernels::TokenCounts getTokenCounts(size_t beamWidth) const;
+
+    //! \brief Builds the list of the requests that were not finished before this step, so that the penalty, stop
+    //! words and next ids kernels skip the finished ones. Sampling only, disabled without the finished states.
+    kernels::ActiveSlots compactActiveSlots(
+        ForwardParams const& params, int32_t const* batchSlots, size_t batchSize, size_t beamWidth);
 
 private:
     std::unique_ptr<OnlineBeamSearchLayer<T>> mOnlineBeamSearchDecode;
@@ -221,6 +261,9 @@ private:
     int32_t* mZeroParentIdsDevice = nullptr;
     int32_t* mPenaltyWorkspaceDevice = nullptr;
     int32_t* mPenaltyWorkspacePrevDevice = nullptr;
+    // Distinct tokens of every slot for the sparse histogram in mPenaltyWorkspaceDevice, sampling only
+    int32_t* mPenaltyUniqueTokensDevice = nullptr;
+    int32_t* mPenaltyNumUniqueTokensDevice = nullptr;
     runtime::ITensor::SharedPtr mIdsPtrHost;
     runtime::ITensor::SharedPtr mLogitsPtrsHost;
 
@@ -229,19 +272,37 @@ private:
     float* mPresencePenaltyDevice = nullptr;
     float* mFrequencyPenaltyDevice = nullptr;
     int32_t* mMinLengthDevice = nullptr;
+    float* mLogitsSoftCapDevice = nullptr;
     T* mRuntimeLogitsDevice = nullptr;
+    // Allowed tokens of every slot, [mMaxBatchSize, mMaxNumAllowedTokens], grown on setup
+    int32_t* mAllowedTokensDevice = nullptr;
+    int32_t* mNumAllowedTokensDevice = nullptr;
+    // Requests not finished before the step, [mMaxBatchSize], and their number
+    int32_t* mActiveSlotsDevice = nullptr;
+    int32_t* mNumActiveSlotsDevice = nullptr;
+    // Batch slots and penalties of the requests of a setup, [1 + kMaxParams, mMaxBatchSize], copied at once
+    runtime::ITensor::SharedPtr mSetupStagingHost;
+    uint32_t* mSetupStagingDevice = nullptr;
+    // Recorded after the copy of mSetupStagingHost, which must complete before the next setup overwrites it
+    cudaEvent_t mSetupStagingEvent = nullptr;
 
     std::vector<float> mTemperature;
     std::vector<float> mRepetitionPenalty;
     std::vector<float> mPresencePenalty;
     std::vector<float> mFrequencyPenalty;
     std::vector<int32_t> mMinLength;
+    std::vector<float> mLogitsSoftCap;
+    std::vector<std::vector<int32_t>> mAllowedTokens;
+    std::vector<int32_t> mNumAllowedTokens;
+    int32_t mMaxNumAllowedTokens = 0;
 
     bool mUseTemperature = false;
     bool mUseRepetitionPenalty = false;
     bool mUsePresencePenalty = false;
     bool mUseFrequencyPenalty = false;
     bool mUseMinLength = false;
+    bool mUseLogitsSoftCap = false;
+    bool mUseAllowedTokens = false;
 
     bool mHasDiffRuntimeArgs = false;
     int* h_pinned_finished_sum_ = nullptr;
@@ -43,6 +43,23 @@ struct FillBuffers
     {
         using tensorrt_llm::common::cudaAutoCpy;
 
+        fillHost(optParam, defaultValue, hostBuffer, batchSlots);
+
+        if (batchSlots)
+        {
+            cudaAutoCpy(deviceBuffer, hostBuffer.data(), maxBatchSize, stream);
+        }
+        else
+        {
+            cudaAutoCpy(deviceBuffer, hostBuffer.data(), batchSize, stream);
+        }
+    }
+
+    //! Fills the slots of the batch in hostBuffer only, for callers that batch the copies to the device.
+    template <typename T>
+    void fillHost(std::optional<std::vector<T>> const& optParam, T const defaultValue, std::vector<T>& hostBuffer,
+        int32_t const* batchSlots) const
+    {
         for (size_t bi = 0; bi < batchSize; ++bi)
         {
             auto const batchSlot = batchSlots ? batchSlots[bi] : bi;
@@ -60,15 +77,6 @@ struct FillBuffers
                 hostBuffer[batchSlot] = optParam.value()[bi];
             }
         }
-
-        if (batchSlots)
-        {
-            cudaAutoCpy(deviceBuffer, hostBuffer.data(), maxBatchSize, stream);
-        }
-        else
-        {
-            cudaAutoCpy(deviceBuffer, hostBuffer.data(), batchSize, stream);
-        }
     }
 
     size_t batchSize;
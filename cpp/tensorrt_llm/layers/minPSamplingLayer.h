@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/tensor.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/layers/baseSamplingLayer.h"
+
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace layers
+{
+
+//! \brief Layer to randomly sample tokens among the tokens with a probability of at least minP times the probability
+//! of the most likely token.
+//! Layer expects probs precomputed in "logits" tensor
+template <typename T>
+class MinPSamplingLayer : public BaseSamplingLayer<T>
+{
+public:
+    using Base = BaseSamplingLayer<T>;
+    using SetupParams = typename Base::SetupParams;
+    using ForwardParams = typename Base::ForwardParams;
+
+    MinPSamplingLayer(std::size_t maxBatchSize, std::size_t vocabSize, std::size_t vocabSizePadded,
+        cudaStream_t stream, std::shared_ptr<tensorrt_llm::common::IAllocator> allocator);
+    ~MinPSamplingLayer();
+
+    void setup(std::size_t batchSize, int32_t const* batchSlots, SetupParams const& setupParams) override;
+    void forward(DecodingOutputParams& outputs, ForwardParams& inputs) override;
+
+protected:
+    float* mRuntimeMinPDevice = nullptr;
+    std::vector<float> mRuntimeMinPHost;
+
+    using Base::mMaxBatchSize;
+    using Base::mVocabSize;
+    using Base::mVocabSizePadded;
+
+    using Base::mSamplingWorkspaceSize;
+    using Base::mAllocatedSize;
+
+    using Base::mStream;
+    using Base::mAllocator;
+
+private:
+    void allocateBuffer(std::size_t batchSize);
+    void freeBuffer();
+};
+
+} // namespace layers
+} // namespace tensorrt_llm
@@ -79,7 +79,8 @@ __global__ void update_kernel(FinishedState* finished, BeamHypotheses beam_hyps)
         parent_ids_ptr[blockIdx.x][beam_idx * max_seq_len + current_step] = new_beam_id;
         output_ids_ptr[blockIdx.x][beam_idx * max_seq_len + current_step] = new_word_id;
     }
-    if (num_beams != nullptr && num_beams[ite * local_batch_size + blockIdx.x] == beam_width)
+    // Finish all beams once no live beam can improve on the finished ones, which frees the slot of the request
+    if (num_beams != nullptr && beam_hyps.is_done[ite * local_batch_size + blockIdx.x])
     {
         for (int beam_idx = threadIdx.x; beam_idx < beam_width; beam_idx += blockDim.x)
         {
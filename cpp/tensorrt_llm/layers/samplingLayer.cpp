@@ -45,9 +45,17 @@ void SamplingLayer<T>::allocateBuffer(size_t batchSize)
     {
         mSamplingWorkspaceSize = std::max(mSamplingWorkspaceSize, mTopPDecode->getWorkspaceSize());
     }
+    if (mDecodingMode.isMinP())
+    {
+        mSamplingWorkspaceSize = std::max(mSamplingWorkspaceSize, mMinPDecode->getWorkspaceSize());
+    }
+    if (mDecodingMode.isTypicalP())
+    {
+        mSamplingWorkspaceSize = std::max(mSamplingWorkspaceSize, mTypicalPDecode->getWorkspaceSize());
+    }
 
     std::array<size_t, 4> deviceBufferSizes;
-    deviceBufferSizes[0] = sizeof(curandState_t) * batchSize;
+    deviceBufferSizes[0] = sizeof(kernels::PhiloxState) * batchSize;
     deviceBufferSizes[1] = sizeof(uint64_t) * batchSize;
     deviceBufferSizes[2] = sizeof(bool) * batchSize;
     deviceBufferSizes[3] = mSamplingWorkspaceSize;
@@ -69,6 +77,14 @@ void SamplingLayer<T>::allocateBuffer(size_t batchSize)
     {
         mAllocatedSize += mTopPDecode->getAllocatedSize();
     }
+    if (mDecodingMode.isMinP())
+    {
+        mAllocatedSize += mMinPDecode->getAllocatedSize();
+    }
+    if (mDecodingMode.isTypicalP())
+    {
+        mAllocatedSize += mTypicalPDecode->getAllocatedSize();
+    }
 
     // host buffers.
     mSkipDecodeHost = (bool*) std::realloc(mSkipDecodeHost, sizeof(bool) * batchSize);
@@ -93,7 +109,7 @@ SamplingLayer<T>::SamplingLayer(DecodingMode const& mode, size_t maxBatchSize, s
     , mDecodingMode(mode)
 {
     TLLM_CHECK_WITH_INFO(!mDecodingMode.isBeamSearch(), "Beam search mode has been requested from Sampling Layer");
-    TLLM_CHECK_WITH_INFO(mDecodingMode.isTopKorTopP(), "Requested mode is neither TopK nor TopP");
+    TLLM_CHECK_WITH_INFO(mDecodingMode.isSampling(), "Requested mode is none of TopK, TopP, MinP or TypicalP");
     if (mDecodingMode.isTopK())
     {
         mTopKDecode
@@ -106,6 +122,18 @@ SamplingLayer<T>::SamplingLayer(DecodingMode const& mode, size_t maxBatchSize, s
             maxBatchSize, vocabSize, vocabSizePadded, mStream, mAllocator, prop, /* deterministic */ true);
     }
 
+    if (mDecodingMode.isMinP())
+    {
+        mMinPDecode
+            = std::make_unique<MinPSamplingLayer<T>>(maxBatchSize, vocabSize, vocabSizePadded, mStream, mAllocator);
+    }
+
+    if (mDecodingMode.isTypicalP())
+    {
+        mTypicalPDecode
+            = std::make_unique<TypicalPSamplingLayer<T>>(maxBatchSize, vocabSize, vocabSizePadded, mStream, mAllocator);
+    }
+
     allocateBuffer(maxBatchSize);
 }
 
@@ -149,6 +177,14 @@ void SamplingLayer<T>::setup(const size_t batchSize, int32_t const* batchSlots,
     {
         mTopPDecode->setup(batchSize, batchSlots, setupParams);
     }
+    if (mDecodingMode.isMinP())
+    {
+        mMinPDecode->setup(batchSize, batchSlots, setupParams);
+    }
+    if (mDecodingMode.isTypicalP())
+    {
+        mTypicalPDecode->setup(batchSize, batchSlots, setupParams);
+    }
 }
 
 template <typename T>
@@ -184,8 +220,16 @@ void SamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams& inp
         skipTopP = allOfBatchSlots(batchSlotsHost, mTopPDecode->getSkipDecodeHost(), batchSize, true);
     }
 
-    // Compute probabilities either for TopP or if cumLogProbs or outputLogProbs are specified
-    bool const skipSoftMax = skipTopP && cumLogProbs == nullptr && outputLogProbs == nullptr;
+    // MinP and TypicalP always sample all requests of the batch
+    bool const skipMinP = !mDecodingMode.isMinP();
+    bool const skipTypicalP = !mDecodingMode.isTypicalP();
+
+    // Greedy requests get their log probs from the log-sum-exp of the argmax pass
+    bool const greedyOnly = skipTopK || mTopKDecode->isGreedyOnly(batchSlotsHost, batchSize);
+
+    // Compute probabilities either for TopP, MinP, TypicalP or if cumLogProbs or outputLogProbs are specified
+    bool const skipSoftMax = skipTopP && skipMinP && skipTypicalP
+        && ((cumLogProbs == nullptr && outputLogProbs == nullptr) || greedyOnly);
 
     inputs.curand_states = mCurandStatesDevice;
     inputs.sampling_workspace = mSamplingWorkspaceDevice;
@@ -205,6 +249,16 @@ void SamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams& inp
         mTopPDecode->forward(outputs, inputs);
     }
 
+    if (!skipMinP)
+    {
+        mMinPDecode->forward(outputs, inputs);
+    }
+
+    if (!skipTypicalP)
+    {
+        mTypicalPDecode->forward(outputs, inputs);
+    }
+
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -22,8 +22,10 @@
 #include "tensorrt_llm/common/tensor.h"
 #include "tensorrt_llm/layers/baseSamplingLayer.h"
 #include "tensorrt_llm/layers/decodingParams.h"
+#include "tensorrt_llm/layers/minPSamplingLayer.h"
 #include "tensorrt_llm/layers/topKSamplingLayer.h"
 #include "tensorrt_llm/layers/topPSamplingLayer.h"
+#include "tensorrt_llm/layers/typicalPSamplingLayer.h"
 #include "tensorrt_llm/runtime/decodingMode.h"
 
 namespace tc = tensorrt_llm::common;
@@ -40,7 +42,8 @@ inline bool allOfBatchSlots(int32_t const* batchSlotsHost, T const* data, size_t
 };
 
 //! \brief Top class for sampling layers.
-//! It sets up and executes TopKSamplingLayer and TopPSamplingLayer samplings
+//! It sets up and executes TopKSamplingLayer and TopPSamplingLayer samplings,
+//! or MinPSamplingLayer or TypicalPSamplingLayer sampling
 template <typename T>
 class SamplingLayer : public BaseSamplingLayer<T>
 {
@@ -71,7 +74,7 @@ private:
     runtime::DecodingMode mDecodingMode;
 
     void* mSamplingWorkspaceDevice = nullptr;
-    curandState_t* mCurandStatesDevice = nullptr;
+    kernels::PhiloxState* mCurandStatesDevice = nullptr;
     uint64_t* mRandomSeedsDevice = nullptr;
 
     bool* mSkipDecodeDevice = nullptr;
@@ -81,6 +84,8 @@ private:
 
     std::unique_ptr<TopKSamplingLayer<T>> mTopKDecode;
     std::unique_ptr<TopPSamplingLayer<T>> mTopPDecode;
+    std::unique_ptr<MinPSamplingLayer<T>> mMinPDecode;
+    std::unique_ptr<TypicalPSamplingLayer<T>> mTypicalPDecode;
 
 private:
     void allocateBuffer(size_t batchSize);
@@ -37,7 +37,7 @@ namespace layers
 
 template <uint32_t TOP_K_MAX>
 __global__ void setupTopKRuntimeArgs(int batchSize, uint32_t topK, uint32_t* topKs, int topKsSize, float topP,
-    float* topPs, int topPsSize, bool* skipDecode, const int* batchSlots)
+    float* topPs, int topPsSize, bool* skipDecode, bool* skipSampling, const int* batchSlots)
 {
     int index = blockIdx.x * blockDim.x + threadIdx.x;
     for (int bi = index; bi < batchSize; bi += gridDim.x * blockDim.x)
@@ -66,6 +66,8 @@ __global__ void setupTopKRuntimeArgs(int batchSize, uint32_t topK, uint32_t* top
         // Clip p value if it is out of range. range = [0.0, 1.0].
         topPs[batchSlot] = p;
         skipDecode[batchSlot] = k == 0;
+        // Greedy requests are decoded by invokeBatchGreedySearch
+        skipSampling[batchSlot] = k <= 1;
     }
 }
 
@@ -77,18 +79,21 @@ void TopKSamplingLayer<T>::allocateBuffer(size_t const batchSize)
         nullptr, nullptr, TOP_K_MAX, 1.0f, mVocabSizePadded, nullptr, nullptr, mStream, batchSize, mMaxBatchSize,
         nullptr, mNormalizeLogProbs, false);
 
-    std::array<size_t, 4> deviceBufferSizes;
+    std::array<size_t, 5> deviceBufferSizes;
     deviceBufferSizes[0] = sizeof(uint32_t) * batchSize;
     deviceBufferSizes[1] = sizeof(float) * batchSize;
     deviceBufferSizes[2] = sizeof(bool) * batchSize;
     deviceBufferSizes[3] = std::max(deviceBufferSizes[0], deviceBufferSizes[1]);
+    deviceBufferSizes[4] = sizeof(bool) * batchSize;
 
     mRuntimeTopKDevice = mAllocator->reMalloc(mRuntimeTopKDevice, deviceBufferSizes[0], false);
     mRuntimeTopPDevice = mAllocator->reMalloc(mRuntimeTopPDevice, deviceBufferSizes[1], false);
     mSkipDecodeDevice = mAllocator->reMalloc(mSkipDecodeDevice, deviceBufferSizes[2], false);
     mSetupWorkspaceDevice = mAllocator->reMalloc(mSetupWorkspaceDevice, deviceBufferSizes[3], false);
+    mSkipSamplingDevice = mAllocator->reMalloc(mSkipSamplingDevice, deviceBufferSizes[4], false);
 
     mSkipDecodeHost = (bool*) std::realloc(mSkipDecodeHost, sizeof(bool) * batchSize);
+    mRuntimeTopKHost.assign(batchSize, 0);
 
     mAllocatedSize = std::accumulate(deviceBufferSizes.begin(), deviceBufferSizes.end(), 0);
     TLLM_LOG_DEBUG("topKSamplingLayer allocated %lu bytes on GPU", mAllocatedSize);
@@ -102,6 +107,7 @@ void TopKSamplingLayer<T>::freeBuffer()
     mAllocator->free((void**) (&mRuntimeTopPDevice));
     mAllocator->free((void**) (&mSkipDecodeDevice));
     mAllocator->free((void**) (&mSetupWorkspaceDevice));
+    mAllocator->free((void**) (&mSkipSamplingDevice));
     std::free(mSkipDecodeHost);
 }
 
@@ -161,11 +167,12 @@ void TopKSamplingLayer<T>::setup(size_t const batchSize, int32_t const* batchSlo
         dim3 grid(divUp((int) batchSize, (int) block.x));
         // support topK up to TOP_K_MAX.
         setupTopKRuntimeArgs<TOP_K_MAX><<<grid, block, 0, mStream>>>(batchSize, topK, mRuntimeTopKDevice,
-            runtimeTopKSize, topP, mRuntimeTopPDevice, runtimeTopPSize, mSkipDecodeDevice, batchSlots);
+            runtimeTopKSize, topP, mRuntimeTopPDevice, runtimeTopPSize, mSkipDecodeDevice, mSkipSamplingDevice,
+            batchSlots);
     }
 
     cudaAutoCpy(mSkipDecodeHost, mSkipDecodeDevice, mMaxBatchSize, mStream);
-    std::vector<uint32_t> runtimeTopKs(mMaxBatchSize);
+    auto& runtimeTopKs = mRuntimeTopKHost;
     cudaAutoCpy(runtimeTopKs.data(), mRuntimeTopKDevice, mMaxBatchSize, mStream);
     {
         uint32_t maxTopK = 0;
@@ -210,12 +217,33 @@ void TopKSamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams&
     float* outputLogProbs = (outputs.output_log_probs) ? outputs.output_log_probs->template getPtr<float>() : nullptr;
     int* sequenceLength = (outputs.sequence_length) ? outputs.sequence_length->template getPtr<int>() : nullptr;
 
-    invokeBatchTopKSampling(samplingWorkspaceDevice, mSamplingWorkspaceSize, logits,
-        outputs.output_ids_ptr.template getPtr<int*>(), sequenceLength, finishedInput, finishedOutput, cumLogProbs,
-        outputLogProbs, curandStatesDevice, (int) mRuntimeMaxTopK, (int*) (mRuntimeTopKDevice), 1.0f,
-        mRuntimeTopPDevice, mVocabSizePadded, endIds, batchSlots, mStream, batchSize, mMaxBatchSize, mSkipDecodeDevice,
-        mNormalizeLogProbs, probsComputed);
-    sync_check_cuda_error();
+    // Batch slots are in pinned memory, see SamplingLayer
+    bool hasGreedy = false;
+    bool hasSampled = false;
+    for (size_t bi = 0; bi < batchSize; ++bi)
+    {
+        auto const topK = mRuntimeTopKHost[batchSlots != nullptr ? batchSlots[bi] : bi];
+        hasGreedy |= topK == 1;
+        hasSampled |= topK > 1;
+    }
+
+    if (hasGreedy)
+    {
+        invokeBatchGreedySearch(logits, outputs.output_ids_ptr.template getPtr<int*>(), sequenceLength, finishedInput,
+            finishedOutput, cumLogProbs, outputLogProbs, (int*) (mRuntimeTopKDevice), mVocabSizePadded, endIds,
+            batchSlots, mStream, batchSize, mMaxBatchSize, mSkipDecodeDevice, mNormalizeLogProbs, probsComputed);
+        sync_check_cuda_error();
+    }
+
+    if (hasSampled)
+    {
+        invokeBatchTopKSampling(samplingWorkspaceDevice, mSamplingWorkspaceSize, logits,
+            outputs.output_ids_ptr.template getPtr<int*>(), sequenceLength, finishedInput, finishedOutput, cumLogProbs,
+            outputLogProbs, curandStatesDevice, (int) mRuntimeMaxTopK, (int*) (mRuntimeTopKDevice), 1.0f,
+            mRuntimeTopPDevice, mVocabSizePadded, endIds, batchSlots, mStream, batchSize, mMaxBatchSize,
+            mSkipSamplingDevice, mNormalizeLogProbs, probsComputed);
+        sync_check_cuda_error();
+    }
 }
 
 template <typename T>
@@ -22,6 +22,9 @@
 #include "tensorrt_llm/kernels/decodingCommon.h"
 #include "tensorrt_llm/layers/baseSamplingLayer.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace tensorrt_llm
 {
 namespace layers
@@ -30,6 +33,7 @@ namespace layers
 //! \brief Layer to randomly sample tokens from TopK logits.
 //! When both TopK and TopP are specified, layer jointly samples using TopK and TopP.
 //! When no TopK param is specified, sampling is skipped for particular request.
+//! Requests with K=1 take a fused argmax instead of the sampling kernels, see invokeBatchGreedySearch.
 template <typename T>
 class TopKSamplingLayer : public BaseSamplingLayer<T>
 {
@@ -50,6 +54,14 @@ public:
         return mSkipDecodeHost;
     }
 
+    //! \brief True if all requests of the batch decoded by this layer are greedy, i.e. have K=1.
+    //! The greedy path computes its log probs from logits, so the softmax is not needed for them.
+    bool isGreedyOnly(int32_t const* batchSlotsHost, size_t batchSize) const
+    {
+        return std::all_of(batchSlotsHost, batchSlotsHost + batchSize,
+            [this](int32_t slot) { return mRuntimeTopKHost[slot] <= 1; });
+    }
+
 protected:
     bool mNormalizeLogProbs = true;
     uint32_t mRuntimeMaxTopK = 0;
@@ -57,7 +69,10 @@ protected:
     float* mRuntimeTopPDevice = nullptr;
     void* mSetupWorkspaceDevice = nullptr;
     bool* mSkipDecodeDevice = nullptr;
+    // Skips the greedy requests in addition to mSkipDecodeDevice, for the sampling kernels
+    bool* mSkipSamplingDevice = nullptr;
     bool* mSkipDecodeHost = nullptr;
+    std::vector<uint32_t> mRuntimeTopKHost;
 
     using Base::mMaxBatchSize;
     using Base::mVocabSize;
@@ -19,6 +19,7 @@
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/samplingRejectionKernels.h"
 #include "tensorrt_llm/kernels/samplingTopKKernels.h"
 #include "tensorrt_llm/kernels/samplingTopPKernels.h"
 #include "tensorrt_llm/layers/topPSamplingLayer.h"
@@ -293,7 +294,11 @@ void TopPSamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams&
     TLLM_CHECK_WITH_INFO(curandStatesDevice, "No curand states provided");
     TLLM_CHECK_WITH_INFO(samplingWorkspaceDevice, "No sampling workspace provided");
 
-    if (mIsDeterministic)
+    // Sorting (or radix selecting) the vocabulary dominates for large vocabularies, sample without sorting then
+    bool const useRejectionSampling = mCudaDeviceProp != nullptr
+        && preferRejectionSampling(batchSize, mVocabSizePadded, mCudaDeviceProp->multiProcessorCount);
+
+    if (mIsDeterministic && !useRejectionSampling)
     {
         invokeTopPInitialize(
             mTopPIdValsDevice, mTopPOffsetDevice, mBeginTopPOffsetDevice, batchSize, mVocabSizePadded, mStream);
@@ -311,7 +316,15 @@ void TopPSamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams&
     float* outputLogProbs = (outputs.output_log_probs) ? outputs.output_log_probs->template getPtr<float>() : nullptr;
     int* sequenceLength = (outputs.sequence_length) ? outputs.sequence_length->template getPtr<int>() : nullptr;
 
-    if (mIsDeterministic)
+    if (useRejectionSampling)
+    {
+        invokeBatchRejectionTopKTopPSampling<T>(outputs.output_ids_ptr.template getPtr<int*>(), sequenceLength,
+            finishedInput, finishedOutput, cumLogProbs, outputLogProbs, probs, curandStatesDevice, batchSize,
+            mMaxBatchSize, mVocabSizePadded, endIds, /* maxTopK */ 0, /* topKs */ nullptr, mRuntimeMaxTopP,
+            mRuntimeTopPDevice, mStream, mSkipDecodeDevice, batchSlots);
+        sync_check_cuda_error();
+    }
+    else if (mIsDeterministic)
     {
         invokeBatchTopPSampling<T>(samplingWorkspaceDevice, mSamplingWorkspaceSize, mCubTempStorageSize,
             outputs.output_ids_ptr.template getPtr<int*>(), sequenceLength, finishedInput, finishedOutput, cumLogProbs,
@@ -319,10 +332,6 @@ void TopPSamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams&
             batchSize, mMaxBatchSize, mVocabSizePadded, endIds, mRuntimeMaxTopP, mRuntimeTopPDevice, mStream,
             mSkipDecodeDevice, batchSlots);
         sync_check_cuda_error();
-        invokeComputeToppDecay(mRuntimeTopPDevice, mInitialTopPDevice,
-            outputs.output_ids_ptr.template getPtr<const int*>(), mTopPDecayDevice, mTopPMinDevice, mTopPResetIdsDevice,
-            sequenceLength, batchSlots, batchSize, mStream);
-        sync_check_cuda_error();
     }
     else
     {
@@ -332,6 +341,14 @@ void TopPSamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams&
             mRuntimeMaxTopP, mRuntimeTopPDevice, mStream, mAirTopPBlockNum, mSkipDecodeDevice, batchSlots);
         sync_check_cuda_error();
     }
+
+    if (mIsDeterministic)
+    {
+        invokeComputeToppDecay(mRuntimeTopPDevice, mInitialTopPDevice,
+            outputs.output_ids_ptr.template getPtr<const int*>(), mTopPDecayDevice, mTopPMinDevice, mTopPResetIdsDevice,
+            sequenceLength, batchSlots, batchSize, mStream);
+        sync_check_cuda_error();
+    }
 }
 
 template <typename T>
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/samplingTypicalPKernels.h"
+#include "tensorrt_llm/layers/fillBuffers.h"
+#include "tensorrt_llm/layers/typicalPSamplingLayer.h"
+
+#include <algorithm>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::kernels;
+
+namespace tensorrt_llm
+{
+namespace layers
+{
+
+template <typename T>
+void TypicalPSamplingLayer<T>::allocateBuffer(size_t batchSize)
+{
+    TLLM_LOG_TRACE(__PRETTY_FUNCTION__);
+
+    // The sampling kernel works on one block per request without global workspace
+    mSamplingWorkspaceSize = 0;
+
+    mAllocatedSize = sizeof(float) * batchSize;
+    mRuntimeTypicalPDevice = mAllocator->reMalloc(mRuntimeTypicalPDevice, mAllocatedSize, false);
+    mRuntimeTypicalPHost.resize(batchSize);
+
+    TLLM_LOG_DEBUG("typicalPSamplingLayer allocated %lu bytes on GPU", mAllocatedSize);
+}
+
+template <typename T>
+void TypicalPSamplingLayer<T>::freeBuffer()
+{
+    TLLM_LOG_TRACE(__PRETTY_FUNCTION__);
+    mAllocator->free((void**) (&mRuntimeTypicalPDevice));
+}
+
+template <typename T>
+void TypicalPSamplingLayer<T>::setup(size_t const batchSize, int32_t const* batchSlots, SetupParams const& setupParams)
+{
+    TLLM_LOG_TRACE(__PRETTY_FUNCTION__);
+
+    // Requests without typicalP are sampled with the default of 1.f, i.e. from the full distribution
+    auto runtimeTypicalP = setupParams.runtime_typical_p;
+    if (runtimeTypicalP)
+    {
+        for (auto& typicalP : runtimeTypicalP.value())
+        {
+            if (typicalP < 0.f || typicalP > 1.0f)
+            {
+                TLLM_LOG_WARNING("TypicalP (%f) is out of range ([0.0, 1.0f]). Clip to closest number.", typicalP);
+                typicalP = std::clamp(typicalP, 0.f, 1.f);
+            }
+        }
+    }
+
+    FillBuffers const fillBuffers{batchSize, mMaxBatchSize, mStream};
+    fillBuffers(runtimeTypicalP, 1.f, mRuntimeTypicalPHost, mRuntimeTypicalPDevice, batchSlots);
+}
+
+template <typename T>
+void TypicalPSamplingLayer<T>::forward(DecodingOutputParams& outputs, ForwardParams& inputs)
+{
+    TLLM_LOG_TRACE(__PRETTY_FUNCTION__);
+
+    auto const batchSize = inputs.logits.shape[0];
+
+    // Probabilities must be already computed instead of logits
+    TLLM_CHECK_WITH_INFO(inputs.probs_computed, "TypicalPSamplingLayer expects probabilities in the logits tensor");
+    auto probs = inputs.logits.template getPtr<T>();
+    auto endIds = inputs.end_ids.template getPtr<int const>();
+    auto batchSlots = inputs.batch_slots ? inputs.batch_slots->template getPtr<int const>() : nullptr;
+    auto curandStatesDevice = inputs.curand_states;
+
+    TLLM_CHECK_WITH_INFO(curandStatesDevice, "No curand states provided");
+
+    FinishedState* finishedInput = (inputs.finished)
+        ? reinterpret_cast<FinishedState*>(inputs.finished->template getPtr<FinishedState::UnderlyingType>())
+        : nullptr;
+    FinishedState* finishedOutput = (outputs.finished)
+        ? reinterpret_cast<FinishedState*>(outputs.finished->template getPtr<FinishedState::UnderlyingType>())
+        : nullptr;
+
+    float* cumLogProbs = (outputs.cum_log_probs) ? outputs.cum_log_probs->template getPtr<float>() : nullptr;
+    float* outputLogProbs = (outputs.output_log_probs) ? outputs.output_log_probs->template getPtr<float>() : nullptr;
+    int* sequenceLength = (outputs.sequence_length) ? outputs.sequence_length->template getPtr<int>() : nullptr;
+    TLLM_CHECK_WITH_INFO(sequenceLength, "No sequence lengths provided");
+
+    invokeBatchTypicalPSampling<T>(outputs.output_ids_ptr.template getPtr<int*>(), sequenceLength, finishedInput,
+        finishedOutput, cumLogProbs, outputLogProbs, probs, curandStatesDevice, batchSize, mMaxBatchSize,
+        mVocabSizePadded, endIds, mRuntimeTypicalPDevice, mStream, /* skipDecode */ nullptr, batchSlots);
+    sync_check_cuda_error();
+}
+
+template <typename T>
+TypicalPSamplingLayer<T>::TypicalPSamplingLayer(std::size_t maxBatchSize, std::size_t vocabSize,
+    std::size_t vocabSizePadded, cudaStream_t stream, std::shared_ptr<IAllocator> allocator)
+    : BaseSamplingLayer<T>(maxBatchSize, vocabSize, vocabSizePadded, stream, std::move(allocator), nullptr)
+{
+    allocateBuffer(mMaxBatchSize);
+}
+
+template <typename T>
+TypicalPSamplingLayer<T>::~TypicalPSamplingLayer()
+{
+    TLLM_LOG_TRACE(__PRETTY_FUNCTION__);
+    freeBuffer();
+}
+
+template class TypicalPSamplingLayer<float>;
+template class TypicalPSamplingLayer<half>;
+
+} // namespace layers
+} // namespace tensorrt_llm
@@ -20,6 +20,7 @@
 #include "tensorrt_llm/runtime/tllmLogger.h"
 
 #include "tensorrt_llm/plugins/bertAttentionPlugin/bertAttentionPlugin.h"
+#include "tensorrt_llm/plugins/fp8RowwiseGemmPlugin/fp8RowwiseGemmPlugin.h"
 #include "tensorrt_llm/plugins/gemmPlugin/gemmPlugin.h"
 #include "tensorrt_llm/plugins/gptAttentionPlugin/gptAttentionPlugin.h"
 #include "tensorrt_llm/plugins/identityPlugin/identityPlugin.h"
@@ -39,6 +40,7 @@
 #include "tensorrt_llm/plugins/rmsnormQuantizationPlugin/rmsnormQuantizationPlugin.h"
 #include "tensorrt_llm/plugins/selectiveScanPlugin/selectiveScanPlugin.h"
 #include "tensorrt_llm/plugins/smoothQuantGemmPlugin/smoothQuantGemmPlugin.h"
+#include "tensorrt_llm/plugins/sparseGemmPlugin/sparseGemmPlugin.h"
 #include "tensorrt_llm/plugins/weightOnlyGroupwiseQuantMatmulPlugin/weightOnlyGroupwiseQuantMatmulPlugin.h"
 #include "tensorrt_llm/plugins/weightOnlyQuantMatmulPlugin/weightOnlyQuantMatmulPlugin.h"
 
@@ -145,6 +147,8 @@ extern "C"
         static tensorrt_llm::plugins::ReduceScatterPluginCreator reduceScatterPluginCreator;
 #endif // ENABLE_MULTI_DEVICE
         static tensorrt_llm::plugins::SmoothQuantGemmPluginCreator smoothQuantGemmPluginCreator;
+        static tensorrt_llm::plugins::Fp8RowwiseGemmPluginCreator fp8RowwiseGemmPluginCreator;
+        static tensorrt_llm::plugins::SparseGemmPluginCreator sparseGemmPluginCreator;
         static tensorrt_llm::plugins::LayernormQuantizationPluginCreator layernormQuantizationPluginCreator;
         static tensorrt_llm::plugins::QuantizePerTokenPluginCreator quantizePerTokenPluginCreator;
         static tensorrt_llm::plugins::QuantizeTensorPluginCreator quantizeTensorPluginCreator;
@@ -170,6 +174,8 @@ extern "C"
                   creatorPtr(reduceScatterPluginCreator),
 #endif // ENABLE_MULTI_DEVICE
                   creatorPtr(smoothQuantGemmPluginCreator),
+                  creatorPtr(fp8RowwiseGemmPluginCreator),
+                  creatorPtr(sparseGemmPluginCreator),
                   creatorPtr(layernormQuantizationPluginCreator),
                   creatorPtr(quantizePerTokenPluginCreator),
                   creatorPtr(quantizeTensorPluginCreator),
@@ -17,6 +17,7 @@
 #include "bertAttentionPlugin.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
 #include "tensorrt_llm/kernels/gptKernels.h"
+#include "tensorrt_llm/kernels/relativeAttentionKernels.h"
 #include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 
@@ -50,7 +51,18 @@ BertAttentionPlugin::BertAttentionPlugin(int num_heads, int head_size, float q_s
     if (mEnableContextFMHA)
     {
         mEnableContextFMHA = false;
-        if (!(mType == DataType::kHALF || mType == DataType::kBF16))
+        if (mRelativeAttention)
+        {
+            // The FMHA kernels cannot add the bias, the implicit bias (max_distance > 0) has its own fused kernel.
+            mFusedRelativeAttention = mMaxDistance > 0 && isRelativeAttentionSupported(mHeadSize);
+            if (!mFusedRelativeAttention)
+            {
+                TLLM_LOG_WARNING("Fall back to unfused MHA because of explicit relative position embedding or "
+                                 "unsupported head size %d.",
+                    mHeadSize);
+            }
+        }
+        else if (!(mType == DataType::kHALF || mType == DataType::kBF16))
         {
             TLLM_LOG_WARNING("Fall back to unfused MHA because of unsupported data type.");
         }
@@ -59,10 +71,6 @@ BertAttentionPlugin::BertAttentionPlugin(int num_heads, int head_size, float q_s
             TLLM_LOG_WARNING(
                 "Fall back to unfused MHA because of unsupported head size %d in sm_{%d}.", mHeadSize, mSM);
         }
-        else if (mRelativeAttention)
-        {
-            TLLM_LOG_WARNING("Fall back to unfused MHA because of relative position embedding.");
-        }
         else
         {
             mEnableContextFMHA = true;
@@ -84,6 +92,7 @@ BertAttentionPlugin::BertAttentionPlugin(const void* data, size_t length)
     read(d, mRelativeAttention);
     read(d, mMaxDistance);
     read(d, mRemovePadding);
+    read(d, mFusedRelativeAttention);
     TLLM_CHECK_WITH_INFO(d == a + length,
         "Expected length (%d) != real length (%d). This is often "
         "caused by using different TensorRT-LLM version to build "
@@ -158,16 +167,18 @@ size_t BertAttentionPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* i
     const int local_hidden_units_ = inputs[0].dims.d[mRemovePadding ? 1 : 2] / 3;
 
     auto const size = tensorrt_llm::runtime::BufferDataType(inputs[0].type).getSize();
+    // the fused kernels need none of the [batch_size, num_heads, seq_len, seq_len] buffers of the unfused MHA
+    const bool fused_mha = mEnableContextFMHA || mFusedRelativeAttention;
 
-    const size_t attention_mask_size = mEnableContextFMHA ? 0 : size * batch_size * input_seq_len * input_seq_len;
+    const size_t attention_mask_size = fused_mha ? 0 : size * batch_size * input_seq_len * input_seq_len;
     const size_t cu_seqlens_size = sizeof(int) * (batch_size + 1);
-    const size_t q_buf_2_size = mEnableContextFMHA ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
-    const size_t k_buf_2_size = mEnableContextFMHA ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
-    const size_t v_buf_2_size = mEnableContextFMHA ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
-    const size_t qk_buf_size = mEnableContextFMHA ? 0 : size * batch_size * mNumHeads * input_seq_len * input_seq_len;
-    const size_t qkv_buf_2_size = mEnableContextFMHA ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
+    const size_t q_buf_2_size = fused_mha ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
+    const size_t k_buf_2_size = fused_mha ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
+    const size_t v_buf_2_size = fused_mha ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
+    const size_t qk_buf_size = fused_mha ? 0 : size * batch_size * mNumHeads * input_seq_len * input_seq_len;
+    const size_t qkv_buf_2_size = fused_mha ? 0 : size * batch_size * input_seq_len * local_hidden_units_;
     const size_t qk_buf_float_size
-        = mEnableContextFMHA ? 0 : sizeof(float) * batch_size * mNumHeads * input_seq_len * input_seq_len;
+        = fused_mha ? 0 : sizeof(float) * batch_size * mNumHeads * input_seq_len * input_seq_len;
     const size_t padding_offset_size = sizeof(int) * batch_size * input_seq_len;
 
     const int NUM_BUFFERS = 10;
@@ -235,16 +246,16 @@ int BertAttentionPlugin::enqueueImpl(const nvinfer1::PluginTensorDesc* inputDesc
     }
 #endif
 
-    const size_t attention_mask_size = mEnableContextFMHA ? 0 : sizeof(T) * batch_size * input_seq_len * input_seq_len;
+    const bool fused_mha = mEnableContextFMHA || mFusedRelativeAttention;
+    const size_t attention_mask_size = fused_mha ? 0 : sizeof(T) * batch_size * input_seq_len * input_seq_len;
     const size_t cu_seqlens_size = sizeof(int) * (batch_size + 1);
-    const size_t q_buf_2_size = mEnableContextFMHA ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
-    const size_t k_buf_2_size = mEnableContextFMHA ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
-    const size_t v_buf_2_size = mEnableContextFMHA ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
-    const size_t qk_buf_size
-        = mEnableContextFMHA ? 0 : sizeof(T) * batch_size * mNumHeads * input_seq_len * input_seq_len;
-    const size_t qkv_buf_2_size = mEnableContextFMHA ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
+    const size_t q_buf_2_size = fused_mha ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
+    const size_t k_buf_2_size = fused_mha ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
+    const size_t v_buf_2_size = fused_mha ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
+    const size_t qk_buf_size = fused_mha ? 0 : sizeof(T) * batch_size * mNumHeads * input_seq_len * input_seq_len;
+    const size_t qkv_buf_2_size = fused_mha ? 0 : sizeof(T) * batch_size * input_seq_len * local_hidden_units_;
     const size_t qk_buf_float_size
-        = mEnableContextFMHA ? 0 : sizeof(float) * batch_size * mNumHeads * input_seq_len * input_seq_len;
+        = fused_mha ? 0 : sizeof(float) * batch_size * mNumHeads * input_seq_len * input_seq_len;
     const size_t padding_offset_size = sizeof(int) * batch_size * input_seq_len;
 
     // Workspace pointer shift
@@ -298,6 +309,25 @@ int BertAttentionPlugin::enqueueImpl(const nvinfer1::PluginTensorDesc* inputDesc
         mFMHARunner->setup(request_batch_size, request_seq_len, request_seq_len, request_batch_size * request_seq_len);
         mFMHARunner->run(const_cast<T*>(attention_input), cu_seqlens, context_buf_, stream);
     }
+    else if (mFusedRelativeAttention)
+    {
+        // softmax(scale * QK + bias) * V with the bias computed from the relative attention table on the fly
+        RelativeAttentionParams relativeParams{};
+        relativeParams.qkv = attention_input;
+        relativeParams.output = context_buf_;
+        relativeParams.relativeAttentionBias = relative_attn_table;
+        relativeParams.seqOffsets = mRemovePadding ? cu_seqlens : nullptr;
+        relativeParams.seqLengths = input_lengths;
+        relativeParams.batchSize = request_batch_size;
+        relativeParams.maxSeqLength = request_seq_len;
+        relativeParams.numHeads = mNumHeads;
+        relativeParams.headSize = mHeadSize;
+        relativeParams.numBuckets = inputDesc[3].dims.d[1];
+        relativeParams.maxDistance = mMaxDistance;
+        relativeParams.qkScale = qk_scale;
+        relativeParams.bidirectional = true;
+        invokeRelativeAttention<T>(relativeParams, stream);
+    }
     else
     {
         // only non-FMHA path needs to split Q,K,V from QKV
@@ -500,7 +530,7 @@ size_t BertAttentionPlugin::getSerializationSize() const noexcept
 {
     return sizeof(mNumHeads) + sizeof(mHeadSize) + sizeof(mQScaling) + sizeof(mQKHalfAccum) + sizeof(mEnableContextFMHA)
         + sizeof(mFMHAForceFP32Acc) + sizeof(mType) + sizeof(mRelativeAttention) + sizeof(mMaxDistance)
-        + sizeof(mRemovePadding);
+        + sizeof(mRemovePadding) + sizeof(mFusedRelativeAttention);
 }
 
 void BertAttentionPlugin::serialize(void* buffer) const noexcept
@@ -516,6 +546,7 @@ void BertAttentionPlugin::serialize(void* buffer) const noexcept
     write(d, mRelativeAttention);
     write(d, mMaxDistance);
     write(d, mRemovePadding);
+    write(d, mFusedRelativeAttention);
     assert(d == a + getSerializationSize());
 }
 
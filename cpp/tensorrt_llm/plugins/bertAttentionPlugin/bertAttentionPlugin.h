@@ -90,6 +90,8 @@ private:
     // fmha runner (disable by default)
     bool mEnableContextFMHA = false;
     bool mFMHAForceFP32Acc = false;
+    // fused kernel for the implicit relative attention bias, used instead of fmha
+    bool mFusedRelativeAttention = false;
     int mSM = tensorrt_llm::common::getSMVersion();
 
     // The default copy constructor will leave them as nullptr. clone() shall initialize it.
@@ -17,10 +17,22 @@
 
 #include "tensorrt_llm/plugins/common/gemmPluginProfiler.h"
 #include "tensorrt_llm/common/cublasMMWrapper.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/fpA_intB_gemm/fpA_intB_gemm.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/int8_gemm/int8_gemm.h"
 #include "tensorrt_llm/plugins/mixtureOfExperts/mixtureOfExpertsPlugin.h"
 
+#include "cutlass/version.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <typeinfo>
+
+namespace fs = std::filesystem;
+
 namespace tensorrt_llm::plugins
 {
 
@@ -38,6 +50,7 @@ GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::GemmPluginPro
             "SKIP_GEMM_PLUGIN_PROFILINGS is set. Skipping GEMM plugin profilings. It could result in runtime error "
             "if default tactic is not defined.");
     }
+    mTacticCacheDir = tensorrt_llm::common::getEnvGemmTacticCacheDir();
 }
 
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
@@ -123,29 +136,47 @@ void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::profileT
 
     auto mProfileMap = mMNKProfileMap->getMProfileMap(gemmId);
 
-    auto profileTactics = [&mProfileMap, this](int m, int n, int k)
+    if (!mTacticCacheDir.empty())
+    {
+        loadTacticCache(gemmId, *mProfileMap);
+    }
+
+    std::vector<int> missingMs;
+    const int startMinMRounded = nextPowerOfTwo(dims.minM);
+    for (int m = startMinMRounded; m < maxM; m *= 2)
     {
         if (mProfileMap->count(m) == 0)
         {
-            initTmpData(m, n, k, mWorkspaceTmp, mTmpWorkspaceSizeInBytes, cudaStreamDefault);
-            const auto tactics = this->getTactics(m, n, k);
-            // Profile different tactics for particular m and insert best config to the map
-            mProfileMap->insert({m, this->profileTacticsForProblem(m, n, k, tactics)});
+            missingMs.push_back(m);
         }
-    };
+    }
+    if (mProfileMap->count(maxM) == 0)
+    {
+        missingMs.push_back(maxM);
+    }
+    if (missingMs.empty())
+    {
+        return;
+    }
 
     // Allocate tmp data to run GEMMs
     allocateTmpData();
 
-    const int startMinMRounded = nextPowerOfTwo(dims.minM);
-    for (int m = startMinMRounded; m < maxM; m *= 2)
+    for (const int m : missingMs)
     {
-        profileTactics(m, dims.n, dims.k);
+        initTmpData(m, dims.n, dims.k, mWorkspaceTmp, mTmpWorkspaceSizeInBytes, cudaStreamDefault);
+        const auto tactics = this->getTactics(m, dims.n, dims.k);
+        // Profile different tactics for particular m and insert best config to the map
+        mProfileMap->insert({m, this->profileTacticsForProblem(m, dims.n, dims.k, tactics)});
     }
 
-    profileTactics(maxM, dims.n, dims.k);
     // Free tmp data
     freeTmpData();
+
+    if (!mTacticCacheDir.empty())
+    {
+        storeTacticCache(gemmId, *mProfileMap);
+    }
 }
 
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
@@ -234,6 +265,113 @@ std::optional<Config> GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHa
     return {bestConfig};
 }
 
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+std::string GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::getTacticCacheKey(
+    const GemmIdType& gemmId) const
+{
+    int cudaRuntimeVersion = 0;
+    cudaRuntimeGetVersion(&cudaRuntimeVersion);
+    std::ostringstream key;
+    // The profiler type tells apart the plugins sharing an ID type, e.g. the int8 and the weight-only GEMMs.
+    key << typeid(*this).name() << " " << gemmId << " sm=" << tensorrt_llm::common::getSMVersion()
+        << " cuda=" << cudaRuntimeVersion << " cublasLt=" << cublasLtGetVersion() << " cutlass=" << CUTLASS_MAJOR
+        << "." << CUTLASS_MINOR << "." << CUTLASS_PATCH << " config=" << sizeof(Config);
+    return key.str();
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::loadTacticCache(
+    const GemmIdType& gemmId, MProfileMap& profileMap) const
+{
+    const auto key = getTacticCacheKey(gemmId);
+    const auto path = fs::path(mTacticCacheDir) / (std::to_string(std::hash<std::string>{}(key)) + ".bin");
+    std::ifstream file(path, std::ios::binary);
+    if (!file.good())
+    {
+        return;
+    }
+    const std::string data(std::istreambuf_iterator<char>(file), {});
+
+    // Layout: key size, key, number of tactics, (M, best config) pairs as in the engine.
+    using ProfileType = std::pair<int, std::optional<Config>>;
+    const char* ptr = data.data();
+    const char* const end = ptr + data.size();
+    size_t keySize = 0;
+    if (data.size() < sizeof(keySize) + sizeof(int))
+    {
+        return;
+    }
+    read(ptr, keySize);
+    int numProfiles = 0;
+    // A hash collision or a file of another layout is ignored and overwritten after profiling.
+    if (static_cast<size_t>(end - ptr) < keySize + sizeof(numProfiles) || std::string(ptr, keySize) != key)
+    {
+        return;
+    }
+    ptr += keySize;
+    read(ptr, numProfiles);
+    if (numProfiles < 0 || static_cast<size_t>(end - ptr) != numProfiles * sizeof(ProfileType))
+    {
+        return;
+    }
+    for (int ii = 0; ii < numProfiles; ++ii)
+    {
+        ProfileType profile;
+        read(ptr, profile);
+        profileMap.insert(profile);
+    }
+    TLLM_LOG_DEBUG("Loaded %d GEMM tactics from %s", numProfiles, path.c_str());
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::storeTacticCache(
+    const GemmIdType& gemmId, const MProfileMap& profileMap) const
+{
+    const auto key = getTacticCacheKey(gemmId);
+    const auto path = fs::path(mTacticCacheDir) / (std::to_string(std::hash<std::string>{}(key)) + ".bin");
+
+    using ProfileType = std::pair<int, std::optional<Config>>;
+    // Ms without a valid tactic are profiled again by the next build.
+    std::vector<ProfileType> profiles;
+    for (const auto& profile : profileMap)
+    {
+        if (profile.second.has_value())
+        {
+            profiles.push_back(profile);
+        }
+    }
+    std::string data(sizeof(size_t) + key.size() + sizeof(int) + profiles.size() * sizeof(ProfileType), '\0');
+    char* ptr = data.data();
+    write(ptr, key.size());
+    std::memcpy(ptr, key.data(), key.size());
+    ptr += key.size();
+    write(ptr, static_cast<int>(profiles.size()));
+    for (const auto& profile : profiles)
+    {
+        write(ptr, profile);
+    }
+
+    // Write to a temporary file first, so that concurrent builds never read a partially written file.
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    auto const tmpPath = fs::path(path).concat(".tmp" + std::to_string(std::hash<std::string>{}(data)));
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.good())
+        {
+            TLLM_LOG_WARNING("Failed to write GEMM tactic cache file %s", tmpPath.c_str());
+            return;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        TLLM_LOG_WARNING("Failed to write GEMM tactic cache file %s: %s", path.c_str(), ec.message().c_str());
+        fs::remove(tmpPath, ec);
+    }
+}
+
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
 float GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::profileTacticForProblem(
     int m, int n, int k, const Config& tactic)
@@ -22,6 +22,7 @@
 #include <mutex>
 #include <shared_mutex>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -258,6 +259,14 @@ private:
 
     std::optional<Config> profileTacticsForProblem(int m, int n, int k, const std::vector<Config>& tactics);
 
+    // Identifies the tactics of a GEMM in the on-disk cache: profiler, GEMM ID, SM and library versions.
+    std::string getTacticCacheKey(const GemmIdType& gemmId) const;
+
+    // Adds the cached tactics of the Ms not yet in profileMap.
+    void loadTacticCache(const GemmIdType& gemmId, MProfileMap& profileMap) const;
+
+    void storeTacticCache(const GemmIdType& gemmId, const MProfileMap& profileMap) const;
+
     float profileTacticForProblem(int m, int n, int k, const Config& tactic);
 
     int nextPowerOfTwo(int v) const
@@ -286,6 +295,9 @@ private:
     GemmDims mDims{};
 
     bool mSkip{false};
+
+    // Directory of the tactic cache shared between engine builds, see getEnvGemmTacticCacheDir.
+    std::string mTacticCacheDir;
 };
 
 template <typename GemmPluginProfilerType>
@@ -17,6 +17,8 @@
 #include "tensorrt_llm/plugins/common/plugin.h"
 
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include "tensorrt_llm/runtime/ncclCommRegistry.h"
 
 #include "checkMacrosPlugin.h"
 #include "cuda.h"
@@ -43,47 +45,35 @@ std::unordered_map<nvinfer1::DataType, ncclDataType_t>* getDtypeMap()
 
 std::map<std::set<int>, ncclComm_t>* getCommMap()
 {
-    static std::map<std::set<int>, ncclComm_t> commMap;
-    return &commMap;
+    // The ranks of an in-process world share the process, each one has its own communicators
+    static std::mutex mutex;
+    static std::map<int, std::map<std::set<int>, ncclComm_t>> commMaps;
+    auto const rank = tensorrt_llm::runtime::InProcessWorld::getSessionRank();
+    std::lock_guard<std::mutex> lock(mutex);
+    return &commMaps[rank];
 }
 
 void initCommMap(std::set<int> const& group)
 {
-    auto& commMap = *getCommMap();
-    // [] operator inserts T() if it does not exist
-    if (isBuilding() || commMap[group] != nullptr)
+    if (isBuilding())
     {
         return;
     }
-    auto& comm = COMM_SESSION;
-    auto const myRank = comm.getRank();
-
-    int groupRank = 0;
-    for (int it : group)
-    {
-        if (it == myRank)
-        {
-            break;
-        }
-        ++groupRank;
-    }
+    (*getCommMap())[group] = tensorrt_llm::runtime::NcclCommRegistry::getInstance().acquire(group);
+}
 
-    ncclUniqueId id;
-    if (myRank == *group.begin())
+void releaseCommMap(std::set<int> const& group)
+{
+    auto& commMap = *getCommMap();
+    auto it = commMap.find(group);
+    if (isBuilding() || it == commMap.end() || it->second == nullptr)
     {
-        ncclGetUniqueId(&id);
-        for (auto it = std::next(std::begin(group), 1); it != group.end(); ++it)
-        {
-            comm.send(id, *it, 0);
-        }
+        return;
     }
-    else
+    if (tensorrt_llm::runtime::NcclCommRegistry::getInstance().release(it->second) == 0)
     {
-        comm.recv(id, *group.begin(), 0);
+        it->second = nullptr;
     }
-
-    commMap[group] = nullptr;
-    NCCLCHECK(ncclCommInitRank(&commMap[group], group.size(), id, groupRank));
 }
 
 void* tensorrt_llm::plugins::getCommSessionHandle()
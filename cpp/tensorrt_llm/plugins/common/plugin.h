@@ -173,10 +173,16 @@ inline bool isBuilding()
 
 std::unordered_map<nvinfer1::DataType, ncclDataType_t>* getDtypeMap();
 
+//! Communicators of the calling rank, the rank of its thread in an in-process world.
 std::map<std::set<int>, ncclComm_t>* getCommMap();
 
+//! Takes a reference to the communicator of group from the runtime's registry, shared by all the plugins and the
+//! runtime, and makes it visible in the comm map. Every call must be matched by a call to releaseCommMap.
 void initCommMap(std::set<int> const& group);
 
+//! Drops the reference of initCommMap, the communicator is destroyed with its last user.
+void releaseCommMap(std::set<int> const& group);
+
 #endif // ENABLE_MULTI_DEVICE
 
 //! To save GPU memory, all the plugins share the same cublas and cublasLt handle globally.
@@ -0,0 +1,373 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "fp8RowwiseGemmPlugin.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include <numeric>
+
+using namespace nvinfer1;
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::kernels::cutlass_kernels;
+using tensorrt_llm::plugins::Fp8RowwiseGemmPluginCreator;
+using tensorrt_llm::plugins::Fp8RowwiseGemmPlugin;
+using tensorrt_llm::plugins::Fp8RowwiseGemmPluginProfiler;
+using tensorrt_llm::plugins::read;
+using tensorrt_llm::plugins::write;
+
+static const char* FP8_ROWWISE_GEMM_PLUGIN_VERSION{"1"};
+static const char* FP8_ROWWISE_GEMM_PLUGIN_NAME{"Fp8RowwiseGemm"};
+PluginFieldCollection Fp8RowwiseGemmPluginCreator::mFC{};
+std::vector<nvinfer1::PluginField> Fp8RowwiseGemmPluginCreator::mPluginAttributes;
+
+void Fp8RowwiseGemmPluginProfiler::runTactic(int m, int n, int k, const Fp8RowwiseGemmPluginProfiler::Config& tactic,
+    char* workspace, const cudaStream_t& stream)
+{
+    int8_t* aTmp = reinterpret_cast<int8_t*>(workspace);
+    int8_t* bTmp = nextWorkspacePtr(aTmp, m * k * sizeof(int8_t));
+    void* dTmp = reinterpret_cast<void*>(nextWorkspacePtr(bTmp, n * k * sizeof(int8_t)));
+    float* scaleTokensTmp = reinterpret_cast<float*>(nextWorkspacePtr(reinterpret_cast<int8_t*>(dTmp), m * n * 2));
+    float* scaleChannelsTmp
+        = reinterpret_cast<float*>(nextWorkspacePtr(reinterpret_cast<int8_t*>(scaleTokensTmp), m * sizeof(float)));
+    char* workspaceTmp
+        = reinterpret_cast<char*>(nextWorkspacePtr(reinterpret_cast<int8_t*>(scaleChannelsTmp), n * sizeof(float)));
+
+    const int wsSize = mRunner->getWorkspaceSize(m, n, k);
+
+    mRunner->gemm(aTmp, bTmp, scaleTokensTmp, scaleChannelsTmp, dTmp, m, n, k, tactic, workspaceTmp, wsSize, stream);
+}
+
+void Fp8RowwiseGemmPluginProfiler::computeTmpSize(int maxM, int n, int k)
+{
+    std::vector<size_t> workspaces = {
+        maxM * k * sizeof(int8_t),            // A
+        n * k * sizeof(int8_t),               // B
+        maxM * n * 2u,                        // D
+        maxM * sizeof(float),                 // scaleTokens
+        n * sizeof(float),                    // scaleChannels
+        mRunner->getWorkspaceSize(maxM, n, k) // workspace
+    };
+    size_t bytes = calculateTotalWorkspaceSize(workspaces.data(), workspaces.size());
+    setTmpWorkspaceSizeInBytes(bytes);
+}
+
+std::vector<Fp8RowwiseGemmPluginProfiler::Config> Fp8RowwiseGemmPluginProfiler::getTactics(int m, int n, int k) const
+{
+    return mRunner->getConfigs();
+}
+
+Fp8RowwiseGemmPlugin::Fp8RowwiseGemmPlugin(
+    nvinfer1::DataType type, const Fp8RowwiseGemmPlugin::PluginProfilerPtr& pluginProfiler)
+    : mPluginProfiler(pluginProfiler)
+{
+    init(type);
+}
+
+// Parameterized constructor
+Fp8RowwiseGemmPlugin::Fp8RowwiseGemmPlugin(
+    const void* data, size_t length, const Fp8RowwiseGemmPlugin::PluginProfilerPtr& pluginProfiler)
+    : mPluginProfiler(pluginProfiler)
+{
+    const char *d = reinterpret_cast<const char*>(data), *a = d;
+    nvinfer1::DataType type;
+    read(d, type);
+    read(d, mDims);
+
+    init(type);
+
+    mPluginProfiler->deserialize(d, mDims, mGemmId);
+
+    TLLM_CHECK_WITH_INFO(d == a + length,
+        "Expected length (%d) != real length (%d). This is often "
+        "caused by using different TensorRT-LLM version to build "
+        "engine and run engine.",
+        (int) length, (int) (d - a));
+}
+
+void Fp8RowwiseGemmPlugin::init(nvinfer1::DataType type)
+{
+    TLLM_CHECK_WITH_INFO(getSMVersion() == 90, "The fp8 row-wise GEMM is only supported on SM90");
+    mType = type;
+    if (mType == nvinfer1::DataType::kHALF)
+    {
+        mGemmRunner = std::make_shared<CutlassFp8RowwiseGemmRunner<half>>();
+    }
+#ifdef ENABLE_BF16
+    else if (mType == nvinfer1::DataType::kBF16)
+    {
+        mGemmRunner = std::make_shared<CutlassFp8RowwiseGemmRunner<__nv_bfloat16>>();
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported output data type for the fp8 row-wise GEMM");
+    }
+
+    mGemmId = GemmIdCore(mDims.n, mDims.k, mType);
+}
+
+// IPluginV2DynamicExt Methods
+nvinfer1::IPluginV2DynamicExt* Fp8RowwiseGemmPlugin::clone() const noexcept
+{
+    auto* plugin = new Fp8RowwiseGemmPlugin(*this);
+    return plugin;
+}
+
+nvinfer1::DimsExprs Fp8RowwiseGemmPlugin::getOutputDimensions(
+    int outputIndex, const nvinfer1::DimsExprs* inputs, int nbInputs, nvinfer1::IExprBuilder& exprBuilder) noexcept
+{
+    try
+    {
+        TLLM_CHECK(nbInputs == 4);
+        TLLM_CHECK(outputIndex == 0);
+        const int nbDimsA = inputs[0].nbDims;
+        TLLM_CHECK(nbDimsA >= 2);
+        DimsExprs ret;
+        ret.nbDims = nbDimsA;
+        for (int ii = 0; ii < nbDimsA - 1; ++ii)
+        {
+            ret.d[ii] = inputs[0].d[ii];
+        }
+        ret.d[nbDimsA - 1] = inputs[1].d[0];
+        return ret;
+    }
+    catch (const std::exception& e)
+    {
+        caughtError(e);
+    }
+    return DimsExprs{};
+}
+
+bool Fp8RowwiseGemmPlugin::supportsFormatCombination(
+    int pos, const nvinfer1::PluginTensorDesc* inOut, int nbInputs, int nbOutputs) noexcept
+{
+    switch (pos)
+    {
+    case 0:
+        // activation
+    case 1:
+        // weights
+        return inOut[pos].type == nvinfer1::DataType::kFP8 && inOut[pos].format == TensorFormat::kLINEAR;
+    case 2:
+        // scales tokens
+    case 3:
+        // scales channels
+        return inOut[pos].type == nvinfer1::DataType::kFLOAT && inOut[pos].format == TensorFormat::kLINEAR;
+    case 4:
+        // out
+        return inOut[pos].type == mType && inOut[pos].format == TensorFormat::kLINEAR;
+    default:
+        // Never should be here
+        assert(false);
+        return false;
+    }
+}
+
+void Fp8RowwiseGemmPlugin::configurePlugin(const nvinfer1::DynamicPluginTensorDesc* in, int nbInputs,
+    const nvinfer1::DynamicPluginTensorDesc* out, int nbOutputs) noexcept
+{
+    const auto minM = std::accumulate(in[0].min.d, in[0].min.d + in[0].min.nbDims - 1, 1, std::multiplies<int>());
+    const auto maxM = std::accumulate(in[0].max.d, in[0].max.d + in[0].max.nbDims - 1, 1, std::multiplies<int>());
+
+    const int maxK = in[0].max.d[in[0].max.nbDims - 1];
+    const int maxN = in[1].max.d[0];
+    const int minK = in[0].min.d[in[0].min.nbDims - 1];
+    const int minN = in[1].min.d[0];
+
+    TLLM_CHECK_WITH_INFO(minN == maxN, "Variable out channels is not allowed");
+    TLLM_CHECK_WITH_INFO(minK == maxK, "Variable in channels is not allowed");
+    // The TMA loads need 16 byte aligned rows.
+    TLLM_CHECK_WITH_INFO(maxK % 16 == 0 && maxN % 16 == 0, "K and N must be multiples of 16 for the fp8 GEMM");
+
+    if (!mDims.isInitialized())
+    {
+        mDims = {minM, maxM, maxN, maxK};
+    }
+    mGemmId = {maxN, maxK, mType};
+
+    mWorkspaceMaxSize = mGemmRunner->getWorkspaceSize(maxM, maxN, maxK);
+}
+
+size_t Fp8RowwiseGemmPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
+    const nvinfer1::PluginTensorDesc* outputs, int nbOutputs) const noexcept
+{
+    return mWorkspaceMaxSize;
+}
+
+int Fp8RowwiseGemmPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
+    const nvinfer1::PluginTensorDesc* outputDesc, const void* const* inputs, void* const* outputs, void* workspace,
+    cudaStream_t stream) noexcept
+{
+    // inputs
+    //     mat1           [M(*), K], quantized per token
+    //     mat2           [N, K], quantized per output channel
+    //     scale_tokens   [M, 1]
+    //     scale_channels [1, N]
+    // outputs
+    //     mat [M(*), N]
+    int m = 1;
+    for (int ii = 0; ii < inputDesc[0].dims.nbDims - 1; ++ii)
+    {
+        m *= inputDesc[0].dims.d[ii];
+    }
+    const int n = inputDesc[1].dims.d[0];
+    const int k = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
+    const int wsSize = mGemmRunner->getWorkspaceSize(m, n, k);
+
+    const auto& bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
+    TLLM_CHECK_WITH_INFO(bestTactic, "No valid fp8 row-wise GEMM tactic");
+    mGemmRunner->gemm(inputs[0], inputs[1], reinterpret_cast<const float*>(inputs[2]),
+        reinterpret_cast<const float*>(inputs[3]), outputs[0], m, n, k, *bestTactic,
+        reinterpret_cast<char*>(workspace), wsSize, stream);
+
+    return 0;
+}
+
+// IPluginV2Ext Methods
+nvinfer1::DataType Fp8RowwiseGemmPlugin::getOutputDataType(
+    int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
+{
+    TLLM_CHECK(index == 0);
+    return mType;
+}
+
+// IPluginV2 Methods
+
+const char* Fp8RowwiseGemmPlugin::getPluginType() const noexcept
+{
+    return FP8_ROWWISE_GEMM_PLUGIN_NAME;
+}
+
+const char* Fp8RowwiseGemmPlugin::getPluginVersion() const noexcept
+{
+    return FP8_ROWWISE_GEMM_PLUGIN_VERSION;
+}
+
+int Fp8RowwiseGemmPlugin::getNbOutputs() const noexcept
+{
+    return 1;
+}
+
+int Fp8RowwiseGemmPlugin::initialize() noexcept
+{
+    configGemm();
+    return 0;
+}
+
+void Fp8RowwiseGemmPlugin::terminate() noexcept {}
+
+size_t Fp8RowwiseGemmPlugin::getSerializationSize() const noexcept
+{
+    return sizeof(nvinfer1::DataType) +                 // dtype
+        sizeof(mDims) +                                 // Dimensions
+        mPluginProfiler->getSerializationSize(mGemmId); // selected tactics container size
+}
+
+void Fp8RowwiseGemmPlugin::serialize(void* buffer) const noexcept
+{
+    char *d = static_cast<char*>(buffer), *a = d;
+    write(d, mType);
+    write(d, mDims);
+
+    mPluginProfiler->serialize(d, mGemmId);
+    assert(d == a + getSerializationSize());
+}
+
+void Fp8RowwiseGemmPlugin::destroy() noexcept
+{
+    // This gets called when the network containing plugin is destroyed
+    delete this;
+}
+
+void Fp8RowwiseGemmPlugin::configGemm()
+{
+    mPluginProfiler->profileTactics(mGemmRunner, mType, mDims, mGemmId);
+}
+
+///////////////
+
+Fp8RowwiseGemmPluginCreator::Fp8RowwiseGemmPluginCreator()
+{
+    // Fill PluginFieldCollection with PluginField arguments metadata
+    mPluginAttributes.clear();
+    mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
+    mFC.nbFields = mPluginAttributes.size();
+    mFC.fields = mPluginAttributes.data();
+}
+
+const char* Fp8RowwiseGemmPluginCreator::getPluginName() const noexcept
+{
+    return FP8_ROWWISE_GEMM_PLUGIN_NAME;
+}
+
+const char* Fp8RowwiseGemmPluginCreator::getPluginVersion() const noexcept
+{
+    return FP8_ROWWISE_GEMM_PLUGIN_VERSION;
+}
+
+const PluginFieldCollection* Fp8RowwiseGemmPluginCreator::getFieldNames() noexcept
+{
+    return &mFC;
+}
+
+IPluginV2* Fp8RowwiseGemmPluginCreator::createPlugin(const char* name, const PluginFieldCollection* fc) noexcept
+{
+    const PluginField* fields = fc->fields;
+    nvinfer1::DataType type;
+    // Read configurations from each fields
+    for (int i = 0; i < fc->nbFields; ++i)
+    {
+        const char* attrName = fields[i].name;
+        if (!strcmp(attrName, "type_id"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            type = static_cast<nvinfer1::DataType>(*(static_cast<const nvinfer1::DataType*>(fields[i].data)));
+        }
+    }
+    try
+    {
+        // Fp8RowwiseGemmPluginCreator is unique and shared for an engine generation
+        // Create plugin profiler with shared tactics map
+        auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ false);
+        auto* obj = new Fp8RowwiseGemmPlugin(type, pluginProfiler);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+    catch (const std::exception& e)
+    {
+        caughtError(e);
+    }
+    return nullptr;
+}
+
+IPluginV2* Fp8RowwiseGemmPluginCreator::deserializePlugin(
+    const char* name, const void* serialData, size_t serialLength) noexcept
+{
+    // This object will be deleted when the network is destroyed, which will
+    // call Fp8RowwiseGemmPlugin::destroy()
+    try
+    {
+        // Create plugin profiler with private tactics map which is read from the serialized engine
+        auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ true);
+        auto* obj = new Fp8RowwiseGemmPlugin(serialData, serialLength, pluginProfiler);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+    catch (const std::exception& e)
+    {
+        caughtError(e);
+    }
+    return nullptr;
+}
@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/kernels/cutlass_kernels/fp8_rowwise_gemm/fp8_rowwise_gemm.h"
+#include "tensorrt_llm/plugins/common/gemmPluginProfiler.h"
+#include "tensorrt_llm/plugins/common/plugin.h"
+#include <cassert>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+using Fp8RowwiseGemmRunnerPtr
+    = std::shared_ptr<tensorrt_llm::kernels::cutlass_kernels::CutlassFp8RowwiseGemmRunnerInterface>;
+
+class Fp8RowwiseGemmPluginProfiler : public GemmPluginProfiler<tensorrt_llm::cutlass_extensions::CutlassGemmConfig,
+                                         Fp8RowwiseGemmRunnerPtr, GemmIdCore, GemmIdCoreHash>
+{
+public:
+    using Config = tensorrt_llm::cutlass_extensions::CutlassGemmConfig;
+
+protected:
+    void runTactic(int m, int n, int k, const Config& tactic, char* workspace, const cudaStream_t& stream) override;
+
+    void computeTmpSize(int maxM, int n, int k) override;
+
+    std::vector<Config> getTactics(int m, int n, int k) const override;
+};
+
+// GEMM of fp8 activations quantized per token and fp8 weights quantized per output channel, see
+// CutlassFp8RowwiseGemmRunner. Unlike the per-tensor fp8 path of the GemmPlugin, the outliers of one token or channel
+// do not squeeze the range of all the others.
+class Fp8RowwiseGemmPlugin : public BasePlugin
+{
+public:
+    using PluginProfilerPtr = std::shared_ptr<Fp8RowwiseGemmPluginProfiler>;
+
+    Fp8RowwiseGemmPlugin() = delete;
+
+    Fp8RowwiseGemmPlugin(nvinfer1::DataType type, const PluginProfilerPtr& pluginProfiler);
+
+    Fp8RowwiseGemmPlugin(const void* data, size_t length, const PluginProfilerPtr& pluginProfiler);
+
+    ~Fp8RowwiseGemmPlugin() override = default;
+
+    // IPluginV2DynamicExt Methods
+    nvinfer1::IPluginV2DynamicExt* clone() const noexcept override;
+    nvinfer1::DimsExprs getOutputDimensions(int outputIndex, const nvinfer1::DimsExprs* inputs, int nbInputs,
+        nvinfer1::IExprBuilder& exprBuilder) noexcept override;
+    bool supportsFormatCombination(
+        int pos, const nvinfer1::PluginTensorDesc* inOut, int nbInputs, int nbOutputs) noexcept override;
+    void configurePlugin(const nvinfer1::DynamicPluginTensorDesc* in, int nbInputs,
+        const nvinfer1::DynamicPluginTensorDesc* out, int nbOutputs) noexcept override;
+    size_t getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
+        const nvinfer1::PluginTensorDesc* outputs, int nbOutputs) const noexcept override;
+    int enqueue(const nvinfer1::PluginTensorDesc* inputDesc, const nvinfer1::PluginTensorDesc* outputDesc,
+        const void* const* inputs, void* const* outputs, void* workspace, cudaStream_t stream) noexcept override;
+
+    // IPluginV2Ext Methods
+    nvinfer1::DataType getOutputDataType(
+        int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept override;
+
+    // IPluginV2 Methods
+    const char* getPluginType() const noexcept override;
+    const char* getPluginVersion() const noexcept override;
+    int getNbOutputs() const noexcept override;
+    int initialize() noexcept override;
+    void terminate() noexcept override;
+    size_t getSerializationSize() const noexcept override;
+    void serialize(void* buffer) const noexcept override;
+    void destroy() noexcept override;
+
+private:
+    void init(nvinfer1::DataType type);
+
+    void configGemm();
+
+private:
+    const std::string mLayerName;
+
+    Fp8RowwiseGemmRunnerPtr mGemmRunner;
+    size_t mWorkspaceMaxSize;
+
+    GemmDims mDims{};
+    GemmIdCore mGemmId{};
+
+    PluginProfilerPtr mPluginProfiler;
+
+    nvinfer1::DataType mType;
+};
+
+class Fp8RowwiseGemmPluginCreator : public BaseCreator
+{
+public:
+    Fp8RowwiseGemmPluginCreator();
+
+    const char* getPluginName() const noexcept override;
+
+    const char* getPluginVersion() const noexcept override;
+
+    const nvinfer1::PluginFieldCollection* getFieldNames() noexcept override;
+
+    nvinfer1::IPluginV2* createPlugin(const char* name, const nvinfer1::PluginFieldCollection* fc) noexcept override;
+
+    nvinfer1::IPluginV2* deserializePlugin(
+        const char* name, const void* serialData, size_t serialLength) noexcept override;
+
+private:
+    GemmPluginProfilerManager<Fp8RowwiseGemmPluginProfiler> gemmPluginProfileManager;
+    static nvinfer1::PluginFieldCollection mFC;
+    static std::vector<nvinfer1::PluginField> mPluginAttributes;
+};
+
+} // namespace tensorrt_llm::plugins
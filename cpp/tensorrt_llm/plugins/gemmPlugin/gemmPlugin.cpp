@@ -16,7 +16,12 @@
  */
 #include "gemmPlugin.h"
 #include "plugin.h"
+#include "tensorrt_llm/common/customAllReduceUtils.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
 #include <NvInferRuntimeBase.h>
+#include <algorithm>
 
 using namespace nvinfer1;
 using namespace tensorrt_llm::common;
@@ -32,6 +37,15 @@ static const char* GEMM_PLUGIN_NAME{"Gemm"};
 PluginFieldCollection GemmPluginCreator::mFC{};
 std::vector<nvinfer1::PluginField> GemmPluginCreator::mPluginAttributes;
 
+namespace
+{
+// Chunks of the GEMM with all-reduce. The chunks use consecutive barrier flags starting at counter * kMaxChunks, so
+// that a chunk never passes the barrier of the previous one.
+constexpr int kMaxAllReduceChunks = 4;
+// Outputs below 1MB per chunk are all-reduced in one go, the overlap would not amortize the extra launches.
+constexpr size_t kMinAllReduceChunkSize = 1 << 20;
+} // namespace
+
 void getProblemParams(cublasOperation_t& transa, cublasOperation_t& transb, int& m, int& n, int& k, int& lda, int& ldb,
     int& ldc, bool transA, bool transB, int M, int N, int K)
 {
@@ -126,14 +140,16 @@ std::vector<CublasLtGemmPluginProfiler::Config> CublasLtGemmPluginProfiler::getT
     return heruistics;
 }
 
-GemmPlugin::GemmPlugin(
-    int transA, int transB, nvinfer1::DataType type, bool useFp8, const GemmPlugin::PluginProfilerPtr& pluginProfiler)
+GemmPlugin::GemmPlugin(int transA, int transB, nvinfer1::DataType type, bool useFp8,
+    const GemmPlugin::PluginProfilerPtr& pluginProfiler, std::set<int> allReduceGroup, int32_t allReduceCounter)
     : mTransA(transA)
     , mTransB(transB)
     , mType(type)
     , mUseFp8(useFp8)
     , mPluginProfiler(pluginProfiler)
     , mOutputType(type)
+    , mAllReduceGroup(std::move(allReduceGroup))
+    , mAllReduceCounter(allReduceCounter)
 {
     init();
 }
@@ -149,6 +165,15 @@ GemmPlugin::GemmPlugin(const void* data, size_t length, const GemmPlugin::Plugin
     read(d, mUseFp8);
     read(d, mDims);
     read(d, mOutputType);
+    int allReduceGroupSize = 0;
+    read(d, allReduceGroupSize);
+    for (int i = 0; i < allReduceGroupSize; ++i)
+    {
+        int rank = 0;
+        read(d, rank);
+        mAllReduceGroup.insert(rank);
+    }
+    read(d, mAllReduceCounter);
 
     init();
 
@@ -171,6 +196,10 @@ void GemmPlugin::init()
     mPluginProfiler->setOutputType(mOutputType);
 
     mGemmId = GemmIdCublas(mDims.n, mDims.k, mType, mTransA, mTransB);
+
+#if !ENABLE_MULTI_DEVICE
+    TLLM_CHECK_WITH_INFO(mAllReduceGroup.empty(), "The GEMM with all-reduce needs a multi-device build");
+#endif // !ENABLE_MULTI_DEVICE
 }
 
 void GemmPlugin::setGemmConfig()
@@ -214,6 +243,9 @@ void GemmPlugin::configGemm()
 nvinfer1::IPluginV2DynamicExt* GemmPlugin::clone() const noexcept
 {
     auto* plugin = new GemmPlugin(*this);
+    // The clone creates its own stream and events
+    plugin->mAllReduceStream = nullptr;
+    plugin->mAllReduceEvents.clear();
     return plugin;
 }
 
@@ -222,7 +254,7 @@ nvinfer1::DimsExprs GemmPlugin::getOutputDimensions(
 {
     try
     {
-        TLLM_CHECK(nbInputs == 2);
+        TLLM_CHECK(nbInputs == (mAllReduceGroup.empty() ? 2 : 3));
         TLLM_CHECK(outputIndex == 0);
         const int nbDimsA = inputs[0].nbDims;
         const int nbDimsB = inputs[1].nbDims;
@@ -275,6 +307,12 @@ bool GemmPlugin::supportsFormatCombination(
         return false;
     }
 
+    if (!mAllReduceGroup.empty() && pos == 2)
+    {
+        // The pointers of the custom all-reduce workspace
+        return desc.type == nvinfer1::DataType::kINT64;
+    }
+
     if (pos < nbInputs)
     {
         return desc.type == mType;
@@ -367,12 +405,80 @@ int GemmPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc, const nvinf
     const auto N = computeNDimension(mTransB, nbDimsB, inputDesc[1].dims.d);
     const int K = mTransA ? inputDesc[0].dims.d[0] : inputDesc[0].dims.d[nbDimsA - 1];
 
+    if (!mAllReduceGroup.empty())
+    {
+        const int ranksPerNode = inputDesc[2].dims.d[0] / utils::customAllReduceUtils::NUM_POINTERS_PER_RANK;
+        runGemmAllReduce(M, N, K, inputs[0], inputs[1], inputs[2], ranksPerNode, outputs[0], workspace, stream);
+        return 0;
+    }
+
     auto bestTactic = mPluginProfiler->getBestConfig(M, mGemmId);
     runGemm(M, N, K, mTransA, mTransB, mType, mCublasWrapper, inputs[0], inputs[1], outputs[0], bestTactic, workspace,
         stream);
     return 0;
 }
 
+void GemmPlugin::runGemmAllReduce(int M, int N, int K, const void* act, const void* weight,
+    const void* allReduceWorkspace, int ranksPerNode, void* output, void* workspace, cudaStream_t stream)
+{
+#if ENABLE_MULTI_DEVICE
+    const auto outputSize = typeSize(mOutputType);
+    const size_t eltsPerThread = 16 / outputSize;
+    const size_t messageSize = static_cast<size_t>(M) * N * outputSize;
+    if (static_cast<int>(mAllReduceGroup.size()) != ranksPerNode
+        || messageSize > utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(ranksPerNode)
+        || N % eltsPerThread != 0)
+    {
+        // The ranks span several nodes or the output does not fit the IPC buffers: GEMM, then NCCL.
+        runGemm(M, N, K, mTransA, mTransB, mType, mCublasWrapper, act, weight, output,
+            mPluginProfiler->getBestConfig(M, mGemmId), workspace, stream);
+        NCCLCHECK(ncclAllReduce(output, output, static_cast<size_t>(M) * N, (*getDtypeMap())[mOutputType], ncclSum,
+            (*getCommMap())[mAllReduceGroup], stream));
+        return;
+    }
+
+    const auto myRank = tensorrt_llm::runtime::InProcessWorld::getSessionRank() % ranksPerNode;
+    auto params = kernels::AllReduceParams::deserialize(
+        reinterpret_cast<const int32_t*>(allReduceWorkspace), ranksPerNode, myRank, mAllReduceCounter);
+    const auto dataType = mOutputType == DataType::kFLOAT
+        ? datatype_enum::TYPE_FP32
+        : (mOutputType == DataType::kHALF ? datatype_enum::TYPE_FP16 : datatype_enum::TYPE_BF16);
+
+    // The rows of A are only contiguous without transposition, a transposed A is a single chunk.
+    const auto maxChunks = static_cast<size_t>(kMaxAllReduceChunks);
+    const int numChunks
+        = mTransA ? 1 : static_cast<int>(std::clamp<size_t>(messageSize / kMinAllReduceChunkSize, 1, maxChunks));
+    const int chunkRows = static_cast<int>(divUp(M, numChunks));
+    auto* const localBuffer = static_cast<char*>(params.peer_comm_buffer_ptrs[myRank]);
+    int chunk = 0;
+    for (int row = 0; row < M; row += chunkRows, ++chunk)
+    {
+        const int rows = std::min(chunkRows, M - row);
+        const size_t offset = static_cast<size_t>(row) * N * outputSize;
+        const auto* chunkAct = static_cast<const char*>(act) + static_cast<size_t>(row) * K * typeSize(mType);
+        runGemm(rows, N, K, mTransA, mTransB, mType, mCublasWrapper, chunkAct, weight, localBuffer + offset,
+            mPluginProfiler->getBestConfig(rows, mGemmId), workspace, stream);
+        TLLM_CUDA_CHECK(cudaEventRecord(mAllReduceEvents[chunk], stream));
+        TLLM_CUDA_CHECK(cudaStreamWaitEvent(mAllReduceStream, mAllReduceEvents[chunk]));
+
+        auto chunkParams = params;
+        for (int ii = 0; ii < ranksPerNode; ++ii)
+        {
+            chunkParams.peer_comm_buffer_ptrs[ii] = static_cast<char*>(params.peer_comm_buffer_ptrs[ii]) + offset;
+        }
+        chunkParams.barrier_flag = mAllReduceCounter * kMaxAllReduceChunks + chunk;
+        // The two-shot kernel splits the chunk evenly between the ranks.
+        const size_t elts = static_cast<size_t>(rows) * N;
+        const auto strategy = elts % (ranksPerNode * eltsPerThread) == 0 ? kernels::AllReduceStrategyType::TWOSHOT
+                                                                         : kernels::AllReduceStrategyType::ONESHOT;
+        kernels::customAllReduce(chunkParams, static_cast<char*>(output) + offset, elts, outputSize, dataType, strategy,
+            mAllReduceStream);
+    }
+    TLLM_CUDA_CHECK(cudaEventRecord(mAllReduceEvents[kMaxAllReduceChunks], mAllReduceStream));
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, mAllReduceEvents[kMaxAllReduceChunks]));
+#endif // ENABLE_MULTI_DEVICE
+}
+
 // IPluginV2Ext Methods
 nvinfer1::DataType GemmPlugin::getOutputDataType(
     int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
@@ -401,6 +507,19 @@ int GemmPlugin::getNbOutputs() const noexcept
 int GemmPlugin::initialize() noexcept
 {
     configGemm();
+#if ENABLE_MULTI_DEVICE
+    if (!mAllReduceGroup.empty() && !isBuilding() && mAllReduceStream == nullptr)
+    {
+        initCommMap(mAllReduceGroup);
+        TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&mAllReduceStream, cudaStreamNonBlocking));
+        // An event per chunk and the end of the all-reduce
+        mAllReduceEvents.resize(kMaxAllReduceChunks + 1);
+        for (auto& event : mAllReduceEvents)
+        {
+            TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+        }
+    }
+#endif // ENABLE_MULTI_DEVICE
     return 0;
 }
 
@@ -412,7 +531,8 @@ void GemmPlugin::destroy() noexcept
 size_t GemmPlugin::getSerializationSize() const noexcept
 {
     return sizeof(mTransA) + sizeof(mTransB) + sizeof(mType) + sizeof(mDims) + sizeof(mUseFp8)
-        + mPluginProfiler->getSerializationSize(mGemmId) + sizeof(mOutputType); // selected tactics container size
+        + mPluginProfiler->getSerializationSize(mGemmId) + sizeof(mOutputType) // selected tactics container size
+        + sizeof(int) * (mAllReduceGroup.size() + 1) + sizeof(mAllReduceCounter);
 }
 
 void GemmPlugin::serialize(void* buffer) const noexcept
@@ -424,12 +544,34 @@ void GemmPlugin::serialize(void* buffer) const noexcept
     write(d, mUseFp8);
     write(d, mDims);
     write(d, mOutputType);
+    write(d, static_cast<int>(mAllReduceGroup.size()));
+    for (const int rank : mAllReduceGroup)
+    {
+        write(d, rank);
+    }
+    write(d, mAllReduceCounter);
     mPluginProfiler->serialize(d, mGemmId);
 
     assert(d == a + getSerializationSize());
 }
 
-void GemmPlugin::terminate() noexcept {}
+void GemmPlugin::terminate() noexcept
+{
+    if (mAllReduceStream == nullptr)
+    {
+        return;
+    }
+    for (auto event : mAllReduceEvents)
+    {
+        cudaEventDestroy(event);
+    }
+    mAllReduceEvents.clear();
+    cudaStreamDestroy(mAllReduceStream);
+    mAllReduceStream = nullptr;
+#if ENABLE_MULTI_DEVICE
+    releaseCommMap(mAllReduceGroup);
+#endif // ENABLE_MULTI_DEVICE
+}
 
 ///////////////
 
@@ -441,6 +583,8 @@ GemmPluginCreator::GemmPluginCreator()
     mPluginAttributes.emplace_back(PluginField("transB", nullptr, PluginFieldType::kINT32, 0));
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("use_fp8", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("allreduce_group", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("allreduce_counter", nullptr, PluginFieldType::kINT32, 0));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -466,6 +610,8 @@ IPluginV2* GemmPluginCreator::createPlugin(const char* name, const PluginFieldCo
     int transA, transB;
     nvinfer1::DataType type;
     int useFp8;
+    std::set<int> allReduceGroup;
+    int32_t allReduceCounter{0};
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
     {
@@ -490,6 +636,17 @@ IPluginV2* GemmPluginCreator::createPlugin(const char* name, const PluginFieldCo
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
             useFp8 = static_cast<int>(*(static_cast<const int*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "allreduce_group"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            const auto* ranks = static_cast<const int*>(fields[i].data);
+            allReduceGroup.insert(ranks, ranks + fields[i].length);
+        }
+        else if (!strcmp(attrName, "allreduce_counter"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            allReduceCounter = *static_cast<const int32_t*>(fields[i].data);
+        }
     }
     try
     {
@@ -497,7 +654,7 @@ IPluginV2* GemmPluginCreator::createPlugin(const char* name, const PluginFieldCo
         // Create plugin profiler with shared tactics map
         // FIXME enable tactic profiler
         auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ false, /* skip */ true);
-        auto* obj = new GemmPlugin(transA, transB, type, useFp8, pluginProfiler);
+        auto* obj = new GemmPlugin(transA, transB, type, useFp8, pluginProfiler, allReduceGroup, allReduceCounter);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
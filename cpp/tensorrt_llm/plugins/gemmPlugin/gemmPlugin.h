@@ -71,7 +71,11 @@ public:
 
     GemmPlugin() = delete;
 
-    GemmPlugin(int transA, int transB, nvinfer1::DataType type, bool useFp8, const PluginProfilerPtr& profiler);
+    //! \param allReduceGroup ranks the output is all-reduced over, empty for a plain GEMM. The all-reduce is overlapped
+    //! with the GEMM, see runGemmAllReduce.
+    //! \param allReduceCounter barrier flag of the custom all-reduce, as the counter of the all-reduce plugin
+    GemmPlugin(int transA, int transB, nvinfer1::DataType type, bool useFp8, const PluginProfilerPtr& profiler,
+        std::set<int> allReduceGroup = {}, int32_t allReduceCounter = 0);
 
     GemmPlugin(const void* data, size_t length, const PluginProfilerPtr& profiler);
 
@@ -108,6 +112,11 @@ private:
     void init();
     void configGemm();
     void setGemmConfig();
+    // Row-parallel GEMM followed by the all-reduce of its output. The GEMM writes the output into the custom
+    // all-reduce buffer of the rank, so the output is not copied there, and is split along M: the all-reduce of a chunk
+    // runs on a side stream while the next chunk is computed.
+    void runGemmAllReduce(int M, int N, int K, const void* act, const void* weight, const void* allReduceWorkspace,
+        int ranksPerNode, void* output, void* workspace, cudaStream_t stream);
 
 private:
     const std::string mLayerName;
@@ -126,6 +135,12 @@ private:
     bool mUseFp8{false};
 
     PluginProfilerPtr mPluginProfiler;
+
+    std::set<int> mAllReduceGroup;
+    int32_t mAllReduceCounter{0};
+    // The side stream of the all-reduce and an event per chunk, created by initialize.
+    cudaStream_t mAllReduceStream{nullptr};
+    std::vector<cudaEvent_t> mAllReduceEvents;
 };
 
 class GemmPluginCreator : public BaseCreator
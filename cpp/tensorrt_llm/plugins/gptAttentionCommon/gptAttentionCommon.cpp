@@ -20,11 +20,16 @@
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQARunner.h"
 #include "tensorrt_llm/kernels/gptKernels.h"
+#include "tensorrt_llm/kernels/gqaGenerationAttentionKernels.h"
+#include "tensorrt_llm/kernels/kvCacheEvictionKernels.h"
+#include "tensorrt_llm/kernels/rotaryCosSinCache.h"
+#include "tensorrt_llm/kernels/sinkAttentionKernels.h"
 #include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
 #include "tensorrt_llm/plugins/common/checkMacrosPlugin.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include <NvInferRuntimePlugin.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <type_traits>
 
@@ -84,8 +89,10 @@ struct FusedQKVMaskedAttentionDispatchParams
     RotaryScalingType rotary_embedding_scale_type;
     float rotary_embedding_scale;
     int rotary_embedding_max_positions;
+    const float2* rotary_embedding_cos_sin;
     PositionEmbeddingType position_embedding_type;
     bool position_shift_enabled;
+    bool qkv_preprocessed = false;
     int max_attention_window;
     int cyclic_attention_window_size;
     int sink_token_length;
@@ -111,7 +118,9 @@ struct FusedQKVMaskedAttentionDispatchParams
     const float* kv_scale_orig_quant;
     const float* kv_scale_quant_orig;
     tc::QuantMode kv_cache_quant_mode;
+    const int* kv_eviction_write_slots = nullptr;
     int multi_processor_count;
+    int sm_version;
     KVCacheBuffer kv_block_array;
     KVLinearBuffer shift_k_cache_buffer;
     bool cross_attention = false;
@@ -225,6 +234,7 @@ bool GPTAttentionPluginCommon::convertMMHAParamsToXQAParams(tensorrt_llm::kernel
     xqaParams.max_blocks_per_sequence = generationsParams.max_blocks_per_sequence;
     xqaParams.sink_token_length = generationsParams.sink_token_length;
     xqaParams.timestep = generationsParams.past_kv_length;
+    xqaParams.rotary_cos_sin = getRotaryCosSin(generationsParams.past_kv_length + generationsParams.input_seq_length);
     xqaParams.qkv_bias = generationsParams.qkv_bias;
     xqaParams.sequence_lengths = generationsParams.sequence_lengths;
     xqaParams.context_lengths = generationsParams.context_lengths;
@@ -274,6 +284,7 @@ void fusedQKV_masked_attention_dispatch(Multihead_attention_params<T_MMHA, CROSS
 
     params.int8_kv_cache = input_params.kv_cache_quant_mode.hasInt8KvCache();
     params.fp8_kv_cache = input_params.kv_cache_quant_mode.hasFp8KvCache();
+    params.kv_cache_dynamic_scales = input_params.kv_cache_quant_mode.hasKvCacheDynamicScales();
     if (input_params.kv_cache_quant_mode.hasKvCacheQuant())
     {
         params.kv_scale_orig_quant = input_params.kv_scale_orig_quant;
@@ -300,8 +311,11 @@ void fusedQKV_masked_attention_dispatch(Multihead_attention_params<T_MMHA, CROSS
     params.rotary_embedding_scale_type = input_params.rotary_embedding_scale_type;
     params.rotary_embedding_scale = input_params.rotary_embedding_scale;
     params.rotary_embedding_max_positions = input_params.rotary_embedding_max_positions;
+    params.rotary_embedding_cos_sin = input_params.rotary_embedding_cos_sin;
     params.position_embedding_type = input_params.position_embedding_type;
     params.position_shift_enabled = input_params.position_shift_enabled;
+    params.qkv_preprocessed = input_params.qkv_preprocessed;
+    params.kv_eviction_write_slots = input_params.kv_eviction_write_slots;
     // Note: keep norm factor (sqrt(K_dim)) when adopting megatron T5 structure (may adjust)
     params.inv_sqrt_dh = 1.F / (sqrtf((float) params.hidden_size_per_head) * input_params.q_scaling);
 
@@ -340,6 +354,7 @@ void fusedQKV_masked_attention_dispatch(Multihead_attention_params<T_MMHA, CROSS
     }
 
     params.multi_processor_count = input_params.multi_processor_count;
+    params.sm_version = input_params.sm_version;
 
     // cross attn
     params.memory_length_per_sample = input_params.memory_length_per_sample;
@@ -374,7 +389,8 @@ GPTAttentionPluginCommon::GPTAttentionPluginCommon(int layer_idx, int num_heads,
     int kv_cache_quant_mode, bool remove_input_padding, tensorrt_llm::kernels::AttentionMaskType mask_type,
     bool paged_kv_cache, int tokens_per_block, nvinfer1::DataType type, int32_t max_context_length,
     bool qkv_bias_enabled, bool cross_attention, int max_distance, bool pos_shift_enabled, bool dense_context_fmha,
-    bool use_paged_context_fmha, bool use_cache, bool is_medusa_enabled)
+    bool use_paged_context_fmha, bool use_cache, bool is_medusa_enabled, KVCacheLayout kv_cache_layout,
+    int kv_cache_eviction_recent_window)
     : mLayerIdx(layer_idx)
     , mNumHeads(num_heads)
     , mNumKVHeads(num_kv_heads)
@@ -410,6 +426,8 @@ GPTAttentionPluginCommon::GPTAttentionPluginCommon(int layer_idx, int num_heads,
     , mPagedContextFMHA(use_paged_context_fmha)
     , mUseKVCache(use_cache)
     , mIsMedusaEnabled(is_medusa_enabled)
+    , mKVCacheLayout(kv_cache_layout)
+    , mKVCacheEvictionRecentWindow(kv_cache_eviction_recent_window)
 {
     // Pre-check whether FMHA is supported in order to save memory allocation.
     if (mEnableContextFMHA)
@@ -443,8 +461,14 @@ GPTAttentionPluginCommon::GPTAttentionPluginCommon(int layer_idx, int num_heads,
     }
 
     TLLM_CHECK(isRoPE() == (rotary_embedding_dim != 0));
+    TLLM_CHECK_WITH_INFO(mRotaryEmbeddingScaleType != RotaryScalingType::kLONGROPE,
+        "GPTAttentionPlugin does not carry LongRoPE rescale factors, build the cos/sin table with "
+        "getRotaryCosSinCache instead.");
     TLLM_CHECK_WITH_INFO((mSM >= 80) || (mType != nvinfer1::DataType::kBF16),
         "Unsupported data type, pre SM 80 GPUs do not support bfloat16");
+    // The context phase can write the INT4 cache, but neither MMHA nor the XQA cubins can read it.
+    TLLM_CHECK_WITH_INFO(!mKVCacheQuantMode.hasInt4KvCache(),
+        "The INT4 KV cache is not supported by the generation attention kernels, use INT8 or FP8 instead.");
 
     // Some features have not been implemented on Volta.
     if (mSM == 70 && mEnableContextFMHA)
@@ -462,6 +486,42 @@ GPTAttentionPluginCommon::GPTAttentionPluginCommon(int layer_idx, int num_heads,
     {
         TLLM_CHECK_WITH_INFO(false, "Head size %d is not supported by MMHA.", getHeadSize());
     }
+
+    // The interleaved K cache is only understood by the MMHA, GQA tensor core and unfused kernels. XQA is skipped in
+    // initialize(), the other users of the cache are rejected here.
+    if (mKVCacheLayout == KVCacheLayout::kINTERLEAVED_K)
+    {
+        TLLM_CHECK_WITH_INFO(!(mPagedKVCache && mPagedContextFMHA && mEnableContextFMHA),
+            "The interleaved K cache layout is not supported by paged context FMHA.");
+        TLLM_CHECK_WITH_INFO(!mIsMedusaEnabled, "Medusa does not support the interleaved K cache layout.");
+        // Every head has to fill whole 16B chunks of the 8-bit cache, the largest x.
+        TLLM_CHECK_WITH_INFO(getHeadSize() % 16 == 0,
+            "The interleaved K cache layout needs a head size multiple of 16, got %d.", getHeadSize());
+    }
+
+    // Dynamic KV cache scales are computed by the context preprocessing kernel and stored in the paged blocks. Only
+    // MMHA reads them in the generation phase, XQA is skipped in initialize().
+    if (mKVCacheQuantMode.hasKvCacheDynamicScales())
+    {
+        TLLM_CHECK_WITH_INFO(mPagedKVCache && mEnableContextFMHA,
+            "Dynamic KV cache scales need the paged KV cache and context FMHA.");
+        TLLM_CHECK_WITH_INFO(!mPosShiftEnabled, "Dynamic KV cache scales do not support position shift.");
+        TLLM_CHECK_WITH_INFO(!mIsMedusaEnabled, "Medusa does not support dynamic KV cache scales.");
+    }
+
+    // KV cache eviction keeps its metadata in the paged blocks and is implemented by MMHA only, XQA is skipped in
+    // initialize().
+    if (mKVCacheEvictionRecentWindow > 0)
+    {
+        TLLM_CHECK_WITH_INFO(
+            mPagedKVCache && !mCrossAttention, "KV cache eviction needs a paged self attention cache.");
+        TLLM_CHECK_WITH_INFO(!mPosShiftEnabled, "KV cache eviction does not support position shift.");
+        // The cached tokens are not in order, so no position dependent bias can be added to their logits.
+        TLLM_CHECK_WITH_INFO(!isALiBi() && !isRelativePosition(), "KV cache eviction needs no attention bias.");
+        TLLM_CHECK_WITH_INFO(!mIsMedusaEnabled, "Medusa does not support KV cache eviction.");
+        TLLM_CHECK_WITH_INFO(
+            !mKVCacheQuantMode.hasKvCacheDynamicScales(), "KV cache eviction does not support dynamic KV cache scales.");
+    }
 }
 
 const int GPTAttentionPluginCommon::getHeadSize(bool checkInit) const
@@ -513,6 +573,8 @@ GPTAttentionPluginCommon::GPTAttentionPluginCommon(const void* data, size_t leng
     read(d, mPagedContextFMHA);
     read(d, mUseKVCache);
     read(d, mIsMedusaEnabled);
+    read(d, mKVCacheLayout);
+    read(d, mKVCacheEvictionRecentWindow);
 
     mKVCacheQuantMode = tc::QuantMode(kvCacheQuantMode);
 
@@ -523,6 +585,9 @@ GPTAttentionPluginCommon::GPTAttentionPluginCommon(const void* data, size_t leng
         (int) length, (int) (d - a));
     TLLM_CHECK_WITH_INFO((mSM >= 80) || (mType != nvinfer1::DataType::kBF16),
         "Unsupported data type, pre SM 80 GPUs do not support bfloat16");
+    // The context phase can write the INT4 cache, but neither MMHA nor the XQA cubins can read it.
+    TLLM_CHECK_WITH_INFO(!mKVCacheQuantMode.hasInt4KvCache(),
+        "The INT4 KV cache is not supported by the generation attention kernels, use INT8 or FP8 instead.");
 }
 
 size_t GPTAttentionPluginCommon::getWorkspaceSizeForContext(nvinfer1::DataType type, int32_t nbReq,
@@ -563,8 +628,20 @@ size_t GPTAttentionPluginCommon::getWorkspaceSizeForContext(nvinfer1::DataType t
     const size_t paged_kv_tma_desc_size = mPagedKVCache && mPagedContextFMHA
         ? batch_size * 2 * TMA_DESC_SIZE_IN_BYTE * tc::divUp(max_attention_window, mTokensPerBlock)
         : 0;
+    // The paged kv context FMHA reads 8bits kv caches from a dequantized copy of the context blocks.
+    const bool dequant_paged_kv_cache = chunked_context_support && mKVCacheQuantMode.hasKvCacheQuant();
+    const size_t dequant_kv_block_ptrs_size = dequant_paged_kv_cache
+        ? sizeof(int64_t) * batch_size * 2 * tc::divUp(max_attention_window, mTokensPerBlock)
+        : 0;
+    const size_t dequant_kv_cache_size = dequant_paged_kv_cache
+        ? size * batch_size * 2 * tc::divUp(max_attention_window, mTokensPerBlock) * mTokensPerBlock
+            * local_hidden_units_kv
+        : 0;
+    // The amax of K and V per sequence and kv head, reduced before the dynamic scales are derived from it.
+    const size_t kv_dynamic_amax_size
+        = mKVCacheQuantMode.hasKvCacheDynamicScales() ? sizeof(float) * batch_size * mNumKVHeads * 2 : 0;
 
-    const int NUM_BUFFERS = 12;
+    const int NUM_BUFFERS = 15;
     size_t workspaces[NUM_BUFFERS];
     workspaces[0] = CUBLAS_WORKSPACE_SIZE;
     workspaces[1] = attention_mask_size;
@@ -578,6 +655,9 @@ size_t GPTAttentionPluginCommon::getWorkspaceSizeForContext(nvinfer1::DataType t
     workspaces[9] = qk_buf_float_size;
     workspaces[10] = padding_offset_size;
     workspaces[11] = paged_kv_tma_desc_size;
+    workspaces[12] = dequant_kv_block_ptrs_size;
+    workspaces[13] = dequant_kv_cache_size;
+    workspaces[14] = kv_dynamic_amax_size;
     context_workspace_size = tc::calculateTotalWorkspaceSize(workspaces, NUM_BUFFERS);
     return context_workspace_size;
 }
@@ -604,14 +684,16 @@ size_t GPTAttentionPluginCommon::getWorkspaceSizeForGeneration(
     const size_t shift_k_cache_size = (!mPosShiftEnabled || isCrossAttention())
         ? 0
         : size * batch_beam * mNumHeads * mHeadSize * max_attention_window;
+    const size_t kv_eviction_slots_size = mKVCacheEvictionRecentWindow > 0 ? sizeof(int) * batch_beam * mNumKVHeads : 0;
 
-    const int NUM_BUFFERS = 5;
+    const int NUM_BUFFERS = 6;
     size_t workspaces[NUM_BUFFERS];
     workspaces[0] = partial_out_size;
     workspaces[1] = partial_sum_size;
     workspaces[2] = partial_max_size;
     workspaces[3] = block_counter_size;
     workspaces[4] = shift_k_cache_size;
+    workspaces[5] = kv_eviction_slots_size;
     generation_workspace_size = tc::calculateTotalWorkspaceSize(workspaces, NUM_BUFFERS);
 
     size_t mqa_workspace_size = 0;
@@ -637,6 +719,20 @@ int GPTAttentionPluginCommon::getMaxNumSeqLenTile(int batch_beam_size) const
     return 0;
 }
 
+template <typename KVCacheBuffer>
+void GPTAttentionPluginCommon::initKVCacheEviction(KVCacheBuffer const& kv_cache_buffer, const int* kv_seq_lengths,
+    int batch_size, int elem_size, cudaStream_t stream) const
+{
+    if constexpr (std::is_same_v<KVCacheBuffer, KVBlockArray>)
+    {
+        if (mKVCacheEvictionRecentWindow > 0)
+        {
+            invokeInitKVCacheEviction(
+                kv_cache_buffer, kv_seq_lengths, batch_size, mNumKVHeads, getHeadSize(), elem_size, stream);
+        }
+    }
+}
+
 template <typename T, typename KVCacheBuffer>
 int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCacheBuffer>& params, cudaStream_t stream)
 {
@@ -657,7 +753,8 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
     {
         using BufferDataType = typename KVCacheBufferDataType<KVCacheBuffer>::Type;
         kv_cache_buffer = KVCacheBuffer(params.batch_size, params.max_blocks_per_sequence, mTokensPerBlock,
-            num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length, false);
+            num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length, false,
+            mKVCacheLayout);
         kv_cache_buffer.data = reinterpret_cast<BufferDataType*>(params.block_pointers);
         host_kv_cache_block_ptrs = reinterpret_cast<int64_t*>(params.host_block_pointers);
     }
@@ -666,7 +763,8 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
         using BufferDataType = typename KVCacheBufferDataType<KVCacheBuffer>::Type;
         kv_cache_buffer = KVCacheBuffer(params.batch_size, 1,
             isCrossAttention() ? params.cross_qkv_length : params.max_attention_window,
-            num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length, false);
+            num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length, false,
+            mKVCacheLayout);
         kv_cache_buffer.data = reinterpret_cast<BufferDataType*>(params.key_value_cache);
     }
 
@@ -730,6 +828,15 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
     const size_t paged_kv_tma_desc_size = mPagedKVCache && mPagedContextFMHA
         ? params.batch_size * 2 * TMA_DESC_SIZE_IN_BYTE * params.max_blocks_per_sequence
         : 0;
+    const bool dequant_paged_kv_cache
+        = mEnableContextFMHA && mPagedKVCache && mPagedContextFMHA && mKVCacheQuantMode.hasKvCacheQuant();
+    const size_t dequant_kv_block_ptrs_size
+        = dequant_paged_kv_cache ? sizeof(int64_t) * params.batch_size * 2 * params.max_blocks_per_sequence : 0;
+    const size_t dequant_kv_cache_size = dequant_paged_kv_cache
+        ? sizeof(T) * params.batch_size * 2 * params.max_blocks_per_sequence * mTokensPerBlock * local_hidden_units_kv
+        : 0;
+    const bool kv_dynamic_scales = mKVCacheQuantMode.hasKvCacheDynamicScales();
+    const size_t kv_dynamic_amax_size = kv_dynamic_scales ? sizeof(float) * params.batch_size * mNumKVHeads * 2 : 0;
 
     const bool is_qk_buf_float_ = true;
 
@@ -749,6 +856,11 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
     int* padding_offset = reinterpret_cast<int*>(nextWorkspacePtr(workspace_byte_ptr, offset, padding_offset_size));
     void* paged_kv_tma_desc
         = reinterpret_cast<int*>(nextWorkspacePtr(workspace_byte_ptr, offset, paged_kv_tma_desc_size));
+    int64_t* dequant_kv_block_ptrs
+        = reinterpret_cast<int64_t*>(nextWorkspacePtr(workspace_byte_ptr, offset, dequant_kv_block_ptrs_size));
+    T* dequant_kv_cache = reinterpret_cast<T*>(nextWorkspacePtr(workspace_byte_ptr, offset, dequant_kv_cache_size));
+    float* kv_dynamic_amax
+        = reinterpret_cast<float*>(nextWorkspacePtr(workspace_byte_ptr, offset, kv_dynamic_amax_size));
 
     // build attention_mask, cu_seqlens, and padding_offset tensors
     // Note: self attn and cross attn should use different params
@@ -800,8 +912,8 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
     }
 
     // write KV to cache
-    const KvCacheDataType cache_type = mKVCacheQuantMode.hasInt8KvCache()
-        ? KvCacheDataType::INT8
+    const KvCacheDataType cache_type = mKVCacheQuantMode.hasInt4KvCache() ? KvCacheDataType::INT4
+        : mKVCacheQuantMode.hasInt8KvCache()                             ? KvCacheDataType::INT8
         : (mKVCacheQuantMode.hasFp8KvCache() ? KvCacheDataType::FP8 : KvCacheDataType::BASE);
 
     const cudaDataType_t gemm_data_type = tc::CudaDataType<T>::value;
@@ -823,17 +935,16 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
     if (mEnableContextFMHA)
     {
         const bool enablePagedKVContextFMHA = mPagedKVCache && mPagedContextFMHA;
-        // Paged Context FMHA doesn't work with fp8/int8 kv cache currently.
-        TLLM_CHECK_WITH_INFO(cache_type == KvCacheDataType::BASE || !enablePagedKVContextFMHA,
-            "Paged Context FMHA doesn't work with fp8/int8 kv cache currently.");
         invokeApplyBiasRopeUpdateKVCache(const_cast<T*>(params.attention_input), q_buf_2_, kv_cache_buffer,
             const_cast<T*>(params.qkv_bias), params.q_seq_lengths, params.kv_seq_lengths,
             mRemovePadding ? padding_offset : nullptr, params.batch_size, params.input_seq_length,
             params.cyclic_attention_window_size, params.sink_token_length, params.num_tokens, mNumHeads, mNumKVHeads,
             getHeadSize(), mRotaryEmbeddingDim, mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale,
             mRotaryEmbeddingMaxPositions, position_embedding_type, (int*) nullptr, mPosShiftEnabled, (float*) nullptr,
-            0, cache_type, params.kv_scale_orig_quant, enablePagedKVContextFMHA, 1, mLaunchGridBlockCache, stream);
+            0, cache_type, params.kv_scale_orig_quant, enablePagedKVContextFMHA, 1, mLaunchGridBlockCache, stream,
+            getRotaryCosSin(params.max_past_kv_len + params.input_seq_length), kv_dynamic_amax);
         sync_check_cuda_error();
+        initKVCacheEviction(kv_cache_buffer, params.kv_seq_lengths, params.batch_size, elem_size, stream);
 
         // It is not needed with packed QKV input.
         if (enablePagedKVContextFMHA)
@@ -855,12 +966,40 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
             {
                 TLLM_LOG_ERROR("Cannot support StreamingLLM now when enabling paged KV context FMHA.");
             }
+            // The FMHA kernels read the kv cache in T. With fp8/int8 kv cache, the blocks of the context sequences
+            // are dequantized to a workspace copy that follows the same block layout.
+            KVBlockArray fmha_kv_cache_buffer = reinterpret_cast<KVBlockArray&>(kv_cache_buffer);
+            std::vector<int64_t> host_dequant_kv_block_ptrs;
+            if (dequant_paged_kv_cache)
+            {
+                const size_t block_size = sizeof(T) * mTokensPerBlock * local_hidden_units_kv;
+                host_dequant_kv_block_ptrs.resize(params.batch_size * 2 * params.max_blocks_per_sequence);
+                for (size_t block_idx = 0; block_idx < host_dequant_kv_block_ptrs.size(); ++block_idx)
+                {
+                    auto* block_ptr = reinterpret_cast<int8_t*>(dequant_kv_cache) + block_idx * block_size;
+                    host_dequant_kv_block_ptrs[block_idx] = reinterpret_cast<int64_t>(block_ptr);
+                }
+                cudaMemcpyAsync(dequant_kv_block_ptrs, host_dequant_kv_block_ptrs.data(), dequant_kv_block_ptrs_size,
+                    cudaMemcpyHostToDevice, stream);
+
+                fmha_kv_cache_buffer = KVBlockArray(params.batch_size, params.max_blocks_per_sequence, mTokensPerBlock,
+                    local_hidden_units_kv * sizeof(T), params.cyclic_attention_window_size, params.sink_token_length,
+                    false);
+                fmha_kv_cache_buffer.data = dequant_kv_block_ptrs;
+                host_kv_cache_block_ptrs = host_dequant_kv_block_ptrs.data();
+
+                using DataType = typename SATypeConverter<T>::Type;
+                invokeDequantizeKVBlockArray<DataType>(reinterpret_cast<KVBlockArray&>(kv_cache_buffer),
+                    fmha_kv_cache_buffer, cache_type, params.kv_seq_lengths, params.batch_size, mNumKVHeads,
+                    getHeadSize(), params.kv_scale_quant_orig, kv_dynamic_scales, stream);
+                sync_check_cuda_error();
+            }
+
             mFMHARunner->setup_paged_kv(params.batch_size, params.input_seq_length, params.max_past_kv_len,
                 params.max_blocks_per_sequence, mTokensPerBlock, params.cyclic_attention_window_size, params.num_tokens,
                 isALiBi(), isAliBiWithScale(), mTpSize, mTpRank);
-            mFMHARunner->run_paged_kv(q_buf_2_, paged_kv_tma_desc, host_kv_cache_block_ptrs,
-                reinterpret_cast<KVBlockArray&>(kv_cache_buffer), cu_q_seqlens, cu_kv_seqlens, params.context_buf,
-                stream);
+            mFMHARunner->run_paged_kv(q_buf_2_, paged_kv_tma_desc, host_kv_cache_block_ptrs, fmha_kv_cache_buffer,
+                cu_q_seqlens, cu_kv_seqlens, params.context_buf, stream);
         }
         else
         {
@@ -868,9 +1007,32 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
             // cyclic_attention_window_size);
             const int attention_window_size
                 = mDenseContextFMHA ? params.num_tokens : params.cyclic_attention_window_size;
-            mFMHARunner->setup(params.batch_size, params.input_seq_length, attention_window_size, params.num_tokens,
-                isALiBi(), isAliBiWithScale(), mTpSize, mTpRank);
-            mFMHARunner->run(const_cast<T*>(params.attention_input), cu_q_seqlens, params.context_buf, stream);
+            if (params.sink_token_length > 0 && !mDenseContextFMHA && !isALiBi()
+                && params.input_seq_length > attention_window_size)
+            {
+                // The fused kernels have no attention sinks, attend to the sinks and the window with a dedicated
+                // kernel that only reads the K/V tiles of both.
+                SinkAttentionParams sink_params{};
+                sink_params.qkv = params.attention_input;
+                sink_params.output = params.context_buf;
+                sink_params.cuSeqLens = cu_q_seqlens;
+                sink_params.paddedSeqLen = mRemovePadding ? 0 : params.input_seq_length;
+                sink_params.batchSize = params.batch_size;
+                sink_params.maxSeqLen = params.input_seq_length;
+                sink_params.numQHeads = mNumHeads;
+                sink_params.numKVHeads = mNumKVHeads;
+                sink_params.headSize = getHeadSize();
+                sink_params.windowSize = attention_window_size;
+                sink_params.sinkTokenLength = params.sink_token_length;
+                sink_params.softmaxScale = 1.f / (sqrtf(getHeadSize() * 1.0f) * mQScaling);
+                invokeSinkAttention<T>(sink_params, stream);
+            }
+            else
+            {
+                mFMHARunner->setup(params.batch_size, params.input_seq_length, attention_window_size,
+                    params.num_tokens, isALiBi(), isAliBiWithScale(), mTpSize, mTpRank);
+                mFMHARunner->run(const_cast<T*>(params.attention_input), cu_q_seqlens, params.context_buf, stream);
+            }
         }
         sync_check_cuda_error();
     }
@@ -891,7 +1053,8 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
                 const_cast<T*>(params.qkv_bias), params.q_seq_lengths, mRemovePadding ? padding_offset : nullptr,
                 params.batch_size, params.input_seq_length, params.num_tokens, mNumHeads, mNumKVHeads, getHeadSize(),
                 mRotaryEmbeddingDim, mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale,
-                mRotaryEmbeddingMaxPositions, position_embedding_type, (float*) nullptr, 0, stream);
+                mRotaryEmbeddingMaxPositions, position_embedding_type, (float*) nullptr, 0, stream,
+                getRotaryCosSin(params.input_seq_length));
         }
         else
         {
@@ -901,13 +1064,14 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
                 const_cast<T*>(params.qkv_bias), params.q_seq_lengths, mRemovePadding ? padding_offset : nullptr,
                 params.batch_size, params.input_seq_length, params.num_tokens, mNumHeads, mNumKVHeads, getHeadSize(),
                 mRotaryEmbeddingDim, mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale,
-                mRotaryEmbeddingMaxPositions, position_embedding_type, (float*) nullptr, 0, stream);
+                mRotaryEmbeddingMaxPositions, position_embedding_type, (float*) nullptr, 0, stream,
+                getRotaryCosSin(params.input_seq_length));
             invokeAddFusedQKVBiasTranspose((T*) nullptr, k_buf_2_, v_buf_2_, const_cast<T*>(params.cross_qkv),
                 const_cast<T*>(params.qkv_bias), params.encoder_input_lengths,
                 mRemovePadding ? padding_offset : nullptr, params.batch_size, params.cross_qkv_length,
                 params.num_encoder_tokens, mNumHeads, mNumKVHeads, getHeadSize(), mRotaryEmbeddingDim,
                 mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale, mRotaryEmbeddingMaxPositions,
-                position_embedding_type, (float*) nullptr, 0, stream);
+                position_embedding_type, (float*) nullptr, 0, stream, getRotaryCosSin(params.cross_qkv_length));
         }
         sync_check_cuda_error();
 
@@ -919,6 +1083,7 @@ int GPTAttentionPluginCommon::enqueueContext(const EnqueueContextParams<T, KVCac
                 isCrossAttention() ? params.cross_qkv_length : params.cyclic_attention_window_size, getHeadSize(),
                 mNumKVHeads, cache_type, params.kv_scale_orig_quant,
                 isCrossAttention() ? params.encoder_input_lengths : params.q_seq_lengths, stream);
+            initKVCacheEviction(kv_cache_buffer, params.kv_seq_lengths, params.batch_size, elem_size, stream);
         }
         sync_check_cuda_error();
 
@@ -1194,7 +1359,7 @@ int GPTAttentionPluginCommon::enqueueGeneration(
             using BufferDataType = typename KVCacheBufferDataType<KVCacheBuffer>::Type;
             kv_cache_buffer = KVCacheBuffer(batch_beam, params.max_blocks_per_sequence, mTokensPerBlock,
                 num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length,
-                false);
+                false, mKVCacheLayout);
             kv_cache_buffer.data = reinterpret_cast<BufferDataType*>(params.block_pointers);
         }
         else
@@ -1202,7 +1367,7 @@ int GPTAttentionPluginCommon::enqueueGeneration(
             using BufferDataType = typename KVCacheBufferDataType<KVCacheBuffer>::Type;
             kv_cache_buffer
                 = KVCacheBuffer(batch_beam, 1, params.max_attention_window, num_kv_heads * head_size * elem_size,
-                    params.cyclic_attention_window_size, params.sink_token_length, false);
+                    params.cyclic_attention_window_size, params.sink_token_length, false, mKVCacheLayout);
             kv_cache_buffer.data = reinterpret_cast<BufferDataType*>(params.key_value_cache);
         }
     }
@@ -1228,6 +1393,62 @@ int GPTAttentionPluginCommon::enqueueGeneration(
         }
     }
 
+    // Then the tensor core kernel for grouped-query attention, when the batch fills the GPU with one block per KV head
+    // of each sequence. MMHA keeps the cases it needs: beam search, attention biases, sinks and position shift.
+    // FP32 has no tensor core path.
+    if constexpr (!std::is_same_v<T, float>)
+    {
+        const int heads_per_kv = num_heads / num_kv_heads;
+        if (!mCrossAttention && params.beam_width == 1 && params.input_seq_length == 1
+            && heads_per_kv >= kGQAGenerationMinHeadsPerKv && !isALiBi() && !isRelativePosition()
+            && params.sink_token_length == 0 && !mPosShiftEnabled && !mKVCacheQuantMode.hasKvCacheDynamicScales()
+            && mKVCacheEvictionRecentWindow == 0
+            && batch_beam * num_kv_heads * tc::divUp(heads_per_kv, 16) >= mMultiProcessorCount
+            && isGQAGenerationAttentionSupported(!std::is_same_v<T, half>, head_size, mSM))
+        {
+            TLLM_LOG_DEBUG("GQA tensor core kernels are selected in the generation phase.");
+            const KvCacheDataType cache_type = mKVCacheQuantMode.hasInt8KvCache()
+                ? KvCacheDataType::INT8
+                : (mKVCacheQuantMode.hasFp8KvCache() ? KvCacheDataType::FP8 : KvCacheDataType::BASE);
+            // Q after bias and RoPE is stored to the output buffer, the kernel overwrites it with the attention output.
+            invokeApplyBiasRopeUpdateKVCache<T, KVCacheBuffer, true>(const_cast<T*>(params.attention_input),
+                params.context_buf, kv_cache_buffer, params.qkv_bias, params.sequence_lengths, nullptr, nullptr,
+                batch_beam, 1, params.cyclic_attention_window_size, 0, batch_beam, num_heads, num_kv_heads, head_size,
+                mRotaryEmbeddingDim, mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale,
+                mRotaryEmbeddingMaxPositions, position_embedding_type, nullptr, false, nullptr, 0, cache_type,
+                params.kv_scale_orig_quant, true, 1, mGenerationLaunchGridBlockCache, stream,
+                getRotaryCosSin(params.past_kv_length + params.input_seq_length));
+            sync_check_cuda_error();
+
+            GQAGenerationAttentionParams gqa_params{};
+            gqa_params.q = params.context_buf;
+            gqa_params.output = params.context_buf;
+            gqa_params.seqLens = params.sequence_lengths;
+            gqa_params.kvScaleQuantOrig = params.kv_scale_quant_orig;
+            gqa_params.batchSize = batch_beam;
+            gqa_params.numQHeads = num_heads;
+            gqa_params.numKVHeads = num_kv_heads;
+            gqa_params.headSize = head_size;
+            gqa_params.cyclicAttentionWindowSize = params.cyclic_attention_window_size;
+            gqa_params.softmaxScale = 1.f / (sqrtf(head_size * 1.0f) * q_scaling);
+            if (cache_type == KvCacheDataType::INT8)
+            {
+                invokeGQAGenerationAttention<T, int8_t>(gqa_params, kv_cache_buffer, stream);
+            }
+#ifdef ENABLE_FP8
+            else if (cache_type == KvCacheDataType::FP8)
+            {
+                invokeGQAGenerationAttention<T, __nv_fp8_e4m3>(gqa_params, kv_cache_buffer, stream);
+            }
+#endif // ENABLE_FP8
+            else
+            {
+                invokeGQAGenerationAttention<T, T>(gqa_params, kv_cache_buffer, stream);
+            }
+            return 0;
+        }
+    }
+
     int timestep = params.past_kv_length;
     const int max_timesteps = mCrossAttention ? params.cyclic_attention_window_size
                                               : std::min(timestep, params.cyclic_attention_window_size);
@@ -1248,8 +1469,9 @@ int GPTAttentionPluginCommon::enqueueGeneration(
     // Runtime check to see the actual number of blocks per sequence we need.
     int32_t const max_num_seq_len_tiles = std::max(getMaxNumSeqLenTile(batch_beam), estimated_min_multi_block_count);
     int32_t const min_num_seq_len_tiles = std::max(1, estimated_min_multi_block_count);
-    const bool enable_multi_block
-        = (mMultiBlockMode && max_num_seq_len_tiles > 1) || estimated_min_multi_block_count > 1;
+    // The attention mass of the cached tokens for KV cache eviction is only accumulated by the single block kernels.
+    const bool enable_multi_block = mKVCacheEvictionRecentWindow == 0
+        && ((mMultiBlockMode && max_num_seq_len_tiles > 1) || estimated_min_multi_block_count > 1);
     const size_t partial_out_size
         = enable_multi_block ? sizeof(T) * batch_beam * mNumHeads * mHeadSize * max_num_seq_len_tiles : 0;
     const size_t partial_sum_size
@@ -1267,18 +1489,33 @@ int GPTAttentionPluginCommon::enqueueGeneration(
     float* partial_max = reinterpret_cast<float*>(nextWorkspacePtr(workspace_byte_ptr, offset, partial_max_size));
     int* block_counter = reinterpret_cast<int*>(nextWorkspacePtr(workspace_byte_ptr, offset, block_counter_size));
     T* shift_k_cache = reinterpret_cast<T*>(nextWorkspacePtr(workspace_byte_ptr, offset, shift_k_cache_size));
+    int* kv_eviction_slots
+        = reinterpret_cast<int*>(nextWorkspacePtr(workspace_byte_ptr, offset, kv_eviction_slots_size));
 
     if (enable_multi_block)
     {
         TLLM_CUDA_CHECK(cudaMemsetAsync(block_counter, 0, block_counter_size, stream));
     }
 
+    // Choose the cache slot of the new token, replacing the least attended token once the attention window is full.
+    if constexpr (std::is_same_v<KVCacheBuffer, KVBlockArray>)
+    {
+        if (mKVCacheEvictionRecentWindow > 0)
+        {
+            TLLM_CHECK_WITH_INFO(params.beam_width == 1 && params.input_seq_length == 1,
+                "KV cache eviction supports neither beam search nor multiple new tokens per step.");
+            invokeSelectKVCacheEvictionSlots(kv_cache_buffer, params.sequence_lengths, batch_beam, num_kv_heads,
+                head_size, elem_size, mKVCacheEvictionRecentWindow, kv_eviction_slots, stream);
+        }
+    }
+
     // Apply position embedding to the keys in the K cache
     KVLinearBuffer shift_k_cache_buffer;
     if (mPosShiftEnabled && !isCrossAttention())
     {
         shift_k_cache_buffer = KVLinearBuffer(batch_beam, 1, params.max_attention_window,
-            num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length, true);
+            num_kv_heads * head_size * elem_size, params.cyclic_attention_window_size, params.sink_token_length, true,
+            mKVCacheLayout);
         shift_k_cache_buffer.data = reinterpret_cast<int8_t*>(shift_k_cache);
         sync_check_cuda_error();
         // KV cache type
@@ -1291,11 +1528,34 @@ int GPTAttentionPluginCommon::enqueueGeneration(
             mRotaryEmbeddingMaxPositions, mPositionEmbeddingType, stream);
     }
 
+    // Optionally do the bias, RoPE, KV quantization and KV cache write of the new token with the same kernel as the
+    // context phase. MMHA then reads the final Q, K and V from the input and does not write the cache. IA3, the INT8
+    // input and position shift are only handled inside MMHA, the preprocessing kernel supports head sizes up to 256.
+    const bool qkv_preprocessed = tc::getEnvFusedQKVPreprocessing() && !mCrossAttention && !mPosShiftEnabled
+        && !mKVCacheQuantMode.hasKvCacheDynamicScales() && mKVCacheEvictionRecentWindow == 0 && ia3_tasks == nullptr
+        && !quant_option.hasStaticActivationScaling() && params.input_seq_length == 1 && head_size <= 256;
+    if (qkv_preprocessed)
+    {
+        const KvCacheDataType cache_type = mKVCacheQuantMode.hasInt8KvCache()
+            ? KvCacheDataType::INT8
+            : (mKVCacheQuantMode.hasFp8KvCache() ? KvCacheDataType::FP8 : KvCacheDataType::BASE);
+        invokeApplyBiasRopeUpdateKVCache<T, KVCacheBuffer, true>(const_cast<T*>(params.attention_input), nullptr,
+            kv_cache_buffer, params.qkv_bias, params.sequence_lengths, nullptr, nullptr, batch_beam, 1,
+            params.cyclic_attention_window_size, params.sink_token_length, batch_beam, num_heads, num_kv_heads,
+            head_size, mRotaryEmbeddingDim, mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale,
+            mRotaryEmbeddingMaxPositions, position_embedding_type, nullptr, false, nullptr, 0, cache_type,
+            params.kv_scale_orig_quant, false, params.beam_width, mGenerationLaunchGridBlockCache, stream,
+            getRotaryCosSin(params.past_kv_length + params.input_seq_length));
+        sync_check_cuda_error();
+    }
+
     FusedQKVMaskedAttentionDispatchParams<T, KVCacheBuffer> dispatch_params;
     memset(&dispatch_params, 0, sizeof(dispatch_params));
     dispatch_params.mUnfuseQkvGemm = mUnfuseQkvGemm;
     dispatch_params.qkv_buf = params.attention_input;
-    dispatch_params.qkv_bias = params.qkv_bias;
+    // The preprocessing wrote the biased values back to the input.
+    dispatch_params.qkv_bias = qkv_preprocessed ? nullptr : params.qkv_bias;
+    dispatch_params.qkv_preprocessed = qkv_preprocessed;
     dispatch_params.relative_attention_bias = relative_attention_bias;
     dispatch_params.relative_attention_bias_stride = relative_attention_bias_stride;
     dispatch_params.max_distance = max_distance;
@@ -1333,15 +1593,18 @@ int GPTAttentionPluginCommon::enqueueGeneration(
     dispatch_params.partial_max = partial_max;
     dispatch_params.block_counter = block_counter;
     dispatch_params.kv_cache_quant_mode = mKVCacheQuantMode;
+    dispatch_params.kv_eviction_write_slots = mKVCacheEvictionRecentWindow > 0 ? kv_eviction_slots : nullptr;
     dispatch_params.kv_scale_orig_quant = params.kv_scale_orig_quant;
     dispatch_params.kv_scale_quant_orig = params.kv_scale_quant_orig;
     dispatch_params.kv_block_array = kv_cache_buffer;
     dispatch_params.shift_k_cache_buffer = shift_k_cache_buffer;
     dispatch_params.multi_processor_count = mMultiProcessorCount;
+    dispatch_params.sm_version = mSM;
     dispatch_params.rotary_embedding_base = mRotaryEmbeddingBase;
     dispatch_params.rotary_embedding_scale_type = mRotaryEmbeddingScaleType;
     dispatch_params.rotary_embedding_scale = mRotaryEmbeddingScale;
     dispatch_params.rotary_embedding_max_positions = mRotaryEmbeddingMaxPositions;
+    dispatch_params.rotary_embedding_cos_sin = getRotaryCosSin(params.past_kv_length + params.input_seq_length);
     dispatch_params.position_shift_enabled = mPosShiftEnabled;
     dispatch_params.cross_attention = mCrossAttention;
     dispatch_params.memory_length_per_sample = params.encoder_input_lengths;
@@ -1430,6 +1693,25 @@ int GPTAttentionPluginCommon::initialize() noexcept
     getEnvMmhaBlocksPerSequence();
 
     mCublasWrapper.reset(new tc::CublasMMWrapper(cublasHandle, cublasLtHandle, nullptr, nullptr));
+
+    if (isRoPE() && mRotaryEmbeddingScaleType != RotaryScalingType::kDYNAMIC)
+    {
+        RotaryCosSinCacheParams rotaryParams;
+        rotaryParams.rotaryEmbeddingDim = mRotaryEmbeddingDim;
+        rotaryParams.rotaryEmbeddingBase = mRotaryEmbeddingBase;
+        rotaryParams.scaleType = mRotaryEmbeddingScaleType;
+        rotaryParams.scale = mRotaryEmbeddingScale;
+        // For YaRN, rotary_embedding_max_positions is the original context and the model extends it by the scale.
+        mRotaryCosSinPositions = std::max(mRotaryEmbeddingMaxPositions, mMaxContextLength);
+        if (mRotaryEmbeddingScaleType == RotaryScalingType::kYARN)
+        {
+            rotaryParams.originalMaxPositions = mRotaryEmbeddingMaxPositions;
+            mRotaryCosSinPositions = std::max(mRotaryCosSinPositions,
+                static_cast<int32_t>(std::ceil(mRotaryEmbeddingMaxPositions * mRotaryEmbeddingScale)));
+        }
+        mRotaryCosSin = getRotaryCosSinCache(rotaryParams, mRotaryCosSinPositions);
+    }
+
     if (mEnableContextFMHA)
     {
         // Pre-checked during constructing.
@@ -1453,8 +1735,11 @@ int GPTAttentionPluginCommon::initialize() noexcept
         mFMHARunner->setup_flags(mFMHAForceFP32Acc, !mRemovePadding, true, mNumKVHeads);
     }
 
+    // The XQA cubins read the linear K cache layout with one static scale and write the cache in order.
     bool useXQAKernels = (mEnableXQA || mIsMedusaEnabled) && !mCrossAttention
-        && (mType == nvinfer1::DataType::kHALF || mType == nvinfer1::DataType::kBF16);
+        && (mType == nvinfer1::DataType::kHALF || mType == nvinfer1::DataType::kBF16)
+        && mKVCacheLayout == KVCacheLayout::kLINEAR && !mKVCacheQuantMode.hasKvCacheDynamicScales()
+        && mKVCacheEvictionRecentWindow == 0;
 
     if (useXQAKernels)
     {
@@ -1505,7 +1790,8 @@ size_t GPTAttentionPluginCommon::getCommonSerializationSize() noexcept
         + sizeof(mRemovePadding) + sizeof(mMaskType) + sizeof(mPagedKVCache) + sizeof(mTokensPerBlock) + sizeof(mType)
         + sizeof(mMaxContextLength) + sizeof(mQKVBiasEnabled) + sizeof(mCrossAttention) + sizeof(mMaxDistance)
         + sizeof(mPosShiftEnabled) + sizeof(mDenseContextFMHA) + sizeof(mPagedContextFMHA) + sizeof(mUseKVCache)
-        + sizeof(mUnfuseQkvGemm) + sizeof(mIsMedusaEnabled);
+        + sizeof(mUnfuseQkvGemm) + sizeof(mIsMedusaEnabled) + sizeof(mKVCacheLayout)
+        + sizeof(mKVCacheEvictionRecentWindow);
 }
 
 void GPTAttentionPluginCommon::serializeCommon(void* buffer) const noexcept
@@ -1545,6 +1831,8 @@ void GPTAttentionPluginCommon::serializeCommon(void* buffer) const noexcept
     write(d, mPagedContextFMHA);
     write(d, mUseKVCache);
     write(d, mIsMedusaEnabled);
+    write(d, mKVCacheLayout);
+    write(d, mKVCacheEvictionRecentWindow);
     assert(d == a + getCommonSerializationSize());
 }
 
@@ -1591,6 +1879,8 @@ GPTAttentionPluginCreatorCommon::GPTAttentionPluginCreatorCommon()
     mPluginAttributes.emplace_back(PluginField("use_paged_context_fmha", nullptr, PluginFieldType::kINT8, 0));
     mPluginAttributes.emplace_back(PluginField("use_cache", nullptr, PluginFieldType::kINT32, 0));
     mPluginAttributes.emplace_back(PluginField("is_medusa_enabled", nullptr, PluginFieldType::kINT8, 0));
+    mPluginAttributes.emplace_back(PluginField("kv_cache_layout", nullptr, PluginFieldType::kINT8, 0));
+    mPluginAttributes.emplace_back(PluginField("kv_cache_eviction_recent_window", nullptr, PluginFieldType::kINT32, 0));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
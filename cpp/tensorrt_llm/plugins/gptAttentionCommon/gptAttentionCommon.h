@@ -47,7 +47,9 @@ public:
         bool paged_kv_cache, int tokens_per_block, nvinfer1::DataType type, int32_t max_context_length,
         bool qkv_bias_enabled, bool cross_attention = false, int max_distance = 0, bool pos_shift_enabled = false,
         bool dense_context_fmha = false, bool use_paged_context_fmha = false, bool use_cache = true,
-        bool is_medusa_enabled = false);
+        bool is_medusa_enabled = false,
+        tensorrt_llm::kernels::KVCacheLayout kv_cache_layout = tensorrt_llm::kernels::KVCacheLayout::kLINEAR,
+        int kv_cache_eviction_recent_window = 0);
 
     GPTAttentionPluginCommon(const void* data, size_t length);
 
@@ -176,6 +178,11 @@ protected:
     bool convertMMHAParamsToXQAParams(tensorrt_llm::kernels::XQAParams& xqaParams,
         const EnqueueGenerationParams<T, KVCacheBuffer>& generationsParams, bool forConfigurePlugin);
 
+    // Resets the eviction metadata of the slots written by the context phase, no-op without KV cache eviction.
+    template <typename KVCacheBuffer>
+    void initKVCacheEviction(KVCacheBuffer const& kv_cache_buffer, const int* kv_seq_lengths, int batch_size,
+        int elem_size, cudaStream_t stream) const;
+
     bool isRelativePosition() const
     {
         return mPositionEmbeddingType == tensorrt_llm::kernels::PositionEmbeddingType::kRELATIVE;
@@ -211,6 +218,12 @@ protected:
 protected:
     static constexpr int kReservedMaxSeqLenTilePerSeq = 64;
 
+    // The shared rotary cos/sin table when it covers numPositions, nullptr to compute the coefficients on the fly.
+    float2 const* getRotaryCosSin(int32_t numPositions) const
+    {
+        return numPositions <= mRotaryCosSinPositions ? mRotaryCosSin : nullptr;
+    }
+
     const std::string mLayerName;
 
     int mLayerIdx;
@@ -243,6 +256,11 @@ protected:
     bool mPagedContextFMHA = false;
     bool mDenseContextFMHA = false;
     bool mIsMedusaEnabled = false;
+    // Layout of the K cache blocks, fixed when the engine is built.
+    tensorrt_llm::kernels::KVCacheLayout mKVCacheLayout = tensorrt_llm::kernels::KVCacheLayout::kLINEAR;
+    // Attention-guided eviction of the KV cache tokens when positive, the number of most recent tokens that are never
+    // evicted. See kvCacheEvictionKernels.h.
+    int mKVCacheEvictionRecentWindow = 0;
 
     // Medusa packed mask.
     uint4* mMedusaPackedMask;
@@ -261,6 +279,11 @@ protected:
     // Cache the grid_size and block_size that gives the highest occupancy for
     //  invokeApplyBiasRopeUpdateKVCache.
     int2 mLaunchGridBlockCache = make_int2(0, 0);
+    // Same for the generation steps that use the GQA tensor core kernels.
+    int2 mGenerationLaunchGridBlockCache = make_int2(0, 0);
+    // Precomputed rotary cos/sin table shared by all the layers, set by initialize() unless the scaling is dynamic.
+    float2 const* mRotaryCosSin = nullptr;
+    int32_t mRotaryCosSinPositions = 0;
 
     bool mMultiBlockMode;
     bool mEnableXQA;
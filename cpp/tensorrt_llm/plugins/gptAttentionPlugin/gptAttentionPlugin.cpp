@@ -47,13 +47,15 @@ GPTAttentionPlugin::GPTAttentionPlugin(int layer_idx, int num_heads, int num_kv_
     int kv_cache_quant_mode, bool remove_input_padding, tensorrt_llm::kernels::AttentionMaskType mask_type,
     bool paged_kv_cache, int tokens_per_block, nvinfer1::DataType type, int32_t max_context_length,
     bool qkv_bias_enabled, bool cross_attention, int max_distance, bool pos_shift_enabled, bool dense_context_fmha,
-    bool use_paged_context_fmha, bool use_cache, bool is_medusa_enabled)
+    bool use_paged_context_fmha, bool use_cache, bool is_medusa_enabled,
+    tensorrt_llm::kernels::KVCacheLayout kv_cache_layout, int kv_cache_eviction_recent_window)
     : GPTAttentionPluginCommon(layer_idx, num_heads, num_kv_heads, head_size, unidirectional, q_scaling,
         position_embedding_type, rotary_embedding_dim, rotary_embedding_base, rotary_embedding_scale_type,
         rotary_embedding_scale, rotary_embedding_max_positions, tp_size, tp_rank, unfuse_qkv_gemm, context_fmha_type,
         multi_block_mode, enable_xqa, kv_cache_quant_mode, remove_input_padding, mask_type, paged_kv_cache,
         tokens_per_block, type, max_context_length, qkv_bias_enabled, cross_attention, max_distance, pos_shift_enabled,
-        dense_context_fmha, use_paged_context_fmha, use_cache, is_medusa_enabled)
+        dense_context_fmha, use_paged_context_fmha, use_cache, is_medusa_enabled, kv_cache_layout,
+        kv_cache_eviction_recent_window)
 {
     initEntryIdx();
 }
@@ -795,7 +797,9 @@ IPluginV2* GPTAttentionPluginCreator::createPlugin(const char* name, const Plugi
             static_cast<bool>(p.getScalar<int8_t>("dense_context_fmha").value()),
             static_cast<bool>(p.getScalar<int8_t>("use_paged_context_fmha").value()),
             static_cast<bool>(p.getScalar<int32_t>("use_cache").value()),
-            static_cast<bool>(p.getScalar<int8_t>("is_medusa_enabled").value()));
+            static_cast<bool>(p.getScalar<int8_t>("is_medusa_enabled").value()),
+            static_cast<KVCacheLayout>(p.getScalar<int8_t>("kv_cache_layout").value()),
+            p.getScalar<int32_t>("kv_cache_eviction_recent_window").value());
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
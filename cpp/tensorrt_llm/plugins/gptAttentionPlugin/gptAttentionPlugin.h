@@ -81,7 +81,9 @@ public:
         bool paged_kv_cache, int tokens_per_block, nvinfer1::DataType type, int32_t max_context_length,
         bool qkv_bias_enabled, bool cross_attention = false, int max_distance = 0, bool pos_shift_enabled = false,
         bool dense_context_fmha = false, bool use_paged_context_fmha = false, bool use_cache = true,
-        bool is_medusa_enabled = false);
+        bool is_medusa_enabled = false,
+        tensorrt_llm::kernels::KVCacheLayout kv_cache_layout = tensorrt_llm::kernels::KVCacheLayout::kLINEAR,
+        int kv_cache_eviction_recent_window = 0);
 
     GPTAttentionPlugin(const void* data, size_t length);
 
@@ -18,6 +18,7 @@
 #include <cstdio>
 
 #include "lookupPlugin.h"
+#include "tensorrt_llm/common/customAllReduceUtils.h"
 #include "tensorrt_llm/kernels/lookupKernels.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
 
@@ -32,9 +33,10 @@ static const char* LOOKUP_PLUGIN_NAME{"Lookup"};
 PluginFieldCollection LookupPluginCreator::mFC{};
 std::vector<nvinfer1::PluginField> LookupPluginCreator::mPluginAttributes;
 
-LookupPlugin::LookupPlugin(nvinfer1::DataType type, int rank)
+LookupPlugin::LookupPlugin(nvinfer1::DataType type, int rank, int counter)
     : mType(type)
     , mRank(rank)
+    , mCounter(counter)
 {
 }
 
@@ -44,6 +46,7 @@ LookupPlugin::LookupPlugin(const void* data, size_t length)
     const char *d = reinterpret_cast<const char*>(data), *a = d;
     read(d, mType);
     read(d, mRank);
+    read(d, mCounter);
     TLLM_CHECK_WITH_INFO(d == a + length,
         "Expected length (%d) != real length (%d). This is often "
         "caused by using different TensorRT-LLM version to build "
@@ -65,7 +68,7 @@ nvinfer1::DimsExprs LookupPlugin::getOutputDimensions(
 {
     try
     {
-        TLLM_CHECK(nbInputs == 2);
+        TLLM_CHECK(nbInputs == (isAllGatherFused() ? 3 : 2));
         TLLM_CHECK(outputIndex == 0);
         DimsExprs ret;
         const int nbDimsInput = inputs[0].nbDims;
@@ -95,7 +98,11 @@ bool LookupPlugin::supportsFormatCombination(
     {
     case 0: res = ((inOut[0].type == DataType::kINT32) && (inOut[0].format == TensorFormat::kLINEAR)); break;
     case 1: res = ((inOut[1].type == mType) && (inOut[1].format == TensorFormat::kLINEAR)); break;
-    case 2: res = ((inOut[2].type == mType) && (inOut[2].format == TensorFormat::kLINEAR)); break;
+    case 2:
+        res = ((inOut[2].type == (isAllGatherFused() ? DataType::kINT64 : mType))
+            && (inOut[2].format == TensorFormat::kLINEAR));
+        break;
+    case 3: res = ((inOut[3].type == mType) && (inOut[3].format == TensorFormat::kLINEAR)); break;
     default: // should NOT be here!
         res = false;
     }
@@ -133,6 +140,41 @@ int LookupPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc, const nvi
     const int hidden = inputDesc[1].dims.d[inputDesc[1].dims.nbDims - 1];
     const int* input = reinterpret_cast<const int*>(inputs[0]);
 
+    if (isAllGatherFused())
+    {
+        //     workspace [ranksPerNode * NUM_POINTERS_PER_RANK], the buffers and barriers of the custom all-reduce
+        if (tensorrt_llm::plugins::isBuilding())
+        {
+            return 0;
+        }
+        namespace carUtils = tensorrt_llm::utils::customAllReduceUtils;
+        const int ranksPerNode = inputDesc[2].dims.d[0] / carUtils::NUM_POINTERS_PER_RANK;
+        TLLM_CHECK_WITH_INFO(
+            mRank < ranksPerNode, "The fused lookup needs the vocabulary split on the ranks of a node");
+        auto params = AllReduceParams::deserialize(
+            reinterpret_cast<const int32_t*>(inputs[2]), ranksPerNode, mRank, static_cast<uint32_t>(mCounter));
+        const auto maxChunkBytes = carUtils::getMaxRequiredWorkspaceSize(ranksPerNode);
+        if (mType == DataType::kHALF)
+        {
+            invokeLookUpAllGather<half>(reinterpret_cast<half*>(outputs[0]), input,
+                reinterpret_cast<const half*>(inputs[1]), batchSize, localVocabSize, hidden, params, maxChunkBytes,
+                stream);
+        }
+        else if (mType == DataType::kFLOAT)
+        {
+            invokeLookUpAllGather<float>(reinterpret_cast<float*>(outputs[0]), input,
+                reinterpret_cast<const float*>(inputs[1]), batchSize, localVocabSize, hidden, params, maxChunkBytes,
+                stream);
+        }
+        else if (mType == DataType::kBF16)
+        {
+            invokeLookUpAllGather<__nv_bfloat16>(reinterpret_cast<__nv_bfloat16*>(outputs[0]), input,
+                reinterpret_cast<const __nv_bfloat16*>(inputs[1]), batchSize, localVocabSize, hidden, params,
+                maxChunkBytes, stream);
+        }
+        return 0;
+    }
+
     int offset = mRank * localVocabSize;
 
     if (mType == DataType::kHALF)
@@ -194,7 +236,7 @@ void LookupPlugin::destroy() noexcept
 
 size_t LookupPlugin::getSerializationSize() const noexcept
 {
-    return sizeof(mType) + sizeof(mRank);
+    return sizeof(mType) + sizeof(mRank) + sizeof(mCounter);
 }
 
 void LookupPlugin::serialize(void* buffer) const noexcept
@@ -202,6 +244,7 @@ void LookupPlugin::serialize(void* buffer) const noexcept
     char *d = static_cast<char*>(buffer), *a = d;
     write(d, mType);
     write(d, mRank);
+    write(d, mCounter);
 
     assert(d == a + getSerializationSize());
 }
@@ -216,6 +259,7 @@ LookupPluginCreator::LookupPluginCreator()
     mPluginAttributes.clear();
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("rank", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("counter", nullptr, PluginFieldType::kINT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -240,6 +284,7 @@ IPluginV2* LookupPluginCreator::createPlugin(const char* name, const PluginField
     const PluginField* fields = fc->fields;
     nvinfer1::DataType type;
     int rank;
+    int counter = -1;
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
     {
@@ -254,10 +299,15 @@ IPluginV2* LookupPluginCreator::createPlugin(const char* name, const PluginField
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
             rank = static_cast<int>(*(static_cast<const int*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "counter"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            counter = static_cast<int>(*(static_cast<const int*>(fields[i].data)));
+        }
     }
     try
     {
-        auto* obj = new LookupPlugin(type, rank);
+        auto* obj = new LookupPlugin(type, rank, counter);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
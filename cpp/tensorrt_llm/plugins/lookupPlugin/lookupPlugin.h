@@ -30,7 +30,9 @@ class LookupPlugin : public BasePlugin
 public:
     LookupPlugin() = delete;
 
-    LookupPlugin(nvinfer1::DataType type, int rank);
+    // With counter >= 0, the plugin takes the custom all-reduce workspace as third input and outputs the embeddings of
+    // the whole vocabulary, gathered from the ranks of the node, instead of those of its shard.
+    LookupPlugin(nvinfer1::DataType type, int rank, int counter = -1);
 
     LookupPlugin(const void* data, size_t length);
 
@@ -66,8 +68,15 @@ public:
 private:
     const std::string mLayerName;
 
+    bool isAllGatherFused() const
+    {
+        return mCounter >= 0;
+    }
+
     nvinfer1::DataType mType;
     int mRank;
+    // Counter of the layer among the users of the all-reduce workspace, -1 without the fused all-gather
+    int mCounter;
 };
 
 class LookupPluginCreator : public BaseCreator
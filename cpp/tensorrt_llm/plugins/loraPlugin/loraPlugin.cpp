@@ -17,7 +17,9 @@
 #include "loraPlugin.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/common/workspace.h"
 #include "tensorrt_llm/kernels/groupGemm.h"
+#include "tensorrt_llm/kernels/segmentedLoraKernels.h"
 #include "tensorrt_llm/kernels/splitkGroupGemm.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 
@@ -328,6 +330,16 @@ int64_t getGemmWorkSpaceSize(
         getSplitkGroupedGemmWorkSpaceSize(nbReq, maxContextLength, maxLoraModuleNum, maxLowRank, splitKSlices));
 }
 
+// Device copies of the per request descriptors of the segmented kernels:
+// [weights pointers (int64) of all modules, ranks of all modules, request token offsets, token adapter indices]
+int64_t getSegmentedLoraWorkSpaceSize(int64_t nbReq, int64_t maxContextLength, int64_t maxLoraModuleNum)
+{
+    // The region follows the grouped GEMM params, whose size is not aligned
+    return kCudaMemAlign + divUp(maxLoraModuleNum * nbReq * 2 * sizeof(int64_t), 16) * 16
+        + divUp(maxLoraModuleNum * nbReq * sizeof(int32_t), 16) * 16 + divUp((nbReq + 1) * sizeof(int32_t), 16) * 16
+        + divUp(nbReq * maxContextLength * sizeof(int32_t), 16) * 16;
+}
+
 size_t LoraPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
     const nvinfer1::PluginTensorDesc* outputs, int nbOutputs) const noexcept
 {
@@ -338,7 +350,77 @@ size_t LoraPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, in
 
     return (size_t) getGemmWorkSpaceSize(nbReq, mMaxContextLength, mNumLoraModules, mMaxLowRank, mSplitKSlices)
         + getLowRankWorkSpaceSize(nbReq, mMaxContextLength, mNumLoraModules, mMaxLowRank, typeSize)
-        + getGroupedGemmParamsWorkSpaceSize(nbReq * mNumLoraModules);
+        + getGroupedGemmParamsWorkSpaceSize(nbReq * mNumLoraModules)
+        + getSegmentedLoraWorkSpaceSize(nbReq, mMaxContextLength, mNumLoraModules);
+}
+
+void LoraPlugin::runSegmentedGemm(nvinfer1::PluginTensorDesc const* inputDesc,
+    nvinfer1::PluginTensorDesc const* outputDesc, void const* const* inputs, void* const* outputs, int32_t numTokens,
+    int32_t const* requestNumTokens, void* lowRankWorkSpace, void* segmentedWorkSpace, cudaStream_t stream)
+{
+    auto const batchSize = inputDesc[getLoraRanksIdx()].dims.d[0];
+    auto const nbDimsA = inputDesc[0].dims.nbDims;
+    auto const typeSize = tensorrt_llm::runtime::BufferDataType(mType).getSize();
+
+    // Stage the host descriptors with a single copy, the kernels only read them on the device
+    auto const ptrsBytes = divUp(mNumLoraModules * batchSize * 2 * sizeof(int64_t), 16) * 16;
+    auto const ranksBytes = divUp(mNumLoraModules * batchSize * sizeof(int32_t), 16) * 16;
+    auto const offsetsBytes = divUp((batchSize + 1) * sizeof(int32_t), 16) * 16;
+    std::vector<char> hostDescriptors(ptrsBytes + ranksBytes + offsetsBytes);
+    auto* hostPtrs = reinterpret_cast<int64_t*>(hostDescriptors.data());
+    auto* hostRanks = reinterpret_cast<int32_t*>(hostDescriptors.data() + ptrsBytes);
+    auto* hostOffsets = reinterpret_cast<int32_t*>(hostDescriptors.data() + ptrsBytes + ranksBytes);
+    int32_t maxRank = 0;
+    for (int loraModuleIdx = 0; loraModuleIdx < mNumLoraModules; loraModuleIdx++)
+    {
+        auto const loraRanks = static_cast<int32_t const*>(inputs[getLoraRanksIdx() + loraModuleIdx]);
+        auto const loraWeightsPtr = static_cast<int64_t const*>(inputs[getLoraWeightsPtrsIdx() + loraModuleIdx]);
+        std::copy_n(loraRanks, batchSize, hostRanks + loraModuleIdx * batchSize);
+        std::copy_n(loraWeightsPtr, 2 * batchSize, hostPtrs + loraModuleIdx * batchSize * 2);
+        maxRank = std::max(maxRank, *std::max_element(loraRanks, loraRanks + batchSize));
+    }
+    TLLM_CHECK_WITH_INFO(maxRank <= mMaxLowRank,
+        fmtstr("Invalid low_rank (%d). low_rank must be smaller than mMaxLowRank (%d)", maxRank, mMaxLowRank));
+    hostOffsets[0] = 0;
+    for (int batchIdx = 0; batchIdx < batchSize; batchIdx++)
+    {
+        hostOffsets[batchIdx + 1] = hostOffsets[batchIdx] + requestNumTokens[batchIdx];
+    }
+
+    auto* deviceDescriptors = static_cast<char*>(segmentedWorkSpace);
+    check_cuda_error(cudaMemcpyAsync(
+        deviceDescriptors, hostDescriptors.data(), hostDescriptors.size(), cudaMemcpyHostToDevice, stream));
+    auto const* devicePtrs = reinterpret_cast<int64_t const*>(deviceDescriptors);
+    auto const* deviceRanks = reinterpret_cast<int32_t const*>(deviceDescriptors + ptrsBytes);
+    auto const* deviceOffsets = reinterpret_cast<int32_t const*>(deviceDescriptors + ptrsBytes + ranksBytes);
+    auto* tokenAdapterIdx = reinterpret_cast<int32_t*>(deviceDescriptors + hostDescriptors.size());
+    tk::invokeBuildTokenAdapterIdx(tokenAdapterIdx, deviceOffsets, batchSize, numTokens, stream);
+
+    for (int loraModuleIdx = 0; loraModuleIdx < mNumLoraModules; loraModuleIdx++)
+    {
+        tk::SegmentedLoraParams params;
+        params.input = inputs[0];
+        params.output = outputs[loraModuleIdx];
+        params.lowRank = static_cast<char*>(lowRankWorkSpace)
+            + loraModuleIdx * batchSize * mMaxContextLength * mMaxLowRank * typeSize;
+        params.tokenAdapterIdx = tokenAdapterIdx;
+        params.adapterRanks = deviceRanks + loraModuleIdx * batchSize;
+        params.adapterWeightsPtrs = devicePtrs + loraModuleIdx * batchSize * 2;
+        params.numTokens = numTokens;
+        params.inHiddenSize = inputDesc[0].dims.d[nbDimsA - 1];
+        params.outHiddenSize = outputDesc[loraModuleIdx].dims.d[nbDimsA - 1];
+        params.maxLowRank = maxRank;
+
+        switch (mType)
+        {
+        case DataType::kFLOAT: tk::invokeSegmentedLoraGemm<float>(params, stream); break;
+        case DataType::kHALF: tk::invokeSegmentedLoraGemm<half>(params, stream); break;
+#ifdef ENABLE_BF16
+        case DataType::kBF16: tk::invokeSegmentedLoraGemm<__nv_bfloat16>(params, stream); break;
+#endif
+        default: TLLM_THROW("Unsupported data type for the segmented LoRA kernels");
+        }
+    }
 }
 
 void runCublasGemmEx(const int M, const int N, const int K, const bool transA, const bool transB, const void* act,
@@ -417,8 +499,21 @@ int LoraPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc, const nvinf
         }
     }
 
+    // Decode batches only have a token per request, gather the adapter weights per token on the device instead of
+    // building grouped GEMM problems on the host. Contexts keep the GEMMs, their tokens amortize the setup.
+    bool const useSegmentedGemm = !mTransA && batch_size > 0
+        && std::all_of(reqTypes, reqTypes + batch_size, [](RequestType t) { return t == RequestType::kGENERATION; });
+
     // TODO can add batch_size == 1 case
-    if (useUnifiedGemm)
+    if (useSegmentedGemm)
+    {
+        std::vector<int32_t> const requestNumTokens(batch_size, 1);
+        void* segmentedWorkSpace
+            = nextWorkspacePtr(static_cast<int8_t*>(groupGemmParamsWorkSpace), groupGemmParamsWorkSpaceSize);
+        runSegmentedGemm(inputDesc, outputDesc, inputs, outputs, batch_size, requestNumTokens.data(),
+            lowRankWorkSpace, segmentedWorkSpace, stream);
+    }
+    else if (useUnifiedGemm)
     {
         for (int loraModuleIdx = 0; loraModuleIdx < mNumLoraModules; loraModuleIdx++)
         {
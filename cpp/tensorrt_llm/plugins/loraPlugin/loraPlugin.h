@@ -77,6 +77,10 @@ private:
     void init();
     void configGemm();
     void setGemmConfig();
+    //! \brief Runs all the modules with the segmented LoRA kernels, tokens of a request are contiguous in the input.
+    void runSegmentedGemm(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::PluginTensorDesc const* outputDesc,
+        void const* const* inputs, void* const* outputs, int32_t numTokens, int32_t const* requestNumTokens,
+        void* lowRankWorkSpace, void* segmentedWorkSpace, cudaStream_t stream);
 
     using IndexType = std::int32_t;
 
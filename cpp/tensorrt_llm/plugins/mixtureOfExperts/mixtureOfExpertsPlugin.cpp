@@ -17,7 +17,12 @@
 #include "tensorrt_llm/plugins/mixtureOfExperts/mixtureOfExpertsPlugin.h"
 #include "tensorrt_llm/common/cudaBf16Wrapper.h"
 #include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include "tensorrt_llm/runtime/moeLoadStats.h"
+#include <algorithm>
+#include <cmath>
 #include <numeric>
 
 using namespace nvinfer1;
@@ -40,7 +45,8 @@ MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(int number_of_experts, int top_k,
     int expert_inter_size, tensorrt_llm::ActivationType activation_type, nvinfer1::DataType type,
     nvinfer1::DataType weight_type, QuantMode quant_mode, bool use_finished, bool use_bias, int tp_size, int tp_rank,
     MOEParallelismMode parallelism_mode, MOEExpertScaleNormalizationMode normalization_mode,
-    MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr)
+    float expert_capacity_factor, int layer_idx, MOEExpertReplication const& replication, int shared_experts,
+    bool gated_weights_interleaved, MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr)
     : mNumExperts(number_of_experts)
     , mK(top_k)
     , mExpertHiddenSize(expert_hidden_size)
@@ -55,6 +61,11 @@ MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(int number_of_experts, int top_k,
     , mTPRank(tp_rank)
     , mParallelismMode(parallelism_mode)
     , mNormalizationMode(normalization_mode)
+    , mExpertCapacityFactor(expert_capacity_factor)
+    , mLayerIdx(layer_idx)
+    , mReplication(replication)
+    , mSharedExperts(shared_experts)
+    , mGatedWeightsInterleaved(gated_weights_interleaved)
     , mPluginProfiler(std::move(plugin_profiler_ptr))
 {
     init();
@@ -76,8 +87,14 @@ tensorrt_llm::plugins::MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(const Mixt
     , mTPRank(other.mTPRank)
     , mParallelismMode(other.mParallelismMode)
     , mNormalizationMode(other.mNormalizationMode)
+    , mExpertCapacityFactor(other.mExpertCapacityFactor)
+    , mLayerIdx(other.mLayerIdx)
+    , mReplication(other.mReplication)
+    , mSharedExperts(other.mSharedExperts)
+    , mGatedWeightsInterleaved(other.mGatedWeightsInterleaved)
     , mDims(other.mDims)
     , mGemmId(other.mGemmId)
+    , mExpertLoad(other.mExpertLoad)
     , mPluginProfiler(other.mPluginProfiler)
     , mLayerName(other.mLayerName)
     , mNamespace(other.mNamespace)
@@ -90,7 +107,9 @@ size_t MixtureOfExpertsPlugin::getSerializationSize() const noexcept
     return sizeof(mNumExperts) + sizeof(mK) + sizeof(mExpertHiddenSize) + sizeof(mExpertInterSize)
         + sizeof(mActivationType) + sizeof(mType) + sizeof(mWeightType) + sizeof(QuantMode::BaseType)
         + sizeof(mUseFinished) + sizeof(mUseBias) + sizeof(mTPSize) + sizeof(mTPRank) + sizeof(mParallelismMode)
-        + sizeof(mNormalizationMode) + sizeof(mDims) + mPluginProfiler->getSerializationSize(mGemmId);
+        + sizeof(mNormalizationMode) + sizeof(mExpertCapacityFactor) + sizeof(mLayerIdx) + sizeof(mReplication)
+        + sizeof(mSharedExperts) + sizeof(mGatedWeightsInterleaved) + sizeof(mDims)
+        + mPluginProfiler->getSerializationSize(mGemmId);
 }
 
 MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(
@@ -115,6 +134,11 @@ MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(
     read(d, mTPRank);
     read(d, mParallelismMode);
     read(d, mNormalizationMode);
+    read(d, mExpertCapacityFactor);
+    read(d, mLayerIdx);
+    read(d, mReplication);
+    read(d, mSharedExperts);
+    read(d, mGatedWeightsInterleaved);
     read(d, mDims);
 
     init();
@@ -145,6 +169,11 @@ void MixtureOfExpertsPlugin::serialize(void* buffer) const noexcept
     write(d, mTPRank);
     write(d, mParallelismMode);
     write(d, mNormalizationMode);
+    write(d, mExpertCapacityFactor);
+    write(d, mLayerIdx);
+    write(d, mReplication);
+    write(d, mSharedExperts);
+    write(d, mGatedWeightsInterleaved);
     write(d, mDims);
 
     mPluginProfiler->serialize(d, mGemmId);
@@ -189,12 +218,37 @@ void MixtureOfExpertsPlugin::init()
             mMOERunner = std::make_unique<CutlassMoeFCRunner<__nv_bfloat16, uint8_t>>();
         }
     }
+#endif
+#ifdef ENABLE_FP8
+    else if (mType == DataType::kHALF && mWeightType == DataType::kFP8)
+    {
+        mMOERunner = std::make_unique<CutlassMoeFCRunner<half, __nv_fp8_e4m3>>();
+    }
+#ifdef ENABLE_BF16
+    else if (mType == DataType::kBF16 && mWeightType == DataType::kFP8)
+    {
+        mMOERunner = std::make_unique<CutlassMoeFCRunner<__nv_bfloat16, __nv_fp8_e4m3>>();
+    }
+#endif
 #endif
     else
     {
         TLLM_THROW("Could not construct the mixture of experts plugin with the requested input combination");
     }
 
+    if (mReplication.num_replicated_experts > 0)
+    {
+        TLLM_CHECK_WITH_INFO(mParallelismMode == MOEParallelismMode::EXPERT_PARALLELISM,
+            "Replicated experts are only supported with expert parallelism");
+        TLLM_CHECK_WITH_INFO(mReplication.num_replicated_experts <= mNumExperts - mNumExperts / mTPSize,
+            "Can not replicate more experts than the other nodes hold");
+    }
+    mMOERunner->setExpertReplication(mReplication);
+    mMOERunner->setExpertLoadCounters(mExpertLoad);
+    TLLM_CHECK_WITH_INFO(mSharedExperts == 0 || !useAllToAll(), "Shared experts are not supported with all-to-all");
+    mMOERunner->setSharedExperts(mSharedExperts);
+    mMOERunner->setGatedWeightsInterleaved(mGatedWeightsInterleaved);
+
     mGemmId = GemmIDMoe{mNumExperts, mK, mExpertHiddenSize, mExpertInterSize, mActivationType, mType, mWeightType,
         mQuantMode, mParallelismMode};
 }
@@ -238,6 +292,10 @@ bool MixtureOfExpertsPlugin::supportsFormatCombination(
     {
         return (inOut[pos].type == DataType::kFLOAT);
     }
+    else if (hasFp8Weights() && (pos == getExpertQuantScale1Index() || pos == getExpertQuantScale2Index()))
+    {
+        return (inOut[pos].type == DataType::kFLOAT);
+    }
     else
     {
         return (inOut[pos].type == mType);
@@ -288,8 +346,8 @@ auto MixtureOfExpertsPlugin::setupWorkspace(void* base_ptr, int num_tokens) cons
     // Output of post-softmax routing probabilities
     size_t scale_probabilities_size = num_tokens * mNumExperts * sizeof(float);
 
-    // Hidden states buffer for GEMM result
-    size_t fc2_output_size = mK * mExpertHiddenSize * num_tokens * dtype_size;
+    // Hidden states buffer for GEMM result, the rows of the shared experts follow the routed rows
+    size_t fc2_output_size = (mK + mSharedExperts) * mExpertHiddenSize * num_tokens * dtype_size;
 
     // Permutation map
     size_t src_to_dest_map_size = mK * num_tokens * sizeof(int);
@@ -337,15 +395,124 @@ size_t MixtureOfExpertsPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc
     const nvinfer1::PluginTensorDesc* outputs, int nbOutputs) const noexcept
 {
     const int num_tokens = getNumTokens(inputs);
+    if (useAllToAll())
+    {
+        return setupAllToAllWorkspace(nullptr, num_tokens).size;
+    }
     return setupWorkspace(nullptr, num_tokens).size;
 }
 
+int MixtureOfExpertsPlugin::getExpertCapacity(int num_tokens) const
+{
+    if (mExpertCapacityFactor <= 0.f)
+    {
+        return 0;
+    }
+    const float mean_rows_per_expert = static_cast<float>(num_tokens) * mK / mNumExperts;
+    return std::max(1, static_cast<int>(std::ceil(mExpertCapacityFactor * mean_rows_per_expert)));
+}
+
+int MixtureOfExpertsPlugin::getMaxSendRows(int num_tokens) const
+{
+    const int capacity = getExpertCapacity(num_tokens);
+    return capacity > 0 ? mNumExperts * capacity : num_tokens * mK;
+}
+
+int MixtureOfExpertsPlugin::getMaxRecvRows(int num_tokens) const
+{
+    const int capacity = getExpertCapacity(num_tokens);
+    if (capacity > 0)
+    {
+        // Each node sends `capacity` rows to each of our experts
+        return mNumExperts * capacity;
+    }
+    // A token sends at most one row to each of our experts
+    const int experts_per_node = mNumExperts / mTPSize;
+    return mTPSize * num_tokens * std::min(mK, experts_per_node);
+}
+
+auto MixtureOfExpertsPlugin::setupAllToAllWorkspace(void* base_ptr, int num_tokens) const -> AllToAllWorkspaceInfo
+{
+    size_t dtype_size = tensorrt_llm::common::getDTypeSize(mType);
+    const int experts_per_node = mNumExperts / mTPSize;
+    const size_t max_send_rows = getMaxSendRows(num_tokens);
+    const size_t max_recv_rows = getMaxRecvRows(num_tokens);
+
+    auto routing_sizes = getAllToAllRoutingBufferSizes(num_tokens, mNumExperts, mK);
+    size_t routing_size = calculateTotalWorkspaceSize(routing_sizes.data(), routing_sizes.size());
+
+    size_t expanded_size = mK * num_tokens * sizeof(int);
+    size_t counts_size = mNumExperts * sizeof(int);
+    size_t send_buffer_size = max_send_rows * mExpertHiddenSize * dtype_size;
+    size_t recv_buffer_size = max_recv_rows * mExpertHiddenSize * dtype_size;
+
+    // The local experts run as an MoE with k = 1 on the received rows
+    size_t local_gating_size = max_recv_rows * experts_per_node * sizeof(float);
+    size_t local_finished_size = max_recv_rows * sizeof(bool);
+    size_t local_workspace_size = mMOERunner->getWorkspaceSize(
+        max_recv_rows, mExpertHiddenSize, mExpertInterSize, experts_per_node, 1, mActivationType, {});
+    size_t local_scales_size = max_recv_rows * experts_per_node * sizeof(float);
+    size_t local_map_size = max_recv_rows * sizeof(int);
+
+    std::vector<size_t> workspaces{
+        routing_size,
+        mK * num_tokens * sizeof(float), // expert_scales
+        expanded_size,                   // selected_experts
+        expanded_size,                   // source_to_send_row
+        counts_size,                     // send_counts
+        counts_size,                     // recv_counts
+        send_buffer_size,
+        recv_buffer_size,
+        local_gating_size,
+        local_finished_size,
+        local_workspace_size,
+        recv_buffer_size, // local_output
+        recv_buffer_size, // local_fc2_output
+        local_scales_size,
+        local_map_size, // local_src_to_dest_map
+        local_map_size, // local_selected_experts
+        send_buffer_size, // returned_buffer
+    };
+
+    AllToAllWorkspaceInfo info{};
+    info.size = calculateTotalWorkspaceSize(workspaces.data(), workspaces.size());
+
+    if (base_ptr)
+    {
+        std::vector<int8_t*> ws_sliced{static_cast<int8_t*>(base_ptr)};
+        for (auto size : workspaces)
+        {
+            ws_sliced.push_back(nextWorkspacePtr(ws_sliced.back(), size));
+        }
+        info.routing = setupAllToAllRoutingBuffers((char*) ws_sliced[0], num_tokens, mNumExperts, mK);
+        info.expert_scales = (float*) ws_sliced[1];
+        info.selected_experts = (int*) ws_sliced[2];
+        info.source_to_send_row = (int*) ws_sliced[3];
+        info.send_counts = (int*) ws_sliced[4];
+        info.recv_counts = (int*) ws_sliced[5];
+        info.send_buffer = ws_sliced[6];
+        info.recv_buffer = ws_sliced[7];
+        info.local_gating = (float*) ws_sliced[8];
+        info.local_finished = (bool*) ws_sliced[9];
+        info.local_workspace = ws_sliced[10];
+        info.local_output = ws_sliced[11];
+        info.local_fc2_output = ws_sliced[12];
+        info.local_scales = (float*) ws_sliced[13];
+        info.local_src_to_dest_map = (int*) ws_sliced[14];
+        info.local_selected_experts = (int*) ws_sliced[15];
+        info.returned_buffer = ws_sliced[16];
+    }
+
+    return info;
+}
+
 MOEParallelismConfig MixtureOfExpertsPlugin::getParallelismConfig() const
 {
     switch (mParallelismMode)
     {
     case kernels::MOEParallelismMode::NONE: return {};
     case kernels::MOEParallelismMode::EXPERT_PARALLELISM:
+    case kernels::MOEParallelismMode::EXPERT_PARALLELISM_ALL_TO_ALL:
         return MOEParallelismConfig::ExpertParallelism(mTPSize, mTPRank);
     case kernels::MOEParallelismMode::TENSOR_PARALLELISM:
         return MOEParallelismConfig::TensorParallelism(mTPSize, mTPRank);
@@ -362,12 +529,12 @@ int MixtureOfExpertsPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
     const int num_not_finished = num_tokens; // TODO Take this as an input
     auto parallelism_config = getParallelismConfig();
 
-    auto workspace = setupWorkspace(workspace_ptr, num_tokens);
-
     auto w1_desc = inputDesc[getExpertWeights1Index()];
     auto w2_desc = inputDesc[getExpertWeights2Index()];
     TLLM_CHECK(w1_desc.dims.nbDims == 3);
-    size_t experts_per_node = mNumExperts / parallelism_config.ep_size;
+    // The replicas of the hot experts are stored after the experts of the node, then the shared experts
+    size_t experts_per_node
+        = mNumExperts / parallelism_config.ep_size + mReplication.num_replicated_experts + mSharedExperts;
     TLLM_CHECK(w1_desc.dims.d[0] == experts_per_node);
     TLLM_CHECK(w2_desc.dims.nbDims == 3);
     TLLM_CHECK(w2_desc.dims.d[0] == experts_per_node);
@@ -389,6 +556,12 @@ int MixtureOfExpertsPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
     TLLM_CHECK(w2_desc.dims.d[outer_dim_idx] * packed_elements == mExpertHiddenSize);
 
     mMOERunner->setTactic(mPluginProfiler->getBestConfig(num_tokens, mGemmId));
+    if (useAllToAll())
+    {
+        enqueueAllToAll(inputDesc, inputs, outputs, workspace_ptr, stream);
+        return 0;
+    }
+    auto workspace = setupWorkspace(workspace_ptr, num_tokens);
     mMOERunner->runMoe(inputs[getInputTensorIndex()], static_cast<const float*>(inputs[getRoutingTensorIndex()]),
         inputs[getExpertWeights1Index()], hasExpertQuantScales() ? inputs[getExpertQuantScale1Index()] : nullptr,
         hasBias() ? inputs[getExpertBias1Index()] : nullptr, mActivationType, inputs[getExpertWeights2Index()],
@@ -404,6 +577,117 @@ int MixtureOfExpertsPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
     return 0;
 }
 
+void MixtureOfExpertsPlugin::enqueueAllToAll(const nvinfer1::PluginTensorDesc* inputDesc, const void* const* inputs,
+    void* const* outputs, void* workspace_ptr, cudaStream_t stream)
+{
+#if ENABLE_MULTI_DEVICE
+    const int num_tokens = getNumTokens(inputDesc);
+    const int ep_size = mTPSize;
+    const int experts_per_node = mNumExperts / ep_size;
+    const int capacity = getExpertCapacity(num_tokens);
+    const size_t row_bytes = mExpertHiddenSize * tensorrt_llm::common::getDTypeSize(mType);
+    auto workspace = setupAllToAllWorkspace(workspace_ptr, num_tokens);
+    auto comm = (*getCommMap())[mGroup];
+    auto nccl_type = (*getDtypeMap())[mType];
+
+    // Route each token to the top-k of all the experts and group the expanded rows by destination node
+    computeAllToAllRouting(static_cast<const float*>(inputs[getRoutingTensorIndex()]),
+        hasFinishedTensor() ? static_cast<const bool*>(inputs[getFinishedTensorIndex()]) : nullptr,
+        workspace.expert_scales, workspace.selected_experts, workspace.routing, num_tokens, mNumExperts, mK, stream);
+    invokeMoeAllToAllDispatch(inputs[getInputTensorIndex()], workspace.send_buffer, workspace.send_counts,
+        workspace.source_to_send_row, workspace.selected_experts, workspace.routing, num_tokens, mExpertHiddenSize,
+        mNumExperts, mK, capacity, mType, stream);
+
+    // Exchange the number of rows of each (node, expert) pair
+    NCCLCHECK(ncclGroupStart());
+    for (int peer = 0; peer < ep_size; ++peer)
+    {
+        NCCLCHECK(
+            ncclSend(workspace.send_counts + peer * experts_per_node, experts_per_node, ncclInt32, peer, comm, stream));
+        NCCLCHECK(
+            ncclRecv(workspace.recv_counts + peer * experts_per_node, experts_per_node, ncclInt32, peer, comm, stream));
+    }
+    NCCLCHECK(ncclGroupEnd());
+
+    // With a capacity, the segments have a static size and the rows past the counts are padding. Without, the sizes of
+    // the exchanges are only known on the device, so we have to wait for the counts.
+    std::vector<int> send_rows(ep_size, experts_per_node * capacity);
+    std::vector<int> recv_rows(ep_size, experts_per_node * capacity);
+    if (capacity == 0)
+    {
+        std::vector<int> counts(2 * mNumExperts);
+        TLLM_CUDA_CHECK(cudaMemcpyAsync(
+            counts.data(), workspace.send_counts, mNumExperts * sizeof(int), cudaMemcpyDeviceToHost, stream));
+        TLLM_CUDA_CHECK(cudaMemcpyAsync(counts.data() + mNumExperts, workspace.recv_counts, mNumExperts * sizeof(int),
+            cudaMemcpyDeviceToHost, stream));
+        TLLM_CUDA_CHECK(cudaStreamSynchronize(stream));
+        for (int peer = 0; peer < ep_size; ++peer)
+        {
+            auto const begin = counts.begin() + peer * experts_per_node;
+            send_rows[peer] = std::accumulate(begin, begin + experts_per_node, 0);
+            recv_rows[peer] = std::accumulate(begin + mNumExperts, begin + mNumExperts + experts_per_node, 0);
+        }
+    }
+    const int num_recv_rows = std::accumulate(recv_rows.begin(), recv_rows.end(), 0);
+
+    // Sends `send_rows` rows of `send` to each peer and receives `recv_rows` rows from each peer into `recv`, the rows
+    // of consecutive peers are packed
+    auto exchangeRows = [&](const void* send, const std::vector<int>& send_rows_per_peer, void* recv,
+                            const std::vector<int>& recv_rows_per_peer)
+    {
+        auto send_ptr = static_cast<const int8_t*>(send);
+        auto recv_ptr = static_cast<int8_t*>(recv);
+        NCCLCHECK(ncclGroupStart());
+        for (int peer = 0; peer < ep_size; ++peer)
+        {
+            if (send_rows_per_peer[peer] > 0)
+            {
+                NCCLCHECK(ncclSend(
+                    send_ptr, send_rows_per_peer[peer] * mExpertHiddenSize, nccl_type, peer, comm, stream));
+            }
+            if (recv_rows_per_peer[peer] > 0)
+            {
+                NCCLCHECK(ncclRecv(
+                    recv_ptr, recv_rows_per_peer[peer] * mExpertHiddenSize, nccl_type, peer, comm, stream));
+            }
+            send_ptr += send_rows_per_peer[peer] * row_bytes;
+            recv_ptr += recv_rows_per_peer[peer] * row_bytes;
+        }
+        NCCLCHECK(ncclGroupEnd());
+    };
+
+    exchangeRows(workspace.send_buffer, send_rows, workspace.recv_buffer, recv_rows);
+
+    if (num_recv_rows > 0)
+    {
+        // Run the local experts on the received rows, each of which goes to exactly one expert
+        invokeMoeAllToAllLocalRouting(workspace.recv_counts, workspace.local_gating, workspace.local_finished,
+            num_recv_rows, ep_size, experts_per_node, capacity, stream);
+        // The local run only sees the experts of this node, starting at 0
+        mMOERunner->setExpertLoadCounters(mExpertLoad ? mExpertLoad + mTPRank * experts_per_node : nullptr);
+        mMOERunner->runMoe(workspace.recv_buffer, workspace.local_gating, inputs[getExpertWeights1Index()],
+            hasExpertQuantScales() ? inputs[getExpertQuantScale1Index()] : nullptr,
+            hasBias() ? inputs[getExpertBias1Index()] : nullptr, mActivationType, inputs[getExpertWeights2Index()],
+            hasExpertQuantScales() ? inputs[getExpertQuantScale2Index()] : nullptr,
+            hasBias() ? inputs[getExpertBias2Index()] : nullptr, num_recv_rows, mExpertHiddenSize, mExpertInterSize,
+            experts_per_node, 1, static_cast<char*>(workspace.local_workspace),
+            // Outputs
+            workspace.local_output, workspace.local_fc2_output, workspace.local_finished, num_recv_rows,
+            workspace.local_scales, workspace.local_src_to_dest_map, workspace.local_selected_experts,
+            MOEParallelismConfig{}, MOEExpertScaleNormalizationMode::NONE, stream);
+        mMOERunner->setExpertLoadCounters(mExpertLoad);
+    }
+
+    // Send the results back where the rows came from, which restores the layout of the send buffer
+    exchangeRows(workspace.local_output, recv_rows, workspace.returned_buffer, send_rows);
+
+    invokeMoeAllToAllCombine(workspace.returned_buffer, outputs[getOutputTensorIndex()], workspace.expert_scales,
+        workspace.source_to_send_row, num_tokens, mExpertHiddenSize, mK, mNormalizationMode, mType, stream);
+#else
+    TLLM_THROW("All-to-all expert parallelism requires a build with ENABLE_MULTI_DEVICE");
+#endif // ENABLE_MULTI_DEVICE
+}
+
 // IPluginV2Ext Methods
 nvinfer1::DataType MixtureOfExpertsPlugin::getOutputDataType(
     int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
@@ -427,10 +711,37 @@ const char* MixtureOfExpertsPlugin::getPluginVersion() const noexcept
 int MixtureOfExpertsPlugin::initialize() noexcept
 {
     mPluginProfiler->profileTactics(this, mType, mDims, mGemmId);
+    if (mLayerIdx >= 0 && !isBuilding())
+    {
+        mExpertLoad = runtime::MoeLoadStatsCollector::getInstance().getLayerCounters(mLayerIdx, mNumExperts);
+        mMOERunner->setExpertLoadCounters(mExpertLoad);
+    }
+#if ENABLE_MULTI_DEVICE
+    if (useAllToAll() && !isBuilding())
+    {
+        // The expert-parallel group is the tensor-parallel group of this rank
+        const int first_rank = tensorrt_llm::runtime::InProcessWorld::getSessionRank() / mTPSize * mTPSize;
+        mGroup.clear();
+        for (int rank = first_rank; rank < first_rank + mTPSize; ++rank)
+        {
+            mGroup.insert(rank);
+        }
+        initCommMap(mGroup);
+    }
+#endif // ENABLE_MULTI_DEVICE
     return 0;
 }
 
-void MixtureOfExpertsPlugin::terminate() noexcept {}
+void MixtureOfExpertsPlugin::terminate() noexcept
+{
+#if ENABLE_MULTI_DEVICE
+    if (!useAllToAll())
+    {
+        return;
+    }
+    releaseCommMap(mGroup);
+#endif // ENABLE_MULTI_DEVICE
+}
 
 void MixtureOfExpertsPlugin::destroy() noexcept
 {
@@ -490,6 +801,13 @@ MixtureOfExpertsPluginCreator::MixtureOfExpertsPluginCreator()
         "parallelism_mode", nullptr, PluginFieldType::kINT32, static_cast<int>(MOEParallelismMode::NONE)));
     mPluginAttributes.emplace_back(nvinfer1::PluginField("normalization_mode", nullptr, PluginFieldType::kINT32,
         static_cast<int>(MOEExpertScaleNormalizationMode::NONE)));
+    mPluginAttributes.emplace_back(
+        nvinfer1::PluginField("expert_capacity_factor", nullptr, PluginFieldType::kFLOAT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("layer_idx", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("replicated_experts", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("shared_experts", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(
+        nvinfer1::PluginField("gated_weights_interleaved", nullptr, PluginFieldType::kINT32, 0));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -512,6 +830,11 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
     int mTPRank{};
     int mParallelismMode{};
     int mNormalizationMode{};
+    float mExpertCapacityFactor{};
+    int mLayerIdx{-1};
+    MOEExpertReplication mReplication{};
+    int mSharedExperts{};
+    int mGatedWeightsInterleaved{};
 
     // Read configurations from each fields
     using MapPair = std::pair<const char*, std::reference_wrapper<int>>;
@@ -530,10 +853,29 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
         MapPair{"tp_rank", std::ref(mTPRank)},
         MapPair{"parallelism_mode", std::ref(mParallelismMode)},
         MapPair{"normalization_mode", std::ref(mNormalizationMode)},
+        MapPair{"layer_idx", std::ref(mLayerIdx)},
+        MapPair{"shared_experts", std::ref(mSharedExperts)},
+        MapPair{"gated_weights_interleaved", std::ref(mGatedWeightsInterleaved)},
     };
     for (int i = 0; i < fc->nbFields; ++i)
     {
         const char* attrName = fields[i].name;
+        if (!strcmp(attrName, "expert_capacity_factor"))
+        {
+            TLLM_CHECK(fields[i].type == nvinfer1::PluginFieldType::kFLOAT32);
+            mExpertCapacityFactor = *static_cast<const float*>(fields[i].data);
+            continue;
+        }
+        if (!strcmp(attrName, "replicated_experts"))
+        {
+            TLLM_CHECK(fields[i].type == nvinfer1::PluginFieldType::kINT32);
+            TLLM_CHECK_WITH_INFO(fields[i].length <= MOEExpertReplication::kMaxReplicatedExperts,
+                "At most %d experts can be replicated", MOEExpertReplication::kMaxReplicatedExperts);
+            mReplication.num_replicated_experts = fields[i].length;
+            const auto* experts = static_cast<const int*>(fields[i].data);
+            std::copy(experts, experts + fields[i].length, mReplication.replicated_experts);
+            continue;
+        }
         for (const auto& item : input_map)
         {
             if (!strcmp(item.first, attrName))
@@ -552,7 +894,8 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
             static_cast<tensorrt_llm::ActivationType>(mActivationType), static_cast<nvinfer1::DataType>(mType),
             static_cast<nvinfer1::DataType>(mWeightType), QuantMode(mQuantMode), mUseFinished != 0, mUseBias != 0,
             mTPSize, mTPRank, static_cast<MOEParallelismMode>(mParallelismMode),
-            static_cast<MOEExpertScaleNormalizationMode>(mNormalizationMode), pluginProfiler);
+            static_cast<MOEExpertScaleNormalizationMode>(mNormalizationMode), mExpertCapacityFactor, mLayerIdx,
+            mReplication, mSharedExperts, mGatedWeightsInterleaved != 0, pluginProfiler);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
@@ -605,19 +948,25 @@ std::vector<size_t> MixtureOfExpertsGemmProfiler::getProfilerWorkspaces(int maxM
 
     size_t hidden_size = plugin.mExpertHiddenSize;
     size_t inter_size = plugin.mExpertInterSize;
-    size_t num_experts = plugin.mNumExperts;
+    // The shared experts follow the routed ones in the weights
+    size_t num_experts = plugin.mNumExperts + plugin.mSharedExperts;
 
     size_t input_size = hidden_size * num_tokens * dtype_bytes;
     size_t routing_weights = num_experts * num_tokens * sizeof(float);
 
     size_t weights_1 = hidden_size * inter_size * num_experts * weight_bytes;
 
-    size_t quant_1 = plugin.hasExpertQuantScales() ? inter_size * num_experts * dtype_bytes : 0;
+    // One fp32 scale per expert with FP8 weights
+    size_t quant_1 = plugin.hasFp8Weights() ? num_experts * sizeof(float)
+        : plugin.hasExpertQuantScales()     ? inter_size * num_experts * dtype_bytes
+                                            : 0;
     size_t bias_1 = plugin.hasBias() ? inter_size * num_experts * dtype_bytes : 0;
 
     size_t weights_2 = hidden_size * inter_size * num_experts * weight_bytes;
 
-    size_t quant_2 = plugin.hasExpertQuantScales() ? hidden_size * num_experts * dtype_bytes : 0;
+    size_t quant_2 = plugin.hasFp8Weights() ? num_experts * sizeof(float)
+        : plugin.hasExpertQuantScales()     ? hidden_size * num_experts * dtype_bytes
+                                            : 0;
     size_t bias_2 = plugin.hasBias() ? hidden_size * num_experts * dtype_bytes : 0;
 
     size_t output = hidden_size * num_tokens * dtype_bytes;
@@ -83,13 +83,15 @@ class MixtureOfExpertsPlugin : public nvinfer1::IPluginV2DynamicExt
 public:
     using MOEParallelismMode = tensorrt_llm::kernels::MOEParallelismMode;
     using MOEExpertScaleNormalizationMode = tensorrt_llm::kernels::MOEExpertScaleNormalizationMode;
+    using MOEExpertReplication = tensorrt_llm::kernels::MOEExpertReplication;
 
     MixtureOfExpertsPlugin() = delete;
     MixtureOfExpertsPlugin(int number_of_experts, int top_k, int expert_hidden_size, int expert_inter_size,
         tensorrt_llm::ActivationType activation_type, nvinfer1::DataType type, nvinfer1::DataType weight_type,
         tensorrt_llm::common::QuantMode quant_mode, bool use_finished, bool use_bias, int tp_size, int tp_rank,
         MOEParallelismMode parallelism_mode, MOEExpertScaleNormalizationMode normalization_mode,
-        MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr);
+        float expert_capacity_factor, int layer_idx, MOEExpertReplication const& replication, int shared_experts,
+        bool gated_weights_interleaved, MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr);
     MixtureOfExpertsPlugin(const void* data, size_t length, MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr);
     MixtureOfExpertsPlugin(const MixtureOfExpertsPlugin&);
 
@@ -148,11 +150,26 @@ private:
     int mTPRank{};
     MOEParallelismMode mParallelismMode{};
     MOEExpertScaleNormalizationMode mNormalizationMode{};
+    // Only used with all-to-all, rows sent to an expert by a node are capped to
+    // ceil(factor * num_tokens * k / num_experts). 0 for no capacity (dropless).
+    float mExpertCapacityFactor{};
+    // Index of the layer in the expert load statistics, -1 to not count the load
+    int mLayerIdx{-1};
+    // Only used with expert parallelism, see MOEExpertReplication
+    MOEExpertReplication mReplication{};
+    // Experts applied to every token, stored after the experts of the node in the weights
+    int mSharedExperts{};
+    // The FC1 weights of gated activations alternate linear and gate columns
+    bool mGatedWeightsInterleaved{};
 
     GemmDims mDims{};
 
     // The below are not serialised
     GemmIDMoe mGemmId{};
+    // Global ranks of the expert-parallel group, only used with all-to-all
+    std::set<int> mGroup;
+    // Counters of the layer in MoeLoadStatsCollector
+    int64_t* mExpertLoad{};
 
     MixtureOfExpertsPluginProfilerPtr mPluginProfiler;
 
@@ -169,9 +186,45 @@ private:
         size_t size{};
     };
 
+    struct AllToAllWorkspaceInfo
+    {
+        kernels::MoeAllToAllRoutingBuffers routing{};
+        float* expert_scales{};
+        int* selected_experts{};
+        int* source_to_send_row{};
+        int* send_counts{};
+        int* recv_counts{};
+        void* send_buffer{};
+        void* recv_buffer{};
+        // Routing, workspace and outputs of the local experts on the received rows
+        float* local_gating{};
+        bool* local_finished{};
+        void* local_workspace{};
+        void* local_output{};
+        void* local_fc2_output{};
+        float* local_scales{};
+        int* local_src_to_dest_map{};
+        int* local_selected_experts{};
+        // Outputs of the local experts sent back to each node, in the layout of send_buffer
+        void* returned_buffer{};
+        size_t size{};
+    };
+
     int getNumTokens(const nvinfer1::PluginTensorDesc* input_tensor) const;
     WorkspaceInfo setupWorkspace(void* base_ptr, int num_tokens) const;
 
+    bool useAllToAll() const
+    {
+        return mParallelismMode == MOEParallelismMode::EXPERT_PARALLELISM_ALL_TO_ALL;
+    }
+
+    int getExpertCapacity(int num_tokens) const;
+    int getMaxSendRows(int num_tokens) const;
+    int getMaxRecvRows(int num_tokens) const;
+    AllToAllWorkspaceInfo setupAllToAllWorkspace(void* base_ptr, int num_tokens) const;
+    void enqueueAllToAll(const nvinfer1::PluginTensorDesc* inputDesc, const void* const* inputs, void* const* outputs,
+        void* workspace_ptr, cudaStream_t stream);
+
     kernels::MOEParallelismConfig getParallelismConfig() const;
 
     using IndexType = std::int32_t;
@@ -208,11 +261,22 @@ private:
         return mUseFinished;
     }
 
-    bool hasExpertQuantScales() const
+    bool hasWeightOnlyQuant() const
     {
         return mQuantMode.hasInt4Weights() || mQuantMode.hasInt8Weights();
     }
 
+    bool hasFp8Weights() const
+    {
+        return mWeightType == nvinfer1::DataType::kFP8;
+    }
+
+    // The weight-only scales are [experts, n] in the activation type, the FP8 ones [experts] in fp32
+    bool hasExpertQuantScales() const
+    {
+        return hasWeightOnlyQuant() || hasFp8Weights();
+    }
+
     IndexType getExpertBias1Index() const
     {
         return getExpertWeights2Index() + hasBias();
@@ -255,7 +319,7 @@ private:
     int getGemmShapeInnerDimIndex() const
     {
         // In weight only mode the shape is transposed
-        return hasExpertQuantScales() ? 1 : 2;
+        return hasWeightOnlyQuant() ? 1 : 2;
     }
 
     /**
@@ -264,7 +328,7 @@ private:
     int getGemmShapeOuterDimIndex() const
     {
         // In weight only mode the shape is transposed
-        return hasExpertQuantScales() ? 2 : 1;
+        return hasWeightOnlyQuant() ? 2 : 1;
     }
 
     /**
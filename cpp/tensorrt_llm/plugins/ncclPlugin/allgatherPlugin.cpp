@@ -139,14 +139,7 @@ int AllgatherPlugin::initialize() noexcept
 
 void AllgatherPlugin::terminate() noexcept
 {
-    auto* commMap = getCommMap();
-    // [] operator inserts T() if it does not exist
-    if (isBuilding() || (*commMap)[mGroup] == nullptr)
-    {
-        return;
-    }
-    NCCLCHECK(ncclCommDestroy((*commMap)[mGroup]));
-    (*commMap)[mGroup] = nullptr;
+    releaseCommMap(mGroup);
 }
 
 size_t AllgatherPlugin::getSerializationSize() const noexcept
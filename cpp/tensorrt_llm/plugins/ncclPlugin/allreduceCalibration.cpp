@@ -0,0 +1,358 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "allreduceCalibration.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/customAllReduceUtils.h"
+#include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/plugins/common/plugin.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace tensorrt_llm::plugins
+{
+
+namespace
+{
+using kernels::AllReduceStrategyType;
+using Strategies = std::vector<std::pair<std::size_t, AllReduceStrategyType>>;
+
+// Strategies compared by the calibration, RING is NCCL.
+constexpr std::array<AllReduceStrategyType, 3> kStrategies{
+    AllReduceStrategyType::RING, AllReduceStrategyType::ONESHOT, AllReduceStrategyType::TWOSHOT};
+constexpr std::size_t kMinMessageSize = 16 * 1024;
+constexpr int kWarmupIterations = 5;
+constexpr int kIterations = 20;
+// The IPC kernels wait for a barrier flag different from the previous one. The flags of the calibration are far above
+// the counters of the plugins, so that the first all-reduce after the calibration never sees its own flag.
+constexpr uint32_t kFlagBase = 1u << 30;
+
+std::map<std::set<int>, AllReduceCalibration>& getCalibrations()
+{
+    static std::map<std::set<int>, AllReduceCalibration> calibrations;
+    return calibrations;
+}
+
+// Powers of two up to the largest message the workspace takes, rounded down to the granularity of the two-shot kernel.
+std::vector<std::size_t> getMessageSizes(std::size_t ranksPerNode, std::size_t maxMessageSize)
+{
+    auto const granularity = ranksPerNode * 16;
+    auto const maxSize = std::min(
+        maxMessageSize, utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(static_cast<int>(ranksPerNode)));
+    std::vector<std::size_t> sizes;
+    for (std::size_t size = kMinMessageSize;; size *= 2)
+    {
+        auto const rounded = std::min(size, maxSize) / granularity * granularity;
+        if (rounded > 0 && (sizes.empty() || rounded > sizes.back()))
+        {
+            sizes.push_back(rounded);
+        }
+        if (size >= maxSize)
+        {
+            break;
+        }
+    }
+    return sizes;
+}
+
+// The same on all the ranks of the node, so that they all find the file written by the first one.
+std::string getCacheKey(std::size_t ranksPerNode)
+{
+    int device = 0;
+    TLLM_CUDA_CHECK(cudaGetDevice(&device));
+    cudaDeviceProp prop;
+    TLLM_CUDA_CHECK(cudaGetDeviceProperties(&prop, device));
+    int deviceCount = 0;
+    TLLM_CUDA_CHECK(cudaGetDeviceCount(&deviceCount));
+    int cudaRuntimeVersion = 0;
+    cudaRuntimeGetVersion(&cudaRuntimeVersion);
+    int ncclVersion = 0;
+    ncclGetVersion(&ncclVersion);
+
+    std::ostringstream key;
+    key << prop.name << " ranks=" << ranksPerNode << " cuda=" << cudaRuntimeVersion << " nccl=" << ncclVersion
+        << " p2p=";
+    // The links between the GPUs of the node tell PCIe from NVLink and NVSwitch machines.
+    auto const numDevices = std::min(static_cast<int>(ranksPerNode), deviceCount);
+    for (int src = 0; src < numDevices; ++src)
+    {
+        for (int dst = 0; dst < numDevices; ++dst)
+        {
+            if (src == dst)
+            {
+                continue;
+            }
+            int canAccessPeer = 0;
+            int performanceRank = -1;
+            TLLM_CUDA_CHECK(cudaDeviceCanAccessPeer(&canAccessPeer, src, dst));
+            if (canAccessPeer)
+            {
+                TLLM_CUDA_CHECK(cudaDeviceGetP2PAttribute(&performanceRank, cudaDevP2PAttrPerformanceRank, src, dst));
+            }
+            key << performanceRank << ",";
+        }
+    }
+    return key.str();
+}
+
+fs::path getCachePath(std::string const& cacheDir, std::string const& key)
+{
+    return fs::path(cacheDir) / ("allreduce_" + std::to_string(std::hash<std::string>{}(key)) + ".txt");
+}
+
+// Layout: the key on the first line, then a line per message size with the size and the strategy.
+std::optional<Strategies> loadCache(fs::path const& path, std::string const& key, std::vector<std::size_t> const& sizes)
+{
+    std::ifstream file(path);
+    std::string line;
+    // A hash collision or a file of another layout is ignored and overwritten after the calibration.
+    if (!file.good() || !std::getline(file, line) || line != key)
+    {
+        return std::nullopt;
+    }
+    std::map<std::size_t, int> cached;
+    std::size_t size = 0;
+    int strategy = 0;
+    while (file >> size >> strategy)
+    {
+        cached[size] = strategy;
+    }
+
+    Strategies strategies;
+    for (auto const size : sizes)
+    {
+        auto const it = cached.find(size);
+        if (it == cached.end()
+            || std::none_of(kStrategies.begin(), kStrategies.end(),
+                [&it](auto const s) { return static_cast<int>(s) == it->second; }))
+        {
+            return std::nullopt;
+        }
+        strategies.emplace_back(size, static_cast<AllReduceStrategyType>(it->second));
+    }
+    return strategies;
+}
+
+void storeCache(fs::path const& path, std::string const& key, Strategies const& strategies)
+{
+    std::ostringstream data;
+    data << key << "\n";
+    for (auto const& [size, strategy] : strategies)
+    {
+        data << size << " " << static_cast<int>(strategy) << "\n";
+    }
+
+    // Write to a temporary file first, so that concurrent processes never read a partially written file.
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    auto const tmpPath = fs::path(path).concat(".tmp" + std::to_string(std::hash<std::string>{}(data.str())));
+    {
+        std::ofstream file(tmpPath);
+        file << data.str();
+        if (!file.good())
+        {
+            TLLM_LOG_WARNING("Failed to write all-reduce calibration file %s", tmpPath.c_str());
+            return;
+        }
+    }
+    fs::rename(tmpPath, path, ec);
+    if (ec)
+    {
+        TLLM_LOG_WARNING("Failed to write all-reduce calibration file %s: %s", path.c_str(), ec.message().c_str());
+        fs::remove(tmpPath, ec);
+    }
+}
+
+common::datatype_enum toDatatypeEnum(nvinfer1::DataType type)
+{
+    switch (type)
+    {
+    case nvinfer1::DataType::kFLOAT: return common::datatype_enum::TYPE_FP32;
+    case nvinfer1::DataType::kHALF: return common::datatype_enum::TYPE_FP16;
+    case nvinfer1::DataType::kBF16: return common::datatype_enum::TYPE_BF16;
+    default: TLLM_THROW("Unsupported data type for the all-reduce calibration");
+    }
+}
+
+// Average latency of every strategy and size on the slowest rank, so that all the ranks pick the same strategies.
+Strategies measure(kernels::AllReduceParams& params, nvinfer1::DataType type, std::vector<std::size_t> const& sizes,
+    ncclComm_t comm, cudaStream_t stream)
+{
+    auto const elemSize = common::getDTypeSize(type);
+    auto const dataType = toDatatypeEnum(type);
+    auto const ncclType = (*getDtypeMap())[type];
+
+    // The input is whatever the workspace holds, only the latency matters.
+    void* output = nullptr;
+    TLLM_CUDA_CHECK(cudaMalloc(&output, sizes.back()));
+    cudaEvent_t start;
+    cudaEvent_t stop;
+    TLLM_CUDA_CHECK(cudaEventCreate(&start));
+    TLLM_CUDA_CHECK(cudaEventCreate(&stop));
+
+    uint32_t flag = kFlagBase;
+    std::vector<float> times(sizes.size() * kStrategies.size());
+    for (std::size_t ii = 0; ii < sizes.size(); ++ii)
+    {
+        auto const elts = sizes[ii] / elemSize;
+        for (std::size_t jj = 0; jj < kStrategies.size(); ++jj)
+        {
+            auto const strategy = kStrategies[jj];
+            auto const run = [&]()
+            {
+                if (strategy == AllReduceStrategyType::RING)
+                {
+                    NCCLCHECK(ncclAllReduce(params.peer_comm_buffer_ptrs[params.local_rank], output, elts, ncclType,
+                        ncclSum, comm, stream));
+                }
+                else
+                {
+                    params.barrier_flag = ++flag;
+                    kernels::customAllReduce(params, output, elts, elemSize, dataType, strategy, stream);
+                }
+            };
+            for (int iter = 0; iter < kWarmupIterations; ++iter)
+            {
+                run();
+            }
+            TLLM_CUDA_CHECK(cudaEventRecord(start, stream));
+            for (int iter = 0; iter < kIterations; ++iter)
+            {
+                run();
+            }
+            TLLM_CUDA_CHECK(cudaEventRecord(stop, stream));
+            TLLM_CUDA_CHECK(cudaEventSynchronize(stop));
+            float elapsed = 0.f;
+            TLLM_CUDA_CHECK(cudaEventElapsedTime(&elapsed, start, stop));
+            times[ii * kStrategies.size() + jj] = elapsed / kIterations;
+        }
+    }
+
+    float* deviceTimes = static_cast<float*>(output);
+    TLLM_CUDA_CHECK(
+        cudaMemcpyAsync(deviceTimes, times.data(), times.size() * sizeof(float), cudaMemcpyHostToDevice, stream));
+    NCCLCHECK(ncclAllReduce(deviceTimes, deviceTimes, times.size(), ncclFloat32, ncclMax, comm, stream));
+    TLLM_CUDA_CHECK(
+        cudaMemcpyAsync(times.data(), deviceTimes, times.size() * sizeof(float), cudaMemcpyDeviceToHost, stream));
+    TLLM_CUDA_CHECK(cudaStreamSynchronize(stream));
+    TLLM_CUDA_CHECK(cudaEventDestroy(start));
+    TLLM_CUDA_CHECK(cudaEventDestroy(stop));
+    TLLM_CUDA_CHECK(cudaFree(output));
+
+    Strategies strategies;
+    for (std::size_t ii = 0; ii < sizes.size(); ++ii)
+    {
+        auto const* sizeTimes = times.data() + ii * kStrategies.size();
+        auto const best = std::min_element(sizeTimes, sizeTimes + kStrategies.size()) - sizeTimes;
+        strategies.emplace_back(sizes[ii], kStrategies[best]);
+        TLLM_LOG_DEBUG("All-reduce of %zu bytes: RING %.3f ms, ONESHOT %.3f ms, TWOSHOT %.3f ms", sizes[ii],
+            sizeTimes[0], sizeTimes[1], sizeTimes[2]);
+    }
+    return strategies;
+}
+} // namespace
+
+std::optional<AllReduceCalibration::StrategyType> AllReduceCalibration::select(std::size_t messageSize) const
+{
+    auto const it = std::lower_bound(mStrategies.begin(), mStrategies.end(), messageSize,
+        [](auto const& entry, std::size_t size) { return entry.first < size; });
+    if (it == mStrategies.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+AllReduceCalibration const* AllReduceCalibration::find(std::set<int> const& group)
+{
+    auto const& calibrations = getCalibrations();
+    auto const it = calibrations.find(group);
+    return it == calibrations.end() ? nullptr : &it->second;
+}
+
+AllReduceCalibration const& AllReduceCalibration::calibrate(std::set<int> const& group,
+    kernels::AllReduceParams params, nvinfer1::DataType type, std::size_t maxMessageSize, cudaStream_t stream)
+{
+    if (auto const* calibration = find(group))
+    {
+        return *calibration;
+    }
+
+    auto const sizes = getMessageSizes(params.ranks_per_node, maxMessageSize);
+    TLLM_CHECK_WITH_INFO(!sizes.empty(), "No message size to calibrate the all-reduce with");
+    auto const cacheDir = common::getEnvAllReduceCalibrationCacheDir();
+    std::string key;
+    std::optional<Strategies> cached;
+    if (!cacheDir.empty())
+    {
+        key = getCacheKey(params.ranks_per_node);
+        cached = loadCache(getCachePath(cacheDir, key), key, sizes);
+    }
+
+    // The ranks use the cached strategies of the first rank when they all found them, and calibrate together
+    // otherwise. Deciding on each rank alone could leave some ranks waiting in a calibration the others skip.
+    auto* const comm = (*getCommMap())[group];
+    std::vector<int32_t> table(sizes.size() + 1, 0);
+    table[0] = cached.has_value();
+    for (std::size_t ii = 0; cached && ii < sizes.size(); ++ii)
+    {
+        table[ii + 1] = static_cast<int32_t>((*cached)[ii].second);
+    }
+    int32_t* deviceTable = nullptr;
+    TLLM_CUDA_CHECK(cudaMalloc(&deviceTable, table.size() * sizeof(int32_t)));
+    TLLM_CUDA_CHECK(
+        cudaMemcpyAsync(deviceTable, table.data(), table.size() * sizeof(int32_t), cudaMemcpyHostToDevice, stream));
+    NCCLCHECK(ncclAllReduce(deviceTable, deviceTable, 1, ncclInt32, ncclMin, comm, stream));
+    NCCLCHECK(ncclBroadcast(deviceTable + 1, deviceTable + 1, sizes.size(), ncclInt32, 0, comm, stream));
+    TLLM_CUDA_CHECK(
+        cudaMemcpyAsync(table.data(), deviceTable, table.size() * sizeof(int32_t), cudaMemcpyDeviceToHost, stream));
+    TLLM_CUDA_CHECK(cudaStreamSynchronize(stream));
+    TLLM_CUDA_CHECK(cudaFree(deviceTable));
+
+    AllReduceCalibration calibration;
+    if (table[0] != 0)
+    {
+        for (std::size_t ii = 0; ii < sizes.size(); ++ii)
+        {
+            calibration.mStrategies.emplace_back(sizes[ii], static_cast<StrategyType>(table[ii + 1]));
+        }
+        TLLM_LOG_INFO("Loaded the all-reduce calibration of %zu message sizes", sizes.size());
+    }
+    else
+    {
+        calibration.mStrategies = measure(params, type, sizes, comm, stream);
+        if (!cacheDir.empty() && tensorrt_llm::runtime::InProcessWorld::getSessionRank() == *group.begin())
+        {
+            storeCache(getCachePath(cacheDir, key), key, calibration.mStrategies);
+        }
+        TLLM_LOG_INFO("Calibrated the all-reduce on %zu message sizes", sizes.size());
+    }
+    return getCalibrations().emplace(group, std::move(calibration)).first->second;
+}
+
+} // namespace tensorrt_llm::plugins
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
+
+#include <NvInferRuntime.h>
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+//! \brief Strategy of the AUTO all-reduce per message size, from the latencies of NCCL and of the one-shot and two-shot
+//! kernels measured on the machine. The crossovers depend on the links between the GPUs (PCIe, NVLink, NVSwitch) far
+//! more than fixed thresholds can capture.
+//!
+//! The calibration is cached per process and group, and on disk per machine type in the directory of
+//! getEnvAllReduceCalibrationCacheDir. The file is named by a key made of the GPU, the number of ranks, the P2P links
+//! between the GPUs of the node and the CUDA and NCCL versions.
+class AllReduceCalibration
+{
+public:
+    using StrategyType = kernels::AllReduceStrategyType;
+
+    //! \brief Fastest strategy for a message of messageSize bytes, nullopt above the largest calibrated size.
+    [[nodiscard]] std::optional<StrategyType> select(std::size_t messageSize) const;
+
+    //! \brief Calibration of the group in this process, nullptr before calibrate.
+    static AllReduceCalibration const* find(std::set<int> const& group);
+
+    //! \brief Loads the calibration of the group from the on-disk cache, or measures messages of up to maxMessageSize
+    //! bytes. Collective: all the ranks of the group call it together. Uses the NCCL communicator of the group and the
+    //! custom all-reduce workspace of params, and synchronizes the stream.
+    static AllReduceCalibration const& calibrate(std::set<int> const& group, kernels::AllReduceParams params,
+        nvinfer1::DataType type, std::size_t maxMessageSize, cudaStream_t stream);
+
+private:
+    // Message sizes in bytes, ascending, and the strategy of the messages up to each size.
+    std::vector<std::pair<std::size_t, StrategyType>> mStrategies;
+};
+
+} // namespace tensorrt_llm::plugins
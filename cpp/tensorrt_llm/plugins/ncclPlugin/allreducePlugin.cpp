@@ -17,25 +17,36 @@
 #include "allreducePlugin.h"
 
 #include "tensorrt_llm/common/customAllReduceUtils.h"
+#include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/kernels/customAllReduceKernels.h"
+#include "tensorrt_llm/plugins/ncclPlugin/allreduceCalibration.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include <algorithm>
+#include <functional>
 #include <nccl.h>
+#include <numeric>
 
 using namespace nvinfer1;
 using tensorrt_llm::plugins::AllreducePluginCreator;
 using tensorrt_llm::plugins::AllreducePlugin;
+using tensorrt_llm::kernels::AllReduceFusionOp;
 using tensorrt_llm::kernels::AllReduceStrategyType;
+using tensorrt_llm::runtime::InProcessWorld;
 
 static const char* ALLREDUCE_PLUGIN_VERSION{"1"};
 static const char* ALLREDUCE_PLUGIN_NAME{"AllReduce"};
 PluginFieldCollection AllreducePluginCreator::mFC{};
 std::vector<nvinfer1::PluginField> AllreducePluginCreator::mPluginAttributes;
 
-AllreducePlugin::AllreducePlugin(
-    std::set<int> group, nvinfer1::DataType type, AllReduceStrategyType strategy, int32_t counter)
+AllreducePlugin::AllreducePlugin(std::set<int> group, nvinfer1::DataType type, AllReduceStrategyType strategy,
+    AllReduceFusionOp op, float eps, int32_t counter)
     : mGroup(std::move(group))
     , mType(type)
     , mStrategy(strategy)
+    , mOp(op)
+    , mEps(eps)
     , mCounter(counter)
 {
 }
@@ -46,6 +57,8 @@ AllreducePlugin::AllreducePlugin(const void* data, size_t length)
     const char *d = reinterpret_cast<const char*>(data), *a = d;
     read(d, mType);
     read(d, mStrategy);
+    read(d, mOp);
+    read(d, mEps);
     read(d, mCounter);
     mGroup.clear();
     int groupItem = 0;
@@ -65,6 +78,10 @@ AllreducePlugin::AllreducePlugin(const void* data, size_t length)
 nvinfer1::IPluginV2DynamicExt* AllreducePlugin::clone() const noexcept
 {
     auto* plugin = new AllreducePlugin(*this);
+    // The clone creates its own stream and events
+    plugin->mInterNodeGroup.clear();
+    plugin->mInterNodeStream = nullptr;
+    plugin->mInterNodeEvents.clear();
     plugin->setPluginNamespace(mNamespace.c_str());
     return plugin;
 }
@@ -72,9 +89,21 @@ nvinfer1::IPluginV2DynamicExt* AllreducePlugin::clone() const noexcept
 nvinfer1::DimsExprs AllreducePlugin::getOutputDimensions(
     int outputIndex, const nvinfer1::DimsExprs* inputs, int nbInputs, nvinfer1::IExprBuilder& exprBuilder) noexcept
 {
+    if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM_QUANT && outputIndex == 2)
+    {
+        // Per-token scales
+        auto ret = inputs[0];
+        ret.d[ret.nbDims - 1] = exprBuilder.constant(1);
+        return ret;
+    }
     return inputs[0];
 }
 
+int AllreducePlugin::getFusionInputIndex() const noexcept
+{
+    return mStrategy == AllReduceStrategyType::RING ? 1 : 2;
+}
+
 bool AllreducePlugin::supportsFormatCombination(
     int pos, const nvinfer1::PluginTensorDesc* inOut, int nbInputs, int nbOutputs) noexcept
 {
@@ -84,22 +113,41 @@ bool AllreducePlugin::supportsFormatCombination(
     }
     else
     {
-        TLLM_CHECK_WITH_INFO(nbInputs == 2, "Non-RING (aka. NCCL) strategies require a workspace tensor.");
+        TLLM_CHECK_WITH_INFO(nbInputs >= 2, "Non-RING (aka. NCCL) strategies require a workspace tensor.");
+    }
+    if (mOp != AllReduceFusionOp::NONE)
+    {
+        TLLM_CHECK_WITH_INFO(nbInputs == getFusionInputIndex() + 2, "The fused RMSNorm requires residual and weight.");
     }
 
-    if (nbInputs == 2 && pos == 1)
+    if (inOut[pos].format != TensorFormat::kLINEAR)
     {
-        return (inOut[pos].type == nvinfer1::DataType::kINT64) && (inOut[pos].format == TensorFormat::kLINEAR);
+        return false;
     }
-    else
+    if (mStrategy != AllReduceStrategyType::RING && pos == 1)
+    {
+        return inOut[pos].type == nvinfer1::DataType::kINT64;
+    }
+    if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM_QUANT && pos == nbInputs)
+    {
+        return inOut[pos].type == nvinfer1::DataType::kINT8;
+    }
+    if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM_QUANT && pos == nbInputs + 2)
     {
-        return (inOut[pos].type == mType) && (inOut[pos].format == TensorFormat::kLINEAR);
+        return inOut[pos].type == nvinfer1::DataType::kFLOAT;
     }
+    return inOut[pos].type == mType;
 }
 
 void AllreducePlugin::configurePlugin(const nvinfer1::DynamicPluginTensorDesc* in, int nbInputs,
     const nvinfer1::DynamicPluginTensorDesc* out, int nbOutputs) noexcept
 {
+    const auto& maxDims = in[0].max;
+    if (std::all_of(maxDims.d, maxDims.d + maxDims.nbDims, [](auto dim) { return dim > 0; }))
+    {
+        mMaxMessageSize = std::accumulate(maxDims.d, maxDims.d + maxDims.nbDims, size_t{1}, std::multiplies<size_t>())
+            * common::getDTypeSize(mType);
+    }
 }
 
 size_t AllreducePlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
@@ -138,6 +186,47 @@ AllReduceStrategyType AllreducePlugin::selectImplementation(size_t messageSize,
     return AllReduceStrategyType::TWOSHOT;
 }
 
+bool AllreducePlugin::isNvlsPreferred(size_t messageSize, int worldSize) noexcept
+{
+    // The one-shot kernel has the lowest latency for small messages, the switch reduction moves the least data.
+    return worldSize > 2 && messageSize >= 256 * 1000
+        && messageSize <= utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(worldSize);
+}
+
+tensorrt_llm::runtime::MulticastMemory const* AllreducePlugin::findMulticastMemory(
+    const void* workspace, int ranksPerNode) const
+{
+    const auto params = tensorrt_llm::kernels::AllReduceParams::deserialize(reinterpret_cast<const int32_t*>(workspace),
+        ranksPerNode, InProcessWorld::getSessionRank() % ranksPerNode, mCounter);
+    return tensorrt_llm::runtime::MulticastMemory::find(params.peer_comm_buffer_ptrs[params.local_rank]);
+}
+
+AllReduceStrategyType AllreducePlugin::selectCalibratedImplementation(
+    size_t messageSize, const void* workspace, int ranksPerNode, cudaStream_t stream)
+{
+    const auto* calibration = AllReduceCalibration::find(mGroup);
+    cudaStreamCaptureStatus captureStatus;
+    // The calibration synchronizes the stream, it cannot run while a CUDA graph is captured.
+    if (calibration == nullptr && common::getEnvAllReduceCalibration()
+        && cudaStreamIsCapturing(stream, &captureStatus) == cudaSuccess
+        && captureStatus == cudaStreamCaptureStatusNone)
+    {
+        const auto myRank = InProcessWorld::getSessionRank() % ranksPerNode;
+        const auto params = tensorrt_llm::kernels::AllReduceParams::deserialize(
+            reinterpret_cast<const int32_t*>(workspace), ranksPerNode, myRank, mCounter);
+        calibration = &AllReduceCalibration::calibrate(
+            mGroup, params, mType, std::max(messageSize, mMaxMessageSize), stream);
+    }
+    if (calibration != nullptr)
+    {
+        if (const auto strategy = calibration->select(messageSize))
+        {
+            return *strategy;
+        }
+    }
+    return selectImplementation(messageSize, mGroup.size());
+}
+
 int AllreducePlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc, const nvinfer1::PluginTensorDesc* outputDesc,
     const void* const* inputs, void* const* outputs, void* workspace, cudaStream_t stream) noexcept
 {
@@ -172,41 +261,219 @@ int AllreducePlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc, const
     default: break;
     }
 
+    // The workspace connects the ranks of a node
+    int const ranksPerNode = mStrategy == AllReduceStrategyType::RING
+        ? 0
+        : inputDesc[1].dims.d[0] / utils::customAllReduceUtils::NUM_POINTERS_PER_RANK;
+    // The NVLS slices of the ranks are made of 16 bytes vectors, like those of the two-shot kernel.
+    const auto* multicastMemory = ranksPerNode > 1 && static_cast<int>(mGroup.size()) == ranksPerNode
+            && size % (ranksPerNode * 16 / sizePerElem) == 0
+        ? findMulticastMemory(inputs[1], ranksPerNode)
+        : nullptr;
     auto runtimeStrategy = mStrategy;
     if (runtimeStrategy == AllReduceStrategyType::AUTO)
     {
-        runtimeStrategy = selectImplementation(size * sizePerElem, mGroup.size());
+        if (static_cast<int>(mGroup.size()) > ranksPerNode)
+        {
+            runtimeStrategy = AllReduceStrategyType::HIERARCHICAL;
+        }
+        else if (multicastMemory != nullptr && isNvlsPreferred(size * sizePerElem, ranksPerNode))
+        {
+            runtimeStrategy = AllReduceStrategyType::NVLS;
+        }
+        else
+        {
+            runtimeStrategy = selectCalibratedImplementation(size * sizePerElem, inputs[1], ranksPerNode, stream);
+        }
+    }
+    if (runtimeStrategy == AllReduceStrategyType::NVLS && multicastMemory == nullptr)
+    {
+        // Without NCCL, initialize() does not create a communicator for NVLS
+        runtimeStrategy = AllReduceStrategyType::ONESHOT;
+    }
+    if (runtimeStrategy == AllReduceStrategyType::HIERARCHICAL && size % (ranksPerNode * 16 / sizePerElem) != 0)
+    {
+        // The slices of the ranks of a node are made of 16 bytes vectors.
+        runtimeStrategy = AllReduceStrategyType::RING;
+    }
+    if (runtimeStrategy == AllReduceStrategyType::QUANTIZED
+        && (static_cast<int>(mGroup.size()) > ranksPerNode || size % kernels::QUANT_ALL_REDUCE_GROUP_SIZE != 0
+            || size + size / kernels::QUANT_ALL_REDUCE_GROUP_SIZE * sizeof(float)
+                > utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(ranksPerNode)))
+    {
+        // The int8 values and their scales live in the IPC buffers of the node, in whole scale groups.
+        runtimeStrategy = AllReduceStrategyType::RING;
+    }
+
+    // With a fused RMSNorm, outputs[1] receives the sum before the norm, the residual of the next layer.
+    tensorrt_llm::kernels::AllReduceFusionParams fusionParams;
+    if (mOp != AllReduceFusionOp::NONE)
+    {
+        auto const fusionInputIndex = getFusionInputIndex();
+        fusionParams.hidden_size = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
+        fusionParams.residual_buffer = inputs[fusionInputIndex];
+        fusionParams.weight_buffer = inputs[fusionInputIndex + 1];
+        fusionParams.eps = mEps;
+        fusionParams.intermediate_buffer = outputs[1];
+        if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM_QUANT)
+        {
+            fusionParams.quant_output_buffer = reinterpret_cast<int8_t*>(outputs[0]);
+            fusionParams.scale_output_buffer = reinterpret_cast<float*>(outputs[2]);
+        }
     }
 
     if (runtimeStrategy == AllReduceStrategyType::RING)
     {
-        NCCLCHECK(ncclAllReduce(inputs[0], outputs[0], size, (*getDtypeMap())[inputDesc[0].type], ncclSum,
+        void* allReduceOutput = mOp == AllReduceFusionOp::NONE ? outputs[0] : outputs[1];
+        NCCLCHECK(ncclAllReduce(inputs[0], allReduceOutput, size, (*getDtypeMap())[inputDesc[0].type], ncclSum,
             (*getCommMap())[mGroup], stream));
+        if (mOp != AllReduceFusionOp::NONE)
+        {
+            tensorrt_llm::kernels::AllReduceParams params{};
+            params.fusion_params = fusionParams;
+            tensorrt_llm::kernels::residualRmsNorm(params, outputs[0], size, type, stream);
+        }
+    }
+    else if (runtimeStrategy == AllReduceStrategyType::HIERARCHICAL)
+    {
+        void* allReduceOutput = mOp == AllReduceFusionOp::NONE ? outputs[0] : outputs[1];
+        hierarchicalAllReduce(inputs[0], allReduceOutput, inputs[1], size, sizePerElem, type, ranksPerNode, stream);
+        if (mOp != AllReduceFusionOp::NONE)
+        {
+            tensorrt_llm::kernels::AllReduceParams params{};
+            params.fusion_params = fusionParams;
+            tensorrt_llm::kernels::residualRmsNorm(params, outputs[0], size, type, stream);
+        }
+    }
+    else if (runtimeStrategy == AllReduceStrategyType::QUANTIZED)
+    {
+        void* allReduceOutput = mOp == AllReduceFusionOp::NONE ? outputs[0] : outputs[1];
+        auto params = tensorrt_llm::kernels::AllReduceParams::deserialize(reinterpret_cast<const int32_t*>(inputs[1]),
+            ranksPerNode, InProcessWorld::getSessionRank() % ranksPerNode, mCounter);
+        params.device_barrier_flag = true;
+        tensorrt_llm::kernels::customQuantizedAllReduce(params, inputs[0], allReduceOutput, size, type, stream);
+        if (mOp != AllReduceFusionOp::NONE)
+        {
+            params.fusion_params = fusionParams;
+            tensorrt_llm::kernels::residualRmsNorm(params, outputs[0], size, type, stream);
+        }
     }
     else
     {
-        auto myRank = COMM_SESSION.getRank();
+        auto myRank = InProcessWorld::getSessionRank();
         int nRanks = inputDesc[1].dims.d[0] / utils::customAllReduceUtils::NUM_POINTERS_PER_RANK;
         // FIXME: pass world config here
         myRank = myRank % nRanks;
 
         auto params = tensorrt_llm::kernels::AllReduceParams::deserialize(
             reinterpret_cast<const int32_t*>(inputs[1]), nRanks, myRank, mCounter);
+        // The barriers do not depend on host values that change from one launch to the next, a captured all-reduce
+        // can be replayed. mCounter still picks the ping or the pong buffers, it is constant for this layer.
+        params.device_barrier_flag = true;
+        if (runtimeStrategy == AllReduceStrategyType::NVLS)
+        {
+            // The inputs are reduced from the buffers bound to the multicast object instead of the IPC buffers
+            params.peer_comm_buffer_ptrs[myRank] = multicastMemory->getUnicastPtr();
+            params.multicast_ptr = multicastMemory->getMulticastPtr();
+        }
 
         cudaMemcpyAsync(
             params.peer_comm_buffer_ptrs[myRank], inputs[0], size * sizePerElem, cudaMemcpyDeviceToDevice, stream);
 
-        tensorrt_llm::kernels::customAllReduce(params, outputs[0], size, sizePerElem, type, runtimeStrategy, stream);
+        params.fusion_params = fusionParams;
+        tensorrt_llm::kernels::customAllReduce(
+            params, outputs[0], size, sizePerElem, type, runtimeStrategy, stream, mOp);
     }
 
     return 0;
 }
 
+void AllreducePlugin::initInterNode(int ranksPerNode)
+{
+    if (mInterNodeStream != nullptr)
+    {
+        return;
+    }
+    TLLM_CHECK_WITH_INFO(isCustomAllReduceSuported(ranksPerNode) && mGroup.size() % ranksPerNode == 0,
+        "HIERARCHICAL all-reduce needs a group of whole nodes, got %d ranks per node for %d ranks", ranksPerNode,
+        static_cast<int>(mGroup.size()));
+
+    // The ranks of a node are consecutive in the group.
+    const std::vector<int> group(mGroup.begin(), mGroup.end());
+    const auto groupRank = std::distance(mGroup.begin(), mGroup.find(InProcessWorld::getSessionRank()));
+    for (auto rank = groupRank % ranksPerNode; rank < static_cast<decltype(rank)>(group.size()); rank += ranksPerNode)
+    {
+        mInterNodeGroup.insert(group[rank]);
+    }
+    initCommMap(mInterNodeGroup);
+
+    TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&mInterNodeStream, cudaStreamNonBlocking));
+    // A pair of events per chunk, the node-local sum being ready and the sum across nodes being ready.
+    mInterNodeEvents.resize(2 * kernels::MAX_HIERARCHICAL_CHUNKS);
+    for (auto& event : mInterNodeEvents)
+    {
+        TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    }
+}
+
+void AllreducePlugin::hierarchicalAllReduce(const void* input, void* output, const void* workspace, size_t size,
+    size_t sizePerElem, common::datatype_enum type, int ranksPerNode, cudaStream_t stream)
+{
+    initInterNode(ranksPerNode);
+
+    const int localRank = static_cast<int>(
+        std::distance(mGroup.begin(), mGroup.find(InProcessWorld::getSessionRank())) % ranksPerNode);
+    auto params = tensorrt_llm::kernels::AllReduceParams::deserialize(
+        reinterpret_cast<const int32_t*>(workspace), ranksPerNode, localRank, mCounter);
+    cudaMemcpyAsync(
+        params.peer_comm_buffer_ptrs[localRank], input, size * sizePerElem, cudaMemcpyDeviceToDevice, stream);
+
+    const auto ncclType = (*getDtypeMap())[mType];
+    auto* const interNodeComm = (*getCommMap())[mInterNodeGroup];
+
+    // Chunks below 1MB do not amortize the launches of the three phases.
+    constexpr size_t kMinChunkSize = 1 << 20;
+    const size_t unit = ranksPerNode * 16 / sizePerElem;
+    const size_t numChunks
+        = std::clamp<size_t>(size * sizePerElem / kMinChunkSize, 1, kernels::MAX_HIERARCHICAL_CHUNKS);
+    const size_t chunkSize = unit * common::divUp(size / unit, numChunks);
+
+    // The node-local phases run on the stream of the plugin, the all-reduce across nodes on the side stream. Chunk i is
+    // all-reduced across nodes while the ranks of the node reduce chunk i + 1 and gather chunk i - 1.
+    auto* const localBuffer = static_cast<char*>(params.peer_comm_buffer_ptrs[localRank]);
+    int chunk = 0;
+    for (size_t offset = 0; offset < size; offset += chunkSize, ++chunk)
+    {
+        const auto elts = std::min(chunkSize, size - offset);
+        tensorrt_llm::kernels::customReduceScatter(params, offset, elts, type, stream);
+
+        // The sum of the slice of this rank is updated in place, where the all-gather reads it.
+        void* slice = localBuffer + (offset + localRank * (elts / ranksPerNode)) * sizePerElem;
+        TLLM_CUDA_CHECK(cudaEventRecord(mInterNodeEvents[2 * chunk], stream));
+        TLLM_CUDA_CHECK(cudaStreamWaitEvent(mInterNodeStream, mInterNodeEvents[2 * chunk]));
+        NCCLCHECK(ncclAllReduce(slice, slice, elts / ranksPerNode, ncclType, ncclSum, interNodeComm, mInterNodeStream));
+        TLLM_CUDA_CHECK(cudaEventRecord(mInterNodeEvents[2 * chunk + 1], mInterNodeStream));
+    }
+
+    chunk = 0;
+    for (size_t offset = 0; offset < size; offset += chunkSize, ++chunk)
+    {
+        const auto elts = std::min(chunkSize, size - offset);
+        TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, mInterNodeEvents[2 * chunk + 1]));
+        tensorrt_llm::kernels::customAllGather(params, output, offset, elts, chunk, type, stream);
+    }
+}
+
 // IPluginV2Ext Methods
 nvinfer1::DataType AllreducePlugin::getOutputDataType(
     int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
 {
-    assert(index == 0);
+    if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM_QUANT)
+    {
+        assert(index <= 2);
+        return index == 0 ? nvinfer1::DataType::kINT8 : (index == 1 ? inputTypes[0] : nvinfer1::DataType::kFLOAT);
+    }
+    assert(index == 0 || (index == 1 && mOp != AllReduceFusionOp::NONE));
     return inputTypes[0];
 }
 
@@ -224,7 +491,12 @@ const char* AllreducePlugin::getPluginVersion() const noexcept
 
 int AllreducePlugin::getNbOutputs() const noexcept
 {
-    return 1;
+    switch (mOp)
+    {
+    case AllReduceFusionOp::RESIDUAL_RMS_NORM: return 2;
+    case AllReduceFusionOp::RESIDUAL_RMS_NORM_QUANT: return 3;
+    default: return 1;
+    }
 }
 
 bool AllreducePlugin::isCustomAllReduceSuported(int ranks_per_node) const noexcept
@@ -242,7 +514,8 @@ bool AllreducePlugin::isCustomAllReduceSuported(int ranks_per_node) const noexce
 
 int AllreducePlugin::initialize() noexcept
 {
-    if (isBuilding() || mStrategy == AllReduceStrategyType::ONESHOT || mStrategy == AllReduceStrategyType::TWOSHOT)
+    if (isBuilding() || mStrategy == AllReduceStrategyType::ONESHOT || mStrategy == AllReduceStrategyType::TWOSHOT
+        || mStrategy == AllReduceStrategyType::NVLS)
     {
         return 0;
     }
@@ -253,22 +526,30 @@ int AllreducePlugin::initialize() noexcept
 
 void AllreducePlugin::terminate() noexcept
 {
-    if (mStrategy == AllReduceStrategyType::RING || mStrategy == AllReduceStrategyType::AUTO)
+    if (mInterNodeStream != nullptr)
     {
-        auto* commMap = getCommMap();
-        // [] operator inserts T() if it does not exist
-        if (isBuilding() || (*commMap)[mGroup] == nullptr)
+        for (auto event : mInterNodeEvents)
         {
-            return;
+            cudaEventDestroy(event);
         }
-        NCCLCHECK(ncclCommDestroy((*commMap)[mGroup]));
-        (*commMap)[mGroup] = nullptr;
+        mInterNodeEvents.clear();
+        cudaStreamDestroy(mInterNodeStream);
+        mInterNodeStream = nullptr;
+
+        releaseCommMap(mInterNodeGroup);
+        mInterNodeGroup.clear();
+    }
+    if (mStrategy == AllReduceStrategyType::RING || mStrategy == AllReduceStrategyType::AUTO
+        || mStrategy == AllReduceStrategyType::HIERARCHICAL || mStrategy == AllReduceStrategyType::QUANTIZED)
+    {
+        releaseCommMap(mGroup);
     }
 }
 
 size_t AllreducePlugin::getSerializationSize() const noexcept
 {
-    return sizeof(int) * mGroup.size() + sizeof(mType) + sizeof(mStrategy) + sizeof(mCounter);
+    return sizeof(int) * mGroup.size() + sizeof(mType) + sizeof(mStrategy) + sizeof(mOp) + sizeof(mEps)
+        + sizeof(mCounter);
 }
 
 void AllreducePlugin::serialize(void* buffer) const noexcept
@@ -276,6 +557,8 @@ void AllreducePlugin::serialize(void* buffer) const noexcept
     char *d = static_cast<char*>(buffer), *a = d;
     write(d, mType);
     write(d, mStrategy);
+    write(d, mOp);
+    write(d, mEps);
     write(d, mCounter);
     for (auto it = mGroup.begin(); it != mGroup.end(); ++it)
     {
@@ -299,6 +582,8 @@ AllreducePluginCreator::AllreducePluginCreator()
     mPluginAttributes.emplace_back(PluginField("group", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("strategy", nullptr, PluginFieldType::kINT8, 1));
+    mPluginAttributes.emplace_back(PluginField("fusion_op", nullptr, PluginFieldType::kINT8, 1));
+    mPluginAttributes.emplace_back(PluginField("eps", nullptr, PluginFieldType::kFLOAT32, 1));
     mPluginAttributes.emplace_back(PluginField("counter", nullptr, PluginFieldType::kINT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
@@ -325,6 +610,8 @@ IPluginV2* AllreducePluginCreator::createPlugin(const char* name, const PluginFi
     std::set<int> group;
     nvinfer1::DataType type;
     AllReduceStrategyType strategy;
+    AllReduceFusionOp op{AllReduceFusionOp::NONE};
+    float eps{1e-6f};
     int32_t counter;
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
@@ -350,6 +637,16 @@ IPluginV2* AllreducePluginCreator::createPlugin(const char* name, const PluginFi
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT8);
             strategy = static_cast<AllReduceStrategyType>(*static_cast<const int8_t*>(fields[i].data));
         }
+        else if (!strcmp(attrName, "fusion_op"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT8);
+            op = static_cast<AllReduceFusionOp>(*static_cast<const int8_t*>(fields[i].data));
+        }
+        else if (!strcmp(attrName, "eps"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kFLOAT32);
+            eps = *static_cast<const float*>(fields[i].data);
+        }
         else if (!strcmp(attrName, "counter"))
         {
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
@@ -359,7 +656,7 @@ IPluginV2* AllreducePluginCreator::createPlugin(const char* name, const PluginFi
 
     try
     {
-        auto* obj = new AllreducePlugin(group, type, strategy, counter);
+        auto* obj = new AllreducePlugin(group, type, strategy, op, eps, counter);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
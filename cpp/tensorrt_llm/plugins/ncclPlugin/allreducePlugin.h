@@ -18,6 +18,7 @@
 
 #include "tensorrt_llm/kernels/customAllReduceKernels.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
+#include "tensorrt_llm/runtime/ipcUtils.h"
 
 #include <cassert>
 #include <memory>
@@ -31,8 +32,8 @@ namespace tensorrt_llm::plugins
 class AllreducePlugin : public BasePlugin
 {
 public:
-    AllreducePlugin(
-        std::set<int> group, nvinfer1::DataType type, kernels::AllReduceStrategyType strategy, int32_t counter);
+    AllreducePlugin(std::set<int> group, nvinfer1::DataType type, kernels::AllReduceStrategyType strategy,
+        kernels::AllReduceFusionOp op, float eps, int32_t counter);
 
     AllreducePlugin(const void* data, size_t length);
 
@@ -69,11 +70,36 @@ public:
 
 private:
     static kernels::AllReduceStrategyType selectImplementation(size_t messageSize, int worldSize) noexcept;
+    // AUTO within a node whose GPUs share an NVLink multicast object: whether NVLS beats the one-shot and two-shot
+    // kernels and NCCL.
+    static bool isNvlsPreferred(size_t messageSize, int worldSize) noexcept;
+    // NVLS buffer paired with the ping or pong buffer of the plugin in the workspace, nullptr if there is none.
+    runtime::MulticastMemory const* findMulticastMemory(const void* workspace, int ranksPerNode) const;
+    // AUTO within a node: the calibrated strategy, calibrating on the first call, or the fixed thresholds of
+    // selectImplementation.
+    kernels::AllReduceStrategyType selectCalibratedImplementation(
+        size_t messageSize, const void* workspace, int ranksPerNode, cudaStream_t stream);
+    // Index of the residual input, followed by the norm weight.
+    int getFusionInputIndex() const noexcept;
+    // The ranks per node are only known from the workspace, so the HIERARCHICAL resources are created on the first
+    // enqueue.
+    void initInterNode(int ranksPerNode);
+    void hierarchicalAllReduce(const void* input, void* output, const void* workspace, size_t size, size_t sizePerElem,
+        common::datatype_enum type, int ranksPerNode, cudaStream_t stream);
     const std::string mLayerName;
     std::set<int> mGroup;
     nvinfer1::DataType mType;
     kernels::AllReduceStrategyType mStrategy;
+    kernels::AllReduceFusionOp mOp;
+    float mEps;
     int32_t mCounter;
+    // Largest message of the optimization profile in bytes, the range of the AUTO calibration.
+    size_t mMaxMessageSize{0};
+    // HIERARCHICAL: ranks of the group with the same local rank on the other nodes, and the stream and events that
+    // pipeline the all-reduce across nodes with the node-local phases.
+    std::set<int> mInterNodeGroup;
+    cudaStream_t mInterNodeStream{nullptr};
+    std::vector<cudaEvent_t> mInterNodeEvents;
 };
 
 class AllreducePluginCreator : public BaseCreator
@@ -17,12 +17,16 @@
 #include "recvPlugin.h"
 
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
 
+#include <algorithm>
+#include <iterator>
 #include <nccl.h>
 
 using namespace nvinfer1;
 using tensorrt_llm::plugins::RecvPluginCreator;
 using tensorrt_llm::plugins::RecvPlugin;
+using tensorrt_llm::runtime::InProcessWorld;
 
 static const char* RECV_PLUGIN_VERSION{"1"};
 static const char* RECV_PLUGIN_NAME{"Recv"};
@@ -128,7 +132,19 @@ int RecvPlugin::initialize() noexcept
         return 0;
     }
     ncclUniqueId id;
-    COMM_SESSION.recv(id, mSrcRank, 0);
+    if (auto* world = InProcessWorld::getCurrent())
+    {
+        // Only the sender contributes to the exchange
+        auto const myRank = InProcessWorld::getSessionRank();
+        auto const parts = world->allgather({myRank, mSrcRank}, {});
+        auto const& sent = parts[mSrcRank < myRank ? 0 : 1];
+        TLLM_CHECK(sent.size() == sizeof(id.internal));
+        std::copy(sent.begin(), sent.end(), std::begin(id.internal));
+    }
+    else
+    {
+        COMM_SESSION.recv(id, mSrcRank, 0);
+    }
     NCCLCHECK(ncclCommInitRank(&mComm, 2, id, 1));
     return 0;
 }
@@ -16,6 +16,8 @@
  */
 #include "reduceScatterPlugin.h"
 
+#include "tensorrt_llm/common/tensor.h"
+
 #include <cassert>
 #include <nccl.h>
 
@@ -28,10 +30,14 @@ static const char* REDUCE_SCATTER_PLUGIN_NAME{"ReduceScatter"};
 PluginFieldCollection ReduceScatterPluginCreator::mFC{};
 std::vector<PluginField> ReduceScatterPluginCreator::mPluginAttributes;
 
-ReduceScatterPlugin::ReduceScatterPlugin(std::set<int> group, nvinfer1::DataType type)
+ReduceScatterPlugin::ReduceScatterPlugin(std::set<int> group, nvinfer1::DataType type, AllReduceFusionOp op, float eps)
     : mGroup(std::move(group))
     , mType(type)
+    , mOp(op)
+    , mEps(eps)
 {
+    TLLM_CHECK_WITH_INFO(mOp == AllReduceFusionOp::NONE || mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM,
+        "The reduce-scatter only fuses the residual RMSNorm");
 }
 
 // Parameterized constructor
@@ -39,6 +45,8 @@ ReduceScatterPlugin::ReduceScatterPlugin(const void* data, size_t length)
 {
     const char *d = reinterpret_cast<const char*>(data), *a = d;
     read(d, mType);
+    read(d, mOp);
+    read(d, mEps);
     mGroup.clear();
     int groupItem = 0;
     while (d != a + length)
@@ -101,8 +109,26 @@ int ReduceScatterPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
         size *= outputDesc[0].dims.d[i];
     }
 
-    NCCLCHECK(ncclReduceScatter(
-        inputs[0], outputs[0], size, (*getDtypeMap())[inputDesc[0].type], ncclSum, (*getCommMap())[mGroup], stream));
+    // With the fused norm, the reduced shard is the residual output, updated in place with the residual.
+    void* reduceScatterOutput = mOp == AllReduceFusionOp::NONE ? outputs[0] : outputs[1];
+    NCCLCHECK(ncclReduceScatter(inputs[0], reduceScatterOutput, size, (*getDtypeMap())[inputDesc[0].type], ncclSum,
+        (*getCommMap())[mGroup], stream));
+
+    if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM)
+    {
+        tensorrt_llm::kernels::AllReduceParams params{};
+        auto& fusionParams = params.fusion_params;
+        fusionParams.hidden_size = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
+        fusionParams.residual_buffer = inputs[1];
+        fusionParams.weight_buffer = inputs[2];
+        fusionParams.eps = mEps;
+        fusionParams.intermediate_buffer = outputs[1];
+        using tensorrt_llm::common::datatype_enum;
+        auto const type = mType == DataType::kFLOAT
+            ? datatype_enum::TYPE_FP32
+            : (mType == DataType::kHALF ? datatype_enum::TYPE_FP16 : datatype_enum::TYPE_BF16);
+        tensorrt_llm::kernels::residualRmsNorm(params, outputs[0], size, type, stream);
+    }
 
     return 0;
 }
@@ -111,7 +137,7 @@ int ReduceScatterPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
 nvinfer1::DataType ReduceScatterPlugin::getOutputDataType(
     int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
 {
-    assert(index == 0);
+    assert(index == 0 || (index == 1 && mOp != AllReduceFusionOp::NONE));
     return inputTypes[0];
 }
 
@@ -129,7 +155,7 @@ const char* ReduceScatterPlugin::getPluginVersion() const noexcept
 
 int ReduceScatterPlugin::getNbOutputs() const noexcept
 {
-    return 1;
+    return mOp == AllReduceFusionOp::NONE ? 1 : 2;
 }
 
 int ReduceScatterPlugin::initialize() noexcept
@@ -140,25 +166,20 @@ int ReduceScatterPlugin::initialize() noexcept
 
 void ReduceScatterPlugin::terminate() noexcept
 {
-    auto* commMap = getCommMap();
-    // [] operator inserts T() if it does not exist
-    if (isBuilding() || (*commMap)[mGroup] == nullptr)
-    {
-        return;
-    }
-    NCCLCHECK(ncclCommDestroy((*commMap)[mGroup]));
-    (*commMap)[mGroup] = nullptr;
+    releaseCommMap(mGroup);
 }
 
 size_t ReduceScatterPlugin::getSerializationSize() const noexcept
 {
-    return sizeof(int) * mGroup.size() + sizeof(mType);
+    return sizeof(int) * mGroup.size() + sizeof(mType) + sizeof(mOp) + sizeof(mEps);
 }
 
 void ReduceScatterPlugin::serialize(void* buffer) const noexcept
 {
     char *d = static_cast<char*>(buffer), *a = d;
     write(d, mType);
+    write(d, mOp);
+    write(d, mEps);
     for (auto it = mGroup.begin(); it != mGroup.end(); ++it)
     {
         write(d, *it);
@@ -180,6 +201,8 @@ ReduceScatterPluginCreator::ReduceScatterPluginCreator()
     mPluginAttributes.clear();
     mPluginAttributes.emplace_back(PluginField("group", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("fusion_op", nullptr, PluginFieldType::kINT8, 1));
+    mPluginAttributes.emplace_back(PluginField("eps", nullptr, PluginFieldType::kFLOAT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -204,6 +227,8 @@ IPluginV2* ReduceScatterPluginCreator::createPlugin(const char* name, const Plug
     const PluginField* fields = fc->fields;
     std::set<int> group;
     nvinfer1::DataType type;
+    auto op = ReduceScatterPlugin::AllReduceFusionOp::NONE;
+    float eps = 1e-6f;
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
     {
@@ -223,11 +248,21 @@ IPluginV2* ReduceScatterPluginCreator::createPlugin(const char* name, const Plug
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
             type = static_cast<nvinfer1::DataType>(*(static_cast<const nvinfer1::DataType*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "fusion_op"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT8);
+            op = static_cast<ReduceScatterPlugin::AllReduceFusionOp>(*static_cast<const int8_t*>(fields[i].data));
+        }
+        else if (!strcmp(attrName, "eps"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kFLOAT32);
+            eps = *static_cast<const float*>(fields[i].data);
+        }
     }
 
     try
     {
-        auto* obj = new ReduceScatterPlugin(group, type);
+        auto* obj = new ReduceScatterPlugin(group, type, op, eps);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
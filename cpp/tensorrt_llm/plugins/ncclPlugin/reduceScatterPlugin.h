@@ -16,6 +16,7 @@
  */
 #pragma once
 
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
 #include <set>
 #include <string>
@@ -24,10 +25,16 @@
 namespace tensorrt_llm::plugins
 {
 
+// Reduce-scatter along the first dimension, the tokens. With a fused residual RMSNorm, the sequence-parallel
+// replacement of the all-reduce at the end of a tensor-parallel block: the inputs are [input, residual shard, weight]
+// and the outputs [normed shard, input shard + residual shard], so the norm runs on 1/TP of the tokens of each rank.
 class ReduceScatterPlugin : public BasePlugin
 {
 public:
-    ReduceScatterPlugin(std::set<int> group, nvinfer1::DataType type);
+    using AllReduceFusionOp = kernels::AllReduceFusionOp;
+
+    ReduceScatterPlugin(std::set<int> group, nvinfer1::DataType type,
+        AllReduceFusionOp op = AllReduceFusionOp::NONE, float eps = 1e-6f);
 
     ReduceScatterPlugin(const void* data, size_t length);
 
@@ -64,6 +71,8 @@ private:
     const std::string mLayerName;
     std::set<int> mGroup;
     nvinfer1::DataType mType;
+    AllReduceFusionOp mOp;
+    float mEps;
 };
 
 class ReduceScatterPluginCreator : public BaseCreator
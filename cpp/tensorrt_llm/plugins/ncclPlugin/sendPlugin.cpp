@@ -17,13 +17,17 @@
 #include "sendPlugin.h"
 
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
 
 #include <cassert>
+#include <iterator>
 #include <nccl.h>
+#include <vector>
 
 using namespace nvinfer1;
 using tensorrt_llm::plugins::SendPluginCreator;
 using tensorrt_llm::plugins::SendPlugin;
+using tensorrt_llm::runtime::InProcessWorld;
 
 static const char* SEND_PLUGIN_VERSION{"1"};
 static const char* SEND_PLUGIN_NAME{"Send"};
@@ -131,7 +135,15 @@ int SendPlugin::initialize() noexcept
 
     ncclUniqueId id;
     ncclGetUniqueId(&id);
-    COMM_SESSION.send(id, mTgtRank, 0);
+    if (auto* world = InProcessWorld::getCurrent())
+    {
+        world->allgather({InProcessWorld::getSessionRank(), mTgtRank},
+            std::vector<char>(std::begin(id.internal), std::end(id.internal)));
+    }
+    else
+    {
+        COMM_SESSION.send(id, mTgtRank, 0);
+    }
     NCCLCHECK(ncclCommInitRank(&mComm, 2, id, 0));
     return 0;
 }
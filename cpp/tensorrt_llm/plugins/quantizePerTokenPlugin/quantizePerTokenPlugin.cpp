@@ -131,12 +131,14 @@ int QuantizePerTokenPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
     if (inputDesc[0].type == DataType::kFLOAT)
     {
         invokePerTokenQuantization<float>(reinterpret_cast<int8_t*>(outputs[0]),
-            reinterpret_cast<const float*>(inputs[0]), m, k, reinterpret_cast<float*>(outputs[1]), stream);
+            reinterpret_cast<const float*>(inputs[0]), m, k, reinterpret_cast<float*>(outputs[1]), nullptr,
+            stream);
     }
     else
     {
         invokePerTokenQuantization<half>(reinterpret_cast<int8_t*>(outputs[0]),
-            reinterpret_cast<const half*>(inputs[0]), m, k, reinterpret_cast<float*>(outputs[1]), stream);
+            reinterpret_cast<const half*>(inputs[0]), m, k, reinterpret_cast<float*>(outputs[1]), nullptr,
+            stream);
     }
 
     return 0;
@@ -106,7 +106,10 @@ void SelectiveScanPlugin::configurePlugin(const nvinfer1::DynamicPluginTensorDes
 size_t SelectiveScanPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
     const nvinfer1::PluginTensorDesc* outputs, int nbOutputs) const noexcept
 {
-    return 0;
+    // Partial states of the chunked scan of long prompts
+    auto const batchSize = inputs[getInputTensorIdx()].dims.d[0];
+    auto const seqLen = inputs[getInputTensorIdx()].dims.d[1];
+    return getSelectiveScanChunkedWorkspaceSize(batchSize, mDim, seqLen, mDState);
 }
 
 void SelectiveScanPlugin::setSSMParams(SSMParamsBase& params, const size_t batch, const size_t dim, const size_t seqLen,
@@ -174,7 +177,14 @@ int SelectiveScanPlugin::enqueueImpl(const nvinfer1::PluginTensorDesc* inputDesc
 
     if (reqTypes[0] == RequestType::kCONTEXT)
     {
-        invokeSelectiveScan<T, float>(ssm_params, stream);
+        if (useSelectiveScanChunked(batch_size, mDim, seq_len))
+        {
+            invokeSelectiveScanChunked<T, float>(ssm_params, workspace, stream);
+        }
+        else
+        {
+            invokeSelectiveScan<T, float>(ssm_params, stream);
+        }
     }
     else if (reqTypes[0] == RequestType::kGENERATION)
     {
@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 #include "smoothQuantGemmPlugin.h"
+#include "tensorrt_llm/kernels/quantization.h"
 #include <numeric>
 
 using namespace nvinfer1;
@@ -69,10 +70,11 @@ std::vector<SmoothQuantGemmPluginProfiler::Config> SmoothQuantGemmPluginProfiler
     return mRunner->getConfigs();
 }
 
-SmoothQuantGemmPlugin::SmoothQuantGemmPlugin(
-    QuantMode quantMode, nvinfer1::DataType type, const SmoothQuantGemmPlugin::PluginProfilerPtr& pluginProfiler)
+SmoothQuantGemmPlugin::SmoothQuantGemmPlugin(QuantMode quantMode, nvinfer1::DataType type,
+    const SmoothQuantGemmPlugin::PluginProfilerPtr& pluginProfiler, bool quantizeActivations)
     : mQuantMode(quantMode)
     , mPluginProfiler(pluginProfiler)
+    , mQuantizeActivations(quantizeActivations)
 {
     init(type);
 }
@@ -89,6 +91,7 @@ SmoothQuantGemmPlugin::SmoothQuantGemmPlugin(
     read(d, quantMode);
     read(d, type);
     read(d, mDims);
+    read(d, mQuantizeActivations);
 
     mQuantMode = QuantMode(quantMode);
 
@@ -118,12 +121,22 @@ void SmoothQuantGemmPlugin::init(nvinfer1::DataType type)
     {
         m_sqGemmRunner = std::make_shared<CutlassInt8GemmRunner<int32_t>>();
     }
+#ifdef ENABLE_BF16
+    else if (mType == nvinfer1::DataType::kBF16)
+    {
+        m_sqGemmRunner = std::make_shared<CutlassInt8GemmRunner<__nv_bfloat16>>();
+    }
+#endif
     else
     {
-        // TODO: add bf16 support
-        TLLM_THROW("Support for bf16 is missing");
+        TLLM_THROW("Unsupported data type");
     }
 
+    TLLM_CHECK_WITH_INFO(!mQuantizeActivations || mQuantMode.hasPerTokenScaling(),
+        "Quantizing the activations in the SmoothQuant GEMM requires per-token scaling");
+    TLLM_CHECK_WITH_INFO(!mQuantizeActivations || mType != nvinfer1::DataType::kINT32,
+        "Quantizing the activations in the SmoothQuant GEMM requires floating point activations");
+
     mPluginProfiler->setQuantMode(mQuantMode);
 
     mGemmId = GemmIdCore(mDims.n, mDims.k, mType);
@@ -168,15 +181,16 @@ bool SmoothQuantGemmPlugin::supportsFormatCombination(
     {
     case 0:
         // activation
-        return inOut[pos].type == nvinfer1::DataType::kINT8 && inOut[pos].format == TensorFormat::kLINEAR;
+        return inOut[pos].type == (mQuantizeActivations ? mType : nvinfer1::DataType::kINT8)
+            && inOut[pos].format == TensorFormat::kLINEAR;
     case 1:
         // weights
         // Weights stored in checkpoint must have int8 type
         return inOut[pos].type == nvinfer1::DataType::kINT8 && inOut[pos].format == TensorFormat::kLINEAR;
     case 2:
-        // scales channels
+        // scales tokens, or the smoothing scales [1, K] with mQuantizeActivations
     case 3:
-        // scales tokens
+        // scales channels
         return inOut[pos].type == nvinfer1::DataType::kFLOAT && inOut[pos].format == TensorFormat::kLINEAR;
     case 4:
         // out
@@ -209,6 +223,15 @@ void SmoothQuantGemmPlugin::configurePlugin(const nvinfer1::DynamicPluginTensorD
     mGemmId = {maxN, maxK, mType};
 
     m_workspaceMaxSize = m_sqGemmRunner->getWorkspaceSize(maxM, maxN, maxK);
+    if (mQuantizeActivations)
+    {
+        std::vector<size_t> workspaces = {
+            static_cast<size_t>(maxM) * maxK * sizeof(int8_t), // quantized activations
+            maxM * sizeof(float),                              // per-token scales
+            m_workspaceMaxSize                                 // GEMM workspace
+        };
+        m_workspaceMaxSize = calculateTotalWorkspaceSize(workspaces.data(), workspaces.size());
+    }
 }
 
 size_t SmoothQuantGemmPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
@@ -222,9 +245,10 @@ int SmoothQuantGemmPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
     cudaStream_t stream) noexcept
 {
     // inputs
-    //     mat1           [M(*), K]
+    //     mat1           [M(*), K], int8, or mType with mQuantizeActivations
     //     mat2           [N, K]
     //     scale_tokens   [M, 1] if has_per_token_scaling else [1, 1]
+    //                    smoothing scales [1, K] with mQuantizeActivations, multiplied with mat1 before quantization
     //     scale_channels [1, N] if has_per_channel_scaling else [1, 1]
     // outputs
     //     mat [M(*), N]
@@ -237,11 +261,42 @@ int SmoothQuantGemmPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
     const int k = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
     const int wsSize = m_sqGemmRunner->getWorkspaceSize(m, n, k);
 
+    auto const* activations = reinterpret_cast<const int8_t*>(inputs[0]);
+    auto const* tokenScales = reinterpret_cast<const float*>(inputs[2]);
+    auto* gemmWorkspace = reinterpret_cast<char*>(workspace);
+    if (mQuantizeActivations)
+    {
+        auto* quantized = reinterpret_cast<int8_t*>(workspace);
+        auto* scales = reinterpret_cast<float*>(nextWorkspacePtr(quantized, static_cast<size_t>(m) * k));
+        gemmWorkspace = reinterpret_cast<char*>(
+            nextWorkspacePtr(reinterpret_cast<int8_t*>(scales), static_cast<size_t>(m) * sizeof(float)));
+        auto const* smoothScales = reinterpret_cast<const float*>(inputs[2]);
+        if (mType == nvinfer1::DataType::kHALF)
+        {
+            tensorrt_llm::kernels::invokePerTokenQuantization(
+                quantized, reinterpret_cast<const half*>(inputs[0]), m, k, scales, smoothScales, stream);
+        }
+        else if (mType == nvinfer1::DataType::kFLOAT)
+        {
+            tensorrt_llm::kernels::invokePerTokenQuantization(
+                quantized, reinterpret_cast<const float*>(inputs[0]), m, k, scales, smoothScales, stream);
+        }
+#ifdef ENABLE_BF16
+        else if (mType == nvinfer1::DataType::kBF16)
+        {
+            tensorrt_llm::kernels::invokePerTokenQuantization(
+                quantized, reinterpret_cast<const __nv_bfloat16*>(inputs[0]), m, k, scales, smoothScales, stream);
+        }
+#endif
+        activations = quantized;
+        tokenScales = scales;
+    }
+
     const auto& bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
     TLLM_CHECK_WITH_INFO(bestTactic, "No valid SQ GEMM tactic");
-    m_sqGemmRunner->gemm(reinterpret_cast<const int8_t*>(inputs[0]), reinterpret_cast<const int8_t*>(inputs[1]),
-        mQuantMode, reinterpret_cast<const float*>(inputs[3]), reinterpret_cast<const float*>(inputs[2]),
-        reinterpret_cast<void*>(outputs[0]), m, n, k, *bestTactic, reinterpret_cast<char*>(workspace), wsSize, stream);
+    m_sqGemmRunner->gemm(activations, reinterpret_cast<const int8_t*>(inputs[1]), mQuantMode,
+        reinterpret_cast<const float*>(inputs[3]), tokenScales, reinterpret_cast<void*>(outputs[0]), m, n, k,
+        *bestTactic, gemmWorkspace, wsSize, stream);
 
     return 0;
 }
@@ -284,6 +339,7 @@ size_t SmoothQuantGemmPlugin::getSerializationSize() const noexcept
     return sizeof(unsigned int) +                       // QuantMode
         sizeof(nvinfer1::DataType) +                    // dtype
         sizeof(mDims) +                                 // Dimensions
+        sizeof(mQuantizeActivations) +                  // quantize activations
         mPluginProfiler->getSerializationSize(mGemmId); // selected tactics container size
 }
 
@@ -293,6 +349,7 @@ void SmoothQuantGemmPlugin::serialize(void* buffer) const noexcept
     write(d, mQuantMode.value());
     write(d, mType);
     write(d, mDims);
+    write(d, mQuantizeActivations);
 
     mPluginProfiler->serialize(d, mGemmId);
     assert(d == a + getSerializationSize());
@@ -318,6 +375,7 @@ SmoothQuantGemmPluginCreator::SmoothQuantGemmPluginCreator()
     mPluginAttributes.emplace_back(PluginField("has_per_channel_scaling", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("has_per_token_scaling", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("quantize_activations", nullptr, PluginFieldType::kINT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -341,6 +399,7 @@ IPluginV2* SmoothQuantGemmPluginCreator::createPlugin(const char* name, const Pl
 {
     const PluginField* fields = fc->fields;
     bool perTokenScaling, perChannelScaling;
+    bool quantizeActivations{false};
     nvinfer1::DataType type;
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
@@ -361,6 +420,11 @@ IPluginV2* SmoothQuantGemmPluginCreator::createPlugin(const char* name, const Pl
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
             type = static_cast<nvinfer1::DataType>(*(static_cast<const nvinfer1::DataType*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "quantize_activations"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            quantizeActivations = static_cast<bool>(*(static_cast<const int*>(fields[i].data)));
+        }
     }
     try
     {
@@ -368,7 +432,7 @@ IPluginV2* SmoothQuantGemmPluginCreator::createPlugin(const char* name, const Pl
         // Create plugin profiler with shared tactics map
         auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ false);
         QuantMode quantMode = QuantMode::fromDescription(true, true, perTokenScaling, perChannelScaling);
-        auto* obj = new SmoothQuantGemmPlugin(quantMode, type, pluginProfiler);
+        auto* obj = new SmoothQuantGemmPlugin(quantMode, type, pluginProfiler, quantizeActivations);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
@@ -61,8 +61,10 @@ public:
 
     SmoothQuantGemmPlugin() = delete;
 
-    SmoothQuantGemmPlugin(
-        tensorrt_llm::common::QuantMode quantMode, nvinfer1::DataType type, const PluginProfilerPtr& pluginProfiler);
+    // With quantizeActivations, the activations are given in type and quantized per token inside the plugin, so the
+    // int8 activations never leave the workspace. Requires per-token scaling.
+    SmoothQuantGemmPlugin(tensorrt_llm::common::QuantMode quantMode, nvinfer1::DataType type,
+        const PluginProfilerPtr& pluginProfiler, bool quantizeActivations = false);
 
     SmoothQuantGemmPlugin(const void* data, size_t length, const PluginProfilerPtr& pluginProfiler);
 
@@ -113,6 +115,8 @@ private:
     PluginProfilerPtr mPluginProfiler;
 
     nvinfer1::DataType mType;
+
+    bool mQuantizeActivations{false};
 };
 
 class SmoothQuantGemmPluginCreator : public BaseCreator
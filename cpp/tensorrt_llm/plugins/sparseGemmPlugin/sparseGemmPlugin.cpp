@@ -0,0 +1,449 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sparseGemmPlugin.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include <numeric>
+
+using namespace nvinfer1;
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::kernels::cutlass_kernels;
+using tensorrt_llm::plugins::SparseGemmPluginCreator;
+using tensorrt_llm::plugins::SparseGemmPlugin;
+using tensorrt_llm::plugins::SparseGemmPluginProfiler;
+using tensorrt_llm::plugins::read;
+using tensorrt_llm::plugins::write;
+
+static const char* SPARSE_GEMM_PLUGIN_VERSION{"1"};
+static const char* SPARSE_GEMM_PLUGIN_NAME{"SparseGemm"};
+PluginFieldCollection SparseGemmPluginCreator::mFC{};
+std::vector<nvinfer1::PluginField> SparseGemmPluginCreator::mPluginAttributes;
+
+namespace
+{
+// Every group of 4 keeps its 2 first elements, a valid metadata pattern for the random weights of the profiler.
+constexpr int kProfilerMetadataByte = 0x44;
+
+size_t getMetadataSize(const QuantMode& quantMode, int n, int k)
+{
+    // The 16-bit types share the metadata format.
+    return quantMode.hasInt8Weights() ? getSparseGemmMetadataSize<int8_t>(n, k) : getSparseGemmMetadataSize<half>(n, k);
+}
+} // namespace
+
+void SparseGemmPluginProfiler::runTactic(
+    int m, int n, int k, const SparseGemmPluginProfiler::Config& tactic, char* workspace, const cudaStream_t& stream)
+{
+    const size_t inputSize = mQuantMode.hasInt8Weights() ? sizeof(int8_t) : 2u;
+    int8_t* aTmp = reinterpret_cast<int8_t*>(workspace);
+    int8_t* bTmp = nextWorkspacePtr(aTmp, m * k * inputSize);
+    int8_t* eTmp = nextWorkspacePtr(bTmp, n * k / 2 * inputSize);
+    const size_t metadataSize = getMetadataSize(mQuantMode, n, k);
+    void* dTmp = reinterpret_cast<void*>(nextWorkspacePtr(eTmp, metadataSize));
+    float* scaleTokensTmp = reinterpret_cast<float*>(nextWorkspacePtr(reinterpret_cast<int8_t*>(dTmp), m * n * 2));
+    float* scaleChannelsTmp
+        = reinterpret_cast<float*>(nextWorkspacePtr(reinterpret_cast<int8_t*>(scaleTokensTmp), m * sizeof(float)));
+    char* workspaceTmp
+        = reinterpret_cast<char*>(nextWorkspacePtr(reinterpret_cast<int8_t*>(scaleChannelsTmp), n * sizeof(float)));
+
+    const int wsSize = mRunner->getWorkspaceSize(m, n, k);
+
+    check_cuda_error(cudaMemsetAsync(eTmp, kProfilerMetadataByte, metadataSize, stream));
+    mRunner->gemm(aTmp, bTmp, eTmp, mQuantMode, scaleTokensTmp, scaleChannelsTmp, dTmp, m, n, k, tactic, workspaceTmp,
+        wsSize, stream);
+}
+
+void SparseGemmPluginProfiler::computeTmpSize(int maxM, int n, int k)
+{
+    const size_t inputSize = mQuantMode.hasInt8Weights() ? sizeof(int8_t) : 2u;
+    std::vector<size_t> workspaces = {
+        maxM * k * inputSize,                 // A
+        n * k / 2 * inputSize,                // B, compressed
+        getMetadataSize(mQuantMode, n, k),    // E
+        maxM * n * 2u,                        // D
+        maxM * sizeof(float),                 // scaleTokens
+        n * sizeof(float),                    // scaleChannels
+        mRunner->getWorkspaceSize(maxM, n, k) // workspace
+    };
+    size_t bytes = calculateTotalWorkspaceSize(workspaces.data(), workspaces.size());
+    setTmpWorkspaceSizeInBytes(bytes);
+}
+
+std::vector<SparseGemmPluginProfiler::Config> SparseGemmPluginProfiler::getTactics(int m, int n, int k) const
+{
+    return mRunner->getConfigs();
+}
+
+SparseGemmPlugin::SparseGemmPlugin(
+    QuantMode quantMode, nvinfer1::DataType type, const SparseGemmPlugin::PluginProfilerPtr& pluginProfiler)
+    : mQuantMode(quantMode)
+    , mPluginProfiler(pluginProfiler)
+{
+    init(type);
+}
+
+// Parameterized constructor
+SparseGemmPlugin::SparseGemmPlugin(
+    const void* data, size_t length, const SparseGemmPlugin::PluginProfilerPtr& pluginProfiler)
+    : mPluginProfiler(pluginProfiler)
+{
+    const char *d = reinterpret_cast<const char*>(data), *a = d;
+    unsigned int quantMode;
+    nvinfer1::DataType type;
+    read(d, quantMode);
+    read(d, type);
+    read(d, mDims);
+
+    mQuantMode = QuantMode(quantMode);
+
+    init(type);
+
+    mPluginProfiler->deserialize(d, mDims, mGemmId);
+
+    TLLM_CHECK_WITH_INFO(d == a + length,
+        "Expected length (%d) != real length (%d). This is often "
+        "caused by using different TensorRT-LLM version to build "
+        "engine and run engine.",
+        (int) length, (int) (d - a));
+}
+
+void SparseGemmPlugin::init(nvinfer1::DataType type)
+{
+    const int sm = getSMVersion();
+    TLLM_CHECK_WITH_INFO(sm >= 80 && sm <= 90, "The sparse GEMM is only supported on SM80 to SM90");
+    mType = type;
+    if (mType == nvinfer1::DataType::kHALF)
+    {
+        if (isInt8())
+        {
+            mGemmRunner = std::make_shared<CutlassSparseGemmRunner<int8_t, half>>();
+        }
+        else
+        {
+            mGemmRunner = std::make_shared<CutlassSparseGemmRunner<half, half>>();
+        }
+    }
+#ifdef ENABLE_BF16
+    else if (mType == nvinfer1::DataType::kBF16)
+    {
+        if (isInt8())
+        {
+            mGemmRunner = std::make_shared<CutlassSparseGemmRunner<int8_t, __nv_bfloat16>>();
+        }
+        else
+        {
+            mGemmRunner = std::make_shared<CutlassSparseGemmRunner<__nv_bfloat16, __nv_bfloat16>>();
+        }
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported output data type for the sparse GEMM");
+    }
+
+    mPluginProfiler->setQuantMode(mQuantMode);
+
+    mGemmId = GemmIdCore(mDims.n, mDims.k, mType);
+}
+
+// IPluginV2DynamicExt Methods
+nvinfer1::IPluginV2DynamicExt* SparseGemmPlugin::clone() const noexcept
+{
+    auto* plugin = new SparseGemmPlugin(*this);
+    return plugin;
+}
+
+nvinfer1::DimsExprs SparseGemmPlugin::getOutputDimensions(
+    int outputIndex, const nvinfer1::DimsExprs* inputs, int nbInputs, nvinfer1::IExprBuilder& exprBuilder) noexcept
+{
+    try
+    {
+        TLLM_CHECK(nbInputs == (isInt8() ? 5 : 3));
+        TLLM_CHECK(outputIndex == 0);
+        const int nbDimsA = inputs[0].nbDims;
+        TLLM_CHECK(nbDimsA >= 2);
+        DimsExprs ret;
+        ret.nbDims = nbDimsA;
+        for (int ii = 0; ii < nbDimsA - 1; ++ii)
+        {
+            ret.d[ii] = inputs[0].d[ii];
+        }
+        ret.d[nbDimsA - 1] = inputs[1].d[0];
+        return ret;
+    }
+    catch (const std::exception& e)
+    {
+        caughtError(e);
+    }
+    return DimsExprs{};
+}
+
+bool SparseGemmPlugin::supportsFormatCombination(
+    int pos, const nvinfer1::PluginTensorDesc* inOut, int nbInputs, int nbOutputs) noexcept
+{
+    const auto inputType = isInt8() ? nvinfer1::DataType::kINT8 : mType;
+    if (pos == nbInputs)
+    {
+        // out
+        return inOut[pos].type == mType && inOut[pos].format == TensorFormat::kLINEAR;
+    }
+    switch (pos)
+    {
+    case 0:
+        // activation
+    case 1:
+        // compressed weights
+        return inOut[pos].type == inputType && inOut[pos].format == TensorFormat::kLINEAR;
+    case 2:
+        // metadata
+        return inOut[pos].type == nvinfer1::DataType::kINT8 && inOut[pos].format == TensorFormat::kLINEAR;
+    case 3:
+        // scales tokens
+    case 4:
+        // scales channels
+        return inOut[pos].type == nvinfer1::DataType::kFLOAT && inOut[pos].format == TensorFormat::kLINEAR;
+    default:
+        // Never should be here
+        assert(false);
+        return false;
+    }
+}
+
+void SparseGemmPlugin::configurePlugin(const nvinfer1::DynamicPluginTensorDesc* in, int nbInputs,
+    const nvinfer1::DynamicPluginTensorDesc* out, int nbOutputs) noexcept
+{
+    const auto minM = std::accumulate(in[0].min.d, in[0].min.d + in[0].min.nbDims - 1, 1, std::multiplies<int>());
+    const auto maxM = std::accumulate(in[0].max.d, in[0].max.d + in[0].max.nbDims - 1, 1, std::multiplies<int>());
+
+    const int maxK = in[0].max.d[in[0].max.nbDims - 1];
+    const int maxN = in[1].max.d[0];
+    const int minK = in[0].min.d[in[0].min.nbDims - 1];
+    const int minN = in[1].min.d[0];
+
+    TLLM_CHECK_WITH_INFO(minN == maxN, "Variable out channels is not allowed");
+    TLLM_CHECK_WITH_INFO(minK == maxK, "Variable in channels is not allowed");
+    TLLM_CHECK_WITH_INFO(in[1].max.d[1] * 2 == maxK, "The compressed weights must hold half of the in channels");
+    // The metadata rows are interleaved by groups of 32 and the K of the tiles is up to 128.
+    TLLM_CHECK_WITH_INFO(maxK % 128 == 0 && maxN % 32 == 0, "K must be a multiple of 128 and N of 32 for sparse GEMM");
+
+    if (!mDims.isInitialized())
+    {
+        mDims = {minM, maxM, maxN, maxK};
+    }
+    mGemmId = {maxN, maxK, mType};
+
+    mWorkspaceMaxSize = mGemmRunner->getWorkspaceSize(maxM, maxN, maxK);
+}
+
+size_t SparseGemmPlugin::getWorkspaceSize(const nvinfer1::PluginTensorDesc* inputs, int nbInputs,
+    const nvinfer1::PluginTensorDesc* outputs, int nbOutputs) const noexcept
+{
+    return mWorkspaceMaxSize;
+}
+
+int SparseGemmPlugin::enqueue(const nvinfer1::PluginTensorDesc* inputDesc,
+    const nvinfer1::PluginTensorDesc* outputDesc, const void* const* inputs, void* const* outputs, void* workspace,
+    cudaStream_t stream) noexcept
+{
+    // inputs
+    //     mat1           [M(*), K]
+    //     mat2           [N, K / 2], nonzeros of the 2:4 sparse weights
+    //     metadata       positions of the nonzeros, see compressSparseGemmWeights
+    //     scale_tokens   [M, 1] or [1, 1], int8 only
+    //     scale_channels [1, N] or [1, 1], int8 only
+    // outputs
+    //     mat [M(*), N]
+    int m = 1;
+    for (int ii = 0; ii < inputDesc[0].dims.nbDims - 1; ++ii)
+    {
+        m *= inputDesc[0].dims.d[ii];
+    }
+    const int n = inputDesc[1].dims.d[0];
+    const int k = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
+    const int wsSize = mGemmRunner->getWorkspaceSize(m, n, k);
+
+    const auto* scaleTokens = isInt8() ? reinterpret_cast<const float*>(inputs[3]) : nullptr;
+    const auto* scaleChannels = isInt8() ? reinterpret_cast<const float*>(inputs[4]) : nullptr;
+
+    const auto& bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
+    TLLM_CHECK_WITH_INFO(bestTactic, "No valid sparse GEMM tactic");
+    mGemmRunner->gemm(inputs[0], inputs[1], inputs[2], mQuantMode, scaleTokens, scaleChannels, outputs[0], m, n, k,
+        *bestTactic, reinterpret_cast<char*>(workspace), wsSize, stream);
+
+    return 0;
+}
+
+// IPluginV2Ext Methods
+nvinfer1::DataType SparseGemmPlugin::getOutputDataType(
+    int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
+{
+    TLLM_CHECK(index == 0);
+    return mType;
+}
+
+// IPluginV2 Methods
+
+const char* SparseGemmPlugin::getPluginType() const noexcept
+{
+    return SPARSE_GEMM_PLUGIN_NAME;
+}
+
+const char* SparseGemmPlugin::getPluginVersion() const noexcept
+{
+    return SPARSE_GEMM_PLUGIN_VERSION;
+}
+
+int SparseGemmPlugin::getNbOutputs() const noexcept
+{
+    return 1;
+}
+
+int SparseGemmPlugin::initialize() noexcept
+{
+    configGemm();
+    return 0;
+}
+
+void SparseGemmPlugin::terminate() noexcept {}
+
+size_t SparseGemmPlugin::getSerializationSize() const noexcept
+{
+    return sizeof(unsigned int) +                       // QuantMode
+        sizeof(nvinfer1::DataType) +                    // dtype
+        sizeof(mDims) +                                 // Dimensions
+        mPluginProfiler->getSerializationSize(mGemmId); // selected tactics container size
+}
+
+void SparseGemmPlugin::serialize(void* buffer) const noexcept
+{
+    char *d = static_cast<char*>(buffer), *a = d;
+    write(d, mQuantMode.value());
+    write(d, mType);
+    write(d, mDims);
+
+    mPluginProfiler->serialize(d, mGemmId);
+    assert(d == a + getSerializationSize());
+}
+
+void SparseGemmPlugin::destroy() noexcept
+{
+    // This gets called when the network containing plugin is destroyed
+    delete this;
+}
+
+void SparseGemmPlugin::configGemm()
+{
+    mPluginProfiler->profileTactics(mGemmRunner, mType, mDims, mGemmId);
+}
+
+///////////////
+
+SparseGemmPluginCreator::SparseGemmPluginCreator()
+{
+    // Fill PluginFieldCollection with PluginField arguments metadata
+    mPluginAttributes.clear();
+    mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("int8_inputs", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("has_per_channel_scaling", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("has_per_token_scaling", nullptr, PluginFieldType::kINT32, 0));
+    mFC.nbFields = mPluginAttributes.size();
+    mFC.fields = mPluginAttributes.data();
+}
+
+const char* SparseGemmPluginCreator::getPluginName() const noexcept
+{
+    return SPARSE_GEMM_PLUGIN_NAME;
+}
+
+const char* SparseGemmPluginCreator::getPluginVersion() const noexcept
+{
+    return SPARSE_GEMM_PLUGIN_VERSION;
+}
+
+const PluginFieldCollection* SparseGemmPluginCreator::getFieldNames() noexcept
+{
+    return &mFC;
+}
+
+IPluginV2* SparseGemmPluginCreator::createPlugin(const char* name, const PluginFieldCollection* fc) noexcept
+{
+    const PluginField* fields = fc->fields;
+    nvinfer1::DataType type;
+    bool int8Inputs{false};
+    bool perTokenScaling{false};
+    bool perChannelScaling{false};
+    // Read configurations from each fields
+    for (int i = 0; i < fc->nbFields; ++i)
+    {
+        const char* attrName = fields[i].name;
+        if (!strcmp(attrName, "type_id"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            type = static_cast<nvinfer1::DataType>(*(static_cast<const nvinfer1::DataType*>(fields[i].data)));
+        }
+        else if (!strcmp(attrName, "int8_inputs"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            int8Inputs = static_cast<bool>(*(static_cast<const int*>(fields[i].data)));
+        }
+        else if (!strcmp(attrName, "has_per_channel_scaling"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            perChannelScaling = static_cast<bool>(*(static_cast<const int*>(fields[i].data)));
+        }
+        else if (!strcmp(attrName, "has_per_token_scaling"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            perTokenScaling = static_cast<bool>(*(static_cast<const int*>(fields[i].data)));
+        }
+    }
+    try
+    {
+        // SparseGemmPluginCreator is unique and shared for an engine generation
+        // Create plugin profiler with shared tactics map
+        auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ false);
+        QuantMode quantMode = int8Inputs ? QuantMode::fromDescription(true, true, perTokenScaling, perChannelScaling)
+                                         : QuantMode::none();
+        auto* obj = new SparseGemmPlugin(quantMode, type, pluginProfiler);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+    catch (const std::exception& e)
+    {
+        caughtError(e);
+    }
+    return nullptr;
+}
+
+IPluginV2* SparseGemmPluginCreator::deserializePlugin(
+    const char* name, const void* serialData, size_t serialLength) noexcept
+{
+    // This object will be deleted when the network is destroyed, which will
+    // call SparseGemmPlugin::destroy()
+    try
+    {
+        // Create plugin profiler with private tactics map which is read from the serialized engine
+        auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ true);
+        auto* obj = new SparseGemmPlugin(serialData, serialLength, pluginProfiler);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+    catch (const std::exception& e)
+    {
+        caughtError(e);
+    }
+    return nullptr;
+}
@@ -32,6 +32,11 @@ static constexpr int BIAS = int(1) << 0;
 static constexpr int ZERO = int(1) << 1;
 static constexpr int PRE_QUANT_SCALE = int(1) << 2;
 static constexpr int FP8_ALPHA = int(1) << 3;
+// The weights are INT4 by default, these flags select a sub-4-bit or NF4 type instead, see
+// weightOnlyBatchedGemv/lowBitKernel.h for their layout. They do not support FP8_ALPHA.
+static constexpr int INT3_WEIGHTS = int(1) << 4;
+static constexpr int INT2_WEIGHTS = int(1) << 5;
+static constexpr int NF4_WEIGHTS = int(1) << 6;
 using tensorrt_llm::plugins::read;
 using tensorrt_llm::plugins::write;
 
@@ -120,7 +125,10 @@ WeightOnlyGroupwiseQuantMatmulPlugin::WeightOnlyGroupwiseQuantMatmulPlugin(
 
     init(type, quant_algo, group_size);
 
-    mPluginProfiler->deserialize(d, mDims, mGemmId);
+    if (!isLowBit())
+    {
+        mPluginProfiler->deserialize(d, mDims, mGemmId);
+    }
 
     TLLM_CHECK_WITH_INFO(d == a + length,
         "Expected length (%d) != real length (%d). This is often "
@@ -143,6 +151,35 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::init(nvinfer1::DataType type, int qua
     mBiasesInputIdx = (quant_algo & BIAS) ? mZerosInputIdx + 1 : mZerosInputIdx;
     mAlphaInputIdx = (quant_algo & FP8_ALPHA) ? mBiasesInputIdx + 1 : mBiasesInputIdx;
 
+    const int low_bit_flags = quant_algo & (INT3_WEIGHTS | INT2_WEIGHTS | NF4_WEIGHTS);
+    TLLM_CHECK_WITH_INFO((low_bit_flags & (low_bit_flags - 1)) == 0, "At most one weight type can be set");
+    mWeightType = tensorrt_llm::kernels::WeightOnlyQuantType::Int4b;
+    if (low_bit_flags == INT3_WEIGHTS)
+    {
+        mWeightType = tensorrt_llm::kernels::WeightOnlyQuantType::Int3b;
+    }
+    else if (low_bit_flags == INT2_WEIGHTS)
+    {
+        mWeightType = tensorrt_llm::kernels::WeightOnlyQuantType::Int2b;
+    }
+    else if (low_bit_flags == NF4_WEIGHTS)
+    {
+        mWeightType = tensorrt_llm::kernels::WeightOnlyQuantType::NF4;
+    }
+
+    if (isLowBit())
+    {
+        TLLM_CHECK_WITH_INFO(!(quant_algo & FP8_ALPHA), "Sub-4-bit weights do not support fp8 activations");
+        TLLM_CHECK_WITH_INFO(mType == nvinfer1::DataType::kHALF || mType == nvinfer1::DataType::kBF16,
+            "Unsupported data type");
+        mCudaKernelEnabled = tensorrt_llm::kernels::isWeightOnlyBatchedGemvEnabled(mWeightType);
+        TLLM_CHECK_WITH_INFO(mCudaKernelEnabled, "Sub-4-bit weights are unsupported on pre-Turing architectures");
+        mPluginProfiler->setQuantAlgo(mQuantAlgo);
+        mPluginProfiler->setGroupSize(mGroupSize);
+        mGemmId = GemmIdCore(mDims.n, mDims.k, mType);
+        return;
+    }
+
     if (mType == nvinfer1::DataType::kHALF)
     {
         if (quant_algo & FP8_ALPHA)
@@ -193,9 +230,24 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::init(nvinfer1::DataType type, int qua
             // Hopper style kernels
             if (getSMVersion() < 90)
             {
-                TLLM_THROW("FP8 is unsupported on pre-Hopper architectures!");
+                TLLM_THROW("W4A(fp)8 kernel is unsupported on pre-Hopper architectures!");
+            }
+            if (quant_algo & ZERO)
+            {
+                // has zeros
+                m_weightOnlyGroupwiseGemmRunner
+                    = std::make_shared<tensorrt_llm::kernels::cutlass_kernels::CutlassFpAIntBGemmRunner<__nv_fp8_e4m3,
+                        cutlass::int4b_t, cutlass::WeightOnlyQuantOp::FINEGRAINED_SCALE_AND_ZEROS, __nv_bfloat16,
+                        __nv_bfloat16, __nv_bfloat16>>();
+            }
+            else
+            {
+                // no zeros
+                m_weightOnlyGroupwiseGemmRunner
+                    = std::make_shared<tensorrt_llm::kernels::cutlass_kernels::CutlassFpAIntBGemmRunner<__nv_fp8_e4m3,
+                        cutlass::int4b_t, cutlass::WeightOnlyQuantOp::FINEGRAINED_SCALE_ONLY, __nv_bfloat16,
+                        __nv_bfloat16, __nv_bfloat16>>();
             }
-            TLLM_THROW("FP8 is unsupported on with BF16 scales and zero-points!");
         }
         else
         {
@@ -237,6 +289,11 @@ nvinfer1::IPluginV2DynamicExt* WeightOnlyGroupwiseQuantMatmulPlugin::clone() con
 
 void WeightOnlyGroupwiseQuantMatmulPlugin::configGemm()
 {
+    if (isLowBit())
+    {
+        // Nothing to profile, the batched GEMV has a single configuration per M
+        return;
+    }
     mPluginProfiler->profileTactics(m_weightOnlyGroupwiseGemmRunner, mType, mDims, mGemmId);
 }
 
@@ -247,7 +304,7 @@ nvinfer1::DimsExprs WeightOnlyGroupwiseQuantMatmulPlugin::getOutputDimensions(
     // inputs
     //   0 activations      [M, K]
     //   1 pre-quant scales [K] (optional)
-    //   2 weights          [K, N/2]
+    //   2 weights          [K, N/2], or [N, K * bits / 16] for the sub-4-bit types
     //   3 scales           [K // group_size, N]
     //   4 zeros            [K // group_size, N] (optional)
     //   5 biases           [M] (optional)
@@ -268,8 +325,16 @@ nvinfer1::DimsExprs WeightOnlyGroupwiseQuantMatmulPlugin::getOutputDimensions(
             ret.d[ii] = inputs[0].d[ii];
         }
 
-        // int4 weight only quant
-        ret.d[nbDimsA - 1] = exprBuilder.constant(inputs[mWeightInputIdx].d[1]->getConstantValue() * FP16_INT4_RATIO);
+        if (isLowBit())
+        {
+            ret.d[nbDimsA - 1] = inputs[mWeightInputIdx].d[0];
+        }
+        else
+        {
+            // int4 weight only quant
+            ret.d[nbDimsA - 1]
+                = exprBuilder.constant(inputs[mWeightInputIdx].d[1]->getConstantValue() * FP16_INT4_RATIO);
+        }
 
         return ret;
     }
@@ -315,6 +380,19 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::configurePlugin(const nvinfer1::Dynam
 
     const int maxK = in[0].max.d[in[0].max.nbDims - 1];
 
+    if (isLowBit())
+    {
+        // The pre-quant scale is applied by the GEMV, no workspace is needed
+        const int N = in[mWeightInputIdx].max.d[0];
+        if (!mDims.isInitialized())
+        {
+            mDims = {minM, maxM, N, maxK};
+        }
+        mGemmId = {N, maxK, mType};
+        m_workspaceMaxSize = 0;
+        return;
+    }
+
     // Quantized weights are packed in FP16 format (INT4*4 -> FP16)
     const int maxN = in[mWeightInputIdx].max.d[1] * FP16_INT4_RATIO;
 
@@ -361,6 +439,12 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(const nvinfer1::PluginTensorDe
     const int n = inputDesc[mWeightInputIdx].dims.d[1];
     const int k = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
 
+    if (isLowBit())
+    {
+        enqueueLowBitGemv(inputs, outputs[0], m, inputDesc[mWeightInputIdx].dims.d[0], k, stream);
+        return 0;
+    }
+
     int smVersion = getSMVersion();
     bool use_cuda_kernel = m < SMALL_M_FAST_PATH && mCudaKernelEnabled;
 #if defined(ENABLE_BF16)
@@ -379,7 +463,10 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(const nvinfer1::PluginTensorDe
         cudaMemcpy(&alpha, const_cast<void*>(inputs[mAlphaInputIdx]), sizeof(float), cudaMemcpyDeviceToHost);
     }
 
-    if (use_pre_quant_scale && !use_cuda_kernel)
+    // The W4A8 cutlass kernels take fp8 activations, the conversion is fused into the pre-quant scaling.
+    bool quantize_act_to_fp8 = mQuantAlgo & FP8_ALPHA;
+    const void* pre_quant_scale_ptr = use_pre_quant_scale ? inputs[mPreQuantScaleInputIdx] : nullptr;
+    if ((use_pre_quant_scale || quantize_act_to_fp8) && !use_cuda_kernel)
     {
         // Apply pre-quant per channel scale on activations
         act_ptr = reinterpret_cast<const half*>(workspace);
@@ -389,13 +476,13 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(const nvinfer1::PluginTensorDe
             {
                 tensorrt_llm::kernels::apply_per_channel_scale_kernel_launcher<half, __nv_fp8_e4m3>(
                     reinterpret_cast<__nv_fp8_e4m3*>(workspace), reinterpret_cast<const half*>(inputs[0]),
-                    reinterpret_cast<const half*>(inputs[mPreQuantScaleInputIdx]), m, k, stream);
+                    reinterpret_cast<const half*>(pre_quant_scale_ptr), m, k, stream);
             }
             else
             {
                 tensorrt_llm::kernels::apply_per_channel_scale_kernel_launcher<half, half>(
                     reinterpret_cast<half*>(workspace), reinterpret_cast<const half*>(inputs[0]),
-                    reinterpret_cast<const half*>(inputs[mPreQuantScaleInputIdx]), m, k, stream);
+                    reinterpret_cast<const half*>(pre_quant_scale_ptr), m, k, stream);
             }
         }
 #if defined(ENABLE_BF16)
@@ -405,13 +492,13 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(const nvinfer1::PluginTensorDe
             {
                 tensorrt_llm::kernels::apply_per_channel_scale_kernel_launcher<__nv_bfloat16, __nv_fp8_e4m3>(
                     reinterpret_cast<__nv_fp8_e4m3*>(workspace), reinterpret_cast<const __nv_bfloat16*>(inputs[0]),
-                    reinterpret_cast<const __nv_bfloat16*>(inputs[mPreQuantScaleInputIdx]), m, k, stream);
+                    reinterpret_cast<const __nv_bfloat16*>(pre_quant_scale_ptr), m, k, stream);
             }
             else
             {
                 tensorrt_llm::kernels::apply_per_channel_scale_kernel_launcher<__nv_bfloat16, __nv_bfloat16>(
                     reinterpret_cast<__nv_bfloat16*>(workspace), reinterpret_cast<const __nv_bfloat16*>(inputs[0]),
-                    reinterpret_cast<const __nv_bfloat16*>(inputs[mPreQuantScaleInputIdx]), m, k, stream);
+                    reinterpret_cast<const __nv_bfloat16*>(pre_quant_scale_ptr), m, k, stream);
             }
         }
 #endif
@@ -444,9 +531,6 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(const nvinfer1::PluginTensorDe
             // Use CUDA kernels for small batch size
             // The CUDA kernel is designed for ColumnMajorTileInterleave weight layout used in fpAIntB cutlass kernel
             // when sm >= 75 and the preprocessing of cutlass on sm70 does not interleave the weights.
-            const void* pre_quant_scale_ptr = nullptr;
-            if (use_pre_quant_scale)
-                pre_quant_scale_ptr = inputs[mPreQuantScaleInputIdx];
             void* cuda_kernel_act_ptr = const_cast<void*>(reinterpret_cast<const void*>(inputs[0]));
             void* cuda_kernel_act_scale_ptr = const_cast<void*>(reinterpret_cast<const void*>(pre_quant_scale_ptr));
             void* cuda_kernel_weight_ptr = const_cast<void*>(reinterpret_cast<const void*>(inputs[mWeightInputIdx]));
@@ -516,6 +600,31 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(const nvinfer1::PluginTensorDe
     return 0;
 }
 
+void WeightOnlyGroupwiseQuantMatmulPlugin::enqueueLowBitGemv(
+    const void* const* inputs, void* output, int m, int n, int k, cudaStream_t stream) const
+{
+    const auto act_type = mType == nvinfer1::DataType::kHALF ? tensorrt_llm::kernels::WeightOnlyActivationType::FP16
+                                                             : tensorrt_llm::kernels::WeightOnlyActivationType::BF16;
+    const void* pre_quant_scale = (mQuantAlgo & PRE_QUANT_SCALE) ? inputs[mPreQuantScaleInputIdx] : nullptr;
+    const void* zeros = (mQuantAlgo & ZERO) ? inputs[mZerosInputIdx] : nullptr;
+    const void* biases = (mQuantAlgo & BIAS) ? inputs[mBiasesInputIdx] : nullptr;
+    // half and bfloat16 have the same size
+    const auto* act_ptr = reinterpret_cast<const half*>(inputs[0]);
+    auto* out_ptr = reinterpret_cast<half*>(output);
+
+    constexpr int max_tile_m = SMALL_M_FAST_PATH - 1;
+    for (int m_start = 0; m_start < m; m_start += max_tile_m)
+    {
+        const int tile_m = std::min(max_tile_m, m - m_start);
+        tensorrt_llm::kernels::WeightOnlyParams params{reinterpret_cast<const uint8_t*>(inputs[mWeightInputIdx]),
+            inputs[mScalesInputIdx], zeros, act_ptr + static_cast<size_t>(m_start) * k, pre_quant_scale, biases,
+            out_ptr + static_cast<size_t>(m_start) * n, tile_m, n, k, mGroupSize, mWeightType,
+            tensorrt_llm::kernels::WeightOnlyType::GroupWise,
+            tensorrt_llm::kernels::WeightOnlyActivationFunctionType::Identity, act_type};
+        tensorrt_llm::kernels::weight_only_batched_gemv_launcher(params, stream);
+    }
+}
+
 // IPluginV2Ext Methods
 nvinfer1::DataType WeightOnlyGroupwiseQuantMatmulPlugin::getOutputDataType(
     int index, const nvinfer1::DataType* inputTypes, int nbInputs) const noexcept
@@ -551,11 +660,13 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::terminate() noexcept {}
 
 size_t WeightOnlyGroupwiseQuantMatmulPlugin::getSerializationSize() const noexcept
 {
-    return sizeof(nvinfer1::DataType) +                 // mType
-        sizeof(int) +                                   // mQuantAlgo
-        sizeof(int) +                                   // mGroupSize
-        sizeof(mDims) +                                 // Dimensions
-        mPluginProfiler->getSerializationSize(mGemmId); // selected tactics container size
+    // The sub-4-bit types are not profiled and have no tactics
+    const size_t tacticsSize = isLowBit() ? 0 : mPluginProfiler->getSerializationSize(mGemmId);
+    return sizeof(nvinfer1::DataType) + // mType
+        sizeof(int) +                   // mQuantAlgo
+        sizeof(int) +                   // mGroupSize
+        sizeof(mDims) +                 // Dimensions
+        tacticsSize;                    // selected tactics container size
 }
 
 void WeightOnlyGroupwiseQuantMatmulPlugin::serialize(void* buffer) const noexcept
@@ -566,7 +677,10 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::serialize(void* buffer) const noexcep
     write(d, mGroupSize);
     write(d, mDims);
 
-    mPluginProfiler->serialize(d, mGemmId);
+    if (!isLowBit())
+    {
+        mPluginProfiler->serialize(d, mGemmId);
+    }
     assert(d == a + getSerializationSize());
 }
 
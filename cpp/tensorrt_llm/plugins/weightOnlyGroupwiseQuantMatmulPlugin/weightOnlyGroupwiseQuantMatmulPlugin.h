@@ -119,6 +119,14 @@ private:
 
     void configGemm();
 
+    // Sub-4-bit weights have no CUTLASS kernel, the batched GEMV runs every M in tiles of SMALL_M_FAST_PATH - 1 rows.
+    void enqueueLowBitGemv(const void* const* inputs, void* output, int m, int n, int k, cudaStream_t stream) const;
+
+    bool isLowBit() const
+    {
+        return tensorrt_llm::kernels::isLowBitQuantType(mWeightType);
+    }
+
 private:
     const std::string mLayerName;
 
@@ -129,12 +137,17 @@ private:
 
     // When M is smaller than this value, we trigger a fast path
     // I.e. a tailored kernel instead of cutlass.
-    static constexpr int SMALL_M_FAST_PATH = 5;
+    // The batched GEMV kernels cover M <= 16, the decode batch of a TP rank. The WeightOnly kernel test prints the
+    // CUDA and CUTLASS kernel times per M and can be used to re-tune this for a GPU.
+    static constexpr int SMALL_M_FAST_PATH = 17;
 
     int mQuantAlgo;
 
     int mGroupSize;
 
+    // Int4b unless one of the sub-4-bit flags of mQuantAlgo is set
+    tensorrt_llm::kernels::WeightOnlyQuantType mWeightType;
+
     int mPreQuantScaleInputIdx;
     int mWeightInputIdx;
     int mScalesInputIdx;
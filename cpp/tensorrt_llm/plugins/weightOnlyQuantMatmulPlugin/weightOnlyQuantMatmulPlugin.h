@@ -132,7 +132,9 @@ private:
 
     // When M is smaller than this value, we trigger a fast path
     // I.e. a tailored kernel instead of cutlass.
-    static constexpr int SMALL_M_FAST_PATH = 5;
+    // The batched GEMV kernels cover M <= 16, the decode batch of a TP rank. The WeightOnly kernel test prints the
+    // CUDA and CUTLASS kernel times per M and can be used to re-tune this for a GPU.
+    static constexpr int SMALL_M_FAST_PATH = 17;
 
     GemmDims mDims{};
     GemmIdCore mGemmId{};
@@ -28,21 +28,80 @@
 #include <torch/extension.h>
 
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <utility>
 
 namespace tb = tensorrt_llm::batch_manager;
 
 namespace tensorrt_llm::pybind::batch_manager
 {
 
+class GptManager::ResponseQueue
+{
+public:
+    void push(Response response)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mResponses.push_back(std::move(response));
+    }
+
+    std::list<Response> pop()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return std::exchange(mResponses, {});
+    }
+
+private:
+    std::mutex mMutex;
+    std::list<Response> mResponses;
+};
+
 GptManager::GptManager(std::filesystem::path const& trtEnginePath, tb::TrtGptModelType modelType, int32_t maxBeamWidth,
     tb::batch_scheduler::SchedulerPolicy schedulerPolicy, GetInferenceRequestsCallback const& getInferenceRequestsCb,
     SendResponseCallback const& sendResponseCb, const tb::PollStopSignalCallback& pollStopSignalCb,
     tb::ReturnBatchManagerStatsCallback const& returnBatchManagerStatsCb,
-    tb::TrtGptModelOptionalParams const& optionalParams, std::optional<uint64_t> terminateReqId)
+    tb::TrtGptModelOptionalParams const& optionalParams, std::optional<uint64_t> terminateReqId,
+    SendResponsesCallback const& sendResponsesCb)
+    : mSendResponsesCb{sendResponsesCb}
 {
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(sendResponseCb) != static_cast<bool>(sendResponsesCb),
+        "Exactly one of send_response_cb and send_responses_cb must be set");
+    tb::GetInferenceRequestsCallback getInferenceRequestsAdapter;
+    tb::SendResponseCallback sendResponseAdapter;
+    if (sendResponsesCb)
+    {
+        // Batched mode: the responses are converted without the GIL as they come and cross into Python once per
+        // iteration, together with the fetch of the new requests.
+        mResponses = std::make_shared<ResponseQueue>();
+        sendResponseAdapter = [responses = mResponses](uint64_t id, std::list<tb::NamedTensor> const& cppTensors,
+                                  bool isOk, std::string const& errMsg)
+        {
+            std::list<NamedTensor> pythonList(cppTensors.begin(), cppTensors.end());
+            responses->push(Response{id, std::move(pythonList), isOk, errMsg});
+        };
+        getInferenceRequestsAdapter = [callback = callbackAdapter(getInferenceRequestsCb), responses = mResponses,
+                                          sendResponsesCb](int32_t maxSequences)
+        {
+            auto pending = responses->pop();
+            py::gil_scoped_acquire acquire;
+            if (!pending.empty())
+            {
+                sendResponsesCb(pending);
+            }
+            return callback(maxSequences);
+        };
+    }
+    else
+    {
+        getInferenceRequestsAdapter = callbackAdapter(getInferenceRequestsCb);
+        sendResponseAdapter = callbackAdapter(sendResponseCb);
+    }
+
+    // Loading the engine takes long and does not touch Python objects
+    py::gil_scoped_release release;
     mManager = std::make_unique<tb::GptManager>(trtEnginePath, modelType, maxBeamWidth, schedulerPolicy,
-        callbackAdapter(getInferenceRequestsCb), callbackAdapter(sendResponseCb), pollStopSignalCb,
+        std::move(getInferenceRequestsAdapter), std::move(sendResponseAdapter), pollStopSignalCb,
         returnBatchManagerStatsCb, optionalParams, terminateReqId);
 }
 
@@ -63,10 +122,26 @@ void GptManager::shutdown()
     // able to do forward progress for the shutdown process to succeed. It takes the GIL during its callbacks, so
     // we release it now. Note that we shouldn't do anything related to python objects after that.
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
-    py::gil_scoped_release release;
-    mManager->shutdown();
-    mManager = nullptr;
-    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    {
+        py::gil_scoped_release release;
+        mManager->shutdown();
+        mManager = nullptr;
+    }
+    flushResponses();
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void GptManager::flushResponses()
+{
+    if (!mResponses)
+    {
+        return;
+    }
+    auto pending = mResponses->pop();
+    if (!pending.empty())
+    {
+        mSendResponsesCb(pending);
+    }
 }
 
 tb::GetInferenceRequestsCallback callbackAdapter(GetInferenceRequestsCallback const& callback)
@@ -103,12 +178,15 @@ void GptManager::initBindings(py::module_& m)
     py::class_<GptManager>(m, "GptManager")
         .def(py::init<std::filesystem::path const&, tb::TrtGptModelType, int32_t, tb::batch_scheduler::SchedulerPolicy,
                  GetInferenceRequestsCallback, SendResponseCallback, tb::PollStopSignalCallback,
-                 tb::ReturnBatchManagerStatsCallback, const tb::TrtGptModelOptionalParams&, std::optional<uint64_t>>(),
+                 tb::ReturnBatchManagerStatsCallback, const tb::TrtGptModelOptionalParams&, std::optional<uint64_t>,
+                 SendResponsesCallback>(),
             py::arg("trt_engine_path"), py::arg("model_type"), py::arg("max_beam_width"), py::arg("scheduler_policy"),
             py::arg("get_inference_requests_cb"), py::arg("send_response_cb"), py::arg("poll_stop_signal_cb") = nullptr,
             py::arg("return_batch_manager_stats_cb") = nullptr,
             py::arg_v("optional_params", tb::TrtGptModelOptionalParams(), "TrtGptModelOptionalParams"),
-            py::arg("terminate_req_id") = std::nullopt)
+            py::arg("terminate_req_id") = std::nullopt, py::arg("send_responses_cb") = nullptr,
+            "Set send_responses_cb instead of send_response_cb to receive the responses of an iteration at once, as a "
+            "list of (request_id, tensors, is_ok, error_msg) tuples, right before get_inference_requests_cb is called")
 
         .def("shutdown", &GptManager::shutdown)
         .def("__enter__", &GptManager::enter)
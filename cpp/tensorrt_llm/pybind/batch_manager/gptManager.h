@@ -24,13 +24,18 @@
 
 #include <ATen/ops/tensor.h>
 #include <functional>
+#include <list>
 #include <memory>
+#include <tuple>
 
 namespace tensorrt_llm::pybind::batch_manager
 {
 
 using GetInferenceRequestsCallback = std::function<std::list<InferenceRequest>(int32_t)>;
 using SendResponseCallback = std::function<void(uint64_t, std::list<NamedTensor> const&, bool, const std::string&)>;
+// Request id, output tensors, isOk and error message of one response
+using Response = std::tuple<uint64_t, std::list<NamedTensor>, bool, std::string>;
+using SendResponsesCallback = std::function<void(std::list<Response> const&)>;
 
 tensorrt_llm::batch_manager::GetInferenceRequestsCallback callbackAdapter(GetInferenceRequestsCallback const& callback);
 tensorrt_llm::batch_manager::SendResponseCallback callbackAdapter(SendResponseCallback const& callback);
@@ -45,7 +50,7 @@ public:
         tensorrt_llm::batch_manager::ReturnBatchManagerStatsCallback const& returnBatchManagerStatsCb = nullptr,
         tensorrt_llm::batch_manager::TrtGptModelOptionalParams const& optionalParams
         = tensorrt_llm::batch_manager::TrtGptModelOptionalParams(),
-        std::optional<uint64_t> terminateReqId = std::nullopt);
+        std::optional<uint64_t> terminateReqId = std::nullopt, SendResponsesCallback const& sendResponsesCb = nullptr);
 
     pybind11::object enter();
     void exit(pybind11::handle type, pybind11::handle value, pybind11::handle traceback);
@@ -54,7 +59,15 @@ public:
     static void initBindings(pybind11::module_& m);
 
 private:
+    class ResponseQueue;
+
+    // Hands the responses that were not delivered yet to sendResponsesCb
+    void flushResponses();
+
     std::unique_ptr<tensorrt_llm::batch_manager::GptManager> mManager;
+    // Set in batched mode, the responses of an iteration are delivered by the next get-requests callback
+    std::shared_ptr<ResponseQueue> mResponses;
+    SendResponsesCallback mSendResponsesCb;
 };
 
 } // namespace tensorrt_llm::pybind::batch_manager
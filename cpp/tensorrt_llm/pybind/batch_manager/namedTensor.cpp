@@ -16,6 +16,7 @@
  */
 #include "namedTensor.h"
 
+#include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/runtime/torch.h"
 
 #include <pybind11/functional.h>
@@ -29,6 +30,15 @@ namespace tb = tensorrt_llm::batch_manager;
 namespace tensorrt_llm::pybind::batch_manager
 {
 
+namespace
+{
+at::Tensor const& checkedTensor(NamedTensor const& namedTensor)
+{
+    TLLM_CHECK_WITH_INFO(namedTensor.tensor.has_value(), "Tensor %s is not set", namedTensor.name.c_str());
+    return namedTensor.tensor.value();
+}
+} // namespace
+
 NamedTensor::NamedTensor(const tb::NamedTensor& cppNamedTensor)
     : Base(runtime::Torch::tensor(cppNamedTensor.tensor), cppNamedTensor.name)
 {
@@ -39,7 +49,16 @@ void NamedTensor::initBindings(py::module_& m)
     py::class_<NamedTensor>(m, "NamedTensor")
         .def(py::init<NamedTensor::TensorPtr, std::string>(), py::arg("tensor"), py::arg("name"))
         .def_readwrite("tensor", &NamedTensor::tensor)
-        .def_readonly("name", &NamedTensor::name);
+        .def_readonly("name", &NamedTensor::name)
+        // Zero-copy views for other frameworks, the tensor already aliases the memory of the C++ tensor
+        .def(
+            "__dlpack__", [](NamedTensor const& self, py::object const& stream)
+            { return py::cast(checkedTensor(self)).attr("__dlpack__")(stream); },
+            py::arg("stream") = py::none())
+        .def("__dlpack_device__",
+            [](NamedTensor const& self) { return py::cast(checkedTensor(self)).attr("__dlpack_device__")(); })
+        .def_property_readonly("__cuda_array_interface__",
+            [](NamedTensor const& self) { return py::cast(checkedTensor(self)).attr("__cuda_array_interface__"); });
 }
 
 } // namespace tensorrt_llm::pybind::batch_manager
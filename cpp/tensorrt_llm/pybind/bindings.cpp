@@ -39,6 +39,7 @@
 #include "tensorrt_llm/runtime/gptSession.h"
 #include "tensorrt_llm/runtime/memoryCounters.h"
 #include "tensorrt_llm/runtime/samplingConfig.h"
+#include "tensorrt_llm/runtime/torchView.h"
 
 namespace py = pybind11;
 namespace tb = tensorrt_llm::batch_manager;
@@ -82,6 +83,9 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_readwrite("max_sequence_length", &tr::GptSession::Config::maxSequenceLength)
         .def_readwrite("decoder_per_request", &tr::GptSession::Config::decoderPerRequest)
         .def_readwrite("cuda_graph_mode", &tr::GptSession::Config::cudaGraphMode)
+        .def_readwrite("cuda_graph_cache_size", &tr::GptSession::Config::cudaGraphCacheSize)
+        .def_readwrite("gpu_weights_percent", &tr::GptSession::Config::gpuWeightsPercent)
+        .def_readwrite("async_callbacks", &tr::GptSession::Config::asyncCallbacks)
         .def_readwrite("ctx_micro_batch_size", &tr::GptSession::Config::ctxMicroBatchSize)
         .def_readwrite("gen_micro_batch_size", &tr::GptSession::Config::genMicroBatchSize)
         .def_readwrite("kv_cache_config", &tr::GptSession::Config::kvCacheConfig);
@@ -92,12 +96,17 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_static("top_p", &tr::DecodingMode::TopP)
         .def_static("top_k_top_p", &tr::DecodingMode::TopKTopP)
         .def_static("beam_search", &tr::DecodingMode::BeamSearch)
+        .def_static("min_p", &tr::DecodingMode::MinP)
+        .def_static("typical_p", &tr::DecodingMode::TypicalP)
         .def_property_readonly("is_none", &tr::DecodingMode::isNone)
         .def_property_readonly("is_top_k", &tr::DecodingMode::isTopK)
         .def_property_readonly("is_top_p", &tr::DecodingMode::isTopP)
         .def_property_readonly("is_top_k_or_top_p", &tr::DecodingMode::isTopKorTopP)
         .def_property_readonly("is_top_k_and_top_p", &tr::DecodingMode::isTopKandTopP)
-        .def_property_readonly("is_beam_search", &tr::DecodingMode::isBeamSearch);
+        .def_property_readonly("is_beam_search", &tr::DecodingMode::isBeamSearch)
+        .def_property_readonly("is_min_p", &tr::DecodingMode::isMinP)
+        .def_property_readonly("is_typical_p", &tr::DecodingMode::isTypicalP)
+        .def_property_readonly("is_sampling", &tr::DecodingMode::isSampling);
 
     py::enum_<nvinfer1::DataType>(m, "DataType")
         .value("FLOAT", nvinfer1::DataType::kFLOAT)
@@ -111,6 +120,11 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .value("INT64", nvinfer1::DataType::kINT64)
         .export_values();
 
+    py::enum_<tr::EmbeddingPooling>(m, "EmbeddingPooling")
+        .value("LAST", tr::EmbeddingPooling::kLAST)
+        .value("MEAN", tr::EmbeddingPooling::kMEAN)
+        .value("WEIGHTED_MEAN", tr::EmbeddingPooling::kWEIGHTED_MEAN);
+
     py::enum_<tr::GptModelConfig::ModelVariant>(m, "GptModelVariant")
         .value("GPT", tr::GptModelConfig::ModelVariant::kGpt)
         .value("GLM", tr::GptModelConfig::ModelVariant::kGlm);
@@ -126,6 +140,8 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_static("int8_kv_cache", &tc::QuantMode::int8KvCache)
         .def_static("fp8_kv_cache", &tc::QuantMode::fp8KvCache)
         .def_static("fp8_qdq", &tc::QuantMode::fp8Qdq)
+        .def_static("int4_kv_cache", &tc::QuantMode::int4KvCache)
+        .def_static("kv_cache_dynamic_scales", &tc::QuantMode::kvCacheDynamicScales)
         .def_property_readonly("value", &tc::QuantMode::value)
         .def("is_set", &tc::QuantMode::isSet, py::arg("mode"))
         .def_property_readonly("has_int4_weights", &tc::QuantMode::hasInt4Weights)
@@ -138,11 +154,13 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_property_readonly("has_int8_kv_cache", &tc::QuantMode::hasInt8KvCache)
         .def_property_readonly("has_fp8_kv_cache", &tc::QuantMode::hasFp8KvCache)
         .def_property_readonly("has_fp8_qdq", &tc::QuantMode::hasFp8Qdq)
+        .def_property_readonly("has_int4_kv_cache", &tc::QuantMode::hasInt4KvCache)
+        .def_property_readonly("has_kv_cache_dynamic_scales", &tc::QuantMode::hasKvCacheDynamicScales)
         .def_property_readonly("has_kv_cache_quant", &tc::QuantMode::hasKvCacheQuant)
         .def_static("from_description", &tc::QuantMode::fromDescription, py::arg("quantize_weights") = false,
             py::arg("quantize_activations") = false, py::arg("per_token") = false, py::arg("per_channel") = false,
             py::arg("per_group") = false, py::arg("use_int4_weights") = false, py::arg("use_int8_kv_cache") = false,
-            py::arg("use_fp8_kv_kache") = false, py::arg("use_fp8_qdq") = false)
+            py::arg("use_fp8_kv_kache") = false, py::arg("use_fp8_qdq") = false, py::arg("use_int4_kv_cache") = false)
         .def_static("use_smooth_quant", &tc::QuantMode::useSmoothQuant, py::arg("per_token") = false,
             py::arg("per_channel") = false)
         .def_static("use_weight_only", &tc::QuantMode::useWeightOnly, py::arg("use_int4_weights") = false,
@@ -193,6 +211,9 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_property("compute_generation_logits",
             py::overload_cast<>(&tr::GptModelConfig::computeGenerationLogits, py::const_),
             py::overload_cast<bool>(&tr::GptModelConfig::computeGenerationLogits))
+        .def_property("compute_hidden_states",
+            py::overload_cast<>(&tr::GptModelConfig::computeHiddenStates, py::const_),
+            py::overload_cast<bool>(&tr::GptModelConfig::computeHiddenStates))
         .def_property("model_variant", &tr::GptModelConfig::getModelVariant, &tr::GptModelConfig::setModelVariant)
         .def_property("use_custom_all_reduce", py::overload_cast<>(&tr::GptModelConfig::useCustomAllReduce, py::const_),
             py::overload_cast<bool>(&tr::GptModelConfig::useCustomAllReduce));
@@ -226,12 +247,16 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_readwrite("repetition_penalty", &tr::SamplingConfig::repetitionPenalty)
         .def_readwrite("presence_penalty", &tr::SamplingConfig::presencePenalty)
         .def_readwrite("frequency_penalty", &tr::SamplingConfig::frequencyPenalty)
+        .def_readwrite("logits_soft_cap", &tr::SamplingConfig::logitsSoftCap)
+        .def_readwrite("allowed_tokens", &tr::SamplingConfig::allowedTokens)
         .def_readwrite("top_k", &tr::SamplingConfig::topK)
         .def_readwrite("top_p", &tr::SamplingConfig::topP)
         .def_readwrite("random_seed", &tr::SamplingConfig::randomSeed)
         .def_readwrite("top_p_decay", &tr::SamplingConfig::topPDecay)
         .def_readwrite("top_p_min", &tr::SamplingConfig::topPMin)
         .def_readwrite("top_p_reset_ids", &tr::SamplingConfig::topPResetIds)
+        .def_readwrite("min_p", &tr::SamplingConfig::minP)
+        .def_readwrite("typical_p", &tr::SamplingConfig::typicalP)
         .def_readwrite("beam_search_diversity_rate", &tr::SamplingConfig::beamSearchDiversityRate)
         .def_readwrite("length_penalty", &tr::SamplingConfig::lengthPenalty)
         .def_readwrite("early_stopping", &tr::SamplingConfig::earlyStopping);
@@ -277,7 +302,14 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
             [](tr::GptSession& self, tpr::GenerationOutput& outputs, tpr::GenerationInput const& inputs,
                 tr::SamplingConfig const& samplingConfig)
             { self.generate(*outputs.toTrtLlm(), *inputs.toTrtLlm(), samplingConfig); },
-            py::arg("outputs"), py::arg("inputs"), py::arg("sampling_config"));
+            py::arg("outputs"), py::arg("inputs"), py::arg("sampling_config"))
+        .def(
+            "compute_embeddings",
+            [](tr::GptSession& self, at::Tensor& embeddings, tpr::GenerationInput const& inputs,
+                tr::EmbeddingPooling pooling, bool normalize)
+            { self.computeEmbeddings(tr::TorchView::of(embeddings), *inputs.toTrtLlm(), pooling, normalize); },
+            py::arg("embeddings"), py::arg("inputs"), py::arg("pooling") = tr::EmbeddingPooling::kLAST,
+            py::arg("normalize") = false);
 
     py::enum_<tb::LlmRequestState_t>(m, "LlmRequestState")
         .value("REQUEST_STATE_UNKNOWN", tb::LlmRequestState_t::REQUEST_STATE_UNKNOWN)
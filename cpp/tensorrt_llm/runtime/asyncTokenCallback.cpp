@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/asyncTokenCallback.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+using namespace tensorrt_llm::runtime;
+
+AsyncTokenCallback::AsyncTokenCallback(
+    Callback callback, TensorPtr outputIds, BufferManager const& manager, SizeType numSlots)
+    : mCallback{std::move(callback)}
+    , mOutputIds{std::move(outputIds)}
+    , mManager{manager}
+    , mSlots(numSlots)
+{
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(mCallback), "Undefined callback");
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(mOutputIds), "Undefined output ids");
+    TLLM_CHECK_WITH_INFO(numSlots > 0, "Number of slots must be positive");
+    for (SizeType slotIdx = 0; slotIdx < numSlots; ++slotIdx)
+    {
+        mSlots[slotIdx].outputIds = BufferManager::pinned(mOutputIds->getShape(), mOutputIds->getDataType());
+        mFreeSlots.push_back(slotIdx);
+    }
+    mThread = std::thread{&AsyncTokenCallback::run, this};
+}
+
+AsyncTokenCallback::~AsyncTokenCallback()
+{
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mShutdown = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+void AsyncTokenCallback::operator()(SizeType step, bool finished)
+{
+    SizeType slotIdx{0};
+    {
+        std::unique_lock<std::mutex> lock{mMutex};
+        mCondition.wait(lock, [this] { return !mFreeSlots.empty(); });
+        slotIdx = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+
+    auto& slot = mSlots[slotIdx];
+    // Output ids may have been reshaped since the last step.
+    slot.outputIds->reshape(mOutputIds->getShape());
+    mManager.copy(*mOutputIds, *slot.outputIds);
+    mManager.getStream().record(slot.copied);
+    slot.step = step;
+    slot.finished = finished;
+
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        mPendingSlots.push_back(slotIdx);
+    }
+    mCondition.notify_all();
+}
+
+void AsyncTokenCallback::flush()
+{
+    std::unique_lock<std::mutex> lock{mMutex};
+    mCondition.wait(lock, [this] { return mPendingSlots.empty() && !mRunning; });
+    if (mError)
+    {
+        std::rethrow_exception(std::exchange(mError, nullptr));
+    }
+}
+
+void AsyncTokenCallback::run()
+{
+    while (true)
+    {
+        SizeType slotIdx{0};
+        {
+            std::unique_lock<std::mutex> lock{mMutex};
+            mCondition.wait(lock, [this] { return mShutdown || !mPendingSlots.empty(); });
+            if (mPendingSlots.empty())
+            {
+                return;
+            }
+            slotIdx = mPendingSlots.front();
+            mPendingSlots.pop_front();
+            mRunning = true;
+        }
+
+        auto& slot = mSlots[slotIdx];
+        try
+        {
+            slot.copied.synchronize();
+            mCallback(slot.outputIds, slot.step, slot.finished);
+        }
+        catch (std::exception const& e)
+        {
+            TLLM_LOG_EXCEPTION(e);
+            std::lock_guard<std::mutex> lock{mMutex};
+            if (!mError)
+            {
+                mError = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mMutex};
+            mFreeSlots.push_back(slotIdx);
+            mRunning = false;
+        }
+        mCondition.notify_all();
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/generationOutput.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Runs the token generated callback of GptSession on a separate thread.
+//! \details Each call takes a snapshot of the output ids into a slot of a ring of pinned host buffers. The copy is
+//! issued on the stream of the buffer manager and a slot event marks its completion, so the generation loop does not
+//! wait for it. The worker thread waits for the event and invokes the user callback with the pinned snapshot, while
+//! the next generation step is already running. If all slots are in use, the generation loop waits for the oldest
+//! callback to return.
+class AsyncTokenCallback
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using Callback = GenerationOutput::Callback;
+
+    static SizeType constexpr kDefaultNumSlots{4};
+
+    AsyncTokenCallback(
+        Callback callback, TensorPtr outputIds, BufferManager const& manager, SizeType numSlots = kDefaultNumSlots);
+
+    ~AsyncTokenCallback();
+
+    AsyncTokenCallback(AsyncTokenCallback const&) = delete;
+    AsyncTokenCallback& operator=(AsyncTokenCallback const&) = delete;
+
+    //! \brief Snapshot the output ids and queue the callback for step.
+    void operator()(SizeType step, bool finished);
+
+    //! \brief Wait for all queued callbacks to return.
+    //! \details Rethrows the first exception thrown by the callback.
+    void flush();
+
+private:
+    struct Slot
+    {
+        TensorPtr outputIds;
+        CudaEvent copied{};
+        SizeType step{0};
+        bool finished{false};
+    };
+
+    void run();
+
+    Callback mCallback;
+    TensorPtr mOutputIds;
+    BufferManager const& mManager;
+    std::vector<Slot> mSlots;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    // Slots waiting for their callback, oldest first
+    std::deque<SizeType> mPendingSlots;
+    std::vector<SizeType> mFreeSlots;
+    bool mRunning{false};
+    bool mShutdown{false};
+    std::exception_ptr mError;
+    std::thread mThread;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/blockPointerTableUpdater.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+bool sameShape(ITensor::Shape const& lhs, ITensor::Shape const& rhs)
+{
+    return lhs.nbDims == rhs.nbDims && std::equal(lhs.d, lhs.d + lhs.nbDims, rhs.d);
+}
+} // namespace
+
+void BlockPointerTableUpdater::update(ITensor const& hostTable, ITensor& deviceTable, BufferManager const& manager)
+{
+    TLLM_CHECK_WITH_INFO(hostTable.getDataType() == nvinfer1::DataType::kINT64
+            && deviceTable.getDataType() == nvinfer1::DataType::kINT64,
+        "Block pointer tables must be of type kINT64");
+    TLLM_CHECK_WITH_INFO(hostTable.getSize() == deviceTable.getSize(), "Host and device tables differ in size");
+
+    auto const size = hostTable.getSize();
+    auto const* hostData = bufferCast<std::int64_t>(hostTable);
+    auto const& shape = hostTable.getShape();
+
+    if (mDeviceTable != deviceTable.data() || mShadow.size() != size || !sameShape(mShape, shape))
+    {
+        manager.copy(hostTable, deviceTable);
+        mShadow.assign(hostData, hostData + size);
+        mShape = shape;
+        mDeviceTable = deviceTable.data();
+        mNumUpdatedEntries = size;
+        return;
+    }
+
+    mDeltasHost.clear();
+    for (std::size_t idx = 0; idx < size; ++idx)
+    {
+        if (hostData[idx] != mShadow[idx])
+        {
+            mDeltasHost.push_back(static_cast<std::int64_t>(idx));
+        }
+    }
+    auto const numDeltas = mDeltasHost.size();
+    mNumUpdatedEntries = numDeltas;
+    if (numDeltas == 0)
+    {
+        return;
+    }
+    if (static_cast<float>(numDeltas) > mMaxDeltaFraction * static_cast<float>(size))
+    {
+        manager.copy(hostTable, deviceTable);
+        std::memcpy(mShadow.data(), hostData, size * sizeof(std::int64_t));
+        mNumUpdatedEntries = size;
+        return;
+    }
+
+    mDeltasHost.resize(2 * numDeltas);
+    for (std::size_t i = 0; i < numDeltas; ++i)
+    {
+        auto const idx = mDeltasHost[i];
+        mDeltasHost[numDeltas + i] = hostData[idx];
+        mShadow[idx] = hostData[idx];
+    }
+    auto const deltasShape = ITensor::makeShape({static_cast<SizeType>(2 * numDeltas)});
+    if (!mDeltasDevice)
+    {
+        mDeltasDevice = manager.gpu(deltasShape, nvinfer1::DataType::kINT64);
+    }
+    else
+    {
+        mDeltasDevice->reshape(deltasShape);
+    }
+    // The source is pageable memory, so it can be reused as soon as the copy returns.
+    manager.copy(mDeltasHost.data(), *mDeltasDevice, MemoryType::kCPU);
+    kernels::invokeScatterDeltas(deviceTable, *mDeltasDevice, manager.getStream());
+}
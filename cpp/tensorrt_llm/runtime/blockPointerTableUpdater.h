@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Keeps a device copy of the KV cache block pointer table in sync with its host copy.
+//! \details The table only changes in a few entries per generation step, typically when a sequence starts a new
+//! block. Instead of copying the whole table to the device, the entries that differ from the last upload are sent
+//! as (index, value) pairs and patched in place with a scatter kernel. The whole table is copied if its shape or
+//! location changed, after reset() or if too many entries changed for the scatter to pay off.
+class BlockPointerTableUpdater
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    //! \param maxDeltaFraction Fraction of changed entries above which the whole table is copied.
+    explicit BlockPointerTableUpdater(float maxDeltaFraction = 0.25f)
+        : mMaxDeltaFraction{maxDeltaFraction}
+    {
+    }
+
+    //! \brief Make deviceTable equal to hostTable. Both are kINT64 tensors with the same shape.
+    void update(ITensor const& hostTable, ITensor& deviceTable, BufferManager const& manager);
+
+    //! \brief Forget the last upload, e.g. because the device table was written by someone else.
+    void reset()
+    {
+        mShadow.clear();
+        mDeviceTable = nullptr;
+    }
+
+    //! \brief Number of entries sent to the device by the last update.
+    [[nodiscard]] std::size_t getNumUpdatedEntries() const
+    {
+        return mNumUpdatedEntries;
+    }
+
+private:
+    float mMaxDeltaFraction;
+    // Host copy of the table as of the last upload
+    std::vector<std::int64_t> mShadow;
+    ITensor::Shape mShape{};
+    void const* mDeviceTable{nullptr};
+    // Changed indices followed by their values
+    std::vector<std::int64_t> mDeltasHost;
+    TensorPtr mDeltasDevice;
+    std::size_t mNumUpdatedEntries{0};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -20,34 +20,130 @@
 #include <cstring>
 #include <cuda_runtime_api.h>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <unordered_set>
+#include <utility>
 
 using namespace tensorrt_llm::runtime;
 
 namespace tc = tensorrt_llm::common;
 
+namespace
+{
+std::mutex& defaultMemoryPoolConfigMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+BufferManager::MemoryPoolConfig& defaultMemoryPoolConfig()
+{
+    static BufferManager::MemoryPoolConfig config;
+    return config;
+}
+
+bool isDefault(BufferManager::MemoryPoolConfig const& poolConfig)
+{
+    return !poolConfig.releaseThreshold && !poolConfig.peerDevices && poolConfig.poolName.empty();
+}
+} // namespace
+
 BufferManager::BufferManager(CudaStreamPtr stream)
+    : BufferManager{std::move(stream), getDefaultMemoryPoolConfig()}
+{
+}
+
+BufferManager::BufferManager(CudaStreamPtr stream, MemoryPoolConfig poolConfig)
     : mStream{std::move(stream)}
+    , mPoolConfig{std::move(poolConfig)}
 {
     TLLM_CHECK_WITH_INFO(static_cast<bool>(mStream), "Undefined CUDA stream");
-    thread_local static std::unordered_set<int> initializedDevices(8);
     auto const device = mStream->getDevice();
-    if (initializedDevices.find(device) == initializedDevices.end())
+    if (!mPoolConfig.poolName.empty())
+    {
+        mMemPool = getNamedMemoryPool(mPoolConfig.poolName, device, mPoolConfig.maxPoolSize);
+    }
+    auto const memPool = getMemoryPool();
+    // The default configuration is applied once, explicit configurations override the current pool attributes.
+    thread_local static std::unordered_set<::cudaMemPool_t> initializedPools(8);
+    if (!isDefault(mPoolConfig) || initializedPools.find(memPool) == initializedPools.end())
     {
-        initializedDevices.insert(device);
-        initMemoryPool(device);
+        initializedPools.insert(memPool);
+        initMemoryPool(memPool, device, mPoolConfig);
     }
 }
 
+void BufferManager::setDefaultMemoryPoolConfig(MemoryPoolConfig poolConfig)
+{
+    std::lock_guard<std::mutex> lock(defaultMemoryPoolConfigMutex());
+    defaultMemoryPoolConfig() = std::move(poolConfig);
+}
+
+BufferManager::MemoryPoolConfig BufferManager::getDefaultMemoryPoolConfig()
+{
+    std::lock_guard<std::mutex> lock(defaultMemoryPoolConfigMutex());
+    return defaultMemoryPoolConfig();
+}
+
+::cudaMemPool_t BufferManager::getNamedMemoryPool(std::string const& name, int device, std::size_t maxPoolSize)
+{
+    TLLM_CHECK_WITH_INFO(!name.empty(), "Memory pool name must not be empty");
+    static std::mutex mutex;
+    static std::map<std::pair<std::string, int>, ::cudaMemPool_t> pools;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto const key = std::make_pair(name, device);
+    if (auto it = pools.find(key); it != pools.end())
+    {
+        return it->second;
+    }
+
+    ::cudaMemPoolProps props{};
+    props.allocType = cudaMemAllocationTypePinned;
+    props.handleTypes = cudaMemHandleTypeNone;
+    props.location.type = cudaMemLocationTypeDevice;
+    props.location.id = device;
+#if CUDART_VERSION >= 12020
+    props.maxSize = maxPoolSize;
+#else
+    TLLM_CHECK_WITH_INFO(maxPoolSize == 0, "Bounding the memory pool size requires CUDA 12.2");
+#endif
+    ::cudaMemPool_t memPool;
+    TLLM_CUDA_CHECK(cudaMemPoolCreate(&memPool, &props));
+    TLLM_LOG_INFO("Created memory pool %s on device %d", name.c_str(), device);
+    pools.emplace(key, memPool);
+    return memPool;
+}
+
 BufferManager::IBufferPtr BufferManager::gpu(std::size_t size, nvinfer1::DataType type) const
 {
-    return std::make_unique<DeviceBuffer>(size, type, CudaAllocatorAsync{mStream});
+    return gpu(size, type, MemoryCounters::getCurrentTag());
 }
 
 BufferManager::ITensorPtr BufferManager::gpu(nvinfer1::Dims dims, nvinfer1::DataType type) const
 {
-    return std::make_unique<DeviceTensor>(dims, type, CudaAllocatorAsync{mStream});
+    return gpu(dims, type, MemoryCounters::getCurrentTag());
+}
+
+BufferManager::IBufferPtr BufferManager::gpu(std::size_t size, nvinfer1::DataType type, MemoryTag tag) const
+{
+    auto allocator = CudaAllocatorAsync{mStream, mMemPool};
+    if (tag == MemoryCounters::kUntagged)
+    {
+        return std::make_unique<DeviceBuffer>(size, type, std::move(allocator));
+    }
+    return std::make_unique<TaggedDeviceBuffer>(size, type, TaggedAllocator{std::move(allocator), tag});
+}
+
+BufferManager::ITensorPtr BufferManager::gpu(nvinfer1::Dims dims, nvinfer1::DataType type, MemoryTag tag) const
+{
+    auto allocator = CudaAllocatorAsync{mStream, mMemPool};
+    if (tag == MemoryCounters::kUntagged)
+    {
+        return std::make_unique<DeviceTensor>(dims, type, std::move(allocator));
+    }
+    return std::make_unique<TaggedDeviceTensor>(dims, type, TaggedAllocator{std::move(allocator), tag});
 }
 
 BufferManager::IBufferPtr BufferManager::cpu(std::size_t size, nvinfer1::DataType type)
@@ -62,12 +158,30 @@ BufferManager::ITensorPtr BufferManager::cpu(nvinfer1::Dims dims, nvinfer1::Data
 
 BufferManager::IBufferPtr BufferManager::pinned(std::size_t size, nvinfer1::DataType type)
 {
-    return std::make_unique<PinnedBuffer>(size, type);
+    return pinned(size, type, MemoryCounters::getCurrentTag());
 }
 
 BufferManager::ITensorPtr BufferManager::pinned(nvinfer1::Dims dims, nvinfer1::DataType type)
 {
-    return std::make_unique<PinnedTensor>(dims, type);
+    return pinned(dims, type, MemoryCounters::getCurrentTag());
+}
+
+BufferManager::IBufferPtr BufferManager::pinned(std::size_t size, nvinfer1::DataType type, MemoryTag tag)
+{
+    if (tag == MemoryCounters::kUntagged)
+    {
+        return std::make_unique<PinnedBuffer>(size, type);
+    }
+    return std::make_unique<TaggedPinnedBuffer>(size, type, TaggedAllocator{PinnedAllocator{}, tag});
+}
+
+BufferManager::ITensorPtr BufferManager::pinned(nvinfer1::Dims dims, nvinfer1::DataType type, MemoryTag tag)
+{
+    if (tag == MemoryCounters::kUntagged)
+    {
+        return std::make_unique<PinnedTensor>(dims, type);
+    }
+    return std::make_unique<TaggedPinnedTensor>(dims, type, TaggedAllocator{PinnedAllocator{}, tag});
 }
 
 BufferManager::IBufferPtr BufferManager::pinnedPool(std::size_t size, nvinfer1::DataType type)
@@ -80,6 +194,16 @@ BufferManager::ITensorPtr BufferManager::pinnedPool(nvinfer1::Dims dims, nvinfer
     return std::make_unique<PinnedPoolTensor>(dims, type);
 }
 
+BufferManager::IBufferPtr BufferManager::pinnedSizeClass(std::size_t size, nvinfer1::DataType type)
+{
+    return std::make_unique<PinnedSizeClassBuffer>(size, type);
+}
+
+BufferManager::ITensorPtr BufferManager::pinnedSizeClass(nvinfer1::Dims dims, nvinfer1::DataType type)
+{
+    return std::make_unique<PinnedSizeClassTensor>(dims, type);
+}
+
 BufferManager::IBufferPtr BufferManager::managed(std::size_t size, nvinfer1::DataType type)
 {
     return std::make_unique<UVMBuffer>(size, type);
@@ -188,17 +312,28 @@ CudaStream const& BufferManager::getStream() const
     return *mStream;
 }
 
-void BufferManager::initMemoryPool(int device)
+void BufferManager::initMemoryPool(::cudaMemPool_t memPool, int device, MemoryPoolConfig const& poolConfig)
 {
     auto const deviceCount = tc::getDeviceCount();
-    ::cudaMemPool_t memPool;
-    TLLM_CUDA_CHECK(cudaDeviceGetDefaultMemPool(&memPool, device));
-    for (auto peerDevice = 0; peerDevice < deviceCount; ++peerDevice)
+    std::vector<int> peerDevices;
+    if (poolConfig.peerDevices)
+    {
+        peerDevices = *poolConfig.peerDevices;
+    }
+    else
+    {
+        for (auto peerDevice = 0; peerDevice < deviceCount; ++peerDevice)
+        {
+            peerDevices.push_back(peerDevice);
+        }
+    }
+    for (auto const peerDevice : peerDevices)
     {
         if (peerDevice == device)
         {
             continue;
         }
+        TLLM_CHECK_WITH_INFO(peerDevice >= 0 && peerDevice < deviceCount, "Invalid peer device %d", peerDevice);
         int peerAccessAvailable = 0;
         TLLM_CUDA_CHECK(cudaDeviceCanAccessPeer(&peerAccessAvailable, device, peerDevice));
         if (!peerAccessAvailable)
@@ -213,53 +348,67 @@ void BufferManager::initMemoryPool(int device)
         desc.flags = cudaMemAccessFlagsProtReadWrite;
         TLLM_CUDA_CHECK(cudaMemPoolSetAccess(memPool, &desc, 1));
     }
-    // set memory pool threshold to avoid shrinking the pool
-    auto maxThreshold = std::numeric_limits<std::uint64_t>::max();
-    TLLM_CUDA_CHECK(cudaMemPoolSetAttribute(memPool, cudaMemPoolAttrReleaseThreshold, &maxThreshold));
+    // by default, set memory pool threshold to avoid shrinking the pool
+    auto threshold = poolConfig.releaseThreshold.value_or(std::numeric_limits<std::uint64_t>::max());
+    TLLM_CUDA_CHECK(cudaMemPoolSetAttribute(memPool, cudaMemPoolAttrReleaseThreshold, &threshold));
 }
 
-std::size_t BufferManager::memoryPoolReserved(int device)
+::cudaMemPool_t BufferManager::getMemoryPool() const
 {
+    if (mMemPool)
+    {
+        return mMemPool;
+    }
     ::cudaMemPool_t memPool;
-    TLLM_CUDA_CHECK(cudaDeviceGetDefaultMemPool(&memPool, device));
+    TLLM_CUDA_CHECK(cudaDeviceGetDefaultMemPool(&memPool, mStream->getDevice()));
+    return memPool;
+}
+
+std::size_t BufferManager::memoryPoolReserved(::cudaMemPool_t memPool)
+{
     std::size_t reserved = 0;
     TLLM_CUDA_CHECK(cudaMemPoolGetAttribute(memPool, cudaMemPoolAttrReservedMemCurrent, &reserved));
     return reserved;
 }
 
-std::size_t BufferManager::memoryPoolUsed(int device)
+std::size_t BufferManager::memoryPoolUsed(::cudaMemPool_t memPool)
 {
-    ::cudaMemPool_t memPool;
-    TLLM_CUDA_CHECK(cudaDeviceGetDefaultMemPool(&memPool, device));
     std::size_t used = 0;
     TLLM_CUDA_CHECK(cudaMemPoolGetAttribute(memPool, cudaMemPoolAttrUsedMemCurrent, &used));
     return used;
 }
 
-void BufferManager::memoryPoolTrimTo(int device, std::size_t size)
+void BufferManager::memoryPoolTrimTo(::cudaMemPool_t memPool, std::size_t size)
 {
-    ::cudaMemPool_t memPool;
-    TLLM_CUDA_CHECK(cudaDeviceGetDefaultMemPool(&memPool, device));
     TLLM_CUDA_CHECK(cudaMemPoolTrimTo(memPool, size));
 }
 
 std::size_t BufferManager::memoryPoolReserved() const
 {
-    return memoryPoolReserved(mStream->getDevice());
+    return memoryPoolReserved(getMemoryPool());
 }
 
 std::size_t BufferManager::memoryPoolUsed() const
 {
-    return memoryPoolUsed(mStream->getDevice());
+    return memoryPoolUsed(getMemoryPool());
 }
 
 std::size_t BufferManager::memoryPoolFree() const
 {
-    return memoryPoolFree(mStream->getDevice());
+    return memoryPoolFree(getMemoryPool());
 }
 
 void BufferManager::memoryPoolTrimTo(std::size_t size)
 {
     mStream->synchronize();
-    memoryPoolTrimTo(mStream->getDevice(), size);
+    memoryPoolTrimTo(getMemoryPool(), size);
+}
+
+void BufferManager::onIdle()
+{
+    if (mPoolConfig.idleTrimSize)
+    {
+        TLLM_LOG_DEBUG("Trimming memory pool to %zu B on idle", *mPoolConfig.idleTrimSize);
+        memoryPoolTrimTo(*mPoolConfig.idleTrimSize);
+    }
 }
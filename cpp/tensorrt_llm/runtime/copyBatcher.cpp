@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/copyBatcher.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+// Alignment of the staged copies, so that the copy kernel can use 16-byte accesses
+std::size_t constexpr kStagingAlignment{16};
+
+std::size_t alignStaging(std::size_t size)
+{
+    return (size + kStagingAlignment - 1) / kStagingAlignment * kStagingAlignment;
+}
+
+bool isHostMemory(MemoryType memoryType)
+{
+    return memoryType == MemoryType::kCPU || memoryType == MemoryType::kPINNED;
+}
+} // namespace
+
+CopyBatcher::CopyBatcher(
+    BufferManager::CudaStreamPtr stream, std::size_t arenaSize, std::size_t maxCopySize, SizeType maxCopies)
+    : mStream{std::move(stream)}
+    , mManager{mStream}
+    , mArenaSize{alignStaging(arenaSize)}
+    , mMaxCopySize{maxCopySize}
+    , mMaxCopies{maxCopies}
+{
+    TLLM_CHECK_WITH_INFO(0 < maxCopySize && maxCopySize <= arenaSize && maxCopies > 0,
+        "Invalid copy batcher of %zu bytes for %d copies of at most %zu bytes", arenaSize, maxCopies, maxCopySize);
+    // The descriptors of the copies follow the staged bytes, so that both go to the device in one memcpy
+    auto const size = mArenaSize + static_cast<std::size_t>(mMaxCopies) * sizeof(kernels::CopyBatchEntry);
+    for (auto& arena : mArenas)
+    {
+        arena.host = BufferManager::pinned(size);
+        arena.device = mManager.gpu(size);
+        arena.hostScatters.reserve(mMaxCopies);
+    }
+    mEntries.reserve(mMaxCopies);
+}
+
+CopyBatcher::~CopyBatcher()
+{
+    flush();
+    // The host callbacks refer to the arenas
+    for (auto& arena : mArenas)
+    {
+        if (arena.inFlight)
+        {
+            arena.flushed.synchronize();
+        }
+    }
+}
+
+void CopyBatcher::copy(IBuffer const& src, IBuffer& dst)
+{
+    auto const size = src.getSizeInBytes();
+    TLLM_CHECK_WITH_INFO(size == dst.getSizeInBytes(), "Incompatible buffer sizes: %zu bytes copied into %zu bytes",
+        size, dst.getSizeInBytes());
+    if (size > mMaxCopySize || (isHostMemory(src.getMemoryType()) && isHostMemory(dst.getMemoryType())))
+    {
+        flush();
+        mManager.copy(src, dst);
+        return;
+    }
+    enqueue(src.data(), src.getMemoryType(), dst.data(), dst.getMemoryType(), size);
+}
+
+void CopyBatcher::copy(void const* src, IBuffer& dst)
+{
+    auto const size = dst.getSizeInBytes();
+    auto const srcType = IBuffer::memoryType(src);
+    if (size > mMaxCopySize || (isHostMemory(srcType) && isHostMemory(dst.getMemoryType())))
+    {
+        flush();
+        mManager.copy(src, dst, srcType);
+        return;
+    }
+    enqueue(src, srcType, dst.data(), dst.getMemoryType(), size);
+}
+
+void CopyBatcher::enqueue(void const* src, MemoryType srcType, void* dst, MemoryType dstType, std::size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    auto const srcOnHost = isHostMemory(srcType);
+    auto const dstOnHost = isHostMemory(dstType);
+    auto const stagedSize = srcOnHost || dstOnHost ? alignStaging(size) : 0;
+    if (getNumPending() == mMaxCopies || mPayloadSize + stagedSize > mArenaSize)
+    {
+        flush();
+    }
+    auto& arena = currentArena();
+    auto* deviceStaging = static_cast<std::uint8_t*>(arena.device->data()) + mPayloadSize;
+    if (srcOnHost)
+    {
+        std::memcpy(static_cast<std::uint8_t*>(arena.host->data()) + mPayloadSize, src, size);
+        mEntries.push_back({deviceStaging, dst, size});
+    }
+    else if (dstOnHost)
+    {
+        mEntries.push_back({src, deviceStaging, size});
+        arena.hostScatters.push_back({mPayloadSize, dst, size});
+    }
+    else
+    {
+        mEntries.push_back({src, dst, size});
+    }
+    mPayloadSize += stagedSize;
+}
+
+CopyBatcher::Arena& CopyBatcher::currentArena()
+{
+    auto& arena = mArenas[mCurrent];
+    if (arena.inFlight)
+    {
+        arena.flushed.synchronize();
+        arena.hostScatters.clear();
+        arena.inFlight = false;
+    }
+    return arena;
+}
+
+void CopyBatcher::flush()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (mEntries.empty())
+    {
+        return;
+    }
+    auto& arena = mArenas[mCurrent];
+    auto* hostData = static_cast<std::uint8_t*>(arena.host->data());
+    auto* deviceData = static_cast<std::uint8_t*>(arena.device->data());
+    auto const entriesSize = mEntries.size() * sizeof(kernels::CopyBatchEntry);
+    std::memcpy(hostData + mPayloadSize, mEntries.data(), entriesSize);
+
+    auto const stream = mStream->get();
+    TLLM_CUDA_CHECK(
+        cudaMemcpyAsync(deviceData, hostData, mPayloadSize + entriesSize, cudaMemcpyHostToDevice, stream));
+    kernels::invokeCopyBatch(reinterpret_cast<kernels::CopyBatchEntry const*>(deviceData + mPayloadSize),
+        getNumPending(), *mStream);
+    if (!arena.hostScatters.empty())
+    {
+        TLLM_CUDA_CHECK(cudaMemcpyAsync(hostData, deviceData, mPayloadSize, cudaMemcpyDeviceToHost, stream));
+        TLLM_CUDA_CHECK(cudaLaunchHostFunc(stream, &CopyBatcher::scatterToHost, &arena));
+    }
+    mStream->record(arena.flushed);
+    arena.inFlight = true;
+
+    TLLM_LOG_DEBUG("Flushed %d copies with %zu staged bytes", getNumPending(), mPayloadSize);
+    mEntries.clear();
+    mPayloadSize = 0;
+    mCurrent = (mCurrent + 1) % kNumArenas;
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void CopyBatcher::scatterToHost(void* arena)
+{
+    auto const& self = *static_cast<Arena const*>(arena);
+    auto const* hostData = static_cast<std::uint8_t const*>(self.host->data());
+    for (auto const& scatter : self.hostScatters)
+    {
+        std::memcpy(scatter.dst, hostData + scatter.offset, scatter.size);
+    }
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Coalesces the small copies issued on one stream into one memcpy and one invokeCopyBatch launch.
+//!
+//! Host sources are staged into a pinned arena when the copy is enqueued, so they may be reused right away. At flush,
+//! the arena and the copy descriptors go to the device in one cudaMemcpyAsync, and a single launch scatters them into
+//! their destinations together with the device-to-device copies. Device-to-host copies are gathered by the same launch
+//! into the device arena, copied back in one memcpy and written to their destinations by a host callback on the
+//! stream. Copies larger than maxCopySize or between two host buffers are issued directly after a flush, so all copies
+//! keep their order. Device sources are read at flush time.
+//!
+//! Call flush() at every stream-ordering point: before enqueuing other work that reads a destination or writes a
+//! source, and before recording an event on or synchronizing the stream. Two arenas alternate, so that staging for the
+//! next flush rarely waits for the previous one. Pending copies are flushed on destruction. Not thread-safe.
+class CopyBatcher
+{
+public:
+    static std::size_t constexpr kDefaultArenaSize{std::size_t{1} << 16};
+    static std::size_t constexpr kDefaultMaxCopySize{4096};
+    static SizeType constexpr kDefaultMaxCopies{256};
+
+    explicit CopyBatcher(BufferManager::CudaStreamPtr stream, std::size_t arenaSize = kDefaultArenaSize,
+        std::size_t maxCopySize = kDefaultMaxCopySize, SizeType maxCopies = kDefaultMaxCopies);
+
+    ~CopyBatcher();
+
+    CopyBatcher(CopyBatcher const&) = delete;
+    CopyBatcher& operator=(CopyBatcher const&) = delete;
+
+    //! \brief Enqueue a copy of src into dst, which must have the same size in bytes.
+    void copy(IBuffer const& src, IBuffer& dst);
+
+    //! \brief Enqueue a copy of dst.getSizeInBytes() bytes of host memory src into dst.
+    void copy(void const* src, IBuffer& dst);
+
+    //! \brief Issue the pending copies on the stream.
+    void flush();
+
+    [[nodiscard]] SizeType getNumPending() const noexcept
+    {
+        return static_cast<SizeType>(mEntries.size());
+    }
+
+    [[nodiscard]] BufferManager::CudaStreamPtr const& getStream() const noexcept
+    {
+        return mStream;
+    }
+
+private:
+    static auto constexpr kNumArenas = 2;
+
+    struct HostScatter
+    {
+        std::size_t offset;
+        void* dst;
+        std::size_t size;
+    };
+
+    struct Arena
+    {
+        IBuffer::UniquePtr host;   // [arenaSize + maxCopies * sizeof(CopyBatchEntry)] bytes, pinned
+        IBuffer::UniquePtr device; // same size, on gpu
+        std::vector<HostScatter> hostScatters;
+        CudaEvent flushed;         // recorded after the last use of the arena by a flush
+        bool inFlight{false};
+    };
+
+    void enqueue(void const* src, MemoryType srcType, void* dst, MemoryType dstType, std::size_t size);
+
+    //! \brief The arena of the next flush, once its previous flush has completed.
+    Arena& currentArena();
+
+    //! \brief Host callback writing the device-to-host copies of an arena to their destinations.
+    static void scatterToHost(void* arena);
+
+    BufferManager::CudaStreamPtr mStream;
+    BufferManager mManager;
+    std::size_t mArenaSize;
+    std::size_t mMaxCopySize;
+    SizeType mMaxCopies;
+    std::array<Arena, kNumArenas> mArenas;
+    SizeType mCurrent{0};
+    std::size_t mPayloadSize{0};
+    std::vector<kernels::CopyBatchEntry> mEntries;
+};
+
+} // namespace tensorrt_llm::runtime
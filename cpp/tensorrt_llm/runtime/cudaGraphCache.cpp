@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/cudaGraphCache.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/startupReport.h"
+
+#include <exception>
+
+using namespace tensorrt_llm::runtime;
+
+CudaGraphCache::CudaGraphCache(SizeType capacity)
+    : mCapacity{capacity}
+{
+    TLLM_CHECK_WITH_INFO(mCapacity > 0, "CUDA graph cache size must be positive");
+}
+
+CudaGraphCache::~CudaGraphCache()
+{
+    try
+    {
+        clear();
+    }
+    catch (std::exception& e)
+    {
+        TLLM_LOG_EXCEPTION(e);
+    }
+}
+
+void CudaGraphCache::launch(Key const& key, CudaStream const& stream, Enqueue const& enqueue)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto* entry = find(key);
+    if (entry == nullptr)
+    {
+        // Warm-up step, captured from the next step on
+        insert(key);
+        enqueue();
+        TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+        return;
+    }
+
+    // Also times the launch, which waits for the upload of a newly instantiated graph
+    StartupReport::ScopedPhase const startupPhase{"cuda_graph_capture"};
+    cudaGraph_t graph;
+    TLLM_CUDA_CHECK(cudaStreamBeginCapture(stream.get(), cudaStreamCaptureModeThreadLocal));
+    try
+    {
+        enqueue();
+    }
+    catch (...)
+    {
+        // End the capture so that the stream can be used again, the partial graph is dropped.
+        if (cudaStreamEndCapture(stream.get(), &graph) == cudaSuccess)
+        {
+            cudaGraphDestroy(graph);
+        }
+        throw;
+    }
+    TLLM_CUDA_CHECK(cudaStreamEndCapture(stream.get(), &graph));
+
+    if (entry->instance != nullptr && cudaGraphExecUpdate(entry->instance, graph, nullptr) != cudaSuccess)
+    {
+        // The topology changed, e.g. because a penalty was enabled for the batch.
+        // Clear the error of the failed update, it is expected.
+        cudaGetLastError();
+        destroy(*entry);
+    }
+    if (entry->instance == nullptr)
+    {
+        TLLM_CUDA_CHECK(cudaGraphInstantiate(&entry->instance, graph, nullptr, nullptr, 0));
+        ++mNumInstantiations;
+    }
+    TLLM_CUDA_CHECK(cudaGraphDestroy(graph));
+    TLLM_CUDA_CHECK(cudaGraphLaunch(entry->instance, stream.get()));
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void CudaGraphCache::clear()
+{
+    for (auto& entry : mEntries)
+    {
+        destroy(entry);
+    }
+    mIndex.clear();
+    mEntries.clear();
+}
+
+SizeType CudaGraphCache::getBatchSizeBucket(SizeType batchSize)
+{
+    SizeType bucket{1};
+    while (bucket < batchSize)
+    {
+        bucket *= 2;
+    }
+    return bucket;
+}
+
+CudaGraphCache::Entry* CudaGraphCache::find(Key const& key)
+{
+    auto it = mIndex.find(key);
+    if (it == mIndex.end())
+    {
+        return nullptr;
+    }
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+    return &*it->second;
+}
+
+CudaGraphCache::Entry& CudaGraphCache::insert(Key const& key)
+{
+    if (size() >= mCapacity)
+    {
+        TLLM_LOG_DEBUG("Evicting least recently used CUDA graph instance");
+        destroy(mEntries.back());
+        mIndex.erase(mEntries.back().key);
+        mEntries.pop_back();
+    }
+    auto& entry = mEntries.emplace_front();
+    entry.key = key;
+    mIndex.emplace(key, mEntries.begin());
+    return entry;
+}
+
+void CudaGraphCache::destroy(Entry& entry)
+{
+    if (entry.instance != nullptr)
+    {
+        TLLM_CUDA_CHECK(cudaGraphExecDestroy(entry.instance));
+        entry.instance = nullptr;
+    }
+}
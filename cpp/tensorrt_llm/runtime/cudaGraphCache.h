@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <cuda_runtime_api.h>
+
+#include <functional>
+#include <list>
+#include <map>
+#include <tuple>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief LRU cache of executable CUDA graphs for a sequence of small kernels that is enqueued at every step.
+//! \details The work of a step is captured into a graph and applied to the cached instance of its key with
+//! cudaGraphExecUpdate, so kernel parameters that change between steps are picked up without instantiating a new
+//! graph. A new instance is only created if the topology of the captured graph changed. The first step of a key is
+//! enqueued without capture, which lets lazily allocated buffers be allocated outside of a capture.
+class CudaGraphCache
+{
+public:
+    // (batch size bucket, beam width, mode), defined by the user of the cache
+    using Key = std::tuple<SizeType, SizeType, SizeType>;
+    using Enqueue = std::function<void()>;
+
+    static SizeType constexpr kDefaultCapacity{8};
+
+    explicit CudaGraphCache(SizeType capacity = kDefaultCapacity);
+
+    ~CudaGraphCache();
+
+    CudaGraphCache(CudaGraphCache const&) = delete;
+    CudaGraphCache& operator=(CudaGraphCache const&) = delete;
+
+    //! \brief Run the work of enqueue on stream, as a graph if the key was seen before.
+    //! \details enqueue must only enqueue work on stream, or on streams joined to it with events, and must not
+    //! synchronize.
+    void launch(Key const& key, CudaStream const& stream, Enqueue const& enqueue);
+
+    void clear();
+
+    [[nodiscard]] SizeType size() const
+    {
+        return static_cast<SizeType>(mEntries.size());
+    }
+
+    //! \brief Number of graphs that had to be instantiated because no instance could be updated.
+    [[nodiscard]] std::size_t getNumInstantiations() const
+    {
+        return mNumInstantiations;
+    }
+
+    //! \brief Smallest power of 2 greater than or equal to batchSize.
+    [[nodiscard]] static SizeType getBatchSizeBucket(SizeType batchSize);
+
+private:
+    struct Entry
+    {
+        Key key;
+        cudaGraphExec_t instance{nullptr};
+    };
+
+    //! \brief Find the entry of key and make it the most recently used one, nullptr if there is none.
+    Entry* find(Key const& key);
+
+    Entry& insert(Key const& key);
+
+    static void destroy(Entry& entry);
+
+    SizeType mCapacity;
+    // most recently used first
+    std::list<Entry> mEntries;
+    std::map<Key, std::list<Entry>::iterator> mIndex;
+    std::size_t mNumInstantiations{0};
+};
+
+} // namespace tensorrt_llm::runtime
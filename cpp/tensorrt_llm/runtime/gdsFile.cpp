@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/gdsFile.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <cuda_runtime_api.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#ifdef ENABLE_CUFILE
+#include <cufile.h>
+#endif
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+#ifdef ENABLE_CUFILE
+// The driver is opened once per process and closed at exit, opening it costs tens of milliseconds.
+class CuFileDriver
+{
+public:
+    static CuFileDriver const& getInstance()
+    {
+        static CuFileDriver const driver;
+        return driver;
+    }
+
+    [[nodiscard]] bool isOpen() const noexcept
+    {
+        return mOpen;
+    }
+
+    ~CuFileDriver()
+    {
+        if (mOpen)
+        {
+            cuFileDriverClose();
+        }
+    }
+
+private:
+    CuFileDriver()
+    {
+        auto const status = cuFileDriverOpen();
+        mOpen = status.err == CU_FILE_SUCCESS;
+        if (!mOpen)
+        {
+            TLLM_LOG_WARNING("GPUDirect Storage is not available (cuFile error %d), device buffers are staged through "
+                             "host memory",
+                static_cast<int>(status.err));
+        }
+    }
+
+    bool mOpen{false};
+};
+#endif
+} // namespace
+
+struct GdsFile::Transfer
+{
+    bool isWrite;
+    // Keeps the buffer alive until the stream has passed the transfer
+    IBuffer::SharedConstPtr buffer;
+    std::vector<Extent> extents;
+    std::size_t numBytes{0};
+    int fd{-1};
+
+    // Host memory of pread / pwrite, either the buffer or the staging buffer, with the offset of each extent in it
+    std::uint8_t* hostData{nullptr};
+    std::vector<std::size_t> hostOffsets;
+    IBuffer::SharedPtr staging;
+    // errno of the host function, 0 on success
+    int error{0};
+
+    // Arguments and results of cuFile, which reads them when the stream reaches the transfer
+    std::vector<std::size_t> gdsSizes;
+    std::vector<std::int64_t> gdsFileOffsets;
+    std::vector<std::int64_t> gdsBufferOffsets;
+    std::vector<std::int64_t> gdsBytes;
+
+    CudaEvent done;
+};
+
+GdsFile::GdsFile(std::filesystem::path path, std::size_t size, bool removeOnClose)
+    : mPath{std::move(path)}
+    , mSize{size}
+    , mRemoveOnClose{removeOnClose}
+{
+    TLLM_CHECK_WITH_INFO(mSize > 0, "File %s must not be empty", mPath.c_str());
+#if defined(__linux__)
+    if (mPath.has_parent_path())
+    {
+        std::filesystem::create_directories(mPath.parent_path());
+    }
+    mFd = ::open(mPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    TLLM_CHECK_WITH_INFO(mFd >= 0, "Failed to open %s: %s", mPath.c_str(), std::strerror(errno));
+    if (::ftruncate(mFd, static_cast<off_t>(mSize)) != 0)
+    {
+        auto const error = errno;
+        ::close(mFd);
+        TLLM_THROW("Failed to resize %s to %zu bytes: %s", mPath.c_str(), mSize, std::strerror(error));
+    }
+
+#ifdef ENABLE_CUFILE
+    if (isGdsAvailable())
+    {
+        // cuFile needs O_DIRECT, which in turn needs aligned host buffers, so pread / pwrite keep their own descriptor
+        mDirectFd = ::open(mPath.c_str(), O_RDWR | O_DIRECT);
+        CUfileError_t status{};
+        status.err = CU_FILE_INVALID_FILE_TYPE;
+        CUfileHandle_t handle{};
+        if (mDirectFd >= 0)
+        {
+            CUfileDescr_t descr{};
+            descr.handle.fd = mDirectFd;
+            descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+            status = cuFileHandleRegister(&handle, &descr);
+        }
+        if (status.err == CU_FILE_SUCCESS)
+        {
+            mCuFileHandle = handle;
+            mUsesGds = true;
+        }
+        else
+        {
+            TLLM_LOG_WARNING("Failed to register %s with cuFile (error %d), device buffers are staged through host "
+                             "memory",
+                mPath.c_str(), static_cast<int>(status.err));
+            if (mDirectFd >= 0)
+            {
+                ::close(mDirectFd);
+                mDirectFd = -1;
+            }
+        }
+    }
+#endif
+    TLLM_LOG_DEBUG("Opened %s with %zu bytes%s", mPath.c_str(), mSize, mUsesGds ? " for GPUDirect Storage" : "");
+#else
+    TLLM_THROW("GdsFile is only supported on Linux");
+#endif
+}
+
+GdsFile::~GdsFile()
+{
+    for (auto const& transfer : mTransfers)
+    {
+        ::cudaEventSynchronize(transfer->done.get());
+        if (transfer->error != 0)
+        {
+            TLLM_LOG_ERROR("Transfer to or from %s failed: %s", mPath.c_str(), std::strerror(transfer->error));
+        }
+    }
+    mTransfers.clear();
+#ifdef ENABLE_CUFILE
+    if (mCuFileHandle != nullptr)
+    {
+        cuFileHandleDeregister(static_cast<CUfileHandle_t>(mCuFileHandle));
+    }
+#endif
+#if defined(__linux__)
+    if (mDirectFd >= 0)
+    {
+        ::close(mDirectFd);
+    }
+    if (mFd >= 0)
+    {
+        ::close(mFd);
+    }
+#endif
+    if (mRemoveOnClose)
+    {
+        std::error_code ec;
+        std::filesystem::remove(mPath, ec);
+    }
+}
+
+bool GdsFile::isGdsAvailable()
+{
+#ifdef ENABLE_CUFILE
+    return CuFileDriver::getInstance().isOpen();
+#else
+    return false;
+#endif
+}
+
+void GdsFile::write(IBuffer::SharedConstPtr src, std::vector<Extent> const& extents, CudaStream const& stream)
+{
+    auto transfer = std::make_unique<Transfer>();
+    transfer->isWrite = true;
+    transfer->buffer = std::move(src);
+    transfer->extents = extents;
+    enqueue(std::move(transfer), stream);
+}
+
+void GdsFile::write(IBuffer::SharedConstPtr const& src, std::size_t fileOffset, CudaStream const& stream)
+{
+    write(src, {Extent{fileOffset, 0, src->getSizeInBytes()}}, stream);
+}
+
+void GdsFile::read(IBuffer::SharedPtr dst, std::vector<Extent> const& extents, CudaStream const& stream)
+{
+    auto transfer = std::make_unique<Transfer>();
+    transfer->isWrite = false;
+    transfer->buffer = std::move(dst);
+    transfer->extents = extents;
+    enqueue(std::move(transfer), stream);
+}
+
+void GdsFile::read(IBuffer::SharedPtr const& dst, std::size_t fileOffset, CudaStream const& stream)
+{
+    read(dst, {Extent{fileOffset, 0, dst->getSizeInBytes()}}, stream);
+}
+
+void GdsFile::synchronize()
+{
+    reclaim(true);
+}
+
+void GdsFile::enqueue(std::unique_ptr<Transfer> transfer, CudaStream const& stream)
+{
+    reclaim(false);
+
+    auto const bufferSize = transfer->buffer->getSizeInBytes();
+    for (auto const& extent : transfer->extents)
+    {
+        TLLM_CHECK_WITH_INFO(extent.fileOffset + extent.size <= mSize, "Extent [%zu, %zu) exceeds %s of %zu bytes",
+            extent.fileOffset, extent.fileOffset + extent.size, mPath.c_str(), mSize);
+        TLLM_CHECK_WITH_INFO(extent.bufferOffset + extent.size <= bufferSize,
+            "Extent [%zu, %zu) exceeds the buffer of %zu bytes", extent.bufferOffset, extent.bufferOffset + extent.size,
+            bufferSize);
+        transfer->numBytes += extent.size;
+    }
+    if (transfer->numBytes == 0)
+    {
+        return;
+    }
+
+    if (mUsesGds && transfer->buffer->getMemoryType() == MemoryType::kGPU)
+    {
+        enqueueGds(*transfer, stream);
+    }
+    else
+    {
+        enqueueHost(*transfer, stream);
+    }
+    stream.record(transfer->done);
+    mTransfers.push_back(std::move(transfer));
+}
+
+void GdsFile::enqueueGds(Transfer& transfer, CudaStream const& stream)
+{
+#ifdef ENABLE_CUFILE
+    auto const numExtents = transfer.extents.size();
+    transfer.gdsSizes.resize(numExtents);
+    transfer.gdsFileOffsets.resize(numExtents);
+    transfer.gdsBufferOffsets.resize(numExtents);
+    transfer.gdsBytes.resize(numExtents);
+    auto* const base = const_cast<void*>(transfer.buffer->data());
+    auto const handle = static_cast<CUfileHandle_t>(mCuFileHandle);
+    static_assert(sizeof(off_t) == sizeof(std::int64_t) && sizeof(ssize_t) == sizeof(std::int64_t));
+    for (std::size_t i = 0; i < numExtents; ++i)
+    {
+        transfer.gdsSizes[i] = transfer.extents[i].size;
+        transfer.gdsFileOffsets[i] = static_cast<std::int64_t>(transfer.extents[i].fileOffset);
+        transfer.gdsBufferOffsets[i] = static_cast<std::int64_t>(transfer.extents[i].bufferOffset);
+        auto* const fileOffset = reinterpret_cast<off_t*>(&transfer.gdsFileOffsets[i]);
+        auto* const bufferOffset = reinterpret_cast<off_t*>(&transfer.gdsBufferOffsets[i]);
+        auto* const bytes = reinterpret_cast<ssize_t*>(&transfer.gdsBytes[i]);
+        auto const status = transfer.isWrite
+            ? cuFileWriteAsync(handle, base, &transfer.gdsSizes[i], fileOffset, bufferOffset, bytes, stream.get())
+            : cuFileReadAsync(handle, base, &transfer.gdsSizes[i], fileOffset, bufferOffset, bytes, stream.get());
+        TLLM_CHECK_WITH_INFO(status.err == CU_FILE_SUCCESS, "cuFile%sAsync of %s failed with error %d",
+            transfer.isWrite ? "Write" : "Read", mPath.c_str(), static_cast<int>(status.err));
+    }
+#else
+    TLLM_THROW("Built without cuFile");
+#endif
+}
+
+void GdsFile::enqueueHost(Transfer& transfer, CudaStream const& stream)
+{
+    transfer.fd = mFd;
+    auto* const base = static_cast<std::uint8_t*>(const_cast<void*>(transfer.buffer->data()));
+    auto const onDevice = transfer.buffer->getMemoryType() == MemoryType::kGPU;
+    if (!onDevice)
+    {
+        transfer.hostData = base;
+        for (auto const& extent : transfer.extents)
+        {
+            transfer.hostOffsets.push_back(extent.bufferOffset);
+        }
+        TLLM_CUDA_CHECK(::cudaLaunchHostFunc(stream.get(), &GdsFile::hostTransfer, &transfer));
+        return;
+    }
+
+    // Extents are packed back to back in the staging buffer
+    transfer.staging = BufferManager::pinnedPool(transfer.numBytes);
+    transfer.hostData = static_cast<std::uint8_t*>(transfer.staging->data());
+    std::size_t stagingOffset{0};
+    for (auto const& extent : transfer.extents)
+    {
+        transfer.hostOffsets.push_back(stagingOffset);
+        stagingOffset += extent.size;
+    }
+
+    auto const copyExtents = [&](cudaMemcpyKind kind)
+    {
+        for (std::size_t i = 0; i < transfer.extents.size(); ++i)
+        {
+            auto* const device = base + transfer.extents[i].bufferOffset;
+            auto* const host = transfer.hostData + transfer.hostOffsets[i];
+            auto const toHost = kind == cudaMemcpyDeviceToHost;
+            TLLM_CUDA_CHECK(::cudaMemcpyAsync(
+                toHost ? host : device, toHost ? device : host, transfer.extents[i].size, kind, stream.get()));
+        }
+    };
+    if (transfer.isWrite)
+    {
+        copyExtents(cudaMemcpyDeviceToHost);
+        TLLM_CUDA_CHECK(::cudaLaunchHostFunc(stream.get(), &GdsFile::hostTransfer, &transfer));
+    }
+    else
+    {
+        TLLM_CUDA_CHECK(::cudaLaunchHostFunc(stream.get(), &GdsFile::hostTransfer, &transfer));
+        copyExtents(cudaMemcpyHostToDevice);
+    }
+}
+
+void GdsFile::hostTransfer(void* userData)
+{
+#if defined(__linux__)
+    auto& transfer = *static_cast<Transfer*>(userData);
+    for (std::size_t i = 0; i < transfer.extents.size(); ++i)
+    {
+        auto const& extent = transfer.extents[i];
+        auto* const data = transfer.hostData + transfer.hostOffsets[i];
+        std::size_t done{0};
+        while (done < extent.size)
+        {
+            auto const offset = static_cast<off_t>(extent.fileOffset + done);
+            auto const count = transfer.isWrite ? ::pwrite(transfer.fd, data + done, extent.size - done, offset)
+                                                : ::pread(transfer.fd, data + done, extent.size - done, offset);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                transfer.error = count < 0 ? errno : EIO;
+                return;
+            }
+            done += static_cast<std::size_t>(count);
+        }
+    }
+#endif
+}
+
+void GdsFile::reclaim(bool wait)
+{
+    for (auto it = mTransfers.begin(); it != mTransfers.end();)
+    {
+        auto& transfer = **it;
+        if (wait)
+        {
+            transfer.done.synchronize();
+        }
+        else
+        {
+            auto const status = ::cudaEventQuery(transfer.done.get());
+            if (status == cudaErrorNotReady)
+            {
+                ++it;
+                continue;
+            }
+            TLLM_CUDA_CHECK(status);
+        }
+
+        auto const isWrite = transfer.isWrite;
+        auto const numBytes = transfer.numBytes;
+        auto const error = transfer.error;
+        // cuFile reports a negative error code or a short transfer in the bytes of an extent
+        std::int64_t gdsResult{0};
+        for (std::size_t i = 0; i < transfer.gdsBytes.size() && gdsResult == 0; ++i)
+        {
+            if (transfer.gdsBytes[i] < 0 || static_cast<std::size_t>(transfer.gdsBytes[i]) != transfer.gdsSizes[i])
+            {
+                gdsResult = transfer.gdsBytes[i] < 0 ? transfer.gdsBytes[i] : -1;
+            }
+        }
+        it = mTransfers.erase(it);
+
+        TLLM_CHECK_WITH_INFO(error == 0, "Failed to %s %zu bytes %s %s: %s", isWrite ? "write" : "read", numBytes,
+            isWrite ? "to" : "from", mPath.c_str(), std::strerror(error));
+        TLLM_CHECK_WITH_INFO(gdsResult == 0, "cuFile failed to %s %zu bytes %s %s with %ld",
+            isWrite ? "write" : "read", numBytes, isWrite ? "to" : "from", mPath.c_str(), static_cast<long>(gdsResult));
+        if (isWrite)
+        {
+            mNumBytesWritten += numBytes;
+        }
+        else
+        {
+            mNumBytesRead += numBytes;
+        }
+    }
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/generationLogitsStreamer.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace tc = tensorrt_llm::common;
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+void convertLogits(IBuffer& output, IBuffer const& input, CudaStream const& stream)
+{
+    auto const* src = bufferCast<float>(input);
+    switch (output.getDataType())
+    {
+    case nvinfer1::DataType::kHALF:
+        tc::invokeCudaD2DcpyConvert(bufferCast<half>(output), src, input.getSize(), stream.get());
+        break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        tc::invokeCudaD2DcpyConvert(bufferCast<__nv_bfloat16>(output), src, input.getSize(), stream.get());
+        break;
+#endif // ENABLE_BF16
+    default: TLLM_THROW("Unsupported data type of the streamed generation logits");
+    }
+}
+} // namespace
+
+GenerationLogitsStreamer::GenerationLogitsStreamer(
+    nvinfer1::DataType logitsType, nvinfer1::DataType hostType, SizeType numMicroBatches)
+    : mLogitsType{logitsType}
+    , mHostType{hostType}
+    , mCopyStream{std::make_shared<CudaStream>()}
+    , mCopyManager{mCopyStream}
+    , mOutputs(numMicroBatches)
+    , mCopied(numMicroBatches)
+{
+    TLLM_CHECK_WITH_INFO(isSupported(logitsType, hostType),
+        "Generation logits of type %d cannot be streamed as type %d", static_cast<int>(logitsType),
+        static_cast<int>(hostType));
+}
+
+bool GenerationLogitsStreamer::isSupported(nvinfer1::DataType logitsType, nvinfer1::DataType hostType)
+{
+    if (logitsType == hostType)
+    {
+        return true;
+    }
+#ifdef ENABLE_BF16
+    if (hostType == nvinfer1::DataType::kBF16)
+    {
+        return logitsType == nvinfer1::DataType::kFLOAT;
+    }
+#endif // ENABLE_BF16
+    return logitsType == nvinfer1::DataType::kFLOAT && hostType == nvinfer1::DataType::kHALF;
+}
+
+void GenerationLogitsStreamer::setOutput(SizeType microBatchId, TensorPtr output)
+{
+    TLLM_CHECK_WITH_INFO(output->getMemoryType() == MemoryType::kPINNED,
+        "Streamed generation logits must be in pinned host memory");
+    TLLM_CHECK_WITH_INFO(output->getDataType() == mHostType, "Streamed generation logits must be of type %d",
+        static_cast<int>(mHostType));
+    TLLM_CHECK_WITH_INFO(output->getShape().nbDims == 4,
+        "Streamed generation logits must have shape [batchSize, beamWidth, maxNewTokens, vocabSizePadded]");
+    mOutputs.at(microBatchId) = std::move(output);
+}
+
+void GenerationLogitsStreamer::push(
+    SizeType microBatchId, SizeType step, ITensor const& logits, CudaStream const& stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const& output = mOutputs.at(microBatchId);
+    TLLM_CHECK_WITH_INFO(output, "No output for the generation logits of micro batch %d", microBatchId);
+    TLLM_CHECK(logits.getDataType() == mLogitsType);
+    auto const& outputShape = output->getShape();
+    auto const batchSize = static_cast<std::size_t>(outputShape.d[0]);
+    auto const beamWidth = static_cast<std::size_t>(outputShape.d[1]);
+    auto const maxNewTokens = static_cast<std::size_t>(outputShape.d[2]);
+    auto const vocabSizePadded = static_cast<std::size_t>(outputShape.d[3]);
+    TLLM_CHECK_WITH_INFO(0 <= step && static_cast<std::size_t>(step) < maxNewTokens,
+        "Step %d out of range of %zu generation logits", step, maxNewTokens);
+    auto const numRows = logits.getSize() / vocabSizePadded;
+    TLLM_CHECK_WITH_INFO(numRows == batchSize * beamWidth || numRows == batchSize,
+        "Invalid shape of generation logits %s", ITensor::toString(logits.getShape()).c_str());
+
+    stream.record(mComputed);
+    mCopyStream->wait(mComputed);
+
+    void const* src = logits.data();
+    if (mHostType != mLogitsType)
+    {
+        if (!mConverted || mConverted->getSize() < logits.getSize())
+        {
+            mConverted = mCopyManager.gpu(logits.getSize(), mHostType);
+        }
+        auto converted = IBuffer::slice(mConverted, 0, logits.getSize());
+        convertLogits(*converted, logits, *mCopyStream);
+        src = converted->data();
+    }
+
+    // Row (batch, beam) of the step goes to output[batch, beam, step, :]
+    auto const rowSize = vocabSizePadded * BufferDataType(mHostType).getSize();
+    auto const beamPitch = maxNewTokens * rowSize;
+    auto* dst = static_cast<std::uint8_t*>(output->data()) + static_cast<std::size_t>(step) * rowSize;
+    if (numRows == batchSize * beamWidth)
+    {
+        TLLM_CUDA_CHECK(cudaMemcpy2DAsync(
+            dst, beamPitch, src, rowSize, rowSize, numRows, cudaMemcpyDeviceToHost, mCopyStream->get()));
+    }
+    else
+    {
+        for (std::size_t beam = 0; beam < beamWidth; ++beam)
+        {
+            TLLM_CUDA_CHECK(cudaMemcpy2DAsync(dst + beam * beamPitch, beamWidth * beamPitch, src, rowSize, rowSize,
+                batchSize, cudaMemcpyDeviceToHost, mCopyStream->get()));
+        }
+    }
+    mCopyStream->record(mCopied.at(microBatchId)[step % kNumSlots]);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void GenerationLogitsStreamer::waitForSlot(SizeType microBatchId, SizeType step, CudaStream const& stream) const
+{
+    stream.wait(mCopied.at(microBatchId)[step % kNumSlots]);
+}
+
+void GenerationLogitsStreamer::join(CudaStream const& stream)
+{
+    mCopyStream->record(mJoined);
+    stream.wait(mJoined);
+}
+
+} // namespace tensorrt_llm::runtime
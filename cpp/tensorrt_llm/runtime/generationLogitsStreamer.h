@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Streams the generation logits of every step to pinned host memory on a separate copy stream.
+//!
+//! The engine writes the logits of step s into slot s % kNumSlots of a small device ring, see
+//! RuntimeBuffers::allGenerationLogits. After the step, push() makes the copy stream wait for it, converts the logits
+//! to the host data type if it differs, and copies them with one strided memcpy into the output of the micro batch.
+//! Before the engine writes a slot again, waitForSlot() makes the compute stream wait for the copy of that slot. The
+//! device memory for generation logits thus no longer scales with the output length, and the copies overlap with the
+//! next steps.
+class GenerationLogitsStreamer
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    static SizeType constexpr kNumSlots{2};
+
+    GenerationLogitsStreamer(nvinfer1::DataType logitsType, nvinfer1::DataType hostType, SizeType numMicroBatches);
+
+    //! \brief Whether logits of logitsType can be streamed as hostType, which is either the same type or a narrower
+    //! floating point type.
+    [[nodiscard]] static bool isSupported(nvinfer1::DataType logitsType, nvinfer1::DataType hostType);
+
+    [[nodiscard]] nvinfer1::DataType getHostType() const noexcept
+    {
+        return mHostType;
+    }
+
+    //! \brief Set the output of a micro batch, [batchSize, beamWidth, maxNewTokens, vocabSizePadded] in pinned memory
+    //! of the host type.
+    void setOutput(SizeType microBatchId, TensorPtr output);
+
+    //! \brief Copy the logits of a step, [batchSize, beamWidth or 1, vocabSizePadded] on gpu, to the output of the
+    //! micro batch once stream has computed them. Logits of a single beam, i.e. of the context, go to every beam.
+    void push(SizeType microBatchId, SizeType step, ITensor const& logits, CudaStream const& stream);
+
+    //! \brief Make stream wait until the logits of the previous step that used the slot of step have been copied.
+    void waitForSlot(SizeType microBatchId, SizeType step, CudaStream const& stream) const;
+
+    //! \brief Make stream wait for all the copies pushed so far.
+    void join(CudaStream const& stream);
+
+private:
+    nvinfer1::DataType mLogitsType;
+    nvinfer1::DataType mHostType;
+    std::shared_ptr<CudaStream> mCopyStream;
+    BufferManager mCopyManager;
+    // Logits converted to the host type, only used on the copy stream
+    IBuffer::SharedPtr mConverted;
+    CudaEvent mComputed;
+    CudaEvent mJoined;
+    std::vector<TensorPtr> mOutputs;
+    // Recorded on the copy stream after the copy of each slot of each micro batch
+    std::vector<std::array<CudaEvent, kNumSlots>> mCopied;
+};
+
+} // namespace tensorrt_llm::runtime
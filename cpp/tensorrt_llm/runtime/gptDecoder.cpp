@@ -66,6 +66,8 @@ void GptDecoder<T>::setup(SamplingConfig const& samplingConfig, size_t batchSize
     setupParams.frequency_penalty = samplingConfig.frequencyPenalty;
     setupParams.temperature = samplingConfig.temperature;
     setupParams.min_length = samplingConfig.minLength;
+    setupParams.logits_soft_cap = samplingConfig.logitsSoftCap;
+    setupParams.allowed_tokens = samplingConfig.allowedTokens;
     setupParams.normalize_log_probs = samplingConfig.normalizeLogProbs;
 
     // signed to unsigned
@@ -79,6 +81,8 @@ void GptDecoder<T>::setup(SamplingConfig const& samplingConfig, size_t batchSize
     setupParams.top_p_decay = samplingConfig.topPDecay;
     setupParams.top_p_min = samplingConfig.topPMin;
     setupParams.top_p_reset_ids = samplingConfig.topPResetIds;
+    setupParams.runtime_min_p = samplingConfig.minP;
+    setupParams.runtime_typical_p = samplingConfig.typicalP;
 
     setupParams.beam_search_diversity_rate = samplingConfig.beamSearchDiversityRate;
     setupParams.length_penalty = samplingConfig.lengthPenalty;
@@ -159,6 +163,23 @@ typename tl::DynamicDecodeLayer<T>::ForwardParams prepareInputs(DecodingInput co
         forwardParams.max_stop_words_len = input.maxStopWordsLen;
     }
 
+    if (input.stopWordsAutomata)
+    {
+        TLLM_CHECK_WITH_INFO(input.wordsAutomataStates, "Automata states must be provided with stopWordsAutomata");
+        forwardParams.stop_words_automata = tcc::toTllmTensor(*input.stopWordsAutomata);
+    }
+
+    if (input.badWordsAutomata)
+    {
+        TLLM_CHECK_WITH_INFO(input.wordsAutomataStates, "Automata states must be provided with badWordsAutomata");
+        forwardParams.bad_words_automata = tcc::toTllmTensor(*input.badWordsAutomata);
+    }
+
+    if (input.wordsAutomataStates)
+    {
+        forwardParams.words_automata_states = tcc::toTllmTensor(*input.wordsAutomataStates);
+    }
+
     if (input.finished)
     {
         forwardParams.finished = tcc::toTllmTensor(*input.finished);
@@ -169,6 +190,11 @@ typename tl::DynamicDecodeLayer<T>::ForwardParams prepareInputs(DecodingInput co
         forwardParams.batch_slots = tcc::toTllmTensor(*input.batchSlots);
     }
 
+    if (!input.logitsPostProcessors.empty())
+    {
+        forwardParams.logits_post_processors = input.logitsPostProcessors;
+    }
+
     return forwardParams;
 }
 
@@ -217,6 +243,13 @@ typename tl::DynamicDecodeLayer<T>::OutputParams prepareOutputs(
         outputParams.output_log_probs_tiled = tcc::toTllmTensor(*logProbsTiled);
     }
 
+    if (output.topNIds)
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(output.topNLogProbs), "topNLogProbs is required with topNIds");
+        outputParams.top_n_ids = tcc::toTllmTensor(*output.topNIds);
+        outputParams.top_n_log_probs = tcc::toTllmTensor(*output.topNLogProbs);
+    }
+
     outputParams.beamHypotheses = std::make_shared<tensorrt_llm::kernels::BeamHypotheses>();
     if (output.beamHypotheses.outputIdsTgt)
     {
@@ -447,7 +480,7 @@ void IGptDecoder::acceptDraftTokensByIds(ITensor const& targetTokenIds, ITensor
 void IGptDecoder::acceptDraftTokensByLogits(ITensor& draftLogits, ITensor const& targetLogits, ITensor& draftProbs,
     ITensor& targetProbs, ITensor const& numDraftTokens, ITensor& finished, ITensor const& batchSlots,
     SizeType vocabSize, SizeType vocabSizePadded, bool useRandomAcceptThreshold, float randomAcceptThreshold,
-    curandState_t* curandState, BufferManager::CudaStreamPtr const& stream)
+    tensorrt_llm::kernels::PhiloxState* curandState, BufferManager::CudaStreamPtr const& stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
@@ -16,9 +16,15 @@
 #include "tensorrt_llm/runtime/gptDecoderBatch.h"
 
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/timelineTracer.h"
+#include "tensorrt_llm/kernels/ahoCorasickKernels.h"
 #include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/topNLogProbsKernels.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/copyBatcher.h"
 #include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaGraphCache.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
 
 #include <algorithm>
@@ -32,6 +38,9 @@ namespace tk = tensorrt_llm::kernels;
 
 namespace
 {
+auto constexpr kSetupParamsWords = static_cast<SizeType>(sizeof(kernels::DecoderSetupParams) / sizeof(SizeType));
+static_assert(sizeof(kernels::DecoderSetupParams) == kSetupParamsWords * sizeof(SizeType));
+
 SamplingConfig extractSamplingConfig(SamplingConfig const& batchSamplingConfig, SizeType batchIdx)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
@@ -61,6 +70,8 @@ SamplingConfig extractSamplingConfig(SamplingConfig const& batchSamplingConfig,
     extractOptional(samplingConfig.topPDecay, batchSamplingConfig.topPDecay);
     extractOptional(samplingConfig.topPMin, batchSamplingConfig.topPMin);
     extractOptional(samplingConfig.topPResetIds, batchSamplingConfig.topPResetIds);
+    extractOptional(samplingConfig.minP, batchSamplingConfig.minP);
+    extractOptional(samplingConfig.typicalP, batchSamplingConfig.typicalP);
 
     // beam search layer
     samplingConfig.beamSearchDiversityRate = batchSamplingConfig.beamSearchDiversityRate;
@@ -80,6 +91,7 @@ GptDecoderBatch::GptDecoderBatch(
     , mVocabSizePadded{vocabSizePadded}
     , mStream{std::move(stream)}
     , mBufferManager{mStream}
+    , mFinalizeStream{std::make_shared<CudaStream>()}
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     auto constexpr nvTokenIdType = TRTDataType<TokenIdType>::value;
@@ -105,6 +117,8 @@ GptDecoderBatch::GptDecoderBatch(
     mDraftProbs = mBufferManager.emptyTensor(MemoryType::kGPU, nvFloatType);
     mTargetProbs = mBufferManager.emptyTensor(MemoryType::kGPU, nvFloatType);
     mBatchSlotsSetup = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
+    mSetupParams = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
+    mSetupParamsDevice = mBufferManager.emptyTensor(MemoryType::kGPU, TRTDataType<SizeType>::value);
     mBatchSlotsDecoder = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
     mBatchSlotsAcceptTokens = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
     mBatchSlotsAcceptLogits = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
@@ -121,11 +135,15 @@ GptDecoderBatch::GptDecoderBatch(
     mDraftTokenIds = mBufferManager.emptyTensor(MemoryType::kGPU, nvinfer1::DataType::kINT32);
     mDraftLogits = mBufferManager.emptyTensor(MemoryType::kGPU, nvFloatType);
     mTargetLogitsPtrs = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<float*>::value);
+    mFinalOutputIds = mBufferManager.emptyTensor(MemoryType::kGPU, nvTokenIdType);
 
     dInput->stopWordsPtrs = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<int32_t*>::value);
     dInput->stopWordsLens = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
     dInput->badWordsPtrs = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<int32_t*>::value);
     dInput->badWordsLens = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<SizeType>::value);
+    mStopWordsAutomata = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<int32_t*>::value);
+    mBadWordsAutomata = mBufferManager.emptyTensor(MemoryType::kPINNED, TRTDataType<int32_t*>::value);
+    mWordsAutomataStates = mBufferManager.emptyTensor(MemoryType::kGPU, nvSizeType);
     dInput->embeddingBias = mBufferManager.emptyTensor(MemoryType::kGPU, nvFloatType);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -176,6 +194,9 @@ void GptDecoderBatch::setup(DecodingMode const& mode, SizeType maxBatchSize, Siz
     mFinishedSteps->reshape(maxTokensPerStepXmaxBatchSizeXmaxBeamWidth);
     mBufferManager.setZero(*mFinishedSteps);
 
+    mSetupParams->reshape(ITensor::makeShape({maxBatchSize, kSetupParamsWords}));
+    mSetupParamsDevice->reshape(ITensor::makeShape({maxBatchSize, kSetupParamsWords}));
+
     if (mFusedDecoder)
     {
         mBatchSlotsSetup->reshape(ITensor::makeShape({maxBatchSize}));
@@ -206,10 +227,12 @@ void GptDecoderBatch::setup(DecodingMode const& mode, SizeType maxBatchSize, Siz
     if (maxBeamWidth > 1)
     {
         dOutput.beamHypotheses.reshape(maxBatchSize, maxBeamWidth, mMaxSequenceLength);
+        mFinalOutputIds->reshape(ITensor::makeShape({1, maxBeamWidth, mMaxSequenceLength}));
     }
     else
     {
         dOutput.beamHypotheses.release();
+        mFinalOutputIds->release();
     }
 
     // speculative decoding only works for beam width == 1
@@ -218,7 +241,7 @@ void GptDecoderBatch::setup(DecodingMode const& mode, SizeType maxBatchSize, Siz
         ITensor::makeShape({maxBatchSize, maxTokensPerStep, static_cast<SizeType>(mVocabSizePadded)}));
     mAcceptByLogits.resize(maxBatchSize);
     mNumDraftTokens->reshape(ITensor::makeShape({maxBatchSize, 1}));
-    mCurandStates->reshape(ITensor::makeShape({maxBatchSize, sizeof(curandState_t)}));
+    mCurandStates->reshape(ITensor::makeShape({maxBatchSize, sizeof(tk::PhiloxState)}));
     mTargetLogitsPtrs->reshape(ITensor::makeShape({maxTokensPerStep, maxBatchSize}));
 
     const_cast<ITensor&>(*dInput.embeddingBias)
@@ -227,9 +250,17 @@ void GptDecoderBatch::setup(DecodingMode const& mode, SizeType maxBatchSize, Siz
     const_cast<ITensor&>(*dInput.badWordsLens).reshape(ITensor::makeShape({maxBatchSize}));
     const_cast<ITensor&>(*dInput.stopWordsPtrs).reshape(ITensor::makeShape({maxBatchSize}));
     const_cast<ITensor&>(*dInput.stopWordsLens).reshape(ITensor::makeShape({maxBatchSize}));
+    dInput.logitsPostProcessors.assign(maxBatchSize, nullptr);
+    mStopWordsAutomata->reshape(ITensor::makeShape({maxBatchSize}));
+    mBufferManager.setZero(*mStopWordsAutomata);
+    mBadWordsAutomata->reshape(ITensor::makeShape({maxBatchSize}));
+    mBufferManager.setZero(*mBadWordsAutomata);
+    mWordsAutomataStates->reshape(ITensor::makeShape({maxBatchSize, tk::kNumWordsAutomata}));
+    mBufferManager.setZero(*mWordsAutomataStates);
 
     auto const numOfDecoders = fusedDecoder ? 1 : maxBatchSize;
     mStreams.resize(maxBatchSize);
+    mFinalizeEvents = std::vector<CudaEvent>(maxBatchSize);
     mDecoders.resize(numOfDecoders);
     mDecodingInputs.resize(maxBatchSize);
     mDecodingOutputs.resize(maxBatchSize);
@@ -256,11 +287,68 @@ void GptDecoderBatch::setup(DecodingMode const& mode, SizeType maxBatchSize, Siz
         mBeamWidths[i] = 0;
         mGeneratedTokensPerStep[i] = 0;
     }
+    mSetupCopies = fusedDecoder ? std::make_shared<CopyBatcher>(mStreams[0]) : nullptr;
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
-void GptDecoderBatch::newRequest(
-    SizeType batchIdx, decoder_batch::Request const& request, SamplingConfig const& samplingConfig)
+void GptDecoderBatch::enableTopNLogProbs(SizeType topN)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(0 < topN && topN <= tk::kMaxTopNLogProbs, "topN (%d) must be in range [1, %d]", topN,
+        tk::kMaxTopNLogProbs);
+    auto& dOutput = *mJointDecodingOutput;
+    auto const& jointOutputIdsShape = dOutput.ids->getShape();
+    TLLM_CHECK_WITH_INFO(jointOutputIdsShape.nbDims == 3, "Decoder must be set up before enabling top-N log probs");
+    auto const topNShape = ITensor::makeShape(
+        {jointOutputIdsShape.d[0], jointOutputIdsShape.d[1], jointOutputIdsShape.d[2], topN});
+    dOutput.topNIds = mBufferManager.gpu(topNShape, TRTDataType<TokenIdType>::value);
+    dOutput.topNLogProbs = mBufferManager.gpu(topNShape, TRTDataType<float>::value);
+    mBufferManager.setZero(*dOutput.topNIds);
+    mBufferManager.setZero(*dOutput.topNLogProbs);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void GptDecoderBatch::enableCudaGraphs(SizeType maxNumGraphs)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(mJointDecodingOutput->ids->getShape().nbDims == 3,
+        "Decoder must be set up before enabling CUDA graphs");
+    if (!mFusedDecoder || mMaxTokensPerStep > 1)
+    {
+        TLLM_LOG_WARNING("CUDA graphs are only supported by the fused decoder without speculative decoding");
+        return;
+    }
+#ifndef NDEBUG
+    bool constexpr syncsAfterKernels{true};
+#else
+    bool const syncsAfterKernels{tc::isCudaLaunchBlocking()};
+#endif
+    if (syncsAfterKernels)
+    {
+        // sync_check_cuda_error synchronizes the device, which is not allowed while capturing
+        TLLM_LOG_WARNING("CUDA graphs of the decoder are disabled in debug and launch blocking mode");
+        return;
+    }
+    mDecoderGraphs = std::make_shared<CudaGraphCache>(maxNumGraphs);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void GptDecoderBatch::enableTokenStreaming(SizeType capacity)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const& jointOutputIdsShape = mJointDecodingOutput->ids->getShape();
+    TLLM_CHECK_WITH_INFO(jointOutputIdsShape.nbDims == 3, "Decoder must be set up before enabling token streaming");
+    auto const maxBatchSizeShape = ITensor::makeShape({jointOutputIdsShape.d[0]});
+    mTokenStream = std::make_shared<TokenStreamRing>(capacity);
+    mStreamedLengths = mBufferManager.gpu(maxBatchSizeShape, TRTDataType<SizeType>::value);
+    mBufferManager.setZero(*mStreamedLengths);
+    mTokenStreamSlots = BufferManager::pinned(maxBatchSizeShape, TRTDataType<SizeType>::value);
+    mTokenStreamOffsets = BufferManager::pinned(maxBatchSizeShape, TRTDataType<SizeType>::value);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void GptDecoderBatch::newRequest(SizeType batchIdx, decoder_batch::Request const& request,
+    SamplingConfig const& samplingConfig, SizeType setupIdx)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     TLLM_CHECK(batchIdx >= 0);
@@ -285,14 +373,31 @@ void GptDecoderBatch::newRequest(
 
     auto const decoderIdx = mFusedDecoder ? 0 : batchIdx;
     auto& stream = mStreams[decoderIdx];
+    // The finalize of the previous request in the slot may still read its buffers
+    stream->wait(mFinalizeEvents[batchIdx]);
     BufferManager manager{stream};
+    // The fused decoder flushes the copies of all the new requests at once in scatterNewRequests
+    auto const copyToSlot = [this, &manager](IBuffer const& src, IBuffer& dst)
+    {
+        if (mSetupCopies)
+        {
+            mSetupCopies->copy(src, dst);
+        }
+        else
+        {
+            manager.copy(src, dst);
+        }
+    };
 
     // input
     auto& dJointInput = *mJointDecodingInput;
     auto& dInput = mDecodingInputs.at(batchIdx);
 
+    // endIds, lengths, sequenceLimitLength and the decoding state of the slot are written by scatterNewRequests
+    reinterpret_cast<kernels::DecoderSetupParams*>(bufferCast<SizeType>(*mSetupParams))[setupIdx]
+        = {batchIdx, endId, inputLength, inputLength + maxNewTokens};
+
     TensorPtr endIdTensorPtr{ITensor::slice(constPointerCast(dJointInput.endIds), batchIdx, localBatchSize)};
-    kernels::invokeFill(*endIdTensorPtr, endId, *stream);
     dInput = std::make_unique<DecodingInput>(
         inputLength, mMaxAttentionWindow, mSinkTokenLength, localBatchSize, dJointInput.logits, endIdTensorPtr);
 
@@ -306,7 +411,7 @@ void GptDecoderBatch::newRequest(
             "The embedding bias shape is not as expected. Expected last dimension to be same as vocab size: %lu.",
             mVocabSize);
 
-        manager.copy(*request.embeddingBias, *embeddingBiasSlice);
+        copyToSlot(*request.embeddingBias, *embeddingBiasSlice);
         dInput->embeddingBias = embeddingBiasSlice;
     }
     else
@@ -353,12 +458,52 @@ void GptDecoderBatch::newRequest(
         dInput->badWordsPtrs, dInput->badWordsLens, dInput->maxBadWordsLen, mMaxBadWordsLen, localBatchSize, batchIdx);
     dJointInput.maxBadWordsLen = mMaxBadWordsLen;
 
+    auto setupAutomaton = [this, &dJointInput, &dInput, localBatchSize, batchIdx](
+                              TensorPtr const& requestAutomaton, TensorPtr const& jointAutomata,
+                              SharedConstPtr& inputJointAutomata, SharedConstPtr& inputAutomata,
+                              SharedConstPtr& inputAutomaton)
+    {
+        auto& automatonPtr = BufferRange<int32_t*>(*jointAutomata)[batchIdx];
+        if (requestAutomaton)
+        {
+            TLLM_CHECK(requestAutomaton->getDataType() == nvinfer1::DataType::kINT32);
+            automatonPtr = bufferCast<int32_t>(*requestAutomaton);
+            // Enabled once the first request with an automaton arrives, other requests hold nullptr
+            inputJointAutomata = jointAutomata;
+            dJointInput.wordsAutomataStates = mWordsAutomataStates;
+            if (!mFusedDecoder)
+            {
+                inputAutomata = ITensor::slice(jointAutomata, batchIdx, localBatchSize);
+                dInput->wordsAutomataStates = ITensor::slice(mWordsAutomataStates, batchIdx, localBatchSize);
+            }
+            // Keeps the automaton allocated while the request is decoded
+            inputAutomaton = requestAutomaton;
+        }
+        else
+        {
+            automatonPtr = nullptr;
+        }
+    };
+
+    TLLM_CHECK_WITH_INFO(!(request.stopWordsAutomaton || request.badWordsAutomaton) || beamWidth == 1,
+        "Stop and bad words automata are only supported with beam width 1");
+    setupAutomaton(request.stopWordsAutomaton, mStopWordsAutomata, dJointInput.stopWordsAutomata,
+        dInput->stopWordsAutomata, dInput->stopWordsAutomaton);
+    setupAutomaton(request.badWordsAutomaton, mBadWordsAutomata, dJointInput.badWordsAutomata,
+        dInput->badWordsAutomata, dInput->badWordsAutomaton);
+    // Decoding starts at the root of the automata, words spanning the prompt are not matched, the states are reset
+    // by scatterNewRequests
+
+    dJointInput.logitsPostProcessors.at(batchIdx) = request.logitsPostProcessor;
+    if (request.logitsPostProcessor)
+    {
+        dInput->logitsPostProcessors = {request.logitsPostProcessor};
+    }
+
     TensorPtr sequenceLimitLength{
         ITensor::slice(constPointerCast(dJointInput.sequenceLimitLength), batchIdx, localBatchSize)};
-    kernels::invokeFill(*sequenceLimitLength, inputLength + maxNewTokens, *stream);
     dInput->sequenceLimitLength = std::move(sequenceLimitLength);
     TensorPtr inputLengths{ITensor::slice(constPointerCast(dJointInput.lengths), batchIdx, localBatchSize)};
-    kernels::invokeFill(*inputLengths, inputLength, *stream);
     dInput->lengths = inputLengths;
 
     // output
@@ -379,16 +524,6 @@ void GptDecoderBatch::newRequest(
         TensorPtr newTokensStepView = ITensor::slice(dJointOutput.newTokensSteps, ti, localBatchSize);
         newTokensStepView->squeeze(0);
         dOutput->newTokensVec[ti] = ITensor::slice(newTokensStepView, batchIdx, localBatchSize);
-        manager.setZero(*dOutput->newTokensVec[ti]);
-    }
-
-    // FIXME(nkorobov): we call setZero mMaxTokensPerStep times for only 1 element
-    for (SizeType ti = 0; ti < mMaxTokensPerStep; ++ti)
-    {
-        TensorPtr finishedStepsView = std::move(ITensor::slice(mFinishedSteps, ti, 1));
-        finishedStepsView->squeeze(0);
-        TensorPtr finishedSteps = std::move(ITensor::slice(finishedStepsView, batchIdx, localBatchSize));
-        manager.setZero(*finishedSteps);
     }
 
     // cumLogProb is mandatory for beamWidth > 1
@@ -406,6 +541,12 @@ void GptDecoderBatch::newRequest(
         manager.setZero(*dOutput->logProbs);
     }
 
+    if (dJointOutput.topNIds)
+    {
+        dOutput->topNIds = ITensor::slice(dJointOutput.topNIds, batchIdx, localBatchSize);
+        dOutput->topNLogProbs = ITensor::slice(dJointOutput.topNLogProbs, batchIdx, localBatchSize);
+    }
+
     if (beamWidth > 1)
     {
         kernels::invokeFill(
@@ -426,7 +567,7 @@ void GptDecoderBatch::newRequest(
         draftTokensReqBatchSlice->squeeze(0);
         TensorPtr draftTokensReqTokensSlice = ITensor::slice(draftTokensReqBatchSlice, 0, numDraftTokens);
         TensorPtr draftTokensView = ITensor::view(request.draftTokens, ITensor::makeShape({numDraftTokens}));
-        manager.copy(*draftTokensView, *draftTokensReqTokensSlice);
+        copyToSlot(*draftTokensView, *draftTokensReqTokensSlice);
         mAcceptByLogits[batchIdx] = false;
         if (request.draftLogits.has_value())
         {
@@ -436,14 +577,14 @@ void GptDecoderBatch::newRequest(
             TensorPtr draftLogitsReqBatchSlice = std::move(ITensor::slice(mDraftLogits, batchIdx, 1));
             draftLogitsReqBatchSlice->squeeze(0);
             TensorPtr draftLogitsReqTokensSlice = ITensor::slice(draftLogitsReqBatchSlice, 0, numDraftTokens);
-            manager.copy(*draftLogitsView, *draftLogitsReqTokensSlice);
+            copyToSlot(*draftLogitsView, *draftLogitsReqTokensSlice);
         }
 
         auto numDraftTokensView = ITensor::slice(mNumDraftTokens, batchIdx, localBatchSize);
         kernels::invokeFill(*numDraftTokensView, numDraftTokens, *stream);
 
         auto const curandStatesView = ITensor::slice(mCurandStates, batchIdx, localBatchSize);
-        auto curandState = reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*curandStatesView));
+        auto curandState = reinterpret_cast<tk::PhiloxState*>(bufferCast<int8_t>(*curandStatesView));
         if (samplingConfig.randomSeed.has_value())
         {
             tk::invokeCurandInitialize(
@@ -483,16 +624,31 @@ void GptDecoderBatch::newRequests(std::vector<SizeType> const& seqSlots,
 
     auto batchSlotsPtr = bufferCast<SizeType>(*mBatchSlotsSetup);
     SizeType const localBatchSize = seqSlots.size();
+    if (mFusedDecoder)
+    {
+        // The staged values of the previous call must have been copied before they are overwritten
+        mSetupParamsEvent.synchronize();
+    }
     for (SizeType bi = 0; bi < localBatchSize; ++bi)
     {
-        newRequest(seqSlots[bi], requests[bi], samplingConfigs[bi]);
+        auto const batchSlot = seqSlots[bi];
         if (mFusedDecoder)
         {
-            batchSlotsPtr[bi] = seqSlots[bi];
+            newRequest(batchSlot, requests[bi], samplingConfigs[bi], bi);
+            batchSlotsPtr[bi] = batchSlot;
+        }
+        else
+        {
+            // Every slot has its own stream and staging row, which is reused only by the next request of the slot
+            newRequest(batchSlot, requests[bi], samplingConfigs[bi], batchSlot);
+            scatterNewRequests(batchSlot, 1, mStreams[batchSlot]);
         }
     }
     if (mFusedDecoder)
     {
+        // One copy and one kernel for all the new requests
+        scatterNewRequests(0, localBatchSize, mStreams[0]);
+        mStreams[0]->record(mSetupParamsEvent);
         TensorPtr batchSlotsView = std::move(ITensor::slice(mBatchSlotsSetup, 0, localBatchSize));
         auto fusedSamplingConfig = SamplingConfig(samplingConfigs);
         mDecoders[0]->setup(fusedSamplingConfig, localBatchSize, mMaxSequenceLength, {batchSlotsView});
@@ -501,10 +657,36 @@ void GptDecoderBatch::newRequests(std::vector<SizeType> const& seqSlots,
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+void GptDecoderBatch::scatterNewRequests(SizeType setupIdx, SizeType numRequests, CudaStreamPtr const& stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (mSetupCopies)
+    {
+        mSetupCopies->flush();
+    }
+    if (numRequests == 0)
+    {
+        return;
+    }
+    BufferManager manager{stream};
+    auto const setupParams = ITensor::slice(mSetupParams, setupIdx, numRequests);
+    auto setupParamsDevice = ITensor::slice(mSetupParamsDevice, setupIdx, numRequests);
+    manager.copy(*setupParams, *setupParamsDevice);
+
+    auto& dJointInput = *mJointDecodingInput;
+    // The prompt is not streamed
+    auto* streamedLengths = mTokenStream ? mStreamedLengths.get() : nullptr;
+    kernels::invokeScatterDecoderSetup(*setupParamsDevice, numRequests, *constPointerCast(dJointInput.endIds),
+        *constPointerCast(dJointInput.lengths), *constPointerCast(dJointInput.sequenceLimitLength),
+        *mJointDecodingOutput->newTokensSteps, *mFinishedSteps, *mWordsAutomataStates, streamedLengths, *stream);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
 GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
     decoder_batch::Output& output, decoder_batch::Input const& input)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_TIMELINE_SCOPE(kDecoderStep, forwardAsync);
     auto& allTargetLogits = input.logits;
 
     // TODO(nkorobov): check logits shape considering draft tokens
@@ -534,6 +716,29 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
     auto const maxGeneratedTokensPerStep
         = *std::max_element(std::begin(mGeneratedTokensPerStep), std::end(mGeneratedTokensPerStep));
 
+    // Requests decoded in this step, collected before mFinished is updated
+    SizeType numStreamedSlots{0};
+    if (mTokenStream)
+    {
+        auto const& finishedStepsShape = mFinishedSteps->getShape();
+        auto const finishedStepStride = static_cast<SizeType>(finishedStepsShape.d[1] * finishedStepsShape.d[2]);
+        auto slotsPtr = bufferCast<SizeType>(*mTokenStreamSlots);
+        auto offsetsPtr = bufferCast<SizeType>(*mTokenStreamOffsets);
+        for (SizeType bi = 0; bi < mActualBatchSize; ++bi)
+        {
+            if (mFinished[bi] || !input.active.at(bi))
+            {
+                continue;
+            }
+            // Step of mFinishedSteps to which the last decoding step of the request writes
+            auto const finalStep = mFusedDecoder ? std::min(mGeneratedTokensPerStep[bi], maxGeneratedTokensPerStep - 1)
+                                                 : mGeneratedTokensPerStep[bi] - 1;
+            slotsPtr[numStreamedSlots] = bi;
+            offsetsPtr[numStreamedSlots] = finalStep * finishedStepStride + bi * maxBeamWidth;
+            ++numStreamedSlots;
+        }
+    }
+
     for (SizeType si = 0; si < maxGeneratedTokensPerStep; ++si)
     {
         SizeType localBatchDecoderIdx = 0;
@@ -671,7 +876,7 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
                     /* [max_tokens_per_step, max_bs] */ *mFinishedSteps,
                     /* [bs] */ *batchSlotsAcceptLogitsSlice, static_cast<SizeType>(mVocabSize),
                     static_cast<SizeType>(mVocabSizePadded), useRandomAcceptanceThreshold, randomAcceptanceThreshold,
-                    reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*mCurandStates)), stream);
+                    reinterpret_cast<tk::PhiloxState*>(bufferCast<int8_t>(*mCurandStates)), stream);
             }
 
             TensorPtr finishedStepsInput = ITensor::slice(mFinishedSteps, si, 1);
@@ -695,7 +900,22 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
 
             if (localBatchDecoderIdx > 0)
             {
-                decoder.forwardAsync(dOutput, dInput);
+                // Logits post processors are user callbacks, which may synchronize the stream
+                auto const useCudaGraph = mDecoderGraphs
+                    && std::none_of(batchSlotsDecoderPtr + si * mActualBatchSize,
+                        batchSlotsDecoderPtr + si * mActualBatchSize + localBatchDecoderIdx,
+                        [&dInput](SizeType slot) { return static_cast<bool>(dInput.logitsPostProcessors.at(slot)); });
+                if (useCudaGraph)
+                {
+                    CudaGraphCache::Key const key{CudaGraphCache::getBatchSizeBucket(localBatchDecoderIdx),
+                        maxBeamWidth, static_cast<SizeType>(srcCacheIndirection != nullptr)};
+                    mDecoderGraphs->launch(
+                        key, *stream, [&decoder, &dOutput, &dInput]() { decoder.forwardAsync(dOutput, dInput); });
+                }
+                else
+                {
+                    decoder.forwardAsync(dOutput, dInput);
+                }
             }
 
             for (SizeType bi = 0; bi < mActualBatchSize; ++bi)
@@ -737,6 +957,13 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
         }
     }
 
+    if (mTokenStream)
+    {
+        auto const& dJointOutput = *mJointDecodingOutput;
+        kernels::invokeWriteTokenStream(*mTokenStream, *mStreamedLengths, *dJointOutput.ids, *dJointOutput.logProbs,
+            *mFinishedSteps, *sequenceLengths, *mTokenStreamSlots, *mTokenStreamOffsets, numStreamedSlots, *mStream);
+    }
+
     CudaEvent eventStop{};
     mStream->record(eventStop);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -746,6 +973,7 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
 void GptDecoderBatch::forwardSync(decoder_batch::Token const& token)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_TIMELINE_SCOPE(kDecoderStep, forwardSync);
     token.event.synchronize();
 
     for (std::int32_t i = 0; i < mActualBatchSize; ++i)
@@ -761,26 +989,32 @@ void GptDecoderBatch::forwardSync(decoder_batch::Token const& token)
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
-// TODO call this at the end of forward if mFinished[i] changes from false to true?
 CudaEvent GptDecoderBatch::postProcessRequest(SizeType batchIdx) const
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
-    auto& stream = mStreams[batchIdx];
-    auto manager = BufferManager{stream};
-    auto& decoder = *mDecoders[batchIdx];
+    // All decoding steps of the request have been joined into mStream by forwardAsync
+    CudaEvent decoded{};
+    mStream->record(decoded);
+    mFinalizeStream->wait(decoded);
 
-    auto& dInput = *mDecodingInputs[batchIdx];
-    auto& dOutput = *mDecodingOutputs[batchIdx];
-
-    // TODO can we do this inplace?
-    auto& outputIds = dOutput.ids;
-    auto finalOutputIds = manager.gpu(outputIds->getShape(), outputIds->getDataType());
-    decoder.gatherTree(*finalOutputIds, dOutput, dInput, manager);
-    manager.copy(*finalOutputIds, *outputIds);
+    // Requests with beam width 1 can share a decoder configured for beam search, their output ids are final
+    if (mBeamWidths[batchIdx] > 1)
+    {
+        auto manager = BufferManager{mFinalizeStream};
+        auto& decoder = *mDecoders[mFusedDecoder ? 0 : batchIdx];
+        auto& dInput = *mDecodingInputs[batchIdx];
+        auto& dOutput = *mDecodingOutputs[batchIdx];
+
+        // The finalizes are serialized on mFinalizeStream, so they share the output of gatherTree
+        auto& outputIds = dOutput.ids;
+        mFinalOutputIds->reshape(outputIds->getShape());
+        decoder.gatherTree(*mFinalOutputIds, dOutput, dInput, manager);
+        manager.copy(*mFinalOutputIds, *outputIds);
+    }
 
+    mFinalizeStream->record(mFinalizeEvents[batchIdx]);
     CudaEvent event{};
-    stream->record(event);
-    mStream->wait(event);
+    mFinalizeStream->record(event);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
     return event;
 }
@@ -809,6 +1043,8 @@ void GptDecoderBatch::newBatch(
     auto inputLengthsHost = mBufferManager.copyFrom(*inputLengths, MemoryType::kCPU);
     auto inputLengthsPtr = bufferCast<SizeType>(*inputLengthsHost);
     auto inputOffset = 0;
+    // The staged values of the previous batch must have been copied before they are overwritten
+    mSetupParamsEvent.synchronize();
     for (auto batchIdx = 0; batchIdx < mActualBatchSize; ++batchIdx)
     {
         mGeneratedTokensPerStep[batchIdx] = 1;
@@ -855,7 +1091,16 @@ void GptDecoderBatch::newBatch(
             stopWordsListView->squeeze(0);
             request.stopWordsList = stopWordsListView;
         }
-        newRequest(batchIdx, request, extractSamplingConfig(samplingConfig, batchIdx));
+        newRequest(batchIdx, request, extractSamplingConfig(samplingConfig, batchIdx), batchIdx);
+        if (!mFusedDecoder)
+        {
+            scatterNewRequests(batchIdx, 1, mStreams[batchIdx]);
+        }
+    }
+    if (mFusedDecoder)
+    {
+        scatterNewRequests(0, mActualBatchSize, mStreams[0]);
+        mStreams[0]->record(mSetupParamsEvent);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -907,6 +1152,10 @@ void GptDecoderBatch::finalize() const
     {
         auto event = postProcessRequest(batchIdx);
     }
+    // The results of the whole batch are read on mStream
+    CudaEvent event{};
+    mFinalizeStream->record(event);
+    mStream->wait(event);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -119,6 +119,7 @@ void parseBuilderConfig(GptModelConfig& modelConfig, Json const& builderConfig)
         = parseJsonFieldOr<SizeType>(builderConfig, "max_prompt_embedding_table_size", 0);
     auto const computeContextLogits = parseJsonFieldOr(builderConfig, "gather_context_logits", false);
     auto const computeGenerationLogits = parseJsonFieldOr(builderConfig, "gather_generation_logits", false);
+    auto const computeHiddenStates = parseJsonFieldOr(builderConfig, "gather_hidden_states", false);
 
     modelConfig.setMaxBatchSize(maxBatchSize);
     modelConfig.setMaxBeamWidth(maxBeamWidth);
@@ -129,6 +130,7 @@ void parseBuilderConfig(GptModelConfig& modelConfig, Json const& builderConfig)
     modelConfig.setMaxPromptEmbeddingTableSize(maxPromptEmbeddingTableSize);
     modelConfig.computeContextLogits(computeContextLogits);
     modelConfig.computeGenerationLogits(computeGenerationLogits);
+    modelConfig.computeHiddenStates(computeHiddenStates);
 }
 
 void parsePluginConfig(GptModelConfig& modelConfig, Json const& pluginConfig)
@@ -140,6 +142,8 @@ void parsePluginConfig(GptModelConfig& modelConfig, Json const& pluginConfig)
     auto const useCustomAllReduce = pluginConfig.at("use_custom_all_reduce").template get<bool>();
     auto const useContextFMHAForGeneration = pluginConfig.at("use_context_fmha_for_generation").template get<bool>();
     auto const pagedContextFMHA = pluginConfig.at("use_paged_context_fmha").template get<bool>();
+    auto const kvCacheEvictionRecentWindow
+        = parseJsonFieldOr(pluginConfig, "kv_cache_eviction_recent_window", SizeType{0});
 
     modelConfig.useGptAttentionPlugin(useGptAttentionPlugin);
     modelConfig.usePackedInput(removeInputPadding);
@@ -148,6 +152,7 @@ void parsePluginConfig(GptModelConfig& modelConfig, Json const& pluginConfig)
     modelConfig.useCustomAllReduce(useCustomAllReduce);
     modelConfig.setUseContextFMHAForGeneration(useContextFMHAForGeneration);
     modelConfig.setPagedContextFMHA(pagedContextFMHA);
+    modelConfig.setKvCacheEvictionRecentWindow(kvCacheEvictionRecentWindow);
 }
 
 void parseLora(GptModelConfig& modelConfig, Json const& json, Json const& pluginConfig, bool engineVersionNone,
@@ -19,19 +19,26 @@
 
 #include "tensorrt_llm/runtime/gptSession.h"
 
+#include "asyncTokenCallback.h"
 #include "common.h"
 #include "iBuffer.h"
 #include "tensorrt_llm/batch_manager/kvCacheManager.h"
 #include "tensorrt_llm/common/customAllReduceUtils.h"
 #include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/runtime/generationLogitsStreamer.h"
 #include "tensorrt_llm/runtime/gptDecoderBatch.h"
 #include "tensorrt_llm/runtime/ipcUtils.h"
+#include "tensorrt_llm/runtime/ncclCommRegistry.h"
 #include "tensorrt_llm/runtime/ncclCommunicator.h"
+#include "tensorrt_llm/runtime/optimizationProfileSelector.h"
 #include "tensorrt_llm/runtime/runtimeBuffers.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
+#include "tensorrt_llm/runtime/startupReport.h"
 #include "tensorrt_llm/runtime/statefulGptDecoder.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 #include "tensorrt_llm/runtime/tllmRuntime.h"
+#include "tensorrt_llm/runtime/utils/mappedFile.h"
 #include "tensorrt_llm/runtime/utils/sessionUtils.h"
 
 #include <algorithm>
@@ -71,6 +78,51 @@ std::unordered_set<std::int32_t> populateMicrobatchIndexes()
 
 auto const kProfileMbIdxs = populateMicrobatchIndexes();
 
+//! @brief Splits the NCCL groups of the world before the engine is deserialized, so that its plugins reuse them.
+std::shared_ptr<TllmRuntime> createRuntime(
+    WorldConfig const& worldConfig, void const* engineBuffer, std::size_t engineSize, nvinfer1::ILogger& logger)
+{
+    if (worldConfig.getSize() > 1)
+    {
+        NcclCommRegistry::getInstance().splitWorld(worldConfig);
+    }
+    return std::make_shared<TllmRuntime>(engineBuffer, engineSize, logger);
+}
+
+//! @brief Records a phase of the generation timeline for the lifetime of the scope, if profiling is enabled.
+class PhaseScope
+{
+public:
+    using GenerationProfiler = GptSession::GenerationProfiler;
+
+    PhaseScope(GenerationProfiler* profiler, GenerationProfiler::Phase phase, SizeType step, SizeType microBatchId,
+        CudaStream const* stream)
+        : mProfiler{profiler != nullptr && profiler->recordsPhases() ? profiler : nullptr}
+        , mStream{stream}
+    {
+        if (mProfiler)
+        {
+            mHandle = mProfiler->beginPhase(phase, step, microBatchId, mStream);
+        }
+    }
+
+    PhaseScope(PhaseScope const&) = delete;
+    PhaseScope& operator=(PhaseScope const&) = delete;
+
+    ~PhaseScope()
+    {
+        if (mProfiler)
+        {
+            mProfiler->endPhase(mHandle, mStream);
+        }
+    }
+
+private:
+    GenerationProfiler* mProfiler;
+    CudaStream const* mStream;
+    std::size_t mHandle{0};
+};
+
 } // namespace
 
 GptSession::GptSession(Config const& sessionConfig, GptModelConfig const& modelConfig, WorldConfig const& worldConfig,
@@ -79,8 +131,17 @@ GptSession::GptSession(Config const& sessionConfig, GptModelConfig const& modelC
     , mWorldConfig{worldConfig}
     , mDevice{utils::initDevice(worldConfig)}
     , mLogger{logger ? std::move(logger) : std::make_shared<TllmLogger>()}
-    , mRuntime{std::make_shared<TllmRuntime>(engineBuffer, engineSize, *mLogger)}
+    , mRuntime{createRuntime(mWorldConfig, engineBuffer, engineSize, *mLogger)}
 {
+    // The attention layers of the engine attend to the local KV cache only, see RingAttention.
+    TLLM_CHECK_WITH_INFO(!mWorldConfig.isContextParallel(), "GptSession does not support context parallelism.");
+
+    if (sessionConfig.affinityConfig)
+    {
+        // Before setup, which allocates the pinned buffers and starts the callback thread
+        NumaAffinity::getInstance().apply(mDevice, *sessionConfig.affinityConfig);
+    }
+
     if (mWorldConfig.isPipelineParallel())
     {
         mPipelineComm = std::make_shared<NcclCommunicator>(mWorldConfig);
@@ -93,6 +154,26 @@ GptSession::GptSession(Config const& sessionConfig, GptModelConfig const& modelC
     // TODO compare expected and runtime tensor names?
 
     setup(sessionConfig);
+    TLLM_LOG_INFO(StartupReport::getInstance().toString());
+}
+
+GptSession::GptSession(Config const& sessionConfig, GptModelConfig const& modelConfig, WorldConfig const& worldConfig,
+    std::string const& engineFile, LoggerPtr logger)
+    : GptSession(sessionConfig, modelConfig, worldConfig, utils::MappedFile{engineFile}, std::move(logger))
+{
+}
+
+GptSession::GptSession(Config const& sessionConfig, GptModelConfig const& modelConfig, WorldConfig const& worldConfig,
+    utils::MappedFile const& engineFile, LoggerPtr logger)
+    : GptSession(sessionConfig, modelConfig, worldConfig, engineFile.data(), engineFile.size(), std::move(logger))
+{
+}
+
+void GptSession::refitWeights(StringPtrMap<ITensor> const& weights)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    mRuntime->refitWeights(weights);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
 nvinfer1::ILogger& GptSession::getLogger() const
@@ -113,11 +194,12 @@ nvinfer1::DataType GptSession::getLogitDataType() const
 void GptSession::createContexts()
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    StartupReport::ScopedPhase const startupPhase{"create_contexts"};
     mRuntime->clearContexts();
 
     auto const numProfiles = mRuntime->getNbProfiles();
-    TLLM_CHECK_WITH_INFO(
-        numProfiles == 1 || numProfiles == 2, "GPT only expects one optimization profile or two optimization profiles");
+    TLLM_CHECK_WITH_INFO(numProfiles == 1 || numProfiles == 2 || mProfileSelector,
+        "GPT only expects one optimization profile or two optimization profiles");
 
     // Instantiate 1 execution context for each profile
     for (auto contextId = 0; contextId < numProfiles; ++contextId)
@@ -131,6 +213,8 @@ void GptSession::createContexts()
 void GptSession::createBuffers(SizeType numMicroBatches)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    StartupReport::ScopedPhase const startupPhase{"create_buffers"};
+    MemoryCounters::ScopedTag const memoryTag{"runtime_buffers"};
     mBuffers.clear();
 
     for (SizeType i = 0; i < numMicroBatches; ++i)
@@ -146,9 +230,11 @@ void GptSession::createDecoders(SizeType batchSize, SizeType beamWidth, SizeType
     SizeType numMicroBatches, DecodingMode const& decodingMode)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    StartupReport::ScopedPhase const startupPhase{"create_decoders"};
     auto const vocabSize = mModelConfig.getVocabSize();
     auto const vocabSizePadded = mModelConfig.getVocabSizePadded(mWorldConfig.getSize());
     auto const& stream = mRuntime->getStreamPtr();
+    MemoryCounters::ScopedTag const memoryTag{"decoder"};
 
     mDecoders.clear();
 
@@ -174,6 +260,7 @@ void GptSession::createKvCacheManager(SizeType batchSize, SizeType beamWidth, Si
     SizeType sinkTokenLength, SizeType maxSequenceLength, KvCacheConfig const& kvCacheConfig)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    StartupReport::ScopedPhase const startupPhase{"kv_cache_allocation"};
     auto const tokensPerBlock = mModelConfig.getTokensPerBlock();
 
     auto const kvDtype = [this]()
@@ -182,7 +269,7 @@ void GptSession::createKvCacheManager(SizeType batchSize, SizeType beamWidth, Si
         {
             return nvinfer1::DataType::kFP8;
         }
-        else if (mModelConfig.getQuantMode().hasInt8KvCache())
+        else if (mModelConfig.getQuantMode().hasInt8KvCache() || mModelConfig.getQuantMode().hasInt4KvCache())
         {
             return nvinfer1::DataType::kINT8;
         }
@@ -192,8 +279,23 @@ void GptSession::createKvCacheManager(SizeType batchSize, SizeType beamWidth, Si
         }
     }();
 
-    auto const maxNumBlocks = bmkv::KVCacheManager::calculateMaxNumBlocks(
+    auto const sizePerHead = mModelConfig.getSizePerHead();
+    // The INT4 cache is allocated as bytes, each head of a token takes the packed values plus its scale and zero.
+    // With dynamic scales, each block of the 8-bit cache holds one more scale per head. With KV cache eviction, each
+    // head of a token holds its eviction metadata too.
+    auto const cacheBytesPerHead = mModelConfig.getQuantMode().hasInt4KvCache()
+        ? tensorrt_llm::kernels::getInt4KVCacheBytesPerHead(sizePerHead)
+        : mModelConfig.getQuantMode().hasKvCacheDynamicScales()
+        ? tensorrt_llm::kernels::getDynamicScaleKVCacheBytesPerHead(sizePerHead, tokensPerBlock)
+        : mModelConfig.getKvCacheEvictionRecentWindow() > 0
+        ? tensorrt_llm::kernels::getKVEvictionCacheSizePerHead(
+            sizePerHead, static_cast<SizeType>(BufferDataType(kvDtype).getSize()))
+        : sizePerHead;
+
+    auto maxNumBlocks = bmkv::KVCacheManager::calculateMaxNumBlocks(
         kvCacheConfig, kvDtype, mModelConfig, mWorldConfig, getBufferManager());
+    // calculateMaxNumBlocks assumes one byte per element for kINT8.
+    maxNumBlocks = static_cast<SizeType>(static_cast<int64_t>(maxNumBlocks) * sizePerHead / cacheBytesPerHead);
 
     // If beamWidth > 1, use one more block for each sequence in the paged kv cache to avoid dropping the needed
     // tokens, when enabling cyclic kv cache.
@@ -201,11 +303,11 @@ void GptSession::createKvCacheManager(SizeType batchSize, SizeType beamWidth, Si
 
     auto const localNbLayers = mModelConfig.getNbLayers(mWorldConfig.getPipelineParallelism());
     auto const nbKvHeads = mModelConfig.getNbKvHeads();
-    auto const sizePerHead = mModelConfig.getSizePerHead();
     bool constexpr enableBlockReuse{false};
-    mKvCacheManager = std::make_shared<bmkv::KVCacheManager>(localNbLayers, nbKvHeads, sizePerHead, tokensPerBlock,
-        maxNumBlocks, batchSize, beamWidth, maxAttentionWindow, sinkTokenLength, useOneMoreBlock, kvDtype,
-        mRuntime->getStreamPtr(), enableBlockReuse, kvCacheConfig.useUvm);
+    MemoryCounters::ScopedTag const memoryTag{"kv_cache"};
+    mKvCacheManager = std::make_shared<bmkv::KVCacheManager>(localNbLayers, nbKvHeads, cacheBytesPerHead,
+        tokensPerBlock, maxNumBlocks, batchSize, beamWidth, maxAttentionWindow, sinkTokenLength, useOneMoreBlock,
+        kvDtype, mRuntime->getStreamPtr(), enableBlockReuse, kvCacheConfig.useUvm);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -213,28 +315,43 @@ void GptSession::createCustomAllReduceWorkspace(
     SizeType maxBatchSize, SizeType maxBeamWidth, SizeType maxSequenceLength)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    StartupReport::ScopedPhase const startupPhase{"custom_all_reduce_workspace"};
     setPeerAccess(mWorldConfig, true);
 
+    // With tensor parallelism across nodes, the workspace connects the ranks of the node.
+    auto const ranksPerNode = mWorldConfig.getTensorParallelRanksPerNode();
+    mMulticastMemoryHandles.clear();
     mIpcMemoryHandles.clear();
     const std::size_t bufferSize = std::min(static_cast<std::size_t>(maxBatchSize) * maxBeamWidth * maxSequenceLength
             * mModelConfig.getHiddenSize() * mWorldConfig.getTensorParallelism() * sizeof(float),
-        ::tensorrt_llm::utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(mWorldConfig.getTensorParallelism()));
+        ::tensorrt_llm::utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(ranksPerNode));
     mIpcMemoryHandles.emplace_back(std::make_shared<IpcMemory>(mWorldConfig, bufferSize));
     mIpcMemoryHandles.emplace_back(std::make_shared<IpcMemory>(mWorldConfig, bufferSize));
     mIpcMemoryHandles.emplace_back(std::make_shared<IpcMemory>(mWorldConfig, IpcMemory::FLAGS_SIZE * sizeof(int32_t)));
     mIpcMemoryHandles.emplace_back(std::make_shared<IpcMemory>(mWorldConfig, IpcMemory::FLAGS_SIZE * sizeof(int32_t)));
 
     mCommPtrs = BufferManager::cpu(
-        ITensor::makeShape({static_cast<SizeType>(mIpcMemoryHandles.size()) * mWorldConfig.getTensorParallelism()}),
+        ITensor::makeShape({static_cast<SizeType>(mIpcMemoryHandles.size()) * ranksPerNode}),
         nvinfer1::DataType::kINT64);
     auto* const commPtrsData = bufferCast<void*>(*mCommPtrs);
 
     for (size_t memIdx = 0; memIdx < mIpcMemoryHandles.size(); memIdx++)
     {
         const auto& memCommPtrs = mIpcMemoryHandles[memIdx]->getCommPtrsTensor();
-        for (SizeType tpIdx = 0; tpIdx < mWorldConfig.getTensorParallelism(); tpIdx++)
+        for (SizeType tpIdx = 0; tpIdx < ranksPerNode; tpIdx++)
         {
-            commPtrsData[memIdx * mWorldConfig.getTensorParallelism() + tpIdx] = memCommPtrs[tpIdx];
+            commPtrsData[memIdx * ranksPerNode + tpIdx] = memCommPtrs[tpIdx];
+        }
+    }
+
+    // The plugins find the NVLS buffers from the local ping and pong buffers of the workspace.
+    auto const localRank = mWorldConfig.getTensorParallelRank() % ranksPerNode;
+    for (std::size_t memIdx = 0; memIdx < 2; ++memIdx)
+    {
+        auto const* ipcBuffer = mIpcMemoryHandles[memIdx]->getCommPtrsTensor()[localRank];
+        if (auto multicastMemory = MulticastMemory::create(mWorldConfig, ipcBuffer, bufferSize))
+        {
+            mMulticastMemoryHandles.push_back(std::move(multicastMemory));
         }
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -265,6 +382,7 @@ void GptSession::setup(Config const& sessionConfig)
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
     mCudaGraphMode = sessionConfig.cudaGraphMode;
+    mAsyncCallbacks = sessionConfig.asyncCallbacks;
 
     auto const maxBatchSize = sessionConfig.maxBatchSize;
     auto const maxBeamWidth = sessionConfig.maxBeamWidth;
@@ -288,8 +406,28 @@ void GptSession::setup(Config const& sessionConfig)
 
     if (sessionConfig.cudaGraphMode)
     {
-        // Instantiate 2 graph instances for flip-flopping of each generation batch
-        mCudaGraphInstances.resize(2 * mMicroBatchConfig.numGenBatches);
+        // Keep 2 graph instances for flip-flopping of each generation batch, per batch size bucket
+        SizeType numBuckets{1};
+        for (SizeType bucket = 1; bucket < mMicroBatchConfig.genBatchSize; bucket *= 2)
+        {
+            ++numBuckets;
+        }
+        auto const minCacheSize = 2 * mMicroBatchConfig.numGenBatches;
+        auto const cacheSize = sessionConfig.cudaGraphCacheSize.value_or(minCacheSize * numBuckets);
+        // Instances launched in the last two steps may still be in flight and must not be evicted.
+        TLLM_CHECK_WITH_INFO(cacheSize >= minCacheSize, "CUDA graph cache size (%d) must be at least %d", cacheSize,
+            minCacheSize);
+        mCudaGraphInstances.emplace(cacheSize);
+    }
+    if (sessionConfig.gpuWeightsPercent < 1.0f)
+    {
+        mRuntime->setWeightStreaming(sessionConfig.gpuWeightsPercent);
+    }
+    mProfileSelector.reset();
+    if (sessionConfig.selectOptimizationProfiles)
+    {
+        mProfileSelector = std::make_shared<OptimizationProfileSelector>(
+            OptimizationProfileSelector::fromEngine(mRuntime->getEngine()));
     }
     createContexts();
     createBuffers(mMicroBatchConfig.numGenBatches);
@@ -304,7 +442,8 @@ void GptSession::setup(Config const& sessionConfig)
     mDecoderMaxAttentionWindow = maxAttentionWindow;
     mDecoderSinkTokenLength = sinkTokenLength;
 
-    if (mWorldConfig.isLastPipelineParallelRank())
+    // Embedding engines have no logits and never decode.
+    if (mWorldConfig.isLastPipelineParallelRank() && !mModelConfig.computeHiddenStates())
     {
         auto const logitsType = mRuntime->getEngine().getTensorDataType("logits");
         DecodingMode decodingMode = sessionConfig.decodingMode.value_or(
@@ -312,6 +451,15 @@ void GptSession::setup(Config const& sessionConfig)
         createDecoders(mMicroBatchConfig.genBatchSize, maxBeamWidth, maxAttentionWindow, sinkTokenLength,
             maxSequenceLength, logitsType, sessionConfig.decoderPerRequest, mMicroBatchConfig.numGenBatches,
             decodingMode);
+
+        mLogitsStreamer.reset();
+        if (sessionConfig.streamGenerationLogits)
+        {
+            TLLM_CHECK_WITH_INFO(mModelConfig.computeGenerationLogits(),
+                "Streaming generation logits requires an engine that computes generation logits");
+            mLogitsStreamer = std::make_shared<GenerationLogitsStreamer>(logitsType,
+                sessionConfig.generationLogitsDataType.value_or(logitsType), mMicroBatchConfig.numGenBatches);
+        }
     }
 
     if (mWorldConfig.isPipelineParallel() || mMicroBatchConfig.numGenBatches > 1)
@@ -341,9 +489,21 @@ void GptSession::setup(Config const& sessionConfig)
         // we don't know maxInputLength yet and ignore it for pre-allocation
         buffers->generationConfig = RuntimeBuffers::GenerationConfig{
             mMicroBatchConfig.genBatchSize, maxBeamWidth, 0, maxAttentionWindow, sinkTokenLength, maxSequenceLength};
+        buffers->streamGenerationLogits = static_cast<bool>(mLogitsStreamer);
+        if (sessionConfig.planRuntimeBuffers)
+        {
+            // Micro batches run concurrently, so each one gets its own plan
+            MemoryPlanner planner;
+            buffers->addToPlan(planner, kvCacheManager, mModelConfig, mWorldConfig);
+            auto const plannedTensors = planner.allocate(getBufferManager());
+            buffers->takeFromPlan(plannedTensors, kvCacheManager, mModelConfig, mWorldConfig);
+            TLLM_LOG_DEBUG("Planned %d runtime buffers in %zu bytes, %zu bytes saved", planner.getNumTensors(),
+                planner.getArenaSize(), planner.getTotalSize() - planner.getArenaSize());
+        }
         buffers->reshape(kvCacheManager, mModelConfig, mWorldConfig);
     }
 
+    TLLM_LOG_DEBUG("%s", MemoryCounters::getInstance().tagsToString().c_str());
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -572,6 +732,8 @@ void GptSession::generate(GenerationOutput& outputs, GenerationInput const& inpu
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
+    TLLM_CHECK_WITH_INFO(!mModelConfig.computeHiddenStates(),
+        "The engine outputs hidden states instead of logits, use computeEmbeddings instead of generate.");
     TLLM_CHECK_WITH_INFO(inputs.packed == mModelConfig.usePackedInput(),
         "The chosen model requires a packed input tensor (did you set packed?).");
     auto const& inputLengths = inputs.lengths;
@@ -634,7 +796,9 @@ void GptSession::generate(GenerationOutput& outputs, GenerationInput const& inpu
 
                 if (!outputs.generationLogits)
                 {
-                    outputs.generationLogits = manager.emptyTensor(MemoryType::kGPU, getLogitDataType());
+                    outputs.generationLogits = mLogitsStreamer
+                        ? manager.emptyTensor(MemoryType::kPINNED, mLogitsStreamer->getHostType())
+                        : manager.emptyTensor(MemoryType::kGPU, getLogitDataType());
                 }
                 outputs.generationLogits->reshape(
                     ITensor::makeShape({batchSize, beamWidth, maxNewTokens, vocabSizePadded}));
@@ -664,6 +828,95 @@ void GptSession::generate(GenerationOutput& outputs, GenerationInput const& inpu
         generateBatched(microBatchesOutputs, microBatchesInputs, samplingConfig, onTokenGenerated, generationProfiler);
     }
 
+    if (auto asyncTokenCallback = std::exchange(mAsyncTokenCallback, nullptr))
+    {
+        // deliver the tokens of all steps before returning
+        asyncTokenCallback->flush();
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void GptSession::computeEmbeddings(
+    TensorPtr const& embeddings, GenerationInput const& inputs, EmbeddingPooling pooling, bool normalize)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    TLLM_CHECK_WITH_INFO(mModelConfig.computeHiddenStates(),
+        "Computing embeddings requires an engine built to output hidden states (gather_hidden_states).");
+    TLLM_CHECK_WITH_INFO(
+        !mWorldConfig.isPipelineParallel(), "Computing embeddings does not support pipeline parallelism.");
+    TLLM_CHECK_WITH_INFO(inputs.packed == mModelConfig.usePackedInput(),
+        "The chosen model requires a packed input tensor (did you set packed?).");
+    auto const& inputLengths = inputs.lengths;
+    TLLM_CHECK_WITH_INFO(inputLengths->getShape().nbDims == 1, "Input lengths tensor must be one-dimensional.");
+
+    auto& manager = mRuntime->getBufferManager();
+    auto const& stream = mRuntime->getStream();
+    auto* kvCacheManager = mModelConfig.usePagedKvCache() ? mKvCacheManager.get() : nullptr;
+
+    auto const batchSize = static_cast<SizeType>(inputLengths->getSize());
+    auto const hiddenSize = mModelConfig.getHiddenSize() * mWorldConfig.getTensorParallelism();
+    TLLM_CHECK_WITH_INFO(embeddings->getDataType() == nvinfer1::DataType::kFLOAT, "Embeddings must be float.");
+    embeddings->reshape(ITensor::makeShape({batchSize, hiddenSize}));
+
+    // Only the context phase runs, so the micro batches reuse the buffers of the first one.
+    auto const microBatchesInputs = batchSize <= mMicroBatchConfig.genBatchSize
+        ? std::vector<GenerationInput>{inputs}
+        : splitInputs(inputs, mMicroBatchConfig.genBatchSize, manager);
+    auto constexpr beamWidth = 1;
+    auto constexpr step = 0;
+    auto constexpr defaultContextId = 0;
+    auto& generationBuffers = *mBuffers.front();
+    SizeType microBatchOffset{0};
+    for (auto const& microBatchInputs : microBatchesInputs)
+    {
+        generationBuffers.initFromInput(*microBatchInputs.ids, microBatchInputs.lengths, microBatchInputs.packed,
+            beamWidth, mDecoderMaxAttentionWindow, mDecoderSinkTokenLength, mDecoderMaxSequenceLength, manager);
+        generationBuffers.reshape(kvCacheManager, mModelConfig, mWorldConfig);
+        generationBuffers.reset(manager);
+        kvCacheAddSequences(beamWidth, 0, 0);
+
+        auto const contextBatchSize = mMicroBatchConfig.ctxBatchSize;
+        auto [inputIds, contextLengths, contextBatchOffsets]
+            = splitInputIds(microBatchInputs, contextBatchSize, manager);
+        auto contextBuffers = generationBuffers.split(contextBatchSize, mModelConfig, mWorldConfig);
+        TLLM_CHECK(inputIds.size() == contextBuffers.size());
+        for (std::size_t contextBatchId = 0; contextBatchId < contextBuffers.size(); ++contextBatchId)
+        {
+            auto& buffers = contextBuffers.at(contextBatchId);
+            auto& inputBuffer = buffers.inputBuffers[0];
+            auto& outputBuffer = buffers.outputBuffers[0];
+
+            buffers.prepareContextStep(inputIds.at(contextBatchId), microBatchInputs.padId, manager, kvCacheManager,
+                contextBatchOffsets.at(contextBatchId), mModelConfig, mWorldConfig);
+            buffers.getRuntimeBuffers(
+                inputBuffer, outputBuffer, step, inputIds.at(contextBatchId), mCommPtrs, mModelConfig, mWorldConfig);
+            mRuntime->setInputTensors(defaultContextId, inputBuffer);
+            mRuntime->setOutputTensors(defaultContextId, outputBuffer);
+            TLLM_CHECK_WITH_INFO(
+                mRuntime->executeContext(defaultContextId), "Executing TRT engine in context step failed!");
+
+            auto const batchOffset = microBatchOffset + contextBatchOffsets.at(contextBatchId);
+            auto const contextBatchEmbeddings
+                = ITensor::slice(embeddings, batchOffset, buffers.generationConfig.batchSize);
+            kernels::embeddingPooling(*contextBatchEmbeddings, *buffers.hiddenStates, *buffers.contextLengthsDevice,
+                pooling, normalize, stream);
+            sync_check_cuda_error();
+        }
+
+        auto const microBatchSize = generationBuffers.generationConfig.batchSize;
+        if (kvCacheManager != nullptr)
+        {
+            for (SizeType batchIdx = 0; batchIdx < microBatchSize; ++batchIdx)
+            {
+                kvCacheManager->removeSequence(batchIdx);
+            }
+        }
+        microBatchOffset += microBatchSize;
+    }
+
+    stream.synchronize();
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -674,6 +927,13 @@ GptSession::TokenGeneratedCallback GptSession::createOnTokenGeneratedCallback(Ge
         ITensor::SharedPtr outputIds{mWorldConfig.isPipelineParallel() || mMicroBatchConfig.numGenBatches > 1
                 ? outputs.ids
                 : mDecoders.front()->getOutputIds()};
+        if (mAsyncCallbacks)
+        {
+            mAsyncTokenCallback = std::make_shared<AsyncTokenCallback>(
+                outputs.onTokenGenerated, std::move(outputIds), mRuntime->getBufferManager());
+            return [asyncTokenCallback = mAsyncTokenCallback](
+                       SizeType step, bool finished) { (*asyncTokenCallback)(step, finished); };
+        }
         return [onTokenGenerated = outputs.onTokenGenerated, outputIds = std::move(outputIds)](
                    SizeType step, bool finished) { onTokenGenerated(outputIds, step, finished); };
     }
@@ -745,6 +1005,10 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
             {
                 buffers.logits = microBatchOutputs.contextLogits;
             }
+            if (mLogitsStreamer)
+            {
+                mLogitsStreamer->setOutput(microBatchId, microBatchOutputs.generationLogits);
+            }
         }
         if (mModelConfig.usePromptTuning())
         {
@@ -752,14 +1016,6 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
         }
     }
 
-    if (useCudaGraphs())
-    {
-        for (auto& instance : mCudaGraphInstances)
-        {
-            instance.clear();
-        }
-    }
-
     auto const profileContext = !kProfileMbIdxs.empty() && kProfileMbIdxs.count(0) > 0;
     if (profileContext)
         cudaProfilerStart();
@@ -773,7 +1029,7 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
 
     if (generationProfiler)
     {
-        manager.getStream().record(generationProfiler->getStart());
+        generationProfiler->startGeneration(manager.getStream());
     }
 
     while (numBatchesFinished < numMicroBatches)
@@ -784,8 +1040,8 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
         if (profileStep)
             cudaProfilerStart();
 
-        numBatchesFinished += executeGenerationStep(
-            step, microBatchesInputs, microBatchesOutputs, microBatchOffsets, kvCacheManager, microBatchesFinished);
+        numBatchesFinished += executeGenerationStep(step, microBatchesInputs, microBatchesOutputs, microBatchOffsets,
+            kvCacheManager, microBatchesFinished, generationProfiler.get());
 
         onTokenGenerated(step - 1, numBatchesFinished == numMicroBatches);
 
@@ -836,7 +1092,7 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
             }
         }
         // copy generation logits fragments into a single generationLogits tensor
-        if (mModelConfig.computeGenerationLogits())
+        if (mModelConfig.computeGenerationLogits() && !mLogitsStreamer)
         {
             auto& buffers = *mBuffers.at(microBatchId);
             auto& microBatchOutputs = microBatchesOutputs.at(microBatchId);
@@ -852,6 +1108,10 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
         }
     }
 
+    if (mLogitsStreamer)
+    {
+        mLogitsStreamer->join(manager.getStream());
+    }
     manager.getStream().synchronize();
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -864,7 +1124,8 @@ void GptSession::executeContextStep(std::vector<GenerationInput> const& generati
 
     auto const numGenerationBatches = static_cast<SizeType>(generationBatchesInputs.size());
     auto constexpr step = 0;
-    auto constexpr contextId = 0;
+    auto constexpr defaultContextId = 0;
+    auto const& stream = mRuntime->getStream();
     for (auto generationBatchId = 0; generationBatchId < numGenerationBatches; ++generationBatchId)
     {
         auto const& generationBatchInputs = generationBatchesInputs.at(generationBatchId);
@@ -888,10 +1149,23 @@ void GptSession::executeContextStep(std::vector<GenerationInput> const& generati
                 kvCacheManager, batchOffset, mModelConfig, mWorldConfig);
             buffers.getRuntimeBuffers(
                 inputBuffer, outputBuffer, step, inputIds.at(contextBatchId), mCommPtrs, mModelConfig, mWorldConfig);
+
+            auto const& inputShape = inputIds.at(contextBatchId)->getShape();
+            auto const numTokens = inputShape.d[inputShape.nbDims - 1];
+            auto const batchSize = buffers.generationConfig.batchSize;
+            auto const contextId = mProfileSelector
+                ? mProfileSelector->select(numTokens, batchSize, defaultContextId)
+                : defaultContextId;
             mRuntime->setInputTensors(contextId, inputBuffer);
             mRuntime->setOutputTensors(contextId, outputBuffer);
 
+            auto const measured
+                = mProfileSelector && mProfileSelector->beginMeasurement(contextId, numTokens, batchSize, stream);
             TLLM_CHECK_WITH_INFO(mRuntime->executeContext(contextId), "Executing TRT engine in context step failed!");
+            if (measured)
+            {
+                mProfileSelector->endMeasurement(stream);
+            }
             sync_check_cuda_error();
         }
 
@@ -899,7 +1173,11 @@ void GptSession::executeContextStep(std::vector<GenerationInput> const& generati
         sync_check_cuda_error();
 
         // Save the last token logits of context into generation logits
-        if (mModelConfig.computeGenerationLogits())
+        if (mLogitsStreamer)
+        {
+            mLogitsStreamer->push(generationBatchId, step, *generationBuffers.logits, mRuntime->getStream());
+        }
+        else if (mModelConfig.computeGenerationLogits())
         {
             auto& buffers = *mBuffers.at(generationBatchId);
             buffers.generationLogitsFragments->push_back(generationBuffers.logits);
@@ -916,6 +1194,10 @@ void GptSession::executeContextStep(std::vector<GenerationInput> const& generati
             TensorPtr newLogitBuffer = ITensor::slice(generationBuffers.allGenerationLogits, 1, 1);
             newLogitBuffer->squeeze(0);
             generationBuffers.logits = newLogitBuffer;
+            if (mLogitsStreamer)
+            {
+                mLogitsStreamer->waitForSlot(generationBatchId, step + 1, mRuntime->getStream());
+            }
         }
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -923,8 +1205,10 @@ void GptSession::executeContextStep(std::vector<GenerationInput> const& generati
 
 SizeType GptSession::executeGenerationStep(SizeType step, std::vector<GenerationInput> const& microBatchesInputs,
     std::vector<GenerationOutput>& microBatchesOutputs, std::vector<SizeType> const& microBatchOffsets,
-    KvCacheManager* kvCacheManager, std::vector<bool>& microBatchesFinished)
+    KvCacheManager* kvCacheManager, std::vector<bool>& microBatchesFinished, GenerationProfiler* profiler)
 {
+    using Phase = GenerationProfiler::Phase;
+
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     TLLM_CHECK(microBatchesInputs.size() == microBatchesOutputs.size());
     auto& manager = mRuntime->getBufferManager();
@@ -933,7 +1217,7 @@ SizeType GptSession::executeGenerationStep(SizeType step, std::vector<Generation
     SizeType numBatchesFinished{0};
 
     auto const flipFlopId = step % 2;
-    auto const contextId = mRuntime->getNbProfiles() - 1;
+    auto const defaultContextId = mRuntime->getNbProfiles() - 1;
     for (auto generationBatchId = 0; generationBatchId < numMicroBatches; ++generationBatchId)
     {
         if (microBatchesFinished.at(generationBatchId))
@@ -943,22 +1227,40 @@ SizeType GptSession::executeGenerationStep(SizeType step, std::vector<Generation
         auto const& generationConfig = buffers.generationConfig;
 
         auto const graphId = mMicroBatchConfig.getGenGraphId(flipFlopId, generationBatchId);
+        // One token per sequence
+        auto const numSequences = generationConfig.batchSize * generationConfig.beamWidth;
+        auto const numTokens = mModelConfig.usePackedInput() ? numSequences : 1;
+        auto const contextId = mProfileSelector
+            ? mProfileSelector->select(numTokens, numSequences, defaultContextId)
+            : defaultContextId;
         auto& inputBuffer = buffers.inputBuffers[flipFlopId];
         auto& outputBuffer = buffers.outputBuffers[flipFlopId];
 
-        auto nextInputIds = buffers.prepareNextStep(
-            step - 1, manager, kvCacheManager, microBatchOffsets.at(generationBatchId), mModelConfig, mWorldConfig);
-        buffers.getRuntimeBuffers(inputBuffer, outputBuffer, step, nextInputIds, mCommPtrs, mModelConfig, mWorldConfig);
-        mRuntime->setInputTensors(contextId, inputBuffer);
-        mRuntime->setOutputTensors(contextId, outputBuffer);
+        auto const& stream = mRuntime->getStream();
+        {
+            PhaseScope const phase{profiler, Phase::kPREPARE_STEP, step, generationBatchId, &stream};
+            auto nextInputIds = buffers.prepareNextStep(
+                step - 1, manager, kvCacheManager, microBatchOffsets.at(generationBatchId), mModelConfig, mWorldConfig);
+            buffers.getRuntimeBuffers(
+                inputBuffer, outputBuffer, step, nextInputIds, mCommPtrs, mModelConfig, mWorldConfig);
+            mRuntime->setInputTensors(contextId, inputBuffer);
+            mRuntime->setOutputTensors(contextId, outputBuffer);
+        }
 
         if (useCudaGraphs())
         {
-            mCudaGraphInstances.at(graphId).prepareNextGraph(*mRuntime, contextId);
+            PhaseScope const phase{profiler, Phase::kGRAPH_CAPTURE, step, generationBatchId, nullptr};
+            mCudaGraphInstances->get(generationConfig.batchSize, contextId, graphId)
+                .prepareNextGraph(*mRuntime, contextId);
         }
 
         // check decoder result of previous iteration
-        if (shouldStopSync(generationConfig.batchSize, generationConfig.beamWidth, generationBatchId))
+        bool shouldStop{false};
+        {
+            PhaseScope const phase{profiler, Phase::kSTOP_CHECK, step, generationBatchId, nullptr};
+            shouldStop = shouldStopSync(generationConfig.batchSize, generationConfig.beamWidth, generationBatchId);
+        }
+        if (shouldStop)
         {
             mLogger->log(nvinfer1::ILogger::Severity::kVERBOSE,
                 tc::fmtstr("GPT decoding finished for step %d and microBatchId %d", step, generationBatchId).c_str());
@@ -967,20 +1269,33 @@ SizeType GptSession::executeGenerationStep(SizeType step, std::vector<Generation
             continue;
         }
 
-        if (useCudaGraphs())
-        {
-            auto& cudaGraphInstance = mCudaGraphInstances.at(graphId);
-            TLLM_CHECK(cudaGraphInstance.hasInstance());
-            cudaGraphInstance.launch(mRuntime->getStream());
-        }
-        else
         {
-            TLLM_CHECK_WITH_INFO(
-                mRuntime->executeContext(contextId), tc::fmtstr("Executing TRT engine in step %d failed!", step));
+            PhaseScope const phase{profiler, Phase::kENGINE, step, generationBatchId, &stream};
+            auto const measured = mProfileSelector
+                && mProfileSelector->beginMeasurement(contextId, numTokens, numSequences, stream);
+            if (useCudaGraphs())
+            {
+                auto& cudaGraphInstance = mCudaGraphInstances->get(generationConfig.batchSize, contextId, graphId);
+                TLLM_CHECK(cudaGraphInstance.hasInstance());
+                cudaGraphInstance.launch(stream);
+            }
+            else
+            {
+                TLLM_CHECK_WITH_INFO(
+                    mRuntime->executeContext(contextId), tc::fmtstr("Executing TRT engine in step %d failed!", step));
+            }
+            if (measured)
+            {
+                mProfileSelector->endMeasurement(stream);
+            }
         }
         sync_check_cuda_error();
 
-        if (mModelConfig.computeGenerationLogits())
+        if (mLogitsStreamer)
+        {
+            mLogitsStreamer->push(generationBatchId, step, *buffers.logits, stream);
+        }
+        else if (mModelConfig.computeGenerationLogits())
         {
             auto& buffers = *mBuffers.at(generationBatchId);
             buffers.generationLogitsFragments->push_back(buffers.logits);
@@ -991,9 +1306,22 @@ SizeType GptSession::executeGenerationStep(SizeType step, std::vector<Generation
 
         auto const decoderStep = generationConfig.maxInputLength + step;
 
-        decoderStepAsync(decoderStep, generationBatchId);
+        {
+            // decoder and pipeline transfers are recorded on the compute stream
+            PhaseScope const phase{profiler, Phase::kDECODER, step, generationBatchId, &stream};
+            decoderStepAsync(decoderStep, generationBatchId);
+        }
 
-        if (mModelConfig.computeGenerationLogits() && buffers.allGenerationLogits->getShape().d[0] > step + 1)
+        if (mLogitsStreamer)
+        {
+            // the engine writes the next logits into the slot of the step before the last one once it is copied
+            TensorPtr newLogitBuffer
+                = ITensor::slice(buffers.allGenerationLogits, (step + 1) % GenerationLogitsStreamer::kNumSlots, 1);
+            newLogitBuffer->squeeze(0);
+            buffers.logits = newLogitBuffer;
+            mLogitsStreamer->waitForSlot(generationBatchId, step + 1, stream);
+        }
+        else if (mModelConfig.computeGenerationLogits() && buffers.allGenerationLogits->getShape().d[0] > step + 1)
         {
             TensorPtr newLogitBuffer = ITensor::slice(buffers.allGenerationLogits, step + 1, 1);
             newLogitBuffer->squeeze(0);
@@ -1224,9 +1552,175 @@ void GptSession::CudaGraphExecutor::clear()
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+void GptSession::GenerationProfiler::startGeneration(CudaStream const& stream)
+{
+    mPhases.clear();
+    mNumUsedEvents = 0;
+    mStartTime = Clock::now();
+    stream.record(start);
+}
+
+std::size_t GptSession::GenerationProfiler::acquireEvent(CudaStream const& stream)
+{
+    if (mNumUsedEvents == mEventPool.size())
+    {
+        mEventPool.emplace_back(flags);
+    }
+    auto const eventIdx = mNumUsedEvents++;
+    stream.record(mEventPool[eventIdx]);
+    return eventIdx;
+}
+
+std::size_t GptSession::GenerationProfiler::beginPhase(
+    Phase phase, SizeType step, SizeType microBatchId, CudaStream const* stream)
+{
+    auto& pending = mPhases.emplace_back(PendingPhase{phase, step, microBatchId, stream != nullptr});
+    if (stream != nullptr)
+    {
+        pending.beginEvent = acquireEvent(*stream);
+    }
+    else
+    {
+        pending.beginTime = Clock::now();
+    }
+    return mPhases.size() - 1;
+}
+
+void GptSession::GenerationProfiler::endPhase(std::size_t handle, CudaStream const* stream)
+{
+    auto& pending = mPhases.at(handle);
+    TLLM_CHECK_WITH_INFO(pending.onDevice == (stream != nullptr), "Phase must begin and end on the same timeline");
+    if (stream != nullptr)
+    {
+        pending.endEvent = acquireEvent(*stream);
+    }
+    else
+    {
+        pending.endTime = Clock::now();
+    }
+}
+
+std::vector<GptSession::GenerationProfiler::PhaseRecord> GptSession::GenerationProfiler::getPhases()
+{
+    end.synchronize();
+    auto const elapsedMs = [this](CudaEvent const& event)
+    {
+        float result;
+        TLLM_CUDA_CHECK(::cudaEventElapsedTime(&result, start.get(), event.get()));
+        return result;
+    };
+    auto const hostMs = [this](Clock::time_point const& time)
+    { return std::chrono::duration<float, std::milli>(time - mStartTime).count(); };
+
+    std::vector<PhaseRecord> records;
+    records.reserve(mPhases.size());
+    for (auto const& pending : mPhases)
+    {
+        auto const startMs = pending.onDevice ? elapsedMs(mEventPool[pending.beginEvent]) : hostMs(pending.beginTime);
+        auto const endMs = pending.onDevice ? elapsedMs(mEventPool[pending.endEvent]) : hostMs(pending.endTime);
+        records.push_back(
+            PhaseRecord{pending.phase, pending.step, pending.microBatchId, pending.onDevice, startMs, endMs - startMs});
+    }
+    return records;
+}
+
+void GptSession::GenerationProfiler::writeChromeTrace(std::ostream& os)
+{
+    // Host and device phases are shown as two threads of one process, one row per micro batch on the device.
+    auto const streamFlags = os.flags();
+    auto const precision = os.precision(3);
+    os << std::fixed << "{\"traceEvents\":[";
+    bool first{true};
+    for (auto const& record : getPhases())
+    {
+        os << (first ? "" : ",") << "\n{\"name\":\"" << getPhaseName(record.phase)
+           << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << (record.onDevice ? 1 + record.microBatchId : 0)
+           << ",\"ts\":" << record.startMs * 1000.0f << ",\"dur\":" << record.durationMs * 1000.0f
+           << ",\"args\":{\"step\":" << record.step << ",\"micro_batch\":" << record.microBatchId << "}}";
+        first = false;
+    }
+    os << "\n]}\n";
+    os.flags(streamFlags);
+    os.precision(precision);
+}
+
+void GptSession::GenerationProfiler::writeCsv(std::ostream& os)
+{
+    auto const streamFlags = os.flags();
+    auto const precision = os.precision(4);
+    os << std::fixed << "phase,step,micro_batch,timeline,start_ms,duration_ms\n";
+    for (auto const& record : getPhases())
+    {
+        os << getPhaseName(record.phase) << ',' << record.step << ',' << record.microBatchId << ','
+           << (record.onDevice ? "device" : "host") << ',' << record.startMs << ',' << record.durationMs << '\n';
+    }
+    os.flags(streamFlags);
+    os.precision(precision);
+}
+
+char const* GptSession::GenerationProfiler::getPhaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::kPREPARE_STEP: return "prepare_step";
+    case Phase::kGRAPH_CAPTURE: return "graph_capture";
+    case Phase::kSTOP_CHECK: return "stop_check";
+    case Phase::kENGINE: return "engine";
+    case Phase::kDECODER: return "decoder";
+    }
+    return "unknown";
+}
+
+GptSession::CudaGraphExecutorCache::CudaGraphExecutorCache(SizeType capacity)
+    : mCapacity{capacity}
+{
+    TLLM_CHECK_WITH_INFO(mCapacity > 0, "CUDA graph cache size must be positive");
+}
+
+GptSession::CudaGraphExecutor& GptSession::CudaGraphExecutorCache::get(
+    SizeType batchSize, SizeType contextId, SizeType graphId)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    Key const key{getBatchSizeBucket(batchSize), contextId, graphId};
+    if (auto it = mIndex.find(key); it != mIndex.end())
+    {
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return it->second->executor;
+    }
+
+    if (size() >= mCapacity)
+    {
+        TLLM_LOG_DEBUG("Evicting least recently used CUDA graph instance");
+        mIndex.erase(mEntries.back().key);
+        mEntries.pop_back();
+    }
+    auto& entry = mEntries.emplace_front();
+    entry.key = key;
+    mIndex.emplace(key, mEntries.begin());
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return entry.executor;
+}
+
+void GptSession::CudaGraphExecutorCache::clear()
+{
+    mIndex.clear();
+    mEntries.clear();
+}
+
+SizeType GptSession::CudaGraphExecutorCache::getBatchSizeBucket(SizeType batchSize)
+{
+    SizeType bucket{1};
+    while (bucket < batchSize)
+    {
+        bucket *= 2;
+    }
+    return bucket;
+}
+
 void GptSession::CudaGraphExecutor::prepareNextGraph(TllmRuntime const& runtime, SizeType nextContextId)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    StartupReport::ScopedPhase const startupPhase{"cuda_graph_capture"};
     auto& stream = runtime.getStream();
 
     cudaGraph_t nextGraph;
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+
+#include <cuda_runtime_api.h>
+
+#include <exception>
+#include <iterator>
+#include <thread>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+thread_local InProcessWorld* currentWorld{nullptr};
+thread_local SizeType currentRank{-1};
+
+SizeType getNumDevices()
+{
+    int numDevices{0};
+    TLLM_CUDA_CHECK(::cudaGetDeviceCount(&numDevices));
+    return numDevices;
+}
+} // namespace
+
+InProcessWorld::InProcessWorld(SizeType tensorParallelism, SizeType pipelineParallelism, SizeType contextParallelism,
+    std::optional<std::vector<SizeType>> const& deviceIds)
+    // All the ranks are on this node, which has as many GPUs as are visible
+    : mWorldConfig{tensorParallelism, pipelineParallelism, 0, getNumDevices(), deviceIds, contextParallelism}
+    , mDeviceIds{deviceIds}
+{
+    TLLM_CHECK_WITH_INFO(mWorldConfig.getSize() <= mWorldConfig.getGpusPerGroup(),
+        "An in-process world of %d ranks needs as many GPUs, %d are available", mWorldConfig.getSize(),
+        mWorldConfig.getGpusPerGroup());
+}
+
+WorldConfig InProcessWorld::getWorldConfig(SizeType rank) const
+{
+    TLLM_CHECK_WITH_INFO(0 <= rank && rank < getSize(), "Invalid rank %d", rank);
+    return WorldConfig{mWorldConfig.getTensorParallelism(), mWorldConfig.getPipelineParallelism(), rank,
+        mWorldConfig.getGpusPerNode(), mDeviceIds, mWorldConfig.getContextParallelism()};
+}
+
+void InProcessWorld::run(RankFunc const& func)
+{
+    TLLM_CHECK_WITH_INFO(getCurrent() == nullptr, "InProcessWorld::run is not reentrant");
+    auto const size = getSize();
+    TLLM_LOG_INFO("Running %d ranks in process", size);
+
+    std::vector<std::exception_ptr> errors(size);
+    std::vector<std::thread> threads;
+    threads.reserve(size);
+    for (SizeType rank = 0; rank < size; ++rank)
+    {
+        threads.emplace_back(
+            [this, &func, &errors, rank]()
+            {
+                currentWorld = this;
+                currentRank = rank;
+                try
+                {
+                    auto const worldConfig = getWorldConfig(rank);
+                    TLLM_CUDA_CHECK(::cudaSetDevice(worldConfig.getDevice()));
+                    func(worldConfig);
+                }
+                catch (...)
+                {
+                    errors[rank] = std::current_exception();
+                }
+                currentWorld = nullptr;
+                currentRank = -1;
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (auto const& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+InProcessWorld* InProcessWorld::getCurrent() noexcept
+{
+    return currentWorld;
+}
+
+std::optional<SizeType> InProcessWorld::getCurrentRank() noexcept
+{
+    return currentWorld != nullptr ? std::optional<SizeType>{currentRank} : std::nullopt;
+}
+
+SizeType InProcessWorld::getSessionRank()
+{
+    return currentWorld != nullptr ? currentRank : COMM_SESSION.getRank();
+}
+
+std::vector<std::vector<char>> InProcessWorld::allgather(std::set<int> const& group, std::vector<char> data)
+{
+    TLLM_CHECK_WITH_INFO(getCurrent() == this, "Collectives of an in-process world must run on its ranks");
+    auto const it = group.find(currentRank);
+    TLLM_CHECK_WITH_INFO(it != group.end(), "Rank %d is not in the group of the exchange", currentRank);
+    auto const groupRank = static_cast<std::size_t>(std::distance(group.begin(), it));
+    auto const groupSize = static_cast<SizeType>(group.size());
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto const key = std::make_pair(group, mNumCalls[{group, currentRank}]++);
+    auto& exchange = mExchanges[key];
+    if (exchange.parts.empty())
+    {
+        exchange.parts.resize(group.size());
+    }
+    exchange.parts[groupRank] = std::move(data);
+    if (++exchange.numArrived == groupSize)
+    {
+        mExchanged.notify_all();
+    }
+    else
+    {
+        mExchanged.wait(lock, [&exchange, groupSize] { return exchange.numArrived == groupSize; });
+    }
+
+    auto parts = exchange.parts;
+    if (++exchange.numDeparted == groupSize)
+    {
+        mExchanges.erase(key);
+    }
+    return parts;
+}
+
+} // namespace tensorrt_llm::runtime
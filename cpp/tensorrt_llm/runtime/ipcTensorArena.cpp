@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/ipcTensorArena.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+namespace tensorrt_llm::runtime
+{
+
+IpcTensorArena::IpcTensorArena(std::size_t capacity)
+    : mCapacity{capacity}
+    , mOwner{true}
+{
+    TLLM_CHECK_WITH_INFO(capacity > 0 && capacity % kAlignment == 0,
+        "Capacity of the IPC tensor arena must be a multiple of %zu, got %zu", kAlignment, capacity);
+    TLLM_CUDA_CHECK(cudaMalloc(&mData, mCapacity));
+}
+
+IpcTensorArena::IpcTensorArena(cudaIpcMemHandle_t const& handle, std::size_t capacity)
+    : mCapacity{capacity}
+    , mOwner{false}
+{
+    TLLM_CUDA_CHECK(cudaIpcOpenMemHandle(&mData, handle, cudaIpcMemLazyEnablePeerAccess));
+}
+
+IpcTensorArena::~IpcTensorArena()
+{
+    auto const status = mOwner ? cudaFree(mData) : cudaIpcCloseMemHandle(mData);
+    if (status != cudaSuccess)
+    {
+        TLLM_LOG_ERROR("Error releasing the IPC tensor arena: %s", cudaGetErrorString(status));
+    }
+}
+
+cudaIpcMemHandle_t IpcTensorArena::getHandle() const
+{
+    TLLM_CHECK_WITH_INFO(mOwner, "Only the owner of the IPC tensor arena can share it");
+    cudaIpcMemHandle_t handle;
+    TLLM_CUDA_CHECK(cudaIpcGetMemHandle(&handle, mData));
+    return handle;
+}
+
+std::optional<IpcTensorDesc> IpcTensorArena::put(ITensor const& tensor, CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(mOwner, "Only the owner of the IPC tensor arena can put tensors");
+    auto const numBytes = static_cast<std::uint64_t>(tensor.getSizeInBytes());
+    auto const size = (numBytes + kAlignment - 1) / kAlignment * kAlignment;
+    auto begin = mHead;
+    // A tensor is never split, skip the end of the arena if it does not fit there
+    auto const offset = begin % mCapacity;
+    if (offset + size > mCapacity)
+    {
+        begin += mCapacity - offset;
+    }
+    auto const tail = mAllocations.empty() ? mHead : mAllocations.front().begin;
+    if (size > mCapacity || begin + size - tail > mCapacity)
+    {
+        return std::nullopt;
+    }
+
+    IpcTensorDesc desc{begin % mCapacity, numBytes, tensor.getDataType(), tensor.getShape()};
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(
+        static_cast<char*>(mData) + desc.offset, tensor.data(), numBytes, cudaMemcpyDefault, stream.get()));
+    mAllocations.push_back(Allocation{begin, begin + size});
+    mHead = begin + size;
+    return desc;
+}
+
+void IpcTensorArena::release(IpcTensorDesc const& desc)
+{
+    TLLM_CHECK_WITH_INFO(!mAllocations.empty() && mAllocations.front().begin % mCapacity == desc.offset,
+        "Tensors of the IPC tensor arena must be released in the order they were put");
+    mAllocations.pop_front();
+}
+
+ITensor::SharedPtr IpcTensorArena::view(IpcTensorDesc const& desc) const
+{
+    TLLM_CHECK_WITH_INFO(desc.offset + desc.numBytes <= mCapacity, "Tensor out of the IPC tensor arena");
+    return ITensor::wrap(static_cast<char*>(mData) + desc.offset, desc.dataType, desc.shape);
+}
+
+} // namespace tensorrt_llm::runtime
@@ -14,17 +14,120 @@
  * limitations under the License.
  */
 #include "tensorrt_llm/runtime/ipcUtils.h"
+#include "tensorrt_llm/common/cudaDriverWrapper.h"
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tc = tensorrt_llm::common;
 
 namespace tensorrt_llm::runtime
 {
 
+namespace
+{
+
+// The buffers are shared by the tensor parallel ranks of the node, NCCL connects the nodes.
+mpi::MpiComm splitNodeComm(WorldConfig const& worldConfig)
+{
+    const auto ranksPerNode = worldConfig.getTensorParallelRanksPerNode();
+    const auto nbNodes = worldConfig.getTensorParallelism() / ranksPerNode;
+    const auto tpRank = worldConfig.getTensorParallelRank();
+    const auto ppRank = worldConfig.getPipelineParallelRank();
+    return COMM_SESSION.split(ppRank * nbNodes + tpRank / ranksPerNode, tpRank % ranksPerNode);
+}
+
+// Ranks of the buffers in an in-process world, the node has all of them
+std::set<int> getNodeGroup(WorldConfig const& worldConfig)
+{
+    auto const ranksPerNode = worldConfig.getTensorParallelRanksPerNode();
+    auto const firstRank = worldConfig.getRank() - worldConfig.getTensorParallelRank() % ranksPerNode;
+    std::set<int> group;
+    for (SizeType idx = 0; idx < ranksPerNode; ++idx)
+    {
+        group.insert(firstRank + idx);
+    }
+    return group;
+}
+
+void checkDriver(CUresult result, tc::CUDADriverWrapper const& driver, char const* call)
+{
+    if (result != CUDA_SUCCESS)
+    {
+        char const* name = nullptr;
+        driver.cuGetErrorName(result, &name);
+        TLLM_THROW("%s failed: %s", call, name != nullptr ? name : "unknown error");
+    }
+}
+
+// The multimem instructions need SM90
+bool isMulticastSupported(tc::CUDADriverWrapper const& driver, CUdevice device)
+{
+    int supported = 0;
+    int major = 0;
+    return driver.cuDeviceGetAttribute(&supported, CU_DEVICE_ATTRIBUTE_MULTICAST_SUPPORTED, device) == CUDA_SUCCESS
+        && supported != 0
+        && driver.cuDeviceGetAttribute(&major, CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR, device) == CUDA_SUCCESS
+        && major >= 9;
+}
+
+// Duplicates the file descriptor fd of the process pid, which needs the permission to ptrace it.
+int duplicateFd(int pid, int fd)
+{
+#if defined(SYS_pidfd_open) && defined(SYS_pidfd_getfd)
+    auto const pidFd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+    if (pidFd < 0)
+    {
+        return -1;
+    }
+    auto const localFd = static_cast<int>(::syscall(SYS_pidfd_getfd, pidFd, fd, 0));
+    ::close(pidFd);
+    return localFd;
+#else
+    return -1;
+#endif
+}
+
+bool allRanks(mpi::MpiComm const& comm, bool value)
+{
+    int const local = value ? 1 : 0;
+    int all = 0;
+    comm.allreduce(&local, &all, 1, mpi::MpiType::kINT32, mpi::MpiOp::MIN);
+    return all != 0;
+}
+
+std::mutex& getMulticastMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_map<void const*, MulticastMemory const*>& getMulticastBuffers()
+{
+    static std::unordered_map<void const*, MulticastMemory const*> buffers;
+    return buffers;
+}
+
+} // namespace
+
 void setPeerAccess(WorldConfig const& worldConfig, bool enable)
 {
-    const auto srcNode = worldConfig.getTensorParallelRank();
+    const auto ranksPerNode = worldConfig.getTensorParallelRanksPerNode();
+    const auto srcNode = worldConfig.getTensorParallelRank() % ranksPerNode;
 
-    for (SizeType destNode = 0; destNode < worldConfig.getTensorParallelism(); destNode++)
+    for (SizeType destNode = 0; destNode < ranksPerNode; destNode++)
     {
         if (destNode == srcNode)
         {
@@ -52,7 +155,7 @@ void setPeerAccess(WorldConfig const& worldConfig, bool enable)
 
 IpcMemory::IpcMemory(WorldConfig const& worldConfig, std::size_t bufferSize)
     : mWorldConfig(worldConfig)
-    , mCommPtrs(worldConfig.getTensorParallelism())
+    , mCommPtrs(worldConfig.getTensorParallelRanksPerNode())
     , mBufferSize(bufferSize)
 {
     allocateIpcMemory();
@@ -63,16 +166,44 @@ void IpcMemory::allocateIpcMemory()
     TLLM_CUDA_CHECK(cudaMalloc(&mBufferPtr, mBufferSize));
     TLLM_CUDA_CHECK(cudaMemset(mBufferPtr, 0, mBufferSize));
 
+    if (auto* world = InProcessWorld::getCurrent())
+    {
+        // The ranks share the address space, they use the buffers of the others directly with peer access
+        mInProcess = true;
+        auto const group = getNodeGroup(mWorldConfig);
+        auto const* localPtr = reinterpret_cast<char const*>(&mBufferPtr);
+        auto const ptrs = world->allgather(group, std::vector<char>(localPtr, localPtr + sizeof(mBufferPtr)));
+        auto peer = group.begin();
+        for (std::size_t nodeId = 0; nodeId < ptrs.size(); ++nodeId, ++peer)
+        {
+            std::memcpy(&mCommPtrs[nodeId], ptrs[nodeId].data(), sizeof(void*));
+            if (mCommPtrs[nodeId] != mBufferPtr)
+            {
+                auto const result = cudaDeviceEnablePeerAccess(world->getWorldConfig(*peer).getDevice(), 0);
+                if (result == cudaErrorPeerAccessAlreadyEnabled)
+                {
+                    // Clear the error
+                    cudaGetLastError();
+                }
+                else
+                {
+                    TLLM_CUDA_CHECK(result);
+                }
+            }
+        }
+        return;
+    }
+
     cudaIpcMemHandle_t localHandle;
     TLLM_CUDA_CHECK(cudaIpcGetMemHandle(&localHandle, mBufferPtr));
 
-    const auto tpRank = mWorldConfig.getTensorParallelRank();
-    const auto ppRank = mWorldConfig.getPipelineParallelRank();
-    auto const comm = COMM_SESSION.split(ppRank, tpRank);
-    std::vector<char> serialHandles(CUDA_IPC_HANDLE_SIZE * mWorldConfig.getTensorParallelism(), 0);
+    const auto ranksPerNode = mWorldConfig.getTensorParallelRanksPerNode();
+    const auto localRank = mWorldConfig.getTensorParallelRank() % ranksPerNode;
+    auto const comm = splitNodeComm(mWorldConfig);
+    std::vector<char> serialHandles(CUDA_IPC_HANDLE_SIZE * ranksPerNode, 0);
     comm.allgather(&localHandle.reserved, serialHandles.data(), CUDA_IPC_HANDLE_SIZE, mpi::MpiType::kBYTE);
 
-    std::vector<cudaIpcMemHandle_t> handles(mWorldConfig.getTensorParallelism());
+    std::vector<cudaIpcMemHandle_t> handles(ranksPerNode);
     for (size_t i = 0; i < handles.size(); ++i)
     {
         memcpy(handles[i].reserved, &serialHandles[i * CUDA_IPC_HANDLE_SIZE], CUDA_IPC_HANDLE_SIZE);
@@ -80,7 +211,7 @@ void IpcMemory::allocateIpcMemory()
 
     for (size_t nodeId = 0; nodeId < handles.size(); nodeId++)
     {
-        if ((int) nodeId == mWorldConfig.getTensorParallelRank())
+        if ((int) nodeId == localRank)
         {
             mCommPtrs[nodeId] = mBufferPtr;
         }
@@ -101,13 +232,14 @@ IpcMemory::~IpcMemory()
 
 void IpcMemory::destroyIpcMemory()
 {
-    for (SizeType nodeId = 0; nodeId < mWorldConfig.getTensorParallelism(); ++nodeId)
+    const auto ranksPerNode = mWorldConfig.getTensorParallelRanksPerNode();
+    for (SizeType nodeId = 0; nodeId < ranksPerNode; ++nodeId)
     {
-        if ((int) nodeId == mWorldConfig.getTensorParallelRank())
+        if ((int) nodeId == mWorldConfig.getTensorParallelRank() % ranksPerNode)
         {
             TLLM_CUDA_CHECK(cudaFree(mCommPtrs[nodeId]));
         }
-        else
+        else if (!mInProcess)
         {
             TLLM_CUDA_CHECK(cudaIpcCloseMemHandle(mCommPtrs[nodeId]));
         }
@@ -115,4 +247,193 @@ void IpcMemory::destroyIpcMemory()
     cudaFree(mBufferPtr);
 }
 
+std::shared_ptr<MulticastMemory> MulticastMemory::create(
+    WorldConfig const& worldConfig, void const* ipcBuffer, std::size_t bufferSize)
+{
+    if (InProcessWorld::getCurrent() != nullptr)
+    {
+        // The multicast object is shared through a file descriptor between processes, the NVLS all-reduce is not
+        // set up for the ranks of one process.
+        return nullptr;
+    }
+    auto const comm = splitNodeComm(worldConfig);
+    auto const ranksPerNode = worldConfig.getTensorParallelRanksPerNode();
+    auto const localRank = worldConfig.getTensorParallelRank() % ranksPerNode;
+
+    auto driver = std::make_shared<tc::CUDADriverWrapper>();
+    int device{-1};
+    TLLM_CUDA_CHECK(cudaGetDevice(&device));
+    CUdevice cuDevice{};
+    bool supported = ranksPerNode > 1 && driver->cuDeviceGet(&cuDevice, device) == CUDA_SUCCESS
+        && isMulticastSupported(*driver, cuDevice);
+#if defined(_WIN32)
+    // The handle of the multicast object is shared as a POSIX file descriptor
+    supported = false;
+#endif
+    if (!allRanks(comm, supported))
+    {
+        return nullptr;
+    }
+
+#if defined(_WIN32)
+    return nullptr;
+#else
+    CUmulticastObjectProp prop{};
+    prop.numDevices = static_cast<unsigned int>(ranksPerNode);
+    prop.handleTypes = CU_MEM_HANDLE_TYPE_POSIX_FILE_DESCRIPTOR;
+    prop.size = bufferSize;
+    std::size_t granularity{0};
+    checkDriver(driver->cuMulticastGetGranularity(&granularity, &prop, CU_MULTICAST_GRANULARITY_RECOMMENDED), *driver,
+        "cuMulticastGetGranularity");
+    prop.size = (bufferSize + granularity - 1) / granularity * granularity;
+
+    // The first rank creates the object, the others duplicate its file descriptor into their process.
+    struct
+    {
+        int pid;
+        int fd;
+        bool created;
+    } exported{::getpid(), -1, false};
+    CUmemGenericAllocationHandle multicastHandle{0};
+    if (localRank == 0)
+    {
+        exported.created = driver->cuMulticastCreate(&multicastHandle, &prop) == CUDA_SUCCESS
+            && driver->cuMemExportToShareableHandle(
+                   &exported.fd, multicastHandle, CU_MEM_HANDLE_TYPE_POSIX_FILE_DESCRIPTOR, 0)
+                == CUDA_SUCCESS;
+    }
+    comm.bcastValue(exported, 0);
+    auto imported = exported.created;
+    if (localRank != 0 && exported.created)
+    {
+        auto const fd = duplicateFd(exported.pid, exported.fd);
+        imported = fd >= 0
+            && driver->cuMemImportFromShareableHandle(&multicastHandle,
+                   reinterpret_cast<void*>(static_cast<std::uintptr_t>(fd)), CU_MEM_HANDLE_TYPE_POSIX_FILE_DESCRIPTOR)
+                == CUDA_SUCCESS;
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    // The descriptor of the first rank is duplicated by now
+    imported = allRanks(comm, imported);
+    if (exported.fd >= 0 && localRank == 0)
+    {
+        ::close(exported.fd);
+    }
+    if (!imported)
+    {
+        if (multicastHandle != 0)
+        {
+            driver->cuMemRelease(multicastHandle);
+        }
+        TLLM_LOG_WARNING("Could not share the NVLink multicast object between the ranks of the node, e.g. for lack of "
+                         "ptrace permission, the NVLS all-reduce is disabled");
+        return nullptr;
+    }
+
+    std::shared_ptr<MulticastMemory> memory{
+        new MulticastMemory(driver, cuDevice, ipcBuffer, prop.size, static_cast<std::uint64_t>(multicastHandle))};
+    checkDriver(driver->cuMulticastAddDevice(multicastHandle, cuDevice), *driver, "cuMulticastAddDevice");
+    // Memory can only be bound once all the devices are added
+    comm.barrier();
+
+    CUmemAllocationProp memoryProp{};
+    memoryProp.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+    memoryProp.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    memoryProp.location.id = device;
+    CUmemGenericAllocationHandle memoryHandle{0};
+    checkDriver(driver->cuMemCreate(&memoryHandle, prop.size, &memoryProp, 0), *driver, "cuMemCreate");
+    auto const bound = driver->cuMulticastBindMem(multicastHandle, 0, memoryHandle, 0, prop.size, 0);
+    if (bound != CUDA_SUCCESS)
+    {
+        driver->cuMemRelease(memoryHandle);
+        checkDriver(bound, *driver, "cuMulticastBindMem");
+    }
+    memory->mMemoryHandle = static_cast<std::uint64_t>(memoryHandle);
+
+    CUmemAccessDesc access{};
+    access.location = memoryProp.location;
+    access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+    std::pair<std::uint64_t*, CUmemGenericAllocationHandle> const mappings[]
+        = {{&memory->mUnicastPtr, memoryHandle}, {&memory->mMulticastPtr, multicastHandle}};
+    for (auto const& [address, handle] : mappings)
+    {
+        CUdeviceptr ptr{0};
+        checkDriver(driver->cuMemAddressReserve(&ptr, prop.size, granularity, 0, 0), *driver, "cuMemAddressReserve");
+        auto result = driver->cuMemMap(ptr, prop.size, 0, handle, 0);
+        if (result == CUDA_SUCCESS)
+        {
+            result = driver->cuMemSetAccess(ptr, prop.size, &access, 1);
+            if (result != CUDA_SUCCESS)
+            {
+                driver->cuMemUnmap(ptr, prop.size);
+            }
+        }
+        if (result != CUDA_SUCCESS)
+        {
+            driver->cuMemAddressFree(ptr, prop.size);
+            checkDriver(result, *driver, "cuMemMap");
+        }
+        *address = static_cast<std::uint64_t>(ptr);
+    }
+    TLLM_CUDA_CHECK(cudaMemset(memory->getUnicastPtr(), 0, prop.size));
+    // All the ranks are bound before the first reduction through the object
+    comm.barrier();
+
+    {
+        std::lock_guard<std::mutex> lock(getMulticastMutex());
+        getMulticastBuffers()[ipcBuffer] = memory.get();
+    }
+    TLLM_LOG_DEBUG("Bound %zu bytes to an NVLink multicast object of %d ranks", prop.size, ranksPerNode);
+    return memory;
+#endif // defined(_WIN32)
+}
+
+MulticastMemory const* MulticastMemory::find(void const* ipcBuffer)
+{
+    std::lock_guard<std::mutex> lock(getMulticastMutex());
+    auto const& buffers = getMulticastBuffers();
+    auto const it = buffers.find(ipcBuffer);
+    return it == buffers.end() ? nullptr : it->second;
+}
+
+MulticastMemory::MulticastMemory(std::shared_ptr<tc::CUDADriverWrapper> driver, int device, void const* ipcBuffer,
+    std::size_t size, std::uint64_t multicastHandle)
+    : mDriver{std::move(driver)}
+    , mDevice{device}
+    , mIpcBuffer{ipcBuffer}
+    , mSize{size}
+    , mMulticastHandle{multicastHandle}
+{
+}
+
+MulticastMemory::~MulticastMemory()
+{
+    {
+        std::lock_guard<std::mutex> lock(getMulticastMutex());
+        auto& buffers = getMulticastBuffers();
+        auto const it = buffers.find(mIpcBuffer);
+        if (it != buffers.end() && it->second == this)
+        {
+            buffers.erase(it);
+        }
+    }
+    for (auto const ptr : {mMulticastPtr, mUnicastPtr})
+    {
+        if (ptr != 0)
+        {
+            mDriver->cuMemUnmap(static_cast<CUdeviceptr>(ptr), mSize);
+            mDriver->cuMemAddressFree(static_cast<CUdeviceptr>(ptr), mSize);
+        }
+    }
+    if (mMemoryHandle != 0)
+    {
+        mDriver->cuMulticastUnbind(mMulticastHandle, mDevice, 0, mSize);
+        mDriver->cuMemRelease(mMemoryHandle);
+    }
+    mDriver->cuMemRelease(mMulticastHandle);
+}
+
 } // namespace tensorrt_llm::runtime
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/lookaheadAlgorithm.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tensorrt_llm::runtime
+{
+
+LookaheadAlgorithm::LookaheadAlgorithm(SizeType windowSize, SizeType ngramSize, SizeType verificationSetSize)
+    : mWindowSize{windowSize}
+    , mNgramSize{ngramSize}
+    , mVerificationSetSize{verificationSetSize}
+    , mMaxNumTokens{getMaxNumTokens(windowSize, ngramSize, verificationSetSize)}
+    , mNumPackedMasks{static_cast<SizeType>(tensorrt_llm::common::divUp(mMaxNumTokens, 32))}
+    , mWindow((ngramSize - 1) * windowSize, 0)
+{
+    TLLM_CHECK_WITH_INFO(windowSize > 0, "Lookahead window size must be positive");
+    TLLM_CHECK_WITH_INFO(ngramSize > 1, "Lookahead n-gram size must be at least 2");
+    TLLM_CHECK_WITH_INFO(verificationSetSize >= 0, "Lookahead verification set size must not be negative");
+}
+
+void LookaheadAlgorithm::setup(VecTokens const& prompt)
+{
+    mPool.clear();
+    mCandidates.clear();
+    auto const promptLen = static_cast<SizeType>(prompt.size());
+    // Any tokens work as initial guesses, tokens of the prompt are more likely to appear again than random ones.
+    for (SizeType i = 0; i < static_cast<SizeType>(mWindow.size()); ++i)
+    {
+        mWindow[i] = promptLen > 0 ? prompt[i % promptLen] : 0;
+    }
+    // Seed the pool with the n-grams of the prompt, which helps when the output copies parts of it.
+    for (SizeType i = 0; i + mNgramSize <= promptLen; ++i)
+    {
+        addNgram(prompt[i], VecTokens(prompt.begin() + i + 1, prompt.begin() + i + mNgramSize));
+    }
+}
+
+SizeType LookaheadAlgorithm::prepare(
+    TokenIdType root, TensorPtr const& inputTokens, TensorPtr const& positionOffsets, TensorPtr const& packedMask)
+{
+    TLLM_CHECK(static_cast<SizeType>(inputTokens->getSize()) >= mMaxNumTokens);
+    TLLM_CHECK(static_cast<SizeType>(positionOffsets->getSize()) >= mMaxNumTokens);
+    TLLM_CHECK(static_cast<SizeType>(packedMask->getSize()) >= mMaxNumTokens * mNumPackedMasks);
+
+    mRoot = root;
+    mCandidates.clear();
+    if (auto it = mPool.find(root); it != mPool.end())
+    {
+        // Most recent n-grams first
+        auto const& ngrams = it->second;
+        auto const numCandidates = std::min(static_cast<SizeType>(ngrams.size()), mVerificationSetSize);
+        mCandidates.assign(ngrams.rbegin(), ngrams.rbegin() + numCandidates);
+    }
+
+    auto const numLevels = mNgramSize - 1;
+    auto const numCandidates = static_cast<SizeType>(mCandidates.size());
+    auto const numTokens = 1 + numLevels * (mWindowSize + numCandidates);
+
+    auto* tokensPtr = bufferCast<TokenIdType>(*inputTokens);
+    auto* offsetsPtr = bufferCast<SizeType>(*positionOffsets);
+    std::memset(packedMask->data(), 0, packedMask->getSizeInBytes());
+
+    tokensPtr[0] = root;
+    offsetsPtr[0] = 0;
+    setMask(packedMask, 0, 0);
+
+    // Lookahead branch, token (l, w) follows root, level 0 up to column w and levels 1 to l of column w
+    for (SizeType l = 0; l < numLevels; ++l)
+    {
+        for (SizeType w = 0; w < mWindowSize; ++w)
+        {
+            auto const row = 1 + l * mWindowSize + w;
+            tokensPtr[row] = window(l, w);
+            offsetsPtr[row] = 1 + l + w;
+            setMask(packedMask, row, 0);
+            for (SizeType c = 0; c <= w; ++c)
+            {
+                setMask(packedMask, row, 1 + c);
+            }
+            for (SizeType ll = 1; ll <= l; ++ll)
+            {
+                setMask(packedMask, row, 1 + ll * mWindowSize + w);
+            }
+        }
+    }
+
+    // Verification branch, every candidate is a causal sequence after the root
+    auto const verificationBegin = 1 + numLevels * mWindowSize;
+    for (SizeType g = 0; g < numCandidates; ++g)
+    {
+        for (SizeType k = 0; k < numLevels; ++k)
+        {
+            auto const row = verificationBegin + g * numLevels + k;
+            tokensPtr[row] = mCandidates[g][k];
+            offsetsPtr[row] = 1 + k;
+            setMask(packedMask, row, 0);
+            for (SizeType kk = 0; kk <= k; ++kk)
+            {
+                setMask(packedMask, row, verificationBegin + g * numLevels + kk);
+            }
+        }
+    }
+    return numTokens;
+}
+
+LookaheadAlgorithm::VecTokens LookaheadAlgorithm::update(
+    ITensor const& outputTokens, std::vector<SizeType>& acceptedIndices)
+{
+    auto const numLevels = mNgramSize - 1;
+    auto const numCandidates = static_cast<SizeType>(mCandidates.size());
+    auto const verificationBegin = 1 + numLevels * mWindowSize;
+    TLLM_CHECK(static_cast<SizeType>(outputTokens.getSize()) >= verificationBegin + numCandidates * numLevels);
+    auto const* outputsPtr = bufferCast<TokenIdType>(outputTokens);
+
+    // Output after token k of candidate g, -1 being the root
+    auto const outputAfter = [&](SizeType g, SizeType k)
+    { return k < 0 ? outputsPtr[0] : outputsPtr[verificationBegin + g * numLevels + k]; };
+
+    SizeType bestCandidate{0};
+    SizeType bestLength{0};
+    for (SizeType g = 0; g < numCandidates; ++g)
+    {
+        SizeType length{0};
+        while (length < numLevels && mCandidates[g][length] == outputAfter(g, length - 1))
+        {
+            ++length;
+        }
+        if (length > bestLength)
+        {
+            bestCandidate = g;
+            bestLength = length;
+        }
+    }
+
+    VecTokens acceptedTokens;
+    acceptedTokens.reserve(bestLength + 1);
+    acceptedIndices.assign(1, 0);
+    for (SizeType k = 0; k < bestLength; ++k)
+    {
+        acceptedTokens.push_back(mCandidates[bestCandidate][k]);
+        acceptedIndices.push_back(verificationBegin + bestCandidate * numLevels + k);
+    }
+    acceptedTokens.push_back(outputAfter(bestCandidate, bestLength - 1));
+
+    // Every column of the window with the output of its last level is a new n-gram, then the window moves one
+    // Jacobi iteration forward.
+    auto const lastLevelBegin = 1 + (numLevels - 1) * mWindowSize;
+    for (SizeType w = 0; w < mWindowSize; ++w)
+    {
+        VecTokens ngram;
+        ngram.reserve(numLevels);
+        for (SizeType l = 1; l < numLevels; ++l)
+        {
+            ngram.push_back(window(l, w));
+        }
+        ngram.push_back(outputsPtr[lastLevelBegin + w]);
+        addNgram(window(0, w), std::move(ngram));
+    }
+    for (SizeType l = 0; l + 1 < numLevels; ++l)
+    {
+        std::copy_n(mWindow.begin() + (l + 1) * mWindowSize, mWindowSize, mWindow.begin() + l * mWindowSize);
+    }
+    std::copy_n(outputsPtr + lastLevelBegin, mWindowSize, mWindow.begin() + (numLevels - 1) * mWindowSize);
+
+    mCandidates.clear();
+    return acceptedTokens;
+}
+
+SizeType LookaheadAlgorithm::getPoolSize() const noexcept
+{
+    SizeType poolSize{0};
+    for (auto const& [key, ngrams] : mPool)
+    {
+        poolSize += static_cast<SizeType>(ngrams.size());
+    }
+    return poolSize;
+}
+
+void LookaheadAlgorithm::setMask(TensorPtr const& packedMask, SizeType row, SizeType col) const
+{
+    bufferCast<SizeType>(*packedMask)[row * mNumPackedMasks + col / 32] |= 1 << (col % 32);
+}
+
+void LookaheadAlgorithm::addNgram(TokenIdType key, VecTokens ngram)
+{
+    if (mVerificationSetSize == 0)
+    {
+        return;
+    }
+    auto& ngrams = mPool[key];
+    if (auto it = std::find(ngrams.begin(), ngrams.end(), ngram); it != ngrams.end())
+    {
+        ngrams.erase(it);
+    }
+    ngrams.push_back(std::move(ngram));
+    if (static_cast<SizeType>(ngrams.size()) > mVerificationSetSize)
+    {
+        ngrams.pop_front();
+    }
+}
+
+} // namespace tensorrt_llm::runtime
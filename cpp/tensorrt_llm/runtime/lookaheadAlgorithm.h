@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Host side state of lookahead (Jacobi) decoding for one sequence.
+//! \details Every step verifies, in the same forward pass, a lookahead branch and a verification branch that
+//! follow the last accepted token (the root):
+//! - The lookahead branch is a window of ngramSize - 1 levels of windowSize guessed tokens. The tokens of column w
+//!   together with level 0 up to column w form a causal sequence after the root. Its greedy outputs form the next
+//!   level, i.e. a Jacobi iteration, and every column yields a new n-gram for the pool.
+//! - The verification branch holds up to verificationSetSize n-grams of the pool starting with the root token.
+//!   The longest one that matches the greedy outputs is accepted, together with the output after its last match.
+//! The inputs use the same position offsets and packed attention mask layout as Medusa, see MedusaModule.
+class LookaheadAlgorithm
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using VecTokens = std::vector<TokenIdType>;
+
+    LookaheadAlgorithm(SizeType windowSize, SizeType ngramSize, SizeType verificationSetSize);
+
+    //! \brief Maximum number of input tokens of a step, including the root.
+    [[nodiscard]] static SizeType getMaxNumTokens(
+        SizeType windowSize, SizeType ngramSize, SizeType verificationSetSize) noexcept
+    {
+        return 1 + (ngramSize - 1) * (windowSize + verificationSetSize);
+    }
+
+    [[nodiscard]] SizeType getMaxNumTokens() const noexcept
+    {
+        return mMaxNumTokens;
+    }
+
+    [[nodiscard]] SizeType getNumPackedMasks() const noexcept
+    {
+        return mNumPackedMasks;
+    }
+
+    //! \brief Reset the state for a new sequence and initialize the lookahead window from its prompt.
+    void setup(VecTokens const& prompt);
+
+    //! \brief Write the inputs of the next step.
+    //! \param root The last accepted token of the sequence.
+    //! \param inputTokens [maxNumTokens] host tensor, first element is root.
+    //! \param positionOffsets [maxNumTokens] host tensor, offsets relative to the root position.
+    //! \param packedMask [maxNumTokens, numPackedMasks] host tensor.
+    //! \return Number of input tokens of the step.
+    SizeType prepare(TokenIdType root, TensorPtr const& inputTokens, TensorPtr const& positionOffsets,
+        TensorPtr const& packedMask);
+
+    //! \brief Verify the step and advance the lookahead window.
+    //! \param outputTokens [numTokens] greedy outputs of the inputs produced by prepare.
+    //! \param acceptedIndices Receives the input indices whose KV cache stays valid, the root first. Can be used as
+    //! packed accepted draft token indices for the parallel decoding KV cache update.
+    //! \return Accepted tokens to append to the sequence, at least one.
+    VecTokens update(ITensor const& outputTokens, std::vector<SizeType>& acceptedIndices);
+
+    //! \brief Number of n-grams in the pool.
+    [[nodiscard]] SizeType getPoolSize() const noexcept;
+
+private:
+    [[nodiscard]] TokenIdType& window(SizeType level, SizeType column)
+    {
+        return mWindow[level * mWindowSize + column];
+    }
+
+    void setMask(TensorPtr const& packedMask, SizeType row, SizeType col) const;
+
+    void addNgram(TokenIdType key, VecTokens ngram);
+
+    SizeType mWindowSize;
+    SizeType mNgramSize;
+    SizeType mVerificationSetSize;
+    SizeType mMaxNumTokens;
+    SizeType mNumPackedMasks;
+    // [ngramSize - 1, windowSize] guessed tokens, level 0 is the oldest Jacobi iteration
+    VecTokens mWindow;
+    // First token -> continuations of ngramSize - 1 tokens, most recent last
+    std::unordered_map<TokenIdType, std::deque<VecTokens>> mPool;
+    // Inputs of the last prepared step
+    TokenIdType mRoot{0};
+    std::vector<VecTokens> mCandidates;
+};
+
+} // namespace tensorrt_llm::runtime
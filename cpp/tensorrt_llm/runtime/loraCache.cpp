@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/loraCache.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/loraUtils.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+LoraCache::LoraCache(LoraCacheConfig config, GptModelConfig const& modelConfig, BufferManager const& manager,
+    BufferManager::CudaStreamPtr transferStream)
+    : mConfig{std::move(config)}
+    , mManager{manager}
+    , mTransferStream{transferStream ? std::move(transferStream) : std::make_shared<CudaStream>()}
+    , mTransferManager{mTransferStream}
+    , mDataType{modelConfig.getDataType()}
+{
+    TLLM_CHECK_WITH_INFO(mConfig.numDevicePages > 0, "LoRA cache needs at least one device page");
+    TLLM_CHECK_WITH_INFO(mConfig.pageSize > 0, "LoRA cache page size must be positive");
+
+    for (auto const& module : modelConfig.getLoraModules())
+    {
+        mModules.emplace(module.value(), module);
+    }
+
+    auto const memoryTag = MemoryCounters::getInstance().getTagId("lora");
+    auto const poolSize = static_cast<std::int64_t>(mConfig.numDevicePages) * mConfig.pageSize;
+    mDevicePool = mManager.gpu(ITensor::makeShape({poolSize}), mDataType, memoryTag);
+
+    // Hand out the pages in ascending order
+    mFreePages.resize(mConfig.numDevicePages);
+    for (SizeType i = 0; i < mConfig.numDevicePages; ++i)
+    {
+        mFreePages[i] = mConfig.numDevicePages - 1 - i;
+    }
+
+    if (mConfig.diskCacheDir)
+    {
+        std::filesystem::create_directories(*mConfig.diskCacheDir);
+    }
+}
+
+LoraCache::~LoraCache()
+{
+    // The files of the disk tier are removed with the entries
+    mTransferStream->synchronize();
+}
+
+SizeType LoraCache::calculatePageSize(GptModelConfig const& modelConfig, SizeType maxAdapterSize)
+{
+    SizeType pageSize = 0;
+    for (auto const& module : modelConfig.getLoraModules())
+    {
+        pageSize = std::max(pageSize, module.flattenedInOutSize(maxAdapterSize));
+    }
+    return pageSize;
+}
+
+void LoraCache::put(TaskIdType taskId, TensorPtr const& weights, TensorPtr const& config)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (has(taskId))
+    {
+        return;
+    }
+    TLLM_CHECK_WITH_INFO(config->getMemoryType() != MemoryType::kGPU, "LoRA config must be in host memory");
+    TLLM_CHECK_WITH_INFO(weights->getDataType() == mDataType, "LoRA weights must have the data type of the model");
+
+    auto weightsShape = weights->getShape();
+    if (weightsShape.nbDims == 3)
+    {
+        weightsShape = ITensor::squeeze(weightsShape, 0);
+    }
+    auto configShape = config->getShape();
+    if (configShape.nbDims == 3)
+    {
+        configShape = ITensor::squeeze(configShape, 0);
+    }
+    TLLM_CHECK_WITH_INFO(weightsShape.nbDims == 2 && configShape.nbDims == 2, "Unexpected LoRA tensor ranks");
+    TLLM_CHECK_WITH_INFO(configShape.d[1] == lora::kLORA_CONFIG_ROW_SIZE,
+        "Expected LoRA config to have a row size of %d", lora::kLORA_CONFIG_ROW_SIZE);
+    TLLM_CHECK_WITH_INFO(weightsShape.d[0] == configShape.d[0], "LoRA weights and config have different row counts");
+
+    auto const numRows = static_cast<SizeType>(configShape.d[0]);
+    auto const rowWidth = static_cast<SizeType>(weightsShape.d[1]);
+
+    TaskEntry entry;
+    entry.config = BufferManager::cpu(configShape, config->getDataType());
+    std::copy_n(bufferCast<SizeType>(*config), entry.config->getSize(), bufferCast<SizeType>(*entry.config));
+    entry.rowWidth = rowWidth;
+
+    // Pack the rows into pages in order, starting a new page when a row does not fit into the current one
+    auto const* configPtr = bufferCast<SizeType>(*entry.config);
+    SizeType offset = 0;
+    for (SizeType row = 0; row < numRows; ++row)
+    {
+        auto const* rowPtr = configPtr + row * lora::kLORA_CONFIG_ROW_SIZE;
+        auto const moduleId = rowPtr[lora::kLORA_CONFIG_MODULE_OFF];
+        auto const adapterSize = rowPtr[lora::kLORA_CONFIG_ADAPTER_SIZE_OFF];
+        auto const it = mModules.find(moduleId);
+        TLLM_CHECK_WITH_INFO(it != mModules.end(), "LoRA module %d is not enabled in the model", moduleId);
+        auto const size = it->second.flattenedInOutSize(adapterSize);
+        TLLM_CHECK_WITH_INFO(size <= rowWidth, "LoRA row %d is wider than the weights", row);
+        TLLM_CHECK_WITH_INFO(size <= mConfig.pageSize,
+            "LoRA row of %d elements does not fit into a page of %d elements", size, mConfig.pageSize);
+
+        if (entry.numPages == 0 || offset + size > mConfig.pageSize)
+        {
+            ++entry.numPages;
+            offset = 0;
+        }
+        entry.rows.push_back(RowPlacement{entry.numPages - 1, offset, size});
+        offset += size;
+    }
+    TLLM_CHECK_WITH_INFO(entry.numPages <= mConfig.numDevicePages,
+        "LoRA task %ld needs %d pages, the device pool only has %d", taskId, entry.numPages, mConfig.numDevicePages);
+
+    auto const memoryTag = MemoryCounters::getInstance().getTagId("lora");
+    TensorPtr hostWeights = BufferManager::pinned(weightsShape, mDataType, memoryTag);
+    mManager.copy(*weights, *hostWeights);
+    mManager.getStream().synchronize();
+
+    mTasks.emplace(taskId, std::move(entry));
+    insertHost(taskId, std::move(hostWeights));
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+bool LoraCache::has(TaskIdType taskId) const
+{
+    return mTasks.find(taskId) != mTasks.end();
+}
+
+bool LoraCache::isResident(TaskIdType taskId) const
+{
+    auto const it = mTasks.find(taskId);
+    return it != mTasks.end() && !it->second.devicePages.empty() && !isLoading(it->second);
+}
+
+bool LoraCache::isLoading(TaskEntry const& entry)
+{
+    if (!entry.loadEvent)
+    {
+        return false;
+    }
+    auto const status = ::cudaEventQuery(entry.loadEvent->get());
+    if (status == cudaErrorNotReady)
+    {
+        return true;
+    }
+    TLLM_CUDA_CHECK(status);
+    return false;
+}
+
+bool LoraCache::prefetch(TaskIdType taskId)
+{
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end(), "LoRA task %ld is not in the cache", taskId);
+    return !it->second.devicePages.empty() || loadToDevice(taskId);
+}
+
+SizeType LoraCache::getNumPages(TaskIdType taskId) const
+{
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end(), "LoRA task %ld is not in the cache", taskId);
+    return it->second.numPages;
+}
+
+bool LoraCache::acquire(TaskIdType taskId, RequestIdType requestId)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (auto const reqIt = mRequestTasks.find(requestId); reqIt != mRequestTasks.end())
+    {
+        TLLM_CHECK_WITH_INFO(reqIt->second == taskId, "Request %lu already holds LoRA task %ld", requestId,
+            reqIt->second);
+        return true;
+    }
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end(), "LoRA task %ld is not in the cache", taskId);
+    auto& entry = it->second;
+
+    if (entry.devicePages.empty() && !loadToDevice(taskId))
+    {
+        TLLM_LOG_DEBUG("LoRA task %ld does not fit into the device pool", taskId);
+        return false;
+    }
+    if (isLoading(entry))
+    {
+        return false;
+    }
+    mDeviceLru.splice(mDeviceLru.begin(), mDeviceLru, entry.deviceLruIt);
+
+    ++entry.numRequests;
+    mRequestTasks.emplace(requestId, taskId);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return true;
+}
+
+void LoraCache::release(RequestIdType requestId)
+{
+    auto const reqIt = mRequestTasks.find(requestId);
+    if (reqIt == mRequestTasks.end())
+    {
+        return;
+    }
+    auto& entry = mTasks.at(reqIt->second);
+    TLLM_CHECK(entry.numRequests > 0);
+    --entry.numRequests;
+    mRequestTasks.erase(reqIt);
+}
+
+LoraCache::TensorPtr LoraCache::getConfig(TaskIdType taskId) const
+{
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end(), "LoRA task %ld is not in the cache", taskId);
+    return it->second.config;
+}
+
+LoraCache::TensorPtr LoraCache::getRowWeights(TaskIdType taskId, SizeType row) const
+{
+    auto const [offset, size] = getRowRange(taskId, row);
+    return ITensor::slice(mDevicePool, offset, size);
+}
+
+TensorSpan LoraCache::getRowWeightsSpan(TaskIdType taskId, SizeType row) const
+{
+    auto const [offset, size] = getRowRange(taskId, row);
+    return TensorSpan{*mDevicePool}.slice(offset, size);
+}
+
+std::pair<std::size_t, std::size_t> LoraCache::getRowRange(TaskIdType taskId, SizeType row) const
+{
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end() && !it->second.devicePages.empty() && !isLoading(it->second),
+        "LoRA task %ld is not resident", taskId);
+    auto const& placement = it->second.rows.at(row);
+    auto const offset
+        = static_cast<std::size_t>(it->second.devicePages[placement.page]) * mConfig.pageSize + placement.offset;
+    return {offset, static_cast<std::size_t>(placement.size)};
+}
+
+void LoraCache::insertHost(TaskIdType taskId, TensorPtr hostWeights)
+{
+    auto const bytes = hostWeights->getSizeInBytes();
+    TLLM_CHECK_WITH_INFO(bytes <= mConfig.hostCacheSize, "LoRA task %ld of %zu bytes exceeds the host cache size",
+        taskId, bytes);
+    evictHost(bytes);
+
+    auto& entry = mTasks.at(taskId);
+    entry.hostWeights = std::move(hostWeights);
+    mHostBytes += bytes;
+    mHostLru.push_front(taskId);
+    entry.hostLruIt = mHostLru.begin();
+}
+
+void LoraCache::evictHost(std::size_t bytes)
+{
+    // Adapters whose copy to the device is in flight are only evicted once all copies have completed
+    for (auto const waitForCopies : {false, true})
+    {
+        if (mHostBytes + bytes <= mConfig.hostCacheSize)
+        {
+            return;
+        }
+        if (waitForCopies)
+        {
+            mTransferStream->synchronize();
+        }
+        for (auto it = mHostLru.end(); mHostBytes + bytes > mConfig.hostCacheSize && it != mHostLru.begin();)
+        {
+            auto const taskId = *--it;
+            auto& entry = mTasks.at(taskId);
+            if (isLoading(entry))
+            {
+                continue;
+            }
+            it = mHostLru.erase(it);
+
+            if (mConfig.diskCacheDir && !entry.diskFile)
+            {
+                // The write keeps the host weights alive until it has completed
+                entry.diskFile = std::make_unique<GdsFile>(getDiskPath(taskId), entry.hostWeights->getSizeInBytes());
+                entry.diskFile->write(entry.hostWeights, 0, *mTransferStream);
+            }
+            mHostBytes -= entry.hostWeights->getSizeInBytes();
+            entry.hostWeights.reset();
+            eraseIfGone(taskId);
+        }
+    }
+}
+
+void LoraCache::loadFromDisk(TaskIdType taskId)
+{
+    auto const& entry = mTasks.at(taskId);
+    TLLM_CHECK_WITH_INFO(entry.diskFile, "LoRA task %ld was evicted from all tiers", taskId);
+
+    // The file holds the padded rows of the host weights, only the used prefix of each row is read
+    auto const elementSize = BufferDataType(mDataType).getSize();
+    auto const rowBytes = static_cast<std::size_t>(entry.rowWidth) * elementSize;
+    std::vector<GdsFile::Extent> extents;
+    extents.reserve(entry.rows.size());
+    for (SizeType row = 0; row < static_cast<SizeType>(entry.rows.size()); ++row)
+    {
+        auto const [offset, size] = getRowRange(taskId, row);
+        extents.push_back(GdsFile::Extent{row * rowBytes, offset * elementSize, size * elementSize});
+    }
+    entry.diskFile->read(mDevicePool, extents, *mTransferStream);
+}
+
+bool LoraCache::loadToDevice(TaskIdType taskId)
+{
+    auto const numPages = mTasks.at(taskId).numPages;
+
+    // Only evict if that frees enough pages, adapters of in-flight requests are never evicted
+    std::vector<TaskIdType> victims;
+    auto numFreePages = getNumFreeDevicePages();
+    for (auto it = mDeviceLru.rbegin(); it != mDeviceLru.rend() && numFreePages < numPages; ++it)
+    {
+        auto const& resident = mTasks.at(*it);
+        if (resident.numRequests == 0 && !isLoading(resident))
+        {
+            victims.push_back(*it);
+            numFreePages += resident.numPages;
+        }
+    }
+    if (numFreePages < numPages)
+    {
+        return false;
+    }
+    for (auto const victimId : victims)
+    {
+        evictDevice(victimId);
+    }
+    if (!victims.empty())
+    {
+        // The last iteration of a released request may still read the pages on the compute stream
+        CudaEvent pagesFree;
+        mManager.getStream().record(pagesFree);
+        mTransferStream->wait(pagesFree);
+    }
+
+    auto& entry = mTasks.at(taskId);
+    entry.loadEvent.reset();
+    entry.devicePages.reserve(numPages);
+    for (SizeType i = 0; i < numPages; ++i)
+    {
+        entry.devicePages.push_back(mFreePages.back());
+        mFreePages.pop_back();
+    }
+    if (entry.hostWeights)
+    {
+        mHostLru.splice(mHostLru.begin(), mHostLru, entry.hostLruIt);
+        for (SizeType row = 0; row < static_cast<SizeType>(entry.rows.size()); ++row)
+        {
+            TensorPtr hostRow = ITensor::slice(entry.hostWeights, row, 1);
+            hostRow->squeeze(0);
+            auto const src = ITensor::slice(hostRow, 0, entry.rows[row].size);
+            auto const dst = getRowWeights(taskId, row);
+            mTransferManager.copy(*src, *dst);
+        }
+    }
+    else
+    {
+        // Straight from the disk tier, without taking room in the host tier
+        loadFromDisk(taskId);
+    }
+    entry.loadEvent = std::make_unique<CudaEvent>();
+    mTransferStream->record(*entry.loadEvent);
+
+    mDeviceLru.push_front(taskId);
+    entry.deviceLruIt = mDeviceLru.begin();
+    return true;
+}
+
+void LoraCache::evictDevice(TaskIdType taskId)
+{
+    auto& entry = mTasks.at(taskId);
+    TLLM_CHECK(entry.numRequests == 0);
+    mFreePages.insert(mFreePages.end(), entry.devicePages.rbegin(), entry.devicePages.rend());
+    entry.devicePages.clear();
+    mDeviceLru.erase(entry.deviceLruIt);
+    eraseIfGone(taskId);
+}
+
+void LoraCache::eraseIfGone(TaskIdType taskId)
+{
+    auto const it = mTasks.find(taskId);
+    if (it != mTasks.end() && !it->second.hostWeights && !it->second.diskFile && it->second.devicePages.empty())
+    {
+        TLLM_LOG_DEBUG("LoRA task %ld dropped from the cache", taskId);
+        mTasks.erase(it);
+    }
+}
+
+std::filesystem::path LoraCache::getDiskPath(TaskIdType taskId) const
+{
+    return *mConfig.diskCacheDir / ("lora_" + std::to_string(taskId) + ".bin");
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/gdsFile.h"
+#include "tensorrt_llm/runtime/gptModelConfig.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/loraModule.h"
+#include "tensorrt_llm/runtime/tensorSpan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+struct LoraCacheConfig
+{
+    // Pages of the device pool.
+    SizeType numDevicePages;
+    // Elements of a page. A module / layer row of an adapter is never split across pages, so a page must hold the
+    // largest row, see LoraCache::calculatePageSize.
+    SizeType pageSize;
+    // Bytes of the pinned host tier.
+    std::size_t hostCacheSize;
+    // Directory of the disk tier, ideally on a local NVMe SSD. Without it, adapters evicted from the host tier are
+    // dropped once they leave the device as well and have to be put again.
+    std::optional<std::filesystem::path> diskCacheDir{std::nullopt};
+};
+
+/**
+ * \brief Cache of LoRA adapters over a paged device pool, a pinned host tier and an optional disk tier.
+ * \details Adapters are put into the host tier, formatted as for LoraManager::addTask. A request acquires its
+ *          adapter before it is scheduled, which pins the device pages of the adapter until the request releases
+ *          it. When the pool is full, the least recently used adapters that no in-flight request holds are evicted
+ *          from the device. The host tier evicts its least recently used adapters to the disk tier when it runs out
+ *          of bytes. Adapters that are only on disk are read straight into their device pages, with GPUDirect
+ *          Storage if available, see GdsFile.
+ *          Copies to the device and writes to disk run on a transfer stream and never block the caller, see prefetch.
+ *          Not thread-safe.
+ */
+class LoraCache
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using TaskIdType = std::int64_t;
+    using RequestIdType = std::uint64_t;
+
+    //! \param transferStream Stream of the host to device copies, a new stream if not set.
+    LoraCache(LoraCacheConfig config, GptModelConfig const& modelConfig, BufferManager const& manager,
+        BufferManager::CudaStreamPtr transferStream = nullptr);
+    ~LoraCache();
+
+    LoraCache(LoraCache const&) = delete;
+    LoraCache& operator=(LoraCache const&) = delete;
+
+    //! \brief Elements of the largest row of an adapter with maxAdapterSize, i.e. the smallest valid page size.
+    [[nodiscard]] static SizeType calculatePageSize(GptModelConfig const& modelConfig, SizeType maxAdapterSize);
+
+    /**
+     * \brief Add an adapter to the host tier.
+     * \param[in] weights: LoRA weights [num_modules_layers, D x Hi + Ho x D], formatted with
+     *                     LoraManager::formatTaskTensors. A leading dimension of 1 is ignored.
+     * \param[in] config: LoRA config [num_modules_layers, 3] in host memory, see LoraManager::addTask.
+     */
+    void put(TaskIdType taskId, TensorPtr const& weights, TensorPtr const& config);
+
+    //! \brief Whether the adapter is in any tier.
+    [[nodiscard]] bool has(TaskIdType taskId) const;
+
+    //! \brief Whether the adapter is in the device pool and its copy has completed.
+    [[nodiscard]] bool isResident(TaskIdType taskId) const;
+
+    //! \brief Pages the adapter takes in the device pool.
+    [[nodiscard]] SizeType getNumPages(TaskIdType taskId) const;
+
+    [[nodiscard]] SizeType getNumFreeDevicePages() const noexcept
+    {
+        return static_cast<SizeType>(mFreePages.size());
+    }
+
+    /**
+     * \brief Start copying the adapter into the device pool without waiting for the copy, e.g. when a request is
+     *        queued. Adapters are not evicted while their copy is in flight.
+     * \return false if the pages cannot be freed because the adapters of in-flight requests take them.
+     */
+    bool prefetch(TaskIdType taskId);
+
+    /**
+     * \brief Pin the adapter of a request until the request releases it.
+     * \details Acquiring again for the same request is a no-op. Never waits for a copy, an adapter that is not
+     *          resident yet is prefetched and the request can be acquired again in a later iteration.
+     * \return false if the adapter is not resident yet.
+     */
+    [[nodiscard]] bool acquire(TaskIdType taskId, RequestIdType requestId);
+
+    //! \brief Unpin the adapter of a finished request. The adapter stays resident until it is evicted.
+    void release(RequestIdType requestId);
+
+    //! \brief Config of the adapter [num_modules_layers, 3] on the host.
+    [[nodiscard]] TensorPtr getConfig(TaskIdType taskId) const;
+
+    //! \brief Device view of the in and out weights of a row of a resident adapter.
+    [[nodiscard]] TensorPtr getRowWeights(TaskIdType taskId, SizeType row) const;
+
+    //! \brief Same as getRowWeights without allocating a view, valid until the adapter is evicted.
+    [[nodiscard]] TensorSpan getRowWeightsSpan(TaskIdType taskId, SizeType row) const;
+
+private:
+    struct RowPlacement
+    {
+        SizeType page;
+        SizeType offset;
+        SizeType size;
+    };
+
+    struct TaskEntry
+    {
+        TensorPtr config;
+        // Pages are relative to the adapter, i.e. indices into devicePages
+        std::vector<RowPlacement> rows;
+        SizeType numPages{0};
+        SizeType rowWidth{0};
+        // Pinned copy of the weights, null when the adapter is not in the host tier
+        TensorPtr hostWeights;
+        // File of the disk tier, null when the adapter is not on disk
+        std::unique_ptr<GdsFile> diskFile;
+        // Empty when the adapter is not resident
+        std::vector<SizeType> devicePages;
+        SizeType numRequests{0};
+        // Recorded on the transfer stream after the last copy to the device
+        std::unique_ptr<CudaEvent> loadEvent;
+        std::list<TaskIdType>::iterator hostLruIt;
+        std::list<TaskIdType>::iterator deviceLruIt;
+    };
+
+    void insertHost(TaskIdType taskId, TensorPtr hostWeights);
+    //! \brief Evict the least recently used host adapters until bytes more fit into the host tier.
+    void evictHost(std::size_t bytes);
+    //! \brief Read the rows from the disk tier into the device pages of the adapter.
+    void loadFromDisk(TaskIdType taskId);
+    [[nodiscard]] bool loadToDevice(TaskIdType taskId);
+    //! \brief Whether the copy of the adapter to the device is still in flight.
+    [[nodiscard]] static bool isLoading(TaskEntry const& entry);
+    void evictDevice(TaskIdType taskId);
+    //! \brief Drop the entry if no tier holds the adapter anymore.
+    void eraseIfGone(TaskIdType taskId);
+    [[nodiscard]] std::filesystem::path getDiskPath(TaskIdType taskId) const;
+    //! \brief Offset and size of a row of a resident adapter in the device pool.
+    [[nodiscard]] std::pair<std::size_t, std::size_t> getRowRange(TaskIdType taskId, SizeType row) const;
+
+    LoraCacheConfig mConfig;
+    BufferManager const& mManager;
+    BufferManager::CudaStreamPtr mTransferStream;
+    BufferManager mTransferManager;
+    nvinfer1::DataType mDataType;
+    std::unordered_map<SizeType, LoraModule> mModules;
+
+    TensorPtr mDevicePool;
+    std::vector<SizeType> mFreePages;
+    std::size_t mHostBytes{0};
+
+    std::unordered_map<TaskIdType, TaskEntry> mTasks;
+    std::unordered_map<RequestIdType, TaskIdType> mRequestTasks;
+    // Most recently used first
+    std::list<TaskIdType> mHostLru;
+    std::list<TaskIdType> mDeviceLru;
+};
+
+} // namespace tensorrt_llm::runtime
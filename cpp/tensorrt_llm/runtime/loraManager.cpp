@@ -24,13 +24,23 @@
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/loraUtils.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
+#include "tensorrt_llm/runtime/tensorSpan.h"
 #include "tensorrt_llm/runtime/utils/sessionUtils.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 #include <NvInferRuntimeBase.h>
 
+#include <algorithm>
+
 namespace tensorrt_llm::runtime
 {
+namespace
+{
+// Requests per stolen chunk, a request fills a few hundred pointers at most
+constexpr SizeType kLoraFillGrainSize = 4;
+} // namespace
+
 void LoraManager::addTask(TaskIdType reqId, TensorPtr weights, TensorPtr config)
 {
     if (mLoras.find(reqId) != mLoras.end())
@@ -67,7 +77,7 @@ void LoraManager::create(
 
 void LoraManager::fillInputTensors(TensorPtr weightsPtrs, TensorPtr adapterSizes, ReqIdsVec const& reqIds,
     std::vector<SizeType> const& reqBeamWidth, std::vector<bool> const& loraEnabled, SizeType numContextRequests,
-    GptModelConfig const& modelConfig, WorldConfig const& worldConfig)
+    GptModelConfig const& modelConfig, WorldConfig const& worldConfig, WorkStealingPool* pool)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     auto localNbLayers = modelConfig.getNbLayers(worldConfig.getPipelineParallelism());
@@ -77,10 +87,34 @@ void LoraManager::fillInputTensors(TensorPtr weightsPtrs, TensorPtr adapterSizes
     auto tpRank = worldConfig.getTensorParallelRank();
 
     auto batchSize = static_cast<SizeType>(reqIds.size());
+    if (pool != nullptr && !mMergedTask)
+    {
+        // Every request writes its own batch index and only reads the tasks
+        pool->parallelFor(batchSize,
+            [&](SizeType bid, SizeType)
+            {
+                if (loraEnabled[bid])
+                {
+                    fillInputTensors(weightsPtrs, adapterSizes, bid, reqIds[bid], reqBeamWidth[bid], firstLayerId,
+                        lastLayerId, tpSize, tpRank);
+                }
+            },
+            kLoraFillGrainSize);
+        TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+        return;
+    }
     for (SizeType bid = 0; bid < batchSize; ++bid)
     {
         if (!loraEnabled[bid])
+        {
+            if (mMergedTask)
+            {
+                // The engine weights hold an adapter that requests without LoRA must cancel
+                fillCorrections(weightsPtrs, adapterSizes, bid, std::nullopt, reqBeamWidth[bid], firstLayerId,
+                    lastLayerId, tpSize, tpRank);
+            }
             continue;
+        }
 
         fillInputTensors(
             weightsPtrs, adapterSizes, bid, reqIds[bid], reqBeamWidth[bid], firstLayerId, lastLayerId, tpSize, tpRank);
@@ -93,10 +127,7 @@ void LoraManager::fillInputTensors(TensorPtr weightsPtrs, TensorPtr adapterSizes
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    auto weightsPointersPtr = bufferCast<int64_t>(*weightsPtrs);
-    auto adapterSizesPtr = bufferCast<int32_t>(*adapterSizes);
-
-    auto [reqWeights, reqKeys] = getTask(taskId);
+    auto const [reqWeights, reqKeys] = lookupTask(taskId);
     auto reqKeysPtr = bufferCast<SizeType>(*reqKeys);
     auto numRows = reqKeys->getShape().d[0];
     if (reqKeys->getShape().d[1] != lora::kLORA_CONFIG_ROW_SIZE)
@@ -104,6 +135,7 @@ void LoraManager::fillInputTensors(TensorPtr weightsPtrs, TensorPtr adapterSizes
         throw std::runtime_error(
             "Expected request lora_keys tor have row size of " + std::to_string(lora::kLORA_CONFIG_ROW_SIZE));
     }
+    auto const hasMergedRows = mMergedTask.has_value() && !mMergedAdapter.empty();
     for (SizeType row = 0; row < numRows; ++row)
     {
         auto layerIdx = reqKeysPtr[row * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_LAYER_OFF];
@@ -113,65 +145,280 @@ void LoraManager::fillInputTensors(TensorPtr weightsPtrs, TensorPtr adapterSizes
         auto moduleId = reqKeysPtr[row * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_MODULE_OFF];
         auto adapterSize = reqKeysPtr[row * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_ADAPTER_SIZE_OFF];
 
-        auto modOff = mModuleOffest.at(moduleId);
-        auto& module = mModuleIdToModule.at(moduleId);
-
-        auto inDim = (module.inDimFirst() && module.inTpSplitDim() == 0)
-                || (!module.inDimFirst() && module.inTpSplitDim() == 1)
-            ? module.inDim() / tpSize
-            : module.inDim();
-        auto inTpSize = module.inTpSplitDim() == -1 ? 1 : tpSize;
-        auto inTpRank = module.inTpSplitDim() == -1 ? 0 : tpRank;
-
-        auto outDim = (module.outDimFirst() && module.outTpSplitDim() == 0)
-                || (!module.outDimFirst() && module.outTpSplitDim() == 1)
-            ? module.outDim() / tpSize
-            : module.outDim();
-        auto outTpSize = module.outTpSplitDim() == -1 ? 1 : tpSize;
-        auto outTpRank = module.outTpSplitDim() == -1 ? 0 : tpRank;
-
-        auto inWeightsShape = module.inDimFirst() ? ITensor::makeShape({inTpSize, inDim, adapterSize})
-                                                  : ITensor::makeShape({inTpSize, adapterSize, inDim});
-        auto outWeightsShape = module.outDimFirst() ? ITensor::makeShape({outTpSize, outDim, adapterSize})
-                                                    : ITensor::makeShape({outTpSize, adapterSize, outDim});
-
-        TensorPtr reqRowWeights = ITensor::slice(reqWeights, row, 1);
-        reqRowWeights->squeeze(0);
-        TensorPtr allInWeights = ITensor::view(reqRowWeights, inWeightsShape);
-
-        TensorPtr allOutWeights
-            = ITensor::slice(reqRowWeights, allInWeights->getSize(), ITensor::volume(outWeightsShape));
-        allOutWeights->reshape(outWeightsShape);
-
-        auto inWeightsPtr = reinterpret_cast<int64_t>(ITensor::slice(allInWeights, inTpRank, 1)->data());
-        auto outWeightsPtr = reinterpret_cast<int64_t>(ITensor::slice(allOutWeights, outTpRank, 1)->data());
-
-        auto weightsPointersPtrOffset = common::flat_index4(modOff, layerIdx - firstLayerId, batchIdx, 0,
-            weightsPtrs->getShape().d[1], weightsPtrs->getShape().d[2], weightsPtrs->getShape().d[3]);
-        auto adapterSizesPtrOffset = common::flat_index3(
-            modOff, layerIdx - firstLayerId, batchIdx, adapterSizes->getShape().d[1], adapterSizes->getShape().d[2]);
-
-        if (static_cast<SizeType>(weightsPtrs->getSize())
-            < weightsPointersPtrOffset + lora::kLORA_NUM_WEIGHTS_POINTERS * beamWidth)
+        if (hasMergedRows && mMergedAdapter.find({moduleId, layerIdx}) != mMergedAdapter.end())
         {
-            throw std::runtime_error("Coding error attempting to write lora ptrs outside range of buffer");
+            // In the engine weights for the merged task, in the corrections for the others
+            continue;
         }
-        if (static_cast<SizeType>(adapterSizes->getSize()) < adapterSizesPtrOffset + beamWidth)
+
+        // Runs for every row of every request at every step, so slice spans instead of allocating views
+        auto const [inWeights, outWeights]
+            = splitRowWeights(getRowWeights(reqWeights, taskId, row), moduleId, adapterSize, tpSize, tpRank);
+        writeRowPointers(weightsPtrs, adapterSizes, mModuleOffest.at(moduleId), layerIdx - firstLayerId, batchIdx,
+            beamWidth, inWeights.data(), outWeights.data(), adapterSize);
+    }
+    if (hasMergedRows && taskId != *mMergedTask)
+    {
+        fillCorrections(
+            weightsPtrs, adapterSizes, batchIdx, taskId, beamWidth, firstLayerId, lastLayerId, tpSize, tpRank);
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+std::pair<LoraManager::TensorPtr, LoraManager::TensorPtr> LoraManager::lookupTask(TaskIdType taskId) const
+{
+    if (mLoraCache && mLoras.find(taskId) == mLoras.end())
+    {
+        return {nullptr, mLoraCache->getConfig(taskId)};
+    }
+    auto const& [weights, config] = mLoras.at(taskId);
+    return {weights, config};
+}
+
+TensorSpan LoraManager::getRowWeights(TensorPtr const& reqWeights, TaskIdType taskId, SizeType row) const
+{
+    return reqWeights ? TensorSpan{*reqWeights}[row] : mLoraCache->getRowWeightsSpan(taskId, row);
+}
+
+std::pair<TensorSpan, TensorSpan> LoraManager::splitRowWeights(TensorSpan const& rowWeights, SizeType moduleId,
+    SizeType adapterSize, SizeType tpSize, SizeType tpRank) const
+{
+    auto& module = mModuleIdToModule.at(moduleId);
+
+    auto inDim = (module.inDimFirst() && module.inTpSplitDim() == 0)
+            || (!module.inDimFirst() && module.inTpSplitDim() == 1)
+        ? module.inDim() / tpSize
+        : module.inDim();
+    auto inTpSize = module.inTpSplitDim() == -1 ? 1 : tpSize;
+    auto inTpRank = module.inTpSplitDim() == -1 ? 0 : tpRank;
+
+    auto outDim = (module.outDimFirst() && module.outTpSplitDim() == 0)
+            || (!module.outDimFirst() && module.outTpSplitDim() == 1)
+        ? module.outDim() / tpSize
+        : module.outDim();
+    auto outTpSize = module.outTpSplitDim() == -1 ? 1 : tpSize;
+    auto outTpRank = module.outTpSplitDim() == -1 ? 0 : tpRank;
+
+    auto inWeightsShape = module.inDimFirst() ? ITensor::makeShape({inTpSize, inDim, adapterSize})
+                                              : ITensor::makeShape({inTpSize, adapterSize, inDim});
+    auto outWeightsShape = module.outDimFirst() ? ITensor::makeShape({outTpSize, outDim, adapterSize})
+                                                : ITensor::makeShape({outTpSize, adapterSize, outDim});
+
+    auto const allInWeights = rowWeights.view(inWeightsShape);
+    auto const allOutWeights
+        = rowWeights.slice(allInWeights.getSize(), ITensor::volume(outWeightsShape)).view(outWeightsShape);
+    return {allInWeights[inTpRank], allOutWeights[outTpRank]};
+}
+
+void LoraManager::writeRowPointers(TensorPtr const& weightsPtrs, TensorPtr const& adapterSizes, SizeType modOff,
+    SizeType localLayerIdx, SizeType batchIdx, SizeType beamWidth, void const* inWeights, void const* outWeights,
+    SizeType adapterSize) const
+{
+    auto weightsPointersPtr = bufferCast<int64_t>(*weightsPtrs);
+    auto adapterSizesPtr = bufferCast<int32_t>(*adapterSizes);
+
+    auto inWeightsPtr = reinterpret_cast<int64_t>(inWeights);
+    auto outWeightsPtr = reinterpret_cast<int64_t>(outWeights);
+
+    auto weightsPointersPtrOffset = common::flat_index4(modOff, localLayerIdx, batchIdx, 0,
+        weightsPtrs->getShape().d[1], weightsPtrs->getShape().d[2], weightsPtrs->getShape().d[3]);
+    auto adapterSizesPtrOffset = common::flat_index3(
+        modOff, localLayerIdx, batchIdx, adapterSizes->getShape().d[1], adapterSizes->getShape().d[2]);
+
+    if (static_cast<SizeType>(weightsPtrs->getSize())
+        < weightsPointersPtrOffset + lora::kLORA_NUM_WEIGHTS_POINTERS * beamWidth)
+    {
+        throw std::runtime_error("Coding error attempting to write lora ptrs outside range of buffer");
+    }
+    if (static_cast<SizeType>(adapterSizes->getSize()) < adapterSizesPtrOffset + beamWidth)
+    {
+        throw std::runtime_error("Coding error attempting to write lora low ranks outside range of buffer");
+    }
+
+    auto const writeWeightsPtr = weightsPointersPtr + weightsPointersPtrOffset;
+    auto const writeAdapterSizesPtr = adapterSizesPtr + adapterSizesPtrOffset;
+
+    SizeType weightsPtrsOff = 0;
+    for (SizeType beamIdx = 0; beamIdx < beamWidth; ++beamIdx)
+    {
+        writeWeightsPtr[weightsPtrsOff++] = inWeightsPtr;
+        writeWeightsPtr[weightsPtrsOff++] = outWeightsPtr;
+    }
+    std::fill_n(writeAdapterSizesPtr, beamWidth, adapterSize);
+}
+
+void LoraManager::fillCorrections(TensorPtr const& weightsPtrs, TensorPtr const& adapterSizes, SizeType batchIdx,
+    std::optional<TaskIdType> taskId, SizeType beamWidth, SizeType firstLayerId, SizeType lastLayerId,
+    SizeType tpSize, SizeType tpRank)
+{
+    auto& corrections = taskId ? mCorrections[*taskId] : mBaseCorrections;
+    if (corrections.empty())
+    {
+        TLLM_LOG_DEBUG("Building the corrections of the merged LoRA task for task %s",
+            taskId ? std::to_string(*taskId).c_str() : "none");
+        TensorPtr reqWeights;
+        TensorPtr reqKeys;
+        if (taskId)
+        {
+            std::tie(reqWeights, reqKeys) = lookupTask(*taskId);
+        }
+        auto const& stream = mCorrectionManager->getStream();
+        auto const memoryTag = MemoryCounters::getInstance().getTagId("lora");
+        for (auto const& [key, merged] : mMergedAdapter)
+        {
+            auto const row = reqKeys ? lora::findConfigRow(*reqKeys, key.first, key.second) : -1;
+            ITensor::UniquePtr ownInWeights;
+            ITensor::UniquePtr ownOutWeights;
+            SizeType ownAdapterSize = 0;
+            if (row >= 0)
+            {
+                ownAdapterSize = bufferCast<SizeType>(
+                    *reqKeys)[row * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_ADAPTER_SIZE_OFF];
+                auto const [inWeights, outWeights] = splitRowWeights(
+                    getRowWeights(reqWeights, *taskId, row), key.first, ownAdapterSize, tpSize, tpRank);
+                ownInWeights = ITensor::wrap(inWeights.data(), inWeights.getDataType(), inWeights.getShape());
+                ownOutWeights = ITensor::wrap(outWeights.data(), outWeights.getDataType(), outWeights.getShape());
+            }
+
+            // (B_t A_t - B_m A_m) = [B_m | B_t] [-A_m ; A_t], negating one factor of the merged adapter is enough
+            auto const adapterSize = merged.adapterSize + ownAdapterSize;
+            auto const inDim = merged.inWeights->getShape().d[1];
+            auto const outDim = merged.outWeights->getShape().d[0];
+            auto const dataType = merged.inWeights->getDataType();
+            RankAdapter correction;
+            correction.inWeights
+                = mCorrectionManager->gpu(ITensor::makeShape({adapterSize, inDim}), dataType, memoryTag);
+            correction.outWeights
+                = mCorrectionManager->gpu(ITensor::makeShape({outDim, adapterSize}), dataType, memoryTag);
+            correction.adapterSize = adapterSize;
+            kernels::concatScaled2D(*correction.inWeights, *merged.inWeights, -1.f, ownInWeights.get(), 0, stream);
+            kernels::concatScaled2D(*correction.outWeights, *merged.outWeights, 1.f, ownOutWeights.get(), 1, stream);
+            corrections.emplace(key, std::move(correction));
+        }
+    }
+
+    for (auto const& [key, correction] : corrections)
+    {
+        auto const& [moduleId, layerIdx] = key;
+        if (layerIdx < firstLayerId || layerIdx >= lastLayerId)
+            continue;
+
+        writeRowPointers(weightsPtrs, adapterSizes, mModuleOffest.at(moduleId), layerIdx - firstLayerId, batchIdx,
+            beamWidth, correction.inWeights->data(), correction.outWeights->data(), correction.adapterSize);
+    }
+}
+
+LoraManager::TensorMap LoraManager::getBaseWeights() const
+{
+    TensorMap weights;
+    for (auto const& target : mMergeTargets)
+    {
+        weights.emplace(target.weightName, target.baseWeights);
+    }
+    return weights;
+}
+
+std::optional<LoraManager::TaskIdType> LoraManager::findDominantTask(
+    ReqIdsVec const& taskIds, std::vector<bool> const& loraEnabled, float minFraction)
+{
+    std::unordered_map<TaskIdType, SizeType> counts;
+    for (std::size_t bid = 0; bid < taskIds.size(); ++bid)
+    {
+        if (loraEnabled[bid])
+        {
+            ++counts[static_cast<TaskIdType>(taskIds[bid])];
+        }
+    }
+    auto const dominant = std::max_element(
+        counts.begin(), counts.end(), [](auto const& lhs, auto const& rhs) { return lhs.second < rhs.second; });
+    if (dominant == counts.end()
+        || static_cast<float>(dominant->second) < minFraction * static_cast<float>(taskIds.size()))
+    {
+        return std::nullopt;
+    }
+    return dominant->first;
+}
+
+LoraManager::TensorMap LoraManager::mergeTask(
+    TaskIdType taskId, WorldConfig const& worldConfig, BufferManager const& manager) const
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(!mMergeTargets.empty(), "No merge targets, see setMergeTargets");
+    auto const [reqWeights, reqKeys] = lookupTask(taskId);
+    auto const tpSize = worldConfig.getTensorParallelism();
+    auto const tpRank = worldConfig.getTensorParallelRank();
+    auto const memoryTag = MemoryCounters::getInstance().getTagId("lora");
+    auto const& stream = manager.getStream();
+
+    TensorMap mergedWeights;
+    for (auto const& target : mMergeTargets)
+    {
+        auto& merged = mergedWeights[target.weightName];
+        if (!merged)
+        {
+            merged = manager.gpu(target.baseWeights->getShape(), target.baseWeights->getDataType(), memoryTag);
+            manager.copy(*target.baseWeights, *merged);
+        }
+        auto const row = lora::findConfigRow(*reqKeys, target.moduleId, target.layerIdx);
+        if (row < 0)
         {
-            throw std::runtime_error("Coding error attempting to write lora low ranks outside range of buffer");
+            continue;
         }
+        auto const adapterSize
+            = bufferCast<SizeType>(*reqKeys)[row * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_ADAPTER_SIZE_OFF];
+        auto const [inWeights, outWeights] = splitRowWeights(
+            getRowWeights(reqWeights, taskId, row), target.moduleId, adapterSize, tpSize, tpRank);
+        TLLM_CHECK_WITH_INFO(inWeights.getMemoryType() == MemoryType::kGPU, "LoRA weights must be on the device");
+        auto const outDim = outWeights.getShape().d[0];
+        auto mergedRows = ITensor::slice(merged, target.rowOffset, outDim);
+        kernels::mergeLoraWeights(*mergedRows, *mergedRows,
+            *ITensor::wrap(inWeights.data(), inWeights.getDataType(), inWeights.getShape()),
+            *ITensor::wrap(outWeights.data(), outWeights.getDataType(), outWeights.getShape()), stream);
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return mergedWeights;
+}
 
-        auto const writeWeightsPtr = weightsPointersPtr + weightsPointersPtrOffset;
-        auto const writeAdapterSizesPtr = adapterSizesPtr + adapterSizesPtrOffset;
+void LoraManager::setMergedTask(
+    std::optional<TaskIdType> taskId, WorldConfig const& worldConfig, BufferManager const& manager)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    mMergedTask = taskId;
+    mMergedAdapter.clear();
+    mCorrections.clear();
+    mBaseCorrections.clear();
+    mCorrectionManager = std::make_unique<BufferManager>(manager);
+    if (!taskId)
+    {
+        TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+        return;
+    }
 
-        SizeType weightsPtrsOff = 0;
-        for (SizeType beamIdx = 0; beamIdx < beamWidth; ++beamIdx)
+    // Keep a copy of the merged rows, so that the corrections do not depend on the task staying in the cache
+    auto const [reqWeights, reqKeys] = lookupTask(*taskId);
+    auto const tpSize = worldConfig.getTensorParallelism();
+    auto const tpRank = worldConfig.getTensorParallelRank();
+    for (auto const& target : mMergeTargets)
+    {
+        ModuleLayer const key{target.moduleId, target.layerIdx};
+        auto const row = lora::findConfigRow(*reqKeys, target.moduleId, target.layerIdx);
+        if (row < 0 || mMergedAdapter.find(key) != mMergedAdapter.end())
         {
-            writeWeightsPtr[weightsPtrsOff++] = inWeightsPtr;
-            writeWeightsPtr[weightsPtrsOff++] = outWeightsPtr;
+            continue;
         }
-        std::fill_n(writeAdapterSizesPtr, beamWidth, adapterSize);
+        auto const adapterSize
+            = bufferCast<SizeType>(*reqKeys)[row * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_ADAPTER_SIZE_OFF];
+        auto const [inWeights, outWeights] = splitRowWeights(
+            getRowWeights(reqWeights, *taskId, row), target.moduleId, adapterSize, tpSize, tpRank);
+        RankAdapter merged;
+        merged.inWeights = manager.copyFrom(
+            *ITensor::wrap(inWeights.data(), inWeights.getDataType(), inWeights.getShape()), MemoryType::kGPU);
+        merged.outWeights = manager.copyFrom(
+            *ITensor::wrap(outWeights.data(), outWeights.getDataType(), outWeights.getShape()), MemoryType::kGPU);
+        merged.adapterSize = adapterSize;
+        mMergedAdapter.emplace(key, std::move(merged));
     }
+    TLLM_LOG_DEBUG("Merged LoRA task %ld into %zu module layers", *taskId, mMergedAdapter.size());
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -221,11 +468,12 @@ void LoraManager::formatTaskTensors(LoraWeightsTensorPtr weights, LoraConfigTens
     config->squeeze(0);
 
     auto tpSize = worldConfig.getTensorParallelism();
+    auto const memoryTag = MemoryCounters::getInstance().getTagId("lora");
 
     SizeType nbRows = config->getShape().d[0];
     for (SizeType row = 0; row < nbRows; ++row)
     {
-        auto rowPtr = bufferCast<SizeType>(*ITensor::slice(config, row, 1));
+        auto rowPtr = TensorSpan{*config}[row].data<SizeType>();
         auto modId = rowPtr[lora::kLORA_CONFIG_MODULE_OFF];
         auto adapterSize = rowPtr[lora::kLORA_CONFIG_ADAPTER_SIZE_OFF];
 
@@ -238,7 +486,7 @@ void LoraManager::formatTaskTensors(LoraWeightsTensorPtr weights, LoraConfigTens
             inWeights->reshape(ITensor::makeShape({adapterSize, module.inDim()}));
             if (mWorkspace->getSize() < inWeights->getSize())
             {
-                mWorkspace = manager.gpu(inWeights->getShape(), inWeights->getDataType());
+                mWorkspace = manager.gpu(inWeights->getShape(), inWeights->getDataType(), memoryTag);
             }
             mWorkspace->reshape(ITensor::makeShape({tpSize, adapterSize, module.inDim() / tpSize}));
             kernels::splitTransposed(*mWorkspace, *inWeights, tpSize, manager.getStream());
@@ -254,7 +502,7 @@ void LoraManager::formatTaskTensors(LoraWeightsTensorPtr weights, LoraConfigTens
             weightsOut->reshape(ITensor::makeShape({module.outDim(), adapterSize}));
             if (mWorkspace->getSize() < weightsOut->getSize())
             {
-                mWorkspace = manager.gpu(weightsOut->getShape(), weightsOut->getDataType());
+                mWorkspace = manager.gpu(weightsOut->getShape(), weightsOut->getDataType(), memoryTag);
             }
             mWorkspace->reshape(weightsOut->getShape());
             kernels::splitTransposed(*mWorkspace, *weightsOut, tpSize, manager.getStream());
@@ -267,6 +515,7 @@ void LoraManager::formatTaskTensors(LoraWeightsTensorPtr weights, LoraConfigTens
 void LoraManager::reset()
 {
     mLoras.clear();
+    mCorrections.clear();
 }
 
 } // namespace tensorrt_llm::runtime
@@ -19,9 +19,16 @@
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/gptModelConfig.h"
+#include "tensorrt_llm/runtime/loraCache.h"
 #include "tensorrt_llm/runtime/loraModule.h"
+#include "tensorrt_llm/runtime/tensorSpan.h"
+#include "tensorrt_llm/runtime/workStealingPool.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
+#include <map>
+#include <memory>
+#include <optional>
 #include <unordered_map>
+#include <utility>
 
 namespace tensorrt_llm::runtime
 {
@@ -41,6 +48,21 @@ public:
     using LoraReqTensors = std::tuple<LoraWeightsTensorPtr, LoraConfigTensorPtr>;
     using TaskIdType = std::int64_t;
 
+    /**
+     * \brief A weight of the engine that an adapter can be merged into, see mergeTask.
+     * \details baseWeights is the whole weight [rows, inDim] of this rank on the device, refittable as weightName.
+     *          The module writes rows [rowOffset, rowOffset + outDim) of it. Several targets can share a weight, e.g.
+     *          attn_q, attn_k and attn_v of a fused QKV weight.
+     */
+    struct MergeTarget
+    {
+        std::string weightName;
+        SizeType moduleId;
+        SizeType layerIdx;
+        TensorPtr baseWeights;
+        SizeType rowOffset{0};
+    };
+
     explicit LoraManager() {}
 
     /**
@@ -84,10 +106,12 @@ public:
 
     /**
      * \brief same as fillInputTensors but for an entire batch
+     * \param[in] pool: if given, the requests are filled in parallel on its workers. Ignored while a task is merged,
+     *                  since the corrections are built on demand.
      */
     void fillInputTensors(TensorPtr weightsPtrs, TensorPtr adapterSizes, ReqIdsVec const& reqIds,
         std::vector<SizeType> const& reqBeamWidth, std::vector<bool> const& loraEnabled, SizeType numContextRequests,
-        GptModelConfig const& modelConfig, WorldConfig const& worldConfig);
+        GptModelConfig const& modelConfig, WorldConfig const& worldConfig, WorkStealingPool* pool = nullptr);
 
     /**
      * \brief fill batch input tensors for LoRA.  This method fills on batch slot.
@@ -117,12 +141,118 @@ public:
     void insertInputTensors(TensorMap& inputTensors, TensorPtr weightsPtrs, TensorPtr adapterSizes,
         GptModelConfig const& modelConfig, WorldConfig const& worldConfig) const;
 
+    /**
+     * \brief Use a LoraCache for the tasks that were not added with addTask.
+     * \details The adapters of the batch must have been acquired in the cache, see LoraCache::acquire.
+     */
+    void setLoraCache(std::shared_ptr<LoraCache> loraCache)
+    {
+        mLoraCache = std::move(loraCache);
+    }
+
+    /**
+     * \brief Set the weights of this rank that adapters can be merged into. See MergeTarget.
+     */
+    void setMergeTargets(std::vector<MergeTarget> targets)
+    {
+        mMergeTargets = std::move(targets);
+    }
+
+    /**
+     * \brief The base weights of the merge targets, to refit the engine without any adapter merged.
+     */
+    [[nodiscard]] TensorMap getBaseWeights() const;
+
+    /**
+     * \brief The task of at least minFraction of the requests of a batch, if any.
+     * \details Requests without LoRA count as requests of no task.
+     * \param[in] taskIds: task id of each request
+     * \param[in] loraEnabled: whether each request uses its task
+     * \param[in] minFraction: fraction of the requests above which merging the task pays off
+     */
+    [[nodiscard]] static std::optional<TaskIdType> findDominantTask(
+        ReqIdsVec const& taskIds, std::vector<bool> const& loraEnabled, float minFraction);
+
+    /**
+     * \brief Compute the weights of the merge targets with the adapter of taskId merged in, i.e. W + B A.
+     * \details The merged weights go to new device buffers, so the work can be enqueued on a side stream while the
+     *          engine keeps running with its current weights. Pass the result to TllmRuntime::refitWeights once the
+     *          stream of manager completed, then call setMergedTask. Targets the task does not adapt get a copy of
+     *          their base weights.
+     * \param[in] taskId: the task to merge, added with addTask or in the LoraCache
+     * \param[in] worldConfig: a WorldConfig
+     * \param[in] manager: allocates the merged weights and enqueues the merge on its stream
+     * \returns the merged weights by refittable name
+     */
+    [[nodiscard]] TensorMap mergeTask(
+        TaskIdType taskId, WorldConfig const& worldConfig, BufferManager const& manager) const;
+
+    /**
+     * \brief Declare the task whose adapter the engine weights hold, or std::nullopt for the base weights.
+     * \details Call it after the refit completed. fillInputTensors then skips the merged rows for the requests of that
+     *          task, whose adapted GEMMs become plain GEMMs. All other requests, with or without LoRA, get a correction
+     *          adapter for the merged rows, which stacks the negated merged adapter and their own one along the rank.
+     *          The max LoRA rank of the engine must cover the sum of both ranks. The corrections are built on demand
+     *          on the stream of manager, which must be the stream of the engine, and freed by the next call.
+     * \param[in] taskId: the merged task
+     * \param[in] worldConfig: a WorldConfig
+     * \param[in] manager: allocates the corrections
+     */
+    void setMergedTask(
+        std::optional<TaskIdType> taskId, WorldConfig const& worldConfig, BufferManager const& manager);
+
+    [[nodiscard]] std::optional<TaskIdType> getMergedTask() const
+    {
+        return mMergedTask;
+    }
+
     void reset();
 
 private:
+    //! (module id, layer index) of a row of the config of a task
+    using ModuleLayer = std::pair<SizeType, SizeType>;
+
+    //! Adapter of one module and layer of this rank, in [adapterSize, inDim] and out [outDim, adapterSize]
+    struct RankAdapter
+    {
+        TensorPtr inWeights;
+        TensorPtr outWeights;
+        SizeType adapterSize{0};
+    };
+
+    using RankAdapters = std::map<ModuleLayer, RankAdapter>;
+
+    //! Weights (null if cached in mLoraCache) and config of a task
+    [[nodiscard]] std::pair<TensorPtr, TensorPtr> lookupTask(TaskIdType taskId) const;
+
+    //! The in and out weights of this rank in a row of the weights of a task
+    [[nodiscard]] std::pair<TensorSpan, TensorSpan> splitRowWeights(TensorSpan const& rowWeights, SizeType moduleId,
+        SizeType adapterSize, SizeType tpSize, SizeType tpRank) const;
+
+    [[nodiscard]] TensorSpan getRowWeights(TensorPtr const& reqWeights, TaskIdType taskId, SizeType row) const;
+
+    void writeRowPointers(TensorPtr const& weightsPtrs, TensorPtr const& adapterSizes, SizeType modOff,
+        SizeType localLayerIdx, SizeType batchIdx, SizeType beamWidth, void const* inWeights, void const* outWeights,
+        SizeType adapterSize) const;
+
+    //! Fill the corrections of the merged rows for a request of taskId, or without LoRA for std::nullopt
+    void fillCorrections(TensorPtr const& weightsPtrs, TensorPtr const& adapterSizes, SizeType batchIdx,
+        std::optional<TaskIdType> taskId, SizeType beamWidth, SizeType firstLayerId, SizeType lastLayerId,
+        SizeType tpSize, SizeType tpRank);
+
     TensorPtr mWorkspace;
+    std::shared_ptr<LoraCache> mLoraCache;
     std::unordered_map<TaskIdType, LoraReqTensors> mLoras;
     std::unordered_map<SizeType, LoraModule> mModuleIdToModule;
     std::unordered_map<SizeType, SizeType> mModuleOffest;
+
+    std::vector<MergeTarget> mMergeTargets;
+    std::optional<TaskIdType> mMergedTask;
+    //! Copy of the rows of the merged task that went into the engine weights
+    RankAdapters mMergedAdapter;
+    std::unique_ptr<BufferManager> mCorrectionManager;
+    std::unordered_map<TaskIdType, RankAdapters> mCorrections;
+    //! Corrections of the requests without LoRA
+    RankAdapters mBaseCorrections;
 };
 } // namespace tensorrt_llm::runtime
@@ -83,4 +83,19 @@ void loraValidateRequestTensors(const std::optional<ITensor::SharedPtr>& optReqL
             "lora_weights has to few values for " + moduleName);
     }
 }
+
+SizeType findConfigRow(ITensor const& config, SizeType moduleId, SizeType layerIdx)
+{
+    auto const* configPtr = bufferCast<SizeType>(config);
+    auto const nbRows = config.getShape().d[0];
+    for (SizeType row = 0; row < nbRows; ++row)
+    {
+        auto const* rowPtr = configPtr + row * kLORA_CONFIG_ROW_SIZE;
+        if (rowPtr[kLORA_CONFIG_MODULE_OFF] == moduleId && rowPtr[kLORA_CONFIG_LAYER_OFF] == layerIdx)
+        {
+            return row;
+        }
+    }
+    return -1;
+}
 } // namespace tensorrt_llm::runtime::lora
@@ -33,4 +33,7 @@ void loraValidateRequestTensorDims(const std::optional<ITensor::SharedPtr>& optR
 void loraValidateRequestTensors(const std::optional<ITensor::SharedPtr>& optReqLoraWeights,
     const std::optional<ITensor::SharedPtr>& optReqLoraConfig, runtime::GptModelConfig const& modelConfig,
     runtime::WorldConfig const& worldConfig);
+
+//! \brief Row of a LoRA config [num_modules_layers, kLORA_CONFIG_ROW_SIZE] for moduleId and layerIdx, -1 if none.
+SizeType findConfigRow(ITensor const& config, SizeType moduleId, SizeType layerIdx);
 } // namespace tensorrt_llm::runtime::lora
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/medusaTreeSelector.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace tensorrt_llm::runtime
+{
+
+MedusaTreeSelector::MedusaTreeSelector(MedusaModule const& module, std::vector<MedusaChoices> treeChoices,
+    SizeType maxBatchSize, SizeType maxBatchMedusaTokens, float acceptanceDecay)
+    : mModule{module}
+    , mMaxBatchMedusaTokens{maxBatchMedusaTokens}
+    , mAcceptanceDecay{acceptanceDecay}
+    , mExpectedAccepted(maxBatchSize, 0.f)
+    , mSelectedTrees(maxBatchSize, 0)
+{
+    TLLM_CHECK_WITH_INFO(!treeChoices.empty(), "At least one Medusa tree is required");
+    TLLM_CHECK_WITH_INFO(maxBatchSize > 0, "maxBatchSize must be positive");
+    TLLM_CHECK_WITH_INFO(acceptanceDecay >= 0.f && acceptanceDecay < 1.f, "acceptanceDecay must be in [0, 1)");
+
+    auto const medusaHeads = mModule.medusaHeads();
+    auto const tokensPerStep = mModule.tokensPerStep();
+    auto const numPackedMasks = mModule.numPackedMasks();
+    auto constexpr dtype = nvinfer1::DataType::kINT32;
+
+    mTrees.reserve(treeChoices.size());
+    for (auto& choices : treeChoices)
+    {
+        auto const numTokens = static_cast<SizeType>(choices.size());
+        TLLM_CHECK_WITH_INFO(numTokens > 0 && numTokens <= mModule.maxMedusaTokens(),
+            "Medusa tree has %d choices, expected between 1 and %d", numTokens, mModule.maxMedusaTokens());
+        SizeType depth{0};
+        for (auto const& choice : choices)
+        {
+            depth = std::max(depth, static_cast<SizeType>(choice.size()));
+        }
+        TLLM_CHECK_WITH_INFO(depth <= medusaHeads, "Medusa tree of depth %d exceeds the %d Medusa heads", depth,
+            medusaHeads);
+
+        Tree tree{numTokens, depth, 0, BufferManager::cpu(ITensor::makeShape({medusaHeads}), dtype),
+            BufferManager::cpu(ITensor::makeShape({tokensPerStep}), dtype),
+            BufferManager::cpu(ITensor::makeShape({tokensPerStep}), dtype),
+            BufferManager::cpu(ITensor::makeShape({tokensPerStep, medusaHeads + 1}), dtype),
+            BufferManager::cpu(ITensor::makeShape({tokensPerStep, numPackedMasks}), dtype)};
+        std::memset(tree.paths->data(), 0, tree.paths->getSizeInBytes());
+        std::memset(tree.packedMask->data(), 0, tree.packedMask->getSizeInBytes());
+        mModule.initMedusaTensorsFromChoices(choices, tree.topKs, tree.positionOffsets, tree.treeIds, tree.paths,
+            tree.packedMask, tree.numPaths);
+        mTrees.emplace_back(std::move(tree));
+    }
+    std::stable_sort(mTrees.begin(), mTrees.end(),
+        [](Tree const& a, Tree const& b) { return a.numTokens < b.numTokens; });
+
+    auto const largestTree = static_cast<SizeType>(mTrees.size()) - 1;
+    std::fill(mSelectedTrees.begin(), mSelectedTrees.end(), largestTree);
+
+    mTopKs = BufferManager::pinned(ITensor::makeShape({maxBatchSize, medusaHeads}), dtype);
+    mPositionOffsets = BufferManager::pinned(ITensor::makeShape({maxBatchSize, tokensPerStep}), dtype);
+    mTreeIds = BufferManager::pinned(ITensor::makeShape({maxBatchSize, tokensPerStep}), dtype);
+    mPaths = BufferManager::pinned(ITensor::makeShape({maxBatchSize, tokensPerStep, medusaHeads + 1}), dtype);
+    mPackedMasks = BufferManager::pinned(ITensor::makeShape({maxBatchSize, tokensPerStep, numPackedMasks}), dtype);
+    mNumPaths = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), dtype);
+    for (SizeType bi = 0; bi < maxBatchSize; ++bi)
+    {
+        newRequest(bi);
+        copyTreeToSlot(largestTree, bi);
+    }
+}
+
+void MedusaTreeSelector::newRequest(SizeType batchSlot)
+{
+    TLLM_CHECK(batchSlot >= 0 && batchSlot < static_cast<SizeType>(mExpectedAccepted.size()));
+    mExpectedAccepted[batchSlot] = static_cast<float>(mTrees.back().depth);
+}
+
+void MedusaTreeSelector::updateAcceptance(SizeType batchSlot, SizeType numAcceptedTokens)
+{
+    TLLM_CHECK(batchSlot >= 0 && batchSlot < static_cast<SizeType>(mExpectedAccepted.size()));
+    auto const accepted = static_cast<float>(std::clamp(numAcceptedTokens, 0, mTrees.back().depth));
+    auto& expected = mExpectedAccepted[batchSlot];
+    expected = mAcceptanceDecay * expected + (1.f - mAcceptanceDecay) * accepted;
+}
+
+SizeType MedusaTreeSelector::preferredTree(SizeType batchSlot) const
+{
+    auto const& largest = mTrees.back();
+    auto const acceptanceRate
+        = largest.depth > 0 ? mExpectedAccepted[batchSlot] / static_cast<float>(largest.depth) : 1.f;
+    auto const targetTokens = acceptanceRate * static_cast<float>(largest.numTokens);
+    SizeType treeIdx{0};
+    for (SizeType ti = 1; ti < getNumTrees(); ++ti)
+    {
+        if (static_cast<float>(mTrees[ti].numTokens) <= targetTokens)
+        {
+            treeIdx = ti;
+        }
+    }
+    return treeIdx;
+}
+
+SizeType MedusaTreeSelector::selectTrees(std::vector<SizeType> const& batchSlots)
+{
+    SizeType totalTokens{0};
+    for (auto const batchSlot : batchSlots)
+    {
+        TLLM_CHECK(batchSlot >= 0 && batchSlot < static_cast<SizeType>(mSelectedTrees.size()));
+        mSelectedTrees[batchSlot] = preferredTree(batchSlot);
+        totalTokens += mTrees[mSelectedTrees[batchSlot]].numTokens;
+    }
+
+    // Shrink the trees of the requests that are least likely to benefit from them until the batch fits.
+    while (mMaxBatchMedusaTokens > 0 && totalTokens > mMaxBatchMedusaTokens)
+    {
+        auto victim = batchSlots.end();
+        for (auto it = batchSlots.begin(); it != batchSlots.end(); ++it)
+        {
+            if (mSelectedTrees[*it] > 0
+                && (victim == batchSlots.end() || mExpectedAccepted[*it] < mExpectedAccepted[*victim]))
+            {
+                victim = it;
+            }
+        }
+        if (victim == batchSlots.end())
+        {
+            TLLM_LOG_DEBUG("Smallest Medusa trees use %d tokens, above the batch budget of %d", totalTokens,
+                mMaxBatchMedusaTokens);
+            break;
+        }
+        auto& treeIdx = mSelectedTrees[*victim];
+        totalTokens -= mTrees[treeIdx].numTokens - mTrees[treeIdx - 1].numTokens;
+        --treeIdx;
+    }
+
+    SizeType maxTokensPerStep{0};
+    for (auto const batchSlot : batchSlots)
+    {
+        copyTreeToSlot(mSelectedTrees[batchSlot], batchSlot);
+        maxTokensPerStep = std::max(maxTokensPerStep, mTrees[mSelectedTrees[batchSlot]].numTokens + 1);
+    }
+    return maxTokensPerStep;
+}
+
+void MedusaTreeSelector::copyTreeToSlot(SizeType treeIdx, SizeType batchSlot)
+{
+    auto const& tree = mTrees[treeIdx];
+    auto const copySlice = [batchSlot](ITensor const& src, TensorPtr const& dst)
+    {
+        auto const slice = ITensor::slice(dst, batchSlot, 1);
+        std::memcpy(slice->data(), src.data(), src.getSizeInBytes());
+    };
+    copySlice(*tree.topKs, mTopKs);
+    copySlice(*tree.positionOffsets, mPositionOffsets);
+    copySlice(*tree.treeIds, mTreeIds);
+    copySlice(*tree.paths, mPaths);
+    copySlice(*tree.packedMask, mPackedMasks);
+    bufferCast<SizeType>(*mNumPaths)[batchSlot] = tree.numPaths;
+}
+
+} // namespace tensorrt_llm::runtime
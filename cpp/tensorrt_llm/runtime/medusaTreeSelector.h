@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/medusaModule.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Selects a Medusa tree per request from a small set of precomputed trees.
+//! \details Every candidate tree is built once with MedusaModule. For each batch slot the selector keeps an
+//! exponential moving average of the number of accepted draft tokens and picks a tree whose size matches it:
+//! requests that accept few tokens verify a small tree, requests that accept many verify a large one.
+//! If the sum of the selected tree sizes exceeds the batch token budget, the trees of the requests with the
+//! lowest acceptance are shrunk first. The per request tensors are laid out by batch slot and padded to the
+//! number of tokens per step of the largest candidate tree, as expected by the attention plugin.
+class MedusaTreeSelector
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using MedusaChoices = MedusaModule::MedusaChoices;
+
+    //! \param module Medusa module of the engine, defines the number of heads and the maximum tree size.
+    //! \param treeChoices Candidate trees, each with at most module.maxMedusaTokens() choices.
+    //! \param maxBatchSize Number of batch slots.
+    //! \param maxBatchMedusaTokens Budget of draft tokens summed over all requests of a step, 0 for no budget.
+    //! \param acceptanceDecay Weight of the history in the moving average of accepted tokens, in [0, 1).
+    MedusaTreeSelector(MedusaModule const& module, std::vector<MedusaChoices> treeChoices, SizeType maxBatchSize,
+        SizeType maxBatchMedusaTokens = 0, float acceptanceDecay = 0.75f);
+
+    [[nodiscard]] SizeType getNumTrees() const noexcept
+    {
+        return static_cast<SizeType>(mTrees.size());
+    }
+
+    //! \brief Number of draft tokens of a candidate tree, without the root. Trees are sorted by this size.
+    [[nodiscard]] SizeType getTreeNumTokens(SizeType treeIdx) const
+    {
+        return mTrees.at(treeIdx).numTokens;
+    }
+
+    //! \brief Longest path of a candidate tree, i.e. the maximum number of draft tokens it can accept.
+    [[nodiscard]] SizeType getTreeDepth(SizeType treeIdx) const
+    {
+        return mTrees.at(treeIdx).depth;
+    }
+
+    //! \brief Start a new request in batchSlot. Without statistics the request is optimistic and gets the
+    //! largest tree.
+    void newRequest(SizeType batchSlot);
+
+    //! \brief Record the number of draft tokens accepted in the last step of the request in batchSlot.
+    void updateAcceptance(SizeType batchSlot, SizeType numAcceptedTokens);
+
+    //! \brief Moving average of the accepted draft tokens per step of the request in batchSlot.
+    [[nodiscard]] float getExpectedAcceptedTokens(SizeType batchSlot) const
+    {
+        return mExpectedAccepted.at(batchSlot);
+    }
+
+    //! \brief Select the tree of every request in batchSlots and write its tensors to the slot.
+    //! \return Number of tokens per step, including the root, of the largest selected tree.
+    SizeType selectTrees(std::vector<SizeType> const& batchSlots);
+
+    [[nodiscard]] SizeType getSelectedTree(SizeType batchSlot) const
+    {
+        return mSelectedTrees.at(batchSlot);
+    }
+
+    // [maxBatchSize, medusaHeads]
+    [[nodiscard]] TensorPtr const& getTopKs() const noexcept
+    {
+        return mTopKs;
+    }
+
+    // [maxBatchSize, tokensPerStep]
+    [[nodiscard]] TensorPtr const& getPositionOffsets() const noexcept
+    {
+        return mPositionOffsets;
+    }
+
+    // [maxBatchSize, tokensPerStep]
+    [[nodiscard]] TensorPtr const& getTreeIds() const noexcept
+    {
+        return mTreeIds;
+    }
+
+    // [maxBatchSize, tokensPerStep, medusaHeads + 1]
+    [[nodiscard]] TensorPtr const& getPaths() const noexcept
+    {
+        return mPaths;
+    }
+
+    // [maxBatchSize, tokensPerStep, numPackedMasks]
+    [[nodiscard]] TensorPtr const& getPackedMasks() const noexcept
+    {
+        return mPackedMasks;
+    }
+
+    // [maxBatchSize]
+    [[nodiscard]] TensorPtr const& getNumPaths() const noexcept
+    {
+        return mNumPaths;
+    }
+
+private:
+    struct Tree
+    {
+        SizeType numTokens;
+        SizeType depth;
+        SizeType numPaths;
+        TensorPtr topKs;
+        TensorPtr positionOffsets;
+        TensorPtr treeIds;
+        TensorPtr paths;
+        TensorPtr packedMask;
+    };
+
+    //! \brief Largest tree whose size does not exceed the share of the largest tree given by the acceptance.
+    [[nodiscard]] SizeType preferredTree(SizeType batchSlot) const;
+
+    void copyTreeToSlot(SizeType treeIdx, SizeType batchSlot);
+
+    MedusaModule mModule;
+    // Candidate trees sorted by increasing number of tokens
+    std::vector<Tree> mTrees;
+    SizeType mMaxBatchMedusaTokens;
+    float mAcceptanceDecay;
+    std::vector<float> mExpectedAccepted;
+    std::vector<SizeType> mSelectedTrees;
+
+    TensorPtr mTopKs;
+    TensorPtr mPositionOffsets;
+    TensorPtr mTreeIds;
+    TensorPtr mPaths;
+    TensorPtr mPackedMasks;
+    TensorPtr mNumPaths;
+};
+
+} // namespace tensorrt_llm::runtime
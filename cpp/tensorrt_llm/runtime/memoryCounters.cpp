@@ -22,11 +22,17 @@
 #include <cmath>
 
 namespace tc = tensorrt_llm::common;
+using tensorrt_llm::runtime::MemoryCounters;
+using tensorrt_llm::runtime::MemoryType;
 
 namespace
 {
 
 auto constexpr kByteUnits = std::array{"B", "KB", "MB", "GB", "TB", "PB", "EB"};
+auto constexpr kMemoryTypes = std::array{MemoryType::kGPU, MemoryType::kCPU, MemoryType::kPINNED, MemoryType::kUVM};
+auto constexpr kMemoryTypeNames = std::array{"GPU", "CPU", "Pinned", "UVM"};
+
+thread_local MemoryCounters::TagId currentTag{MemoryCounters::kUntagged};
 
 std::string doubleBytesToString(double bytes, int precision)
 {
@@ -83,6 +89,88 @@ void MemoryCounters::deallocate(MemoryType memoryType, MemoryCounters::SizeType
     }
 }
 
+MemoryCounters::TagId MemoryCounters::getTagId(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mTagLock);
+    if (auto it = mTagIds.find(name); it != mTagIds.end())
+    {
+        return it->second;
+    }
+    auto const tag = mNumTags.load(std::memory_order_relaxed);
+    TLLM_CHECK_WITH_INFO(tag < kMaxTags, "Cannot register memory tag %s, limit of %zu tags reached", name.c_str(),
+        kMaxTags);
+    mTagNames[tag] = name;
+    mTagIds.emplace(name, tag);
+    mNumTags.store(tag + 1, std::memory_order_release);
+    return tag;
+}
+
+std::string const& MemoryCounters::getTagName(TagId tag) const
+{
+    TLLM_CHECK_WITH_INFO(tag < mNumTags.load(std::memory_order_acquire), "Unknown memory tag %u", tag);
+    return mTagNames[tag];
+}
+
+std::vector<MemoryCounters::TagStats> MemoryCounters::getTagStats() const
+{
+    std::vector<TagStats> stats;
+    auto const numTags = mNumTags.load(std::memory_order_acquire);
+    for (TagId tag = 0; tag < numTags; ++tag)
+    {
+        for (std::size_t typeIdx = 0; typeIdx < kMemoryTypes.size(); ++typeIdx)
+        {
+            auto const& counters = mTagCounters[tag];
+            auto const peak = counters.peak[typeIdx].load();
+            if (peak > 0)
+            {
+                stats.push_back(TagStats{mTagNames[tag], kMemoryTypes[typeIdx], counters.current[typeIdx], peak});
+            }
+        }
+    }
+    return stats;
+}
+
+void MemoryCounters::resetTagPeaks()
+{
+    auto const numTags = mNumTags.load(std::memory_order_acquire);
+    for (TagId tag = 0; tag < numTags; ++tag)
+    {
+        auto& counters = mTagCounters[tag];
+        for (std::size_t typeIdx = 0; typeIdx < kMemoryTypes.size(); ++typeIdx)
+        {
+            counters.peak[typeIdx] = counters.current[typeIdx].load();
+        }
+    }
+}
+
+std::string MemoryCounters::tagsToString() const
+{
+    std::string result{"[MemUsage] by tag:"};
+    for (auto const& stats : getTagStats())
+    {
+        result += tc::fmtstr("\n  %s %s: %s (peak %s)", stats.name.c_str(),
+            kMemoryTypeNames[static_cast<std::size_t>(stats.memoryType)], bytesToString(stats.current).c_str(),
+            bytesToString(stats.peak).c_str());
+    }
+    return result;
+}
+
+MemoryCounters::TagId MemoryCounters::getCurrentTag()
+{
+    return currentTag;
+}
+
+MemoryCounters::ScopedTag::ScopedTag(TagId tag)
+    : mPrevious{currentTag}
+{
+    currentTag = tag;
+}
+
+MemoryCounters::ScopedTag::~ScopedTag()
+{
+    currentTag = mPrevious;
+}
+
 MemoryCounters& MemoryCounters::getInstance()
 {
     static MemoryCounters mInstance;
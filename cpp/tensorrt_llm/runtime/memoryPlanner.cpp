@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/memoryPlanner.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+std::size_t alignSize(std::size_t size)
+{
+    return (size + MemoryPlanner::kAlignment - 1) / MemoryPlanner::kAlignment * MemoryPlanner::kAlignment;
+}
+} // namespace
+
+SizeType MemoryPlanner::add(ITensor::Shape const& maxShape, nvinfer1::DataType type, Lifetime lifetime)
+{
+    TLLM_CHECK_WITH_INFO(lifetime.first <= lifetime.last, "Invalid lifetime [%d, %d]", lifetime.first, lifetime.last);
+    auto const size = ITensor::volumeNonNegative(maxShape) * BufferDataType(type).getSize();
+    mTensors.push_back({maxShape, type, lifetime, alignSize(size), 0});
+    mPlanned = false;
+    return static_cast<SizeType>(mTensors.size() - 1);
+}
+
+std::size_t MemoryPlanner::plan()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    std::vector<SizeType> order(mTensors.size());
+    std::iota(order.begin(), order.end(), 0);
+    // Larger tensors first, the smaller ones then fill the gaps between them
+    std::stable_sort(order.begin(), order.end(),
+        [this](SizeType lhs, SizeType rhs) { return mTensors[lhs].size > mTensors[rhs].size; });
+
+    std::vector<PlannedTensor const*> conflicts;
+    mArenaSize = 0;
+    for (auto placed = order.begin(); placed != order.end(); ++placed)
+    {
+        auto& tensor = mTensors[*placed];
+        // Tensors placed before that are alive together with this one, by increasing offset
+        conflicts.clear();
+        for (auto other = order.begin(); other != placed; ++other)
+        {
+            auto const& otherTensor = mTensors[*other];
+            if (otherTensor.size > 0 && otherTensor.lifetime.intersects(tensor.lifetime))
+            {
+                conflicts.push_back(&otherTensor);
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end(),
+            [](PlannedTensor const* lhs, PlannedTensor const* rhs) { return lhs->offset < rhs->offset; });
+
+        // Lowest gap that fits the tensor
+        std::size_t offset{0};
+        for (auto const* conflict : conflicts)
+        {
+            if (conflict->offset >= offset + tensor.size)
+            {
+                break;
+            }
+            offset = std::max(offset, conflict->offset + conflict->size);
+        }
+        tensor.offset = offset;
+        mArenaSize = std::max(mArenaSize, offset + tensor.size);
+    }
+    mPlanned = true;
+    TLLM_LOG_DEBUG("Planned %zu tensors of %zu bytes in %zu bytes", mTensors.size(), getTotalSize(), mArenaSize);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return mArenaSize;
+}
+
+std::vector<MemoryPlanner::TensorPtr> MemoryPlanner::allocate(BufferManager const& manager)
+{
+    if (!mPlanned)
+    {
+        plan();
+    }
+    std::shared_ptr<IBuffer> arena = manager.gpu(mArenaSize);
+    auto* data = static_cast<std::uint8_t*>(arena->data());
+
+    std::vector<TensorPtr> tensors;
+    tensors.reserve(mTensors.size());
+    for (auto const& tensor : mTensors)
+    {
+        auto wrapped = ITensor::wrap(
+            data + tensor.offset, tensor.type, tensor.shape, ITensor::volumeNonNegative(tensor.shape));
+        // The wrapped tensors do not own their memory, the deleter keeps the arena alive instead
+        tensors.emplace_back(wrapped.release(), [arena](ITensor* wrappedTensor) { delete wrappedTensor; });
+    }
+    return tensors;
+}
+
+std::size_t MemoryPlanner::getOffset(SizeType index) const
+{
+    TLLM_CHECK_WITH_INFO(mPlanned, "Offsets are only known after plan()");
+    return mTensors.at(index).offset;
+}
+
+std::size_t MemoryPlanner::getTotalSize() const noexcept
+{
+    return std::accumulate(mTensors.begin(), mTensors.end(), std::size_t{0},
+        [](std::size_t sum, PlannedTensor const& tensor) { return sum + tensor.size; });
+}
+
+} // namespace tensorrt_llm::runtime
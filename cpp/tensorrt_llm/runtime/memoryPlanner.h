@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Places device tensors with known lifetimes in one allocation, so that tensors which are never alive at the
+//! same time share memory.
+//! \details A lifetime is a closed interval of phases, e.g. the context and the generation phase of a session. Each
+//! tensor is added with the largest shape it will be reshaped to. plan() assigns offsets greedily by decreasing size,
+//! each at the lowest aligned offset that overlaps no placed tensor with an intersecting lifetime. allocate() then
+//! wraps every tensor in one device buffer. The tensors cannot grow beyond their planned shape.
+class MemoryPlanner
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    //! Offsets are aligned so that any data type and vectorized access works on every tensor
+    static std::size_t constexpr kAlignment{256};
+
+    struct Lifetime
+    {
+        SizeType first;
+        SizeType last;
+
+        [[nodiscard]] bool intersects(Lifetime const& other) const noexcept
+        {
+            return first <= other.last && other.first <= last;
+        }
+    };
+
+    //! \brief Add a tensor of maxShape alive from lifetime.first to lifetime.last.
+    //! \returns the index of the tensor in the result of allocate()
+    SizeType add(ITensor::Shape const& maxShape, nvinfer1::DataType type, Lifetime lifetime);
+
+    //! \brief Assign the offsets of all tensors added so far.
+    //! \returns the size of the arena in bytes
+    std::size_t plan();
+
+    //! \brief Allocate the arena with manager and wrap every tensor, in the order they were added. The tensors keep
+    //! the arena alive. Plans first if the tensors changed since the last plan().
+    [[nodiscard]] std::vector<TensorPtr> allocate(BufferManager const& manager);
+
+    [[nodiscard]] std::size_t getOffset(SizeType index) const;
+
+    [[nodiscard]] std::size_t getArenaSize() const noexcept
+    {
+        return mArenaSize;
+    }
+
+    //! \brief Bytes needed without sharing, i.e. the sum of the aligned sizes of all tensors.
+    [[nodiscard]] std::size_t getTotalSize() const noexcept;
+
+    [[nodiscard]] SizeType getNumTensors() const noexcept
+    {
+        return static_cast<SizeType>(mTensors.size());
+    }
+
+private:
+    struct PlannedTensor
+    {
+        ITensor::Shape shape;
+        nvinfer1::DataType type;
+        Lifetime lifetime;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    std::vector<PlannedTensor> mTensors;
+    std::size_t mArenaSize{0};
+    bool mPlanned{true};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/stringUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <map>
+#include <unistd.h>
+
+namespace tc = tensorrt_llm::common;
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+
+auto constexpr kMemoryTypes = std::array{MemoryType::kGPU, MemoryType::kCPU, MemoryType::kPINNED, MemoryType::kUVM};
+auto constexpr kMemoryTypeNames = std::array{"GPU", "CPU", "Pinned", "UVM"};
+
+// Frames of recordAllocation and of the allocator calling it
+std::size_t constexpr kSkippedFrames{2};
+
+std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::string symbolize(void* address)
+{
+    ::Dl_info info{};
+    if (::dladdr(address, &info) == 0)
+    {
+        return tc::fmtstr("%p", address);
+    }
+    if (info.dli_sname != nullptr)
+    {
+        int status{-1};
+        auto* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        auto result = tc::fmtstr("%s+0x%tx", status == 0 ? demangled : info.dli_sname,
+            static_cast<char*>(address) - static_cast<char*>(info.dli_saddr));
+        std::free(demangled);
+        return result;
+    }
+    return tc::fmtstr("%s+0x%tx", info.dli_fname != nullptr ? info.dli_fname : "?",
+        static_cast<char*>(address) - static_cast<char*>(info.dli_fbase));
+}
+
+void writeEscaped(std::ostream& os, std::string const& str)
+{
+    for (auto const c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            os << '\\';
+        }
+        os << c;
+    }
+}
+
+} // namespace
+
+MemoryTimeline& MemoryTimeline::getInstance()
+{
+    static MemoryTimeline& timeline = []() -> MemoryTimeline&
+    {
+        static MemoryTimeline instance;
+        if (!tc::getEnvMemoryTimeline().empty())
+        {
+            instance.setEnabled(true);
+            // Registered after the construction of the instance, so that it runs before its destruction
+            std::atexit(
+                []()
+                {
+                    auto const path = tc::getEnvMemoryTimeline();
+                    try
+                    {
+                        getInstance().dump(path);
+                        TLLM_LOG_INFO("Wrote memory timeline %s", path.c_str());
+                    }
+                    catch (std::exception const& e)
+                    {
+                        TLLM_LOG_ERROR("Memory timeline dump failed: %s", e.what());
+                    }
+                });
+            TLLM_LOG_INFO("Memory timeline enabled");
+        }
+        return instance;
+    }();
+    return timeline;
+}
+
+void MemoryTimeline::recordAllocation(MemoryType memoryType, void const* ptr, SizeType size, cudaStream_t stream)
+{
+    Event event{now(), ptr, size, memoryType, true, MemoryCounters::getCurrentTag(), stream, {}};
+    std::array<void*, kCallSiteDepth + kSkippedFrames> frames{};
+    auto const numFrames = static_cast<std::size_t>(::backtrace(frames.data(), static_cast<int>(frames.size())));
+    if (numFrames > kSkippedFrames)
+    {
+        std::copy(frames.begin() + kSkippedFrames, frames.begin() + numFrames, event.callSite.begin());
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLive.insert_or_assign(ptr, mEvents.size());
+    mEvents.push_back(event);
+}
+
+void MemoryTimeline::recordFree(MemoryType memoryType, void const* ptr, cudaStream_t stream)
+{
+    auto const timestamp = now();
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto const it = mLive.find(ptr);
+    if (it == mLive.end())
+    {
+        return;
+    }
+    auto const& allocation = mEvents[it->second];
+    TLLM_CHECK_WITH_INFO(allocation.memoryType == memoryType, "Buffer %p freed as %s memory, allocated as %s", ptr,
+        kMemoryTypeNames[static_cast<std::size_t>(memoryType)],
+        kMemoryTypeNames[static_cast<std::size_t>(allocation.memoryType)]);
+    Event const event{timestamp, ptr, allocation.size, memoryType, false, allocation.tag, stream, {}};
+    mLive.erase(it);
+    mEvents.push_back(event);
+}
+
+std::vector<MemoryTimeline::Event> MemoryTimeline::getEvents() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEvents;
+}
+
+std::vector<MemoryTimeline::PeakSnapshot> MemoryTimeline::getPeakSnapshots() const
+{
+    auto const events = getEvents();
+
+    // First pass: where every memory type peaks
+    std::array<SizeType, kMemoryTypes.size()> current{}, peak{};
+    std::array<std::size_t, kMemoryTypes.size()> peakEvent{};
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        auto const& event = events[i];
+        auto const typeIdx = static_cast<std::size_t>(event.memoryType);
+        if (!event.allocation)
+        {
+            current[typeIdx] -= event.size;
+        }
+        else if ((current[typeIdx] += event.size) > peak[typeIdx])
+        {
+            peak[typeIdx] = current[typeIdx];
+            peakEvent[typeIdx] = i;
+        }
+    }
+
+    // Second pass per memory type: replay up to its peak
+    std::vector<PeakSnapshot> snapshots;
+    for (auto const memoryType : kMemoryTypes)
+    {
+        auto const typeIdx = static_cast<std::size_t>(memoryType);
+        if (peak[typeIdx] == 0)
+        {
+            continue;
+        }
+        std::unordered_map<void const*, std::size_t> live;
+        for (std::size_t i = 0; i <= peakEvent[typeIdx]; ++i)
+        {
+            auto const& event = events[i];
+            if (event.memoryType != memoryType)
+            {
+                continue;
+            }
+            if (event.allocation)
+            {
+                live.insert_or_assign(event.ptr, i);
+            }
+            else
+            {
+                live.erase(event.ptr);
+            }
+        }
+        PeakSnapshot snapshot{memoryType, peak[typeIdx], events[peakEvent[typeIdx]].timestampNs, {}};
+        snapshot.allocations.reserve(live.size());
+        for (auto const& [ptr, i] : live)
+        {
+            snapshot.allocations.push_back(events[i]);
+        }
+        std::sort(snapshot.allocations.begin(), snapshot.allocations.end(),
+            [](Event const& a, Event const& b) { return a.size > b.size || (a.size == b.size && a.ptr < b.ptr); });
+        snapshots.push_back(std::move(snapshot));
+    }
+    return snapshots;
+}
+
+void MemoryTimeline::dump(std::ostream& os) const
+{
+    auto const events = getEvents();
+    auto const snapshots = getPeakSnapshots();
+    auto& counters = MemoryCounters::getInstance();
+    auto const pid = ::getpid();
+
+    auto const flags = os.flags();
+    os << std::fixed;
+    os.precision(3);
+    os << "{\"traceEvents\":[";
+    // Bytes of every tag seen so far, by memory type, so that every counter event carries all the series of its track
+    std::array<std::map<TagId, SizeType>, kMemoryTypes.size()> bytesByTag;
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        auto const& event = events[i];
+        auto const typeIdx = static_cast<std::size_t>(event.memoryType);
+        auto& bytes = bytesByTag[typeIdx][event.tag];
+        bytes = event.allocation ? bytes + event.size : bytes - event.size;
+        os << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << kMemoryTypeNames[typeIdx]
+           << " memory\",\"ph\":\"C\",\"ts\":" << static_cast<double>(event.timestampNs) / 1000. << ",\"pid\":" << pid
+           << ",\"args\":{";
+        char const* separator = "";
+        for (auto const& [tag, tagBytes] : bytesByTag[typeIdx])
+        {
+            os << separator << "\"";
+            writeEscaped(os, counters.getTagName(tag));
+            os << "\":" << tagBytes;
+            separator = ",";
+        }
+        os << "}}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\",\n\"peaks\":[";
+
+    std::unordered_map<void*, std::string> symbols;
+    for (std::size_t s = 0; s < snapshots.size(); ++s)
+    {
+        auto const& snapshot = snapshots[s];
+        std::map<TagId, SizeType> peakByTag;
+        for (auto const& allocation : snapshot.allocations)
+        {
+            peakByTag[allocation.tag] += allocation.size;
+        }
+        os << (s == 0 ? "\n" : ",\n") << "{\"memoryType\":\""
+           << kMemoryTypeNames[static_cast<std::size_t>(snapshot.memoryType)] << "\",\"bytes\":" << snapshot.bytes
+           << ",\"ts\":" << static_cast<double>(snapshot.timestampNs) / 1000. << ",\"byTag\":{";
+        char const* separator = "";
+        for (auto const& [tag, bytes] : peakByTag)
+        {
+            os << separator << "\"";
+            writeEscaped(os, counters.getTagName(tag));
+            os << "\":" << bytes;
+            separator = ",";
+        }
+        os << "},\"allocations\":[";
+        for (std::size_t a = 0; a < snapshot.allocations.size(); ++a)
+        {
+            auto const& allocation = snapshot.allocations[a];
+            os << (a == 0 ? "\n" : ",\n") << "{\"size\":" << allocation.size << ",\"tag\":\"";
+            writeEscaped(os, counters.getTagName(allocation.tag));
+            os << "\",\"ptr\":\"" << allocation.ptr << "\",\"stream\":\"" << static_cast<void*>(allocation.stream)
+               << "\",\"ts\":" << static_cast<double>(allocation.timestampNs) / 1000. << ",\"callSite\":[";
+            separator = "";
+            for (auto* address : allocation.callSite)
+            {
+                if (address == nullptr)
+                {
+                    break;
+                }
+                auto it = symbols.find(address);
+                if (it == symbols.end())
+                {
+                    it = symbols.emplace(address, symbolize(address)).first;
+                }
+                os << separator << "\"";
+                writeEscaped(os, it->second);
+                os << "\"";
+                separator = ",";
+            }
+            os << "]}";
+        }
+        os << "]}";
+    }
+    os << "\n]}\n";
+    os.flags(flags);
+}
+
+void MemoryTimeline::dump(std::string const& path) const
+{
+    std::ofstream file(path);
+    TLLM_CHECK_WITH_INFO(file.good(), "Failed to open %s", path.c_str());
+    dump(file);
+    TLLM_CHECK_WITH_INFO(file.good(), "Failed to write %s", path.c_str());
+}
+
+void MemoryTimeline::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.clear();
+    mLive.clear();
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/moeLoadStats.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <cstring>
+
+using namespace tensorrt_llm::runtime;
+
+MoeLoadStatsCollector& MoeLoadStatsCollector::getInstance()
+{
+    static MoeLoadStatsCollector mInstance;
+    return mInstance;
+}
+
+std::int64_t* MoeLoadStatsCollector::getLayerCounters(SizeType layerIdx, SizeType numExperts)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& counters = mLayerCounters[layerIdx];
+    if (!counters)
+    {
+        counters = BufferManager::managed(numExperts, nvinfer1::DataType::kINT64);
+        std::memset(counters->data(), 0, counters->getSizeInBytes());
+    }
+    TLLM_CHECK_WITH_INFO(static_cast<SizeType>(counters->getSize()) == numExperts,
+        "Layer %d registered with %lu experts, got %d", layerIdx, counters->getSize(), numExperts);
+    return bufferCast<std::int64_t>(*counters);
+}
+
+void MoeLoadStatsCollector::collect(executor::MoeLoadStats& stats)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& [layerIdx, counters] : mLayerCounters)
+    {
+        stats.addLayer(bufferCast<std::int64_t>(*counters), static_cast<SizeType>(counters->getSize()));
+        std::memset(counters->data(), 0, counters->getSizeInBytes());
+    }
+}
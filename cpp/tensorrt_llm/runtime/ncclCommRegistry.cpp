@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/ncclCommRegistry.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include "tensorrt_llm/runtime/utils/multiDeviceUtils.h"
+
+#if ENABLE_MULTI_DEVICE
+#include <nccl.h>
+#endif // ENABLE_MULTI_DEVICE
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+#if ENABLE_MULTI_DEVICE
+
+// Exchanges a unique id between the ranks of group, a broadcast when the group is the whole session. The ranks of an
+// in-process world exchange it in memory.
+ncclComm_t createComm(std::set<int> const& group, int myRank)
+{
+    auto const it = group.find(myRank);
+    TLLM_CHECK_WITH_INFO(it != group.end(), "Rank %d is not in the requested NCCL group", myRank);
+    auto const groupRank = static_cast<int>(std::distance(group.begin(), it));
+
+    ncclUniqueId id;
+    auto const& session = COMM_SESSION;
+    if (auto* world = InProcessWorld::getCurrent())
+    {
+        if (myRank == *group.begin())
+        {
+            TLLM_NCCL_CHECK(ncclGetUniqueId(&id));
+        }
+        id = world->broadcastValue(group, id);
+    }
+    else if (static_cast<int>(group.size()) == session.getSize())
+    {
+        if (myRank == 0)
+        {
+            TLLM_NCCL_CHECK(ncclGetUniqueId(&id));
+        }
+        session.bcastValue(id, 0);
+    }
+    else if (myRank == *group.begin())
+    {
+        TLLM_NCCL_CHECK(ncclGetUniqueId(&id));
+        for (auto peer = std::next(group.begin()); peer != group.end(); ++peer)
+        {
+            session.send(id, *peer, 0);
+        }
+    }
+    else
+    {
+        session.recv(id, *group.begin(), 0);
+    }
+
+    ncclComm_t comm = nullptr;
+    TLLM_NCCL_CHECK(ncclCommInitRank(&comm, static_cast<int>(group.size()), id, groupRank));
+    return comm;
+}
+
+std::set<int> toSet(std::vector<SizeType> const& ranks)
+{
+    return {ranks.begin(), ranks.end()};
+}
+
+std::set<int> getTensorParallelGroup(WorldConfig const& worldConfig)
+{
+    auto const tp = worldConfig.getTensorParallelism();
+    auto const firstRank = worldConfig.getRank() - worldConfig.getTensorParallelRank();
+    std::set<int> group;
+    for (SizeType idx = 0; idx < tp; ++idx)
+    {
+        group.insert(firstRank + idx);
+    }
+    return group;
+}
+
+#endif // ENABLE_MULTI_DEVICE
+} // namespace
+
+NcclCommRegistry& NcclCommRegistry::getInstance()
+{
+    static NcclCommRegistry instance;
+    return instance;
+}
+
+ncclComm_t NcclCommRegistry::acquire(std::set<int> const& group)
+{
+#if ENABLE_MULTI_DEVICE
+    auto const myRank = InProcessWorld::getSessionRank();
+    std::lock_guard<std::mutex> creationLock(getCreationMutex(myRank));
+    return findOrCreate(group, myRank, [&group, myRank]() { return createComm(group, myRank); });
+#else
+    TLLM_THROW("Multi device support is disabled.");
+#endif // ENABLE_MULTI_DEVICE
+}
+
+std::size_t NcclCommRegistry::release(ncclComm_t comm)
+{
+#if ENABLE_MULTI_DEVICE
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = std::find_if(
+        mComms.begin(), mComms.end(), [comm](auto const& entry) { return entry.second.comm == comm; });
+    TLLM_CHECK_WITH_INFO(it != mComms.end(), "NCCL communicator was not acquired from the registry");
+    auto const refCount = --it->second.refCount;
+    if (refCount == 0)
+    {
+        if (ncclCommDestroy(comm) != ncclSuccess)
+        {
+            TLLM_LOG_WARNING("Failed to destroy NCCL communicator.");
+        }
+        mComms.erase(it);
+    }
+    return refCount;
+#else
+    return 0;
+#endif // ENABLE_MULTI_DEVICE
+}
+
+bool NcclCommRegistry::contains(ncclComm_t comm) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return comm != nullptr
+        && std::any_of(
+            mComms.begin(), mComms.end(), [comm](auto const& entry) { return entry.second.comm == comm; });
+}
+
+void NcclCommRegistry::splitWorld(WorldConfig const& worldConfig)
+{
+#if ENABLE_MULTI_DEVICE
+    auto const myRank = worldConfig.getRank();
+    std::lock_guard<std::mutex> creationLock(getCreationMutex(myRank));
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (worldConfig.getSize() == 1 || !mSplitRanks.insert(myRank).second)
+        {
+            return;
+        }
+    }
+
+    std::set<int> world;
+    for (SizeType rank = 0; rank < worldConfig.getSize(); ++rank)
+    {
+        world.insert(rank);
+    }
+    // Held for the rest of the process
+    auto* worldComm = findOrCreate(world, myRank, [&world, myRank]() { return createComm(world, myRank); });
+
+    for (auto const& group : {getTensorParallelGroup(worldConfig), toSet(worldConfig.getContextParallelGroup()),
+             toSet(worldConfig.getPipelineParallelGroup())})
+    {
+        // Every rank takes part in every split, the sizes of the groups are the same on all of them.
+        if (group.size() == 1 || group == world)
+        {
+            continue;
+        }
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 18, 0)
+        bool exists{false};
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            exists = mComms.count(Key{myRank, group}) != 0;
+        }
+        ncclConfig_t config = NCCL_CONFIG_INITIALIZER;
+        config.splitShare = 1;
+        ncclComm_t comm = nullptr;
+        // The first rank of a group tells it apart from the others of the same split
+        auto const color = exists ? NCCL_SPLIT_NOCOLOR : *group.begin();
+        TLLM_NCCL_CHECK(ncclCommSplit(worldComm, color, myRank, &comm, &config));
+        findOrCreate(group, myRank, [comm]() { return comm; });
+#else
+        findOrCreate(group, myRank, [&group, myRank]() { return createComm(group, myRank); });
+#endif
+    }
+#endif // ENABLE_MULTI_DEVICE
+}
+
+std::mutex& NcclCommRegistry::getCreationMutex(int rank)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCreationMutexes[rank];
+}
+
+ncclComm_t NcclCommRegistry::findOrCreate(
+    std::set<int> const& group, int rank, std::function<ncclComm_t()> const& create)
+{
+    Key const key{rank, group};
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mComms.find(key);
+        if (it != mComms.end())
+        {
+            ++it->second.refCount;
+            return it->second.comm;
+        }
+    }
+    auto* comm = create();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mComms.emplace(key, Entry{comm, 1});
+    return comm;
+}
+
+void* NcclCommRegistry::registerBuffer(ncclComm_t comm, void* buffer, std::size_t size)
+{
+    void* handle = nullptr;
+#if ENABLE_MULTI_DEVICE
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 19, 0)
+    TLLM_NCCL_CHECK(ncclCommRegister(comm, buffer, size, &handle));
+#endif
+#endif // ENABLE_MULTI_DEVICE
+    return handle;
+}
+
+void NcclCommRegistry::deregisterBuffer(ncclComm_t comm, void* handle)
+{
+#if ENABLE_MULTI_DEVICE
+#if NCCL_VERSION_CODE >= NCCL_VERSION(2, 19, 0)
+    if (handle != nullptr)
+    {
+        TLLM_NCCL_CHECK(ncclCommDeregister(comm, handle));
+    }
+#endif
+#endif // ENABLE_MULTI_DEVICE
+}
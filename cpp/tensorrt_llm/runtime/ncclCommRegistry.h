@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/worldConfig.h"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+
+struct ncclComm;
+typedef struct ncclComm* ncclComm_t;
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief NCCL communicators of the process, shared by the runtime and the plugins, one per group of ranks.
+//! \details Groups are sets of ranks of COMM_SESSION, or of the InProcessWorld of the calling thread. A communicator is
+//! created on the first request of a rank for its group, with an exchange of unique id between the ranks of the group,
+//! and is reference counted from then on, so that the plugins of an engine and the runtime using the same group share
+//! it. Creations hold a lock of their rank only, the ranks of an in-process world create theirs concurrently.
+//! splitWorld creates the communicator of the whole session once per rank and derives the tensor, context and pipeline
+//! parallel groups from it with ncclCommSplit, which needs no further exchange of ids and lets NCCL share the resources
+//! of the parent.
+class NcclCommRegistry
+{
+public:
+    static NcclCommRegistry& getInstance();
+
+    //! \brief Communicator of group, with one more reference.
+    //! \details Collective over the ranks of group when the communicator does not exist yet.
+    ncclComm_t acquire(std::set<int> const& group);
+
+    //! \brief Drops a reference taken by acquire, the communicator is destroyed with the last one.
+    //! \returns the number of references left
+    std::size_t release(ncclComm_t comm);
+
+    //! \brief Whether comm was acquired from the registry and is not destroyed yet.
+    [[nodiscard]] bool contains(ncclComm_t comm) const;
+
+    //! \brief Creates the communicator of the session and splits the parallel groups of worldConfig from it.
+    //! \details Collective over all the ranks of the session. Must run before the engines are deserialized for their
+    //! plugins to find the groups. The registry holds a reference to these communicators for the rest of the process.
+    //! Groups are created one by one instead with NCCL older than 2.18.
+    void splitWorld(WorldConfig const& worldConfig);
+
+    //! \brief Registers a buffer reused by many collectives of comm, which then skip its registration on every call.
+    //! \returns the handle to pass to deregisterBuffer, nullptr with NCCL older than 2.19
+    void* registerBuffer(ncclComm_t comm, void* buffer, std::size_t size);
+
+    void deregisterBuffer(ncclComm_t comm, void* handle);
+
+    NcclCommRegistry(NcclCommRegistry const&) = delete;
+    NcclCommRegistry& operator=(NcclCommRegistry const&) = delete;
+
+private:
+    struct Entry
+    {
+        ncclComm_t comm;
+        std::size_t refCount;
+    };
+
+    // Rank of the session and group
+    using Key = std::pair<int, std::set<int>>;
+
+    NcclCommRegistry() = default;
+
+    // Serializes the collective creations of rank
+    std::mutex& getCreationMutex(int rank);
+
+    // Communicator of rank for group with one more reference, created with create if there is none.
+    ncclComm_t findOrCreate(std::set<int> const& group, int rank, std::function<ncclComm_t()> const& create);
+
+    std::mutex mutable mMutex;
+    std::map<Key, Entry> mComms;
+    std::map<int, std::mutex> mCreationMutexes;
+    std::set<int> mSplitRanks;
+};
+
+} // namespace tensorrt_llm::runtime
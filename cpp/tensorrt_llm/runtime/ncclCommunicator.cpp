@@ -17,6 +17,8 @@
 #include "tensorrt_llm/runtime/ncclCommunicator.h"
 
 #include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include "tensorrt_llm/runtime/ncclCommRegistry.h"
 #include "tensorrt_llm/runtime/utils/multiDeviceUtils.h"
 
 #if ENABLE_MULTI_DEVICE
@@ -72,6 +74,30 @@ void NcclCommunicator::receive(
 ncclComm_t NcclCommunicator::createComm(int worldSize, int rank, mpi::MpiComm const& mpiComm)
 {
 #if ENABLE_MULTI_DEVICE
+    // The ranks of an in-process world have no MPI communicator, they share the communicators of the registry
+    if (auto* world = InProcessWorld::getCurrent())
+    {
+        TLLM_CHECK_WITH_INFO(worldSize == world->getSize() && rank == InProcessWorld::getSessionRank(),
+            "Ranks of an in-process world only communicate with the whole world");
+        std::set<int> ranks;
+        for (int idx = 0; idx < worldSize; ++idx)
+        {
+            ranks.insert(idx);
+        }
+        return NcclCommRegistry::getInstance().acquire(ranks);
+    }
+
+    // The communicator of the whole session is shared with the plugins and the other sessions of the process
+    if (&mpiComm == &COMM_SESSION && worldSize == mpiComm.getSize())
+    {
+        TLLM_CHECK(rank == mpiComm.getRank());
+        std::set<int> world;
+        for (int idx = 0; idx < worldSize; ++idx)
+        {
+            world.insert(idx);
+        }
+        return NcclCommRegistry::getInstance().acquire(world);
+    }
 
     ncclUniqueId id;
     if (rank == 0)
@@ -92,7 +118,12 @@ ncclComm_t NcclCommunicator::createComm(int worldSize, int rank, mpi::MpiComm co
 NcclCommunicator::~NcclCommunicator()
 {
 #if ENABLE_MULTI_DEVICE
-    if (mComm && ncclCommDestroy(mComm) != ncclSuccess)
+    auto& registry = NcclCommRegistry::getInstance();
+    if (registry.contains(mComm))
+    {
+        registry.release(mComm);
+    }
+    else if (mComm && ncclCommDestroy(mComm) != ncclSuccess)
     {
         TLLM_LOG_WARNING("Failed to destroy NCCL communicator.");
     }
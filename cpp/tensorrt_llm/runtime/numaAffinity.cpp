@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/numaAffinity.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+#if defined(__linux__)
+// From numaif.h, which is only installed with libnuma
+constexpr int kMpolBind = 2;
+
+std::size_t roundUpToPages(std::size_t size)
+{
+    auto const pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return (size + pageSize - 1) / pageSize * pageSize;
+}
+#endif
+
+std::optional<std::string> readFirstLine(std::filesystem::path const& path)
+{
+    std::ifstream file{path};
+    std::string line;
+    if (!file || !std::getline(file, line))
+    {
+        return std::nullopt;
+    }
+    return line;
+}
+} // namespace
+
+NumaAffinity& NumaAffinity::getInstance()
+{
+    static NumaAffinity instance;
+    return instance;
+}
+
+std::optional<NumaAffinity::DeviceLocality> NumaAffinity::getDeviceLocality(int device)
+{
+    char pciBusId[32];
+    TLLM_CUDA_CHECK(::cudaDeviceGetPCIBusId(pciBusId, sizeof(pciBusId), device));
+    return getDeviceLocality(std::string{pciBusId});
+}
+
+std::optional<NumaAffinity::DeviceLocality> NumaAffinity::getDeviceLocality(
+    std::string const& pciBusId, std::filesystem::path const& sysfsRoot)
+{
+    // sysfs names devices with a lower case id and a 4 digit domain, NVML reports 8 domain digits
+    auto id = pciBusId;
+    std::transform(id.begin(), id.end(), id.begin(), [](unsigned char c) { return std::tolower(c); });
+    auto const domainEnd = id.find(':');
+    if (domainEnd != std::string::npos && domainEnd > 4)
+    {
+        id.erase(0, domainEnd - 4);
+    }
+
+    auto const devicePath = sysfsRoot / id;
+    auto const numaNode = readFirstLine(devicePath / "numa_node");
+    if (!numaNode)
+    {
+        return std::nullopt;
+    }
+    auto const node = std::stoi(*numaNode);
+    if (node < 0)
+    {
+        // Not reported, e.g. on hosts with a single node
+        return std::nullopt;
+    }
+    auto const cpuList = readFirstLine(devicePath / "local_cpulist");
+    return DeviceLocality{node, cpuList ? parseCpuList(*cpuList) : std::vector<SizeType>{}};
+}
+
+std::vector<SizeType> NumaAffinity::parseCpuList(std::string const& cpuList)
+{
+    std::vector<SizeType> cpus;
+    std::istringstream stream{cpuList};
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), [](unsigned char c) { return std::isspace(c); }),
+            range.end());
+        if (range.empty())
+        {
+            continue;
+        }
+        auto const dash = range.find('-');
+        auto const first = std::stoi(range.substr(0, dash));
+        auto const last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        TLLM_CHECK_WITH_INFO(0 <= first && first <= last, "Invalid CPU range %s", range.c_str());
+        for (auto cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool NumaAffinity::bindCurrentThread(std::vector<SizeType> const& cpus)
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (auto const cpu : cpus)
+    {
+        if (0 <= cpu && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    return CPU_COUNT(&cpuSet) > 0 && ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+    return false;
+#endif
+}
+
+std::optional<NumaAffinity::DeviceLocality> NumaAffinity::apply(int device, AffinityConfig const& config)
+{
+    auto locality = getDeviceLocality(device);
+    if (config.numaNode || config.cpus)
+    {
+        if (!locality)
+        {
+            locality = DeviceLocality{-1, {}};
+        }
+        if (config.numaNode)
+        {
+            locality->numaNode = *config.numaNode;
+        }
+        if (config.cpus)
+        {
+            locality->cpus = *config.cpus;
+        }
+    }
+    if (!locality)
+    {
+        TLLM_LOG_INFO("No NUMA node reported for device %d, host placement is left to the OS", device);
+        return std::nullopt;
+    }
+
+    if (!locality->cpus.empty() && !bindCurrentThread(locality->cpus))
+    {
+        TLLM_LOG_WARNING("Could not bind the host threads of device %d to its %zu local CPUs", device,
+            locality->cpus.size());
+    }
+    if (locality->numaNode >= 0)
+    {
+        setPinnedMemoryNode(locality->numaNode);
+    }
+    TLLM_LOG_INFO("Placed the host threads of device %d on %zu CPUs and its pinned memory on NUMA node %d", device,
+        locality->cpus.size(), locality->numaNode);
+    return locality;
+}
+
+void NumaAffinity::setPinnedMemoryNode(std::optional<SizeType> node)
+{
+    TLLM_CHECK_WITH_INFO(!node || *node >= 0, "Invalid NUMA node %d", node.value_or(-1));
+    mPinnedMemoryNode.store(node.value_or(-1), std::memory_order_relaxed);
+}
+
+void* NumaAffinity::allocatePinned(std::size_t size, SizeType node)
+{
+    void* ptr{nullptr};
+    if (size == 0)
+    {
+        return ptr;
+    }
+#if defined(__linux__)
+    auto const bytes = roundUpToPages(size);
+    ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    // The pages are faulted in by cudaHostRegister and follow the policy
+    auto constexpr kBitsPerWord = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> nodeMask(node / kBitsPerWord + 1, 0);
+    nodeMask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+    if (::syscall(SYS_mbind, ptr, bytes, kMpolBind, nodeMask.data(), nodeMask.size() * kBitsPerWord, 0) != 0)
+    {
+        TLLM_LOG_WARNING("Could not bind %zu bytes of pinned memory to NUMA node %d", bytes, node);
+    }
+    auto const status = ::cudaHostRegister(ptr, bytes, cudaHostRegisterDefault);
+    if (status != cudaSuccess)
+    {
+        ::munmap(ptr, bytes);
+        TLLM_CUDA_CHECK(status);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mNodeAllocations.insert(ptr);
+    }
+    mHasNodeAllocations.store(true, std::memory_order_relaxed);
+#else
+    TLLM_CUDA_CHECK(::cudaHostAlloc(&ptr, size, cudaHostAllocDefault));
+#endif
+    return ptr;
+}
+
+bool NumaAffinity::freePinned(void* ptr, std::size_t size)
+{
+#if defined(__linux__)
+    if (ptr == nullptr || !mHasNodeAllocations.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mNodeAllocations.erase(ptr) == 0)
+        {
+            return false;
+        }
+    }
+    TLLM_CUDA_CHECK(::cudaHostUnregister(ptr));
+    ::munmap(ptr, roundUpToPages(size));
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace tensorrt_llm::runtime
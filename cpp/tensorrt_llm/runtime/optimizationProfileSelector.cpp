@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/optimizationProfileSelector.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+SizeType getBucket(SizeType value)
+{
+    SizeType bucket{1};
+    while (bucket < value)
+    {
+        bucket *= 2;
+    }
+    return bucket;
+}
+} // namespace
+
+OptimizationProfileSelector::OptimizationProfileSelector(std::vector<ProfileRange> profileRanges)
+    : mProfileRanges{std::move(profileRanges)}
+{
+    TLLM_CHECK_WITH_INFO(!mProfileRanges.empty(), "At least one optimization profile is required");
+}
+
+OptimizationProfileSelector OptimizationProfileSelector::fromEngine(nvinfer1::ICudaEngine const& engine)
+{
+    auto const numProfiles = engine.getNbOptimizationProfiles();
+    std::vector<ProfileRange> profileRanges;
+    profileRanges.reserve(numProfiles);
+    for (SizeType profile = 0; profile < numProfiles; ++profile)
+    {
+        // input_ids is [numTokens] with packed inputs and [batchSize, maxInputLength] otherwise
+        auto const minInputIds = engine.getProfileShape("input_ids", profile, nvinfer1::OptProfileSelector::kMIN);
+        auto const maxInputIds = engine.getProfileShape("input_ids", profile, nvinfer1::OptProfileSelector::kMAX);
+        TLLM_CHECK(minInputIds.nbDims > 0 && maxInputIds.nbDims == minInputIds.nbDims);
+        auto const minLastTokenIds
+            = engine.getProfileShape("last_token_ids", profile, nvinfer1::OptProfileSelector::kMIN);
+        auto const maxLastTokenIds
+            = engine.getProfileShape("last_token_ids", profile, nvinfer1::OptProfileSelector::kMAX);
+        auto const tokensDim = minInputIds.nbDims - 1;
+        profileRanges.push_back(
+            {minInputIds.d[tokensDim], maxInputIds.d[tokensDim], minLastTokenIds.d[0], maxLastTokenIds.d[0]});
+        TLLM_LOG_DEBUG("Optimization profile %d: tokens [%d, %d], batch size [%d, %d]", profile,
+            profileRanges.back().minNumTokens, profileRanges.back().maxNumTokens, profileRanges.back().minBatchSize,
+            profileRanges.back().maxBatchSize);
+    }
+    return OptimizationProfileSelector{std::move(profileRanges)};
+}
+
+OptimizationProfileSelector::Key OptimizationProfileSelector::makeKey(
+    SizeType profile, SizeType numTokens, SizeType batchSize)
+{
+    return {profile, getBucket(numTokens), getBucket(batchSize)};
+}
+
+SizeType OptimizationProfileSelector::select(SizeType numTokens, SizeType batchSize, SizeType defaultProfile)
+{
+    poll();
+    std::optional<SizeType> fastest;
+    float fastestMs{0};
+    for (SizeType profile = 0; profile < getNbProfiles(); ++profile)
+    {
+        if (!mProfileRanges[profile].contains(numTokens, batchSize))
+        {
+            continue;
+        }
+        auto const latency = getLatency(profile, numTokens, batchSize);
+        if (!latency)
+        {
+            // Still warming up, measure this profile
+            return profile;
+        }
+        if (!fastest || *latency < fastestMs)
+        {
+            fastest = profile;
+            fastestMs = *latency;
+        }
+    }
+    return fastest.value_or(defaultProfile);
+}
+
+bool OptimizationProfileSelector::beginMeasurement(
+    SizeType profile, SizeType numTokens, SizeType batchSize, CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(!mMeasuring, "A measurement is already in progress");
+    auto const key = makeKey(profile, numTokens, batchSize);
+    auto& entry = mLatencies[key];
+    if (entry.numSamples + entry.numPending >= kNumWarmUpSamples)
+    {
+        return false;
+    }
+    ++entry.numPending;
+    auto& measurement = mMeasurements.emplace_back();
+    measurement.key = key;
+    stream.record(measurement.start);
+    mMeasuring = true;
+    return true;
+}
+
+void OptimizationProfileSelector::endMeasurement(CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(mMeasuring, "No measurement in progress");
+    stream.record(mMeasurements.back().end);
+    mMeasuring = false;
+}
+
+void OptimizationProfileSelector::addSample(SizeType profile, SizeType numTokens, SizeType batchSize, float latencyMs)
+{
+    auto& entry = mLatencies[makeKey(profile, numTokens, batchSize)];
+    entry.sumMs += latencyMs;
+    ++entry.numSamples;
+}
+
+std::optional<float> OptimizationProfileSelector::getLatency(
+    SizeType profile, SizeType numTokens, SizeType batchSize) const
+{
+    auto const it = mLatencies.find(makeKey(profile, numTokens, batchSize));
+    if (it == mLatencies.end() || it->second.numSamples < kNumWarmUpSamples)
+    {
+        return std::nullopt;
+    }
+    return it->second.sumMs / static_cast<float>(it->second.numSamples);
+}
+
+void OptimizationProfileSelector::poll()
+{
+    auto const numOpen = mMeasuring ? 1 : 0;
+    auto const numComplete = static_cast<SizeType>(mMeasurements.size()) - numOpen;
+    auto it = mMeasurements.begin();
+    for (SizeType i = 0; i < numComplete; ++i)
+    {
+        auto const status = ::cudaEventQuery(it->end.get());
+        if (status == cudaErrorNotReady)
+        {
+            ++it;
+            continue;
+        }
+        TLLM_CUDA_CHECK(status);
+        float latencyMs{0};
+        TLLM_CUDA_CHECK(::cudaEventElapsedTime(&latencyMs, it->start.get(), it->end.get()));
+        auto& entry = mLatencies[it->key];
+        entry.sumMs += latencyMs;
+        ++entry.numSamples;
+        --entry.numPending;
+        it = mMeasurements.erase(it);
+    }
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <NvInferRuntime.h>
+
+#include <list>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Selects the optimization profile of an engine execution by its number of tokens and batch size.
+//! The number of tokens is the last dimension of `input_ids`, i.e. the total number of tokens with packed inputs and
+//! the padded length of the sequences otherwise.
+//! \details Every profile whose shape range contains an execution can run it, but TensorRT picks tactics for the
+//! optimal shape of each profile, so a profile tuned for small shapes is usually faster for small batches than the
+//! profile covering the maximum shape. The selector keeps a latency table per profile, number of tokens and batch
+//! size, both rounded up to the next power of 2. While a bucket has fewer than kNumWarmUpSamples samples for a
+//! feasible profile, select() returns that profile and the execution is timed with CUDA events. Afterwards it returns
+//! the feasible profile with the lowest mean latency. Timings are read without synchronizing, once their events have
+//! completed.
+class OptimizationProfileSelector
+{
+public:
+    static SizeType constexpr kNumWarmUpSamples{3};
+
+    struct ProfileRange
+    {
+        SizeType minNumTokens;
+        SizeType maxNumTokens;
+        SizeType minBatchSize;
+        SizeType maxBatchSize;
+
+        [[nodiscard]] bool contains(SizeType numTokens, SizeType batchSize) const noexcept
+        {
+            return minNumTokens <= numTokens && numTokens <= maxNumTokens && minBatchSize <= batchSize
+                && batchSize <= maxBatchSize;
+        }
+    };
+
+    explicit OptimizationProfileSelector(std::vector<ProfileRange> profileRanges);
+
+    //! \brief Read the ranges of the profiles from the last dimension of `input_ids` and the first of `last_token_ids`.
+    static OptimizationProfileSelector fromEngine(nvinfer1::ICudaEngine const& engine);
+
+    [[nodiscard]] SizeType getNbProfiles() const noexcept
+    {
+        return static_cast<SizeType>(mProfileRanges.size());
+    }
+
+    //! \brief Select the profile for an execution. Returns defaultProfile if no profile contains the shape.
+    [[nodiscard]] SizeType select(SizeType numTokens, SizeType batchSize, SizeType defaultProfile);
+
+    //! \brief Start timing an execution with profile on stream, if its bucket still needs samples.
+    //! \returns whether endMeasurement must be called after enqueuing the execution
+    bool beginMeasurement(SizeType profile, SizeType numTokens, SizeType batchSize, CudaStream const& stream);
+
+    void endMeasurement(CudaStream const& stream);
+
+    //! \brief Add a latency sample of an execution with profile.
+    void addSample(SizeType profile, SizeType numTokens, SizeType batchSize, float latencyMs);
+
+    //! \brief The mean latency of the bucket, once it has kNumWarmUpSamples samples.
+    [[nodiscard]] std::optional<float> getLatency(SizeType profile, SizeType numTokens, SizeType batchSize) const;
+
+private:
+    using Key = std::tuple<SizeType, SizeType, SizeType>;
+
+    struct Entry
+    {
+        float sumMs{0};
+        SizeType numSamples{0};
+        // Measurements started but not yet read
+        SizeType numPending{0};
+    };
+
+    struct Measurement
+    {
+        Key key;
+        CudaEvent start{static_cast<unsigned int>(cudaEventDefault)};
+        CudaEvent end{static_cast<unsigned int>(cudaEventDefault)};
+    };
+
+    static Key makeKey(SizeType profile, SizeType numTokens, SizeType batchSize);
+
+    //! \brief Add the samples of all completed measurements.
+    void poll();
+
+    std::vector<ProfileRange> mProfileRanges;
+    std::map<Key, Entry> mLatencies;
+    std::list<Measurement> mMeasurements;
+    bool mMeasuring{false};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/packedEncoderInputs.h"
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace tensorrt_llm::runtime;
+
+std::vector<PackedEncoderBatch> PackedEncoderInputs::batchByTokens(
+    std::vector<SizeType> const& inputLengths, SizeType maxNumTokens, SizeType maxBatchSize)
+{
+    TLLM_CHECK_WITH_INFO(maxNumTokens > 0 && maxBatchSize > 0, "Invalid batch limits");
+    std::vector<PackedEncoderBatch> batches;
+    PackedEncoderBatch batch;
+    for (SizeType request = 0; request < static_cast<SizeType>(inputLengths.size()); ++request)
+    {
+        auto const inputLength = inputLengths[request];
+        TLLM_CHECK_WITH_INFO(0 < inputLength && inputLength <= maxNumTokens,
+            "Request %d has %d tokens, more than the %d tokens of a batch", request, inputLength, maxNumTokens);
+        if (batch.numRequests == maxBatchSize || batch.numTokens + inputLength > maxNumTokens)
+        {
+            batches.push_back(batch);
+            batch = PackedEncoderBatch{request, 0, 0, 0};
+        }
+        ++batch.numRequests;
+        batch.numTokens += inputLength;
+        batch.maxInputLength = std::max(batch.maxInputLength, inputLength);
+    }
+    if (batch.numRequests > 0)
+    {
+        batches.push_back(batch);
+    }
+    return batches;
+}
+
+PackedEncoderInputs::PackedEncoderInputs(SizeType maxBatchSize, SizeType maxNumTokens, BufferManager const& manager)
+    : mManager{manager}
+    , mMaxBatchSize{maxBatchSize}
+    , mMaxNumTokens{maxNumTokens}
+{
+    auto constexpr nvSizeType = TRTDataType<SizeType>::value;
+    auto const tokensShape = ITensor::makeShape({maxNumTokens});
+    auto const requestsShape = ITensor::makeShape({maxBatchSize});
+
+    mInputIdsHost = BufferManager::cpu(tokensShape, nvSizeType);
+    mPositionIdsHost = BufferManager::cpu(tokensShape, nvSizeType);
+    mInputLengthsHost = BufferManager::cpu(requestsShape, nvSizeType);
+
+    mInputIds = mManager.gpu(tokensShape, nvSizeType);
+    mPositionIds = mManager.gpu(tokensShape, nvSizeType);
+    mTokenTypeIds = mManager.gpu(tokensShape, nvSizeType);
+    mManager.setZero(*mTokenTypeIds);
+    mInputLengths = mManager.gpu(requestsShape, nvSizeType);
+    mMaxInputLengthShape = mManager.gpu(tokensShape, nvSizeType);
+}
+
+void PackedEncoderInputs::pack(std::vector<std::vector<TokenIdType>> const& inputIds, PackedEncoderBatch const& batch)
+{
+    TLLM_CHECK_WITH_INFO(batch.numRequests <= mMaxBatchSize, "Batch of %d requests exceeds the maximum of %d",
+        batch.numRequests, mMaxBatchSize);
+    TLLM_CHECK_WITH_INFO(batch.numTokens <= mMaxNumTokens, "Batch of %d tokens exceeds the maximum of %d",
+        batch.numTokens, mMaxNumTokens);
+    TLLM_CHECK(batch.firstRequest + batch.numRequests <= static_cast<SizeType>(inputIds.size()));
+
+    auto* inputIdsHost = bufferCast<SizeType>(*mInputIdsHost);
+    auto* positionIdsHost = bufferCast<SizeType>(*mPositionIdsHost);
+    auto* inputLengthsHost = bufferCast<SizeType>(*mInputLengthsHost);
+    mTokenOffsets.assign(1, 0);
+    SizeType maxInputLength{0};
+    for (SizeType bi = 0; bi < batch.numRequests; ++bi)
+    {
+        auto const& tokens = inputIds[batch.firstRequest + bi];
+        auto const inputLength = static_cast<SizeType>(tokens.size());
+        auto const offset = mTokenOffsets.back();
+        TLLM_CHECK_WITH_INFO(offset + inputLength <= batch.numTokens, "Requests have more tokens than the batch");
+        std::copy(tokens.begin(), tokens.end(), inputIdsHost + offset);
+        std::iota(positionIdsHost + offset, positionIdsHost + offset + inputLength, 0);
+        inputLengthsHost[bi] = inputLength;
+        maxInputLength = std::max(maxInputLength, inputLength);
+        mTokenOffsets.push_back(offset + inputLength);
+    }
+    auto const numTokens = mTokenOffsets.back();
+
+    // Views of the packed size keep the addresses of the buffers, only the shapes seen by the engine change
+    mManager.copy(*ITensor::slice(mInputIdsHost, 0, numTokens), *ITensor::slice(mInputIds, 0, numTokens));
+    mManager.copy(*ITensor::slice(mPositionIdsHost, 0, numTokens), *ITensor::slice(mPositionIds, 0, numTokens));
+    mManager.copy(
+        *ITensor::slice(mInputLengthsHost, 0, batch.numRequests), *ITensor::slice(mInputLengths, 0, batch.numRequests));
+    mNumTokens = numTokens;
+    mNumRequests = batch.numRequests;
+    mMaxInputLength = maxInputLength;
+}
+
+void PackedEncoderInputs::insertInputTensors(TllmRuntime::TensorMap& tensorMap) const
+{
+    tensorMap.insert_or_assign("input_ids", ITensor::slice(mInputIds, 0, mNumTokens));
+    tensorMap.insert_or_assign("position_ids", ITensor::slice(mPositionIds, 0, mNumTokens));
+    tensorMap.insert_or_assign("token_type_ids", ITensor::slice(mTokenTypeIds, 0, mNumTokens));
+    tensorMap.insert_or_assign("input_lengths", ITensor::slice(mInputLengths, 0, mNumRequests));
+    tensorMap.insert_or_assign("max_input_length", ITensor::slice(mMaxInputLengthShape, 0, mMaxInputLength));
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/tllmRuntime.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Consecutive requests run together by an encoder engine.
+struct PackedEncoderBatch
+{
+    SizeType firstRequest{0};
+    SizeType numRequests{0};
+    SizeType numTokens{0};
+    SizeType maxInputLength{0};
+};
+
+//! \brief Inputs of encoder engines built with remove_input_padding, e.g. BERT.
+//! \details The sequences of a batch are concatenated into [numTokens] instead of padded to [batchSize,
+//! maxInputLength]. The BERT attention plugin rebuilds the padding only inside the attention kernels and removes it
+//! again from their output, so the cost of a batch follows its number of tokens rather than its longest sequence.
+//! With inputs of very different lengths, batches are formed by their number of tokens.
+class PackedEncoderInputs
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    //! \brief Split the requests, in order, into batches of at most maxNumTokens tokens and maxBatchSize requests.
+    static std::vector<PackedEncoderBatch> batchByTokens(
+        std::vector<SizeType> const& inputLengths, SizeType maxNumTokens, SizeType maxBatchSize);
+
+    PackedEncoderInputs(SizeType maxBatchSize, SizeType maxNumTokens, BufferManager const& manager);
+
+    //! \brief Pack the tokens of the requests of batch and copy them to the device on the stream of the manager.
+    //! \param inputIds Tokens of all the requests, the batch refers to them by index.
+    void pack(std::vector<std::vector<TokenIdType>> const& inputIds, PackedEncoderBatch const& batch);
+
+    //! \brief Add input_ids, position_ids and token_type_ids of shape [numTokens], input_lengths of shape
+    //! [numRequests] and max_input_length, whose shape [maxInputLength] carries the longest sequence of the batch to
+    //! the plugin. TllmRuntime ignores the ones the engine does not declare.
+    void insertInputTensors(TllmRuntime::TensorMap& tensorMap) const;
+
+    //! \brief Offsets of the requests of the last packed batch in the packed outputs, numRequests + 1 values.
+    [[nodiscard]] std::vector<SizeType> const& getTokenOffsets() const
+    {
+        return mTokenOffsets;
+    }
+
+private:
+    BufferManager const& mManager;
+    SizeType mMaxBatchSize;
+    SizeType mMaxNumTokens;
+
+    // Pageable host staging, the copies return once the source is staged, so it can be refilled right away
+    TensorPtr mInputIdsHost;
+    TensorPtr mPositionIdsHost;
+    TensorPtr mInputLengthsHost;
+
+    TensorPtr mInputIds;
+    TensorPtr mPositionIds;
+    TensorPtr mTokenTypeIds;
+    TensorPtr mInputLengths;
+    // Only its shape is read
+    TensorPtr mMaxInputLengthShape;
+
+    // Last packed batch
+    SizeType mNumRequests{0};
+    SizeType mNumTokens{0};
+    SizeType mMaxInputLength{0};
+    std::vector<SizeType> mTokenOffsets;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/promptTableCache.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <numeric>
+
+namespace tensorrt_llm::runtime
+{
+
+PromptTableCache::PromptTableCache(SizeType numSlots, SizeType maxTaskVocabSize, SizeType hiddenSize,
+    nvinfer1::DataType dataType, BufferManager const& manager)
+    : mManager{manager}
+    , mMaxTaskVocabSize{maxTaskVocabSize}
+    , mHiddenSize{hiddenSize}
+{
+    TLLM_CHECK_WITH_INFO(numSlots > 0 && maxTaskVocabSize > 0 && hiddenSize > 0,
+        "Invalid prompt table cache of %d slots of [%d, %d]", numSlots, maxTaskVocabSize, hiddenSize);
+    mEmbeddingTable = mManager.gpu(ITensor::makeShape({numSlots * maxTaskVocabSize, hiddenSize}), dataType);
+    mManager.setZero(*mEmbeddingTable);
+    std::vector<SizeType> const taskVocabSize{maxTaskVocabSize};
+    mTaskVocabSize = mManager.copyFrom(taskVocabSize, ITensor::makeShape({1}), MemoryType::kGPU);
+    // Slots are taken from the back
+    mFreeSlots.resize(numSlots);
+    std::iota(mFreeSlots.rbegin(), mFreeSlots.rend(), 0);
+}
+
+bool PromptTableCache::put(TaskIdType taskId, TensorPtr const& table)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TensorPtr tableView = ITensor::view(table);
+    if (tableView->getShape().nbDims == 3)
+    {
+        tableView->squeeze(0);
+    }
+    auto const& shape = tableView->getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims == 2 && shape.d[1] == mHiddenSize,
+        "Prompt table of task %ld must have shape [numVirtualTokens, %d]", taskId, mHiddenSize);
+    auto const numVirtualTokens = static_cast<SizeType>(shape.d[0]);
+    TLLM_CHECK_WITH_INFO(0 < numVirtualTokens && numVirtualTokens <= mMaxTaskVocabSize,
+        "Prompt table of task %ld has %d virtual tokens, expected at most %d", taskId, numVirtualTokens,
+        mMaxTaskVocabSize);
+    TLLM_CHECK_WITH_INFO(tableView->getDataType() == mEmbeddingTable->getDataType(),
+        "Prompt table of task %ld has the wrong data type", taskId);
+
+    auto it = mTasks.find(taskId);
+    if (it != mTasks.end())
+    {
+        TLLM_CHECK_WITH_INFO(
+            it->second.numRequests == 0, "Prompt table of task %ld is replaced while requests hold it", taskId);
+        mLru.splice(mLru.begin(), mLru, it->second.lruIt);
+    }
+    else
+    {
+        auto const slot = allocateSlot();
+        if (slot < 0)
+        {
+            TLLM_LOG_DEBUG("No free slot for the prompt table of task %ld", taskId);
+            return false;
+        }
+        mLru.push_front(taskId);
+        it = mTasks.emplace(taskId, TaskEntry{slot, 0, 0, mLru.begin()}).first;
+    }
+    auto& entry = it->second;
+    entry.numVirtualTokens = numVirtualTokens;
+    auto slotView = ITensor::slice(mEmbeddingTable, entry.slot * mMaxTaskVocabSize, numVirtualTokens);
+    mManager.copy(*tableView, *slotView);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return true;
+}
+
+bool PromptTableCache::has(TaskIdType taskId) const
+{
+    return mTasks.find(taskId) != mTasks.end();
+}
+
+bool PromptTableCache::acquire(TaskIdType taskId, RequestIdType requestId)
+{
+    if (auto const reqIt = mRequestTasks.find(requestId); reqIt != mRequestTasks.end())
+    {
+        TLLM_CHECK_WITH_INFO(reqIt->second == taskId, "Request %lu already holds prompt table of task %ld",
+            requestId, reqIt->second);
+        return true;
+    }
+    auto const it = mTasks.find(taskId);
+    if (it == mTasks.end())
+    {
+        return false;
+    }
+    auto& entry = it->second;
+    mLru.splice(mLru.begin(), mLru, entry.lruIt);
+    ++entry.numRequests;
+    mRequestTasks.emplace(requestId, taskId);
+    return true;
+}
+
+void PromptTableCache::release(RequestIdType requestId)
+{
+    auto const reqIt = mRequestTasks.find(requestId);
+    if (reqIt == mRequestTasks.end())
+    {
+        return;
+    }
+    auto& entry = mTasks.at(reqIt->second);
+    TLLM_CHECK(entry.numRequests > 0);
+    --entry.numRequests;
+    mRequestTasks.erase(reqIt);
+}
+
+SizeType PromptTableCache::getSlot(TaskIdType taskId) const
+{
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end(), "Prompt table of task %ld is not resident", taskId);
+    return it->second.slot;
+}
+
+SizeType PromptTableCache::getNumVirtualTokens(TaskIdType taskId) const
+{
+    auto const it = mTasks.find(taskId);
+    TLLM_CHECK_WITH_INFO(it != mTasks.end(), "Prompt table of task %ld is not resident", taskId);
+    return it->second.numVirtualTokens;
+}
+
+void PromptTableCache::setupParams(PromptTuningParams& params) const
+{
+    params.embeddingTable = mEmbeddingTable;
+    params.vocabSize = mTaskVocabSize;
+}
+
+SizeType PromptTableCache::allocateSlot()
+{
+    if (mFreeSlots.empty())
+    {
+        // Evict the least recently used table that no request holds
+        for (auto lruIt = mLru.rbegin(); lruIt != mLru.rend(); ++lruIt)
+        {
+            auto const taskIt = mTasks.find(*lruIt);
+            if (taskIt->second.numRequests == 0)
+            {
+                TLLM_LOG_DEBUG("Evict prompt table of task %ld", *lruIt);
+                mFreeSlots.push_back(taskIt->second.slot);
+                mLru.erase(taskIt->second.lruIt);
+                mTasks.erase(taskIt);
+                break;
+            }
+        }
+        if (mFreeSlots.empty())
+        {
+            return -1;
+        }
+    }
+    auto const slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    return slot;
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/promptTuningParams.h"
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+/**
+ * \brief Device-resident cache of prompt tuning embedding tables keyed by a client task id.
+ * \details The tables live in one device table of numSlots slots of maxTaskVocabSize rows, which is the embedding
+ *          table of PromptTuningParams. A request refers to its table by the slot of its task, so a batch needs no
+ *          copy or concatenation of tables. Tables are put like LoRA tasks: a request acquires the table of its task
+ *          before it is scheduled, which pins the slot until the request releases it. When all slots are taken, the
+ *          least recently used table that no in-flight request holds is evicted and has to be put again.
+ *          Not thread-safe.
+ */
+class PromptTableCache
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using TaskIdType = std::int64_t;
+    using RequestIdType = std::uint64_t;
+
+    PromptTableCache(SizeType numSlots, SizeType maxTaskVocabSize, SizeType hiddenSize, nvinfer1::DataType dataType,
+        BufferManager const& manager);
+
+    /**
+     * \brief Copy the table of a task into a slot, evicting the least recently used table if needed.
+     * \param[in] table: embedding table [numVirtualTokens, hiddenSize], numVirtualTokens <= maxTaskVocabSize.
+     *                   A leading dimension of 1 is ignored.
+     * \return false if every slot is held by an in-flight request.
+     */
+    [[nodiscard]] bool put(TaskIdType taskId, TensorPtr const& table);
+
+    //! \brief Whether the table of the task is resident.
+    [[nodiscard]] bool has(TaskIdType taskId) const;
+
+    /**
+     * \brief Pin the table of a task until the request releases it. Acquiring again for the same request is a no-op.
+     * \return false if the table is not resident, it has to be put first.
+     */
+    [[nodiscard]] bool acquire(TaskIdType taskId, RequestIdType requestId);
+
+    //! \brief Unpin the table of a finished request. The table stays resident until it is evicted.
+    void release(RequestIdType requestId);
+
+    //! \brief Slot of a resident table, which is the task of the request in PromptTuningParams::tasks.
+    [[nodiscard]] SizeType getSlot(TaskIdType taskId) const;
+
+    //! \brief Rows of the table of a resident task.
+    [[nodiscard]] SizeType getNumVirtualTokens(TaskIdType taskId) const;
+
+    [[nodiscard]] SizeType getNumFreeSlots() const noexcept
+    {
+        return static_cast<SizeType>(mFreeSlots.size());
+    }
+
+    [[nodiscard]] SizeType getMaxTaskVocabSize() const noexcept
+    {
+        return mMaxTaskVocabSize;
+    }
+
+    //! \brief All the slots [numSlots * maxTaskVocabSize, hiddenSize], on gpu.
+    [[nodiscard]] TensorPtr const& getEmbeddingTable() const noexcept
+    {
+        return mEmbeddingTable;
+    }
+
+    //! \brief Let params look the virtual tokens up in the cache. The tasks of the requests must be their slots.
+    void setupParams(PromptTuningParams& params) const;
+
+private:
+    struct TaskEntry
+    {
+        SizeType slot;
+        SizeType numVirtualTokens;
+        SizeType numRequests{0};
+        std::list<TaskIdType>::iterator lruIt;
+    };
+
+    //! \brief Take a free slot, evicting the least recently used table that no request holds.
+    //! \return -1 if every slot is held.
+    [[nodiscard]] SizeType allocateSlot();
+
+    BufferManager const& mManager;
+    SizeType mMaxTaskVocabSize;
+    SizeType mHiddenSize;
+    TensorPtr mEmbeddingTable;
+    TensorPtr mTaskVocabSize; // [1], on gpu
+    std::vector<SizeType> mFreeSlots;
+    std::unordered_map<TaskIdType, TaskEntry> mTasks;
+    std::unordered_map<RequestIdType, TaskIdType> mRequestTasks;
+    // Most recently used first
+    std::list<TaskIdType> mLru;
+};
+
+} // namespace tensorrt_llm::runtime
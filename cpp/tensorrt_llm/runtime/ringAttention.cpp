@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/ringAttention.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/ringAttentionKernels.h"
+
+#include <algorithm>
+#include <cuda_fp16.h>
+#ifdef ENABLE_BF16
+#include <cuda_bf16.h>
+#endif
+
+using namespace tensorrt_llm::runtime;
+namespace tk = tensorrt_llm::kernels;
+
+namespace
+{
+
+void invokeRingAttentionStep(
+    nvinfer1::DataType dataType, tk::RingAttentionStepParams const& params, CudaStream const& stream)
+{
+    switch (dataType)
+    {
+    case nvinfer1::DataType::kFLOAT: tk::invokeRingAttentionStep<float>(params, stream.get()); break;
+    case nvinfer1::DataType::kHALF: tk::invokeRingAttentionStep<half>(params, stream.get()); break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16: tk::invokeRingAttentionStep<__nv_bfloat16>(params, stream.get()); break;
+#endif
+    default: TLLM_THROW("Unsupported data type for ring attention: %d", static_cast<int>(dataType));
+    }
+}
+
+void invokeRingAttentionFinalize(nvinfer1::DataType dataType, ITensor& output, ITensor const& accumulator,
+    ITensor const& rowSum, SizeType numTokens, SizeType numQHeads, SizeType headSize, CudaStream const& stream)
+{
+    auto const* acc = bufferCast<float>(accumulator);
+    auto const* sum = bufferCast<float>(rowSum);
+    switch (dataType)
+    {
+    case nvinfer1::DataType::kFLOAT:
+        tk::invokeRingAttentionFinalize<float>(output.data(), acc, sum, numTokens, numQHeads, headSize, stream.get());
+        break;
+    case nvinfer1::DataType::kHALF:
+        tk::invokeRingAttentionFinalize<half>(output.data(), acc, sum, numTokens, numQHeads, headSize, stream.get());
+        break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        tk::invokeRingAttentionFinalize<__nv_bfloat16>(
+            output.data(), acc, sum, numTokens, numQHeads, headSize, stream.get());
+        break;
+#endif
+    default: TLLM_THROW("Unsupported data type for ring attention: %d", static_cast<int>(dataType));
+    }
+}
+
+} // namespace
+
+RingAttention::RingAttention(WorldConfig const& worldConfig, std::shared_ptr<NcclCommunicator> comm)
+    : mWorldConfig{worldConfig}
+    , mComm{std::move(comm)}
+{
+    TLLM_CHECK_WITH_INFO(mWorldConfig.isContextParallel(), "Ring attention requires context parallelism");
+}
+
+void RingAttention::forward(ITensor const& q, ITensor const& kv, ITensor& output,
+    std::vector<SizeType> const& shardLengths, float softmaxScale, bool causal, BufferManager const& manager)
+{
+    auto const cp = mWorldConfig.getContextParallelism();
+    auto const cpRank = mWorldConfig.getContextParallelRank();
+    TLLM_CHECK_WITH_INFO(static_cast<SizeType>(shardLengths.size()) == cp,
+        "Expected the lengths of %d shards, got %zu", cp, shardLengths.size());
+
+    auto const& qShape = q.getShape();
+    auto const& kvShape = kv.getShape();
+    auto const numTokens = shardLengths[cpRank];
+    auto const numQHeads = static_cast<SizeType>(qShape.d[1]);
+    auto const numKVHeads = static_cast<SizeType>(kvShape.d[2]);
+    auto const headSize = static_cast<SizeType>(qShape.d[2]);
+    TLLM_CHECK(qShape.d[0] == numTokens && kvShape.d[0] == numTokens);
+    TLLM_CHECK(kv.getDataType() == q.getDataType() && output.getDataType() == q.getDataType());
+
+    auto const maxShardLength = *std::max_element(shardLengths.begin(), shardLengths.end());
+    for (auto& buffer : mKvBuffers)
+    {
+        if (!buffer || buffer->getDataType() != kv.getDataType())
+        {
+            buffer = manager.gpu(ITensor::makeShape({maxShardLength, 2, numKVHeads, headSize}), kv.getDataType());
+        }
+        else
+        {
+            buffer->reshape(ITensor::makeShape({maxShardLength, 2, numKVHeads, headSize}));
+        }
+    }
+    auto const stateShape = ITensor::makeShape({numTokens, numQHeads});
+    if (!mAccumulator)
+    {
+        mAccumulator = manager.gpu(ITensor::makeShape({numTokens, numQHeads, headSize}), nvinfer1::DataType::kFLOAT);
+        mRowMax = manager.gpu(stateShape, nvinfer1::DataType::kFLOAT);
+        mRowSum = manager.gpu(stateShape, nvinfer1::DataType::kFLOAT);
+    }
+    else
+    {
+        mAccumulator->reshape(ITensor::makeShape({numTokens, numQHeads, headSize}));
+        mRowMax->reshape(stateShape);
+        mRowSum->reshape(stateShape);
+    }
+    manager.setZero(*mAccumulator);
+    manager.setZero(*mRowMax);
+    manager.setZero(*mRowSum);
+
+    std::vector<SizeType> shardPositions(cp, 0);
+    for (SizeType idx = 1; idx < cp; ++idx)
+    {
+        shardPositions[idx] = shardPositions[idx - 1] + shardLengths[idx - 1];
+    }
+
+    auto const& stream = manager.getStream();
+    auto const group = mWorldConfig.getContextParallelGroup();
+    auto const nextPeer = group[(cpRank + 1) % cp];
+    auto const prevPeer = group[(cpRank + cp - 1) % cp];
+
+    tk::RingAttentionStepParams params{};
+    params.q = q.data();
+    params.accumulator = bufferCast<float>(*mAccumulator);
+    params.rowMax = bufferCast<float>(*mRowMax);
+    params.rowSum = bufferCast<float>(*mRowSum);
+    params.numQTokens = numTokens;
+    params.qPosition = shardPositions[cpRank];
+    params.numQHeads = numQHeads;
+    params.numKVHeads = numKVHeads;
+    params.headSize = headSize;
+    params.softmaxScale = softmaxScale;
+    params.causal = causal;
+
+    // The local shard is sent first, the comm stream must not read it before it is written.
+    stream.record(mCommEvent);
+    mCommStream.wait(mCommEvent);
+
+    // At step s the shard of rank cpRank - s is attended while the one of rank cpRank - s - 1 is received.
+    IBuffer const* current = &kv;
+    std::array<TensorPtr, 2> received;
+    for (SizeType step = 0; step < cp; ++step)
+    {
+        auto const srcRank = (cpRank + cp - step) % cp;
+        auto const nextBufferIdx = step % 2;
+        if (step < cp - 1)
+        {
+            auto const nextLength = shardLengths[(srcRank + cp - 1) % cp];
+            received[nextBufferIdx] = ITensor::slice(mKvBuffers[nextBufferIdx], 0, nextLength);
+            auto& next = *received[nextBufferIdx];
+            // The buffer was last read by the previous step.
+            if (step >= 2)
+            {
+                mCommStream.wait(mComputeEvents[nextBufferIdx]);
+            }
+            // Opposite orders on neighbouring ranks so that the blocking send and receive pair up around the ring.
+            if (cpRank % 2 == 0)
+            {
+                mComm->send(*current, nextPeer, mCommStream);
+                mComm->receive(next, prevPeer, mCommStream);
+            }
+            else
+            {
+                mComm->receive(next, prevPeer, mCommStream);
+                mComm->send(*current, nextPeer, mCommStream);
+            }
+        }
+
+        params.kv = current->data();
+        params.numKvTokens = shardLengths[srcRank];
+        params.kvPosition = shardPositions[srcRank];
+        invokeRingAttentionStep(q.getDataType(), params, stream);
+
+        if (step < cp - 1)
+        {
+            // Step s reads the buffer received at step s - 1, i.e. buffer (s - 1) % 2.
+            if (step >= 1)
+            {
+                stream.record(mComputeEvents[(step - 1) % 2]);
+            }
+            mCommStream.record(mCommEvent);
+            stream.wait(mCommEvent);
+            current = received[nextBufferIdx].get();
+        }
+    }
+
+    invokeRingAttentionFinalize(
+        q.getDataType(), output, *mAccumulator, *mRowSum, numTokens, numQHeads, headSize, stream);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/ncclCommunicator.h"
+#include "tensorrt_llm/runtime/worldConfig.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Context attention of a sequence split across the ranks of a context parallel group (ring attention).
+//! \details Every rank holds a contiguous shard of the sequence: its queries and its K/V. The K/V shards travel
+//! around the ring over NCCL on a separate stream while the current shard is attended, so the transfer of the next
+//! shard overlaps with the compute of the current one.
+class RingAttention
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    //! \param comm Communicator over all ranks of the world, the peers are taken from the context parallel group.
+    RingAttention(WorldConfig const& worldConfig, std::shared_ptr<NcclCommunicator> comm);
+
+    //! \brief Attention of the queries of the local shard to the K/V of the whole sequence.
+    //! \param q Queries of the local shard after bias and RoPE, [numTokens, numQHeads, headSize]
+    //! \param kv K/V of the local shard, [numTokens, 2, numKVHeads, headSize]
+    //! \param output Attention output of the local shard, [numTokens, numQHeads, headSize]
+    //! \param shardLengths Tokens of the shard of every context parallel rank, in the order of the sequence.
+    void forward(ITensor const& q, ITensor const& kv, ITensor& output, std::vector<SizeType> const& shardLengths,
+        float softmaxScale, bool causal, BufferManager const& manager);
+
+private:
+    WorldConfig mWorldConfig;
+    std::shared_ptr<NcclCommunicator> mComm;
+    CudaStream mCommStream;
+    // Set when a step is done reading a K/V buffer and when a K/V shard has arrived.
+    std::array<CudaEvent, 2> mComputeEvents;
+    CudaEvent mCommEvent;
+
+    // K/V shards in flight, each one large enough for the largest shard.
+    std::array<TensorPtr, 2> mKvBuffers;
+    // State of the online softmax, see invokeRingAttentionStep.
+    TensorPtr mAccumulator;
+    TensorPtr mRowMax;
+    TensorPtr mRowSum;
+};
+
+} // namespace tensorrt_llm::runtime
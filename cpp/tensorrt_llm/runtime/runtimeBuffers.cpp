@@ -19,6 +19,7 @@
 #include "tensorrt_llm/batch_manager/kvCacheManager.h"
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/stlUtils.h"
+#include "tensorrt_llm/runtime/generationLogitsStreamer.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
 #include "tensorrt_llm/runtime/tllmRuntime.h"
 #include "tensorrt_llm/runtime/utils/sessionUtils.h"
@@ -123,7 +124,7 @@ void RuntimeBuffers::create(TllmRuntime& runtime, GptModelConfig const& modelCon
     auto& manager = runtime.getBufferManager();
     auto& engine = runtime.getEngine();
 
-    if (worldConfig.isLastPipelineParallelRank())
+    if (worldConfig.isLastPipelineParallelRank() && !modelConfig.computeHiddenStates())
     {
         auto const logitsType = engine.getTensorDataType("logits");
         logits = manager.emptyTensor(MemoryType::kGPU, logitsType);
@@ -152,7 +153,7 @@ void RuntimeBuffers::create(TllmRuntime& runtime, GptModelConfig const& modelCon
         {
             kvDtype = nvinfer1::DataType::kFP8;
         }
-        else if (modelConfig.getQuantMode().hasInt8KvCache())
+        else if (modelConfig.getQuantMode().hasInt8KvCache() || modelConfig.getQuantMode().hasInt4KvCache())
         {
             kvDtype = nvinfer1::DataType::kINT8;
         }
@@ -163,6 +164,8 @@ void RuntimeBuffers::create(TllmRuntime& runtime, GptModelConfig const& modelCon
     }
     else
     {
+        TLLM_CHECK_WITH_INFO(
+            !modelConfig.getQuantMode().hasInt4KvCache(), "The INT4 KV cache requires the paged KV cache");
         kvDtype = modelConfig.getQuantMode().hasFp8KvCache()
             ? nvinfer1::DataType::kFP8
             : engine.getTensorDataType(("present_key_value_" + std::to_string(firstLayerId)).c_str());
@@ -200,7 +203,7 @@ void RuntimeBuffers::create(TllmRuntime& runtime, GptModelConfig const& modelCon
 
     nbFinished = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
 
-    if (worldConfig.isPipelineParallel())
+    if (worldConfig.isPipelineParallel() || modelConfig.computeHiddenStates())
     {
         hiddenStates = manager.emptyTensor(MemoryType::kGPU, modelConfig.getDataType());
     }
@@ -233,7 +236,7 @@ void RuntimeBuffers::reshape(
     auto const maxSeqLength = generationConfig.maxSeqLength;
     auto const vocabSizePadded = modelConfig.getVocabSizePadded(worldConfig.getSize());
 
-    if (worldConfig.isLastPipelineParallelRank())
+    if (worldConfig.isLastPipelineParallelRank() && !modelConfig.computeHiddenStates())
     {
         if (modelConfig.computeContextLogits())
         {
@@ -256,8 +259,10 @@ void RuntimeBuffers::reshape(
 
         if (modelConfig.computeGenerationLogits())
         {
+            auto const numGenerationLogits
+                = streamGenerationLogits ? GenerationLogitsStreamer::kNumSlots : maxSeqLength - maxInputLength;
             allGenerationLogits->reshape(
-                ITensor::makeShape({(maxSeqLength - maxInputLength), batchSize, beamWidth, vocabSizePadded}));
+                ITensor::makeShape({numGenerationLogits, batchSize, beamWidth, vocabSizePadded}));
 
             cacheGenerationFragmentPointerDevice->reshape(
                 ITensor::makeShape({batchSize, (maxSeqLength - maxInputLength)}));
@@ -313,7 +318,7 @@ void RuntimeBuffers::reshape(
     cacheIndirectionDecoderInput->reshape(cacheIndirShape);
     cacheIndirectionDecoderOutput->reshape(cacheIndirShape);
 
-    if (worldConfig.isPipelineParallel())
+    if (worldConfig.isPipelineParallel() || modelConfig.computeHiddenStates())
     {
         // reserve max size
         auto const maxNumTokens = std::max(beamWidth, maxInputLength);
@@ -334,6 +339,102 @@ void RuntimeBuffers::reset(BufferManager& manager)
     manager.setZero(*cacheIndirectionDecoderOutput);
 }
 
+namespace
+{
+// Phases of a call to GptSession::generate, for the lifetimes of the planned tensors. The generation phase is 1.
+SizeType constexpr kContextPhase{0};
+SizeType constexpr kFinalizePhase{2};
+MemoryPlanner::Lifetime constexpr kPersistent{kContextPhase, kFinalizePhase};
+} // namespace
+
+void RuntimeBuffers::forEachPlannedTensor(PlannedTensorVisitor const& visit, KvCacheManager const* kvCacheManager,
+    GptModelConfig const& modelConfig, WorldConfig const& worldConfig)
+{
+    auto const batchSize = generationConfig.batchSize;
+    auto const beamWidth = generationConfig.beamWidth;
+    auto const maxAttentionWindow = generationConfig.maxAttentionWindow;
+    auto const maxSeqLength = generationConfig.maxSeqLength;
+    auto const vocabSizePadded = modelConfig.getVocabSizePadded(worldConfig.getSize());
+    auto const localNbLayers = modelConfig.getNbLayers(worldConfig.getPipelineParallelism());
+
+    if (worldConfig.isLastPipelineParallelRank() && !modelConfig.computeHiddenStates())
+    {
+        if (modelConfig.computeGenerationLogits())
+        {
+            // Written by the context step with the last token of the context, and by every generation step
+            auto const numGenerationLogits
+                = streamGenerationLogits ? GenerationLogitsStreamer::kNumSlots : maxSeqLength;
+            visit(allGenerationLogits,
+                ITensor::makeShape({numGenerationLogits, batchSize, beamWidth, vocabSizePadded}), kPersistent);
+            // Only used to merge the logits fragments after the last step
+            visit(cacheGenerationFragmentPointerDevice, ITensor::makeShape({batchSize, maxSeqLength}),
+                {kFinalizePhase, kFinalizePhase});
+        }
+        else if (modelConfig.computeContextLogits())
+        {
+            visit(allGenerationLogits, ITensor::makeShape({1, batchSize, beamWidth, vocabSizePadded}), kPersistent);
+        }
+    }
+
+    visit(lastTokenIds, ITensor::makeShape({batchSize * beamWidth}), kPersistent);
+
+    auto const kvCacheReserve = ITensor::makeShape(
+        {batchSize, 2, modelConfig.getNbKvHeads(), maxAttentionWindow, modelConfig.getSizePerHead()});
+    if (modelConfig.usePagedKvCache())
+    {
+        TLLM_CHECK(kvCacheManager);
+        auto const maxBlocksPerSeq = kvCacheManager->getMaxBlocksPerSeq();
+        auto const cacheBlockPointersShape
+            = ITensor::makeShape({localNbLayers, batchSize * beamWidth, 2, maxBlocksPerSeq});
+        visit(kvCacheBlockPointersDevice, cacheBlockPointersShape, kPersistent);
+    }
+    else
+    {
+        for (auto& presentKeysVal : presentKeysVals)
+        {
+            visit(presentKeysVal, kvCacheReserve, kPersistent);
+        }
+    }
+    for (auto& presentKeysValAlt : presentKeysValsAlt)
+    {
+        visit(presentKeysValAlt, kvCacheReserve, kPersistent);
+    }
+
+    auto const cacheIndirShape = ITensor::makeShape({batchSize, beamWidth, maxAttentionWindow});
+    visit(cacheIndirectionDecoderInput, cacheIndirShape, kPersistent);
+    visit(cacheIndirectionDecoderOutput, cacheIndirShape, kPersistent);
+}
+
+void RuntimeBuffers::addToPlan(MemoryPlanner& planner, KvCacheManager const* kvCacheManager,
+    GptModelConfig const& modelConfig, WorldConfig const& worldConfig)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    plannedTensorIds.clear();
+    forEachPlannedTensor(
+        [this, &planner](TensorPtr& tensor, ITensor::Shape const& maxShape, MemoryPlanner::Lifetime lifetime)
+        { plannedTensorIds.push_back(planner.add(maxShape, tensor->getDataType(), lifetime)); },
+        kvCacheManager, modelConfig, worldConfig);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void RuntimeBuffers::takeFromPlan(std::vector<TensorPtr> const& plannedTensors, KvCacheManager const* kvCacheManager,
+    GptModelConfig const& modelConfig, WorldConfig const& worldConfig)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    std::size_t next{0};
+    forEachPlannedTensor(
+        [this, &plannedTensors, &next](TensorPtr& tensor, ITensor::Shape const&, MemoryPlanner::Lifetime)
+        {
+            TLLM_CHECK(next < plannedTensorIds.size());
+            auto const& planned = plannedTensors.at(plannedTensorIds[next++]);
+            TLLM_CHECK(planned->getDataType() == tensor->getDataType());
+            tensor = planned;
+        },
+        kvCacheManager, modelConfig, worldConfig);
+    TLLM_CHECK_WITH_INFO(next == plannedTensorIds.size(), "The planned tensors changed since addToPlan");
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
 std::vector<RuntimeBuffers> RuntimeBuffers::split(
     SizeType contextBatchSize, GptModelConfig const& modelConfig, WorldConfig const& worldConfig)
 {
@@ -358,7 +459,8 @@ std::vector<RuntimeBuffers> RuntimeBuffers::split(
             buffers.contextLengthsHost = ITensor::slice(contextLengthsHost, offset, batchSize);
             buffers.contextLengthsDevice = ITensor::slice(contextLengthsDevice, offset, batchSize);
 
-            if (worldConfig.isLastPipelineParallelRank() && !modelConfig.computeContextLogits())
+            if (worldConfig.isLastPipelineParallelRank() && !modelConfig.computeContextLogits()
+                && !modelConfig.computeHiddenStates())
             {
                 buffers.logits = ITensor::slice(logits, offset, batchSize);
             }
@@ -403,7 +505,7 @@ std::vector<RuntimeBuffers> RuntimeBuffers::split(
                 buffers.presentKeysValsAlt = utils::sliceBufferVector(presentKeysValsAlt, offset, batchSize);
             }
 
-            if (worldConfig.isPipelineParallel())
+            if (worldConfig.isPipelineParallel() || modelConfig.computeHiddenStates())
             {
                 TLLM_CHECK_WITH_INFO(hiddenStates->getShape().nbDims == 3,
                     "Invalid shape for hiddenStates."); // Expect hiddens states shape to be [bs, seq_len, hidden_size]
@@ -558,6 +660,8 @@ void RuntimeBuffers::postContextStep(std::vector<RuntimeBuffers> const& contextB
         cacheBlockPointersShape.d[1] = batchSize * beamWidth;
         kvCacheBlockPointersHost->reshape(cacheBlockPointersShape);
         kvCacheBlockPointersDevice->reshape(cacheBlockPointersShape);
+        // the context steps wrote the device table directly
+        kvCacheBlockPointersUpdater.reset();
     }
 
     if (modelConfig.usePromptTuning())
@@ -647,7 +751,7 @@ void RuntimeBuffers::prepareContextStep(TensorPtr const& inputIds, TokenIdType c
             pastKeyValueLengthsPtr[i] = contextLengthsHostPtr[i];
         }
 
-        if (worldConfig.isPipelineParallel())
+        if (worldConfig.isPipelineParallel() || modelConfig.computeHiddenStates())
         {
             auto const hiddenSize
                 = hiddenStates->getShape().nbDims == 2 ? hiddenStates->getShape().d[1] : hiddenStates->getShape().d[2];
@@ -751,9 +855,8 @@ RuntimeBuffers::TensorPtr RuntimeBuffers::prepareNextStep(SizeType const step, B
 
         if (modelVariant == GptModelConfig::ModelVariant::kGpt)
         {
+            // Built together with lastTokenIds below
             positionIds->reshape(inputShape);
-            manager.copy(*contextLengthsDevice, *positionIds);
-            kernels::invokeAdd(*positionIds, step, stream);
         }
         else if (modelVariant == GptModelConfig::ModelVariant::kGlm)
         {
@@ -775,7 +878,7 @@ RuntimeBuffers::TensorPtr RuntimeBuffers::prepareNextStep(SizeType const step, B
             TLLM_THROW("Unsupported model variant");
         }
 
-        if (worldConfig.isPipelineParallel())
+        if (worldConfig.isPipelineParallel() || modelConfig.computeHiddenStates())
         {
             auto const hiddenSize
                 = hiddenStates->getShape().nbDims == 2 ? hiddenStates->getShape().d[1] : hiddenStates->getShape().d[2];
@@ -824,14 +927,13 @@ RuntimeBuffers::TensorPtr RuntimeBuffers::prepareNextStep(SizeType const step, B
             kvCacheManager->addToken(batchIdx);
         }
         kvCacheManager->getBlockPointersOfBatch(*kvCacheBlockPointersHost, firstBatchSlotIdx, batchSize, beamWidth);
-        manager.copy(*kvCacheBlockPointersHost, *kvCacheBlockPointersDevice);
+        kvCacheBlockPointersUpdater.update(*kvCacheBlockPointersHost, *kvCacheBlockPointersDevice, manager);
     }
 
-    kernels::invokeFill(*lastTokenIds, 1, stream);
-    if (modelConfig.usePackedInput())
-    {
-        kernels::invokeInclusiveSum(*lastTokenIds, *lastTokenIds, manager, stream);
-    }
+    auto const buildPositionIds
+        = modelConfig.useGptAttentionPlugin() && modelConfig.getModelVariant() == GptModelConfig::ModelVariant::kGpt;
+    kernels::invokeBuildGenerationStepInputs(buildPositionIds ? positionIds.get() : nullptr, *lastTokenIds,
+        *contextLengthsDevice, step, modelConfig.usePackedInput(), stream);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
     return nextInputIds;
 }
@@ -844,7 +946,7 @@ void RuntimeBuffers::getRuntimeBuffers(TensorMap& inputBuffers, TensorMap& outpu
     inputBuffers.clear();
     outputBuffers.clear();
 
-    if (worldConfig.isLastPipelineParallelRank())
+    if (worldConfig.isLastPipelineParallelRank() && !modelConfig.computeHiddenStates())
     {
         // feed a view to TensorRT runtime so reshaping does not change logits buffer
         outputBuffers.insert_or_assign("logits", ITensor::view(logits));
@@ -864,7 +966,8 @@ void RuntimeBuffers::getRuntimeBuffers(TensorMap& inputBuffers, TensorMap& outpu
     }
 
     inputBuffers.insert_or_assign("context_lengths", contextLengthsDevice);
-    if (!modelConfig.computeContextLogits())
+    // Engines that gather the logits or hidden states of all tokens have no last token ids
+    if (!modelConfig.computeContextLogits() && !modelConfig.computeHiddenStates())
     {
         inputBuffers.insert_or_assign("last_token_ids", lastTokenIds);
     }
@@ -16,13 +16,16 @@
 
 #pragma once
 
+#include "tensorrt_llm/runtime/blockPointerTableUpdater.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/gptModelConfig.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/memoryPlanner.h"
 #include "tensorrt_llm/runtime/promptTuningParams.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
 #include <array>
+#include <functional>
 #include <vector>
 
 namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -104,6 +107,7 @@ public:
     TensorPtr sinkTokenLengths;                // with attention plugin, host tensor
     TensorPtr kvCacheBlockPointersHost;        // [numLayers, batchSize * beamWidth, 2, maxBlocksPerSeq * 2]
     TensorPtr kvCacheBlockPointersDevice;      // [numLayers, batchSize * beamWidth, 2, maxBlocksPerSeq * 2]
+    BlockPointerTableUpdater kvCacheBlockPointersUpdater; // uploads changed block pointers in generation steps
 
     // References to tmp buffers
     TensorPtr newTokens;
@@ -135,6 +139,11 @@ public:
     TensorPtr
         cacheGenerationFragmentPointerHost;   // host pointer array, used in merge generation logits fragments kernel
 
+    // Keep only the slots of GenerationLogitsStreamer in `allGenerationLogits`
+    bool streamGenerationLogits{false};
+    // Indices in the MemoryPlanner of the tensors added by addToPlan
+    std::vector<SizeType> plannedTensorIds;
+
     bool allocated{false};
 
 public:
@@ -152,6 +161,15 @@ public:
 
     void reset(BufferManager& manager);
 
+    //! \brief Add the device tensors of fixed size to planner, with the largest shapes of the current
+    //! GenerationConfig. Call before the first reshape, so that the tensors are not allocated twice.
+    void addToPlan(MemoryPlanner& planner, KvCacheManager const* kvCacheManager, GptModelConfig const& modelConfig,
+        WorldConfig const& worldConfig);
+
+    //! \brief Replace the tensors added by addToPlan with the tensors allocated by the planner.
+    void takeFromPlan(std::vector<TensorPtr> const& plannedTensors, KvCacheManager const* kvCacheManager,
+        GptModelConfig const& modelConfig, WorldConfig const& worldConfig);
+
     std::vector<RuntimeBuffers> split(
         SizeType contextBatchSize, GptModelConfig const& modelConfig, WorldConfig const& worldConfig);
 
@@ -169,6 +187,12 @@ public:
         WorldConfig const& worldConfig) const;
 
 private:
+    using PlannedTensorVisitor = std::function<void(TensorPtr&, ITensor::Shape const&, MemoryPlanner::Lifetime)>;
+
+    //! \brief Visit the tensors managed by addToPlan and takeFromPlan, always in the same order.
+    void forEachPlannedTensor(PlannedTensorVisitor const& visit, KvCacheManager const* kvCacheManager,
+        GptModelConfig const& modelConfig, WorldConfig const& worldConfig);
+
     void gatherLastTokenLogits(
         BufferManager& manager, GptModelConfig const& modelConfig, WorldConfig const& worldConfig);
 
@@ -176,6 +176,311 @@ void invokeCopyBatch(IBuffer const& srcBuffer, IBuffer& dstBuffer, IBuffer const
         srcDataPtr, dstDataPtr, srcOffsetsPtr, dstOffsetsPtr, sizesPtr, static_cast<int32_t>(dataTypeSize));
 }
 
+namespace
+{
+__global__ void copyBatchEntries(CopyBatchEntry const* entries)
+{
+    auto const entry = entries[blockIdx.x];
+    auto const* src = static_cast<std::uint8_t const*>(entry.src);
+    auto* dst = static_cast<std::uint8_t*>(entry.dst);
+    auto const size = entry.size;
+    // Staged copies are 16-byte aligned, so most of them take the vectorized path
+    auto const alignment = reinterpret_cast<std::uintptr_t>(src) | reinterpret_cast<std::uintptr_t>(dst) | size;
+    if (alignment % sizeof(uint4) == 0)
+    {
+        for (auto idx = static_cast<std::uint64_t>(threadIdx.x) * sizeof(uint4); idx < size;
+             idx += static_cast<std::uint64_t>(blockDim.x) * sizeof(uint4))
+        {
+            *reinterpret_cast<uint4*>(dst + idx) = *reinterpret_cast<uint4 const*>(src + idx);
+        }
+    }
+    else
+    {
+        for (auto idx = static_cast<std::uint64_t>(threadIdx.x); idx < size; idx += blockDim.x)
+        {
+            dst[idx] = src[idx];
+        }
+    }
+}
+} // namespace
+
+void invokeCopyBatch(CopyBatchEntry const* entries, SizeType numCopies, CudaStream const& stream)
+{
+    if (numCopies == 0)
+    {
+        return;
+    }
+    copyBatchEntries<<<numCopies, 256, 0, stream.get()>>>(entries);
+}
+
+namespace
+{
+template <typename VecT>
+__global__ void copyBlocks(uint8_t* data, std::int32_t const* srcBlockIds, std::int32_t const* dstBlockIds,
+    std::size_t const blockSizeInBytes)
+{
+    constexpr auto VEC_ELTS = sizeof(VecT);
+    auto const srcStartIdx = static_cast<std::size_t>(srcBlockIds[blockIdx.y]) * blockSizeInBytes;
+    auto const dstStartIdx = static_cast<std::size_t>(dstBlockIds[blockIdx.y]) * blockSizeInBytes;
+    auto const tidx = (static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x) * VEC_ELTS;
+    auto const stride = static_cast<std::size_t>(blockDim.x) * gridDim.x * VEC_ELTS;
+
+    for (auto idx = tidx; idx < blockSizeInBytes; idx += stride)
+    {
+        *reinterpret_cast<VecT*>(&data[dstStartIdx + idx]) = *reinterpret_cast<VecT const*>(&data[srcStartIdx + idx]);
+    }
+}
+} // namespace
+
+void invokeCopyBlocks(ITensor& pool, IBuffer const& srcBlockIds, IBuffer const& dstBlockIds, CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(srcBlockIds.getSize() == dstBlockIds.getSize(), "Block id buffers have different sizes");
+    auto const numCopies = srcBlockIds.getSize();
+    if (numCopies == 0)
+    {
+        return;
+    }
+    auto const numBlocks = static_cast<std::size_t>(pool.getShape().d[0]);
+    auto const blockSizeInBytes = pool.getSizeInBytes() / numBlocks;
+    auto dataPtr = reinterpret_cast<uint8_t*>(pool.data());
+    auto srcBlockIdsPtr = bufferCast<std::int32_t>(srcBlockIds);
+    auto dstBlockIdsPtr = bufferCast<std::int32_t>(dstBlockIds);
+
+    dim3 const blockSize{256};
+    std::size_t const gridMax{std::numeric_limits<std::uint32_t>::max()};
+    auto const launch = [&](auto kernel, std::size_t vectorSize)
+    {
+        std::size_t const gridx{tc::ceilDiv(blockSizeInBytes / vectorSize, blockSize.x)};
+        dim3 const gridSize{
+            static_cast<std::uint32_t>(std::min(gridx, gridMax)), static_cast<std::uint32_t>(numCopies)};
+        kernel<<<gridSize, blockSize, 0, stream.get()>>>(dataPtr, srcBlockIdsPtr, dstBlockIdsPtr, blockSizeInBytes);
+    };
+    // Block offsets are multiples of the block size, so the widest vector dividing it keeps all accesses aligned.
+    if (blockSizeInBytes % 16 == 0)
+    {
+        launch(copyBlocks<uint4>, 16);
+    }
+    else if (blockSizeInBytes % 4 == 0)
+    {
+        launch(copyBlocks<uint32_t>, 4);
+    }
+    else
+    {
+        launch(copyBlocks<uint8_t>, 1);
+    }
+}
+
+namespace
+{
+__global__ void scatterDeltas(std::int64_t* data, std::int64_t const* indices, std::int64_t const* values,
+    std::size_t const numDeltas)
+{
+    auto const tidx = static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    auto const stride = static_cast<std::size_t>(blockDim.x) * gridDim.x;
+
+    for (auto idx = tidx; idx < numDeltas; idx += stride)
+    {
+        data[indices[idx]] = values[idx];
+    }
+}
+} // namespace
+
+void invokeScatterDeltas(IBuffer& buffer, IBuffer const& deltas, CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(deltas.getSize() % 2 == 0, "Deltas must hold pairs of indices and values");
+    auto const numDeltas = deltas.getSize() / 2;
+    if (numDeltas == 0)
+    {
+        return;
+    }
+    auto data = bufferCast<std::int64_t>(buffer);
+    auto indices = bufferCast<std::int64_t>(deltas);
+    dim3 const blockSize{256};
+    std::size_t const gridx{tc::ceilDiv(numDeltas, blockSize.x)};
+    std::size_t const gridMax{std::numeric_limits<std::uint32_t>::max()};
+    dim3 const gridSize{static_cast<std::uint32_t>(std::min(gridx, gridMax))};
+
+    scatterDeltas<<<gridSize, blockSize, 0, stream.get()>>>(data, indices, indices + numDeltas, numDeltas);
+}
+
+namespace
+{
+__global__ void scatterDecoderSetup(DecoderSetupParams const* setupParams, TokenIdType* endIds, SizeType* lengths,
+    SizeType* sequenceLimitLength, TokenIdType* newTokensSteps, std::uint8_t* finishedSteps,
+    SizeType* wordsAutomataStates, SizeType* streamedLengths, SizeType const maxBatchSize,
+    SizeType const maxBeamWidth, SizeType const maxTokensPerStep, SizeType const numAutomata)
+{
+    auto const params = setupParams[blockIdx.x];
+    auto const slot = params.batchSlot;
+    for (auto beam = static_cast<SizeType>(threadIdx.x); beam < maxBeamWidth; beam += blockDim.x)
+    {
+        endIds[slot * maxBeamWidth + beam] = params.endId;
+        lengths[slot * maxBeamWidth + beam] = params.inputLength;
+    }
+    for (auto idx = static_cast<SizeType>(threadIdx.x); idx < maxTokensPerStep * maxBeamWidth; idx += blockDim.x)
+    {
+        auto const step = idx / maxBeamWidth;
+        auto const beam = idx % maxBeamWidth;
+        auto const offset = (step * maxBatchSize + slot) * maxBeamWidth + beam;
+        newTokensSteps[offset] = 0;
+        finishedSteps[offset] = 0;
+    }
+    for (auto idx = static_cast<SizeType>(threadIdx.x); idx < numAutomata; idx += blockDim.x)
+    {
+        wordsAutomataStates[slot * numAutomata + idx] = 0;
+    }
+    if (threadIdx.x == 0)
+    {
+        sequenceLimitLength[slot] = params.sequenceLimitLength;
+        if (streamedLengths != nullptr)
+        {
+            streamedLengths[slot] = params.inputLength;
+        }
+    }
+}
+} // namespace
+
+void invokeScatterDecoderSetup(IBuffer const& setupParams, SizeType numRequests, ITensor& endIds, ITensor& lengths,
+    IBuffer& sequenceLimitLength, ITensor& newTokensSteps, ITensor& finishedSteps, ITensor& wordsAutomataStates,
+    IBuffer* streamedLengths, CudaStream const& stream)
+{
+    if (numRequests == 0)
+    {
+        return;
+    }
+    TLLM_CHECK(setupParams.getSizeInBytes() >= numRequests * sizeof(DecoderSetupParams));
+    auto const& stepsShape = newTokensSteps.getShape();
+    TLLM_CHECK(stepsShape.nbDims == 3);
+    TLLM_CHECK(finishedSteps.getSizeInBytes() == newTokensSteps.getSize() * sizeof(std::uint8_t));
+    auto const maxTokensPerStep = stepsShape.d[0];
+    auto const maxBatchSize = stepsShape.d[1];
+    auto const maxBeamWidth = stepsShape.d[2];
+    TLLM_CHECK(static_cast<SizeType>(endIds.getSize()) == maxBatchSize * maxBeamWidth);
+    TLLM_CHECK(static_cast<SizeType>(lengths.getSize()) == maxBatchSize * maxBeamWidth);
+    auto const numAutomata = static_cast<SizeType>(wordsAutomataStates.getSize()) / maxBatchSize;
+
+    auto const* params = reinterpret_cast<DecoderSetupParams const*>(setupParams.data());
+    auto* finished = static_cast<std::uint8_t*>(finishedSteps.data());
+    auto* streamed = streamedLengths != nullptr ? bufferCast<SizeType>(*streamedLengths) : nullptr;
+    dim3 const blockSize{32};
+    dim3 const gridSize{static_cast<std::uint32_t>(numRequests)};
+    scatterDecoderSetup<<<gridSize, blockSize, 0, stream.get()>>>(params, bufferCast<TokenIdType>(endIds),
+        bufferCast<SizeType>(lengths), bufferCast<SizeType>(sequenceLimitLength),
+        bufferCast<TokenIdType>(newTokensSteps), finished, bufferCast<SizeType>(wordsAutomataStates), streamed,
+        maxBatchSize, maxBeamWidth, maxTokensPerStep, numAutomata);
+}
+
+namespace
+{
+auto constexpr kTokenStreamBlockSize = 256;
+
+__global__ void writeTokenStream(TokenStreamRecord* records, std::int64_t* writeIndex, SizeType const capacity,
+    SizeType* streamedLengths, TokenIdType const* outputIds, float const* logProbs, std::uint8_t const* finished,
+    SizeType const* sequenceLengths, SizeType const* slots, SizeType const* finishedOffsets, SizeType const numSlots,
+    SizeType const beamWidth, SizeType const maxSequenceLength)
+{
+    using BlockScan = cub::BlockScan<SizeType, kTokenStreamBlockSize>;
+    using BlockReduce = cub::BlockReduce<SizeType, kTokenStreamBlockSize>;
+    __shared__ typename BlockScan::TempStorage tempStorage;
+    __shared__ typename BlockReduce::TempStorage reduceTempStorage;
+    __shared__ SizeType numNewTokens;
+
+    SizeType threadNumTokens{0};
+    for (auto idx = static_cast<SizeType>(threadIdx.x); idx < numSlots; idx += kTokenStreamBlockSize)
+    {
+        auto const slot = slots[idx];
+        threadNumTokens += max(sequenceLengths[slot * beamWidth] - streamedLengths[slot], 0);
+    }
+    auto const blockNumTokens = BlockReduce(reduceTempStorage).Sum(threadNumTokens);
+    if (threadIdx.x == 0)
+    {
+        numNewTokens = blockNumTokens;
+    }
+    __syncthreads();
+
+    // Only this kernel writes the index, launches on the same stream see the value of the previous launch.
+    auto baseIdx = *writeIndex;
+    // Records overwritten again within this launch are skipped, so that every record has a single writer.
+    auto const minRecordIdx = baseIdx + numNewTokens - capacity;
+    for (SizeType chunkStart = 0; chunkStart < numSlots; chunkStart += kTokenStreamBlockSize)
+    {
+        auto const idx = chunkStart + static_cast<SizeType>(threadIdx.x);
+        SizeType slot{0};
+        SizeType firstPos{0};
+        SizeType numTokens{0};
+        if (idx < numSlots)
+        {
+            slot = slots[idx];
+            firstPos = streamedLengths[slot];
+            numTokens = max(sequenceLengths[slot * beamWidth] - firstPos, 0);
+        }
+        SizeType offset{0};
+        SizeType total{0};
+        BlockScan(tempStorage).ExclusiveSum(numTokens, offset, total);
+
+        auto const* ids = outputIds + static_cast<std::size_t>(slot) * beamWidth * maxSequenceLength;
+        auto const* probs = logProbs + static_cast<std::size_t>(slot) * beamWidth * maxSequenceLength;
+        for (SizeType ti = 0; ti < numTokens; ++ti)
+        {
+            auto const recordIdx = baseIdx + offset + ti;
+            if (recordIdx < minRecordIdx)
+            {
+                continue;
+            }
+            auto volatile* record = records + recordIdx % capacity;
+            auto const pos = firstPos + ti;
+            // Invalidate the record first, so that the host can detect that it is overwritten while reading it.
+            record->sequence = 0;
+            __threadfence_system();
+            record->slot = slot;
+            record->position = pos;
+            record->token = ids[pos];
+            record->logProb = probs[pos];
+            record->finished = ti == numTokens - 1 ? finished[finishedOffsets[idx]] : 0;
+            __threadfence_system();
+            record->sequence = recordIdx + 1;
+        }
+        if (numTokens > 0)
+        {
+            streamedLengths[slot] = firstPos + numTokens;
+        }
+        baseIdx += total;
+        // tempStorage is reused by the next chunk
+        __syncthreads();
+    }
+
+    __threadfence_system();
+    if (threadIdx.x == 0)
+    {
+        *static_cast<std::int64_t volatile*>(writeIndex) = baseIdx;
+    }
+}
+} // namespace
+
+void invokeWriteTokenStream(TokenStreamRing& ring, IBuffer& streamedLengths, ITensor const& outputIds,
+    ITensor const& logProbs, IBuffer const& finished, ITensor const& sequenceLengths, IBuffer const& slots,
+    IBuffer const& finishedOffsets, SizeType numSlots, CudaStream const& stream)
+{
+    auto const& outputIdsShape = outputIds.getShape();
+    TLLM_CHECK_WITH_INFO(outputIdsShape.nbDims == 3, "Output ids must have shape [batch, beam, sequence]");
+    TLLM_CHECK(logProbs.getShape().nbDims == 3 && logProbs.getShape().d[2] == outputIdsShape.d[2]);
+    TLLM_CHECK(static_cast<SizeType>(slots.getSize()) >= numSlots);
+    TLLM_CHECK(static_cast<SizeType>(finishedOffsets.getSize()) >= numSlots);
+    if (numSlots == 0)
+    {
+        return;
+    }
+    auto const beamWidth = static_cast<SizeType>(outputIdsShape.d[1]);
+    auto const maxSequenceLength = static_cast<SizeType>(outputIdsShape.d[2]);
+
+    auto* records = reinterpret_cast<TokenStreamRecord*>(ring.getRecords()->data());
+    writeTokenStream<<<1, kTokenStreamBlockSize, 0, stream.get()>>>(records,
+        bufferCast<std::int64_t>(*ring.getWriteIndex()), ring.getCapacity(), bufferCast<SizeType>(streamedLengths),
+        bufferCast<TokenIdType>(outputIds), bufferCast<float>(logProbs),
+        reinterpret_cast<std::uint8_t const*>(finished.data()), bufferCast<SizeType>(sequenceLengths),
+        bufferCast<SizeType>(slots), bufferCast<SizeType>(finishedOffsets), numSlots, beamWidth, maxSequenceLength);
+}
+
 namespace
 {
 template <typename T>
@@ -208,6 +513,43 @@ template void invokeAdd(IBuffer&, std::int32_t, CudaStream const&);
 template void invokeAdd(IBuffer&, std::int8_t, CudaStream const&);
 template void invokeAdd(IBuffer&, float, CudaStream const&);
 
+namespace
+{
+__global__ void buildGenerationStepInputs(SizeType* positionIds, SizeType* lastTokenIds,
+    SizeType const* contextLengths, SizeType size, SizeType step, bool packedInput)
+{
+    auto const idx = static_cast<SizeType>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (idx >= size)
+    {
+        return;
+    }
+    if (positionIds != nullptr)
+    {
+        positionIds[idx] = contextLengths[idx] + step;
+    }
+    // Every sequence has one token, the inclusive sum of ones for packed inputs
+    lastTokenIds[idx] = packedInput ? idx + 1 : 1;
+}
+} // namespace
+
+void invokeBuildGenerationStepInputs(IBuffer* positionIds, IBuffer& lastTokenIds, IBuffer const& contextLengths,
+    SizeType step, bool packedInput, CudaStream const& stream)
+{
+    auto const size = static_cast<SizeType>(lastTokenIds.getSize());
+    TLLM_CHECK_WITH_INFO(positionIds == nullptr
+            || (positionIds->getSize() == lastTokenIds.getSize() && contextLengths.getSize() == lastTokenIds.getSize()),
+        "Position ids, last token ids and context lengths must have the same size");
+    if (size == 0)
+    {
+        return;
+    }
+    dim3 const blockSize{256};
+    dim3 const gridSize{static_cast<std::uint32_t>(tc::ceilDiv(size, static_cast<SizeType>(blockSize.x)))};
+    buildGenerationStepInputs<<<gridSize, blockSize, 0, stream.get()>>>(
+        positionIds != nullptr ? bufferCast<SizeType>(*positionIds) : nullptr, bufferCast<SizeType>(lastTokenIds),
+        positionIds != nullptr ? bufferCast<SizeType>(contextLengths) : nullptr, size, step, packedInput);
+}
+
 namespace
 {
 template <typename T>
@@ -1214,4 +1556,242 @@ void mergeLogitsFragments(BufferManager const& bufferManager, ITensor& output, s
     }
 }
 
+namespace
+{
+template <typename T>
+__global__ void mergeLoraWeightsKernel(T* merged, T const* base, T const* inWeights, T const* outWeights,
+    std::uint32_t outDim, std::uint32_t inDim, std::uint32_t rank)
+{
+    auto const col = blockIdx.x * blockDim.x + threadIdx.x;
+    auto const row = blockIdx.y;
+    if (col >= inDim)
+    {
+        return;
+    }
+    // Accumulate in float, the low-rank product is tiny compared to the base weight
+    auto const idx = static_cast<std::size_t>(row) * inDim + col;
+    float value = static_cast<float>(base[idx]);
+    for (std::uint32_t r = 0; r < rank; ++r)
+    {
+        value += static_cast<float>(outWeights[static_cast<std::size_t>(row) * rank + r])
+            * static_cast<float>(inWeights[static_cast<std::size_t>(r) * inDim + col]);
+    }
+    merged[idx] = static_cast<T>(value);
+}
+
+template <typename T>
+__global__ void concatScaled2DKernel(T* output, T const* first, T const* second, std::uint32_t nbRows,
+    std::uint32_t firstCols, std::uint32_t secondCols, float firstScale)
+{
+    auto const row = blockIdx.y;
+    auto const nbCols = firstCols + secondCols;
+    for (auto col = blockIdx.x * blockDim.x + threadIdx.x; col < nbCols; col += blockDim.x * gridDim.x)
+    {
+        output[static_cast<std::size_t>(row) * nbCols + col] = col < firstCols
+            ? static_cast<T>(firstScale * static_cast<float>(first[static_cast<std::size_t>(row) * firstCols + col]))
+            : second[static_cast<std::size_t>(row) * secondCols + col - firstCols];
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeMergeLoraWeights(
+    ITensor& merged, ITensor const& base, ITensor const& inWeights, ITensor const& outWeights, CudaStream const& stream)
+{
+    auto const& shape = base.getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims == 2, "base weights must be [outDim, inDim]");
+    auto const outDim = static_cast<std::uint32_t>(shape.d[0]);
+    auto const inDim = static_cast<std::uint32_t>(shape.d[1]);
+    auto const rank = static_cast<std::uint32_t>(inWeights.getShape().d[0]);
+    TLLM_CHECK_WITH_INFO(merged.getSize() == base.getSize(), "merged and base weights must have the same size");
+    TLLM_CHECK_WITH_INFO(inWeights.getSize() == static_cast<std::size_t>(rank) * inDim,
+        common::fmtstr("in weights must be [%u, %u]", rank, inDim));
+    TLLM_CHECK_WITH_INFO(outWeights.getSize() == static_cast<std::size_t>(outDim) * rank,
+        common::fmtstr("out weights must be [%u, %u]", outDim, rank));
+
+    dim3 const blockSize{256, 1, 1};
+    dim3 const gridSize{static_cast<std::uint32_t>(tc::ceilDiv(inDim, blockSize.x)), outDim, 1};
+    mergeLoraWeightsKernel<<<gridSize, blockSize, 0, stream.get()>>>(bufferCast<T>(merged), bufferCast<T const>(base),
+        bufferCast<T const>(inWeights), bufferCast<T const>(outWeights), outDim, inDim, rank);
+}
+
+void mergeLoraWeights(
+    ITensor& merged, ITensor const& base, ITensor const& inWeights, ITensor const& outWeights, CudaStream const& stream)
+{
+    switch (base.getDataType())
+    {
+    case nvinfer1::DataType::kFLOAT: invokeMergeLoraWeights<float>(merged, base, inWeights, outWeights, stream); break;
+    case nvinfer1::DataType::kHALF: invokeMergeLoraWeights<half>(merged, base, inWeights, outWeights, stream); break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        invokeMergeLoraWeights<__nv_bfloat16>(merged, base, inWeights, outWeights, stream);
+        break;
+#endif // ENABLE_BF16
+    default: TLLM_CHECK_WITH_INFO(false, "data type not supported");
+    }
+}
+
+template <typename T>
+void invokeConcatScaled2D(ITensor& output, ITensor const& first, float firstScale, ITensor const* second, SizeType dim,
+    CudaStream const& stream)
+{
+    auto const& firstShape = first.getShape();
+    TLLM_CHECK_WITH_INFO(firstShape.nbDims == 2, "only 2D tensors are supported");
+    TLLM_CHECK_WITH_INFO(dim == 0 || dim == 1, common::fmtstr("invalid concat dimension %d", dim));
+    auto const secondSize = second != nullptr ? second->getSize() : 0;
+    TLLM_CHECK_WITH_INFO(output.getSize() == first.getSize() + secondSize,
+        "output must hold exactly the two concatenated tensors");
+
+    // Along dim 0 the tensors are contiguous, i.e. a single row of first and second
+    auto const nbRows = dim == 0 ? 1u : static_cast<std::uint32_t>(firstShape.d[0]);
+    auto const firstCols = static_cast<std::uint32_t>(first.getSize() / nbRows);
+    auto const secondCols = static_cast<std::uint32_t>(secondSize / nbRows);
+    if (dim == 1 && second != nullptr)
+    {
+        TLLM_CHECK_WITH_INFO(second->getShape().d[0] == firstShape.d[0], "the tensors must have the same rows");
+    }
+
+    dim3 const blockSize{256, 1, 1};
+    std::size_t const gridx{tc::ceilDiv(firstCols + secondCols, blockSize.x)};
+    std::size_t const gridMax{std::numeric_limits<std::uint16_t>::max()};
+    dim3 const gridSize{static_cast<std::uint32_t>(std::min(gridx, gridMax)), nbRows, 1};
+    concatScaled2DKernel<<<gridSize, blockSize, 0, stream.get()>>>(bufferCast<T>(output), bufferCast<T const>(first),
+        second != nullptr ? bufferCast<T const>(*second) : nullptr, nbRows, firstCols, secondCols, firstScale);
+}
+
+void concatScaled2D(ITensor& output, ITensor const& first, float firstScale, ITensor const* second, SizeType dim,
+    CudaStream const& stream)
+{
+    switch (first.getDataType())
+    {
+    case nvinfer1::DataType::kFLOAT:
+        invokeConcatScaled2D<float>(output, first, firstScale, second, dim, stream);
+        break;
+    case nvinfer1::DataType::kHALF: invokeConcatScaled2D<half>(output, first, firstScale, second, dim, stream); break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        invokeConcatScaled2D<__nv_bfloat16>(output, first, firstScale, second, dim, stream);
+        break;
+#endif // ENABLE_BF16
+    default: TLLM_CHECK_WITH_INFO(false, "data type not supported");
+    }
+}
+
+namespace
+{
+constexpr int kEmbeddingPoolingBlockSize = 256;
+
+// One block per sequence. hiddenStates holds the rows of the tokens of sequence i from inputOffsets[i] (packed input)
+// or from i * maxInputLength (padded input).
+template <typename T>
+__global__ void embeddingPoolingKernel(float* embeddings, T const* hiddenStates, SizeType const* contextLengths,
+    SizeType maxInputLength, SizeType hiddenSize, bool inputPacked, EmbeddingPooling pooling, bool normalize)
+{
+    using BlockReduce = cub::BlockReduce<float, kEmbeddingPoolingBlockSize>;
+    __shared__ typename BlockReduce::TempStorage reduceTempStorage;
+    __shared__ float normScale;
+
+    auto const batchIdx = static_cast<SizeType>(blockIdx.x);
+    auto const length = contextLengths[batchIdx];
+    std::size_t firstRow{0};
+    if (inputPacked)
+    {
+        for (SizeType bi = 0; bi < batchIdx; ++bi)
+        {
+            firstRow += contextLengths[bi];
+        }
+    }
+    else
+    {
+        firstRow = static_cast<std::size_t>(batchIdx) * maxInputLength;
+    }
+    T const* rows = hiddenStates + firstRow * hiddenSize;
+    float* output = embeddings + static_cast<std::size_t>(batchIdx) * hiddenSize;
+
+    float threadSumSq{0.f};
+    for (SizeType h = threadIdx.x; h < hiddenSize; h += blockDim.x)
+    {
+        float value{0.f};
+        if (length > 0 && pooling == EmbeddingPooling::kLAST)
+        {
+            value = static_cast<float>(rows[static_cast<std::size_t>(length - 1) * hiddenSize + h]);
+        }
+        else if (length > 0)
+        {
+            float acc{0.f};
+            float weightSum{0.f};
+            for (SizeType t = 0; t < length; ++t)
+            {
+                auto const weight = pooling == EmbeddingPooling::kWEIGHTED_MEAN ? static_cast<float>(t + 1) : 1.f;
+                acc += weight * static_cast<float>(rows[static_cast<std::size_t>(t) * hiddenSize + h]);
+                weightSum += weight;
+            }
+            value = acc / weightSum;
+        }
+        output[h] = value;
+        threadSumSq += value * value;
+    }
+
+    if (!normalize)
+    {
+        return;
+    }
+    auto const sumSq = BlockReduce(reduceTempStorage).Sum(threadSumSq);
+    if (threadIdx.x == 0)
+    {
+        normScale = rsqrtf(fmaxf(sumSq, 1e-12f));
+    }
+    __syncthreads();
+    for (SizeType h = threadIdx.x; h < hiddenSize; h += blockDim.x)
+    {
+        output[h] *= normScale;
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeEmbeddingPooling(ITensor& embeddings, ITensor const& hiddenStates, ITensor const& contextLengths,
+    EmbeddingPooling pooling, bool normalize, CudaStream const& stream)
+{
+    auto const& shape = hiddenStates.getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims == 2 || shape.nbDims == 3,
+        "hidden states must be [numTokens, hiddenSize] or [batchSize, maxInputLength, hiddenSize]");
+    auto const inputPacked = shape.nbDims == 2;
+    auto const hiddenSize = static_cast<SizeType>(shape.d[shape.nbDims - 1]);
+    auto const maxInputLength = inputPacked ? 0 : static_cast<SizeType>(shape.d[1]);
+    auto const batchSize = static_cast<SizeType>(contextLengths.getSize());
+    TLLM_CHECK_WITH_INFO(inputPacked || shape.d[0] == batchSize, "hidden states and context lengths mismatch");
+    TLLM_CHECK_WITH_INFO(embeddings.getDataType() == nvinfer1::DataType::kFLOAT, "embeddings must be float");
+    TLLM_CHECK_WITH_INFO(embeddings.getSize() == static_cast<std::size_t>(batchSize) * hiddenSize,
+        common::fmtstr("embeddings must be [%d, %d]", batchSize, hiddenSize));
+    if (batchSize == 0)
+    {
+        return;
+    }
+
+    embeddingPoolingKernel<<<batchSize, kEmbeddingPoolingBlockSize, 0, stream.get()>>>(bufferCast<float>(embeddings),
+        bufferCast<T const>(hiddenStates), bufferCast<SizeType const>(contextLengths), maxInputLength, hiddenSize,
+        inputPacked, pooling, normalize);
+}
+
+void embeddingPooling(ITensor& embeddings, ITensor const& hiddenStates, ITensor const& contextLengths,
+    EmbeddingPooling pooling, bool normalize, CudaStream const& stream)
+{
+    switch (hiddenStates.getDataType())
+    {
+    case nvinfer1::DataType::kFLOAT:
+        invokeEmbeddingPooling<float>(embeddings, hiddenStates, contextLengths, pooling, normalize, stream);
+        break;
+    case nvinfer1::DataType::kHALF:
+        invokeEmbeddingPooling<half>(embeddings, hiddenStates, contextLengths, pooling, normalize, stream);
+        break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        invokeEmbeddingPooling<__nv_bfloat16>(embeddings, hiddenStates, contextLengths, pooling, normalize, stream);
+        break;
+#endif // ENABLE_BF16
+    default: TLLM_CHECK_WITH_INFO(false, "data type not supported");
+    }
+}
+
 } // namespace tensorrt_llm::runtime::kernels
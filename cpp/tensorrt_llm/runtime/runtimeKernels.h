@@ -19,7 +19,9 @@
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/generationOutput.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/tokenStreamRing.h"
 
 namespace tensorrt_llm::runtime::kernels
 {
@@ -36,11 +38,73 @@ void invokeFillBatch(
 void invokeCopyBatch(IBuffer const& srcBuffer, IBuffer& dstBuffer, IBuffer const& srcOffsets, IBuffer const& dstOffsets,
     IBuffer const& sizes, std::size_t maxStride, CudaStream const& stream);
 
+//! \brief A copy of size bytes between two regions addressable by the device.
+struct CopyBatchEntry
+{
+    void const* src;
+    void* dst;
+    std::uint64_t size;
+};
+
+//! \brief Copy numCopies small regions between unrelated buffers in a single launch, one block per copy.
+//! \param entries Device array of numCopies entries.
+void invokeCopyBatch(CopyBatchEntry const* entries, SizeType numCopies, CudaStream const& stream);
+
+//! \brief Copy blocks srcBlockIds[i] to dstBlockIds[i] of a pool of shape [numBlocks, ...] in a single launch.
+//! \param srcBlockIds, dstBlockIds Device buffers of kINT32 block ids with the same size.
+void invokeCopyBlocks(
+    ITensor& pool, IBuffer const& srcBlockIds, IBuffer const& dstBlockIds, CudaStream const& stream);
+
+//! \brief Patch single elements of a kINT64 buffer, buffer[deltas[i]] = deltas[n + i] for i < n.
+//! \param deltas Device buffer of kINT64 with 2 * n elements, n indices followed by n values.
+void invokeScatterDeltas(IBuffer& buffer, IBuffer const& deltas, CudaStream const& stream);
+
+//! \brief Append the tokens generated since the last call to the ring of a TokenStreamRing, beam 0 only.
+//! \details For each slot the tokens in [streamedLengths[slot], sequenceLengths[slot]) are written, then
+//! streamedLengths and the write index of the ring are updated.
+//! \param outputIds [maxBatchSize, maxBeamWidth, maxSequenceLength], on gpu
+//! \param logProbs [maxBatchSize, maxBeamWidth, maxSequenceLength], on gpu
+//! \param finished Device buffer of FinishedState, indexed by finishedOffsets
+//! \param sequenceLengths [batchSize, maxBeamWidth], on gpu
+//! \param slots, finishedOffsets Buffers of kINT32 with one entry per request decoded in this step, pinned.
+void invokeWriteTokenStream(TokenStreamRing& ring, IBuffer& streamedLengths, ITensor const& outputIds,
+    ITensor const& logProbs, IBuffer const& finished, ITensor const& sequenceLengths, IBuffer const& slots,
+    IBuffer const& finishedOffsets, SizeType numSlots, CudaStream const& stream);
+
+//! \brief Values of a new request of GptDecoderBatch, staged on the host for invokeScatterDecoderSetup.
+struct DecoderSetupParams
+{
+    SizeType batchSlot;
+    TokenIdType endId;
+    SizeType inputLength;
+    SizeType sequenceLimitLength;
+};
+
+//! \brief Set up the slots of numRequests new requests in a single launch: endIds, lengths and sequenceLimitLength are
+//! filled from setupParams, the decoding state of the slots is reset.
+//! \param setupParams Device buffer of numRequests DecoderSetupParams.
+//! \param endIds, lengths [maxBatchSize, maxBeamWidth], on gpu
+//! \param sequenceLimitLength [maxBatchSize], on gpu
+//! \param newTokensSteps, finishedSteps [maxTokensPerStep, maxBatchSize, maxBeamWidth], zeroed, on gpu
+//! \param wordsAutomataStates [maxBatchSize, numAutomata], zeroed, on gpu
+//! \param streamedLengths [maxBatchSize], set to the input lengths, optional, on gpu
+void invokeScatterDecoderSetup(IBuffer const& setupParams, SizeType numRequests, ITensor& endIds, ITensor& lengths,
+    IBuffer& sequenceLimitLength, ITensor& newTokensSteps, ITensor& finishedSteps, ITensor& wordsAutomataStates,
+    IBuffer* streamedLengths, CudaStream const& stream);
+
 template <typename T>
 void invokeAdd(IBuffer& buffer, T value, CudaStream const& stream);
 
 void reduce(IBuffer& output, IBuffer const& input, CudaStream const& stream);
 
+//! \brief Build the per-step inputs of a generation step on the device in a single launch.
+//! \details Writes positionIds[i] = contextLengths[i] + step, and lastTokenIds[i] = i + 1 for packed inputs or 1
+//! otherwise. Replaces a copy, an add, a fill and a scan with a temporary allocation per step.
+//! \param positionIds kINT32 buffer of the same size as lastTokenIds, or nullptr to only build lastTokenIds.
+//! \param contextLengths kINT32 buffer of the same size as lastTokenIds, on gpu. Unused without positionIds.
+void invokeBuildGenerationStepInputs(IBuffer* positionIds, IBuffer& lastTokenIds, IBuffer const& contextLengths,
+    SizeType step, bool packedInput, CudaStream const& stream);
+
 void invokeTranspose(ITensor& output, ITensor const& input, CudaStream const& stream);
 
 void invokeTransposeWithOutputOffset(
@@ -94,4 +158,21 @@ void mergeLogitsFragments(BufferManager const& bufferManager, ITensor& output, s
     ITensor& cachePointerDevice, ITensor& cachePointerHost, SizeType firstBatchSlotIdx, SizeType const microBatchSize,
     SizeType const beamWidth, CudaStream const& stream, int stepOffset);
 
+//! \brief Merge a LoRA adapter into a weight, merged = base + outWeights * inWeights.
+//! \details base and merged are [outDim, inDim] and may alias, inWeights is [rank, inDim] and outWeights
+//! [outDim, rank]. The product is accumulated in float.
+void mergeLoraWeights(ITensor& merged, ITensor const& base, ITensor const& inWeights, ITensor const& outWeights,
+    CudaStream const& stream);
+
+//! \brief Concatenate the 2D tensors firstScale * first and second along dim into output.
+//! \details second may be null, output then holds the scaled first only.
+void concatScaled2D(ITensor& output, ITensor const& first, float firstScale, ITensor const* second, SizeType dim,
+    CudaStream const& stream);
+
+//! \brief Pool the hidden states of the context tokens of every sequence into one float embedding per sequence.
+//! \details hiddenStates is [numTokens, hiddenSize] for packed input, [batchSize, maxInputLength, hiddenSize]
+//! otherwise, and embeddings is [batchSize, hiddenSize]. With normalize, every embedding is scaled to unit L2 norm.
+void embeddingPooling(ITensor& embeddings, ITensor const& hiddenStates, ITensor const& contextLengths,
+    EmbeddingPooling pooling, bool normalize, CudaStream const& stream);
+
 } // namespace tensorrt_llm::runtime::kernels
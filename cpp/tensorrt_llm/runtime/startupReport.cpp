@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/startupReport.h"
+
+#include "tensorrt_llm/common/stringUtils.h"
+
+#include <algorithm>
+
+namespace tc = tensorrt_llm::common;
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+
+// Innermost running phase of the calling thread
+thread_local StartupReport::ScopedPhase* currentPhase{nullptr};
+
+} // namespace
+
+StartupReport& StartupReport::getInstance()
+{
+    static StartupReport instance;
+    return instance;
+}
+
+void StartupReport::record(std::string const& name, double ms, bool nested)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = std::find_if(mPhases.begin(), mPhases.end(), [&name](Phase const& phase) { return phase.name == name; });
+    if (it == mPhases.end())
+    {
+        mPhases.push_back(Phase{name, ms, 1, nested});
+    }
+    else
+    {
+        it->totalMs += ms;
+        ++it->count;
+    }
+}
+
+std::vector<StartupReport::Phase> StartupReport::getPhases() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPhases;
+}
+
+double StartupReport::getTotalMs() const
+{
+    double totalMs{0};
+    for (auto const& phase : getPhases())
+    {
+        if (!phase.nested)
+        {
+            totalMs += phase.totalMs;
+        }
+    }
+    return totalMs;
+}
+
+std::string StartupReport::toString() const
+{
+    auto const phases = getPhases();
+    auto const totalMs = getTotalMs();
+    auto result = tc::fmtstr("[Startup] total %.1f ms", totalMs);
+    for (auto const& phase : phases)
+    {
+        result += tc::fmtstr("\n  %s: %.1f ms (%.1f%%)", phase.name.c_str(), phase.totalMs,
+            totalMs > 0 ? 100. * phase.totalMs / totalMs : 0.);
+        if (phase.count > 1)
+        {
+            result += tc::fmtstr(" in %zu calls", phase.count);
+        }
+    }
+    return result;
+}
+
+std::string StartupReport::toJson() const
+{
+    auto const phases = getPhases();
+    auto result = tc::fmtstr("{\"total_ms\": %.3f, \"phases\": [", getTotalMs());
+    for (std::size_t i = 0; i < phases.size(); ++i)
+    {
+        auto const& phase = phases[i];
+        // Phase names are identifiers chosen by the code, they need no escaping
+        result += tc::fmtstr("%s{\"name\": \"%s\", \"ms\": %.3f, \"count\": %zu}", i == 0 ? "" : ", ",
+            phase.name.c_str(), phase.totalMs, phase.count);
+    }
+    return result + "]}";
+}
+
+void StartupReport::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPhases.clear();
+}
+
+StartupReport::ScopedPhase::ScopedPhase(char const* name)
+    : mName{currentPhase != nullptr ? currentPhase->mName + "/" + name : std::string{name}}
+    , mNested{currentPhase != nullptr}
+    , mParent{currentPhase}
+    , mStart{std::chrono::steady_clock::now()}
+{
+    currentPhase = this;
+}
+
+StartupReport::ScopedPhase::~ScopedPhase()
+{
+    currentPhase = mParent;
+    auto const ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+    getInstance().record(mName, ms, mNested);
+}
+
+} // namespace tensorrt_llm::runtime
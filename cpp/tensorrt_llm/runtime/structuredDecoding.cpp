@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/structuredDecoding.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/kernels/banBadWords.h"
+
+#include <algorithm>
+
+namespace tk = tensorrt_llm::kernels;
+
+namespace tensorrt_llm::runtime
+{
+
+TokenFsm::TokenFsm(SizeType vocabSize, SizeType numStates, TokenIdType endId, StateType initialState)
+    : mVocabSize{vocabSize}
+    , mEndId{endId}
+    , mInitialState{initialState}
+    , mTransitions(numStates)
+    , mFinal(numStates, false)
+{
+    TLLM_CHECK_WITH_INFO(vocabSize > 0, "Vocab size must be positive");
+    TLLM_CHECK_WITH_INFO(0 <= initialState && initialState < numStates, "Initial state %d out of range [0, %d)",
+        initialState, numStates);
+    TLLM_CHECK_WITH_INFO(0 <= endId && endId < vocabSize, "End id %d out of range [0, %d)", endId, vocabSize);
+}
+
+void TokenFsm::addTransition(StateType from, TokenIdType token, StateType to)
+{
+    auto const numStates = static_cast<StateType>(mTransitions.size());
+    TLLM_CHECK_WITH_INFO(0 <= from && from < numStates && 0 <= to && to < numStates,
+        "Transition %d -> %d out of range [0, %d)", from, to, numStates);
+    TLLM_CHECK_WITH_INFO(0 <= token && token < mVocabSize && token != mEndId, "Invalid transition token %d", token);
+    mTransitions[from][token] = to;
+}
+
+void TokenFsm::addFinalState(StateType state)
+{
+    mFinal.at(state) = true;
+}
+
+void TokenFsm::compile()
+{
+    auto const bitmaskSize = getBitmaskSize(mVocabSize);
+    mBitmasks.assign(mTransitions.size() * bitmaskSize, 0u);
+    for (std::size_t state = 0; state < mTransitions.size(); ++state)
+    {
+        auto* bitmask = mBitmasks.data() + state * bitmaskSize;
+        for (auto const& [token, next] : mTransitions[state])
+        {
+            bitmask[token / 32] |= 1u << (token % 32);
+        }
+        if (mFinal[state])
+        {
+            bitmask[mEndId / 32] |= 1u << (mEndId % 32);
+        }
+    }
+}
+
+std::optional<TokenFsm::StateType> TokenFsm::nextState(StateType state, TokenIdType token) const
+{
+    auto const& transitions = mTransitions.at(state);
+    if (auto it = transitions.find(token); it != transitions.end())
+    {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::uint32_t const* TokenFsm::getStateBitmask(StateType state) const
+{
+    TLLM_CHECK_WITH_INFO(!mBitmasks.empty(), "TokenFsm has not been compiled");
+    return mBitmasks.data() + static_cast<std::size_t>(state) * getBitmaskSize(mVocabSize);
+}
+
+void TokenFsmMatcher::fillNextTokenBitmask(std::uint32_t* bitmask, SizeType vocabSize) const
+{
+    TLLM_CHECK_WITH_INFO(vocabSize == mFsm->getVocabSize(), "Vocab size %d does not match the grammar (%d)", vocabSize,
+        mFsm->getVocabSize());
+    auto const bitmaskSize = TokenFsm::getBitmaskSize(vocabSize);
+    if (mTerminated)
+    {
+        auto const endId = mFsm->getEndId();
+        std::fill(bitmask, bitmask + bitmaskSize, 0u);
+        bitmask[endId / 32] = 1u << (endId % 32);
+        return;
+    }
+    auto const* stateBitmask = mFsm->getStateBitmask(mState);
+    std::copy(stateBitmask, stateBitmask + bitmaskSize, bitmask);
+}
+
+bool TokenFsmMatcher::acceptToken(TokenIdType token)
+{
+    if (mTerminated)
+    {
+        return token == mFsm->getEndId();
+    }
+    if (token == mFsm->getEndId())
+    {
+        mTerminated = mFsm->isFinal(mState);
+        return mTerminated;
+    }
+    auto const next = mFsm->nextState(mState, token);
+    if (!next)
+    {
+        return false;
+    }
+    mState = *next;
+    return true;
+}
+
+StructuredDecoding::StructuredDecoding(SizeType maxBatchSize, SizeType vocabSize, BufferManager const& manager)
+    : mVocabSize{vocabSize}
+    , mBitmaskSize{TokenFsm::getBitmaskSize(vocabSize)}
+    , mBufferManager{manager}
+    , mMatchers(maxBatchSize)
+{
+    auto constexpr nvBitmaskType = TRTDataType<std::uint32_t>::value;
+    auto const bitmasksShape = ITensor::makeShape({maxBatchSize, mBitmaskSize});
+    mBitmasksHost = mBufferManager.pinned(bitmasksShape, nvBitmaskType);
+    mBitmasksDevice = mBufferManager.gpu(bitmasksShape, nvBitmaskType);
+    mBitmaskPtrs = mBufferManager.pinned(ITensor::makeShape({maxBatchSize}), TRTDataType<std::uint32_t*>::value);
+    auto* bitmaskPtrs = bufferCast<std::uint32_t*>(*mBitmaskPtrs);
+    std::fill(bitmaskPtrs, bitmaskPtrs + maxBatchSize, nullptr);
+
+    mLogitsPostProcessor = std::make_shared<LogitsPostProcessor const>(
+        [this](ITensor& logits, ITensor const& batchSlots, std::vector<SizeType> const&, cudaStream_t stream)
+        { applyBitmasks(logits, batchSlots, stream); });
+}
+
+void StructuredDecoding::setMatcher(SizeType seqSlot, MatcherPtr matcher)
+{
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(matcher), "Undefined grammar matcher");
+    // The pinned masks may still be read by the last upload or the last masking kernel.
+    mBitmasksApplied.synchronize();
+    mMatchers.at(seqSlot) = std::move(matcher);
+    uploadBitmasks({seqSlot});
+}
+
+void StructuredDecoding::release(SizeType seqSlot)
+{
+    mBitmasksApplied.synchronize();
+    mMatchers.at(seqSlot).reset();
+    bufferCast<std::uint32_t*>(*mBitmaskPtrs)[seqSlot] = nullptr;
+}
+
+void StructuredDecoding::advance(ITensor const& newTokens, std::vector<SizeType> const& seqSlots)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(newTokens.getMemoryType() != MemoryType::kGPU, "New tokens must be accessible on the host");
+
+    auto const* newTokensPtr = bufferCast<TokenIdType>(newTokens);
+    std::vector<SizeType> constrainedSlots;
+    constrainedSlots.reserve(seqSlots.size());
+    for (auto const seqSlot : seqSlots)
+    {
+        auto& matcher = mMatchers.at(seqSlot);
+        if (!matcher)
+        {
+            continue;
+        }
+        auto const token = newTokensPtr[seqSlot];
+        if (!matcher->acceptToken(token))
+        {
+            TLLM_LOG_WARNING("Token %d sampled for slot %d is not allowed by its grammar", token, seqSlot);
+            ++mNumRejectedTokens;
+        }
+        constrainedSlots.push_back(seqSlot);
+    }
+
+    if (!constrainedSlots.empty())
+    {
+        mBitmasksApplied.synchronize();
+        uploadBitmasks(constrainedSlots);
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void StructuredDecoding::uploadBitmasks(std::vector<SizeType> const& seqSlots)
+{
+    auto* bitmaskPtrs = bufferCast<std::uint32_t*>(*mBitmaskPtrs);
+    for (auto const seqSlot : seqSlots)
+    {
+        auto bitmaskHost = ITensor::slice(mBitmasksHost, seqSlot, 1);
+        auto bitmaskDevice = ITensor::slice(mBitmasksDevice, seqSlot, 1);
+        mMatchers[seqSlot]->fillNextTokenBitmask(bufferCast<std::uint32_t>(*bitmaskHost), mVocabSize);
+        mBufferManager.copy(*bitmaskHost, *bitmaskDevice);
+        bitmaskPtrs[seqSlot] = bufferCast<std::uint32_t>(*bitmaskDevice);
+    }
+    mBufferManager.getStream().record(mBitmasksUploaded);
+}
+
+void StructuredDecoding::applyBitmasks(ITensor& logits, ITensor const& batchSlots, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const& logitsShape = logits.getShape();
+    TLLM_CHECK_WITH_INFO(logitsShape.nbDims == 3, "Logits must have shape [batchSize, beamWidth, vocabSizePadded]");
+    auto const batchSize = logitsShape.d[0];
+    auto const beamWidth = logitsShape.d[1];
+    auto const vocabSizePadded = logitsShape.d[2];
+    TLLM_CHECK_WITH_INFO(beamWidth == 1, "Structured decoding does not support beam search");
+
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, mBitmasksUploaded.get()));
+    auto const* bitmaskPtrs = bufferCast<std::uint32_t*>(*mBitmaskPtrs);
+    auto const* batchSlotsPtr = bufferCast<SizeType>(batchSlots);
+    switch (logits.getDataType())
+    {
+    case nvinfer1::DataType::kFLOAT:
+        tk::invokeApplyTokenBitmask(bufferCast<float>(logits), bitmaskPtrs, batchSlotsPtr, batchSize, beamWidth,
+            mVocabSize, vocabSizePadded, stream);
+        break;
+    case nvinfer1::DataType::kHALF:
+        tk::invokeApplyTokenBitmask(bufferCast<half>(logits), bitmaskPtrs, batchSlotsPtr, batchSize, beamWidth,
+            mVocabSize, vocabSizePadded, stream);
+        break;
+    default: TLLM_THROW("Unsupported logits data type");
+    }
+    TLLM_CUDA_CHECK(cudaEventRecord(mBitmasksApplied.get(), stream));
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/logitsPostProcessor.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+/**
+ * \brief Tracks the state of one request in a grammar and tells which tokens may follow.
+ * \details Implementations wrap a compiled grammar, e.g. a JSON schema or a regex compiled to a token automaton.
+ */
+class IGrammarMatcher
+{
+public:
+    virtual ~IGrammarMatcher() = default;
+
+    /**
+     * \brief Write the tokens allowed in the current state.
+     * \param[out] bitmask: [ceil(vocabSize / 32)], bit (t % 32) of word (t / 32) is set if token t is allowed
+     */
+    virtual void fillNextTokenBitmask(std::uint32_t* bitmask, SizeType vocabSize) const = 0;
+
+    /**
+     * \brief Advance the state with a sampled token.
+     * \return false if the token is not allowed in the current state, the state is left unchanged then.
+     */
+    virtual bool acceptToken(TokenIdType token) = 0;
+
+    //! \brief True once the grammar has been completed and only the end token can follow.
+    [[nodiscard]] virtual bool isTerminated() const = 0;
+};
+
+/**
+ * \brief Deterministic automaton over token ids, the compiled form of a grammar shared by all requests using it.
+ * \details Allowed token masks are computed once per state, so advancing a request is a hash lookup and filling its
+ * mask a copy of ceil(vocabSize / 32) words.
+ */
+class TokenFsm
+{
+public:
+    using StateType = SizeType;
+
+    TokenFsm(SizeType vocabSize, SizeType numStates, TokenIdType endId, StateType initialState = 0);
+
+    void addTransition(StateType from, TokenIdType token, StateType to);
+
+    //! \brief Allow the end token in a state, i.e. the output may stop here.
+    void addFinalState(StateType state);
+
+    //! \brief Precompute the allowed token masks. Must be called after the last transition was added.
+    void compile();
+
+    [[nodiscard]] std::optional<StateType> nextState(StateType state, TokenIdType token) const;
+
+    [[nodiscard]] bool isFinal(StateType state) const
+    {
+        return mFinal.at(state);
+    }
+
+    [[nodiscard]] bool hasTransitions(StateType state) const
+    {
+        return !mTransitions.at(state).empty();
+    }
+
+    //! \brief Mask of the tokens allowed in a state, [ceil(vocabSize / 32)].
+    [[nodiscard]] std::uint32_t const* getStateBitmask(StateType state) const;
+
+    [[nodiscard]] SizeType getVocabSize() const noexcept
+    {
+        return mVocabSize;
+    }
+
+    [[nodiscard]] TokenIdType getEndId() const noexcept
+    {
+        return mEndId;
+    }
+
+    [[nodiscard]] StateType getInitialState() const noexcept
+    {
+        return mInitialState;
+    }
+
+    [[nodiscard]] static SizeType getBitmaskSize(SizeType vocabSize) noexcept
+    {
+        return (vocabSize + 31) / 32;
+    }
+
+private:
+    SizeType mVocabSize;
+    TokenIdType mEndId;
+    StateType mInitialState;
+    std::vector<std::unordered_map<TokenIdType, StateType>> mTransitions;
+    std::vector<bool> mFinal;
+    // [numStates, ceil(vocabSize / 32)], filled by compile
+    std::vector<std::uint32_t> mBitmasks;
+};
+
+//! \brief Matcher of a single request walking a shared TokenFsm.
+class TokenFsmMatcher : public IGrammarMatcher
+{
+public:
+    explicit TokenFsmMatcher(std::shared_ptr<TokenFsm const> fsm)
+        : mFsm{std::move(fsm)}
+        , mState{mFsm->getInitialState()}
+    {
+    }
+
+    void fillNextTokenBitmask(std::uint32_t* bitmask, SizeType vocabSize) const override;
+
+    bool acceptToken(TokenIdType token) override;
+
+    [[nodiscard]] bool isTerminated() const override
+    {
+        return mTerminated || (mFsm->isFinal(mState) && !mFsm->hasTransitions(mState));
+    }
+
+    [[nodiscard]] TokenFsm::StateType getState() const noexcept
+    {
+        return mState;
+    }
+
+private:
+    std::shared_ptr<TokenFsm const> mFsm;
+    TokenFsm::StateType mState;
+    bool mTerminated{false};
+};
+
+/**
+ * \brief Applies per-request grammar constraints to the decoder logits.
+ * \details Each constrained request owns a matcher. After every decoding step, the matchers are advanced on the
+ * host with the sampled tokens and their masks are uploaded on the given stream. The masks are applied on the gpu
+ * by the logits post-processor returned by getLogitsPostProcessor, which has to be registered for the constrained
+ * requests of the decoder. Advancing is meant to be called after the forward pass of the next step has been
+ * enqueued, so that the host work overlaps with the engine.
+ */
+class StructuredDecoding
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using MatcherPtr = std::shared_ptr<IGrammarMatcher>;
+
+    StructuredDecoding(SizeType maxBatchSize, SizeType vocabSize, BufferManager const& manager);
+
+    // The logits post-processor refers to this object
+    StructuredDecoding(StructuredDecoding const&) = delete;
+    StructuredDecoding& operator=(StructuredDecoding const&) = delete;
+
+    //! \brief Constrain the request in seqSlot and upload the mask of its first step.
+    void setMatcher(SizeType seqSlot, MatcherPtr matcher);
+
+    //! \brief Remove the constraint of the request in seqSlot.
+    void release(SizeType seqSlot);
+
+    [[nodiscard]] bool isConstrained(SizeType seqSlot) const
+    {
+        return static_cast<bool>(mMatchers.at(seqSlot));
+    }
+
+    /**
+     * \brief Advance the matchers with the tokens of the last step and upload the masks of the next one.
+     * \param[in] newTokens: [maxBatchSize], the tokens sampled in the last step, indexed by seq slot, on cpu
+     * \param[in] seqSlots: the slots that generated a token in the last step
+     */
+    void advance(ITensor const& newTokens, std::vector<SizeType> const& seqSlots);
+
+    //! \brief The processor that masks the logits of the constrained requests, to register with their requests.
+    [[nodiscard]] LogitsPostProcessorPtr getLogitsPostProcessor() const
+    {
+        return mLogitsPostProcessor;
+    }
+
+    //! \brief Number of tokens rejected by a matcher since construction, these come only from unmasked sampling.
+    [[nodiscard]] std::size_t getNumRejectedTokens() const noexcept
+    {
+        return mNumRejectedTokens;
+    }
+
+private:
+    void uploadBitmasks(std::vector<SizeType> const& seqSlots);
+
+    void applyBitmasks(ITensor& logits, ITensor const& batchSlots, cudaStream_t stream);
+
+    SizeType mVocabSize;
+    SizeType mBitmaskSize;
+    BufferManager mBufferManager;
+    std::vector<MatcherPtr> mMatchers;
+    // [maxBatchSize, ceil(vocabSize / 32)], written by the host, pinned
+    TensorPtr mBitmasksHost;
+    // [maxBatchSize, ceil(vocabSize / 32)], read by the masking kernel, on gpu
+    TensorPtr mBitmasksDevice;
+    // [maxBatchSize], device pointer to the mask of each slot or nullptr if unconstrained, pinned
+    TensorPtr mBitmaskPtrs;
+    // Recorded after the masks have been uploaded, the decoder stream waits for it
+    CudaEvent mBitmasksUploaded;
+    // Recorded after the masks have been applied, the host waits for it before writing the pinned masks again
+    CudaEvent mBitmasksApplied;
+    LogitsPostProcessorPtr mLogitsPostProcessor;
+    std::size_t mNumRejectedTokens{0};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Non-owning view of the memory of a tensor: a pointer, a shape, a data type and a memory type.
+//!
+//! ITensor::slice and ITensor::view allocate a TensorView and its control block on every call. A TensorSpan lives on
+//! the stack and is trivially copyable, so slicing it per request or per row in a hot loop costs no allocation. It
+//! does not keep the tensor alive, the tensor must outlive every span of it. Where the slice is passed on as an
+//! ITensor, e.g. to a BufferManager copy or an engine binding, use the owning ITensor::slice instead.
+template <typename TVoid>
+class BasicTensorSpan
+{
+    static_assert(std::is_same_v<std::remove_const_t<TVoid>, void>);
+
+public:
+    using Shape = ITensor::Shape;
+    using DimType = ITensor::DimType;
+
+    BasicTensorSpan() = default;
+
+    BasicTensorSpan(TVoid* data, Shape const& shape, nvinfer1::DataType dataType, MemoryType memoryType) noexcept
+        : mData{data}
+        , mShape{shape}
+        , mDataType{dataType}
+        , mMemoryType{memoryType}
+    {
+    }
+
+    template <typename TTensor,
+        std::enable_if_t<std::is_base_of_v<ITensor, std::remove_const_t<TTensor>>
+                && std::is_convertible_v<decltype(std::declval<TTensor&>().data()), TVoid*>,
+            int>
+        = 0>
+    explicit BasicTensorSpan(TTensor& tensor)
+        : BasicTensorSpan{tensor.data(), tensor.getShape(), tensor.getDataType(), tensor.getMemoryType()}
+    {
+    }
+
+    //! \brief A span of a const tensor from a span of a mutable one.
+    template <typename TOther, std::enable_if_t<std::is_const_v<TVoid> && !std::is_const_v<TOther>, int> = 0>
+    BasicTensorSpan(BasicTensorSpan<TOther> const& other) noexcept // NOLINT(google-explicit-constructor)
+        : BasicTensorSpan{other.data(), other.getShape(), other.getDataType(), other.getMemoryType()}
+    {
+    }
+
+    [[nodiscard]] TVoid* data() const noexcept
+    {
+        return mData;
+    }
+
+    //! \brief Typed pointer to the data, throws std::bad_cast on a type mismatch like bufferCast.
+    template <typename T>
+    [[nodiscard]] auto data() const
+    {
+        using TElem = std::conditional_t<std::is_const_v<TVoid>, T const, T>;
+        if (TRTDataType<std::remove_cv_t<T>>::value != mDataType)
+        {
+            throw std::bad_cast();
+        }
+        return static_cast<TElem*>(mData);
+    }
+
+    [[nodiscard]] Shape const& getShape() const noexcept
+    {
+        return mShape;
+    }
+
+    [[nodiscard]] nvinfer1::DataType getDataType() const noexcept
+    {
+        return mDataType;
+    }
+
+    [[nodiscard]] MemoryType getMemoryType() const noexcept
+    {
+        return mMemoryType;
+    }
+
+    [[nodiscard]] std::size_t getSize() const
+    {
+        return ITensor::volumeNonNegative(mShape);
+    }
+
+    [[nodiscard]] std::size_t getSizeInBytes() const
+    {
+        return getSize() * BufferDataType(mDataType).getSize();
+    }
+
+    //! \brief Rows [offset, offset + size) of dimension 0, like ITensor::slice.
+    [[nodiscard]] BasicTensorSpan slice(std::size_t offset, std::size_t size) const
+    {
+        TLLM_CHECK_WITH_INFO(mShape.nbDims > 0, "Cannot slice a tensor of rank 0");
+        auto const dim0 = static_cast<std::size_t>(mShape.d[0]);
+        TLLM_CHECK_WITH_INFO(offset + size <= dim0, "Slice [%zu, %zu) out of range of dimension 0 of size %zu",
+            offset, offset + size, dim0);
+        auto shape = mShape;
+        shape.d[0] = static_cast<DimType>(size);
+        auto const rowBytes = (dim0 == 0 ? 0 : getSizeInBytes() / dim0);
+        return BasicTensorSpan{offsetBytes(offset * rowBytes), shape, mDataType, mMemoryType};
+    }
+
+    //! \brief Rows [offset, end) of dimension 0.
+    [[nodiscard]] BasicTensorSpan slice(std::size_t offset) const
+    {
+        TLLM_CHECK_WITH_INFO(mShape.nbDims > 0, "Cannot slice a tensor of rank 0");
+        auto const dim0 = static_cast<std::size_t>(mShape.d[0]);
+        TLLM_CHECK_WITH_INFO(offset <= dim0, "Slice offset %zu out of range of dimension 0 of size %zu", offset, dim0);
+        return slice(offset, dim0 - offset);
+    }
+
+    //! \brief Row index of dimension 0 with that dimension removed.
+    [[nodiscard]] BasicTensorSpan operator[](std::size_t index) const
+    {
+        return slice(index, 1).squeeze(0);
+    }
+
+    //! \brief The first elements of the span seen with another shape, like ITensor::view.
+    [[nodiscard]] BasicTensorSpan view(Shape const& shape) const
+    {
+        TLLM_CHECK_WITH_INFO(ITensor::volumeNonNegative(shape) <= getSize(), "New shape %s exceeds the span %s",
+            ITensor::toString(shape).c_str(), ITensor::toString(mShape).c_str());
+        return BasicTensorSpan{mData, shape, mDataType, mMemoryType};
+    }
+
+    [[nodiscard]] BasicTensorSpan squeeze(SizeType dim) const
+    {
+        return BasicTensorSpan{mData, ITensor::squeeze(mShape, dim), mDataType, mMemoryType};
+    }
+
+    [[nodiscard]] BasicTensorSpan unsqueeze(SizeType dim) const
+    {
+        return BasicTensorSpan{mData, ITensor::unsqueeze(mShape, dim), mDataType, mMemoryType};
+    }
+
+private:
+    [[nodiscard]] TVoid* offsetBytes(std::size_t bytes) const noexcept
+    {
+        using TByte = std::conditional_t<std::is_const_v<TVoid>, std::byte const, std::byte>;
+        return static_cast<TByte*>(mData) + bytes;
+    }
+
+    TVoid* mData{nullptr};
+    Shape mShape{};
+    nvinfer1::DataType mDataType{nvinfer1::DataType::kFLOAT};
+    MemoryType mMemoryType{MemoryType::kCPU};
+};
+
+using TensorSpan = BasicTensorSpan<void>;
+using ConstTensorSpan = BasicTensorSpan<void const>;
+
+static_assert(std::is_trivially_copyable_v<TensorSpan>);
+static_assert(std::is_trivially_copyable_v<ConstTensorSpan>);
+
+} // namespace tensorrt_llm::runtime
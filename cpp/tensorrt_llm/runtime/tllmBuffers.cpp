@@ -26,6 +26,14 @@ typename PoolAllocator<TAllocator>::PoolType& PoolAllocator<TAllocator>::getPool
     return pool;
 }
 
+template <typename TAllocator>
+typename SizeClassPoolAllocator<TAllocator>::PoolType& SizeClassPoolAllocator<TAllocator>::getPool()
+{
+    static PoolType pool{PoolAllocator<TAllocator>::getPool()};
+    return pool;
+}
+
 // explicit instantiations
 template class PoolAllocator<PinnedAllocator>;
+template class SizeClassPoolAllocator<PinnedAllocator>;
 } // namespace tensorrt_llm::runtime
@@ -23,22 +23,43 @@
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/memoryCounters.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+#include "tensorrt_llm/runtime/numaAffinity.h"
 
 #include <NvInferRuntime.h>
 #include <cuda_runtime_api.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace tensorrt_llm::runtime
 {
 
+namespace detail
+{
+template <typename TAllocator, typename = void>
+struct HasCudaStream : std::false_type
+{
+};
+
+template <typename TAllocator>
+struct HasCudaStream<TAllocator, std::void_t<decltype(std::declval<TAllocator const&>().getCudaStream())>>
+    : std::true_type
+{
+};
+} // namespace detail
+
 // CRTP base class
 template <typename TDerived, MemoryType memoryType, bool count = true>
 class BaseAllocator
@@ -54,7 +75,14 @@ public:
         PointerType ptr{};
         static_cast<TDerived*>(this)->allocateImpl(&ptr, n);
         if constexpr (count)
+        {
             MemoryCounters::getInstance().allocate<memoryType>(n);
+            auto& timeline = MemoryTimeline::getInstance();
+            if (timeline.isEnabled())
+            {
+                timeline.recordAllocation(memoryType, ptr, n, getStream());
+            }
+        }
         return ptr;
     }
 
@@ -64,7 +92,14 @@ public:
         {
             static_cast<TDerived*>(this)->deallocateImpl(ptr, n);
             if constexpr (count)
+            {
                 MemoryCounters::getInstance().deallocate<memoryType>(n);
+                auto& timeline = MemoryTimeline::getInstance();
+                if (timeline.isEnabled())
+                {
+                    timeline.recordFree(memoryType, ptr, getStream());
+                }
+            }
         }
     }
 
@@ -72,6 +107,19 @@ public:
     {
         return memoryType;
     }
+
+private:
+    [[nodiscard]] cudaStream_t getStream() const
+    {
+        if constexpr (detail::HasCudaStream<TDerived>::value)
+        {
+            return static_cast<TDerived const*>(this)->getCudaStream()->get();
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
 };
 
 class CudaAllocator : public BaseAllocator<CudaAllocator, MemoryType::kGPU>
@@ -101,8 +149,10 @@ class CudaAllocatorAsync : public BaseAllocator<CudaAllocatorAsync, MemoryType::
 public:
     using CudaStreamPtr = std::shared_ptr<CudaStream>;
 
-    explicit CudaAllocatorAsync(CudaStreamPtr stream)
+    //! \param memPool Pool to allocate from, nullptr for the current memory pool of the device.
+    explicit CudaAllocatorAsync(CudaStreamPtr stream, ::cudaMemPool_t memPool = nullptr)
         : mCudaStream(std::move(stream))
+        , mMemPool{memPool}
     {
         TLLM_CHECK_WITH_INFO(static_cast<bool>(mCudaStream), "Undefined CUDA stream");
     }
@@ -112,10 +162,22 @@ public:
         return mCudaStream;
     }
 
+    [[nodiscard]] ::cudaMemPool_t getMemPool() const
+    {
+        return mMemPool;
+    }
+
 protected:
     void allocateImpl(PointerType* ptr, SizeType n)
     {
-        TLLM_CUDA_CHECK(::cudaMallocAsync(ptr, n, mCudaStream->get()));
+        if (mMemPool)
+        {
+            TLLM_CUDA_CHECK(::cudaMallocFromPoolAsync(ptr, n, mMemPool, mCudaStream->get()));
+        }
+        else
+        {
+            TLLM_CUDA_CHECK(::cudaMallocAsync(ptr, n, mCudaStream->get()));
+        }
     }
 
     void deallocateImpl(PointerType ptr, [[maybe_unused]] SizeType n)
@@ -125,6 +187,7 @@ protected:
 
 private:
     CudaStreamPtr mCudaStream;
+    ::cudaMemPool_t mMemPool;
 };
 
 class UVMAllocator : public BaseAllocator<UVMAllocator, MemoryType::kUVM>
@@ -160,13 +223,24 @@ public:
 protected:
     void allocateImpl(PointerType* ptr, SizeType n) // NOLINT(readability-convert-member-functions-to-static)
     {
-        TLLM_CUDA_CHECK(::cudaHostAlloc(ptr, n, cudaHostAllocDefault));
+        auto& numaAffinity = NumaAffinity::getInstance();
+        if (auto const node = numaAffinity.getPinnedMemoryNode())
+        {
+            *ptr = numaAffinity.allocatePinned(n, *node);
+        }
+        else
+        {
+            TLLM_CUDA_CHECK(::cudaHostAlloc(ptr, n, cudaHostAllocDefault));
+        }
     }
 
     void deallocateImpl( // NOLINT(readability-convert-member-functions-to-static)
-        PointerType ptr, [[maybe_unused]] SizeType n)
+        PointerType ptr, SizeType n)
     {
-        TLLM_CUDA_CHECK(::cudaFreeHost(ptr));
+        if (!NumaAffinity::getInstance().freePinned(ptr, n))
+        {
+            TLLM_CUDA_CHECK(::cudaFreeHost(ptr));
+        }
     }
 };
 
@@ -242,6 +316,48 @@ using ManagedBorrowingAllocator = BorrowingAllocator<MemoryType::kUVM>;
 
 // using UVMBorrowingAllocator = BorrowingAllocator<MemoryType::kUVM>;
 
+//! \brief Wraps an allocator and accounts the allocated bytes to a MemoryCounters tag.
+template <typename TAllocator>
+class TaggedAllocator : public TAllocator
+{
+public:
+    using PointerType = typename TAllocator::PointerType;
+    using SizeType = typename TAllocator::SizeType;
+    using TagId = MemoryCounters::TagId;
+
+    TaggedAllocator(TAllocator allocator, TagId tag)
+        : TAllocator{std::move(allocator)}
+        , mTag{tag}
+    {
+    }
+
+    PointerType allocate(SizeType n)
+    {
+        // Also seen by the memory timeline of the wrapped allocator
+        MemoryCounters::ScopedTag const scopedTag{mTag};
+        auto ptr = TAllocator::allocate(n);
+        MemoryCounters::getInstance().allocateTagged(TAllocator::kMemoryType, mTag, n);
+        return ptr;
+    }
+
+    void deallocate(PointerType ptr, SizeType n)
+    {
+        if (ptr)
+        {
+            TAllocator::deallocate(ptr, n);
+            MemoryCounters::getInstance().deallocateTagged(TAllocator::kMemoryType, mTag, n);
+        }
+    }
+
+    [[nodiscard]] TagId getTag() const
+    {
+        return mTag;
+    }
+
+private:
+    TagId mTag;
+};
+
 /**
  * A memory manager that acts as a memory pool, preallocating a configurable
  * amount of memory. It is able to grow in size and allocate memory chunks as required.
@@ -497,6 +613,286 @@ protected:
 
 using PinnedPoolAllocator = PoolAllocator<PinnedAllocator>;
 
+/**
+ * A sub-allocator on top of a MemoryPool that serves small requests from size-class slabs.
+ * Requests up to kMaxClassSize B are rounded up to a power of two and taken from the free list of their class.
+ * The free lists are lock-free stacks with a tagged head, so a cached block is allocated and freed without
+ * taking the pool lock. A class only requests a new slab of kSlabSize B from the pool when its free list is
+ * empty. Slabs are returned to the pool when the SizeClassPool is destroyed. Larger requests go to the pool.
+ */
+template <typename TAllocator>
+class SizeClassPool : public BaseAllocator<SizeClassPool<TAllocator>, TAllocator::kMemoryType, false>
+{
+    friend class BaseAllocator<SizeClassPool<TAllocator>, TAllocator::kMemoryType, false>;
+
+public:
+    using Base = BaseAllocator<SizeClassPool<TAllocator>, TAllocator::kMemoryType, false>;
+    using PointerType = typename Base::PointerType;
+    using SizeType = typename Base::SizeType;
+    using PoolType = MemoryPool<TAllocator>;
+
+    static SizeType constexpr kMinClassSize{PoolType::kAlignment};
+    static SizeType constexpr kMaxClassSize{SizeType{1} << 20}; // 1 MB
+    static SizeType constexpr kSlabSize{SizeType{2} << 20};     // 2 MB
+    static SizeType constexpr kMaxSlabsPerClass{1024};
+
+    //! \brief Index of the size class serving requests of n B, n must not exceed kMaxClassSize.
+    [[nodiscard]] static constexpr std::size_t getClassIndex(SizeType n)
+    {
+        std::size_t classIdx{0};
+        while ((kMinClassSize << classIdx) < n)
+        {
+            ++classIdx;
+        }
+        return classIdx;
+    }
+
+    [[nodiscard]] static constexpr SizeType getClassSize(std::size_t classIdx)
+    {
+        return kMinClassSize << classIdx;
+    }
+
+    static std::size_t constexpr kNumClasses{getClassIndex(kMaxClassSize) + 1};
+
+    explicit SizeClassPool(PoolType& pool)
+        : mPool{pool}
+    {
+    }
+
+    ~SizeClassPool()
+    {
+        auto& counters = MemoryCounters::getInstance();
+        for (auto& sizeClass : mClasses)
+        {
+            auto const numSlabs = sizeClass.numSlabs.load();
+            for (std::uint32_t slabIdx = 0; slabIdx < numSlabs; ++slabIdx)
+            {
+                try
+                {
+                    mPool.deallocate(sizeClass.slabs[slabIdx].basePointer, kSlabSize);
+                }
+                catch (std::exception const& e)
+                {
+                    TLLM_LOG_EXCEPTION(e);
+                }
+            }
+            counters.releaseSlab(Base::kMemoryType, numSlabs * kSlabSize);
+        }
+        counters.deallocateSlabBlock(Base::kMemoryType, mUsedSize.load());
+    }
+
+    SizeClassPool(SizeClassPool const&) = delete;
+    SizeClassPool& operator=(SizeClassPool const&) = delete;
+
+    //! \brief Bytes of slabs requested from the pool.
+    [[nodiscard]] SizeType getReservedSize() const
+    {
+        SizeType numSlabs{0};
+        for (auto const& sizeClass : mClasses)
+        {
+            numSlabs += sizeClass.numSlabs.load(std::memory_order_relaxed);
+        }
+        return numSlabs * kSlabSize;
+    }
+
+    //! \brief Bytes of slab blocks currently handed out, including the rounding to the class size.
+    [[nodiscard]] SizeType getUsedSize() const
+    {
+        return mUsedSize.load(std::memory_order_relaxed);
+    }
+
+    //! \brief Fraction of the reserved slab memory that is not handed out.
+    [[nodiscard]] double getFragmentation() const
+    {
+        auto const reserved = getReservedSize();
+        return reserved > 0 ? 1.0 - static_cast<double>(getUsedSize()) / static_cast<double>(reserved) : 0.0;
+    }
+
+    [[nodiscard]] PoolType& getPool() const
+    {
+        return mPool;
+    }
+
+protected:
+    void allocateImpl(PointerType* ptr, SizeType n)
+    {
+        if (n > kMaxClassSize)
+        {
+            *ptr = mPool.allocate(n);
+            return;
+        }
+
+        auto const classIdx = getClassIndex(n);
+        auto& sizeClass = mClasses[classIdx];
+        auto blockIdx = popBlock(classIdx);
+        while (!blockIdx)
+        {
+            addSlab(classIdx);
+            blockIdx = popBlock(classIdx);
+        }
+
+        auto const classSize = getClassSize(classIdx);
+        auto const blocksPerSlab = kSlabSize / classSize;
+        auto const& slab = sizeClass.slabs[*blockIdx / blocksPerSlab];
+        *ptr = static_cast<std::uint8_t*>(slab.basePointer) + (*blockIdx % blocksPerSlab) * classSize;
+        mUsedSize.fetch_add(classSize, std::memory_order_relaxed);
+        MemoryCounters::getInstance().allocateSlabBlock(Base::kMemoryType, classSize);
+    }
+
+    void deallocateImpl(PointerType ptr, SizeType n)
+    {
+        if (n > kMaxClassSize)
+        {
+            mPool.deallocate(ptr, n);
+            return;
+        }
+
+        auto const classIdx = getClassIndex(n);
+        auto const& sizeClass = mClasses[classIdx];
+        auto const classSize = getClassSize(classIdx);
+        auto const blocksPerSlab = static_cast<std::uint32_t>(kSlabSize / classSize);
+        // A class only has a few slabs, scanning them is cheaper than a locked lookup.
+        auto const numSlabs = sizeClass.numSlabs.load(std::memory_order_acquire);
+        auto const* const bytePtr = static_cast<std::uint8_t const*>(ptr);
+        for (std::uint32_t slabIdx = 0; slabIdx < numSlabs; ++slabIdx)
+        {
+            auto const* const base = static_cast<std::uint8_t const*>(sizeClass.slabs[slabIdx].basePointer);
+            if (bytePtr >= base && bytePtr < base + kSlabSize)
+            {
+                auto const offset = static_cast<std::uint32_t>((bytePtr - base) / classSize);
+                pushBlocks(classIdx, slabIdx * blocksPerSlab + offset, slabIdx * blocksPerSlab + offset);
+                mUsedSize.fetch_sub(classSize, std::memory_order_relaxed);
+                MemoryCounters::getInstance().deallocateSlabBlock(Base::kMemoryType, classSize);
+                return;
+            }
+        }
+        TLLM_THROW("SizeClassPool free: pointer %p of %zu B does not belong to a slab", ptr, n);
+    }
+
+private:
+    // Heads and links store the block index + 1, 0 terminates a list.
+    static std::uint32_t constexpr kNullLink{0};
+
+    struct Slab
+    {
+        PointerType basePointer{nullptr};
+        std::unique_ptr<std::atomic<std::uint32_t>[]> next;
+    };
+
+    struct SizeClass
+    {
+        // Upper 32 bits count the updates to avoid ABA, lower 32 bits hold the first link
+        std::atomic<std::uint64_t> head{0};
+        std::atomic<std::uint32_t> numSlabs{0};
+        std::array<Slab, kMaxSlabsPerClass> slabs{};
+        std::mutex growLock{};
+    };
+
+    [[nodiscard]] std::atomic<std::uint32_t>& getLink(std::size_t classIdx, std::uint32_t blockIdx)
+    {
+        auto const blocksPerSlab = static_cast<std::uint32_t>(kSlabSize / getClassSize(classIdx));
+        return mClasses[classIdx].slabs[blockIdx / blocksPerSlab].next[blockIdx % blocksPerSlab];
+    }
+
+    [[nodiscard]] std::optional<std::uint32_t> popBlock(std::size_t classIdx)
+    {
+        auto& head = mClasses[classIdx].head;
+        auto current = head.load(std::memory_order_acquire);
+        while (true)
+        {
+            auto const link = static_cast<std::uint32_t>(current);
+            if (link == kNullLink)
+            {
+                return std::nullopt;
+            }
+            auto const next = getLink(classIdx, link - 1).load(std::memory_order_relaxed);
+            auto const tag = (current >> 32) + 1;
+            if (head.compare_exchange_weak(
+                    current, (tag << 32) | next, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return link - 1;
+            }
+        }
+    }
+
+    //! \brief Push the already linked blocks first, ..., last to the free list of a class.
+    void pushBlocks(std::size_t classIdx, std::uint32_t first, std::uint32_t last)
+    {
+        auto& head = mClasses[classIdx].head;
+        auto& lastLink = getLink(classIdx, last);
+        auto current = head.load(std::memory_order_relaxed);
+        std::uint64_t next{};
+        do
+        {
+            lastLink.store(static_cast<std::uint32_t>(current), std::memory_order_relaxed);
+            next = (((current >> 32) + 1) << 32) | (first + 1);
+        } while (!head.compare_exchange_weak(current, next, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void addSlab(std::size_t classIdx)
+    {
+        auto& sizeClass = mClasses[classIdx];
+        std::lock_guard<std::mutex> lock(sizeClass.growLock);
+        if (static_cast<std::uint32_t>(sizeClass.head.load(std::memory_order_acquire)) != kNullLink)
+        {
+            // Another thread added a slab or freed a block in the meantime.
+            return;
+        }
+        auto const slabIdx = sizeClass.numSlabs.load(std::memory_order_relaxed);
+        TLLM_CHECK_WITH_INFO(slabIdx < kMaxSlabsPerClass, "SizeClassPool: class of %zu B exceeds %zu slabs",
+            getClassSize(classIdx), kMaxSlabsPerClass);
+
+        auto const blocksPerSlab = static_cast<std::uint32_t>(kSlabSize / getClassSize(classIdx));
+        TLLM_LOG_DEBUG("SizeClassPool: Adding slab of %u blocks of %zu B", blocksPerSlab, getClassSize(classIdx));
+        auto& slab = sizeClass.slabs[slabIdx];
+        slab.basePointer = mPool.allocate(kSlabSize);
+        slab.next = std::make_unique<std::atomic<std::uint32_t>[]>(blocksPerSlab);
+        auto const first = slabIdx * blocksPerSlab;
+        for (std::uint32_t i = 0; i + 1 < blocksPerSlab; ++i)
+        {
+            slab.next[i].store(first + i + 2, std::memory_order_relaxed);
+        }
+        // Publish the slab before its blocks become reachable through the free list.
+        sizeClass.numSlabs.store(slabIdx + 1, std::memory_order_release);
+        MemoryCounters::getInstance().reserveSlab(Base::kMemoryType, kSlabSize);
+        pushBlocks(classIdx, first, first + blocksPerSlab - 1);
+    }
+
+    PoolType& mPool;
+    std::array<SizeClass, kNumClasses> mClasses{};
+    std::atomic<SizeType> mUsedSize{0};
+};
+
+template <typename TAllocator>
+class SizeClassPoolAllocator
+    : public BaseAllocator<SizeClassPoolAllocator<TAllocator>, TAllocator::kMemoryType, false>
+{
+    friend class BaseAllocator<SizeClassPoolAllocator<TAllocator>, TAllocator::kMemoryType, false>;
+
+public:
+    using Base = BaseAllocator<SizeClassPoolAllocator<TAllocator>, TAllocator::kMemoryType, false>;
+    using PointerType = typename Base::PointerType;
+    using SizeType = typename Base::SizeType;
+    using PoolType = SizeClassPool<TAllocator>;
+
+    //! \brief Size-class pool on top of PoolAllocator<TAllocator>::getPool().
+    static PoolType& getPool();
+
+protected:
+    void allocateImpl(PointerType* ptr, SizeType n) // NOLINT(readability-convert-member-functions-to-static)
+    {
+        *ptr = getPool().allocate(n);
+    }
+
+    void deallocateImpl( // NOLINT(readability-convert-member-functions-to-static)
+        typename TAllocator::PointerType ptr, SizeType n)
+    {
+        getPool().deallocate(ptr, n);
+    }
+};
+
+using PinnedSizeClassAllocator = SizeClassPoolAllocator<PinnedAllocator>;
+
 // Adopted from https://github.com/NVIDIA/TensorRT/blob/release/8.6/samples/common/buffers.h
 
 //!
@@ -671,7 +1067,10 @@ using DeviceBuffer = GenericBuffer<CudaAllocatorAsync>;
 using HostBuffer = GenericBuffer<HostAllocator>;
 using PinnedBuffer = GenericBuffer<PinnedAllocator>;
 using PinnedPoolBuffer = GenericBuffer<PinnedPoolAllocator>;
+using PinnedSizeClassBuffer = GenericBuffer<PinnedSizeClassAllocator>;
 using UVMBuffer = GenericBuffer<UVMAllocator>;
+using TaggedDeviceBuffer = GenericBuffer<TaggedAllocator<CudaAllocatorAsync>>;
+using TaggedPinnedBuffer = GenericBuffer<TaggedAllocator<PinnedAllocator>>;
 
 template <typename T>
 typename std::make_unsigned<T>::type nonNegative(T value)
@@ -760,6 +1159,9 @@ using DeviceTensor = GenericTensor<CudaAllocatorAsync>;
 using HostTensor = GenericTensor<HostAllocator>;
 using PinnedTensor = GenericTensor<PinnedAllocator>;
 using PinnedPoolTensor = GenericTensor<PinnedPoolAllocator>;
+using PinnedSizeClassTensor = GenericTensor<PinnedSizeClassAllocator>;
 using UVMTensor = GenericTensor<UVMAllocator>;
+using TaggedDeviceTensor = GenericTensor<TaggedAllocator<CudaAllocatorAsync>>;
+using TaggedPinnedTensor = GenericTensor<TaggedAllocator<PinnedAllocator>>;
 
 } // namespace tensorrt_llm::runtime
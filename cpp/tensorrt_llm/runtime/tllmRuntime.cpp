@@ -14,10 +14,15 @@
  * limitations under the License.
  */
 #include "tllmRuntime.h"
+#include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/nvtxUtils.h"
+#include "tensorrt_llm/common/timelineTracer.h"
+#include "tensorrt_llm/runtime/startupReport.h"
 #include "tllmLogger.h"
 
+#include <algorithm>
 #include <limits>
+#include <string>
 #include <type_traits>
 
 using namespace tensorrt_llm::runtime;
@@ -55,19 +60,45 @@ std::vector<std::size_t> dimsToShape(nvinfer1::Dims const& dims)
     return shape;
 }
 
+nvinfer1::ICudaEngine* deserializeEngine(nvinfer1::IRuntime& runtime, void const* engineData, std::size_t engineSize)
+{
+    // With a mapped engine file, this includes reading the pages that were not read ahead yet.
+    StartupReport::ScopedPhase const startupPhase{"engine_deserialize"};
+    return runtime.deserializeCudaEngine(engineData, engineSize);
+}
+
 tensorrt_llm::runtime::TllmLogger defaultLogger{};
 
 } // namespace
 
 TllmRuntime::TllmRuntime(void const* engineData, std::size_t engineSize, nvinfer1::ILogger& logger)
-    : mStream(std::make_shared<CudaStream>())
+    : mLogger{logger}
+    , mStream(std::make_shared<CudaStream>())
     , mBufferManager{mStream}
     , mRuntime{nvinfer1::createInferRuntime(logger)}
-    , mEngine{mRuntime->deserializeCudaEngine(engineData, engineSize)}
+    , mEngine{deserializeEngine(*mRuntime, engineData, engineSize)}
 {
     TLLM_CHECK_WITH_INFO(mEngine != nullptr, "Failed to deserialize cuda engine");
     auto const devMemorySize = mEngine->getDeviceMemorySize();
-    mEngineBuffer = mBufferManager.gpu(devMemorySize);
+    {
+        StartupReport::ScopedPhase const startupPhase{"trt_workspace_allocation"};
+        mEngineBuffer = mBufferManager.gpu(
+            devMemorySize, BufferManager::kBYTE_TYPE, MemoryCounters::getInstance().getTagId("trt_workspace"));
+    }
+
+    for (std::int32_t i = 0; i < mEngine->getNbIOTensors(); ++i)
+    {
+        auto const name = mEngine->getIOTensorName(i);
+        TensorBinding binding{name, mEngine->getTensorDataType(name), mEngine->getTensorShape(name)};
+        if (mEngine->getTensorIOMode(name) == nvinfer1::TensorIOMode::kINPUT)
+        {
+            mInputBindings.emplace_back(std::move(binding));
+        }
+        else if (mEngine->getTensorIOMode(name) == nvinfer1::TensorIOMode::kOUTPUT)
+        {
+            mOutputBindings.emplace_back(std::move(binding));
+        }
+    }
 }
 
 TllmRuntime::TllmRuntime(void const* engineData, std::size_t engineSize)
@@ -79,6 +110,9 @@ nvinfer1::IExecutionContext& TllmRuntime::addContext(std::int32_t profileIndex)
 {
     TLLM_CHECK(0 <= profileIndex && profileIndex < mEngine->getNbOptimizationProfiles());
     mContexts.emplace_back(mEngine->createExecutionContextWithoutDeviceMemory());
+    mContextBindings.emplace_back(ContextBindings{std::vector<std::optional<nvinfer1::Dims>>(mInputBindings.size()),
+        std::vector<void const*>(mInputBindings.size(), nullptr),
+        std::vector<void*>(mOutputBindings.size(), nullptr)});
     auto& context = *mContexts.back();
     context.setDeviceMemory(mEngineBuffer->data());
     context.setOptimizationProfileAsync(profileIndex, mStream->get());
@@ -92,11 +126,82 @@ void TllmRuntime::clearContexts()
         context.reset();
     }
     mContexts.clear();
+    mContextBindings.clear();
+}
+
+void TllmRuntime::setWeightStreaming(float gpuWeightsPercent)
+{
+    TLLM_CHECK_WITH_INFO(0.0f <= gpuWeightsPercent && gpuWeightsPercent <= 1.0f,
+        "GPU weights percent must be in [0, 1], got %f", gpuWeightsPercent);
+    TLLM_CHECK_WITH_INFO(
+        mContexts.empty(), "Weight streaming must be configured before execution contexts are created");
+#if defined(NV_TENSORRT_MAJOR) && NV_TENSORRT_MAJOR >= 10
+    auto const streamableSize = mEngine->getStreamableWeightsSize();
+    if (streamableSize <= 0)
+    {
+        TLLM_CHECK_WITH_INFO(gpuWeightsPercent == 1.0f, "Engine was not built with weight streaming enabled");
+        return;
+    }
+    auto const minBudget = mEngine->getMinimumWeightStreamingBudget();
+    auto const budget
+        = std::max(minBudget, static_cast<std::int64_t>(gpuWeightsPercent * static_cast<double>(streamableSize)));
+    TLLM_CHECK_WITH_INFO(mEngine->setWeightStreamingBudget(budget), "Failed to set weight streaming budget");
+    TLLM_LOG_INFO("Weight streaming: %ld of %ld bytes of streamable weights resident on GPU", budget, streamableSize);
+    // The activation memory required by the engine depends on the budget.
+    mEngineBuffer = mBufferManager.gpu(mEngine->getDeviceMemorySize(), BufferManager::kBYTE_TYPE,
+        MemoryCounters::getInstance().getTagId("trt_workspace"));
+#else
+    TLLM_CHECK_WITH_INFO(gpuWeightsPercent == 1.0f, "Weight streaming requires TensorRT 10 or later");
+#endif
+}
+
+void TllmRuntime::refitWeights(TensorMap const& weights)
+{
+    NVTX3_FUNC_RANGE();
+    TLLM_CHECK_WITH_INFO(mEngine->isRefittable(), "Engine was not built with refit enabled");
+    std::unique_ptr<nvinfer1::IRefitter> refitter{nvinfer1::createInferRefitter(*mEngine, mLogger)};
+    TLLM_CHECK_WITH_INFO(refitter != nullptr, "Failed to create refitter");
+
+    // Previous executions must not read the weights while they are replaced.
+    mStream->synchronize();
+
+    // The refitter reads weights from host memory.
+    std::vector<ITensor::SharedPtr> hostWeights;
+    hostWeights.reserve(weights.size());
+    for (auto const& [name, tensor] : weights)
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(tensor), "Undefined weights %s", name.c_str());
+        auto const memoryType = tensor->getMemoryType();
+        auto const& hostTensor = hostWeights.emplace_back(memoryType == MemoryType::kGPU
+                ? ITensor::SharedPtr{mBufferManager.copyFrom(*tensor, MemoryType::kPINNED)}
+                : tensor);
+        nvinfer1::Weights const refitWeights{
+            hostTensor->getDataType(), hostTensor->data(), static_cast<std::int64_t>(hostTensor->getSize())};
+        TLLM_CHECK_WITH_INFO(refitter->setNamedWeights(name.c_str(), refitWeights), "Failed to set weights %s",
+            name.c_str());
+    }
+    mStream->synchronize();
+
+    auto const numMissing = refitter->getMissingWeights(0, nullptr);
+    if (numMissing > 0)
+    {
+        std::vector<char const*> missingNames(numMissing);
+        refitter->getMissingWeights(numMissing, missingNames.data());
+        std::string names;
+        for (auto const* name : missingNames)
+        {
+            names += (names.empty() ? "" : ", ") + std::string{name};
+        }
+        TLLM_THROW("Refit requires weights that were not provided: %s", names.c_str());
+    }
+    TLLM_CHECK_WITH_INFO(refitter->refitCudaEngine(), "Failed to refit engine");
+    TLLM_LOG_INFO("Refitted %zu weights", weights.size());
 }
 
 bool TllmRuntime::executeContext(SizeType contextIndex) const
 {
     NVTX3_FUNC_RANGE();
+    TLLM_TIMELINE_SCOPE(kEngineEnqueue, executeContext);
     auto& context = getContext(contextIndex);
     return context.enqueueV3(mStream->get());
 }
@@ -105,31 +210,34 @@ void TllmRuntime::setInputTensors(SizeType contextIndex, TensorMap const& tensor
 {
     NVTX3_FUNC_RANGE();
     auto& context = getContext(contextIndex);
-    for (std::int32_t i = 0; i < mEngine->getNbIOTensors(); ++i)
+    auto& cache = mContextBindings.at(contextIndex);
+    bool shapesChanged{false};
+    for (std::size_t i = 0; i < mInputBindings.size(); ++i)
     {
-        auto const name = mEngine->getIOTensorName(i);
-        if (mEngine->getTensorIOMode(name) == nvinfer1::TensorIOMode::kINPUT)
+        auto const& binding = mInputBindings[i];
+        auto const* const name = binding.name.c_str();
+        auto pos = tensorMap.find(binding.name);
+        if (pos == tensorMap.end())
         {
-            auto pos = tensorMap.find(name);
-            if (pos == tensorMap.end())
-            {
-                auto expectedShape = mEngine->getTensorShape(name);
-                TLLM_THROW(
-                    "Input tensor '%s' not found; expected shape: %s", name, ITensor::toString(expectedShape).c_str());
-            }
-            auto const& tensor = pos->second;
-            auto const tensorDtype = tensor->getDataType();
-            auto const engineDtype = mEngine->getTensorDataType(name);
-            // WAR: TRT does not support mixed FP8 and FP16 input, so engine expects FP16 tensors.
-            TLLM_CHECK_WITH_INFO(tensorDtype == engineDtype
-                    || (tensorDtype == nvinfer1::DataType::kFP8 && engineDtype == nvinfer1::DataType::kHALF),
-                "%s: expected type %d, provided type %d", name, static_cast<std::int32_t>(engineDtype),
-                static_cast<std::int32_t>(tensorDtype));
+            TLLM_THROW(
+                "Input tensor '%s' not found; expected shape: %s", name, ITensor::toString(binding.shape).c_str());
+        }
+        auto const& tensor = pos->second;
+        auto const tensorDtype = tensor->getDataType();
+        auto const engineDtype = binding.dataType;
+        // WAR: TRT does not support mixed FP8 and FP16 input, so engine expects FP16 tensors.
+        TLLM_CHECK_WITH_INFO(tensorDtype == engineDtype
+                || (tensorDtype == nvinfer1::DataType::kFP8 && engineDtype == nvinfer1::DataType::kHALF),
+            "%s: expected type %d, provided type %d", name, static_cast<std::int32_t>(engineDtype),
+            static_cast<std::int32_t>(tensorDtype));
 
-            auto const shapeExpected = mEngine->getTensorShape(name);
-            auto const shapeProvided = tensor->getShape();
-            TLLM_CHECK_WITH_INFO(shapeExpected.nbDims == shapeProvided.nbDims, "%s: expected %d dims, provided %d dims",
-                name, shapeExpected.nbDims, shapeProvided.nbDims);
+        auto const& shapeExpected = binding.shape;
+        auto const shapeProvided = tensor->getShape();
+        // Only shapes and addresses that changed since the last call are passed to TensorRT.
+        if (!cache.inputShapes[i] || !ITensor::shapeEquals(*cache.inputShapes[i], shapeProvided))
+        {
+            TLLM_CHECK_WITH_INFO(shapeExpected.nbDims == shapeProvided.nbDims,
+                "%s: expected %d dims, provided %d dims", name, shapeExpected.nbDims, shapeProvided.nbDims);
             for (SizeType j = 0; j < shapeExpected.nbDims; ++j)
             {
                 auto const dimExpected = shapeExpected.d[j];
@@ -143,22 +251,31 @@ void TllmRuntime::setInputTensors(SizeType contextIndex, TensorMap const& tensor
             TLLM_CHECK_WITH_INFO(context.setInputShape(name, shapeProvided),
                 "Tensor '%s' has invalid shape %s, expected %s", name, ITensor::toString(shapeProvided).c_str(),
                 ITensor::toString(shapeExpected).c_str());
-            auto* const data = tensor->data();
-            if (data)
-            {
-                context.setInputTensorAddress(name, data);
-            }
-            else
+            cache.inputShapes[i] = shapeProvided;
+            shapesChanged = true;
+        }
+
+        void const* data = tensor->data();
+        if (!data)
+        {
+            TLLM_CHECK_WITH_INFO(tensor->getSize() == 0, std::string("Invalid data for tensor: ") + name);
+            // TensorRT runtime does not support nullptr.
+            if (!mDummyTensor)
             {
-                TLLM_CHECK_WITH_INFO(tensor->getSize() == 0, std::string("Invalid data for tensor: ") + name);
-                // TensorRT runtime does not support nullptr.
-                if (!mDummyTensor)
-                {
-                    mDummyTensor = mBufferManager.gpu(ITensor::makeShape({1}));
-                }
-                context.setInputTensorAddress(name, mDummyTensor->data());
+                mDummyTensor = mBufferManager.gpu(ITensor::makeShape({1}));
             }
+            data = mDummyTensor->data();
         }
+        if (cache.inputAddresses[i] != data)
+        {
+            context.setInputTensorAddress(name, data);
+            cache.inputAddresses[i] = data;
+        }
+    }
+
+    if (!shapesChanged)
+    {
+        return;
     }
 
     {
@@ -186,33 +303,38 @@ void TllmRuntime::setOutputTensors(SizeType contextIndex, TensorMap& tensorMap)
 {
     NVTX3_FUNC_RANGE();
     auto& context = getContext(contextIndex);
-    for (std::int32_t i = 0; i < mEngine->getNbIOTensors(); ++i)
+    auto& cache = mContextBindings.at(contextIndex);
+    for (std::size_t i = 0; i < mOutputBindings.size(); ++i)
     {
-        auto const name = mEngine->getIOTensorName(i);
-        if (mEngine->getTensorIOMode(name) == nvinfer1::TensorIOMode::kOUTPUT)
+        auto const& binding = mOutputBindings[i];
+        auto const* const name = binding.name.c_str();
+        auto const dims = context.getTensorShape(name);
+        auto const engineDtype = binding.dataType;
+        auto pos = tensorMap.find(binding.name);
+        void* data{nullptr};
+        if (pos != tensorMap.end())
         {
-            auto const dims = context.getTensorShape(name);
-            auto const engineDtype = mEngine->getTensorDataType(name);
-            auto pos = tensorMap.find(name);
-            if (pos != tensorMap.end())
-            {
-                auto const& tensor = pos->second;
-                auto const tensorDtype = tensor->getDataType();
-                // WAR: TRT does not support mixed FP8 and FP16 input, so engine expects FP16 tensors.
-                TLLM_CHECK_WITH_INFO(tensorDtype == engineDtype
-                        || (tensorDtype == nvinfer1::DataType::kFP8 && engineDtype == nvinfer1::DataType::kHALF),
-                    "%s: expected type %d, provided type %d", name, static_cast<std::int32_t>(engineDtype),
-                    static_cast<std::int32_t>(tensorDtype));
-
-                tensor->reshape(dims);
-                context.setTensorAddress(name, tensor->data());
-            }
-            else
-            {
-                auto tensor = ITensor::SharedPtr(mBufferManager.gpu(dims, engineDtype));
-                tensorMap.insert(pos, std::make_pair(name, tensor));
-                context.setTensorAddress(name, tensor->data());
-            }
+            auto const& tensor = pos->second;
+            auto const tensorDtype = tensor->getDataType();
+            // WAR: TRT does not support mixed FP8 and FP16 input, so engine expects FP16 tensors.
+            TLLM_CHECK_WITH_INFO(tensorDtype == engineDtype
+                    || (tensorDtype == nvinfer1::DataType::kFP8 && engineDtype == nvinfer1::DataType::kHALF),
+                "%s: expected type %d, provided type %d", name, static_cast<std::int32_t>(engineDtype),
+                static_cast<std::int32_t>(tensorDtype));
+
+            tensor->reshape(dims);
+            data = tensor->data();
+        }
+        else
+        {
+            auto tensor = ITensor::SharedPtr(mBufferManager.gpu(dims, engineDtype));
+            tensorMap.insert(pos, std::make_pair(binding.name, tensor));
+            data = tensor->data();
+        }
+        if (cache.outputAddresses[i] != data)
+        {
+            context.setTensorAddress(name, data);
+            cache.outputAddresses[i] = data;
         }
     }
 }
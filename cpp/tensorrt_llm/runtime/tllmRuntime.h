@@ -18,10 +18,13 @@
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/utils/mappedFile.h"
 #include <NvInferRuntime.h>
 
 #include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace tensorrt_llm::runtime
@@ -40,6 +43,17 @@ public:
 
     explicit TllmRuntime(void const* engineData, std::size_t engineSize);
 
+    //! @brief Deserialize the engine from a memory-mapped file instead of a buffer read into memory.
+    explicit TllmRuntime(std::string const& enginePath, nvinfer1::ILogger& logger)
+        : TllmRuntime{utils::MappedFile{enginePath}, logger}
+    {
+    }
+
+    explicit TllmRuntime(utils::MappedFile const& engineFile, nvinfer1::ILogger& logger)
+        : TllmRuntime{engineFile.data(), engineFile.size(), logger}
+    {
+    }
+
     explicit TllmRuntime(nvinfer1::IHostMemory const& engineBuffer)
         : TllmRuntime{engineBuffer.data(), engineBuffer.size()}
     {
@@ -64,6 +78,20 @@ public:
 
     void clearContexts();
 
+    //! @brief Keep only a fraction of the streamable weights resident in device memory.
+    //! @details The remaining weights stay in host memory and are streamed to the device by TensorRT while the
+    //!          engine executes. The engine must be built with weight streaming enabled, and this must be called
+    //!          before any execution context is added.
+    //! @param gpuWeightsPercent Fraction of the streamable weights kept on the GPU, in [0, 1].
+    void setWeightStreaming(float gpuWeightsPercent);
+
+    //! @brief Replace weights of the engine in place, e.g. to swap in fine-tuned weights without rebuilding.
+    //! @details The engine must be built with refit enabled. Weights are identified by their refittable name and
+    //!          may reside in host or device memory. The stream is synchronized before and after the refit, so the
+    //!          call must not overlap with enqueued executions. Device addresses of the weights stay the same and
+    //!          captured CUDA graphs remain valid.
+    void refitWeights(TensorMap const& weights);
+
     void setInputTensors(SizeType contextIndex, TensorMap const& tensorMap);
 
     void setOutputTensors(SizeType contextIndex, TensorMap& tensorMap);
@@ -98,12 +126,33 @@ public:
     }
 
 private:
+    // Engine IO tensors, resolved once so that binding tensors does not query the engine by name every step
+    struct TensorBinding
+    {
+        std::string name;
+        nvinfer1::DataType dataType;
+        nvinfer1::Dims shape;
+    };
+
+    // Shapes and addresses last passed to an execution context, same order as mInputBindings and mOutputBindings
+    struct ContextBindings
+    {
+        std::vector<std::optional<nvinfer1::Dims>> inputShapes;
+        std::vector<void const*> inputAddresses;
+        std::vector<void*> outputAddresses;
+    };
+
+    nvinfer1::ILogger& mLogger;
     BufferManager::CudaStreamPtr mStream;
     BufferManager mBufferManager;
     std::unique_ptr<nvinfer1::IRuntime> mRuntime;
     std::unique_ptr<nvinfer1::ICudaEngine> mEngine;
     BufferManager::IBufferPtr mEngineBuffer;
     std::vector<std::unique_ptr<nvinfer1::IExecutionContext>> mContexts;
+    std::vector<TensorBinding> mInputBindings;
+    std::vector<TensorBinding> mOutputBindings;
+    // for each context
+    std::vector<ContextBindings> mContextBindings;
     std::unique_ptr<ITensor> mDummyTensor;
 };
 } // namespace tensorrt_llm::runtime
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/tokenStreamRing.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <atomic>
+#include <cstring>
+
+using namespace tensorrt_llm::runtime;
+
+TokenStreamRing::TokenStreamRing(SizeType capacity)
+    : mCapacity{capacity}
+{
+    TLLM_CHECK_WITH_INFO(capacity > 0, "Capacity must be positive");
+    auto const numBytes = static_cast<SizeType>(capacity * sizeof(TokenStreamRecord));
+    mRecords = BufferManager::pinned(ITensor::makeShape({numBytes}), nvinfer1::DataType::kUINT8);
+    mWriteIndex = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT64);
+    std::memset(mRecords->data(), 0, mRecords->getSizeInBytes());
+    *bufferCast<std::int64_t>(*mWriteIndex) = 0;
+}
+
+SizeType TokenStreamRing::poll(std::vector<TokenStreamRecord>& records)
+{
+    auto const* ring = static_cast<TokenStreamRecord const volatile*>(mRecords->data());
+    auto const writeIndex = *static_cast<std::int64_t const volatile*>(mWriteIndex->data());
+    // The records up to writeIndex are complete once the write index is visible.
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (writeIndex - mReadIndex > mCapacity)
+    {
+        auto const numOverwritten = writeIndex - mCapacity - mReadIndex;
+        TLLM_LOG_WARNING("Token stream overflow, %ld tokens were overwritten before polling", numOverwritten);
+        mNumDropped += numOverwritten;
+        mReadIndex = writeIndex - mCapacity;
+    }
+
+    SizeType numPolled{0};
+    for (; mReadIndex < writeIndex; ++mReadIndex)
+    {
+        auto const& src = ring[mReadIndex % mCapacity];
+        auto const sequence = src.sequence;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        TokenStreamRecord record{};
+        record.sequence = sequence;
+        record.slot = src.slot;
+        record.position = src.position;
+        record.token = src.token;
+        record.logProb = src.logProb;
+        record.finished = src.finished;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // A later decoding step may already be overwriting the record.
+        if (sequence != mReadIndex + 1 || src.sequence != sequence)
+        {
+            ++mNumDropped;
+            continue;
+        }
+        records.push_back(record);
+        ++numPolled;
+    }
+    return numPolled;
+}
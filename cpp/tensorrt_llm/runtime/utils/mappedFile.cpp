@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/utils/mappedFile.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/startupReport.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif // !defined(_WIN32)
+
+using namespace tensorrt_llm::runtime::utils;
+
+MappedFile::MappedFile(std::string const& path, bool readahead)
+    : mPath{path}
+{
+    StartupReport::ScopedPhase const startupPhase{"engine_read"};
+#if !defined(_WIN32)
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    TLLM_CHECK_WITH_INFO(fd >= 0, "Error opening file %s: %s", path.c_str(), std::strerror(errno));
+
+    struct stat fileStat = {};
+    if (::fstat(fd, &fileStat) != 0)
+    {
+        auto const error = errno;
+        ::close(fd);
+        TLLM_THROW("Error reading size of file %s: %s", path.c_str(), std::strerror(error));
+    }
+    mSize = static_cast<std::size_t>(fileStat.st_size);
+    if (mSize == 0)
+    {
+        ::close(fd);
+        return;
+    }
+
+    if (readahead)
+    {
+        // Start reading the whole file into the page cache in the background.
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    }
+
+    auto* const mapping = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    auto const error = errno;
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    TLLM_CHECK_WITH_INFO(mapping != MAP_FAILED, "Error mapping file %s: %s", path.c_str(), std::strerror(error));
+    mData = mapping;
+
+    if (readahead)
+    {
+        ::madvise(mapping, mSize, MADV_SEQUENTIAL);
+        ::madvise(mapping, mSize, MADV_WILLNEED);
+    }
+    TLLM_LOG_DEBUG("Mapped %s (%zu bytes)", path.c_str(), mSize);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    TLLM_CHECK_WITH_INFO(file.good(), std::string("Error opening file: " + path));
+    mSize = static_cast<std::size_t>(file.tellg());
+    file.seekg(0, std::ifstream::beg);
+    mBuffer.resize(mSize);
+    file.read(reinterpret_cast<char*>(mBuffer.data()), static_cast<std::streamsize>(mSize));
+    TLLM_CHECK_WITH_INFO(file.good(), std::string("Error loading file: " + path));
+    mData = mBuffer.data();
+#endif // !defined(_WIN32)
+}
+
+MappedFile::~MappedFile()
+{
+#if !defined(_WIN32)
+    if (mData != nullptr)
+    {
+        ::munmap(const_cast<void*>(mData), mSize);
+    }
+#endif // !defined(_WIN32)
+}
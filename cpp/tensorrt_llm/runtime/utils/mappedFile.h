@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime::utils
+{
+
+//! \brief Read-only view of a whole file, memory-mapped where the platform supports it.
+//! \details Mapping an engine instead of reading it into a std::vector avoids a private copy per process: pages
+//! come straight from the page cache, which stays warm across restarts and is shared by all processes that load
+//! the same file. With readahead enabled the kernel is asked to fetch the whole file asynchronously, so disk reads
+//! overlap with deserialization.
+class MappedFile
+{
+public:
+    explicit MappedFile(std::string const& path, bool readahead = true);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    [[nodiscard]] void const* data() const noexcept
+    {
+        return mData;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+    [[nodiscard]] std::string const& getPath() const noexcept
+    {
+        return mPath;
+    }
+
+private:
+    std::string mPath;
+    void const* mData{nullptr};
+    std::size_t mSize{0};
+    // Fallback storage on platforms without mmap
+    std::vector<std::uint8_t> mBuffer;
+};
+
+} // namespace tensorrt_llm::runtime::utils
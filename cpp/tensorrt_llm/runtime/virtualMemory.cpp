@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/virtualMemory.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+using namespace tensorrt_llm::runtime;
+
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+
+void checkDriver(CUresult result, tc::CUDADriverWrapper const& driver, char const* call)
+{
+    if (result != CUDA_SUCCESS)
+    {
+        char const* name = nullptr;
+        driver.cuGetErrorName(result, &name);
+        TLLM_THROW("%s failed: %s", call, name != nullptr ? name : "unknown error");
+    }
+}
+
+CUmemAllocationProp makeAllocationProp(int device)
+{
+    CUmemAllocationProp prop{};
+    prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+    prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    prop.location.id = device;
+    return prop;
+}
+
+std::size_t roundUp(std::size_t value, std::size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+VirtualMemoryBuffer::VirtualMemoryBuffer(std::size_t maxSizeInBytes, int device, std::size_t chunkSize)
+    : mDriver{std::make_shared<tc::CUDADriverWrapper>()}
+    , mDevice{device}
+{
+    TLLM_CHECK_WITH_INFO(maxSizeInBytes > 0, "Virtual memory buffer must not be empty");
+    auto const prop = makeAllocationProp(mDevice);
+    std::size_t granularity{0};
+    checkDriver(mDriver->cuMemGetAllocationGranularity(&granularity, &prop, CU_MEM_ALLOC_GRANULARITY_RECOMMENDED),
+        *mDriver, "cuMemGetAllocationGranularity");
+    mChunkSize = roundUp(chunkSize > 0 ? chunkSize : granularity, granularity);
+    mReservedSize = roundUp(maxSizeInBytes, mChunkSize);
+    checkDriver(mDriver->cuMemAddressReserve(&mBasePtr, mReservedSize, mChunkSize, 0, 0), *mDriver,
+        "cuMemAddressReserve");
+    mHandles.reserve(mReservedSize / mChunkSize);
+    TLLM_LOG_DEBUG("Reserved %zu bytes of virtual memory in chunks of %zu bytes", mReservedSize, mChunkSize);
+}
+
+VirtualMemoryBuffer::~VirtualMemoryBuffer()
+{
+    try
+    {
+        resize(0);
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_EXCEPTION(e);
+    }
+    mDriver->cuMemAddressFree(mBasePtr, mReservedSize);
+}
+
+void VirtualMemoryBuffer::resize(std::size_t sizeInBytes)
+{
+    TLLM_CHECK_WITH_INFO(sizeInBytes <= mReservedSize, "Requested size %zu exceeds reserved size %zu", sizeInBytes,
+        mReservedSize);
+    auto const numChunks = roundUp(sizeInBytes, mChunkSize) / mChunkSize;
+    while (mHandles.size() < numChunks)
+    {
+        mapChunk();
+    }
+    while (mHandles.size() > numChunks)
+    {
+        unmapChunk();
+    }
+}
+
+bool VirtualMemoryBuffer::isSupported(int device)
+{
+    tc::CUDADriverWrapper driver{};
+    auto const prop = makeAllocationProp(device);
+    std::size_t granularity{0};
+    return driver.cuMemGetAllocationGranularity(&granularity, &prop, CU_MEM_ALLOC_GRANULARITY_MINIMUM)
+        == CUDA_SUCCESS;
+}
+
+void VirtualMemoryBuffer::mapChunk()
+{
+    auto const prop = makeAllocationProp(mDevice);
+    CUmemGenericAllocationHandle handle{};
+    checkDriver(mDriver->cuMemCreate(&handle, mChunkSize, &prop, 0), *mDriver, "cuMemCreate");
+
+    auto const chunkPtr = mBasePtr + mHandles.size() * mChunkSize;
+    auto result = mDriver->cuMemMap(chunkPtr, mChunkSize, 0, handle, 0);
+    if (result == CUDA_SUCCESS)
+    {
+        CUmemAccessDesc access{};
+        access.location = prop.location;
+        access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+        result = mDriver->cuMemSetAccess(chunkPtr, mChunkSize, &access, 1);
+        if (result != CUDA_SUCCESS)
+        {
+            mDriver->cuMemUnmap(chunkPtr, mChunkSize);
+        }
+    }
+    if (result != CUDA_SUCCESS)
+    {
+        mDriver->cuMemRelease(handle);
+        checkDriver(result, *mDriver, "cuMemMap");
+    }
+
+    mHandles.push_back(handle);
+    MemoryCounters::getInstance().allocate<MemoryType::kGPU>(mChunkSize);
+}
+
+void VirtualMemoryBuffer::unmapChunk()
+{
+    auto const chunkPtr = mBasePtr + (mHandles.size() - 1) * mChunkSize;
+    checkDriver(mDriver->cuMemUnmap(chunkPtr, mChunkSize), *mDriver, "cuMemUnmap");
+    checkDriver(mDriver->cuMemRelease(mHandles.back()), *mDriver, "cuMemRelease");
+    mHandles.pop_back();
+    MemoryCounters::getInstance().deallocate<MemoryType::kGPU>(mChunkSize);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/workStealingPool.h"
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+
+namespace tensorrt_llm::runtime
+{
+
+WorkStealingPool::WorkStealingPool(SizeType numWorkers)
+    : mQueues(std::max(numWorkers, 1))
+{
+    TLLM_CHECK_WITH_INFO(numWorkers > 0, "A work stealing pool needs at least one worker");
+    mThreads.reserve(numWorkers - 1);
+    for (SizeType workerIdx = 1; workerIdx < numWorkers; ++workerIdx)
+    {
+        mThreads.emplace_back(&WorkStealingPool::workerLoop, this, workerIdx);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShutdown = true;
+    }
+    mStart.notify_all();
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(SizeType numItems, Task const& task, SizeType grainSize)
+{
+    TLLM_CHECK_WITH_INFO(grainSize > 0, "Grain size must be positive");
+    if (numItems <= 0)
+    {
+        return;
+    }
+    auto const numChunks = (numItems + grainSize - 1) / grainSize;
+    auto const numWorkers = getNumWorkers();
+    if (numWorkers == 1 || numChunks == 1)
+    {
+        for (SizeType itemIdx = 0; itemIdx < numItems; ++itemIdx)
+        {
+            task(itemIdx, 0);
+        }
+        return;
+    }
+
+    // The workers are idle, the previous call waited for them.
+    for (SizeType workerIdx = 0; workerIdx < numWorkers; ++workerIdx)
+    {
+        auto& queue = mQueues[workerIdx];
+        queue.begin = static_cast<SizeType>(static_cast<int64_t>(numChunks) * workerIdx / numWorkers);
+        queue.end = static_cast<SizeType>(static_cast<int64_t>(numChunks) * (workerIdx + 1) / numWorkers);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTask = &task;
+        mNumItems = numItems;
+        mGrainSize = grainSize;
+        mFailed = false;
+        mError = nullptr;
+        mNumBusy = numWorkers - 1;
+        ++mGeneration;
+    }
+    mStart.notify_all();
+
+    runWorker(0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this] { return mNumBusy == 0; });
+        mTask = nullptr;
+        std::swap(error, mError);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkStealingPool::workerLoop(SizeType workerIdx)
+{
+    std::uint64_t generation{0};
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStart.wait(lock, [this, generation] { return mShutdown || mGeneration != generation; });
+            if (mShutdown)
+            {
+                return;
+            }
+            generation = mGeneration;
+        }
+        runWorker(workerIdx);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--mNumBusy == 0)
+            {
+                mDone.notify_one();
+            }
+        }
+    }
+}
+
+void WorkStealingPool::runWorker(SizeType workerIdx)
+{
+    SizeType chunk{0};
+    while (!mFailed.load(std::memory_order_relaxed) && (popChunk(workerIdx, chunk) || stealChunk(workerIdx, chunk)))
+    {
+        auto const begin = chunk * mGrainSize;
+        auto const end = std::min(begin + mGrainSize, mNumItems);
+        try
+        {
+            for (auto itemIdx = begin; itemIdx < end; ++itemIdx)
+            {
+                (*mTask)(itemIdx, workerIdx);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mError)
+            {
+                mError = std::current_exception();
+            }
+            mFailed = true;
+        }
+    }
+}
+
+bool WorkStealingPool::popChunk(SizeType workerIdx, SizeType& chunk)
+{
+    auto& queue = mQueues[workerIdx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end)
+    {
+        return false;
+    }
+    chunk = queue.begin++;
+    return true;
+}
+
+bool WorkStealingPool::stealChunk(SizeType workerIdx, SizeType& chunk)
+{
+    auto const numWorkers = getNumWorkers();
+    for (SizeType offset = 1; offset < numWorkers; ++offset)
+    {
+        auto& victim = mQueues[(workerIdx + offset) % numWorkers];
+        SizeType begin{0};
+        SizeType end{0};
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto const numRemaining = victim.end - victim.begin;
+            if (numRemaining == 0)
+            {
+                continue;
+            }
+            // Take the back half, the victim keeps working on the front
+            end = victim.end;
+            begin = end - (numRemaining + 1) / 2;
+            victim.end = begin;
+        }
+        chunk = begin;
+        auto& queue = mQueues[workerIdx];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin = begin + 1;
+        queue.end = end;
+        return true;
+    }
+    return false;
+}
+
+} // namespace tensorrt_llm::runtime
@@ -29,9 +29,10 @@ using namespace tensorrt_llm::runtime;
 namespace tc = tensorrt_llm::common;
 
 WorldConfig::WorldConfig(SizeType tensorParallelism, SizeType pipelineParallelism, SizeType rank, SizeType gpusPerNode,
-    std::optional<std::vector<SizeType>> const& deviceIds)
+    std::optional<std::vector<SizeType>> const& deviceIds, SizeType contextParallelism)
     : mTensorParallelism{tensorParallelism}
     , mPipelineParallelism{pipelineParallelism}
+    , mContextParallelism{contextParallelism}
     , mRank{rank}
     , mGpusPerNode{gpusPerNode}
     , mDeviceIds{deviceIds.value_or(std::vector<SizeType>(mGpusPerNode))}
@@ -70,39 +71,56 @@ WorldConfig::WorldConfig(SizeType tensorParallelism, SizeType pipelineParallelis
 
     TLLM_CHECK(mTensorParallelism > 0);
     TLLM_CHECK(mPipelineParallelism > 0);
+    TLLM_CHECK(mContextParallelism > 0);
 }
 
-bool WorldConfig::validConfig(SizeType tensorParallelism, SizeType pipelineParallelism)
+bool WorldConfig::validConfig(SizeType tensorParallelism, SizeType pipelineParallelism, SizeType contextParallelism)
 {
     auto const mpiSize = COMM_SESSION.getSize();
-    return mpiSize == tensorParallelism * pipelineParallelism;
+    return mpiSize == tensorParallelism * pipelineParallelism * contextParallelism;
 }
 
 WorldConfig WorldConfig::mpi(SizeType gpusPerNode, std::optional<SizeType> tensorParallelism,
-    std::optional<SizeType> pipelineParallelism, std::optional<std::vector<SizeType>> const& deviceIds)
+    std::optional<SizeType> pipelineParallelism, std::optional<std::vector<SizeType>> const& deviceIds,
+    std::optional<SizeType> contextParallelism)
 {
     auto& comm = COMM_SESSION;
     auto const mpiSize = comm.getSize();
     auto const mpiRank = comm.getRank();
     TLLM_LOG_INFO("MPI size: %d, rank: %d", mpiSize, mpiRank);
     auto const pp = pipelineParallelism.value_or(1);
-    auto const tp = tensorParallelism.value_or(mpiSize / pp);
-    TLLM_LOG_DEBUG("TP: %d, PP: %d", tp, pp);
-    TLLM_CHECK(mpiSize == tp * pp);
+    auto const cp = contextParallelism.value_or(1);
+    auto const tp = tensorParallelism.value_or(mpiSize / (pp * cp));
+    TLLM_LOG_DEBUG("TP: %d, PP: %d, CP: %d", tp, pp, cp);
+    TLLM_CHECK(mpiSize == tp * pp * cp);
 
-    return WorldConfig{tp, pp, mpiRank, gpusPerNode, deviceIds};
+    return WorldConfig{tp, pp, mpiRank, gpusPerNode, deviceIds, cp};
 }
 
 std::vector<SizeType> WorldConfig::getPipelineParallelGroup() const
 {
     auto const pp = getPipelineParallelism();
-    auto const tp = getTensorParallelism();
+    auto const stageSize = getTensorParallelism() * getContextParallelism();
     auto const worldSize = getSize();
     std::vector<SizeType> group;
     group.reserve(pp);
-    for (SizeType idx = getTensorParallelRank(); idx < worldSize; idx += tp)
+    for (SizeType idx = mRank % stageSize; idx < worldSize; idx += stageSize)
     {
         group.push_back(idx);
     }
     return group;
 }
+
+std::vector<SizeType> WorldConfig::getContextParallelGroup() const
+{
+    auto const cp = getContextParallelism();
+    auto const tp = getTensorParallelism();
+    auto const firstRank = getPipelineParallelRank() * tp * cp + getTensorParallelRank();
+    std::vector<SizeType> group;
+    group.reserve(cp);
+    for (SizeType idx = 0; idx < cp; ++idx)
+    {
+        group.push_back(firstRank + idx * tp);
+    }
+    return group;
+}
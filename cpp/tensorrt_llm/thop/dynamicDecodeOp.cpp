@@ -16,15 +16,12 @@
 
 #include "tensorrt_llm/thop/dynamicDecodeOp.h"
 
-#include "tensorrt_llm/common/tensorConversion.h"
-#include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/thop/thUtils.h"
 #include "tensorrt_llm/thop/torchAllocator.h"
 
 namespace th = torch;
 
 namespace tr = tensorrt_llm::runtime;
-namespace tcc = tensorrt_llm::common::conversion;
 
 namespace torch_ext
 {
@@ -34,8 +31,10 @@ FtDynamicDecode<T>::FtDynamicDecode(const size_t max_batch_size, const size_t ma
     const size_t vocab_size_padded, const int tensor_para_size, const int pipeline_para_size)
     : vocab_size_(vocab_size)
     , vocab_size_padded_(vocab_size_padded)
-    , finished_sum_(tr::BufferManager::pinned(
-          tr::ITensor::makeShape({static_cast<int32_t>(max_batch_size)}), nvinfer1::DataType::kINT32))
+    , finished_sum_(torch::zeros({static_cast<int64_t>(max_batch_size)},
+          torch::dtype(torch::kInt32).device(torch::kCUDA, at::cuda::current_device()).requires_grad(false)))
+    , should_stop_(torch::zeros(
+          {1}, torch::dtype(torch::kBool).device(torch::kCUDA, at::cuda::current_device()).requires_grad(false)))
 {
     TLLM_CHECK_WITH_INFO(vocab_size_padded_ % tensor_para_size == 0,
         tensorrt_llm::common::fmtstr(
@@ -134,7 +133,7 @@ void FtDynamicDecode<T>::setup(size_t batch_size, size_t beam_width, th::optiona
 }
 
 template <typename T>
-void FtDynamicDecode<T>::forward(th::Tensor& logits, // (batch_size, beam_width, hidden_size)
+th::Tensor FtDynamicDecode<T>::forward(th::Tensor& logits, // (batch_size, beam_width, hidden_size)
     int step, int max_input_length, int max_attention_window, int sink_token_length, uint64_t ite, int local_batch_size,
     th::Tensor end_id, th::optional<th::Tensor> embedding_bias_opt, th::optional<th::Tensor> input_lengths_opt,
     th::optional<th::Tensor> sequence_limit_length_opt, th::optional<th::Tensor> stop_words_list_ptrs_opt,
@@ -143,18 +142,20 @@ void FtDynamicDecode<T>::forward(th::Tensor& logits, // (batch_size, beam_width,
     int32_t max_bad_words_len, th::optional<th::Tensor> no_repeat_ngram_size_opt,
     th::optional<th::Tensor> src_cache_indirection_opt,
     // Outputs
-    th::Tensor& output_token_ids, th::Tensor& newTokens, th::Tensor& should_stop,
-    th::optional<th::Tensor> finished_input, th::optional<th::Tensor> finished_output,
-    th::optional<th::Tensor> sequence_lengths_opt, th::optional<th::Tensor> cum_log_probs_opt,
-    th::optional<th::Tensor> output_log_probs_opt, th::optional<th::Tensor> output_log_probs_tiled_opt,
-    th::optional<th::Tensor> parent_ids_opt, th::optional<th::Tensor> tgt_cache_indirection_opt,
-    th::optional<th::Tensor> beam_hyps_output_ids_tgt_opt, th::optional<th::Tensor> beam_hyps_sequence_lengths_tgt_opt,
-    th::optional<th::Tensor> beam_hyps_cum_log_probs_opt, th::optional<th::Tensor> beam_hyps_normed_scores_opt,
-    th::optional<th::Tensor> beam_hyps_log_probs_opt, th::optional<th::Tensor> beam_hyps_min_normed_scores_opt,
-    th::optional<th::Tensor> beam_hyps_num_beams_opt, th::optional<th::Tensor> beam_hyps_is_done_opt,
-    bool use_beam_hyps)
+    th::Tensor& output_token_ids, th::Tensor& newTokens, th::optional<th::Tensor> finished_input,
+    th::optional<th::Tensor> finished_output, th::optional<th::Tensor> sequence_lengths_opt,
+    th::optional<th::Tensor> cum_log_probs_opt, th::optional<th::Tensor> output_log_probs_opt,
+    th::optional<th::Tensor> output_log_probs_tiled_opt, th::optional<th::Tensor> parent_ids_opt,
+    th::optional<th::Tensor> tgt_cache_indirection_opt, th::optional<th::Tensor> beam_hyps_output_ids_tgt_opt,
+    th::optional<th::Tensor> beam_hyps_sequence_lengths_tgt_opt, th::optional<th::Tensor> beam_hyps_cum_log_probs_opt,
+    th::optional<th::Tensor> beam_hyps_normed_scores_opt, th::optional<th::Tensor> beam_hyps_log_probs_opt,
+    th::optional<th::Tensor> beam_hyps_min_normed_scores_opt, th::optional<th::Tensor> beam_hyps_num_beams_opt,
+    th::optional<th::Tensor> beam_hyps_is_done_opt, bool use_beam_hyps)
 
 {
+    // Follow the current stream, e.g. the capture stream of a CUDA graph
+    dynamic_decode_layer_->setStream(at::cuda::getCurrentCUDAStream().stream());
+
     auto const& logits_converted = convert_tensor<float>(logits);
     auto const& end_ids_converted = convert_tensor<int>(end_id);
     typename tensorrt_llm::layers::DynamicDecodeLayer<T>::ForwardParams forwardParams{step, static_cast<int>(ite),
@@ -179,15 +180,12 @@ void FtDynamicDecode<T>::forward(th::Tensor& logits, // (batch_size, beam_width,
     outputParams.newTokens = std::move(convert_tensor<int>(newTokens));
 
     safeUpdate<uint8_t>(finished_output, outputParams.finished);
-    std::int32_t* finished_sum_host = nullptr;
-    if (forwardParams.sequence_limit_length && outputParams.finished.has_value())
+    bool const check_finished_sum = forwardParams.sequence_limit_length && outputParams.finished.has_value();
+    auto finished_sum = finished_sum_.narrow(0, 0, local_batch_size);
+    if (check_finished_sum)
     {
-        outputParams.finished_sum = tcc::toTllmTensor(*finished_sum_);
-        finished_sum_host = tr::bufferCast<std::int32_t>(*finished_sum_);
-        for (int32_t bi = 0; bi < local_batch_size; ++bi)
-        {
-            finished_sum_host[bi] = 0;
-        }
+        finished_sum.zero_();
+        outputParams.finished_sum = convert_tensor<int>(finished_sum);
     }
     safeUpdate<int>(sequence_lengths_opt, outputParams.sequence_length);
     safeUpdate<int>(parent_ids_opt, outputParams.parent_ids);
@@ -211,18 +209,17 @@ void FtDynamicDecode<T>::forward(th::Tensor& logits, // (batch_size, beam_width,
     }
 
     dynamic_decode_layer_->forward(outputParams, forwardParams);
-    if (finished_sum_host)
+    if (check_finished_sum)
+    {
+        // Reduced on the device, the caller decides when to read it back
+        auto const numToFinish = static_cast<int64_t>(outputParams.finished->size());
+        should_stop_.copy_(finished_sum.sum().eq(numToFinish).reshape({1}));
+    }
+    else
     {
-        TLLM_CUDA_CHECK(::cudaStreamSynchronize(dynamic_decode_layer_->getStream()));
-        int32_t finished_sum = 0;
-        for (int32_t bi = 0; bi < local_batch_size; ++bi)
-        {
-            finished_sum += finished_sum_host[bi];
-        }
-        auto const numToFinish = outputParams.finished->size();
-        auto should_stop_accessor = should_stop.accessor<bool, 1>();
-        should_stop_accessor[0] = numToFinish == finished_sum;
+        should_stop_.zero_();
     }
+    return should_stop_;
 }
 
 DynamicDecodeOp::DynamicDecodeOp(const int64_t max_batch_size, const int64_t max_beam_width, const int64_t vocab_size,
@@ -359,9 +356,7 @@ th::Tensor DynamicDecodeOp::forward(th::Tensor logits, int64_t step, int64_t max
     CHECK_OPTIONAL_INPUT(parent_ids_opt, torch::kInt32);
     CHECK_OPTIONAL_INPUT(tgt_cache_indirection_opt, torch::kInt32);
 
-    th::Tensor should_stop = torch::zeros({1}, torch::dtype(torch::kBool).requires_grad(false));
-
-    dynamic_decode_->forward(
+    return dynamic_decode_->forward(
         // Inputs
         logits, static_cast<int>(step), static_cast<int>(max_input_length), static_cast<int>(max_attention_window),
         static_cast<int>(sink_token_length), static_cast<uint32_t>(ite), static_cast<int>(local_batch_size), end_id,
@@ -369,13 +364,11 @@ th::Tensor DynamicDecodeOp::forward(th::Tensor logits, int64_t step, int64_t max
         static_cast<int32_t>(max_stop_words_len), bad_words_list_ptrs_opt, bad_words_lens_opt,
         static_cast<int32_t>(max_bad_words_len), no_repeat_ngram_size_opt, src_cache_indirection_opt,
         // Outputs
-        output_token_ids, newTokens, should_stop, finished_input, finished_output, seuqence_lengths_opt,
-        cum_log_probs_opt, output_log_probs_opt, output_log_probs_tiled_opt, parent_ids_opt, tgt_cache_indirection_opt,
+        output_token_ids, newTokens, finished_input, finished_output, seuqence_lengths_opt, cum_log_probs_opt,
+        output_log_probs_opt, output_log_probs_tiled_opt, parent_ids_opt, tgt_cache_indirection_opt,
         beam_hyps_output_ids_tgt_opt, beam_hyps_sequence_lengths_tgt_opt, beam_hyps_cum_log_probs_opt,
         beam_hyps_normed_scores_opt, beam_hyps_log_probs_opt, beam_hyps_min_normed_scores_opt, beam_hyps_num_beams_opt,
         beam_hyps_is_done_opt, use_beam_hyps);
-
-    return should_stop;
 }
 
 } // namespace torch_ext
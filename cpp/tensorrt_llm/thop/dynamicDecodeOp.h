@@ -37,7 +37,10 @@ public:
         th::optional<th::Tensor> top_p_reset_ids_opt)
         = 0;
 
-    virtual void forward(th::Tensor& logits, // (batch_size, beam_width, hidden_size)
+    // Enqueues on the current CUDA stream without host synchronization or device allocations, so that the decoding
+    // steps can be captured into a CUDA graph. Returns whether all sequences finished, as a [1] bool tensor on the
+    // device that is overwritten by the next call.
+    virtual th::Tensor forward(th::Tensor& logits, // (batch_size, beam_width, hidden_size)
         int step, int max_input_length, int max_attention_window, int sink_token_length, uint64_t ite,
         int local_batch_size, th::Tensor end_id, th::optional<th::Tensor> embedding_bias_opt,
         th::optional<th::Tensor> input_lengths_opt, th::optional<th::Tensor> sequence_limit_length_opt,
@@ -46,12 +49,11 @@ public:
         th::optional<th::Tensor> bad_words_lens_opt, int32_t max_bad_words_len,
         th::optional<th::Tensor> no_repeat_ngram_size_opt, th::optional<th::Tensor> src_cache_indirection_opt,
         // Outputs
-        th::Tensor& output_token_ids, th::Tensor& newTokens, th::Tensor& should_stop,
-        th::optional<th::Tensor> finished_input, th::optional<th::Tensor> finished_output,
-        th::optional<th::Tensor> sequence_lengths_opt, th::optional<th::Tensor> cum_log_probs_opt,
-        th::optional<th::Tensor> output_log_probs_opt, th::optional<th::Tensor> output_log_probs_tiled_opt,
-        th::optional<th::Tensor> parent_ids_opt, th::optional<th::Tensor> tgt_cache_indirection_opt,
-        th::optional<th::Tensor> beam_hyps_output_ids_tgt_opt,
+        th::Tensor& output_token_ids, th::Tensor& newTokens, th::optional<th::Tensor> finished_input,
+        th::optional<th::Tensor> finished_output, th::optional<th::Tensor> sequence_lengths_opt,
+        th::optional<th::Tensor> cum_log_probs_opt, th::optional<th::Tensor> output_log_probs_opt,
+        th::optional<th::Tensor> output_log_probs_tiled_opt, th::optional<th::Tensor> parent_ids_opt,
+        th::optional<th::Tensor> tgt_cache_indirection_opt, th::optional<th::Tensor> beam_hyps_output_ids_tgt_opt,
         th::optional<th::Tensor> beam_hyps_sequence_lengths_tgt_opt,
         th::optional<th::Tensor> beam_hyps_cum_log_probs_opt, th::optional<th::Tensor> beam_hyps_normed_scores_opt,
         th::optional<th::Tensor> beam_hyps_log_probs_opt, th::optional<th::Tensor> beam_hyps_min_normed_scores_opt,
@@ -78,7 +80,7 @@ public:
         th::optional<th::Tensor> top_p_decay_opt, th::optional<th::Tensor> top_p_min_opt,
         th::optional<th::Tensor> top_p_reset_ids_opt) override;
 
-    void forward(th::Tensor& logits, // (batch_size, beam_width, hidden_size)
+    th::Tensor forward(th::Tensor& logits, // (batch_size, beam_width, hidden_size)
         int step, int max_input_length, int max_attention_window, int sink_token_length, uint64_t ite,
         int local_batch_size, th::Tensor end_id, th::optional<th::Tensor> embedding_bias_opt,
         th::optional<th::Tensor> input_lengths_opt, th::optional<th::Tensor> sequence_limit_length_opt,
@@ -87,12 +89,11 @@ public:
         th::optional<th::Tensor> bad_words_lens_opt, int32_t max_bad_words_len,
         th::optional<th::Tensor> no_repeat_ngram_size_opt, th::optional<th::Tensor> src_cache_indirection_opt,
         // Outputs
-        th::Tensor& output_token_ids, th::Tensor& newTokens, th::Tensor& should_stop,
-        th::optional<th::Tensor> finished_input, th::optional<th::Tensor> finished_output,
-        th::optional<th::Tensor> sequence_lengths_opt, th::optional<th::Tensor> cum_log_probs_opt,
-        th::optional<th::Tensor> output_log_probs_opt, th::optional<th::Tensor> output_log_probs_tiled_opt,
-        th::optional<th::Tensor> parent_ids_opt, th::optional<th::Tensor> tgt_cache_indirection_opt,
-        th::optional<th::Tensor> beam_hyps_output_ids_tgt_opt,
+        th::Tensor& output_token_ids, th::Tensor& newTokens, th::optional<th::Tensor> finished_input,
+        th::optional<th::Tensor> finished_output, th::optional<th::Tensor> sequence_lengths_opt,
+        th::optional<th::Tensor> cum_log_probs_opt, th::optional<th::Tensor> output_log_probs_opt,
+        th::optional<th::Tensor> output_log_probs_tiled_opt, th::optional<th::Tensor> parent_ids_opt,
+        th::optional<th::Tensor> tgt_cache_indirection_opt, th::optional<th::Tensor> beam_hyps_output_ids_tgt_opt,
         th::optional<th::Tensor> beam_hyps_sequence_lengths_tgt_opt,
         th::optional<th::Tensor> beam_hyps_cum_log_probs_opt, th::optional<th::Tensor> beam_hyps_normed_scores_opt,
         th::optional<th::Tensor> beam_hyps_log_probs_opt, th::optional<th::Tensor> beam_hyps_min_normed_scores_opt,
@@ -106,7 +107,9 @@ private:
     cudaDeviceProp prop_;
 
     std::shared_ptr<tensorrt_llm::layers::DynamicDecodeLayer<T>> dynamic_decode_layer_;
-    tensorrt_llm::runtime::ITensor::SharedPtr finished_sum_;
+    // Preallocated on the device, [max_batch_size] int32 and [1] bool
+    th::Tensor finished_sum_;
+    th::Tensor should_stop_;
 };
 
 class DynamicDecodeOp : public th::jit::CustomClassHolder
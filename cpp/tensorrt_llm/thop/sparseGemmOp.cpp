@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaBf16Wrapper.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/sparse_gemm/sparse_gemm.h"
+#include "tensorrt_llm/thop/thUtils.h"
+
+namespace torch_ext
+{
+using torch::Tensor;
+using namespace tensorrt_llm::kernels::cutlass_kernels;
+
+// Compresses the 2:4 structured sparse [n, k] weight of the SparseGemm plugin into its [n, k / 2] nonzeros and the
+// int8 metadata that locates them. If prune is set, the 2 elements of largest magnitude of every group of 4 along k
+// are kept, else the weight must already be 2:4 sparse.
+std::vector<Tensor> compress_2_4_sparse_weights(Tensor weight, bool prune)
+{
+    CHECK_CONTIGUOUS(weight);
+    TORCH_CHECK(!weight.is_cuda(), "The weight must be on the CPU");
+    TORCH_CHECK(weight.dim() == 2, "Invalid dim. The dim of weight should be 2");
+
+    const int n = weight.size(0);
+    const int k = weight.size(1);
+    TORCH_CHECK(n % 32 == 0 && k % 128 == 0, "n must be a multiple of 32 and k a multiple of 128");
+
+    Tensor compressed = torch::empty({n, k / 2}, torch::dtype(weight.dtype()).requires_grad(false));
+
+    auto _st = weight.scalar_type();
+    size_t metadataSize{0};
+    if (_st == at::ScalarType::Char)
+    {
+        metadataSize = getSparseGemmMetadataSize<int8_t>(n, k);
+    }
+    else
+    {
+        TORCH_CHECK(_st == at::ScalarType::Half || _st == at::ScalarType::BFloat16,
+            "Invalid datatype. Weight must be FP16, BF16 or INT8");
+        metadataSize = getSparseGemmMetadataSize<half>(n, k);
+    }
+    Tensor metadata = torch::empty({n, int64_t(metadataSize / n)}, torch::dtype(torch::kInt8).requires_grad(false));
+
+    if (_st == at::ScalarType::Char)
+    {
+        compressSparseGemmWeights<int8_t>(
+            get_ptr<int8_t>(compressed), get_ptr<int8_t>(metadata), get_ptr<const int8_t>(weight), n, k, prune);
+    }
+    else if (_st == at::ScalarType::Half)
+    {
+        compressSparseGemmWeights<half>(
+            get_ptr<half>(compressed), get_ptr<int8_t>(metadata), get_ptr<const half>(weight), n, k, prune);
+    }
+#ifdef ENABLE_BF16
+    else if (_st == at::ScalarType::BFloat16)
+    {
+        compressSparseGemmWeights<__nv_bfloat16>(get_ptr<__nv_bfloat16>(compressed), get_ptr<int8_t>(metadata),
+            get_ptr<const __nv_bfloat16>(weight), n, k, prune);
+    }
+#endif
+    else
+    {
+        TORCH_CHECK(false, "Invalid datatype. Weight must be FP16, BF16 or INT8");
+    }
+
+    return std::vector<Tensor>{compressed, metadata};
+}
+
+} // namespace torch_ext
+
+static auto compress_2_4_sparse_weights
+    = torch::RegisterOperators("trtllm::compress_2_4_sparse_weights", &torch_ext::compress_2_4_sparse_weights);
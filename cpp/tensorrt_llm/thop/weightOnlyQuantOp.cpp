@@ -60,7 +60,6 @@ QuantType get_ft_quant_type(torch::ScalarType quant_type)
 Tensor permute_B_rows_for_mixed_gemm(Tensor quantized_tensor, torch::ScalarType quant_type, const int64_t arch_version)
 {
     auto _st = quantized_tensor.scalar_type();
-    CHECK_CPU(quantized_tensor);
     CHECK_CONTIGUOUS(quantized_tensor);
     TORCH_CHECK(_st == torch::kInt8, "Quantized tensor must be int8 dtype");
     check_quant_type_allowed(quant_type);
@@ -79,8 +78,16 @@ Tensor permute_B_rows_for_mixed_gemm(Tensor quantized_tensor, torch::ScalarType
     int8_t* input_byte_ptr = get_ptr<int8_t>(quantized_tensor);
     int8_t* output_byte_ptr = get_ptr<int8_t>(transformed_tensor);
 
-    permute_B_rows_for_mixed_gemm(
-        output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type, arch_version);
+    if (quantized_tensor.is_cuda())
+    {
+        permute_B_rows_for_mixed_gemm_cuda(output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols},
+            ft_quant_type, arch_version, at::cuda::getCurrentCUDAStream().stream());
+    }
+    else
+    {
+        permute_B_rows_for_mixed_gemm(
+            output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type, arch_version);
+    }
 
     return transformed_tensor;
 }
@@ -90,7 +97,6 @@ Tensor subbyte_transpose(Tensor quantized_tensor, torch::ScalarType quant_type)
 {
 
     auto _st = quantized_tensor.scalar_type();
-    CHECK_CPU(quantized_tensor);
     CHECK_CONTIGUOUS(quantized_tensor);
     TORCH_CHECK(_st == torch::kInt8, "Quantized tensor must be int8 dtype");
     check_quant_type_allowed(quant_type);
@@ -109,14 +115,22 @@ Tensor subbyte_transpose(Tensor quantized_tensor, torch::ScalarType quant_type)
     int8_t* input_byte_ptr = get_ptr<int8_t>(quantized_tensor);
     int8_t* output_byte_ptr = get_ptr<int8_t>(transposed_tensor);
 
-    subbyte_transpose(output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type);
+    if (quantized_tensor.is_cuda())
+    {
+        subbyte_transpose_cuda(output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type,
+            at::cuda::getCurrentCUDAStream().stream());
+    }
+    else
+    {
+        subbyte_transpose(output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type);
+    }
     return transposed_tensor;
 }
 
+// Runs on the device of the weight, a weight on gpu is preprocessed by the CUDA kernels.
 Tensor preprocess_weights_for_mixed_gemm(Tensor row_major_quantized_weight, torch::ScalarType quant_type)
 {
     auto _st = row_major_quantized_weight.scalar_type();
-    CHECK_CPU(row_major_quantized_weight);
     CHECK_CONTIGUOUS(row_major_quantized_weight);
     TORCH_CHECK(_st == torch::kInt8, "Quantized tensor must be int8 dtype");
     check_quant_type_allowed(quant_type);
@@ -134,16 +148,62 @@ Tensor preprocess_weights_for_mixed_gemm(Tensor row_major_quantized_weight, torc
     int8_t* input_byte_ptr = get_ptr<int8_t>(row_major_quantized_weight);
     int8_t* output_byte_ptr = get_ptr<int8_t>(processed_tensor);
 
-    preprocess_weights_for_mixed_gemm(
-        output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type);
+    if (row_major_quantized_weight.is_cuda())
+    {
+        const std::vector<size_t> shape{num_experts, num_rows, num_cols};
+        Tensor workspace = torch::empty(
+            {int64_t(get_preprocess_weights_for_mixed_gemm_cuda_workspace_size(shape, ft_quant_type))},
+            torch::dtype(torch::kInt8).device(row_major_quantized_weight.device()).requires_grad(false));
+        preprocess_weights_for_mixed_gemm_cuda(output_byte_ptr, input_byte_ptr, get_ptr<int8_t>(workspace), shape,
+            ft_quant_type, at::cuda::getCurrentCUDAStream().stream());
+    }
+    else
+    {
+        preprocess_weights_for_mixed_gemm(
+            output_byte_ptr, input_byte_ptr, {num_experts, num_rows, num_cols}, ft_quant_type);
+    }
 
     return processed_tensor;
 }
 
+// Quantizes on the device of the weight, the outputs are on the same device.
+void symmetric_quantize_cuda_helper(int8_t* processed_quantized_weight_ptr, int8_t* unprocessed_quantized_weight_ptr,
+    Tensor& scales, const Tensor& weight, const std::vector<size_t>& shape, QuantType ft_quant_type,
+    bool force_interleave)
+{
+    Tensor workspace = torch::empty({int64_t(get_symmetric_quantize_cuda_workspace_size(shape, ft_quant_type))},
+        torch::dtype(torch::kInt8).device(weight.device()).requires_grad(false));
+    auto stream = at::cuda::getCurrentCUDAStream().stream();
+
+    if (weight.scalar_type() == at::ScalarType::Float)
+    {
+        symmetric_quantize_cuda<float, float>(processed_quantized_weight_ptr, unprocessed_quantized_weight_ptr,
+            get_ptr<float>(scales), get_ptr<const float>(weight), get_ptr<int8_t>(workspace), shape, ft_quant_type,
+            force_interleave, stream);
+    }
+    else if (weight.scalar_type() == at::ScalarType::Half)
+    {
+        symmetric_quantize_cuda<half, half>(processed_quantized_weight_ptr, unprocessed_quantized_weight_ptr,
+            get_ptr<half>(scales), get_ptr<const half>(weight), get_ptr<int8_t>(workspace), shape, ft_quant_type,
+            force_interleave, stream);
+    }
+#ifdef ENABLE_BF16
+    else if (weight.scalar_type() == at::ScalarType::BFloat16)
+    {
+        symmetric_quantize_cuda<__nv_bfloat16, __nv_bfloat16>(processed_quantized_weight_ptr,
+            unprocessed_quantized_weight_ptr, get_ptr<__nv_bfloat16>(scales), get_ptr<const __nv_bfloat16>(weight),
+            get_ptr<int8_t>(workspace), shape, ft_quant_type, force_interleave, stream);
+    }
+#endif
+    else
+    {
+        TORCH_CHECK(false, "Invalid datatype. Weight must be BF16/FP16");
+    }
+}
+
 std::vector<Tensor> symmetric_quantize_helper(
     Tensor weight, torch::ScalarType quant_type, bool return_unprocessed_quantized_tensor)
 {
-    CHECK_CPU(weight);
     CHECK_CONTIGUOUS(weight);
     TORCH_CHECK(weight.numel() != 0, "weight should not be empty tensor");
     TORCH_CHECK(weight.dim() == 2 || weight.dim() == 3, "Invalid dim. The dim of weight should be 2 or 3");
@@ -181,12 +241,13 @@ std::vector<Tensor> symmetric_quantize_helper(
         TORCH_CHECK(false, "Invalid weight dimension. Weight must have dim 2 or 3");
     }
 
-    Tensor unprocessed_quantized_weight
-        = torch::empty(quantized_weight_shape, torch::dtype(torch::kInt8).device(torch::kCPU).requires_grad(false));
+    Tensor unprocessed_quantized_weight = torch::empty(
+        quantized_weight_shape, torch::dtype(torch::kInt8).device(weight.device()).requires_grad(false));
 
     Tensor processed_quantized_weight = torch::empty_like(unprocessed_quantized_weight);
 
-    Tensor scales = torch::empty(scale_shape, torch::dtype(weight.dtype()).device(torch::kCPU).requires_grad(false));
+    Tensor scales
+        = torch::empty(scale_shape, torch::dtype(weight.dtype()).device(weight.device()).requires_grad(false));
 
     int8_t* unprocessed_quantized_weight_ptr = get_ptr<int8_t>(unprocessed_quantized_weight);
     int8_t* processed_quantized_weight_ptr = get_ptr<int8_t>(processed_quantized_weight);
@@ -194,7 +255,12 @@ std::vector<Tensor> symmetric_quantize_helper(
     // TODO(dastokes) This should be removed if Grouped GEMM is updated to not need interleaved input
     bool force_interleave = weight.dim() == 3;
 
-    if (weight.scalar_type() == at::ScalarType::Float)
+    if (weight.is_cuda())
+    {
+        symmetric_quantize_cuda_helper(processed_quantized_weight_ptr, unprocessed_quantized_weight_ptr, scales,
+            weight, {num_experts, num_rows, num_cols}, ft_quant_type, force_interleave);
+    }
+    else if (weight.scalar_type() == at::ScalarType::Float)
     {
         symmetric_quantize<float, float>(processed_quantized_weight_ptr, unprocessed_quantized_weight_ptr,
             get_ptr<float>(scales), get_ptr<const float>(weight), {num_experts, num_rows, num_cols}, ft_quant_type,
@@ -242,7 +308,6 @@ std::vector<Tensor> _symmetric_quantize_last_axis_of_batched_matrix(Tensor weigh
 
 Tensor add_bias_and_interleave_int4s(Tensor weight)
 {
-    CHECK_CPU(weight);
     CHECK_CONTIGUOUS(weight);
     TORCH_CHECK(weight.numel() != 0, "weight should not be empty tensor");
     TORCH_CHECK(weight.dtype() == torch::kInt8, "Weight must be a packed int8 tensor");
@@ -251,14 +316,22 @@ Tensor add_bias_and_interleave_int4s(Tensor weight)
     int8_t* int4_tensor_ptr = get_ptr<int8_t>(output);
     const size_t num_bytes = output.numel();
     const size_t num_elts = 2 * num_bytes;
-    add_bias_and_interleave_quantized_tensor_inplace(int4_tensor_ptr, num_elts, QuantType::PACKED_INT4_WEIGHT_ONLY);
+    if (output.is_cuda())
+    {
+        add_bias_and_interleave_quantized_tensor_inplace_cuda(int4_tensor_ptr, num_elts,
+            QuantType::PACKED_INT4_WEIGHT_ONLY, at::cuda::getCurrentCUDAStream().stream());
+    }
+    else
+    {
+        add_bias_and_interleave_quantized_tensor_inplace(
+            int4_tensor_ptr, num_elts, QuantType::PACKED_INT4_WEIGHT_ONLY);
+    }
 
     return output;
 }
 
 Tensor add_bias_and_interleave_int8s(Tensor weight)
 {
-    CHECK_CPU(weight);
     CHECK_CONTIGUOUS(weight);
     TORCH_CHECK(weight.numel() != 0, "weight should not be empty tensor");
     TORCH_CHECK(weight.dtype() == torch::kInt8, "Weight must be an int8 tensor");
@@ -266,7 +339,15 @@ Tensor add_bias_and_interleave_int8s(Tensor weight)
 
     int8_t* int8_tensor_ptr = get_ptr<int8_t>(output);
     const size_t num_elts = output.numel();
-    add_bias_and_interleave_quantized_tensor_inplace(int8_tensor_ptr, num_elts, QuantType::INT8_WEIGHT_ONLY);
+    if (output.is_cuda())
+    {
+        add_bias_and_interleave_quantized_tensor_inplace_cuda(
+            int8_tensor_ptr, num_elts, QuantType::INT8_WEIGHT_ONLY, at::cuda::getCurrentCUDAStream().stream());
+    }
+    else
+    {
+        add_bias_and_interleave_quantized_tensor_inplace(int8_tensor_ptr, num_elts, QuantType::INT8_WEIGHT_ONLY);
+    }
 
     return output;
 }
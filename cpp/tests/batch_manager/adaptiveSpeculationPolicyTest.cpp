@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/adaptiveSpeculationPolicy.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+
+namespace tensorrt_llm::batch_manager
+{
+
+namespace
+{
+using SizeType = AdaptiveSpeculationPolicy::SizeType;
+using RequestPtr = std::shared_ptr<LlmRequest>;
+
+RequestPtr createRequest(LlmRequest::RequestIdType requestId, LlmRequestState_t state, SizeType numDraftTokens)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(4, 1);
+    auto request = std::make_shared<LlmRequest>(requestId, 8, tokens, runtime::SamplingConfig{1}, false);
+    request->mState = state;
+    request->setDraftTokens(std::make_shared<LlmRequest::VecTokens>(numDraftTokens, 2));
+    return request;
+}
+} // namespace
+
+TEST(AdaptiveSpeculationPolicyTest, expectedTokensPerStep)
+{
+    EXPECT_FLOAT_EQ(AdaptiveSpeculationPolicy::expectedTokensPerStep(3, 1.f), 4.f);
+    EXPECT_FLOAT_EQ(AdaptiveSpeculationPolicy::expectedTokensPerStep(3, 0.f), 1.f);
+    EXPECT_FLOAT_EQ(AdaptiveSpeculationPolicy::expectedTokensPerStep(1, 0.5f), 1.5f);
+}
+
+TEST(AdaptiveSpeculationPolicyTest, stopsDraftingForLargeBatches)
+{
+    AdaptiveSpeculationPolicy policy(4, 256);
+    // Optimistic until the first measurement
+    EXPECT_FLOAT_EQ(policy.getAcceptanceRate(), 1.f);
+    EXPECT_EQ(policy.computeDraftLength(1), 4);
+    EXPECT_EQ(policy.computeDraftLength(0), 4);
+    // Every draft token costs a whole token of a compute bound step
+    EXPECT_EQ(policy.computeDraftLength(256), 0);
+}
+
+TEST(AdaptiveSpeculationPolicyTest, stopsDraftingWhenRejected)
+{
+    AdaptiveSpeculationPolicy policy(4, 256, 0.5f);
+    policy.recordAcceptance(4, 4);
+    EXPECT_FLOAT_EQ(policy.getAcceptanceRate(), 1.f);
+    for (int i = 0; i < 20; ++i)
+    {
+        policy.recordAcceptance(4, 0);
+    }
+    EXPECT_LT(policy.getAcceptanceRate(), 0.01f);
+    EXPECT_EQ(policy.computeDraftLength(1), 0);
+    // Verifications without drafts do not count
+    policy.recordAcceptance(0, 0);
+    EXPECT_LT(policy.getAcceptanceRate(), 0.01f);
+}
+
+TEST(AdaptiveSpeculationPolicyTest, applyCutsDraftsAndProbes)
+{
+    AdaptiveSpeculationPolicy policy(4, 256, 0.f, 2);
+    policy.recordAcceptance(4, 0);
+    auto const generation = createRequest(0, REQUEST_STATE_GENERATION_IN_PROGRESS, 4);
+    auto const context = createRequest(1, REQUEST_STATE_CONTEXT_INIT, 4);
+    AdaptiveSpeculationPolicy::RequestList const requests{generation, context};
+
+    EXPECT_EQ(policy.apply(requests), 0);
+    EXPECT_FALSE(generation->hasDraftTokens());
+    EXPECT_EQ(context->getNumDraftTokens(), 4);
+
+    // The second iteration without drafts probes the acceptance with a single token
+    generation->setDraftTokens(std::make_shared<LlmRequest::VecTokens>(4, 2));
+    EXPECT_EQ(policy.apply(requests), 1);
+    EXPECT_EQ(policy.getDraftLength(), 1);
+    EXPECT_EQ(generation->getNumDraftTokens(), 1);
+    EXPECT_EQ(policy.getMaxBatchDraftTokens(), 1);
+
+    // Accepted probes turn speculation back on
+    policy.recordAcceptance(1, 1);
+    generation->setDraftTokens(std::make_shared<LlmRequest::VecTokens>(4, 2));
+    EXPECT_EQ(policy.apply(requests), 4);
+    EXPECT_EQ(generation->getNumDraftTokens(), 4);
+}
+
+TEST(AdaptiveSpeculationPolicyTest, rejectsInvalidConfig)
+{
+    EXPECT_THROW(AdaptiveSpeculationPolicy(-1), std::exception);
+    EXPECT_THROW(AdaptiveSpeculationPolicy(4, 0), std::exception);
+    EXPECT_THROW(AdaptiveSpeculationPolicy(4, 256, 1.f), std::exception);
+    EXPECT_THROW(AdaptiveSpeculationPolicy(4, 256, 0.9f, 0), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager
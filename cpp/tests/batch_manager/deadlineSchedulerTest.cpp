@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/deadlineScheduler.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/requestSchedulingTable.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+namespace
+{
+using RequestIdType = RequestSchedulingTable::RequestIdType;
+using SizeType = DeadlineScheduler::SizeType;
+
+std::shared_ptr<LlmRequest> createRequest(RequestIdType requestId, SizeType seqSlot)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(4, 1);
+    auto request = std::make_shared<LlmRequest>(requestId, 8, tokens, runtime::SamplingConfig{1}, false);
+    request->mSeqSlot = seqSlot;
+    return request;
+}
+} // namespace
+
+TEST(RequestSchedulingTableTest, cancellation)
+{
+    RequestSchedulingTable table;
+    EXPECT_FALSE(table.isCancelled(1));
+    table.setPriority(1, RequestSchedulingTable::kMaxPriority);
+    table.cancel(1);
+    EXPECT_TRUE(table.isCancelled(1));
+    // Cancelling keeps the other attributes
+    EXPECT_EQ(table.getPriority(1), RequestSchedulingTable::kMaxPriority);
+    table.erase(1);
+    EXPECT_FALSE(table.isCancelled(1));
+}
+
+TEST(DeadlineSchedulerTest, dropsCancelledAndExpiredRequests)
+{
+    DeadlineScheduler scheduler;
+    auto& table = *scheduler.getSchedulingTable();
+    auto const now = RequestSchedulingTable::Clock::now();
+    DeadlineScheduler::RequestList requests{createRequest(1, 0), createRequest(2, 1), createRequest(3, -1)};
+    table.cancel(1);
+    table.setDeadline(2, now + std::chrono::seconds(1));
+    table.setDeadline(3, now - std::chrono::seconds(1));
+
+    std::vector<SizeType> releasedSlots;
+    RequestResources resources;
+    resources.releaseSeqSlot = [&releasedSlots](SizeType seqSlot) { releasedSlots.push_back(seqSlot); };
+    auto const dropped = scheduler.dropExpired(requests, resources, now);
+
+    ASSERT_EQ(dropped.size(), 2);
+    EXPECT_EQ(dropped[0]->mRequestId, 1);
+    EXPECT_EQ(dropped[1]->mRequestId, 3);
+    for (auto const& request : dropped)
+    {
+        EXPECT_EQ(request->mState, REQUEST_STATE_GENERATION_COMPLETE);
+        EXPECT_EQ(request->mSeqSlot, -1);
+    }
+    // Only the cancelled request held a decoder slot
+    EXPECT_EQ(releasedSlots, (std::vector<SizeType>{0}));
+    ASSERT_EQ(requests.size(), 1);
+    EXPECT_EQ(requests.front()->mRequestId, 2);
+    EXPECT_EQ(scheduler.getNumCancelled(), 1);
+    EXPECT_EQ(scheduler.getNumExpired(), 1);
+    EXPECT_FALSE(table.isCancelled(1));
+    EXPECT_EQ(table.size(), 1);
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheCompaction.h"
+
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+namespace
+{
+using SizeType = KVCacheCompactor::SizeType;
+using BlockCopy = CopyOnWriteBlockTable::BlockCopy;
+} // namespace
+
+TEST(KVCacheCompactorTest, planMovesTailIntoHoles)
+{
+    //                             0     1      2     3      4      5     6     7
+    std::vector<bool> const isLive{true, false, true, false, false, true, false, true};
+    EXPECT_EQ(KVCacheCompactor::countMisplaced(isLive), 2);
+
+    auto const plan = KVCacheCompactor::plan(isLive);
+    EXPECT_EQ(plan.numLiveBlocks, 4);
+    // The highest live block goes into the lowest hole
+    EXPECT_EQ(plan.moves, (std::vector<BlockCopy>{{7, 1}, {5, 3}}));
+    EXPECT_EQ(plan.remap.at(7), 1);
+    EXPECT_EQ(plan.remap.at(5), 3);
+}
+
+TEST(KVCacheCompactorTest, planIsBoundedByMaxMoves)
+{
+    std::vector<bool> const isLive{false, false, true, true};
+    auto const first = KVCacheCompactor::plan(isLive, 1);
+    EXPECT_EQ(first.moves, (std::vector<BlockCopy>{{3, 0}}));
+
+    // The next step continues where the first one stopped
+    std::vector<bool> const afterFirst{true, false, true, false};
+    EXPECT_EQ(KVCacheCompactor::countMisplaced(afterFirst), 1);
+    EXPECT_EQ(KVCacheCompactor::plan(afterFirst, 1).moves, (std::vector<BlockCopy>{{2, 1}}));
+    EXPECT_TRUE(KVCacheCompactor::plan({true, true, false}).moves.empty());
+    EXPECT_TRUE(KVCacheCompactor::plan({}).moves.empty());
+}
+
+TEST(KVCacheCompactorTest, remapBlockIds)
+{
+    auto const plan = KVCacheCompactor::plan({true, false, false, true, true});
+    std::vector<std::vector<SizeType>> cacheBlockIds{{0, 3}, {0, 4}};
+    KVCacheCompactor::remapBlockIds(plan, cacheBlockIds);
+    EXPECT_EQ(cacheBlockIds, (std::vector<std::vector<SizeType>>{{0, 2}, {0, 1}}));
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheCopyOnWrite.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+namespace
+{
+using SizeType = CopyOnWriteBlockTable::SizeType;
+using VecBlockIds = std::vector<SizeType>;
+
+VecBlockIds sorted(VecBlockIds blockIds)
+{
+    std::sort(blockIds.begin(), blockIds.end());
+    return blockIds;
+}
+} // namespace
+
+class CopyOnWriteBlockTableTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    SizeType allocateBlock()
+    {
+        return mNextBlockIdx++;
+    }
+
+    CopyOnWriteBlockTable::AllocateBlockFn mAllocate{[this]() { return allocateBlock(); }};
+    SizeType mNextBlockIdx{100};
+};
+
+TEST_F(CopyOnWriteBlockTableTest, sharedBlocksAreForkedOnWrite)
+{
+    CopyOnWriteBlockTable table(2);
+    EXPECT_THROW(CopyOnWriteBlockTable(0), std::exception);
+    table.addSharedBlock(0);
+    table.addSharedBlock(1);
+    EXPECT_EQ(table.getRefCount(0), 2);
+
+    // The first beam writes into the last context block
+    EXPECT_TRUE(table.prepareWrite(0, 1, mAllocate));
+    EXPECT_EQ(table.getCacheBlockIds()[0], (VecBlockIds{0, 100}));
+    EXPECT_EQ(table.getCacheBlockIds()[1], (VecBlockIds{0, 1}));
+    EXPECT_EQ(table.getRefCount(1), 1);
+    // The second beam is now the only owner and writes in place
+    EXPECT_FALSE(table.prepareWrite(1, 1, mAllocate));
+
+    auto const copies = table.takePendingCopies();
+    ASSERT_EQ(copies.size(), 1);
+    EXPECT_EQ(copies.front(), (CopyOnWriteBlockTable::BlockCopy{1, 100}));
+    EXPECT_TRUE(table.takePendingCopies().empty());
+}
+
+TEST_F(CopyOnWriteBlockTableTest, reorderBeamsSharesParentBlocks)
+{
+    CopyOnWriteBlockTable table(3);
+    table.addSharedBlock(0);
+    table.addBlock(0, 10);
+    table.addBlock(1, 11);
+    table.addBlock(2, 12);
+
+    // Beams 0 and 1 continue beam 0, beam 2 continues beam 2, the history of beam 1 is dropped
+    auto const freed = table.reorderBeams({0, 0, 2});
+    EXPECT_EQ(freed, (VecBlockIds{11}));
+    EXPECT_EQ(table.getCacheBlockIds()[1], (VecBlockIds{0, 10}));
+    EXPECT_EQ(table.getRefCount(10), 2);
+    EXPECT_EQ(table.getRefCount(11), 0);
+    EXPECT_THROW(table.reorderBeams({0}), std::exception);
+
+    // Writing the shared block of beam 1 forks it
+    EXPECT_TRUE(table.prepareWrite(1, 1, mAllocate));
+    EXPECT_EQ(table.getRefCount(10), 1);
+
+    EXPECT_EQ(sorted(table.release()), (VecBlockIds{0, 10, 12, 100}));
+    EXPECT_TRUE(table.getCacheBlockIds()[0].empty());
+    EXPECT_EQ(table.getRefCount(0), 0);
+    EXPECT_TRUE(table.takePendingCopies().empty());
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
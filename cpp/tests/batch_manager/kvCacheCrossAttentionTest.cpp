@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheCrossAttention.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <memory>
+#include <utility>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+using SizeType = EncoderDecoderKVCacheManager::SizeType;
+
+TEST(EncoderDecoderKVCacheManagerTest, calculateMaxNumBlocks)
+{
+    // Split in proportion to the maximum lengths by default
+    auto const [numSelfBlocks, numCrossBlocks]
+        = EncoderDecoderKVCacheManager::calculateMaxNumBlocks(100 * 64, 64, 300, 100);
+    EXPECT_EQ(numSelfBlocks, 75);
+    EXPECT_EQ(numCrossBlocks, 25);
+    EXPECT_EQ(EncoderDecoderKVCacheManager::calculateMaxNumBlocks(100 * 64 + 63, 64, 300, 100, 0.5f),
+        (std::pair<SizeType, SizeType>{50, 50}));
+    EXPECT_THROW(static_cast<void>(EncoderDecoderKVCacheManager::calculateMaxNumBlocks(100, 64, 300, 100, 1.f)),
+        std::exception);
+    EXPECT_THROW(
+        static_cast<void>(EncoderDecoderKVCacheManager::calculateMaxNumBlocks(100, 0, 300, 100)), std::exception);
+}
+
+class EncoderDecoderKVCacheManagerGpuTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kTOKENS_PER_BLOCK = 4;
+    static SizeType constexpr kNUM_SELF_BLOCKS = 8;
+    static SizeType constexpr kNUM_CROSS_BLOCKS = 6;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<runtime::CudaStream>();
+        mKvCacheManager = std::make_unique<EncoderDecoderKVCacheManager>(1, 1, 1, kTOKENS_PER_BLOCK, kNUM_SELF_BLOCKS,
+            kNUM_CROSS_BLOCKS, 2, 2, 16, 12, nvinfer1::DataType::kHALF, mStream);
+    }
+
+    std::shared_ptr<runtime::CudaStream> mStream;
+    std::unique_ptr<EncoderDecoderKVCacheManager> mKvCacheManager;
+};
+
+TEST_F(EncoderDecoderKVCacheManagerGpuTest, neededCrossBlocks)
+{
+    // Only a partially filled last block is allocated per beam
+    EXPECT_EQ(mKvCacheManager->getNeededCrossBlocks(10, 2), 4);
+    EXPECT_EQ(mKvCacheManager->getNeededCrossBlocks(8, 2), 2);
+    EXPECT_EQ(mKvCacheManager->getNeededCrossBlocks(10, 1), 3);
+}
+
+TEST_F(EncoderDecoderKVCacheManagerGpuTest, crossBlocksFollowTheEncoderOutput)
+{
+    auto const& selfManager = mKvCacheManager->getSelfKVCacheManager();
+    auto const& crossManager = mKvCacheManager->getCrossKVCacheManager();
+    EXPECT_THROW(mKvCacheManager->addSequence(0, 4, 0, 1), std::exception);
+
+    ASSERT_TRUE(mKvCacheManager->canAddSequence(10, 1));
+    mKvCacheManager->addSequence(0, 4, 10, 1);
+    EXPECT_EQ(mKvCacheManager->getEncoderInputLength(0), 10);
+    EXPECT_EQ(selfManager.getNumFreeBlocks(), kNUM_SELF_BLOCKS - 1);
+    EXPECT_EQ(crossManager.getNumFreeBlocks(), kNUM_CROSS_BLOCKS - 3);
+    EXPECT_TRUE(mKvCacheManager->canAddSequence(12, 1));
+    EXPECT_FALSE(mKvCacheManager->canAddSequence(9, 2));
+
+    // Generation only grows the self-attention KV cache
+    mKvCacheManager->addToken(0);
+    EXPECT_EQ(selfManager.getNumFreeBlocks(), kNUM_SELF_BLOCKS - 2);
+    EXPECT_EQ(crossManager.getNumFreeBlocks(), kNUM_CROSS_BLOCKS - 3);
+
+    mKvCacheManager->removeSequence(0);
+    EXPECT_EQ(mKvCacheManager->getEncoderInputLength(0), 0);
+    EXPECT_EQ(selfManager.getNumFreeBlocks(), kNUM_SELF_BLOCKS);
+    EXPECT_EQ(crossManager.getNumFreeBlocks(), kNUM_CROSS_BLOCKS);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheEvictionPolicy.h"
+
+#include <stdexcept>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+TEST(EvictionPolicyTest, lruEvictsOldestFirst)
+{
+    EvictionPolicy policy;
+    EXPECT_EQ(policy.getType(), EvictionPolicyType::kLRU);
+    EXPECT_FALSE(policy.evict().has_value());
+
+    policy.insert(0, 0);
+    policy.insert(1, 0);
+    policy.insert(2, 0);
+    // Reinserting a block refreshes its recency
+    policy.insert(0, 0);
+    EXPECT_EQ(policy.getNumCandidates(), 3);
+    EXPECT_EQ(policy.evict(), 1);
+    EXPECT_EQ(policy.evict(), 2);
+    EXPECT_EQ(policy.evict(), 0);
+    EXPECT_EQ(policy.getNumCandidates(), 0);
+}
+
+TEST(EvictionPolicyTest, lfuEvictsFewestHitsFirst)
+{
+    EvictionPolicy policy(EvictionPolicyType::kLFU);
+    policy.insert(0, 0);
+    policy.insert(1, 0);
+    // Block 0 is reused twice and released again
+    for (int i = 0; i < 2; ++i)
+    {
+        policy.claim(0);
+        EXPECT_FALSE(policy.contains(0));
+        policy.insert(0, 0);
+    }
+    policy.insert(2, 0);
+    EXPECT_EQ(policy.evict(), 1);
+    EXPECT_EQ(policy.evict(), 2);
+    EXPECT_EQ(policy.evict(), 0);
+}
+
+TEST(EvictionPolicyTest, prefixDepthWeightedKeepsShallowBlocks)
+{
+    EvictionPolicy policy(EvictionPolicyType::kPrefixDepthWeighted);
+    policy.insert(0, 0);
+    policy.insert(1, 7);
+    policy.insert(2, 3);
+    EXPECT_EQ(policy.evict(), 1);
+    EXPECT_EQ(policy.evict(), 2);
+    EXPECT_EQ(policy.evict(), 0);
+}
+
+TEST(EvictionPolicyTest, priorityDominatesPolicy)
+{
+    EvictionPolicy policy;
+    policy.insert(0, 0, kMaxRetentionPriority);
+    policy.insert(1, 0, kMinRetentionPriority);
+    policy.insert(2, 0);
+    // A second release keeps the highest priority requested
+    policy.insert(1, 0, kMaxRetentionPriority);
+    policy.insert(1, 0, kMinRetentionPriority);
+    EXPECT_EQ(policy.evict(), 2);
+    EXPECT_EQ(policy.evict(), 0);
+    EXPECT_EQ(policy.evict(), 1);
+
+    EXPECT_THROW(policy.insert(3, 0, kMaxRetentionPriority + 1), std::exception);
+    EXPECT_THROW(policy.insert(3, 0, kMinRetentionPriority - 1), std::exception);
+}
+
+TEST(EvictionPolicyTest, removeForgetsBlock)
+{
+    EvictionPolicy policy;
+    policy.insert(0, 0);
+    policy.insert(1, 0);
+    policy.remove(0);
+    EXPECT_FALSE(policy.contains(0));
+    EXPECT_TRUE(policy.contains(1));
+    EXPECT_EQ(policy.evict(), 1);
+    EXPECT_FALSE(policy.evict().has_value());
+    // Unknown blocks are ignored
+    policy.remove(5);
+    policy.claim(5);
+    EXPECT_EQ(policy.getNumCandidates(), 0);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
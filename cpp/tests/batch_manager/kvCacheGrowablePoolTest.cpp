@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheGrowablePool.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/virtualMemory.h"
+
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class GrowableKVCachePoolsTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kMAX_NUM_BLOCKS = 64;
+    // 512 KiB per block, several blocks fit into one mapped chunk
+    static SizeType constexpr kBLOCK_SIZE = 128 * 1024;
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || !VirtualMemoryBuffer::isSupported(0))
+        {
+            GTEST_SKIP();
+        }
+        mShapes.push_back(ITensor::makeShape({kMAX_NUM_BLOCKS, kBLOCK_SIZE}));
+        mShapes.push_back(ITensor::makeShape({kMAX_NUM_BLOCKS, 2, kBLOCK_SIZE}));
+    }
+
+    std::vector<ITensor::Shape> mShapes;
+};
+
+TEST_F(GrowableKVCachePoolsTest, growKeepsAddresses)
+{
+    SizeType constexpr kGROWTH_NUM_BLOCKS = 8;
+    GrowableKVCachePools pools(mShapes, nvinfer1::DataType::kFLOAT, 1, kGROWTH_NUM_BLOCKS, 0);
+    EXPECT_EQ(pools.getMaxNumBlocks(), kMAX_NUM_BLOCKS);
+    EXPECT_EQ(pools.getBytesPerBlock(), 3 * kBLOCK_SIZE * sizeof(float));
+    ASSERT_EQ(pools.getPools().size(), mShapes.size());
+    auto const initialNumBlocks = pools.getNumBlocks();
+    // The first chunk is mapped in full
+    EXPECT_GE(initialNumBlocks, 1);
+    EXPECT_GE(pools.getMappedSize(), static_cast<std::size_t>(initialNumBlocks) * pools.getBytesPerBlock());
+    auto const* const basePtr = pools.getPools().front()->data();
+
+    EXPECT_EQ(pools.grow(initialNumBlocks), 0);
+    auto const added = pools.grow(initialNumBlocks + 1);
+    EXPECT_GE(added, kGROWTH_NUM_BLOCKS);
+    EXPECT_EQ(pools.getNumBlocks(), initialNumBlocks + added);
+    EXPECT_EQ(pools.getPools().front()->data(), basePtr);
+
+    // Growth stops at the reserved size
+    pools.grow(10 * kMAX_NUM_BLOCKS);
+    EXPECT_EQ(pools.getNumBlocks(), kMAX_NUM_BLOCKS);
+    EXPECT_EQ(pools.grow(kMAX_NUM_BLOCKS + 1), 0);
+    EXPECT_EQ(pools.getPools().front()->data(), basePtr);
+}
+
+TEST_F(GrowableKVCachePoolsTest, shrinkReleasesMemory)
+{
+    GrowableKVCachePools pools(mShapes, nvinfer1::DataType::kFLOAT, kMAX_NUM_BLOCKS, 1, 0);
+    EXPECT_EQ(pools.getNumBlocks(), kMAX_NUM_BLOCKS);
+    auto const mappedSize = pools.getMappedSize();
+
+    pools.shrink(1);
+    EXPECT_LT(pools.getMappedSize(), mappedSize);
+    EXPECT_GE(pools.getNumBlocks(), 1);
+    EXPECT_LT(pools.getNumBlocks(), kMAX_NUM_BLOCKS);
+    // Shrinking to a larger size is a no-op
+    auto const numBlocks = pools.getNumBlocks();
+    pools.shrink(kMAX_NUM_BLOCKS);
+    EXPECT_EQ(pools.getNumBlocks(), numBlocks);
+    EXPECT_THROW(pools.shrink(0), std::exception);
+}
+
+TEST_F(GrowableKVCachePoolsTest, rejectsInvalidShapes)
+{
+    EXPECT_THROW(GrowableKVCachePools({}, nvinfer1::DataType::kFLOAT, 1, 1, 0), std::exception);
+    EXPECT_THROW(GrowableKVCachePools(mShapes, nvinfer1::DataType::kFLOAT, 1, 0, 0), std::exception);
+    auto shapes = mShapes;
+    shapes.back().d[0] = kMAX_NUM_BLOCKS / 2;
+    EXPECT_THROW(GrowableKVCachePools(shapes, nvinfer1::DataType::kFLOAT, 1, 1, 0), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
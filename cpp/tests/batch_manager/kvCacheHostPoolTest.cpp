@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheHostPool.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+using namespace tensorrt_llm::runtime;
+
+class KVCacheHostPoolTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kNUM_GPU_BLOCKS = 4;
+    static SizeType constexpr kBLOCK_SIZE = 16;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        // Two pools, e.g. of two layer groups, with different block sizes
+        mGpuPools.push_back(
+            mManager->gpu(ITensor::makeShape({kNUM_GPU_BLOCKS, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        mGpuPools.push_back(
+            mManager->gpu(ITensor::makeShape({kNUM_GPU_BLOCKS, 2, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        for (auto const& pool : mGpuPools)
+        {
+            mManager->setZero(*pool);
+        }
+    }
+
+    //! \brief Fill GPU block blockIdx of every pool with consecutive values starting at first.
+    void fillBlock(SizeType blockIdx, float first)
+    {
+        for (auto const& pool : mGpuPools)
+        {
+            auto block = ITensor::slice(pool, blockIdx, 1);
+            std::vector<float> values(block->getSize());
+            std::iota(values.begin(), values.end(), first);
+            mManager->copy(values.data(), *block);
+        }
+    }
+
+    void expectBlock(SizeType blockIdx, float first)
+    {
+        for (auto const& pool : mGpuPools)
+        {
+            auto const block = mManager->copyFrom(*ITensor::slice(pool, blockIdx, 1), MemoryType::kCPU);
+            mStream->synchronize();
+            auto const* values = bufferCast<float>(*block);
+            for (std::size_t i = 0; i < block->getSize(); ++i)
+            {
+                ASSERT_EQ(values[i], first + static_cast<float>(i)) << "block " << blockIdx << " at " << i;
+            }
+        }
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::vector<ITensor::SharedPtr> mGpuPools;
+};
+
+TEST_F(KVCacheHostPoolTest, offloadOnboard)
+{
+    KVCacheHostPool hostPool(2, mGpuPools, mStream);
+    EXPECT_EQ(hostPool.getMaxNumBlocks(), 2);
+    ASSERT_EQ(hostPool.getHostPools().size(), mGpuPools.size());
+    EXPECT_EQ(hostPool.getHostPools()[1]->getShape().d[0], 2);
+    EXPECT_EQ(hostPool.getHostPools()[1]->getShape().d[1], 2);
+
+    VecTokens const tokens{1, 2, 3, 4};
+    auto const key = KVCacheHostPool::hashBlockKey(0, tokens);
+    fillBlock(1, 100.f);
+    hostPool.offloadBlock(key, tokens, 1);
+    EXPECT_TRUE(hostPool.hasBlock(key, tokens));
+    EXPECT_FALSE(hostPool.hasBlock(key, VecTokens{1, 2, 3, 5}));
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 1);
+
+    // The compute stream waits for the offload, so the GPU block can be reused right away.
+    fillBlock(1, 0.f);
+    EXPECT_TRUE(hostPool.onboardBlock(key, tokens, 3));
+    expectBlock(3, 100.f);
+    expectBlock(1, 0.f);
+    EXPECT_EQ(hostPool.getNumOffloadedBlocks(), 1);
+    EXPECT_EQ(hostPool.getNumOnboardedBlocks(), 1);
+
+    // Onboarding does not remove the block from the host tier.
+    EXPECT_TRUE(hostPool.hasBlock(key, tokens));
+    hostPool.removeBlock(key);
+    EXPECT_FALSE(hostPool.hasBlock(key, tokens));
+    EXPECT_FALSE(hostPool.onboardBlock(key, tokens, 3));
+    EXPECT_EQ(hostPool.getNumMisses(), 1);
+}
+
+TEST_F(KVCacheHostPoolTest, evictsLeastRecentlyUsed)
+{
+    KVCacheHostPool hostPool(2, mGpuPools, mStream);
+    std::vector<VecTokens> const tokens{{1, 2}, {3, 4}, {5, 6}};
+    std::vector<KVCacheHostPool::BlockKey> keys;
+    for (auto const& blockTokens : tokens)
+    {
+        keys.push_back(KVCacheHostPool::hashBlockKey(0, blockTokens));
+    }
+
+    fillBlock(0, 10.f);
+    hostPool.offloadBlock(keys[0], tokens[0], 0);
+    fillBlock(0, 20.f);
+    hostPool.offloadBlock(keys[1], tokens[1], 0);
+    // Touch the first block, so that the second one is evicted by the third.
+    EXPECT_TRUE(hostPool.onboardBlock(keys[0], tokens[0], 1));
+    fillBlock(0, 30.f);
+    hostPool.offloadBlock(keys[2], tokens[2], 0);
+
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 2);
+    EXPECT_TRUE(hostPool.hasBlock(keys[0], tokens[0]));
+    EXPECT_FALSE(hostPool.hasBlock(keys[1], tokens[1]));
+    EXPECT_TRUE(hostPool.hasBlock(keys[2], tokens[2]));
+
+    EXPECT_TRUE(hostPool.onboardBlock(keys[2], tokens[2], 2));
+    expectBlock(2, 30.f);
+    EXPECT_TRUE(hostPool.onboardBlock(keys[0], tokens[0], 3));
+    expectBlock(3, 10.f);
+}
+
+TEST_F(KVCacheHostPoolTest, evictsLowestRetentionPriority)
+{
+    KVCacheHostPool hostPool(2, mGpuPools, mStream, nullptr, EvictionPolicyType::kLRU);
+    EXPECT_EQ(hostPool.getEvictionPolicyType(), EvictionPolicyType::kLRU);
+    std::vector<VecTokens> const tokens{{1, 2}, {3, 4}, {5, 6}};
+    std::vector<KVCacheHostPool::BlockKey> keys;
+    for (auto const& blockTokens : tokens)
+    {
+        keys.push_back(KVCacheHostPool::hashBlockKey(0, blockTokens));
+    }
+
+    // The first block, e.g. of a shared system prompt, is kept although it is the least recently used.
+    fillBlock(0, 10.f);
+    hostPool.offloadBlock(keys[0], tokens[0], 0, 0, kMaxRetentionPriority);
+    fillBlock(0, 20.f);
+    hostPool.offloadBlock(keys[1], tokens[1], 0);
+    fillBlock(0, 30.f);
+    hostPool.offloadBlock(keys[2], tokens[2], 0);
+
+    EXPECT_TRUE(hostPool.hasBlock(keys[0], tokens[0]));
+    EXPECT_FALSE(hostPool.hasBlock(keys[1], tokens[1]));
+    EXPECT_TRUE(hostPool.hasBlock(keys[2], tokens[2]));
+    EXPECT_TRUE(hostPool.onboardBlock(keys[0], tokens[0], 1));
+    expectBlock(1, 10.f);
+}
+
+TEST_F(KVCacheHostPoolTest, offloadingTwiceKeepsOneCopy)
+{
+    KVCacheHostPool hostPool(2, mGpuPools, mStream);
+    VecTokens const tokens{7, 8};
+    auto const key = KVCacheHostPool::hashBlockKey(0, tokens);
+    fillBlock(0, 1.f);
+    hostPool.offloadBlock(key, tokens, 0);
+    hostPool.offloadBlock(key, tokens, 0);
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 1);
+    EXPECT_EQ(hostPool.getNumOffloadedBlocks(), 1);
+}
+
+TEST_F(KVCacheHostPoolTest, keyCollisionReplacesBlock)
+{
+    KVCacheHostPool hostPool(2, mGpuPools, mStream);
+    // Two blocks with different tokens under the same key
+    KVCacheHostPool::BlockKey constexpr kKEY = 42;
+    VecTokens const first{1, 2};
+    VecTokens const second{3, 4};
+    fillBlock(0, 10.f);
+    hostPool.offloadBlock(kKEY, first, 0);
+    fillBlock(0, 20.f);
+    hostPool.offloadBlock(kKEY, second, 0);
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 1);
+    EXPECT_FALSE(hostPool.hasBlock(kKEY, first));
+    EXPECT_TRUE(hostPool.hasBlock(kKEY, second));
+
+    // Filling the tier must not evict the newer block through the slot of the older one.
+    VecTokens const other{5, 6};
+    auto const otherKey = KVCacheHostPool::hashBlockKey(0, other);
+    fillBlock(0, 30.f);
+    hostPool.offloadBlock(otherKey, other, 0);
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 2);
+    EXPECT_TRUE(hostPool.onboardBlock(kKEY, second, 1));
+    expectBlock(1, 20.f);
+    EXPECT_TRUE(hostPool.onboardBlock(otherKey, other, 2));
+    expectBlock(2, 30.f);
+
+    // Evicting the colliding block keeps the mapping of the others.
+    VecTokens const last{7, 8};
+    auto const lastKey = KVCacheHostPool::hashBlockKey(0, last);
+    hostPool.offloadBlock(lastKey, last, 0);
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 2);
+    EXPECT_FALSE(hostPool.hasBlock(kKEY, second));
+    EXPECT_TRUE(hostPool.hasBlock(otherKey, other));
+    EXPECT_TRUE(hostPool.hasBlock(lastKey, last));
+}
+
+TEST_F(KVCacheHostPoolTest, calculateMaxNumBlocks)
+{
+    // A block takes (16 + 2 * 16) floats over both pools
+    auto const bytesPerBlock = 3 * kBLOCK_SIZE * sizeof(float);
+    EXPECT_EQ(KVCacheHostPool::calculateMaxNumBlocks(10 * bytesPerBlock + 1, mGpuPools), 10);
+    EXPECT_EQ(KVCacheHostPool::calculateMaxNumBlocks(bytesPerBlock - 1, mGpuPools), 0);
+}
+
+TEST_F(KVCacheHostPoolTest, blockKeysDependOnPrefix)
+{
+    VecTokens const tokens{1, 2};
+    auto const first = KVCacheHostPool::hashBlockKey(0, tokens);
+    EXPECT_EQ(first, KVCacheHostPool::hashBlockKey(0, tokens));
+    EXPECT_NE(KVCacheHostPool::hashBlockKey(first, tokens), KVCacheHostPool::hashBlockKey(first + 1, tokens));
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheLayerGroups.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+namespace
+{
+using SizeType = KVCacheLayerGroup::SizeType;
+using VecLayers = std::vector<SizeType>;
+
+SizeType constexpr kSIZE_PER_HEAD = 64;
+SizeType constexpr kTOKENS_PER_BLOCK = 16;
+SizeType constexpr kMAX_SEQUENCE_LENGTH = 1024;
+SizeType constexpr kWINDOW = 128;
+
+//! \brief Sliding window and global layers interleaved, the global layers with fewer KV heads.
+std::vector<KVCacheLayerGroup> makeInterleavedGroups()
+{
+    return groupLayersByGeometry(
+        {kWINDOW, kMAX_SEQUENCE_LENGTH, kWINDOW, kMAX_SEQUENCE_LENGTH}, {8, 4, 8, 4}, kSIZE_PER_HEAD);
+}
+} // namespace
+
+TEST(KVCacheLayerGroupTest, groupLayersByGeometry)
+{
+    auto const groups = makeInterleavedGroups();
+    ASSERT_EQ(groups.size(), 2);
+    // Groups are ordered by attention window
+    EXPECT_EQ(groups[0].layers, (VecLayers{0, 2}));
+    EXPECT_EQ(groups[0].attentionWindow, kWINDOW);
+    EXPECT_EQ(groups[0].numKvHeads, 8);
+    EXPECT_EQ(groups[1].layers, (VecLayers{1, 3}));
+    EXPECT_EQ(groups[1].numKvHeads, 4);
+
+    // Same window, different number of KV heads
+    EXPECT_EQ(groupLayersByGeometry({kWINDOW, kWINDOW}, {8, 4}, kSIZE_PER_HEAD).size(), 2);
+    EXPECT_EQ(groupLayersByGeometry({kWINDOW, kWINDOW}, {8, 8}, kSIZE_PER_HEAD).size(), 1);
+    EXPECT_THROW(groupLayersByGeometry({kWINDOW}, {8, 8}, kSIZE_PER_HEAD), std::exception);
+}
+
+TEST(KVCacheLayerGroupTest, blockSizes)
+{
+    auto const groups = makeInterleavedGroups();
+    // 2 layers * (K, V) * 8 heads * 16 tokens * 64 * 2 bytes
+    EXPECT_EQ(groups[0].getBlockSizeInBytes(kTOKENS_PER_BLOCK, nvinfer1::DataType::kHALF), 2 * 2 * 8 * 16 * 64 * 2);
+    EXPECT_EQ(groups[0].getMaxBlocksPerSeq(kTOKENS_PER_BLOCK, kMAX_SEQUENCE_LENGTH, false), kWINDOW / 16);
+    EXPECT_EQ(groups[0].getMaxBlocksPerSeq(kTOKENS_PER_BLOCK, kMAX_SEQUENCE_LENGTH, true), kWINDOW / 16 + 1);
+    EXPECT_EQ(groups[1].getMaxBlocksPerSeq(kTOKENS_PER_BLOCK, kMAX_SEQUENCE_LENGTH, false), 1024 / 16);
+    // The window is capped by the sequence length
+    EXPECT_EQ(groups[0].getMaxBlocksPerSeq(kTOKENS_PER_BLOCK, 20, false), 2);
+}
+
+TEST(KVCacheLayerGroupTest, calculateMaxNumBlocks)
+{
+    auto const groups = makeInterleavedGroups();
+    auto const dtype = nvinfer1::DataType::kHALF;
+    auto const bytesPerSequence
+        = groups[0].getBlockSizeInBytes(kTOKENS_PER_BLOCK, dtype) * (kWINDOW / kTOKENS_PER_BLOCK)
+        + groups[1].getBlockSizeInBytes(kTOKENS_PER_BLOCK, dtype) * (kMAX_SEQUENCE_LENGTH / kTOKENS_PER_BLOCK);
+    auto const maxNumBlocks = LayerGroupedKVCacheManager::calculateMaxNumBlocks(
+        groups, 3 * bytesPerSequence + 1, kTOKENS_PER_BLOCK, kMAX_SEQUENCE_LENGTH, false, dtype);
+    // Both groups can hold the same three sequences
+    EXPECT_EQ(maxNumBlocks, (VecLayers{3 * kWINDOW / kTOKENS_PER_BLOCK, 3 * kMAX_SEQUENCE_LENGTH / kTOKENS_PER_BLOCK}));
+}
+
+TEST(KVCacheLayerGroupTest, managerMapsLayersToGroups)
+{
+    auto const groups = makeInterleavedGroups();
+    auto const stream = std::make_shared<runtime::CudaStream>();
+    LayerGroupedKVCacheManager manager(groups, {16, 128}, kTOKENS_PER_BLOCK, 2, 1, kMAX_SEQUENCE_LENGTH, 0, false,
+        nvinfer1::DataType::kHALF, stream);
+    EXPECT_EQ(manager.getNumGroups(), 2);
+    EXPECT_EQ(manager.getNumLayers(), 4);
+    EXPECT_EQ(manager.getGroupOfLayer(0), 0);
+    EXPECT_EQ(manager.getGroupOfLayer(1), 1);
+    EXPECT_EQ(manager.getGroupOfLayer(2), 0);
+    EXPECT_EQ(manager.getGroupOfLayer(3), 1);
+    EXPECT_EQ(manager.getMaxBlocksPerSeq(), manager.getGroupManager(1).getMaxBlocksPerSeq());
+    EXPECT_LT(manager.getGroupManager(0).getMaxBlocksPerSeq(), manager.getMaxBlocksPerSeq());
+    for (SizeType layer = 0; layer < manager.getNumLayers(); ++layer)
+    {
+        EXPECT_NE(manager.getLayerMemoryPool(layer), nullptr) << layer;
+    }
+    EXPECT_EQ(manager.getKvCacheStats().size(), 2);
+
+    // A layer must be part of exactly one group
+    auto overlapping = groups;
+    overlapping[1].layers = {1, 2};
+    EXPECT_THROW(LayerGroupedKVCacheManager(overlapping, {16, 128}, kTOKENS_PER_BLOCK, 2, 1, kMAX_SEQUENCE_LENGTH,
+                     0, false, nvinfer1::DataType::kHALF, stream),
+        std::exception);
+    EXPECT_THROW(LayerGroupedKVCacheManager(groups, {16}, kTOKENS_PER_BLOCK, 2, 1, kMAX_SEQUENCE_LENGTH, 0, false,
+                     nvinfer1::DataType::kHALF, stream),
+        std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheGrowablePool.h"
+#include "tensorrt_llm/batch_manager/kvCacheMemoryArbiter.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/virtualMemory.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class KVCacheMemoryArbiterTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kMAX_NUM_BLOCKS = 16;
+    // 2 MiB per block, i.e. one mapped chunk, so that the pools hold exactly the requested blocks
+    static SizeType constexpr kBLOCK_SIZE = 512 * 1024;
+    static std::size_t constexpr kBUDGET_NUM_BLOCKS = 8;
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || !VirtualMemoryBuffer::isSupported(0))
+        {
+            GTEST_SKIP();
+        }
+        std::vector<ITensor::Shape> const shapes{ITensor::makeShape({kMAX_NUM_BLOCKS, kBLOCK_SIZE})};
+        mFirstPools = std::make_unique<GrowableKVCachePools>(shapes, nvinfer1::DataType::kFLOAT, 1, 1, 0);
+        mSecondPools = std::make_unique<GrowableKVCachePools>(shapes, nvinfer1::DataType::kFLOAT, 1, 1, 0);
+        mArbiter = std::make_unique<KVCacheMemoryArbiter>(kBUDGET_NUM_BLOCKS * mFirstPools->getBytesPerBlock());
+        mArbiter->addModel(*mFirstPools);
+        mArbiter->addModel(*mSecondPools);
+    }
+
+    std::unique_ptr<GrowableKVCachePools> mFirstPools;
+    std::unique_ptr<GrowableKVCachePools> mSecondPools;
+    std::unique_ptr<KVCacheMemoryArbiter> mArbiter;
+};
+
+TEST_F(KVCacheMemoryArbiterTest, computeTargets)
+{
+    EXPECT_EQ(mArbiter->getNumModels(), 2);
+    EXPECT_THROW(mArbiter->addModel(*mFirstPools, 0), std::exception);
+    EXPECT_THROW(mArbiter->addModel(*mFirstPools, kMAX_NUM_BLOCKS + 1), std::exception);
+    EXPECT_THROW(static_cast<void>(mArbiter->computeTargets({KVCacheModelDemand{}})), std::exception);
+
+    // Enough memory for every queue
+    EXPECT_EQ(mArbiter->computeTargets({{1, 2}, {1, 1}}), (std::vector<SizeType>{3, 2}));
+    // The spare memory is split in proportion to the needs
+    EXPECT_EQ(mArbiter->computeTargets({{1, 8}, {1, 4}}), (std::vector<SizeType>{5, 3}));
+    // Live blocks are granted even over the budget
+    EXPECT_EQ(mArbiter->computeTargets({{6, 2}, {7, 0}}), (std::vector<SizeType>{6, 7}));
+    // The minimum and the size of the pools bound the targets
+    EXPECT_EQ(mArbiter->computeTargets({{0, 0}, {0, 100}}), (std::vector<SizeType>{1, 7}));
+}
+
+TEST_F(KVCacheMemoryArbiterTest, rebalanceMovesMemory)
+{
+    EXPECT_EQ(mArbiter->rebalance({{1, 8}, {1, 4}}), 0);
+    EXPECT_EQ(mFirstPools->getNumBlocks(), 5);
+    EXPECT_EQ(mSecondPools->getNumBlocks(), 3);
+
+    // The queue of the second model grows, the first model gives back its idle blocks
+    EXPECT_EQ(mArbiter->rebalance({{1, 0}, {1, 6}}), 4);
+    EXPECT_EQ(mFirstPools->getNumBlocks(), 1);
+    EXPECT_EQ(mSecondPools->getNumBlocks(), 7);
+    EXPECT_LE(mArbiter->getMappedSize(), mArbiter->getBudgetBytes());
+
+    // Idle blocks are kept while no other model needs the memory
+    EXPECT_EQ(mArbiter->rebalance({{1, 0}, {1, 0}}), 0);
+    EXPECT_EQ(mSecondPools->getNumBlocks(), 7);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheHostPool.h"
+#include "tensorrt_llm/batch_manager/kvCacheNvmePool.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+using namespace tensorrt_llm::runtime;
+
+class KVCacheNvmePoolTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kNUM_GPU_BLOCKS = 4;
+    static SizeType constexpr kBLOCK_SIZE = 16;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        // Two pools with different block sizes, each is stored at its own aligned offset of a slot
+        mGpuPools.push_back(
+            mManager->gpu(ITensor::makeShape({kNUM_GPU_BLOCKS, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        mGpuPools.push_back(
+            mManager->gpu(ITensor::makeShape({kNUM_GPU_BLOCKS, 2, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        for (auto const& pool : mGpuPools)
+        {
+            mManager->setZero(*pool);
+        }
+        mPath = fs::temp_directory_path() / "kvCacheNvmePoolTest" / "blocks.bin";
+        fs::remove_all(mPath.parent_path());
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(mPath.parent_path());
+    }
+
+    //! \brief Fill GPU block blockIdx of every pool with consecutive values starting at first.
+    void fillBlock(SizeType blockIdx, float first)
+    {
+        for (auto const& pool : mGpuPools)
+        {
+            auto block = ITensor::slice(pool, blockIdx, 1);
+            std::vector<float> values(block->getSize());
+            std::iota(values.begin(), values.end(), first);
+            mManager->copy(values.data(), *block);
+        }
+    }
+
+    void expectBlock(SizeType blockIdx, float first)
+    {
+        for (auto const& pool : mGpuPools)
+        {
+            auto const block = mManager->copyFrom(*ITensor::slice(pool, blockIdx, 1), MemoryType::kCPU);
+            mStream->synchronize();
+            auto const* values = bufferCast<float>(*block);
+            for (std::size_t i = 0; i < block->getSize(); ++i)
+            {
+                ASSERT_EQ(values[i], first + static_cast<float>(i)) << "block " << blockIdx << " at " << i;
+            }
+        }
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::vector<ITensor::SharedPtr> mGpuPools;
+    fs::path mPath;
+};
+
+TEST_F(KVCacheNvmePoolTest, offloadOnboard)
+{
+    KVCacheNvmePool nvmePool(mPath, 2, mGpuPools, mStream);
+    EXPECT_EQ(nvmePool.getMaxNumBlocks(), 2);
+    EXPECT_EQ(fs::file_size(mPath), 2 * 2 * KVCacheNvmePool::kAlignment);
+
+    VecTokens const tokens{1, 2, 3, 4};
+    auto const key = KVCacheHostPool::hashBlockKey(0, tokens);
+    fillBlock(1, 100.f);
+    nvmePool.offloadBlock(key, tokens, 1);
+    EXPECT_TRUE(nvmePool.hasBlock(key, tokens));
+    EXPECT_FALSE(nvmePool.hasBlock(key, VecTokens{1, 2, 3, 5}));
+
+    // The compute stream waits for the write, so the GPU block can be reused right away.
+    fillBlock(1, 0.f);
+    EXPECT_TRUE(nvmePool.onboardBlock(key, tokens, 2));
+    expectBlock(2, 100.f);
+    expectBlock(1, 0.f);
+    EXPECT_EQ(nvmePool.getNumOffloadedBlocks(), 1);
+    EXPECT_EQ(nvmePool.getNumOnboardedBlocks(), 1);
+
+    nvmePool.removeBlock(key);
+    EXPECT_FALSE(nvmePool.onboardBlock(key, tokens, 2));
+    EXPECT_EQ(nvmePool.getNumMisses(), 1);
+}
+
+TEST_F(KVCacheNvmePoolTest, hostTierSpillsEvictedBlocks)
+{
+    KVCacheHostPool hostPool(1, mGpuPools, mStream);
+    auto const nvmePool = std::make_shared<KVCacheNvmePool>(mPath, 2, mGpuPools, mStream);
+    hostPool.setNvmeTier(nvmePool);
+
+    std::vector<VecTokens> const tokens{{1, 2}, {3, 4}};
+    auto const firstKey = KVCacheHostPool::hashBlockKey(0, tokens[0]);
+    auto const secondKey = KVCacheHostPool::hashBlockKey(0, tokens[1]);
+    fillBlock(0, 10.f);
+    hostPool.offloadBlock(firstKey, tokens[0], 0);
+    // The only host slot is taken, the first block is spilled to the NVMe tier
+    fillBlock(0, 20.f);
+    hostPool.offloadBlock(secondKey, tokens[1], 0);
+    EXPECT_EQ(nvmePool->getNumSpilledBlocks(), 1);
+    EXPECT_EQ(hostPool.getNumCachedBlocks(), 1);
+
+    // A host miss falls through to the NVMe tier
+    EXPECT_TRUE(hostPool.hasBlock(firstKey, tokens[0]));
+    EXPECT_TRUE(hostPool.onboardBlock(firstKey, tokens[0], 3));
+    expectBlock(3, 10.f);
+    EXPECT_EQ(nvmePool->getNumOnboardedBlocks(), 1);
+    EXPECT_TRUE(hostPool.onboardBlock(secondKey, tokens[1], 2));
+    expectBlock(2, 20.f);
+
+    // Removing a block drops it from both tiers
+    hostPool.removeBlock(firstKey);
+    EXPECT_FALSE(nvmePool->hasBlock(firstKey, tokens[0]));
+}
+
+TEST_F(KVCacheNvmePoolTest, calculateMaxNumBlocks)
+{
+    // A slot holds one aligned block of each pool
+    auto const slotBytes = 2 * KVCacheNvmePool::kAlignment;
+    EXPECT_EQ(KVCacheNvmePool::calculateMaxNumBlocks(10 * slotBytes + 1, mGpuPools), 10);
+    EXPECT_EQ(KVCacheNvmePool::calculateMaxNumBlocks(slotBytes - 1, mGpuPools), 0);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheRadixIndex.h"
+
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+namespace
+{
+using VecTokens = BlockRadixIndex::VecTokens;
+using SizeType = BlockRadixIndex::SizeType;
+
+VecTokens makeTokens(SizeType numTokens, BlockRadixIndex::TokenIdType first)
+{
+    VecTokens tokens(numTokens);
+    std::iota(tokens.begin(), tokens.end(), first);
+    return tokens;
+}
+} // namespace
+
+TEST(BlockRadixIndexTest, matchPrefix)
+{
+    BlockRadixIndex index(4);
+    auto const tokens = makeTokens(10, 0);
+    auto const last = index.insertPrefix(tokens, {7, 3});
+    EXPECT_EQ(index.getNumBlocks(), 2);
+    EXPECT_EQ(index.getBlockIdx(last), 3);
+    EXPECT_TRUE(index.isLeaf(last));
+    EXPECT_FALSE(index.isLeaf(index.getParent(last)));
+
+    std::vector<SizeType> blockIds;
+    EXPECT_EQ(index.matchPrefix(tokens, blockIds), last);
+    EXPECT_EQ(blockIds, (std::vector<SizeType>{7, 3}));
+
+    // Only the first block is shared
+    auto other = tokens;
+    other[5] = 100;
+    auto const node = index.matchPrefix(other, blockIds);
+    EXPECT_EQ(blockIds, (std::vector<SizeType>{7}));
+    EXPECT_EQ(index.getParent(node), BlockRadixIndex::kRootNode);
+
+    // A block is identified by its whole prefix, not only by its own tokens
+    auto shifted = makeTokens(4, 4);
+    EXPECT_EQ(index.matchPrefix(shifted, blockIds), BlockRadixIndex::kRootNode);
+    EXPECT_TRUE(blockIds.empty());
+}
+
+TEST(BlockRadixIndexTest, insertIsIdempotent)
+{
+    BlockRadixIndex index(2);
+    auto const tokens = makeTokens(4, 1);
+    auto const first = index.insertPrefix(tokens, {0, 1});
+    // The existing nodes keep their blocks
+    EXPECT_EQ(index.insertPrefix(tokens, {5, 6}), first);
+    EXPECT_EQ(index.getNumBlocks(), 2);
+    EXPECT_EQ(index.getBlockIdx(first), 1);
+    EXPECT_EQ(index.findChild(BlockRadixIndex::kRootNode, tokens.data()), index.getParent(first));
+}
+
+TEST(BlockRadixIndexTest, eraseLeafRecyclesNodes)
+{
+    BlockRadixIndex index(2);
+    auto const tokens = makeTokens(4, 1);
+    auto const leaf = index.insertPrefix(tokens, {0, 1});
+    auto const parent = index.getParent(leaf);
+    EXPECT_THROW(index.eraseLeaf(parent), std::exception);
+    EXPECT_THROW(index.eraseLeaf(BlockRadixIndex::kRootNode), std::exception);
+
+    index.eraseLeaf(leaf);
+    EXPECT_EQ(index.getNumBlocks(), 1);
+    EXPECT_TRUE(index.isLeaf(parent));
+    std::vector<SizeType> blockIds;
+    EXPECT_EQ(index.matchPrefix(tokens, blockIds), parent);
+    EXPECT_EQ(blockIds, (std::vector<SizeType>{0}));
+
+    // The erased node is reused for the next block
+    auto const other = makeTokens(2, 50);
+    EXPECT_EQ(index.insert(parent, other.data(), 2), leaf);
+    EXPECT_EQ(index.getBlockIdx(leaf), 2);
+}
+
+TEST(BlockRadixIndexTest, growsTable)
+{
+    SizeType constexpr kNUM_BLOCKS = 1000;
+    BlockRadixIndex index(3);
+    std::vector<BlockRadixIndex::NodeIdx> nodes;
+    for (SizeType blockIdx = 0; blockIdx < kNUM_BLOCKS; ++blockIdx)
+    {
+        auto const tokens = makeTokens(3, 3 * blockIdx);
+        nodes.push_back(index.insert(BlockRadixIndex::kRootNode, tokens.data(), blockIdx));
+    }
+    EXPECT_EQ(index.getNumBlocks(), kNUM_BLOCKS);
+    // Erase every other block, the tombstones must not break the probe chains of the others
+    for (SizeType blockIdx = 0; blockIdx < kNUM_BLOCKS; blockIdx += 2)
+    {
+        index.eraseLeaf(nodes[blockIdx]);
+    }
+    for (SizeType blockIdx = 0; blockIdx < kNUM_BLOCKS; ++blockIdx)
+    {
+        auto const tokens = makeTokens(3, 3 * blockIdx);
+        auto const node = index.findChild(BlockRadixIndex::kRootNode, tokens.data());
+        if (blockIdx % 2 == 0)
+        {
+            EXPECT_EQ(node, BlockRadixIndex::kInvalidNode) << blockIdx;
+        }
+        else
+        {
+            ASSERT_NE(node, BlockRadixIndex::kInvalidNode) << blockIdx;
+            EXPECT_EQ(index.getBlockIdx(node), blockIdx);
+        }
+    }
+}
+
+TEST(BlockRadixIndexTest, matchPartialBlock)
+{
+    BlockRadixIndex index(4);
+    auto const tokens = makeTokens(7, 0);
+    auto const full = index.insertPrefix(VecTokens(tokens.begin(), tokens.begin() + 4), {2});
+    // The last block of a released sequence only holds 3 tokens
+    auto const partial = index.insertPartial(full, tokens.data() + 4, 3, 5);
+    EXPECT_FALSE(index.isFull(partial));
+    EXPECT_EQ(index.getNumTokens(partial), 3);
+    EXPECT_EQ(index.insertPartial(full, tokens.data() + 4, 3, 6), partial);
+    EXPECT_THROW(index.insertPartial(full, tokens.data(), 4, 6), std::exception);
+
+    // A new prompt diverges in the middle of the partial block
+    auto other = makeTokens(9, 0);
+    other[6] = 100;
+    auto const match = index.matchPrefixWithPartial(other);
+    EXPECT_EQ(match.node, full);
+    EXPECT_EQ(match.blockIds, (std::vector<SizeType>{2}));
+    ASSERT_TRUE(match.partial.has_value());
+    EXPECT_EQ(match.partial->node, partial);
+    EXPECT_EQ(match.partial->blockIdx, 5);
+    EXPECT_EQ(match.partial->numMatchedTokens, 2);
+    EXPECT_EQ(match.numMatchedTokens, 6);
+
+    // Partial matches shorter than the threshold are not worth a block copy
+    auto const shortMatch = index.matchPrefixWithPartial(other, 3);
+    EXPECT_FALSE(shortMatch.partial.has_value());
+    EXPECT_EQ(shortMatch.numMatchedTokens, 4);
+
+    // Partial blocks are never matched as full blocks
+    std::vector<SizeType> blockIds;
+    EXPECT_EQ(index.matchPrefix(makeTokens(8, 0), blockIds), full);
+    EXPECT_EQ(blockIds, (std::vector<SizeType>{2}));
+}
+
+TEST(BlockRadixIndexTest, partialMatchOfFullBlock)
+{
+    BlockRadixIndex index(4);
+    index.insertPrefix(makeTokens(8, 0), {0, 1});
+    // The leading tokens of a full child can be reused as well
+    auto other = makeTokens(8, 0);
+    other[7] = 100;
+    auto const match = index.matchPrefixWithPartial(other);
+    EXPECT_EQ(match.blockIds, (std::vector<SizeType>{0}));
+    ASSERT_TRUE(match.partial.has_value());
+    EXPECT_EQ(match.partial->blockIdx, 1);
+    EXPECT_EQ(match.numMatchedTokens, 7);
+}
+
+TEST(BlockRadixIndexTest, erasePartialBlock)
+{
+    BlockRadixIndex index(4);
+    auto const tokens = makeTokens(4, 0);
+    auto const first = index.insertPartial(BlockRadixIndex::kRootNode, tokens.data(), 2, 0);
+    auto const second = index.insertPartial(BlockRadixIndex::kRootNode, tokens.data(), 3, 1);
+    EXPECT_EQ(index.getNumBlocks(), 2);
+    index.eraseLeaf(second);
+    EXPECT_FALSE(index.isLeaf(BlockRadixIndex::kRootNode));
+    auto const match = index.matchPrefixWithPartial(tokens);
+    ASSERT_TRUE(match.partial.has_value());
+    EXPECT_EQ(match.partial->node, first);
+    EXPECT_EQ(match.numMatchedTokens, 2);
+    index.eraseLeaf(first);
+    EXPECT_TRUE(index.isLeaf(BlockRadixIndex::kRootNode));
+    EXPECT_FALSE(index.matchPrefixWithPartial(tokens).partial.has_value());
+}
+
+TEST(BlockRadixIndexTest, hashDependsOnParent)
+{
+    auto const tokens = makeTokens(4, 0);
+    auto const hash = BlockRadixIndex::hashBlock(1, tokens.data(), 4);
+    EXPECT_EQ(hash, BlockRadixIndex::hashBlock(1, tokens.data(), 4));
+    EXPECT_NE(hash, BlockRadixIndex::hashBlock(2, tokens.data(), 4));
+    EXPECT_NE(hash, BlockRadixIndex::hashBlock(1, tokens.data(), 3));
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
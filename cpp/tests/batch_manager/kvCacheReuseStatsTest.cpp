@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheReuseStats.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <numeric>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+TEST(PrefixMatchHistogramTest, buckets)
+{
+    EXPECT_EQ(PrefixMatchHistogram::getBucket(0), 0);
+    EXPECT_EQ(PrefixMatchHistogram::getBucket(1), 1);
+    EXPECT_EQ(PrefixMatchHistogram::getBucket(2), 2);
+    EXPECT_EQ(PrefixMatchHistogram::getBucket(3), 2);
+    EXPECT_EQ(PrefixMatchHistogram::getBucket(64), 7);
+    EXPECT_EQ(PrefixMatchHistogram::getBucket(1 << 30), PrefixMatchHistogram::kNumBuckets - 1);
+}
+
+TEST(PrefixMatchHistogramTest, add)
+{
+    PrefixMatchHistogram histogram;
+    EXPECT_EQ(histogram.getTokenHitRate(), 0.f);
+    histogram.add(0, 100);
+    histogram.add(64, 100);
+    histogram.add(100, 200);
+    EXPECT_EQ(histogram.getNumRequests(), 3);
+    EXPECT_EQ(histogram.getBuckets()[0], 1);
+    EXPECT_EQ(histogram.getBuckets()[7], 2);
+    EXPECT_FLOAT_EQ(histogram.getTokenHitRate(), 164.f / 400.f);
+    EXPECT_THROW(histogram.add(101, 100), std::exception);
+    EXPECT_THROW(histogram.add(-1, 100), std::exception);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.getNumRequests(), 0);
+    EXPECT_EQ(histogram.getBuckets()[7], 0);
+}
+
+TEST(KvCacheReuseStatsTest, countsReusedBlocks)
+{
+    using SizeType = KVCacheManager::SizeType;
+    SizeType constexpr kTOKENS_PER_BLOCK = 4;
+    SizeType constexpr kPROMPT_LEN = 9;
+    auto const stream = std::make_shared<runtime::CudaStream>();
+    KVCacheManager kvCacheManager(1, 1, 1, kTOKENS_PER_BLOCK, 8, 1, 1, 16, 0, false, nvinfer1::DataType::kHALF, stream,
+        true);
+    EXPECT_EQ(getKvCacheReuseStats(kvCacheManager).cacheHitRate, 0.f);
+
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(kPROMPT_LEN);
+    std::iota(tokens->begin(), tokens->end(), 0);
+    PrefixMatchHistogram histogram;
+    for (LlmRequest::RequestIdType requestId = 0; requestId < 2; ++requestId)
+    {
+        auto request = std::make_shared<LlmRequest>(requestId, 1, tokens, runtime::SamplingConfig{1}, false);
+        kvCacheManager.addSequence(0, kPROMPT_LEN, 1, request);
+        histogram.add(kvCacheManager, 0, kPROMPT_LEN);
+        request->mState = REQUEST_STATE_GENERATION_COMPLETE;
+        kvCacheManager.removeSequence(0, request);
+    }
+
+    // The second request reuses the full blocks of the first one
+    auto const stats = getKvCacheReuseStats(kvCacheManager);
+    EXPECT_GT(stats.reusedBlocks, 0);
+    EXPECT_EQ(stats.allocTotalBlocks, stats.allocNewBlocks + stats.reusedBlocks);
+    EXPECT_FLOAT_EQ(stats.cacheHitRate, static_cast<float>(stats.reusedBlocks) / stats.allocTotalBlocks);
+    EXPECT_EQ(histogram.getBuckets()[0], 1);
+    EXPECT_GT(histogram.getTokenHitRate(), 0.f);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
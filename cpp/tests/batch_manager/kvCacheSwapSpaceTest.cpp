@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheSwapSpace.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+using namespace tensorrt_llm::runtime;
+
+class KVCacheSwapSpaceTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kNUM_GPU_BLOCKS = 6;
+    static SizeType constexpr kBLOCK_SIZE = 16;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        mGpuPools.push_back(
+            mManager->gpu(ITensor::makeShape({kNUM_GPU_BLOCKS, 2, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        mManager->setZero(*mGpuPools.front());
+    }
+
+    void fillBlock(SizeType blockIdx, float first)
+    {
+        auto block = ITensor::slice(mGpuPools.front(), blockIdx, 1);
+        std::vector<float> values(block->getSize());
+        std::iota(values.begin(), values.end(), first);
+        mManager->copy(values.data(), *block);
+    }
+
+    void expectBlock(SizeType blockIdx, float first)
+    {
+        auto const block = mManager->copyFrom(*ITensor::slice(mGpuPools.front(), blockIdx, 1), MemoryType::kCPU);
+        mStream->synchronize();
+        auto const* values = bufferCast<float>(*block);
+        for (std::size_t i = 0; i < block->getSize(); ++i)
+        {
+            ASSERT_EQ(values[i], first + static_cast<float>(i)) << "block " << blockIdx << " at " << i;
+        }
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::vector<ITensor::SharedPtr> mGpuPools;
+};
+
+TEST_F(KVCacheSwapSpaceTest, swapOutSwapIn)
+{
+    KVCacheSwapSpace swapSpace(3, mGpuPools, mStream);
+    EXPECT_EQ(swapSpace.getMaxNumBlocks(), 3);
+
+    fillBlock(0, 100.f);
+    fillBlock(4, 200.f);
+    swapSpace.swapOut(1, {0, 4});
+    EXPECT_TRUE(swapSpace.isSwappedOut(1));
+    EXPECT_EQ(swapSpace.getNumSwappedBlocks(1), 2);
+    EXPECT_FALSE(swapSpace.canSwapOut(2));
+    EXPECT_THROW(swapSpace.swapOut(1, {1}), std::exception);
+    EXPECT_THROW(swapSpace.swapOut(2, {1, 2}), std::exception);
+
+    // The released GPU blocks are overwritten by other sequences
+    fillBlock(0, 0.f);
+    fillBlock(4, 0.f);
+
+    EXPECT_THROW(swapSpace.swapIn(1, {2}), std::exception);
+    swapSpace.swapIn(1, {5, 2});
+    expectBlock(5, 100.f);
+    expectBlock(2, 200.f);
+    EXPECT_FALSE(swapSpace.isSwappedOut(1));
+    EXPECT_TRUE(swapSpace.canSwapOut(3));
+    EXPECT_THROW(swapSpace.swapIn(1, {5, 2}), std::exception);
+
+    mStream->synchronize();
+    auto const stats = swapSpace.getSwapStats();
+    EXPECT_EQ(stats.numSwappedRequests, 0);
+    EXPECT_EQ(stats.numSwappedBlocks, 0);
+    EXPECT_EQ(stats.numSwapOuts, 1);
+    EXPECT_EQ(stats.numSwapIns, 1);
+    EXPECT_EQ(stats.swappedBytes, 2 * 2 * 2 * kBLOCK_SIZE * sizeof(float));
+}
+
+TEST_F(KVCacheSwapSpaceTest, discard)
+{
+    KVCacheSwapSpace swapSpace(2, mGpuPools, mStream);
+    swapSpace.swapOut(7, {1, 3});
+    EXPECT_EQ(swapSpace.getSwapStats().numSwappedRequests, 1);
+    swapSpace.discard(7);
+    EXPECT_FALSE(swapSpace.isSwappedOut(7));
+    EXPECT_EQ(swapSpace.getNumSwappedBlocks(7), 0);
+    EXPECT_TRUE(swapSpace.canSwapOut(2));
+    // Unknown requests are ignored
+    swapSpace.discard(8);
+}
+
+TEST_F(KVCacheSwapSpaceTest, calculateMaxNumBlocks)
+{
+    auto const bytesPerBlock = 2 * kBLOCK_SIZE * sizeof(float);
+    EXPECT_EQ(KVCacheSwapSpace::calculateMaxNumBlocks(5 * bytesPerBlock, mGpuPools), 5);
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheTransfer.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+//! \brief Stands in for NcclCommunicator, received buffers are the sent buffers in order.
+class LoopbackCommunicator
+{
+public:
+    explicit LoopbackCommunicator(BufferManager const& manager)
+        : mManager{manager}
+    {
+    }
+
+    void send(IBuffer const& buf, int /*peer*/, CudaStream const& /*stream*/) const
+    {
+        mQueue.push_back(mManager.copyFrom(buf, MemoryType::kGPU));
+    }
+
+    void receive(IBuffer& buf, int /*peer*/, CudaStream const& /*stream*/) const
+    {
+        ASSERT_FALSE(mQueue.empty());
+        mManager.copy(*mQueue.front(), buf);
+        mQueue.pop_front();
+    }
+
+    [[nodiscard]] std::size_t getNumPending() const
+    {
+        return mQueue.size();
+    }
+
+private:
+    BufferManager const& mManager;
+    mutable std::deque<IBuffer::SharedPtr> mQueue;
+};
+} // namespace
+
+class KVCacheTransferTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kNUM_BLOCKS = 4;
+    static SizeType constexpr kBLOCK_SIZE = 8;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        mPools.push_back(mManager->gpu(ITensor::makeShape({kNUM_BLOCKS, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        mPools.push_back(
+            mManager->gpu(ITensor::makeShape({kNUM_BLOCKS, 2, kBLOCK_SIZE}), nvinfer1::DataType::kFLOAT));
+        for (auto const& pool : mPools)
+        {
+            std::vector<float> values(pool->getSize());
+            std::iota(values.begin(), values.end(), 0.f);
+            mManager->copy(values.data(), *pool);
+        }
+    }
+
+    [[nodiscard]] std::vector<float> readBlock(ITensor::SharedPtr const& pool, SizeType blockIdx) const
+    {
+        auto const block = mManager->copyFrom(*ITensor::slice(pool, blockIdx, 1), MemoryType::kCPU);
+        mStream->synchronize();
+        auto const* data = bufferCast<float>(*block);
+        return {data, data + block->getSize()};
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::vector<ITensor::SharedPtr> mPools;
+};
+
+TEST_F(KVCacheTransferTest, copyBlock)
+{
+    std::vector<std::vector<float>> expected;
+    for (auto const& pool : mPools)
+    {
+        expected.push_back(readBlock(pool, 1));
+    }
+    copyBlock(mPools, 1, 3, *mManager);
+    for (std::size_t poolIdx = 0; poolIdx < mPools.size(); ++poolIdx)
+    {
+        EXPECT_EQ(readBlock(mPools[poolIdx], 3), expected[poolIdx]);
+        EXPECT_EQ(readBlock(mPools[poolIdx], 1), expected[poolIdx]);
+        EXPECT_NE(readBlock(mPools[poolIdx], 2), expected[poolIdx]);
+    }
+    EXPECT_THROW(copyBlock(mPools, 2, 2, *mManager), std::exception);
+}
+
+TEST_F(KVCacheTransferTest, descriptorRoundTrip)
+{
+    SizeType constexpr kTOKENS_PER_BLOCK = 4;
+    GenerationRequest sequence(0, 6, 2);
+    // The first block is shared by both beams
+    sequence.addCacheBlock(0, 1);
+    sequence.addCacheBlock(0, 2);
+    sequence.addCacheBlock(1, 1);
+    sequence.addCacheBlock(1, 3);
+
+    KVCacheBlockDescriptor const descriptor(sequence, mPools, kTOKENS_PER_BLOCK);
+    EXPECT_EQ(descriptor.getNumTokens(), 6);
+    EXPECT_EQ(descriptor.getUniqueBlockIds(), (std::vector<SizeType>{1, 2, 3}));
+    EXPECT_EQ(descriptor.getNumUniqueBlocks(), 3);
+    EXPECT_TRUE(descriptor.isCompatible(mPools, kTOKENS_PER_BLOCK));
+    EXPECT_FALSE(descriptor.isCompatible(mPools, 2 * kTOKENS_PER_BLOCK));
+    EXPECT_FALSE(descriptor.isCompatible({mPools.front()}, kTOKENS_PER_BLOCK));
+
+    auto const packed = descriptor.serialize();
+    auto const copy = KVCacheBlockDescriptor::deserialize(packed);
+    EXPECT_EQ(copy.getDataType(), nvinfer1::DataType::kFLOAT);
+    EXPECT_EQ(copy.getTokensPerBlock(), kTOKENS_PER_BLOCK);
+    EXPECT_EQ(copy.getNumTokens(), 6);
+    EXPECT_EQ(copy.getCacheBlockIds(), sequence.getCacheBlockIds());
+    EXPECT_TRUE(copy.isCompatible(mPools, kTOKENS_PER_BLOCK));
+
+    auto truncated = packed;
+    truncated.pop_back();
+    EXPECT_THROW(KVCacheBlockDescriptor::deserialize(truncated), std::exception);
+    auto trailing = packed;
+    trailing.push_back(0);
+    EXPECT_THROW(KVCacheBlockDescriptor::deserialize(trailing), std::exception);
+}
+
+TEST(KVCacheBlockDescriptorTest, rejectsCorruptDescriptors)
+{
+    // Data type, tokens per block, number of tokens, one pool of block shape [2, 4], one beam with blocks 5 and 7
+    std::vector<std::int64_t> const packed{0, 4, 6, 1, 2, 2, 4, 1, 2, 5, 7};
+    auto const descriptor = KVCacheBlockDescriptor::deserialize(packed);
+    EXPECT_EQ(descriptor.getCacheBlockIds(), (std::vector<std::vector<SizeType>>{{5, 7}}));
+
+    auto invalidDataType = packed;
+    invalidDataType[0] = 100;
+    EXPECT_THROW(KVCacheBlockDescriptor::deserialize(invalidDataType), std::exception);
+    // Counts must be rejected before anything is allocated for them
+    for (std::size_t const countPos : {3, 7, 8})
+    {
+        for (std::int64_t const count : {std::int64_t{-1}, std::int64_t{1} << 40})
+        {
+            auto corrupt = packed;
+            corrupt[countPos] = count;
+            EXPECT_THROW(KVCacheBlockDescriptor::deserialize(corrupt), std::exception) << countPos << " " << count;
+        }
+    }
+}
+
+TEST_F(KVCacheTransferTest, sendReceiveBlocks)
+{
+    GenerationRequest sequence(0, 8, 1);
+    sequence.addCacheBlock(0, 2);
+    sequence.addCacheBlock(0, 0);
+    KVCacheBlockDescriptor const descriptor(sequence, mPools, 4);
+
+    std::vector<std::vector<float>> expected;
+    for (auto const& pool : mPools)
+    {
+        expected.push_back(readBlock(pool, 2));
+        expected.push_back(readBlock(pool, 0));
+    }
+
+    LoopbackCommunicator const comm(*mManager);
+    sendBlocks(comm, descriptor, mPools, 1, *mStream);
+    EXPECT_EQ(comm.getNumPending(), 2 * mPools.size());
+    EXPECT_THROW(receiveBlocks(comm, descriptor, mPools, 4, {1}, 0, *mStream), std::exception);
+    // The generation instance uses another block size
+    EXPECT_THROW(receiveBlocks(comm, descriptor, mPools, 8, {1, 3}, 0, *mStream), std::exception);
+    receiveBlocks(comm, descriptor, mPools, 4, {1, 3}, 0, *mStream);
+    EXPECT_EQ(comm.getNumPending(), 0);
+    for (std::size_t poolIdx = 0; poolIdx < mPools.size(); ++poolIdx)
+    {
+        EXPECT_EQ(readBlock(mPools[poolIdx], 1), expected[2 * poolIdx]);
+        EXPECT_EQ(readBlock(mPools[poolIdx], 3), expected[2 * poolIdx + 1]);
+    }
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/multiModelScheduler.h"
+
+#include <chrono>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+namespace
+{
+using SizeType = MultiModelScheduler::SizeType;
+
+//! \brief Run numIterations iterations of one second each and count the iterations of every model.
+std::vector<SizeType> runIterations(
+    MultiModelScheduler& scheduler, std::vector<SizeType> const& numRequests, SizeType numIterations)
+{
+    std::vector<SizeType> counts(numRequests.size());
+    for (SizeType i = 0; i < numIterations; ++i)
+    {
+        auto const model = scheduler.next(numRequests);
+        if (!model)
+        {
+            break;
+        }
+        scheduler.recordIteration(*model, MultiModelScheduler::Duration{1.0});
+        ++counts[*model];
+    }
+    return counts;
+}
+} // namespace
+
+TEST(MultiModelSchedulerTest, iterationsFollowTheRequests)
+{
+    MultiModelScheduler scheduler(2);
+    EXPECT_FALSE(scheduler.next({0, 0}).has_value());
+    EXPECT_EQ(scheduler.next({0, 2}), 1);
+
+    // Weights of 4 and 2
+    auto const counts = runIterations(scheduler, {3, 1}, 60);
+    EXPECT_EQ(counts, (std::vector<SizeType>{40, 20}));
+    EXPECT_EQ(scheduler.getNumIterations(0), 40);
+    EXPECT_DOUBLE_EQ(scheduler.getGpuTime(1).count(), 20.0);
+}
+
+TEST(MultiModelSchedulerTest, idleModelDoesNotCatchUp)
+{
+    MultiModelScheduler scheduler(2);
+    EXPECT_EQ(runIterations(scheduler, {1, 0}, 10), (std::vector<SizeType>{10, 0}));
+    // The second model rejoins at the virtual time of the first, instead of taking the next 10 iterations
+    EXPECT_EQ(runIterations(scheduler, {1, 1}, 10), (std::vector<SizeType>{5, 5}));
+}
+
+TEST(MultiModelSchedulerTest, rejectsInvalidArguments)
+{
+    EXPECT_THROW(MultiModelScheduler(0), std::exception);
+    MultiModelScheduler scheduler(2);
+    EXPECT_THROW(static_cast<void>(scheduler.next({1})), std::exception);
+    EXPECT_THROW(scheduler.recordIteration(2, MultiModelScheduler::Duration{1.0}), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/multiStepPlanner.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+namespace
+{
+using SizeType = MultiStepPlanner::SizeType;
+using RequestPtr = std::shared_ptr<LlmRequest>;
+
+SizeType constexpr kTOKENS_PER_BLOCK = 4;
+
+RequestPtr createRequest(SizeType promptLen, SizeType maxNewTokens, SizeType numGeneratedTokens = 0,
+    SizeType beamWidth = 1)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(promptLen, 1);
+    auto request = std::make_shared<LlmRequest>(0, maxNewTokens, tokens, runtime::SamplingConfig{beamWidth}, false);
+    for (SizeType i = 0; i < numGeneratedTokens; ++i)
+    {
+        request->addNewTokens(LlmRequest::VecTokens(beamWidth, 2));
+    }
+    request->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    return request;
+}
+} // namespace
+
+TEST(MultiStepPlannerTest, neededBlocks)
+{
+    MultiStepPlanner const planner(8, kTOKENS_PER_BLOCK);
+    // The cache holds the 4 tokens before the last one, i.e. one full block
+    auto const request = createRequest(5, 10);
+    EXPECT_EQ(MultiStepPlanner::getRemainingSteps(*request), 10);
+    EXPECT_EQ(planner.getNeededBlocks(*request, 4), 1);
+    EXPECT_EQ(planner.getNeededBlocks(*request, 5), 2);
+    // No block past maxNewTokens
+    EXPECT_EQ(planner.getNeededBlocks(*request, 100), 3);
+    // Every beam needs its own blocks
+    EXPECT_EQ(planner.getNeededBlocks(*createRequest(5, 10, 0, 2), 4), 2);
+    EXPECT_EQ(MultiStepPlanner::getRemainingSteps(*createRequest(4, 3, 1)), 2);
+}
+
+TEST(MultiStepPlannerTest, roundShrinksToFreeBlocks)
+{
+    MultiStepPlanner const planner(8, kTOKENS_PER_BLOCK);
+    MultiStepPlanner::RequestList const requests{createRequest(5, 10), createRequest(4, 3, 1)};
+
+    auto plan = planner.plan(requests, 3);
+    EXPECT_EQ(plan.numSteps, 8);
+    // The second request is masked once it reaches its maxNewTokens
+    EXPECT_EQ(plan.requestSteps, (std::vector<SizeType>{8, 2}));
+    EXPECT_EQ(plan.numBlocks, 3);
+
+    plan = planner.plan(requests, 2);
+    EXPECT_EQ(plan.numSteps, 4);
+    EXPECT_EQ(plan.requestSteps, (std::vector<SizeType>{4, 2}));
+    EXPECT_EQ(plan.numBlocks, 2);
+
+    // A single step is left to the KV cache manager
+    plan = planner.plan(requests, 0);
+    EXPECT_EQ(plan.numSteps, 1);
+    EXPECT_EQ(plan.requestSteps, (std::vector<SizeType>{1, 1}));
+    EXPECT_EQ(plan.numBlocks, 2);
+}
+
+TEST(MultiStepPlannerTest, noStepPastTheLongestRequest)
+{
+    MultiStepPlanner const planner(8, kTOKENS_PER_BLOCK);
+    auto plan = planner.plan({createRequest(4, 3, 1)}, 100);
+    EXPECT_EQ(plan.numSteps, 2);
+
+    plan = planner.plan({createRequest(4, 2, 2)}, 100);
+    EXPECT_EQ(plan.numSteps, 0);
+    EXPECT_EQ(plan.requestSteps, (std::vector<SizeType>{0}));
+    EXPECT_EQ(plan.numBlocks, 0);
+    EXPECT_EQ(planner.plan({}, 100).numSteps, 0);
+}
+
+TEST(MultiStepPlannerTest, rejectsInvalidConfig)
+{
+    EXPECT_THROW(MultiStepPlanner(0, kTOKENS_PER_BLOCK), std::exception);
+    EXPECT_THROW(MultiStepPlanner(8, 0), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/ngramDrafter.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+namespace
+{
+using VecTokens = NgramDrafter::VecTokens;
+} // namespace
+
+TEST(NgramDrafterTest, proposesContinuationOfLatestMatch)
+{
+    NgramDrafter drafter(3, 2);
+    VecTokens tokens{1, 2, 3, 4, 1, 2};
+    EXPECT_EQ(drafter.proposeDraftTokens(0, tokens, 8), (VecTokens{3, 4, 1}));
+    // The caller may ask for fewer drafts
+    EXPECT_EQ(drafter.proposeDraftTokens(0, tokens, 1), (VecTokens{3}));
+
+    // The index is extended with the new tokens, the latest occurrence of (1, 2) now continues with 5
+    tokens.insert(tokens.end(), {5, 6, 1, 2});
+    EXPECT_EQ(drafter.proposeDraftTokens(0, tokens, 8), (VecTokens{5, 6, 1}));
+    EXPECT_EQ(drafter.getNumHits(), 3);
+}
+
+TEST(NgramDrafterTest, longestNgramFirst)
+{
+    NgramDrafter drafter(2, 2);
+    // (3) continues with 9 at its latest occurrence, but the bigram (2, 3) continues with 4
+    VecTokens const tokens{2, 3, 4, 5, 3, 9, 2, 3};
+    EXPECT_EQ(drafter.proposeDraftTokens(0, tokens, 8), (VecTokens{4, 5}));
+}
+
+TEST(NgramDrafterTest, missAndRewind)
+{
+    NgramDrafter drafter(4, 3);
+    EXPECT_TRUE(drafter.proposeDraftTokens(0, VecTokens{1, 2, 3}, 4).empty());
+    EXPECT_EQ(drafter.getNumMisses(), 1);
+
+    // Rejected drafts rewind the sequence, which is indexed again
+    EXPECT_EQ(drafter.proposeDraftTokens(0, VecTokens{7, 8, 7}, 4), (VecTokens{8, 7}));
+    EXPECT_EQ(drafter.getNumSequences(), 1);
+    drafter.removeRequest(0);
+    EXPECT_EQ(drafter.getNumSequences(), 0);
+    EXPECT_THROW(NgramDrafter(0), std::exception);
+    EXPECT_THROW(NgramDrafter(1, 1, 2), std::exception);
+}
+
+TEST(NgramDrafterTest, prepareDraftTokens)
+{
+    NgramDrafter drafter(4);
+    auto tokens = std::make_shared<VecTokens>(VecTokens{5, 6, 7, 5, 6});
+    LlmRequest request(0, 3, tokens, runtime::SamplingConfig{1}, false);
+    // Requests in the context phase get no drafts
+    drafter.prepareDraftTokens(request);
+    EXPECT_FALSE(request.hasDraftTokens());
+
+    request.mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    request.addNewToken(7, 0);
+    drafter.prepareDraftTokens(request);
+    // One token is generated and the target model adds one to the drafts, so one draft fits into 3 new tokens
+    ASSERT_TRUE(request.hasDraftTokens());
+    EXPECT_EQ(*request.getDraftTokens(), (VecTokens{5}));
+}
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheCopyOnWrite.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/parallelSamplingTable.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+namespace
+{
+using RequestIdType = ParallelSamplingTable::RequestIdType;
+using SizeType = ParallelSamplingTable::SizeType;
+
+std::shared_ptr<LlmRequest> createRequest(RequestIdType requestId, SizeType promptLen, SizeType beamWidth = 1)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(promptLen, 1);
+    runtime::SamplingConfig samplingConfig{beamWidth};
+    samplingConfig.randomSeed = std::vector<std::uint64_t>{42};
+    return std::make_shared<LlmRequest>(requestId, 8, tokens, samplingConfig, false);
+}
+} // namespace
+
+TEST(ParallelSamplingTableTest, defaults)
+{
+    ParallelSamplingTable table;
+    EXPECT_EQ(table.getNumReturnSequences(1), 1);
+    EXPECT_FALSE(table.getParentRequestId(1).has_value());
+    EXPECT_EQ(table.getSequenceIndex(1), 0);
+
+    auto const beamSearch = createRequest(1, 4, 2);
+    table.setNumReturnSequences(*beamSearch, 1);
+    EXPECT_THROW(table.setNumReturnSequences(*beamSearch, 2), std::exception);
+    EXPECT_THROW(table.setNumReturnSequences(*createRequest(2, 4), 0), std::exception);
+}
+
+TEST(ParallelSamplingTableTest, createChildRequests)
+{
+    SizeType constexpr kNUM_SEQUENCES = 3;
+    ParallelSamplingTable table;
+    auto const parent = createRequest(1, 5);
+    table.setNumReturnSequences(*parent, kNUM_SEQUENCES);
+    EXPECT_EQ(table.getNumReturnSequences(1), kNUM_SEQUENCES);
+
+    std::set<std::uint64_t> seeds{parent->mSamplingConfig.randomSeed->front()};
+    for (SizeType sequenceIdx = 1; sequenceIdx < kNUM_SEQUENCES; ++sequenceIdx)
+    {
+        auto const requestId = static_cast<RequestIdType>(10 + sequenceIdx);
+        auto const child = table.createChildRequest(*parent, requestId, sequenceIdx);
+        EXPECT_EQ(child->mRequestId, requestId);
+        EXPECT_EQ(child->mPromptLen, parent->mPromptLen);
+        EXPECT_EQ(child->getTokens(0), parent->getTokens(0));
+        EXPECT_EQ(table.getParentRequestId(requestId), parent->mRequestId);
+        EXPECT_EQ(table.getSequenceIndex(requestId), sequenceIdx);
+        EXPECT_EQ(table.getNumReturnSequences(requestId), 1);
+        ASSERT_TRUE(child->mSamplingConfig.randomSeed.has_value());
+        auto const seed = child->mSamplingConfig.randomSeed->front();
+        EXPECT_EQ(seed, ParallelSamplingTable::deriveSequenceSeed(42, sequenceIdx));
+        EXPECT_TRUE(seeds.insert(seed).second);
+    }
+    // The parent is unchanged
+    EXPECT_EQ(parent->mSamplingConfig.randomSeed->front(), 42);
+    EXPECT_FALSE(table.getParentRequestId(1).has_value());
+    EXPECT_EQ(table.size(), kNUM_SEQUENCES);
+
+    table.erase(11);
+    EXPECT_FALSE(table.getParentRequestId(11).has_value());
+    EXPECT_EQ(table.size(), kNUM_SEQUENCES - 1);
+}
+
+TEST(ParallelSamplingTableTest, rejectsInvalidForks)
+{
+    ParallelSamplingTable table;
+    auto const parent = createRequest(1, 5);
+    table.setNumReturnSequences(*parent, 2);
+    EXPECT_THROW(static_cast<void>(table.createChildRequest(*parent, 2, 0)), std::exception);
+    EXPECT_THROW(static_cast<void>(table.createChildRequest(*parent, 2, 2)), std::exception);
+    // The request id of the child must be new
+    EXPECT_THROW(static_cast<void>(table.createChildRequest(*parent, 1, 1)), std::exception);
+
+    auto const child = table.createChildRequest(*parent, 2, 1);
+    EXPECT_THROW(static_cast<void>(table.createChildRequest(*child, 3, 1)), std::exception);
+    EXPECT_THROW(table.setNumReturnSequences(*child, 2), std::exception);
+
+    // Forking after the first generated token would lose the sampled token
+    parent->addNewToken(7, 0);
+    EXPECT_THROW(static_cast<void>(table.createChildRequest(*parent, 3, 1)), std::exception);
+}
+
+TEST(ParallelSamplingTableTest, sequencesShareContextBlocks)
+{
+    SizeType constexpr kNUM_SEQUENCES = 3;
+    auto blockTable = kv_cache_manager::CopyOnWriteBlockTable::fromContext({4, 5}, kNUM_SEQUENCES);
+    EXPECT_EQ(blockTable.getBeamWidth(), kNUM_SEQUENCES);
+    EXPECT_EQ(blockTable.getRefCount(4), kNUM_SEQUENCES);
+    EXPECT_EQ(blockTable.getRefCount(5), kNUM_SEQUENCES);
+
+    // The first write of each sequence but the last into the partial context block forks it
+    SizeType nextBlockIdx = 10;
+    auto const allocate = [&nextBlockIdx]() { return nextBlockIdx++; };
+    EXPECT_TRUE(blockTable.prepareWrite(0, 1, allocate));
+    EXPECT_TRUE(blockTable.prepareWrite(1, 1, allocate));
+    EXPECT_FALSE(blockTable.prepareWrite(2, 1, allocate));
+    EXPECT_EQ(blockTable.getRefCount(4), kNUM_SEQUENCES);
+    EXPECT_EQ(blockTable.getRefCount(5), 1);
+    EXPECT_EQ(blockTable.takePendingCopies().size(), 2);
+}
+
+} // namespace tensorrt_llm::batch_manager
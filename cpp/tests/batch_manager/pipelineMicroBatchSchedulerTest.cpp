@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/pipelineMicroBatchScheduler.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+namespace
+{
+using SizeType = PipelineMicroBatchScheduler::SizeType;
+using RequestPtr = std::shared_ptr<LlmRequest>;
+using VecRequestIds = std::vector<LlmRequest::RequestIdType>;
+
+RequestPtr createGenerationRequest(LlmRequest::RequestIdType requestId)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(4, 1);
+    auto request = std::make_shared<LlmRequest>(requestId, 8, tokens, runtime::SamplingConfig{1}, false);
+    request->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    return request;
+}
+
+VecRequestIds getRequestIds(TokenBudgetSchedule const& schedule)
+{
+    VecRequestIds requestIds;
+    for (auto const& request : schedule.generationRequests)
+    {
+        requestIds.push_back(request->mRequestId);
+    }
+    return requestIds;
+}
+} // namespace
+
+TEST(PipelineMicroBatchSchedulerTest, decodesAreSharedBetweenMicroBatches)
+{
+    PipelineMicroBatchScheduler scheduler(2, TokenBudgetConfig{64});
+    PipelineMicroBatchScheduler::RequestList requests;
+    for (LlmRequest::RequestIdType requestId = 0; requestId < 4; ++requestId)
+    {
+        requests.push_back(createGenerationRequest(requestId));
+    }
+
+    auto const first = scheduler.scheduleNext(requests, 8);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->first, 0);
+    EXPECT_EQ(getRequestIds(first->second), (VecRequestIds{0, 1}));
+    // Requests in flight are left to the next micro-batch
+    auto const second = scheduler.scheduleNext(requests, 8);
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->first, 1);
+    EXPECT_EQ(getRequestIds(second->second), (VecRequestIds{2, 3}));
+
+    // The pipeline is full until the oldest micro-batch completes
+    EXPECT_EQ(scheduler.getNumInFlight(), 2);
+    EXPECT_FALSE(scheduler.getNextMicroBatchId().has_value());
+    EXPECT_FALSE(scheduler.scheduleNext(requests, 8).has_value());
+    EXPECT_THROW(scheduler.complete(1), std::exception);
+    scheduler.complete(0);
+    EXPECT_THROW(scheduler.complete(0), std::exception);
+    EXPECT_EQ(scheduler.getNextMicroBatchId(), 0);
+
+    auto const third = scheduler.scheduleNext(requests, 8);
+    ASSERT_TRUE(third.has_value());
+    EXPECT_EQ(third->first, 0);
+    EXPECT_EQ(getRequestIds(third->second), (VecRequestIds{0, 1}));
+}
+
+TEST(PipelineMicroBatchSchedulerTest, emptyMicroBatchesAreNotLaunched)
+{
+    PipelineMicroBatchScheduler scheduler(3, TokenBudgetConfig{64});
+    PipelineMicroBatchScheduler::RequestList const requests{createGenerationRequest(0)};
+    ASSERT_TRUE(scheduler.scheduleNext(requests, 8).has_value());
+    // The only request is in flight
+    EXPECT_FALSE(scheduler.scheduleNext(requests, 8).has_value());
+    EXPECT_EQ(scheduler.getNumInFlight(), 1);
+    EXPECT_EQ(scheduler.getNextMicroBatchId(), 1);
+
+    scheduler.complete(0);
+    auto const next = scheduler.scheduleNext(requests, 8);
+    ASSERT_TRUE(next.has_value());
+    EXPECT_EQ(next->first, 1);
+}
+
+TEST(PipelineMicroBatchSchedulerTest, rejectsInvalidConfig)
+{
+    EXPECT_THROW(PipelineMicroBatchScheduler(0, TokenBudgetConfig{64}), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
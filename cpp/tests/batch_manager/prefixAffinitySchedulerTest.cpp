@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/prefixAffinityScheduler.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+class PrefixAffinityReordererTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    using SizeType = PrefixAffinityReorderer::SizeType;
+    using RequestIdType = PrefixAffinityReorderer::RequestIdType;
+    using RequestList = PrefixAffinityReorderer::RequestList;
+
+    static SizeType constexpr kTOKENS_PER_BLOCK = 4;
+    static SizeType constexpr kPROMPT_LEN = 9;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<runtime::CudaStream>();
+        mKvCacheManager = std::make_unique<kv_cache_manager::KVCacheManager>(1, 1, 1, kTOKENS_PER_BLOCK, 16, 1, 1,
+            2 * kPROMPT_LEN, 0, false, nvinfer1::DataType::kHALF, mStream, true);
+        // Cache the prompt starting with token 0 in the reuse tree
+        auto request = createRequest(99, 0);
+        mKvCacheManager->addSequence(0, kPROMPT_LEN, 1, request);
+        request->mState = REQUEST_STATE_GENERATION_COMPLETE;
+        mKvCacheManager->removeSequence(0, request);
+    }
+
+    //! \brief Prompt of kPROMPT_LEN consecutive tokens starting at first.
+    static LlmRequest::VecTokens makeTokens(LlmRequest::TokenIdType first)
+    {
+        LlmRequest::VecTokens tokens(kPROMPT_LEN);
+        std::iota(tokens.begin(), tokens.end(), first);
+        return tokens;
+    }
+
+    static std::shared_ptr<LlmRequest> createRequest(RequestIdType requestId, LlmRequest::VecTokens tokens)
+    {
+        return std::make_shared<LlmRequest>(requestId, 1,
+            std::make_shared<LlmRequest::VecTokens>(std::move(tokens)), runtime::SamplingConfig{1}, false);
+    }
+
+    static std::shared_ptr<LlmRequest> createRequest(RequestIdType requestId, LlmRequest::TokenIdType first)
+    {
+        return createRequest(requestId, makeTokens(first));
+    }
+
+    static std::vector<RequestIdType> getRequestIds(RequestList const& requests)
+    {
+        std::vector<RequestIdType> requestIds;
+        for (auto const& request : requests)
+        {
+            requestIds.push_back(request->mRequestId);
+        }
+        return requestIds;
+    }
+
+    [[nodiscard]] kv_cache_manager::BlockManager const& getBlockManager() const
+    {
+        return mKvCacheManager->getBlockManager();
+    }
+
+    std::shared_ptr<runtime::CudaStream> mStream;
+    std::unique_ptr<kv_cache_manager::KVCacheManager> mKvCacheManager;
+};
+
+TEST_F(PrefixAffinityReordererTest, countCachedBlocks)
+{
+    // The last prompt token is never reused, so only the two full blocks before it count
+    EXPECT_EQ(PrefixAffinityReorderer::countCachedBlocks(getBlockManager(), *createRequest(0, 0)), 2);
+    EXPECT_EQ(PrefixAffinityReorderer::countCachedBlocks(getBlockManager(), *createRequest(0, 1000)), 0);
+    auto tokens = makeTokens(0);
+    tokens[5] = 1000;
+    EXPECT_EQ(PrefixAffinityReorderer::countCachedBlocks(getBlockManager(), *createRequest(0, tokens)), 1);
+}
+
+TEST_F(PrefixAffinityReordererTest, cachedFirstThenGrouped)
+{
+    PrefixAffinityReorderer reorderer(64, 8);
+    auto sharedFirstBlock = makeTokens(100);
+    sharedFirstBlock[6] = 1000;
+    RequestList requests{
+        createRequest(0, 100), createRequest(1, 200), createRequest(2, 0), createRequest(3, sharedFirstBlock)};
+    reorderer.reorder(requests, getBlockManager());
+    // The cached request goes first, request 3 joins request 0 that populates their common first block
+    EXPECT_EQ(getRequestIds(requests), (std::vector<RequestIdType>{2, 0, 3, 1}));
+    EXPECT_EQ(reorderer.getBypassCount(0), 1);
+    EXPECT_EQ(reorderer.getBypassCount(1), 1);
+    EXPECT_EQ(reorderer.getBypassCount(2), 0);
+    EXPECT_EQ(reorderer.getBypassCount(3), 0);
+}
+
+TEST_F(PrefixAffinityReordererTest, starvingRequestsAreNotOvertaken)
+{
+    PrefixAffinityReorderer reorderer(64, 1);
+    RequestList requests{createRequest(0, 100), createRequest(1, 0)};
+    reorderer.reorder(requests, getBlockManager());
+    EXPECT_EQ(getRequestIds(requests), (std::vector<RequestIdType>{1, 0}));
+    // Request 0 was overtaken once and keeps its position from now on
+    requests.push_back(createRequest(2, 0));
+    reorderer.reorder(requests, getBlockManager());
+    EXPECT_EQ(getRequestIds(requests), (std::vector<RequestIdType>{0, 1, 2}));
+
+    // Counts of finished requests are dropped
+    requests.pop_front();
+    reorderer.reorder(requests, getBlockManager());
+    EXPECT_EQ(reorderer.getBypassCount(0), 0);
+}
+
+TEST_F(PrefixAffinityReordererTest, generationRequestsKeepTheirPosition)
+{
+    PrefixAffinityReorderer reorderer;
+    auto generation = createRequest(0, 100);
+    generation->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    RequestList requests{generation, createRequest(1, 200), createRequest(2, 0)};
+    reorderer.reorder(requests, getBlockManager());
+    EXPECT_EQ(getRequestIds(requests), (std::vector<RequestIdType>{0, 2, 1}));
+    EXPECT_THROW(PrefixAffinityReorderer(0), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/priorityScheduler.h"
+#include "tensorrt_llm/batch_manager/requestSchedulingTable.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <chrono>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+namespace
+{
+using RequestIdType = RequestSchedulingTable::RequestIdType;
+using SizeType = PriorityScheduler::SizeType;
+
+std::shared_ptr<LlmRequest> createRequest(RequestIdType requestId, SizeType promptLen)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(promptLen, 1);
+    return std::make_shared<LlmRequest>(requestId, 8, tokens, runtime::SamplingConfig{1}, false);
+}
+
+std::vector<RequestIdType> getRequestIds(PriorityScheduler::RequestList const& requests)
+{
+    std::vector<RequestIdType> requestIds;
+    for (auto const& request : requests)
+    {
+        requestIds.push_back(request->mRequestId);
+    }
+    return requestIds;
+}
+} // namespace
+
+TEST(RequestSchedulingTableTest, defaultsAndDeadlines)
+{
+    RequestSchedulingTable table;
+    EXPECT_EQ(table.getPriority(1), RequestSchedulingTable::kDefaultPriority);
+    EXPECT_FALSE(table.getDeadline(1).has_value());
+    EXPECT_FALSE(table.isExpired(1));
+    EXPECT_THROW(table.setPriority(1, 1.5f), std::exception);
+    EXPECT_EQ(table.size(), 0);
+
+    auto const arrival = RequestSchedulingTable::Clock::now();
+    table.setTimeout(1, std::chrono::milliseconds{100}, arrival);
+    ASSERT_TRUE(table.getDeadline(1).has_value());
+    EXPECT_EQ(*table.getDeadline(1), arrival + std::chrono::milliseconds{100});
+    EXPECT_FALSE(table.isExpired(1, arrival + std::chrono::milliseconds{99}));
+    EXPECT_TRUE(table.isExpired(1, arrival + std::chrono::milliseconds{100}));
+    // Setting the deadline keeps the priority and vice versa
+    table.setPriority(1, RequestSchedulingTable::kMaxPriority);
+    EXPECT_TRUE(table.getDeadline(1).has_value());
+    EXPECT_EQ(table.getPriority(1), RequestSchedulingTable::kMaxPriority);
+
+    table.erase(1);
+    EXPECT_EQ(table.size(), 0);
+    EXPECT_EQ(table.getPriority(1), RequestSchedulingTable::kDefaultPriority);
+}
+
+TEST(RequestSchedulingTableTest, loraTaskIds)
+{
+    RequestSchedulingTable table;
+    EXPECT_FALSE(table.getLoraTaskId(1).has_value());
+    table.setLoraTaskId(1, 7);
+    EXPECT_EQ(table.getLoraTaskId(1), 7);
+    EXPECT_EQ(table.getPriority(1), RequestSchedulingTable::kDefaultPriority);
+    table.erase(1);
+    EXPECT_FALSE(table.getLoraTaskId(1).has_value());
+}
+
+TEST(PrioritySchedulerTest, admitByPriorityThenDeadline)
+{
+    PriorityScheduler scheduler;
+    auto& table = *scheduler.getSchedulingTable();
+    auto const now = RequestSchedulingTable::Clock::now();
+    table.setPriority(1, 0.2f);
+    table.setPriority(3, 0.9f);
+    table.setDeadline(4, now + std::chrono::seconds{2});
+    table.setDeadline(5, now + std::chrono::seconds{1});
+
+    auto running = createRequest(0, 4);
+    running->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    PriorityScheduler::RequestList requests{running};
+    for (RequestIdType requestId = 1; requestId <= 5; ++requestId)
+    {
+        requests.push_back(createRequest(requestId, 4));
+    }
+    scheduler.admit(requests);
+    // The running request keeps its position, the others are ordered by priority, then by deadline
+    EXPECT_EQ(getRequestIds(requests), (std::vector<RequestIdType>{0, 3, 5, 4, 2, 1}));
+}
+
+TEST(PrioritySchedulerTest, selectVictimsByPriority)
+{
+    SizeType constexpr kTOKENS_PER_BLOCK = 4;
+    SizeType constexpr kMAX_NUM_BLOCKS = 8;
+    auto stream = std::make_shared<runtime::CudaStream>();
+    kv_cache_manager::KVCacheManager kvCacheManager(
+        1, 1, 1, kTOKENS_PER_BLOCK, kMAX_NUM_BLOCKS, 2, 1, 32, 0, false, nvinfer1::DataType::kHALF, stream);
+
+    PriorityScheduler scheduler;
+    auto& table = *scheduler.getSchedulingTable();
+    PriorityScheduler::RequestList running{createRequest(0, 6), createRequest(1, 9)};
+    SizeType seqSlot{0};
+    for (auto const& request : running)
+    {
+        request->mSeqSlot = seqSlot;
+        kvCacheManager.addSequence(seqSlot++, request->mPromptLen, 1, request);
+        request->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+        request->addNewToken(2, 0);
+    }
+    table.setPriority(0, 0.2f);
+
+    // The blocks are recovered from the block pointers
+    auto const blockIds0 = PriorityScheduler::getCacheBlockIds(*running.front(), kvCacheManager);
+    auto const blockIds1 = PriorityScheduler::getCacheBlockIds(*running.back(), kvCacheManager);
+    ASSERT_EQ(blockIds0.size(), 1);
+    ASSERT_EQ(blockIds0.front().size(), 2);
+    ASSERT_EQ(blockIds1.front().size(), 3);
+    std::set<SizeType> distinct(blockIds0.front().begin(), blockIds0.front().end());
+    distinct.insert(blockIds1.front().begin(), blockIds1.front().end());
+    EXPECT_EQ(distinct.size(), 5);
+    EXPECT_LT(*distinct.rbegin(), kMAX_NUM_BLOCKS);
+    EXPECT_EQ(PriorityScheduler::getNumHeldBlocks(*running.back(), kvCacheManager), 3);
+
+    auto incoming = createRequest(2, 4);
+    table.setPriority(2, RequestSchedulingTable::kMaxPriority);
+    EXPECT_TRUE(scheduler.selectVictims(running, *incoming, 3, kvCacheManager).empty());
+    auto victims = scheduler.selectVictims(running, *incoming, 5, kvCacheManager);
+    ASSERT_EQ(victims.size(), 1);
+    EXPECT_EQ(victims.front()->mRequestId, 0);
+    EXPECT_EQ(scheduler.selectVictims(running, *incoming, 8, kvCacheManager).size(), 2);
+    EXPECT_TRUE(scheduler.selectVictims(running, *incoming, 9, kvCacheManager).empty());
+
+    // Requests of equal priority are never preempted
+    table.erase(2);
+    EXPECT_TRUE(scheduler.selectVictims(running, *incoming, 6, kvCacheManager).empty());
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/inferenceRequest.h"
+#include "tensorrt_llm/batch_manager/requestBroadcaster.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+namespace
+{
+using VecTokens = std::vector<std::int32_t>;
+
+std::shared_ptr<InferenceRequest> createRequest(std::uint64_t requestId, VecTokens const& tokens)
+{
+    auto request = std::make_shared<InferenceRequest>(requestId);
+    auto inputIds = runtime::BufferManager::cpu(
+        runtime::ITensor::makeShape({1, static_cast<runtime::SizeType>(tokens.size())}), nvinfer1::DataType::kINT32);
+    std::copy(tokens.begin(), tokens.end(), runtime::bufferCast<std::int32_t>(*inputIds));
+    request->setInputIds(std::move(inputIds));
+    return request;
+}
+
+VecTokens getInputIds(InferenceRequest const& request)
+{
+    auto const& inputIds = *request.getInputIds();
+    auto const* data = runtime::bufferCast<std::int32_t>(inputIds);
+    return VecTokens(data, data + inputIds.getSize());
+}
+} // namespace
+
+// Runs on any number of ranks, rank 0 fetches the requests.
+TEST(RequestBroadcasterTest, broadcastsRequests)
+{
+    auto const& comm = mpi::MpiComm::world();
+    auto constexpr kROOT = 0;
+    RequestBroadcaster broadcaster(comm, kROOT);
+    EXPECT_EQ(broadcaster.isRoot(), comm.getRank() == kROOT);
+
+    VecTokens firstTokens(5);
+    std::iota(firstTokens.begin(), firstTokens.end(), 10);
+    VecTokens const secondTokens{3, 2, 1};
+    RequestBroadcaster::RequestList newRequests;
+    if (broadcaster.isRoot())
+    {
+        newRequests.push_back(createRequest(7, firstTokens));
+        newRequests.push_back(createRequest(8, secondTokens));
+    }
+
+    broadcaster.start(newRequests);
+    EXPECT_THROW(broadcaster.start(newRequests), std::exception);
+    auto const requests = broadcaster.finish();
+    ASSERT_EQ(requests.size(), 2);
+    EXPECT_EQ(requests.front()->getRequestId(), 7);
+    EXPECT_EQ(getInputIds(*requests.front()), firstTokens);
+    EXPECT_EQ(requests.back()->getRequestId(), 8);
+    EXPECT_EQ(getInputIds(*requests.back()), secondTokens);
+
+    // An iteration without new requests only broadcasts the header
+    broadcaster.start({});
+    EXPECT_TRUE(broadcaster.finish().empty());
+    EXPECT_THROW(broadcaster.finish(), std::exception);
+}
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/rnnStateManager.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::rnn_state_manager
+{
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+VecTokens makeTokens(SizeType numTokens, std::int32_t first)
+{
+    VecTokens tokens(numTokens);
+    std::iota(tokens.begin(), tokens.end(), first);
+    return tokens;
+}
+} // namespace
+
+TEST(RnnStateManagerTest, slotsFromMemoryBudget)
+{
+    std::vector<RnnStateDesc> const states{{"conv_state", ITensor::makeShape({2, 3, 4}), nvinfer1::DataType::kHALF},
+        {"ssm_state", ITensor::makeShape({2, 16, 4}), nvinfer1::DataType::kFLOAT}};
+    EXPECT_EQ(RnnStateManager::getBytesPerSlot(states), 24 * 2 + 128 * 4);
+    EXPECT_EQ(RnnStateManager::calculateMaxNumSlots(560 * 10 + 1, states), 10);
+    EXPECT_EQ(RnnStateManager::calculateMaxNumSlots(1000, {}), 0);
+}
+
+class RnnStateManagerGpuTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kSTATE_SIZE = 8;
+    static SizeType constexpr kCHECKPOINT_INTERVAL = 4;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mBufferManager = std::make_unique<BufferManager>(mStream);
+        mStateManager = std::make_unique<RnnStateManager>(2,
+            std::vector<RnnStateDesc>{{"ssm_state", ITensor::makeShape({kSTATE_SIZE}), nvinfer1::DataType::kFLOAT}},
+            mStream, 2, kCHECKPOINT_INTERVAL, 1);
+    }
+
+    //! \brief Fill the state of a slot with consecutive values starting at first.
+    void fillSlot(SizeType slot, float first)
+    {
+        std::vector<float> values(kSTATE_SIZE);
+        std::iota(values.begin(), values.end(), first);
+        auto state = ITensor::slice(mStateManager->getStatePools().front(), slot, 1);
+        mBufferManager->copy(values.data(), *state);
+    }
+
+    float getFirstValue(SizeType slot)
+    {
+        auto const state = mBufferManager->copyFrom(
+            *ITensor::slice(mStateManager->getStatePools().front(), slot, 1), MemoryType::kCPU);
+        mStream->synchronize();
+        return *bufferCast<float>(*state);
+    }
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mBufferManager;
+    std::unique_ptr<RnnStateManager> mStateManager;
+};
+
+TEST_F(RnnStateManagerGpuTest, slots)
+{
+    auto const first = mStateManager->addSequence(1);
+    auto const second = mStateManager->addSequence(2);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(mStateManager->getNumFreeSlots(), 0);
+    EXPECT_THROW(mStateManager->addSequence(3), std::exception);
+    EXPECT_THROW(mStateManager->addSequence(1), std::exception);
+
+    auto slotIds = BufferManager::cpu(ITensor::makeShape({2}), nvinfer1::DataType::kINT32);
+    mStateManager->fillSlotIds({2, 1}, *slotIds);
+    EXPECT_EQ(bufferCast<SizeType>(*slotIds)[0], second);
+    EXPECT_EQ(bufferCast<SizeType>(*slotIds)[1], first);
+
+    // A new sequence starts from zero states
+    fillSlot(first, 5.f);
+    mStateManager->removeSequence(1);
+    EXPECT_THROW(static_cast<void>(mStateManager->getSlot(1)), std::exception);
+    EXPECT_EQ(mStateManager->addSequence(3), first);
+    EXPECT_EQ(getFirstValue(first), 0.f);
+}
+
+TEST_F(RnnStateManagerGpuTest, restoreCheckpoint)
+{
+    auto const prompt = makeTokens(9, 0);
+    auto const slot = mStateManager->addSequence(1);
+    fillSlot(slot, 10.f);
+    EXPECT_THROW(mStateManager->storeCheckpoint(1, makeTokens(3, 0)), std::exception);
+    mStateManager->storeCheckpoint(1, makeTokens(8, 0));
+    mStateManager->removeSequence(1);
+
+    auto const other = mStateManager->addSequence(2);
+    EXPECT_EQ(mStateManager->restoreCheckpoint(2, prompt), 8);
+    EXPECT_EQ(getFirstValue(other), 10.f);
+    mStateManager->removeSequence(2);
+
+    // The last prompt token is left for the context phase, the prefix of 4 tokens has no checkpoint
+    mStateManager->addSequence(3);
+    EXPECT_EQ(mStateManager->restoreCheckpoint(3, makeTokens(8, 0)), 0);
+    auto const stats = mStateManager->getStats();
+    EXPECT_EQ(stats.numCheckpoints, 1);
+    EXPECT_EQ(stats.numCheckpointHits, 1);
+    EXPECT_EQ(stats.numCheckpointMisses, 1);
+    EXPECT_EQ(stats.numReusedTokens, 8);
+}
+
+TEST_F(RnnStateManagerGpuTest, evictsLeastRecentlyUsedCheckpoint)
+{
+    mStateManager->addSequence(1);
+    auto const first = makeTokens(4, 0);
+    auto const second = makeTokens(4, 100);
+    mStateManager->storeCheckpoint(1, first);
+    mStateManager->storeCheckpoint(1, second);
+    // Touch the first checkpoint, so that the second one is evicted by the third
+    mStateManager->addSequence(2);
+    EXPECT_EQ(mStateManager->restoreCheckpoint(2, makeTokens(5, 0)), 4);
+    mStateManager->storeCheckpoint(1, makeTokens(4, 200));
+
+    EXPECT_EQ(mStateManager->getStats().numCheckpoints, 2);
+    mStateManager->removeSequence(2);
+    mStateManager->addSequence(2);
+    EXPECT_EQ(mStateManager->restoreCheckpoint(2, makeTokens(5, 100)), 0);
+    EXPECT_EQ(mStateManager->restoreCheckpoint(2, makeTokens(5, 0)), 4);
+}
+
+TEST_F(RnnStateManagerGpuTest, swapOutSwapIn)
+{
+    auto const slot = mStateManager->addSequence(1);
+    fillSlot(slot, 3.f);
+    ASSERT_TRUE(mStateManager->canSwapOut());
+    mStateManager->swapOut(1);
+    EXPECT_TRUE(mStateManager->isSwappedOut(1));
+    EXPECT_FALSE(mStateManager->canSwapOut());
+    EXPECT_EQ(mStateManager->getNumFreeSlots(), 2);
+
+    // The freed slot is overwritten by another sequence in the meantime
+    EXPECT_EQ(mStateManager->addSequence(2), slot);
+    fillSlot(slot, 50.f);
+    auto const newSlot = mStateManager->swapIn(1);
+    EXPECT_NE(newSlot, slot);
+    EXPECT_EQ(getFirstValue(newSlot), 3.f);
+    EXPECT_FALSE(mStateManager->isSwappedOut(1));
+    EXPECT_THROW(mStateManager->swapIn(1), std::exception);
+
+    auto const stats = mStateManager->getStats();
+    EXPECT_EQ(stats.numSwapOuts, 1);
+    EXPECT_EQ(stats.numSwapIns, 1);
+}
+
+} // namespace tensorrt_llm::batch_manager::rnn_state_manager
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/scoringRequestTable.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <numeric>
+
+namespace tensorrt_llm::batch_manager
+{
+
+namespace
+{
+using RequestIdType = ScoringRequestTable::RequestIdType;
+using SizeType = ScoringRequestTable::SizeType;
+using VecTokens = ScoringRequestTable::VecTokens;
+
+std::shared_ptr<LlmRequest> createRequest(RequestIdType requestId, SizeType promptLen)
+{
+    auto tokens = std::make_shared<VecTokens>(promptLen);
+    std::iota(tokens->begin(), tokens->end(), 100);
+    return std::make_shared<LlmRequest>(requestId, 1, tokens, runtime::SamplingConfig{1}, false);
+}
+} // namespace
+
+TEST(ScoringRequestTableTest, targetIds)
+{
+    ScoringRequestTable table;
+    auto const request = createRequest(1, 5);
+    EXPECT_FALSE(table.isScoringRequest(1));
+    EXPECT_FALSE(table.getContinuationLength(1).has_value());
+    EXPECT_THROW(static_cast<void>(table.getScoringTargetIds(*request)), std::exception);
+
+    table.setContinuationLength(*request, 2);
+    EXPECT_TRUE(table.isScoringRequest(1));
+    EXPECT_EQ(table.getContinuationLength(1), 2);
+    // Rows 2 and 3 predict the continuation tokens 3 and 4
+    EXPECT_EQ(table.getScoringTargetIds(*request), (VecTokens{-1, -1, 103, 104, -1}));
+
+    // The first token has no logits row predicting it
+    EXPECT_THROW(table.setContinuationLength(*request, 5), std::exception);
+    EXPECT_THROW(table.setContinuationLength(*request, 0), std::exception);
+}
+
+TEST(ScoringRequestTableTest, logProbs)
+{
+    ScoringRequestTable table;
+    auto const request = createRequest(1, 5);
+    table.setContinuationLength(*request, 2);
+    EXPECT_TRUE(table.getScoringLogProbs(1).empty());
+    EXPECT_THROW(table.setScoringLogProbs(1, {-0.5f}), std::exception);
+    EXPECT_THROW(table.setScoringLogProbs(2, {-0.5f, -1.f}), std::exception);
+
+    table.setScoringLogProbs(1, {-0.5f, -1.f});
+    EXPECT_EQ(table.getScoringLogProbs(1), (ScoringRequestTable::VecLogProbs{-0.5f, -1.f}));
+    EXPECT_EQ(table.size(), 1);
+    table.erase(1);
+    EXPECT_FALSE(table.isScoringRequest(1));
+    EXPECT_EQ(table.size(), 0);
+}
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/tokenBudgetScheduler.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/requestLatencyTracker.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::batch_scheduler
+{
+
+namespace
+{
+using SizeType = TokenBudgetScheduler::SizeType;
+using RequestPtr = std::shared_ptr<LlmRequest>;
+
+RequestPtr createContextRequest(LlmRequest::RequestIdType requestId, SizeType promptLen)
+{
+    auto tokens = std::make_shared<LlmRequest::VecTokens>(promptLen, 1);
+    return std::make_shared<LlmRequest>(requestId, 8, tokens, runtime::SamplingConfig{1}, false);
+}
+
+RequestPtr createGenerationRequest(LlmRequest::RequestIdType requestId)
+{
+    auto request = createContextRequest(requestId, 4);
+    request->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    return request;
+}
+} // namespace
+
+TEST(TokenBudgetSchedulerTest, decodesFirstThenContextChunks)
+{
+    auto latencyTracker = std::make_shared<executor::RequestLatencyTracker>();
+    TokenBudgetScheduler scheduler(TokenBudgetConfig{8, 8, 4}, latencyTracker);
+    auto context = createContextRequest(2, 10);
+    latencyTracker->arrive(context->mRequestId);
+    TokenBudgetScheduler::RequestList requests{context, createGenerationRequest(0), createGenerationRequest(1)};
+    auto const schedule = scheduler.schedule(requests, 8);
+    EXPECT_EQ(schedule.generationRequests.size(), 2);
+    ASSERT_EQ(schedule.contextRequests.size(), 1);
+    // 6 tokens remain after the decodes, the chunk is rounded down to whole units
+    EXPECT_EQ(context->getContextChunkSize(), 4);
+    EXPECT_EQ(schedule.numTokens, 6);
+    EXPECT_TRUE(latencyTracker->getPerfMetrics(context->mRequestId)->firstScheduledTime.has_value());
+}
+
+TEST(TokenBudgetSchedulerTest, unchunkedContextIsNotOvertaken)
+{
+    TokenBudgetScheduler scheduler(TokenBudgetConfig{8});
+    TokenBudgetScheduler::RequestList requests{createContextRequest(0, 10), createContextRequest(1, 2)};
+    auto const schedule = scheduler.schedule(requests, 8);
+    EXPECT_TRUE(schedule.contextRequests.empty());
+    EXPECT_EQ(schedule.numTokens, 0);
+}
+
+TEST(TokenBudgetSchedulerTest, maxBatchSize)
+{
+    TokenBudgetScheduler scheduler(TokenBudgetConfig{64});
+    TokenBudgetScheduler::RequestList requests{
+        createGenerationRequest(0), createContextRequest(1, 4), createContextRequest(2, 4)};
+    auto const schedule = scheduler.schedule(requests, 2);
+    EXPECT_EQ(schedule.generationRequests.size(), 1);
+    ASSERT_EQ(schedule.contextRequests.size(), 1);
+    EXPECT_EQ(schedule.contextRequests.front()->mRequestId, 1);
+}
+
+TEST(TokenBudgetSchedulerTest, maxNumLoraAdapters)
+{
+    TokenBudgetConfig config{64};
+    config.maxNumLoraAdapters = 1;
+    TokenBudgetScheduler scheduler(config);
+    auto& schedulingTable = *scheduler.getSchedulingTable();
+    auto generation = createGenerationRequest(0);
+    schedulingTable.setLoraTaskId(0, 1);
+    auto newAdapter = createContextRequest(1, 4);
+    schedulingTable.setLoraTaskId(1, 2);
+    auto sharedAdapter = createContextRequest(2, 4);
+    schedulingTable.setLoraTaskId(2, 1);
+    TokenBudgetScheduler::RequestList requests{generation, newAdapter, sharedAdapter};
+    auto const schedule = scheduler.schedule(requests, 8);
+    // The context sharing the adapter of the decode goes first, the one with a new adapter waits
+    ASSERT_EQ(schedule.contextRequests.size(), 1);
+    EXPECT_EQ(schedule.contextRequests.front()->mRequestId, 2);
+    EXPECT_EQ(schedule.numLoraAdapters, 1);
+    // Releasing a request without cache or pinned adapter is a no-op
+    scheduler.release(*sharedAdapter, nullptr);
+}
+
+TEST(TokenBudgetSchedulerTest, skippedAdaptersAreNotStarved)
+{
+    TokenBudgetConfig config{64};
+    config.maxNumLoraAdapters = 1;
+    config.maxNumLoraSkips = 2;
+    TokenBudgetScheduler scheduler(config);
+    auto& schedulingTable = *scheduler.getSchedulingTable();
+    auto generation = createGenerationRequest(0);
+    schedulingTable.setLoraTaskId(0, 1);
+    auto rareAdapter = createContextRequest(1, 4);
+    schedulingTable.setLoraTaskId(1, 2);
+
+    // New requests keep sharing the adapter of the decode
+    for (LlmRequest::RequestIdType requestId = 2; requestId < 4; ++requestId)
+    {
+        auto sharedAdapter = createContextRequest(requestId, 4);
+        schedulingTable.setLoraTaskId(requestId, 1);
+        auto const schedule = scheduler.schedule({generation, rareAdapter, sharedAdapter}, 8);
+        ASSERT_EQ(schedule.contextRequests.size(), 1);
+        EXPECT_EQ(schedule.contextRequests.front()->mRequestId, requestId);
+    }
+
+    // The rare adapter goes first and exceeds the cap once it was skipped maxNumLoraSkips times
+    auto sharedAdapter = createContextRequest(4, 4);
+    schedulingTable.setLoraTaskId(4, 1);
+    auto schedule = scheduler.schedule({generation, sharedAdapter, rareAdapter}, 8);
+    ASSERT_EQ(schedule.contextRequests.size(), 2);
+    EXPECT_EQ(schedule.contextRequests.front()->mRequestId, 1);
+    EXPECT_EQ(schedule.numLoraAdapters, 2);
+
+    // Once scheduled, its skips start over
+    schedule = scheduler.schedule({generation, rareAdapter, sharedAdapter}, 8);
+    ASSERT_EQ(schedule.contextRequests.size(), 1);
+    EXPECT_EQ(schedule.contextRequests.front()->mRequestId, 4);
+
+    config.maxNumLoraSkips = 0;
+    EXPECT_THROW(TokenBudgetScheduler{config}, std::exception);
+}
+
+TEST(TokenBudgetSchedulerTest, fromExecutorConfig)
+{
+    auto config = TokenBudgetConfig::fromExecutorConfig(executor::ExecutorConfig{}, 256, 64);
+    EXPECT_EQ(config.maxNumTokens, 256);
+    EXPECT_FALSE(config.contextChunkSize.has_value());
+
+    executor::ExecutorConfig chunked{1, executor::SchedulerConfig{}, executor::KvCacheConfig{}, true};
+    config = TokenBudgetConfig::fromExecutorConfig(chunked, 256, 64);
+    EXPECT_EQ(config.contextChunkSize, 256);
+    EXPECT_EQ(config.chunkUnitSize, 64);
+}
+
+} // namespace tensorrt_llm::batch_manager::batch_scheduler
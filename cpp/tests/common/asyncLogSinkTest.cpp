@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensorrt_llm/common/asyncLogSink.h"
+
+using namespace tensorrt_llm::common;
+
+namespace
+{
+
+int constexpr kInfo{20};
+
+bool write(AsyncLogSink& sink, int level, std::string const& text, bool toStderr = false)
+{
+    auto* record = sink.acquire(level);
+    if (record == nullptr)
+    {
+        return false;
+    }
+    std::snprintf(record->text, AsyncLogSink::kRecordSize, "%s", text.c_str());
+    record->toStderr = toStderr;
+    sink.commit(record);
+    return true;
+}
+
+std::vector<std::string> readLines(std::FILE* file)
+{
+    std::fflush(file);
+    std::rewind(file);
+    std::vector<std::string> lines;
+    char line[AsyncLogSink::kRecordSize + 1];
+    while (std::fgets(line, sizeof(line), file) != nullptr)
+    {
+        lines.emplace_back(line, std::strcspn(line, "\n"));
+    }
+    return lines;
+}
+
+} // namespace
+
+TEST(AsyncLogSink, WritesInOrder)
+{
+    auto* out = std::tmpfile();
+    auto* err = std::tmpfile();
+    {
+        AsyncLogSink sink{16, out, err};
+        for (int i = 0; i < 100; ++i)
+        {
+            // The ring is small, wait for the writer rather than dropping
+            while (!write(sink, kInfo, "record " + std::to_string(i), i % 10 == 0))
+            {
+                std::this_thread::yield();
+            }
+        }
+        sink.flush();
+        EXPECT_EQ(readLines(err).size(), 10);
+    }
+    auto const lines = readLines(out);
+    ASSERT_EQ(lines.size(), 90);
+    EXPECT_EQ(lines.front(), "record 1");
+    EXPECT_EQ(lines.back(), "record 99");
+    std::fclose(out);
+    std::fclose(err);
+}
+
+TEST(AsyncLogSink, MultipleProducers)
+{
+    auto* out = std::tmpfile();
+    auto* err = std::tmpfile();
+    int constexpr numThreads{8};
+    int constexpr numRecords{1000};
+    {
+        AsyncLogSink sink{1024, out, err};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back(
+                [&sink, t]()
+                {
+                    for (int i = 0; i < numRecords; ++i)
+                    {
+                        while (!write(sink, kInfo, std::to_string(t) + " " + std::to_string(i)))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Every record once, in order per producer
+    std::vector<int> next(numThreads, 0);
+    auto const lines = readLines(out);
+    ASSERT_EQ(lines.size(), numThreads * numRecords);
+    for (auto const& line : lines)
+    {
+        std::istringstream stream(line);
+        int t;
+        int i;
+        stream >> t >> i;
+        ASSERT_EQ(i, next.at(t)++);
+    }
+    std::fclose(out);
+    std::fclose(err);
+}
+
+TEST(AsyncLogSink, DropsWhenRateLimitedOrFull)
+{
+    auto* out = std::tmpfile();
+    auto* err = std::tmpfile();
+    {
+        AsyncLogSink sink{4, out, err};
+        sink.setRateLimit(kInfo, 2);
+        auto* first = sink.acquire(kInfo);
+        ASSERT_NE(first, nullptr);
+        auto* second = sink.acquire(kInfo);
+        ASSERT_NE(second, nullptr);
+        // Over the limit of the current second, unless the second just changed
+        auto const limited = sink.acquire(kInfo) == nullptr;
+        EXPECT_EQ(sink.getDropped(), limited ? 1 : 0);
+        for (auto* record : {first, second})
+        {
+            std::snprintf(record->text, AsyncLogSink::kRecordSize, "admitted");
+            record->toStderr = false;
+            sink.commit(record);
+        }
+
+        // Other levels are not limited, the ring of 4 fills up if nothing is committed
+        std::vector<AsyncLogSink::Record*> records;
+        while (auto* record = sink.acquire(30))
+        {
+            records.push_back(record);
+        }
+        EXPECT_LE(records.size(), 4);
+        for (auto* record : records)
+        {
+            std::snprintf(record->text, AsyncLogSink::kRecordSize, "warning");
+            record->toStderr = true;
+            sink.commit(record);
+        }
+    }
+    auto const errLines = readLines(err);
+    ASSERT_FALSE(errLines.empty());
+    EXPECT_NE(errLines.back().find("Dropped"), std::string::npos);
+    std::fclose(out);
+    std::fclose(err);
+}
@@ -51,3 +51,29 @@ TEST(Quantization, PlusMinus)
     EXPECT_FALSE(quantMode.hasPerChannelScaling());
     EXPECT_EQ(quantMode, QuantMode::none());
 }
+
+TEST(Quantization, KvCacheDynamicScales)
+{
+    // The flag only takes effect together with an 8-bit KV cache.
+    EXPECT_FALSE(QuantMode::kvCacheDynamicScales().hasKvCacheDynamicScales());
+    static_assert((QuantMode::int8KvCache() + QuantMode::kvCacheDynamicScales()).hasKvCacheDynamicScales());
+
+    auto const int8Dynamic = QuantMode::fromQuantAlgo(std::nullopt, "INT8_DYNAMIC");
+    EXPECT_TRUE(int8Dynamic.hasInt8KvCache());
+    EXPECT_TRUE(int8Dynamic.hasKvCacheDynamicScales());
+    auto const fp8Dynamic = QuantMode::fromQuantAlgo(std::nullopt, "FP8_DYNAMIC");
+    EXPECT_TRUE(fp8Dynamic.hasFp8KvCache());
+    EXPECT_TRUE(fp8Dynamic.hasKvCacheDynamicScales());
+    EXPECT_FALSE(QuantMode::fromQuantAlgo(std::nullopt, "FP8").hasKvCacheDynamicScales());
+}
+
+TEST(Quantization, Int4KvCache)
+{
+    static_assert(QuantMode::int4KvCache().hasInt4KvCache());
+    // The INT4 cache has its own layout, it is not one of the 8-bit caches.
+    static_assert(!QuantMode::int4KvCache().hasKvCacheQuant());
+    EXPECT_TRUE(QuantMode::fromQuantAlgo(std::nullopt, "INT4").hasInt4KvCache());
+    EXPECT_FALSE(QuantMode::fromQuantAlgo(std::nullopt, "INT8").hasInt4KvCache());
+    EXPECT_EQ(QuantMode::fromDescription(false, false, false, false, false, false, false, false, false, true),
+        QuantMode::int4KvCache());
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "tensorrt_llm/common/shmRingBuffer.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+using namespace tensorrt_llm::common;
+
+namespace
+{
+
+std::string uniqueName(std::string const& suffix)
+{
+    return "/trtllm_test_" + std::to_string(::getpid()) + "_" + suffix;
+}
+
+std::vector<char> makeMessage(std::size_t size, int seed)
+{
+    std::vector<char> message(size);
+    std::iota(message.begin(), message.end(), static_cast<char>(seed));
+    return message;
+}
+
+} // namespace
+
+TEST(ShmRingBuffer, WriteRead)
+{
+    auto const name = uniqueName("write_read");
+    auto producer = ShmRingBuffer::create(name, 256);
+    auto consumer = ShmRingBuffer::open(name);
+    EXPECT_EQ(consumer.getCapacity(), 256);
+
+    std::vector<char> message;
+    EXPECT_FALSE(consumer.tryRead(message));
+    auto const first = makeMessage(10, 1);
+    auto const second = makeMessage(0, 2);
+    EXPECT_TRUE(producer.tryWrite(first.data(), first.size()));
+    EXPECT_TRUE(producer.tryWrite(second.data(), second.size()));
+    EXPECT_TRUE(consumer.tryRead(message));
+    EXPECT_EQ(message, first);
+    EXPECT_TRUE(consumer.tryRead(message));
+    EXPECT_EQ(message, second);
+    EXPECT_FALSE(consumer.tryRead(message));
+}
+
+TEST(ShmRingBuffer, FullAndWrapAround)
+{
+    auto const name = uniqueName("full");
+    auto producer = ShmRingBuffer::create(name, 64);
+    auto consumer = ShmRingBuffer::open(name);
+
+    // 8 + 40 bytes, the second message does not fit until the first one is read
+    auto const message = makeMessage(40, 3);
+    EXPECT_TRUE(producer.tryWrite(message.data(), message.size()));
+    EXPECT_FALSE(producer.tryWrite(message.data(), message.size()));
+    EXPECT_FALSE(producer.write(message.data(), message.size(), std::chrono::microseconds(100)));
+
+    std::vector<char> received;
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_TRUE(consumer.tryRead(received));
+        EXPECT_EQ(received, message);
+        EXPECT_TRUE(producer.tryWrite(message.data(), message.size()));
+    }
+    EXPECT_THROW(producer.tryWrite(message.data(), producer.getMaxMessageSize() + 1), TllmException);
+}
+
+TEST(ShmRingBuffer, ProducerConsumer)
+{
+    auto const name = uniqueName("threads");
+    auto producer = ShmRingBuffer::create(name, 1024);
+    auto consumer = ShmRingBuffer::open(name);
+    int constexpr numMessages{2000};
+    auto constexpr timeout = std::chrono::seconds(10);
+
+    std::thread producerThread(
+        [&]()
+        {
+            for (int i = 0; i < numMessages; ++i)
+            {
+                auto const message = makeMessage(i % 300, i);
+                ASSERT_TRUE(producer.write(message.data(), message.size(), timeout));
+            }
+        });
+
+    std::vector<char> received;
+    for (int i = 0; i < numMessages; ++i)
+    {
+        ASSERT_TRUE(consumer.read(received, timeout));
+        ASSERT_EQ(received, makeMessage(i % 300, i));
+    }
+    producerThread.join();
+    EXPECT_FALSE(consumer.tryRead(received));
+}
+
+TEST(ShmRingBuffer, Errors)
+{
+    EXPECT_THROW(ShmRingBuffer::create(uniqueName("capacity"), 100), TllmException);
+    EXPECT_THROW(ShmRingBuffer::open(uniqueName("missing")), TllmException);
+
+    auto const name = uniqueName("unlink");
+    {
+        auto ring = ShmRingBuffer::create(name, 64);
+        EXPECT_THROW(ShmRingBuffer::create(name, 64), TllmException);
+    }
+    // The owner removed the name
+    EXPECT_THROW(ShmRingBuffer::open(name), TllmException);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensorrt_llm/common/timelineTracer.h"
+
+using namespace tensorrt_llm::common::timeline;
+
+namespace
+{
+
+std::size_t countOccurrences(std::string const& str, std::string const& pattern)
+{
+    std::size_t count{0};
+    for (auto pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + pattern.size()))
+    {
+        ++count;
+    }
+    return count;
+}
+
+std::string dumpToString(Tracer const& tracer)
+{
+    std::ostringstream os;
+    tracer.dump(os);
+    return os.str();
+}
+
+} // namespace
+
+TEST(TimelineTracer, DisabledRecordsNothing)
+{
+    Tracer tracer{16};
+    {
+        ScopedEvent event{Category::kScheduling, "schedule", tracer};
+    }
+    EXPECT_EQ(countOccurrences(dumpToString(tracer), "\"ph\":\"X\""), 0);
+}
+
+TEST(TimelineTracer, ChromeTraceFormat)
+{
+    Tracer tracer{16};
+    tracer.setEnabled(true);
+    tracer.record(Category::kDecoderStep, "forwardAsync", 1000, 3500);
+    tracer.record(Category::kMpiBroadcast, "bcast", 4000, 4250);
+
+    auto const trace = dumpToString(tracer);
+    EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+    EXPECT_NE(trace.find("\"name\":\"forwardAsync\",\"cat\":\"decoder_step\",\"ph\":\"X\",\"ts\":1.000,\"dur\":2.500"),
+        std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"bcast\",\"cat\":\"mpi_broadcast\",\"ph\":\"X\",\"ts\":4.000,\"dur\":0.250"),
+        std::string::npos);
+    EXPECT_LT(trace.find("forwardAsync"), trace.find("bcast"));
+}
+
+TEST(TimelineTracer, RingKeepsLatestEvents)
+{
+    Tracer tracer{4};
+    tracer.setEnabled(true);
+    std::vector<std::string> names;
+    for (int i = 0; i < 10; ++i)
+    {
+        names.push_back("event" + std::to_string(i));
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        tracer.record(Category::kScheduling, names[i].c_str(), i, i + 1);
+    }
+
+    auto const trace = dumpToString(tracer);
+    EXPECT_EQ(countOccurrences(trace, "\"ph\":\"X\""), 4);
+    EXPECT_EQ(trace.find("\"event5\""), std::string::npos);
+    for (int i = 6; i < 10; ++i)
+    {
+        EXPECT_NE(trace.find("\"" + names[i] + "\""), std::string::npos);
+    }
+}
+
+TEST(TimelineTracer, ThreadsRecordOnTheirOwnRings)
+{
+    Tracer tracer{1024};
+    tracer.setEnabled(true);
+    auto constexpr numThreads = 4;
+    auto constexpr eventsPerThread = 100;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back(
+            [&tracer]()
+            {
+                for (int i = 0; i < eventsPerThread; ++i)
+                {
+                    ScopedEvent event{Category::kEngineEnqueue, "executeContext", tracer};
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto const trace = dumpToString(tracer);
+    EXPECT_EQ(countOccurrences(trace, "\"ph\":\"X\""), numThreads * eventsPerThread);
+    for (int t = 0; t < numThreads; ++t)
+    {
+        EXPECT_EQ(countOccurrences(trace, "\"tid\":" + std::to_string(t) + "}"), eventsPerThread);
+    }
+}
+
+TEST(TimelineTracer, DumpWhileRecording)
+{
+    Tracer tracer{64};
+    tracer.setEnabled(true);
+    std::atomic<bool> stop{false};
+    std::thread recorder(
+        [&]()
+        {
+            for (std::int64_t i = 0; !stop.load(); ++i)
+            {
+                tracer.record(Category::kResponseDelivery, "sendResponse", i, i + 1);
+            }
+        });
+    for (int i = 0; i < 100; ++i)
+    {
+        auto const trace = dumpToString(tracer);
+        EXPECT_LE(countOccurrences(trace, "\"ph\":\"X\""), 64);
+        EXPECT_EQ(countOccurrences(trace, "\"dur\":0.001"), countOccurrences(trace, "\"ph\":\"X\""));
+    }
+    stop = true;
+    recorder.join();
+}
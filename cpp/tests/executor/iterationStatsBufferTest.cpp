@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/iterationStatsBuffer.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <chrono>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+namespace
+{
+IterationStats makeStats(std::uint64_t iter)
+{
+    IterationStats stats;
+    stats.iter = iter;
+    stats.numActiveRequests = static_cast<SizeType>(iter);
+    return stats;
+}
+} // namespace
+
+TEST(IterationStatsBufferTest, keepsLatestIterations)
+{
+    IterationStatsBuffer buffer(3);
+    EXPECT_EQ(buffer.getCapacity(), 3);
+    for (std::uint64_t iter = 0; iter < 5; ++iter)
+    {
+        buffer.push(makeStats(iter));
+    }
+    EXPECT_EQ(buffer.getNumDropped(), 2);
+
+    auto const stats = buffer.getLatestIterationStats();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats.front().iter, 2);
+    EXPECT_EQ(stats.back().iter, 4);
+    EXPECT_TRUE(buffer.getLatestIterationStats().empty());
+}
+
+TEST(IterationStatsBufferTest, drainReusesOutput)
+{
+    IterationStatsBuffer buffer(4);
+    std::vector<IterationStats> out;
+    out.reserve(4);
+    auto const* data = out.data();
+    buffer.push(makeStats(1));
+    buffer.push(makeStats(2));
+    EXPECT_EQ(buffer.drain(out), 2);
+    EXPECT_EQ(out.data(), data);
+    EXPECT_EQ(out.back().iter, 2);
+    // Waits at most the timeout when nothing is buffered
+    EXPECT_EQ(buffer.drain(out, std::chrono::milliseconds{1}), 0);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(IterationStatsBufferTest, json)
+{
+    IterationStatsBuffer buffer(2);
+    auto stats = makeStats(7);
+    stats.kvCacheStats.usedNumBlocks = 5;
+    stats.inflightBatchingStats.numCtxTokens = 128;
+    buffer.push(stats);
+    auto const json = buffer.getLatestIterationStatsJson();
+    ASSERT_EQ(json.size(), 1);
+    EXPECT_EQ(json.front(), toJson(stats));
+    EXPECT_NE(json.front().find("\"iter\":7,"), std::string::npos);
+    EXPECT_NE(json.front().find("\"usedNumBlocks\":5,"), std::string::npos);
+    EXPECT_NE(json.front().find("\"numCtxTokens\":128,"), std::string::npos);
+    EXPECT_EQ(json.front().front(), '{');
+    EXPECT_EQ(json.front().back(), '}');
+}
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/metricsRegistry.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::executor::metrics
+{
+
+namespace
+{
+testing::AssertionResult contains(std::string const& text, std::string const& line)
+{
+    if (text.find(line) != std::string::npos)
+    {
+        return testing::AssertionSuccess();
+    }
+    return testing::AssertionFailure() << "'" << line << "' not in\n" << text;
+}
+} // namespace
+
+TEST(MetricsRegistryTest, rendersCountersAndGauges)
+{
+    MetricsRegistry registry;
+    auto& counter = registry.getCounter("requests_total", "Requests", "model=\"a\"");
+    counter.increment();
+    counter.increment(2.);
+    // The same name and labels return the same metric
+    EXPECT_EQ(&registry.getCounter("requests_total", "Requests", "model=\"a\""), &counter);
+    registry.getCounter("requests_total", "Requests", "model=\"b\"").increment();
+    auto& gauge = registry.getGauge("queue_depth", "Queued requests");
+    gauge.set(4.);
+    gauge.add(-1.5);
+    EXPECT_THROW(registry.getGauge("requests_total", "Requests"), std::exception);
+
+    auto const text = registry.render();
+    EXPECT_TRUE(contains(text,
+        "# HELP queue_depth Queued requests\n# TYPE queue_depth gauge\nqueue_depth 2.5\n"
+        "# HELP requests_total Requests\n# TYPE requests_total counter\n"
+        "requests_total{model=\"a\"} 3\nrequests_total{model=\"b\"} 1\n"));
+}
+
+TEST(MetricsRegistryTest, rendersHistograms)
+{
+    EXPECT_THROW(Histogram({2., 1.}), std::exception);
+    EXPECT_EQ(Histogram::exponentialBounds(1., 2., 3), (std::vector<double>{1., 2., 4.}));
+
+    MetricsRegistry registry;
+    auto& histogram = registry.getHistogram("latency_seconds", "Latency", {1., 2.}, "op=\"x\"");
+    histogram.observe(0.5);
+    // The bounds are inclusive
+    histogram.observe(2.);
+    histogram.observe(5.);
+    EXPECT_EQ(histogram.getBucketCounts(), (std::vector<std::uint64_t>{1, 1, 1}));
+    EXPECT_DOUBLE_EQ(histogram.getSum(), 7.5);
+
+    auto const text = registry.render();
+    EXPECT_TRUE(contains(text,
+        "latency_seconds_bucket{op=\"x\",le=\"1\"} 1\nlatency_seconds_bucket{op=\"x\",le=\"2\"} 2\n"
+        "latency_seconds_bucket{op=\"x\",le=\"+Inf\"} 3\nlatency_seconds_sum{op=\"x\"} 7.5\n"
+        "latency_seconds_count{op=\"x\"} 3\n"));
+}
+
+TEST(ExecutorMetricsTest, observeIteration)
+{
+    ExecutorMetrics metrics;
+    IterationStats stats;
+    stats.iterLatencyMs = 10.f;
+    stats.numActiveRequests = 3;
+    stats.inflightBatchingStats.numContextRequests = 1;
+    stats.inflightBatchingStats.numGenRequests = 2;
+    stats.inflightBatchingStats.numCtxTokens = 100;
+    stats.specDecodingStats.numDraftTokens = 8;
+    stats.specDecodingStats.numAcceptedTokens = 5;
+    stats.kvCacheStats.reusedBlocks = 5;
+    metrics.observeIteration(stats);
+    // The reused blocks of the stats are cumulative
+    stats.kvCacheStats.reusedBlocks = 8;
+    metrics.observeIteration(stats);
+    metrics.setQueueDepth(7);
+
+    auto const text = metrics.render();
+    EXPECT_TRUE(contains(text, "trtllm_iterations_total 2\n"));
+    EXPECT_TRUE(contains(text, "trtllm_active_requests 3\n"));
+    EXPECT_TRUE(contains(text, "trtllm_queued_requests 7\n"));
+    EXPECT_TRUE(contains(text, "trtllm_context_tokens_total 200\n"));
+    // One token per request plus the accepted drafts
+    EXPECT_TRUE(contains(text, "trtllm_generated_tokens_total 16\n"));
+    EXPECT_TRUE(contains(text, "trtllm_tokens_per_second 10800\n"));
+    EXPECT_TRUE(contains(text, "trtllm_kv_cache_reused_blocks_total 8\n"));
+    EXPECT_TRUE(contains(text, "trtllm_spec_decoding_accepted_tokens_total 10\n"));
+    EXPECT_TRUE(contains(text, "trtllm_iteration_latency_seconds_count 2\n"));
+}
+
+TEST(ExecutorMetricsTest, observeRequest)
+{
+    using namespace std::chrono_literals;
+    ExecutorMetrics metrics;
+    RequestPerfMetrics perfMetrics;
+    perfMetrics.firstScheduledTime = perfMetrics.arrivalTime + 1ms;
+    perfMetrics.firstTokenTime = perfMetrics.arrivalTime + 20ms;
+    metrics.observeRequest(perfMetrics);
+
+    auto const text = metrics.render();
+    EXPECT_TRUE(contains(text, "trtllm_request_queue_time_seconds_count 1\n"));
+    EXPECT_TRUE(contains(text, "trtllm_time_to_first_token_seconds_bucket{le=\"0.02\"} 1\n"));
+    // Latencies that are not known yet are not observed
+    EXPECT_TRUE(contains(text, "trtllm_inter_token_latency_seconds_count 0\n"));
+    EXPECT_TRUE(contains(text, "trtllm_e2e_request_latency_seconds_count 0\n"));
+}
+
+} // namespace tensorrt_llm::executor::metrics
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/requestCheckpoint.h"
+
+#include <list>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+namespace
+{
+RequestCheckpoint createCheckpoint()
+{
+    SamplingConfig const samplingConfig{1, 5, 0.9f, std::nullopt, std::nullopt, std::nullopt, 42, 0.7f, 3};
+    OutputConfig outputConfig;
+    outputConfig.excludeInputFromOutput = true;
+    Request const request{VecTokens{1, 2, 3}, 8, true, samplingConfig, outputConfig, 2, std::nullopt, std::nullopt,
+        std::list<VecTokens>{{7, 8}}};
+    auto checkpoint = RequestCheckpoint::fromRequest(request);
+    checkpoint.generatedTokenIds = {4, 5};
+    checkpoint.numRandomDraws = 2;
+    return checkpoint;
+}
+} // namespace
+
+TEST(RequestCheckpointTest, serializeRoundTrip)
+{
+    auto const checkpoint = createCheckpoint();
+    auto const restored = RequestCheckpoint::deserialize(checkpoint.serialize());
+    EXPECT_EQ(restored.inputTokenIds, checkpoint.inputTokenIds);
+    EXPECT_EQ(restored.generatedTokenIds, checkpoint.generatedTokenIds);
+    EXPECT_EQ(restored.maxNewTokens, 8);
+    EXPECT_TRUE(restored.streaming);
+    EXPECT_EQ(restored.samplingConfig.getTopK(), 5);
+    EXPECT_EQ(restored.samplingConfig.getRandomSeed(), 42);
+    EXPECT_EQ(restored.samplingConfig.getMinLength(), 3);
+    EXPECT_FALSE(restored.samplingConfig.getTopPMin().has_value());
+    EXPECT_TRUE(restored.outputConfig.excludeInputFromOutput);
+    EXPECT_EQ(restored.endId, 2);
+    EXPECT_FALSE(restored.padId.has_value());
+    EXPECT_FALSE(restored.badWords.has_value());
+    ASSERT_TRUE(restored.stopWords.has_value());
+    EXPECT_EQ(restored.stopWords->front(), (VecTokens{7, 8}));
+    EXPECT_EQ(restored.numRandomDraws, 2);
+}
+
+TEST(RequestCheckpointTest, rejectsCorruptBlobs)
+{
+    auto blob = createCheckpoint().serialize();
+    auto truncated = blob;
+    truncated.resize(blob.size() - 1);
+    EXPECT_THROW(static_cast<void>(RequestCheckpoint::deserialize(truncated)), std::exception);
+    auto trailing = blob;
+    trailing.push_back(0);
+    EXPECT_THROW(static_cast<void>(RequestCheckpoint::deserialize(trailing)), std::exception);
+    blob.front() ^= 1;
+    EXPECT_THROW(static_cast<void>(RequestCheckpoint::deserialize(blob)), std::exception);
+}
+
+TEST(RequestCheckpointTest, toResumeRequest)
+{
+    auto checkpoint = createCheckpoint();
+    EXPECT_EQ(checkpoint.getRemainingTokens(), 6);
+    auto const request = checkpoint.toResumeRequest();
+    // The generated tokens are appended to the prompt
+    EXPECT_EQ(request.getInputTokenIds(), (VecTokens{1, 2, 3, 4, 5}));
+    EXPECT_EQ(request.getMaxNewTokens(), 6);
+    auto const samplingConfig = request.getSamplingConfig();
+    EXPECT_EQ(samplingConfig.getMinLength(), 1);
+    // The seed depends on the draws, so a resumed request does not replay the random numbers of the start
+    ASSERT_TRUE(samplingConfig.getRandomSeed().has_value());
+    EXPECT_NE(samplingConfig.getRandomSeed(), 42);
+    EXPECT_EQ(checkpoint.toResumeRequest().getSamplingConfig().getRandomSeed(), samplingConfig.getRandomSeed());
+    EXPECT_EQ(request.getStopWords(), checkpoint.stopWords);
+
+    checkpoint.generatedTokenIds.resize(8, 6);
+    EXPECT_THROW(static_cast<void>(checkpoint.toResumeRequest()), std::exception);
+}
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/requestLatencyTracker.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <chrono>
+
+namespace tensorrt_llm::executor
+{
+
+namespace
+{
+using namespace std::chrono_literals;
+using TimePoint = RequestLatencyTracker::TimePoint;
+} // namespace
+
+TEST(RequestLatencyTrackerTest, requestLifetime)
+{
+    RequestLatencyTracker tracker(16);
+    TimePoint const t0{};
+    tracker.arrive(1, true, t0);
+    tracker.markScheduled(1, t0 + 2ms);
+    tracker.markScheduled(1, t0 + 5ms);
+    tracker.recordTokenStep(1, t0 + 10ms);
+    tracker.recordTokenStep(1, t0 + 14ms);
+    tracker.recordTokenStep(1, t0 + 18ms);
+    EXPECT_EQ(tracker.getNumInFlight(), 1);
+    ASSERT_TRUE(tracker.getPerfMetrics(1).has_value());
+    EXPECT_FALSE(tracker.getPerfMetrics(2).has_value());
+
+    auto const metrics = tracker.complete(1, t0 + 20ms);
+    ASSERT_TRUE(metrics.has_value());
+    EXPECT_EQ(tracker.getNumInFlight(), 0);
+    EXPECT_FLOAT_EQ(metrics->getQueueTimeMs().value(), 2.f);
+    EXPECT_FLOAT_EQ(metrics->getTimeToFirstTokenMs().value(), 10.f);
+    EXPECT_FLOAT_EQ(metrics->getMeanInterTokenLatencyMs().value(), 4.f);
+    EXPECT_FLOAT_EQ(metrics->getEndToEndLatencyMs().value(), 20.f);
+    ASSERT_TRUE(metrics->tokenTimes.has_value());
+    EXPECT_EQ(metrics->tokenTimes->size(), 3);
+
+    auto const stats = tracker.getStats();
+    EXPECT_EQ(stats.endToEndLatencyMs.numSamples, 1);
+    EXPECT_FLOAT_EQ(stats.endToEndLatencyMs.max, 20.f);
+}
+
+TEST(RequestLatencyTrackerTest, untrackedRequests)
+{
+    RequestLatencyTracker tracker;
+    // Events of requests that never arrived are ignored
+    tracker.markScheduled(3);
+    tracker.recordTokenStep(3);
+    EXPECT_FALSE(tracker.complete(3).has_value());
+    EXPECT_EQ(tracker.getNumInFlight(), 0);
+    EXPECT_EQ(tracker.getStats().endToEndLatencyMs.numSamples, 0);
+
+    // Per-token times are only kept on request
+    tracker.arrive(4);
+    tracker.recordTokenStep(4);
+    EXPECT_FALSE(tracker.getPerfMetrics(4)->tokenTimes.has_value());
+}
+
+TEST(RequestLatencyTrackerTest, percentilesOverWindow)
+{
+    RequestLatencyTracker tracker(4);
+    TimePoint const t0{};
+    for (IdType requestId = 0; requestId < 8; ++requestId)
+    {
+        tracker.arrive(requestId, false, t0);
+        tracker.complete(requestId, t0 + std::chrono::milliseconds{requestId + 1});
+    }
+    // Only the last four requests are in the window
+    auto const stats = tracker.getStats();
+    EXPECT_EQ(stats.endToEndLatencyMs.numSamples, 4);
+    EXPECT_FLOAT_EQ(stats.endToEndLatencyMs.p50, 6.f);
+    EXPECT_FLOAT_EQ(stats.endToEndLatencyMs.max, 8.f);
+    EXPECT_EQ(stats.timeToFirstTokenMs.numSamples, 0);
+}
+
+} // namespace tensorrt_llm::executor
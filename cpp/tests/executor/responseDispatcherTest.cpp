@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/responseDispatcher.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+namespace
+{
+// Hands out prepared batches of responses like Executor::awaitResponses
+class FakeResponseSource
+{
+public:
+    void push(std::vector<Response> responses)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBatches.push_back(std::move(responses));
+        mCv.notify_one();
+    }
+
+    std::vector<Response> await(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mCv.wait_for(lock, timeout, [this]() { return !mBatches.empty(); }))
+        {
+            return {};
+        }
+        auto responses = std::move(mBatches.front());
+        mBatches.pop_front();
+        return responses;
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    std::deque<std::vector<Response>> mBatches;
+};
+} // namespace
+
+TEST(ResponseDispatcherTest, dispatchesBatches)
+{
+    FakeResponseSource source;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::vector<IdType>> batches;
+    std::thread::id callbackThread;
+
+    ResponseDispatcher dispatcher([&source](std::chrono::milliseconds timeout) { return source.await(timeout); },
+        [&](std::vector<Response>&& responses)
+        {
+            std::vector<IdType> requestIds;
+            for (auto const& response : responses)
+            {
+                requestIds.push_back(response.getRequestId());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            callbackThread = std::this_thread::get_id();
+            batches.push_back(std::move(requestIds));
+            cv.notify_one();
+        },
+        std::chrono::milliseconds{5});
+
+    source.push({Response{1, "error"}, Response{2, "error"}});
+    source.push({Response{3, "error"}});
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds{10}, [&batches]() { return batches.size() == 2; }));
+    }
+    dispatcher.stop();
+
+    // Responses that became ready together are delivered in one call, from the dispatcher thread
+    EXPECT_EQ(batches, (std::vector<std::vector<IdType>>{{1, 2}, {3}}));
+    EXPECT_NE(callbackThread, std::this_thread::get_id());
+    EXPECT_EQ(dispatcher.getNumBatches(), 2);
+    EXPECT_EQ(dispatcher.getNumResponses(), 3);
+}
+
+TEST(ResponseDispatcherTest, stopWithoutResponses)
+{
+    FakeResponseSource source;
+    auto numCalls = 0;
+    {
+        ResponseDispatcher dispatcher([&source](std::chrono::milliseconds timeout) { return source.await(timeout); },
+            [&numCalls](std::vector<Response>&&) { ++numCalls; }, std::chrono::milliseconds{1});
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        // The destructor stops and joins the dispatcher thread
+    }
+    EXPECT_EQ(numCalls, 0);
+}
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOP_LEVEL_DIR
+#error "Define TOP_LEVEL_DIR"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/ahoCorasick.h"
+#include "tensorrt_llm/kernels/ahoCorasickKernels.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+using Words = std::vector<std::vector<int32_t>>;
+
+bool endsWith(std::vector<int32_t> const& sequence, std::vector<int32_t> const& word)
+{
+    return word.size() <= sequence.size() && std::equal(word.rbegin(), word.rend(), sequence.rbegin());
+}
+
+bool endsWithAny(std::vector<int32_t> const& sequence, Words const& words)
+{
+    return std::any_of(words.begin(), words.end(), [&sequence](auto const& word) { return endsWith(sequence, word); });
+}
+
+Words generateWords(std::mt19937& generator, SizeType numWords, SizeType maxWordLen, SizeType vocabSize)
+{
+    std::uniform_int_distribution<SizeType> lenDistr(1, maxWordLen);
+    std::uniform_int_distribution<SizeType> tokenDistr(0, vocabSize - 1);
+    Words words(numWords);
+    for (auto& word : words)
+    {
+        word.resize(lenDistr(generator));
+        std::generate(word.begin(), word.end(), [&]() { return tokenDistr(generator); });
+    }
+    return words;
+}
+
+TEST(AhoCorasickTest, MatchesWordsList)
+{
+    Words const words{{5, 6}, {6}, {1, 2, 3}, {2, 3, 4}};
+    // [2, wordsLen] layout of bad and stop words lists: tokens followed by the end offsets of the words
+    std::vector<int32_t> const wordsList{5, 6, 6, 1, 2, 3, 2, 3, 4, 2, 3, 6, 9, -1, -1, -1, -1, -1};
+    auto const fromWords = tk::buildAhoCorasick(words);
+    auto const fromWordsList = tk::buildAhoCorasickFromWordsList(wordsList.data(), 9);
+    EXPECT_EQ(fromWords, fromWordsList);
+
+    tk::AhoCorasickView const automaton{fromWords.data()};
+    auto state = tk::AhoCorasickView::kRootState;
+    std::vector<int32_t> matchLengths;
+    for (auto const token : {1, 2, 3, 4, 5, 6})
+    {
+        state = automaton.next(state, token);
+        matchLengths.push_back(automaton.getMatchLength(state));
+    }
+    EXPECT_EQ(matchLengths, (std::vector<int32_t>{0, 0, 3, 3, 0, 2}));
+}
+
+class AhoCorasickKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = tensorrt_llm::runtime::ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    void runTest(SizeType batchSize, SizeType vocabSize, SizeType numWords, SizeType maxWordLen, SizeType numSteps)
+    {
+        auto const maxBatchSize = 2 * batchSize;
+        auto const vocabSizePadded = vocabSize + 3;
+        auto const maxSeqLen = numSteps;
+
+        std::mt19937 generator(42);
+        std::vector<Words> stopWords(maxBatchSize);
+        std::vector<Words> badWords(maxBatchSize);
+        std::vector<TensorPtr> automata;
+
+        auto stopWordsAutomata
+            = mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), TRTDataType<int32_t*>::value);
+        auto badWordsAutomata
+            = mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), TRTDataType<int32_t*>::value);
+        auto states = mBufferManager->pinned(
+            ITensor::makeShape({maxBatchSize, tk::kNumWordsAutomata}), nvinfer1::DataType::kINT32);
+        auto outputIds
+            = mBufferManager->pinned(ITensor::makeShape({maxBatchSize, maxSeqLen}), nvinfer1::DataType::kINT32);
+        auto outputIdsPtrs = mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), TRTDataType<int32_t*>::value);
+        auto sequenceLengths = mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+        auto finished = mBufferManager->pinned(
+            ITensor::makeShape({maxBatchSize}), TRTDataType<tk::FinishedState::UnderlyingType>::value);
+        auto batchSlots = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto logits
+            = mBufferManager->pinned(ITensor::makeShape({batchSize, vocabSizePadded}), nvinfer1::DataType::kFLOAT);
+
+        auto stopWordsAutomataPtr = BufferRange<int32_t*>(*stopWordsAutomata);
+        auto badWordsAutomataPtr = BufferRange<int32_t*>(*badWordsAutomata);
+        auto outputIdsPtrsPtr = BufferRange<int32_t*>(*outputIdsPtrs);
+        auto batchSlotsPtr = bufferCast<SizeType>(*batchSlots);
+        auto sequenceLengthsPtr = bufferCast<SizeType>(*sequenceLengths);
+        auto finishedPtr
+            = reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*finished));
+        auto logitsPtr = bufferCast<float>(*logits);
+        std::fill_n(bufferCast<int32_t>(*states), states->getSize(), 0);
+
+        auto makeAutomaton = [this, &automata](Words const& words)
+        {
+            auto const data = tk::buildAhoCorasick(words);
+            TensorPtr automaton = mBufferManager->pinned(
+                ITensor::makeShape({static_cast<SizeType>(data.size())}), nvinfer1::DataType::kINT32);
+            std::copy(data.begin(), data.end(), bufferCast<int32_t>(*automaton));
+            automata.push_back(automaton);
+            return bufferCast<int32_t>(*automaton);
+        };
+
+        for (SizeType bi = 0; bi < maxBatchSize; ++bi)
+        {
+            outputIdsPtrsPtr[bi] = bufferCast<int32_t>(*outputIds) + bi * maxSeqLen;
+            sequenceLengthsPtr[bi] = 0;
+            finishedPtr[bi] = tk::FinishedState::empty();
+            // Every third request has no bad words and every fourth no stop words
+            stopWordsAutomataPtr[bi] = nullptr;
+            badWordsAutomataPtr[bi] = nullptr;
+            if (bi % 4 != 3)
+            {
+                stopWords[bi] = generateWords(generator, numWords, maxWordLen, vocabSize);
+                stopWordsAutomataPtr[bi] = makeAutomaton(stopWords[bi]);
+            }
+            if (bi % 3 != 2)
+            {
+                // Few short words to ban a fair share of the vocabulary
+                badWords[bi] = generateWords(generator, std::max(numWords / 8, 1), 2, vocabSize);
+                badWordsAutomataPtr[bi] = makeAutomaton(badWords[bi]);
+            }
+        }
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            batchSlotsPtr[bi] = 2 * bi + 1;
+        }
+
+        std::vector<std::vector<int32_t>> sequences(maxBatchSize);
+        std::uniform_int_distribution<SizeType> tokenDistr(0, vocabSize - 1);
+        for (SizeType step = 0; step < numSteps; ++step)
+        {
+            std::fill_n(logitsPtr, logits->getSize(), 0.f);
+            tk::invokeBanBadWordsAhoCorasick(logitsPtr, badWordsAutomataPtr.begin(), bufferCast<int32_t>(*states),
+                batchSlotsPtr, batchSize, vocabSizePadded, mStream->get());
+            mStream->synchronize();
+
+            for (SizeType bi = 0; bi < batchSize; ++bi)
+            {
+                auto const batchSlot = batchSlotsPtr[bi];
+                auto& sequence = sequences[batchSlot];
+                std::vector<int32_t> allowedTokens;
+                for (SizeType vi = 0; vi < vocabSize; ++vi)
+                {
+                    sequence.push_back(vi);
+                    auto const refBanned = endsWithAny(sequence, badWords[batchSlot]);
+                    sequence.pop_back();
+                    auto const banned = std::isinf(logitsPtr[bi * vocabSizePadded + vi]);
+                    EXPECT_EQ(banned, refBanned) << "step " << step << " bi " << bi << " token " << vi;
+                    if (!banned)
+                    {
+                        allowedTokens.push_back(vi);
+                    }
+                }
+                if (finishedPtr[batchSlot].isFinished())
+                {
+                    continue;
+                }
+                // Sample mostly allowed tokens, sometimes any token to also advance through bad words
+                auto const token = allowedTokens.empty() || step % 5 == 4
+                    ? tokenDistr(generator)
+                    : allowedTokens[std::uniform_int_distribution<size_t>(0, allowedTokens.size() - 1)(generator)];
+                sequence.push_back(token);
+                outputIdsPtrsPtr[batchSlot][sequenceLengthsPtr[batchSlot]] = token;
+                ++sequenceLengthsPtr[batchSlot];
+            }
+
+            tk::invokeAdvanceWordsAutomata(stopWordsAutomataPtr.begin(), badWordsAutomataPtr.begin(),
+                bufferCast<int32_t>(*states), const_cast<int32_t const**>(outputIdsPtrsPtr.begin()), finishedPtr,
+                sequenceLengthsPtr, batchSlotsPtr, batchSize, mStream->get());
+            mStream->synchronize();
+
+            for (SizeType bi = 0; bi < batchSize; ++bi)
+            {
+                auto const batchSlot = batchSlotsPtr[bi];
+                auto const refFinished = endsWithAny(sequences[batchSlot], stopWords[batchSlot]);
+                if (refFinished)
+                {
+                    EXPECT_TRUE(finishedPtr[batchSlot].isFinishedStopWords()) << "step " << step << " bi " << bi;
+                }
+                else
+                {
+                    EXPECT_FALSE(finishedPtr[batchSlot].isFinished()) << "step " << step << " bi " << bi;
+                }
+            }
+        }
+
+        // Requests outside of the batch are untouched
+        for (SizeType bi = 0; bi < maxBatchSize; bi += 2)
+        {
+            EXPECT_EQ(sequenceLengthsPtr[bi], 0);
+            EXPECT_FALSE(finishedPtr[bi].isFinished());
+        }
+    }
+
+protected:
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+};
+
+TEST_F(AhoCorasickKernelsTest, FewWords)
+{
+    this->runTest(/* batchSize */ 4, /* vocabSize */ 8, /* numWords */ 3, /* maxWordLen */ 3, /* numSteps */ 32);
+}
+
+TEST_F(AhoCorasickKernelsTest, ManyWords)
+{
+    this->runTest(/* batchSize */ 6, /* vocabSize */ 16, /* numWords */ 64, /* maxWordLen */ 6, /* numSteps */ 64);
+}
+
+} // end of namespace
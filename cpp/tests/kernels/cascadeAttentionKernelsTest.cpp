@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/cascadeAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+TEST(CascadeAttentionPlanTest, groupsSharedPrefixes)
+{
+    // Sequences 0, 2 and 3 share blocks {7, 8}, sequence 3 diverges after them. Sequence 1 shares nothing and
+    // sequence 4 only shares the block of its current token with sequence 5.
+    std::vector<std::vector<int32_t>> const seqBlockIds{
+        {7, 8, 9, 10}, {1, 2}, {7, 8, 9, 11}, {7, 8, 12}, {20}, {20}};
+    std::vector<int32_t> const seqLens{14, 6, 13, 9, 3, 3};
+
+    auto const plan = tk::buildCascadeAttentionPlan(seqBlockIds, seqLens, 4);
+
+    // Sequences 0 and 2 could share 3 blocks but sequence 3 limits the group to 2.
+    ASSERT_EQ(plan.getNumGroups(), 1);
+    EXPECT_EQ(plan.groupKvSeqIdx, (std::vector<int32_t>{0}));
+    EXPECT_EQ(plan.groupPrefixLens, (std::vector<int32_t>{8}));
+    EXPECT_EQ(plan.groupQueryOffsets, (std::vector<int32_t>{0, 3}));
+    EXPECT_EQ(plan.groupQuerySeqIdx, (std::vector<int32_t>{0, 2, 3}));
+    EXPECT_EQ(plan.seqPrefixLens, (std::vector<int32_t>{8, 0, 8, 8, 0, 0}));
+    EXPECT_EQ(plan.maxGroupSize, 3);
+}
+
+TEST(CascadeAttentionPlanTest, keepsCurrentTokenInSuffix)
+{
+    // Both sequences fill exactly two blocks, the second holds the current token and is not shared.
+    std::vector<std::vector<int32_t>> const seqBlockIds{{3, 4}, {3, 4}};
+    std::vector<int32_t> const seqLens{8, 8};
+
+    auto const plan = tk::buildCascadeAttentionPlan(seqBlockIds, seqLens, 4);
+
+    EXPECT_EQ(plan.groupPrefixLens, (std::vector<int32_t>{4}));
+    EXPECT_EQ(plan.seqPrefixLens, (std::vector<int32_t>{4, 4}));
+    EXPECT_EQ(tk::buildCascadeAttentionPlan(seqBlockIds, seqLens, 4, 2).getNumGroups(), 0);
+    EXPECT_EQ(tk::buildCascadeAttentionPlan(seqBlockIds, seqLens, 4, 1, 3).getNumGroups(), 0);
+}
+
+class CascadeAttentionKernelTest : public testing::Test
+{
+public:
+    using TensorPtr = tensorrt_llm::runtime::ITensor::SharedPtr;
+
+    static auto constexpr kNumSeqs = 4;
+    static auto constexpr kNumQHeads = 4;
+    static auto constexpr kNumKVHeads = 2;
+    static auto constexpr kHeadSize = 64;
+    static auto constexpr kMaxSeqLen = 48;
+    static auto constexpr kTokensPerBlock = 8;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    TensorPtr pinnedInt(std::vector<int32_t> const& values)
+    {
+        TensorPtr tensor = mBufferManager->pinned(
+            ITensor::makeShape({static_cast<SizeType>(std::max<size_t>(values.size(), 1))}),
+            nvinfer1::DataType::kINT32);
+        std::copy(values.begin(), values.end(), bufferCast<int32_t>(*tensor));
+        return tensor;
+    }
+
+    //! \brief Index of a KV cache element in the linear cache, [seq, 2, kvHeads, maxSeqLen, headSize].
+    static size_t kvIndex(int seq, int kv, int head, int pos, int channel)
+    {
+        return (((static_cast<size_t>(seq) * 2 + kv) * kNumKVHeads + head) * kMaxSeqLen + pos) * kHeadSize + channel;
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(CascadeAttentionKernelTest, matchesReferenceAttention)
+{
+    // Sequences 0, 1 and 3 share a prefix of 32 tokens, sequence 2 has its own KV cache.
+    std::vector<std::vector<int32_t>> const seqBlockIds{
+        {0, 1, 2, 3, 4, 5}, {0, 1, 2, 3, 6}, {10, 11, 12}, {0, 1, 2, 3, 7, 8}};
+    std::vector<int32_t> const seqLens{41, 37, 20, 48};
+    auto const plan = tk::buildCascadeAttentionPlan(seqBlockIds, seqLens, kTokensPerBlock);
+    ASSERT_EQ(plan.getNumGroups(), 1);
+    ASSERT_EQ(plan.groupPrefixLens[0], 32);
+
+    auto const pseudoRandom = [](size_t idx) { return static_cast<float>((idx * 2654435761u) % 1000) / 500.f - 1.f; };
+
+    auto kvCache = mBufferManager->pinned(
+        ITensor::makeShape({static_cast<SizeType>(kvIndex(kNumSeqs, 0, 0, 0, 0))}), nvinfer1::DataType::kFLOAT);
+    auto* kvPtr = bufferCast<float>(*kvCache);
+    for (int seq = 0; seq < kNumSeqs; ++seq)
+    {
+        for (int kv = 0; kv < 2; ++kv)
+        {
+            for (int head = 0; head < kNumKVHeads; ++head)
+            {
+                for (int pos = 0; pos < kMaxSeqLen; ++pos)
+                {
+                    // Tokens of shared blocks hold the same values in every sequence.
+                    auto const owner = pos < plan.seqPrefixLens[seq] ? plan.groupKvSeqIdx[0] : seq;
+                    for (int channel = 0; channel < kHeadSize; ++channel)
+                    {
+                        kvPtr[kvIndex(seq, kv, head, pos, channel)]
+                            = pseudoRandom(kvIndex(owner, kv, head, pos, channel));
+                    }
+                }
+            }
+        }
+    }
+
+    auto const qSize = static_cast<SizeType>(kNumSeqs * kNumQHeads * kHeadSize);
+    auto q = mBufferManager->pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+    auto output = mBufferManager->pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+    auto* qPtr = bufferCast<float>(*q);
+    for (SizeType idx = 0; idx < qSize; ++idx)
+    {
+        qPtr[idx] = pseudoRandom(idx + 12345);
+    }
+
+    auto groupKvSeqIdx = pinnedInt(plan.groupKvSeqIdx);
+    auto groupPrefixLens = pinnedInt(plan.groupPrefixLens);
+    auto groupQueryOffsets = pinnedInt(plan.groupQueryOffsets);
+    auto groupQuerySeqIdx = pinnedInt(plan.groupQuerySeqIdx);
+    auto seqPrefixLens = pinnedInt(plan.seqPrefixLens);
+    auto seqLensTensor = pinnedInt(seqLens);
+    auto workspace = mBufferManager->gpu(
+        tk::getCascadeAttentionWorkspaceSize(kNumSeqs, kNumQHeads, kHeadSize), nvinfer1::DataType::kINT8);
+
+    auto const softmaxScale = 1.f / std::sqrt(static_cast<float>(kHeadSize));
+    tk::CascadeAttentionParams params{};
+    params.q = q->data();
+    params.output = output->data();
+    params.groupKvSeqIdx = bufferCast<int32_t>(*groupKvSeqIdx);
+    params.groupPrefixLens = bufferCast<int32_t>(*groupPrefixLens);
+    params.groupQueryOffsets = bufferCast<int32_t>(*groupQueryOffsets);
+    params.groupQuerySeqIdx = bufferCast<int32_t>(*groupQuerySeqIdx);
+    params.seqPrefixLens = bufferCast<int32_t>(*seqPrefixLens);
+    params.seqLens = bufferCast<int32_t>(*seqLensTensor);
+    params.workspace = workspace->data();
+    params.numSeqs = kNumSeqs;
+    params.numGroups = plan.getNumGroups();
+    params.maxGroupSize = plan.maxGroupSize;
+    params.numQHeads = kNumQHeads;
+    params.numKVHeads = kNumKVHeads;
+    params.headSize = kHeadSize;
+    params.softmaxScale = softmaxScale;
+
+    tk::KVLinearBuffer kvCacheBuffer(
+        kNumSeqs, 1, kMaxSeqLen, kNumKVHeads * kHeadSize * static_cast<int32_t>(sizeof(float)), kMaxSeqLen, 0, false);
+    kvCacheBuffer.data = static_cast<int8_t*>(kvCache->data());
+
+    tk::invokeCascadeAttention<float>(params, kvCacheBuffer, mStream->get());
+    mStream->synchronize();
+
+    auto const* outputPtr = bufferCast<float>(*output);
+    for (int seq = 0; seq < kNumSeqs; ++seq)
+    {
+        for (int qHead = 0; qHead < kNumQHeads; ++qHead)
+        {
+            auto const kvHead = qHead / (kNumQHeads / kNumKVHeads);
+            auto const* qRow = qPtr + (seq * kNumQHeads + qHead) * kHeadSize;
+            std::vector<float> scores(seqLens[seq]);
+            for (int pos = 0; pos < seqLens[seq]; ++pos)
+            {
+                float score = 0.f;
+                for (int channel = 0; channel < kHeadSize; ++channel)
+                {
+                    score += qRow[channel] * kvPtr[kvIndex(seq, 0, kvHead, pos, channel)];
+                }
+                scores[pos] = score * softmaxScale;
+            }
+            auto const maxScore = *std::max_element(scores.begin(), scores.end());
+            float sum = 0.f;
+            for (auto& score : scores)
+            {
+                score = std::exp(score - maxScore);
+                sum += score;
+            }
+            for (int channel = 0; channel < kHeadSize; ++channel)
+            {
+                float expected = 0.f;
+                for (int pos = 0; pos < seqLens[seq]; ++pos)
+                {
+                    expected += scores[pos] / sum * kvPtr[kvIndex(seq, 1, kvHead, pos, channel)];
+                }
+                EXPECT_NEAR(outputPtr[(seq * kNumQHeads + qHead) * kHeadSize + channel], expected, 1e-4)
+                    << "seq " << seq << " head " << qHead << " channel " << channel;
+            }
+        }
+    }
+}
+
+} // namespace
@@ -153,7 +153,7 @@ public:
         mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
         mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
 
-        cudaMalloc(&mCurandStates, sizeof(curandState_t) * maxBatchSize);
+        cudaMalloc(&mCurandStates, sizeof(tk::PhiloxState) * maxBatchSize);
     }
 
     void TearDown() override
@@ -500,7 +500,7 @@ protected:
     std::vector<int> mOutputLen;
     std::vector<tk::FinishedState> mAcceptedFinished;
 
-    curandState_t* mCurandStates;
+    tk::PhiloxState* mCurandStates;
 
     static constexpr SizeType batchSize{128};
     static constexpr SizeType maxBatchSize{2 * batchSize};
@@ -535,4 +535,56 @@ TYPED_TEST(DecodingKernelsTest, acceptDraftTokensByLogitsKernel)
     }
 }
 
+TEST(ActiveSlotsTest, compactActiveSlots)
+{
+    auto const stream = std::make_shared<CudaStream>();
+    BufferManager manager(stream);
+
+    // More requests than threads of the compaction block, in reverse slot order
+    SizeType constexpr batchSize{500};
+    SizeType constexpr maxBatchSize{600};
+    auto finishedHost = manager.pinned(
+        ITensor::makeShape({maxBatchSize}), TRTDataType<tk::FinishedState::UnderlyingType>::value);
+    auto batchSlotsHost = manager.pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+    auto finishedPtr
+        = reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*finishedHost));
+    auto batchSlotsPtr = bufferCast<SizeType>(*batchSlotsHost);
+    std::vector<SizeType> expected;
+    for (SizeType bi = 0; bi < batchSize; ++bi)
+    {
+        batchSlotsPtr[bi] = maxBatchSize - 1 - bi;
+    }
+    for (SizeType slot = 0; slot < maxBatchSize; ++slot)
+    {
+        finishedPtr[slot] = slot % 3 == 0 ? tk::FinishedState::finishedEOS() : tk::FinishedState::empty();
+    }
+    for (SizeType bi = 0; bi < batchSize; ++bi)
+    {
+        if (batchSlotsPtr[bi] % 3 != 0)
+        {
+            expected.push_back(bi);
+        }
+    }
+
+    auto finished = manager.copyFrom(*finishedHost, MemoryType::kGPU);
+    auto batchSlots = manager.copyFrom(*batchSlotsHost, MemoryType::kGPU);
+    auto activeSlots = manager.gpu(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+    auto numActiveSlots = manager.gpu(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+    tk::invokeCompactActiveSlots(bufferCast<SizeType>(*activeSlots), bufferCast<SizeType>(*numActiveSlots),
+        reinterpret_cast<tk::FinishedState const*>(bufferCast<tk::FinishedState::UnderlyingType>(*finished)),
+        bufferCast<SizeType>(*batchSlots), batchSize, 1, stream->get());
+
+    auto activeSlotsHost = manager.copyFrom(*activeSlots, MemoryType::kCPU);
+    auto numActiveSlotsHost = manager.copyFrom(*numActiveSlots, MemoryType::kCPU);
+    stream->synchronize();
+
+    auto const numActive = *bufferCast<SizeType>(*numActiveSlotsHost);
+    ASSERT_EQ(numActive, static_cast<SizeType>(expected.size()));
+    auto const activeSlotsPtr = bufferCast<SizeType>(*activeSlotsHost);
+    for (SizeType ai = 0; ai < numActive; ++ai)
+    {
+        EXPECT_EQ(activeSlotsPtr[ai], expected[ai]) << "ai: " << ai;
+    }
+}
+
 } // end of namespace
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/gqaGenerationAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cuda_fp16.h>
+#include <type_traits>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+namespace tc = tensorrt_llm::common;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class GQAGenerationAttentionKernelTest : public testing::Test
+{
+public:
+    static auto constexpr kMaxSeqLen = 160;
+    // Dequantization scale of the INT8 cache.
+    static auto constexpr kInt8Scale = 1.f / 127.f;
+
+    void SetUp() override
+    {
+        if (!tk::isGQAGenerationAttentionSupported(false, 64, tc::getSMVersion()))
+        {
+            GTEST_SKIP() << "The GQA generation attention kernels need tensor cores";
+        }
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    template <typename TCache>
+    void runTest(int32_t numQHeads, int32_t numKVHeads, int32_t headSize, std::vector<int32_t> const& seqLens,
+        int32_t windowSize)
+    {
+        auto constexpr kQuantized = std::is_same_v<TCache, int8_t>;
+        auto const batchSize = static_cast<int32_t>(seqLens.size());
+        auto const pseudoRandom
+            = [](size_t idx) { return static_cast<float>((idx * 2654435761u) % 1000) / 500.f - 1.f; };
+
+        // Linear cache, [batchSize, 2, numKVHeads, kMaxSeqLen, headSize]
+        auto const kvIndex = [&](int seq, int kv, int head, int pos, int channel)
+        {
+            return (((static_cast<size_t>(seq) * 2 + kv) * numKVHeads + head) * kMaxSeqLen + pos) * headSize + channel;
+        };
+        auto const kvSize = kvIndex(batchSize, 0, 0, 0, 0);
+        auto kvCache = mBufferManager->pinned(ITensor::makeShape({static_cast<SizeType>(kvSize)}),
+            kQuantized ? nvinfer1::DataType::kINT8 : nvinfer1::DataType::kHALF);
+        auto* kvPtr = bufferCast<TCache>(*kvCache);
+        // Values as the kernel sees them after dequantization.
+        std::vector<float> kvValues(kvSize);
+        for (size_t idx = 0; idx < kvSize; ++idx)
+        {
+            if constexpr (kQuantized)
+            {
+                kvPtr[idx] = static_cast<int8_t>(static_cast<int>((idx * 40503u) % 255) - 127);
+                kvValues[idx] = static_cast<float>(kvPtr[idx]) * kInt8Scale;
+            }
+            else
+            {
+                kvPtr[idx] = __float2half(pseudoRandom(idx));
+                kvValues[idx] = __half2float(kvPtr[idx]);
+            }
+        }
+
+        auto const qSize = static_cast<SizeType>(batchSize * numQHeads * headSize);
+        auto q = mBufferManager->pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kHALF);
+        auto output = mBufferManager->pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kHALF);
+        auto* qPtr = bufferCast<half>(*q);
+        for (SizeType idx = 0; idx < qSize; ++idx)
+        {
+            qPtr[idx] = __float2half(pseudoRandom(idx + 12345));
+        }
+        auto seqLensTensor = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        std::copy(seqLens.begin(), seqLens.end(), bufferCast<int32_t>(*seqLensTensor));
+        auto kvScale = mBufferManager->pinned(ITensor::makeShape({1}), nvinfer1::DataType::kFLOAT);
+        *bufferCast<float>(*kvScale) = kInt8Scale;
+
+        auto const softmaxScale = 1.f / std::sqrt(static_cast<float>(headSize));
+        tk::GQAGenerationAttentionParams params{};
+        params.q = q->data();
+        params.output = output->data();
+        params.seqLens = bufferCast<int32_t>(*seqLensTensor);
+        params.kvScaleQuantOrig = kQuantized ? bufferCast<float>(*kvScale) : nullptr;
+        params.batchSize = batchSize;
+        params.numQHeads = numQHeads;
+        params.numKVHeads = numKVHeads;
+        params.headSize = headSize;
+        params.cyclicAttentionWindowSize = windowSize;
+        params.softmaxScale = softmaxScale;
+
+        tk::KVLinearBuffer kvCacheBuffer(batchSize, 1, kMaxSeqLen,
+            numKVHeads * headSize * static_cast<int32_t>(sizeof(TCache)), windowSize, 0, false);
+        kvCacheBuffer.data = static_cast<int8_t*>(kvCache->data());
+
+        tk::invokeGQAGenerationAttention<half, TCache>(params, kvCacheBuffer, mStream->get());
+        mStream->synchronize();
+
+        auto const* outputPtr = bufferCast<half>(*output);
+        for (int seq = 0; seq < batchSize; ++seq)
+        {
+            // Logical token pos of a cyclic cache is stored at pos % windowSize.
+            auto const begin = std::max(0, seqLens[seq] - windowSize);
+            for (int qHead = 0; qHead < numQHeads; ++qHead)
+            {
+                auto const kvHead = qHead / (numQHeads / numKVHeads);
+                auto const* qRow = qPtr + (seq * numQHeads + qHead) * headSize;
+                std::vector<float> scores;
+                for (int pos = begin; pos < seqLens[seq]; ++pos)
+                {
+                    float score = 0.f;
+                    for (int channel = 0; channel < headSize; ++channel)
+                    {
+                        score += __half2float(qRow[channel])
+                            * kvValues[kvIndex(seq, 0, kvHead, pos % windowSize, channel)];
+                    }
+                    scores.push_back(score * softmaxScale);
+                }
+                auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                float sum = 0.f;
+                for (auto& score : scores)
+                {
+                    score = std::exp(score - maxScore);
+                    sum += score;
+                }
+                for (int channel = 0; channel < headSize; ++channel)
+                {
+                    float expected = 0.f;
+                    for (int pos = begin; pos < seqLens[seq]; ++pos)
+                    {
+                        expected += scores[pos - begin] / sum
+                            * kvValues[kvIndex(seq, 1, kvHead, pos % windowSize, channel)];
+                    }
+                    // Q, K, V and the probabilities go through FP16.
+                    EXPECT_NEAR(__half2float(outputPtr[(seq * numQHeads + qHead) * headSize + channel]), expected,
+                        2e-2)
+                        << "seq " << seq << " head " << qHead << " channel " << channel;
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(GQAGenerationAttentionKernelTest, fp16Cache)
+{
+    for (auto const headSize : {32, 64, 128, 256})
+    {
+        runTest<half>(16, 2, headSize, {1, 77, 160, 130}, kMaxSeqLen);
+    }
+}
+
+TEST_F(GQAGenerationAttentionKernelTest, moreHeadsPerKvThanMmaRows)
+{
+    // 20 query heads per KV head are split into a full and a partial 16-row tile.
+    runTest<half>(40, 2, 128, {50, 160}, kMaxSeqLen);
+}
+
+TEST_F(GQAGenerationAttentionKernelTest, cyclicCache)
+{
+    runTest<half>(8, 1, 64, {150, 40}, 64);
+}
+
+TEST_F(GQAGenerationAttentionKernelTest, int8Cache)
+{
+    runTest<int8_t>(8, 2, 128, {100, 33}, kMaxSeqLen);
+}
+
+} // namespace
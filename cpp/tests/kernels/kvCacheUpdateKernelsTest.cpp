@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/parallelDecoding/kvCacheUpdateKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class AcceptDraftTokensAndUpdateKVCacheTest : public testing::Test
+{
+public:
+    using TensorPtr = tensorrt_llm::runtime::ITensor::SharedPtr;
+
+    static auto constexpr kLayerCount = 2;
+    static auto constexpr kSeqCount = 2;
+    static auto constexpr kNumKVHeads = 2;
+    static auto constexpr kEltsPerHead = 4;
+    static auto constexpr kMaxKVCacheLen = 16;
+    static auto constexpr kMaxDraftTokens = 4;
+    static auto constexpr kMaxNumPaths = 2;
+    static auto constexpr kMaxPathLen = 3;
+    static auto constexpr kMaxSeqLen = 16;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    //! \brief Value stored at a KV cache element, unique per element.
+    static int32_t kvValue(int layer, int seq, int kv, int head, int pos, int elt)
+    {
+        return ((((layer * kSeqCount + seq) * 2 + kv) * kNumKVHeads + head) * kMaxKVCacheLen + pos) * kEltsPerHead
+            + elt;
+    }
+
+    //! \brief Index of a KV cache element in the linear cache of a layer, [seq, 2, heads, maxKVCacheLen, elts].
+    static std::size_t kvIndex(int seq, int kv, int head, int pos, int elt)
+    {
+        return (((seq * 2 + kv) * kNumKVHeads + head) * kMaxKVCacheLen + pos) * kEltsPerHead + elt;
+    }
+
+    //! \brief Call func(seq, kv, head, pos, elt) for every element of the cache of one layer.
+    template <typename Func>
+    static void forEachElement(Func&& func)
+    {
+        for (int idx = 0; idx < kSeqCount * 2 * kNumKVHeads * kMaxKVCacheLen * kEltsPerHead; ++idx)
+        {
+            auto const elt = idx % kEltsPerHead;
+            auto const pos = idx / kEltsPerHead % kMaxKVCacheLen;
+            auto const head = idx / (kEltsPerHead * kMaxKVCacheLen) % kNumKVHeads;
+            auto const kv = idx / (kEltsPerHead * kMaxKVCacheLen * kNumKVHeads) % 2;
+            auto const seq = idx / (kEltsPerHead * kMaxKVCacheLen * kNumKVHeads * 2);
+            func(seq, kv, head, pos, elt);
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(AcceptDraftTokensAndUpdateKVCacheTest, linearKVCache)
+{
+    auto const pinnedInt = [this](std::vector<int32_t> const& values)
+    {
+        TensorPtr tensor = mBufferManager->pinned(
+            ITensor::makeShape({static_cast<SizeType>(values.size())}), nvinfer1::DataType::kINT32);
+        std::copy(values.begin(), values.end(), bufferCast<int32_t>(*tensor));
+        return tensor;
+    };
+
+    // Sequence 0 verifies a tree with paths {10, 11} and {20, 21}, the second one is accepted entirely.
+    // Sequence 1 verifies the linear drafts {5, 6, 7}, the first two are accepted.
+    auto draftIds = pinnedInt({10, 11, 20, 21, 5, 6, 7, 0});
+    auto targetIds = pinnedInt({20, 0, 0, 21, 99, 5, 6, 8, 0, 0});
+    auto paths = pinnedInt({0, 1, -1, 2, 3, -1, 0, 1, 2, -1, -1, -1});
+    auto pastKeyValueLengths = pinnedInt({3, 5});
+    auto sequenceLengths = pinnedInt({7, 9});
+    auto numAcceptedTokens = pinnedInt({-1, -1});
+    auto outputIds = pinnedInt(std::vector<int32_t>(kSeqCount * kMaxSeqLen, 0));
+
+    auto const layerSize = static_cast<SizeType>(kSeqCount * 2 * kNumKVHeads * kMaxKVCacheLen * kEltsPerHead);
+    std::vector<TensorPtr> kvCaches;
+    std::vector<int8_t*> kvCachePtrs;
+    for (int layer = 0; layer < kLayerCount; ++layer)
+    {
+        kvCaches.emplace_back(mBufferManager->pinned(ITensor::makeShape({layerSize}), nvinfer1::DataType::kINT32));
+        auto* kvPtr = bufferCast<int32_t>(*kvCaches.back());
+        forEachElement([&](int seq, int kv, int head, int pos, int elt)
+            { kvPtr[kvIndex(seq, kv, head, pos, elt)] = kvValue(layer, seq, kv, head, pos, elt); });
+        kvCachePtrs.push_back(static_cast<int8_t*>(kvCaches.back()->data()));
+    }
+
+    tk::parallel_decoding::AcceptDraftTokensParams params{};
+    params.draftIds = bufferCast<int32_t>(*draftIds);
+    params.targetIds = bufferCast<int32_t>(*targetIds);
+    params.paths = bufferCast<int32_t>(*paths);
+    params.pastKeyValueLengths = bufferCast<int32_t>(*pastKeyValueLengths);
+    params.batchSlots = nullptr;
+    params.outputIds = bufferCast<int32_t>(*outputIds);
+    params.sequenceLengths = bufferCast<int32_t>(*sequenceLengths);
+    params.numAcceptedTokens = bufferCast<int32_t>(*numAcceptedTokens);
+    params.maxDraftTokens = kMaxDraftTokens;
+    params.maxNumPaths = kMaxNumPaths;
+    params.maxPathLen = kMaxPathLen;
+    params.maxSeqLen = kMaxSeqLen;
+
+    tk::parallel_decoding::acceptDraftTokensAndUpdateLinearKVCache(params, kvCachePtrs.data(), kLayerCount, kSeqCount,
+        kNumKVHeads, kEltsPerHead * sizeof(int32_t), kMaxKVCacheLen, mStream->get());
+    mStream->synchronize();
+
+    EXPECT_EQ(bufferCast<int32_t>(*numAcceptedTokens)[0], 2);
+    EXPECT_EQ(bufferCast<int32_t>(*numAcceptedTokens)[1], 2);
+    EXPECT_EQ(bufferCast<int32_t>(*sequenceLengths)[0], 10);
+    EXPECT_EQ(bufferCast<int32_t>(*sequenceLengths)[1], 12);
+    auto const* outputPtr = bufferCast<int32_t>(*outputIds);
+    EXPECT_EQ(std::vector<int32_t>(outputPtr + 7, outputPtr + 10), (std::vector<int32_t>{20, 21, 99}));
+    EXPECT_EQ(std::vector<int32_t>(outputPtr + kMaxSeqLen + 9, outputPtr + kMaxSeqLen + 12),
+        (std::vector<int32_t>{5, 6, 8}));
+
+    // Sequence 0 moves draft tokens 2 and 3 to the positions of draft tokens 0 and 1, sequence 1 keeps its KV.
+    for (int layer = 0; layer < kLayerCount; ++layer)
+    {
+        auto const* kvPtr = bufferCast<int32_t>(*kvCaches[layer]);
+        forEachElement(
+            [&](int seq, int kv, int head, int pos, int elt)
+            {
+                auto const srcPos = seq == 0 && (pos == 3 || pos == 4) ? pos + 2 : pos;
+                EXPECT_EQ(kvPtr[kvIndex(seq, kv, head, pos, elt)], kvValue(layer, seq, kv, head, srcPos, elt))
+                    << "layer " << layer << " seq " << seq << " kv " << kv << " head " << head << " pos " << pos;
+            });
+    }
+}
+
+} // namespace
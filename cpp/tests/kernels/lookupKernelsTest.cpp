@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/lookupKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class LookupKernelsTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Looks up ids in the shard [offset, offset + size) of a table and checks that the rows of the other ids are zero.
+    void runTest(std::vector<int32_t> const& ids, int32_t offset, int32_t size, int32_t hidden)
+    {
+        auto const batch = static_cast<SizeType>(ids.size());
+        auto input = mBufferManager->copyFrom(ids, ITensor::makeShape({batch}), MemoryType::kGPU);
+        std::vector<float> table(size * hidden);
+        for (size_t idx = 0; idx < table.size(); ++idx)
+        {
+            table[idx] = static_cast<float>(idx) + 0.5f;
+        }
+        auto weight = mBufferManager->copyFrom(table, ITensor::makeShape({size, hidden}), MemoryType::kGPU);
+        auto output = mBufferManager->gpu(ITensor::makeShape({batch, hidden}), nvinfer1::DataType::kFLOAT);
+
+        tk::invokeLookUp<float, int>(bufferCast<float>(*output), bufferCast<int32_t>(*input),
+            bufferCast<float>(*weight), batch, offset, size, hidden, mStream->get());
+        auto const result = mBufferManager->copyFrom(*output, MemoryType::kCPU);
+        mStream->synchronize();
+
+        auto const* resultPtr = bufferCast<float>(*result);
+        for (SizeType row = 0; row < batch; ++row)
+        {
+            auto const word = ids[row] - offset;
+            for (int32_t col = 0; col < hidden; ++col)
+            {
+                auto const expected = word >= 0 && word < size ? table[word * hidden + col] : 0.f;
+                ASSERT_EQ(resultPtr[row * hidden + col], expected) << "row " << row << " col " << col;
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(LookupKernelsTest, vectorizedRows)
+{
+    // Rows of 4096 bytes, ids below, inside and above the shard
+    runTest({99, 100, 163, 164, 120, -1, 100}, 100, 64, 1024);
+}
+
+TEST_F(LookupKernelsTest, unalignedRows)
+{
+    // Rows of 12 bytes take the scalar kernel
+    runTest({0, 5, 7, 8, 3}, 0, 8, 3);
+}
+
+} // namespace
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/medusaDecodingKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/medusaModule.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class MedusaDecodingKernelTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    static auto constexpr kMedusaHeads = 2;
+    static auto constexpr kMaxMedusaTokens = 4;
+    static auto constexpr kTokensPerStep = kMaxMedusaTokens + 1;
+    static auto constexpr kVocabSize = 32;
+    static auto constexpr kMaxBatchSize = 2;
+    static auto constexpr kMaxSeqLen = 16;
+    static auto constexpr kSequenceLength = 4;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mBufferManager = std::make_shared<BufferManager>(mStream);
+    }
+
+    TensorPtr pinnedInt(std::initializer_list<SizeType> dims)
+    {
+        auto tensor = mBufferManager->pinned(ITensor::makeShape(dims), nvinfer1::DataType::kINT32);
+        std::fill_n(bufferCast<int32_t>(*tensor), tensor->getSize(), 0);
+        return tensor;
+    }
+
+    TensorPtr pinnedFloat(std::initializer_list<SizeType> dims)
+    {
+        auto tensor = mBufferManager->pinned(ITensor::makeShape(dims), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*tensor), tensor->getSize(), 0.f);
+        return tensor;
+    }
+
+    std::shared_ptr<CudaStream> mStream;
+    std::shared_ptr<BufferManager> mBufferManager;
+};
+
+// Host reference of the top-k of a head, by decreasing logit and increasing token on ties
+std::vector<int32_t> topKTokens(float const* logits, int32_t k)
+{
+    std::vector<int32_t> tokens(MedusaDecodingKernelTest::kVocabSize);
+    std::iota(tokens.begin(), tokens.end(), 0);
+    std::stable_sort(tokens.begin(), tokens.end(), [logits](int32_t a, int32_t b) { return logits[a] > logits[b]; });
+    tokens.resize(k);
+    return tokens;
+}
+
+TEST_F(MedusaDecodingKernelTest, greedyAndTypicalAcceptance)
+{
+    // Two chains of depth 2 below the root: nodes 1 -> 3 and 2 -> 4
+    MedusaModule::MedusaChoices choices{{0}, {1}, {0, 0}, {1, 0}};
+    MedusaModule medusaModule(kMedusaHeads, kMaxMedusaTokens);
+    auto topKsTree = pinnedInt({kMedusaHeads});
+    auto positionOffsets = pinnedInt({kTokensPerStep});
+    auto treeIdsTree = pinnedInt({kTokensPerStep});
+    auto pathsTree = pinnedInt({kTokensPerStep, kMedusaHeads + 1});
+    auto packedMask = pinnedInt({kTokensPerStep, medusaModule.numPackedMasks()});
+    SizeType numPathsTree = 0;
+    medusaModule.initMedusaTensorsFromChoices(
+        choices, topKsTree, positionOffsets, treeIdsTree, pathsTree, packedMask, numPathsTree);
+
+    auto topKs = pinnedInt({kMaxBatchSize, kMedusaHeads});
+    auto treeIds = pinnedInt({kMaxBatchSize, kTokensPerStep});
+    auto paths = pinnedInt({kMaxBatchSize, kTokensPerStep, kMedusaHeads + 1});
+    auto numPaths = pinnedInt({kMaxBatchSize});
+    for (SizeType slot = 0; slot < kMaxBatchSize; ++slot)
+    {
+        std::copy_n(bufferCast<int32_t>(*topKsTree), kMedusaHeads, bufferCast<int32_t>(*topKs) + slot * kMedusaHeads);
+        std::copy_n(
+            bufferCast<int32_t>(*treeIdsTree), kTokensPerStep, bufferCast<int32_t>(*treeIds) + slot * kTokensPerStep);
+        std::copy_n(bufferCast<int32_t>(*pathsTree), pathsTree->getSize(),
+            bufferCast<int32_t>(*paths) + slot * pathsTree->getSize());
+        bufferCast<int32_t>(*numPaths)[slot] = numPathsTree;
+    }
+
+    auto targetLogits = pinnedFloat({kMaxBatchSize, kTokensPerStep, kVocabSize});
+    auto medusaLogits = pinnedFloat({kMaxBatchSize, kTokensPerStep, kMedusaHeads, kVocabSize});
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    for (auto const& logits : {targetLogits, medusaLogits})
+    {
+        std::generate_n(bufferCast<float>(*logits), logits->getSize(), [&]() { return dist(gen); });
+    }
+    auto const targetAt = [&](SizeType slot, SizeType node)
+    { return bufferCast<float>(*targetLogits) + (slot * kTokensPerStep + node) * kVocabSize; };
+    auto const argMax = [](float const* logits)
+    { return static_cast<int32_t>(std::max_element(logits, logits + kVocabSize) - logits); };
+
+    // Slot 0 uses typical acceptance: two likely tokens at the root, the second one is typical but not the argmax.
+    // Nodes 1 and 3 are peaked, so the accepted path is 1 -> 3 and the sampled target token is deterministic
+    auto treeTokensTensor = pinnedInt({kMaxBatchSize, kTokensPerStep});
+    auto* treeTokens = bufferCast<int32_t>(*treeTokensTensor);
+    targetAt(0, 0)[3] = 10.f;
+    targetAt(0, 0)[5] = 9.5f;
+    targetAt(0, 1)[7] = 20.f;
+    targetAt(0, 3)[11] = 20.f;
+    treeTokens[0 * kTokensPerStep + 0] = 1;
+    treeTokens[0 * kTokensPerStep + 1] = 5;
+    treeTokens[0 * kTokensPerStep + 2] = 6;
+    treeTokens[0 * kTokensPerStep + 3] = 7;
+    treeTokens[0 * kTokensPerStep + 4] = 8;
+
+    // Slot 1 accepts greedily: node 2 is the argmax of the root, node 4 is not the argmax of node 2
+    treeTokens[1 * kTokensPerStep + 0] = 2;
+    treeTokens[1 * kTokensPerStep + 1] = (argMax(targetAt(1, 0)) + 1) % kVocabSize;
+    treeTokens[1 * kTokensPerStep + 2] = argMax(targetAt(1, 0));
+    treeTokens[1 * kTokensPerStep + 3] = 0;
+    treeTokens[1 * kTokensPerStep + 4] = (argMax(targetAt(1, 2)) + 1) % kVocabSize;
+
+    auto posteriorThresholds = pinnedFloat({kMaxBatchSize});
+    bufferCast<float>(*posteriorThresholds)[0] = 0.09f;
+    auto batchSlots = pinnedInt({kMaxBatchSize});
+    bufferCast<int32_t>(*batchSlots)[0] = 1;
+    bufferCast<int32_t>(*batchSlots)[1] = 0;
+    auto outputIds = pinnedInt({kMaxBatchSize, kMaxSeqLen});
+    auto sequenceLengths = pinnedInt({kMaxBatchSize});
+    std::fill_n(bufferCast<int32_t>(*sequenceLengths), kMaxBatchSize, kSequenceLength);
+    auto numAcceptedTokens = pinnedInt({kMaxBatchSize});
+    auto acceptedPaths = pinnedInt({kMaxBatchSize});
+    auto nextTreeTokens = pinnedInt({kMaxBatchSize, kTokensPerStep});
+    auto curandState = mBufferManager->gpu(
+        ITensor::makeShape({kMaxBatchSize, sizeof(tk::PhiloxState)}), nvinfer1::DataType::kINT8);
+    auto* curandStatePtr = reinterpret_cast<tk::PhiloxState*>(bufferCast<int8_t>(*curandState));
+    tk::invokeCurandInitialize(curandStatePtr, nullptr, kMaxBatchSize, 1234, mStream->get());
+
+    tk::MedusaDecodingParams<float> params{};
+    params.targetLogits = bufferCast<float>(*targetLogits);
+    params.medusaLogits = bufferCast<float>(*medusaLogits);
+    params.treeTokens = treeTokens;
+    params.topKs = bufferCast<int32_t>(*topKs);
+    params.treeIds = bufferCast<int32_t>(*treeIds);
+    params.paths = bufferCast<int32_t>(*paths);
+    params.numPaths = bufferCast<int32_t>(*numPaths);
+    params.batchSlots = bufferCast<int32_t>(*batchSlots);
+    params.posteriorThresholds = bufferCast<float>(*posteriorThresholds);
+    params.curandState = curandStatePtr;
+    params.outputIds = bufferCast<int32_t>(*outputIds);
+    params.sequenceLengths = bufferCast<int32_t>(*sequenceLengths);
+    params.numAcceptedTokens = bufferCast<int32_t>(*numAcceptedTokens);
+    params.acceptedPaths = bufferCast<int32_t>(*acceptedPaths);
+    params.nextTreeTokens = bufferCast<int32_t>(*nextTreeTokens);
+    params.batchSize = kMaxBatchSize;
+    params.maxBatchSize = kMaxBatchSize;
+    params.medusaHeads = kMedusaHeads;
+    params.maxTokensPerStep = kTokensPerStep;
+    params.vocabSize = kVocabSize;
+    params.vocabSizePadded = kVocabSize;
+    params.maxSeqLen = kMaxSeqLen;
+    tk::invokeMedusaDecoding(params, mStream->get());
+    mStream->synchronize();
+
+    std::vector<std::vector<int32_t>> const expectedOutputs{
+        {5, 7, 11}, {argMax(targetAt(1, 0)), argMax(targetAt(1, 2))}};
+    std::vector<SizeType> const lastNodes{3, 2};
+    for (SizeType slot = 0; slot < kMaxBatchSize; ++slot)
+    {
+        auto const& expected = expectedOutputs[slot];
+        auto const numAccepted = static_cast<int32_t>(expected.size()) - 1;
+        EXPECT_EQ(bufferCast<int32_t>(*numAcceptedTokens)[slot], numAccepted) << slot;
+        EXPECT_EQ(bufferCast<int32_t>(*sequenceLengths)[slot], kSequenceLength + numAccepted + 1) << slot;
+        auto const* path
+            = bufferCast<int32_t>(*pathsTree) + bufferCast<int32_t>(*acceptedPaths)[slot] * (kMedusaHeads + 1);
+        EXPECT_EQ(path[numAccepted], lastNodes[slot]) << slot;
+        for (SizeType ti = 0; ti <= numAccepted; ++ti)
+        {
+            EXPECT_EQ(bufferCast<int32_t>(*outputIds)[slot * kMaxSeqLen + kSequenceLength + ti], expected[ti])
+                << slot << " " << ti;
+        }
+
+        // Candidates of the next tree: the target token, then the top-k of every head at the last accepted node
+        std::vector<int32_t> candidates{expected.back()};
+        for (SizeType head = 0; head < kMedusaHeads; ++head)
+        {
+            auto const* logits = bufferCast<float>(*medusaLogits)
+                + ((slot * kTokensPerStep + lastNodes[slot]) * kMedusaHeads + head) * kVocabSize;
+            auto const tokens = topKTokens(logits, bufferCast<int32_t>(*topKsTree)[head]);
+            candidates.insert(candidates.end(), tokens.begin(), tokens.end());
+        }
+        for (SizeType node = 0; node < kTokensPerStep; ++node)
+        {
+            auto const treeId = bufferCast<int32_t>(*treeIdsTree)[node];
+            EXPECT_EQ(bufferCast<int32_t>(*nextTreeTokens)[slot * kTokensPerStep + node], candidates[treeId])
+                << slot << " " << node;
+        }
+    }
+}
+
+} // namespace
@@ -53,6 +53,8 @@ protected:
     int mHiddenSize{};
     int mNumExperts{};
     int mK{};
+    // Stored after the routed experts, with the following expert ids
+    int mNumSharedExperts{};
 
     static void SetUpTestCase()
     {
@@ -91,14 +93,14 @@ protected:
     void initWeights(DataType* buffer, int w, int h, DataType scalar)
     {
         dim3 block(16, 16, 1);
-        dim3 grid(divUp(w, block.x), divUp(h, block.y), mNumExperts);
+        dim3 grid(divUp(w, block.x), divUp(h, block.y), mNumExperts + mNumSharedExperts);
         initWeightsKernel<DataType><<<grid, block, 0, mStream->get()>>>(buffer, w, h, scalar);
     }
 
     void initBias(DataType* buffer, int w)
     {
         dim3 block(256, 1, 1);
-        dim3 grid(divUp(w, block.x), mNumExperts);
+        dim3 grid(divUp(w, block.x), mNumExperts + mNumSharedExperts);
         initBiasToExpertIdKernel<DataType><<<grid, block, 0, mStream->get()>>>(buffer, w);
     }
 
@@ -161,6 +163,7 @@ protected:
             mMaxSeqLen = std::max(mMaxSeqLen, num_tokens);
         }
 
+        mMoERunner.setSharedExperts(mNumSharedExperts);
         size_t workspace_size = mMoERunner.getWorkspaceSize(
             mTotalTokens, mHiddenSize, mInterSize, mNumExperts, mK, mActType, parallelism_config);
 
@@ -168,7 +171,8 @@ protected:
 
         mWorkspace = allocBuffer<char>(workspace_size);
         check_cuda_error(cudaMemsetAsync(mWorkspace, 0xD5, workspace_size, stream));
-        const size_t expert_matrix_size = mNumExperts * mHiddenSize * mInterSize;
+        const int num_weight_experts = mNumExperts + mNumSharedExperts;
+        const size_t expert_matrix_size = num_weight_experts * mHiddenSize * mInterSize;
 
         mExpertWeight1 = allocBuffer<DataType>(expert_matrix_size);
         mExpertWeight2 = allocBuffer<DataType>(expert_matrix_size);
@@ -181,14 +185,16 @@ protected:
         {
             // Allow space for the slice of bias1 in the scratch
             mTpExpertScratchSize += mNumExperts * mInterSize / parallelism_config.tp_size;
-            mExpertBias1 = allocBuffer<DataType>(mNumExperts * mInterSize);
-            mExpertBias2 = allocBuffer<DataType>(mNumExperts * mHiddenSize);
+            mExpertBias1 = allocBuffer<DataType>(num_weight_experts * mInterSize);
+            mExpertBias2 = allocBuffer<DataType>(num_weight_experts * mHiddenSize);
 
-            check_cuda_error(cudaMemsetAsync(mExpertBias1, 0x0, mNumExperts * mInterSize * sizeof(DataType), stream));
-            check_cuda_error(cudaMemsetAsync(mExpertBias2, 0x0, mNumExperts * mHiddenSize * sizeof(DataType), stream));
+            check_cuda_error(
+                cudaMemsetAsync(mExpertBias1, 0x0, num_weight_experts * mInterSize * sizeof(DataType), stream));
+            check_cuda_error(
+                cudaMemsetAsync(mExpertBias2, 0x0, num_weight_experts * mHiddenSize * sizeof(DataType), stream));
         }
 
-        mExpertOutput = allocBuffer<DataType>(mTotalTokens * mHiddenSize * mK);
+        mExpertOutput = allocBuffer<DataType>(mTotalTokens * mHiddenSize * (mK + mNumSharedExperts));
 
         mTpExpertScratch = nullptr;
         if (parallelism_config.tp_size > 1)
@@ -254,8 +260,8 @@ protected:
         check_cuda_error(cudaMemsetAsync(mSourceToExpandedMap, 0x0, sizeof(int) * mTotalTokens * mK, stream));
         check_cuda_error(cudaMemsetAsync(mSelectedExpert, 0x0, sizeof(int) * mTotalTokens * mK, stream));
         check_cuda_error(cudaMemsetAsync(mScaleProbs, 0x0, sizeof(DataType) * mTotalTokens * mK, stream));
-        check_cuda_error(
-            cudaMemsetAsync(mExpertOutput, 0x0, mTotalTokens * mHiddenSize * mK * sizeof(DataType), stream));
+        check_cuda_error(cudaMemsetAsync(
+            mExpertOutput, 0x0, mTotalTokens * mHiddenSize * (mK + mNumSharedExperts) * sizeof(DataType), stream));
 
         check_cuda_error(cudaStreamSynchronize(mStream->get()));
     }
@@ -405,6 +411,12 @@ protected:
     {
         if (expert_id >= mNumExperts)
             return 0;
+        return calcExpertMLPVal(input, expert_id, final_bias);
+    }
+
+    // Also computes the shared experts, which come after the routed expert ids
+    DataType calcExpertMLPVal(DataType input, int expert_id, bool final_bias)
+    {
         auto fc1 = input * mExpertWDiag1 + (DataType) (mUseBias ? expert_id : 0);
         auto activated = actfn(fc1) * mExpertWDiag2;
         return activated + (DataType) (final_bias ? expert_id : 0);
@@ -527,6 +539,12 @@ protected:
                     sum += calcMLPValWithFinalBias(input_data[token_id * mHiddenSize + hidden_id], selected_expert)
                         * softmax_probs[token_id * mNumExperts + selected_expert];
                 }
+                // The shared experts are not scaled by the router
+                for (int shared_idx = 0; shared_idx < mNumSharedExperts; shared_idx++)
+                {
+                    sum += calcExpertMLPVal(
+                        input_data[token_id * mHiddenSize + hidden_id], mNumExperts + shared_idx, mUseBias);
+                }
 
                 EXPECT_FLOAT_EQ(sum, final_results[token_id * mHiddenSize + hidden_id])
                     << "Incorrect final value at position: " << token_id * mHiddenSize + hidden_id;
@@ -598,6 +616,20 @@ TEST_F(MixtureOfExpertsTest, PermuteK2)
     BasicPermuteTest(2);
 }
 
+TEST_F(MixtureOfExpertsTest, SharedExperts)
+{
+    mNumSharedExperts = 2;
+    BasicPermuteTest();
+    BasicPermuteTest(2);
+}
+
+TEST_F(MixtureOfExpertsTest, SharedExpertsNoBias)
+{
+    mNumSharedExperts = 1;
+    mUseBias = false;
+    BasicPermuteTest(2);
+}
+
 TEST_F(MixtureOfExpertsTest, PermuteK3)
 {
     BasicPermuteTest(3);
@@ -757,6 +789,45 @@ TEST_F(MixtureOfExpertsTest, ExpertParallelRenorm)
     ExpertParallelTest(2);
 }
 
+TEST_F(MixtureOfExpertsTest, ExpertLoadCounters)
+{
+    int hidden_size = DEFAULT_HIDDEN_SIZE;
+    int parallelism = 2;
+    int num_experts = 4;
+    int k = 2;
+
+    std::vector<DataType> hidden_states(hidden_size * 3, 0);
+    std::iota(hidden_states.begin(), hidden_states.end(), 0.0f);
+
+    std::vector<float> probs = {
+        0.5, 0.1, 0.25, 0.15,   //
+        0.03, 0.2, 0.07, 0.7,   //
+        0.25, 0.21, 0.35, 0.19, //
+    };
+
+    auto load_buffer = mBufferManager->gpu(num_experts * sizeof(int64_t));
+    mBufferManager->setZero(*load_buffer);
+    auto* expert_load = static_cast<int64_t*>(load_buffer->data());
+    mMoERunner.setExpertLoadCounters(expert_load);
+    for (int i = 0; i < parallelism; i++)
+    {
+        if (i == 0)
+        {
+            runMoEPermute({hidden_states}, {probs}, hidden_size, num_experts, k, {},
+                MOEParallelismConfig::ExpertParallelism(parallelism, i));
+        }
+        else
+        {
+            runMoEPermute(MOEParallelismConfig::ExpertParallelism(parallelism, i));
+        }
+    }
+    mMoERunner.setExpertLoadCounters(nullptr);
+
+    // Each node counts the rows of its experts, the selected experts are {0, 2, 3, 1, 2, 0}
+    auto load = getDataFromDevice(expert_load, num_experts);
+    EXPECT_EQ(load, (std::vector<int64_t>{2, 1, 2, 1}));
+}
+
 void MixtureOfExpertsTest::TensorParallelTest(int k)
 {
     int hidden_size = DEFAULT_HIDDEN_SIZE;
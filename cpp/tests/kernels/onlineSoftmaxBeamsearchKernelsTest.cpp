@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOP_LEVEL_DIR
+#error "Define TOP_LEVEL_DIR"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/onlineSoftmaxBeamsearchKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class OnlineSoftmaxBeamsearchKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = tensorrt_llm::runtime::ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    void TearDown() override {}
+
+    // Runs one beam search step without finished beams and compares the selected beams with a reference computed
+    // over all beamWidth * vocabSize candidates of each batch.
+    void runTest(SizeType batchSize, SizeType beamWidth, SizeType vocabSize)
+    {
+        SizeType constexpr step{3};
+        SizeType constexpr maxSeqLen{step + 1};
+        auto const numVectors = batchSize * beamWidth;
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> logitDistr(-5.f, 5.f);
+        std::uniform_real_distribution<float> cumLogProbDistr(-3.f, 0.f);
+
+        auto logits = mBufferManager->pinned(ITensor::makeShape({numVectors, vocabSize}), nvinfer1::DataType::kFLOAT);
+        auto cumLogProbs = mBufferManager->pinned(ITensor::makeShape({numVectors}), nvinfer1::DataType::kFLOAT);
+        auto finished = mBufferManager->pinned(
+            ITensor::makeShape({numVectors}), TRTDataType<tk::FinishedState::UnderlyingType>::value);
+        auto sequenceLengths = mBufferManager->pinned(ITensor::makeShape({numVectors}), nvinfer1::DataType::kINT32);
+        auto outputIds
+            = mBufferManager->pinned(ITensor::makeShape({batchSize, beamWidth, maxSeqLen}), nvinfer1::DataType::kINT32);
+        auto outputIdsPtrs = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT64);
+        auto endIds = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto diversityRates = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kFLOAT);
+        auto lengthPenalties = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kFLOAT);
+        auto earlyStoppings = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        // Same workspace size as OnlineBeamSearchLayer, which covers both the split and the fused path
+        auto workspace = mBufferManager->gpu(
+            ITensor::makeShape({static_cast<SizeType>(std::ceil(batchSize * 64 * (64 * 2) / 4.) * 4 * 2
+                + std::ceil(batchSize * (64 * 2) * 128 * (2 * (4 * 2) + 2) / 4.) * 4)}),
+            nvinfer1::DataType::kFLOAT);
+
+        auto logitsPtr = bufferCast<float>(*logits);
+        auto cumLogProbsPtr = bufferCast<float>(*cumLogProbs);
+        std::generate(logitsPtr, logitsPtr + logits->getSize(), [&]() { return logitDistr(generator); });
+        std::generate(cumLogProbsPtr, cumLogProbsPtr + numVectors, [&]() { return cumLogProbDistr(generator); });
+        auto finishedPtr
+            = reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*finished));
+        std::fill_n(finishedPtr, numVectors, tk::FinishedState::empty());
+        std::fill_n(bufferCast<SizeType>(*sequenceLengths), numVectors, step);
+        std::fill_n(bufferCast<SizeType>(*outputIds), outputIds->getSize(), -1);
+        std::fill_n(bufferCast<SizeType>(*endIds), batchSize, vocabSize - 1);
+        std::fill_n(bufferCast<float>(*diversityRates), batchSize, 0.f);
+        std::fill_n(bufferCast<float>(*lengthPenalties), batchSize, 0.f);
+        std::fill_n(bufferCast<SizeType>(*earlyStoppings), batchSize, 1);
+        auto outputIdsPtrsPtr = reinterpret_cast<int**>(bufferCast<int64_t>(*outputIdsPtrs));
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            outputIdsPtrsPtr[bi] = bufferCast<SizeType>(*outputIds) + bi * beamWidth * maxSeqLen;
+        }
+
+        // Reference scores before the kernel updates the cumulative log probs in place
+        std::vector<float> refScores(numVectors * vocabSize);
+        for (SizeType vi = 0; vi < numVectors; ++vi)
+        {
+            auto const* row = logitsPtr + vi * vocabSize;
+            auto const maxLogit = *std::max_element(row, row + vocabSize);
+            double sum{0.0};
+            for (SizeType ti = 0; ti < vocabSize; ++ti)
+            {
+                sum += std::exp(row[ti] - maxLogit);
+            }
+            auto const logSum = static_cast<float>(std::log(sum)) + maxLogit;
+            for (SizeType ti = 0; ti < vocabSize; ++ti)
+            {
+                refScores[vi * vocabSize + ti] = cumLogProbsPtr[vi] + row[ti] - logSum;
+            }
+        }
+
+        tk::BeamHypotheses beamHyps;
+        beamHyps.end_ids = bufferCast<SizeType>(*endIds);
+        beamHyps.sequence_lengths_src = bufferCast<SizeType>(*sequenceLengths);
+        beamHyps.output_ids_tgt_ptr = outputIdsPtrsPtr;
+        beamHyps.batch_size = batchSize;
+        beamHyps.beam_width = beamWidth;
+        beamHyps.local_batch_size = batchSize;
+        beamHyps.max_seq_len = maxSeqLen;
+        beamHyps.vocab_size = vocabSize;
+        beamHyps.diversity_rates = bufferCast<float>(*diversityRates);
+        beamHyps.length_penalties = bufferCast<float>(*lengthPenalties);
+        beamHyps.early_stoppings = bufferCast<SizeType>(*earlyStoppings);
+
+        tk::invokeTopkSoftMax(logitsPtr, (float const*) nullptr, finishedPtr, cumLogProbsPtr,
+            bufferCast<float>(*workspace), static_cast<int>(workspace->getSize()), beamHyps, mStream->get());
+        mStream->synchronize();
+        sync_check_cuda_error();
+
+        auto const outputIdsHost = bufferCast<SizeType>(*outputIds);
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            auto const* batchScores = refScores.data() + bi * beamWidth * vocabSize;
+            std::vector<SizeType> order(beamWidth * vocabSize);
+            std::iota(order.begin(), order.end(), 0);
+            std::partial_sort(order.begin(), order.begin() + beamWidth, order.end(),
+                [&](SizeType a, SizeType b) { return batchScores[a] > batchScores[b]; });
+            for (SizeType bwi = 0; bwi < beamWidth; ++bwi)
+            {
+                auto const absoluteId = bi * beamWidth * vocabSize + order[bwi];
+                EXPECT_EQ(outputIdsHost[(bi * beamWidth + bwi) * maxSeqLen + step], absoluteId)
+                    << "batch " << bi << " beam " << bwi;
+                EXPECT_NEAR(cumLogProbsPtr[bi * beamWidth + bwi], batchScores[order[bwi]], 1e-3f)
+                    << "batch " << bi << " beam " << bwi;
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+};
+
+TEST_F(OnlineSoftmaxBeamsearchKernelsTest, BS1BW8Test)
+{
+    // Too few beams to fill the device, takes the split path
+    runTest(1, 8, 4000);
+}
+
+TEST_F(OnlineSoftmaxBeamsearchKernelsTest, BS64BW8Test)
+{
+    // Takes the fused path on devices with up to 512 SMs
+    runTest(64, 8, 4000);
+}
+
+#ifndef FAST_BUILD
+TEST_F(OnlineSoftmaxBeamsearchKernelsTest, BS1BW16Test)
+{
+    runTest(1, 16, 32000);
+}
+
+TEST_F(OnlineSoftmaxBeamsearchKernelsTest, BS32BW16Test)
+{
+    runTest(32, 16, 32000);
+}
+
+TEST_F(OnlineSoftmaxBeamsearchKernelsTest, BS16BW64Test)
+{
+    runTest(16, 64, 1000);
+}
+#endif // FAST_BUILD
+
+} // end of namespace
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/relativeAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// T5 bucketing as in addRelativeAttentionBiasUnaligned
+int32_t relativePositionBucket(int32_t relativePosition, int32_t numBuckets, int32_t maxDistance)
+{
+    numBuckets /= 2;
+    int32_t bucket = relativePosition > 0 ? numBuckets : 0;
+    relativePosition = std::abs(relativePosition);
+    auto const maxExact = numBuckets / 2;
+    if (relativePosition < maxExact)
+    {
+        return bucket + relativePosition;
+    }
+    auto const large = maxExact
+        + static_cast<int32_t>(std::log(relativePosition * 1.0f / maxExact)
+            / std::log(static_cast<float>(maxDistance) / maxExact) * (numBuckets - maxExact));
+    return bucket + std::min(large, numBuckets - 1);
+}
+
+class RelativeAttentionKernelTest : public testing::Test
+{
+public:
+    static auto constexpr kNumHeads = 2;
+    static auto constexpr kHeadSize = 64;
+    static auto constexpr kNumBuckets = 32;
+    static auto constexpr kMaxDistance = 128;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Compares with softmax(scale * QK + bias) * V computed on the host from a materialized bias.
+    void runTest(std::vector<int32_t> const& seqLengths, bool removePadding)
+    {
+        auto const batchSize = static_cast<int32_t>(seqLengths.size());
+        auto const maxSeqLength = *std::max_element(seqLengths.begin(), seqLengths.end());
+        std::vector<int32_t> seqOffsets(batchSize + 1, 0);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            seqOffsets[bi + 1] = seqOffsets[bi] + (removePadding ? seqLengths[bi] : maxSeqLength);
+        }
+        auto const numTokens = seqOffsets.back();
+
+        auto qkv = mBufferManager->pinned(
+            ITensor::makeShape({numTokens, 3, kNumHeads, kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto output
+            = mBufferManager->pinned(ITensor::makeShape({numTokens, kNumHeads, kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto table = mBufferManager->pinned(ITensor::makeShape({kNumHeads, kNumBuckets}), nvinfer1::DataType::kFLOAT);
+        auto offsetsDevice
+            = mBufferManager->copyFrom(seqOffsets, ITensor::makeShape({batchSize + 1}), MemoryType::kGPU);
+        auto lengthsDevice = mBufferManager->copyFrom(seqLengths, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+        auto* qkvPtr = bufferCast<float>(*qkv);
+        auto* tablePtr = bufferCast<float>(*table);
+        for (size_t idx = 0; idx < qkv->getSize(); ++idx)
+        {
+            qkvPtr[idx] = static_cast<float>((idx * 2654435761u) % 1000) / 500.f - 1.f;
+        }
+        for (size_t idx = 0; idx < table->getSize(); ++idx)
+        {
+            tablePtr[idx] = static_cast<float>((idx * 40503u + 17) % 100) / 25.f - 2.f;
+        }
+
+        auto const qkScale = 1.f / std::sqrt(static_cast<float>(kHeadSize));
+        tk::RelativeAttentionParams params{};
+        params.qkv = qkvPtr;
+        params.output = output->data();
+        params.relativeAttentionBias = tablePtr;
+        params.seqOffsets = removePadding ? bufferCast<int32_t>(*offsetsDevice) : nullptr;
+        params.seqLengths = bufferCast<int32_t>(*lengthsDevice);
+        params.batchSize = batchSize;
+        params.maxSeqLength = maxSeqLength;
+        params.numHeads = kNumHeads;
+        params.headSize = kHeadSize;
+        params.numBuckets = kNumBuckets;
+        params.maxDistance = kMaxDistance;
+        params.qkScale = qkScale;
+        params.bidirectional = true;
+        tk::invokeRelativeAttention<float>(params, mStream->get());
+        mStream->synchronize();
+
+        auto const* outputPtr = bufferCast<float>(*output);
+        auto const qkvStride = static_cast<size_t>(3 * kNumHeads) * kHeadSize;
+        auto const outStride = static_cast<size_t>(kNumHeads) * kHeadSize;
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            auto const length = seqLengths[bi];
+            auto const* seqQkv = qkvPtr + seqOffsets[bi] * qkvStride;
+            auto const numRows = seqOffsets[bi + 1] - seqOffsets[bi];
+            for (int32_t token = 0; token < numRows; ++token)
+            {
+                for (int32_t head = 0; head < kNumHeads; ++head)
+                {
+                    auto const* actual = outputPtr + (seqOffsets[bi] + token) * outStride + head * kHeadSize;
+                    if (token >= length)
+                    {
+                        for (int32_t channel = 0; channel < kHeadSize; ++channel)
+                        {
+                            ASSERT_EQ(actual[channel], 0.f) << "padding token " << token;
+                        }
+                        continue;
+                    }
+                    auto const* qRow = seqQkv + token * qkvStride + head * kHeadSize;
+                    std::vector<float> scores;
+                    for (int32_t pos = 0; pos < length; ++pos)
+                    {
+                        auto const* kRow = seqQkv + pos * qkvStride + (kNumHeads + head) * kHeadSize;
+                        auto const score = std::inner_product(qRow, qRow + kHeadSize, kRow, 0.f);
+                        auto const bucket = relativePositionBucket(pos - token, kNumBuckets, kMaxDistance);
+                        scores.push_back(score * qkScale + tablePtr[head * kNumBuckets + bucket]);
+                    }
+                    auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                    float sum = 0.f;
+                    for (auto& score : scores)
+                    {
+                        score = std::exp(score - maxScore);
+                        sum += score;
+                    }
+                    for (int32_t channel = 0; channel < kHeadSize; ++channel)
+                    {
+                        float expected = 0.f;
+                        for (int32_t pos = 0; pos < length; ++pos)
+                        {
+                            auto const* vRow = seqQkv + pos * qkvStride + (2 * kNumHeads + head) * kHeadSize;
+                            expected += scores[pos] / sum * vRow[channel];
+                        }
+                        ASSERT_NEAR(actual[channel], expected, 1e-4)
+                            << "batch " << bi << " token " << token << " head " << head << " channel " << channel;
+                    }
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(RelativeAttentionKernelTest, removePadding)
+{
+    runTest({150, 5, 33}, true);
+}
+
+TEST_F(RelativeAttentionKernelTest, padded)
+{
+    runTest({70, 17}, false);
+}
+
+} // namespace
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/residualNormKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class ResidualNormKernelTest : public testing::Test
+{
+public:
+    static auto constexpr kNumTokens = 5;
+    static auto constexpr kEps = 1e-5f;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Compares with the residual add followed by the norm computed in double on the host. The values are offset
+    // from zero, which a one-pass E[x²] - E[x]² variance would not resolve.
+    void runTest(int32_t hiddenSize, bool rmsNorm, bool withBeta)
+    {
+        auto const shape = ITensor::makeShape({kNumTokens, hiddenSize});
+        auto input = mBufferManager->pinned(shape, nvinfer1::DataType::kFLOAT);
+        auto residual = mBufferManager->pinned(shape, nvinfer1::DataType::kFLOAT);
+        auto output = mBufferManager->pinned(shape, nvinfer1::DataType::kFLOAT);
+        auto gamma = mBufferManager->pinned(ITensor::makeShape({hiddenSize}), nvinfer1::DataType::kFLOAT);
+        auto beta = mBufferManager->pinned(ITensor::makeShape({hiddenSize}), nvinfer1::DataType::kFLOAT);
+        auto* inputPtr = bufferCast<float>(*input);
+        auto* residualPtr = bufferCast<float>(*residual);
+        auto* gammaPtr = bufferCast<float>(*gamma);
+        auto* betaPtr = bufferCast<float>(*beta);
+        for (size_t idx = 0; idx < input->getSize(); ++idx)
+        {
+            inputPtr[idx] = static_cast<float>((idx * 2654435761u) % 1000) / 500.f - 1.f;
+            residualPtr[idx] = 100.f + static_cast<float>((idx * 40503u + 17) % 1000) / 250.f;
+        }
+        for (int32_t idx = 0; idx < hiddenSize; ++idx)
+        {
+            gammaPtr[idx] = 0.5f + static_cast<float>(idx % 7) / 7.f;
+            betaPtr[idx] = static_cast<float>(idx % 5) / 5.f - 0.4f;
+        }
+        std::vector<float> const residualIn(residualPtr, residualPtr + residual->getSize());
+
+        auto const* betaArg = withBeta ? betaPtr : nullptr;
+        if (rmsNorm)
+        {
+            tk::invokeResidualRmsNorm(bufferCast<float>(*output), residualPtr, inputPtr, gammaPtr, betaArg, kEps,
+                kNumTokens, hiddenSize, mStream->get());
+        }
+        else
+        {
+            tk::invokeResidualLayerNorm(bufferCast<float>(*output), residualPtr, inputPtr, gammaPtr, betaArg, kEps,
+                kNumTokens, hiddenSize, mStream->get());
+        }
+        mStream->synchronize();
+
+        auto const* outputPtr = bufferCast<float>(*output);
+        for (int32_t token = 0; token < kNumTokens; ++token)
+        {
+            auto const offset = static_cast<size_t>(token) * hiddenSize;
+            std::vector<double> sum(hiddenSize);
+            double mean = 0.0;
+            for (int32_t idx = 0; idx < hiddenSize; ++idx)
+            {
+                sum[idx] = static_cast<double>(inputPtr[offset + idx] + residualIn[offset + idx]);
+                ASSERT_EQ(residualPtr[offset + idx], static_cast<float>(sum[idx])) << "token " << token << " " << idx;
+                mean += sum[idx] / hiddenSize;
+            }
+            if (rmsNorm)
+            {
+                mean = 0.0;
+            }
+            double variance = 0.0;
+            for (int32_t idx = 0; idx < hiddenSize; ++idx)
+            {
+                variance += (sum[idx] - mean) * (sum[idx] - mean) / hiddenSize;
+            }
+            auto const invStd = 1.0 / std::sqrt(variance + kEps);
+            for (int32_t idx = 0; idx < hiddenSize; ++idx)
+            {
+                auto expected = (sum[idx] - mean) * invStd * gammaPtr[idx] + (withBeta ? betaPtr[idx] : 0.f);
+                ASSERT_NEAR(outputPtr[offset + idx], expected, 1e-3 * std::max(1.0, std::abs(expected)))
+                    << "token " << token << " index " << idx;
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(ResidualNormKernelTest, layerNormRegisters)
+{
+    runTest(4096, false, true);
+    runTest(5120, false, false);
+}
+
+TEST_F(ResidualNormKernelTest, layerNormSharedMemory)
+{
+    runTest(2560, false, true);
+    runTest(100, false, true);
+}
+
+TEST_F(ResidualNormKernelTest, rmsNorm)
+{
+    runTest(8192, true, false);
+    runTest(1028, true, true);
+}
+
+} // namespace
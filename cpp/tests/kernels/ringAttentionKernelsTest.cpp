@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/ringAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class RingAttentionKernelTest : public testing::Test
+{
+public:
+    static auto constexpr kNumQHeads = 4;
+    static auto constexpr kNumKVHeads = 2;
+    static auto constexpr kHeadSize = 64;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Runs the steps every rank of the ring would run, each shard attending to all shards in ring order, and compares
+    // with attention over the whole sequence.
+    void runTest(std::vector<int32_t> const& shardLengths, bool causal)
+    {
+        std::vector<int32_t> shardPositions{0};
+        for (auto const length : shardLengths)
+        {
+            shardPositions.push_back(shardPositions.back() + length);
+        }
+        auto const seqLen = shardPositions.back();
+        auto const numShards = static_cast<int32_t>(shardLengths.size());
+
+        auto q = mBufferManager->pinned(
+            ITensor::makeShape({seqLen, kNumQHeads, kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto kv = mBufferManager->pinned(
+            ITensor::makeShape({seqLen, 2, kNumKVHeads, kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto output = mBufferManager->pinned(
+            ITensor::makeShape({seqLen, kNumQHeads, kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto accumulator = mBufferManager->pinned(
+            ITensor::makeShape({seqLen, kNumQHeads, kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto rowMax = mBufferManager->pinned(ITensor::makeShape({seqLen, kNumQHeads}), nvinfer1::DataType::kFLOAT);
+        auto rowSum = mBufferManager->pinned(ITensor::makeShape({seqLen, kNumQHeads}), nvinfer1::DataType::kFLOAT);
+        auto* qPtr = bufferCast<float>(*q);
+        auto* kvPtr = bufferCast<float>(*kv);
+        for (size_t idx = 0; idx < q->getSize(); ++idx)
+        {
+            qPtr[idx] = static_cast<float>((idx * 2654435761u) % 1000) / 500.f - 1.f;
+        }
+        for (size_t idx = 0; idx < kv->getSize(); ++idx)
+        {
+            kvPtr[idx] = static_cast<float>((idx * 40503u + 17) % 1000) / 500.f - 1.f;
+        }
+        mBufferManager->setZero(*accumulator);
+        mBufferManager->setZero(*rowMax);
+        mBufferManager->setZero(*rowSum);
+
+        auto const softmaxScale = 1.f / std::sqrt(static_cast<float>(kHeadSize));
+        auto const qStride = static_cast<size_t>(kNumQHeads) * kHeadSize;
+        auto const kvStride = static_cast<size_t>(2 * kNumKVHeads) * kHeadSize;
+        for (int32_t rank = 0; rank < numShards; ++rank)
+        {
+            auto const qBegin = static_cast<size_t>(shardPositions[rank]);
+            for (int32_t step = 0; step < numShards; ++step)
+            {
+                auto const srcRank = (rank + numShards - step) % numShards;
+                tk::RingAttentionStepParams params{};
+                params.q = qPtr + qBegin * qStride;
+                params.kv = kvPtr + static_cast<size_t>(shardPositions[srcRank]) * kvStride;
+                params.accumulator = bufferCast<float>(*accumulator) + qBegin * qStride;
+                params.rowMax = bufferCast<float>(*rowMax) + qBegin * kNumQHeads;
+                params.rowSum = bufferCast<float>(*rowSum) + qBegin * kNumQHeads;
+                params.numQTokens = shardLengths[rank];
+                params.numKvTokens = shardLengths[srcRank];
+                params.qPosition = shardPositions[rank];
+                params.kvPosition = shardPositions[srcRank];
+                params.numQHeads = kNumQHeads;
+                params.numKVHeads = kNumKVHeads;
+                params.headSize = kHeadSize;
+                params.softmaxScale = softmaxScale;
+                params.causal = causal;
+                tk::invokeRingAttentionStep<float>(params, mStream->get());
+            }
+        }
+        tk::invokeRingAttentionFinalize<float>(output->data(), bufferCast<float>(*accumulator),
+            bufferCast<float>(*rowSum), seqLen, kNumQHeads, kHeadSize, mStream->get());
+        mStream->synchronize();
+
+        auto const* outputPtr = bufferCast<float>(*output);
+        for (int32_t token = 0; token < seqLen; ++token)
+        {
+            auto const numAttended = causal ? token + 1 : seqLen;
+            for (int32_t qHead = 0; qHead < kNumQHeads; ++qHead)
+            {
+                auto const kvHead = qHead / (kNumQHeads / kNumKVHeads);
+                auto const* qRow = qPtr + token * qStride + qHead * kHeadSize;
+                std::vector<float> scores;
+                for (int32_t pos = 0; pos < numAttended; ++pos)
+                {
+                    auto const* kRow = kvPtr + pos * kvStride + kvHead * kHeadSize;
+                    float score = 0.f;
+                    for (int32_t channel = 0; channel < kHeadSize; ++channel)
+                    {
+                        score += qRow[channel] * kRow[channel];
+                    }
+                    scores.push_back(score * softmaxScale);
+                }
+                auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                float sum = 0.f;
+                for (auto& score : scores)
+                {
+                    score = std::exp(score - maxScore);
+                    sum += score;
+                }
+                for (int32_t channel = 0; channel < kHeadSize; ++channel)
+                {
+                    float expected = 0.f;
+                    for (int32_t pos = 0; pos < numAttended; ++pos)
+                    {
+                        auto const* vRow = kvPtr + pos * kvStride + (kNumKVHeads + kvHead) * kHeadSize;
+                        expected += scores[pos] / sum * vRow[channel];
+                    }
+                    auto const actual = outputPtr[token * qStride + qHead * kHeadSize + channel];
+                    ASSERT_NEAR(actual, expected, 1e-4) << "token " << token << " head " << qHead << " channel "
+                                                        << channel;
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(RingAttentionKernelTest, causal)
+{
+    runTest({40, 40, 33}, true);
+}
+
+TEST_F(RingAttentionKernelTest, bidirectional)
+{
+    runTest({17, 50}, false);
+}
+
+TEST_F(RingAttentionKernelTest, singleShard)
+{
+    runTest({29}, true);
+}
+
+} // namespace
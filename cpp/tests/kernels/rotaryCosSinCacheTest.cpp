@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/rotaryCosSinCache.h"
+
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+namespace
+{
+
+TEST(RotaryCosSinCacheTest, linearScalingDividesFrequencies)
+{
+    tk::RotaryCosSinCacheParams params;
+    params.rotaryEmbeddingDim = 64;
+    params.scaleType = tk::RotaryScalingType::kLINEAR;
+    params.scale = 4.f;
+
+    float attentionFactor;
+    auto const invFreqs = tk::computeRotaryInvFreqs(params, attentionFactor);
+    ASSERT_EQ(invFreqs.size(), 32);
+    EXPECT_EQ(attentionFactor, 1.f);
+    for (int i = 0; i < 32; ++i)
+    {
+        EXPECT_NEAR(invFreqs[i], std::pow(10000.0, -2.0 * i / 64) / 4.0, 1e-7);
+    }
+}
+
+TEST(RotaryCosSinCacheTest, yarnRampsFromExtrapolationToInterpolation)
+{
+    tk::RotaryCosSinCacheParams params;
+    params.rotaryEmbeddingDim = 128;
+    params.scaleType = tk::RotaryScalingType::kYARN;
+    params.scale = 16.f;
+    params.originalMaxPositions = 4096;
+
+    float attentionFactor;
+    auto const invFreqs = tk::computeRotaryInvFreqs(params, attentionFactor);
+    ASSERT_EQ(invFreqs.size(), 64);
+    EXPECT_NEAR(attentionFactor, 0.1 * std::log(16.0) + 1.0, 1e-6);
+    // The fastest frequencies are kept, the slowest ones are interpolated and the ramp in between is monotonic.
+    EXPECT_NEAR(invFreqs[0], 1.0, 1e-7);
+    EXPECT_NEAR(invFreqs[63], std::pow(10000.0, -126.0 / 128) / 16.0, 1e-9);
+    for (int i = 1; i < 64; ++i)
+    {
+        auto const extrapolation = std::pow(10000.0, -2.0 * i / 128);
+        EXPECT_LE(invFreqs[i], extrapolation * (1 + 1e-6));
+        EXPECT_GE(invFreqs[i], extrapolation / 16.0 * (1 - 1e-6));
+    }
+}
+
+TEST(RotaryCosSinCacheTest, tableMatchesReference)
+{
+    tk::RotaryCosSinCacheParams params;
+    params.rotaryEmbeddingDim = 64;
+    params.scaleType = tk::RotaryScalingType::kLONGROPE;
+    params.scale = 32.f;
+    params.originalMaxPositions = 4096;
+    for (int i = 0; i < 32; ++i)
+    {
+        params.longRopeFactors.push_back(1.f + i * 0.5f);
+    }
+    int const numPositions = 131072;
+
+    auto const* cosSin = tk::getRotaryCosSinCache(params, numPositions);
+    EXPECT_EQ(tk::getRotaryCosSinCache(params, numPositions / 2), cosSin);
+
+    std::vector<float2> table(static_cast<size_t>(numPositions) * 32);
+    TLLM_CUDA_CHECK(cudaMemcpy(table.data(), cosSin, table.size() * sizeof(float2), cudaMemcpyDeviceToHost));
+
+    float attentionFactor;
+    auto const invFreqs = tk::computeRotaryInvFreqs(params, attentionFactor);
+    EXPECT_NEAR(attentionFactor, std::sqrt(1.0 + std::log(32.0) / std::log(4096.0)), 1e-6);
+    for (int pos : {0, 1, 4095, 65537, numPositions - 1})
+    {
+        for (int i = 0; i < 32; ++i)
+        {
+            auto const angle = static_cast<double>(pos) * invFreqs[i];
+            auto const& entry = table[static_cast<size_t>(pos) * 32 + i];
+            EXPECT_NEAR(entry.x, std::cos(angle) * attentionFactor, 1e-6) << "pos " << pos << " freq " << i;
+            EXPECT_NEAR(entry.y, std::sin(angle) * attentionFactor, 1e-6) << "pos " << pos << " freq " << i;
+        }
+    }
+}
+
+} // namespace
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "tensorrt_llm/kernels/decodingKernels.h"
 #include "tensorrt_llm/kernels/penaltyTypes.h"
 #include "tests/kernels/sampling/samplingTest.h"
 
@@ -331,6 +332,7 @@ struct RepetitionPenaltyTestCase
     int32_t repetitionPenaltiesSize;
     int32_t presencePenaltiesSize;
     int32_t frequencyPenaltiesSize;
+    bool useTokenCounts{false};
 
     RepetitionPenaltyTestCase& setBatchSize(int32_t bs)
     {
@@ -386,15 +388,21 @@ struct RepetitionPenaltyTestCase
         return *this;
     }
 
+    RepetitionPenaltyTestCase& setUseTokenCounts(bool utc)
+    {
+        useTokenCounts = utc;
+        return *this;
+    }
+
     std::string toString() const
     {
         return tc::fmtstr(
             "RepetitionPenaltyTestCase[batch=%d, vocab=%d, maxInputLength=%d, "
-            "repetitionPenalties=%s, presencePenalties=%s, frequencyPenalties=%s]",
+            "repetitionPenalties=%s, presencePenalties=%s, frequencyPenalties=%s, useTokenCounts=%d]",
             batchSize, vocabSize, maxInputLength,
             tc::arr2str(bufferCast<float>(*repetitionPenalties), repetitionPenaltiesSize).c_str(),
             tc::arr2str(bufferCast<float>(*presencePenalties), presencePenaltiesSize).c_str(),
-            tc::arr2str(bufferCast<float>(*frequencyPenalties), frequencyPenaltiesSize).c_str());
+            tc::arr2str(bufferCast<float>(*frequencyPenalties), frequencyPenaltiesSize).c_str(), useTokenCounts);
     }
 };
 
@@ -437,6 +445,10 @@ protected:
     TensorPtr mFrequencyPenaltiesDevice;
     TensorPtr mBatchSlots;
 
+    TensorPtr mTokenCountsDevice;
+    TensorPtr mUniqueTokensDevice;
+    TensorPtr mNumUniqueTokensDevice;
+
     void subsetup(RepetitionPenaltyTestCase param)
     {
         auto const dataType = TRTDataType<T>::value;
@@ -567,10 +579,77 @@ protected:
         }
     }
 
+    //! \brief Counts the prompts in the context phase, then adds the generated tokens one step at a time.
+    TokenCounts countTokens()
+    {
+        mTokenCountsDevice
+            = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize, mVocabSize}), nvinfer1::DataType::kINT32);
+        mUniqueTokensDevice
+            = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize, mVocabSize}), nvinfer1::DataType::kINT32);
+        mNumUniqueTokensDevice = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize}), nvinfer1::DataType::kINT32);
+        mBufferManager->setZero(*mTokenCountsDevice);
+        mBufferManager->setZero(*mNumUniqueTokensDevice);
+        TokenCounts const tokenCounts{bufferCast<int32_t>(*mTokenCountsDevice),
+            bufferCast<int32_t>(*mUniqueTokensDevice), bufferCast<int32_t>(*mNumUniqueTokensDevice), mVocabSize};
+
+        // The first half of every sequence is the prompt
+        auto const seqLengthsPtr = bufferCast<int32_t>(*mSeqLengthHost);
+        auto contextLengthPtr = bufferCast<int32_t>(*mContextLengthHost);
+        for (SizeType bi = 0; bi < mMaxBatchSize; ++bi)
+        {
+            contextLengthPtr[bi] = (seqLengthsPtr[bi] + 1) / 2;
+        }
+        mBufferManager->copy(*mContextLengthHost, *mContextLengthDevice);
+
+        InvokeBatchApplyPenaltyParams<T> contextParams{reinterpret_cast<T**>(bufferCast<int64_t>(*mLogitsPtrs)),
+            bufferCast<T>(*mOutLogitsDevice), nullptr, nullptr, nullptr, nullptr,
+            bufferCast<float>(*mRepetitionPenaltiesDevice), bufferCast<float>(*mPresencePenaltiesDevice),
+            bufferCast<float>(*mFrequencyPenaltiesDevice), true, static_cast<size_t>(mBatchSize), 1, mSequenceLength,
+            static_cast<size_t>(mVocabSize), static_cast<size_t>(mVocabSizePadded),
+            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mIdsPtrDevice)), nullptr,
+            bufferCast<int32_t>(*mContextLengthDevice), bufferCast<int32_t>(*mContextLengthDevice), nullptr, nullptr,
+            bufferCast<int32_t>(*mBatchSlots), mStream->get(), nullptr, nullptr, 0, tokenCounts};
+        tk::invokeBatchApplyPenalty(contextParams);
+
+        auto currentLengthsHost = mBufferManager->copyFrom(*mContextLengthHost, MemoryType::kPINNED);
+        auto currentLengthsDevice = mBufferManager->copyFrom(*mContextLengthHost, MemoryType::kGPU);
+        auto nextStepIdsDevice = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize}), nvinfer1::DataType::kINT32);
+        auto activeSlots = mBufferManager->pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT32);
+        auto const batchSlotsPtr = bufferCast<int32_t>(*mBatchSlots);
+        auto currentLengthsPtr = bufferCast<int32_t>(*currentLengthsHost);
+        auto activeSlotsPtr = bufferCast<int32_t>(*activeSlots);
+        while (true)
+        {
+            SizeType numActive{0};
+            for (SizeType bi = 0; bi < mBatchSize; ++bi)
+            {
+                auto const batchSlot = batchSlotsPtr[bi];
+                if (currentLengthsPtr[batchSlot] < seqLengthsPtr[batchSlot])
+                {
+                    ++currentLengthsPtr[batchSlot];
+                    activeSlotsPtr[numActive++] = batchSlot;
+                }
+            }
+            if (numActive == 0)
+            {
+                break;
+            }
+            mBufferManager->copy(*currentLengthsHost, *currentLengthsDevice);
+            tk::invokeCopyNextStepIds(bufferCast<int32_t>(*nextStepIdsDevice),
+                reinterpret_cast<int32_t**>(bufferCast<int64_t>(*mIdsPtrDevice)),
+                bufferCast<int32_t>(*currentLengthsDevice), activeSlotsPtr, numActive, 1, mSequenceLength,
+                mStream->get(), tokenCounts);
+            // Active slots are rewritten on the host in the next iteration
+            mStream->synchronize();
+        }
+        return tokenCounts;
+    }
+
 public:
     void runTest(RepetitionPenaltyTestCase param)
     {
         subsetup(param);
+        auto const tokenCounts = param.useTokenCounts ? countTokens() : TokenCounts{};
         InvokeBatchApplyPenaltyParams<T> penalty_params{reinterpret_cast<T**>(bufferCast<int64_t>(*mLogitsPtrs)),
             bufferCast<T>(*mOutLogitsDevice), nullptr, bufferCast<int32_t>(*mPenaltyWorkspaceDevice), nullptr, nullptr,
             bufferCast<float>(*mRepetitionPenaltiesDevice), bufferCast<float>(*mPresencePenaltiesDevice),
@@ -578,7 +657,7 @@ public:
             static_cast<size_t>(mVocabSize), static_cast<size_t>(mVocabSizePadded),
             reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mIdsPtrDevice)), nullptr,
             bufferCast<int32_t>(*mContextLengthDevice), bufferCast<int32_t>(*mSeqLengthDevice), nullptr, nullptr,
-            bufferCast<int32_t>(*mBatchSlots), mStream->get()};
+            bufferCast<int32_t>(*mBatchSlots), mStream->get(), nullptr, nullptr, 0, tokenCounts};
         tk::invokeBatchApplyPenalty(penalty_params);
 
         auto logitsOutHost = mBufferManager->copyFrom(*mOutLogitsDevice, MemoryType::kCPU);
@@ -935,6 +1014,64 @@ TYPED_TEST(RepetitionPenaltyTest, PenaltyTypeFull)
                       .setFrequencyPenaltiesSize(maxBatchSize));
 }
 
+TYPED_TEST(RepetitionPenaltyTest, PenaltyTypeFullTokenCounts)
+{
+    int32_t batchSize = 6;
+    int32_t maxBatchSize = 2 * batchSize;
+    TensorPtr repetitionPenaltyHost
+        = this->mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kFLOAT);
+    TensorPtr presencePenaltyHost
+        = this->mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kFLOAT);
+    TensorPtr frequencyPenaltyHost
+        = this->mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kFLOAT);
+    for (int32_t i = 0; i < maxBatchSize; ++i)
+    {
+        bufferCast<float>(*repetitionPenaltyHost)[i] = 0.53 + i * 0.2f;
+        bufferCast<float>(*presencePenaltyHost)[i] = 0.53 + i * 0.2f;
+        bufferCast<float>(*frequencyPenaltyHost)[i] = 0.53 + i * 0.2f;
+    }
+    this->runTest(RepetitionPenaltyTestCase()
+                      .setBatchSize(batchSize)
+                      .setVocabSize(4)
+                      .setMaxInputLength(5)
+                      .setRepetitionPenalties(repetitionPenaltyHost)
+                      .setPresencePenalties(presencePenaltyHost)
+                      .setFrequencyPenalties(frequencyPenaltyHost)
+                      .setRepetitionPenaltiesSize(maxBatchSize)
+                      .setPresencePenaltiesSize(maxBatchSize)
+                      .setFrequencyPenaltiesSize(maxBatchSize)
+                      .setUseTokenCounts(true));
+}
+
+TYPED_TEST(RepetitionPenaltyTest, LargeVocabTokenCounts)
+{
+    int32_t batchSize = 6;
+    int32_t maxBatchSize = 2 * batchSize;
+    TensorPtr repetitionPenaltyHost
+        = this->mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kFLOAT);
+    TensorPtr presencePenaltyHost
+        = this->mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kFLOAT);
+    TensorPtr frequencyPenaltyHost
+        = this->mBufferManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kFLOAT);
+    for (int32_t i = 0; i < maxBatchSize; ++i)
+    {
+        bufferCast<float>(*repetitionPenaltyHost)[i] = 0.53 + i * 0.2f;
+        bufferCast<float>(*presencePenaltyHost)[i] = 0.53 + i * 0.2f;
+        bufferCast<float>(*frequencyPenaltyHost)[i] = 0.53 + i * 0.2f;
+    }
+    this->runTest(RepetitionPenaltyTestCase()
+                      .setBatchSize(batchSize)
+                      .setVocabSize(32000)
+                      .setMaxInputLength(200)
+                      .setRepetitionPenalties(repetitionPenaltyHost)
+                      .setPresencePenalties(presencePenaltyHost)
+                      .setFrequencyPenalties(frequencyPenaltyHost)
+                      .setRepetitionPenaltiesSize(maxBatchSize)
+                      .setPresencePenaltiesSize(maxBatchSize)
+                      .setFrequencyPenaltiesSize(maxBatchSize)
+                      .setUseTokenCounts(true));
+}
+
 struct MinLengthPenaltyTestParams
 {
     int32_t batchSize;
@@ -1144,4 +1281,177 @@ TYPED_TEST(MinLengthPenaltyTest, BatchMaxSeqLen64)
     this->runTest(MinLengthPenaltyTestParams().setBatchSize(16).setVocabSize(51200).setMaxSeqLength(64));
 }
 
+template <typename T>
+class BadWordsPenaltyTest : public SamplingKernelTest<T>
+{
+protected:
+    using SamplingKernelTest<T>::mBufferManager;
+    using SamplingKernelTest<T>::mStream;
+
+public:
+    void runTest()
+    {
+        auto const dataType = TRTDataType<T>::value;
+        int32_t constexpr batchSize = 2;
+        int32_t constexpr vocabSize = 10;
+        int32_t constexpr maxSeqLen = 4;
+        int32_t constexpr currentStep = 2;
+        auto const vocabSizePadded = static_cast<int32_t>(padVocabSize(vocabSize));
+
+        auto logitsHost = mBufferManager->pinned(ITensor::makeShape({batchSize, vocabSizePadded}), dataType);
+        initLogitsAndBias(bufferCast<T>(*logitsHost), static_cast<T*>(nullptr), batchSize, vocabSize, vocabSizePadded);
+        TensorPtr logitsDevice = mBufferManager->copyFrom(*logitsHost, MemoryType::kGPU);
+        TensorPtr outLogitsDevice = mBufferManager->gpu(ITensor::makeShape({batchSize, vocabSizePadded}), dataType);
+        TensorPtr logitsPtrs = mBufferManager->pinned(ITensor::makeShape({batchSize}), TRTDataType<T*>::value);
+        TensorPtr penaltyWorkspaceDevice
+            = mBufferManager->gpu(ITensor::makeShape({batchSize, vocabSize}), nvinfer1::DataType::kINT32);
+        mBufferManager->setZero(*penaltyWorkspaceDevice);
+
+        // The last generated token is 5 for request 0 and 4 for request 1.
+        std::vector<int32_t> const outputIds{1, 5, 0, 0, 2, 4, 0, 0};
+        // Request 0 bans {3} and {5, 7}, request 1 bans {5, 7}. Rows are [tokens, offsets].
+        std::vector<int32_t> const badWords0{3, 5, 7, 1, 3, -1};
+        std::vector<int32_t> const badWords1{5, 7, 2, -1};
+        std::vector<int32_t> const badWordsLens{3, 2};
+        std::vector<int32_t> const sequenceLengths{currentStep, currentStep};
+        auto outputIdsDevice = mBufferManager->copyFrom(outputIds, MemoryType::kGPU);
+        auto badWords0Device = mBufferManager->copyFrom(badWords0, MemoryType::kGPU);
+        auto badWords1Device = mBufferManager->copyFrom(badWords1, MemoryType::kGPU);
+        auto badWordsLensDevice = mBufferManager->copyFrom(badWordsLens, MemoryType::kGPU);
+        auto sequenceLengthsDevice = mBufferManager->copyFrom(sequenceLengths, MemoryType::kGPU);
+
+        TensorPtr outputIdsPtrs
+            = mBufferManager->pinned(ITensor::makeShape({batchSize}), TRTDataType<int32_t*>::value);
+        TensorPtr badWordsPtrs = mBufferManager->pinned(ITensor::makeShape({batchSize}), TRTDataType<int32_t*>::value);
+        auto logitsPtrsRange = BufferRange<T*>(*logitsPtrs);
+        auto outputIdsPtrsRange = BufferRange<int32_t*>(*outputIdsPtrs);
+        auto badWordsPtrsRange = BufferRange<int32_t*>(*badWordsPtrs);
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            logitsPtrsRange[bi] = bufferCast<T>(*logitsDevice) + bi * vocabSizePadded;
+            outputIdsPtrsRange[bi] = bufferCast<int32_t>(*outputIdsDevice) + bi * maxSeqLen;
+        }
+        badWordsPtrsRange[0] = bufferCast<int32_t>(*badWords0Device);
+        badWordsPtrsRange[1] = bufferCast<int32_t>(*badWords1Device);
+
+        InvokeBatchApplyPenaltyParams<T> penaltyParams{reinterpret_cast<T**>(bufferCast<int64_t>(*logitsPtrs)),
+            bufferCast<T>(*outLogitsDevice), nullptr, bufferCast<int32_t>(*penaltyWorkspaceDevice), nullptr, nullptr,
+            nullptr, nullptr, nullptr, false, static_cast<size_t>(batchSize), 1, maxSeqLen,
+            static_cast<size_t>(vocabSize), static_cast<size_t>(vocabSizePadded),
+            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*outputIdsPtrs)), nullptr, nullptr,
+            bufferCast<int32_t>(*sequenceLengthsDevice), nullptr, nullptr, nullptr, mStream->get(),
+            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*badWordsPtrs)),
+            bufferCast<int32_t>(*badWordsLensDevice), 3};
+        tk::invokeBatchApplyPenalty(penaltyParams);
+        auto logitsOutHost = mBufferManager->copyFrom(*outLogitsDevice, MemoryType::kCPU);
+        mStream->synchronize();
+
+        auto const* inLogits = bufferCast<T>(*logitsHost);
+        auto const* outLogits = bufferCast<T>(*logitsOutHost);
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            for (SizeType vi = 0; vi < vocabSize; ++vi)
+            {
+                auto const idx = bi * vocabSizePadded + vi;
+                auto const banned = bi == 0 && (vi == 3 || vi == 7);
+                if (banned)
+                {
+                    EXPECT_TRUE(std::isinf(static_cast<float>(outLogits[idx]))) << "batch " << bi << " token " << vi;
+                }
+                else
+                {
+                    EXPECT_EQ(static_cast<float>(outLogits[idx]), static_cast<float>(inLogits[idx]))
+                        << "batch " << bi << " token " << vi;
+                }
+            }
+        }
+    }
+};
+
+TYPED_TEST_SUITE(BadWordsPenaltyTest, FloatAndHalfTypes);
+
+TYPED_TEST(BadWordsPenaltyTest, FusedWithPenalties)
+{
+    this->runTest();
+}
+
+template <typename T>
+class AllowedTokensPenaltyTest : public SamplingKernelTest<T>
+{
+protected:
+    using SamplingKernelTest<T>::mBufferManager;
+    using SamplingKernelTest<T>::mStream;
+
+public:
+    void runTest()
+    {
+        auto const dataType = TRTDataType<T>::value;
+        int32_t constexpr batchSize = 2;
+        int32_t constexpr vocabSize = 10;
+        int32_t constexpr maxSeqLen = 4;
+        int32_t constexpr maxNumAllowedTokens = 3;
+        float constexpr softCap = 2.f;
+        auto const vocabSizePadded = static_cast<int32_t>(padVocabSize(vocabSize));
+
+        auto logitsHost = mBufferManager->pinned(ITensor::makeShape({batchSize, vocabSizePadded}), dataType);
+        initLogitsAndBias(bufferCast<T>(*logitsHost), static_cast<T*>(nullptr), batchSize, vocabSize, vocabSizePadded);
+        TensorPtr logitsDevice = mBufferManager->copyFrom(*logitsHost, MemoryType::kGPU);
+        TensorPtr outLogitsDevice = mBufferManager->gpu(ITensor::makeShape({batchSize, vocabSizePadded}), dataType);
+        TensorPtr logitsPtrs = mBufferManager->pinned(ITensor::makeShape({batchSize}), TRTDataType<T*>::value);
+        auto logitsPtrsRange = BufferRange<T*>(*logitsPtrs);
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            logitsPtrsRange[bi] = bufferCast<T>(*logitsDevice) + bi * vocabSizePadded;
+        }
+
+        // Request 0 may only generate {2, 5, 7} and is soft-capped, request 1 is unrestricted.
+        std::vector<int32_t> const allowedTokens{2, 5, 7, 0, 0, 0};
+        std::vector<int32_t> const numAllowedTokens{3, 0};
+        std::vector<float> const softCaps{softCap, 0.f};
+        auto allowedTokensDevice = mBufferManager->copyFrom(allowedTokens, MemoryType::kGPU);
+        auto numAllowedTokensDevice = mBufferManager->copyFrom(numAllowedTokens, MemoryType::kGPU);
+        auto softCapsDevice = mBufferManager->copyFrom(softCaps, MemoryType::kGPU);
+
+        InvokeBatchApplyPenaltyParams<T> penaltyParams{reinterpret_cast<T**>(bufferCast<int64_t>(*logitsPtrs)),
+            bufferCast<T>(*outLogitsDevice), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, false,
+            static_cast<size_t>(batchSize), 1, maxSeqLen, static_cast<size_t>(vocabSize),
+            static_cast<size_t>(vocabSizePadded), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+            mStream->get(), nullptr, nullptr, 0, TokenCounts{}, bufferCast<float>(*softCapsDevice),
+            AllowedTokens{bufferCast<int32_t>(*allowedTokensDevice), bufferCast<int32_t>(*numAllowedTokensDevice),
+                maxNumAllowedTokens}};
+        tk::invokeBatchApplyPenalty(penaltyParams);
+        auto logitsOutHost = mBufferManager->copyFrom(*outLogitsDevice, MemoryType::kCPU);
+        mStream->synchronize();
+
+        auto const maskValue = std::is_same_v<T, half> ? -HALF_FLT_MAX : -FLT_MAX;
+        auto const* inLogits = bufferCast<T>(*logitsHost);
+        auto const* outLogits = bufferCast<T>(*logitsOutHost);
+        for (SizeType vi = 0; vi < vocabSizePadded; ++vi)
+        {
+            auto const allowed = vi == 2 || vi == 5 || vi == 7;
+            if (allowed)
+            {
+                auto const expected = softCap * std::tanh(static_cast<float>(inLogits[vi]) / softCap);
+                EXPECT_NEAR(static_cast<float>(outLogits[vi]), expected, 1e-2f) << "token " << vi;
+            }
+            else
+            {
+                EXPECT_EQ(static_cast<float>(outLogits[vi]), maskValue) << "token " << vi;
+            }
+        }
+        for (SizeType vi = 0; vi < vocabSize; ++vi)
+        {
+            auto const idx = vocabSizePadded + vi;
+            EXPECT_EQ(static_cast<float>(outLogits[idx]), static_cast<float>(inLogits[idx])) << "token " << vi;
+        }
+    }
+};
+
+TYPED_TEST_SUITE(AllowedTokensPenaltyTest, FloatAndHalfTypes);
+
+TYPED_TEST(AllowedTokensPenaltyTest, SoftCappedSubset)
+{
+    this->runTest();
+}
+
 } // namespace
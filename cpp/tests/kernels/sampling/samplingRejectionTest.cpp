@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOP_LEVEL_DIR
+#error "Define TOP_LEVEL_DIR"
+#endif
+
+#include "tensorrt_llm/kernels/samplingRejectionKernels.h"
+#include "tests/kernels/sampling/samplingTest.h"
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+using namespace tensorrt_llm::tests::kernels::sampling;
+
+namespace
+{
+
+template <typename T>
+class RejectionSamplingKernelTest : public SamplingKernelTest<T>
+{
+
+protected:
+    using SamplingKernelTest<T>::mStream;
+
+private:
+    size_t getWorkspaceSize(const SamplingKernelTestParam& params) override
+    {
+        // The rejection sampler does not need a workspace
+        return 0;
+    }
+
+    void callTestedFunction(const SamplingKernelTestParam& params, bool hasDiffRuntimeArgs, size_t workspaceSize,
+        tensorrt_llm::runtime::ITensor::SharedPtr& workspaceDevice) override
+    {
+        auto const maxBatchSize = 2 * params.batchSize;
+        tk::invokeBatchRejectionTopKTopPSampling<T>(bufferCast<int*>(*this->mIdsPtrHost),
+            bufferCast<int32_t>(*this->mSeqLengthsDevice),
+            reinterpret_cast<tensorrt_llm::kernels::FinishedState*>(
+                bufferCast<tensorrt_llm::kernels::FinishedState::UnderlyingType>(*this->mFinishedDevice)),
+            reinterpret_cast<tensorrt_llm::kernels::FinishedState*>(
+                bufferCast<tensorrt_llm::kernels::FinishedState::UnderlyingType>(*this->mFinishedDevice)),
+            bufferCast<float>(*this->mCumLogProbsDevice), bufferCast<float>(*this->mOutputLogProbsDevice),
+            bufferCast<T>(*this->mProbsDevice), this->mCurandStatesDevice, params.batchSize, maxBatchSize,
+            params.vocabSize, bufferCast<int32_t>(*this->mEndIdsDevice), this->mMaxTopK,
+            hasDiffRuntimeArgs ? reinterpret_cast<std::uint32_t const*>(bufferCast<int32_t>(*this->mTopKsDevice))
+                               : nullptr,
+            this->mMaxTopP, hasDiffRuntimeArgs ? bufferCast<float>(*this->mTopPsDevice) : nullptr,
+            this->mStream->get(), bufferCast<bool>(*this->mSkipDecodeDevice), bufferCast<int32_t>(*this->mBatchSlots));
+    }
+};
+
+TYPED_TEST_SUITE(RejectionSamplingKernelTest, FloatAndHalfTypes);
+
+TYPED_TEST(RejectionSamplingKernelTest, CorrectnessGreedy)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(1).setTopP(1.0f).setOutputLen(1));
+};
+
+TYPED_TEST(RejectionSamplingKernelTest, CorrectnessSmallP)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(0).setTopP(0.2f).setOutputLen(1));
+};
+
+TYPED_TEST(RejectionSamplingKernelTest, CorrectnessTopKTopP)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(2).setTopP(0.9f).setOutputLen(1));
+};
+
+TYPED_TEST(RejectionSamplingKernelTest, CorrectnessLargeVocabSmallP)
+{
+    this->runTest(
+        SamplingKernelTestParam().setBatchSize(32).setVocabSize(151936).setTopK(0).setTopP(0.2f).setOutputLen(16));
+};
+
+TYPED_TEST(RejectionSamplingKernelTest, CorrectnessLargeVocabLargeP)
+{
+    this->runTest(
+        SamplingKernelTestParam().setBatchSize(32).setVocabSize(151936).setTopK(0).setTopP(0.9f).setOutputLen(16));
+};
+
+} // end of namespace
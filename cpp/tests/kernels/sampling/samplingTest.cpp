@@ -105,7 +105,7 @@ void SamplingKernelTest<T>::setupBuffers(int32_t batchSize, int32_t maxBatchSize
     }
 
     // Allocate and init curand states
-    cudaMalloc(&mCurandStatesDevice, sizeof(curandState_t) * maxBatchSize);
+    cudaMalloc(&mCurandStatesDevice, sizeof(tk::PhiloxState) * maxBatchSize);
     tk::invokeCurandInitialize(mCurandStatesDevice, batchSlotsPtr, batchSize, mSeed, mStream->get());
 
     std::uniform_real_distribution<> skipDecodeDist(0, 1); // uniform distribution between 0 and 1
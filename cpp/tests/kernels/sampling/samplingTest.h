@@ -319,7 +319,7 @@ protected:
     int32_t mMaxTopK;
     float mMaxTopP;
 
-    curandState_t* mCurandStatesDevice;
+    tensorrt_llm::kernels::PhiloxState* mCurandStatesDevice;
 };
 
 } // namespace tensorrt_llm::tests::kernels::sampling
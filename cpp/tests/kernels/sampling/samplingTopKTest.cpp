@@ -120,4 +120,69 @@ TYPED_TEST(TopKSamplingKernelTest, NotSupportedLargerThanK1024)
         std::domain_error);
 };
 
+template <typename T>
+class GreedySearchKernelTest : public SamplingKernelTest<T>
+{
+
+protected:
+    size_t getWorkspaceSize(const SamplingKernelTestParam& params) override
+    {
+        return 0;
+    }
+
+    void callTestedFunction(const SamplingKernelTestParam& params, bool hasDiffRuntimeArgs, size_t workspaceSize,
+        tensorrt_llm::runtime::ITensor::SharedPtr& workspaceDevice) override
+    {
+        auto const maxBatchSize = 2 * params.batchSize;
+        // Without probabilities the kernel computes the log probs from the logits
+        auto logProbsDevice = this->mProbsDevice;
+        if (!params.logitsHasProbs)
+        {
+            mLogitsDevice = this->mBufferManager->copyFrom(*this->mLogitsHost, MemoryType::kGPU);
+            logProbsDevice = mLogitsDevice;
+        }
+        // The topKs of different runtime args are mostly larger than 1, all requests are greedy here
+        tk::invokeBatchGreedySearch(bufferCast<T>(*logProbsDevice), bufferCast<int*>(*this->mIdsPtrHost),
+            bufferCast<int32_t>(*this->mSeqLengthsDevice),
+            reinterpret_cast<tensorrt_llm::kernels::FinishedState*>(
+                bufferCast<tensorrt_llm::kernels::FinishedState::UnderlyingType>(*this->mFinishedDevice)),
+            reinterpret_cast<tensorrt_llm::kernels::FinishedState*>(
+                bufferCast<tensorrt_llm::kernels::FinishedState::UnderlyingType>(*this->mFinishedDevice)),
+            bufferCast<float>(*this->mCumLogProbsDevice), bufferCast<float>(*this->mOutputLogProbsDevice), nullptr,
+            params.vocabSize, bufferCast<int32_t>(*this->mEndIdsDevice), bufferCast<int32_t>(*this->mBatchSlots),
+            this->mStream->get(), params.batchSize, maxBatchSize, bufferCast<bool>(*this->mSkipDecodeDevice),
+            params.normalizeLogProbs, params.logitsHasProbs);
+    }
+
+    // Kept until the next step, the kernel reads it asynchronously
+    typename SamplingKernelTest<T>::TensorPtr mLogitsDevice;
+};
+
+TYPED_TEST_SUITE(GreedySearchKernelTest, FloatAndHalfTypes);
+
+TYPED_TEST(GreedySearchKernelTest, Correctness)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(1).setTopP(1.0f).setOutputLen(1));
+};
+
+TYPED_TEST(GreedySearchKernelTest, CorrectnessLarge)
+{
+    this->runTest(
+        SamplingKernelTestParam().setBatchSize(16).setVocabSize(51200).setTopK(1).setTopP(1.0f).setOutputLen(8));
+};
+
+TYPED_TEST(GreedySearchKernelTest, CorrectnessUnalignedVocab)
+{
+    this->runTest(
+        SamplingKernelTestParam().setBatchSize(16).setVocabSize(32001).setTopK(1).setTopP(1.0f).setOutputLen(8));
+};
+
+TYPED_TEST(GreedySearchKernelTest, CorrectnessFromLogits)
+{
+    auto params
+        = SamplingKernelTestParam().setBatchSize(16).setVocabSize(51200).setTopK(1).setTopP(1.0f).setOutputLen(8);
+    params.logitsHasProbs = false;
+    this->runTest(params);
+};
+
 } // end of namespace
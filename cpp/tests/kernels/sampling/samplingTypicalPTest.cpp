@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOP_LEVEL_DIR
+#error "Define TOP_LEVEL_DIR"
+#endif
+
+#include "tensorrt_llm/kernels/samplingTypicalPKernels.h"
+#include "tests/kernels/sampling/samplingTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+using namespace tensorrt_llm::tests::kernels::sampling;
+
+namespace
+{
+
+// Smallest set of tokens with the information content closest to the entropy reaching a mass of typicalP
+std::set<int32_t> computeKeptTokens(std::vector<float> const& probs, float typicalP)
+{
+    float entropy = 0.f;
+    std::vector<std::pair<float, int32_t>> distances;
+    for (size_t vi = 0; vi < probs.size(); ++vi)
+    {
+        if (probs[vi] > 0.f)
+        {
+            entropy -= probs[vi] * std::log(probs[vi]);
+        }
+    }
+    for (size_t vi = 0; vi < probs.size(); ++vi)
+    {
+        if (probs[vi] > 0.f)
+        {
+            distances.emplace_back(std::abs(-std::log(probs[vi]) - entropy), static_cast<int32_t>(vi));
+        }
+    }
+    std::sort(distances.begin(), distances.end());
+    std::set<int32_t> keptTokens;
+    float mass = 0.f;
+    for (auto const& [distance, tokenId] : distances)
+    {
+        keptTokens.insert(tokenId);
+        mass += probs[tokenId];
+        if (mass >= typicalP)
+        {
+            break;
+        }
+    }
+    return keptTokens;
+}
+
+template <typename T>
+class TypicalPSamplingKernelTest : public SamplingKernelTest<T>
+{
+protected:
+    using SamplingKernelTest<T>::mBufferManager;
+    using SamplingKernelTest<T>::mStream;
+    using TensorPtr = typename SamplingKernelTest<T>::TensorPtr;
+
+public:
+    // Runs the kernel for numSteps steps with one typical-p value per request and checks all sampled tokens.
+    void runTest(std::vector<float> const& params)
+    {
+        auto const dataType = TRTDataType<T>::value;
+        std::vector<float> const probsRow{0.4f, 0.3f, 0.15f, 0.1f, 0.05f, 0.f, 0.f, 0.f};
+        auto const batchSize = static_cast<int32_t>(params.size());
+        auto const vocabSize = static_cast<int32_t>(probsRow.size());
+        int32_t constexpr numSteps = 64;
+
+        auto probsHost = mBufferManager->pinned(ITensor::makeShape({batchSize, vocabSize}), dataType);
+        auto probsHostPtr = bufferCast<T>(*probsHost);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                probsHostPtr[bi * vocabSize + vi] = static_cast<T>(probsRow[vi]);
+            }
+        }
+        TensorPtr probsDevice = mBufferManager->copyFrom(*probsHost, MemoryType::kGPU);
+
+        auto paramsDevice = mBufferManager->copyFrom(params, MemoryType::kGPU);
+        // End id is out of the vocabulary, so that every step appends a token
+        auto endIdsDevice = mBufferManager->copyFrom(std::vector<int32_t>(batchSize, vocabSize), MemoryType::kGPU);
+        auto seqLengthsDevice = mBufferManager->gpu(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        mBufferManager->setZero(*seqLengthsDevice);
+        TensorPtr outputIdsDevice
+            = mBufferManager->gpu(ITensor::makeShape({batchSize, numSteps}), nvinfer1::DataType::kINT32);
+        TensorPtr idsPtrHost = mBufferManager->pinned(ITensor::makeShape({batchSize}), TRTDataType<int32_t*>::value);
+        auto idsPtrRange = BufferRange<int32_t*>(*idsPtrHost);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            idsPtrRange[bi] = bufferCast<int32_t>(*outputIdsDevice) + bi * numSteps;
+        }
+
+        tk::PhiloxState* curandStatesDevice;
+        cudaMalloc(&curandStatesDevice, sizeof(tk::PhiloxState) * batchSize);
+        tk::invokeCurandInitialize(curandStatesDevice, nullptr, batchSize, 0, mStream->get());
+
+        for (int32_t step = 0; step < numSteps; ++step)
+        {
+            tk::invokeBatchTypicalPSampling<T>(reinterpret_cast<int**>(bufferCast<int64_t>(*idsPtrHost)),
+                bufferCast<int32_t>(*seqLengthsDevice), nullptr, nullptr, nullptr, nullptr,
+                bufferCast<T>(*probsDevice), curandStatesDevice, batchSize, batchSize, vocabSize,
+                bufferCast<int32_t>(*endIdsDevice), bufferCast<float>(*paramsDevice), mStream->get(), nullptr,
+                nullptr);
+        }
+        auto outputIdsHost = mBufferManager->copyFrom(*outputIdsDevice, MemoryType::kCPU);
+        auto seqLengthsHost = mBufferManager->copyFrom(*seqLengthsDevice, MemoryType::kCPU);
+        mStream->synchronize();
+        cudaFree(curandStatesDevice);
+
+        auto const outputIds = bufferCast<int32_t>(*outputIdsHost);
+        auto const seqLengths = bufferCast<int32_t>(*seqLengthsHost);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            EXPECT_EQ(seqLengths[bi], numSteps);
+            auto const keptTokens = computeKeptTokens(probsRow, params[bi]);
+            std::set<int32_t> sampledTokens;
+            for (int32_t step = 0; step < numSteps; ++step)
+            {
+                auto const tokenId = outputIds[bi * numSteps + step];
+                EXPECT_TRUE(keptTokens.count(tokenId) > 0)
+                    << "batch " << bi << " step " << step << " token " << tokenId;
+                sampledTokens.insert(tokenId);
+            }
+            if (keptTokens.size() > 2)
+            {
+                // Sampling must not degenerate into greedy search
+                EXPECT_GT(sampledTokens.size(), 1);
+            }
+        }
+    }
+};
+
+TYPED_TEST_SUITE(TypicalPSamplingKernelTest, FloatAndHalfTypes);
+
+TYPED_TEST(TypicalPSamplingKernelTest, Correctness)
+{
+    this->runTest({0.2f, 0.5f, 0.9f, 1.f});
+}
+
+} // namespace
@@ -17,6 +17,7 @@
 #error "Define TOP_LEVEL_DIR"
 #endif
 
+#include "tensorrt_llm/kernels/samplingUtils.cuh"
 #include "tests/kernels/sampling/samplingTest.h"
 #include <random>
 
@@ -31,12 +32,12 @@ namespace
 
 static float constexpr HALF_FLT_MAX = 65504.F;
 
-__global__ void generateRandomNumber(int32_t* vals, curandState_t* states, const int batch_size)
+__global__ void generateRandomNumber(int32_t* vals, tk::PhiloxState* states, const int batch_size)
 {
     int idx = threadIdx.x;
     if (idx < batch_size)
     {
-        vals[idx] = curand(states + idx);
+        vals[idx] = tk::philoxRandom(states + idx);
     }
 }
 
@@ -50,8 +51,8 @@ TEST_F(SamplingUtilsKernelTest, CurandInitialize)
 
     auto initSeedAndGenerateNumbers = [batchSize, this](uint64_t seed) -> auto
     {
-        curandState_t* curandStates;
-        cudaMalloc(&curandStates, sizeof(curandState_t) * batchSize);
+        tk::PhiloxState* curandStates;
+        cudaMalloc(&curandStates, sizeof(tk::PhiloxState) * batchSize);
         // Initialize curand states.
         tk::invokeCurandInitialize(curandStates, nullptr, batchSize, seed, this->mStream->get());
         sync_check_cuda_error();
@@ -90,12 +91,41 @@ TEST_F(SamplingUtilsKernelTest, CurandInitialize)
     }
 }
 
+TEST_F(SamplingUtilsKernelTest, CurandInitializeIndependentOfSlot)
+{
+    int32_t batchSize = 64;
+
+    tk::PhiloxState* curandStates;
+    cudaMalloc(&curandStates, sizeof(tk::PhiloxState) * batchSize);
+    tk::invokeCurandInitialize(curandStates, nullptr, batchSize, 1234, mStream->get());
+
+    // Consecutive draws advance the counter of the state
+    auto randValsDevice = mBufferManager->gpu(ITensor::makeShape({2, batchSize}), nvinfer1::DataType::kINT32);
+    auto randValsPtr = bufferCast<int32_t>(*randValsDevice);
+    generateRandomNumber<<<1, batchSize, 0, mStream->get()>>>(randValsPtr, curandStates, batchSize);
+    generateRandomNumber<<<1, batchSize, 0, mStream->get()>>>(randValsPtr + batchSize, curandStates, batchSize);
+    auto const randValsHost = mBufferManager->copyFrom(*randValsDevice, MemoryType::kCPU);
+    mStream->synchronize();
+    auto const randValsHostPtr = bufferCast<int32_t>(*randValsHost);
+
+    for (int32_t i = 0; i < batchSize; ++i)
+    {
+        // All slots seeded with the same seed draw the same numbers
+        EXPECT_EQ(randValsHostPtr[i], randValsHostPtr[0]) << "Fail at slot " << i;
+        EXPECT_EQ(randValsHostPtr[batchSize + i], randValsHostPtr[batchSize]) << "Fail at slot " << i;
+    }
+    EXPECT_NE(randValsHostPtr[0], randValsHostPtr[batchSize]);
+
+    cudaFree(curandStates);
+    sync_check_cuda_error();
+}
+
 TEST_F(SamplingUtilsKernelTest, CurandBatchInitialize)
 {
     int32_t batchSize = 127;
 
-    curandState_t* curandStates;
-    cudaMalloc(&curandStates, sizeof(curandState_t) * batchSize);
+    tk::PhiloxState* curandStates;
+    cudaMalloc(&curandStates, sizeof(tk::PhiloxState) * batchSize);
 
     auto randomSeedsHost = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT64);
     auto randomSeedsHostPtr = bufferCast<int64_t>(*randomSeedsHost);
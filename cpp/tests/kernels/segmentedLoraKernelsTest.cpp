@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/segmentedLoraKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class SegmentedLoraKernelTest : public testing::Test
+{
+public:
+    static auto constexpr kInHiddenSize = 64;
+    static auto constexpr kOutHiddenSize = 96;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Tokens of segment i use adapter i, a rank of 0 disables the adapter. Compares with a reference on the host.
+    void runTest(std::vector<int32_t> const& segmentLengths, std::vector<int32_t> const& ranks)
+    {
+        auto const numAdapters = static_cast<int32_t>(ranks.size());
+        std::vector<int32_t> offsets{0};
+        for (auto const length : segmentLengths)
+        {
+            offsets.push_back(offsets.back() + length);
+        }
+        // One trailing token without an adapter
+        auto const numTokens = offsets.back() + 1;
+        auto const maxRank = *std::max_element(ranks.begin(), ranks.end());
+
+        auto const fill = [](ITensor& tensor, uint32_t seed)
+        {
+            auto* ptr = bufferCast<float>(tensor);
+            for (size_t idx = 0; idx < tensor.getSize(); ++idx)
+            {
+                ptr[idx] = static_cast<float>((idx * 2654435761u + seed) % 1000) / 500.f - 1.f;
+            }
+        };
+
+        auto input = mBufferManager->pinned(ITensor::makeShape({numTokens, kInHiddenSize}), nvinfer1::DataType::kFLOAT);
+        fill(*input, 1);
+        auto output
+            = mBufferManager->pinned(ITensor::makeShape({numTokens, kOutHiddenSize}), nvinfer1::DataType::kFLOAT);
+        mBufferManager->setZero(*output);
+        auto lowRank = mBufferManager->gpu(ITensor::makeShape({numTokens, maxRank}), nvinfer1::DataType::kFLOAT);
+
+        std::vector<ITensor::SharedPtr> inWeights;
+        std::vector<ITensor::SharedPtr> outWeights;
+        auto weightsPtrs = mBufferManager->pinned(ITensor::makeShape({numAdapters, 2}), nvinfer1::DataType::kINT64);
+        auto* weightsPtrsPtr = bufferCast<int64_t>(*weightsPtrs);
+        for (int32_t a = 0; a < numAdapters; ++a)
+        {
+            auto const rank = std::max(ranks[a], 1);
+            inWeights.emplace_back(
+                mBufferManager->pinned(ITensor::makeShape({rank, kInHiddenSize}), nvinfer1::DataType::kFLOAT));
+            outWeights.emplace_back(
+                mBufferManager->pinned(ITensor::makeShape({kOutHiddenSize, rank}), nvinfer1::DataType::kFLOAT));
+            fill(*inWeights.back(), 7 * a + 2);
+            fill(*outWeights.back(), 11 * a + 3);
+            weightsPtrsPtr[2 * a] = reinterpret_cast<int64_t>(inWeights.back()->data());
+            weightsPtrsPtr[2 * a + 1] = reinterpret_cast<int64_t>(outWeights.back()->data());
+        }
+
+        auto adapterRanks = mBufferManager->copyFrom(ranks, ITensor::makeShape({numAdapters}), MemoryType::kGPU);
+        auto segmentOffsets = mBufferManager->copyFrom(
+            offsets, ITensor::makeShape({static_cast<SizeType>(offsets.size())}), MemoryType::kGPU);
+        auto tokenAdapterIdx = mBufferManager->pinned(ITensor::makeShape({numTokens}), nvinfer1::DataType::kINT32);
+
+        tk::invokeBuildTokenAdapterIdx(bufferCast<int32_t>(*tokenAdapterIdx), bufferCast<int32_t>(*segmentOffsets),
+            numAdapters, numTokens, mStream->get());
+
+        tk::SegmentedLoraParams params;
+        params.input = input->data();
+        params.output = output->data();
+        params.lowRank = lowRank->data();
+        params.tokenAdapterIdx = bufferCast<int32_t>(*tokenAdapterIdx);
+        params.adapterRanks = bufferCast<int32_t>(*adapterRanks);
+        params.adapterWeightsPtrs = weightsPtrsPtr;
+        params.numTokens = numTokens;
+        params.inHiddenSize = kInHiddenSize;
+        params.outHiddenSize = kOutHiddenSize;
+        params.maxLowRank = maxRank;
+        tk::invokeSegmentedLoraGemm<float>(params, mStream->get());
+        mStream->synchronize();
+
+        auto const* tokenAdapterIdxPtr = bufferCast<int32_t>(*tokenAdapterIdx);
+        auto const* inputPtr = bufferCast<float>(*input);
+        auto const* outputPtr = bufferCast<float>(*output);
+        for (int32_t t = 0; t < numTokens; ++t)
+        {
+            auto const expectedAdapter = t < offsets.back()
+                ? static_cast<int32_t>(std::upper_bound(offsets.begin(), offsets.end(), t) - offsets.begin()) - 1
+                : -1;
+            ASSERT_EQ(tokenAdapterIdxPtr[t], expectedAdapter) << "token " << t;
+
+            auto const rank = expectedAdapter < 0 ? 0 : ranks[expectedAdapter];
+            std::vector<float> y(rank, 0.f);
+            for (int32_t r = 0; r < rank; ++r)
+            {
+                auto const* a = bufferCast<float>(*inWeights[expectedAdapter]) + r * kInHiddenSize;
+                for (int32_t k = 0; k < kInHiddenSize; ++k)
+                {
+                    y[r] += inputPtr[t * kInHiddenSize + k] * a[k];
+                }
+            }
+            for (int32_t n = 0; n < kOutHiddenSize; ++n)
+            {
+                float expected = 0.f;
+                for (int32_t r = 0; r < rank; ++r)
+                {
+                    expected += y[r] * bufferCast<float>(*outWeights[expectedAdapter])[n * rank + r];
+                }
+                EXPECT_NEAR(outputPtr[t * kOutHiddenSize + n], expected, 1e-3f * std::max(1.f, std::abs(expected)))
+                    << "token " << t << " n " << n;
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+};
+
+TEST_F(SegmentedLoraKernelTest, decodeTokens)
+{
+    runTest({1, 1, 1, 1}, {8, 16, 8, 64});
+}
+
+TEST_F(SegmentedLoraKernelTest, sharedAdaptersAndMixedRanks)
+{
+    runTest({3, 1, 5, 2}, {8, 128, 0, 4});
+}
+
+TEST_F(SegmentedLoraKernelTest, unalignedRanks)
+{
+    runTest({2, 2}, {3, 5});
+}
+
+} // namespace
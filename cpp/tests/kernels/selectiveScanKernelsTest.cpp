@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/selectiveScan.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Pseudo-random values in [low, high)
+void fill(ITensor& tensor, unsigned seed, float low, float high)
+{
+    auto* ptr = bufferCast<float>(tensor);
+    for (size_t idx = 0; idx < tensor.getSize(); ++idx)
+    {
+        ptr[idx] = low + (high - low) * static_cast<float>((idx * 2654435761u + seed * 40503u) % 1000) / 1000.f;
+    }
+}
+
+double silu(double value)
+{
+    return value / (1. + std::exp(-value));
+}
+
+class SelectiveScanChunkedTest : public testing::Test
+{
+public:
+    static auto constexpr kDim = 256;
+    static auto constexpr kDState = 16;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Compares the chunked scan with a sequential scan on the host
+    void runTest(int32_t batch, int32_t seqLen)
+    {
+        auto const tokens = static_cast<SizeType>(batch * seqLen);
+        auto makeTensor = [this](std::initializer_list<SizeType> dims)
+        { return mBufferManager->pinned(ITensor::makeShape(dims), nvinfer1::DataType::kFLOAT); };
+        auto x = makeTensor({tokens, kDim});
+        auto dt = makeTensor({tokens, kDim});
+        auto z = makeTensor({tokens, kDim});
+        auto B = makeTensor({tokens, kDState});
+        auto C = makeTensor({tokens, kDState});
+        auto A = makeTensor({kDState, kDim});
+        auto D = makeTensor({kDim});
+        auto dtBias = makeTensor({kDim});
+        auto output = makeTensor({tokens, kDim});
+        auto state = makeTensor({batch, kDState, kDim});
+        fill(*x, 1, -1.f, 1.f);
+        fill(*dt, 2, -3.f, -1.f);
+        fill(*z, 3, -1.f, 1.f);
+        fill(*B, 4, -1.f, 1.f);
+        fill(*C, 5, -1.f, 1.f);
+        fill(*A, 6, -2.f, -0.1f);
+        fill(*D, 7, 0.f, 1.f);
+        fill(*dtBias, 8, -0.5f, 0.5f);
+
+        tk::SSMParamsBase params{};
+        params.batch = batch;
+        params.dim = kDim;
+        params.seqlen = seqLen;
+        params.dstate = kDState;
+        params.is_variable_B = true;
+        params.is_variable_C = true;
+        params.delta_softplus = true;
+        params.u_ptr = x->data();
+        params.delta_ptr = dt->data();
+        params.delta_bias_ptr = dtBias->data();
+        params.A_ptr = A->data();
+        params.B_ptr = B->data();
+        params.C_ptr = C->data();
+        params.D_ptr = D->data();
+        params.z_ptr = z->data();
+        params.out_ptr = output->data();
+        params.x_ptr = state->data();
+
+        auto const workspaceSize = tk::getSelectiveScanChunkedWorkspaceSize(batch, kDim, seqLen, kDState);
+        auto workspace = mBufferManager->gpu(workspaceSize);
+        tk::invokeSelectiveScanChunked<float, float>(params, workspace->data(), mStream->get());
+        mStream->synchronize();
+
+        auto const* xPtr = bufferCast<float>(*x);
+        auto const* dtPtr = bufferCast<float>(*dt);
+        auto const* zPtr = bufferCast<float>(*z);
+        auto const* BPtr = bufferCast<float>(*B);
+        auto const* CPtr = bufferCast<float>(*C);
+        auto const* APtr = bufferCast<float>(*A);
+        auto const* DPtr = bufferCast<float>(*D);
+        auto const* dtBiasPtr = bufferCast<float>(*dtBias);
+        auto const* outputPtr = bufferCast<float>(*output);
+        auto const* statePtr = bufferCast<float>(*state);
+        for (int32_t sample = 0; sample < batch; ++sample)
+        {
+            for (int32_t channel = 0; channel < kDim; ++channel)
+            {
+                std::vector<double> h(kDState, 0.);
+                for (int32_t token = 0; token < seqLen; ++token)
+                {
+                    auto const row = static_cast<size_t>(sample) * seqLen + token;
+                    auto const dtRaw = static_cast<double>(dtPtr[row * kDim + channel]) + dtBiasPtr[channel];
+                    auto const delta = dtRaw <= 20. ? std::log1p(std::exp(dtRaw)) : dtRaw;
+                    auto const xValue = static_cast<double>(xPtr[row * kDim + channel]);
+                    double expected = DPtr[channel] * xValue;
+                    for (int32_t i = 0; i < kDState; ++i)
+                    {
+                        auto const decay = std::exp(APtr[i * kDim + channel] * delta);
+                        h[i] = decay * h[i] + BPtr[row * kDState + i] * delta * xValue;
+                        expected += h[i] * CPtr[row * kDState + i];
+                    }
+                    expected *= silu(zPtr[row * kDim + channel]);
+                    ASSERT_NEAR(outputPtr[row * kDim + channel], expected, 1e-3 * (1. + std::abs(expected)))
+                        << "sample " << sample << " token " << token << " channel " << channel;
+                }
+                for (int32_t i = 0; i < kDState; ++i)
+                {
+                    auto const actual = statePtr[(static_cast<size_t>(sample) * kDState + i) * kDim + channel];
+                    ASSERT_NEAR(actual, h[i], 1e-3 * (1. + std::abs(h[i])));
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(SelectiveScanChunkedTest, singleChunk)
+{
+    runTest(2, 100);
+}
+
+TEST_F(SelectiveScanChunkedTest, partialLastChunk)
+{
+    runTest(2, 1100);
+}
+
+TEST_F(SelectiveScanChunkedTest, exactChunks)
+{
+    runTest(1, 1024);
+}
+
+class SelectiveScanFusedConvUpdateTest : public testing::Test
+{
+public:
+    static auto constexpr kDim = 160;
+    static auto constexpr kDState = 16;
+    static auto constexpr kDConv = 4;
+    static auto constexpr kConvChannels = kDim + 2 * kDState;
+    static auto constexpr kNumSlots = 3;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    // Runs numSteps generation steps of a batch whose samples use the given state slots, from empty states, and
+    // compares with the conv over the whole history and the scan on the host.
+    void runTest(std::vector<int32_t> const& slotIds, int32_t numSteps)
+    {
+        auto const batch = static_cast<SizeType>(slotIds.size());
+        auto makeTensor = [this](std::initializer_list<SizeType> dims)
+        { return mBufferManager->pinned(ITensor::makeShape(dims), nvinfer1::DataType::kFLOAT); };
+        auto x = makeTensor({batch, kDim});
+        auto dt = makeTensor({batch, kDim});
+        auto z = makeTensor({batch, kDim});
+        auto B = makeTensor({batch, kDState});
+        auto C = makeTensor({batch, kDState});
+        auto A = makeTensor({kDState, kDim});
+        auto D = makeTensor({kDim});
+        auto dtBias = makeTensor({kDim});
+        auto convWeight = makeTensor({kDConv, kConvChannels});
+        auto convBias = makeTensor({kConvChannels});
+        auto output = makeTensor({batch, kDim});
+        auto state = makeTensor({kNumSlots, kDState, kDim});
+        auto convState = makeTensor({kNumSlots, kDConv, kConvChannels});
+        auto slots = mBufferManager->pinned(ITensor::makeShape({batch}), nvinfer1::DataType::kINT32);
+        auto positions = mBufferManager->pinned(ITensor::makeShape({batch}), nvinfer1::DataType::kINT32);
+        fill(*A, 6, -2.f, -0.1f);
+        fill(*D, 7, 0.f, 1.f);
+        fill(*dtBias, 8, -0.5f, 0.5f);
+        fill(*convWeight, 9, -0.5f, 0.5f);
+        fill(*convBias, 10, -0.1f, 0.1f);
+        mBufferManager->setZero(*state);
+        mBufferManager->setZero(*convState);
+        std::copy(slotIds.begin(), slotIds.end(), bufferCast<int32_t>(*slots));
+
+        tk::SSMParamsBase params{};
+        params.batch = batch;
+        params.dim = kDim;
+        params.dstate = kDState;
+        params.dconv = kDConv;
+        params.is_variable_B = true;
+        params.is_variable_C = true;
+        params.delta_softplus = true;
+        params.u_ptr = x->data();
+        params.delta_ptr = dt->data();
+        params.delta_bias_ptr = dtBias->data();
+        params.A_ptr = A->data();
+        params.B_ptr = B->data();
+        params.C_ptr = C->data();
+        params.D_ptr = D->data();
+        params.z_ptr = z->data();
+        params.out_ptr = output->data();
+        params.x_ptr = state->data();
+        params.conv_weight_ptr = convWeight->data();
+        params.conv_bias_ptr = convBias->data();
+        params.conv_state_ptr = convState->data();
+        params.slot_ids_ptr = bufferCast<int32_t>(*slots);
+        params.positions_ptr = bufferCast<int32_t>(*positions);
+
+        auto const* weightPtr = bufferCast<float>(*convWeight);
+        auto const* convBiasPtr = bufferCast<float>(*convBias);
+        auto const* APtr = bufferCast<float>(*A);
+        auto const* DPtr = bufferCast<float>(*D);
+        auto const* dtBiasPtr = bufferCast<float>(*dtBias);
+        // Conv inputs of every step [batch][step][convChannel] and SSM states [batch][dstate][dim] of the reference
+        std::vector<std::vector<std::vector<float>>> history(batch);
+        std::vector<std::vector<double>> h(batch, std::vector<double>(kDState * kDim, 0.));
+        for (int32_t step = 0; step < numSteps; ++step)
+        {
+            fill(*x, 11 + step, -1.f, 1.f);
+            fill(*dt, 21 + step, -3.f, -1.f);
+            fill(*z, 31 + step, -1.f, 1.f);
+            fill(*B, 41 + step, -1.f, 1.f);
+            fill(*C, 51 + step, -1.f, 1.f);
+            std::fill_n(bufferCast<int32_t>(*positions), batch, step);
+            tk::invokeSelectiveScanFusedConvUpdate<float, float>(params, mStream->get());
+            mStream->synchronize();
+
+            auto const* xPtr = bufferCast<float>(*x);
+            auto const* BPtr = bufferCast<float>(*B);
+            auto const* CPtr = bufferCast<float>(*C);
+            auto const* dtPtr = bufferCast<float>(*dt);
+            auto const* zPtr = bufferCast<float>(*z);
+            auto const* outputPtr = bufferCast<float>(*output);
+            for (int32_t sample = 0; sample < batch; ++sample)
+            {
+                std::vector<float> inputs(xPtr + sample * kDim, xPtr + (sample + 1) * kDim);
+                inputs.insert(inputs.end(), BPtr + sample * kDState, BPtr + (sample + 1) * kDState);
+                inputs.insert(inputs.end(), CPtr + sample * kDState, CPtr + (sample + 1) * kDState);
+                history[sample].push_back(inputs);
+
+                auto convSilu = [&](int32_t convChannel)
+                {
+                    double acc = convBiasPtr[convChannel];
+                    for (int32_t k = 0; k < kDConv; ++k)
+                    {
+                        auto const token = step - (kDConv - 1) + k;
+                        if (token >= 0)
+                        {
+                            acc += weightPtr[k * kConvChannels + convChannel] * history[sample][token][convChannel];
+                        }
+                    }
+                    return silu(acc);
+                };
+                for (int32_t channel = 0; channel < kDim; ++channel)
+                {
+                    auto const xValue = convSilu(channel);
+                    auto const dtRaw = static_cast<double>(dtPtr[sample * kDim + channel]) + dtBiasPtr[channel];
+                    auto const delta = dtRaw <= 20. ? std::log1p(std::exp(dtRaw)) : dtRaw;
+                    double expected = DPtr[channel] * xValue;
+                    for (int32_t i = 0; i < kDState; ++i)
+                    {
+                        auto& hValue = h[sample][i * kDim + channel];
+                        hValue = std::exp(APtr[i * kDim + channel] * delta) * hValue
+                            + convSilu(kDim + i) * delta * xValue;
+                        expected += hValue * convSilu(kDim + kDState + i);
+                    }
+                    expected *= silu(zPtr[sample * kDim + channel]);
+                    ASSERT_NEAR(outputPtr[sample * kDim + channel], expected, 1e-3 * (1. + std::abs(expected)))
+                        << "step " << step << " sample " << sample << " channel " << channel;
+                }
+            }
+        }
+
+        auto const* statePtr = bufferCast<float>(*state);
+        for (int32_t sample = 0; sample < batch; ++sample)
+        {
+            for (int32_t idx = 0; idx < kDState * kDim; ++idx)
+            {
+                auto const expected = h[sample][idx];
+                ASSERT_NEAR(
+                    statePtr[slotIds[sample] * kDState * kDim + idx], expected, 1e-3 * (1. + std::abs(expected)));
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(SelectiveScanFusedConvUpdateTest, wrapsConvWindow)
+{
+    runTest({2, 0}, 2 * kDConv + 1);
+}
+
+} // namespace
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/sinkAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class SinkAttentionKernelTest : public testing::Test
+{
+public:
+    static auto constexpr kNumQHeads = 4;
+    static auto constexpr kNumKVHeads = 2;
+    static auto constexpr kHeadSize = 64;
+    static auto constexpr kQkvWidth = (kNumQHeads + 2 * kNumKVHeads) * kHeadSize;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    void runTest(std::vector<int32_t> const& seqLens, int32_t windowSize, int32_t sinkTokenLength)
+    {
+        std::vector<int32_t> cuSeqLens{0};
+        for (auto const seqLen : seqLens)
+        {
+            cuSeqLens.push_back(cuSeqLens.back() + seqLen);
+        }
+        auto const numTokens = cuSeqLens.back();
+
+        auto qkv = mBufferManager->pinned(ITensor::makeShape({numTokens, kQkvWidth}), nvinfer1::DataType::kFLOAT);
+        auto output = mBufferManager->pinned(
+            ITensor::makeShape({numTokens, kNumQHeads * kHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto cuSeqLensTensor = mBufferManager->pinned(
+            ITensor::makeShape({static_cast<SizeType>(cuSeqLens.size())}), nvinfer1::DataType::kINT32);
+        std::copy(cuSeqLens.begin(), cuSeqLens.end(), bufferCast<int32_t>(*cuSeqLensTensor));
+        auto* qkvPtr = bufferCast<float>(*qkv);
+        for (size_t idx = 0; idx < static_cast<size_t>(numTokens) * kQkvWidth; ++idx)
+        {
+            qkvPtr[idx] = static_cast<float>((idx * 2654435761u) % 1000) / 500.f - 1.f;
+        }
+
+        auto const softmaxScale = 1.f / std::sqrt(static_cast<float>(kHeadSize));
+        tk::SinkAttentionParams params{};
+        params.qkv = qkv->data();
+        params.output = output->data();
+        params.cuSeqLens = bufferCast<int32_t>(*cuSeqLensTensor);
+        params.batchSize = static_cast<int32_t>(seqLens.size());
+        params.maxSeqLen = *std::max_element(seqLens.begin(), seqLens.end());
+        params.numQHeads = kNumQHeads;
+        params.numKVHeads = kNumKVHeads;
+        params.headSize = kHeadSize;
+        params.windowSize = windowSize;
+        params.sinkTokenLength = sinkTokenLength;
+        params.softmaxScale = softmaxScale;
+        tk::invokeSinkAttention<float>(params, mStream->get());
+        mStream->synchronize();
+
+        auto const* outputPtr = bufferCast<float>(*output);
+        for (size_t seq = 0; seq < seqLens.size(); ++seq)
+        {
+            auto const* seqQkv = qkvPtr + static_cast<size_t>(cuSeqLens[seq]) * kQkvWidth;
+            for (int token = 0; token < seqLens[seq]; ++token)
+            {
+                // Same tokens as the cyclic KV cache keeps for a sequence of token + 1 tokens.
+                std::vector<int> attended;
+                for (int pos = 0; pos <= token; ++pos)
+                {
+                    if (pos < sinkTokenLength || pos > token - (windowSize - sinkTokenLength))
+                    {
+                        attended.push_back(pos);
+                    }
+                }
+                for (int qHead = 0; qHead < kNumQHeads; ++qHead)
+                {
+                    auto const kvHead = qHead / (kNumQHeads / kNumKVHeads);
+                    auto const* qRow = seqQkv + token * kQkvWidth + qHead * kHeadSize;
+                    std::vector<float> scores;
+                    for (auto const pos : attended)
+                    {
+                        auto const* kRow = seqQkv + pos * kQkvWidth + (kNumQHeads + kvHead) * kHeadSize;
+                        float score = 0.f;
+                        for (int channel = 0; channel < kHeadSize; ++channel)
+                        {
+                            score += qRow[channel] * kRow[channel];
+                        }
+                        scores.push_back(score * softmaxScale);
+                    }
+                    auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                    float sum = 0.f;
+                    for (auto& score : scores)
+                    {
+                        score = std::exp(score - maxScore);
+                        sum += score;
+                    }
+                    for (int channel = 0; channel < kHeadSize; ++channel)
+                    {
+                        float expected = 0.f;
+                        for (size_t i = 0; i < attended.size(); ++i)
+                        {
+                            auto const* vRow
+                                = seqQkv + attended[i] * kQkvWidth + (kNumQHeads + kNumKVHeads + kvHead) * kHeadSize;
+                            expected += scores[i] / sum * vRow[channel];
+                        }
+                        auto const actual
+                            = outputPtr[(static_cast<size_t>(cuSeqLens[seq] + token) * kNumQHeads + qHead) * kHeadSize
+                                + channel];
+                        ASSERT_NEAR(actual, expected, 1e-4)
+                            << "seq " << seq << " token " << token << " head " << qHead << " channel " << channel;
+                    }
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+};
+
+TEST_F(SinkAttentionKernelTest, windowWithSinks)
+{
+    runTest({100, 37, 64}, 24, 4);
+}
+
+TEST_F(SinkAttentionKernelTest, windowWithoutSinks)
+{
+    runTest({77, 5}, 16, 0);
+}
+
+} // namespace
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/sparse_gemm/sparse_gemm.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::kernels::cutlass_kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class SparseGemmTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        auto const sm = tc::getSMVersion();
+        if (sm < 80 || sm > 90)
+        {
+            GTEST_SKIP() << "The sparse GEMM needs SM80 to SM90";
+        }
+        mStream = std::make_shared<CudaStream>();
+        mBufferManager = std::make_shared<BufferManager>(mStream);
+    }
+
+    // Random weights where only 2 random elements of every group of 4 are nonzero.
+    template <typename T>
+    std::vector<T> makeSparseWeights(int n, int k, float maxValue)
+    {
+        std::uniform_real_distribution<float> valueDist(-maxValue, maxValue);
+        std::uniform_int_distribution<int> positionDist(0, 3);
+        std::vector<T> weights(static_cast<size_t>(n) * k, T(0));
+        for (size_t group = 0; group < weights.size() / 4; ++group)
+        {
+            int const first = positionDist(mGenerator);
+            int second = positionDist(mGenerator);
+            while (second == first)
+            {
+                second = positionDist(mGenerator);
+            }
+            weights[group * 4 + first] = static_cast<T>(valueDist(mGenerator));
+            weights[group * 4 + second] = static_cast<T>(valueDist(mGenerator));
+        }
+        return weights;
+    }
+
+    template <typename T>
+    std::vector<T> makeDense(size_t size, float maxValue)
+    {
+        std::uniform_real_distribution<float> valueDist(-maxValue, maxValue);
+        std::vector<T> values(size);
+        for (auto& value : values)
+        {
+            value = static_cast<T>(valueDist(mGenerator));
+        }
+        return values;
+    }
+
+    // Runs every config of the runner and compares the [m, n] outputs with the float product of the dense operands.
+    template <typename TIn, typename TOut>
+    void runAndCompare(tkc::CutlassSparseGemmRunnerInterface& runner, std::vector<TIn> const& act,
+        std::vector<TIn> const& weights, tc::QuantMode quantMode, std::vector<float> const& scaleTokens,
+        std::vector<float> const& scaleChannels, int m, int n, int k, float tolerance)
+    {
+        std::vector<TIn> compressed(static_cast<size_t>(n) * k / 2);
+        std::vector<int8_t> metadata(tkc::getSparseGemmMetadataSize<TIn>(n, k));
+        tkc::compressSparseGemmWeights<TIn>(compressed.data(), metadata.data(), weights.data(), n, k, false);
+
+        std::vector<float> reference(static_cast<size_t>(m) * n);
+        for (int i = 0; i < m; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                float acc = 0.f;
+                for (int l = 0; l < k; ++l)
+                {
+                    acc += static_cast<float>(act[static_cast<size_t>(i) * k + l])
+                        * static_cast<float>(weights[static_cast<size_t>(j) * k + l]);
+                }
+                if (!scaleTokens.empty())
+                {
+                    acc *= scaleTokens[quantMode.hasPerTokenScaling() ? i : 0];
+                }
+                if (!scaleChannels.empty())
+                {
+                    acc *= scaleChannels[quantMode.hasPerChannelScaling() ? j : 0];
+                }
+                reference[static_cast<size_t>(i) * n + j] = acc;
+            }
+        }
+
+        auto dAct = mBufferManager->gpu(act.size() * sizeof(TIn));
+        auto dWeights = mBufferManager->gpu(compressed.size() * sizeof(TIn));
+        auto dMetadata = mBufferManager->gpu(metadata.size());
+        auto dScaleTokens = mBufferManager->gpu(std::max<size_t>(scaleTokens.size(), 1) * sizeof(float));
+        auto dScaleChannels = mBufferManager->gpu(std::max<size_t>(scaleChannels.size(), 1) * sizeof(float));
+        auto dOut = mBufferManager->gpu(static_cast<size_t>(m) * n * sizeof(TOut));
+        auto const workspaceBytes = runner.getWorkspaceSize(m, n, k);
+        auto dWorkspace = mBufferManager->gpu(std::max<size_t>(workspaceBytes, 1));
+        mBufferManager->copy(act.data(), *dAct, MemoryType::kCPU);
+        mBufferManager->copy(compressed.data(), *dWeights, MemoryType::kCPU);
+        mBufferManager->copy(metadata.data(), *dMetadata, MemoryType::kCPU);
+        if (!scaleTokens.empty())
+        {
+            mBufferManager->copy(scaleTokens.data(), *dScaleTokens, MemoryType::kCPU);
+            mBufferManager->copy(scaleChannels.data(), *dScaleChannels, MemoryType::kCPU);
+        }
+
+        for (auto const& config : runner.getConfigs())
+        {
+            mBufferManager->setZero(*dOut);
+            runner.gemm(dAct->data(), dWeights->data(), dMetadata->data(), quantMode,
+                scaleTokens.empty() ? nullptr : static_cast<float const*>(dScaleTokens->data()),
+                scaleChannels.empty() ? nullptr : static_cast<float const*>(dScaleChannels->data()), dOut->data(), m,
+                n, k, config, static_cast<char*>(dWorkspace->data()), workspaceBytes, mStream->get());
+            std::vector<TOut> out(static_cast<size_t>(m) * n);
+            mBufferManager->copy(*dOut, out.data(), MemoryType::kCPU);
+            mStream->synchronize();
+
+            for (size_t i = 0; i < out.size(); ++i)
+            {
+                ASSERT_NEAR(static_cast<float>(out[i]), reference[i], tolerance * (1.f + std::abs(reference[i])))
+                    << "m " << m << " n " << n << " k " << k << " tile " << static_cast<int>(config.tile_config)
+                    << " stages " << config.stages << " at " << i;
+            }
+        }
+    }
+
+    std::mt19937 mGenerator{42};
+    std::shared_ptr<CudaStream> mStream;
+    std::shared_ptr<BufferManager> mBufferManager;
+};
+
+TEST_F(SparseGemmTest, Fp16)
+{
+    tkc::CutlassSparseGemmRunner<half, half> runner;
+    int const n = 256;
+    int const k = 512;
+    auto const weights = makeSparseWeights<half>(n, k, 1.f);
+    // Token counts that are and are not multiples of the alignment of the kernel
+    for (int const m : {1, 7, 16, 100})
+    {
+        auto const act = makeDense<half>(static_cast<size_t>(m) * k, 1.f);
+        runAndCompare<half, half>(runner, act, weights, tc::QuantMode::none(), {}, {}, m, n, k, 1e-2f);
+    }
+}
+
+#ifdef ENABLE_BF16
+TEST_F(SparseGemmTest, Bf16)
+{
+    tkc::CutlassSparseGemmRunner<__nv_bfloat16, __nv_bfloat16> runner;
+    int const n = 128;
+    int const k = 256;
+    auto const weights = makeSparseWeights<__nv_bfloat16>(n, k, 1.f);
+    for (int const m : {3, 32})
+    {
+        auto const act = makeDense<__nv_bfloat16>(static_cast<size_t>(m) * k, 1.f);
+        runAndCompare<__nv_bfloat16, __nv_bfloat16>(
+            runner, act, weights, tc::QuantMode::none(), {}, {}, m, n, k, 5e-2f);
+    }
+}
+#endif
+
+TEST_F(SparseGemmTest, Int8SmoothQuant)
+{
+    tkc::CutlassSparseGemmRunner<int8_t, half> runner;
+    int const n = 128;
+    int const k = 256;
+    auto const weights = makeSparseWeights<int8_t>(n, k, 127.f);
+    auto const quantMode = tc::QuantMode::fromDescription(true, true, true, true);
+    for (int const m : {5, 64})
+    {
+        auto const act = makeDense<int8_t>(static_cast<size_t>(m) * k, 127.f);
+        auto const scaleTokens = makeDense<float>(m, 1e-3f);
+        auto const scaleChannels = makeDense<float>(n, 1e-3f);
+        runAndCompare<int8_t, half>(runner, act, weights, quantMode, scaleTokens, scaleChannels, m, n, k, 1e-2f);
+    }
+}
+
+TEST(SparseGemmCompressTest, PrunesOrRejectsDenseGroups)
+{
+    int const n = 32;
+    int const k = 128;
+    std::vector<half> dense(static_cast<size_t>(n) * k);
+    for (size_t i = 0; i < dense.size(); ++i)
+    {
+        dense[i] = static_cast<half>(static_cast<float>(i % 4 + 1));
+    }
+    std::vector<half> compressed(static_cast<size_t>(n) * k / 2);
+    std::vector<int8_t> metadata(tkc::getSparseGemmMetadataSize<half>(n, k));
+
+    EXPECT_THROW(
+        tkc::compressSparseGemmWeights<half>(compressed.data(), metadata.data(), dense.data(), n, k, false),
+        std::runtime_error);
+
+    // The 2 largest of every group are 3 and 4, kept in their order
+    tkc::compressSparseGemmWeights<half>(compressed.data(), metadata.data(), dense.data(), n, k, true);
+    for (size_t i = 0; i < compressed.size(); ++i)
+    {
+        EXPECT_EQ(static_cast<float>(compressed[i]), i % 2 == 0 ? 3.f : 4.f);
+    }
+}
+
+} // namespace
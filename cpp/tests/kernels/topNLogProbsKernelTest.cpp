@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOP_LEVEL_DIR
+#error "Define TOP_LEVEL_DIR"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/topNLogProbsKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class TopNLogProbsKernelTest : public testing::Test
+{
+public:
+    using TensorPtr = tensorrt_llm::runtime::ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+        mBufferManager = std::make_shared<tensorrt_llm::runtime::BufferManager>(mStream);
+    }
+
+    void runTest(SizeType batchSize, SizeType beamWidth, SizeType vocabSize, SizeType topN)
+    {
+        auto const maxBatchSize = 2 * batchSize;
+        auto const vocabSizePadded = vocabSize + 3;
+        SizeType constexpr maxSeqLen = 4;
+
+        auto logits = mBufferManager->pinned(
+            ITensor::makeShape({batchSize, beamWidth, vocabSizePadded}), nvinfer1::DataType::kFLOAT);
+        auto sequenceLengths
+            = mBufferManager->pinned(ITensor::makeShape({maxBatchSize, beamWidth}), nvinfer1::DataType::kINT32);
+        auto finished = mBufferManager->pinned(
+            ITensor::makeShape({maxBatchSize, beamWidth}), TRTDataType<tk::FinishedState::UnderlyingType>::value);
+        auto batchSlots = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto const topNShape = ITensor::makeShape({maxBatchSize, beamWidth, maxSeqLen, topN});
+        auto topNIds = mBufferManager->pinned(topNShape, nvinfer1::DataType::kINT32);
+        auto topNLogProbs = mBufferManager->pinned(topNShape, nvinfer1::DataType::kFLOAT);
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> logitsDistr(-5.f, 5.f);
+        auto logitsPtr = bufferCast<float>(*logits);
+        for (SizeType i = 0; i < batchSize * beamWidth * vocabSizePadded; ++i)
+        {
+            // Padded logits are large to check that they are ignored
+            logitsPtr[i] = i % vocabSizePadded < vocabSize ? logitsDistr(generator) : 100.f;
+        }
+        // Duplicate values are ordered by token id
+        logitsPtr[1] = logitsPtr[0];
+
+        auto batchSlotsPtr = bufferCast<SizeType>(*batchSlots);
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            batchSlotsPtr[bi] = 2 * bi;
+        }
+        auto sequenceLengthsPtr = bufferCast<SizeType>(*sequenceLengths);
+        auto finishedPtr
+            = reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*finished));
+        for (SizeType i = 0; i < maxBatchSize * beamWidth; ++i)
+        {
+            sequenceLengthsPtr[i] = i % maxSeqLen;
+            finishedPtr[i] = tk::FinishedState::empty();
+        }
+        // The last request has finished and must be left untouched
+        for (SizeType ri = 0; ri < beamWidth; ++ri)
+        {
+            finishedPtr[batchSlotsPtr[batchSize - 1] * beamWidth + ri].setFinishedEOS();
+        }
+        std::fill_n(bufferCast<SizeType>(*topNIds), topNIds->getSize(), -1);
+        std::fill_n(bufferCast<float>(*topNLogProbs), topNLogProbs->getSize(), 0.f);
+
+        tk::invokeTopNLogProbs(bufferCast<int32_t>(*topNIds), bufferCast<float>(*topNLogProbs),
+            bufferCast<float>(*logits), finishedPtr, sequenceLengthsPtr, batchSlotsPtr, batchSize, beamWidth, vocabSize,
+            vocabSizePadded, maxSeqLen, topN, mStream->get());
+        mStream->synchronize();
+
+        auto const topNIdsPtr = bufferCast<SizeType>(*topNIds);
+        auto const topNLogProbsPtr = bufferCast<float>(*topNLogProbs);
+        for (SizeType bi = 0; bi < batchSize; ++bi)
+        {
+            auto const batchSlot = batchSlotsPtr[bi];
+            for (SizeType ri = 0; ri < beamWidth; ++ri)
+            {
+                auto const slotBeamIdx = batchSlot * beamWidth + ri;
+                auto const step = sequenceLengthsPtr[slotBeamIdx];
+                auto const outputOffset = (slotBeamIdx * maxSeqLen + step) * topN;
+                if (finishedPtr[slotBeamIdx].isFinished())
+                {
+                    EXPECT_EQ(topNIdsPtr[outputOffset], -1);
+                    continue;
+                }
+
+                auto const* rowLogits = logitsPtr + (bi * beamWidth + ri) * vocabSizePadded;
+                auto const maxLogit = *std::max_element(rowLogits, rowLogits + vocabSize);
+                double sum = 0.0;
+                for (SizeType vi = 0; vi < vocabSize; ++vi)
+                {
+                    sum += std::exp(rowLogits[vi] - maxLogit);
+                }
+                auto const logSumExp = maxLogit + std::log(sum);
+
+                std::vector<SizeType> refIds(vocabSize);
+                std::iota(refIds.begin(), refIds.end(), 0);
+                std::stable_sort(refIds.begin(), refIds.end(),
+                    [rowLogits](SizeType a, SizeType b) { return rowLogits[a] > rowLogits[b]; });
+                for (SizeType ni = 0; ni < topN; ++ni)
+                {
+                    EXPECT_EQ(topNIdsPtr[outputOffset + ni], refIds[ni]) << "bi " << bi << " ri " << ri << " ni " << ni;
+                    EXPECT_NEAR(topNLogProbsPtr[outputOffset + ni], rowLogits[refIds[ni]] - logSumExp, 1e-3f);
+                }
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<tensorrt_llm::runtime::BufferManager> mBufferManager;
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+};
+
+TEST_F(TopNLogProbsKernelTest, Top1)
+{
+    this->runTest(/* batchSize */ 4, /* beamWidth */ 1, /* vocabSize */ 100, /* topN */ 1);
+}
+
+TEST_F(TopNLogProbsKernelTest, Top5)
+{
+    this->runTest(/* batchSize */ 6, /* beamWidth */ 1, /* vocabSize */ 1000, /* topN */ 5);
+}
+
+TEST_F(TopNLogProbsKernelTest, Top20Beams)
+{
+    this->runTest(/* batchSize */ 3, /* beamWidth */ 2, /* vocabSize */ 51200, /* topN */ 20);
+}
+
+TEST_F(TopNLogProbsKernelTest, GatherTokenLogProbs)
+{
+    SizeType constexpr numTokens = 7;
+    SizeType constexpr vocabSize = 1000;
+    SizeType constexpr vocabSizePadded = vocabSize + 3;
+    auto logits
+        = mBufferManager->pinned(ITensor::makeShape({numTokens, vocabSizePadded}), nvinfer1::DataType::kFLOAT);
+    auto targetIds = mBufferManager->pinned(ITensor::makeShape({numTokens}), nvinfer1::DataType::kINT32);
+    auto logProbs = mBufferManager->pinned(ITensor::makeShape({numTokens}), nvinfer1::DataType::kFLOAT);
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> logitsDistr(-5.f, 5.f);
+    std::uniform_int_distribution<SizeType> tokenDistr(0, vocabSize - 1);
+    auto logitsPtr = bufferCast<float>(*logits);
+    for (SizeType i = 0; i < numTokens * vocabSizePadded; ++i)
+    {
+        logitsPtr[i] = i % vocabSizePadded < vocabSize ? logitsDistr(generator) : 100.f;
+    }
+    auto targetIdsPtr = bufferCast<SizeType>(*targetIds);
+    for (SizeType ti = 0; ti < numTokens; ++ti)
+    {
+        // The first rows belong to the prompt and are not scored
+        targetIdsPtr[ti] = ti < 2 ? -1 : tokenDistr(generator);
+    }
+    std::fill_n(bufferCast<float>(*logProbs), numTokens, 1.f);
+
+    tk::invokeGatherTokenLogProbs(bufferCast<float>(*logProbs), logitsPtr, targetIdsPtr, numTokens, vocabSize,
+        vocabSizePadded, mStream->get());
+    mStream->synchronize();
+
+    auto const logProbsPtr = bufferCast<float>(*logProbs);
+    for (SizeType ti = 0; ti < numTokens; ++ti)
+    {
+        if (targetIdsPtr[ti] < 0)
+        {
+            EXPECT_EQ(logProbsPtr[ti], 0.f);
+            continue;
+        }
+        auto const* rowLogits = logitsPtr + ti * vocabSizePadded;
+        auto const maxLogit = *std::max_element(rowLogits, rowLogits + vocabSize);
+        double sum = 0.0;
+        for (SizeType vi = 0; vi < vocabSize; ++vi)
+        {
+            sum += std::exp(rowLogits[vi] - maxLogit);
+        }
+        auto const expected = rowLogits[targetIdsPtr[ti]] - maxLogit - std::log(sum);
+        EXPECT_NEAR(logProbsPtr[ti], expected, 1e-3f) << "ti " << ti;
+    }
+}
+
+} // end of namespace
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
+#include "tensorrt_llm/kernels/weightOnlyBatchedGemv/common.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+using namespace tensorrt_llm::kernels::cutlass_kernels;
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class CutlassPreprocessorsTest : public testing::TestWithParam<QuantType>
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    static std::vector<int8_t> randomBytes(size_t numBytes)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> dist(-128, 127);
+        std::vector<int8_t> bytes(numBytes);
+        for (auto& byte : bytes)
+        {
+            byte = static_cast<int8_t>(dist(gen));
+        }
+        return bytes;
+    }
+
+    std::vector<int8_t> toHost(IBuffer const& buffer)
+    {
+        std::vector<int8_t> host(buffer.getSize());
+        mManager->copy(buffer, host.data());
+        mStream->synchronize();
+        return host;
+    }
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_P(CutlassPreprocessorsTest, PreprocessMatchesHost)
+{
+    auto const quantType = GetParam();
+    for (std::vector<size_t> const& shape : {std::vector<size_t>{256, 128}, std::vector<size_t>{3, 128, 320}})
+    {
+        for (bool forceInterleave : {false, true})
+        {
+            size_t numElts = 1;
+            for (auto dim : shape)
+            {
+                numElts *= dim;
+            }
+            auto const numBytes = numElts * get_bits_in_quant_type(quantType) / 8;
+            auto const input = randomBytes(numBytes);
+
+            std::vector<int8_t> expected(numBytes);
+            preprocess_weights_for_mixed_gemm(expected.data(), input.data(), shape, quantType, forceInterleave);
+
+            auto deviceInput = mManager->copyFrom(input, MemoryType::kGPU);
+            auto deviceOutput = mManager->gpu(numBytes, nvinfer1::DataType::kINT8);
+            auto workspace = mManager->gpu(
+                get_preprocess_weights_for_mixed_gemm_cuda_workspace_size(shape, quantType), nvinfer1::DataType::kINT8);
+            preprocess_weights_for_mixed_gemm_cuda(bufferCast<int8_t>(*deviceOutput),
+                bufferCast<int8_t>(*deviceInput), workspace->data(), shape, quantType, mStream->get(),
+                forceInterleave);
+
+            EXPECT_EQ(toHost(*deviceOutput), expected);
+        }
+    }
+}
+
+TEST_P(CutlassPreprocessorsTest, SymmetricQuantizeMatchesHost)
+{
+    auto const quantType = GetParam();
+    std::vector<size_t> const shape{2, 128, 256};
+    auto const numElts = shape[0] * shape[1] * shape[2];
+    auto const numBytes = numElts * get_bits_in_quant_type(quantType) / 8;
+
+    std::mt19937 gen(7);
+    std::normal_distribution<float> dist(0.f, 0.05f);
+    std::vector<half> weight(numElts);
+    for (auto& value : weight)
+    {
+        value = half(dist(gen));
+    }
+
+    std::vector<int8_t> expectedProcessed(numBytes);
+    std::vector<int8_t> expectedUnprocessed(numBytes);
+    std::vector<half> expectedScales(shape[0] * shape[2]);
+    symmetric_quantize<half, half>(expectedProcessed.data(), expectedUnprocessed.data(), expectedScales.data(),
+        weight.data(), shape, quantType, true);
+
+    auto deviceWeight = mManager->copyFrom(weight, MemoryType::kGPU);
+    auto processed = mManager->gpu(numBytes, nvinfer1::DataType::kINT8);
+    auto unprocessed = mManager->gpu(numBytes, nvinfer1::DataType::kINT8);
+    auto scales = mManager->gpu(expectedScales.size(), nvinfer1::DataType::kHALF);
+    auto workspace
+        = mManager->gpu(get_symmetric_quantize_cuda_workspace_size(shape, quantType), nvinfer1::DataType::kINT8);
+    symmetric_quantize_cuda<half, half>(bufferCast<int8_t>(*processed), bufferCast<int8_t>(*unprocessed),
+        bufferCast<half>(*scales), bufferCast<half>(*deviceWeight), workspace->data(), shape, quantType, true,
+        mStream->get());
+
+    EXPECT_EQ(toHost(*unprocessed), expectedUnprocessed);
+    EXPECT_EQ(toHost(*processed), expectedProcessed);
+    std::vector<half> hostScales(expectedScales.size());
+    mManager->copy(*scales, hostScales.data());
+    mStream->synchronize();
+    for (size_t idx = 0; idx < hostScales.size(); ++idx)
+    {
+        EXPECT_EQ(static_cast<float>(hostScales[idx]), static_cast<float>(expectedScales[idx])) << idx;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(QuantTypes, CutlassPreprocessorsTest,
+    testing::Values(QuantType::INT8_WEIGHT_ONLY, QuantType::PACKED_INT4_WEIGHT_ONLY));
+
+class LowBitPreprocessorsTest : public testing::TestWithParam<QuantType>
+{
+};
+
+TEST_P(LowBitPreprocessorsTest, GroupwiseQuantizeRoundTrip)
+{
+    auto const quantType = GetParam();
+    auto const bits = get_bits_in_quant_type(quantType);
+    int const groupSize = 64;
+    std::vector<size_t> const shape{256, 96};
+    auto const numRows = shape[0];
+    auto const numCols = shape[1];
+
+    std::mt19937 gen(11);
+    std::normal_distribution<float> dist(0.f, 0.05f);
+    std::vector<float> weight(numRows * numCols);
+    for (auto& value : weight)
+    {
+        value = dist(gen);
+    }
+
+    auto const packedSize = get_low_bit_packed_weight_size(shape, quantType);
+    EXPECT_EQ(packedSize, numRows * numCols * bits / 8);
+    std::vector<int8_t> packed(packedSize);
+    std::vector<uint8_t> codes(numRows * numCols);
+    std::vector<float> scales(numRows / groupSize * numCols);
+    groupwise_quantize_low_bit<float, float>(
+        packed.data(), codes.data(), scales.data(), weight.data(), shape, quantType, groupSize);
+
+    // Unpack the bit planes, [col][row / 32][bit] words with bit i of a word for row i of the pack
+    auto const* words = reinterpret_cast<uint32_t const*>(packed.data());
+    auto const numPacks = numRows / 32;
+    auto const halfRange = 1 << (bits - 1);
+    for (size_t col = 0; col < numCols; ++col)
+    {
+        for (size_t row = 0; row < numRows; ++row)
+        {
+            int code = 0;
+            for (int bit = 0; bit < bits; ++bit)
+            {
+                code |= ((words[(col * numPacks + row / 32) * bits + bit] >> (row % 32)) & 1) << bit;
+            }
+            ASSERT_EQ(code, codes[row * numCols + col]) << row << ", " << col;
+
+            // The dequantized weight is within half a step of the weight, the largest step of NF4 is about 0.3. The
+            // integer types clip the largest positive weight by a whole step.
+            auto const scale = scales[row / groupSize * numCols + col];
+            auto const value = quantType == QuantType::PACKED_NF4_WEIGHT_ONLY
+                ? tensorrt_llm::kernels::nf4_value(code)
+                : static_cast<float>(code - halfRange);
+            auto const maxError = quantType == QuantType::PACKED_NF4_WEIGHT_ONLY ? 0.16f : 1.f;
+            EXPECT_LE(std::abs(value * scale - weight[row * numCols + col]), maxError * scale + 1e-6f)
+                << row << ", " << col;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(QuantTypes, LowBitPreprocessorsTest,
+    testing::Values(QuantType::PACKED_INT3_WEIGHT_ONLY, QuantType::PACKED_INT2_WEIGHT_ONLY,
+        QuantType::PACKED_NF4_WEIGHT_ONLY));
+
+} // namespace
@@ -5,6 +5,7 @@
 #include "cutlass/numeric_types.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/fpA_intB_gemm/fpA_intB_gemm.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/enabled.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/kernelLauncher.h"
@@ -438,7 +439,7 @@ TEST(Kernel, WeightOnly)
     }
     bool pass;
     int warmup = 10, iter = 30;
-    std::vector<int> ms{1, 2, 4};
+    std::vector<int> ms{1, 2, 4, 6, 8, 13, 16};
     std::vector<int> ns{512, 1024, 2048, 4096};
     std::vector<int> ks{512, 1024, 2048, 4096};
     std::vector<int> gss{0, 64, 128};
@@ -469,3 +470,117 @@ TEST(Kernel, WeightOnly)
         }
     }
 }
+
+// The sub-4-bit types have no CUTLASS kernel, the CUDA kernel is compared with a float reference on the unpacked codes.
+bool benchmark_low_bit(WeightOnlyQuantType qtype, int m, int n, int k, int group_size, int warmup, int iter)
+{
+    namespace ck = tensorrt_llm::kernels::cutlass_kernels;
+    const auto quant_type = qtype == WeightOnlyQuantType::Int3b ? ck::QuantType::PACKED_INT3_WEIGHT_ONLY
+        : qtype == WeightOnlyQuantType::Int2b                   ? ck::QuantType::PACKED_INT2_WEIGHT_ONLY
+                                                                : ck::QuantType::PACKED_NF4_WEIGHT_ONLY;
+    const int bits = ck::get_bits_in_quant_type(quant_type);
+    printf("benchmark mnk (%d, %d, %d) FP16 Activation %d bits%s GroupWise%d Weight Only\n", m, n, k, bits,
+        qtype == WeightOnlyQuantType::NF4 ? " NF4" : "", group_size);
+
+    std::vector<half> h_act(m * k), h_bias(n), h_out(m * n);
+    std::vector<float> h_weight(k * n);
+    random_fill(h_act, -1.f, 1.f);
+    random_fill(h_bias, -1.f, 1.f);
+    random_fill(h_weight, -1.f, 1.f);
+
+    const std::vector<size_t> shape{static_cast<size_t>(k), static_cast<size_t>(n)};
+    std::vector<int8_t> h_packed(ck::get_low_bit_packed_weight_size(shape, quant_type));
+    std::vector<uint8_t> h_codes(k * n);
+    std::vector<half> h_scales(k / group_size * n);
+    ck::groupwise_quantize_low_bit<half, float>(
+        h_packed.data(), h_codes.data(), h_scales.data(), h_weight.data(), shape, quant_type, group_size);
+
+    std::vector<float> h_ref(m * n);
+    const int half_range = 1 << (bits - 1);
+    for (int col = 0; col < n; ++col)
+    {
+        for (int row = 0; row < m; ++row)
+        {
+            float acc = static_cast<float>(h_bias[col]);
+            for (int kk = 0; kk < k; ++kk)
+            {
+                const int code = h_codes[kk * n + col];
+                const float value = qtype == WeightOnlyQuantType::NF4 ? tensorrt_llm::kernels::nf4_value(code)
+                                                                      : static_cast<float>(code - half_range);
+                acc += static_cast<float>(h_act[row * k + kk]) * value
+                    * static_cast<float>(h_scales[kk / group_size * n + col]);
+            }
+            h_ref[row * n + col] = acc;
+        }
+    }
+
+    CudaBuffer d_act(m * k * sizeof(half));
+    CudaBuffer d_weight(h_packed.size());
+    CudaBuffer d_scales(h_scales.size() * sizeof(half));
+    CudaBuffer d_bias(n * sizeof(half));
+    CudaBuffer d_out(m * n * sizeof(half));
+    d_act.copy_from(h_act.data());
+    d_weight.copy_from(h_packed.data());
+    d_scales.copy_from(h_scales.data());
+    d_bias.copy_from(h_bias.data());
+
+    WeightOnlyParams params{d_weight.data<uint8_t>(), d_scales.data(), nullptr, d_act.data(), nullptr, d_bias.data(),
+        d_out.data(), m, n, k, group_size, qtype, WeightOnlyType::GroupWise,
+        WeightOnlyActivationFunctionType::Identity, WeightOnlyActivationType::FP16};
+    cudaStream_t s;
+    cudaStreamCreate(&s);
+    cudaEvent_t begin, end;
+    cudaEventCreate(&begin);
+    cudaEventCreate(&end);
+    for (int i = 0; i < warmup; ++i)
+    {
+        tensorrt_llm::kernels::weight_only_batched_gemv_launcher(params, s);
+    }
+    cudaEventRecord(begin, s);
+    for (int i = 0; i < iter; ++i)
+    {
+        tensorrt_llm::kernels::weight_only_batched_gemv_launcher(params, s);
+    }
+    cudaEventRecord(end, s);
+    cudaEventSynchronize(end);
+    float time;
+    cudaEventElapsedTime(&time, begin, end);
+    cudaEventDestroy(begin);
+    cudaEventDestroy(end);
+    cudaStreamDestroy(s);
+    d_out.copy_to(h_out.data());
+
+    std::vector<float> h_out_float(h_out.begin(), h_out.end());
+    bool pass = compare<float>(h_out_float.data(), h_ref.data(), m * n, 1.f / 64);
+    printf("cuda kernel cost time %.6f\n", time / iter);
+    return pass;
+}
+
+TEST(Kernel, WeightOnlyLowBit)
+{
+    if (!tensorrt_llm::kernels::isWeightOnlyBatchedGemvEnabled(WeightOnlyQuantType::Int3b))
+    {
+        return;
+    }
+    int warmup = 10, iter = 30;
+    std::vector<int> ms{1, 3, 8, 16};
+    std::vector<int> ns{512, 4096};
+    std::vector<int> ks{1024, 4096};
+    std::vector<int> gss{64, 128};
+    for (auto qtype : {WeightOnlyQuantType::Int3b, WeightOnlyQuantType::Int2b, WeightOnlyQuantType::NF4})
+    {
+        for (auto m : ms)
+        {
+            for (auto n : ns)
+            {
+                for (auto k : ks)
+                {
+                    for (auto gs : gss)
+                    {
+                        EXPECT_TRUE(benchmark_low_bit(qtype, m, n, k, gs, warmup, iter));
+                    }
+                }
+            }
+        }
+    }
+}
@@ -64,7 +64,7 @@ void BaseSamplingLayerTest<T>::setup(uint64_t seed, SamplingParams const& params
     mBatchSlots = mBufferManager->pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT32);
 
     mCurandStatesDevice
-        = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize, sizeof(curandState_t)}), nvinfer1::DataType::kINT8);
+        = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize, sizeof(tk::PhiloxState)}), nvinfer1::DataType::kINT8);
     auto const workspaceSize = mSamplingLayer->getWorkspaceSize();
     mSamplingWorkspaceDevice = mBufferManager->gpu(workspaceSize, nvinfer1::DataType::kINT8);
 
@@ -120,7 +120,7 @@ typename BaseSamplingLayer<T>::ForwardParams BaseSamplingLayerTest<T>::createInp
 
     decodeInputTensors.probs_computed = mComputeProbs;
 
-    decodeInputTensors.curand_states = reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*mCurandStatesDevice));
+    decodeInputTensors.curand_states = reinterpret_cast<tk::PhiloxState*>(bufferCast<int8_t>(*mCurandStatesDevice));
 
     decodeInputTensors.sampling_workspace = reinterpret_cast<void*>(bufferCast<int8_t>(*mSamplingWorkspaceDevice));
 
@@ -211,6 +211,49 @@ void DynamicDecodeLayerTest<T>::setup(uint64_t seed, SamplingParams const& param
         mBufferManager->copy(*mEmbeddingBiasHost, *mEmbeddingBiasDevice);
     }
 
+    mLogitsPostProcessors.clear();
+    if (params.forcedTokens.size())
+    {
+        // Each forced request gets a row of logits in which only its token can be sampled
+        auto forcedLogitsHost = mBufferManager->pinned(ITensor::makeShape({mBatchSize, mVocabSizePadded}), dataType);
+        auto forcedLogitsHostPtr = bufferCast<T>(*forcedLogitsHost);
+        for (SizeType bi = 0; bi < mBatchSize; ++bi)
+        {
+            for (SizeType vi = 0; vi < mVocabSizePadded; ++vi)
+            {
+                forcedLogitsHostPtr[bi * mVocabSizePadded + vi] = vi == params.forcedTokens[bi] ? T{0.0f} : T{-FLT_MAX};
+            }
+        }
+        mForcedLogitsDevice = mBufferManager->copyFrom(*forcedLogitsHost, tensorrt_llm::runtime::MemoryType::kGPU);
+
+        auto forcedLogits = mForcedLogitsDevice;
+        auto const vocabSizePadded = mVocabSizePadded;
+        auto processor = std::make_shared<tensorrt_llm::runtime::LogitsPostProcessor const>(
+            [forcedLogits, vocabSizePadded](ITensor& logits, ITensor const& batchSlots,
+                std::vector<SizeType> const& batchIndices, cudaStream_t stream)
+            {
+                auto const beamWidth = logits.getShape().d[1];
+                for (auto const bi : batchIndices)
+                {
+                    for (SizeType beam = 0; beam < beamWidth; ++beam)
+                    {
+                        auto* dst = bufferCast<T>(logits) + (bi * beamWidth + beam) * vocabSizePadded;
+                        auto const* src = bufferCast<T>(*forcedLogits) + bi * vocabSizePadded;
+                        TLLM_CUDA_CHECK(cudaMemcpyAsync(
+                            dst, src, vocabSizePadded * sizeof(T), cudaMemcpyDeviceToDevice, stream));
+                    }
+                }
+            });
+        mLogitsPostProcessors.resize(mMaxBatchSize);
+        for (SizeType bi = 0; bi < mBatchSize; ++bi)
+        {
+            if (params.forcedTokens[bi] >= 0)
+            {
+                mLogitsPostProcessors[batchSlotsPtr[bi]] = processor;
+            }
+        }
+    }
+
     mLogitsVec.resize(mBatchSize);
     for (SizeType bi = 0; bi < mBatchSize; ++bi)
     {
@@ -339,6 +382,11 @@ typename DynamicDecodeLayer<T>::ForwardParams DynamicDecodeLayerTest<T>::createI
     forwardParams.stop_words_lengths = tcc::toTllmTensor(*mStopWordsLens);
     forwardParams.max_stop_words_len = mMaxStopWordsLen;
 
+    if (!mLogitsPostProcessors.empty())
+    {
+        forwardParams.logits_post_processors = mLogitsPostProcessors;
+    }
+
     // TODO(nkorobov): extend to
     // std::optional<tc::Tensor> src_cache_indirection;
     // std::optional<tc::Tensor> sequence_limit_length;
@@ -432,8 +480,8 @@ bool DynamicDecodeLayerTest<T>::checkResult(int32_t* outputIds, std::vector<std:
 }
 
 template <typename T>
-void DynamicDecodeLayerTest<T>::fillRefLogits(
-    int32_t const* seqLenHost, std::vector<std::set<int32_t>> const& expectedOutputIds, SizeType step)
+void DynamicDecodeLayerTest<T>::fillRefLogits(int32_t const* seqLenHost,
+    std::vector<std::set<int32_t>> const& expectedOutputIds, SamplingParams const& params, SizeType step)
 {
     auto const batchSlotsPtr = bufferCast<int32_t>(*mBatchSlots);
     auto const runtimeLogitsHost = bufferCast<T>(*mRuntimeLogitsHost);
@@ -447,8 +495,9 @@ void DynamicDecodeLayerTest<T>::fillRefLogits(
         auto& expectedSet = expectedOutputIds[step * mBatchBeam + bi];
         TLLM_CHECK(expectedSet.size() == 1);
         auto expectedToken = *expectedSet.begin();
-        bufferCast<float>(*mRefLogProbsHost)[batchSlot * mMaxSeqLen + step]
-            = logf(runtimeLogitsHost[bi * mVocabSizePadded + expectedToken]);
+        bufferCast<float>(*mRefLogProbsHost)[batchSlot * mMaxSeqLen + step] = params.refLogProbs.empty()
+            ? logf(runtimeLogitsHost[bi * mVocabSizePadded + expectedToken])
+            : params.refLogProbs[step];
     }
 }
 
@@ -485,7 +534,7 @@ void DynamicDecodeLayerTest<T>::runTestImpl(
 
             if (greedySearch)
             {
-                fillRefLogits(bufferCast<int32_t>(*seqLenHost), expectedOutputIds, step);
+                fillRefLogits(bufferCast<int32_t>(*seqLenHost), expectedOutputIds, params, step);
             }
 
             {
@@ -1142,6 +1191,40 @@ TYPED_TEST(DynamicDecodeLayerTest, TopKTemperatureBatch)
     this->runTest(expectedOutputIds, params);
 }
 
+TYPED_TEST(DynamicDecodeLayerTest, TopKZeroTemperature)
+{
+    // Temperature 0 is greedy search. The logits must not be scaled by 1 / 1e-6, which overflows them in half precision
+    // and picks the first token instead of the argmax.
+    SamplingParams params;
+    params.temperatures = {0.0f};
+    params.topKs = {2};
+    params.topPs = {1.0f};
+    // The argmax has probability 0.4 at every step
+    params.refLogProbs = std::vector<float>(4, logf(0.4f));
+    std::vector<std::set<int32_t>> expectedOutputIds{
+        {4}, {4}, {4}, {4}, {4}, {4}, // step 0
+        {0}, {0}, {0}, {0}, {0}, {0}, // step 1
+        {2}, {2}, {2}, {2}, {2}, {2}, // step 2
+        {0}, {0}, {0}, {0}, {0}, {0}  // step 3
+    };
+    this->runTest(expectedOutputIds, params);
+}
+
+TYPED_TEST(DynamicDecodeLayerTest, TopKZeroTemperatureBatch)
+{
+    SamplingParams params;
+    params.temperatures = {0.0f, 1.0f, 0.0f, 0.5f, 0.0f, 1.0f};
+    params.topKs = {2};
+    params.topPs = {1.0f};
+    std::vector<std::set<int32_t>> expectedOutputIds{
+        {4}, {4, 5}, {4}, {4, 5}, {4}, {4, 5}, // step 0
+        {0}, {0, 1}, {0}, {0, 1}, {0}, {0, 1}, // step 1
+        {2}, {2, 3}, {2}, {2, 3}, {2}, {2, 3}, // step 2
+        {0}, {0, 1}, {0}, {0, 1}, {0}, {0, 1}  // step 3
+    };
+    this->runTest(expectedOutputIds, params);
+}
+
 TYPED_TEST(DynamicDecodeLayerTest, TopKRepetitionPenalty)
 {
     uint32_t topK = 1;
@@ -1483,4 +1566,21 @@ TYPED_TEST(DynamicDecodeLayerTest, StopWords)
     };
     this->runTest(expectedOutputIds, params);
 }
+
+TYPED_TEST(DynamicDecodeLayerTest, LogitsPostProcessor)
+{
+    uint32_t topK = 1;
+    SamplingParams params;
+    params.topKs = {topK};
+    params.topPs = {1.0f};
+    params.forcedTokens = {7, -1, 1, -1, 6, -1};
+    std::vector<std::set<int32_t>> expectedOutputIds{
+        // batch
+        {7}, {4}, {1}, {4}, {6}, {4}, // step 0
+        {7}, {0}, {1}, {0}, {6}, {0}, // step 1
+        {7}, {2}, {1}, {2}, {6}, {2}, // step 2
+        {7}, {0}, {1}, {0}, {6}, {0}  // step 3
+    };
+    this->runTest(expectedOutputIds, params);
+}
 } // namespace tensorrt_llm::tests::layers::sampling
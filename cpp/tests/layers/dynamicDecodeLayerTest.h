@@ -52,6 +52,8 @@ struct SamplingParams
     std::vector<int32_t> topPResetIds;
     std::vector<std::vector<std::vector<int32_t>>> badWords;
     std::vector<std::vector<std::vector<int32_t>>> stopWords;
+    std::vector<int32_t> forcedTokens; // [batchSize], token forced by a logits post-processor, -1 for none
+    std::vector<float> refLogProbs;    // [step], log prob of every greedy token, from the runtime logits if empty
     bool useBias = false;
 };
 
@@ -110,6 +112,9 @@ private:
 
     TensorPtr mCumLogProbsDevice;
 
+    TensorPtr mForcedLogitsDevice;
+    std::vector<tensorrt_llm::runtime::LogitsPostProcessorPtr> mLogitsPostProcessors;
+
     std::vector<tensorrt_llm::common::Tensor> mLogitsVec;
 
     struct cudaDeviceProp mDeviceProp;
@@ -145,8 +150,8 @@ private:
     void runTestImpl(
         std::vector<std::set<int32_t>> const& expectedOutputIds, SamplingParams const& params, int32_t endId = -1);
 
-    void fillRefLogits(
-        int32_t const* seqLenHost, std::vector<std::set<int32_t>> const& expectedOutputIds, int32_t step);
+    void fillRefLogits(int32_t const* seqLenHost, std::vector<std::set<int32_t>> const& expectedOutputIds,
+        SamplingParams const& params, int32_t step);
 
 public:
     void runTest(
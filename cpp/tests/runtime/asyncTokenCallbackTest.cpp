@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/asyncTokenCallback.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class AsyncTokenCallbackTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_F(AsyncTokenCallbackTest, DeliversSnapshotsInOrder)
+{
+    SizeType constexpr numSteps{16};
+    std::vector<SizeType> const initial(numSteps, -1);
+    ITensor::SharedPtr outputIds = mManager->copyFrom(initial, ITensor::makeShape({numSteps}), MemoryType::kGPU);
+
+    std::vector<SizeType> steps;
+    std::vector<SizeType> lastTokens;
+    bool finished{false};
+    {
+        AsyncTokenCallback callback{[&](ITensor::SharedPtr const& ids, SizeType step, bool isFinished)
+            {
+                EXPECT_EQ(ids->getMemoryType(), MemoryType::kPINNED);
+                steps.push_back(step);
+                lastTokens.push_back(bufferCast<SizeType>(*ids)[step]);
+                finished = isFinished;
+            },
+            outputIds, *mManager, 2};
+
+        for (SizeType step = 0; step < numSteps; ++step)
+        {
+            // Emulate the decoder writing the token of this step.
+            auto tokenSlot = ITensor::slice(outputIds, step, 1);
+            std::vector<SizeType> const value{step};
+            mManager->copy(value.data(), *tokenSlot);
+            callback(step, step == numSteps - 1);
+        }
+        callback.flush();
+    }
+
+    ASSERT_EQ(steps.size(), numSteps);
+    for (SizeType step = 0; step < numSteps; ++step)
+    {
+        EXPECT_EQ(steps[step], step);
+        EXPECT_EQ(lastTokens[step], step);
+    }
+    EXPECT_TRUE(finished);
+}
+
+TEST_F(AsyncTokenCallbackTest, FlushRethrowsCallbackException)
+{
+    ITensor::SharedPtr outputIds = mManager->gpu(ITensor::makeShape({4}), nvinfer1::DataType::kINT32);
+    AsyncTokenCallback callback{[](ITensor::SharedPtr const&, SizeType step, bool)
+        {
+            if (step == 1)
+            {
+                throw std::runtime_error("callback failed");
+            }
+        },
+        outputIds, *mManager};
+
+    callback(0, false);
+    callback(1, false);
+    callback(2, true);
+    EXPECT_THROW(callback.flush(), std::runtime_error);
+    EXPECT_NO_THROW(callback.flush());
+}
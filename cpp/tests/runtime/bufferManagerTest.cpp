@@ -170,3 +170,31 @@ TEST_F(BufferManagerTest, MemPoolAttributes)
     EXPECT_LE(manager.memoryPoolReserved(), reserved);
     EXPECT_LE(manager.memoryPoolFree(), free);
 }
+
+TEST_F(BufferManagerTest, NamedMemPool)
+{
+    BufferManager::MemoryPoolConfig poolConfig;
+    poolConfig.poolName = "bufferManagerTest";
+    poolConfig.releaseThreshold = 0;
+    poolConfig.idleTrimSize = 0;
+    BufferManager manager(mStream, poolConfig);
+    auto const device = mStream->getDevice();
+    auto const memPool = manager.getMemoryPool();
+    EXPECT_EQ(memPool, BufferManager::getNamedMemoryPool(poolConfig.poolName, device));
+    ::cudaMemPool_t defaultPool;
+    TLLM_CUDA_CHECK(cudaDeviceGetDefaultMemPool(&defaultPool, device));
+    EXPECT_NE(memPool, defaultPool);
+    std::uint64_t threshold{1};
+    TLLM_CUDA_CHECK(cudaMemPoolGetAttribute(memPool, cudaMemPoolAttrReleaseThreshold, &threshold));
+    EXPECT_EQ(threshold, 0u);
+
+    auto constexpr kBytesToReserve = 1 << 20;
+    auto const defaultUsed = BufferManager(mStream).memoryPoolUsed();
+    {
+        auto const mem = manager.gpu(kBytesToReserve);
+        EXPECT_GE(manager.memoryPoolUsed(), kBytesToReserve);
+        EXPECT_EQ(BufferManager(mStream).memoryPoolUsed(), defaultUsed);
+    }
+    manager.onIdle();
+    EXPECT_EQ(manager.memoryPoolReserved(), 0u);
+}
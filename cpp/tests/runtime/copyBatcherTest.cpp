@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/copyBatcher.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class CopyBatcherTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_F(CopyBatcherTest, RoundTrip)
+{
+    // Sizes that are not multiples of the staging alignment take the byte path of the kernel
+    std::vector<std::size_t> const sizes{1, 3, 16, 37, 64, 100};
+    CopyBatcher batcher{mStream, 1024, 128, 4};
+
+    std::vector<IBuffer::UniquePtr> sources;
+    std::vector<IBuffer::UniquePtr> devices;
+    std::vector<IBuffer::UniquePtr> copies;
+    std::vector<IBuffer::UniquePtr> results;
+    for (std::size_t i = 0; i < sizes.size(); ++i)
+    {
+        auto& src = sources.emplace_back(BufferManager::cpu(sizes[i], nvinfer1::DataType::kINT8));
+        auto* srcPtr = bufferCast<std::int8_t>(*src);
+        std::iota(srcPtr, srcPtr + sizes[i], static_cast<std::int8_t>(i));
+        devices.emplace_back(mManager->gpu(sizes[i], nvinfer1::DataType::kINT8));
+        copies.emplace_back(mManager->gpu(sizes[i], nvinfer1::DataType::kINT8));
+        results.emplace_back(BufferManager::cpu(sizes[i], nvinfer1::DataType::kINT8));
+        batcher.copy(*src, *devices[i]);
+        // The source is staged at enqueue and may be overwritten right away
+        std::fill_n(srcPtr, sizes[i], std::int8_t{-1});
+    }
+    // More copies than maxCopies, so this flushed in between
+    EXPECT_LT(batcher.getNumPending(), static_cast<SizeType>(sizes.size()));
+    for (std::size_t i = 0; i < sizes.size(); ++i)
+    {
+        batcher.copy(*devices[i], *copies[i]);
+        batcher.copy(*copies[i], *results[i]);
+    }
+    batcher.flush();
+    EXPECT_EQ(batcher.getNumPending(), 0);
+    mStream->synchronize();
+
+    for (std::size_t i = 0; i < sizes.size(); ++i)
+    {
+        auto const* resultPtr = bufferCast<std::int8_t>(*results[i]);
+        for (std::size_t j = 0; j < sizes[i]; ++j)
+        {
+            EXPECT_EQ(resultPtr[j], static_cast<std::int8_t>(i + j)) << "copy " << i << " byte " << j;
+        }
+    }
+}
+
+TEST_F(CopyBatcherTest, LargeCopyKeepsOrder)
+{
+    CopyBatcher batcher{mStream, 256, 64, 8};
+    auto const small = mManager->copyFrom(std::vector<std::int32_t>{1, 2, 3, 4}, MemoryType::kCPU);
+    auto large = BufferManager::cpu(32, nvinfer1::DataType::kINT32);
+    std::fill_n(bufferCast<std::int32_t>(*large), large->getSize(), 7);
+    IBuffer::SharedPtr device = mManager->gpu(32, nvinfer1::DataType::kINT32);
+    auto deviceHead = IBuffer::slice(device, 0, small->getSize());
+
+    // The large copy is issued directly and must not overwrite the small one enqueued after it
+    batcher.copy(*large, *device);
+    batcher.copy(*small, *deviceHead);
+    batcher.flush();
+    auto host = mManager->copyFrom(*device, MemoryType::kCPU);
+    mStream->synchronize();
+
+    auto const* hostPtr = bufferCast<std::int32_t>(*host);
+    std::vector<std::int32_t> const expected{1, 2, 3, 4, 7, 7};
+    EXPECT_EQ(std::vector<std::int32_t>(hostPtr, hostPtr + expected.size()), expected);
+}
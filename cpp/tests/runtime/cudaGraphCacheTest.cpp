@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaGraphCache.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class CudaGraphCacheTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    std::vector<SizeType> copyToHost(IBuffer const& buffer)
+    {
+        std::vector<SizeType> values(buffer.getSize());
+        mManager->copy(buffer, values.data());
+        mStream->synchronize();
+        return values;
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_F(CudaGraphCacheTest, UpdatesKernelParameters)
+{
+    SizeType constexpr size{1000};
+    auto buffer = mManager->gpu(ITensor::makeShape({size}), nvinfer1::DataType::kINT32);
+    CudaGraphCache cache{};
+    CudaGraphCache::Key const key{CudaGraphCache::getBatchSizeBucket(3), 1, 0};
+
+    for (SizeType step = 0; step < 4; ++step)
+    {
+        // The filled value changes at every step and is baked into the captured kernel parameters
+        cache.launch(key, *mStream,
+            [&]()
+            {
+                kernels::invokeFill(*buffer, step, *mStream);
+                kernels::invokeAdd(*buffer, 1, *mStream);
+            });
+        auto const values = copyToHost(*buffer);
+        for (SizeType i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(values[i], step + 1) << "Error at step " << step << " index " << i;
+        }
+    }
+    // The first step runs without capture, the following ones update the same instance.
+    EXPECT_EQ(cache.getNumInstantiations(), 1);
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(CudaGraphCacheTest, ReinstantiatesOnTopologyChange)
+{
+    auto buffer = mManager->gpu(ITensor::makeShape({16}), nvinfer1::DataType::kINT32);
+    CudaGraphCache cache{};
+    CudaGraphCache::Key const key{4, 1, 0};
+
+    for (SizeType numAdds = 1; numAdds <= 3; ++numAdds)
+    {
+        auto enqueue = [&]()
+        {
+            kernels::invokeFill(*buffer, SizeType{0}, *mStream);
+            for (SizeType i = 0; i < numAdds; ++i)
+            {
+                kernels::invokeAdd(*buffer, 1, *mStream);
+            }
+        };
+        cache.launch(key, *mStream, enqueue);
+        EXPECT_EQ(copyToHost(*buffer).front(), numAdds);
+    }
+    // A different number of kernels cannot be applied with an update
+    EXPECT_EQ(cache.getNumInstantiations(), 2);
+}
+
+TEST_F(CudaGraphCacheTest, EvictsLeastRecentlyUsed)
+{
+    auto buffer = mManager->gpu(ITensor::makeShape({16}), nvinfer1::DataType::kINT32);
+    CudaGraphCache cache{2};
+    auto enqueue = [&]() { kernels::invokeFill(*buffer, SizeType{1}, *mStream); };
+
+    for (SizeType batchSize : {1, 2, 4, 8})
+    {
+        cache.launch({batchSize, 1, 0}, *mStream, enqueue);
+    }
+    EXPECT_EQ(cache.size(), 2);
+    mStream->synchronize();
+}
+
+TEST_F(CudaGraphCacheTest, EndsCaptureOnException)
+{
+    auto buffer = mManager->gpu(ITensor::makeShape({16}), nvinfer1::DataType::kINT32);
+    CudaGraphCache cache{};
+    CudaGraphCache::Key const key{1, 1, 0};
+    cache.launch(key, *mStream, [&]() { kernels::invokeFill(*buffer, SizeType{1}, *mStream); });
+
+    EXPECT_THROW(cache.launch(key, *mStream,
+                     [&]()
+                     {
+                         kernels::invokeFill(*buffer, SizeType{2}, *mStream);
+                         throw std::runtime_error("enqueue failed");
+                     }),
+        std::runtime_error);
+
+    // The stream is usable again
+    kernels::invokeFill(*buffer, SizeType{3}, *mStream);
+    EXPECT_EQ(copyToHost(*buffer).front(), 3);
+}
+
+TEST(CudaGraphCacheBucketTest, BatchSizeBucket)
+{
+    EXPECT_EQ(CudaGraphCache::getBatchSizeBucket(1), 1);
+    EXPECT_EQ(CudaGraphCache::getBatchSizeBucket(3), 4);
+    EXPECT_EQ(CudaGraphCache::getBatchSizeBucket(32), 32);
+    EXPECT_EQ(CudaGraphCache::getBatchSizeBucket(33), 64);
+}
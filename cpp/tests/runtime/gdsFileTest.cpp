@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/gdsFile.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace tensorrt_llm::runtime
+{
+
+class GdsFileTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static std::size_t constexpr kSIZE = 3 * 4096 + 100;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        mPath = fs::temp_directory_path() / "gdsFileTest" / "file.bin";
+        fs::remove_all(mPath.parent_path());
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(mPath.parent_path());
+    }
+
+    static IBuffer::SharedPtr createPattern(std::size_t size, std::uint8_t first)
+    {
+        IBuffer::SharedPtr buffer = BufferManager::pinned(size);
+        auto* data = bufferCast<std::uint8_t>(*buffer);
+        std::iota(data, data + size, first);
+        return buffer;
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+    fs::path mPath;
+};
+
+TEST_F(GdsFileTest, hostRoundTrip)
+{
+    {
+        GdsFile file(mPath, kSIZE);
+        EXPECT_TRUE(fs::exists(mPath));
+        EXPECT_EQ(fs::file_size(mPath), kSIZE);
+
+        auto src = createPattern(kSIZE, 7);
+        file.write(src, 0, *mStream);
+        IBuffer::SharedPtr dst = BufferManager::pinned(kSIZE);
+        file.read(dst, 0, *mStream);
+        file.synchronize();
+
+        auto const* srcData = bufferCast<std::uint8_t>(*src);
+        auto const* dstData = bufferCast<std::uint8_t>(*dst);
+        for (std::size_t i = 0; i < kSIZE; ++i)
+        {
+            ASSERT_EQ(dstData[i], srcData[i]) << "at " << i;
+        }
+        EXPECT_EQ(file.getNumBytesWritten(), kSIZE);
+        EXPECT_EQ(file.getNumBytesRead(), kSIZE);
+    }
+    EXPECT_FALSE(fs::exists(mPath));
+}
+
+TEST_F(GdsFileTest, deviceExtents)
+{
+    GdsFile file(mPath, kSIZE);
+    std::size_t constexpr kEXTENT = 1000;
+
+    // Two extents of a device buffer are written to the file in reverse order
+    auto const pattern = createPattern(2 * kEXTENT, 0);
+    IBuffer::SharedPtr device = mManager->gpu(2 * kEXTENT);
+    mManager->copy(*pattern, *device);
+    file.write(device,
+        {GdsFile::Extent{kSIZE - kEXTENT, 0, kEXTENT}, GdsFile::Extent{4096, kEXTENT, kEXTENT}}, *mStream);
+    // The source may be dropped right after enqueueing
+    device.reset();
+
+    IBuffer::SharedPtr readBack = mManager->gpu(2 * kEXTENT);
+    mManager->setZero(*readBack);
+    file.read(readBack, {GdsFile::Extent{4096, 0, kEXTENT}, GdsFile::Extent{kSIZE - kEXTENT, kEXTENT, kEXTENT}},
+        *mStream);
+    auto const host = mManager->copyFrom(*readBack, MemoryType::kCPU);
+    file.synchronize();
+    mStream->synchronize();
+
+    auto const* patternData = bufferCast<std::uint8_t>(*pattern);
+    auto const* hostData = bufferCast<std::uint8_t>(*host);
+    for (std::size_t i = 0; i < kEXTENT; ++i)
+    {
+        ASSERT_EQ(hostData[i], patternData[kEXTENT + i]) << "at " << i;
+        ASSERT_EQ(hostData[kEXTENT + i], patternData[i]) << "at " << kEXTENT + i;
+    }
+}
+
+TEST_F(GdsFileTest, rejectsOutOfBoundsExtents)
+{
+    GdsFile file(mPath, kSIZE);
+    auto const buffer = createPattern(100, 0);
+    EXPECT_THROW(file.write(buffer, kSIZE - 10, *mStream), std::runtime_error);
+    EXPECT_THROW(file.read(buffer, {GdsFile::Extent{0, 50, 100}}, *mStream), std::runtime_error);
+}
+
+TEST_F(GdsFileTest, keepsFileIfRequested)
+{
+    {
+        GdsFile file(mPath, kSIZE, false);
+    }
+    EXPECT_TRUE(fs::exists(mPath));
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/generationLogitsStreamer.h"
+
+#include <memory>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class GenerationLogitsStreamerTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    // Logits of a step with the value 100 * step + 10 * row + column
+    ITensor::SharedPtr makeLogits(SizeType step, SizeType numRows, SizeType vocabSize)
+    {
+        std::vector<float> values(numRows * vocabSize);
+        for (SizeType row = 0; row < numRows; ++row)
+        {
+            for (SizeType column = 0; column < vocabSize; ++column)
+            {
+                values[row * vocabSize + column] = static_cast<float>(100 * step + 10 * row + column);
+            }
+        }
+        return mManager->copyFrom(values, ITensor::makeShape({numRows, 1, vocabSize}), MemoryType::kGPU);
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_F(GenerationLogitsStreamerTest, ScattersStepsIntoOutput)
+{
+    SizeType constexpr batchSize{2};
+    SizeType constexpr beamWidth{2};
+    SizeType constexpr maxNewTokens{3};
+    SizeType constexpr vocabSize{4};
+    ITensor::SharedPtr output = BufferManager::pinned(
+        ITensor::makeShape({batchSize, beamWidth, maxNewTokens, vocabSize}), nvinfer1::DataType::kFLOAT);
+
+    GenerationLogitsStreamer streamer{nvinfer1::DataType::kFLOAT, nvinfer1::DataType::kFLOAT, 1};
+    streamer.setOutput(0, output);
+    // The context produces one row per request, the generation steps one per beam
+    std::vector<ITensor::SharedPtr> logits{makeLogits(0, batchSize, vocabSize)};
+    for (SizeType step = 1; step < maxNewTokens; ++step)
+    {
+        logits.push_back(makeLogits(step, batchSize * beamWidth, vocabSize));
+    }
+    for (SizeType step = 0; step < maxNewTokens; ++step)
+    {
+        streamer.waitForSlot(0, step, *mStream);
+        streamer.push(0, step, *logits[step], *mStream);
+    }
+    streamer.join(*mStream);
+    mStream->synchronize();
+
+    auto const* outputPtr = bufferCast<float>(*output);
+    for (SizeType batch = 0; batch < batchSize; ++batch)
+    {
+        for (SizeType beam = 0; beam < beamWidth; ++beam)
+        {
+            for (SizeType step = 0; step < maxNewTokens; ++step)
+            {
+                auto const row = step == 0 ? batch : batch * beamWidth + beam;
+                for (SizeType column = 0; column < vocabSize; ++column)
+                {
+                    auto const index = ((batch * beamWidth + beam) * maxNewTokens + step) * vocabSize + column;
+                    EXPECT_EQ(outputPtr[index], static_cast<float>(100 * step + 10 * row + column))
+                        << "batch " << batch << " beam " << beam << " step " << step;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(GenerationLogitsStreamerTest, NarrowsToHalf)
+{
+    SizeType constexpr batchSize{3};
+    SizeType constexpr maxNewTokens{2};
+    SizeType constexpr vocabSize{8};
+    EXPECT_FALSE(GenerationLogitsStreamer::isSupported(nvinfer1::DataType::kHALF, nvinfer1::DataType::kFLOAT));
+    ITensor::SharedPtr output
+        = BufferManager::pinned(ITensor::makeShape({batchSize, 1, maxNewTokens, vocabSize}), nvinfer1::DataType::kHALF);
+
+    GenerationLogitsStreamer streamer{nvinfer1::DataType::kFLOAT, nvinfer1::DataType::kHALF, 1};
+    streamer.setOutput(0, output);
+    std::vector<ITensor::SharedPtr> logits;
+    for (SizeType step = 0; step < maxNewTokens; ++step)
+    {
+        // The logits must stay alive until the copies are joined
+        auto const& stepLogits = logits.emplace_back(makeLogits(step, batchSize, vocabSize));
+        streamer.push(0, step, *stepLogits, *mStream);
+    }
+    streamer.join(*mStream);
+    mStream->synchronize();
+
+    auto const* outputPtr = bufferCast<half>(*output);
+    for (SizeType batch = 0; batch < batchSize; ++batch)
+    {
+        for (SizeType step = 0; step < maxNewTokens; ++step)
+        {
+            for (SizeType column = 0; column < vocabSize; ++column)
+            {
+                auto const index = (batch * maxNewTokens + step) * vocabSize + column;
+                EXPECT_EQ(static_cast<float>(outputPtr[index]), static_cast<float>(100 * step + 10 * batch + column));
+            }
+        }
+    }
+}
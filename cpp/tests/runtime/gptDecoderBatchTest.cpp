@@ -560,8 +560,8 @@ TEST_P(ParamTest, Test)
 
 INSTANTIATE_TEST_SUITE_P(DecoderBwTest, ParamTest,
     testing::Combine(testing::Values(nvinfer1::DataType::kFLOAT, nvinfer1::DataType::kHALF),
-        testing::Values(
-            BeamConfig{1, {1, 1, 1}}, BeamConfig{3, {3, 3, 3, 3}}, BeamConfig{4, {3, 3, 3}}, BeamConfig{4, {2, 3, 4}}),
+        testing::Values(BeamConfig{1, {1, 1, 1}}, BeamConfig{3, {3, 3, 3, 3}}, BeamConfig{4, {3, 3, 3}},
+            BeamConfig{4, {2, 3, 4}}, BeamConfig{4, {1, 4, 1, 2}}),
         testing::Values(false, true)),
     generateTestName);
 
@@ -586,8 +586,8 @@ TEST_P(ParamWavefrontTest, Test)
 
 INSTANTIATE_TEST_SUITE_P(DecoderBwTest, ParamWavefrontTest,
     testing::Combine(testing::Values(nvinfer1::DataType::kFLOAT, nvinfer1::DataType::kHALF),
-        testing::Values(
-            BeamConfig{1, {1, 1, 1}}, BeamConfig{3, {3, 3, 3, 3}}, BeamConfig{4, {3, 3, 3}}, BeamConfig{4, {2, 3, 4}}),
+        testing::Values(BeamConfig{1, {1, 1, 1}}, BeamConfig{3, {3, 3, 3, 3}}, BeamConfig{4, {3, 3, 3}},
+            BeamConfig{4, {2, 3, 4}}, BeamConfig{4, {1, 4, 1, 2}}),
         testing::Values(false, true)),
     generateTestName);
 
@@ -19,6 +19,7 @@
 
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/tensorSpan.h"
 
 using namespace tensorrt_llm::runtime;
 
@@ -217,3 +218,38 @@ TEST(ITensorTest, TensorSlice)
     auto uniqueSlice = ITensor::slice(std::move(constSlice), 1);
     EXPECT_EQ(uniqueSlice->getShape().d[0], dims.d[0] - offset - 1);
 }
+
+TEST(ITensorTest, TensorSpan)
+{
+    auto const dims = ITensor::makeShape({16, 8, 4});
+    auto constexpr dataType = nvinfer1::DataType::kFLOAT;
+    ITensor::SharedPtr tensor{BufferManager::cpu(dims, dataType)};
+    TensorSpan const span{*tensor};
+    EXPECT_EQ(span.data(), tensor->data());
+    EXPECT_EQ(span.getSize(), tensor->getSize());
+    EXPECT_EQ(span.getMemoryType(), MemoryType::kCPU);
+
+    auto const offset = 4;
+    auto const slice = span.slice(offset, 2);
+    auto const ownedSlice = ITensor::slice(tensor, offset, 2);
+    EXPECT_EQ(slice.data(), ownedSlice->data());
+    EXPECT_EQ(slice.getShape().d[0], 2);
+    EXPECT_EQ(slice.getSize(), ownedSlice->getSize());
+    EXPECT_EQ(span.slice(offset).getShape().d[0], dims.d[0] - offset);
+    EXPECT_THROW(static_cast<void>(span.slice(dims.d[0] - 1, 2)), std::runtime_error);
+
+    auto const row = span[offset];
+    EXPECT_EQ(row.getShape().nbDims, 2);
+    EXPECT_EQ(row.data<float>(), bufferCast<float>(*tensor) + offset * dims.d[1] * dims.d[2]);
+    EXPECT_THROW(static_cast<void>(row.data<std::int32_t>()), std::bad_cast);
+
+    auto const view = row.view(ITensor::makeShape({2, 4, 2}));
+    EXPECT_EQ(view.data(), row.data());
+    EXPECT_EQ(view[1].data<float>(), row.data<float>() + 8);
+    EXPECT_THROW(static_cast<void>(row.view(ITensor::makeShape({2, 8, 4}))), std::runtime_error);
+
+    std::shared_ptr<ITensor const> constTensor{tensor};
+    ConstTensorSpan const constSpan{*constTensor};
+    ConstTensorSpan const fromMutable{slice};
+    EXPECT_EQ(constSpan.slice(offset, 2).data(), fromMutable.data());
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/inProcessWorld.h"
+#include "tensorrt_llm/runtime/spscQueue.h"
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+SizeType getNumDevices()
+{
+    int numDevices{0};
+    return cudaGetDeviceCount(&numDevices) == cudaSuccess ? numDevices : 0;
+}
+} // namespace
+
+TEST(SpscQueueTest, PushPop)
+{
+    SpscQueue<int> queue{2};
+    EXPECT_EQ(queue.getCapacity(), 2);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.tryPop().has_value());
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_FALSE(queue.tryPush(3));
+    EXPECT_EQ(queue.tryPop(), 1);
+    EXPECT_TRUE(queue.tryPush(3));
+    EXPECT_EQ(queue.tryPop(), 2);
+    EXPECT_EQ(queue.tryPop(), 3);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, KeepsOrderAcrossThreads)
+{
+    int constexpr numValues = 100000;
+    SpscQueue<std::unique_ptr<int>> queue{16};
+    std::thread producer(
+        [&queue]()
+        {
+            for (int value = 0; value < numValues; ++value)
+            {
+                auto item = std::make_unique<int>(value);
+                while (!queue.tryPush(std::move(item)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    for (int expected = 0; expected < numValues; ++expected)
+    {
+        std::optional<std::unique_ptr<int>> item;
+        while (!(item = queue.tryPop()))
+        {
+            std::this_thread::yield();
+        }
+        ASSERT_EQ(**item, expected);
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(InProcessWorldTest, SingleRank)
+{
+    if (getNumDevices() < 1)
+    {
+        GTEST_SKIP() << "No GPU available";
+    }
+    EXPECT_EQ(InProcessWorld::getCurrent(), nullptr);
+    EXPECT_FALSE(InProcessWorld::getCurrentRank().has_value());
+
+    InProcessWorld world{1};
+    std::atomic<int> numCalls{0};
+    world.run(
+        [&](WorldConfig const& worldConfig)
+        {
+            ++numCalls;
+            EXPECT_EQ(worldConfig.getSize(), 1);
+            EXPECT_EQ(InProcessWorld::getCurrent(), &world);
+            EXPECT_EQ(InProcessWorld::getSessionRank(), 0);
+            EXPECT_EQ(world.broadcastValue(std::set<int>{0}, 42), 42);
+        });
+    EXPECT_EQ(numCalls.load(), 1);
+    EXPECT_EQ(InProcessWorld::getCurrent(), nullptr);
+}
+
+TEST(InProcessWorldTest, Collectives)
+{
+    auto const numDevices = getNumDevices();
+    if (numDevices < 2)
+    {
+        GTEST_SKIP() << "Needs at least 2 GPUs";
+    }
+    auto const size = std::min(numDevices, 4);
+    InProcessWorld world{size};
+    std::vector<int*> sharedObjects(size);
+    world.run(
+        [&](WorldConfig const& worldConfig)
+        {
+            auto const rank = worldConfig.getRank();
+            EXPECT_EQ(InProcessWorld::getCurrentRank(), rank);
+            EXPECT_EQ(worldConfig.getTensorParallelism(), size);
+            int device{-1};
+            EXPECT_EQ(cudaGetDevice(&device), cudaSuccess);
+            EXPECT_EQ(device, worldConfig.getDevice());
+
+            std::set<int> all;
+            for (int idx = 0; idx < size; ++idx)
+            {
+                all.insert(idx);
+            }
+            // Consecutive calls with the same group are matched in order
+            for (int round = 0; round < 3; ++round)
+            {
+                auto const parts = world.allgather(all, std::vector<char>(rank + 1, static_cast<char>(round)));
+                ASSERT_EQ(static_cast<SizeType>(parts.size()), size);
+                for (int idx = 0; idx < size; ++idx)
+                {
+                    EXPECT_EQ(parts[idx], std::vector<char>(idx + 1, static_cast<char>(round)));
+                }
+            }
+            EXPECT_EQ(world.broadcastValue(all, 100 + rank), 100);
+
+            // Pairs exchange independently of the others
+            std::set<int> const pair{rank - rank % 2, std::min(rank - rank % 2 + 1, size - 1)};
+            EXPECT_EQ(world.broadcastValue(pair, rank), *pair.begin());
+
+            auto const shared = world.getShared<int>("value", []() { return std::make_shared<int>(7); });
+            sharedObjects[rank] = shared.get();
+        });
+    for (auto* shared : sharedObjects)
+    {
+        ASSERT_NE(shared, nullptr);
+        EXPECT_EQ(shared, sharedObjects.front());
+        EXPECT_EQ(*shared, 7);
+    }
+}
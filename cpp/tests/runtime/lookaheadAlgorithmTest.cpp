@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/lookaheadAlgorithm.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+using TensorPtr = ITensor::SharedPtr;
+using VecTokens = LookaheadAlgorithm::VecTokens;
+
+class LookaheadAlgorithmTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static auto constexpr kWindowSize = 2;
+    static auto constexpr kNgramSize = 3;
+    static auto constexpr kVerificationSetSize = 2;
+
+    void SetUp() override
+    {
+        mAlgorithm = std::make_unique<LookaheadAlgorithm>(kWindowSize, kNgramSize, kVerificationSetSize);
+        auto const maxNumTokens = mAlgorithm->getMaxNumTokens();
+        mInputTokens = BufferManager::cpu(ITensor::makeShape({maxNumTokens}), nvinfer1::DataType::kINT32);
+        mPositionOffsets = BufferManager::cpu(ITensor::makeShape({maxNumTokens}), nvinfer1::DataType::kINT32);
+        mPackedMask = BufferManager::cpu(
+            ITensor::makeShape({maxNumTokens, mAlgorithm->getNumPackedMasks()}), nvinfer1::DataType::kINT32);
+        mOutputTokens = BufferManager::cpu(ITensor::makeShape({maxNumTokens}), nvinfer1::DataType::kINT32);
+
+        // Window levels {1, 2} and {3, 1}, pool 1 -> {2, 3}, 2 -> {3, 1}, 3 -> {1, 2}
+        mAlgorithm->setup({1, 2, 3, 1, 2});
+    }
+
+    SizeType prepare(TokenIdType root)
+    {
+        return mAlgorithm->prepare(root, mInputTokens, mPositionOffsets, mPackedMask);
+    }
+
+    void setOutputs(std::vector<TokenIdType> const& outputs)
+    {
+        std::copy(outputs.begin(), outputs.end(), bufferCast<TokenIdType>(*mOutputTokens));
+    }
+
+    std::unique_ptr<LookaheadAlgorithm> mAlgorithm;
+    TensorPtr mInputTokens;
+    TensorPtr mPositionOffsets;
+    TensorPtr mPackedMask;
+    TensorPtr mOutputTokens;
+};
+
+TEST_F(LookaheadAlgorithmTest, prepareLayout)
+{
+    EXPECT_EQ(mAlgorithm->getMaxNumTokens(), 9);
+    EXPECT_EQ(mAlgorithm->getPoolSize(), 3);
+
+    auto const numTokens = prepare(1);
+    ASSERT_EQ(numTokens, 7);
+
+    std::vector<TokenIdType> const refTokens{1, 1, 2, 3, 1, 2, 3};
+    std::vector<SizeType> const refOffsets{0, 1, 2, 2, 3, 1, 2};
+    std::vector<SizeType> const refMask{0b1, 0b11, 0b111, 0b1011, 0b10111, 0b100001, 0b1100001};
+    for (SizeType i = 0; i < numTokens; ++i)
+    {
+        EXPECT_EQ(bufferCast<TokenIdType>(*mInputTokens)[i], refTokens[i]) << "token " << i;
+        EXPECT_EQ(bufferCast<SizeType>(*mPositionOffsets)[i], refOffsets[i]) << "token " << i;
+        EXPECT_EQ(bufferCast<SizeType>(*mPackedMask)[i], refMask[i]) << "token " << i;
+    }
+}
+
+TEST_F(LookaheadAlgorithmTest, acceptLongestMatch)
+{
+    prepare(1);
+    // Root predicts 2, candidate {2, 3} predicts 3 and 4, the last window level predicts 7 and 8
+    setOutputs({2, 0, 0, 7, 8, 3, 4});
+    std::vector<SizeType> acceptedIndices;
+    auto const acceptedTokens = mAlgorithm->update(*mOutputTokens, acceptedIndices);
+    EXPECT_EQ(acceptedTokens, (VecTokens{2, 3, 4}));
+    EXPECT_EQ(acceptedIndices, (std::vector<SizeType>{0, 5, 6}));
+
+    // New n-grams 1 -> {3, 7} and 2 -> {1, 8}, the window is now {3, 1} and {7, 8}
+    EXPECT_EQ(mAlgorithm->getPoolSize(), 5);
+    ASSERT_EQ(prepare(1), 1 + 2 * (kWindowSize + 2));
+    std::vector<TokenIdType> const refTokens{1, 3, 1, 7, 8, 3, 7, 2, 3};
+    for (SizeType i = 0; i < static_cast<SizeType>(refTokens.size()); ++i)
+    {
+        EXPECT_EQ(bufferCast<TokenIdType>(*mInputTokens)[i], refTokens[i]) << "token " << i;
+    }
+}
+
+TEST_F(LookaheadAlgorithmTest, noMatch)
+{
+    prepare(1);
+    setOutputs({9, 0, 0, 7, 8, 3, 4});
+    std::vector<SizeType> acceptedIndices;
+    auto const acceptedTokens = mAlgorithm->update(*mOutputTokens, acceptedIndices);
+    EXPECT_EQ(acceptedTokens, (VecTokens{9}));
+    EXPECT_EQ(acceptedIndices, (std::vector<SizeType>{0}));
+
+    // Without n-grams for the root only the lookahead branch is verified
+    EXPECT_EQ(prepare(42), 1 + 2 * kWindowSize);
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/gptModelConfig.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/loraCache.h"
+#include "tensorrt_llm/runtime/loraModule.h"
+#include "tensorrt_llm/runtime/loraUtils.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+namespace tensorrt_llm::runtime
+{
+using TensorPtr = ITensor::SharedPtr;
+
+class LoraCacheTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kADAPTER_SIZE = 2;
+    static SizeType constexpr kNUM_ROWS = 2;
+
+    LoraCacheTest()
+        : mModelConfig(1, 2, 1, 4, nvinfer1::DataType::kFLOAT)
+    {
+    }
+
+    void SetUp() override
+    {
+        mStream = std::make_unique<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+
+        mModelConfig.setLoraModules(LoraModule::createLoraModules({"attn_dense", "attn_qkv"}, 4, 4, 1, 1, 2, 1));
+        auto const& modules = mModelConfig.getLoraModules();
+        auto const dense = std::find_if(modules.begin(), modules.end(),
+            [](auto const& m) { return m.value() == static_cast<SizeType>(LoraModule::ModuleType::kATTN_DENSE); });
+        mRowSize = dense->flattenedInOutSize(kADAPTER_SIZE);
+        mRowWidth = LoraCache::calculatePageSize(mModelConfig, kADAPTER_SIZE);
+
+        mDiskDir = fs::temp_directory_path() / "loraCacheTest";
+        fs::remove_all(mDiskDir);
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(mDiskDir);
+    }
+
+    //! \brief One attn_dense row per layer, all weights set to value.
+    std::tuple<TensorPtr, TensorPtr> createTask(float value) const
+    {
+        TensorPtr weights = BufferManager::cpu(ITensor::makeShape({kNUM_ROWS, mRowWidth}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*weights), weights->getSize(), value);
+        TensorPtr config = BufferManager::cpu(
+            ITensor::makeShape({kNUM_ROWS, lora::kLORA_CONFIG_ROW_SIZE}), nvinfer1::DataType::kINT32);
+        auto configPtr = bufferCast<SizeType>(*config);
+        for (SizeType row = 0; row < kNUM_ROWS; ++row)
+        {
+            auto rowPtr = configPtr + row * lora::kLORA_CONFIG_ROW_SIZE;
+            rowPtr[lora::kLORA_CONFIG_MODULE_OFF] = static_cast<SizeType>(LoraModule::ModuleType::kATTN_DENSE);
+            rowPtr[lora::kLORA_CONFIG_LAYER_OFF] = row;
+            rowPtr[lora::kLORA_CONFIG_ADAPTER_SIZE_OFF] = kADAPTER_SIZE;
+        }
+        return {weights, config};
+    }
+
+    void checkRows(LoraCache const& cache, LoraCache::TaskIdType taskId, float value) const
+    {
+        for (SizeType row = 0; row < kNUM_ROWS; ++row)
+        {
+            auto rowWeights = cache.getRowWeights(taskId, row);
+            ASSERT_EQ(rowWeights->getSize(), mRowSize);
+            auto hostRow = mManager->copyFrom(*rowWeights, MemoryType::kCPU);
+            mStream->synchronize();
+            auto hostRowPtr = bufferCast<float>(*hostRow);
+            for (std::size_t i = 0; i < hostRow->getSize(); ++i)
+            {
+                EXPECT_EQ(hostRowPtr[i], value) << "row " << row << " element " << i;
+            }
+        }
+    }
+
+    //! \brief Prefetch and wait for the copy, so that acquire succeeds if the adapter fits.
+    bool acquire(LoraCache& cache, LoraCache::TaskIdType taskId, LoraCache::RequestIdType requestId) const
+    {
+        if (!cache.prefetch(taskId))
+        {
+            return false;
+        }
+        mStream->synchronize();
+        return cache.acquire(taskId, requestId);
+    }
+
+    // A page per row, a device pool that fits one task and a host tier of bytes per task
+    LoraCacheConfig createConfig(SizeType numTasksHost, bool useDisk) const
+    {
+        auto const taskBytes = static_cast<std::size_t>(kNUM_ROWS) * mRowWidth * sizeof(float);
+        return LoraCacheConfig{kNUM_ROWS, mRowSize, numTasksHost * taskBytes,
+            useDisk ? std::optional<fs::path>{mDiskDir} : std::nullopt};
+    }
+
+    std::unique_ptr<BufferManager> mManager;
+    BufferManager::CudaStreamPtr mStream;
+    GptModelConfig mModelConfig;
+    SizeType mRowSize;
+    SizeType mRowWidth;
+    fs::path mDiskDir;
+};
+
+TEST_F(LoraCacheTest, putAcquire)
+{
+    LoraCache cache(createConfig(2, false), mModelConfig, *mManager, mStream);
+    auto [weights, config] = createTask(1.f);
+    cache.put(1, weights, config);
+
+    EXPECT_TRUE(cache.has(1));
+    EXPECT_FALSE(cache.isResident(1));
+    EXPECT_EQ(cache.getNumPages(1), kNUM_ROWS);
+
+    ASSERT_TRUE(acquire(cache, 1, 10));
+    EXPECT_TRUE(cache.isResident(1));
+    EXPECT_EQ(cache.getNumFreeDevicePages(), 0);
+    // Acquiring again for the same request is a no-op
+    ASSERT_TRUE(acquire(cache, 1, 10));
+    checkRows(cache, 1, 1.f);
+
+    auto cachedConfig = cache.getConfig(1);
+    EXPECT_EQ(cachedConfig->getSize(), config->getSize());
+    EXPECT_TRUE(std::equal(bufferCast<SizeType>(*config), bufferCast<SizeType>(*config) + config->getSize(),
+        bufferCast<SizeType>(*cachedConfig)));
+}
+
+TEST_F(LoraCacheTest, evictionRespectsInFlightRequests)
+{
+    LoraCache cache(createConfig(2, false), mModelConfig, *mManager, mStream);
+    auto [weights1, config1] = createTask(1.f);
+    auto [weights2, config2] = createTask(2.f);
+    cache.put(1, weights1, config1);
+    cache.put(2, weights2, config2);
+
+    ASSERT_TRUE(acquire(cache, 1, 10));
+    EXPECT_FALSE(acquire(cache, 2, 11));
+    EXPECT_TRUE(cache.isResident(1));
+
+    cache.release(10);
+    ASSERT_TRUE(acquire(cache, 2, 11));
+    EXPECT_FALSE(cache.isResident(1));
+    EXPECT_TRUE(cache.has(1));
+    checkRows(cache, 2, 2.f);
+
+    cache.release(11);
+    ASSERT_TRUE(acquire(cache, 1, 12));
+    checkRows(cache, 1, 1.f);
+}
+
+TEST_F(LoraCacheTest, acquireDoesNotWaitForCopy)
+{
+    LoraCache cache(createConfig(2, false), mModelConfig, *mManager);
+    auto [weights, config] = createTask(1.f);
+    cache.put(1, weights, config);
+
+    // A cold adapter is prefetched by the first acquire, which fails until the copy on the transfer stream is done
+    while (!cache.acquire(1, 10))
+    {
+        EXPECT_TRUE(cache.has(1));
+    }
+    EXPECT_TRUE(cache.isResident(1));
+    checkRows(cache, 1, 1.f);
+}
+
+TEST_F(LoraCacheTest, hostSpillsToDisk)
+{
+    {
+        LoraCache cache(createConfig(1, true), mModelConfig, *mManager, mStream);
+        auto [weights1, config1] = createTask(1.f);
+        auto [weights2, config2] = createTask(2.f);
+        cache.put(1, weights1, config1);
+        cache.put(2, weights2, config2);
+        EXPECT_TRUE(cache.has(1));
+        EXPECT_TRUE(fs::exists(mDiskDir / "lora_1.bin"));
+
+        // Task 1 is read from disk straight into the device pool and leaves task 2 in the host tier
+        ASSERT_TRUE(acquire(cache, 1, 10));
+        checkRows(cache, 1, 1.f);
+        cache.release(10);
+        EXPECT_FALSE(fs::exists(mDiskDir / "lora_2.bin"));
+
+        ASSERT_TRUE(acquire(cache, 2, 11));
+        checkRows(cache, 2, 2.f);
+        cache.release(11);
+
+        // Evicted from the device again, task 1 is still on disk
+        ASSERT_TRUE(acquire(cache, 1, 12));
+        checkRows(cache, 1, 1.f);
+    }
+    EXPECT_FALSE(fs::exists(mDiskDir / "lora_1.bin"));
+    EXPECT_FALSE(fs::exists(mDiskDir / "lora_2.bin"));
+}
+
+TEST_F(LoraCacheTest, hostDropsWithoutDisk)
+{
+    LoraCache cache(createConfig(1, false), mModelConfig, *mManager, mStream);
+    auto [weights1, config1] = createTask(1.f);
+    auto [weights2, config2] = createTask(2.f);
+    cache.put(1, weights1, config1);
+    cache.put(2, weights2, config2);
+    EXPECT_FALSE(cache.has(1));
+    EXPECT_TRUE(cache.has(2));
+}
+
+} // namespace tensorrt_llm::runtime
@@ -32,6 +32,7 @@
 #include "tensorrt_llm/runtime/utils/numpyUtils.h"
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -919,4 +920,124 @@ TEST_F(LoraManagerTest, fillInputTensors_tp2_pp2)
     checkLoraTensors(loraManager, targetPtrs, weightsPtrs, targetAdapterSizes, adapterSizes, modelConfig, worldConfig,
         modules, numModules, numLayers, numSeqs);
 }
+
+TEST_F(LoraManagerTest, mergeDominantTask)
+{
+    auto const worldConfig = WorldConfig(1);
+    LoraManager loraManager;
+    loraManager.create(mModelConfig, worldConfig, *mManager);
+
+    auto const moduleId = static_cast<SizeType>(LoraModule::ModuleType::kATTN_DENSE);
+    SizeType constexpr hidden = 8;
+    SizeType constexpr rowSize = 2 * 2 * hidden;
+    std::vector<SizeType> const adapterSizes{2, 1};
+
+    // attn_dense of layer 0 for both tasks, in [adapterSize, hidden] then out [hidden, adapterSize] per row
+    std::vector<std::vector<float>> hostWeights;
+    for (SizeType taskId = 0; taskId < static_cast<SizeType>(adapterSizes.size()); ++taskId)
+    {
+        std::vector<float> rowWeights(rowSize, 0.f);
+        for (SizeType i = 0; i < rowSize; ++i)
+        {
+            rowWeights[i] = 0.01f * static_cast<float>((i * 7 + taskId * 3) % 11) - 0.05f;
+        }
+        hostWeights.push_back(rowWeights);
+        std::vector<SizeType> const config{moduleId, 0, adapterSizes[taskId]};
+        loraManager.addTask(taskId, mManager->copyFrom(rowWeights, ITensor::makeShape({1, rowSize}), MemoryType::kGPU),
+            mManager->copyFrom(config, ITensor::makeShape({1, 3}), MemoryType::kCPU));
+    }
+
+    std::vector<float> baseHost(hidden * hidden);
+    for (SizeType i = 0; i < hidden * hidden; ++i)
+    {
+        baseHost[i] = static_cast<float>(i % 5) - 2.f;
+    }
+    TensorPtr base = mManager->copyFrom(baseHost, ITensor::makeShape({hidden, hidden}), MemoryType::kGPU);
+    loraManager.setMergeTargets({{"dense_0", moduleId, 0, base, 0}});
+
+    LoraManager::ReqIdsVec const taskIds{0, 0, 1};
+    std::vector<bool> const loraEnabled{true, true, true};
+    EXPECT_EQ(LoraManager::findDominantTask(taskIds, loraEnabled, 0.6f), std::optional<LoraManager::TaskIdType>{0});
+    EXPECT_EQ(LoraManager::findDominantTask(taskIds, loraEnabled, 0.7f), std::nullopt);
+
+    auto const inWeights = [&](SizeType taskId, SizeType r, SizeType i) { return hostWeights[taskId][r * hidden + i]; };
+    auto const outWeights = [&](SizeType taskId, SizeType o, SizeType r)
+    { return hostWeights[taskId][adapterSizes[taskId] * hidden + o * adapterSizes[taskId] + r]; };
+
+    auto merged = loraManager.mergeTask(0, worldConfig, *mManager);
+    ASSERT_EQ(merged.size(), 1);
+    auto mergedHost = mManager->copyFrom(*merged.at("dense_0"), MemoryType::kCPU);
+    mStream->synchronize();
+    for (SizeType o = 0; o < hidden; ++o)
+    {
+        for (SizeType i = 0; i < hidden; ++i)
+        {
+            auto expected = baseHost[o * hidden + i];
+            for (SizeType r = 0; r < adapterSizes[0]; ++r)
+            {
+                expected += outWeights(0, o, r) * inWeights(0, r, i);
+            }
+            EXPECT_NEAR(bufferCast<float>(*mergedHost)[o * hidden + i], expected, 1e-5f) << o << " " << i;
+        }
+    }
+
+    loraManager.setMergedTask(0, worldConfig, *mManager);
+    auto const numModules = static_cast<SizeType>(mModelConfig.getLoraModules().size());
+    auto const numLayers = mModelConfig.getNbLayers();
+    SizeType constexpr numSeqs = 4;
+    auto weightsPtrs
+        = mManager->cpu(ITensor::makeShape({numModules, numLayers, numSeqs, 2}), nvinfer1::DataType::kINT64);
+    auto ranks = mManager->cpu(ITensor::makeShape({numModules, numLayers, numSeqs}), nvinfer1::DataType::kINT32);
+    mManager->setZero(*weightsPtrs);
+    mManager->setZero(*ranks);
+    // A request of the merged task, one of the other task and one without LoRA, the last slot stays empty
+    loraManager.fillInputTensors(
+        weightsPtrs, ranks, {0, 1, 0}, {1, 1, 1}, {true, true, false}, 3, mModelConfig, worldConfig);
+    mStream->synchronize();
+
+    auto const* ranksPtr = bufferCast<int32_t>(*ranks);
+    auto const* ptrsPtr = bufferCast<int64_t>(*weightsPtrs);
+    // attn_dense is the first module, only layer 0 is adapted
+    EXPECT_EQ(ranksPtr[0], 0);
+    EXPECT_EQ(ranksPtr[1], adapterSizes[0] + adapterSizes[1]);
+    EXPECT_EQ(ranksPtr[2], adapterSizes[0]);
+    EXPECT_EQ(ranksPtr[3], 0);
+    for (SizeType i = numSeqs; i < static_cast<SizeType>(ranks->getSize()); ++i)
+    {
+        EXPECT_EQ(ranksPtr[i], 0);
+    }
+
+    auto const readCorrection = [&](SizeType seq, bool in)
+    {
+        auto const rank = ranksPtr[seq];
+        auto const shape = in ? ITensor::makeShape({rank, hidden}) : ITensor::makeShape({hidden, rank});
+        auto* data = reinterpret_cast<void*>(ptrsPtr[seq * 2 + (in ? 0 : 1)]);
+        auto host = mManager->copyFrom(*ITensor::wrap(data, nvinfer1::DataType::kFLOAT, shape), MemoryType::kCPU);
+        mStream->synchronize();
+        return std::vector<float>(bufferCast<float>(*host), bufferCast<float>(*host) + host->getSize());
+    };
+
+    // The corrections subtract the merged adapter and add their own one: in [-A_0 ; A_t], out [B_0 | B_t]
+    for (SizeType seq : {1, 2})
+    {
+        auto const rank = ranksPtr[seq];
+        auto const correctionIn = readCorrection(seq, true);
+        auto const correctionOut = readCorrection(seq, false);
+        for (SizeType r = 0; r < rank; ++r)
+        {
+            for (SizeType i = 0; i < hidden; ++i)
+            {
+                auto const expected
+                    = r < adapterSizes[0] ? -inWeights(0, r, i) : inWeights(1, r - adapterSizes[0], i);
+                EXPECT_FLOAT_EQ(correctionIn[r * hidden + i], expected) << seq << " " << r << " " << i;
+            }
+            for (SizeType o = 0; o < hidden; ++o)
+            {
+                auto const expected
+                    = r < adapterSizes[0] ? outWeights(0, o, r) : outWeights(1, o, r - adapterSizes[0]);
+                EXPECT_FLOAT_EQ(correctionOut[o * rank + r], expected) << seq << " " << o << " " << r;
+            }
+        }
+    }
+}
 } // namespace tensorrt_llm::runtime
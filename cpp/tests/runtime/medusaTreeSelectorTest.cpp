@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/medusaTreeSelector.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/medusaModule.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+using TensorPtr = ITensor::SharedPtr;
+
+class MedusaTreeSelectorTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static auto constexpr kMedusaHeads = 3;
+    static auto constexpr kMaxMedusaTokens = 6;
+
+    MedusaTreeSelectorTest()
+        : mModule(kMedusaHeads, kMaxMedusaTokens)
+    {
+    }
+
+    std::vector<MedusaModule::MedusaChoices> makeTrees() const
+    {
+        // Deliberately not sorted by size
+        return {{{0}, {1}, {0, 0}, {0, 1}, {0, 0, 0}, {1, 0}}, {{0}}, {{0}, {1}, {0, 0}}};
+    }
+
+    void expectSlotEqualsTree(
+        MedusaTreeSelector const& selector, SizeType batchSlot, MedusaModule::MedusaChoices choices)
+    {
+        auto const tokensPerStep = mModule.tokensPerStep();
+        auto constexpr dtype = nvinfer1::DataType::kINT32;
+        TensorPtr topKs = BufferManager::cpu(ITensor::makeShape({kMedusaHeads}), dtype);
+        TensorPtr positionOffsets = BufferManager::cpu(ITensor::makeShape({tokensPerStep}), dtype);
+        TensorPtr treeIds = BufferManager::cpu(ITensor::makeShape({tokensPerStep}), dtype);
+        TensorPtr paths = BufferManager::cpu(ITensor::makeShape({tokensPerStep, kMedusaHeads + 1}), dtype);
+        TensorPtr packedMask
+            = BufferManager::cpu(ITensor::makeShape({tokensPerStep, mModule.numPackedMasks()}), dtype);
+        std::memset(paths->data(), 0, paths->getSizeInBytes());
+        std::memset(packedMask->data(), 0, packedMask->getSizeInBytes());
+        SizeType numPaths{0};
+        mModule.initMedusaTensorsFromChoices(choices, topKs, positionOffsets, treeIds, paths, packedMask, numPaths);
+
+        auto const expectSliceEq = [batchSlot](TensorPtr const& all, TensorPtr const& ref)
+        {
+            auto const slice = ITensor::slice(all, batchSlot, 1);
+            ASSERT_EQ(slice->getSize(), ref->getSize());
+            auto const* slicePtr = bufferCast<SizeType>(*slice);
+            auto const* refPtr = bufferCast<SizeType>(*ref);
+            for (std::size_t i = 0; i < ref->getSize(); ++i)
+            {
+                EXPECT_EQ(slicePtr[i], refPtr[i]) << "index " << i;
+            }
+        };
+        expectSliceEq(selector.getTopKs(), topKs);
+        expectSliceEq(selector.getPositionOffsets(), positionOffsets);
+        expectSliceEq(selector.getTreeIds(), treeIds);
+        expectSliceEq(selector.getPaths(), paths);
+        expectSliceEq(selector.getPackedMasks(), packedMask);
+        EXPECT_EQ(bufferCast<SizeType>(*selector.getNumPaths())[batchSlot], numPaths);
+    }
+
+    MedusaModule mModule;
+};
+
+TEST_F(MedusaTreeSelectorTest, sortsTrees)
+{
+    MedusaTreeSelector selector(mModule, makeTrees(), 2);
+    ASSERT_EQ(selector.getNumTrees(), 3);
+    EXPECT_EQ(selector.getTreeNumTokens(0), 1);
+    EXPECT_EQ(selector.getTreeNumTokens(1), 3);
+    EXPECT_EQ(selector.getTreeNumTokens(2), 6);
+    EXPECT_EQ(selector.getTreeDepth(0), 1);
+    EXPECT_EQ(selector.getTreeDepth(1), 2);
+    EXPECT_EQ(selector.getTreeDepth(2), 3);
+}
+
+TEST_F(MedusaTreeSelectorTest, newRequestUsesLargestTree)
+{
+    MedusaTreeSelector selector(mModule, makeTrees(), 2);
+    selector.newRequest(1);
+    EXPECT_EQ(selector.selectTrees({1}), kMaxMedusaTokens + 1);
+    EXPECT_EQ(selector.getSelectedTree(1), 2);
+    expectSlotEqualsTree(selector, 1, makeTrees()[0]);
+}
+
+TEST_F(MedusaTreeSelectorTest, lowAcceptanceShrinksTree)
+{
+    MedusaTreeSelector selector(mModule, makeTrees(), 2);
+    selector.newRequest(0);
+    selector.newRequest(1);
+    for (int step = 0; step < 16; ++step)
+    {
+        selector.updateAcceptance(0, 0);
+        selector.updateAcceptance(1, 3);
+    }
+    EXPECT_LT(selector.getExpectedAcceptedTokens(0), 0.1f);
+    EXPECT_FLOAT_EQ(selector.getExpectedAcceptedTokens(1), 3.f);
+
+    EXPECT_EQ(selector.selectTrees({0, 1}), kMaxMedusaTokens + 1);
+    EXPECT_EQ(selector.getSelectedTree(0), 0);
+    EXPECT_EQ(selector.getSelectedTree(1), 2);
+    expectSlotEqualsTree(selector, 0, makeTrees()[1]);
+    expectSlotEqualsTree(selector, 1, makeTrees()[0]);
+
+    // A new request in the slot starts again with the largest tree.
+    selector.newRequest(0);
+    selector.selectTrees({0});
+    EXPECT_EQ(selector.getSelectedTree(0), 2);
+}
+
+TEST_F(MedusaTreeSelectorTest, batchBudgetShrinksLowestAcceptanceFirst)
+{
+    MedusaTreeSelector selector(mModule, makeTrees(), 2, 7);
+    selector.newRequest(0);
+    selector.newRequest(1);
+    selector.updateAcceptance(0, 3);
+    // 0.75 * 3 + 0.25 * 2 = 2.75 accepted tokens, prefers the tree with 3 tokens
+    selector.updateAcceptance(1, 2);
+
+    EXPECT_EQ(selector.selectTrees({0, 1}), kMaxMedusaTokens + 1);
+    EXPECT_EQ(selector.getSelectedTree(0), 2);
+    EXPECT_EQ(selector.getSelectedTree(1), 0);
+    expectSlotEqualsTree(selector, 1, makeTrees()[1]);
+}
+
+TEST_F(MedusaTreeSelectorTest, budgetBelowSmallestTrees)
+{
+    MedusaTreeSelector selector(mModule, makeTrees(), 2, 1);
+    selector.newRequest(0);
+    selector.newRequest(1);
+    EXPECT_EQ(selector.selectTrees({0, 1}), 2);
+    EXPECT_EQ(selector.getSelectedTree(0), 0);
+    EXPECT_EQ(selector.getSelectedTree(1), 0);
+}
+
+} // namespace tensorrt_llm::runtime
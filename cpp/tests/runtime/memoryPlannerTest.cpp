@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/memoryPlanner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+auto constexpr kFloat = nvinfer1::DataType::kFLOAT;
+} // namespace
+
+TEST(MemoryPlannerTest, DisjointLifetimesShareMemory)
+{
+    MemoryPlanner planner;
+    auto const first = planner.add(ITensor::makeShape({64, 16}), kFloat, {0, 0});
+    auto const second = planner.add(ITensor::makeShape({32, 16}), kFloat, {1, 2});
+    planner.plan();
+
+    EXPECT_EQ(planner.getOffset(first), 0);
+    EXPECT_EQ(planner.getOffset(second), 0);
+    EXPECT_EQ(planner.getArenaSize(), 64 * 16 * sizeof(float));
+    EXPECT_EQ(planner.getTotalSize(), 96 * 16 * sizeof(float));
+}
+
+TEST(MemoryPlannerTest, OverlappingLifetimesDoNotShareMemory)
+{
+    MemoryPlanner planner;
+    auto const first = planner.add(ITensor::makeShape({64, 16}), kFloat, {0, 1});
+    auto const second = planner.add(ITensor::makeShape({32, 16}), kFloat, {1, 2});
+    auto const third = planner.add(ITensor::makeShape({32, 16}), kFloat, {2, 2});
+    planner.plan();
+
+    EXPECT_EQ(planner.getOffset(first), 0);
+    EXPECT_EQ(planner.getOffset(second), 64 * 16 * sizeof(float));
+    // Only the first tensor is dead in the last phase
+    EXPECT_EQ(planner.getOffset(third), 0);
+    EXPECT_EQ(planner.getArenaSize(), 96 * 16 * sizeof(float));
+}
+
+TEST(MemoryPlannerTest, AlignsOffsets)
+{
+    MemoryPlanner planner;
+    auto const first = planner.add(ITensor::makeShape({3}), nvinfer1::DataType::kINT8, {0, 0});
+    auto const second = planner.add(ITensor::makeShape({5}), nvinfer1::DataType::kINT32, {0, 0});
+    planner.plan();
+
+    EXPECT_EQ(planner.getOffset(first) % MemoryPlanner::kAlignment, 0);
+    EXPECT_EQ(planner.getOffset(second) % MemoryPlanner::kAlignment, 0);
+    EXPECT_NE(planner.getOffset(first), planner.getOffset(second));
+    EXPECT_EQ(planner.getArenaSize(), 2 * MemoryPlanner::kAlignment);
+}
+
+TEST(MemoryPlannerTest, AllocatesTensorsInOneArena)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    BufferManager manager{std::make_shared<CudaStream>()};
+    MemoryPlanner planner;
+    planner.add(ITensor::makeShape({4, 8}), kFloat, {0, 1});
+    planner.add(ITensor::makeShape({2, 8}), nvinfer1::DataType::kINT32, {0, 1});
+    auto const tensors = planner.allocate(manager);
+
+    ASSERT_EQ(tensors.size(), 2);
+    EXPECT_EQ(tensors[0]->getShape().d[0], 4);
+    EXPECT_EQ(tensors[1]->getDataType(), nvinfer1::DataType::kINT32);
+    EXPECT_EQ(tensors[0]->getMemoryType(), MemoryType::kGPU);
+    auto const* first = static_cast<std::uint8_t*>(tensors[0]->data());
+    auto const* second = static_cast<std::uint8_t*>(tensors[1]->data());
+    // Both are rounded up to one alignment unit, tensors of equal size are placed in the order they were added
+    EXPECT_EQ(second - first, static_cast<std::ptrdiff_t>(MemoryPlanner::kAlignment));
+
+    // Planned tensors can shrink but not grow beyond their planned shape
+    tensors[0]->reshape(ITensor::makeShape({2, 8}));
+    EXPECT_THROW(tensors[0]->reshape(ITensor::makeShape({5, 8})), std::exception);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+
+#include <sstream>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class MemoryTimelineTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        auto& timeline = MemoryTimeline::getInstance();
+        mWasEnabled = timeline.isEnabled();
+        timeline.clear();
+        timeline.setEnabled(true);
+    }
+
+    void TearDown() override
+    {
+        auto& timeline = MemoryTimeline::getInstance();
+        timeline.setEnabled(mWasEnabled);
+        timeline.clear();
+    }
+
+    bool mWasEnabled;
+};
+
+TEST_F(MemoryTimelineTest, PeakSnapshot)
+{
+    auto& timeline = MemoryTimeline::getInstance();
+    auto& counters = MemoryCounters::getInstance();
+    std::vector<char> storage(4);
+    auto const* a = &storage[0];
+    auto const* b = &storage[1];
+    auto const* c = &storage[2];
+    auto const* d = &storage[3];
+
+    {
+        MemoryCounters::ScopedTag const tag{"memoryTimelineTest.kvCache"};
+        timeline.recordAllocation(MemoryType::kGPU, a, 100);
+    }
+    {
+        MemoryCounters::ScopedTag const tag{"memoryTimelineTest.workspace"};
+        timeline.recordAllocation(MemoryType::kGPU, b, 50);
+        timeline.recordAllocation(MemoryType::kPINNED, d, 10);
+    }
+    // Peak of 180 B: a, b and c
+    timeline.recordAllocation(MemoryType::kGPU, c, 30);
+    timeline.recordFree(MemoryType::kGPU, b);
+    timeline.recordAllocation(MemoryType::kGPU, b, 40);
+    // Unknown buffers are ignored
+    timeline.recordFree(MemoryType::kGPU, &storage);
+
+    auto const events = timeline.getEvents();
+    ASSERT_EQ(events.size(), 6);
+    EXPECT_FALSE(events[4].allocation);
+    EXPECT_EQ(events[4].size, 50);
+    EXPECT_EQ(events[4].tag, counters.getTagId("memoryTimelineTest.workspace"));
+    EXPECT_EQ(events[0].tag, counters.getTagId("memoryTimelineTest.kvCache"));
+    EXPECT_EQ(events[3].tag, MemoryCounters::kUntagged);
+    EXPECT_NE(events[0].callSite[0], nullptr);
+
+    auto const snapshots = timeline.getPeakSnapshots();
+    ASSERT_EQ(snapshots.size(), 2);
+    EXPECT_EQ(snapshots[0].memoryType, MemoryType::kGPU);
+    EXPECT_EQ(snapshots[0].bytes, 180);
+    EXPECT_EQ(snapshots[0].timestampNs, events[3].timestampNs);
+    ASSERT_EQ(snapshots[0].allocations.size(), 3);
+    EXPECT_EQ(snapshots[0].allocations[0].ptr, a);
+    EXPECT_EQ(snapshots[0].allocations[1].ptr, b);
+    EXPECT_EQ(snapshots[0].allocations[2].ptr, c);
+    EXPECT_EQ(snapshots[1].memoryType, MemoryType::kPINNED);
+    EXPECT_EQ(snapshots[1].bytes, 10);
+
+    std::ostringstream os;
+    timeline.dump(os);
+    auto const json = os.str();
+    EXPECT_NE(json.find("\"name\":\"GPU memory\",\"ph\":\"C\""), std::string::npos);
+    EXPECT_NE(json.find("\"memoryTimelineTest.kvCache\":100"), std::string::npos);
+    EXPECT_NE(json.find("\"memoryType\":\"GPU\",\"bytes\":180"), std::string::npos);
+    EXPECT_NE(json.find("\"callSite\":[\""), std::string::npos);
+
+    EXPECT_THROW(timeline.recordFree(MemoryType::kCPU, a), tc::TllmException);
+}
+
+TEST_F(MemoryTimelineTest, BufferManager)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+    auto const tag = MemoryCounters::getInstance().getTagId("memoryTimelineTest.decoder");
+    {
+        auto buffer = manager.gpu(1024, nvinfer1::DataType::kINT8, tag);
+        auto untagged = manager.gpu(512, nvinfer1::DataType::kINT8);
+    }
+    stream->synchronize();
+
+    auto const events = MemoryTimeline::getInstance().getEvents();
+    ASSERT_EQ(events.size(), 4);
+    EXPECT_TRUE(events[0].allocation);
+    EXPECT_EQ(events[0].size, 1024);
+    EXPECT_EQ(events[0].tag, tag);
+    EXPECT_EQ(events[0].stream, stream->get());
+    EXPECT_EQ(events[1].tag, MemoryCounters::kUntagged);
+    EXPECT_FALSE(events[2].allocation);
+    EXPECT_FALSE(events[3].allocation);
+    EXPECT_EQ(MemoryTimeline::getInstance().getPeakSnapshots().at(0).bytes, 1536);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/numaAffinity.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace tensorrt_llm::runtime;
+namespace fs = std::filesystem;
+
+namespace
+{
+void writeFile(fs::path const& path, std::string const& content)
+{
+    std::ofstream file{path};
+    file << content;
+}
+} // namespace
+
+TEST(NumaAffinityTest, ParseCpuList)
+{
+    EXPECT_EQ(NumaAffinity::parseCpuList("0-3,8,10-11\n"), (std::vector<SizeType>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(NumaAffinity::parseCpuList("5"), (std::vector<SizeType>{5}));
+    EXPECT_TRUE(NumaAffinity::parseCpuList("").empty());
+    EXPECT_ANY_THROW(NumaAffinity::parseCpuList("4-2"));
+}
+
+TEST(NumaAffinityTest, DeviceLocalityFromSysfs)
+{
+    auto const root = fs::temp_directory_path() / "numaAffinityTest";
+    fs::remove_all(root);
+    fs::create_directories(root / "0000:3b:00.0");
+    writeFile(root / "0000:3b:00.0" / "numa_node", "1\n");
+    writeFile(root / "0000:3b:00.0" / "local_cpulist", "16-19,48\n");
+    fs::create_directories(root / "0000:af:00.0");
+    writeFile(root / "0000:af:00.0" / "numa_node", "-1\n");
+
+    // CUDA reports upper case ids and NVML an 8 digit domain
+    for (auto const* busId : {"0000:3B:00.0", "00000000:3B:00.0"})
+    {
+        auto const locality = NumaAffinity::getDeviceLocality(busId, root);
+        ASSERT_TRUE(locality.has_value()) << busId;
+        EXPECT_EQ(locality->numaNode, 1);
+        EXPECT_EQ(locality->cpus, (std::vector<SizeType>{16, 17, 18, 19, 48}));
+    }
+    EXPECT_FALSE(NumaAffinity::getDeviceLocality("0000:AF:00.0", root).has_value());
+    EXPECT_FALSE(NumaAffinity::getDeviceLocality("0000:01:00.0", root).has_value());
+    fs::remove_all(root);
+}
+
+#if defined(__linux__)
+TEST(NumaAffinityTest, BindCurrentThread)
+{
+    cpu_set_t original;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(original), &original), 0);
+    std::vector<SizeType> allowed;
+    for (SizeType cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &original))
+        {
+            allowed.push_back(cpu);
+        }
+    }
+    ASSERT_FALSE(allowed.empty());
+
+    EXPECT_TRUE(NumaAffinity::bindCurrentThread({allowed.front()}));
+    cpu_set_t bound;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(bound), &bound), 0);
+    EXPECT_EQ(CPU_COUNT(&bound), 1);
+    EXPECT_TRUE(CPU_ISSET(allowed.front(), &bound));
+    EXPECT_FALSE(NumaAffinity::bindCurrentThread({}));
+
+    EXPECT_TRUE(NumaAffinity::bindCurrentThread(allowed));
+}
+#endif
+
+TEST(NumaAffinityTest, PinnedMemoryNode)
+{
+    auto& numaAffinity = NumaAffinity::getInstance();
+    EXPECT_FALSE(numaAffinity.getPinnedMemoryNode().has_value());
+    numaAffinity.setPinnedMemoryNode(0);
+    EXPECT_EQ(numaAffinity.getPinnedMemoryNode(), 0);
+    numaAffinity.setPinnedMemoryNode(std::nullopt);
+    EXPECT_FALSE(numaAffinity.getPinnedMemoryNode().has_value());
+    EXPECT_ANY_THROW(numaAffinity.setPinnedMemoryNode(-2));
+
+    int notNodeLocal{0};
+    EXPECT_FALSE(numaAffinity.freePinned(&notNodeLocal, sizeof(notNodeLocal)));
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/optimizationProfileSelector.h"
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+using Selector = OptimizationProfileSelector;
+
+// A profile for small batches and one covering the maximum shape
+Selector makeSelector()
+{
+    return Selector{{{1, 16, 1, 8}, {1, 1024, 1, 64}}};
+}
+
+void warmUp(Selector& selector, SizeType profile, SizeType numTokens, SizeType batchSize, float latencyMs)
+{
+    for (SizeType i = 0; i < Selector::kNumWarmUpSamples; ++i)
+    {
+        selector.addSample(profile, numTokens, batchSize, latencyMs);
+    }
+}
+} // namespace
+
+TEST(OptimizationProfileSelectorTest, WarmsUpFeasibleProfiles)
+{
+    auto selector = makeSelector();
+    EXPECT_EQ(selector.select(8, 4, 1), 0);
+    warmUp(selector, 0, 8, 4, 2.0f);
+    EXPECT_EQ(selector.select(8, 4, 1), 1);
+    // Shapes beyond the small profile only warm up the large one
+    EXPECT_EQ(selector.select(100, 4, 0), 1);
+}
+
+TEST(OptimizationProfileSelectorTest, SelectsFastestProfile)
+{
+    auto selector = makeSelector();
+    warmUp(selector, 0, 8, 4, 2.0f);
+    warmUp(selector, 1, 8, 4, 3.0f);
+    EXPECT_EQ(selector.select(8, 4, 1), 0);
+    ASSERT_TRUE(selector.getLatency(0, 8, 4).has_value());
+    EXPECT_FLOAT_EQ(*selector.getLatency(0, 8, 4), 2.0f);
+
+    // Latencies are kept per power of 2 bucket
+    EXPECT_EQ(selector.select(7, 3, 1), 0);
+    warmUp(selector, 0, 2, 2, 5.0f);
+    warmUp(selector, 1, 2, 2, 1.0f);
+    EXPECT_EQ(selector.select(2, 2, 0), 1);
+}
+
+TEST(OptimizationProfileSelectorTest, FallsBackToDefaultProfile)
+{
+    auto selector = makeSelector();
+    EXPECT_EQ(selector.select(2048, 4, 1), 1);
+    EXPECT_EQ(selector.select(8, 128, 0), 0);
+}
+
+TEST(OptimizationProfileSelectorTest, MeasuresOnStream)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    CudaStream stream;
+    Selector selector{{{1, 16, 1, 8}}};
+    for (SizeType i = 0; i < Selector::kNumWarmUpSamples; ++i)
+    {
+        EXPECT_EQ(selector.select(4, 2, 0), 0);
+        ASSERT_TRUE(selector.beginMeasurement(0, 4, 2, stream));
+        selector.endMeasurement(stream);
+    }
+    // Enough measurements are pending
+    EXPECT_FALSE(selector.beginMeasurement(0, 4, 2, stream));
+    EXPECT_FALSE(selector.getLatency(0, 4, 2).has_value());
+
+    stream.synchronize();
+    EXPECT_EQ(selector.select(4, 2, 0), 0);
+    ASSERT_TRUE(selector.getLatency(0, 4, 2).has_value());
+    EXPECT_GE(*selector.getLatency(0, 4, 2), 0.0f);
+}
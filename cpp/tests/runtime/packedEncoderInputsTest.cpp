@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/packedEncoderInputs.h"
+
+#include <memory>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+TEST(PackedEncoderInputsTest, BatchByTokens)
+{
+    std::vector<SizeType> const inputLengths{5, 3, 8, 1, 1, 1, 10};
+    auto const batches = PackedEncoderInputs::batchByTokens(inputLengths, 10, 3);
+    ASSERT_EQ(batches.size(), 4);
+
+    EXPECT_EQ(batches[0].firstRequest, 0);
+    EXPECT_EQ(batches[0].numRequests, 2);
+    EXPECT_EQ(batches[0].numTokens, 8);
+    EXPECT_EQ(batches[0].maxInputLength, 5);
+
+    // Limited by the number of tokens, then by the number of requests
+    EXPECT_EQ(batches[1].firstRequest, 2);
+    EXPECT_EQ(batches[1].numRequests, 3);
+    EXPECT_EQ(batches[1].numTokens, 10);
+    EXPECT_EQ(batches[1].maxInputLength, 8);
+
+    EXPECT_EQ(batches[2].firstRequest, 5);
+    EXPECT_EQ(batches[2].numRequests, 1);
+    EXPECT_EQ(batches[2].numTokens, 1);
+
+    EXPECT_EQ(batches[3].firstRequest, 6);
+    EXPECT_EQ(batches[3].numRequests, 1);
+    EXPECT_EQ(batches[3].numTokens, 10);
+
+    EXPECT_TRUE(PackedEncoderInputs::batchByTokens({}, 10, 3).empty());
+    EXPECT_THROW(PackedEncoderInputs::batchByTokens({11}, 10, 3), tc::TllmException);
+}
+
+TEST(PackedEncoderInputsTest, Pack)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+    std::vector<std::vector<TokenIdType>> const inputIds{{1, 2, 3}, {4}, {5, 6}, {7, 8, 9, 10}};
+    PackedEncoderInputs inputs{4, 16, manager};
+
+    PackedEncoderBatch const batch{1, 3, 7, 4};
+    inputs.pack(inputIds, batch);
+    EXPECT_EQ(inputs.getTokenOffsets(), (std::vector<SizeType>{0, 1, 3, 7}));
+
+    TllmRuntime::TensorMap tensorMap;
+    inputs.insertInputTensors(tensorMap);
+    auto const copyToHost = [&](std::string const& name)
+    {
+        auto const& tensor = tensorMap.at(name);
+        std::vector<SizeType> values(tensor->getSize());
+        manager.copy(*tensor, values.data());
+        stream->synchronize();
+        return values;
+    };
+    EXPECT_EQ(copyToHost("input_ids"), (std::vector<SizeType>{4, 5, 6, 7, 8, 9, 10}));
+    EXPECT_EQ(copyToHost("position_ids"), (std::vector<SizeType>{0, 0, 1, 0, 1, 2, 3}));
+    EXPECT_EQ(copyToHost("token_type_ids"), (std::vector<SizeType>(7, 0)));
+    EXPECT_EQ(copyToHost("input_lengths"), (std::vector<SizeType>{1, 2, 4}));
+    EXPECT_EQ(tensorMap.at("max_input_length")->getShape().d[0], 4);
+
+    // The tensors keep their addresses from one batch to the next
+    auto const* inputIdsData = tensorMap.at("input_ids")->data();
+    inputs.pack(inputIds, PackedEncoderBatch{0, 1, 3, 3});
+    inputs.insertInputTensors(tensorMap);
+    EXPECT_EQ(tensorMap.at("input_ids")->data(), inputIdsData);
+    EXPECT_EQ(copyToHost("input_ids"), (std::vector<SizeType>{1, 2, 3}));
+    EXPECT_EQ(tensorMap.at("max_input_length")->getShape().d[0], 3);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/promptTableCache.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+using TensorPtr = ITensor::SharedPtr;
+
+class PromptTableCacheTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static SizeType constexpr kNUM_SLOTS = 2;
+    static SizeType constexpr kMAX_TASK_VOCAB_SIZE = 4;
+    static SizeType constexpr kHIDDEN_SIZE = 3;
+
+    void SetUp() override
+    {
+        mStream = std::make_unique<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        mCache = std::make_unique<PromptTableCache>(
+            kNUM_SLOTS, kMAX_TASK_VOCAB_SIZE, kHIDDEN_SIZE, nvinfer1::DataType::kFLOAT, *mManager);
+    }
+
+    static TensorPtr createTable(SizeType numVirtualTokens, float value)
+    {
+        TensorPtr table
+            = BufferManager::cpu(ITensor::makeShape({numVirtualTokens, kHIDDEN_SIZE}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*table), table->getSize(), value);
+        return table;
+    }
+
+    //! \brief Rows of the slot of the task in the device table.
+    std::vector<float> getSlotRows(PromptTableCache::TaskIdType taskId) const
+    {
+        auto const slot = mCache->getSlot(taskId);
+        auto const slotView = ITensor::slice(
+            mCache->getEmbeddingTable(), slot * kMAX_TASK_VOCAB_SIZE, mCache->getNumVirtualTokens(taskId));
+        auto host = mManager->copyFrom(*slotView, MemoryType::kCPU);
+        mStream->synchronize();
+        auto const* hostPtr = bufferCast<float>(*host);
+        return {hostPtr, hostPtr + host->getSize()};
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::unique_ptr<PromptTableCache> mCache;
+};
+
+TEST_F(PromptTableCacheTest, PutAndLookup)
+{
+    EXPECT_FALSE(mCache->has(1));
+    EXPECT_FALSE(mCache->acquire(1, 100));
+
+    ASSERT_TRUE(mCache->put(1, createTable(2, 1.f)));
+    ASSERT_TRUE(mCache->put(2, createTable(4, 2.f)));
+    EXPECT_TRUE(mCache->has(1));
+    EXPECT_NE(mCache->getSlot(1), mCache->getSlot(2));
+    EXPECT_EQ(mCache->getNumVirtualTokens(1), 2);
+    EXPECT_EQ(mCache->getNumFreeSlots(), 0);
+    EXPECT_EQ(getSlotRows(1), std::vector<float>(2 * kHIDDEN_SIZE, 1.f));
+    EXPECT_EQ(getSlotRows(2), std::vector<float>(4 * kHIDDEN_SIZE, 2.f));
+
+    PromptTuningParams params;
+    mCache->setupParams(params);
+    EXPECT_EQ(params.embeddingTable, mCache->getEmbeddingTable());
+    auto vocabSize = mManager->copyFrom(*params.vocabSize, MemoryType::kCPU);
+    mStream->synchronize();
+    EXPECT_EQ(*bufferCast<SizeType>(*vocabSize), kMAX_TASK_VOCAB_SIZE);
+}
+
+TEST_F(PromptTableCacheTest, EvictLeastRecentlyUsed)
+{
+    ASSERT_TRUE(mCache->put(1, createTable(2, 1.f)));
+    ASSERT_TRUE(mCache->put(2, createTable(2, 2.f)));
+    // Task 1 becomes the most recently used
+    ASSERT_TRUE(mCache->acquire(1, 100));
+    mCache->release(100);
+
+    ASSERT_TRUE(mCache->put(3, createTable(3, 3.f)));
+    EXPECT_TRUE(mCache->has(1));
+    EXPECT_FALSE(mCache->has(2));
+    EXPECT_EQ(getSlotRows(3), std::vector<float>(3 * kHIDDEN_SIZE, 3.f));
+}
+
+TEST_F(PromptTableCacheTest, AcquiredTablesAreNotEvicted)
+{
+    ASSERT_TRUE(mCache->put(1, createTable(2, 1.f)));
+    ASSERT_TRUE(mCache->put(2, createTable(2, 2.f)));
+    ASSERT_TRUE(mCache->acquire(1, 100));
+    ASSERT_TRUE(mCache->acquire(2, 101));
+    EXPECT_FALSE(mCache->put(3, createTable(2, 3.f)));
+
+    mCache->release(101);
+    ASSERT_TRUE(mCache->put(3, createTable(2, 3.f)));
+    EXPECT_TRUE(mCache->has(1));
+    EXPECT_FALSE(mCache->has(2));
+    EXPECT_THROW(static_cast<void>(mCache->put(1, createTable(2, 4.f))), tensorrt_llm::common::TllmException);
+}
+
+} // namespace tensorrt_llm::runtime
@@ -27,6 +27,7 @@
 #include <NvInferRuntime.h>
 
 #include <algorithm>
+#include <cmath>
 #include <memory>
 #include <numeric>
 #include <vector>
@@ -163,6 +164,35 @@ TEST_F(RuntimeKernelTest, ReduceBufferInt32)
     }
 }
 
+TEST_F(RuntimeKernelTest, BuildGenerationStepInputs)
+{
+    SizeType constexpr step{3};
+    for (auto size : {1, 123, 1025})
+    {
+        std::vector<SizeType> contextLengthsVec(size);
+        std::iota(contextLengthsVec.begin(), contextLengthsVec.end(), 5);
+        auto contextLengths = mManager->copyFrom(contextLengthsVec, ITensor::makeShape({size}), MemoryType::kGPU);
+        auto positionIds = mManager->gpu(size, nvinfer1::DataType::kINT32);
+        auto lastTokenIds = mManager->gpu(size, nvinfer1::DataType::kINT32);
+
+        for (auto const packedInput : {false, true})
+        {
+            kernels::invokeBuildGenerationStepInputs(
+                positionIds.get(), *lastTokenIds, *contextLengths, step, packedInput, *mStream);
+            auto positionIdsHost = mManager->copyFrom(*positionIds, MemoryType::kCPU);
+            auto lastTokenIdsHost = mManager->copyFrom(*lastTokenIds, MemoryType::kCPU);
+            mStream->synchronize();
+            auto const* positionIdsPtr = bufferCast<SizeType>(*positionIdsHost);
+            auto const* lastTokenIdsPtr = bufferCast<SizeType>(*lastTokenIdsHost);
+            for (SizeType i = 0; i < size; ++i)
+            {
+                EXPECT_EQ(positionIdsPtr[i], contextLengthsVec[i] + step) << i;
+                EXPECT_EQ(lastTokenIdsPtr[i], packedInput ? i + 1 : 1) << i;
+            }
+        }
+    }
+}
+
 TEST_F(RuntimeKernelTest, Transpose)
 {
     std::vector<std::int32_t> const inputHost{28524, 287, 5093, 12, 23316, 4881, 11, 30022, 263, 8776, 355, 257};
@@ -997,3 +1027,330 @@ TEST_F(RuntimeKernelTest, CopyBatchStride5)
 {
     testCopyBatch(5, *mManager, *mStream);
 }
+
+namespace
+{
+void testCopyBlocks(SizeType blockSize, BufferManager& manager, CudaStream& stream)
+{
+    SizeType constexpr numBlocks{8};
+    std::vector<SizeType> const srcBlockIds{1, 1, 6};
+    std::vector<SizeType> const dstBlockIds{2, 5, 0};
+
+    auto const poolShape = ITensor::makeShape({numBlocks, blockSize});
+    auto poolHost = manager.cpu(poolShape, nvinfer1::DataType::kINT8);
+    auto poolHostPtr = bufferCast<std::int8_t>(*poolHost);
+    for (SizeType idx = 0; idx < numBlocks * blockSize; ++idx)
+    {
+        poolHostPtr[idx] = static_cast<std::int8_t>(idx / blockSize + 1);
+    }
+    auto poolDevice = manager.copyFrom(*poolHost, MemoryType::kGPU);
+    auto srcBlockIdsDevice = manager.copyFrom(srcBlockIds, MemoryType::kGPU);
+    auto dstBlockIdsDevice = manager.copyFrom(dstBlockIds, MemoryType::kGPU);
+
+    kernels::invokeCopyBlocks(*poolDevice, *srcBlockIdsDevice, *dstBlockIdsDevice, stream);
+
+    auto poolOut = manager.copyFrom(*poolDevice, MemoryType::kCPU);
+    auto poolOutPtr = bufferCast<std::int8_t>(*poolOut);
+    for (SizeType block = 0; block < numBlocks; ++block)
+    {
+        auto expected = block + 1;
+        for (std::size_t i = 0; i < dstBlockIds.size(); ++i)
+        {
+            if (dstBlockIds[i] == block)
+            {
+                expected = srcBlockIds[i] + 1;
+            }
+        }
+        for (SizeType ci = 0; ci < blockSize; ++ci)
+        {
+            EXPECT_EQ(expected, poolOutPtr[block * blockSize + ci])
+                << "Error at block: " << block << " column: " << ci << " for block size " << blockSize;
+        }
+    }
+}
+} // namespace
+
+TEST_F(RuntimeKernelTest, CopyBlocksVectorized)
+{
+    testCopyBlocks(1024, *mManager, *mStream);
+}
+
+TEST_F(RuntimeKernelTest, CopyBlocksUnaligned)
+{
+    testCopyBlocks(37, *mManager, *mStream);
+}
+
+TEST_F(RuntimeKernelTest, ScatterDeltas)
+{
+    SizeType constexpr size{1000};
+    std::vector<std::int64_t> table(size);
+    std::iota(table.begin(), table.end(), 0);
+    auto tableDevice = mManager->copyFrom(table, MemoryType::kGPU);
+
+    std::vector<std::int64_t> const indices{3, 999, 0, 512};
+    std::vector<std::int64_t> deltas{indices};
+    for (auto const idx : indices)
+    {
+        deltas.push_back(-idx - 1);
+        table[idx] = -idx - 1;
+    }
+    auto deltasDevice = mManager->copyFrom(deltas, MemoryType::kGPU);
+
+    kernels::invokeScatterDeltas(*tableDevice, *deltasDevice, *mStream);
+
+    auto tableOut = mManager->copyFrom(*tableDevice, MemoryType::kCPU);
+    auto tableOutPtr = bufferCast<std::int64_t>(*tableOut);
+    for (SizeType idx = 0; idx < size; ++idx)
+    {
+        EXPECT_EQ(table[idx], tableOutPtr[idx]) << "Error at index " << idx;
+    }
+}
+
+TEST_F(RuntimeKernelTest, ScatterDecoderSetup)
+{
+    SizeType constexpr maxBatchSize{6};
+    SizeType constexpr maxBeamWidth{2};
+    SizeType constexpr maxTokensPerStep{3};
+    SizeType constexpr numAutomata{2};
+    auto const nvSizeType = TRTDataType<SizeType>::value;
+    auto endIds = mManager->gpu(ITensor::makeShape({maxBatchSize, maxBeamWidth}), nvSizeType);
+    auto lengths = mManager->gpu(ITensor::makeShape({maxBatchSize, maxBeamWidth}), nvSizeType);
+    auto sequenceLimitLength = mManager->gpu(ITensor::makeShape({maxBatchSize}), nvSizeType);
+    auto const stepsShape = ITensor::makeShape({maxTokensPerStep, maxBatchSize, maxBeamWidth});
+    auto newTokensSteps = mManager->gpu(stepsShape, nvSizeType);
+    auto finishedSteps = mManager->gpu(stepsShape, nvinfer1::DataType::kUINT8);
+    auto wordsAutomataStates = mManager->gpu(ITensor::makeShape({maxBatchSize, numAutomata}), nvSizeType);
+    auto streamedLengths = mManager->gpu(ITensor::makeShape({maxBatchSize}), nvSizeType);
+    for (auto* tensor : {endIds.get(), lengths.get(), sequenceLimitLength.get(), newTokensSteps.get(),
+             wordsAutomataStates.get(), streamedLengths.get()})
+    {
+        kernels::invokeFill(*tensor, SizeType{-1}, *mStream);
+    }
+    kernels::invokeFill(*finishedSteps, std::uint8_t{1}, *mStream);
+
+    std::vector<kernels::DecoderSetupParams> const params{{4, 2, 10, 30}, {1, 7, 5, 12}};
+    SizeType const numRequests = params.size();
+    auto paramsDevice = mManager->gpu(
+        ITensor::makeShape({numRequests, static_cast<SizeType>(sizeof(kernels::DecoderSetupParams) / 4)}), nvSizeType);
+    mManager->copy(params.data(), *paramsDevice);
+
+    kernels::invokeScatterDecoderSetup(*paramsDevice, numRequests, *endIds, *lengths, *sequenceLimitLength,
+        *newTokensSteps, *finishedSteps, *wordsAutomataStates, streamedLengths.get(), *mStream);
+
+    auto endIdsHost = mManager->copyFrom(*endIds, MemoryType::kCPU);
+    auto lengthsHost = mManager->copyFrom(*lengths, MemoryType::kCPU);
+    auto sequenceLimitLengthHost = mManager->copyFrom(*sequenceLimitLength, MemoryType::kCPU);
+    auto newTokensStepsHost = mManager->copyFrom(*newTokensSteps, MemoryType::kCPU);
+    auto finishedStepsHost = mManager->copyFrom(*finishedSteps, MemoryType::kCPU);
+    auto wordsAutomataStatesHost = mManager->copyFrom(*wordsAutomataStates, MemoryType::kCPU);
+    auto streamedLengthsHost = mManager->copyFrom(*streamedLengths, MemoryType::kCPU);
+    mStream->synchronize();
+
+    for (SizeType slot = 0; slot < maxBatchSize; ++slot)
+    {
+        auto const it = std::find_if(params.begin(), params.end(),
+            [slot](kernels::DecoderSetupParams const& p) { return p.batchSlot == slot; });
+        auto const isNew = it != params.end();
+        for (SizeType beam = 0; beam < maxBeamWidth; ++beam)
+        {
+            auto const idx = slot * maxBeamWidth + beam;
+            EXPECT_EQ(bufferCast<SizeType>(*endIdsHost)[idx], isNew ? it->endId : -1) << "slot " << slot;
+            EXPECT_EQ(bufferCast<SizeType>(*lengthsHost)[idx], isNew ? it->inputLength : -1) << "slot " << slot;
+            for (SizeType step = 0; step < maxTokensPerStep; ++step)
+            {
+                auto const stepIdx = (step * maxBatchSize + slot) * maxBeamWidth + beam;
+                EXPECT_EQ(bufferCast<SizeType>(*newTokensStepsHost)[stepIdx], isNew ? 0 : -1) << "slot " << slot;
+                EXPECT_EQ(bufferCast<std::uint8_t>(*finishedStepsHost)[stepIdx], isNew ? 0 : 1) << "slot " << slot;
+            }
+        }
+        for (SizeType automaton = 0; automaton < numAutomata; ++automaton)
+        {
+            EXPECT_EQ(bufferCast<SizeType>(*wordsAutomataStatesHost)[slot * numAutomata + automaton], isNew ? 0 : -1);
+        }
+        EXPECT_EQ(bufferCast<SizeType>(*sequenceLimitLengthHost)[slot], isNew ? it->sequenceLimitLength : -1);
+        EXPECT_EQ(bufferCast<SizeType>(*streamedLengthsHost)[slot], isNew ? it->inputLength : -1);
+    }
+}
+
+namespace
+{
+struct TokenStreamInputs
+{
+    TensorPtr outputIds;
+    TensorPtr logProbs;
+    TensorPtr finished;
+    TensorPtr streamedLengths;
+    TensorPtr slots;
+    TensorPtr finishedOffsets;
+};
+
+TokenStreamInputs makeTokenStreamInputs(
+    SizeType batchSize, SizeType maxSeqLength, std::vector<SizeType> const& streamedLengths, BufferManager& manager)
+{
+    auto const shape = ITensor::makeShape({batchSize, 1, maxSeqLength});
+    std::vector<TokenIdType> outputIds(batchSize * maxSeqLength);
+    std::vector<float> logProbs(batchSize * maxSeqLength);
+    for (SizeType bi = 0; bi < batchSize; ++bi)
+    {
+        for (SizeType pos = 0; pos < maxSeqLength; ++pos)
+        {
+            outputIds[bi * maxSeqLength + pos] = bi * 100 + pos;
+            logProbs[bi * maxSeqLength + pos] = -static_cast<float>(pos);
+        }
+    }
+    // Single step of finished states, only the last request is finished
+    std::vector<std::uint8_t> finished(batchSize, 0);
+    finished.back() = 1;
+    std::vector<SizeType> slots(batchSize);
+    std::iota(slots.begin(), slots.end(), 0);
+
+    TokenStreamInputs inputs;
+    inputs.outputIds = manager.copyFrom(outputIds, shape, MemoryType::kGPU);
+    inputs.logProbs = manager.copyFrom(logProbs, shape, MemoryType::kGPU);
+    inputs.finished = manager.copyFrom(finished, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+    inputs.streamedLengths = manager.copyFrom(streamedLengths, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+    inputs.slots = manager.copyFrom(slots, ITensor::makeShape({batchSize}), MemoryType::kPINNED);
+    inputs.finishedOffsets = manager.copyFrom(slots, ITensor::makeShape({batchSize}), MemoryType::kPINNED);
+    return inputs;
+}
+} // namespace
+
+TEST_F(RuntimeKernelTest, WriteTokenStream)
+{
+    SizeType constexpr batchSize{3};
+    SizeType constexpr maxSeqLength{8};
+    auto inputs = makeTokenStreamInputs(batchSize, maxSeqLength, {2, 3, 1}, *mManager);
+    TokenStreamRing ring{16};
+
+    std::vector<SizeType> const sequenceLengths{4, 3, 3};
+    auto sequenceLengthsDevice
+        = mManager->copyFrom(sequenceLengths, ITensor::makeShape({batchSize, 1}), MemoryType::kGPU);
+    kernels::invokeWriteTokenStream(ring, *inputs.streamedLengths, *inputs.outputIds, *inputs.logProbs,
+        *inputs.finished, *sequenceLengthsDevice, *inputs.slots, *inputs.finishedOffsets, batchSize, *mStream);
+    mStream->synchronize();
+
+    std::vector<TokenStreamRecord> records;
+    ASSERT_EQ(ring.poll(records), 4);
+    // Records are ordered by slot, then by position
+    std::vector<std::pair<SizeType, SizeType>> const expected{{0, 2}, {0, 3}, {2, 1}, {2, 2}};
+    for (std::size_t ri = 0; ri < expected.size(); ++ri)
+    {
+        auto const& record = records[ri];
+        auto const [slot, pos] = expected[ri];
+        EXPECT_EQ(record.sequence, static_cast<std::int64_t>(ri + 1));
+        EXPECT_EQ(record.slot, slot);
+        EXPECT_EQ(record.position, pos);
+        EXPECT_EQ(record.token, slot * 100 + pos);
+        EXPECT_EQ(record.logProb, -static_cast<float>(pos));
+        // Only the last token of a request carries its finished state
+        EXPECT_EQ(record.finished, ri == expected.size() - 1 ? 1 : 0);
+    }
+
+    // Nothing new until the sequences grow
+    EXPECT_EQ(ring.poll(records), 0);
+    std::vector<SizeType> const nextSequenceLengths{5, 3, 3};
+    mManager->copy(nextSequenceLengths.data(), *sequenceLengthsDevice);
+    kernels::invokeWriteTokenStream(ring, *inputs.streamedLengths, *inputs.outputIds, *inputs.logProbs,
+        *inputs.finished, *sequenceLengthsDevice, *inputs.slots, *inputs.finishedOffsets, batchSize, *mStream);
+    mStream->synchronize();
+    records.clear();
+    ASSERT_EQ(ring.poll(records), 1);
+    EXPECT_EQ(records[0].slot, 0);
+    EXPECT_EQ(records[0].position, 4);
+    EXPECT_EQ(ring.getNumDropped(), 0);
+}
+
+TEST_F(RuntimeKernelTest, WriteTokenStreamOverflow)
+{
+    SizeType constexpr batchSize{2};
+    SizeType constexpr maxSeqLength{8};
+    auto inputs = makeTokenStreamInputs(batchSize, maxSeqLength, {0, 0}, *mManager);
+    TokenStreamRing ring{4};
+
+    std::vector<SizeType> const sequenceLengths{3, 3};
+    auto sequenceLengthsDevice
+        = mManager->copyFrom(sequenceLengths, ITensor::makeShape({batchSize, 1}), MemoryType::kGPU);
+    kernels::invokeWriteTokenStream(ring, *inputs.streamedLengths, *inputs.outputIds, *inputs.logProbs,
+        *inputs.finished, *sequenceLengthsDevice, *inputs.slots, *inputs.finishedOffsets, batchSize, *mStream);
+    mStream->synchronize();
+
+    // Six tokens were written into four records, the two oldest ones are lost
+    std::vector<TokenStreamRecord> records;
+    ASSERT_EQ(ring.poll(records), 4);
+    EXPECT_EQ(ring.getNumDropped(), 2);
+    EXPECT_EQ(records.front().slot, 0);
+    EXPECT_EQ(records.front().position, 2);
+    EXPECT_EQ(records.back().slot, 1);
+    EXPECT_EQ(records.back().position, 2);
+}
+
+namespace
+{
+std::vector<float> poolEmbeddings(std::vector<float> const& hiddenStates, std::vector<SizeType> const& contextLengths,
+    SizeType hiddenSize, EmbeddingPooling pooling, bool normalize)
+{
+    std::vector<float> embeddings(contextLengths.size() * hiddenSize);
+    std::size_t firstRow{0};
+    for (std::size_t bi = 0; bi < contextLengths.size(); ++bi)
+    {
+        auto const length = contextLengths[bi];
+        auto* embedding = embeddings.data() + bi * hiddenSize;
+        for (SizeType h = 0; h < hiddenSize; ++h)
+        {
+            float acc{0.f};
+            float weightSum{0.f};
+            for (SizeType t = pooling == EmbeddingPooling::kLAST ? length - 1 : 0; t < length; ++t)
+            {
+                auto const weight = pooling == EmbeddingPooling::kWEIGHTED_MEAN ? static_cast<float>(t + 1) : 1.f;
+                acc += weight * hiddenStates[(firstRow + t) * hiddenSize + h];
+                weightSum += weight;
+            }
+            embedding[h] = acc / weightSum;
+        }
+        if (normalize)
+        {
+            auto const norm = std::sqrt(std::inner_product(embedding, embedding + hiddenSize, embedding, 0.f));
+            std::transform(embedding, embedding + hiddenSize, embedding, [norm](float v) { return v / norm; });
+        }
+        firstRow += length;
+    }
+    return embeddings;
+}
+} // namespace
+
+TEST_F(RuntimeKernelTest, EmbeddingPooling)
+{
+    SizeType constexpr hiddenSize{300};
+    std::vector<SizeType> const contextLengths{3, 1, 5};
+    auto const batchSize = static_cast<SizeType>(contextLengths.size());
+    auto const numTokens = std::accumulate(contextLengths.begin(), contextLengths.end(), 0);
+
+    std::vector<float> hiddenStates(numTokens * hiddenSize);
+    for (std::size_t i = 0; i < hiddenStates.size(); ++i)
+    {
+        hiddenStates[i] = static_cast<float>(static_cast<int>(i * 7 % 23) - 11) / 4.f;
+    }
+    auto hiddenStatesDevice
+        = mManager->copyFrom(hiddenStates, ITensor::makeShape({numTokens, hiddenSize}), MemoryType::kGPU);
+    auto contextLengthsDevice = mManager->copyFrom(contextLengths, ITensor::makeShape({batchSize}), MemoryType::kGPU);
+    auto embeddings = mManager->gpu(ITensor::makeShape({batchSize, hiddenSize}), nvinfer1::DataType::kFLOAT);
+
+    for (auto const pooling : {EmbeddingPooling::kLAST, EmbeddingPooling::kMEAN, EmbeddingPooling::kWEIGHTED_MEAN})
+    {
+        for (auto const normalize : {false, true})
+        {
+            kernels::embeddingPooling(
+                *embeddings, *hiddenStatesDevice, *contextLengthsDevice, pooling, normalize, *mStream);
+            auto const embeddingsHost = mManager->copyFrom(*embeddings, MemoryType::kCPU);
+            mStream->synchronize();
+
+            auto const expected = poolEmbeddings(hiddenStates, contextLengths, hiddenSize, pooling, normalize);
+            auto const* actual = bufferCast<float>(*embeddingsHost);
+            for (std::size_t i = 0; i < expected.size(); ++i)
+            {
+                EXPECT_NEAR(actual[i], expected[i], 1e-5f) << "pooling " << static_cast<int>(pooling) << " normalize "
+                                                           << normalize << " at " << i;
+            }
+        }
+    }
+}
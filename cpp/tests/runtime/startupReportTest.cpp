@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/startupReport.h"
+
+#include <thread>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(StartupReportTest, Phases)
+{
+    auto& report = StartupReport::getInstance();
+    report.clear();
+
+    report.record("engine_read", 10.);
+    {
+        StartupReport::ScopedPhase const warmUp{"warm_up"};
+        {
+            StartupReport::ScopedPhase const capture{"cuda_graph_capture"};
+        }
+        {
+            StartupReport::ScopedPhase const capture{"cuda_graph_capture"};
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    report.record("engine_read", 5.);
+    // Not nested in the phase of another thread
+    std::thread([]() { StartupReport::ScopedPhase const phase{"kv_cache_allocation"}; }).join();
+
+    auto const phases = report.getPhases();
+    ASSERT_EQ(phases.size(), 4);
+    EXPECT_EQ(phases[0].name, "engine_read");
+    EXPECT_EQ(phases[0].totalMs, 15.);
+    EXPECT_EQ(phases[0].count, 2);
+    EXPECT_EQ(phases[1].name, "warm_up/cuda_graph_capture");
+    EXPECT_TRUE(phases[1].nested);
+    EXPECT_EQ(phases[1].count, 2);
+    EXPECT_GE(phases[1].totalMs, 2.);
+    EXPECT_EQ(phases[2].name, "warm_up");
+    EXPECT_FALSE(phases[2].nested);
+    EXPECT_GE(phases[2].totalMs, phases[1].totalMs);
+    EXPECT_EQ(phases[3].name, "kv_cache_allocation");
+    EXPECT_FALSE(phases[3].nested);
+
+    EXPECT_DOUBLE_EQ(report.getTotalMs(), 15. + phases[2].totalMs + phases[3].totalMs);
+    auto const text = report.toString();
+    EXPECT_EQ(text.rfind("[Startup] total ", 0), 0);
+    EXPECT_NE(text.find("\n  engine_read: 15.0 ms ("), std::string::npos);
+    EXPECT_NE(text.find(" in 2 calls"), std::string::npos);
+    auto const json = report.toJson();
+    EXPECT_NE(json.find("{\"name\": \"engine_read\", \"ms\": 15.000, \"count\": 2}"), std::string::npos);
+
+    report.clear();
+    EXPECT_TRUE(report.getPhases().empty());
+    EXPECT_EQ(report.toJson(), "{\"total_ms\": 0.000, \"phases\": []}");
+}
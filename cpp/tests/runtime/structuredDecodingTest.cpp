@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/structuredDecoding.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+
+// Accepts "ab*" over a vocab of [a, b, c, end]
+std::shared_ptr<TokenFsm const> makeFsm()
+{
+    TokenIdType constexpr a = 0, b = 1, end = 3;
+    auto fsm = std::make_shared<TokenFsm>(4, 2, end);
+    fsm->addTransition(0, a, 1);
+    fsm->addTransition(1, b, 1);
+    fsm->addFinalState(1);
+    fsm->compile();
+    return fsm;
+}
+
+} // namespace
+
+TEST(TokenFsmTest, Bitmask)
+{
+    auto const fsm = makeFsm();
+    TokenFsmMatcher matcher{fsm};
+    std::uint32_t bitmask{0};
+
+    matcher.fillNextTokenBitmask(&bitmask, 4);
+    EXPECT_EQ(bitmask, 0b0001u);
+    EXPECT_FALSE(matcher.acceptToken(1));
+    EXPECT_EQ(matcher.getState(), 0);
+    EXPECT_TRUE(matcher.acceptToken(0));
+
+    matcher.fillNextTokenBitmask(&bitmask, 4);
+    EXPECT_EQ(bitmask, 0b1010u);
+    EXPECT_TRUE(matcher.acceptToken(1));
+    EXPECT_FALSE(matcher.isTerminated());
+    EXPECT_TRUE(matcher.acceptToken(3));
+    EXPECT_TRUE(matcher.isTerminated());
+
+    matcher.fillNextTokenBitmask(&bitmask, 4);
+    EXPECT_EQ(bitmask, 0b1000u);
+}
+
+TEST(TokenFsmTest, BitmaskSize)
+{
+    EXPECT_EQ(TokenFsm::getBitmaskSize(1), 1);
+    EXPECT_EQ(TokenFsm::getBitmaskSize(32), 1);
+    EXPECT_EQ(TokenFsm::getBitmaskSize(33), 2);
+    EXPECT_THROW(TokenFsm(4, 2, 4), tc::TllmException);
+}
+
+class StructuredDecodingTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        mDeviceCount = tc::getDeviceCount();
+        if (mDeviceCount == 0)
+            GTEST_SKIP();
+
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    int mDeviceCount;
+    std::unique_ptr<BufferManager> mManager;
+    BufferManager::CudaStreamPtr mStream;
+};
+
+TEST_F(StructuredDecodingTest, MaskLogits)
+{
+    SizeType constexpr maxBatchSize = 4;
+    SizeType constexpr vocabSize = 4;
+    SizeType constexpr vocabSizePadded = 8;
+    SizeType constexpr batchSize = 2;
+
+    StructuredDecoding structuredDecoding{maxBatchSize, vocabSize, *mManager};
+    auto const fsm = makeFsm();
+    // Slot 1 is constrained, slot 3 is not
+    structuredDecoding.setMatcher(1, std::make_shared<TokenFsmMatcher>(fsm));
+    EXPECT_TRUE(structuredDecoding.isConstrained(1));
+    EXPECT_FALSE(structuredDecoding.isConstrained(3));
+
+    auto batchSlots = mManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+    bufferCast<SizeType>(*batchSlots)[0] = 1;
+    bufferCast<SizeType>(*batchSlots)[1] = 3;
+    auto newTokens = mManager->pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+
+    auto const processor = structuredDecoding.getLogitsPostProcessor();
+    auto logitsHost = mManager->pinned(ITensor::makeShape({batchSize, 1, vocabSizePadded}), nvinfer1::DataType::kFLOAT);
+    auto logits = mManager->gpu(logitsHost->getShape(), nvinfer1::DataType::kFLOAT);
+
+    auto const runStep = [&]()
+    {
+        mManager->setZero(*logits);
+        (*processor)(*logits, *batchSlots, {0}, mStream->get());
+        mManager->copy(*logits, *logitsHost);
+        mStream->synchronize();
+        return bufferCast<float>(*logitsHost);
+    };
+
+    auto const* logitsPtr = runStep();
+    for (SizeType vi = 0; vi < vocabSizePadded; ++vi)
+    {
+        // Only token a is allowed in the initial state, padded logits are left unchanged
+        EXPECT_EQ(std::isinf(logitsPtr[vi]), vi != 0 && vi < vocabSize) << vi;
+        // The unconstrained request is left alone
+        EXPECT_EQ(logitsPtr[vocabSizePadded + vi], 0.f) << vi;
+    }
+
+    bufferCast<SizeType>(*newTokens)[1] = 0;
+    bufferCast<SizeType>(*newTokens)[3] = 2;
+    structuredDecoding.advance(*newTokens, {1, 3});
+    logitsPtr = runStep();
+    for (SizeType vi = 0; vi < vocabSize; ++vi)
+    {
+        EXPECT_EQ(std::isinf(logitsPtr[vi]), vi != 1 && vi != 3) << vi;
+    }
+    EXPECT_EQ(structuredDecoding.getNumRejectedTokens(), 0);
+
+    structuredDecoding.release(1);
+    logitsPtr = runStep();
+    for (SizeType vi = 0; vi < vocabSize; ++vi)
+    {
+        EXPECT_EQ(logitsPtr[vi], 0.f) << vi;
+    }
+}
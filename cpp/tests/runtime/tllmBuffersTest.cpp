@@ -589,3 +589,146 @@ TEST_F(TllmBuffersTest, PinnedPoolStressTest)
         });
     thread.join();
 }
+
+TEST_F(TllmBuffersTest, SizeClassPool)
+{
+    using MemPool = MemoryPool<HostAllocator>;
+    using SlabPool = SizeClassPool<HostAllocator>;
+    auto& memCounters = MemoryCounters::getInstance();
+    auto const initSlabReserved = memCounters.getSlabReserved(MemoryType::kCPU);
+    auto const initSlabUsed = memCounters.getSlabUsed(MemoryType::kCPU);
+    MemPool pool{SlabPool::kSlabSize * 4};
+    {
+        SlabPool slabPool{pool};
+        EXPECT_EQ(SlabPool::getClassIndex(0), 0u);
+        EXPECT_EQ(SlabPool::getClassIndex(SlabPool::kMinClassSize + 1), 1u);
+        EXPECT_EQ(SlabPool::getClassSize(SlabPool::kNumClasses - 1), SlabPool::kMaxClassSize);
+
+        auto constexpr smallSize = SlabPool::kMinClassSize * 3;
+        auto* ptr0 = slabPool.allocate(smallSize);
+        auto* ptr1 = slabPool.allocate(smallSize);
+        auto const classSize = SlabPool::getClassSize(SlabPool::getClassIndex(smallSize));
+        EXPECT_EQ(static_cast<std::uint8_t*>(ptr1) - static_cast<std::uint8_t*>(ptr0),
+            static_cast<std::ptrdiff_t>(classSize));
+        EXPECT_EQ(slabPool.getReservedSize(), SlabPool::kSlabSize);
+        EXPECT_EQ(slabPool.getUsedSize(), 2 * classSize);
+        EXPECT_EQ(pool.getUsedSize(), SlabPool::kSlabSize);
+        EXPECT_EQ(memCounters.getSlabReserved(MemoryType::kCPU), initSlabReserved + SlabPool::kSlabSize);
+        EXPECT_EQ(memCounters.getSlabUsed(MemoryType::kCPU), initSlabUsed + 2 * classSize);
+        EXPECT_NEAR(slabPool.getFragmentation(), 1.0 - 2.0 * classSize / SlabPool::kSlabSize, 1e-9);
+
+        // Freed blocks are reused first
+        slabPool.deallocate(ptr1, smallSize);
+        EXPECT_EQ(slabPool.allocate(smallSize), ptr1);
+
+        // Large requests bypass the slabs
+        auto constexpr largeSize = SlabPool::kMaxClassSize + 1;
+        auto* ptr2 = slabPool.allocate(largeSize);
+        EXPECT_EQ(slabPool.getReservedSize(), SlabPool::kSlabSize);
+        EXPECT_GE(pool.getUsedSize(), SlabPool::kSlabSize + largeSize);
+        slabPool.deallocate(ptr2, largeSize);
+        EXPECT_EQ(pool.getUsedSize(), SlabPool::kSlabSize);
+
+        slabPool.deallocate(ptr0, smallSize);
+        slabPool.deallocate(ptr1, smallSize);
+        EXPECT_EQ(slabPool.getUsedSize(), 0u);
+        std::uint8_t foreign{0};
+        EXPECT_THROW(slabPool.deallocate(&foreign, smallSize), std::exception);
+
+        // Concurrent allocations from several threads must never hand out the same block twice
+        auto constexpr numThreads = std::size_t{4};
+        auto constexpr numAllocations = std::size_t{1000};
+        std::vector<std::vector<void*>> results(numThreads);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back(
+                [&slabPool, &result = results[t], t]()
+                {
+                    auto const size = SlabPool::kMinClassSize * (t + 1);
+                    for (std::size_t i = 0; i < numAllocations; ++i)
+                    {
+                        result.push_back(slabPool.allocate(size));
+                        if (i % 3 == 0)
+                        {
+                            slabPool.deallocate(result.back(), size);
+                            result.pop_back();
+                        }
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        std::vector<void*> allPointers;
+        for (auto const& result : results)
+        {
+            allPointers.insert(allPointers.end(), result.begin(), result.end());
+        }
+        std::sort(allPointers.begin(), allPointers.end());
+        EXPECT_EQ(std::adjacent_find(allPointers.begin(), allPointers.end()), allPointers.end());
+        for (std::size_t t = 0; t < numThreads; ++t)
+        {
+            for (auto* ptr : results[t])
+            {
+                slabPool.deallocate(ptr, SlabPool::kMinClassSize * (t + 1));
+            }
+        }
+        EXPECT_EQ(slabPool.getUsedSize(), 0u);
+    }
+    // Slabs have been returned to the pool
+    EXPECT_EQ(pool.getUsedSize(), 0u);
+    EXPECT_EQ(memCounters.getSlabReserved(MemoryType::kCPU), initSlabReserved);
+    EXPECT_EQ(memCounters.getSlabUsed(MemoryType::kCPU), initSlabUsed);
+}
+
+TEST_F(TllmBuffersTest, MemoryCountersTags)
+{
+    auto& memCounters = MemoryCounters::getInstance();
+    auto const tag = memCounters.getTagId("tllmBuffersTest");
+    EXPECT_NE(tag, MemoryCounters::kUntagged);
+    EXPECT_EQ(memCounters.getTagId("tllmBuffersTest"), tag);
+    EXPECT_EQ(memCounters.getTagName(tag), "tllmBuffersTest");
+
+    EXPECT_EQ(MemoryCounters::getCurrentTag(), MemoryCounters::kUntagged);
+    {
+        MemoryCounters::ScopedTag const scopedTag{"tllmBuffersTest"};
+        EXPECT_EQ(MemoryCounters::getCurrentTag(), tag);
+        {
+            MemoryCounters::ScopedTag const nestedTag{MemoryCounters::kUntagged};
+            EXPECT_EQ(MemoryCounters::getCurrentTag(), MemoryCounters::kUntagged);
+        }
+        EXPECT_EQ(MemoryCounters::getCurrentTag(), tag);
+    }
+    EXPECT_EQ(MemoryCounters::getCurrentTag(), MemoryCounters::kUntagged);
+
+    auto constexpr size = std::size_t{1} << 10;
+    auto const initCpu = memCounters.getCpu();
+    {
+        TaggedAllocator allocator{HostAllocator{}, tag};
+        auto* ptr0 = allocator.allocate(size);
+        auto* ptr1 = allocator.allocate(2 * size);
+        EXPECT_EQ(memCounters.getCpu(), initCpu + 3 * size);
+        EXPECT_EQ(memCounters.getTagged(MemoryType::kCPU, tag), 3 * size);
+        allocator.deallocate(ptr1, 2 * size);
+        EXPECT_EQ(memCounters.getTagged(MemoryType::kCPU, tag), size);
+        EXPECT_EQ(memCounters.getTaggedPeak(MemoryType::kCPU, tag), 3 * size);
+        allocator.deallocate(ptr0, size);
+    }
+    EXPECT_EQ(memCounters.getCpu(), initCpu);
+    EXPECT_EQ(memCounters.getTagged(MemoryType::kCPU, tag), 0u);
+    EXPECT_EQ(memCounters.getTagged(MemoryType::kGPU, tag), 0u);
+
+    auto const stats = memCounters.getTagStats();
+    auto const it = std::find_if(stats.begin(), stats.end(),
+        [tag, &memCounters](auto const& s) { return s.name == memCounters.getTagName(tag); });
+    ASSERT_NE(it, stats.end());
+    EXPECT_EQ(it->memoryType, MemoryType::kCPU);
+    EXPECT_EQ(it->peak, 3 * size);
+    EXPECT_THAT(memCounters.tagsToString(), ::testing::HasSubstr("tllmBuffersTest CPU: 0.00 B (peak 3.00 KB)"));
+
+    memCounters.resetTagPeaks();
+    EXPECT_EQ(memCounters.getTaggedPeak(MemoryType::kCPU, tag), 0u);
+    EXPECT_THROW(memCounters.getTagName(MemoryCounters::kMaxTags), std::exception);
+}
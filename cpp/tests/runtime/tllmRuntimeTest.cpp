@@ -25,10 +25,13 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 #include "tensorrt_llm/runtime/tllmRuntime.h"
+#include "tensorrt_llm/runtime/utils/mappedFile.h"
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <memory>
 #include <vector>
 
@@ -144,3 +147,26 @@ TEST_F(TllmRuntimeTest, SinglePass)
     auto max = std::max_element(output.begin(), output.end());
     EXPECT_NEAR(*max, 0.140218f, 1e-5f);
 }
+
+TEST_F(TllmRuntimeTest, MappedEngineFile)
+{
+    auto const enginePath = fs::temp_directory_path() / "tllmRuntimeTest_mnist.engine";
+    {
+        std::ofstream engineFile(enginePath, std::ios::binary);
+        engineFile.write(static_cast<char const*>(mSerializedEngine->data()),
+            static_cast<std::streamsize>(mSerializedEngine->size()));
+        ASSERT_TRUE(engineFile.good());
+    }
+
+    {
+        utils::MappedFile const mappedFile{enginePath.string()};
+        ASSERT_EQ(mappedFile.size(), mSerializedEngine->size());
+        EXPECT_EQ(std::memcmp(mappedFile.data(), mSerializedEngine->data(), mappedFile.size()), 0);
+    }
+
+    TllmRuntime rt{enginePath.string(), mLogger};
+    auto& engine = rt.getEngine();
+    EXPECT_EQ(rt.getNbProfiles(), engine.getNbOptimizationProfiles());
+    EXPECT_EQ(engine.getNbIOTensors(), 2);
+    fs::remove(enginePath);
+}
@@ -115,7 +115,8 @@ void verifyKVTransposed(int batchSize, int headsNum, int dimsPerHead, int seqLen
                         const int refKVIdx = bi * headsNum * seqLen * dimsPerHead + hi * seqLen * dimsPerHead
                             + li * dimsPerHead + di * X_ELEMS + xi;
 
-                        const int kVIdx = buffer.getKVLocalIdx(li, hi, dimsPerHead, di * X_ELEMS + xi);
+                        const int kIdx = buffer.template getKLocalIdx<T_DST>(li, hi, dimsPerHead, di * X_ELEMS + xi);
+                        const int vIdx = buffer.getKVLocalIdx(li, hi, dimsPerHead, di * X_ELEMS + xi);
 
                         T refK = refKCacheVec[refKVIdx];
                         T refV = vTransposedCacheVec[refKVIdx];
@@ -128,8 +129,8 @@ void verifyKVTransposed(int batchSize, int headsNum, int dimsPerHead, int seqLen
                         const T_DST castedRefK = castTo<T, T_DST>(refK);
                         const T_DST castedRefV = castTo<T, T_DST>(refV);
 
-                        const auto outK = blockKPtr[kVIdx];
-                        const auto outV = blockVPtr[kVIdx];
+                        const auto outK = blockKPtr[kIdx];
+                        const auto outV = blockVPtr[vIdx];
 
                         // Since EXPECT_EQ does not support fp8, casting to float to compare
                         const float outK_float = castTo<T_DST, float>(outK);
@@ -146,7 +147,8 @@ void verifyKVTransposed(int batchSize, int headsNum, int dimsPerHead, int seqLen
 }
 
 template <typename T, typename T_DST>
-void testTransposeBatch4dPaged(bool multiQueryMode, bool int8KVCache, bool fp8KVCache)
+void testTransposeBatch4dPaged(
+    bool multiQueryMode, bool int8KVCache, bool fp8KVCache, KVCacheLayout kLayout = KVCacheLayout::kLINEAR)
 {
     // Fix seed
     srand(42);
@@ -172,7 +174,7 @@ void testTransposeBatch4dPaged(bool multiQueryMode, bool int8KVCache, bool fp8KV
         "Total amount of tokens is less than max amount of tokens is cache per sequence");
 
     KVBlockArray blockArray(maxSeq, maxBlocksPerSeq, tokensPerBlock, dimsPerHead * headsNum * sizeof(T_DST),
-        maxAttentionWindow, sinkTokenLen, onlyKorV);
+        maxAttentionWindow, sinkTokenLen, onlyKorV, kLayout);
 
     // Allocate for pointer array
     const auto pointerArrayElts = maxSeq * maxBlocksPerSeq;
@@ -265,7 +267,8 @@ void testTransposeBatch4dPaged(bool multiQueryMode, bool int8KVCache, bool fp8KV
 }
 
 template <typename T, typename T_DST>
-void testTransposeBatch4dContiguous(bool multiQueryMode, bool int8KVCache, bool fp8KVCache)
+void testTransposeBatch4dContiguous(
+    bool multiQueryMode, bool int8KVCache, bool fp8KVCache, KVCacheLayout kLayout = KVCacheLayout::kLINEAR)
 {
     // Fix seed
     srand(42);
@@ -282,8 +285,8 @@ void testTransposeBatch4dContiguous(bool multiQueryMode, bool int8KVCache, bool
     constexpr int32_t sinkTokenLen{0};
     constexpr int32_t onlyKorV{false};
 
-    KVLinearBuffer kvLinearBuffer(
-        batchSize, 1, maxSeqLen, dimsPerHead * headsNum * sizeof(T_DST), maxAttentionWindow, sinkTokenLen, onlyKorV);
+    KVLinearBuffer kvLinearBuffer(batchSize, 1, maxSeqLen, dimsPerHead * headsNum * sizeof(T_DST), maxAttentionWindow,
+        sinkTokenLen, onlyKorV, kLayout);
 
     // Allocate for kv cache pool
     const auto kvPoolElts = 2 * batchSize * maxSeqLen * dimsPerHead * headsNum;
@@ -372,6 +375,16 @@ TEST(AttentionKernelTest, transposeBatch4dPagedFp8)
 }
 #endif
 
+TEST(AttentionKernelTest, transposeBatch4dPagedInterleavedKHalf)
+{
+    testTransposeBatch4dPaged<half, half>(false, false, false, KVCacheLayout::kINTERLEAVED_K);
+}
+
+TEST(AttentionKernelTest, transposeBatch4dPagedInterleavedKInt8)
+{
+    testTransposeBatch4dPaged<float, int8_t>(false, true, false, KVCacheLayout::kINTERLEAVED_K);
+}
+
 TEST(AttentionKernelTest, transposeBatch4dContiguousFloat)
 {
     testTransposeBatch4dContiguous<float, float>(false, false, false);
@@ -398,3 +411,8 @@ TEST(AttentionKernelTest, transposeBatch4dContiguousFp8)
     testTransposeBatch4dContiguous<float, __nv_fp8_e4m3>(false, false, true);
 }
 #endif
+
+TEST(AttentionKernelTest, transposeBatch4dContiguousInterleavedKFloat)
+{
+    testTransposeBatch4dContiguous<float, float>(false, false, false, KVCacheLayout::kINTERLEAVED_K);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/virtualMemory.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class VirtualMemoryTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || !VirtualMemoryBuffer::isSupported(0))
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    BufferManager::CudaStreamPtr mStream;
+};
+
+TEST_F(VirtualMemoryTest, GrowKeepsAddressAndContents)
+{
+    VirtualMemoryBuffer buffer{std::size_t{64} << 20, 0};
+    auto const chunkSize = buffer.getChunkSize();
+    EXPECT_EQ(buffer.getMappedSize(), 0);
+    EXPECT_EQ(buffer.getReservedSize() % chunkSize, 0);
+
+    BufferManager manager{mStream};
+    auto const basePtr = buffer.data();
+    buffer.resize(1);
+    EXPECT_EQ(buffer.getMappedSize(), chunkSize);
+
+    auto const numValues = chunkSize / sizeof(std::int32_t);
+    std::vector<std::int32_t> input(numValues);
+    for (std::size_t i = 0; i < numValues; ++i)
+    {
+        input[i] = static_cast<std::int32_t>(i);
+    }
+    auto view = ITensor::wrap(
+        static_cast<std::int32_t*>(buffer.data()), ITensor::makeShape({static_cast<SizeType>(numValues)}));
+    manager.copy(input.data(), *view, MemoryType::kCPU);
+
+    buffer.resize(2 * chunkSize);
+    EXPECT_EQ(buffer.data(), basePtr);
+    EXPECT_EQ(buffer.getMappedSize(), 2 * chunkSize);
+
+    std::vector<std::int32_t> output(numValues);
+    manager.copy(*view, output.data(), MemoryType::kCPU);
+    mStream->synchronize();
+    EXPECT_EQ(input, output);
+
+    buffer.resize(0);
+    EXPECT_EQ(buffer.getMappedSize(), 0);
+    EXPECT_THROW(buffer.resize(buffer.getReservedSize() + 1), tc::TllmException);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/workStealingPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(WorkStealingPoolTest, RunsEveryItemOnce)
+{
+    WorkStealingPool pool{4};
+    EXPECT_EQ(pool.getNumWorkers(), 4);
+    for (SizeType const grainSize : {1, 3, 64})
+    {
+        SizeType constexpr numItems = 1000;
+        std::vector<std::atomic<SizeType>> counts(numItems);
+        std::vector<SizeType> workers(numItems, -1);
+        pool.parallelFor(
+            numItems,
+            [&](SizeType itemIdx, SizeType workerIdx)
+            {
+                ++counts[itemIdx];
+                workers[itemIdx] = workerIdx;
+            },
+            grainSize);
+        for (SizeType i = 0; i < numItems; ++i)
+        {
+            EXPECT_EQ(counts[i].load(), 1) << "item " << i << " grain " << grainSize;
+            EXPECT_GE(workers[i], 0);
+            EXPECT_LT(workers[i], pool.getNumWorkers());
+        }
+    }
+}
+
+TEST(WorkStealingPoolTest, SingleWorker)
+{
+    WorkStealingPool pool{1};
+    std::vector<SizeType> order;
+    pool.parallelFor(5, [&](SizeType itemIdx, SizeType workerIdx) { order.push_back(itemIdx + 10 * workerIdx); });
+    EXPECT_EQ(order, (std::vector<SizeType>{0, 1, 2, 3, 4}));
+    pool.parallelFor(0, [&](SizeType, SizeType) { FAIL(); });
+}
+
+TEST(WorkStealingPoolTest, StealsUnevenWork)
+{
+    // The first items are slow, so the workers owning the back of the range run out and must steal
+    WorkStealingPool pool{4};
+    SizeType constexpr numItems = 64;
+    std::vector<SizeType> workers(numItems, -1);
+    pool.parallelFor(numItems,
+        [&](SizeType itemIdx, SizeType workerIdx)
+        {
+            if (itemIdx < numItems / 4)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+            workers[itemIdx] = workerIdx;
+        });
+    auto numStolen = 0;
+    for (SizeType i = 0; i < numItems / 4; ++i)
+    {
+        numStolen += workers[i] != 0;
+    }
+    EXPECT_GT(numStolen, 0);
+}
+
+TEST(WorkStealingPoolTest, RethrowsAndRecovers)
+{
+    WorkStealingPool pool{3};
+    EXPECT_THROW(pool.parallelFor(100,
+                     [](SizeType itemIdx, SizeType)
+                     {
+                         if (itemIdx == 42)
+                         {
+                             throw std::runtime_error("failed");
+                         }
+                     }),
+        std::runtime_error);
+
+    // The pool stays usable after a failed call
+    std::atomic<SizeType> sum{0};
+    pool.parallelFor(100, [&](SizeType itemIdx, SizeType) { sum += itemIdx; });
+    EXPECT_EQ(sum.load(), 4950);
+}
@@ -55,3 +55,25 @@ TEST(WorldConfig, DeviceIds)
     EXPECT_NO_THROW(
         tr::WorldConfig(tensorParallelism, pipelineParallelism, rank, gpusPerNode, std::vector{0, 1, 2, 3, 4, 6}));
 }
+
+TEST(WorldConfig, ContextParallelRanks)
+{
+    auto constexpr tensorParallelism = 2;
+    auto constexpr pipelineParallelism = 2;
+    auto constexpr contextParallelism = 3;
+    auto constexpr gpusPerNode = 8;
+    auto constexpr rank = 9;
+    tr::WorldConfig const worldConfig{
+        tensorParallelism, pipelineParallelism, rank, gpusPerNode, std::nullopt, contextParallelism};
+
+    EXPECT_EQ(worldConfig.getSize(), 12);
+    EXPECT_TRUE(worldConfig.isContextParallel());
+    EXPECT_EQ(worldConfig.getTensorParallelRank(), 1);
+    EXPECT_EQ(worldConfig.getContextParallelRank(), 1);
+    EXPECT_EQ(worldConfig.getPipelineParallelRank(), 1);
+    EXPECT_EQ(worldConfig.getContextParallelGroup(), (std::vector{7, 9, 11}));
+    EXPECT_EQ(worldConfig.getPipelineParallelGroup(), (std::vector{3, 9}));
+
+    EXPECT_THROW(tr::WorldConfig(tensorParallelism, pipelineParallelism, rank, gpusPerNode, std::nullopt, 0),
+        tc::TllmException);
+}